@@ -113,6 +113,16 @@
 #define SBC_IS_64_MULT_IN_WINDOW_ACCU  FALSE
 #endif /*SBC_IS_64_MULT_IN_WINDOW_ACCU */
 
+/* Set SBC_SIMD_OPT to TRUE to compute the windowing of the analysis filter with SSE2 or NEON intrinsics */
+/* -> bit exact with the SBC_IPAQ_OPT windowing, enabled by default if the compiler targets SSE2 or NEON */
+#ifndef SBC_SIMD_OPT
+#if (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)) && (SBC_IPAQ_OPT == TRUE) && (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE) && (SBC_ARM_ASM_OPT == FALSE)
+#define SBC_SIMD_OPT TRUE
+#else
+#define SBC_SIMD_OPT FALSE
+#endif
+#endif /* SBC_SIMD_OPT */
+
 /* Set SBC_IS_64_MULT_IN_IDCT to TRUE to use 64 bits multiplication in the DCT of Matrixing */
 /* -> more MIPS required for a better audio quality. comparasion with the SIG utilities shows a division by 10 of the RMS */
 /* CAUTION: It only apply in the if SBC_FAST_DCT is set to TRUE */
@@ -196,6 +206,11 @@ typedef struct SBC_ENC_PARAMS_TAG
     UINT16 u16PacketLength;
     /* BK4BTSTACK_CHANGE START */
     UINT8  mSBCEnabled;
+    /* analysis filter state, kept per encoder instead of in globals */
+    SINT16 s16EncMaxShiftCounter;
+    SINT16 s16ShiftCounter;
+    SINT32 as32DCTY[16];
+    SINT32 as32X[ENC_VX_BUFFER_SIZE/2];             /* accessed as SINT16, must be 32 bits aligned cf SHIFTUP_X8_2 */
     /* BK4BTSTACK_CHANGE END */
 }SBC_ENC_PARAMS;
 
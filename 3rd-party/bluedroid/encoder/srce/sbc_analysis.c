@@ -25,6 +25,18 @@
 #include <string.h>
 #include "sbc_encoder.h"
 #include "sbc_enc_func_declare.h"
+#if (SBC_SIMD_OPT == TRUE)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#else
+#error "SBC_SIMD_OPT requires a target with SSE2 or NEON"
+#endif
+#if (SBC_IPAQ_OPT == FALSE) || (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE) || (SBC_ARM_ASM_OPT == TRUE)
+#error "SBC_SIMD_OPT requires SBC_IPAQ_OPT with 16 bit windowing"
+#endif
+#endif
 /*#include <math.h>*/
 
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
@@ -153,15 +165,9 @@
 #define WIND_8_SUBBANDS_8_2 (SINT16)0x12CF  /* 40 = 0x12CF6C75 */
 #endif
 
-#if (SBC_USE_ARM_PRAGMA==TRUE)
-#pragma arm section zidata = "sbc_s32_analysis_section"
-#endif
-static SINT32   s32DCTY[16]  = {0};
-static SINT32   s32X[ENC_VX_BUFFER_SIZE/2];
-static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
-#if (SBC_USE_ARM_PRAGMA==TRUE)
-#pragma arm section zidata
-#endif
+/* BK4BTSTACK_CHANGE START */
+/* s32DCTY, s16X and the shift counters are part of SBC_ENC_PARAMS to allow for multiple encoder instances */
+/* BK4BTSTACK_CHANGE END */
 
 /* This macro is for 4 subbands */
 #define SHIFTUP_X4                                                               \
@@ -805,6 +811,97 @@ static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  S
     s32DCTY[4]=(SINT32)(s32Temp);\
 }
 #endif
+#if (SBC_SIMD_OPT == TRUE)
+/* Window coefficients rearranged so that s32DCTY[n] = sum over i of coeffs[i*2*subbands+n] * s16X[ChOffset+i*2*subbands+n] */
+static const SINT16 as16WindowSimdCoeffs4[5*8] =
+{
+    0, WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_1_4,
+    WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_3_1,
+    WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3,
+    WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_3_2,
+    WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2,
+    (SINT16)-WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_3_3,
+    WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1,
+    (SINT16)-WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_3_4,
+    WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0
+};
+
+static const SINT16 as16WindowSimdCoeffs8[5*16] =
+{
+    0, WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_7_0,
+    WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4,
+    WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4,
+    WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_3_1,
+    WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1,
+    WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_1_3,
+    WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_3_2,
+    WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2,
+    WIND_8_SUBBANDS_8_2, WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_1_2,
+    (SINT16)-WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_3_3,
+    WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3,
+    WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_1_1,
+    (SINT16)-WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_3_4,
+    WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4,
+    WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_1_0
+};
+
+/****************************************************************************
+* SbcWindowSimd - computes s32DCTY for 2*subbands outputs, 8 at a time
+*
+* RETURNS : N/A
+*/
+static void SbcWindowSimd(const SINT16 *ps16X, const SINT16 *ps16Coeffs, SINT32 s32Stride, SINT32 *ps32DCTY)
+{
+    SINT32 s32Pos, i;
+
+    for (s32Pos = 0; s32Pos < s32Stride; s32Pos += 8)
+    {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        int32x4_t accLo = vdupq_n_s32(0);
+        int32x4_t accHi = vdupq_n_s32(0);
+        for (i = 0; i < 5; i++)
+        {
+            int16x8_t x = vld1q_s16(ps16X + i * s32Stride + s32Pos);
+            int16x8_t c = vld1q_s16(ps16Coeffs + i * s32Stride + s32Pos);
+            accLo = vmlal_s16(accLo, vget_low_s16(x), vget_low_s16(c));
+            accHi = vmlal_s16(accHi, vget_high_s16(x), vget_high_s16(c));
+        }
+        vst1q_s32(ps32DCTY + s32Pos, accLo);
+        vst1q_s32(ps32DCTY + s32Pos + 4, accHi);
+#else
+        __m128i accLo = _mm_setzero_si128();
+        __m128i accHi = _mm_setzero_si128();
+        for (i = 0; i < 5; i++)
+        {
+            __m128i x  = _mm_loadu_si128((const __m128i *)(ps16X + i * s32Stride + s32Pos));
+            __m128i c  = _mm_loadu_si128((const __m128i *)(ps16Coeffs + i * s32Stride + s32Pos));
+            __m128i lo = _mm_mullo_epi16(x, c);
+            __m128i hi = _mm_mulhi_epi16(x, c);
+            accLo = _mm_add_epi32(accLo, _mm_unpacklo_epi16(lo, hi));
+            accHi = _mm_add_epi32(accHi, _mm_unpackhi_epi16(lo, hi));
+        }
+        _mm_storeu_si128((__m128i *)(ps32DCTY + s32Pos), accLo);
+        _mm_storeu_si128((__m128i *)(ps32DCTY + s32Pos + 4), accHi);
+#endif
+    }
+}
+
+#define WINDOW_PARTIAL_4 \
+{\
+    SbcWindowSimd(s16X + ChOffset, as16WindowSimdCoeffs4, 2 * SUB_BANDS_4, s32DCTY);\
+}
+
+#define WINDOW_PARTIAL_8 \
+{\
+    SbcWindowSimd(s16X + ChOffset, as16WindowSimdCoeffs8, 2 * SUB_BANDS_8, s32DCTY);\
+}
+#else
 #define WINDOW_PARTIAL_4 \
 {\
     WINDOW_ACCU_4_0;     WINDOW_ACCU_4_1_7;\
@@ -820,6 +917,7 @@ static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  S
     WINDOW_ACCU_8_6_10;      WINDOW_ACCU_8_7_9;\
     WINDOW_ACCU_8_8;\
 }
+#endif /* SBC_SIMD_OPT */
 #else
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
 #define WINDOW_ACCU_4(i) \
@@ -897,8 +995,6 @@ static SINT16   *s16X=(SINT16*) s32X;      /* s16X must be 32 bits aligned cf  S
 #endif
 #endif
 
-static SINT16 ShiftCounter=0;
-extern SINT16 EncMaxShiftCounter;
 /****************************************************************************
 * SbcAnalysisFilter - performs Analysis of the input audio stream
 *
@@ -918,7 +1014,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IPAQ_OPT==TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp,s64Temp2;
-#else
+#elif (SBC_SIMD_OPT == FALSE)
 	register SINT32 s32Temp,s32Temp2;
 #endif
 #else
@@ -930,6 +1026,11 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #endif
 #endif
 
+    SINT16 *s16X = (SINT16 *) pstrEncParams->as32X;
+    SINT32 *s32DCTY = pstrEncParams->as32DCTY;
+    SINT16 ShiftCounter = pstrEncParams->s16ShiftCounter;
+    SINT16 EncMaxShiftCounter = pstrEncParams->s16EncMaxShiftCounter;
+
     s32NumOfChannels = pstrEncParams->s16NumOfChannels;
     s32NumOfBlocks   = pstrEncParams->s16NumOfBlocks;
 
@@ -995,6 +1096,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
             }
         }
     }
+    pstrEncParams->s16ShiftCounter = ShiftCounter;
 }
 
 /* //////////////////////////////////////////////////////////////////////////////////////////////////////////////////// */
@@ -1013,7 +1115,7 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IPAQ_OPT==TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp,s64Temp2;
-#else
+#elif (SBC_SIMD_OPT == FALSE)
 	register SINT32 s32Temp,s32Temp2;
 #endif
 #else
@@ -1023,6 +1125,11 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #endif
 #endif
 
+    SINT16 *s16X = (SINT16 *) pstrEncParams->as32X;
+    SINT32 *s32DCTY = pstrEncParams->as32DCTY;
+    SINT16 ShiftCounter = pstrEncParams->s16ShiftCounter;
+    SINT16 EncMaxShiftCounter = pstrEncParams->s16EncMaxShiftCounter;
+
     s32NumOfChannels = pstrEncParams->s16NumOfChannels;
     s32NumOfBlocks   = pstrEncParams->s16NumOfBlocks;
 
@@ -1099,10 +1206,12 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
             }
         }
     }
+    pstrEncParams->s16ShiftCounter = ShiftCounter;
 }
 
-void SbcAnalysisInit (void)
+void SbcAnalysisInit (SBC_ENC_PARAMS *pstrEncParams)
 {
-    memset(s16X,0,ENC_VX_BUFFER_SIZE*sizeof(SINT16));
-    ShiftCounter=0;
+    memset(pstrEncParams->as32X,0,ENC_VX_BUFFER_SIZE*sizeof(SINT16));
+    memset(pstrEncParams->as32DCTY,0,sizeof(pstrEncParams->as32DCTY));
+    pstrEncParams->s16ShiftCounter=0;
 }
@@ -26,8 +26,6 @@
 #include "sbc_encoder.h"
 #include "sbc_enc_func_declare.h"
 
-SINT16 EncMaxShiftCounter;
-
 /*************************************************************************************************
  * SBC encoder scramble code
  * Purpose: to tie the SBC code with BTE/mobile stack code,
@@ -95,7 +93,10 @@ typedef struct
     UINT8           index;
     UINT8           base;
 } tSBC_PRTC_CB;
-tSBC_PRTC_CB sbc_prtc_cb;
+/* BK4BTSTACK_CHANGE START */
+/* scrambling is not used, no global state to allow for multiple encoder instances */
+// tSBC_PRTC_CB sbc_prtc_cb;
+/* BK4BTSTACK_CHANGE STOP */
 
 #define SBC_PRTC_IDX(sc) (((sc) & 0x3) + (((sc) & 0x30) >> 2))
 #define SBC_PRTC_CHK_INIT(ar) {if(sbc_prtc_cb.init == 0){sbc_prtc_cb.init=1; ar[0] &= ~SBC_PRTC_SYNC_MASK;}}
@@ -108,11 +109,6 @@ tSBC_PRTC_CB sbc_prtc_cb;
     if(idx > 0){if((idx&1)&&(pstrEncParams->u16PacketLength > (sbc_prtc_cb.base+(idx<<1)))) {tmp2=idx<<1; tmp=ar[idx];ar[idx]=ar[tmp2];ar[tmp2]=tmp;} \
                 else{tmp2=ar[idx]; tmp=(tmp2>>5)+(tmp2<<3);ar[idx]=(UINT8)tmp;}}}
 
-#if (SBC_JOINT_STE_INCLUDED == TRUE)
-SINT32   s32LRDiff[SBC_MAX_NUM_OF_BLOCKS]    = {0};
-SINT32   s32LRSum[SBC_MAX_NUM_OF_BLOCKS]     = {0};
-#endif
-
 void SBC_Encoder(SBC_ENC_PARAMS *pstrEncParams)
 {
     SINT32 s32Ch;                               /* counter for ch*/
@@ -128,6 +124,8 @@ void SBC_Encoder(SBC_ENC_PARAMS *pstrEncParams)
     SINT32 s32MaxValue2;
     UINT32 u32CountSum,u32CountDiff;
     SINT32 *pSum, *pDiff;
+    SINT32   s32LRDiff[SBC_MAX_NUM_OF_BLOCKS];
+    SINT32   s32LRSum[SBC_MAX_NUM_OF_BLOCKS];
 #endif
     /* BK4BTSTACK_CHANGE START */
     // UINT8  *pu8;
@@ -393,23 +391,25 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
     if (pstrEncParams->s16NumOfSubBands==4)
     {
         if (pstrEncParams->s16NumOfChannels==1)
-            EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(4*10))>>2)<<2;
+            pstrEncParams->s16EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(4*10))>>2)<<2;
         else
-            EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(4*10*2))>>3)<<2;
+            pstrEncParams->s16EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(4*10*2))>>3)<<2;
     }
     else
     {
         if (pstrEncParams->s16NumOfChannels==1)
-            EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(8*10))>>3)<<3;
+            pstrEncParams->s16EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(8*10))>>3)<<3;
         else
-            EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(8*10*2))>>4)<<3;
+            pstrEncParams->s16EncMaxShiftCounter=((ENC_VX_BUFFER_SIZE-(8*10*2))>>4)<<3;
     }
 
     // APPL_TRACE_EVENT("SBC_Encoder_Init : bitrate %d, bitpool %d",
     //         pstrEncParams->u16BitRate, pstrEncParams->s16BitPool);
 
-    SbcAnalysisInit();
+    SbcAnalysisInit(pstrEncParams);
 
-    memset(&sbc_prtc_cb, 0, sizeof(tSBC_PRTC_CB));
-    sbc_prtc_cb.base = 6 + (pstrEncParams->s16NumOfChannels*pstrEncParams->s16NumOfSubBands/2);
+/* BK4BTSTACK_CHANGE START */
+    // memset(&sbc_prtc_cb, 0, sizeof(tSBC_PRTC_CB));
+    // sbc_prtc_cb.base = 6 + (pstrEncParams->s16NumOfChannels*pstrEncParams->s16NumOfSubBands/2);
+/* BK4BTSTACK_CHANGE STOP */
 }
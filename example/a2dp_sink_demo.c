@@ -71,7 +71,6 @@
 #include <string.h>
 
 #include "btstack.h"
-#include "btstack_resample.h"
 
 //#define AVRCP_BROWSING_ENABLED
 
@@ -89,32 +88,20 @@
 
 #define NUM_CHANNELS 2
 #define BYTES_PER_FRAME     (2*NUM_CHANNELS)
-#define MAX_SBC_FRAME_SIZE 120
 
 // SBC Decoder for WAV file or live playback
 static btstack_sbc_decoder_state_t state;
 static btstack_sbc_mode_t mode = SBC_MODE_STANDARD;
 
-// ring buffer for SBC Frames
-// below 30: add samples, 30-40: fine, above 40: drop samples
-#define OPTIMAL_FRAMES_MIN 30
-#define OPTIMAL_FRAMES_MAX 40
-#define ADDITIONAL_FRAMES  20
-static uint8_t sbc_frame_storage[(OPTIMAL_FRAMES_MAX + ADDITIONAL_FRAMES) * MAX_SBC_FRAME_SIZE];
-static btstack_ring_buffer_t sbc_frame_ring_buffer;
-static unsigned int sbc_frame_size;
-
-// rest buffer for not fully used sbc frames, with additional frames for resampling
-static uint8_t decoded_audio_storage[(128+16) * BYTES_PER_FRAME];
-static btstack_ring_buffer_t decoded_audio_ring_buffer;
+// playback engine with PCM jitter buffer and clock drift compensation
+#define PLAYBACK_TARGET_LATENCY_MS 100
+#define PLAYBACK_STORAGE_MS        150
+static uint8_t pcm_storage[(48000 * PLAYBACK_STORAGE_MS / 1000) * BYTES_PER_FRAME];
+static a2dp_sink_playback_t playback;
 
 // 
 static int audio_stream_started;
 
-// temp storage of lower-layer request
-static int16_t * request_buffer;
-static int       request_frames;
-
 #define STORE_FROM_PLAYBACK
 
 // WAV File
@@ -204,8 +191,6 @@ static uint8_t media_sbc_codec_configuration[] = {
     2, 53
 }; 
 
-static btstack_resample_t resample_instance;
-
 /* @section Main Application Setup
  *
  * @text The Listing MainConfiguration shows how to setup AD2P Sink and AVRCP controller services. 
@@ -299,37 +284,12 @@ static int a2dp_and_avrcp_setup(void){
 }
 
 static void playback_handler(int16_t * buffer, uint16_t num_audio_frames){
-
-#ifdef STORE_TO_WAV_FILE
-    int       wav_samples = num_audio_frames * NUM_CHANNELS;
-    int16_t * wav_buffer  = buffer;
-#endif
-    
     // called from lower-layer but guaranteed to be on main thread
-    if (sbc_frame_size == 0){
-        memset(buffer, 0, num_audio_frames * BYTES_PER_FRAME);
-        return;
-    }
-
-    // first fill from resampled audio
-    uint32_t bytes_read;
-    btstack_ring_buffer_read(&decoded_audio_ring_buffer, (uint8_t *) buffer, num_audio_frames * BYTES_PER_FRAME, &bytes_read);
-    buffer          += bytes_read / NUM_CHANNELS;
-    num_audio_frames   -= bytes_read / BYTES_PER_FRAME;
-
-    // then start decoding sbc frames using request_* globals
-    request_buffer = buffer;
-    request_frames = num_audio_frames;
-    while (request_frames && btstack_ring_buffer_bytes_available(&sbc_frame_ring_buffer) >= sbc_frame_size){
-        // decode frame
-        uint8_t sbc_frame[MAX_SBC_FRAME_SIZE];
-        btstack_ring_buffer_read(&sbc_frame_ring_buffer, sbc_frame, sbc_frame_size, &bytes_read);
-        btstack_sbc_decoder_process_data(&state, 0, sbc_frame, sbc_frame_size);
-    }
+    a2dp_sink_playback_fill(&playback, buffer, num_audio_frames);
 
 #ifdef STORE_TO_WAV_FILE
     audio_frame_count += num_audio_frames;
-    wav_writer_write_int16(wav_samples, wav_buffer);
+    wav_writer_write_int16(num_audio_frames * NUM_CHANNELS, buffer);
 #endif
 }
 
@@ -347,24 +307,8 @@ static void handle_pcm_data(int16_t * data, int num_audio_frames, int num_channe
         return;
     }
 
-    // resample into request buffer - add some additional space for resampling
-    int16_t  output_buffer[(128+16) * NUM_CHANNELS]; // 16 * 8 * 2
-    uint32_t resampled_frames = btstack_resample_block(&resample_instance, data, num_audio_frames, output_buffer);
-
-    // store data in btstack_audio buffer first
-    int frames_to_copy = btstack_min(resampled_frames, request_frames);
-    memcpy(request_buffer, output_buffer, frames_to_copy * BYTES_PER_FRAME);
-    request_frames  -= frames_to_copy;
-    request_buffer  += frames_to_copy * NUM_CHANNELS;
-
-    // and rest in ring buffer
-    int frames_to_store = resampled_frames - frames_to_copy;
-    if (frames_to_store){
-        int status = btstack_ring_buffer_write(&decoded_audio_ring_buffer, (uint8_t *)&output_buffer[frames_to_copy * NUM_CHANNELS], frames_to_store * BYTES_PER_FRAME);
-        if (status){
-            printf("Error storing samples in PCM ring buffer!!!\n");
-        }
-    }
+    // resample into jitter buffer
+    a2dp_sink_playback_write(&playback, data, num_audio_frames);
 }
 
 static int media_processing_init(avdtp_media_codec_configuration_sbc_t configuration){
@@ -380,9 +324,7 @@ static int media_processing_init(avdtp_media_codec_configuration_sbc_t configura
    sbc_file = fopen(sbc_filename, "wb"); 
 #endif
 
-    btstack_ring_buffer_init(&sbc_frame_ring_buffer, sbc_frame_storage, sizeof(sbc_frame_storage));
-    btstack_ring_buffer_init(&decoded_audio_ring_buffer, decoded_audio_storage, sizeof(decoded_audio_storage));
-    btstack_resample_init(&resample_instance, configuration.num_channels);
+    a2dp_sink_playback_init(&playback, pcm_storage, sizeof(pcm_storage), NUM_CHANNELS, configuration.sampling_frequency, PLAYBACK_TARGET_LATENCY_MS);
 
     // setup audio playback
     const btstack_audio_sink_t * audio = btstack_audio_sink_get_instance();
@@ -413,13 +355,13 @@ static void media_processing_pause(void){
     if (audio){
         audio->stop_stream();
     }
+    a2dp_sink_playback_reset(&playback);
 }
 
 static void media_processing_close(void){
     if (!media_initialized) return;
     media_initialized = 0;
     audio_stream_started = 0;
-    sbc_frame_size = 0;
 
 #ifdef STORE_TO_WAV_FILE                 
     wav_writer_close();
@@ -445,8 +387,9 @@ static void media_processing_close(void){
  *
  * @text Media data packets, in this case the audio data, are received through the handle_l2cap_media_data_packet callback.
  * Currently, only the SBC media codec is supported. Hence, the media data consists of the media packet header and the SBC packet.
- * The SBC frame will be stored in a ring buffer for later processing (instead of decoding it to PCM right away which would require a much larger buffer)
- * If the audio stream wasn't started already and there are enough SBC frames in the ring buffer, start playback.
+ * The SBC frames are decoded right away and the PCM audio is stored by the a2dp_sink_playback engine, which resamples it to compensate
+ * for the clock drift between A2DP Source and the local audio output. If the audio stream wasn't started already, start playback.
+ * The playback engine outputs silence until the target latency is buffered.
  */ 
 
 static int read_media_data_header(uint8_t * packet, int size, int * offset, avdtp_media_packet_header_t * media_header);
@@ -466,50 +409,13 @@ static void handle_l2cap_media_data_packet(uint8_t seid, uint8_t *packet, uint16
     fwrite(packet+pos, size-pos, 1, sbc_file);
 #endif
 
-    const btstack_audio_sink_t * audio = btstack_audio_sink_get_instance();
-    // process data right away if there's no audio implementation active, e.g. on posix systems to store as .wav
-    if (!audio){
-        btstack_sbc_decoder_process_data(&state, 0, packet+pos, size-pos);
-        return;
-    }
-
-    // store sbc frame size for buffer management
-    sbc_frame_size = (size-pos)/ sbc_header.num_frames;
-        
-    int status = btstack_ring_buffer_write(&sbc_frame_ring_buffer, packet+pos, size-pos);
-    if (status){
-        printf("Error storing samples in SBC ring buffer!!!\n");
-    }
-
-    // decide on audio sync drift based on number of sbc frames in queue
-    int sbc_frames_in_buffer = btstack_ring_buffer_bytes_available(&sbc_frame_ring_buffer) / sbc_frame_size;
-    uint32_t resampling_factor;
-
-    // nomimal factor (fixed-point 2^16) and compensation offset
-    uint32_t nomimal_factor = 0x10000;
-    uint32_t compensation   = 0x00100;
-
-    if (sbc_frames_in_buffer < OPTIMAL_FRAMES_MIN){
-    	resampling_factor = nomimal_factor - compensation;    // stretch samples
-    } else if (sbc_frames_in_buffer <= OPTIMAL_FRAMES_MAX){
-    	resampling_factor = nomimal_factor;                   // nothing to do
-    } else {
-    	resampling_factor = nomimal_factor + compensation;    // compress samples
-    }
-
-    btstack_resample_set_factor(&resample_instance, resampling_factor);
-
-    // dump
-    // printf("%6u %03u %05x\n",  (int) btstack_run_loop_get_time_ms(), sbc_frames_in_buffer, resampling_factor);
-    // log_info("%03u %05x", sbc_frames_in_buffer, resampling_factor);
+    btstack_sbc_decoder_process_data(&state, 0, packet+pos, size-pos);
 
-    // start stream if enough frames buffered
-    if (!audio_stream_started && sbc_frames_in_buffer >= OPTIMAL_FRAMES_MIN){
+    // start stream on first media packet
+    const btstack_audio_sink_t * audio = btstack_audio_sink_get_instance();
+    if (audio && !audio_stream_started){
         audio_stream_started = 1;
-        // setup audio playback
-        if (audio){
-            audio->start_stream();
-        }
+        audio->start_stream();
     }
 }
 
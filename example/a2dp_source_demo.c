@@ -78,11 +78,13 @@
 
 #define NUM_CHANNELS                2
 #define BYTES_PER_AUDIO_SAMPLE      (2*NUM_CHANNELS)
-#define AUDIO_TIMEOUT_MS            10 
 #define TABLE_SIZE_441HZ            100
 
 #define SBC_STORAGE_SIZE 1030
 
+// reduce bitpool if more audio than this is waiting to be sent
+#define BITPOOL_CONTROL_TARGET_MS   30
+
 typedef enum {
     STREAM_SINE = 0,
     STREAM_MOD,
@@ -96,16 +98,13 @@ typedef struct {
     uint8_t  stream_opened;
     uint16_t avrcp_cid;
 
-    uint32_t time_audio_data_sent; // ms
-    uint32_t acc_num_missed_samples;
-    uint32_t samples_ready;
-    btstack_timer_source_t audio_timer;
+    a2dp_source_media_pacer_t pacer;
     uint8_t  streaming;
     int      max_media_payload_size;
     
     uint8_t  sbc_storage[SBC_STORAGE_SIZE];
     uint16_t sbc_storage_count;
-    uint8_t  sbc_ready_to_send;
+    a2dp_source_bitpool_control_t bitpool_control;
 } a2dp_media_sending_context_t;
 
 static  uint8_t media_sbc_codec_capabilities[] = {
@@ -274,7 +273,6 @@ static void a2dp_demo_reconfigure_sample_rate(int new_sample_rate){
     }
     sample_rate = new_sample_rate;
     media_tracker.sbc_storage_count = 0;
-    media_tracker.samples_ready = 0;
     hxcmod_unload(&mod_context);
     hxcmod_setcfg(&mod_context, sample_rate, 16, 1, 1, 1);
     hxcmod_load(&mod_context, (void *) &mod_data, mod_len);
@@ -352,13 +350,23 @@ static int a2dp_source_and_avrcp_services_init(void){
 }
 /* LISTING_END */
 
+static int a2dp_demo_fill_sbc_audio_buffer(a2dp_media_sending_context_t * context, uint8_t num_frames);
+
 static void a2dp_demo_send_media_packet(void){
-    int num_bytes_in_frame = btstack_sbc_encoder_sbc_buffer_length();
-    int bytes_in_storage = media_tracker.sbc_storage_count;
-    uint8_t num_frames = bytes_in_storage / num_bytes_in_frame;
-    a2dp_source_stream_send_media_payload(media_tracker.a2dp_cid, media_tracker.local_seid, media_tracker.sbc_storage, bytes_in_storage, num_frames, 0);
-    media_tracker.sbc_storage_count = 0;
-    media_tracker.sbc_ready_to_send = 0;
+    a2dp_media_sending_context_t * context = &media_tracker;
+
+    // adapt bitpool per media packet, so all SBC frames in a packet have the same length
+    uint8_t bitpool = a2dp_source_bitpool_control_update(&context->bitpool_control, context->a2dp_cid, context->local_seid,
+        a2dp_source_media_pacer_get_queued_ms(&context->pacer), BITPOOL_CONTROL_TARGET_MS);
+    btstack_sbc_encoder_state_set_bitpool(&sbc_encoder_state, bitpool);
+
+    // pacer provides number of SBC frames due according to wall clock
+    uint8_t num_frames = a2dp_demo_fill_sbc_audio_buffer(context, a2dp_source_media_pacer_get_num_frames(&context->pacer));
+    if (num_frames == 0) return;
+    a2dp_source_stream_send_media_payload(context->a2dp_cid, context->local_seid, context->sbc_storage, context->sbc_storage_count, num_frames, 0);
+    context->sbc_storage_count = 0;
+    a2dp_source_media_pacer_set_frame_size(&context->pacer, btstack_sbc_encoder_sbc_buffer_length());
+    a2dp_source_media_pacer_packet_sent(&context->pacer, num_frames);
 }
 
 static void produce_sine_audio(int16_t * pcm_buffer, int num_samples_to_write){
@@ -416,12 +424,14 @@ static void produce_audio(int16_t * pcm_buffer, int num_samples){
 #endif
 }
 
-static int a2dp_demo_fill_sbc_audio_buffer(a2dp_media_sending_context_t * context){
-    // perform sbc encodin
-    int total_num_bytes_read = 0;
+static int a2dp_demo_fill_sbc_audio_buffer(a2dp_media_sending_context_t * context, uint8_t num_frames){
+    // perform sbc encoding
+    int num_frames_encoded = 0;
     unsigned int num_audio_samples_per_sbc_buffer = btstack_sbc_encoder_num_audio_frames();
-    while (context->samples_ready >= num_audio_samples_per_sbc_buffer
-        && (context->max_media_payload_size - context->sbc_storage_count) >= btstack_sbc_encoder_sbc_buffer_length()){
+
+    // media payload starts with SBC header
+    while ((num_frames_encoded < num_frames)
+        && (context->max_media_payload_size - 1 - context->sbc_storage_count) >= btstack_sbc_encoder_sbc_buffer_length()){
 
         int16_t pcm_frame[256*NUM_CHANNELS];
 
@@ -431,66 +441,27 @@ static int a2dp_demo_fill_sbc_audio_buffer(a2dp_media_sending_context_t * contex
         uint16_t sbc_frame_size = btstack_sbc_encoder_sbc_buffer_length(); 
         uint8_t * sbc_frame = btstack_sbc_encoder_sbc_buffer();
         
-        total_num_bytes_read += num_audio_samples_per_sbc_buffer;
         memcpy(&context->sbc_storage[context->sbc_storage_count], sbc_frame, sbc_frame_size);
         context->sbc_storage_count += sbc_frame_size;
-        context->samples_ready -= num_audio_samples_per_sbc_buffer;
-    }
-    return total_num_bytes_read;
-}
-
-static void a2dp_demo_audio_timeout_handler(btstack_timer_source_t * timer){
-    a2dp_media_sending_context_t * context = (a2dp_media_sending_context_t *) btstack_run_loop_get_timer_context(timer);
-    btstack_run_loop_set_timer(&context->audio_timer, AUDIO_TIMEOUT_MS); 
-    btstack_run_loop_add_timer(&context->audio_timer);
-    uint32_t now = btstack_run_loop_get_time_ms();
-
-    uint32_t update_period_ms = AUDIO_TIMEOUT_MS;
-    if (context->time_audio_data_sent > 0){
-        update_period_ms = now - context->time_audio_data_sent;
-    } 
-
-    uint32_t num_samples = (update_period_ms * sample_rate) / 1000;
-    context->acc_num_missed_samples += (update_period_ms * sample_rate) % 1000;
-    
-    while (context->acc_num_missed_samples >= 1000){
-        num_samples++;
-        context->acc_num_missed_samples -= 1000;
-    }
-    context->time_audio_data_sent = now;
-    context->samples_ready += num_samples;
-
-    if (context->sbc_ready_to_send) return;
-
-    a2dp_demo_fill_sbc_audio_buffer(context);
-
-    if ((context->sbc_storage_count + btstack_sbc_encoder_sbc_buffer_length()) > context->max_media_payload_size){
-        // schedule sending
-        context->sbc_ready_to_send = 1;
-        a2dp_source_stream_endpoint_request_can_send_now(context->a2dp_cid, context->local_seid);
+        num_frames_encoded++;
     }
+    return num_frames_encoded;
 }
 
 static void a2dp_demo_timer_start(a2dp_media_sending_context_t * context){
     context->max_media_payload_size = btstack_min(a2dp_max_media_payload_size(context->a2dp_cid, context->local_seid), SBC_STORAGE_SIZE);
     context->sbc_storage_count = 0;
-    context->sbc_ready_to_send = 0;
     context->streaming = 1;
-    btstack_run_loop_remove_timer(&context->audio_timer);
-    btstack_run_loop_set_timer_handler(&context->audio_timer, a2dp_demo_audio_timeout_handler);
-    btstack_run_loop_set_timer_context(&context->audio_timer, context);
-    btstack_run_loop_set_timer(&context->audio_timer, AUDIO_TIMEOUT_MS); 
-    btstack_run_loop_add_timer(&context->audio_timer);
+    a2dp_source_media_pacer_init(&context->pacer, context->a2dp_cid, context->local_seid, sample_rate,
+        btstack_sbc_encoder_num_audio_frames(), context->max_media_payload_size);
+    a2dp_source_media_pacer_set_frame_size(&context->pacer, btstack_sbc_encoder_sbc_buffer_length());
+    a2dp_source_media_pacer_start(&context->pacer);
 }
 
 static void a2dp_demo_timer_stop(a2dp_media_sending_context_t * context){
-    context->time_audio_data_sent = 0;
-    context->acc_num_missed_samples = 0;
-    context->samples_ready = 0;
     context->streaming = 1;
     context->sbc_storage_count = 0;
-    context->sbc_ready_to_send = 0;
-    btstack_run_loop_remove_timer(&context->audio_timer);
+    a2dp_source_media_pacer_stop(&context->pacer);
 } 
 
 static void dump_sbc_configuration(avdtp_media_codec_configuration_sbc_t * configuration){
@@ -595,6 +566,8 @@ static void a2dp_source_packet_handler(uint8_t packet_type, uint16_t channel, ui
                 sbc_configuration.allocation_method, sbc_configuration.sampling_frequency, 
                 sbc_configuration.max_bitpool_value,
                 sbc_configuration.channel_mode);
+            a2dp_source_bitpool_control_init(&media_tracker.bitpool_control,
+                sbc_configuration.min_bitpool_value, sbc_configuration.max_bitpool_value);
             break;
         }  
 
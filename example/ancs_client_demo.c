@@ -127,6 +127,9 @@ static void ancs_callback(uint8_t packet_type, uint16_t channel, uint8_t *packet
             if (!attribute_name) break;
             printf("Notification: %s - %s\n", attribute_name, ancs_subevent_client_notification_get_text(packet));
             break;
+        case ANCS_SUBEVENT_CLIENT_APP_DISPLAY_NAME:
+            printf("Notification: DisplayName - %s\n", ancs_subevent_client_app_display_name_get_display_name(packet));
+            break;
         default:
             break;
     }
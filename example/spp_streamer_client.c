@@ -100,9 +100,10 @@ static uint16_t  rfcomm_cid = 0;
 
 /**
  * RFCOMM can make use for ERTM. Due to the need to re-transmit packets,
- * a large buffer is needed to still get high throughput
+ * a large buffer is needed to still get high throughput.
+ * With ENABLE_RFCOMM_HIGH_THROUGHPUT, RFCOMM provides ERTM buffers itself.
  */
-#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE_FOR_RFCOMM
+#if defined(ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE_FOR_RFCOMM) && !defined(ENABLE_RFCOMM_HIGH_THROUGHPUT)
 static uint8_t ertm_buffer[20000];
 static l2cap_ertm_config_t ertm_config = {
     0,       // ertm mandatory
@@ -383,7 +384,7 @@ int btstack_main(int argc, const char * argv[]){
 
     rfcomm_init();
 
-#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE_FOR_RFCOMM
+#if defined(ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE_FOR_RFCOMM) && !defined(ENABLE_RFCOMM_HIGH_THROUGHPUT)
     // setup ERTM management
     rfcomm_enable_l2cap_ertm(&rfcomm_ertm_request_handler, &rfcomm_ertm_released_handler);
 #endif
@@ -1,5 +1,6 @@
 package com.bluekitchen.btstack;
 
+import java.io.BufferedInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -29,7 +30,7 @@ public class SocketConnectionUnix extends SocketConnection {
 			socket = new LocalSocket();
 			LocalSocketAddress socketAddress = new LocalSocketAddress(unixSocketName, LocalSocketAddress.Namespace.FILESYSTEM);
 			socket.connect(socketAddress);
-			in = socket.getInputStream();
+			in = new BufferedInputStream(socket.getInputStream(), RECEIVE_BUFFER_SIZE);
 			out = socket.getOutputStream();
 			return true;
 		} catch (IOException e) {
@@ -79,6 +80,19 @@ public class SocketConnectionUnix extends SocketConnection {
 		Packet packet = new Packet(packetType, channel, inPayload, len);
 		return packet;
 	}
+
+	/* (non-Javadoc)
+	 * @see com.bluekitchen.btstack.SocketConnection#available()
+	 */
+	@Override
+	protected int available() {
+		if (in == null) return 0;
+		try {
+			return in.available();
+		} catch (IOException e) {
+			return 0;
+		}
+	}
 	
 	/* (non-Javadoc)
 	 * @see com.bluekitchen.btstack.SocketConnection#disconnect()
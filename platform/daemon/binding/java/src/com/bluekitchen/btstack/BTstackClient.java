@@ -1,5 +1,8 @@
 package com.bluekitchen.btstack;
 
+import java.util.ArrayList;
+import java.util.List;
+
 import com.bluekitchen.btstack.event.BTstackEventDaemonDisconnect;
 
 public class BTstackClient {
@@ -11,9 +14,11 @@ public class BTstackClient {
 	
 	public static final int DEFAULT_TCP_PORT = 13333;
 	public static final String DEFAULT_UNIX_SOCKET = "/tmp/BTstack";
+	public static final int MAX_PACKETS_PER_LIST = 64;
 
 	private volatile SocketConnection socketConnection;
 	private PacketHandler packetHandler;
+	private PacketListHandler packetListHandler;
 	private boolean connected;
 	private int logicTime = 1;
 	private Thread rxThread;
@@ -37,6 +42,37 @@ public class BTstackClient {
 	public void registerPacketHandler(PacketHandler packetHandler){
 		this.packetHandler = packetHandler;
 	}
+
+	/**
+	 * @brief register handler for all packets received with a single socket read, used instead of packet handler
+	 */
+	public void registerPacketListHandler(PacketListHandler packetListHandler){
+		this.packetListHandler = packetListHandler;
+	}
+
+	private static Packet packetForPacket(Packet packet){
+		switch (packet.getPacketType()){
+			case Packet.HCI_EVENT_PACKET:
+				return EventFactory.eventForPacket(packet);
+			case Packet.L2CAP_DATA_PACKET:
+				return new L2CAPDataPacket(packet);
+			case Packet.RFCOMM_DATA_PACKET:
+				return new RFCOMMDataPacket(packet);
+			default:
+				return packet;
+		}
+	}
+
+	private void dispatchPackets(List<Packet> packets){
+		if (packetListHandler != null){
+			packetListHandler.handlePackets(packets);
+			return;
+		}
+		if (packetHandler == null) return;
+		for (Packet packet : packets){
+			packetHandler.handlePacket(packet);
+		}
+	}
 	
 	public boolean connect(){
 		
@@ -76,31 +112,23 @@ public class BTstackClient {
 			@Override
 			public void run() {
 				while (logicTime == rxThreadId){
-					Packet packet = threadSocketConnection.receivePacket();
+					List<Packet> packets = threadSocketConnection.receivePackets(MAX_PACKETS_PER_LIST);
 					if (Thread.currentThread().isInterrupted()){
 						System.out.println("Rx Thread: exit via interrupt, thread id " + rxThreadId);
 						return;
 					}
-					if (packet == null) {
+					List<Packet> decodedPackets = new ArrayList<Packet>();
+					if (packets == null) {
 						// server disconnected
 						System.out.println("Rx Thread: Daemon Disconnected");
-						packetHandler.handlePacket(new BTstackEventDaemonDisconnect());
+						decodedPackets.add(new BTstackEventDaemonDisconnect());
+						dispatchPackets(decodedPackets);
 						return;
 					}
-					switch (packet.getPacketType()){
-						case Packet.HCI_EVENT_PACKET:
-							packetHandler.handlePacket(EventFactory.eventForPacket(packet));
-							break;
-						case Packet.L2CAP_DATA_PACKET:
-							packetHandler.handlePacket(new L2CAPDataPacket(packet));
-							break;
-						case Packet.RFCOMM_DATA_PACKET:
-							packetHandler.handlePacket(new RFCOMMDataPacket(packet));
-							break;
-						default:
-							packetHandler.handlePacket(packet);
-							break;
+					for (Packet packet : packets){
+						decodedPackets.add(packetForPacket(packet));
 					}
+					dispatchPackets(decodedPackets);
 				}
 				System.out.println("Rx Thread: exit via logic time change, thread id " + rxThreadId);
 			}
@@ -7,7 +7,8 @@ public class Event extends Packet {
 	}
 	
 	public Event(Packet packet){
-		super(HCI_EVENT_PACKET, 0, packet.getBuffer(), packet.getPayloadLen());
+		super(HCI_EVENT_PACKET, packet);
+		this.channel = 0;
 	}
 	
 	/**
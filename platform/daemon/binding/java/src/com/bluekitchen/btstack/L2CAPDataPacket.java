@@ -7,6 +7,6 @@ public class L2CAPDataPacket extends Packet {
 	}
 	
 	public L2CAPDataPacket(Packet packet){
-		super(L2CAP_DATA_PACKET, packet.getChannel(), packet.getBuffer(), packet.getPayloadLen());
+		super(L2CAP_DATA_PACKET, packet);
 	}
 }
\ No newline at end of file
@@ -36,6 +36,16 @@ public class Packet {
 		this.payloadLen = payloadLen;
 	}
 
+	/**
+	 * @brief share buffer of received packet without copy
+	 */
+	protected Packet(int packetType, Packet packet){
+		this.packetType = packetType;
+		this.channel = packet.getChannel();
+		this.data = packet.getBuffer();
+		this.payloadLen = packet.getPayloadLen();
+	}
+
 	public String toString(){
 		StringBuffer t = new StringBuffer();
 		t.append(String.format("Packet %d, channel %d, len %d: ", packetType, channel, payloadLen));
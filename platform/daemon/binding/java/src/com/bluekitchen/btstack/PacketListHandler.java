@@ -0,0 +1,7 @@
+package com.bluekitchen.btstack;
+
+import java.util.List;
+
+public interface PacketListHandler {
+	void handlePackets(List<Packet> packets);
+}
@@ -7,7 +7,7 @@ public class RFCOMMDataPacket extends Packet {
 	}
 	
 	public RFCOMMDataPacket(Packet packet){
-		super(RFCOMM_DATA_PACKET, packet.getChannel(), packet.getBuffer(), packet.getPayloadLen());
+		super(RFCOMM_DATA_PACKET, packet);
 	}
 }
 
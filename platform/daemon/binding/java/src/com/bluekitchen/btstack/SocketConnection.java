@@ -1,13 +1,43 @@
 package com.bluekitchen.btstack;
 
+import java.util.ArrayList;
+import java.util.List;
+
 public abstract class SocketConnection {
 
+	/** size of buffered input stream, allows to read many packets with a single socket read */
+	protected static final int RECEIVE_BUFFER_SIZE = 65536;
+
 	public abstract boolean connect();
 
 	public abstract boolean sendPacket(Packet packet);
 
 	public abstract Packet receivePacket();
 
+	/**
+	 * @brief blocks until a packet is received, then adds all packets that are already buffered
+	 * @return list of up to maxPackets packets, null if disconnected
+	 */
+	public List<Packet> receivePackets(int maxPackets){
+		Packet packet = receivePacket();
+		if (packet == null) return null;
+		List<Packet> packets = new ArrayList<Packet>();
+		packets.add(packet);
+		while ((packets.size() < maxPackets) && (available() > 0)){
+			packet = receivePacket();
+			if (packet == null) break;
+			packets.add(packet);
+		}
+		return packets;
+	}
+
+	/**
+	 * @return number of bytes that can be read without blocking
+	 */
+	protected int available(){
+		return 0;
+	}
+
 	public abstract void disconnect();
 
 	public void setUnixDomainSocketPath(String path) {
@@ -1,5 +1,6 @@
 package com.bluekitchen.btstack;
 
+import java.io.BufferedInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -30,7 +31,7 @@ public class SocketConnectionTCP extends SocketConnection {
 	public boolean connect() {
 		try {
 			socket = new Socket("localhost", port);
-			in = socket.getInputStream();
+			in = new BufferedInputStream(socket.getInputStream(), RECEIVE_BUFFER_SIZE);
 			out = socket.getOutputStream();
 			return true;
 		} catch (IOException e) {
@@ -80,6 +81,19 @@ public class SocketConnectionTCP extends SocketConnection {
 		Packet packet = new Packet(packetType, channel ,inPayload, len);
 		return packet;
 	}
+
+	/* (non-Javadoc)
+	 * @see com.bluekitchen.btstack.SocketConnection#available()
+	 */
+	@Override
+	protected int available() {
+		if (in == null) return 0;
+		try {
+			return in.available();
+		} catch (IOException e) {
+			return 0;
+		}
+	}
 	
 	/* (non-Javadoc)
 	 * @see com.bluekitchen.btstack.SocketConnection#disconnect()
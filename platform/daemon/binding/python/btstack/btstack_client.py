@@ -7,6 +7,12 @@ import time
 BTSTACK_SERVER_HOST = "localhost"
 BTSTACK_SERVER_TCP_PORT = 13333
 
+# receive buffer for batched socket reads, fits at least one packet with max payload
+RECEIVE_BUFFER_SIZE = 0x20000
+
+# packet header: packet type, channel, len
+packet_header = struct.Struct("<HHH")
+
 # utils
 def print_hex(data):
     print(" ".join("{:02x}".format(c) for c in data))
@@ -19,6 +25,9 @@ class BTstackClient(btstack.command_builder.CommandBuilder):
     #
     packet_handler = None
 
+    #
+    packet_list_handler = None
+
     def __init__(self):
         pass
 
@@ -43,6 +52,11 @@ class BTstackClient(btstack.command_builder.CommandBuilder):
         print("[+] Register packet handler")
         self.packet_handler = callback
 
+    def register_packet_list_handler(self, callback):
+        # callback receives list of all events decoded from a single socket read, used instead of packet handler
+        print("[+] Register packet list handler")
+        self.packet_list_handler = callback
+
     def send_hci_command(self, command):
         packet_type = 1
         channel = 0
@@ -52,14 +66,37 @@ class BTstackClient(btstack.command_builder.CommandBuilder):
 
     def run(self):
         print("[+] Run")
+        buffer = bytearray(RECEIVE_BUFFER_SIZE)
+        view = memoryview(buffer)
+        fill = 0
         while True:
-            # receive packet header: packet type, channel, len
-            header = self.btstack_server_socket.recv(6)
-            (packet_type, channel, length) = struct.unpack("<HHH", header)
-            payload = self.btstack_server_socket.recv(length)
-            # print_hex(header+payload)
-            if packet_type == btstack.btstack_types.Packet.HCI_EVENT_PACKET:
-                event = btstack.event_factory.event_for_payload(payload)
-                # print(event)
-                if not self.packet_handler == None:
+            # read as much as available
+            received = self.btstack_server_socket.recv_into(view[fill:])
+            if received == 0:
+                print("[!] Server disconnected")
+                return
+            fill += received
+
+            # decode all complete packets
+            events = []
+            pos = 0
+            while fill - pos >= packet_header.size:
+                (packet_type, channel, length) = packet_header.unpack_from(buffer, pos)
+                start = pos + packet_header.size
+                if fill - start < length:
+                    break
+                pos = start + length
+                if packet_type == btstack.btstack_types.Packet.HCI_EVENT_PACKET:
+                    events.append(btstack.event_factory.event_for_payload(bytes(view[start:pos])))
+
+            # keep partial packet for next read
+            if pos > 0:
+                buffer[0:fill-pos] = buffer[pos:fill]
+                fill -= pos
+
+            if not self.packet_list_handler == None:
+                if len(events) > 0:
+                    self.packet_list_handler(events)
+            elif not self.packet_handler == None:
+                for event in events:
                     self.packet_handler(event)
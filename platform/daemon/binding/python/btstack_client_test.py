@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# BlueKitchen GmbH (c) 2026
+
+# Tests for batched socket reads and generated event decoders, run 'make test' to generate event factory first
+
+import io
+import struct
+import unittest
+import contextlib
+
+from btstack import btstack_client, event_factory
+
+HCI_COMMAND_DATA_PACKET = 1
+HCI_EVENT_PACKET = 4
+
+def packet(packet_type, payload):
+    return struct.pack("<HHH", packet_type, 0, len(payload)) + payload
+
+def btstack_state_event(state):
+    return packet(HCI_EVENT_PACKET, bytes([0x60, 1, state]))
+
+def advertising_report_event(address, rssi, data):
+    payload = bytes([0xe2, 10 + len(data), 0x03, 0x01]) + bytes(reversed(address)) + bytes([rssi, len(data)]) + data
+    return packet(HCI_EVENT_PACKET, payload)
+
+class FakeSocket(object):
+    # delivers one chunk per recv_into call, then signals disconnect
+    def __init__(self, chunks):
+        self.chunks = list(chunks)
+
+    def recv_into(self, view):
+        if len(self.chunks) == 0:
+            return 0
+        chunk = self.chunks.pop(0)
+        view[0:len(chunk)] = chunk
+        return len(chunk)
+
+def run_client(chunks, use_list_handler):
+    received = []
+    client = btstack_client.BTstackClient()
+    client.btstack_server_socket = FakeSocket(chunks)
+    with contextlib.redirect_stdout(io.StringIO()):
+        if use_list_handler:
+            client.register_packet_list_handler(lambda events: received.append(events))
+        else:
+            client.register_packet_handler(lambda event: received.append(event))
+        client.run()
+    return received
+
+class BatchedReadTest(unittest.TestCase):
+
+    def test_single_read_delivers_list(self):
+        data = btstack_state_event(1) + btstack_state_event(2) + btstack_state_event(3)
+        received = run_client([data], True)
+        self.assertEqual(len(received), 1)
+        self.assertEqual([event.get_state() for event in received[0]], [1, 2, 3])
+
+    def test_split_packet_reassembled(self):
+        data = btstack_state_event(1) + btstack_state_event(2)
+        # split inside header of second packet, then inside its payload
+        received = run_client([data[:11], data[11:16], data[16:]], True)
+        self.assertEqual([[event.get_state() for event in events] for events in received], [[1], [2]])
+
+    def test_packet_handler_per_event(self):
+        data = btstack_state_event(1) + btstack_state_event(2)
+        received = run_client([data], False)
+        self.assertEqual([event.get_state() for event in received], [1, 2])
+
+    def test_non_event_packets_skipped(self):
+        data = packet(HCI_COMMAND_DATA_PACKET, bytes([0x03, 0x0c, 0x00])) + btstack_state_event(2)
+        received = run_client([data], True)
+        self.assertEqual(len(received[0]), 1)
+        self.assertIsInstance(received[0][0], event_factory.BTstackEventState)
+
+class EventDecoderTest(unittest.TestCase):
+
+    def test_btstack_state(self):
+        event = event_factory.event_for_payload(btstack_state_event(2)[6:])
+        self.assertIsInstance(event, event_factory.BTstackEventState)
+        self.assertEqual(event.get_state(), 2)
+
+    def test_advertising_report(self):
+        address = bytes([0x00, 0x1b, 0xdc, 0x07, 0x32, 0xef])
+        event = event_factory.event_for_payload(advertising_report_event(address, 0xc4, b'\x02\x01\x06')[6:])
+        self.assertIsInstance(event, event_factory.GAPEventAdvertisingReport)
+        self.assertEqual(event.get_advertising_event_type(), 0x03)
+        self.assertEqual(event.get_address_type(), 0x01)
+        self.assertEqual(str(event.get_address()), "00:1b:dc:07:32:ef")
+        self.assertEqual(event.get_rssi(), 0xc4)
+        self.assertEqual(event.get_data_length(), 3)
+        self.assertEqual(event.get_data(), b'\x02\x01\x06')
+
+if __name__ == '__main__':
+    unittest.main()
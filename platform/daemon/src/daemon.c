@@ -162,6 +162,9 @@ typedef struct {
     
     // discoverable
     uint8_t        discoverable;
+
+    // broadcast HCI events not forwarded to this client, bit per event type
+    uint8_t        event_filter[32];
     
 } client_state_t;
 
@@ -960,6 +963,16 @@ static int btstack_command_handler(connection_t *connection, uint8_t *packet, ui
             // merge state
             gap_discoverable_control(clients_require_discoverable());
             break;
+        case BTSTACK_SET_EVENT_FILTER:
+            log_info("BTSTACK_SET_EVENT_FILTER event type 0x%02x, enabled %u", packet[3], packet[4]);
+            client = client_for_connection(connection);
+            if (!client) break;
+            if (packet[4]){
+                client->event_filter[packet[3] >> 3] &= ~(1 << (packet[3] & 7));
+            } else {
+                client->event_filter[packet[3] >> 3] |=   1 << (packet[3] & 7);
+            }
+            break;
         case BTSTACK_SET_BLUETOOTH_ENABLED:
             log_info("BTSTACK_SET_BLUETOOTH_ENABLED: %u\n", packet[3]);
             if (packet[3]) {
@@ -1482,8 +1495,19 @@ static void daemon_retry_parked(void){
 static void daemon_emit_packet(void * connection, uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     if (connection) {
         socket_connection_send_packet(connection, packet_type, channel, packet, size);
-    } else {
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET){
         socket_connection_send_packet_all(packet_type, channel, packet, size);
+        return;
+    }
+    // only forward events to clients that did not filter them
+    uint8_t event_type = hci_event_packet_get_type(packet);
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) clients; it ; it = it->next){
+        client_state_t * client_state = (client_state_t *) it;
+        if (client_state->event_filter[event_type >> 3] & (1 << (event_type & 7))) continue;
+        socket_connection_send_packet(client_state->connection, packet_type, channel, packet, size);
     }
 }
 
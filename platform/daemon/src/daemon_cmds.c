@@ -97,6 +97,14 @@ const hci_cmd_t btstack_set_bluetooth_enabled = {
 OPCODE(OGF_BTSTACK, BTSTACK_SET_BLUETOOTH_ENABLED), "1"
 };
 
+/**
+ * @param event_type
+ * @param enabled_flag (0 = don't forward event type to this client, 1 = forward, default)
+ */
+const hci_cmd_t btstack_set_event_filter = {
+OPCODE(OGF_BTSTACK, BTSTACK_SET_EVENT_FILTER), "11"
+};
+
 /**
  * @param bd_addr (48)
  * @param psm (16)
@@ -70,6 +70,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #endif
  
@@ -100,6 +101,11 @@ struct sockaddr_un {
 
 #define MAX_PENDING_CONNECTIONS 10
 
+// packets sent to accepted connections are collected and written with a single system call per run loop iteration
+#ifndef SOCKET_CONNECTION_TX_BUFFER_SIZE
+#define SOCKET_CONNECTION_TX_BUFFER_SIZE 8192
+#endif
+
 /** prototypes */
 static void socket_connection_hci_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type);
 static int socket_connection_dummy_handler(connection_t *connection, uint16_t packet_type, uint16_t channel, uint8_t *data, uint16_t length);
@@ -132,6 +138,11 @@ struct connection {
     uint16_t bytes_read;
     uint16_t bytes_to_read;
     uint8_t  buffer[6+HCI_ACL_BUFFER_SIZE]; // packet_header(6) + max packet: 3-DH5 = header(6) + payload (1021)
+#ifndef _WIN32
+    uint8_t  tx_buffered;                    // set for accepted connections
+    uint32_t tx_len;
+    uint8_t  tx_buffer[SOCKET_CONNECTION_TX_BUFFER_SIZE];
+#endif
 };
 
 /** list of socket connections */
@@ -141,6 +152,9 @@ static btstack_linked_list_t parked = NULL;
 #ifdef _WIN32
 // workaround as btstack_data_source_t only stores windows event (instead of fd)
 static int tcp_socket_fd;
+#else
+static btstack_timer_source_t socket_connection_flush_timer;
+static int socket_connection_flush_timer_active;
 #endif
 
 /** client packet handler */
@@ -376,6 +390,17 @@ static void socket_connection_accept(btstack_data_source_t *socket_ds, btstack_d
     log_info("socket_connection_accept new connection %u", fd);
     
     connection_t * connection = socket_connection_register_new_connection(fd);
+    if (connection == NULL) {
+#ifdef _WIN32
+        closesocket(fd);
+#else
+        close(fd);
+#endif
+        return;
+    }
+#ifndef _WIN32
+    connection->tx_buffered = 1;
+#endif
     socket_connection_emit_connection_opened(connection);
 }
 
@@ -555,6 +580,57 @@ void socket_connection_register_packet_callback( int (*packet_callback)(connecti
     socket_connection_packet_callback = packet_callback;
 }
 
+#ifndef _WIN32
+static void socket_connection_writev(int fd, struct iovec * iov, int iovcnt){
+    // blocking socket, continue after partial write. errors are detected by read in socket_connection_hci_process
+    while (iovcnt > 0){
+        ssize_t res = writev(fd, iov, iovcnt);
+        if (res < 0){
+            if (errno == EINTR) continue;
+            return;
+        }
+        size_t bytes_written = (size_t) res;
+        while ((iovcnt > 0) && (bytes_written >= iov->iov_len)){
+            bytes_written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0){
+            iov->iov_base = ((uint8_t *) iov->iov_base) + bytes_written;
+            iov->iov_len -= bytes_written;
+        }
+    }
+}
+
+static void socket_connection_flush(connection_t *conn){
+    if (conn->tx_len == 0) return;
+    struct iovec iov;
+    iov.iov_base = conn->tx_buffer;
+    iov.iov_len  = conn->tx_len;
+    conn->tx_len = 0;
+    socket_connection_writev(conn->socket_fd, &iov, 1);
+}
+
+static void socket_connection_flush_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    socket_connection_flush_timer_active = 0;
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) connections; it ; it = it->next){
+        linked_connection_t * linked_connection = (linked_connection_t *) it;
+        socket_connection_flush(linked_connection->connection);
+    }
+}
+
+static void socket_connection_trigger_flush(void){
+    if (socket_connection_flush_timer_active) return;
+    socket_connection_flush_timer_active = 1;
+    // timers are processed after the data sources, i.e. all packets created in this run loop iteration get collected
+    btstack_run_loop_set_timer_handler(&socket_connection_flush_timer, &socket_connection_flush_timer_handler);
+    btstack_run_loop_set_timer(&socket_connection_flush_timer, 0);
+    btstack_run_loop_add_timer(&socket_connection_flush_timer);
+}
+#endif
+
 /**
  * send HCI packet to single connection
  */
@@ -563,17 +639,33 @@ void socket_connection_send_packet(connection_t *conn, uint16_t type, uint16_t c
     little_endian_store_16(header, 0, type);
     little_endian_store_16(header, 2, channel);
     little_endian_store_16(header, 4, size);
+#ifdef _WIN32
     // avoid -Wunused-result
     int res;
-#ifdef _WIN32
     int flags = 0;
     res = send(conn->socket_fd, (const char *) header, 6, flags);
     res = send(conn->socket_fd, (const char *) packet, size, flags);
+    UNUSED(res);
 #else
-    res = write(conn->socket_fd, header, 6);
-    res = write(conn->socket_fd, packet, size);
+    uint32_t packet_len = sizeof(packet_header_t) + size;
+    if (conn->tx_buffered && ((conn->tx_len + packet_len) <= SOCKET_CONNECTION_TX_BUFFER_SIZE)){
+        memcpy(&conn->tx_buffer[conn->tx_len], header, sizeof(packet_header_t));
+        memcpy(&conn->tx_buffer[conn->tx_len + sizeof(packet_header_t)], packet, size);
+        conn->tx_len += packet_len;
+        socket_connection_trigger_flush();
+        return;
+    }
+    // write pending data, header and packet with a single call
+    struct iovec iov[3];
+    iov[0].iov_base = conn->tx_buffer;
+    iov[0].iov_len  = conn->tx_len;
+    iov[1].iov_base = header;
+    iov[1].iov_len  = sizeof(packet_header_t);
+    iov[2].iov_base = packet;
+    iov[2].iov_len  = size;
+    conn->tx_len = 0;
+    socket_connection_writev(conn->socket_fd, iov, 3);
 #endif
-    UNUSED(res);
 }
 
 /**
@@ -57,6 +57,7 @@
 
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_embedded.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_linked_list.h"
 #include "btstack_util.h"
 #include "hal_tick.h"
@@ -74,6 +75,10 @@
 #error "Please specify either HAVE_EMBEDDED_TICK or HAVE_EMBEDDED_TIME_MS"
 #endif
 
+#if defined(HAVE_EMBEDDED_TICKLESS) && !defined(HAVE_EMBEDDED_TICK)
+#error "HAVE_EMBEDDED_TICKLESS requires HAVE_EMBEDDED_TICK"
+#endif
+
 #if defined(HAVE_EMBEDDED_TICK) || defined(HAVE_EMBEDDED_TIME_MS)
 #define TIMER_SUPPORT
 #endif
@@ -81,16 +86,27 @@
 // the run loop
 static btstack_linked_list_t data_sources;
 
-#ifdef TIMER_SUPPORT
-static btstack_linked_list_t timers;
-#endif
-
 #ifdef HAVE_EMBEDDED_TICK
 static volatile uint32_t system_ticks;
 #endif
 
 static int trigger_event_received = 0;
 
+#ifdef HAVE_EMBEDDED_TICKLESS
+// add ticks elapsed since last update to system ticks, IRQs must be disabled
+static uint32_t btstack_run_loop_embedded_update_ticks_irqs_disabled(void){
+    system_ticks += hal_tick_get_elapsed_ticks();
+    return system_ticks;
+}
+
+static uint32_t btstack_run_loop_embedded_update_ticks(void){
+    hal_cpu_disable_irqs();
+    uint32_t now = btstack_run_loop_embedded_update_ticks_irqs_disabled();
+    hal_cpu_enable_irqs();
+    return now;
+}
+#endif
+
 /**
  * Add data_source to run_loop
  */
@@ -111,7 +127,7 @@ static void btstack_run_loop_embedded_set_timer(btstack_timer_source_t *ts, uint
     uint32_t ticks = btstack_run_loop_embedded_ticks_for_ms(timeout_in_ms);
     if (ticks == 0) ticks++;
     // time until next tick is < hal_tick_get_tick_period_in_ms() and we don't know, so we add one
-    ts->timeout = system_ticks + 1 + ticks; 
+    ts->timeout = btstack_run_loop_embedded_get_ticks() + 1 + ticks;
 #endif
 #ifdef HAVE_EMBEDDED_TIME_MS
     ts->timeout = hal_time_ms() + timeout_in_ms + 1;
@@ -119,25 +135,11 @@ static void btstack_run_loop_embedded_set_timer(btstack_timer_source_t *ts, uint
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_embedded_add_timer(btstack_timer_source_t *ts){
 #ifdef TIMER_SUPPORT
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
 #endif
 }
 
@@ -146,7 +148,7 @@ static void btstack_run_loop_embedded_add_timer(btstack_timer_source_t *ts){
  */
 static bool btstack_run_loop_embedded_remove_timer(btstack_timer_source_t *ts){
 #ifdef TIMER_SUPPORT
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(ts);
 #else
     return 0;
 #endif
@@ -155,12 +157,7 @@ static bool btstack_run_loop_embedded_remove_timer(btstack_timer_source_t *ts){
 static void btstack_run_loop_embedded_dump_timer(void){
 #ifdef TIMER_SUPPORT
 #ifdef ENABLE_LOG_INFO 
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer();
 #endif
 #endif
 }
@@ -184,28 +181,30 @@ void btstack_run_loop_embedded_execute_once(void) {
     for (ds = (btstack_data_source_t *) data_sources; ds != NULL ; ds = next){
         next = (btstack_data_source_t *) ds->item.next; // cache pointer to next data_source to allow data source to remove itself
         if (ds->flags & DATA_SOURCE_CALLBACK_POLL){
-            ds->process(ds, DATA_SOURCE_CALLBACK_POLL);
+            btstack_run_loop_base_process_data_source(ds, DATA_SOURCE_CALLBACK_POLL);
         }
     }
+
+    // execute callbacks from btstack_run_loop_execute_on_main_thread
+    while (true){
+        hal_cpu_disable_irqs();
+        btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+        hal_cpu_enable_irqs();
+        if (callback_registration == NULL) break;
+        btstack_run_loop_base_execute_callback(callback_registration);
+    }
     
 #ifdef TIMER_SUPPORT
 
 #ifdef HAVE_EMBEDDED_TICK
-    uint32_t now = system_ticks;
+    uint32_t now = btstack_run_loop_embedded_get_ticks();
 #endif
 #ifdef HAVE_EMBEDDED_TIME_MS
     uint32_t now = hal_time_ms();
 #endif
 
     // process timers
-    while (timers) {
-        btstack_timer_source_t * ts = (btstack_timer_source_t *) timers;
-        int32_t delta = btstack_time_delta(ts->timeout, now);
-        if (delta > 0) break;
-
-        btstack_run_loop_embedded_remove_timer(ts);
-        ts->process(ts);
-    }
+    btstack_run_loop_base_process_timers(now);
 #endif
     
     // disable IRQs and check if run loop iteration has been requested. if not, go to sleep
@@ -213,9 +212,18 @@ void btstack_run_loop_embedded_execute_once(void) {
     if (trigger_event_received){
         trigger_event_received = 0;
         hal_cpu_enable_irqs();
-    } else {
-        hal_cpu_enable_irqs_and_sleep();
+        return;
     }
+#ifdef HAVE_EMBEDDED_TICKLESS
+    // program wakeup for next timer, skip sleep if it's already due
+    int32_t ticks_until_timeout = btstack_run_loop_base_get_time_until_timeout(btstack_run_loop_embedded_update_ticks_irqs_disabled());
+    if (ticks_until_timeout == 0){
+        hal_cpu_enable_irqs();
+        return;
+    }
+    hal_tick_set_timeout((ticks_until_timeout < 0) ? 0 : (uint32_t) ticks_until_timeout);
+#endif
+    hal_cpu_enable_irqs_and_sleep();
 }
 
 /**
@@ -229,12 +237,19 @@ static void btstack_run_loop_embedded_execute(void) {
 
 #ifdef HAVE_EMBEDDED_TICK
 static void btstack_run_loop_embedded_tick_handler(void){
+#ifndef HAVE_EMBEDDED_TICKLESS
+    // in tickless mode, elapsed ticks are provided by hal_tick_get_elapsed_ticks
     system_ticks++;
+#endif
     trigger_event_received = 1;
 }
 
 uint32_t btstack_run_loop_embedded_get_ticks(void){
+#ifdef HAVE_EMBEDDED_TICKLESS
+    return btstack_run_loop_embedded_update_ticks();
+#else
     return system_ticks;
+#endif
 }
 
 uint32_t btstack_run_loop_embedded_ticks_for_ms(uint32_t time_in_ms){
@@ -246,7 +261,7 @@ static uint32_t btstack_run_loop_embedded_get_time_ms(void){
 #if   defined(HAVE_EMBEDDED_TIME_MS)
     return hal_time_ms();
 #elif defined(HAVE_EMBEDDED_TICK)
-    return system_ticks * hal_tick_get_tick_period_in_ms();
+    return btstack_run_loop_embedded_get_ticks() * hal_tick_get_tick_period_in_ms();
 #else
     return 0;
 #endif
@@ -260,12 +275,17 @@ void btstack_run_loop_embedded_trigger(void){
     trigger_event_received = 1;
 }
 
+static void btstack_run_loop_embedded_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    hal_cpu_disable_irqs();
+    btstack_run_loop_base_add_callback(callback_registration);
+    trigger_event_received = 1;
+    hal_cpu_enable_irqs();
+}
+
 static void btstack_run_loop_embedded_init(void){
     data_sources = NULL;
 
-#ifdef TIMER_SUPPORT
-    timers = NULL;
-#endif
+    btstack_run_loop_base_init();
 
 #ifdef HAVE_EMBEDDED_TICK
     system_ticks = 0;
@@ -290,6 +310,7 @@ static const btstack_run_loop_t btstack_run_loop_embedded = {
     &btstack_run_loop_embedded_execute,
     &btstack_run_loop_embedded_dump_timer,
     &btstack_run_loop_embedded_get_time_ms,
+    &btstack_run_loop_embedded_execute_on_main_thread,
 };
 
 const btstack_run_loop_t * btstack_run_loop_embedded_get_instance(void){
@@ -69,6 +69,18 @@
 #define BTSTACK_FLASH_ALIGNMENT_MAX 8
 #endif
 
+// ENABLE_TLV_FLASH_DEFERRED_ERASE
+//
+// Erasing a bank blocks the CPU on most MCUs. By default, the unused bank is erased at the start of a migration,
+// i.e. while storing a tag. With ENABLE_TLV_FLASH_DEFERRED_ERASE, the unused bank is erased from a timer after
+// TLV_FLASH_DEFERRED_ERASE_DELAY_MS instead, so that a later migration finds it already erased.
+
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+#ifndef TLV_FLASH_DEFERRED_ERASE_DELAY_MS
+#define TLV_FLASH_DEFERRED_ERASE_DELAY_MS 1000
+#endif
+#endif
+
 static const char * btstack_tlv_header_magic = "BTstack";
 
 // TLV Iterator
@@ -178,6 +190,60 @@ static void tlv_iterator_fetch_next(btstack_tlv_flash_bank_t * self, tlv_iterato
 
 //
 
+#ifdef ENABLE_TLV_FLASH_INDEX
+
+static void btstack_tlv_flash_bank_index_reset(btstack_tlv_flash_bank_t * self){
+	self->index_valid = 1;
+	self->index_count = 0;
+}
+
+static btstack_tlv_flash_bank_index_entry_t * btstack_tlv_flash_bank_index_find(btstack_tlv_flash_bank_t * self, uint32_t tag){
+	uint16_t i;
+	for (i=0;i<self->index_count;i++){
+		if (self->index[i].tag == tag) return &self->index[i];
+	}
+	return NULL;
+}
+
+static void btstack_tlv_flash_bank_index_set(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t offset, uint32_t len){
+	if (!self->index_valid) return;
+	btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+	if (entry == NULL){
+		if (self->index_count >= TLV_FLASH_INDEX_SIZE){
+			log_info("index full, fall back to bank scan");
+			self->index_valid = 0;
+			return;
+		}
+		entry = &self->index[self->index_count++];
+		entry->tag = tag;
+	}
+	entry->offset = offset;
+	entry->len    = len;
+}
+
+static void btstack_tlv_flash_bank_index_remove(btstack_tlv_flash_bank_t * self, uint32_t tag){
+	if (!self->index_valid) return;
+	btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+	if (entry == NULL) return;
+	// replace with last entry
+	self->index_count--;
+	*entry = self->index[self->index_count];
+}
+
+static void btstack_tlv_flash_bank_index_build(btstack_tlv_flash_bank_t * self){
+	btstack_tlv_flash_bank_index_reset(self);
+	tlv_iterator_t it;
+	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
+	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
+		if (it.tag){
+			btstack_tlv_flash_bank_index_set(self, it.tag, it.offset, it.len);
+		}
+		tlv_iterator_fetch_next(self, &it);
+	}
+	log_info("index valid %u, %u tags", self->index_valid, self->index_count);
+}
+#endif
+
 // check both banks for headers and pick the one with the higher epoch % 4
 // @returns bank or -1 if something is invalid
 static int btstack_tlv_flash_bank_get_latest_bank(btstack_tlv_flash_bank_t * self){
@@ -237,6 +303,21 @@ static void btstack_tlv_flash_bank_erase_bank(btstack_tlv_flash_bank_t * self, i
 	}
 }
 
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+static void btstack_tlv_flash_bank_handle_erase_timeout(btstack_timer_source_t * ts){
+	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) btstack_run_loop_get_timer_context(ts);
+	btstack_tlv_flash_bank_erase_bank(self, 1 - self->current_bank);
+}
+
+static void btstack_tlv_flash_bank_schedule_erase(btstack_tlv_flash_bank_t * self){
+	btstack_run_loop_remove_timer(&self->erase_timer);
+	btstack_run_loop_set_timer_handler(&self->erase_timer, &btstack_tlv_flash_bank_handle_erase_timeout);
+	btstack_run_loop_set_timer_context(&self->erase_timer, self);
+	btstack_run_loop_set_timer(&self->erase_timer, TLV_FLASH_DEFERRED_ERASE_DELAY_MS);
+	btstack_run_loop_add_timer(&self->erase_timer);
+}
+#endif
+
 static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 
 	int next_bank = 1 - self->current_bank;
@@ -245,6 +326,10 @@ static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 	btstack_tlv_flash_bank_erase_bank(self, next_bank);
 	int next_write_pos = 8;
 
+#ifdef ENABLE_TLV_FLASH_INDEX
+	btstack_tlv_flash_bank_index_reset(self);
+#endif
+
 	tlv_iterator_t it;
 	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
 	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
@@ -255,6 +340,10 @@ static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 
 			log_info("migrate pos %u, tag '%x' len %u -> new pos %u", tag_index, it.tag, tag_len, next_write_pos);
 
+#ifdef ENABLE_TLV_FLASH_INDEX
+			btstack_tlv_flash_bank_index_set(self, it.tag, next_write_pos, tag_len);
+#endif
+
 			// copy header
 			uint8_t header_buffer[8];
 			btstack_tlv_flash_bank_read(self, self->current_bank, tag_index,      header_buffer, 8);
@@ -288,25 +377,42 @@ static void btstack_tlv_flash_bank_migrate(btstack_tlv_flash_bank_t * self){
 	btstack_tlv_flash_bank_write_header(self, next_bank, (epoch_buffer + 1) & 3);
 	self->current_bank = next_bank;
 	self->write_offset = next_write_pos;
+
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+	btstack_tlv_flash_bank_schedule_erase(self);
+#endif
 }
 
-static void btstack_tlv_flash_bank_delete_tag_until_offset(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t offset){
-	tlv_iterator_t it;
-	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
-	while (btstack_tlv_flash_bank_iterator_has_next(self, &it) && it.offset < offset){
-		if (it.tag == tag){
-			log_info("Erase tag '%x' at position %u", tag, it.offset);
+static void btstack_tlv_flash_bank_mark_deleted(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t offset){
+	log_info("Erase tag '%x' at position %u", tag, offset);
 
-			// mark entry as invalid
-			uint32_t zero_value = 0;
+	// mark entry as invalid
+	uint32_t zero_value = 0;
 #ifdef ENABLE_TLV_FLASH_EXPLICIT_DELETE_FIELD
-			// write delete field at offset 8
-			btstack_tlv_flash_bank_write(self, self->current_bank, it.offset+8, (uint8_t*) &zero_value, sizeof(zero_value));
+	// write delete field at offset 8
+	btstack_tlv_flash_bank_write(self, self->current_bank, offset+8, (uint8_t*) &zero_value, sizeof(zero_value));
 #else
-			// overwrite tag with zero value
-			btstack_tlv_flash_bank_write(self, self->current_bank, it.offset, (uint8_t*) &zero_value, sizeof(zero_value));
+	// overwrite tag with zero value
+	btstack_tlv_flash_bank_write(self, self->current_bank, offset, (uint8_t*) &zero_value, sizeof(zero_value));
 #endif
+}
 
+static void btstack_tlv_flash_bank_delete_tag_until_offset(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t offset){
+#ifdef ENABLE_TLV_FLASH_INDEX
+	// index contains the only valid entry for tag
+	if (self->index_valid){
+		btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+		if ((entry != NULL) && (entry->offset < offset)){
+			btstack_tlv_flash_bank_mark_deleted(self, tag, entry->offset);
+		}
+		return;
+	}
+#endif
+	tlv_iterator_t it;
+	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
+	while (btstack_tlv_flash_bank_iterator_has_next(self, &it) && it.offset < offset){
+		if (it.tag == tag){
+			btstack_tlv_flash_bank_mark_deleted(self, tag, it.offset);
 		}
 		tlv_iterator_fetch_next(self, &it);
 	}
@@ -325,16 +431,27 @@ static int btstack_tlv_flash_bank_get_tag(void * context, uint32_t tag, uint8_t
 
 	uint32_t tag_index = 0;
 	uint32_t tag_len   = 0;
-	tlv_iterator_t it;
-	btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
-	while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
-		if (it.tag == tag){
-			log_info("Found tag '%x' at position %u", tag, it.offset);
-			tag_index = it.offset;
-			tag_len   = it.len;
-			break;
+#ifdef ENABLE_TLV_FLASH_INDEX
+	if (self->index_valid){
+		btstack_tlv_flash_bank_index_entry_t * entry = btstack_tlv_flash_bank_index_find(self, tag);
+		if (entry != NULL){
+			tag_index = entry->offset;
+			tag_len   = entry->len;
+		}
+	} else
+#endif
+	{
+		tlv_iterator_t it;
+		btstack_tlv_flash_bank_iterator_init(self, &it, self->current_bank);
+		while (btstack_tlv_flash_bank_iterator_has_next(self, &it)){
+			if (it.tag == tag){
+				log_info("Found tag '%x' at position %u", tag, it.offset);
+				tag_index = it.offset;
+				tag_len   = it.len;
+				break;
+			}
+			tlv_iterator_fetch_next(self, &it);
 		}
-		tlv_iterator_fetch_next(self, &it);
 	}
 	if (tag_index == 0) return 0;
 	if (!buffer) return tag_len;
@@ -391,6 +508,10 @@ static int btstack_tlv_flash_bank_store_tag(void * context, uint32_t tag, const
 	// overwrite old entries (if exists)
 	btstack_tlv_flash_bank_delete_tag_until_offset(self, tag, self->write_offset);
 
+#ifdef ENABLE_TLV_FLASH_INDEX
+	btstack_tlv_flash_bank_index_set(self, tag, self->write_offset, data_size);
+#endif
+
 	// done
 	self->write_offset += sizeof(entry) + btstack_tlv_flash_bank_align_size(self, data_size);
 
@@ -409,6 +530,9 @@ static int btstack_tlv_flash_bank_store_tag(void * context, uint32_t tag, const
 static void btstack_tlv_flash_bank_delete_tag(void * context, uint32_t tag){
 	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) context;
 	btstack_tlv_flash_bank_delete_tag_until_offset(self, tag, self->write_offset);
+#ifdef ENABLE_TLV_FLASH_INDEX
+	btstack_tlv_flash_bank_index_remove(self, tag);
+#endif
 }
 
 static const btstack_tlv_t btstack_tlv_flash_bank = {
@@ -425,6 +549,13 @@ const btstack_tlv_t * btstack_tlv_flash_bank_init_instance(btstack_tlv_flash_ban
 	self->hal_flash_bank_impl    = hal_flash_bank_impl;
 	self->hal_flash_bank_context = hal_flash_bank_context;
 	self->delete_tag_len = 0;
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+	memset(&self->erase_timer, 0, sizeof(btstack_timer_source_t));
+#endif
+#ifdef ENABLE_TLV_FLASH_INDEX
+	// scan bank until index is built
+	self->index_valid = 0;
+#endif
 
 #ifdef ENABLE_TLV_FLASH_EXPLICIT_DELETE_FIELD
 	if (hal_flash_bank_impl->get_alignment(hal_flash_bank_context) > 8){
@@ -483,6 +614,15 @@ const btstack_tlv_t * btstack_tlv_flash_bank_init_instance(btstack_tlv_flash_ban
 		self->write_offset = 8;
 	}
 
+#ifdef ENABLE_TLV_FLASH_INDEX
+	btstack_tlv_flash_bank_index_build(self);
+#endif
+
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+	// prepare other bank for next migration
+	btstack_tlv_flash_bank_schedule_erase(self);
+#endif
+
 	log_info("write offset %u", self->write_offset);
 	return &btstack_tlv_flash_bank;
 }
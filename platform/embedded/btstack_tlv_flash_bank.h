@@ -40,23 +40,51 @@
 #define BTSTACK_TLV_FLASH_BANK_H
 
 #include <stdint.h>
+#include "btstack_config.h"
 #include "btstack_tlv.h"
 #include "hal_flash_bank.h"
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+#include "btstack_run_loop.h"
+#endif
 
 #if defined __cplusplus
 extern "C" {
 #endif
 
+#ifdef ENABLE_TLV_FLASH_INDEX
+#ifndef TLV_FLASH_INDEX_SIZE
+#define TLV_FLASH_INDEX_SIZE 32
+#endif
+
+// location of latest entry for tag in current bank
+typedef struct {
+	uint32_t tag;
+	uint32_t offset;
+	uint32_t len;
+} btstack_tlv_flash_bank_index_entry_t;
+#endif
+
 typedef struct {
 	const hal_flash_bank_t * hal_flash_bank_impl;
 	void * hal_flash_bank_context;
 	int current_bank;
 	int write_offset;
 	int delete_tag_len;
+#ifdef ENABLE_TLV_FLASH_INDEX
+	// index is not used if there are more than TLV_FLASH_INDEX_SIZE tags
+	int index_valid;
+	uint16_t index_count;
+	btstack_tlv_flash_bank_index_entry_t index[TLV_FLASH_INDEX_SIZE];
+#endif
+#ifdef ENABLE_TLV_FLASH_DEFERRED_ERASE
+	// erases unused bank after migration
+	btstack_timer_source_t erase_timer;
+#endif
 } btstack_tlv_flash_bank_t;
 
 /**
  * Init Tag Length Value Store
+ * @note with ENABLE_TLV_FLASH_DEFERRED_ERASE, the run loop needs to be initialized first
  * @param context btstack_tlv_flash_bank_t 
  * @param hal_flash_bank_impl    of hal_flash_bank interface
  * @Param hal_flash_bank_context of hal_flash_bank_interface
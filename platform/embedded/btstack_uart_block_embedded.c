@@ -58,11 +58,18 @@ static btstack_data_source_t transport_data_source;
 static int send_complete;
 static int receive_complete;
 static int wakeup_event;
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+static int bytes_received_complete;
+static uint16_t bytes_received_len;
+#endif
 
 // callbacks
 static void (*block_sent)(void);
 static void (*block_received)(void);
 static void (*wakeup_handler)(void);
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+static void (*bytes_received)(uint16_t num_bytes);
+#endif
 
 
 static void btstack_uart_block_received(void){
@@ -75,6 +82,14 @@ static void btstack_uart_block_sent(void){
     btstack_run_loop_embedded_trigger();
 }
 
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+static void btstack_uart_bytes_received(uint16_t num_bytes){
+    bytes_received_len = num_bytes;
+    bytes_received_complete = 1;
+    btstack_run_loop_embedded_trigger();
+}
+#endif
+
 static void btstack_uart_cts_pulse(void){
     wakeup_event = 1;
     btstack_run_loop_embedded_trigger();
@@ -84,6 +99,9 @@ static int btstack_uart_embedded_init(const btstack_uart_config_t * config){
     uart_config = config;
     hal_uart_dma_set_block_received(&btstack_uart_block_received);
     hal_uart_dma_set_block_sent(&btstack_uart_block_sent);
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+    hal_uart_dma_set_bytes_received(&btstack_uart_bytes_received);
+#endif
     return 0;
 }
 
@@ -102,6 +120,14 @@ static void btstack_uart_embedded_process(btstack_data_source_t *ds, btstack_dat
                     block_received();
                 }
             }
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+            if (bytes_received_complete){
+                bytes_received_complete = 0;
+                if (bytes_received){
+                    bytes_received(bytes_received_len);
+                }
+            }
+#endif
             if (wakeup_event){
                 wakeup_event = 0;
                 if (wakeup_handler){
@@ -160,6 +186,16 @@ static void btstack_uart_embedded_receive_block(uint8_t *buffer, uint16_t len){
     hal_uart_dma_receive_block(buffer, len);
 }
 
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+static void btstack_uart_embedded_set_bytes_received( void (*bytes_handler)(uint16_t num_bytes)){
+    bytes_received = bytes_handler;
+}
+
+static void btstack_uart_embedded_receive_bytes(uint8_t *buffer, uint16_t max_len){
+    hal_uart_dma_receive_to_idle(buffer, max_len);
+}
+#endif
+
 static int btstack_uart_embedded_get_supported_sleep_modes(void){
 #ifdef HAVE_HAL_UART_DMA_SLEEP_MODES
 	return hal_uart_dma_get_supported_sleep_modes();
@@ -202,6 +238,13 @@ static const btstack_uart_block_t btstack_uart_embedded = {
 	/* int (*get_supported_sleep_modes); */                           &btstack_uart_embedded_get_supported_sleep_modes,
     /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    &btstack_uart_embedded_set_sleep,
     /* void (*set_wakeup_handler)(void (*handler)(void)); */          &btstack_uart_embedded_set_wakeup_handler,
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+    /* void (*set_bytes_received)(void (*handler)(uint16_t)); */      &btstack_uart_embedded_set_bytes_received,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */   &btstack_uart_embedded_receive_bytes,
+#else
+    /* void (*set_bytes_received)(void (*handler)(uint16_t)); */      NULL,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */   NULL,
+#endif
 };
 
 const btstack_uart_block_t * btstack_uart_block_embedded_instance(void){
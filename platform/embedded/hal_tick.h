@@ -55,6 +55,21 @@ void hal_tick_init(void);
 void hal_tick_set_handler(void (*tick_handler)(void));
 int  hal_tick_get_tick_period_in_ms(void);
 
+// HAVE_EMBEDDED_TICKLESS: tick handler is only called by one-shot timer programmed with hal_tick_set_timeout
+
+/**
+ * @brief Program one-shot timer that calls tick handler after given number of ticks, replaces previous timeout
+ * @param ticks until tick handler gets called, 0 = stop timer
+ * @note Called with IRQs disabled
+ */
+void hal_tick_set_timeout(uint32_t ticks);
+
+/**
+ * @brief Get number of ticks elapsed since previous call, the HAL keeps track of partial ticks
+ * @note Called with IRQs disabled
+ */
+uint32_t hal_tick_get_elapsed_ticks(void);
+
 #if defined __cplusplus
 }
 #endif
@@ -45,6 +45,9 @@
  *
  * If HAVE_HAL_UART_DMA_SLEEP_MODES is defined, different sleeps modes can be provided and used
  *
+ * If HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE is defined, DMA receive up to a max length that completes on idle RX line
+ * can be provided and used for batched reads, e.g. by H4 with ENABLE_H4_RX_BATCH
+ *
  */
 
 #ifndef HAL_UART_DMA_H
@@ -102,6 +105,24 @@ void hal_uart_dma_send_block(const uint8_t *buffer, uint16_t length);
  */
 void hal_uart_dma_receive_block(uint8_t *buffer, uint16_t len);
 
+#ifdef HAVE_HAL_UART_DMA_RECEIVE_TO_IDLE
+
+/**
+ * @brief Set callback for bytes received by hal_uart_dma_receive_to_idle - can be called from ISR context
+ * @param callback with number of bytes received
+ */
+void hal_uart_dma_set_bytes_received( void (*callback)(uint16_t num_bytes));
+
+/**
+ * @brief Receive up to max_len bytes. When buffer is full or RX line is idle after at least one byte,
+ *        e.g. for one character time, DMA is stopped and callback set by hal_uart_dma_set_bytes_received must be called
+ * @param buffer
+ * @param max_len
+ */
+void hal_uart_dma_receive_to_idle(uint8_t *buffer, uint16_t max_len);
+
+#endif
+
 /**
  * @brief Set or clear callback for CSR pulse - can be called from ISR context
  * @param csr_irq_handler or NULL to disable IRQ handler
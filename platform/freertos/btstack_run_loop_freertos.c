@@ -46,8 +46,10 @@
 #define BTSTACK_FILE__ "btstack_run_loop_freertos.c"
 
 #include <stddef.h> // NULL
+#include <string.h>
 
 #include "btstack_run_loop_freertos.h"
+#include "btstack_run_loop_base.h"
 
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
@@ -61,11 +63,13 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 #else
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
 #include "event_groups.h"
 #endif
 
@@ -90,11 +94,15 @@ typedef struct function_call {
 #ifdef USE_STATIC_ALLOC
 static StaticQueue_t btstack_run_loop_queue_object;
 static uint8_t btstack_run_loop_queue_storage[ RUN_LOOP_QUEUE_LENGTH * RUN_LOOP_QUEUE_ITEM_SIZE ];
+static StaticSemaphore_t btstack_run_loop_callbacks_mutex_object;
 #endif
 
 static QueueHandle_t        btstack_run_loop_queue;
 static TaskHandle_t         btstack_run_loop_task;
 
+// protects list of callbacks from btstack_run_loop_execute_on_main_thread
+static SemaphoreHandle_t    btstack_run_loop_callbacks_mutex;
+
 #ifndef HAVE_FREERTOS_TASK_NOTIFICATIONS
 static EventGroupHandle_t   btstack_run_loop_event_group;
 #endif
@@ -102,11 +110,23 @@ static EventGroupHandle_t   btstack_run_loop_event_group;
 // bit 0 event group reserved to wakeup run loop
 #define EVENT_GROUP_FLAG_RUN_LOOP 1
 
+// data sources with DATA_SOURCE_CALLBACK_READ get one of the following event group bits
+// default fits into 8 bit event groups used with configUSE_16_BIT_TICKS
+#ifndef BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES
+#define BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES 7
+#endif
+
+#define EVENT_GROUP_FLAGS_ALL ((1u << (BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES + 1)) - 1u)
+
 // the run loop
-static btstack_linked_list_t timers;
 static btstack_linked_list_t data_sources;
 static bool run_loop_exit_requested;
 
+// data source for event bit (index + 1)
+static btstack_data_source_t * event_data_sources[BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES];
+// event bits received but not processed yet
+static uint32_t event_bits_pending;
+
 static uint32_t btstack_run_loop_freertos_get_time_ms(void){
     return hal_time_ms();
 }
@@ -117,52 +137,75 @@ static void btstack_run_loop_freertos_set_timer(btstack_timer_source_t *ts, uint
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_freertos_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
 }
 
 /**
  * Remove timer from run loop
  */
 static bool btstack_run_loop_freertos_remove_timer(btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(ts);
 }
 
 static void btstack_run_loop_freertos_dump_timer(void){
 #ifdef ENABLE_LOG_INFO 
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer();
 #endif
 }
 
-// schedules execution from regular thread
-void btstack_run_loop_freertos_trigger(void){
+static int btstack_run_loop_freertos_event_index(const btstack_data_source_t * ds){
+    int i;
+    for (i=0;i<BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES;i++){
+        if (event_data_sources[i] == ds) return i;
+    }
+    return -1;
+}
+
+// event bit for data source, data sources without event bit are polled and use run loop bit
+static uint32_t btstack_run_loop_freertos_event_bit(const btstack_data_source_t * ds){
+    int index = btstack_run_loop_freertos_event_index(ds);
+    if (index < 0) return EVENT_GROUP_FLAG_RUN_LOOP;
+    return 1u << (index + 1);
+}
+
+static void btstack_run_loop_freertos_event_data_source_update(btstack_data_source_t * ds, bool use_event){
+    int index = btstack_run_loop_freertos_event_index(ds);
+    if (use_event){
+        if (index >= 0) return;
+        index = btstack_run_loop_freertos_event_index(NULL);
+        if (index < 0){
+            log_info("no event bit for data source %p, polling it", ds);
+            return;
+        }
+        // drop stale event
+        event_bits_pending &= ~(1u << (index + 1));
+        event_data_sources[index] = ds;
+    } else {
+        if (index < 0) return;
+        event_data_sources[index] = NULL;
+    }
+}
+
+static void btstack_run_loop_freertos_set_bits(uint32_t bits){
 #ifdef HAVE_FREERTOS_TASK_NOTIFICATIONS
-    xTaskNotify(btstack_run_loop_task, EVENT_GROUP_FLAG_RUN_LOOP, eSetBits);
+    xTaskNotify(btstack_run_loop_task, bits, eSetBits);
 #else
-    xEventGroupSetBits(btstack_run_loop_event_group, EVENT_GROUP_FLAG_RUN_LOOP);
+    xEventGroupSetBits(btstack_run_loop_event_group, bits);
 #endif
 }
 
+// schedules execution from regular thread
+void btstack_run_loop_freertos_trigger(void){
+    btstack_run_loop_freertos_set_bits(EVENT_GROUP_FLAG_RUN_LOOP);
+}
+
+void btstack_run_loop_freertos_data_source_set_ready(btstack_data_source_t * ds){
+    btstack_run_loop_freertos_set_bits(btstack_run_loop_freertos_event_bit(ds));
+}
+
 void btstack_run_loop_freertos_execute_code_on_main_thread(void (*fn)(void *arg), void * arg){
 
     // directly call function if already on btstack task
@@ -181,11 +224,18 @@ void btstack_run_loop_freertos_execute_code_on_main_thread(void (*fn)(void *arg)
     btstack_run_loop_freertos_trigger();
 }
 
+static void btstack_run_loop_freertos_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    xSemaphoreTake(btstack_run_loop_callbacks_mutex, portMAX_DELAY);
+    btstack_run_loop_base_add_callback(callback_registration);
+    xSemaphoreGive(btstack_run_loop_callbacks_mutex);
+    btstack_run_loop_freertos_trigger();
+}
+
 #if defined(HAVE_FREERTOS_TASK_NOTIFICATIONS) || (INCLUDE_xEventGroupSetBitFromISR == 1)
-void btstack_run_loop_freertos_trigger_from_isr(void){
+static void btstack_run_loop_freertos_set_bits_from_isr(uint32_t bits){
     BaseType_t xHigherPriorityTaskWoken;
 #ifdef HAVE_FREERTOS_TASK_NOTIFICATIONS
-    xTaskNotifyFromISR(btstack_run_loop_task, EVENT_GROUP_FLAG_RUN_LOOP, eSetBits, &xHigherPriorityTaskWoken);
+    xTaskNotifyFromISR(btstack_run_loop_task, bits, eSetBits, &xHigherPriorityTaskWoken);
     if (xHigherPriorityTaskWoken) {
 #ifdef ESP_PLATFORM
         portYIELD_FROM_ISR();
@@ -194,10 +244,18 @@ void btstack_run_loop_freertos_trigger_from_isr(void){
 #endif
     }
 #else
-    xEventGroupSetBitsFromISR(btstack_run_loop_event_group, EVENT_GROUP_FLAG_RUN_LOOP, &xHigherPriorityTaskWoken);
+    xEventGroupSetBitsFromISR(btstack_run_loop_event_group, bits, &xHigherPriorityTaskWoken);
 #endif
 }
 
+void btstack_run_loop_freertos_trigger_from_isr(void){
+    btstack_run_loop_freertos_set_bits_from_isr(EVENT_GROUP_FLAG_RUN_LOOP);
+}
+
+void btstack_run_loop_freertos_data_source_set_ready_from_isr(btstack_data_source_t * ds){
+    btstack_run_loop_freertos_set_bits_from_isr(btstack_run_loop_freertos_event_bit(ds));
+}
+
 void btstack_run_loop_freertos_execute_code_on_main_thread_from_isr(void (*fn)(void *arg), void * arg){
     function_call_t message;
     message.fn  = fn;
@@ -222,13 +280,27 @@ static void btstack_run_loop_freertos_execute(void) {
 
     while (true) {
 
-        // process data sources
+        // process data sources that are ready
+        uint32_t event_bits = event_bits_pending;
+        event_bits_pending = 0;
+        int i;
+        for (i=0;i<BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES;i++){
+            if ((event_bits & (1u << (i + 1))) == 0) continue;
+            // data source might have been removed by previous callback
+            btstack_data_source_t * ds = event_data_sources[i];
+            if (ds == NULL) continue;
+            btstack_run_loop_base_process_data_source(ds, DATA_SOURCE_CALLBACK_READ);
+        }
+
+        // poll data sources, including read data sources without event bit
         btstack_data_source_t *ds;
         btstack_data_source_t *next;
         for (ds = (btstack_data_source_t *) data_sources; ds != NULL ; ds = next){
             next = (btstack_data_source_t *) ds->item.next; // cache pointer to next data_source to allow data source to remove itself
             if (ds->flags & DATA_SOURCE_CALLBACK_POLL){
-                ds->process(ds, DATA_SOURCE_CALLBACK_POLL);
+                btstack_run_loop_base_process_data_source(ds, DATA_SOURCE_CALLBACK_POLL);
+            } else if ((ds->flags & DATA_SOURCE_CALLBACK_READ) && (btstack_run_loop_freertos_event_index(ds) < 0)){
+                btstack_run_loop_base_process_data_source(ds, DATA_SOURCE_CALLBACK_READ);
             }
         }
 
@@ -242,11 +314,20 @@ static void btstack_run_loop_freertos_execute(void) {
             }
         }
 
+        // execute callbacks from btstack_run_loop_execute_on_main_thread
+        while (true){
+            xSemaphoreTake(btstack_run_loop_callbacks_mutex, portMAX_DELAY);
+            btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+            xSemaphoreGive(btstack_run_loop_callbacks_mutex);
+            if (callback_registration == NULL) break;
+            btstack_run_loop_base_execute_callback(callback_registration);
+        }
+
         // process timers and get next timeout
         uint32_t timeout_ms = portMAX_DELAY;
         log_debug("RL: portMAX_DELAY %u", portMAX_DELAY);
-        while (timers) {
-            btstack_timer_source_t * ts = (btstack_timer_source_t *) timers;
+        while (btstack_run_loop_base_timers) {
+            btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
             uint32_t now = btstack_run_loop_freertos_get_time_ms();
             int32_t delta_ms = btstack_time_delta(ts->timeout, now);
             log_debug("RL: now %u, expires %u -> delta %d", now, ts->timeout, delta_ms);
@@ -257,7 +338,7 @@ static void btstack_run_loop_freertos_execute(void) {
             // remove timer before processing it to allow handler to re-register with run loop
             btstack_run_loop_freertos_remove_timer(ts);
             log_debug("RL: first timer %p", ts->process);
-            ts->process(ts);
+            btstack_run_loop_base_process_timer(ts);
         }
 
         // exit triggered by btstack_run_loop_freertos_trigger_exit (from data source, timer, run on main thread)
@@ -266,36 +347,50 @@ static void btstack_run_loop_freertos_execute(void) {
         // wait for timeout or event group/task notification
         log_debug("RL: wait with timeout %u", (int) timeout_ms);
 #ifdef HAVE_FREERTOS_TASK_NOTIFICATIONS
-        xTaskNotifyWait(pdFALSE, 0xffffffff, NULL, pdMS_TO_TICKS(timeout_ms));
+        uint32_t notified_bits = 0;
+        xTaskNotifyWait(pdFALSE, 0xffffffff, &notified_bits, pdMS_TO_TICKS(timeout_ms));
+        event_bits_pending |= notified_bits;
 #else
-        xEventGroupWaitBits(btstack_run_loop_event_group, EVENT_GROUP_FLAG_RUN_LOOP, 1, 0, pdMS_TO_TICKS(timeout_ms));
+        event_bits_pending |= (uint32_t) xEventGroupWaitBits(btstack_run_loop_event_group, EVENT_GROUP_FLAGS_ALL, 1, 0, pdMS_TO_TICKS(timeout_ms));
 #endif
     }
 }
 
 static void btstack_run_loop_freertos_add_data_source(btstack_data_source_t *ds){
     btstack_linked_list_add(&data_sources, (btstack_linked_item_t *) ds);
+    btstack_run_loop_freertos_event_data_source_update(ds, (ds->flags & DATA_SOURCE_CALLBACK_READ) != 0);
 }
 
 static bool btstack_run_loop_freertos_remove_data_source(btstack_data_source_t *ds){
+    btstack_run_loop_freertos_event_data_source_update(ds, false);
     return btstack_linked_list_remove(&data_sources, (btstack_linked_item_t *) ds);
 }
 
 static void btstack_run_loop_freertos_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
     ds->flags |= callback_types;
+    if ((callback_types & DATA_SOURCE_CALLBACK_READ) == 0) return;
+    btstack_run_loop_freertos_event_data_source_update(ds, true);
 }
 
 static void btstack_run_loop_freertos_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
     ds->flags &= ~callback_types;
+    if ((callback_types & DATA_SOURCE_CALLBACK_READ) == 0) return;
+    btstack_run_loop_freertos_event_data_source_update(ds, false);
 }
 
 static void btstack_run_loop_freertos_init(void){
-    timers = NULL;
+    btstack_run_loop_base_init();
+
+    data_sources = NULL;
+    memset(event_data_sources, 0, sizeof(event_data_sources));
+    event_bits_pending = 0;
 
 #ifdef USE_STATIC_ALLOC
     btstack_run_loop_queue = xQueueCreateStatic(RUN_LOOP_QUEUE_LENGTH, RUN_LOOP_QUEUE_ITEM_SIZE, btstack_run_loop_queue_storage, &btstack_run_loop_queue_object);
+    btstack_run_loop_callbacks_mutex = xSemaphoreCreateMutexStatic(&btstack_run_loop_callbacks_mutex_object);
 #else
     btstack_run_loop_queue = xQueueCreate(RUN_LOOP_QUEUE_LENGTH, RUN_LOOP_QUEUE_ITEM_SIZE);
+    btstack_run_loop_callbacks_mutex = xSemaphoreCreateMutex();
 #endif
 
 #ifndef HAVE_FREERTOS_TASK_NOTIFICATIONS
@@ -325,6 +420,7 @@ static const btstack_run_loop_t btstack_run_loop_freertos = {
     &btstack_run_loop_freertos_execute,
     &btstack_run_loop_freertos_dump_timer,
     &btstack_run_loop_freertos_get_time_ms,
+    &btstack_run_loop_freertos_execute_on_main_thread,
 };
 
 const btstack_run_loop_t * btstack_run_loop_freertos_get_instance(void){
@@ -78,6 +78,22 @@ void btstack_run_loop_freertos_trigger(void);
  */
 void btstack_run_loop_freertos_trigger_from_isr(void);
 
+/**
+ * @brief Mark data source with enabled DATA_SOURCE_CALLBACK_READ as ready from thread context.
+ * Its process function gets called with DATA_SOURCE_CALLBACK_READ in the next run loop iteration.
+ * @note Up to BTSTACK_RUN_LOOP_FREERTOS_MAX_EVENT_DATA_SOURCES read data sources get an event bit,
+ *       additional ones are called in every iteration as poll data sources
+ * @param data_source
+ */
+void btstack_run_loop_freertos_data_source_set_ready(btstack_data_source_t * data_source);
+
+/**
+ * @brief Mark data source with enabled DATA_SOURCE_CALLBACK_READ as ready from an ISR.
+ * Its process function gets called with DATA_SOURCE_CALLBACK_READ in the next run loop iteration.
+ * @param data_source
+ */
+void btstack_run_loop_freertos_data_source_set_ready_from_isr(btstack_data_source_t * data_source);
+
 /**
  * @brief Triggers exit of run loop from BTstack main thread, causes call to btstack_run_loop_execute to return
  */
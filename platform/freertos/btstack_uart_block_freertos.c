@@ -77,17 +77,17 @@ static int receive_complete;
 
 static void btstack_uart_block_freertos_received_isr(void){
     receive_complete = 1;
-    btstack_run_loop_freertos_trigger_from_isr();
+    btstack_run_loop_freertos_data_source_set_ready_from_isr(&transport_data_source);
 }
 
 static void btstack_uart_block_freertos_sent_isr(void){
     send_complete = 1;
-    btstack_run_loop_freertos_trigger_from_isr();
+    btstack_run_loop_freertos_data_source_set_ready_from_isr(&transport_data_source);
 }
 
 static void btstack_uart_block_freertos_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
     switch (callback_type){
-        case DATA_SOURCE_CALLBACK_POLL:
+        case DATA_SOURCE_CALLBACK_READ:
             if (send_complete){
                 send_complete = 0;
                 if (block_sent){
@@ -112,9 +112,9 @@ static int btstack_uart_block_freertos_init(const btstack_uart_config_t * config
     hal_uart_dma_set_block_received(&btstack_uart_block_freertos_received_isr);
     hal_uart_dma_set_block_sent(&btstack_uart_block_freertos_sent_isr);
 
-    // set up polling data_source
+    // set up data_source, called when marked as ready by UART ISRs
     btstack_run_loop_set_data_source_handler(&transport_data_source, &btstack_uart_block_freertos_process);
-    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
     btstack_run_loop_add_data_source(&transport_data_source);
     return 0;
 }
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_worker_freertos.c"
+
+/*
+ *  btstack_worker_freertos.c
+ *
+ *  Single worker task that executes jobs in FIFO order
+ */
+
+#include "btstack_worker_freertos.h"
+
+#include "btstack_config.h"
+#include "btstack_debug.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
+
+#ifdef HAVE_FREERTOS_INCLUDE_PREFIX
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#else
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
+
+// stack size in units of StackType_t, which is bytes on ESP-IDF
+#ifndef BTSTACK_WORKER_FREERTOS_STACK_SIZE
+#define BTSTACK_WORKER_FREERTOS_STACK_SIZE 2048
+#endif
+
+#ifndef BTSTACK_WORKER_FREERTOS_PRIORITY
+#define BTSTACK_WORKER_FREERTOS_PRIORITY (tskIDLE_PRIORITY + 1)
+#endif
+
+// pick allocation style, prefer static
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define USE_STATIC_ALLOC
+static StaticTask_t      btstack_worker_freertos_task_object;
+static StackType_t       btstack_worker_freertos_task_stack[BTSTACK_WORKER_FREERTOS_STACK_SIZE];
+static StaticSemaphore_t btstack_worker_freertos_mutex_object;
+#endif
+
+static TaskHandle_t          btstack_worker_freertos_task;
+static SemaphoreHandle_t     btstack_worker_freertos_mutex;
+static btstack_linked_list_t btstack_worker_freertos_jobs;
+
+static void btstack_worker_freertos_task_handler(void * arg){
+    UNUSED(arg);
+    while (true){
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (true){
+            xSemaphoreTake(btstack_worker_freertos_mutex, portMAX_DELAY);
+            btstack_worker_job_t * job = (btstack_worker_job_t *) btstack_linked_list_pop(&btstack_worker_freertos_jobs);
+            xSemaphoreGive(btstack_worker_freertos_mutex);
+            if (job == NULL) break;
+            (*job->work)(job->context);
+            btstack_run_loop_execute_on_main_thread(&job->completion);
+        }
+    }
+}
+
+static void btstack_worker_freertos_start(void){
+#ifdef USE_STATIC_ALLOC
+    btstack_worker_freertos_mutex = xSemaphoreCreateMutexStatic(&btstack_worker_freertos_mutex_object);
+    btstack_worker_freertos_task  = xTaskCreateStatic(&btstack_worker_freertos_task_handler, "btstack_worker",
+                                                      BTSTACK_WORKER_FREERTOS_STACK_SIZE, NULL, BTSTACK_WORKER_FREERTOS_PRIORITY,
+                                                      btstack_worker_freertos_task_stack, &btstack_worker_freertos_task_object);
+#else
+    btstack_worker_freertos_mutex = xSemaphoreCreateMutex();
+    xTaskCreate(&btstack_worker_freertos_task_handler, "btstack_worker", BTSTACK_WORKER_FREERTOS_STACK_SIZE, NULL,
+                BTSTACK_WORKER_FREERTOS_PRIORITY, &btstack_worker_freertos_task);
+#endif
+    log_info("worker task %p", btstack_worker_freertos_task);
+}
+
+static void btstack_worker_freertos_submit(btstack_worker_job_t * job){
+    if (btstack_worker_freertos_mutex == NULL){
+        btstack_worker_freertos_start();
+    }
+    xSemaphoreTake(btstack_worker_freertos_mutex, portMAX_DELAY);
+    btstack_linked_list_add_tail(&btstack_worker_freertos_jobs, (btstack_linked_item_t *) job);
+    xSemaphoreGive(btstack_worker_freertos_mutex);
+    xTaskNotifyGive(btstack_worker_freertos_task);
+}
+
+static const btstack_worker_t btstack_worker_freertos = {
+    &btstack_worker_freertos_submit,
+};
+
+const btstack_worker_t * btstack_worker_freertos_get_instance(void){
+    return &btstack_worker_freertos;
+}
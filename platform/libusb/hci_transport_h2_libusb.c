@@ -54,16 +54,19 @@
 // SCO Data     0 0 0x03 Isochronous (Out)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <strings.h>
 #include <string.h>
 #include <unistd.h>   /* UNIX standard function definitions */
 #include <sys/types.h>
+#include <poll.h>
 
 #include <libusb.h>
 
 #include "btstack_config.h"
 
 #include "btstack_debug.h"
+#include "btstack_linked_list.h"
 #include "hci.h"
 #include "hci_transport.h"
 
@@ -79,11 +82,23 @@
 #define HAVE_USB_VENDOR_ID_AND_PRODUCT_ID
 #endif
 
-#define ACL_IN_BUFFER_COUNT    3
-#define EVENT_IN_BUFFER_COUNT  3
+// default number of queued IN transfers, can be changed with hci_transport_usb_set_in_transfer_count
+#ifndef HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT  4
+#endif
+#ifndef HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT    8
+#endif
+
+// number of ACL OUT transfers in flight, outgoing packets are copied if > 1
+#ifndef HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT   4
+#endif
+
 #define SCO_IN_BUFFER_COUNT   10
 
-#define ASYNC_POLLING_INTERVAL_MS 1
+#define EVENT_IN_BUFFER_SIZE  HCI_ACL_BUFFER_SIZE  // bigger than largest packet
+#define ACL_IN_BUFFER_SIZE    (HCI_INCOMING_PRE_BUFFER_SIZE + HCI_ACL_BUFFER_SIZE)
 
 //
 // Bluetooth USB Transport Alternate Settings:
@@ -101,9 +116,12 @@
 // alt setting for 1-3 connections and 8/16 bit
 static const int alt_setting_8_bit[]  = {1,2,3};      
 static const int alt_setting_16_bit[] = {2,4,5};
+// transparent air mode (mSBC) uses 64 kbit/s per connection independent of sample size, same as 8 kHz 8-bit
+static const int alt_setting_transparent[] = {1,2,3};
 
 // for ALT_SETTING >= 1 and 8-bit channel, we need the following isochronous packets
 // One complete SCO packet with 24 frames every 3 frames (== 3 ms)
+// Incoming transfers use NUM_ISO_PACKETS to keep latency low, incoming SCO packets are reassembled across transfers
 #define NUM_ISO_PACKETS (3)
 
 static const uint16_t iso_packet_size_for_alt_setting[] = {
@@ -121,6 +139,9 @@ static const uint16_t iso_packet_size_for_alt_setting[] = {
 // note: alt setting 6 has max packet size of 63 every 7.5 ms = 472.5 bytes / HCI packet, while max SCO packet has 255 byte payload
 #define SCO_PACKET_SIZE  (49 * NUM_ISO_PACKETS)
 
+// outgoing transfers carry a single SCO packet, e.g. 63 byte mSBC packet in 7 ISO packets with alt setting 1
+#define SCO_OUT_MAX_ISO_PACKETS ((SCO_PACKET_SIZE + 8) / 9)
+
 // Outgoing SCO packet queue
 // simplified ring buffer implementation
 #define SCO_OUT_BUFFER_COUNT  (8)
@@ -161,9 +182,18 @@ static struct libusb_device_descriptor desc;
 static libusb_device_handle * handle;
 
 static struct libusb_transfer *command_out_transfer;
-static struct libusb_transfer *acl_out_transfer;
-static struct libusb_transfer *event_in_transfer[EVENT_IN_BUFFER_COUNT];
-static struct libusb_transfer *acl_in_transfer[ACL_IN_BUFFER_COUNT];
+static struct libusb_transfer *acl_out_transfers[HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT];
+static int      acl_out_transfers_in_flight[HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT];
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+static uint8_t  acl_out_buffers[HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT][HCI_OUTGOING_PACKET_BUFFER_SIZE];
+static btstack_timer_source_t acl_out_packet_sent_timer;
+static int      acl_out_packet_sent_timer_active;
+static int      acl_out_packet_sent_pending;
+#endif
+static struct libusb_transfer **event_in_transfer;
+static struct libusb_transfer **acl_in_transfer;
+static int event_in_transfer_count = HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT;
+static int acl_in_transfer_count   = HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT;
 
 #ifdef ENABLE_SCO_OVER_HCI
 
@@ -200,20 +230,24 @@ static int      sco_enabled;
 // outgoing buffer for HCI Command packets
 static uint8_t hci_cmd_buffer[3 + 256 + LIBUSB_CONTROL_SETUP_SIZE];
 
-// incoming buffer for HCI Events and ACL Packets
-static uint8_t hci_event_in_buffer[EVENT_IN_BUFFER_COUNT][HCI_ACL_BUFFER_SIZE]; // bigger than largest packet
-static uint8_t hci_acl_in_buffer[ACL_IN_BUFFER_COUNT][HCI_INCOMING_PRE_BUFFER_SIZE + HCI_ACL_BUFFER_SIZE]; 
+// incoming buffers for HCI Events and ACL Packets, one per transfer, allocated in usb_open
+static uint8_t * hci_event_in_buffer;
+static uint8_t * hci_acl_in_buffer;
 
 // For (ab)use as a linked list of received packets
 static struct libusb_transfer *handle_packet;
+static struct libusb_transfer *handle_packet_tail;
 
-static int doing_pollfds;
-static int num_pollfds;
-static btstack_data_source_t * pollfd_data_sources;
+// run loop data sources for libusb pollfds
+static btstack_linked_list_t pollfd_data_sources;
+static int pollfd_notifiers_registered;
+
+// timer for libusb internal timeouts, only used if libusb requires explicit timeout handling
 static btstack_timer_source_t usb_timer;
 static int usb_timer_active;
+static int usb_handle_timeouts;
 
-static int usb_acl_out_active = 0;
+static int usb_acl_out_active = 0;  // num ACL OUT transfers in flight
 static int usb_command_active = 0;
 
 // endpoint addresses
@@ -241,6 +275,19 @@ static int sco_ring_have_space(void){
 }
 #endif
 
+void hci_transport_usb_set_in_transfer_count(int num_event_in, int num_acl_in){
+    if (usb_transport_open){
+        log_error("hci_transport_usb_set_in_transfer_count: transport already open");
+        return;
+    }
+    if (num_event_in < 1 || num_acl_in < 1){
+        log_error("hci_transport_usb_set_in_transfer_count: at least one transfer each required");
+        return;
+    }
+    event_in_transfer_count = num_event_in;
+    acl_in_transfer_count   = num_acl_in;
+}
+
 void hci_transport_usb_set_path(int len, uint8_t * port_numbers){
     if (len > USB_MAX_PATH_LEN || !port_numbers){
         log_error("hci_transport_usb_set_path: len or port numbers invalid");
@@ -257,18 +304,13 @@ static void queue_transfer(struct libusb_transfer *transfer){
 
     transfer->user_data = NULL;
 
-    // insert first element
+    // append to list, completed transfers are dispatched from their buffers in usb_process_ds
     if (handle_packet == NULL) {
         handle_packet = transfer;
-        return;
-    }
-
-    // Walk to end of list and add current packet there
-    struct libusb_transfer *temp = handle_packet;
-    while (temp->user_data) {
-        temp = (struct libusb_transfer*)temp->user_data;
+    } else {
+        handle_packet_tail->user_data = transfer;
     }
-    temp->user_data = transfer;
+    handle_packet_tail = transfer;
 }
 
 LIBUSB_CALL static void async_callback(struct libusb_transfer *transfer){
@@ -303,14 +345,14 @@ LIBUSB_CALL static void async_callback(struct libusb_transfer *transfer){
 #endif
 
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) {
-        for (c=0;c<EVENT_IN_BUFFER_COUNT;c++){
+        for (c=0;c<event_in_transfer_count;c++){
             if (transfer == event_in_transfer[c]){
                 libusb_free_transfer(transfer);
                 event_in_transfer[c] = 0;
                 return;
             }
         }
-        for (c=0;c<ACL_IN_BUFFER_COUNT;c++){
+        for (c=0;c<acl_in_transfer_count;c++){
             if (transfer == acl_in_transfer[c]){
                 libusb_free_transfer(transfer);
                 acl_in_transfer[c] = 0;
@@ -364,15 +406,24 @@ static int usb_send_sco_packet(uint8_t *packet, int size){
 
     // log_info("usb_send_acl_packet enter, size %u", size);
 
-    // store packet in free slot
+    // number of ISO packets for this SCO packet
+    int num_iso_packets = (size + iso_packet_size - 1) / iso_packet_size;
+    int transfer_size   = num_iso_packets * iso_packet_size;
+    if (transfer_size > SCO_PACKET_SIZE){
+        log_error("usb_send_sco_packet: size %u > max size %u", size, SCO_PACKET_SIZE);
+        return -1;
+    }
+
+    // store packet in free slot, pad last ISO packet
     int tranfer_index = sco_ring_write;
     uint8_t * data = &sco_out_ring_buffer[tranfer_index * SCO_PACKET_SIZE];
     memcpy(data, packet, size);
+    memset(&data[size], 0, transfer_size - size);
 
     // setup transfer
-    // log_info("usb_send_sco_packet: size %u, max size %u, iso packet size %u", size, NUM_ISO_PACKETS * iso_packet_size, iso_packet_size);
+    // log_info("usb_send_sco_packet: size %u, num iso packets %u, iso packet size %u", size, num_iso_packets, iso_packet_size);
     struct libusb_transfer * sco_transfer = sco_out_transfers[tranfer_index];
-    libusb_fill_iso_transfer(sco_transfer, handle, sco_out_addr, data, NUM_ISO_PACKETS * iso_packet_size, NUM_ISO_PACKETS, async_callback, NULL, 0);
+    libusb_fill_iso_transfer(sco_transfer, handle, sco_out_addr, data, transfer_size, num_iso_packets, async_callback, NULL, 0);
     libusb_set_iso_packet_lengths(sco_transfer, iso_packet_size);
     r = libusb_submit_transfer(sco_transfer);
     if (r < 0) {
@@ -410,6 +461,16 @@ static void sco_state_machine_init(void){
 
 static void handle_isochronous_data(uint8_t * buffer, uint16_t size){
     while (size){
+        // complete SCO packets at start of buffer are passed up in place
+        if ((sco_state == H2_W4_SCO_HEADER) && (sco_read_pos == 0) && (size >= 3)){
+            uint16_t packet_size = 3 + buffer[2];
+            if (size >= packet_size){
+                packet_handler(HCI_SCO_DATA_PACKET, buffer, packet_size);
+                buffer += packet_size;
+                size   -= packet_size;
+                continue;
+            }
+        }
         if (size < sco_bytes_to_read){
             // just store incomplete data
             memcpy(&sco_buffer[sco_read_pos], buffer, size);
@@ -439,6 +500,27 @@ static void handle_isochronous_data(uint8_t * buffer, uint16_t size){
 }
 #endif
 
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+static void usb_acl_out_emit_packet_sent(void){
+    if (acl_out_packet_sent_timer_active){
+        btstack_run_loop_remove_timer(&acl_out_packet_sent_timer);
+        acl_out_packet_sent_timer_active = 0;
+    }
+    acl_out_packet_sent_pending = 0;
+    // notify upper stack that provided buffer can be used again
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+}
+
+static void usb_acl_out_packet_sent_handler(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    acl_out_packet_sent_timer_active = 0;
+    if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
+    if (!acl_out_packet_sent_pending) return;
+    usb_acl_out_emit_packet_sent();
+}
+#endif
+
 static void handle_completed_transfer(struct libusb_transfer *transfer){
 
     int resubmit = 0;
@@ -457,23 +539,47 @@ static void handle_completed_transfer(struct libusb_transfer *transfer){
         signal_done = 1;
     } else if (transfer->endpoint == acl_out_addr){
         // log_info("acl out done, size %u", transfer->actual_length);
-        usb_acl_out_active = 0;
+        int i;
+        for (i = 0; i < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT; i++){
+            if (transfer == acl_out_transfers[i]){
+                acl_out_transfers_in_flight[i] = 0;
+                usb_acl_out_active--;
+            }
+        }
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+        // packet has been copied before, report it as sent as soon as a transfer is free again
+        if (acl_out_packet_sent_pending){
+            usb_acl_out_emit_packet_sent();
+        }
+#else
         signal_done = 1;
+#endif
 #ifdef ENABLE_SCO_OVER_HCI
     } else if (transfer->endpoint == sco_in_addr) {
         // log_info("handle_completed_transfer for SCO IN! num packets %u", transfer->NUM_ISO_PACKETS);
+        // ISO packets are consecutive in transfer buffer if all of them are complete
         int i;
+        int total_length = 0;
         for (i = 0; i < transfer->num_iso_packets; i++) {
             struct libusb_iso_packet_descriptor *pack = &transfer->iso_packet_desc[i];
-            if (pack->status != LIBUSB_TRANSFER_COMPLETED) {
-                log_error("Error: pack %u status %d\n", i, pack->status);
-                continue;
+            if ((pack->status != LIBUSB_TRANSFER_COMPLETED) || (pack->actual_length != pack->length)) break;
+            total_length += pack->actual_length;
+        }
+        if (i == transfer->num_iso_packets){
+            handle_isochronous_data(transfer->buffer, total_length);
+        } else {
+            for (i = 0; i < transfer->num_iso_packets; i++) {
+                struct libusb_iso_packet_descriptor *pack = &transfer->iso_packet_desc[i];
+                if (pack->status != LIBUSB_TRANSFER_COMPLETED) {
+                    log_error("Error: pack %u status %d\n", i, pack->status);
+                    continue;
+                }
+                if (!pack->actual_length) continue;
+                uint8_t * data = libusb_get_iso_packet_buffer_simple(transfer, i);
+                // printf_hexdump(data, pack->actual_length);
+                // log_info("handle_isochronous_data,size %u/%u", pack->length, pack->actual_length);
+                handle_isochronous_data(data, pack->actual_length);
             }
-            if (!pack->actual_length) continue;
-            uint8_t * data = libusb_get_iso_packet_buffer_simple(transfer, i);
-            // printf_hexdump(data, pack->actual_length);
-            // log_info("handle_isochronous_data,size %u/%u", pack->length, pack->actual_length);
-            handle_isochronous_data(data, pack->actual_length);
         }
         resubmit = 1;
     } else if (transfer->endpoint == sco_out_addr){
@@ -520,14 +626,34 @@ static void handle_completed_transfer(struct libusb_transfer *transfer){
     }   
 }
 
-static void usb_process_ds(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
+static void usb_process_ts(btstack_timer_source_t *timer);
 
-    UNUSED(ds);
-    UNUSED(callback_type);
+static void usb_update_timeout(void){
+
+    if (usb_timer_active){
+        btstack_run_loop_remove_timer(&usb_timer);
+        usb_timer_active = 0;
+    }
 
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
+    if (!usb_handle_timeouts) return;
+
+    // Get the amount of time until next libusb timeout is due
+    struct timeval tv;
+    if (libusb_get_next_timeout(NULL, &tv) != 1) return;
+    uint32_t msec = (uint32_t) tv.tv_sec * 1000u + (uint32_t) ((tv.tv_usec + 999) / 1000);
+
+    btstack_run_loop_set_timer_handler(&usb_timer, &usb_process_ts);
+    btstack_run_loop_set_timer(&usb_timer, msec);
+    btstack_run_loop_add_timer(&usb_timer);
+    usb_timer_active = 1;
+}
+
+static void usb_handle_events(void){
 
-    // log_info("begin usb_process_ds");
+    if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
+
+    // log_info("begin usb_handle_events");
     // always handling an event as we're called when data is ready
     struct timeval tv;
     memset(&tv, 0, sizeof(struct timeval));
@@ -547,32 +673,92 @@ static void usb_process_ds(btstack_data_source_t *ds, btstack_data_source_callba
         // handle case where libusb_close might be called by hci packet handler        
         if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
     }
-    // log_info("end usb_process_ds");
+    // log_info("end usb_handle_events");
+
+    usb_update_timeout();
+}
+
+static void usb_process_ds(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
+
+    UNUSED(ds);
+    UNUSED(callback_type);
+
+    usb_handle_events();
 }
 
 static void usb_process_ts(btstack_timer_source_t *timer) {
 
     UNUSED(timer);
 
-    // log_info("in usb_process_ts");
-
     // timer is deactive, when timer callback gets called
     usb_timer_active = 0;
 
-    if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
+    usb_handle_events();
+}
 
-    // actually handled the packet in the pollfds function
-    usb_process_ds((struct btstack_data_source *) NULL, DATA_SOURCE_CALLBACK_READ);
+static void usb_pollfd_set_callbacks(btstack_data_source_t * ds, short events){
+    // usbfs on Linux reports completed transfers as writable device fd
+    if (events & POLLIN){
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+    }
+    if (events & POLLOUT){
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+    }
+}
 
-    // Get the amount of time until next event is due
-    long msec = ASYNC_POLLING_INTERVAL_MS;
+static int usb_pollfd_add(int fd, short events){
+    btstack_data_source_t * ds = (btstack_data_source_t *) malloc(sizeof(btstack_data_source_t));
+    if (!ds){
+        log_error("Cannot allocate data source for pollfd %d", fd);
+        return -1;
+    }
+    memset(ds, 0, sizeof(btstack_data_source_t));
+    btstack_run_loop_set_data_source_fd(ds, fd);
+    btstack_run_loop_set_data_source_handler(ds, &usb_process_ds);
+    usb_pollfd_set_callbacks(ds, events);
+    btstack_run_loop_add_data_source(ds);
+    btstack_linked_list_add(&pollfd_data_sources, (btstack_linked_item_t *) ds);
+    log_info("pollfd added: fd %d, events %x", fd, events);
+    return 0;
+}
 
-    // Activate timer
-    btstack_run_loop_set_timer(&usb_timer, msec);
-    btstack_run_loop_add_timer(&usb_timer);
-    usb_timer_active = 1;
+static void usb_pollfd_remove_all(void){
+    while (pollfd_data_sources){
+        btstack_data_source_t * ds = (btstack_data_source_t *) btstack_linked_list_pop(&pollfd_data_sources);
+        btstack_run_loop_remove_data_source(ds);
+        free(ds);
+    }
+}
 
-    return;
+LIBUSB_CALL static void usb_pollfd_added(int fd, short events, void * user_data){
+    UNUSED(user_data);
+    usb_pollfd_add(fd, events);
+}
+
+LIBUSB_CALL static void usb_pollfd_removed(int fd, void * user_data){
+    UNUSED(user_data);
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &pollfd_data_sources);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_data_source_t * ds = (btstack_data_source_t *) btstack_linked_list_iterator_next(&it);
+        if (ds->source.fd != fd) continue;
+        btstack_linked_list_iterator_remove(&it);
+        btstack_run_loop_remove_data_source(ds);
+        free(ds);
+        log_info("pollfd removed: fd %d", fd);
+        return;
+    }
+}
+
+static void usb_free_in_transfers(void){
+    free(event_in_transfer);
+    free(acl_in_transfer);
+    free(hci_event_in_buffer);
+    free(hci_acl_in_buffer);
+    event_in_transfer = NULL;
+    acl_in_transfer = NULL;
+    hci_event_in_buffer = NULL;
+    hci_acl_in_buffer = NULL;
 }
 
 #ifndef HAVE_USB_VENDOR_ID_AND_PRODUCT_ID
@@ -803,6 +989,24 @@ static libusb_device_handle * try_open_device(libusb_device * device){
 
 #ifdef ENABLE_SCO_OVER_HCI
 
+static int usb_sco_alt_setting(uint16_t voice_setting, int num_connections){
+    if (num_connections < 1) return 0;
+    if (num_connections > 3) {
+        log_error("usb_sco_alt_setting: %u connections not supported, using 3", num_connections);
+        num_connections = 3;
+    }
+    if ((voice_setting & 0x0003) == 0x0003){
+        // transparent, e.g. mSBC
+        return alt_setting_transparent[num_connections-1];
+    }
+    if (voice_setting & 0x0020){
+        // 16-bit PCM
+        return alt_setting_16_bit[num_connections-1];
+    }
+    // 8-bit PCM
+    return alt_setting_8_bit[num_connections-1];
+}
+
 static int usb_sco_start(void){
 
     printf("usb_sco_start\n");
@@ -811,14 +1015,7 @@ static int usb_sco_start(void){
     sco_state_machine_init();
     sco_ring_init();
 
-    int alt_setting;
-    if (sco_voice_setting & 0x0020){
-        // 16-bit PCM  
-        alt_setting = alt_setting_16_bit[sco_num_connections-1];
-    } else {
-        // 8-bit PCM or mSBC
-        alt_setting = alt_setting_8_bit[sco_num_connections-1];
-    }
+    int alt_setting = usb_sco_alt_setting(sco_voice_setting, sco_num_connections);
     // derive iso packet size from alt setting
     iso_packet_size = iso_packet_size_for_alt_setting[alt_setting];
 
@@ -851,7 +1048,7 @@ static int usb_sco_start(void){
 
     // outgoing
     for (c=0; c < SCO_OUT_BUFFER_COUNT ; c++){
-        sco_out_transfers[c] = libusb_alloc_transfer(NUM_ISO_PACKETS); // 1 isochronous transfers SCO out - up to 3 parts
+        sco_out_transfers[c] = libusb_alloc_transfer(SCO_OUT_MAX_ISO_PACKETS); // 1 isochronous transfers SCO out - single SCO packet
         sco_out_transfers_in_flight[c] = 0;
     }
     return 0;
@@ -929,6 +1126,7 @@ static int usb_open(void){
     if (usb_transport_open) return 0;
 
     handle_packet = NULL;
+    handle_packet_tail = NULL;
 
     // default endpoint addresses
     event_in_addr = 0x81; // EP1, IN interrupt
@@ -1059,16 +1257,28 @@ static int usb_open(void){
 
 #endif
     
-    // allocate transfer handlers
+    // allocate transfer handlers and their buffers
+    event_in_transfer   = (struct libusb_transfer **) calloc(event_in_transfer_count, sizeof(struct libusb_transfer *));
+    acl_in_transfer     = (struct libusb_transfer **) calloc(acl_in_transfer_count,   sizeof(struct libusb_transfer *));
+    hci_event_in_buffer = (uint8_t *) malloc(event_in_transfer_count * EVENT_IN_BUFFER_SIZE);
+    hci_acl_in_buffer   = (uint8_t *) malloc(acl_in_transfer_count   * ACL_IN_BUFFER_SIZE);
+    if (!event_in_transfer || !acl_in_transfer || !hci_event_in_buffer || !hci_acl_in_buffer){
+        log_error("Cannot allocate %u event in and %u acl in transfers", event_in_transfer_count, acl_in_transfer_count);
+        usb_free_in_transfers();
+        usb_close();
+        return LIBUSB_ERROR_NO_MEM;
+    }
+    log_info("Using %u event in and %u acl in transfers", event_in_transfer_count, acl_in_transfer_count);
+
     int c;
-    for (c = 0 ; c < EVENT_IN_BUFFER_COUNT ; c++) {
+    for (c = 0 ; c < event_in_transfer_count ; c++) {
         event_in_transfer[c] = libusb_alloc_transfer(0); // 0 isochronous transfers Events
         if (!event_in_transfer[c]) {
             usb_close();
             return LIBUSB_ERROR_NO_MEM;
         }
     }
-    for (c = 0 ; c < ACL_IN_BUFFER_COUNT ; c++) {
+    for (c = 0 ; c < acl_in_transfer_count ; c++) {
         acl_in_transfer[c]  =  libusb_alloc_transfer(0); // 0 isochronous transfers ACL in
         if (!acl_in_transfer[c]) {
             usb_close();
@@ -1077,16 +1287,23 @@ static int usb_open(void){
     }
 
     command_out_transfer = libusb_alloc_transfer(0);
-    acl_out_transfer     = libusb_alloc_transfer(0);
+    for (c = 0 ; c < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT ; c++) {
+        acl_out_transfers[c] = libusb_alloc_transfer(0);
+        acl_out_transfers_in_flight[c] = 0;
+    }
+    usb_acl_out_active = 0;
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    acl_out_packet_sent_pending = 0;
+#endif
 
     // TODO check for error
 
     libusb_state = LIB_USB_TRANSFERS_ALLOCATED;
 
-    for (c = 0 ; c < EVENT_IN_BUFFER_COUNT ; c++) {
+    for (c = 0 ; c < event_in_transfer_count ; c++) {
         // configure event_in handlers
         libusb_fill_interrupt_transfer(event_in_transfer[c], handle, event_in_addr, 
-                hci_event_in_buffer[c], HCI_ACL_BUFFER_SIZE, async_callback, NULL, 0) ;
+                &hci_event_in_buffer[c * EVENT_IN_BUFFER_SIZE], EVENT_IN_BUFFER_SIZE, async_callback, NULL, 0) ;
         r = libusb_submit_transfer(event_in_transfer[c]);
         if (r) {
             log_error("Error submitting interrupt transfer %d", r);
@@ -1095,10 +1312,10 @@ static int usb_open(void){
         }
     }
 
-    for (c = 0 ; c < ACL_IN_BUFFER_COUNT ; c++) {
-        // configure acl_in handlers
+    for (c = 0 ; c < acl_in_transfer_count ; c++) {
+        // configure acl_in handlers, received packets are passed up in place with space for the pre-buffer
         libusb_fill_bulk_transfer(acl_in_transfer[c], handle, acl_in_addr, 
-                hci_acl_in_buffer[c] + HCI_INCOMING_PRE_BUFFER_SIZE, HCI_ACL_BUFFER_SIZE, async_callback, NULL, 0) ;
+                &hci_acl_in_buffer[c * ACL_IN_BUFFER_SIZE + HCI_INCOMING_PRE_BUFFER_SIZE], HCI_ACL_BUFFER_SIZE, async_callback, NULL, 0) ;
         r = libusb_submit_transfer(acl_in_transfer[c]);
         if (r) {
             log_error("Error submitting bulk in transfer %d", r);
@@ -1108,43 +1325,28 @@ static int usb_open(void){
  
      }
 
- #if 0
-    // Check for pollfds functionality
-    doing_pollfds = libusb_pollfds_handle_timeouts(NULL);
-#else
-    // NOTE: using pollfds doesn't work on Linux, so it is disable until further investigation
-    doing_pollfds = 0;
-#endif
-
-    if (doing_pollfds) {
-        log_info("Async using pollfds:");
-
-        const struct libusb_pollfd ** pollfd = libusb_get_pollfds(NULL);
-        for (num_pollfds = 0 ; pollfd[num_pollfds] ; num_pollfds++);
-        pollfd_data_sources = (btstack_data_source_t *)malloc(sizeof(btstack_data_source_t) * num_pollfds);
-        if (!pollfd_data_sources){
-            log_error("Cannot allocate data sources for pollfds");
+    // add libusb pollfds to run loop and track changes
+    const struct libusb_pollfd ** pollfd = libusb_get_pollfds(NULL);
+    if (!pollfd){
+        log_error("libusb does not provide pollfds");
+        usb_close();
+        return -1;
+    }
+    log_info("Async using pollfds:");
+    for (c = 0 ; pollfd[c] ; c++) {
+        if (usb_pollfd_add(pollfd[c]->fd, pollfd[c]->events)){
+            free(pollfd);
             usb_close();
-            return 1;            
-        }
-        memset(pollfd_data_sources, 0, sizeof(btstack_data_source_t) * num_pollfds);
-        for (r = 0 ; r < num_pollfds ; r++) {
-            btstack_data_source_t *ds = &pollfd_data_sources[r];
-            btstack_run_loop_set_data_source_fd(ds, pollfd[r]->fd);
-            btstack_run_loop_set_data_source_handler(ds, &usb_process_ds);
-            btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
-            btstack_run_loop_add_data_source(ds);
-            log_info("%u: %p fd: %u, events %x", r, pollfd[r], pollfd[r]->fd, pollfd[r]->events);
+            return LIBUSB_ERROR_NO_MEM;
         }
-        free(pollfd);
-    } else {
-        log_info("Async using timers:");
-
-        usb_timer.process = usb_process_ts;
-        btstack_run_loop_set_timer(&usb_timer, ASYNC_POLLING_INTERVAL_MS);
-        btstack_run_loop_add_timer(&usb_timer);
-        usb_timer_active = 1;
     }
+    free(pollfd);
+    libusb_set_pollfd_notifiers(NULL, &usb_pollfd_added, &usb_pollfd_removed, NULL);
+    pollfd_notifiers_registered = 1;
+
+    // libusb timeouts are handled via pollfds, e.g. timerfd, or via run loop timer
+    usb_handle_timeouts = !libusb_pollfds_handle_timeouts(NULL);
+    usb_update_timeout();
 
     usb_transport_open = 1;
 
@@ -1170,34 +1372,43 @@ static int usb_close(void){
                 btstack_run_loop_remove_timer(&usb_timer);
                 usb_timer_active = 0;
             }
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+            if (acl_out_packet_sent_timer_active){
+                btstack_run_loop_remove_timer(&acl_out_packet_sent_timer);
+                acl_out_packet_sent_timer_active = 0;
+            }
+            acl_out_packet_sent_pending = 0;
+#endif
 
-            if (doing_pollfds){
-                int r;
-                for (r = 0 ; r < num_pollfds ; r++) {
-                    btstack_data_source_t *ds = &pollfd_data_sources[r];
-                    btstack_run_loop_remove_data_source(ds);
-                }
-                free(pollfd_data_sources);
-                pollfd_data_sources = NULL;
-                num_pollfds = 0;
-                doing_pollfds = 0;
+            if (pollfd_notifiers_registered){
+                libusb_set_pollfd_notifiers(NULL, NULL, NULL, NULL);
+                pollfd_notifiers_registered = 0;
             }
+            usb_pollfd_remove_all();
 
         case LIB_USB_INTERFACE_CLAIMED:
             // Cancel all transfers, ignore warnings for this
             libusb_set_debug(NULL, LIBUSB_LOG_LEVEL_ERROR);
-            for (c = 0 ; c < EVENT_IN_BUFFER_COUNT ; c++) {
+            for (c = 0 ; c < event_in_transfer_count ; c++) {
                 if (event_in_transfer[c]){
                     log_info("cancel event_in_transfer[%u] = %p", c, event_in_transfer[c]);
                     libusb_cancel_transfer(event_in_transfer[c]);
                 }
             }
-            for (c = 0 ; c < ACL_IN_BUFFER_COUNT ; c++) {
+            for (c = 0 ; c < acl_in_transfer_count ; c++) {
                 if (acl_in_transfer[c]){
                     log_info("cancel acl_in_transfer[%u] = %p", c, acl_in_transfer[c]);
                     libusb_cancel_transfer(acl_in_transfer[c]);
                 }
             }
+            for (c = 0 ; c < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT ; c++) {
+                if (acl_out_transfers_in_flight[c]){
+                    log_info("cancel acl_out_transfers[%u] = %p", c, acl_out_transfers[c]);
+                    libusb_cancel_transfer(acl_out_transfers[c]);
+                    acl_out_transfers_in_flight[c] = 0;
+                }
+            }
+            usb_acl_out_active = 0;
 #ifdef ENABLE_SCO_OVER_HCI
             for (c = 0 ; c < SCO_IN_BUFFER_COUNT ; c++) {
                 if (sco_in_transfer[c]){
@@ -1231,7 +1442,7 @@ static int usb_close(void){
                 libusb_handle_events_timeout(NULL, &tv);
                 // check if all done
                 completed = 1;
-                for (c=0;c<EVENT_IN_BUFFER_COUNT;c++){
+                for (c=0;c<event_in_transfer_count;c++){
                     if (event_in_transfer[c]) {
                         log_info("event_in_transfer[%u] still active (%p)", c, event_in_transfer[c]);
                         completed = 0;
@@ -1241,7 +1452,7 @@ static int usb_close(void){
 
                 if (!completed) continue;
 
-                for (c=0;c<ACL_IN_BUFFER_COUNT;c++){
+                for (c=0;c<acl_in_transfer_count;c++){
                     if (acl_in_transfer[c]) {
                         log_info("acl_in_transfer[%u] still active (%p)", c, acl_in_transfer[c]);
                         completed = 0;
@@ -1288,6 +1499,8 @@ static int usb_close(void){
             libusb_exit(NULL);
     }
 
+    usb_free_in_transfers();
+
     libusb_state = LIB_USB_CLOSED;
     handle = NULL;
     usb_transport_open = 0;
@@ -1330,23 +1543,56 @@ static int usb_send_acl_packet(uint8_t *packet, int size){
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return -1;
 
     // log_info("usb_send_acl_packet enter, size %u", size);
-    
+
+    // get free transfer
+    int slot;
+    for (slot = 0; slot < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT; slot++){
+        if (!acl_out_transfers_in_flight[slot]) break;
+    }
+    if (slot == HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT){
+        log_error("usb_send_acl_packet: no free transfer");
+        return -1;
+    }
+    struct libusb_transfer * transfer = acl_out_transfers[slot];
+
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    // copy packet, so that upper layer can provide the next one while this one is in flight
+    if (size > HCI_OUTGOING_PACKET_BUFFER_SIZE){
+        log_error("usb_send_acl_packet: size %u > buffer size", size);
+        return -1;
+    }
+    memcpy(acl_out_buffers[slot], packet, size);
+    packet = acl_out_buffers[slot];
+#endif
+
     // prepare transfer
-    int completed = 0;
-    libusb_fill_bulk_transfer(acl_out_transfer, handle, acl_out_addr, packet, size,
-        async_callback, &completed, 0);
-    acl_out_transfer->type = LIBUSB_TRANSFER_TYPE_BULK;
+    libusb_fill_bulk_transfer(transfer, handle, acl_out_addr, packet, size,
+        async_callback, NULL, 0);
+    transfer->type = LIBUSB_TRANSFER_TYPE_BULK;
 
     // update stata before submitting transfer
-    usb_acl_out_active = 1;
+    acl_out_transfers_in_flight[slot] = 1;
+    usb_acl_out_active++;
 
-    r = libusb_submit_transfer(acl_out_transfer);
+    r = libusb_submit_transfer(transfer);
     if (r < 0) {
-        usb_acl_out_active = 0;
+        acl_out_transfers_in_flight[slot] = 0;
+        usb_acl_out_active--;
         log_error("Error submitting acl transfer, %d", r);
         return -1;
     }
 
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    // report packet as sent from run loop if another transfer is free, or on next completed transfer
+    acl_out_packet_sent_pending = 1;
+    if (usb_acl_out_active < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT){
+        btstack_run_loop_set_timer_handler(&acl_out_packet_sent_timer, &usb_acl_out_packet_sent_handler);
+        btstack_run_loop_set_timer(&acl_out_packet_sent_timer, 0);
+        btstack_run_loop_add_timer(&acl_out_packet_sent_timer);
+        acl_out_packet_sent_timer_active = 1;
+    }
+#endif
+
     return 0;
 }
 
@@ -1355,7 +1601,12 @@ static int usb_can_send_packet_now(uint8_t packet_type){
         case HCI_COMMAND_DATA_PACKET:
             return !usb_command_active;
         case HCI_ACL_DATA_PACKET:
-            return !usb_acl_out_active;
+        // ISO data is sent over the bulk endpoint, too
+        case HCI_ISO_DATA_PACKET:
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+            if (acl_out_packet_sent_pending) return 0;
+#endif
+            return usb_acl_out_active < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT;
 #ifdef ENABLE_SCO_OVER_HCI
         case HCI_SCO_DATA_PACKET:
             if (!sco_enabled) return 0;
@@ -1371,6 +1622,7 @@ static int usb_send_packet(uint8_t packet_type, uint8_t * packet, int size){
         case HCI_COMMAND_DATA_PACKET:
             return usb_send_cmd_packet(packet, size);
         case HCI_ACL_DATA_PACKET:
+        case HCI_ISO_DATA_PACKET:
             return usb_send_acl_packet(packet, size);
 #ifdef ENABLE_SCO_OVER_HCI
         case HCI_SCO_DATA_PACKET:
@@ -1388,7 +1640,9 @@ static void usb_set_sco_config(uint16_t voice_setting, int num_connections){
 
     log_info("usb_set_sco_config: voice settings 0x%04x, num connections %u", voice_setting, num_connections);
 
-    if (num_connections != sco_num_connections){
+    // restart SCO if number of connections or required alt setting changes, e.g. CVSD -> mSBC
+    int alt_setting_changed = usb_sco_alt_setting(voice_setting, num_connections) != usb_sco_alt_setting(sco_voice_setting, sco_num_connections);
+    if ((num_connections != sco_num_connections) || alt_setting_changed){
         sco_voice_setting = voice_setting;
         if (sco_num_connections){
             usb_sco_stop();
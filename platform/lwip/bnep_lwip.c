@@ -104,6 +104,9 @@ static btstack_packet_handler_t client_handler;
 // next packet only modified from btstack context
 static struct pbuf * bnep_lwip_outgoing_next_packet;
 
+// packet sent via bnep_send_iov, released on next can send now
+static struct pbuf * bnep_lwip_outgoing_in_flight_packet;
+
 // temp buffer to unchain buffer
 static uint8_t btstack_network_outgoing_buffer[HCI_ACL_PAYLOAD_SIZE];
 
@@ -177,6 +180,12 @@ static void bnep_lwip_outgoing_packet_processed(void){
     bnep_lwip_outgoing_next_packet = NULL;
 }
 
+static void bnep_lwip_outgoing_release_in_flight_packet(void){
+    if (bnep_lwip_outgoing_in_flight_packet == NULL) return;
+    bnep_lwip_free_pbuf(bnep_lwip_outgoing_in_flight_packet);
+    bnep_lwip_outgoing_in_flight_packet = NULL;
+}
+
 static void bnep_lwip_trigger_outgoing_process(void){
 #if NO_SYS
     bnep_lwip_outgoing_process(NULL);
@@ -365,26 +374,53 @@ static void bnep_lwip_outgoing_process(void * arg){
     bnep_request_can_send_now_event(bnep_cid);
 }
 
-static void bnep_lwip_send_packet(void){
-    if (bnep_lwip_outgoing_next_packet == NULL){
-        log_error("CAN SEND NOW, but now packet queued");
-        return;
+// returns true if pbuf chain was passed to bnep_send_iov and needs to stay valid
+static bool bnep_lwip_send_packet(void){
+    struct pbuf * p = bnep_lwip_outgoing_next_packet;
+
+    // send pbuf chain without copy if it has few enough segments
+    btstack_iovec_t iov[HCI_TRANSPORT_IOV_MAX];
+    uint16_t iov_count = 0;
+    struct pbuf * q;
+    for (q = p; q != NULL; q = q->next){
+        if (iov_count == HCI_TRANSPORT_IOV_MAX) break;
+        iov[iov_count].base = (const uint8_t *) q->payload;
+        iov[iov_count].len  = q->len;
+        iov_count++;
+        if (q->tot_len == q->len) break;
+    }
+    if ((q != NULL) && (q->tot_len == q->len)){
+        bnep_send_iov(bnep_cid, iov, iov_count);
+        return true;
     }
 
     // flatten into our buffer
-    uint32_t len = btstack_min(sizeof(btstack_network_outgoing_buffer), bnep_lwip_outgoing_next_packet->tot_len);
-    pbuf_copy_partial(bnep_lwip_outgoing_next_packet, btstack_network_outgoing_buffer, len, 0);
+    uint32_t len = btstack_min(sizeof(btstack_network_outgoing_buffer), p->tot_len);
+    pbuf_copy_partial(p, btstack_network_outgoing_buffer, len, 0);
     bnep_send(bnep_cid, (uint8_t*) btstack_network_outgoing_buffer, len);
+    return false;
 }
 
-static void bnep_lwip_packet_sent(void){
+static void bnep_lwip_packet_sent(bool in_flight){
     log_debug("bnep_lwip_packet_sent: %p", bnep_lwip_outgoing_next_packet);
 
-    // release current packet
-    bnep_lwip_outgoing_packet_processed();
+    if (in_flight){
+        // keep pbuf until next can send now
+        bnep_lwip_outgoing_in_flight_packet = bnep_lwip_outgoing_next_packet;
+        bnep_lwip_outgoing_next_packet = NULL;
+    } else {
+        // release current packet
+        bnep_lwip_outgoing_packet_processed();
+    }
 
     // more ?
-    if (bnep_lwip_outgoing_packets_empty()) return;
+    if (bnep_lwip_outgoing_packets_empty()){
+        // get can send now to release in flight packet
+        if (in_flight){
+            bnep_request_can_send_now_event(bnep_cid);
+        }
+        return;
+    }
     bnep_lwip_trigger_outgoing_process();
 }
 
@@ -394,6 +430,9 @@ static void bnep_lwip_discard_packets(void){
         bnep_lwip_outgoing_packet_processed();
     }
 
+    // discard packet passed to bnep_send_iov
+    bnep_lwip_outgoing_release_in_flight_packet();
+
     // reset queue
     bnep_lwip_outgoing_reset_queue();
 }
@@ -449,8 +488,10 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                  * stored network packet. The tap datas source can be enabled again
                  */
                 case BNEP_EVENT_CAN_SEND_NOW:
-                    bnep_lwip_send_packet();
-                    bnep_lwip_packet_sent();
+                    // buffers of previous packet not used anymore
+                    bnep_lwip_outgoing_release_in_flight_packet();
+                    if (bnep_lwip_outgoing_next_packet == NULL) break;
+                    bnep_lwip_packet_sent(bnep_lwip_send_packet());
                     break;
                     
                 default:
@@ -42,13 +42,15 @@
 #include <string.h>
 #include "btstack_debug.h"
 #include "btstack_audio.h"
+#include "btstack_ring_buffer_spsc.h"
 #include "btstack_run_loop.h"
 
 #ifdef HAVE_PORTAUDIO
 
 #define PA_SAMPLE_TYPE               paInt16
 #define NUM_FRAMES_PER_PA_BUFFER       512
-#define NUM_OUTPUT_BUFFERS               3
+#define NUM_OUTPUT_BUFFERS               4
+#define NUM_OUTPUT_BUFFERS_QUEUED        2
 #define NUM_INPUT_BUFFERS                2
 #define DRIVER_POLL_INTERVAL_MS          5
 
@@ -75,20 +77,13 @@ static PaStream * stream_sink;
 static void (*playback_callback)(int16_t * buffer, uint16_t num_samples);
 static void (*recording_callback)(const int16_t * buffer, uint16_t num_samples);
 
-// output buffer
-static int16_t               output_buffer_a[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               output_buffer_b[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               output_buffer_c[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t             * output_buffers[NUM_OUTPUT_BUFFERS] = { output_buffer_a, output_buffer_b, output_buffer_c};
-static int                   output_buffer_to_play;
-static int                   output_buffer_to_fill;
+// output ring buffer, filled by BTstack thread, read by portaudio thread
+static uint8_t                    output_storage[NUM_OUTPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 4];   // stereo
+static btstack_ring_buffer_spsc_t output_ring_buffer;
 
-// input buffer
-static int16_t               input_buffer_a[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               input_buffer_b[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t             * input_buffers[NUM_INPUT_BUFFERS] = { input_buffer_a, input_buffer_b};
-static int                   input_buffer_to_record;
-static int                   input_buffer_to_fill;
+// input ring buffer, filled by portaudio thread, read by BTstack thread
+static uint8_t                    input_storage[NUM_INPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 4];     // stereo
+static btstack_ring_buffer_spsc_t input_ring_buffer;
 
 
 // timer to fill output ring buffer
@@ -107,14 +102,15 @@ static int portaudio_callback_sink( const void *                     inputBuffer
     (void) timeInfo; /* Prevent unused variable warnings. */
     (void) statusFlags;
     (void) userData;
-    (void) samples_per_buffer;
     (void) inputBuffer;
 
-    // fill from one of our buffers
-    memcpy(outputBuffer, output_buffers[output_buffer_to_play], NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink);
-
-    // next
-    output_buffer_to_play = (output_buffer_to_play + 1 ) % NUM_OUTPUT_BUFFERS;
+    // fill from output ring buffer, play silence on underrun
+    uint32_t bytes_to_play = samples_per_buffer * num_bytes_per_sample_sink;
+    uint32_t bytes_read;
+    btstack_ring_buffer_spsc_read(&output_ring_buffer, (uint8_t *) outputBuffer, bytes_to_play, &bytes_read);
+    if (bytes_read < bytes_to_play){
+        memset(((uint8_t *) outputBuffer) + bytes_read, 0, bytes_to_play - bytes_read);
+    }
 
     return 0;
 }
@@ -131,26 +127,25 @@ static int portaudio_callback_source( const void *                     inputBuff
     (void) timeInfo; /* Prevent unused variable warnings. */
     (void) statusFlags;
     (void) userData;
-    (void) samples_per_buffer;
     (void) outputBuffer;
 
-    // store in one of our buffers
-    memcpy(input_buffers[input_buffer_to_fill], inputBuffer, NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source);
-
-    // next
-    input_buffer_to_fill = (input_buffer_to_fill + 1 ) % NUM_INPUT_BUFFERS;
+    // store in input ring buffer, drop samples on overrun
+    (void) btstack_ring_buffer_spsc_write(&input_ring_buffer, (const uint8_t *) inputBuffer, samples_per_buffer * num_bytes_per_sample_source);
 
     return 0;
 }
 
 static void driver_timer_handler_sink(btstack_timer_source_t * ts){
 
-    // playback buffer ready to fill
-    if (output_buffer_to_play != output_buffer_to_fill){
-        (*playback_callback)(output_buffers[output_buffer_to_fill], NUM_FRAMES_PER_PA_BUFFER);
-
-        // next
-        output_buffer_to_fill = (output_buffer_to_fill + 1 ) % NUM_OUTPUT_BUFFERS;
+    // fill playback buffer in place if less than NUM_OUTPUT_BUFFERS_QUEUED are queued
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink;
+    if (btstack_ring_buffer_spsc_bytes_available(&output_ring_buffer) < (NUM_OUTPUT_BUFFERS_QUEUED * bytes_per_buffer)){
+        uint32_t region_size;
+        int16_t * buffer = (int16_t *) btstack_ring_buffer_spsc_get_write_region(&output_ring_buffer, &region_size);
+        if (region_size >= bytes_per_buffer){
+            (*playback_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
+            btstack_ring_buffer_spsc_write_commit(&output_ring_buffer, bytes_per_buffer);
+        }
     }
 
     // re-set timer
@@ -160,14 +155,14 @@ static void driver_timer_handler_sink(btstack_timer_source_t * ts){
 
 static void driver_timer_handler_source(btstack_timer_source_t * ts){
 
-    // recording buffer ready to process
-    if (input_buffer_to_record != input_buffer_to_fill){
-
-        (*recording_callback)(input_buffers[input_buffer_to_record], NUM_FRAMES_PER_PA_BUFFER);
-
-        // next
-        input_buffer_to_record = (input_buffer_to_record + 1 ) % NUM_INPUT_BUFFERS;
-    }    
+    // process recorded buffer in place
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source;
+    uint32_t region_size;
+    const int16_t * buffer = (const int16_t *) btstack_ring_buffer_spsc_get_read_region(&input_ring_buffer, &region_size);
+    if (region_size >= bytes_per_buffer){
+        (*recording_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
+        btstack_ring_buffer_spsc_read_commit(&input_ring_buffer, bytes_per_buffer);
+    }
 
     // re-set timer
     btstack_run_loop_set_timer(ts, DRIVER_POLL_INTERVAL_MS);
@@ -306,11 +301,16 @@ static void btstack_audio_portaudio_sink_start_stream(void){
 
     if (!playback_callback) return;
 
-    // fill buffer once
-    (*playback_callback)(output_buffer_a, NUM_FRAMES_PER_PA_BUFFER);
-    (*playback_callback)(output_buffer_b, NUM_FRAMES_PER_PA_BUFFER);
-    output_buffer_to_play = 0;
-    output_buffer_to_fill = 2;
+    // fill buffers once
+    btstack_ring_buffer_spsc_init(&output_ring_buffer, output_storage, sizeof(output_storage));
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink;
+    int i;
+    for (i=0;i<NUM_OUTPUT_BUFFERS_QUEUED;i++){
+        uint32_t region_size;
+        int16_t * buffer = (int16_t *) btstack_ring_buffer_spsc_get_write_region(&output_ring_buffer, &region_size);
+        (*playback_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
+        btstack_ring_buffer_spsc_write_commit(&output_ring_buffer, bytes_per_buffer);
+    }
 
     /* -- start stream -- */
     PaError err = Pa_StartStream(stream_sink);
@@ -331,6 +331,8 @@ static void btstack_audio_portaudio_source_start_stream(void){
 
     if (!recording_callback) return;
 
+    btstack_ring_buffer_spsc_init(&input_ring_buffer, input_storage, sizeof(input_storage));
+
     /* -- start stream -- */
     PaError err = Pa_StartStream(stream_source);
     if (err != paNoError){
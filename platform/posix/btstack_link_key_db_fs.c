@@ -131,28 +131,6 @@ static void set_path(bd_addr_t bd_addr){
     strcat(keypath, LINK_KEY_SUFFIX);
 }
 
-// Device info
-static void db_open(void){
-}
-
-static void db_set_local_bd_addr(bd_addr_t bd_addr){
-    memcpy(local_addr, bd_addr, 6);
-}
-
-static void db_close(void){ 
-}
-
-static void put_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t link_key_type){
-    set_path(bd_addr);
-    char * link_key_str = link_key_to_str(link_key);
-    char * link_key_type_str = link_key_type_to_str(link_key_type); 
-
-    FILE * wFile = fopen(keypath,"w+");
-    fwrite(link_key_str, strlen(link_key_str), 1, wFile);
-    fwrite(link_key_type_str, strlen(link_key_type_str), 1, wFile);
-    fclose(wFile);
-}
-
 static int read_link_key(const char * path, link_key_t link_key, link_key_type_t * link_key_type){
     if (access(path, R_OK)) return 0;
     
@@ -182,12 +160,164 @@ static int read_link_key(const char * path, link_key_t link_key, link_key_type_t
     return 1;
 }
 
-static int get_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t * link_key_type) {
+// In-memory table of all link keys for current local address, loaded on first access
+#define LINK_KEY_DB_FS_NUM_BUCKETS 32
+
+typedef struct link_key_db_fs_entry {
+    struct link_key_db_fs_entry * next;
+    bd_addr_t bd_addr;
+    link_key_t link_key;
+    link_key_type_t link_key_type;
+} link_key_db_fs_entry_t;
+
+typedef struct {
+    int bucket;
+    link_key_db_fs_entry_t * next;
+} link_key_db_fs_iterator_t;
+
+static link_key_db_fs_entry_t * link_key_db_fs_buckets[LINK_KEY_DB_FS_NUM_BUCKETS];
+static int link_key_db_fs_loaded;
+
+static link_key_db_fs_entry_t ** link_key_db_fs_bucket_for_addr(bd_addr_t bd_addr){
+    uint8_t hash = bd_addr[0] ^ bd_addr[1] ^ bd_addr[2] ^ bd_addr[3] ^ bd_addr[4] ^ bd_addr[5];
+    return &link_key_db_fs_buckets[hash & (LINK_KEY_DB_FS_NUM_BUCKETS - 1)];
+}
+
+static link_key_db_fs_entry_t * link_key_db_fs_find(bd_addr_t bd_addr){
+    link_key_db_fs_entry_t * entry;
+    for (entry = *link_key_db_fs_bucket_for_addr(bd_addr); entry != NULL; entry = entry->next){
+        if (bd_addr_cmp(entry->bd_addr, bd_addr) == 0) return entry;
+    }
+    return NULL;
+}
+
+static void link_key_db_fs_set(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t link_key_type){
+    link_key_db_fs_entry_t * entry = link_key_db_fs_find(bd_addr);
+    if (entry == NULL){
+        entry = (link_key_db_fs_entry_t *) malloc(sizeof(link_key_db_fs_entry_t));
+        if (entry == NULL) return;
+        link_key_db_fs_entry_t ** bucket = link_key_db_fs_bucket_for_addr(bd_addr);
+        bd_addr_copy(entry->bd_addr, bd_addr);
+        entry->next = *bucket;
+        *bucket = entry;
+    }
+    memcpy(entry->link_key, link_key, LINK_KEY_LEN);
+    entry->link_key_type = link_key_type;
+}
+
+static void link_key_db_fs_remove(bd_addr_t bd_addr){
+    link_key_db_fs_entry_t ** prev = link_key_db_fs_bucket_for_addr(bd_addr);
+    for (; *prev != NULL; prev = &(*prev)->next){
+        link_key_db_fs_entry_t * entry = *prev;
+        if (bd_addr_cmp(entry->bd_addr, bd_addr) != 0) continue;
+        *prev = entry->next;
+        free(entry);
+        return;
+    }
+}
+
+static void link_key_db_fs_clear(void){
+    int i;
+    for (i=0;i<LINK_KEY_DB_FS_NUM_BUCKETS;i++){
+        while (link_key_db_fs_buckets[i] != NULL){
+            link_key_db_fs_entry_t * entry = link_key_db_fs_buckets[i];
+            link_key_db_fs_buckets[i] = entry->next;
+            free(entry);
+        }
+    }
+    link_key_db_fs_loaded = 0;
+}
+
+// read all link key files for local address
+static void link_key_db_fs_load(void){
+    if (link_key_db_fs_loaded) return;
+    link_key_db_fs_loaded = 1;
+
+    tinydir_dir dir;
+    if (tinydir_open(&dir, LINK_KEY_PATH) != 0) return;
+
+    // construct prefix
+    char prefix[sizeof(LINK_KEY_PREFIX) + LINK_KEY_STRING_LEN + sizeof(LINK_KEY_FOR)];
+    strcpy(prefix, LINK_KEY_PREFIX);
+    strcat(prefix, bd_addr_to_dash_str(local_addr));
+    strcat(prefix, LINK_KEY_FOR);
+
+    while (dir.has_next) {
+        tinydir_file file;
+        tinydir_readfile(&dir, &file);
+        tinydir_next(&dir);
+        // compare
+        if (strncmp(prefix, file.name, strlen(prefix)) != 0) continue;
+        // parse bd_addr
+        bd_addr_t bd_addr;
+        const int addr_offset = sizeof(LINK_KEY_PREFIX) + LINK_KEY_STRING_LEN + sizeof(LINK_KEY_FOR) - 2;   // -1 for each sizeof
+        if (sscanf_bd_addr(&file.name[addr_offset], bd_addr) == 0) continue;
+        // path found, read file
+        link_key_t link_key;
+        link_key_type_t link_key_type;
+        strcpy(keypath, LINK_KEY_PATH);
+        strcat(keypath, file.name);
+        if (read_link_key(keypath, link_key, &link_key_type) == 0) continue;
+        link_key_db_fs_set(bd_addr, link_key, link_key_type);
+    }
+    tinydir_close(&dir);
+}
+
+// Device info
+static void db_open(void){
+}
+
+static void db_set_local_bd_addr(bd_addr_t bd_addr){
+    if (bd_addr_cmp(local_addr, bd_addr) != 0){
+        link_key_db_fs_clear();
+    }
+    memcpy(local_addr, bd_addr, 6);
+}
+
+static void db_close(void){ 
+    link_key_db_fs_clear();
+}
+
+static void put_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t link_key_type){
+    link_key_db_fs_load();
+
     set_path(bd_addr);
-    return read_link_key(keypath, link_key, link_key_type);
+    char * link_key_str = link_key_to_str(link_key);
+    char * link_key_type_str = link_key_type_to_str(link_key_type); 
+
+    // write to temp file and replace existing one
+    char temp_path[sizeof(keypath) + 4];
+    strcpy(temp_path, keypath);
+    strcat(temp_path, ".tmp");
+    FILE * wFile = fopen(temp_path,"w+");
+    if (wFile == NULL){
+        log_error("File %s could not be created.\n", temp_path);
+        return;
+    }
+    fwrite(link_key_str, strlen(link_key_str), 1, wFile);
+    fwrite(link_key_type_str, strlen(link_key_type_str), 1, wFile);
+    fclose(wFile);
+    if (rename(temp_path, keypath) != 0){
+        log_error("File %s could not be renamed.\n", temp_path);
+        remove(temp_path);
+        return;
+    }
+
+    link_key_db_fs_set(bd_addr, link_key, link_key_type);
+}
+
+static int get_link_key(bd_addr_t bd_addr, link_key_t link_key, link_key_type_t * link_key_type) {
+    link_key_db_fs_load();
+    link_key_db_fs_entry_t * entry = link_key_db_fs_find(bd_addr);
+    if (entry == NULL) return 0;
+    memcpy(link_key, entry->link_key, LINK_KEY_LEN);
+    *link_key_type = entry->link_key_type;
+    return 1;
 }
 
 static void delete_link_key(bd_addr_t bd_addr){
+    link_key_db_fs_load();
+    link_key_db_fs_remove(bd_addr);
     set_path(bd_addr);
     if (access(keypath, R_OK)) return;
     if(remove(keypath) != 0){
@@ -196,45 +326,32 @@ static void delete_link_key(bd_addr_t bd_addr){
 }
 
 static int iterator_init(btstack_link_key_iterator_t * it){
-    tinydir_dir * dir = (tinydir_dir *) malloc(sizeof(tinydir_dir));
-    if (!dir) return 0;
-    it->context = dir;
-    tinydir_open(dir, LINK_KEY_PATH);
+    link_key_db_fs_load();
+    link_key_db_fs_iterator_t * fs_it = (link_key_db_fs_iterator_t *) malloc(sizeof(link_key_db_fs_iterator_t));
+    if (!fs_it) return 0;
+    fs_it->bucket = 0;
+    fs_it->next   = link_key_db_fs_buckets[0];
+    it->context = fs_it;
     return 1;
 }
 
 static int  iterator_get_next(btstack_link_key_iterator_t * it, bd_addr_t bd_addr, link_key_t link_key, link_key_type_t * type){
-    (void)bd_addr;
-    (void)link_key;
-    UNUSED(type);
-    tinydir_dir * dir = (tinydir_dir*) it->context;
-
-    // construct prefix
-    strcpy(keypath, LINK_KEY_PREFIX);
-    strcat(keypath, bd_addr_to_dash_str(local_addr));
-    strcat(keypath, LINK_KEY_FOR);
-
-    while (dir->has_next) {
-        tinydir_file file;
-        tinydir_readfile(dir, &file);
-        tinydir_next(dir);
-        // compare 
-        if (strncmp(keypath, file.name, strlen(keypath)) == 0){
-            // parse bd_addr
-            const int addr_offset = sizeof(LINK_KEY_PREFIX) + LINK_KEY_STRING_LEN + sizeof(LINK_KEY_FOR) - 2;   // -1 for each sizeof
-            sscanf_bd_addr(&file.name[addr_offset], bd_addr);
-            // path found, read file
-            strcpy(keypath, LINK_KEY_PATH);
-            strcat(keypath, file.name);
-            read_link_key(keypath, link_key, type);
-            return 1;
-        }
+    link_key_db_fs_iterator_t * fs_it = (link_key_db_fs_iterator_t *) it->context;
+    while (fs_it->next == NULL){
+        fs_it->bucket++;
+        if (fs_it->bucket >= LINK_KEY_DB_FS_NUM_BUCKETS) return 0;
+        fs_it->next = link_key_db_fs_buckets[fs_it->bucket];
     }
-    return 0;
+    // advance before returning entry to allow for deleting it
+    link_key_db_fs_entry_t * entry = fs_it->next;
+    fs_it->next = entry->next;
+    bd_addr_copy(bd_addr, entry->bd_addr);
+    memcpy(link_key, entry->link_key, LINK_KEY_LEN);
+    *type = entry->link_key_type;
+    return 1;
 }
 
 static void iterator_done(btstack_link_key_iterator_t * it){
-    tinydir_close((tinydir_dir*)it->context);
     free(it->context);
     it->context = NULL;
 }
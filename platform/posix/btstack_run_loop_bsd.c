@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_run_loop_bsd.c"
+
+/*
+ *  btstack_run_loop_bsd.c
+ *
+ *  Run loop for BSD-like systems (FreeBSD, macOS) based on kqueue. File descriptors
+ *  are registered once and kevent only reports the ready ones.
+ */
+
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809
+
+#include "btstack_run_loop_bsd.h"
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+#include "btstack_linked_list.h"
+#include "btstack_debug.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BTSTACK_RUN_LOOP_BSD_MAX_EVENTS
+#define BTSTACK_RUN_LOOP_BSD_MAX_EVENTS 16
+#endif
+
+static int kqueue_fd = -1;
+
+// callbacks to execute on main thread, wakeup via pipe
+static pthread_mutex_t       btstack_run_loop_bsd_callbacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                   btstack_run_loop_bsd_pipe_fds[2] = { -1, -1 };
+static btstack_data_source_t btstack_run_loop_bsd_pipe_ds;
+
+// ready events of current iteration, entries get cleared if their data source is removed
+static struct kevent ready_events[BTSTACK_RUN_LOOP_BSD_MAX_EVENTS];
+static int ready_events_count;
+
+// start time. tv_usec/tv_nsec = 0
+#ifdef _POSIX_MONOTONIC_CLOCK
+// use monotonic clock if available
+static struct timespec init_ts;
+#else
+// fallback to gettimeofday
+static struct timeval init_tv;
+#endif
+
+static void btstack_run_loop_bsd_update_filter(btstack_data_source_t * ds, int16_t filter, uint16_t action){
+    struct kevent change;
+    EV_SET(&change, ds->source.fd, filter, action, 0, 0, ds);
+    int res = kevent(kqueue_fd, &change, 1, NULL, 0, NULL);
+    if ((res < 0) && ((action & EV_DELETE) == 0)){
+        log_error("kevent filter %d action 0x%04x for fd %u failed", filter, action, ds->source.fd);
+    }
+}
+
+static uint16_t btstack_run_loop_bsd_action_for_flag(uint16_t flags, uint16_t flag){
+    return (flags & flag) ? EV_ENABLE : EV_DISABLE;
+}
+
+/**
+ * Add data_source to run_loop
+ */
+static void btstack_run_loop_bsd_add_data_source(btstack_data_source_t *ds){
+    btstack_run_loop_base_add_data_source(ds);
+    if (ds->source.fd < 0) return;
+    btstack_run_loop_bsd_update_filter(ds, EVFILT_READ,  EV_ADD | btstack_run_loop_bsd_action_for_flag(ds->flags, DATA_SOURCE_CALLBACK_READ));
+    btstack_run_loop_bsd_update_filter(ds, EVFILT_WRITE, EV_ADD | btstack_run_loop_bsd_action_for_flag(ds->flags, DATA_SOURCE_CALLBACK_WRITE));
+}
+
+/**
+ * Remove data_source from run loop
+ */
+static bool btstack_run_loop_bsd_remove_data_source(btstack_data_source_t *ds){
+    log_debug("btstack_run_loop_bsd_remove_data_source %p\n", ds);
+    if (ds->source.fd >= 0){
+        btstack_run_loop_bsd_update_filter(ds, EVFILT_READ,  EV_DELETE);
+        btstack_run_loop_bsd_update_filter(ds, EVFILT_WRITE, EV_DELETE);
+    }
+    // drop pending events for this data source
+    int i;
+    for (i=0;i<ready_events_count;i++){
+        if (ready_events[i].udata == (void *) ds){
+            ready_events[i].udata = NULL;
+        }
+    }
+    return btstack_run_loop_base_remove_data_source(ds);
+}
+
+static void btstack_run_loop_bsd_update_data_source(btstack_data_source_t * ds, uint16_t old_flags){
+    if (ds->source.fd < 0) return;
+    uint16_t changed = old_flags ^ ds->flags;
+    if (changed & DATA_SOURCE_CALLBACK_READ){
+        btstack_run_loop_bsd_update_filter(ds, EVFILT_READ,  btstack_run_loop_bsd_action_for_flag(ds->flags, DATA_SOURCE_CALLBACK_READ));
+    }
+    if (changed & DATA_SOURCE_CALLBACK_WRITE){
+        btstack_run_loop_bsd_update_filter(ds, EVFILT_WRITE, btstack_run_loop_bsd_action_for_flag(ds->flags, DATA_SOURCE_CALLBACK_WRITE));
+    }
+}
+
+static void btstack_run_loop_bsd_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    btstack_run_loop_base_enable_data_source_callbacks(ds, callback_types);
+    btstack_run_loop_bsd_update_data_source(ds, old_flags);
+}
+
+static void btstack_run_loop_bsd_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    btstack_run_loop_base_disable_data_source_callbacks(ds, callback_types);
+    btstack_run_loop_bsd_update_data_source(ds, old_flags);
+}
+
+/**
+ * Add timer to run_loop
+ */
+static void btstack_run_loop_bsd_add_timer(btstack_timer_source_t *ts){
+    btstack_run_loop_base_add_timer(ts);
+}
+
+/**
+ * Remove timer from run loop
+ */
+static bool btstack_run_loop_bsd_remove_timer(btstack_timer_source_t *ts){
+    return btstack_run_loop_base_remove_timer(ts);
+}
+
+static void btstack_run_loop_bsd_dump_timer(void){
+    btstack_run_loop_base_dump_timer();
+}
+
+#ifdef _POSIX_MONOTONIC_CLOCK
+/**
+ * @brief Returns the timespec which represents the time(stop - start). It might be negative
+ */
+static void timespec_diff(struct timespec *start, struct timespec *stop, struct timespec *result){
+    result->tv_sec = stop->tv_sec - start->tv_sec;
+    if ((stop->tv_nsec - start->tv_nsec) < 0) {
+        result->tv_sec = stop->tv_sec - start->tv_sec - 1;
+        result->tv_nsec = stop->tv_nsec - start->tv_nsec + 1000000000;
+    } else {
+        result->tv_sec = stop->tv_sec - start->tv_sec;
+        result->tv_nsec = stop->tv_nsec - start->tv_nsec;
+    }
+}
+
+/**
+ * @brief Convert timespec to miliseconds, might overflow
+ */
+static uint64_t timespec_to_milliseconds(struct timespec *a){
+    uint64_t ret = 0;
+    uint64_t sec_val = (uint64_t)(a->tv_sec);
+    uint64_t nsec_val = (uint64_t)(a->tv_nsec);
+    ret = (sec_val*1000) + (nsec_val/1000000);
+    return ret;
+}
+
+/**
+ * @brief Returns the milisecond value of (stop - start). Might overflow
+ */
+static uint64_t timespec_diff_milis(struct timespec* start, struct timespec* stop){
+    struct timespec diff_ts;
+    timespec_diff(start, stop, &diff_ts);
+    return timespec_to_milliseconds(&diff_ts);
+}
+#endif
+
+/**
+ * @brief Queries the current time in ms since start
+ */
+static uint32_t btstack_run_loop_bsd_get_time_ms(void){
+    uint32_t time_ms;
+#ifdef _POSIX_MONOTONIC_CLOCK
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    time_ms = (uint32_t) timespec_diff_milis(&init_ts, &now_ts);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    time_ms = (uint32_t) ((tv.tv_sec  - init_tv.tv_sec) * 1000) + (tv.tv_usec / 1000);
+#endif
+    return time_ms;
+}
+
+/**
+ * Execute run_loop
+ */
+static void btstack_run_loop_bsd_execute(void) {
+
+    log_info("BSD run loop with kqueue");
+
+    while (true) {
+
+        // get next timeout, NULL = wait forever
+        struct timespec * timeout = NULL;
+        struct timespec ts;
+        int32_t timeout_ms = btstack_run_loop_base_get_time_until_timeout(btstack_run_loop_bsd_get_time_ms());
+        if (timeout_ms >= 0){
+            ts.tv_sec  = timeout_ms / 1000;
+            ts.tv_nsec = (long) (timeout_ms - (ts.tv_sec * 1000)) * 1000000;
+            timeout = &ts;
+            log_debug("btstack_run_loop_execute next timeout in %u ms", timeout_ms);
+        }
+
+        // wait for ready FDs
+        int res = kevent(kqueue_fd, NULL, 0, ready_events, BTSTACK_RUN_LOOP_BSD_MAX_EVENTS, timeout);
+        ready_events_count = (res < 0) ? 0 : res;
+
+        // process ready data sources. removed data sources are cleared from the array
+        int i;
+        for (i=0;i<ready_events_count;i++){
+            btstack_data_source_t * ds = (btstack_data_source_t *) ready_events[i].udata;
+            if (ds == NULL) continue;
+            if ((ready_events[i].filter == EVFILT_READ) && (ds->flags & DATA_SOURCE_CALLBACK_READ)){
+                log_debug("btstack_run_loop_bsd_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+            }
+            if ((ready_events[i].filter == EVFILT_WRITE) && (ds->flags & DATA_SOURCE_CALLBACK_WRITE)){
+                log_debug("btstack_run_loop_bsd_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+            }
+        }
+        ready_events_count = 0;
+
+        // process timers
+        btstack_run_loop_base_process_timers(btstack_run_loop_bsd_get_time_ms());
+    }
+}
+
+static void btstack_run_loop_bsd_process_callbacks(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    // drain pipe
+    uint8_t buffer[16];
+    while (read(ds->source.fd, buffer, sizeof(buffer)) > 0);
+    // execute callbacks, unlock during callback to allow it to register again
+    while (true){
+        pthread_mutex_lock(&btstack_run_loop_bsd_callbacks_mutex);
+        btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+        pthread_mutex_unlock(&btstack_run_loop_bsd_callbacks_mutex);
+        if (callback_registration == NULL) break;
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_bsd_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    pthread_mutex_lock(&btstack_run_loop_bsd_callbacks_mutex);
+    btstack_run_loop_base_add_callback(callback_registration);
+    pthread_mutex_unlock(&btstack_run_loop_bsd_callbacks_mutex);
+    // wake up main thread, pipe is full only if wakeup is already pending
+    const uint8_t wakeup = 0;
+    ssize_t res = write(btstack_run_loop_bsd_pipe_fds[1], &wakeup, 1);
+    UNUSED(res);
+}
+
+// set timer
+static void btstack_run_loop_bsd_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+    uint32_t time_ms = btstack_run_loop_bsd_get_time_ms();
+    a->timeout = time_ms + timeout_in_ms;
+    log_debug("btstack_run_loop_bsd_set_timer to %u ms (now %u, timeout %u)", a->timeout, time_ms, timeout_in_ms);
+}
+
+static void btstack_run_loop_bsd_init(void){
+    btstack_run_loop_base_init();
+    ready_events_count = 0;
+    if (kqueue_fd >= 0){
+        close(kqueue_fd);
+    }
+    kqueue_fd = kqueue();
+    btstack_assert(kqueue_fd >= 0);
+#ifdef _POSIX_MONOTONIC_CLOCK
+    clock_gettime(CLOCK_MONOTONIC, &init_ts);
+    init_ts.tv_nsec = 0;
+#else
+    // just assume that we started at tv_usec == 0
+    gettimeofday(&init_tv, NULL);
+    init_tv.tv_usec = 0;
+#endif
+
+    // create pipe once, it's used for the lifetime of the process
+    if (btstack_run_loop_bsd_pipe_fds[0] < 0){
+        if (pipe(btstack_run_loop_bsd_pipe_fds) != 0){
+            log_error("pipe() failed, execute on main thread not supported");
+            return;
+        }
+        fcntl(btstack_run_loop_bsd_pipe_fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(btstack_run_loop_bsd_pipe_fds[1], F_SETFL, O_NONBLOCK);
+    }
+    btstack_run_loop_bsd_pipe_ds.source.fd = btstack_run_loop_bsd_pipe_fds[0];
+    btstack_run_loop_bsd_pipe_ds.process   = &btstack_run_loop_bsd_process_callbacks;
+    btstack_run_loop_bsd_pipe_ds.flags     = DATA_SOURCE_CALLBACK_READ;
+    btstack_run_loop_bsd_add_data_source(&btstack_run_loop_bsd_pipe_ds);
+}
+
+
+static const btstack_run_loop_t btstack_run_loop_bsd = {
+    &btstack_run_loop_bsd_init,
+    &btstack_run_loop_bsd_add_data_source,
+    &btstack_run_loop_bsd_remove_data_source,
+    &btstack_run_loop_bsd_enable_data_source_callbacks,
+    &btstack_run_loop_bsd_disable_data_source_callbacks,
+    &btstack_run_loop_bsd_set_timer,
+    &btstack_run_loop_bsd_add_timer,
+    &btstack_run_loop_bsd_remove_timer,
+    &btstack_run_loop_bsd_execute,
+    &btstack_run_loop_bsd_dump_timer,
+    &btstack_run_loop_bsd_get_time_ms,
+    &btstack_run_loop_bsd_execute_on_main_thread,
+};
+
+/**
+ * Provide btstack_run_loop_bsd instance
+ */
+const btstack_run_loop_t * btstack_run_loop_bsd_get_instance(void){
+    return &btstack_run_loop_bsd;
+}
+
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_run_loop_linux.c"
+
+/*
+ *  btstack_run_loop_linux.c
+ *
+ *  Run loop for Linux based on epoll. File descriptors are registered once
+ *  and epoll_wait only reports the ready ones.
+ */
+
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809
+
+#include "btstack_run_loop_linux.h"
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+#include "btstack_linked_list.h"
+#include "btstack_debug.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BTSTACK_RUN_LOOP_LINUX_MAX_EVENTS
+#define BTSTACK_RUN_LOOP_LINUX_MAX_EVENTS 16
+#endif
+
+static int epoll_fd = -1;
+
+// ready events of current iteration, entries get cleared if their data source is removed
+static struct epoll_event ready_events[BTSTACK_RUN_LOOP_LINUX_MAX_EVENTS];
+static int ready_events_count;
+
+// callbacks to execute on main thread, wakeup via eventfd
+static pthread_mutex_t       btstack_run_loop_linux_callbacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                   btstack_run_loop_linux_event_fd = -1;
+static btstack_data_source_t btstack_run_loop_linux_event_ds;
+
+// start time. tv_usec/tv_nsec = 0
+#ifdef _POSIX_MONOTONIC_CLOCK
+// use monotonic clock if available
+static struct timespec init_ts;
+#else
+// fallback to gettimeofday
+static struct timeval init_tv;
+#endif
+
+static uint32_t btstack_run_loop_linux_epoll_events_for_flags(uint16_t flags){
+    uint32_t events = 0;
+    if (flags & DATA_SOURCE_CALLBACK_READ){
+        events |= EPOLLIN;
+    }
+    if (flags & DATA_SOURCE_CALLBACK_WRITE){
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+static void btstack_run_loop_linux_update_epoll(btstack_data_source_t * ds, int op){
+    if (ds->source.fd < 0) return;
+    // kernels before 2.6.9 require a non-null event for EPOLL_CTL_DEL
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = btstack_run_loop_linux_epoll_events_for_flags(ds->flags);
+    event.data.ptr = ds;
+    int res = epoll_ctl(epoll_fd, op, ds->source.fd, &event);
+    if (res < 0){
+        log_error("epoll_ctl op %u for fd %u failed", op, ds->source.fd);
+    }
+}
+
+// fds are only registered while read or write callbacks are enabled, as epoll always reports errors and hangups
+static void btstack_run_loop_linux_flags_changed(btstack_data_source_t * ds, uint16_t old_flags){
+    if (old_flags == ds->flags) return;
+    bool was_registered = btstack_run_loop_linux_epoll_events_for_flags(old_flags) != 0;
+    bool is_registered  = btstack_run_loop_linux_epoll_events_for_flags(ds->flags) != 0;
+    if (was_registered && is_registered){
+        btstack_run_loop_linux_update_epoll(ds, EPOLL_CTL_MOD);
+    } else if (is_registered){
+        btstack_run_loop_linux_update_epoll(ds, EPOLL_CTL_ADD);
+    } else if (was_registered){
+        btstack_run_loop_linux_update_epoll(ds, EPOLL_CTL_DEL);
+    }
+}
+
+/**
+ * Add data_source to run_loop
+ */
+static void btstack_run_loop_linux_add_data_source(btstack_data_source_t *ds){
+    btstack_run_loop_base_add_data_source(ds);
+    btstack_run_loop_linux_flags_changed(ds, 0);
+}
+
+/**
+ * Remove data_source from run loop
+ */
+static bool btstack_run_loop_linux_remove_data_source(btstack_data_source_t *ds){
+    log_debug("btstack_run_loop_linux_remove_data_source %p\n", ds);
+    if (btstack_run_loop_linux_epoll_events_for_flags(ds->flags) != 0){
+        btstack_run_loop_linux_update_epoll(ds, EPOLL_CTL_DEL);
+    }
+    // drop pending events for this data source
+    int i;
+    for (i=0;i<ready_events_count;i++){
+        if (ready_events[i].data.ptr == ds){
+            ready_events[i].data.ptr = NULL;
+        }
+    }
+    return btstack_run_loop_base_remove_data_source(ds);
+}
+
+static void btstack_run_loop_linux_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    btstack_run_loop_base_enable_data_source_callbacks(ds, callback_types);
+    btstack_run_loop_linux_flags_changed(ds, old_flags);
+}
+
+static void btstack_run_loop_linux_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint16_t old_flags = ds->flags;
+    btstack_run_loop_base_disable_data_source_callbacks(ds, callback_types);
+    btstack_run_loop_linux_flags_changed(ds, old_flags);
+}
+
+/**
+ * Add timer to run_loop
+ */
+static void btstack_run_loop_linux_add_timer(btstack_timer_source_t *ts){
+    btstack_run_loop_base_add_timer(ts);
+}
+
+/**
+ * Remove timer from run loop
+ */
+static bool btstack_run_loop_linux_remove_timer(btstack_timer_source_t *ts){
+    return btstack_run_loop_base_remove_timer(ts);
+}
+
+static void btstack_run_loop_linux_dump_timer(void){
+    btstack_run_loop_base_dump_timer();
+}
+
+#ifdef _POSIX_MONOTONIC_CLOCK
+/**
+ * @brief Returns the timespec which represents the time(stop - start). It might be negative
+ */
+static void timespec_diff(struct timespec *start, struct timespec *stop, struct timespec *result){
+    result->tv_sec = stop->tv_sec - start->tv_sec;
+    if ((stop->tv_nsec - start->tv_nsec) < 0) {
+        result->tv_sec = stop->tv_sec - start->tv_sec - 1;
+        result->tv_nsec = stop->tv_nsec - start->tv_nsec + 1000000000;
+    } else {
+        result->tv_sec = stop->tv_sec - start->tv_sec;
+        result->tv_nsec = stop->tv_nsec - start->tv_nsec;
+    }
+}
+
+/**
+ * @brief Convert timespec to miliseconds, might overflow
+ */
+static uint64_t timespec_to_milliseconds(struct timespec *a){
+    uint64_t ret = 0;
+    uint64_t sec_val = (uint64_t)(a->tv_sec);
+    uint64_t nsec_val = (uint64_t)(a->tv_nsec);
+    ret = (sec_val*1000) + (nsec_val/1000000);
+    return ret;
+}
+
+/**
+ * @brief Returns the milisecond value of (stop - start). Might overflow
+ */
+static uint64_t timespec_diff_milis(struct timespec* start, struct timespec* stop){
+    struct timespec diff_ts;
+    timespec_diff(start, stop, &diff_ts);
+    return timespec_to_milliseconds(&diff_ts);
+}
+#endif
+
+/**
+ * @brief Queries the current time in ms since start
+ */
+static uint32_t btstack_run_loop_linux_get_time_ms(void){
+    uint32_t time_ms;
+#ifdef _POSIX_MONOTONIC_CLOCK
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    time_ms = (uint32_t) timespec_diff_milis(&init_ts, &now_ts);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    time_ms = (uint32_t) ((tv.tv_sec  - init_tv.tv_sec) * 1000) + (tv.tv_usec / 1000);
+#endif
+    return time_ms;
+}
+
+/**
+ * Execute run_loop
+ */
+static void btstack_run_loop_linux_execute(void) {
+
+    log_info("Linux run loop with epoll");
+
+    while (true) {
+
+        // get next timeout, -1 = wait forever
+        int32_t timeout_ms = btstack_run_loop_base_get_time_until_timeout(btstack_run_loop_linux_get_time_ms());
+        log_debug("btstack_run_loop_execute next timeout in %d ms", timeout_ms);
+
+        // wait for ready FDs
+        int res = epoll_wait(epoll_fd, ready_events, BTSTACK_RUN_LOOP_LINUX_MAX_EVENTS, (int) timeout_ms);
+        ready_events_count = (res < 0) ? 0 : res;
+
+        // process ready data sources. removed data sources are cleared from the array
+        int i;
+        for (i=0;i<ready_events_count;i++){
+            uint32_t events = ready_events[i].events;
+            btstack_data_source_t * ds = (btstack_data_source_t *) ready_events[i].data.ptr;
+            if (ds == NULL) continue;
+            // report errors and hangups to enabled callbacks, so that read/write can fail
+            if (events & (EPOLLERR | EPOLLHUP)){
+                events |= EPOLLIN | EPOLLOUT;
+            }
+            if ((events & EPOLLIN) && (ds->flags & DATA_SOURCE_CALLBACK_READ)){
+                log_debug("btstack_run_loop_linux_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+            }
+            // data source might have been removed by read callback
+            if (ready_events[i].data.ptr == NULL) continue;
+            if ((events & EPOLLOUT) && (ds->flags & DATA_SOURCE_CALLBACK_WRITE)){
+                log_debug("btstack_run_loop_linux_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+            }
+        }
+        ready_events_count = 0;
+
+        // process timers
+        btstack_run_loop_base_process_timers(btstack_run_loop_linux_get_time_ms());
+    }
+}
+
+static void btstack_run_loop_linux_process_callbacks(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    // reset eventfd counter
+    uint64_t counter;
+    ssize_t res = read(ds->source.fd, &counter, sizeof(counter));
+    UNUSED(res);
+    // execute callbacks, unlock during callback to allow it to register again
+    while (true){
+        pthread_mutex_lock(&btstack_run_loop_linux_callbacks_mutex);
+        btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+        pthread_mutex_unlock(&btstack_run_loop_linux_callbacks_mutex);
+        if (callback_registration == NULL) break;
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_linux_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    pthread_mutex_lock(&btstack_run_loop_linux_callbacks_mutex);
+    btstack_run_loop_base_add_callback(callback_registration);
+    pthread_mutex_unlock(&btstack_run_loop_linux_callbacks_mutex);
+    // wake up main thread
+    const uint64_t increment = 1;
+    ssize_t res = write(btstack_run_loop_linux_event_fd, &increment, sizeof(increment));
+    UNUSED(res);
+}
+
+// set timer
+static void btstack_run_loop_linux_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+    uint32_t time_ms = btstack_run_loop_linux_get_time_ms();
+    a->timeout = time_ms + timeout_in_ms;
+    log_debug("btstack_run_loop_linux_set_timer to %u ms (now %u, timeout %u)", a->timeout, time_ms, timeout_in_ms);
+}
+
+static void btstack_run_loop_linux_init(void){
+    btstack_run_loop_base_init();
+    ready_events_count = 0;
+    if (epoll_fd >= 0){
+        close(epoll_fd);
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    btstack_assert(epoll_fd >= 0);
+#ifdef _POSIX_MONOTONIC_CLOCK
+    clock_gettime(CLOCK_MONOTONIC, &init_ts);
+    init_ts.tv_nsec = 0;
+#else
+    // just assume that we started at tv_usec == 0
+    gettimeofday(&init_tv, NULL);
+    init_tv.tv_usec = 0;
+#endif
+
+    // create eventfd once, it's used for the lifetime of the process
+    if (btstack_run_loop_linux_event_fd < 0){
+        btstack_run_loop_linux_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (btstack_run_loop_linux_event_fd < 0){
+            log_error("eventfd() failed, execute on main thread not supported");
+            return;
+        }
+    }
+    btstack_run_loop_linux_event_ds.source.fd = btstack_run_loop_linux_event_fd;
+    btstack_run_loop_linux_event_ds.process   = &btstack_run_loop_linux_process_callbacks;
+    btstack_run_loop_linux_event_ds.flags     = DATA_SOURCE_CALLBACK_READ;
+    btstack_run_loop_linux_add_data_source(&btstack_run_loop_linux_event_ds);
+}
+
+
+static const btstack_run_loop_t btstack_run_loop_linux = {
+    &btstack_run_loop_linux_init,
+    &btstack_run_loop_linux_add_data_source,
+    &btstack_run_loop_linux_remove_data_source,
+    &btstack_run_loop_linux_enable_data_source_callbacks,
+    &btstack_run_loop_linux_disable_data_source_callbacks,
+    &btstack_run_loop_linux_set_timer,
+    &btstack_run_loop_linux_add_timer,
+    &btstack_run_loop_linux_remove_timer,
+    &btstack_run_loop_linux_execute,
+    &btstack_run_loop_linux_dump_timer,
+    &btstack_run_loop_linux_get_time_ms,
+    &btstack_run_loop_linux_execute_on_main_thread,
+};
+
+/**
+ * Provide btstack_run_loop_linux instance
+ */
+const btstack_run_loop_t * btstack_run_loop_linux_get_instance(void){
+    return &btstack_run_loop_linux;
+}
+
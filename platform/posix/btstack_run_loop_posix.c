@@ -49,10 +49,13 @@
 #include "btstack_run_loop_posix.h"
 
 #include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_util.h"
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
 
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/select.h>
@@ -60,12 +63,14 @@
 #include <time.h>
 #include <unistd.h>
 
-static void btstack_run_loop_posix_dump_timer(void);
-
 // the run loop
 static btstack_linked_list_t data_sources;
 static int data_sources_modified;
-static btstack_linked_list_t timers;
+
+// callbacks to execute on main thread, wakeup via pipe
+static pthread_mutex_t       btstack_run_loop_posix_callbacks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int                   btstack_run_loop_posix_pipe_fds[2] = { -1, -1 };
+static btstack_data_source_t btstack_run_loop_posix_pipe_ds;
 
 // start time. tv_usec/tv_nsec = 0
 #ifdef _POSIX_MONOTONIC_CLOCK
@@ -95,39 +100,22 @@ static bool btstack_run_loop_posix_remove_data_source(btstack_data_source_t *ds)
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_posix_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        btstack_assert(next != ts);
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
     log_debug("Added timer %p at %u\n", ts, ts->timeout);
-    // btstack_run_loop_posix_dump_timer();
 }
 
 /**
  * Remove timer from run loop
  */
 static bool btstack_run_loop_posix_remove_timer(btstack_timer_source_t *ts){
-    // log_info("Removed timer %x at %u\n", (int) ts, (unsigned int) ts->timeout.tv_sec);
-    // btstack_run_loop_posix_dump_timer();
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(ts);
 }
 
 static void btstack_run_loop_posix_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u (%p): timeout %u\n", i, ts, ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer();
 }
 
 static void btstack_run_loop_posix_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
@@ -191,6 +179,20 @@ static uint32_t btstack_run_loop_posix_get_time_ms(void){
     return time_ms;
 }
 
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+static uint32_t btstack_run_loop_posix_get_time_us(void){
+#ifdef _POSIX_MONOTONIC_CLOCK
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    return (uint32_t) (((now_ts.tv_sec - init_ts.tv_sec) * 1000000) + (now_ts.tv_nsec / 1000));
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint32_t) (((tv.tv_sec - init_tv.tv_sec) * 1000000) + tv.tv_usec);
+#endif
+}
+#endif
+
 /**
  * Execute run_loop
  */
@@ -198,7 +200,6 @@ static void btstack_run_loop_posix_execute(void) {
     fd_set descriptors_read;
     fd_set descriptors_write;
     
-    btstack_timer_source_t       *ts;
     btstack_linked_list_iterator_t it;
     struct timeval * timeout;
     struct timeval tv;
@@ -237,15 +238,10 @@ static void btstack_run_loop_posix_execute(void) {
         
         // get next timeout
         timeout = NULL;
-        if (timers) {
-            ts = (btstack_timer_source_t *) timers;
+        now_ms = btstack_run_loop_posix_get_time_ms();
+        int32_t delta = btstack_run_loop_base_get_time_until_timeout(now_ms);
+        if (delta >= 0) {
             timeout = &tv;
-            uint32_t list_timeout  = ts->timeout;
-            now_ms = btstack_run_loop_posix_get_time_ms();
-            int32_t delta = btstack_time_delta(list_timeout, now_ms);
-            if (delta < 0){
-                delta = 0;
-            }
             tv.tv_sec  = delta / 1000;
             tv.tv_usec = (int) (delta - (tv.tv_sec * 1000)) * 1000;
             log_debug("btstack_run_loop_execute next timeout in %u ms", delta);
@@ -262,31 +258,47 @@ static void btstack_run_loop_posix_execute(void) {
             log_debug("btstack_run_loop_posix_execute: check ds %p with fd %u\n", ds, ds->source.fd);
             if (FD_ISSET(ds->source.fd, &descriptors_read)) {
                 log_debug("btstack_run_loop_posix_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
-                ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+                btstack_run_loop_base_process_data_source(ds, DATA_SOURCE_CALLBACK_READ);
             }
             if (data_sources_modified) break;
             if (FD_ISSET(ds->source.fd, &descriptors_write)) {
                 log_debug("btstack_run_loop_posix_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
-                ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+                btstack_run_loop_base_process_data_source(ds, DATA_SOURCE_CALLBACK_WRITE);
             }
         }
         log_debug("btstack_run_loop_posix_execute: after ds check\n");
         
         // process timers
         now_ms = btstack_run_loop_posix_get_time_ms();
-        while (timers) {
-            ts = (btstack_timer_source_t *) timers;
-            int32_t delta = btstack_time_delta(ts->timeout, now_ms);
-            if (delta > 0) break;
-            log_debug("btstack_run_loop_posix_execute: process timer %p\n", ts);
-            
-            // remove timer before processing it to allow handler to re-register with run loop
-            btstack_run_loop_posix_remove_timer(ts);
-            ts->process(ts);
-        }
+        btstack_run_loop_base_process_timers(now_ms);
     }
 }
 
+static void btstack_run_loop_posix_process_callbacks(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    // drain pipe
+    uint8_t buffer[16];
+    while (read(ds->source.fd, buffer, sizeof(buffer)) > 0);
+    // execute callbacks, unlock during callback to allow it to register again
+    while (true){
+        pthread_mutex_lock(&btstack_run_loop_posix_callbacks_mutex);
+        btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+        pthread_mutex_unlock(&btstack_run_loop_posix_callbacks_mutex);
+        if (callback_registration == NULL) break;
+        btstack_run_loop_base_execute_callback(callback_registration);
+    }
+}
+
+static void btstack_run_loop_posix_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    pthread_mutex_lock(&btstack_run_loop_posix_callbacks_mutex);
+    btstack_run_loop_base_add_callback(callback_registration);
+    pthread_mutex_unlock(&btstack_run_loop_posix_callbacks_mutex);
+    // wake up main thread, pipe is full only if wakeup is already pending
+    const uint8_t wakeup = 0;
+    ssize_t res = write(btstack_run_loop_posix_pipe_fds[1], &wakeup, 1);
+    UNUSED(res);
+}
+
 // set timer
 static void btstack_run_loop_posix_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
     uint32_t time_ms = btstack_run_loop_posix_get_time_ms();
@@ -296,7 +308,7 @@ static void btstack_run_loop_posix_set_timer(btstack_timer_source_t *a, uint32_t
 
 static void btstack_run_loop_posix_init(void){
     data_sources = NULL;
-    timers = NULL;
+    btstack_run_loop_base_init();
 #ifdef _POSIX_MONOTONIC_CLOCK
     clock_gettime(CLOCK_MONOTONIC, &init_ts);
     init_ts.tv_nsec = 0;
@@ -305,6 +317,24 @@ static void btstack_run_loop_posix_init(void){
     gettimeofday(&init_tv, NULL);
     init_tv.tv_usec = 0;
 #endif
+
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+    btstack_run_loop_base_profiling_init(&btstack_run_loop_posix_get_time_us, 1000000);
+#endif
+
+    // create pipe once, it's used for the lifetime of the process
+    if (btstack_run_loop_posix_pipe_fds[0] < 0){
+        if (pipe(btstack_run_loop_posix_pipe_fds) != 0){
+            log_error("pipe() failed, execute on main thread not supported");
+            return;
+        }
+        fcntl(btstack_run_loop_posix_pipe_fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(btstack_run_loop_posix_pipe_fds[1], F_SETFL, O_NONBLOCK);
+    }
+    btstack_run_loop_posix_pipe_ds.source.fd = btstack_run_loop_posix_pipe_fds[0];
+    btstack_run_loop_posix_pipe_ds.process   = &btstack_run_loop_posix_process_callbacks;
+    btstack_run_loop_posix_pipe_ds.flags     = DATA_SOURCE_CALLBACK_READ;
+    btstack_run_loop_posix_add_data_source(&btstack_run_loop_posix_pipe_ds);
 }
 
 
@@ -320,6 +350,7 @@ static const btstack_run_loop_t btstack_run_loop_posix = {
     &btstack_run_loop_posix_execute,
     &btstack_run_loop_posix_dump_timer,
     &btstack_run_loop_posix_get_time_ms,
+    &btstack_run_loop_posix_execute_on_main_thread,
 };
 
 /**
@@ -56,6 +56,12 @@
 #define BTSTACK_TLV_HEADER_LEN 8
 static const char * btstack_tlv_header_magic = "BTstack";
 
+// Compaction: file is rewritten with current entries only if superseded entries use more space than
+// current entries and at least BTSTACK_TLV_POSIX_COMPACTION_THRESHOLD bytes
+#ifndef BTSTACK_TLV_POSIX_COMPACTION_THRESHOLD
+#define BTSTACK_TLV_POSIX_COMPACTION_THRESHOLD 4096
+#endif
+
 #define DUMMY_SIZE 4
 typedef struct tlv_entry {
 	void   * next;
@@ -64,9 +70,22 @@ typedef struct tlv_entry {
 	uint8_t  value[DUMMY_SIZE];	// dummy size
 } tlv_entry_t;
 
+static btstack_linked_list_t * btstack_tlv_posix_bucket_for_tag(btstack_tlv_posix_t * self, uint32_t tag){
+	uint32_t hash = tag ^ (tag >> 8) ^ (tag >> 16) ^ (tag >> 24);
+	return &self->entry_buckets[hash & (BTSTACK_TLV_POSIX_NUM_BUCKETS - 1)];
+}
+
+static void btstack_tlv_posix_write_header(FILE * file){
+	uint8_t header[BTSTACK_TLV_HEADER_LEN];
+	memset(header, 0, sizeof(header));
+	strcpy((char *)header, btstack_tlv_header_magic);
+	fwrite(header, 1, sizeof(header), file);
+}
+
 static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
 
 	if (!self->file) return 1;
+	self->file_size += 8 + data_size;
 
 	log_info("append tag %04x, len %u", tag, data_size);
 
@@ -85,7 +104,7 @@ static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag
 
 static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, uint32_t tag){
 	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
+	btstack_linked_list_iterator_init(&it, btstack_tlv_posix_bucket_for_tag(self, tag));
 	while (btstack_linked_list_iterator_has_next(&it)){
 		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
 		if (entry->tag != tag) continue;
@@ -94,22 +113,77 @@ static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, ui
 	return NULL;
 }
 
+static void btstack_tlv_posix_add_entry(btstack_tlv_posix_t * self, tlv_entry_t * entry){
+	btstack_linked_list_add(btstack_tlv_posix_bucket_for_tag(self, entry->tag), (btstack_linked_item_t *) entry);
+	self->live_size += 8 + entry->len;
+}
+
+static void btstack_tlv_posix_remove_entry(btstack_tlv_posix_t * self, tlv_entry_t * entry){
+	btstack_linked_list_remove(btstack_tlv_posix_bucket_for_tag(self, entry->tag), (btstack_linked_item_t *) entry);
+	self->live_size -= 8 + entry->len;
+	free(entry);
+}
+
+// write all current entries into temp file and replace db file
+static void btstack_tlv_posix_compact(btstack_tlv_posix_t * self){
+	log_info("compact db %s: file size %u, live size %u", self->db_path, self->file_size, self->live_size);
+	size_t path_len = strlen(self->db_path);
+	char * temp_path = (char *) malloc(path_len + 5);
+	if (!temp_path) return;
+	memcpy(temp_path, self->db_path, path_len);
+	memcpy(&temp_path[path_len], ".tmp", 5);
+
+	FILE * temp_file = fopen(temp_path, "w+");
+	if (!temp_file){
+		free(temp_path);
+		return;
+	}
+	btstack_tlv_posix_write_header(temp_file);
+	FILE * db_file = self->file;
+	self->file = temp_file;
+	self->file_size = BTSTACK_TLV_HEADER_LEN;
+	int i;
+	for (i=0;i<BTSTACK_TLV_POSIX_NUM_BUCKETS;i++){
+		btstack_linked_list_iterator_t it;
+		btstack_linked_list_iterator_init(&it, &self->entry_buckets[i]);
+		while (btstack_linked_list_iterator_has_next(&it)){
+			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
+			btstack_tlv_posix_append_tag(self, entry->tag, &entry->value[0], entry->len);
+		}
+	}
+
+	// atomically replace db file, continue with old file on error
+	if (rename(temp_path, self->db_path) == 0){
+		fclose(db_file);
+	} else {
+		log_error("rename %s failed", temp_path);
+		fclose(temp_file);
+		remove(temp_path);
+		self->file = db_file;
+		fseek(self->file, 0, SEEK_END);
+		self->file_size = (uint32_t) ftell(self->file);
+	}
+	free(temp_path);
+}
+
+static void btstack_tlv_posix_compact_if_needed(btstack_tlv_posix_t * self){
+	uint32_t wasted_size = self->file_size - BTSTACK_TLV_HEADER_LEN - self->live_size;
+	if (wasted_size < BTSTACK_TLV_POSIX_COMPACTION_THRESHOLD) return;
+	if (wasted_size < self->live_size) return;
+	btstack_tlv_posix_compact(self);
+}
+
 /**
  * Delete Tag
  * @param tag
  */
 static void btstack_tlv_posix_delete_tag(void * context, uint32_t tag){
 	btstack_tlv_posix_t * self = (btstack_tlv_posix_t *) context;
-	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
-	while (btstack_linked_list_iterator_has_next(&it)){
-		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		if (entry->tag != tag) continue;
-		btstack_linked_list_iterator_remove(&it);
-		free(entry);
-		btstack_tlv_posix_append_tag(self, tag, NULL, 0);
-		return;
-	}
+	tlv_entry_t * entry = btstack_tlv_posix_find_entry(self, tag);
+	if (!entry) return;
+	btstack_tlv_posix_remove_entry(self, entry);
+	btstack_tlv_posix_append_tag(self, tag, NULL, 0);
+	btstack_tlv_posix_compact_if_needed(self);
 }
 
 /**
@@ -144,8 +218,7 @@ static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8
 	// remove old entry
 	tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
 	if (old_entry){
-		btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-		free(old_entry);
+		btstack_tlv_posix_remove_entry(self, old_entry);
 	}
 
 	// create new entry
@@ -158,10 +231,11 @@ static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8
 	memcpy(&new_entry->value[0], data, data_size);
 
 	// append new entry
-	btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
+	btstack_tlv_posix_add_entry(self, new_entry);
 
 	// write new tag
 	btstack_tlv_posix_append_tag(self, tag, data, data_size);
+	btstack_tlv_posix_compact_if_needed(self);
 
 	return 0;
 }
@@ -172,6 +246,7 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
 	log_info("open db %s", self->db_path);
     self->file = fopen(self->db_path,"r+");
     uint8_t header[BTSTACK_TLV_HEADER_LEN];
+    self->file_size = BTSTACK_TLV_HEADER_LEN;
     if (self->file){
     	// checker header
 	    size_t objects_read = fread(header, 1, BTSTACK_TLV_HEADER_LEN, self->file );
@@ -195,6 +270,7 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
 
                     // arbitrary safety check: values < 1000 bytes each
                     if (len > 1000) break;
+                    self->file_size += 8 + len;
 
                     // create new entry for regular tag
                     tlv_entry_t * new_entry = NULL;
@@ -212,13 +288,12 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
                     // remove old entry
                     tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
                     if (old_entry){
-                        btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-                        free(old_entry);
+                        btstack_tlv_posix_remove_entry(self, old_entry);
                     }
 
                     // append new entry
                     if (new_entry){
-	                    btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
+                        btstack_tlv_posix_add_entry(self, new_entry);
                     }
 		    	}
 	    	}
@@ -232,16 +307,21 @@ static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
     if (!self->file){
     	// create truncate file
 	    self->file = fopen(self->db_path,"w+");
-	    memset(header, 0, sizeof(header));
-	    strcpy((char *)header, btstack_tlv_header_magic);
-	    fwrite(header, 1, sizeof(header), self->file);
+	    btstack_tlv_posix_write_header(self->file);
+	    self->file_size = BTSTACK_TLV_HEADER_LEN;
 	    // write out all valid entries (if any)
-		btstack_linked_list_iterator_t it;
-		btstack_linked_list_iterator_init(&it, &self->entry_list);
-		while (btstack_linked_list_iterator_has_next(&it)){
-			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-			btstack_tlv_posix_append_tag(self, entry->tag, &entry->value[0], entry->len);
-		}
+	    int i;
+	    for (i=0;i<BTSTACK_TLV_POSIX_NUM_BUCKETS;i++){
+			btstack_linked_list_iterator_t it;
+			btstack_linked_list_iterator_init(&it, &self->entry_buckets[i]);
+			while (btstack_linked_list_iterator_has_next(&it)){
+				tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
+				btstack_tlv_posix_append_tag(self, entry->tag, &entry->value[0], entry->len);
+			}
+	    }
+    } else {
+        // drop superseded entries on startup
+        btstack_tlv_posix_compact_if_needed(self);
     }
 	return 0;
 }
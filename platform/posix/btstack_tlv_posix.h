@@ -48,10 +48,16 @@
 extern "C" {
 #endif
 
+// number of hash buckets for tags, power of 2
+#define BTSTACK_TLV_POSIX_NUM_BUCKETS 16
+
 typedef struct {
-	btstack_linked_list_t entry_list;
+	btstack_linked_list_t entry_buckets[BTSTACK_TLV_POSIX_NUM_BUCKETS];
 	const char * db_path;
 	FILE * file;
+	// bytes in file and bytes used by current entries, used to trigger compaction
+	uint32_t file_size;
+	uint32_t live_size;
 } btstack_tlv_posix_t;
 
 /**
@@ -47,12 +47,14 @@
 #include "btstack_uart_block.h"
 #include "btstack_run_loop.h"
 #include "btstack_debug.h"
+#include "btstack_util.h"
 
 #include <termios.h>  /* POSIX terminal control definitions */
 #include <fcntl.h>    /* File control definitions */
 #include <unistd.h>   /* UNIX standard function definitions */
 #include <string.h>
 #include <errno.h>
+#include <sys/uio.h>
 #ifdef __APPLE__
 #include <sys/ioctl.h>
 #include <IOKit/serial/ioss.h>
@@ -68,13 +70,26 @@ static btstack_data_source_t transport_data_source;
 static int             write_bytes_len;
 static const uint8_t * write_bytes_data;
 
+#ifdef ENABLE_POSIX_UART_TX_BATCH
+#ifndef BTSTACK_UART_POSIX_TX_BUFFER_SIZE
+#define BTSTACK_UART_POSIX_TX_BUFFER_SIZE 4096
+#endif
+// blocks are copied into tx buffer and reported as sent before they are written, so that the upper layer
+// can queue more blocks that get written together. Blocks that don't fit are written from their own buffer
+static uint8_t  tx_buffer[BTSTACK_UART_POSIX_TX_BUFFER_SIZE];
+static uint16_t tx_buffer_len;
+static int      tx_block_sent_pending;
+#endif
+
 // block read
 static uint16_t  read_bytes_len;
 static uint8_t * read_bytes_data;
+static int       read_bytes_partial;
 
 // callbacks
 static void (*block_sent)(void);
 static void (*block_received)(void);
+static void (*bytes_received)(uint16_t num_bytes);
 
 
 static int btstack_uart_posix_init(const btstack_uart_config_t * config){
@@ -82,6 +97,99 @@ static int btstack_uart_posix_init(const btstack_uart_config_t * config){
     return 0;
 }
 
+#ifdef ENABLE_POSIX_UART_TX_BATCH
+static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
+
+    // report copied blocks as sent, upper layer might queue more
+    while (tx_block_sent_pending){
+        tx_block_sent_pending = 0;
+        if (block_sent){
+            block_sent();
+        }
+    }
+
+    if ((tx_buffer_len == 0) && (write_bytes_len == 0)){
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+
+    // write tx buffer followed by uncopied block
+    struct iovec iov[2];
+    int iovcnt = 0;
+    if (tx_buffer_len){
+        iov[iovcnt].iov_base = tx_buffer;
+        iov[iovcnt].iov_len  = tx_buffer_len;
+        iovcnt++;
+    }
+    if (write_bytes_len){
+        iov[iovcnt].iov_base = (void *) write_bytes_data;
+        iov[iovcnt].iov_len  = (size_t) write_bytes_len;
+        iovcnt++;
+    }
+
+    uint32_t start = btstack_run_loop_get_time_ms();
+    ssize_t bytes_written = writev(ds->source.fd, iov, iovcnt);
+    uint32_t end = btstack_run_loop_get_time_ms();
+    if (end - start > 10){
+        log_info("write took %u ms", end - start);
+    }
+    if (bytes_written == 0){
+        log_error("wrote zero bytes\n");
+        return;
+    }
+    if (bytes_written < 0) {
+        log_error("write returned error\n");
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+
+    // consume tx buffer first
+    uint16_t bytes_from_buffer = btstack_min((uint32_t) bytes_written, tx_buffer_len);
+    tx_buffer_len -= bytes_from_buffer;
+    if (tx_buffer_len){
+        memmove(tx_buffer, &tx_buffer[bytes_from_buffer], tx_buffer_len);
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+    bytes_written -= bytes_from_buffer;
+    if (write_bytes_len == 0) return;
+
+    write_bytes_data += bytes_written;
+    write_bytes_len  -= (int) bytes_written;
+    if (write_bytes_len){
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+
+    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+
+    // notify uncopied block done
+    if (block_sent){
+        block_sent();
+    }
+}
+
+// write all queued data, e.g. before baud rate change
+static void btstack_uart_posix_flush_tx(void){
+    int fd = transport_data_source.source.fd;
+    while (tx_buffer_len){
+        ssize_t bytes_written = write(fd, tx_buffer, tx_buffer_len);
+        if (bytes_written < 0){
+            if (errno != EAGAIN) {
+                log_error("flush: write returned error\n");
+                return;
+            }
+            usleep(1000);
+            continue;
+        }
+        tx_buffer_len -= (uint16_t) bytes_written;
+        memmove(tx_buffer, &tx_buffer[bytes_written], tx_buffer_len);
+    }
+    tcdrain(fd);
+}
+
+#else
+
 static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
     
     if (write_bytes_len == 0) return;
@@ -119,6 +227,7 @@ static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
         block_sent();
     }
 }
+#endif
 
 static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
 
@@ -145,6 +254,16 @@ static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
         return;
     }
 
+    if (read_bytes_partial){
+        // report what we got
+        read_bytes_len = 0;
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+        if (bytes_received){
+            bytes_received((uint16_t) bytes_read);
+        }
+        return;
+    }
+
     read_bytes_len   -= bytes_read;
     read_bytes_data  += bytes_read;
     if (read_bytes_len > 0) return;
@@ -176,6 +295,11 @@ static int btstack_uart_posix_set_baudrate(uint32_t baudrate){
 
     log_info("h4_set_baudrate %u", baudrate);
 
+#ifdef ENABLE_POSIX_UART_TX_BATCH
+    // blocks already reported as sent have to go out with the current baud rate
+    btstack_uart_posix_flush_tx();
+#endif
+
 #ifdef __APPLE__
 
     // From https://developer.apple.com/library/content/samplecode/SerialPortSample/Listings/SerialPortSample_SerialPortSample_c.html
@@ -382,6 +506,13 @@ static int btstack_uart_posix_close_new(void){
     // then close device 
     close(transport_data_source.source.fd);
     transport_data_source.source.fd = -1;
+
+#ifdef ENABLE_POSIX_UART_TX_BATCH
+    // drop queued data
+    tx_buffer_len = 0;
+    tx_block_sent_pending = 0;
+    write_bytes_len = 0;
+#endif
     return 0;
 }
 
@@ -393,7 +524,21 @@ static void btstack_uart_posix_set_block_sent( void (*block_handler)(void)){
     block_sent = block_handler;
 }
 
+static void btstack_uart_posix_set_bytes_received( void (*bytes_handler)(uint16_t num_bytes)){
+    bytes_received = bytes_handler;
+}
+
 static void btstack_uart_posix_send_block(const uint8_t *data, uint16_t size){
+#ifdef ENABLE_POSIX_UART_TX_BATCH
+    // copy block if it fits and no uncopied block is pending
+    if ((write_bytes_len == 0) && (size <= (sizeof(tx_buffer) - tx_buffer_len))){
+        memcpy(&tx_buffer[tx_buffer_len], data, size);
+        tx_buffer_len += size;
+        tx_block_sent_pending = 1;
+        btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+#endif
     // setup async write
     write_bytes_data = data;
     write_bytes_len  = size;
@@ -406,12 +551,20 @@ static void btstack_uart_posix_send_block(const uint8_t *data, uint16_t size){
 static void btstack_uart_posix_receive_block(uint8_t *buffer, uint16_t len){
     read_bytes_data = buffer;
     read_bytes_len = len;
+    read_bytes_partial = 0;
     btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
 
     // go
     // btstack_uart_posix_process_read(&transport_data_source);
 }
 
+static void btstack_uart_posix_receive_bytes(uint8_t *buffer, uint16_t max_len){
+    read_bytes_data = buffer;
+    read_bytes_len = max_len;
+    read_bytes_partial = 1;
+    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
+}
+
 // static void btstack_uart_posix_set_sleep(uint8_t sleep){
 // }
 // static void btstack_uart_posix_set_csr_irq_handler( void (*csr_irq_handler)(void)){
@@ -431,6 +584,8 @@ static const btstack_uart_block_t btstack_uart_posix = {
     /* int (*get_supported_sleep_modes); */                           NULL,
     /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
     /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*set_bytes_received)(void (*handler)(uint16_t)); */      &btstack_uart_posix_set_bytes_received,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */   &btstack_uart_posix_receive_bytes,
 };
 
 const btstack_uart_block_t * btstack_uart_block_posix_instance(void){
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_worker_posix.c"
+
+/*
+ *  btstack_worker_posix.c
+ *
+ *  Pool of pthreads that execute jobs in FIFO order
+ */
+
+#include "btstack_worker_posix.h"
+
+#include "btstack_config.h"
+#include "btstack_bool.h"
+#include "btstack_debug.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
+
+#include <pthread.h>
+
+#ifndef BTSTACK_WORKER_POSIX_NUM_THREADS
+#define BTSTACK_WORKER_POSIX_NUM_THREADS 2
+#endif
+
+static pthread_mutex_t       btstack_worker_posix_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t        btstack_worker_posix_cond  = PTHREAD_COND_INITIALIZER;
+static btstack_linked_list_t btstack_worker_posix_jobs;
+static bool                  btstack_worker_posix_started;
+
+static void * btstack_worker_posix_thread(void * arg){
+    UNUSED(arg);
+    while (true){
+        pthread_mutex_lock(&btstack_worker_posix_mutex);
+        while (btstack_linked_list_empty(&btstack_worker_posix_jobs)){
+            pthread_cond_wait(&btstack_worker_posix_cond, &btstack_worker_posix_mutex);
+        }
+        btstack_worker_job_t * job = (btstack_worker_job_t *) btstack_linked_list_pop(&btstack_worker_posix_jobs);
+        pthread_mutex_unlock(&btstack_worker_posix_mutex);
+
+        (*job->work)(job->context);
+        btstack_run_loop_execute_on_main_thread(&job->completion);
+    }
+    return NULL;
+}
+
+static void btstack_worker_posix_start(void){
+    btstack_worker_posix_started = true;
+    int i;
+    for (i=0;i<BTSTACK_WORKER_POSIX_NUM_THREADS;i++){
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, &btstack_worker_posix_thread, NULL) != 0){
+            log_error("failed to create worker thread %u", i);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
+
+static void btstack_worker_posix_submit(btstack_worker_job_t * job){
+    if (btstack_worker_posix_started == false){
+        btstack_worker_posix_start();
+    }
+    pthread_mutex_lock(&btstack_worker_posix_mutex);
+    btstack_linked_list_add_tail(&btstack_worker_posix_jobs, (btstack_linked_item_t *) job);
+    pthread_cond_signal(&btstack_worker_posix_cond);
+    pthread_mutex_unlock(&btstack_worker_posix_mutex);
+}
+
+static const btstack_worker_t btstack_worker_posix = {
+    &btstack_worker_posix_submit,
+};
+
+const btstack_worker_t * btstack_worker_posix_get_instance(void){
+    return &btstack_worker_posix;
+}
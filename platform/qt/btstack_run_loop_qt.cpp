@@ -220,7 +220,7 @@ static void btstack_run_loop_qt_set_timer(btstack_timer_source_t *a, uint32_t ti
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_qt_add_timer(btstack_timer_source_t *ts){
     uint32_t now = btstack_run_loop_qt_get_time_ms();
@@ -313,12 +313,7 @@ static void btstack_run_loop_qt_init(void){
 }
 
 static void btstack_run_loop_qt_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) btstack_run_loop_base_timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u (%p): timeout %u\n", i, ts, ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer();
 }
 
 static const btstack_run_loop_t btstack_run_loop_qt = {
@@ -333,6 +328,7 @@ static const btstack_run_loop_t btstack_run_loop_qt = {
     &btstack_run_loop_qt_execute,
     &btstack_run_loop_qt_dump_timer,
     &btstack_run_loop_qt_get_time_ms,
+    NULL,
 };
 
 /**
@@ -52,6 +52,7 @@
 #include "btstack_debug.h"
 #include "btstack_util.h"
 #include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
 
 #include <stddef.h> // NULL
  
@@ -64,9 +65,6 @@ static const btstack_run_loop_t btstack_run_loop_wiced;
 
 static wiced_queue_t btstack_run_loop_queue;
 
-// the run loop
-static btstack_linked_list_t timers;
-
 static uint32_t btstack_run_loop_wiced_get_time_ms(void){
     wiced_time_t time;
     wiced_time_get_time(&time);
@@ -79,40 +77,22 @@ static void btstack_run_loop_wiced_set_timer(btstack_timer_source_t *ts, uint32_
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_wiced_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
 }
 
 /**
  * Remove timer from run loop
  */
 static bool btstack_run_loop_wiced_remove_timer(btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(ts);
 }
 
 static void btstack_run_loop_wiced_dump_timer(void){
 #ifdef ENABLE_LOG_INFO 
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer();
 #endif
 }
 
@@ -131,8 +111,8 @@ static void btstack_run_loop_wiced_execute(void) {
     while (true) {
         // get next timeout
         uint32_t timeout_ms = WICED_NEVER_TIMEOUT;
-        if (timers) {
-            btstack_timer_source_t * ts = (btstack_timer_source_t *) timers;
+        if (btstack_run_loop_base_timers) {
+            btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
             uint32_t now = btstack_run_loop_wiced_get_time_ms();
             int32_t delta_ms = btstack_time_delta(ts->timeout, now);
             if (delta_ms <= 0){
@@ -155,7 +135,7 @@ static void btstack_run_loop_wiced_execute(void) {
 }
 
 static void btstack_run_loop_wiced_btstack_run_loop_init(void){
-    timers = NULL;
+    btstack_run_loop_base_init();
 
     // queue to receive events: up to 2 calls from transport, up to 3 for app
     wiced_rtos_init_queue(&btstack_run_loop_queue, "BTstack Run Loop", sizeof(function_call_t), 5);
@@ -180,4 +160,5 @@ static const btstack_run_loop_t btstack_run_loop_wiced = {
     &btstack_run_loop_wiced_execute,
     &btstack_run_loop_wiced_dump_timer,
     &btstack_run_loop_wiced_get_time_ms,
+    NULL,
 };
@@ -43,6 +43,7 @@
 
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_windows.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
 #include "btstack_util.h"
@@ -51,16 +52,88 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-
-static void btstack_run_loop_windows_dump_timer(void);
+#include <string.h>
 
 // the run loop
 static btstack_linked_list_t data_sources;
 static int data_sources_modified;
-static btstack_linked_list_t timers;
 // start time. 
 static ULARGE_INTEGER start_time;
 
+// I/O Completion Port for overlapped I/O, signalled data sources and callbacks
+static HANDLE btstack_run_loop_windows_iocp;
+
+// completion keys
+#define BTSTACK_RUN_LOOP_WINDOWS_KEY_OVERLAPPED 0
+#define BTSTACK_RUN_LOOP_WINDOWS_KEY_WAIT       1
+#define BTSTACK_RUN_LOOP_WINDOWS_KEY_CALLBACKS  2
+
+// max number of completions processed before timers are checked
+#ifndef BTSTACK_RUN_LOOP_WINDOWS_MAX_COMPLETIONS
+#define BTSTACK_RUN_LOOP_WINDOWS_MAX_COMPLETIONS 16
+#endif
+
+// callbacks to execute on main thread, wakeup via completion packet
+static CRITICAL_SECTION      btstack_run_loop_windows_callbacks_lock;
+static bool                  btstack_run_loop_windows_callbacks_lock_initialized;
+static bool                  btstack_run_loop_windows_callbacks_posted;
+// posted as overlapped, as completion packets without overlapped cannot be distinguished from a timeout
+static OVERLAPPED            btstack_run_loop_windows_callbacks_overlapped;
+
+// data sources with event handle are waited for by the thread pool, which posts a completion packet when the event
+// is signalled. Entries are kept for reuse, as a completion packet for an unregistered wait might still be queued
+typedef struct {
+    btstack_linked_item_t   item;
+    btstack_data_source_t * ds;
+    HANDLE                  wait_handle;
+    // incremented on unregister to detect stale completion packets
+    uint32_t                generation;
+} btstack_run_loop_windows_wait_t;
+
+static btstack_linked_list_t btstack_run_loop_windows_waits;
+
+static btstack_run_loop_windows_wait_t * btstack_run_loop_windows_get_wait(btstack_data_source_t * ds){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack_run_loop_windows_waits);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_run_loop_windows_wait_t * wait = (btstack_run_loop_windows_wait_t *) btstack_linked_list_iterator_next(&it);
+        if (wait->ds == ds) return wait;
+    }
+    return NULL;
+}
+
+static VOID CALLBACK btstack_run_loop_windows_wait_callback(PVOID context, BOOLEAN timer_or_wait_fired){
+    UNUSED(timer_or_wait_fired);
+    btstack_run_loop_windows_wait_t * wait = (btstack_run_loop_windows_wait_t *) context;
+    PostQueuedCompletionStatus(btstack_run_loop_windows_iocp, wait->generation, BTSTACK_RUN_LOOP_WINDOWS_KEY_WAIT, (LPOVERLAPPED) wait);
+}
+
+static void btstack_run_loop_windows_wait_unregister(btstack_run_loop_windows_wait_t * wait){
+    if (wait->wait_handle == NULL) return;
+    // blocks until a running callback has completed
+    UnregisterWaitEx(wait->wait_handle, INVALID_HANDLE_VALUE);
+    wait->wait_handle = NULL;
+    wait->generation++;
+}
+
+// register wait if data source is enabled, unregister otherwise
+static void btstack_run_loop_windows_wait_update(btstack_data_source_t * ds){
+    btstack_run_loop_windows_wait_t * wait = btstack_run_loop_windows_get_wait(ds);
+    if (wait == NULL) return;
+    bool enabled = (ds->source.handle != NULL) && ((ds->flags & (DATA_SOURCE_CALLBACK_READ | DATA_SOURCE_CALLBACK_WRITE)) != 0);
+    if (enabled == false){
+        btstack_run_loop_windows_wait_unregister(wait);
+        return;
+    }
+    if (wait->wait_handle != NULL) return;
+    BOOL ok = RegisterWaitForSingleObject(&wait->wait_handle, ds->source.handle, &btstack_run_loop_windows_wait_callback,
+                                          wait, INFINITE, WT_EXECUTEINWAITTHREAD | WT_EXECUTEONLYONCE);
+    if (!ok){
+        log_error("RegisterWaitForSingleObject failed, error %lu", GetLastError());
+        wait->wait_handle = NULL;
+    }
+}
+
 /**
  * Add data_source to run_loop
  */
@@ -68,6 +141,20 @@ static void btstack_run_loop_windows_add_data_source(btstack_data_source_t *ds){
     data_sources_modified = 1;
     // log_info("btstack_run_loop_windows_add_data_source %x with fd %u\n", (int) ds, ds->fd);
     btstack_linked_list_add(&data_sources, (btstack_linked_item_t *) ds);
+
+    // get unused wait entry
+    btstack_run_loop_windows_wait_t * wait = btstack_run_loop_windows_get_wait(NULL);
+    if (wait == NULL){
+        wait = (btstack_run_loop_windows_wait_t *) malloc(sizeof(btstack_run_loop_windows_wait_t));
+        if (wait == NULL){
+            log_error("btstack_run_loop_windows_add_data_source: out of memory");
+            return;
+        }
+        memset(wait, 0, sizeof(btstack_run_loop_windows_wait_t));
+        btstack_linked_list_add(&btstack_run_loop_windows_waits, (btstack_linked_item_t *) wait);
+    }
+    wait->ds = ds;
+    btstack_run_loop_windows_wait_update(ds);
 }
 
 /**
@@ -76,55 +163,41 @@ static void btstack_run_loop_windows_add_data_source(btstack_data_source_t *ds){
 static bool btstack_run_loop_windows_remove_data_source(btstack_data_source_t *ds){
     data_sources_modified = 1;
     // log_info("btstack_run_loop_windows_remove_data_source %x\n", (int) ds);
+    btstack_run_loop_windows_wait_t * wait = btstack_run_loop_windows_get_wait(ds);
+    if (wait != NULL){
+        btstack_run_loop_windows_wait_unregister(wait);
+        wait->ds = NULL;
+    }
     return btstack_linked_list_remove(&data_sources, (btstack_linked_item_t *) ds);
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_windows_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if list timeout is after new timeout
-        uint32_t list_timeout = ((btstack_timer_source_t *) it->next)->timeout;
-        int32_t delta = btstack_time_delta(ts->timeout, list_timeout);
-        if (delta < 0) break;
-    }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
     log_debug("Added timer %p at %u\n", ts, ts->timeout);
-    // btstack_run_loop_windows_dump_timer();
 }
 
 /**
  * Remove timer from run loop
  */
 static bool btstack_run_loop_windows_remove_timer(btstack_timer_source_t *ts){
-    // log_info("Removed timer %x at %u\n", (int) ts, (unsigned int) ts->timeout.tv_sec);
-    // btstack_run_loop_windows_dump_timer();
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(ts);
 }
 
 static void btstack_run_loop_windows_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, ts->timeout);
-    }
+    btstack_run_loop_base_dump_timer();
 }
 
 static void btstack_run_loop_windows_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
     ds->flags |= callback_types;
+    btstack_run_loop_windows_wait_update(ds);
 }
 
 static void btstack_run_loop_windows_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
     ds->flags &= ~callback_types;
+    btstack_run_loop_windows_wait_update(ds);
 }
 
 /**
@@ -144,86 +217,123 @@ static uint32_t btstack_run_loop_windows_get_time_ms(void){
     return time_ms;
 }
 
+static void btstack_run_loop_windows_process_wait(btstack_run_loop_windows_wait_t * wait, uint32_t generation){
+    btstack_data_source_t * ds = wait->ds;
+    // ignore completion for removed data source or unregistered wait
+    if (ds == NULL) return;
+    if (wait->generation != generation) return;
+
+    // wait was registered for a single callback
+    btstack_run_loop_windows_wait_unregister(wait);
+
+    if (ds->flags & DATA_SOURCE_CALLBACK_READ){
+        log_debug("btstack_run_loop_windows_execute: process read ds %p with handle %p\n", ds, ds->source.handle);
+        ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+    } else if (ds->flags & DATA_SOURCE_CALLBACK_WRITE){
+        log_debug("btstack_run_loop_windows_execute: process write ds %p with handle %p\n", ds, ds->source.handle);
+        ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+    }
+
+    // wait for event again, if data source is still registered and enabled
+    btstack_run_loop_windows_wait_update(ds);
+}
+
+static void btstack_run_loop_windows_process_callbacks(void){
+    // execute callbacks, unlock during callback to allow it to register again
+    EnterCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+    btstack_run_loop_windows_callbacks_posted = false;
+    LeaveCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+    while (true){
+        EnterCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+        btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+        LeaveCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+        if (callback_registration == NULL) break;
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_windows_process_completion(ULONG_PTR key, LPOVERLAPPED overlapped, DWORD bytes_transferred, DWORD error){
+    btstack_run_loop_windows_overlapped_t * request;
+    switch (key){
+        case BTSTACK_RUN_LOOP_WINDOWS_KEY_OVERLAPPED:
+            request = (btstack_run_loop_windows_overlapped_t *) overlapped;
+            (*request->process)(request, bytes_transferred, error);
+            break;
+        case BTSTACK_RUN_LOOP_WINDOWS_KEY_WAIT:
+            btstack_run_loop_windows_process_wait((btstack_run_loop_windows_wait_t *) overlapped, bytes_transferred);
+            break;
+        case BTSTACK_RUN_LOOP_WINDOWS_KEY_CALLBACKS:
+            btstack_run_loop_windows_process_callbacks();
+            break;
+        default:
+            break;
+    }
+}
+
 /**
  * Execute run_loop
  */
 static void btstack_run_loop_windows_execute(void) {
 
-    btstack_timer_source_t *ts;
-    btstack_linked_list_iterator_t it;
-
     while (true) {
 
-        // collect handles to wait for
-        HANDLE handles[100];
-        memset(handles, 0, sizeof(handles));
-        int num_handles = 0;     
-        btstack_linked_list_iterator_init(&it, &data_sources);
-        while (btstack_linked_list_iterator_has_next(&it)){
-            btstack_data_source_t *ds = (btstack_data_source_t*) btstack_linked_list_iterator_next(&it);
-            if (ds->source.handle == 0) continue;
-            if (ds->flags & (DATA_SOURCE_CALLBACK_READ | DATA_SOURCE_CALLBACK_WRITE)){
-                handles[num_handles++] = ds->source.handle;
-                log_debug("btstack_run_loop_execute adding handle %p", ds->source.handle);
-            }
-        }
-
         // get next timeout
-        int32_t timeout_ms = INFINITE;
-        if (timers) {
-            ts = (btstack_timer_source_t *) timers;
-            uint32_t now_ms = btstack_run_loop_windows_get_time_ms();
-            timeout_ms = btstack_time_delta(ts->timeout, now_ms);
-            if (timeout_ms < 0){
-                timeout_ms = 0;
-            }
+        int32_t timeout_ms = btstack_run_loop_base_get_time_until_timeout(btstack_run_loop_windows_get_time_ms());
+        DWORD timeout = INFINITE;
+        if (timeout_ms >= 0){
             log_debug("btstack_run_loop_execute next timeout in %u ms", timeout_ms);
+            timeout = (DWORD) timeout_ms;
         }
-        
-        int res;
-        if (num_handles){
-            // wait for ready Events or timeout
-            res = WaitForMultipleObjects(num_handles, &handles[0], 0, timeout_ms);
-        } else {
-            // just wait for timeout
-            Sleep(timeout_ms);
-            res = WAIT_TIMEOUT;
-        }
-        
-        // process data source
-        if (WAIT_OBJECT_0 <= res && res < (WAIT_OBJECT_0 + num_handles)){
-            void * triggered_handle = handles[res - WAIT_OBJECT_0];
-            btstack_linked_list_iterator_init(&it, &data_sources);
-            while (btstack_linked_list_iterator_has_next(&it)){
-                btstack_data_source_t *ds = (btstack_data_source_t*) btstack_linked_list_iterator_next(&it);
-                log_debug("btstack_run_loop_windows_execute: check ds %p with handle %p\n", ds, ds->source.handle);
-                if (triggered_handle == ds->source.handle){
-                    if (ds->flags & DATA_SOURCE_CALLBACK_READ){
-                        log_debug("btstack_run_loop_windows_execute: process read ds %p with handle %p\n", ds, ds->source.handle);
-                        ds->process(ds, DATA_SOURCE_CALLBACK_READ);
-                    } else if (ds->flags & DATA_SOURCE_CALLBACK_WRITE){
-                        log_debug("btstack_run_loop_windows_execute: process write ds %p with handle %p\n", ds, ds->source.handle);
-                        ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
-                    }
-                    break;
-                }
-            }
+
+        // wait for first completion or timeout, then process already queued completions
+        int num_completions;
+        for (num_completions = 0; num_completions < BTSTACK_RUN_LOOP_WINDOWS_MAX_COMPLETIONS; num_completions++){
+            DWORD        bytes_transferred = 0;
+            ULONG_PTR    key = 0;
+            LPOVERLAPPED overlapped = NULL;
+            BOOL ok = GetQueuedCompletionStatus(btstack_run_loop_windows_iocp, &bytes_transferred, &key, &overlapped,
+                                                (num_completions == 0) ? timeout : 0);
+            // timeout or error of completion port itself
+            if (overlapped == NULL) break;
+            // overlapped operation failed otherwise
+            DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+            btstack_run_loop_windows_process_completion(key, overlapped, bytes_transferred, error);
         }
 
         // process timers
-        uint32_t now_ms = btstack_run_loop_windows_get_time_ms();
-        while (timers) {
-            ts = (btstack_timer_source_t *) timers;
-            if (ts->timeout > now_ms) break;
-            log_debug("btstack_run_loop_windows_execute: process timer %p\n", ts);
-            
-            // remove timer before processing it to allow handler to re-register with run loop
-            btstack_run_loop_windows_remove_timer(ts);
-            ts->process(ts);
-        }
+        btstack_run_loop_base_process_timers(btstack_run_loop_windows_get_time_ms());
     }
 }
 
+static void btstack_run_loop_windows_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    EnterCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+    btstack_run_loop_base_add_callback(callback_registration);
+    bool post = btstack_run_loop_windows_callbacks_posted == false;
+    btstack_run_loop_windows_callbacks_posted = true;
+    LeaveCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+    // wake up main thread
+    if (post){
+        PostQueuedCompletionStatus(btstack_run_loop_windows_iocp, 0, BTSTACK_RUN_LOOP_WINDOWS_KEY_CALLBACKS,
+                                   &btstack_run_loop_windows_callbacks_overlapped);
+    }
+}
+
+bool btstack_run_loop_windows_add_file_handle(HANDLE handle){
+    HANDLE port = CreateIoCompletionPort(handle, btstack_run_loop_windows_iocp, BTSTACK_RUN_LOOP_WINDOWS_KEY_OVERLAPPED, 0);
+    if (port == NULL){
+        log_error("btstack_run_loop_windows_add_file_handle: CreateIoCompletionPort failed, error %lu", GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void btstack_run_loop_windows_overlapped_init(btstack_run_loop_windows_overlapped_t * request,
+    void (*process)(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error), void * context){
+    memset(&request->overlapped, 0, sizeof(OVERLAPPED));
+    request->process = process;
+    request->context = context;
+}
+
 // set timer
 static void btstack_run_loop_windows_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
     uint32_t time_ms = btstack_run_loop_windows_get_time_ms();
@@ -233,7 +343,7 @@ static void btstack_run_loop_windows_set_timer(btstack_timer_source_t *a, uint32
 
 static void btstack_run_loop_windows_init(void){
     data_sources = NULL;
-    timers = NULL;
+    btstack_run_loop_base_init();
 
     // store start time
     FILETIME    file_time;
@@ -243,6 +353,28 @@ static void btstack_run_loop_windows_init(void){
     start_time.LowPart =  file_time.dwLowDateTime;
     start_time.HighPart = file_time.dwHighDateTime;
 
+    // create lock and completion port once, they're used for the lifetime of the process
+    if (btstack_run_loop_windows_callbacks_lock_initialized == false){
+        InitializeCriticalSection(&btstack_run_loop_windows_callbacks_lock);
+        btstack_run_loop_windows_callbacks_lock_initialized = true;
+    }
+    if (btstack_run_loop_windows_iocp == NULL){
+        btstack_run_loop_windows_iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+        if (btstack_run_loop_windows_iocp == NULL){
+            log_error("btstack_run_loop_windows_init: CreateIoCompletionPort failed, error %lu", GetLastError());
+        }
+    }
+    btstack_run_loop_windows_callbacks_posted = false;
+
+    // release waits of previous data sources
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack_run_loop_windows_waits);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_run_loop_windows_wait_t * wait = (btstack_run_loop_windows_wait_t *) btstack_linked_list_iterator_next(&it);
+        btstack_run_loop_windows_wait_unregister(wait);
+        wait->ds = NULL;
+    }
+
     log_debug("btstack_run_loop_windows_init");
 }
 
@@ -259,6 +391,7 @@ static const btstack_run_loop_t btstack_run_loop_windows = {
     &btstack_run_loop_windows_execute,
     &btstack_run_loop_windows_dump_timer,
     &btstack_run_loop_windows_get_time_ms,
+    &btstack_run_loop_windows_execute_on_main_thread,
 };
 
 /**
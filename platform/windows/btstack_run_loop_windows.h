@@ -45,15 +45,46 @@
 
 #include "btstack_run_loop.h"
 
+#include <Windows.h>
+
 #if defined __cplusplus
 extern "C" {
 #endif
-	
+
+/**
+ * Overlapped I/O request completed via the I/O Completion Port of the run loop
+ */
+typedef struct btstack_run_loop_windows_overlapped {
+    // has to be first
+    OVERLAPPED overlapped;
+    // called on run loop thread, error is ERROR_SUCCESS if the operation succeeded
+    void (*process)(struct btstack_run_loop_windows_overlapped * request, DWORD bytes_transferred, DWORD error);
+    void * context;
+} btstack_run_loop_windows_overlapped_t;
+
 /**
  * Provide btstack_run_loop_windows instance
  */
 const btstack_run_loop_t * btstack_run_loop_windows_get_instance(void);
 
+/**
+ * @brief Associate handle opened with FILE_FLAG_OVERLAPPED with the I/O Completion Port of the run loop.
+ * Overlapped operations on it have to use a btstack_run_loop_windows_overlapped_t without event,
+ * their completions are processed in order on the run loop thread
+ * @param handle
+ * @return true if successful
+ */
+bool btstack_run_loop_windows_add_file_handle(HANDLE handle);
+
+/**
+ * @brief Init overlapped request before starting an overlapped operation
+ * @param request
+ * @param process handler called with result
+ * @param context
+ */
+void btstack_run_loop_windows_overlapped_init(btstack_run_loop_windows_overlapped_t * request,
+    void (*process)(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error), void * context);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -61,6 +61,7 @@
 #include "btstack_config.h"
 
 #include "btstack_debug.h"
+#include "btstack_run_loop_windows.h"
 #include "hci.h"
 #include "hci_transport.h"
 
@@ -151,6 +152,30 @@ static BTstack_WinUsb_UnregisterIsochBuffer_t 	BTstack_WinUsb_UnregisterIsochBuf
 static BTstack_WinUsb_GetCurrentFrameNumber_t   BTstack_WinUsb_GetCurrentFrameNumber;
 #endif
 
+// number of queued IN transfers
+#ifndef HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT  4
+#endif
+#ifndef HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT    8
+#endif
+
+// number of ACL and ISO OUT transfers in flight, outgoing packets are copied if > 1
+#ifndef HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT   4
+#endif
+
+// number of queued isochronous transfers for SCO
+#ifndef HCI_TRANSPORT_USB_ISOC_IN_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_ISOC_IN_TRANSFER_COUNT   8
+#endif
+#ifndef HCI_TRANSPORT_USB_ISOC_OUT_TRANSFER_COUNT
+#define HCI_TRANSPORT_USB_ISOC_OUT_TRANSFER_COUNT  20
+#endif
+
+#define EVENT_IN_BUFFER_SIZE  (2 + 255)
+#define ACL_IN_BUFFER_SIZE    (HCI_INCOMING_PRE_BUFFER_SIZE + HCI_ACL_BUFFER_SIZE)
+
 // Doesn't work as expected
 // #define SCHEDULE_SCO_IN_TRANSFERS_MANUALLY
 
@@ -191,11 +216,11 @@ const uint16_t iso_packet_size_for_alt_setting[] = {
 // note: alt setting 6 has max packet size of 63 every 7.5 ms = 472.5 bytes / HCI packet, while max SCO packet has 255 byte payload
 #define SCO_PACKET_SIZE  (49 * NUM_ISO_PACKETS)
 
-#define ISOC_BUFFERS   8
+#define ISOC_BUFFERS   HCI_TRANSPORT_USB_ISOC_IN_TRANSFER_COUNT
 
 // Outgoing SCO packet queue
 // simplified ring buffer implementation
-#define SCO_RING_BUFFER_COUNT  (20)
+#define SCO_RING_BUFFER_COUNT  HCI_TRANSPORT_USB_ISOC_OUT_TRANSFER_COUNT
 #define SCO_RING_BUFFER_SIZE (SCO_RING_BUFFER_COUNT * SCO_PACKET_SIZE)
 
 /** Request type bits of the "bmRequestType" field in control transfers. */
@@ -232,22 +257,27 @@ static int sco_out_addr;
 static HANDLE usb_device_handle;
 static WINUSB_INTERFACE_HANDLE usb_interface_0_handle;
 static WINUSB_INTERFACE_HANDLE usb_interface_1_handle;
-static OVERLAPPED usb_overlapped_event_in;
-static OVERLAPPED usb_overlapped_command_out;
-static OVERLAPPED usb_overlapped_acl_in;
-static OVERLAPPED usb_overlapped_acl_out;
-static btstack_data_source_t usb_data_source_event_in;
-static btstack_data_source_t usb_data_source_command_out;
-static btstack_data_source_t usb_data_source_acl_in;
-static btstack_data_source_t usb_data_source_acl_out;
+
+// overlapped transfers, completed via I/O Completion Port of run loop
+static btstack_run_loop_windows_overlapped_t usb_request_event_in[HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT];
+static btstack_run_loop_windows_overlapped_t usb_request_acl_in[HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT];
+static btstack_run_loop_windows_overlapped_t usb_request_command_out;
+static btstack_run_loop_windows_overlapped_t usb_request_acl_out[HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT];
 
 //
 static int usb_command_out_active;
-static int usb_acl_out_active;
+static int usb_acl_out_active;   // number of ACL OUT transfers in flight
+static int usb_acl_out_in_flight[HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT];
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+static uint8_t usb_acl_out_buffer[HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT][HCI_OUTGOING_PACKET_BUFFER_SIZE];
+static btstack_timer_source_t usb_acl_out_packet_sent_timer;
+static int usb_acl_out_packet_sent_timer_active;
+static int usb_acl_out_packet_sent_pending;
+#endif
 
-// buffer for HCI Events and ACL Packets
-static uint8_t hci_event_in_buffer[2 + 255];
-static uint8_t hci_acl_in_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_ACL_BUFFER_SIZE]; 
+// buffers for HCI Events and ACL Packets
+static uint8_t hci_event_in_buffer[HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT][EVENT_IN_BUFFER_SIZE];
+static uint8_t hci_acl_in_buffer[HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT][ACL_IN_BUFFER_SIZE];
 
 // transport interface state
 static int usb_transport_open;
@@ -263,11 +293,7 @@ typedef enum {
 static uint8_t hci_sco_in_buffer[ISOC_BUFFERS * SCO_PACKET_SIZE]; 
 static BTSTACK_WINUSB_ISOCH_BUFFER_HANDLE hci_sco_in_buffer_handle;
 static USBD_ISO_PACKET_DESCRIPTOR hci_sco_packet_descriptors[ISOC_BUFFERS * NUM_ISO_PACKETS];
-static OVERLAPPED usb_overlapped_sco_in[ISOC_BUFFERS];
-static int usb_sco_in_expected_transfer;
-
-// SCO Incoming Run Loop
-static btstack_data_source_t usb_data_source_sco_in[ISOC_BUFFERS];
+static btstack_run_loop_windows_overlapped_t usb_request_sco_in[ISOC_BUFFERS];
 
 // SCO Incoming HCI
 static H2_SCO_STATE sco_state;
@@ -277,18 +303,14 @@ static uint16_t sco_bytes_to_read;
 
 // SCO Outgoing Windows
 static BTSTACK_WINUSB_ISOCH_BUFFER_HANDLE hci_sco_out_buffer_handle;
-static OVERLAPPED usb_overlapped_sco_out[SCO_RING_BUFFER_COUNT];
+static btstack_run_loop_windows_overlapped_t usb_request_sco_out[SCO_RING_BUFFER_COUNT];
 static int        sco_ring_transfers_active;
-static int        usb_sco_out_expected_transfer;
 
 #ifdef SCHEDULE_SCO_IN_TRANSFERS_MANUALLY
 // next tranfer
 static ULONG sco_next_transfer_at_frame;
 #endif
 
-// SCO Outgoing Run Loop
-static btstack_data_source_t usb_data_source_sco_out[SCO_RING_BUFFER_COUNT];
-
 // SCO Outgoing HCI
 static uint8_t  sco_ring_buffer[SCO_RING_BUFFER_SIZE];
 static int      sco_ring_write;  // packet idx
@@ -400,30 +422,39 @@ static void usb_free_resources(void){
 #endif
 }
 
-static void usb_submit_event_in_transfer(void){
+static void usb_process_event_in(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error);
+static void usb_process_acl_in(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error);
+static void usb_process_command_out(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error);
+static void usb_process_acl_out(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error);
+#ifdef ENABLE_SCO_OVER_HCI
+static void usb_process_sco_in(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error);
+static void usb_process_sco_out(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error);
+#endif
+
+static void usb_submit_event_in_transfer(int i){
 	// submit transfer
-	BOOL result = WinUsb_ReadPipe(usb_interface_0_handle, event_in_addr, hci_event_in_buffer, sizeof(hci_event_in_buffer), NULL, &usb_overlapped_event_in);
+    btstack_run_loop_windows_overlapped_init(&usb_request_event_in[i], &usb_process_event_in, NULL);
+	BOOL result = WinUsb_ReadPipe(usb_interface_0_handle, event_in_addr, hci_event_in_buffer[i], EVENT_IN_BUFFER_SIZE, NULL, &usb_request_event_in[i].overlapped);
 	if (!result) {
 		if (GetLastError() != ERROR_IO_PENDING) goto exit_on_error;
 	}
 
-    // IO_PENDING -> wait for completed
-    btstack_run_loop_enable_data_source_callbacks(&usb_data_source_event_in, DATA_SOURCE_CALLBACK_READ);
+    // IO_PENDING -> completion is processed by run loop
     return;
 
 exit_on_error:
 	log_error("usb_submit_event_in_transfer: winusb last error %lu", GetLastError());
 }
 
-static void usb_submit_acl_in_transfer(void){
+static void usb_submit_acl_in_transfer(int i){
 	// submit transfer
-	BOOL result = WinUsb_ReadPipe(usb_interface_0_handle, acl_in_addr, hci_acl_in_buffer, sizeof(hci_acl_in_buffer), NULL, &usb_overlapped_acl_in);
+    btstack_run_loop_windows_overlapped_init(&usb_request_acl_in[i], &usb_process_acl_in, NULL);
+	BOOL result = WinUsb_ReadPipe(usb_interface_0_handle, acl_in_addr, &hci_acl_in_buffer[i][HCI_INCOMING_PRE_BUFFER_SIZE], HCI_ACL_BUFFER_SIZE, NULL, &usb_request_acl_in[i].overlapped);
 	if (!result) {
 		if (GetLastError() != ERROR_IO_PENDING) goto exit_on_error;
 	}
 
-    // IO_PENDING -> wait for completed
-    btstack_run_loop_enable_data_source_callbacks(&usb_data_source_acl_in, DATA_SOURCE_CALLBACK_READ);
+    // IO_PENDING -> completion is processed by run loop
     return;
 
 exit_on_error:
@@ -447,8 +478,9 @@ static void usb_submit_sco_in_transfer_at_frame(int i, ULONG * frame_number){
 
     ULONG frame_before = *frame_number;
 
+    btstack_run_loop_windows_overlapped_init(&usb_request_sco_in[i], &usb_process_sco_in, NULL);
     BOOL result = BTstack_WinUsb_ReadIsochPipe(hci_sco_in_buffer_handle, i * SCO_PACKET_SIZE, iso_packet_size * NUM_ISO_PACKETS,  
-        frame_number, NUM_ISO_PACKETS, &hci_sco_packet_descriptors[i * NUM_ISO_PACKETS], &usb_overlapped_sco_in[i]);
+        frame_number, NUM_ISO_PACKETS, &hci_sco_packet_descriptors[i * NUM_ISO_PACKETS], &usb_request_sco_in[i].overlapped);
 
     // log_info("BTstack_WinUsb_ReadIsochPipe #%02u: current %lu, planned %lu - buffer %lu", i, current_frame_number, frame_before, frame_before - current_frame_number);
 
@@ -480,8 +512,9 @@ static void usb_submit_sco_in_transfer_asap(int i, int continue_stream){
 
     // log_info("usb_submit_sco_in_transfer[%02u]: current frame %lu", i, current_frame_number);
 
+    btstack_run_loop_windows_overlapped_init(&usb_request_sco_in[i], &usb_process_sco_in, NULL);
     BOOL result = BTstack_WinUsb_ReadIsochPipeAsap(hci_sco_in_buffer_handle, i * SCO_PACKET_SIZE, iso_packet_size * NUM_ISO_PACKETS,  
-        continue_stream, NUM_ISO_PACKETS, &hci_sco_packet_descriptors[i * NUM_ISO_PACKETS], &usb_overlapped_sco_in[i]);
+        continue_stream, NUM_ISO_PACKETS, &hci_sco_packet_descriptors[i * NUM_ISO_PACKETS], &usb_request_sco_in[i].overlapped);
 
     if (!result) {
         if (GetLastError() != ERROR_IO_PENDING) goto exit_on_error;
@@ -495,62 +528,58 @@ exit_on_error:
 #endif
 #endif
 
-static void usb_process_event_in(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
+static void usb_process_event_in(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error) {
 
-    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+    if (!usb_transport_open) return;
 
-    DWORD bytes_read;
-    BOOL ok = WinUsb_GetOverlappedResult(usb_interface_0_handle, &usb_overlapped_event_in, &bytes_read, FALSE);
-    if(!ok){
-        DWORD err = GetLastError();
-        if (err == ERROR_IO_INCOMPLETE){
-            // IO_INCOMPLETE -> wait for completed
-            btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
-        } else {
-            log_error("usb_process_event_in: error reading");
+    int i = (int) (request - usb_request_event_in);
+    if (error != ERROR_SUCCESS){
+        if (error != ERROR_OPERATION_ABORTED){
+            log_error("usb_process_event_in: error reading %lu", error);
         }
         return;
     }
 
     // notify uppper
-    packet_handler(HCI_EVENT_PACKET, hci_event_in_buffer, bytes_read);
+    packet_handler(HCI_EVENT_PACKET, hci_event_in_buffer[i], bytes_transferred);
+
+    // transport might have been closed by packet handler
+    if (!usb_transport_open) return;
 
 	// re-submit transfer
-	usb_submit_event_in_transfer();
+	usb_submit_event_in_transfer(i);
 }
 
-static void usb_process_acl_in(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
+static void usb_process_acl_in(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error) {
 
-    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+    if (!usb_transport_open) return;
 
-    DWORD bytes_read;
-    BOOL ok = WinUsb_GetOverlappedResult(usb_interface_0_handle, &usb_overlapped_acl_in, &bytes_read, FALSE);
-    if(!ok){
-        DWORD err = GetLastError();
-        if (err == ERROR_IO_INCOMPLETE){
-            // IO_INCOMPLETE -> wait for completed
-            btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
-        } else {
-            log_error("usb_process_acl_in: error reading");
+    int i = (int) (request - usb_request_acl_in);
+    if (error != ERROR_SUCCESS){
+        if (error == ERROR_OPERATION_ABORTED) return;
 
-            // Reset Pipe
-            err = WinUsb_ResetPipe(usb_interface_0_handle, acl_in_addr);
-            log_info("WinUsb_ResetPipe: result %u", (int) err);
-            if (err){
-                log_info("WinUsb_ResetPipe error %u", (int) GetLastError());
-            }
-            
-            // re-submit transfer
-            usb_submit_acl_in_transfer();
+        log_error("usb_process_acl_in: error reading %lu", error);
+
+        // Reset Pipe
+        BOOL ok = WinUsb_ResetPipe(usb_interface_0_handle, acl_in_addr);
+        log_info("WinUsb_ResetPipe: result %u", (int) ok);
+        if (!ok){
+            log_info("WinUsb_ResetPipe error %u", (int) GetLastError());
         }
+
+        // re-submit transfer
+        usb_submit_acl_in_transfer(i);
         return;
     }
 
     // notify uppper
-    packet_handler(HCI_ACL_DATA_PACKET, hci_acl_in_buffer, bytes_read);
+    packet_handler(HCI_ACL_DATA_PACKET, &hci_acl_in_buffer[i][HCI_INCOMING_PRE_BUFFER_SIZE], bytes_transferred);
+
+    // transport might have been closed by packet handler
+    if (!usb_transport_open) return;
 
 	// re-submit transfer
-	usb_submit_acl_in_transfer();
+	usb_submit_acl_in_transfer(i);
 }
 
 #ifdef ENABLE_SCO_OVER_HCI
@@ -595,52 +624,23 @@ static void sco_handle_data(uint8_t * buffer, uint16_t size){
     }
 }
 
-static void usb_process_sco_out(btstack_data_source_t *ds,  btstack_data_source_callback_type_t callback_type){
-
-    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+static void usb_process_sco_out(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error){
 
     if (sco_shutdown){
         log_info("USB SCO Shutdown:: usb_process_sco_out called");
         return;
     }
 
-    // get current frame number
-    ULONG current_frame_number;
-    LARGE_INTEGER timestamp;
-    BTstack_WinUsb_GetCurrentFrameNumber(usb_interface_0_handle, &current_frame_number, &timestamp);
+    int transfer_index = (int) (request - usb_request_sco_out);
 
-    // find index
-    int transfer_index;
-    for (transfer_index=0;transfer_index<SCO_RING_BUFFER_COUNT;transfer_index++){
-        if (ds == &usb_data_source_sco_out[transfer_index]) break;
+    // log_info("usb_process_sco_out_done: #%u error %u, bytes %u, state %u", transfer_index, (int) error, (int) bytes_transferred, sco_state);
+    if (error != ERROR_SUCCESS){
+        log_error("usb_process_sco_out_done[%02u]: error writing %u, Internal %x", transfer_index, (int) error, (int) request->overlapped.Internal);
     }
 
-    // log_info("usb_process_sco_out[%02u] -- current frame %lu", transfer_index, current_frame_number);
-
-    DWORD bytes_transferred;
-    BOOL ok = WinUsb_GetOverlappedResult(usb_interface_0_handle, &usb_overlapped_sco_out[transfer_index], &bytes_transferred, FALSE);
-    // log_info("usb_process_sco_out_done: #%u result %u, bytes %u, state %u", transfer_index, ok, (int) bytes_transferred, sco_state);
-    if(!ok){
-        DWORD err = GetLastError();
-        if (err == ERROR_IO_INCOMPLETE){
-            // IO_INCOMPLETE -> wait for completed
-            btstack_run_loop_enable_data_source_callbacks(&usb_data_source_sco_out[transfer_index], DATA_SOURCE_CALLBACK_WRITE);
-            return;
-        }
-        log_error("usb_process_sco_out_done[%02u]: error writing %u, Internal %x", transfer_index, (int) err, (int) usb_overlapped_sco_out[transfer_index].Internal);
-    }
-
-    // decrease tab
+    // decrease tab, transfers complete in order
     sco_ring_transfers_active--;
 
-    // enable next data source callback
-    if (sco_ring_transfers_active){
-        // update expected and wait for completion
-        usb_sco_out_expected_transfer = (transfer_index+ 1) % SCO_RING_BUFFER_COUNT;
-        // log_info("usb_process_sco_out_done[%02u]: wait for transfer %02u", transfer_index, usb_sco_out_expected_transfer);
-        btstack_run_loop_enable_data_source_callbacks(&usb_data_source_sco_out[usb_sco_out_expected_transfer], DATA_SOURCE_CALLBACK_WRITE);
-    }
-
     // log_info("usb_process_sco_out_done: transfers active %u", sco_ring_transfers_active);
 
     // mark free
@@ -650,42 +650,21 @@ static void usb_process_sco_out(btstack_data_source_t *ds,  btstack_data_source_
     }
 }
 
-static void usb_process_sco_in(btstack_data_source_t *ds,  btstack_data_source_callback_type_t callback_type){
-
-    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+static void usb_process_sco_in(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error){
 
     if (sco_shutdown){
-        log_info("USB SCO Shutdown: usb_process_sco_out called");
+        log_info("USB SCO Shutdown: usb_process_sco_in called");
         return;
     }
 
-    // find index
-    int i;
-    for (i=0;i<ISOC_BUFFERS;i++){
-        if (ds == &usb_data_source_sco_in[i]) break;
-    }
-    int transfer_index = i;
+    int transfer_index = (int) (request - usb_request_sco_in);
 
-    // ULONG current_frame_number;
-    // LARGE_INTEGER timestamp;
-    // BTstack_WinUsb_GetCurrentFrameNumber(usb_interface_0_handle, &current_frame_number, &timestamp);
+    // log_info("usb_process_sco_in[%02u]", transfer_index);
 
-    // log_info("usb_process_sco_in[%02u] -- current frame %lu", transfer_index, current_frame_number);
-
-    DWORD bytes_transferred;
-    BOOL ok = WinUsb_GetOverlappedResult(usb_interface_0_handle, &usb_overlapped_sco_in[transfer_index], &bytes_transferred, FALSE);
-
-    if(!ok) {
-        DWORD err = GetLastError();
-        if (err == ERROR_IO_INCOMPLETE) {
-            // IO_INCOMPLETE -> wait for completed
-            btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
-            return;
-        }
-        log_error("usb_process_sco_in[%02u]: error reading %u, Internal %x", transfer_index, (int) err, (int) usb_overlapped_sco_out[i].Internal);
-    }
-
-    if (ok){
+    if (error != ERROR_SUCCESS){
+        log_error("usb_process_sco_in[%02u]: error reading %u, Internal %x", transfer_index, (int) error, (int) request->overlapped.Internal);
+    } else {
+        int i;
         for (i=0;i<NUM_ISO_PACKETS;i++){
             USBD_ISO_PACKET_DESCRIPTOR * packet_descriptor = &hci_sco_packet_descriptors[transfer_index * NUM_ISO_PACKETS + i];
             if (packet_descriptor->Length){
@@ -696,41 +675,76 @@ static void usb_process_sco_in(btstack_data_source_t *ds,  btstack_data_source_c
         }
     }
 
+    // transfers complete in order, re-submit this one to continue stream
 #ifdef SCHEDULE_SCO_IN_TRANSFERS_MANUALLY
-    usb_submit_sco_in_transfer_at_frame(i, &sco_next_transfer_at_frame);
+    usb_submit_sco_in_transfer_at_frame(transfer_index, &sco_next_transfer_at_frame);
 #else
     usb_submit_sco_in_transfer_asap(transfer_index, 1);
 #endif
-    // update expected and wait for completion
-    usb_sco_in_expected_transfer = (transfer_index+ 1) % ISOC_BUFFERS;
-
-    // log_info("usb_process_sco_in[%02u]: enable data source %02u", transfer_index, usb_sco_in_expected_transfer);
-    btstack_run_loop_enable_data_source_callbacks(&usb_data_source_sco_in[usb_sco_in_expected_transfer], DATA_SOURCE_CALLBACK_READ);
 }
 #endif
 
-static void usb_process_command_out(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+static void usb_emit_packet_sent(void){
+    // notify upper stack that provided buffer can be used again
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+}
+
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+static void usb_acl_out_emit_packet_sent(void){
+    if (usb_acl_out_packet_sent_timer_active){
+        btstack_run_loop_remove_timer(&usb_acl_out_packet_sent_timer);
+        usb_acl_out_packet_sent_timer_active = 0;
+    }
+    usb_acl_out_packet_sent_pending = 0;
+    usb_emit_packet_sent();
+}
+
+static void usb_acl_out_packet_sent_handler(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    usb_acl_out_packet_sent_timer_active = 0;
+    if (!usb_transport_open) return;
+    if (!usb_acl_out_packet_sent_pending) return;
+    usb_acl_out_emit_packet_sent();
+}
+#endif
 
-    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+static void usb_process_command_out(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error){
 
     // update stata before submitting transfer
     usb_command_out_active = 0;
 
-    // notify upper stack that provided buffer can be used again
-    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+    if (!usb_transport_open) return;
+
+    if (error != ERROR_SUCCESS){
+        log_error("usb_process_command_out: error %lu", error);
+    }
+
+    usb_emit_packet_sent();
 } 
 
-static void usb_process_acl_out(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+static void usb_process_acl_out(btstack_run_loop_windows_overlapped_t * request, DWORD bytes_transferred, DWORD error){
 
-    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+    int i = (int) (request - usb_request_acl_out);
+    if (usb_acl_out_in_flight[i]){
+        usb_acl_out_in_flight[i] = 0;
+        usb_acl_out_active--;
+    }
 
-    // update stata before submitting transfer
-    usb_acl_out_active = 0;
+    if (!usb_transport_open) return;
 
-    // notify upper stack that provided buffer can be used again
-    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+    if (error != ERROR_SUCCESS){
+        log_error("usb_process_acl_out: error %lu", error);
+    }
+
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    // packet has been copied before, report it as sent as soon as a transfer is free again
+    if (usb_acl_out_packet_sent_pending){
+        usb_acl_out_emit_packet_sent();
+    }
+#else
+    usb_emit_packet_sent();
+#endif
 }
 
 static BOOL usb_scan_for_bluetooth_endpoints(void) {
@@ -895,10 +909,7 @@ static int usb_sco_start(void){
 #endif    
     }
 
-    usb_sco_in_expected_transfer = 0;
-
-    // only await first transfer to return
-    btstack_run_loop_enable_data_source_callbacks(&usb_data_source_sco_in[usb_sco_in_expected_transfer], DATA_SOURCE_CALLBACK_READ);
+    // transfers complete in order via run loop
     return 1;
 
 exit_on_error:
@@ -990,63 +1001,31 @@ static int usb_try_open_device(const char * device_path){
         return 0;
     }
 
-#ifdef ENABLE_SCO_OVER_HCI
-    int i;
+    // completions of all transfers are processed by run loop
+    result = btstack_run_loop_windows_add_file_handle(usb_device_handle);
+    if (!result) goto exit_on_error;
 
+#ifdef ENABLE_SCO_OVER_HCI
 	memset(hci_sco_packet_descriptors, 0, sizeof(hci_sco_packet_descriptors));
 	log_info("Size of packet descriptors for SCO IN%u", (int) sizeof(hci_sco_packet_descriptors));
-
-	// setup async io && btstack handler
-	memset(&usb_overlapped_sco_in, 0, sizeof(usb_overlapped_sco_in));
-	for (i=0;i<ISOC_BUFFERS;i++){
-		usb_overlapped_sco_in[i].hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
-		// log_info_hexdump(&usb_overlapped_sco_in[i], sizeof(OVERLAPPED));
-        // log_info("data source SCO in %u, handle %p", i, usb_overlapped_sco_in[i].hEvent);
-		usb_data_source_sco_in[i].source.handle = usb_overlapped_sco_in[i].hEvent;
-	    btstack_run_loop_set_data_source_handler(&usb_data_source_sco_in[i], &usb_process_sco_in);
-        btstack_run_loop_add_data_source(&usb_data_source_sco_in[i]);
-	}
-
-    memset(&usb_overlapped_sco_out, 0, sizeof(usb_overlapped_sco_out));
-    for (i=0;i<SCO_RING_BUFFER_COUNT;i++){
-        usb_overlapped_sco_out[i].hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
-        // log_info("data source SCO out %u, handle %p", i, usb_overlapped_sco_out[i].hEvent);
-        usb_data_source_sco_out[i].source.handle = usb_overlapped_sco_out[i].hEvent;
-        btstack_run_loop_set_data_source_handler(&usb_data_source_sco_out[i], &usb_process_sco_out);
-        btstack_run_loop_add_data_source(&usb_data_source_sco_out[i]);
-    }
 #endif
 
-	// setup async io
-    memset(&usb_overlapped_event_in,     0, sizeof(usb_overlapped_event_in));
-    memset(&usb_overlapped_command_out,  0, sizeof(usb_overlapped_command_out));
-    memset(&usb_overlapped_acl_out,      0, sizeof(usb_overlapped_acl_out));
-    memset(&usb_overlapped_acl_in,       0, sizeof(usb_overlapped_acl_in));
-    usb_overlapped_event_in.hEvent    = CreateEvent(NULL, TRUE, FALSE, NULL);
-    usb_overlapped_command_out.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
-    usb_overlapped_acl_in.hEvent      = CreateEvent(NULL, TRUE, FALSE, NULL);
-    usb_overlapped_acl_out.hEvent     = CreateEvent(NULL, TRUE, FALSE, NULL);
-
-	// setup btstack data soures
-    usb_data_source_event_in.source.handle = usb_overlapped_event_in.hEvent;
-    btstack_run_loop_set_data_source_handler(&usb_data_source_event_in, &usb_process_event_in);
-    btstack_run_loop_add_data_source(&usb_data_source_event_in);
-
-    usb_data_source_command_out.source.handle = usb_overlapped_command_out.hEvent;
-    btstack_run_loop_set_data_source_handler(&usb_data_source_command_out, &usb_process_command_out);
-    btstack_run_loop_add_data_source(&usb_data_source_command_out);
-
-    usb_data_source_acl_in.source.handle = usb_overlapped_acl_in.hEvent;
-    btstack_run_loop_set_data_source_handler(&usb_data_source_acl_in, &usb_process_acl_in);
-    btstack_run_loop_add_data_source(&usb_data_source_acl_in);
-
-    usb_data_source_acl_out.source.handle = usb_overlapped_acl_out.hEvent;
-    btstack_run_loop_set_data_source_handler(&usb_data_source_acl_out, &usb_process_acl_out);
-    btstack_run_loop_add_data_source(&usb_data_source_acl_out);
+    // reset state
+    usb_command_out_active = 0;
+    usb_acl_out_active = 0;
+    memset(usb_acl_out_in_flight, 0, sizeof(usb_acl_out_in_flight));
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    usb_acl_out_packet_sent_pending = 0;
+#endif
 
     // submit all incoming transfers
-    usb_submit_event_in_transfer();
-    usb_submit_acl_in_transfer();    
+    int i;
+    for (i = 0; i < HCI_TRANSPORT_USB_EVENT_IN_TRANSFER_COUNT; i++){
+        usb_submit_event_in_transfer(i);
+    }
+    for (i = 0; i < HCI_TRANSPORT_USB_ACL_IN_TRANSFER_COUNT; i++){
+        usb_submit_acl_in_transfer(i);
+    }
 	return 1;
 
 exit_on_error:
@@ -1214,22 +1193,14 @@ static int usb_open(void){
 
 static int usb_close(void){
     
-    if (!usb_transport_open == 0) return 0;
-
-    // remove data sources
-    btstack_run_loop_remove_data_source(&usb_data_source_command_out);
-    btstack_run_loop_remove_data_source(&usb_data_source_event_in);
-    btstack_run_loop_remove_data_source(&usb_data_source_acl_in);
-    btstack_run_loop_remove_data_source(&usb_data_source_acl_out);
+    if (!usb_transport_open) return 0;
 
-#ifdef ENABLE_SCO_OVER_HCI
-    int i;
-    for (i=0;i<ISOC_BUFFERS;i++){
-        btstack_run_loop_remove_data_source(&usb_data_source_sco_in[i]);
-    }
-    for (i=0;i<SCO_RING_BUFFER_COUNT;i++){
-        btstack_run_loop_remove_data_source(&usb_data_source_sco_out[i]);
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    if (usb_acl_out_packet_sent_timer_active){
+        btstack_run_loop_remove_timer(&usb_acl_out_packet_sent_timer);
+        usb_acl_out_packet_sent_timer_active = 0;
     }
+    usb_acl_out_packet_sent_pending = 0;
 #endif
 
     log_info("usb_close abort event and acl pipes");
@@ -1242,12 +1213,13 @@ static int usb_close(void){
     usb_sco_stop();
 #endif
     usb_acl_out_active = 0;
+    memset(usb_acl_out_in_flight, 0, sizeof(usb_acl_out_in_flight));
 
     // control transfer cannot be stopped, just wait for completion
     if (usb_command_out_active){
         log_info("usb_close command out active, wait for complete");
         DWORD bytes_transferred;
-        WinUsb_GetOverlappedResult(usb_interface_0_handle, &usb_overlapped_command_out, &bytes_transferred, TRUE);
+        WinUsb_GetOverlappedResult(usb_interface_0_handle, &usb_request_command_out.overlapped, &bytes_transferred, TRUE);
         usb_command_out_active = 0;
     }
 
@@ -1268,7 +1240,12 @@ static int usb_can_send_packet_now(uint8_t packet_type){
         case HCI_COMMAND_DATA_PACKET:
             return !usb_command_out_active;
         case HCI_ACL_DATA_PACKET:
-            return !usb_acl_out_active;
+        // ISO data is sent over the bulk endpoint, too
+        case HCI_ISO_DATA_PACKET:
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+            if (usb_acl_out_packet_sent_pending) return 0;
+#endif
+            return usb_acl_out_active < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT;
 #ifdef ENABLE_SCO_OVER_HCI
         case HCI_SCO_DATA_PACKET:
             // return 0;
@@ -1289,38 +1266,72 @@ static int usb_send_cmd_packet(uint8_t *packet, int size){
 	memset(&setup_packet, 0, sizeof(setup_packet));
 	setup_packet.RequestType =  USB_REQUEST_TYPE_CLASS | USB_RECIPIENT_INTERFACE;
 	setup_packet.Length = sizeof(size);
-	BOOL result = WinUsb_ControlTransfer(usb_interface_0_handle, setup_packet, packet, size,  NULL, &usb_overlapped_command_out);
+    btstack_run_loop_windows_overlapped_init(&usb_request_command_out, &usb_process_command_out, NULL);
+	BOOL result = WinUsb_ControlTransfer(usb_interface_0_handle, setup_packet, packet, size,  NULL, &usb_request_command_out.overlapped);
 	if (!result) {
 		if (GetLastError() != ERROR_IO_PENDING) goto exit_on_error;
 	}
 
-    // IO_PENDING -> wait for completed
-    btstack_run_loop_enable_data_source_callbacks(&usb_data_source_command_out, DATA_SOURCE_CALLBACK_WRITE);
-
+    // IO_PENDING -> completion is processed by run loop
     return 0;
 
 exit_on_error:
 	log_error("winusb: last error %lu", GetLastError());
+    usb_command_out_active = 0;
 	return -1;
 }
 
 static int usb_send_acl_packet(uint8_t *packet, int size){
 
+    // get free transfer
+    int slot;
+    for (slot = 0; slot < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT; slot++){
+        if (!usb_acl_out_in_flight[slot]) break;
+    }
+    if (slot == HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT){
+        log_error("usb_send_acl_packet: no free transfer");
+        return -1;
+    }
+
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    // copy packet, so that upper layer can provide the next one while this one is in flight
+    if (size > HCI_OUTGOING_PACKET_BUFFER_SIZE){
+        log_error("usb_send_acl_packet: size %u > buffer size", size);
+        return -1;
+    }
+    memcpy(usb_acl_out_buffer[slot], packet, size);
+    packet = usb_acl_out_buffer[slot];
+#endif
+
     // update stata before submitting transfer
-    usb_acl_out_active = 1;
+    usb_acl_out_in_flight[slot] = 1;
+    usb_acl_out_active++;
 
 	// Start trasnsfer
-	BOOL ok = WinUsb_WritePipe(usb_interface_0_handle, acl_out_addr, packet, size,  NULL, &usb_overlapped_acl_out);
+    btstack_run_loop_windows_overlapped_init(&usb_request_acl_out[slot], &usb_process_acl_out, NULL);
+	BOOL ok = WinUsb_WritePipe(usb_interface_0_handle, acl_out_addr, packet, size,  NULL, &usb_request_acl_out[slot].overlapped);
 	if (!ok) {
 		if (GetLastError() != ERROR_IO_PENDING) goto exit_on_error;
 	}
 
-    // IO_PENDING -> wait for completed
-    btstack_run_loop_enable_data_source_callbacks(&usb_data_source_acl_out, DATA_SOURCE_CALLBACK_WRITE);
+#if HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT > 1
+    // report packet as sent from run loop if another transfer is free, or on next completed transfer
+    usb_acl_out_packet_sent_pending = 1;
+    if (usb_acl_out_active < HCI_TRANSPORT_USB_ACL_OUT_TRANSFER_COUNT){
+        btstack_run_loop_set_timer_handler(&usb_acl_out_packet_sent_timer, &usb_acl_out_packet_sent_handler);
+        btstack_run_loop_set_timer(&usb_acl_out_packet_sent_timer, 0);
+        btstack_run_loop_add_timer(&usb_acl_out_packet_sent_timer);
+        usb_acl_out_packet_sent_timer_active = 1;
+    }
+#endif
+
+    // IO_PENDING -> completion is processed by run loop
     return 0;
 
 exit_on_error:
 	log_error("winusb: last error %lu", GetLastError());
+    usb_acl_out_in_flight[slot] = 0;
+    usb_acl_out_active--;
 	return -1;
 }
 
@@ -1345,18 +1356,13 @@ static int usb_send_sco_packet(uint8_t *packet, int size){
 
     // setup transfer
     int continue_stream = sco_ring_transfers_active > 0;
-    BOOL ok = BTstack_WinUsb_WriteIsochPipeAsap(hci_sco_out_buffer_handle, transfer_index * SCO_PACKET_SIZE, size, continue_stream, &usb_overlapped_sco_out[transfer_index]);
+    btstack_run_loop_windows_overlapped_init(&usb_request_sco_out[transfer_index], &usb_process_sco_out, NULL);
+    BOOL ok = BTstack_WinUsb_WriteIsochPipeAsap(hci_sco_out_buffer_handle, transfer_index * SCO_PACKET_SIZE, size, continue_stream, &usb_request_sco_out[transfer_index].overlapped);
     // log_info("usb_send_sco_packet: using slot #%02u, current frame %lu, continue stream %u, ok %u", transfer_index, current_frame_number, continue_stream, ok);
     if (!ok) {
         if (GetLastError() != ERROR_IO_PENDING) goto exit_on_error;
     }
 
-    // successful started transfer, enable data source callback if first active transfer
-    if (sco_ring_transfers_active == 0){
-        usb_sco_out_expected_transfer = transfer_index;
-        btstack_run_loop_enable_data_source_callbacks(&usb_data_source_sco_out[transfer_index], DATA_SOURCE_CALLBACK_WRITE);
-    }
-
     // mark slot as full
     sco_ring_write = (sco_ring_write + 1) % SCO_RING_BUFFER_COUNT;
     sco_ring_transfers_active++;
@@ -1385,6 +1391,7 @@ static int usb_send_packet(uint8_t packet_type, uint8_t * packet, int size){
         case HCI_COMMAND_DATA_PACKET:
             return usb_send_cmd_packet(packet, size);
         case HCI_ACL_DATA_PACKET:
+        case HCI_ISO_DATA_PACKET:
             return usb_send_acl_packet(packet, size);
 #ifdef ENABLE_SCO_OVER_HCI
         case HCI_SCO_DATA_PACKET:
@@ -47,7 +47,7 @@
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_freertos.h"
-#include "btstack_ring_buffer.h"
+#include "btstack_ring_buffer_spsc.h"
 #include "btstack_tlv.h"
 #include "btstack_tlv_esp32.h"
 #include "ble/le_device_db_tlv.h"
@@ -62,7 +62,6 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 
 uint32_t esp_log_timestamp();
 
@@ -80,24 +79,37 @@ uint32_t hal_time_ms(void) {
 
 static void (*transport_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
 
-// ring buffer for incoming HCI packets. Each packet has 2 byte len tag + H4 packet type + packet itself
+// lock-free ring buffer for incoming HCI packets, written by VHCI task, read by BTstack thread.
+// Each packet is stored as contiguous record: 2 byte len tag + pre-buffer + H4 packet type + packet itself,
+// padded to 4 bytes. Packets are passed to the packet handler from the ring buffer and released afterwards.
+// If a record does not fit before the end of the storage, the remaining bytes are skipped with a padding tag.
+#define HCI_RECORD_PADDING 0xffff
+#define HCI_RECORD_SIZE(len) ((2u + HCI_INCOMING_PRE_BUFFER_SIZE + (len) + 3u) & ~3u)
 #define MAX_NR_HOST_EVENT_PACKETS 4
-static uint8_t hci_ringbuffer_storage[HCI_HOST_ACL_PACKET_NUM   * (2 + 1 + HCI_ACL_HEADER_SIZE + HCI_HOST_ACL_PACKET_LEN) +
-                                      HCI_HOST_SCO_PACKET_NUM   * (2 + 1 + HCI_SCO_HEADER_SIZE + HCI_HOST_SCO_PACKET_LEN) +
-                                      MAX_NR_HOST_EVENT_PACKETS * (2 + 1 + HCI_EVENT_BUFFER_SIZE)];
-
-static btstack_ring_buffer_t hci_ringbuffer;
-
-// incoming packet buffer
-static uint8_t hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE]; // packet type + max(acl header + acl payload, event header + event data)
-static uint8_t * hci_receive_buffer = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+#define HCI_RINGBUFFER_MIN_SIZE (HCI_HOST_ACL_PACKET_NUM   * HCI_RECORD_SIZE(1 + HCI_ACL_HEADER_SIZE + HCI_HOST_ACL_PACKET_LEN) + \
+                                 HCI_HOST_SCO_PACKET_NUM   * HCI_RECORD_SIZE(1 + HCI_SCO_HEADER_SIZE + HCI_HOST_SCO_PACKET_LEN) + \
+                                 MAX_NR_HOST_EVENT_PACKETS * HCI_RECORD_SIZE(1 + HCI_EVENT_BUFFER_SIZE) + \
+                                 HCI_RECORD_SIZE(1 + HCI_INCOMING_PACKET_BUFFER_SIZE))
+
+// storage size needs to be a power of two
+#if HCI_RINGBUFFER_MIN_SIZE <= 16384
+#define HCI_RINGBUFFER_SIZE 16384
+#elif HCI_RINGBUFFER_MIN_SIZE <= 32768
+#define HCI_RINGBUFFER_SIZE 32768
+#else
+#define HCI_RINGBUFFER_SIZE 65536
+#endif
+static uint8_t hci_ringbuffer_storage[HCI_RINGBUFFER_SIZE];
 
-static SemaphoreHandle_t ring_buffer_mutex;
+static btstack_ring_buffer_spsc_t hci_ringbuffer;
 
 // data source for integration with BTstack Runloop
+// flags are set by VHCI task and cleared by BTstack thread, the BTstack thread is only triggered on 0->1 transitions
 static btstack_data_source_t transport_data_source;
-static int                   transport_signal_sent;
-static int                   transport_packets_to_deliver;
+static volatile int          transport_signal_sent;
+static volatile int          transport_packets_to_deliver;
+// incremented when ring buffer is reset by transport_open
+static uint32_t              transport_ringbuffer_generation;
 
 // TODO: remove once stable 
 void report_recv_called_from_isr(void){
@@ -117,7 +129,8 @@ static void host_send_pkt_available_cb(void){
         return;
     }
 
-    // set flag and trigger polling of transport data source on main thread
+    // set flag and trigger polling of transport data source on main thread, if not already pending
+    if (transport_signal_sent) return;
     transport_signal_sent = 1;
     btstack_run_loop_freertos_trigger();
 }
@@ -129,27 +142,29 @@ static int host_recv_pkt_cb(uint8_t *data, uint16_t len){
         return 0;
     }
 
-    xSemaphoreTake(ring_buffer_mutex, portMAX_DELAY);
-
-    // check space
-    uint16_t space = btstack_ring_buffer_bytes_free(&hci_ringbuffer);
-    if (space < len){
-        xSemaphoreGive(ring_buffer_mutex);
-        log_error("transport_recv_pkt_cb packet %u, space %u -> dropping packet", len, space);
+    // check space for contiguous record
+    uint32_t record_size = HCI_RECORD_SIZE(len);
+    uint32_t space = btstack_ring_buffer_spsc_bytes_free(&hci_ringbuffer);
+    uint32_t region_size;
+    uint8_t * region = btstack_ring_buffer_spsc_get_write_region(&hci_ringbuffer, &region_size);
+    if ((region_size < record_size) && (region_size < space) && ((space - region_size) >= record_size)){
+        // skip to start of storage
+        little_endian_store_16(region, 0, HCI_RECORD_PADDING);
+        btstack_ring_buffer_spsc_write_commit(&hci_ringbuffer, region_size);
+        region = btstack_ring_buffer_spsc_get_write_region(&hci_ringbuffer, &region_size);
+    }
+    if (region_size < record_size){
+        log_error("transport_recv_pkt_cb packet %u, space %u -> dropping packet", len, (unsigned int) space);
         return 0;
     }
 
-    // store size in ringbuffer
-    uint8_t len_tag[2];
-    little_endian_store_16(len_tag, 0, len);
-    btstack_ring_buffer_write(&hci_ringbuffer, len_tag, sizeof(len_tag));
-
-    // store in ringbuffer
-    btstack_ring_buffer_write(&hci_ringbuffer, data, len);
-
-    xSemaphoreGive(ring_buffer_mutex);
+    // store record in ringbuffer
+    little_endian_store_16(region, 0, len);
+    (void) memcpy(&region[2 + HCI_INCOMING_PRE_BUFFER_SIZE], data, len);
+    btstack_ring_buffer_spsc_write_commit(&hci_ringbuffer, record_size);
 
-    // set flag and trigger delivery of packets on main thread
+    // set flag and trigger delivery of packets on main thread, if not already pending
+    if (transport_packets_to_deliver) return 0;
     transport_packets_to_deliver = 1;
     btstack_run_loop_freertos_trigger();
     return 0;
@@ -169,18 +184,25 @@ static void transport_notify_packet_send(void){
 }
 
 static void transport_deliver_packets(void){
-    xSemaphoreTake(ring_buffer_mutex, portMAX_DELAY);
-    while (btstack_ring_buffer_bytes_available(&hci_ringbuffer)){
-        uint32_t number_read;
-        uint8_t len_tag[2];
-        btstack_ring_buffer_read(&hci_ringbuffer, len_tag, 2, &number_read);
-        uint32_t len = little_endian_read_16(len_tag, 0);
-        btstack_ring_buffer_read(&hci_ringbuffer, hci_receive_buffer, len, &number_read);
-        xSemaphoreGive(ring_buffer_mutex);
-        transport_packet_handler(hci_receive_buffer[0], &hci_receive_buffer[1], len-1);
-        xSemaphoreTake(ring_buffer_mutex, portMAX_DELAY);
+    while (1){
+        // records are committed as a whole and are contiguous
+        uint32_t region_size;
+        uint8_t * region = (uint8_t *) btstack_ring_buffer_spsc_get_read_region(&hci_ringbuffer, &region_size);
+        if (region_size < 2) break;
+        uint16_t len = little_endian_read_16(region, 0);
+        if (len == HCI_RECORD_PADDING){
+            btstack_ring_buffer_spsc_read_commit(&hci_ringbuffer, region_size);
+            continue;
+        }
+        // deliver packet from ring buffer, pre-buffer is part of record
+        uint8_t * packet = &region[2 + HCI_INCOMING_PRE_BUFFER_SIZE];
+        uint32_t generation = transport_ringbuffer_generation;
+        transport_packet_handler(packet[0], &packet[1], len-1);
+        // transport re-opened by packet handler
+        if (generation != transport_ringbuffer_generation) break;
+        // release record after packet handler returned
+        btstack_ring_buffer_spsc_read_commit(&hci_ringbuffer, HCI_RECORD_SIZE(len));
     }
-    xSemaphoreGive(ring_buffer_mutex);
 }
 
 
@@ -207,7 +229,6 @@ static void transport_process(btstack_data_source_t *ds, btstack_data_source_cal
  */
 static void transport_init(const void *transport_config){
     log_info("transport_init");
-    ring_buffer_mutex = xSemaphoreCreateMutex();
 
     // set up polling data_source
     btstack_run_loop_set_data_source_handler(&transport_data_source, &transport_process);
@@ -224,7 +245,8 @@ static int transport_open(void){
 
     log_info("transport_open");
 
-    btstack_ring_buffer_init(&hci_ringbuffer, hci_ringbuffer_storage, sizeof(hci_ringbuffer_storage));
+    btstack_ring_buffer_spsc_init(&hci_ringbuffer, hci_ringbuffer_storage, sizeof(hci_ringbuffer_storage));
+    transport_ringbuffer_generation++;
 
     // http://esp-idf.readthedocs.io/en/latest/api-reference/bluetooth/controller_vhci.html (2017104)
     // - "esp_bt_controller_init: ... This function should be called only once, before any other BT functions are called."
@@ -275,6 +275,7 @@ static const btstack_run_loop_t btstack_run_loop_wiced = {
     &btstack_run_loop_zephyr_execute,
     &btstack_run_loop_zephyr_dump_timer,
     &btstack_run_loop_zephyr_get_time_ms,
+    NULL,
 };
 /**
  * @brief Provide btstack_run_loop_posix instance for use with btstack_run_loop_init
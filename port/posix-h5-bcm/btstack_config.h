@@ -32,6 +32,7 @@
 // BTstack configuration. buffers, sizes, ...
 #define HCI_INCOMING_PRE_BUFFER_SIZE 14 // sizeof benep heade, avoid memcpy
 #define HCI_ACL_PAYLOAD_SIZE (1691 + 4)
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 4
 
 #define NVM_NUM_DEVICE_DB_ENTRIES      20
 
@@ -57,6 +57,13 @@
 
 #include "ad_parser.h"
 
+static const uint8_t * ad_parser_bluetooth_base_uuid_le(uint16_t uuid16, uint8_t * buffer){
+    uint8_t uuid128[16];
+    uuid_add_bluetooth_prefix(uuid128, uuid16);
+    reverse_128(uuid128, buffer);
+    return buffer;
+}
+
 void ad_iterator_init(ad_context_t *context, uint8_t ad_len, const uint8_t * ad_data){
     context->data = ad_data;
     context->length = ad_len;
@@ -97,6 +104,9 @@ const uint8_t * ad_iterator_get_data(const ad_context_t * context){
 
 bool ad_data_contains_uuid16(uint8_t ad_len, const uint8_t * ad_data, uint16_t uuid16){
     ad_context_t context;
+    // Bluetooth Base UUID form of uuid16, only built if a 128-bit list is present
+    uint8_t uuid128_bt_storage[16];
+    const uint8_t * uuid128_bt = NULL;
     ad_iterator_init(&context, ad_len, ad_data);
     while ( ad_iterator_has_more(&context) ){
         uint8_t data_type    = ad_iterator_get_data_type(&context);
@@ -104,7 +114,6 @@ bool ad_data_contains_uuid16(uint8_t ad_len, const uint8_t * ad_data, uint16_t u
         const uint8_t * data = ad_iterator_get_data(&context);
         
         int i;
-        uint8_t ad_uuid128[16], uuid128_bt[16];
                 
         switch (data_type){
             case BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
@@ -116,8 +125,9 @@ bool ad_data_contains_uuid16(uint8_t ad_len, const uint8_t * ad_data, uint16_t u
                 break;
             case BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS:
             case BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS:
-                uuid_add_bluetooth_prefix(ad_uuid128, uuid16);
-                reverse_128(ad_uuid128, uuid128_bt);
+                if (uuid128_bt == NULL){
+                    uuid128_bt = ad_parser_bluetooth_base_uuid_le(uuid16, uuid128_bt_storage);
+                }
                 for (i=0; (i+16) <= data_len; i+=16){
                     if (memcmp(uuid128_bt, &data[i], 16) == 0) return true;
                 }
@@ -135,6 +145,9 @@ bool ad_data_contains_uuid128(uint8_t ad_len, const uint8_t * ad_data, const uin
     // input in big endian/network order, bluetooth data in little endian
     uint8_t uuid128_le[16];
     reverse_128(uuid128, uuid128_le);
+    // 16-bit list entries can only match a target based on the Bluetooth Base UUID
+    bool     has_uuid16 = (uuid_has_bluetooth_prefix(uuid128) != 0) && (big_endian_read_16(uuid128, 0) == 0);
+    uint16_t uuid16 = big_endian_read_16(uuid128, 2);
     ad_iterator_init(&context, ad_len, ad_data);
     while ( ad_iterator_has_more(&context) ){
         uint8_t data_type = ad_iterator_get_data_type(&context);
@@ -142,16 +155,13 @@ bool ad_data_contains_uuid128(uint8_t ad_len, const uint8_t * ad_data, const uin
         const uint8_t * data = ad_iterator_get_data(&context);
         
         int i;
-        uint8_t ad_uuid128[16];
 
         switch (data_type){
             case BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
             case BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
+                if (has_uuid16 == false) break;
                 for (i=0; (i+2) <= data_len; i+=2){
-                    uint16_t uuid16 = little_endian_read_16(data, i);
-                    uuid_add_bluetooth_prefix(ad_uuid128, uuid16);
-                    
-                    if (memcmp(ad_uuid128, uuid128_le, 16) == 0) return true;
+                    if (little_endian_read_16(data, i) == uuid16) return true;
                 }
 
                 break;
@@ -169,3 +179,152 @@ bool ad_data_contains_uuid128(uint8_t ad_len, const uint8_t * ad_data, const uin
     return false;
 }
 
+
+// UUID Matcher
+
+static uint16_t ad_uuid_matcher_hash16(uint16_t uuid16){
+    // multiplicative hashing, use upper bits
+    return (uint16_t) ((((uint32_t) uuid16) * 2654435761u) >> 16);
+}
+
+// FNV-1a over the UUID in big endian order, le = true if uuid128 is stored in little endian
+static uint16_t ad_uuid_matcher_hash128(const uint8_t * uuid128, bool le){
+    uint32_t hash = 2166136261u;
+    int i;
+    for (i=0;i<16;i++){
+        hash ^= le ? uuid128[15-i] : uuid128[i];
+        hash *= 16777619u;
+    }
+    return (uint16_t) (hash ^ (hash >> 16));
+}
+
+// return true if 128-bit UUID (big endian) is based on the Bluetooth Base UUID and fits into 16 bit
+static bool ad_uuid_matcher_uuid128_is_uuid16(const uint8_t * uuid128, uint16_t * uuid16){
+    if (uuid_has_bluetooth_prefix(uuid128) == 0) return false;
+    if (big_endian_read_16(uuid128, 0) != 0) return false;
+    *uuid16 = big_endian_read_16(uuid128, 2);
+    return true;
+}
+
+static bool ad_uuid_matcher_target_is_uuid16(const ad_uuid_matcher_t * matcher, uint16_t index, uint16_t * uuid16){
+    if (index < matcher->num_uuid16s){
+        *uuid16 = matcher->uuid16s[index];
+        return true;
+    }
+    return ad_uuid_matcher_uuid128_is_uuid16(&matcher->uuid128s[(index - matcher->num_uuid16s) * 16], uuid16);
+}
+
+static uint16_t ad_uuid_matcher_add_match(uint16_t * matches, uint16_t num_matches, uint16_t max_matches, uint16_t index){
+    uint16_t i;
+    for (i=0;i<num_matches;i++){
+        if (matches[i] == index) return num_matches;
+    }
+    if (num_matches >= max_matches) return num_matches;
+    matches[num_matches] = index;
+    return num_matches + 1;
+}
+
+static uint16_t ad_uuid_matcher_lookup_uuid16(const ad_uuid_matcher_t * matcher, uint16_t uuid16,
+                                              uint16_t * matches, uint16_t num_matches, uint16_t max_matches){
+    uint16_t slot = ad_uuid_matcher_hash16(uuid16) & matcher->table_mask;
+    while (matcher->table[slot] != 0){
+        uint16_t index = matcher->table[slot] - 1;
+        uint16_t target_uuid16;
+        if (ad_uuid_matcher_target_is_uuid16(matcher, index, &target_uuid16) && (target_uuid16 == uuid16)){
+            num_matches = ad_uuid_matcher_add_match(matches, num_matches, max_matches, index);
+        }
+        slot = (slot + 1) & matcher->table_mask;
+    }
+    return num_matches;
+}
+
+// uuid128 in little endian as found in advertisement
+static uint16_t ad_uuid_matcher_lookup_uuid128(const ad_uuid_matcher_t * matcher, const uint8_t * uuid128_le,
+                                               uint16_t * matches, uint16_t num_matches, uint16_t max_matches){
+    uint16_t slot = ad_uuid_matcher_hash128(uuid128_le, true) & matcher->table_mask;
+    while (matcher->table[slot] != 0){
+        uint16_t index = matcher->table[slot] - 1;
+        if (index >= matcher->num_uuid16s){
+            const uint8_t * target = &matcher->uuid128s[(index - matcher->num_uuid16s) * 16];
+            int i;
+            for (i=0;i<16;i++){
+                if (target[i] != uuid128_le[15-i]) break;
+            }
+            if (i == 16){
+                num_matches = ad_uuid_matcher_add_match(matches, num_matches, max_matches, index);
+            }
+        }
+        slot = (slot + 1) & matcher->table_mask;
+    }
+    return num_matches;
+}
+
+bool ad_uuid_matcher_init(ad_uuid_matcher_t * matcher, uint16_t * table, uint16_t table_size,
+                          const uint16_t * uuid16s, uint16_t num_uuid16s,
+                          const uint8_t * uuid128s, uint16_t num_uuid128s){
+    uint32_t num_targets = (uint32_t) num_uuid16s + num_uuid128s;
+    // table_size power of two with at least one empty slot to terminate probing
+    if ((table_size == 0) || ((table_size & (table_size - 1)) != 0)) return false;
+    if (num_targets >= table_size) return false;
+
+    (void)memset(table, 0, table_size * sizeof(uint16_t));
+    matcher->table = table;
+    matcher->table_mask = table_size - 1;
+    matcher->uuid16s = uuid16s;
+    matcher->num_uuid16s = num_uuid16s;
+    matcher->uuid128s = uuid128s;
+    matcher->num_uuid128s = num_uuid128s;
+
+    uint16_t index;
+    for (index = 0; index < num_targets; index++){
+        uint16_t uuid16;
+        uint16_t slot;
+        if (ad_uuid_matcher_target_is_uuid16(matcher, index, &uuid16)){
+            slot = ad_uuid_matcher_hash16(uuid16);
+        } else {
+            slot = ad_uuid_matcher_hash128(&uuid128s[(index - num_uuid16s) * 16], false);
+        }
+        slot &= matcher->table_mask;
+        while (table[slot] != 0){
+            slot = (slot + 1) & matcher->table_mask;
+        }
+        table[slot] = index + 1;
+    }
+    return true;
+}
+
+uint16_t ad_uuid_matcher_match(const ad_uuid_matcher_t * matcher, uint8_t ad_len, const uint8_t * ad_data,
+                               uint16_t * matches, uint16_t max_matches){
+    uint16_t num_matches = 0;
+    ad_context_t context;
+    for (ad_iterator_init(&context, ad_len, ad_data) ; ad_iterator_has_more(&context) ; ad_iterator_next(&context)){
+        uint8_t data_type    = ad_iterator_get_data_type(&context);
+        uint8_t data_len     = ad_iterator_get_data_len(&context);
+        const uint8_t * data = ad_iterator_get_data(&context);
+        int i;
+        switch (data_type){
+            case BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
+            case BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
+                for (i=0; (i+2) <= data_len; i+=2){
+                    num_matches = ad_uuid_matcher_lookup_uuid16(matcher, little_endian_read_16(data, i), matches, num_matches, max_matches);
+                }
+                break;
+            case BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS:
+            case BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS:
+                for (i=0; (i+16) <= data_len; i+=16){
+                    uint8_t uuid128[16];
+                    uint16_t uuid16;
+                    reverse_128(&data[i], uuid128);
+                    if (ad_uuid_matcher_uuid128_is_uuid16(uuid128, &uuid16)){
+                        num_matches = ad_uuid_matcher_lookup_uuid16(matcher, uuid16, matches, num_matches, max_matches);
+                    } else {
+                        num_matches = ad_uuid_matcher_lookup_uuid128(matcher, &data[i], matches, num_matches, max_matches);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return num_matches;
+}
@@ -75,6 +75,47 @@ const uint8_t * ad_iterator_get_data(const ad_context_t * context);
 bool ad_data_contains_uuid16(uint8_t ad_len, const uint8_t * ad_data, uint16_t uuid16);
 bool ad_data_contains_uuid128(uint8_t ad_len, const uint8_t * ad_data, const uint8_t * uuid128);
 
+// Precompiled matcher for a set of target UUIDs
+typedef struct {
+    // open addressing hash table, slot contains target index + 1, 0 = empty
+    uint16_t       * table;
+    uint16_t         table_mask;
+    const uint16_t * uuid16s;
+    uint16_t         num_uuid16s;
+    // 128-bit UUIDs in big endian/network order, 16 bytes each
+    const uint8_t  * uuid128s;
+    uint16_t         num_uuid128s;
+} ad_uuid_matcher_t;
+
+/**
+ * @brief Compile target UUIDs into matcher. UUID16 targets get index 0..num_uuid16s-1, 
+ *        UUID128 targets get index num_uuid16s..num_uuid16s+num_uuid128s-1. Target lists are referenced, not copied.
+ *        128-bit UUIDs based on the Bluetooth Base UUID also match their 16-bit form and vice versa.
+ * @param matcher
+ * @param table storage for hash table
+ * @param table_size number of entries in table, power of two and larger than num_uuid16s + num_uuid128s
+ * @param uuid16s
+ * @param num_uuid16s
+ * @param uuid128s in big endian
+ * @param num_uuid128s
+ * @return true if table_size is valid
+ */
+bool ad_uuid_matcher_init(ad_uuid_matcher_t * matcher, uint16_t * table, uint16_t table_size,
+                          const uint16_t * uuid16s, uint16_t num_uuid16s,
+                          const uint8_t * uuid128s, uint16_t num_uuid128s);
+
+/**
+ * @brief Find all targets listed in the 16-bit and 128-bit Service Class UUID fields of an advertisement in a single pass
+ * @param matcher
+ * @param ad_len
+ * @param ad_data
+ * @param matches array for matching target indices, each target is reported once
+ * @param max_matches
+ * @return number of matches stored
+ */
+uint16_t ad_uuid_matcher_match(const ad_uuid_matcher_t * matcher, uint8_t ad_len, const uint8_t * ad_data,
+                               uint16_t * matches, uint16_t max_matches);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -54,13 +54,70 @@
 #include "classic/sdp_util.h"
 #include "gap.h"
 
+// max number of Get Notification / App Attributes requests queued on the Control Point
+#ifndef ANCS_CLIENT_REQUEST_QUEUE_SIZE
+#define ANCS_CLIENT_REQUEST_QUEUE_SIZE 4
+#endif
+
+// number of App Display Names kept in LRU cache
+#ifndef ANCS_CLIENT_APP_CACHE_SIZE
+#define ANCS_CLIENT_APP_CACHE_SIZE 4
+#endif
+
+// longer App Identifiers cannot be cached
+#ifndef ANCS_CLIENT_APP_IDENTIFIER_MAX_LEN
+#define ANCS_CLIENT_APP_IDENTIFIER_MAX_LEN 48
+#endif
+
+// cached App Display Names get truncated
+#ifndef ANCS_CLIENT_DISPLAY_NAME_MAX_LEN
+#define ANCS_CLIENT_DISPLAY_NAME_MAX_LEN 32
+#endif
+
+#define ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES 0
+#define ANCS_COMMAND_ID_GET_APP_ATTRIBUTES          1
+
+#define ANCS_EVENT_ID_NOTIFICATION_REMOVED          2
+
+#define ANCS_NOTIFICATION_ATTRIBUTE_ID_APP_IDENTIFIER 0
+#define ANCS_APP_ATTRIBUTE_ID_DISPLAY_NAME            0
+
+// AppIdentifier, Title, Subtitle, Message, MessageSize, Date
+#define ANCS_NOTIFICATION_ATTRIBUTES_REQUESTED 6
+// DisplayName
+#define ANCS_APP_ATTRIBUTES_REQUESTED          1
+
 // ancs_client.h Start
 typedef enum ancs_chunk_parser_state {
+    W4_COMMAND_ID,
+    W4_NOTIFICATION_UID,
+    W4_APP_IDENTIFIER,
     W4_ATTRIBUTE_ID,
     W4_ATTRIBUTE_LEN,
     W4_ATTRIBUTE_COMPLETE,
 } ancs_chunk_parser_state_t;
 
+typedef enum {
+    ANCS_REQUEST_W4_WRITE,
+    ANCS_REQUEST_W4_WRITE_COMPLETE,
+    ANCS_REQUEST_W4_RESPONSE,
+    ANCS_REQUEST_DONE,
+} ancs_request_state_t;
+
+typedef struct {
+    ancs_request_state_t state;
+    uint8_t  command_id;
+    uint32_t notification_uid;
+    // only used for Get App Attributes
+    char     app_identifier[ANCS_CLIENT_APP_IDENTIFIER_MAX_LEN + 1];
+} ancs_request_t;
+
+typedef struct {
+    char     app_identifier[ANCS_CLIENT_APP_IDENTIFIER_MAX_LEN + 1];
+    char     display_name[ANCS_CLIENT_DISPLAY_NAME_MAX_LEN + 1];
+    uint32_t last_used;
+} ancs_app_cache_entry_t;
+
 typedef enum {
     TC_IDLE,
     TC_W4_ENCRYPTED_CONNECTION,
@@ -90,6 +147,19 @@ static uint16_t ancs_bytes_received;
 static uint16_t ancs_bytes_needed;
 static uint8_t  ancs_attribute_id;
 static uint16_t ancs_attribute_len;
+static uint8_t  ancs_command_id;
+static uint8_t  ancs_attributes_remaining;
+static char     ancs_app_identifier[ANCS_CLIENT_APP_IDENTIFIER_MAX_LEN + 1];
+static bool     ancs_app_identifier_valid;
+
+// requests are written in order and iOS answers them in order on the Data Source
+static ancs_request_t ancs_requests[ANCS_CLIENT_REQUEST_QUEUE_SIZE];
+static uint8_t  ancs_requests_head;
+static uint8_t  ancs_requests_count;
+static uint8_t  ancs_control_point_buffer[ANCS_CLIENT_APP_IDENTIFIER_MAX_LEN + 3];
+
+static ancs_app_cache_entry_t ancs_app_cache[ANCS_CLIENT_APP_CACHE_SIZE];
+static uint32_t ancs_app_cache_counter;
 
 static btstack_packet_handler_t client_handler;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
@@ -112,6 +182,23 @@ static void notify_client_text(int event_type){
     (*client_handler)(HCI_EVENT_PACKET, 0, event, event[1] + 2);
 }
 
+static void notify_client_display_name(uint32_t notification_uid, const char * display_name){
+    if (!client_handler) return;
+    uint16_t len = (uint16_t) strlen(display_name);
+    if (len > ANCS_CLIENT_DISPLAY_NAME_MAX_LEN){
+        len = ANCS_CLIENT_DISPLAY_NAME_MAX_LEN;
+    }
+    uint8_t event[9 + ANCS_CLIENT_DISPLAY_NAME_MAX_LEN + 1];
+    event[0] = HCI_EVENT_ANCS_META;
+    event[1] = 7 + len;
+    event[2] = ANCS_SUBEVENT_CLIENT_APP_DISPLAY_NAME;
+    little_endian_store_16(event, 3, gc_handle);
+    little_endian_store_32(event, 5, notification_uid);
+    (void)memcpy(&event[9], display_name, len);
+    event[9+len] = 0;
+    (*client_handler)(HCI_EVENT_PACKET, 0, event, event[1] + 2);
+}
+
 static void notify_client_simple(int event_type){
     if (!client_handler) return;
     uint8_t event[5];
@@ -123,9 +210,147 @@ static void notify_client_simple(int event_type){
 }
 
 static void ancs_chunk_parser_init(void){
-    chunk_parser_state = W4_ATTRIBUTE_ID;
+    chunk_parser_state = W4_COMMAND_ID;
     ancs_bytes_received = 0;
-    ancs_bytes_needed = 6;
+    ancs_bytes_needed = 1;
+}
+
+static void ancs_string_copy(char * dest, uint16_t dest_size, const char * src){
+    uint16_t len = (uint16_t) strlen(src);
+    if (len >= dest_size){
+        len = dest_size - 1u;
+    }
+    (void)memcpy(dest, src, len);
+    dest[len] = 0;
+}
+
+static const char * ancs_app_cache_lookup(const char * app_identifier){
+    int i;
+    for (i = 0; i < ANCS_CLIENT_APP_CACHE_SIZE; i++){
+        ancs_app_cache_entry_t * entry = &ancs_app_cache[i];
+        if (entry->last_used == 0u) continue;
+        if (strcmp(entry->app_identifier, app_identifier) != 0) continue;
+        entry->last_used = ++ancs_app_cache_counter;
+        return entry->display_name;
+    }
+    return NULL;
+}
+
+static void ancs_app_cache_store(const char * app_identifier, const char * display_name){
+    // replace entry for same app, otherwise least recently used one
+    ancs_app_cache_entry_t * victim = &ancs_app_cache[0];
+    int i;
+    for (i = 0; i < ANCS_CLIENT_APP_CACHE_SIZE; i++){
+        ancs_app_cache_entry_t * entry = &ancs_app_cache[i];
+        if ((entry->last_used != 0u) && (strcmp(entry->app_identifier, app_identifier) == 0)){
+            victim = entry;
+            break;
+        }
+        if (entry->last_used < victim->last_used){
+            victim = entry;
+        }
+    }
+    ancs_string_copy(victim->app_identifier, sizeof(victim->app_identifier), app_identifier);
+    ancs_string_copy(victim->display_name, sizeof(victim->display_name), display_name);
+    victim->last_used = ++ancs_app_cache_counter;
+}
+
+static void ancs_requests_reset(void){
+    ancs_requests_head  = 0;
+    ancs_requests_count = 0;
+}
+
+static ancs_request_t * ancs_requests_add(uint8_t command_id, uint32_t notification_uid){
+    if (ancs_requests_count >= ANCS_CLIENT_REQUEST_QUEUE_SIZE){
+        log_info("Request queue full, drop request for UID %04x", (int) notification_uid);
+        return NULL;
+    }
+    ancs_request_t * request = &ancs_requests[(ancs_requests_head + ancs_requests_count) % ANCS_CLIENT_REQUEST_QUEUE_SIZE];
+    ancs_requests_count++;
+    request->state = ANCS_REQUEST_W4_WRITE;
+    request->command_id = command_id;
+    request->notification_uid = notification_uid;
+    request->app_identifier[0] = 0;
+    return request;
+}
+
+static ancs_request_t * ancs_requests_find(ancs_request_state_t state){
+    uint8_t i;
+    for (i = 0; i < ancs_requests_count; i++){
+        ancs_request_t * request = &ancs_requests[(ancs_requests_head + i) % ANCS_CLIENT_REQUEST_QUEUE_SIZE];
+        if (request->state == state) return request;
+    }
+    return NULL;
+}
+
+static void ancs_requests_drop_completed(void){
+    while ((ancs_requests_count > 0u) && (ancs_requests[ancs_requests_head].state == ANCS_REQUEST_DONE)){
+        ancs_requests_head = (ancs_requests_head + 1u) % ANCS_CLIENT_REQUEST_QUEUE_SIZE;
+        ancs_requests_count--;
+    }
+}
+
+static void ancs_requests_run(void);
+static bool ancs_requests_app_in_flight(const char * app_identifier);
+static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+static void ancs_handle_response_complete(void){
+    // responses arrive in the order requests have been written
+    ancs_request_t * request = ancs_requests_find(ANCS_REQUEST_W4_RESPONSE);
+    if (request == NULL) return;
+    request->state = ANCS_REQUEST_DONE;
+    ancs_requests_drop_completed();
+
+    if ((ancs_command_id == ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES) && ancs_app_identifier_valid){
+        const char * display_name = ancs_app_cache_lookup(ancs_app_identifier);
+        if (display_name != NULL){
+            notify_client_display_name(ancs_notification_uid, display_name);
+        } else {
+            request = ancs_requests_add(ANCS_COMMAND_ID_GET_APP_ATTRIBUTES, ancs_notification_uid);
+            if (request != NULL){
+                ancs_string_copy(request->app_identifier, sizeof(request->app_identifier), ancs_app_identifier);
+            }
+        }
+    }
+    ancs_requests_run();
+}
+
+static void ancs_start_attribute(uint8_t attributes){
+    ancs_attributes_remaining = attributes;
+    ancs_bytes_received = 0;
+    ancs_bytes_needed   = 1;
+    chunk_parser_state  = W4_ATTRIBUTE_ID;
+}
+
+static void ancs_handle_attribute_complete(void){
+    // bytes beyond the buffer have been dropped
+    if (ancs_attribute_len >= sizeof(ancs_notification_buffer)){
+        ancs_attribute_len = sizeof(ancs_notification_buffer) - 1u;
+    }
+    ancs_notification_buffer[ancs_attribute_len] = 0;
+    if (ancs_command_id == ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES){
+        if (ancs_attribute_len > 0u){
+            notify_client_text(ANCS_SUBEVENT_CLIENT_NOTIFICATION);
+        }
+    } else if (ancs_attribute_id == ANCS_APP_ATTRIBUTE_ID_DISPLAY_NAME){
+        ancs_request_t * request = ancs_requests_find(ANCS_REQUEST_W4_RESPONSE);
+        if (ancs_app_identifier_valid){
+            ancs_app_cache_store(ancs_app_identifier, (const char *) ancs_notification_buffer);
+        }
+        if (request != NULL){
+            const char * display_name = ancs_app_identifier_valid ? ancs_app_cache_lookup(ancs_app_identifier) : (const char *) ancs_notification_buffer;
+            notify_client_display_name(request->notification_uid, display_name);
+        }
+    }
+    if (ancs_attributes_remaining > 0u){
+        ancs_attributes_remaining--;
+    }
+    if (ancs_attributes_remaining == 0u){
+        ancs_chunk_parser_init();
+        ancs_handle_response_complete();
+    } else {
+        ancs_start_attribute(ancs_attributes_remaining);
+    }
 }
 
 const char * ancs_client_attribute_name_for_id(int id){
@@ -144,35 +369,141 @@ const char * ancs_client_attribute_name_for_id(int id){
     return ancs_attribute_names[id];
 }
 
+// responses may be split across several Data Source notifications, so bytes are processed one by one
 static void ancs_chunk_parser_handle_byte(uint8_t data){
-    ancs_notification_buffer[ancs_bytes_received++] = data;
+    if (ancs_bytes_received < (sizeof(ancs_notification_buffer) - 1u)){
+        ancs_notification_buffer[ancs_bytes_received] = data;
+    }
+    ancs_bytes_received++;
+    if (chunk_parser_state == W4_APP_IDENTIFIER){
+        if (data != 0u) return;
+        ancs_app_identifier_valid = ancs_bytes_received <= sizeof(ancs_app_identifier);
+        if (ancs_app_identifier_valid){
+            (void)memcpy(ancs_app_identifier, ancs_notification_buffer, ancs_bytes_received);
+        }
+        ancs_start_attribute(ANCS_APP_ATTRIBUTES_REQUESTED);
+        return;
+    }
     if (ancs_bytes_received < ancs_bytes_needed) return;
     switch (chunk_parser_state){
+        case W4_COMMAND_ID:
+            ancs_command_id = data;
+            ancs_bytes_received = 0;
+            switch (ancs_command_id){
+                case ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES:
+                    ancs_app_identifier_valid = false;
+                    ancs_bytes_needed   = 4;
+                    chunk_parser_state  = W4_NOTIFICATION_UID;
+                    break;
+                case ANCS_COMMAND_ID_GET_APP_ATTRIBUTES:
+                    chunk_parser_state  = W4_APP_IDENTIFIER;
+                    break;
+                default:
+                    log_info("Unknown Command ID %u in Data Source", ancs_command_id);
+                    break;
+            }
+            break;
+        case W4_NOTIFICATION_UID:
+            ancs_notification_uid = little_endian_read_32(ancs_notification_buffer, 0);
+            ancs_start_attribute(ANCS_NOTIFICATION_ATTRIBUTES_REQUESTED);
+            break;
         case W4_ATTRIBUTE_ID:
-            ancs_attribute_id   = ancs_notification_buffer[ancs_bytes_received-1];
+            ancs_attribute_id   = data;
             ancs_bytes_received = 0;
             ancs_bytes_needed   = 2;
             chunk_parser_state  = W4_ATTRIBUTE_LEN;
             break;
         case W4_ATTRIBUTE_LEN:
-            ancs_attribute_len  = little_endian_read_16(ancs_notification_buffer, ancs_bytes_received-2);
+            ancs_attribute_len  = little_endian_read_16(ancs_notification_buffer, 0);
             ancs_bytes_received = 0;
             ancs_bytes_needed   = ancs_attribute_len;
             if (ancs_attribute_len == 0) {
-                ancs_bytes_needed   = 1;
-                chunk_parser_state  = W4_ATTRIBUTE_ID;
+                ancs_handle_attribute_complete();
                 break;
             }
             chunk_parser_state  = W4_ATTRIBUTE_COMPLETE;
             break;
         case W4_ATTRIBUTE_COMPLETE:
-            ancs_notification_buffer[ancs_bytes_received] = 0;
-            notify_client_text(ANCS_SUBEVENT_CLIENT_NOTIFICATION);
-            ancs_bytes_received = 0;
-            ancs_bytes_needed   = 1;
-            chunk_parser_state  = W4_ATTRIBUTE_ID;
+            if ((ancs_command_id == ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES) && (ancs_attribute_id == ANCS_NOTIFICATION_ATTRIBUTE_ID_APP_IDENTIFIER)){
+                ancs_app_identifier_valid = ancs_attribute_len < sizeof(ancs_app_identifier);
+                if (ancs_app_identifier_valid){
+                    (void)memcpy(ancs_app_identifier, ancs_notification_buffer, ancs_attribute_len);
+                    ancs_app_identifier[ancs_attribute_len] = 0;
+                }
+            }
+            ancs_handle_attribute_complete();
             break;
+        default:
+            break;
+    }
+}
+
+static bool ancs_requests_app_in_flight(const char * app_identifier){
+    uint8_t i;
+    for (i = 0; i < ancs_requests_count; i++){
+        const ancs_request_t * request = &ancs_requests[(ancs_requests_head + i) % ANCS_CLIENT_REQUEST_QUEUE_SIZE];
+        if (request->command_id != ANCS_COMMAND_ID_GET_APP_ATTRIBUTES) continue;
+        if ((request->state != ANCS_REQUEST_W4_WRITE_COMPLETE) && (request->state != ANCS_REQUEST_W4_RESPONSE)) continue;
+        if (strcmp(request->app_identifier, app_identifier) == 0) return true;
     }
+    return false;
+}
+
+static void ancs_requests_run(void){
+    while (true){
+        // at most one write on the Control Point at a time, next one is sent as soon as it completes
+        if (ancs_requests_find(ANCS_REQUEST_W4_WRITE_COMPLETE) != NULL) return;
+        ancs_request_t * request = ancs_requests_find(ANCS_REQUEST_W4_WRITE);
+        if (request == NULL) return;
+
+        uint16_t len;
+        if (request->command_id == ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES){
+            static const uint8_t get_notification_attributes[] = {ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES, 0,0,0,0,  0,  1,32,0,  2,32,0, 3,32,0, 4, 5};
+            (void)memcpy(ancs_control_point_buffer, get_notification_attributes, sizeof(get_notification_attributes));
+            little_endian_store_32(ancs_control_point_buffer, 1, request->notification_uid);
+            len = sizeof(get_notification_attributes);
+        } else {
+            // App Display Name may have been fetched in the meantime
+            const char * display_name = ancs_app_cache_lookup(request->app_identifier);
+            if (display_name != NULL){
+                request->state = ANCS_REQUEST_DONE;
+                ancs_requests_drop_completed();
+                notify_client_display_name(request->notification_uid, display_name);
+                continue;
+            }
+            // wait for Display Name of same app requested before, keeps requests in order
+            if (ancs_requests_app_in_flight(request->app_identifier)) return;
+            uint16_t app_identifier_len = (uint16_t) strlen(request->app_identifier);
+            ancs_control_point_buffer[0] = ANCS_COMMAND_ID_GET_APP_ATTRIBUTES;
+            (void)memcpy(&ancs_control_point_buffer[1], request->app_identifier, app_identifier_len + 1u);
+            ancs_control_point_buffer[2 + app_identifier_len] = ANCS_APP_ATTRIBUTE_ID_DISPLAY_NAME;
+            len = 3 + app_identifier_len;
+        }
+
+        uint8_t status = gatt_client_write_value_of_characteristic(handle_hci_event, gc_handle,
+            ancs_control_point_characteristic.value_handle, len, ancs_control_point_buffer);
+        if (status == ERROR_CODE_SUCCESS){
+            request->state = ANCS_REQUEST_W4_WRITE_COMPLETE;
+            return;
+        }
+        log_info("Control Point write failed, status 0x%02x", status);
+        request->state = ANCS_REQUEST_DONE;
+        ancs_requests_drop_completed();
+    }
+}
+
+static void ancs_handle_write_complete(uint8_t att_status){
+    ancs_request_t * request = ancs_requests_find(ANCS_REQUEST_W4_WRITE_COMPLETE);
+    if (request == NULL) return;
+    if (att_status == ATT_ERROR_SUCCESS){
+        request->state = ANCS_REQUEST_W4_RESPONSE;
+    } else {
+        // e.g. unknown Notification UID, no response on Data Source
+        log_info("Control Point write for UID %04x failed, ATT status 0x%02x", (int) request->notification_uid, att_status);
+        request->state = ANCS_REQUEST_DONE;
+        ancs_requests_drop_completed();
+    }
+    ancs_requests_run();
 }
 
 static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
@@ -226,6 +557,7 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
             }
             tc_state = TC_IDLE;
             gc_handle = 0;
+            ancs_requests_reset();
             return;
 
         default:
@@ -311,6 +643,8 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
                 case GATT_EVENT_QUERY_COMPLETE:
                     log_info("ANCS Data Source subscribed");
                     tc_state = TC_SUBSCRIBED;
+                    ancs_requests_reset();
+                    ancs_chunk_parser_init();
                     notify_client_simple(ANCS_SUBEVENT_CLIENT_CONNECTED);
                     break;
                 default:
@@ -318,6 +652,10 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
             }
             break;
         case TC_SUBSCRIBED:
+            if (hci_event_packet_get_type(packet) == GATT_EVENT_QUERY_COMPLETE){
+                ancs_handle_write_complete(gatt_event_query_complete_get_att_status(packet));
+                break;
+            }
             if ((hci_event_packet_get_type(packet) != GATT_EVENT_NOTIFICATION) && (hci_event_packet_get_type(packet) != GATT_EVENT_INDICATION) ) break;
 
             value_handle = little_endian_read_16(packet, 4);
@@ -332,15 +670,14 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
                     ancs_chunk_parser_handle_byte(value[i]);
                 }
             } else if (value_handle == ancs_notification_source_characteristic.value_handle){
-                ancs_notification_uid = little_endian_read_32(value, 4);
+                uint32_t notification_uid = little_endian_read_32(value, 4);
                 log_info("Notification received: EventID %02x, EventFlags %02x, CategoryID %02x, CategoryCount %u, UID %04x",
-                    value[0], value[1], value[2], value[3], (int) ancs_notification_uid);
-                static uint8_t get_notification_attributes[] = {0, 0,0,0,0,  0,  1,32,0,  2,32,0, 3,32,0, 4, 5};
-                little_endian_store_32(get_notification_attributes, 1, ancs_notification_uid);
-                ancs_notification_uid = 0;
-                ancs_chunk_parser_init();
-                gatt_client_write_value_of_characteristic(handle_hci_event, gc_handle, ancs_control_point_characteristic.value_handle, 
-                    sizeof(get_notification_attributes), get_notification_attributes);
+                    value[0], value[1], value[2], value[3], (int) notification_uid);
+                // nothing to fetch for removed notifications
+                if (value[0] == ANCS_EVENT_ID_NOTIFICATION_REMOVED) break;
+                // queue request, data source responses for earlier ones are parsed meanwhile
+                (void) ancs_requests_add(ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES, notification_uid);
+                ancs_requests_run();
             } else {
                 log_info("Unknown Source: ");
                 log_info_hexdump(value , value_length);
@@ -39,6 +39,8 @@
 
 #include <string.h>
 
+#include "btstack_config.h"
+
 #include "ble/att_db.h"
 #include "ble/core.h"
 #include "bluetooth.h"
@@ -85,6 +87,13 @@ typedef struct att_iterator {
     uint8_t  const * uuid;
     uint16_t value_len;
     uint8_t  const * value;
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+    // private: iterate over handles from uuid16 index
+    bool     index_active;
+    uint8_t const * index_ptr;
+    uint16_t index_remaining;
+    uint16_t index_entry_size;
+#endif
 } att_iterator_t;
 
 static void att_persistent_ccc_cache(att_iterator_t * it);
@@ -93,14 +102,61 @@ static uint8_t const * att_db = NULL;
 static att_read_callback_t  att_read_callback  = NULL;
 static att_write_callback_t att_write_callback = NULL;
 static int      att_prepare_write_error_code   = 0;
+#ifdef ENABLE_ATT_DB_INLINE_VALUES
+// writable att_db provided by att_set_db_inline_values
+static uint8_t * att_db_inline_values;
+static att_value_changed_callback_t att_value_changed_callback;
+#endif
 static uint16_t att_prepare_write_error_handle = 0x0000;
 
 // single cache for att_is_persistent_ccc - stores flags before write callback
 static uint16_t att_persistent_ccc_handle;
 static uint16_t att_persistent_ccc_uuid16;
 
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+// attribute handles >= ATT_DB_HANDLE_INDEX_SIZE are found by linear search
+#ifndef ATT_DB_HANDLE_INDEX_SIZE
+#define ATT_DB_HANDLE_INDEX_SIZE 256
+#endif
+// offset + 1 of attribute in att_db by handle, 0 = not indexed
+static uint16_t att_db_handle_index[ATT_DB_HANDLE_INDEX_SIZE];
+// range queries can only start in the middle if handles are ascending
+static bool     att_db_handle_index_sorted;
+#endif
+
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+#define ATT_DB_UUID16_INDEX_VERSION 2
+// offset of attribute not stored in uuid16 index
+#define ATT_DB_UUID16_INDEX_NO_OFFSET 0xffffu
+static uint8_t const * att_db_uuid16_index;
+#endif
+
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+static void att_iterator_fetch_next_from_uuid16_index(att_iterator_t *it);
+#endif
+
 static void att_iterator_init(att_iterator_t *it){
     it->att_ptr = att_db;
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+    it->index_active = false;
+#endif
+}
+
+// start iteration at first attribute with handle >= start_handle if possible, else at start of att db
+static void att_iterator_init_from_handle(att_iterator_t *it, uint16_t start_handle){
+    att_iterator_init(it);
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+    if (!att_db_handle_index_sorted) return;
+    uint32_t handle;
+    for (handle = start_handle; handle < ATT_DB_HANDLE_INDEX_SIZE; handle++){
+        uint16_t entry = att_db_handle_index[handle];
+        if (entry == 0) continue;
+        it->att_ptr = &att_db[entry - 1];
+        return;
+    }
+#else
+    UNUSED(start_handle);
+#endif
 }
 
 static bool att_iterator_has_next(att_iterator_t *it){
@@ -108,6 +164,12 @@ static bool att_iterator_has_next(att_iterator_t *it){
 }
 
 static void att_iterator_fetch_next(att_iterator_t *it){
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+    if (it->index_active){
+        att_iterator_fetch_next_from_uuid16_index(it);
+        return;
+    }
+#endif
     it->size   = little_endian_read_16(it->att_ptr, 0);
     if (it->size == 0){
         it->flags = 0;
@@ -161,6 +223,18 @@ static int att_iterator_match_uuid(att_iterator_t *it, uint8_t *uuid, uint16_t u
 static int att_find_handle(att_iterator_t *it, uint16_t handle){
     if (handle == 0) return 0;
     att_iterator_init(it);
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+    if (handle < ATT_DB_HANDLE_INDEX_SIZE){
+        uint16_t entry = att_db_handle_index[handle];
+        if (entry != 0){
+            it->att_ptr = &att_db[entry - 1];
+            att_iterator_fetch_next(it);
+            if (it->handle == handle) return 1;
+        }
+    }
+    // not indexed or att db was modified after att_set_db
+    att_iterator_init(it);
+#endif
     while (att_iterator_has_next(it)){
         att_iterator_fetch_next(it);
         if (it->handle != handle) continue;
@@ -169,6 +243,100 @@ static int att_find_handle(att_iterator_t *it, uint16_t handle){
     return 0;
 }
 
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+static uint16_t att_uuid16_index_entry_size(uint16_t uuid16){
+    // entries store handle and offset in att db, service declarations also store the end handle
+    bool is_service = (uuid16 == GATT_PRIMARY_SERVICE_UUID) || (uuid16 == GATT_SECONDARY_SERVICE_UUID);
+    return is_service ? 6 : 4;
+}
+
+// fetch attribute for uuid16 index entry from stored offset, falls back to att_find_handle
+static int att_uuid16_index_fetch(att_iterator_t *it, uint8_t const * entry){
+    uint16_t handle = little_endian_read_16(entry, 0);
+    uint16_t offset = little_endian_read_16(entry, 2);
+    if (offset != ATT_DB_UUID16_INDEX_NO_OFFSET){
+        att_iterator_init(it);
+        it->att_ptr = &att_db[offset];
+        att_iterator_fetch_next(it);
+        if (it->handle == handle) return 1;
+    }
+    return att_find_handle(it, handle);
+}
+
+// @returns true if uuid16 index is available and provides list of entries for uuid16, which might be empty
+static bool att_uuid16_index_lookup(uint16_t uuid16, uint8_t const ** entries, uint16_t * num_entries){
+    if (att_db_uuid16_index == NULL) return false;
+    *entries = NULL;
+    *num_entries = 0;
+    uint8_t const * index_ptr = &att_db_uuid16_index[1];
+    while (true){
+        uint16_t index_uuid16 = little_endian_read_16(index_ptr, 0);
+        // end of index or not found, uuids are sorted
+        if ((index_uuid16 == 0) || (index_uuid16 > uuid16)) break;
+        uint16_t count = little_endian_read_16(index_ptr, 2);
+        if (index_uuid16 == uuid16){
+            *entries = &index_ptr[4];
+            *num_entries = count;
+            break;
+        }
+        index_ptr += 4 + (count * att_uuid16_index_entry_size(index_uuid16));
+    }
+    return true;
+}
+
+static void att_iterator_fetch_next_from_uuid16_index(att_iterator_t *it){
+    while (it->index_remaining > 0){
+        uint8_t const * entry = it->index_ptr;
+        it->index_ptr += it->index_entry_size;
+        it->index_remaining--;
+        att_iterator_t found;
+        if (att_uuid16_index_fetch(&found, entry) == 0) continue;
+        it->size      = found.size;
+        it->flags     = found.flags;
+        it->handle    = found.handle;
+        it->uuid      = found.uuid;
+        it->value_len = found.value_len;
+        it->value     = found.value;
+        return;
+    }
+    // end of list, set up like end of att db
+    it->size = 0;
+    it->flags = 0;
+    it->handle = 0;
+    it->uuid = NULL;
+    it->value_len = 0;
+    it->value = NULL;
+    it->att_ptr = NULL;
+}
+#endif
+
+// iterate over attributes that might match attribute type starting at start_handle, uses uuid16 index if available
+static void att_iterator_init_for_uuid(att_iterator_t *it, uint16_t start_handle, uint16_t uuid_len, uint8_t * uuid){
+    att_iterator_init_from_handle(it, start_handle);
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+    uint16_t uuid16 = uuid16_from_uuid(uuid_len, uuid);
+    if (uuid16 == 0) return;
+    uint8_t const * entries;
+    uint16_t num_entries;
+    if (att_uuid16_index_lookup(uuid16, &entries, &num_entries) == false) return;
+    uint16_t entry_size = att_uuid16_index_entry_size(uuid16);
+    // skip handles before start handle
+    while ((num_entries > 0) && (little_endian_read_16(entries, 0) < start_handle)){
+        entries += entry_size;
+        num_entries--;
+    }
+    it->index_active     = true;
+    it->index_ptr        = entries;
+    it->index_remaining  = num_entries;
+    it->index_entry_size = entry_size;
+    // att_ptr stays valid until end of list is reached
+    it->att_ptr = att_db;
+#else
+    UNUSED(uuid_len);
+    UNUSED(uuid);
+#endif
+}
+
 // experimental client API
 uint16_t att_uuid_for_handle(uint16_t attribute_handle){
     att_iterator_t it;
@@ -202,6 +370,28 @@ static int att_copy_value(att_iterator_t *it, uint16_t offset, uint8_t * buffer,
     return bytes_to_copy;
 }
 
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+static void att_db_handle_index_build(void){
+    (void)memset(att_db_handle_index, 0, sizeof(att_db_handle_index));
+    att_db_handle_index_sorted = true;
+    uint16_t prev_handle = 0;
+    att_iterator_t it;
+    att_iterator_init(&it);
+    while (att_iterator_has_next(&it)){
+        uintptr_t offset = (uintptr_t) (it.att_ptr - att_db);
+        att_iterator_fetch_next(&it);
+        if (it.handle == 0) break;
+        if (it.handle <= prev_handle){
+            att_db_handle_index_sorted = false;
+        }
+        prev_handle = it.handle;
+        if (it.handle >= ATT_DB_HANDLE_INDEX_SIZE) continue;
+        if (offset >= 0xffffu) continue;
+        att_db_handle_index[it.handle] = (uint16_t) (offset + 1u);
+    }
+}
+#endif
+
 void att_set_db(uint8_t const * db){
     // validate db version
     if (db == NULL) return;
@@ -210,8 +400,26 @@ void att_set_db(uint8_t const * db){
         return;
     }
     att_db = db;
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+    att_db_handle_index_build();
+#endif
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+    att_db_uuid16_index = NULL;
+#endif
 }
 
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+void att_set_db_uuid16_index(uint8_t const * index){
+    att_db_uuid16_index = NULL;
+    if (index == NULL) return;
+    if (index[0] != ATT_DB_UUID16_INDEX_VERSION){
+        log_error("ATT DB UUID16 index version differs, please regenerate .h from .gatt file");
+        return;
+    }
+    att_db_uuid16_index = index;
+}
+#endif
+
 void att_set_read_callback(att_read_callback_t callback){
     att_read_callback = callback;
 }
@@ -220,6 +428,25 @@ void att_set_write_callback(att_write_callback_t callback){
     att_write_callback = callback;
 }
 
+#ifdef ENABLE_ATT_DB_INLINE_VALUES
+static uint8_t * att_inline_value_for_attribute(const att_iterator_t * it);
+
+void att_set_db_inline_values(uint8_t * db, att_value_changed_callback_t callback){
+    att_db_inline_values = db;
+    att_value_changed_callback = callback;
+}
+
+bool att_set_inline_value(uint16_t attribute_handle, const uint8_t * value, uint16_t value_len){
+    att_iterator_t it;
+    if (att_find_handle(&it, attribute_handle) == 0) return false;
+    uint8_t * inline_value = att_inline_value_for_attribute(&it);
+    if (inline_value == NULL) return false;
+    if (value_len != it.value_len) return false;
+    (void)memcpy(inline_value, value, value_len);
+    return true;
+}
+#endif
+
 void att_dump_attributes(void){
     att_iterator_t it;
     att_iterator_init(&it);
@@ -396,7 +623,7 @@ static uint16_t handle_find_information_request2(att_connection_t * att_connecti
     uint16_t uuid_len = 0;
     
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_from_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (!it.handle) break;
@@ -489,7 +716,7 @@ static uint16_t handle_find_by_type_value_request(att_connection_t * att_connect
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_from_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
 
@@ -550,7 +777,7 @@ static uint16_t handle_read_by_type_request2(att_connection_t * att_connection,
     uint16_t pair_len = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_for_uuid(&it, start_handle, attribute_type_len, attribute_type);
     uint8_t error_code = 0;
     uint16_t first_matching_but_unreadable_handle = 0;
 
@@ -758,10 +985,11 @@ static uint16_t handle_read_blob_request(att_connection_t * att_connection, uint
 
 //
 // MARK: ATT_READ_MULTIPLE_REQUEST 0x0e
+// MARK: ATT_READ_MULTIPLE_VARIABLE_REQUEST 0x20
 //
-static uint16_t handle_read_multiple_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size, uint16_t num_handles, uint8_t * handles){
-    log_info("ATT_READ_MULTIPLE_REQUEST: num handles %u", num_handles);
-    uint8_t request_type = ATT_READ_MULTIPLE_REQUEST;
+static uint16_t handle_read_multiple_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size, uint16_t num_handles, uint8_t * handles, bool store_length){
+    log_info("ATT_READ_MULTIPLE_(VARIABLE_)REQUEST: num handles %u", num_handles);
+    uint8_t request_type = store_length ? ATT_READ_MULTIPLE_VARIABLE_REQUEST : ATT_READ_MULTIPLE_REQUEST;
     
     // TODO: figure out which error to respond with
     // if (num_handles < 2){
@@ -811,6 +1039,13 @@ static uint16_t handle_read_multiple_request2(att_connection_t * att_connection,
         if (read_request_pending) continue;
 #endif
 
+        // store length of complete value, value might get truncated
+        if (store_length){
+            if ((offset + 2) > response_buffer_size) break;
+            little_endian_store_16(response_buffer, offset, it.value_len);
+            offset += 2;
+        }
+
         // store
         uint16_t bytes_copied = att_copy_value(&it, 0, response_buffer + offset, response_buffer_size - offset, att_connection->con_handle);
         offset += bytes_copied;
@@ -820,7 +1055,7 @@ static uint16_t handle_read_multiple_request2(att_connection_t * att_connection,
         return setup_error(response_buffer, request_type, handle, error_code);
     }
     
-    response_buffer[0] = ATT_READ_MULTIPLE_RESPONSE;
+    response_buffer[0] = store_length ? ATT_READ_MULTIPLE_VARIABLE_RESPONSE : ATT_READ_MULTIPLE_RESPONSE;
     return offset;
 }
 static uint16_t handle_read_multiple_request(att_connection_t * att_connection, uint8_t * request_buffer,  uint16_t request_len,
@@ -828,10 +1063,11 @@ static uint16_t handle_read_multiple_request(att_connection_t * att_connection,
 
     // 1 byte opcode + two or more attribute handles (2 bytes each)
     if ( (request_len < 5) || ((request_len & 1) == 0) ) return setup_error_invalid_pdu(response_buffer,
-                                                                                        ATT_READ_MULTIPLE_REQUEST);
+                                                                                        request_buffer[0]);
 
     int num_handles = (request_len - 1) >> 1;
-    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1]);
+    bool store_length = request_buffer[0] == ATT_READ_MULTIPLE_VARIABLE_REQUEST;
+    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1], store_length);
 }
 
 //
@@ -850,6 +1086,63 @@ static uint16_t handle_read_multiple_request(att_connection_t * att_connection,
 //  confidential information, and therefore the Service and Characteristic Discovery procedures
 //  shall always be permitted. " 
 //
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+// same result as iterating over att db, uses precomputed list of service start and end handles instead
+static uint16_t att_read_by_group_type_from_uuid16_index(uint8_t * response_buffer, uint16_t response_buffer_size,
+                                                         uint16_t start_handle, uint16_t end_handle, uint8_t request_type,
+                                                         uint8_t const * groups, uint16_t num_groups){
+    uint16_t offset   = 1;
+    uint16_t pair_len = 0;
+    uint16_t i;
+    for (i = 0; i < num_groups; i++){
+        uint8_t const * group = &groups[i * 6];
+        uint16_t group_start_handle = little_endian_read_16(group, 0);
+        uint16_t group_end_handle   = little_endian_read_16(group, 4);
+        if (group_start_handle < start_handle) continue;
+        // like the att db walk, only report groups closed by next attribute within range or by end of att db
+        if (group_end_handle > end_handle) break;
+        att_iterator_t it;
+        if ((group_end_handle == end_handle) && att_find_handle(&it, group_end_handle + 1)) break;
+
+        if (att_uuid16_index_fetch(&it, group) == 0) break;
+
+        // check if value has same len as last one
+        uint16_t this_pair_len = 4 + it.value_len;
+        if (offset > 1){
+            if (this_pair_len != pair_len) {
+                break;
+            }
+        }
+
+        // first
+        if (offset == 1) {
+            pair_len = this_pair_len;
+            response_buffer[offset] = this_pair_len;
+            offset++;
+        }
+
+        little_endian_store_16(response_buffer, offset, group_start_handle);
+        offset += 2;
+        little_endian_store_16(response_buffer, offset, group_end_handle);
+        offset += 2;
+        (void)memcpy(response_buffer + offset, it.value, pair_len - 4);
+        offset += pair_len - 4;
+
+        // check if space for another handle pair available
+        if ((offset + pair_len) > response_buffer_size){
+            break;
+        }
+    }
+
+    if (offset == 1){
+        return setup_error_atribute_not_found(response_buffer, request_type, start_handle);
+    }
+
+    response_buffer[0] = ATT_READ_BY_GROUP_TYPE_RESPONSE;
+    return offset;
+}
+#endif
+
 static uint16_t handle_read_by_group_type_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size,
                                             uint16_t start_handle, uint16_t end_handle,
                                             uint16_t attribute_type_len, uint8_t * attribute_type){
@@ -870,6 +1163,14 @@ static uint16_t handle_read_by_group_type_request2(att_connection_t * att_connec
         return setup_error(response_buffer, request_type, start_handle, ATT_ERROR_UNSUPPORTED_GROUP_TYPE);
     }
 
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+    uint8_t const * groups;
+    uint16_t num_groups;
+    if (att_uuid16_index_lookup(uuid16, &groups, &num_groups)){
+        return att_read_by_group_type_from_uuid16_index(response_buffer, response_buffer_size, start_handle, end_handle, request_type, groups, num_groups);
+    }
+#endif
+
     uint16_t offset   = 1;
     uint16_t pair_len = 0;
     uint16_t in_group = 0;
@@ -878,7 +1179,7 @@ static uint16_t handle_read_by_group_type_request2(att_connection_t * att_connec
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_from_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         
@@ -963,6 +1264,27 @@ static uint16_t handle_read_by_group_type_request(att_connection_t * att_connect
     return handle_read_by_group_type_request2(att_connection, response_buffer, response_buffer_size, start_handle, end_handle, attribute_type_len, &request_buffer[5]);
 }
 
+#ifdef ENABLE_ATT_DB_INLINE_VALUES
+// returns writable value of attribute without ATT_PROPERTY_DYNAMIC if current db was provided by att_set_db_inline_values
+static uint8_t * att_inline_value_for_attribute(const att_iterator_t * it){
+    if (att_db_inline_values == NULL) return NULL;
+    // att_db skips version byte
+    if ((att_db_inline_values + 1) != att_db) return NULL;
+    if ((it->flags & ATT_PROPERTY_DYNAMIC) != 0) return NULL;
+    return att_db_inline_values + 1 + (it->value - att_db);
+}
+
+// inline values have the fixed length reserved in the database
+static int att_write_inline_value(hci_con_handle_t con_handle, const att_iterator_t * it, uint8_t * inline_value, const uint8_t * value, uint16_t value_len){
+    if (value_len != it->value_len) return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
+    (void)memcpy(inline_value, value, value_len);
+    if (att_value_changed_callback != NULL){
+        (*att_value_changed_callback)(con_handle, it->handle, inline_value, value_len);
+    }
+    return 0;
+}
+#endif
+
 //
 // MARK: ATT_WRITE_REQUEST 0x12
 static uint16_t handle_write_request(att_connection_t * att_connection, uint8_t * request_buffer,  uint16_t request_len,
@@ -980,10 +1302,24 @@ static uint16_t handle_write_request(att_connection_t * att_connection, uint8_t
     if (!ok) {
         return setup_error_invalid_handle(response_buffer, request_type, handle);
     }
-    if (att_write_callback == NULL) {
+    if ((it.flags & ATT_PROPERTY_WRITE) == 0) {
         return setup_error_write_not_permitted(response_buffer, request_type, handle);
     }
-    if ((it.flags & ATT_PROPERTY_WRITE) == 0) {
+#ifdef ENABLE_ATT_DB_INLINE_VALUES
+    uint8_t * inline_value = att_inline_value_for_attribute(&it);
+    if (inline_value != NULL){
+        int inline_error_code = att_validate_security(att_connection, ATT_WRITE, &it);
+        if (inline_error_code == 0){
+            inline_error_code = att_write_inline_value(att_connection->con_handle, &it, inline_value, request_buffer + 3, request_len - 3);
+        }
+        if (inline_error_code) {
+            return setup_error(response_buffer, request_type, handle, inline_error_code);
+        }
+        response_buffer[0] = ATT_WRITE_RESPONSE;
+        return 1;
+    }
+#endif
+    if (att_write_callback == NULL) {
         return setup_error_write_not_permitted(response_buffer, request_type, handle);
     }
     if ((it.flags & ATT_PROPERTY_DYNAMIC) == 0) {
@@ -1116,13 +1452,21 @@ static void handle_write_command(att_connection_t * att_connection, uint8_t * re
     if (request_len < 3) return;
 
     uint16_t handle = little_endian_read_16(request_buffer, 1);
-    if (att_write_callback == NULL) return;
 
     att_iterator_t it;
     int ok = att_find_handle(&it, handle);
     if (!ok) return;
-    if ((it.flags & ATT_PROPERTY_DYNAMIC) == 0) return;
     if ((it.flags & required_flags) == 0) return;
+#ifdef ENABLE_ATT_DB_INLINE_VALUES
+    uint8_t * inline_value = att_inline_value_for_attribute(&it);
+    if (inline_value != NULL){
+        if (att_validate_security(att_connection, ATT_WRITE, &it)) return;
+        (void) att_write_inline_value(att_connection->con_handle, &it, inline_value, request_buffer + 3, request_len - 3);
+        return;
+    }
+#endif
+    if (att_write_callback == NULL) return;
+    if ((it.flags & ATT_PROPERTY_DYNAMIC) == 0) return;
     if (att_validate_security(att_connection, ATT_WRITE, &it)) return;
     att_persistent_ccc_cache(&it);
     (*att_write_callback)(att_connection->con_handle, handle, ATT_TRANSACTION_MODE_NONE, 0, request_buffer + 3, request_len - 3);
@@ -1192,6 +1536,7 @@ uint16_t att_handle_request(att_connection_t * att_connection,
             response_len = handle_read_blob_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
             break;
         case ATT_READ_MULTIPLE_REQUEST:  
+        case ATT_READ_MULTIPLE_VARIABLE_REQUEST:
             response_len = handle_read_multiple_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
             break;
         case ATT_READ_BY_GROUP_TYPE_REQUEST:  
@@ -1259,7 +1604,7 @@ bool gatt_server_get_get_handle_range_for_service_with_uuid16(uint16_t uuid16, u
 // returns false if not found
 uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_from_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (it.handle && (it.handle < start_handle)) continue;
@@ -1272,7 +1617,7 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t st
 
 uint16_t gatt_server_get_descriptor_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t characteristic_uuid16, uint16_t descriptor_uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_from_handle(&it, start_handle);
     int characteristic_found = 0;
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
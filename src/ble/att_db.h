@@ -70,6 +70,8 @@ extern "C" {
 #define ATT_READ_MULTIPLE_RESPONSE      0x0f
 #define ATT_READ_BY_GROUP_TYPE_REQUEST  0x10
 #define ATT_READ_BY_GROUP_TYPE_RESPONSE 0x11
+#define ATT_READ_MULTIPLE_VARIABLE_REQUEST  0x20
+#define ATT_READ_MULTIPLE_VARIABLE_RESPONSE 0x21
 
 #define ATT_WRITE_REQUEST               0x12
 #define ATT_WRITE_RESPONSE              0x13
@@ -83,6 +85,8 @@ extern "C" {
 #define ATT_HANDLE_VALUE_INDICATION     0x1d
 #define ATT_HANDLE_VALUE_CONFIRMATION   0x1e
 
+#define ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION 0x23
+
 
 #define ATT_WRITE_COMMAND                0x52
 #define ATT_SIGNED_WRITE_COMMAND         0xD2
@@ -145,6 +149,13 @@ typedef uint16_t (*att_read_callback_t)(hci_con_handle_t con_handle, uint16_t at
 //
 typedef int (*att_write_callback_t)(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size);
 
+// ATT Value Changed Callback for attributes with inline value storage, see att_set_db_inline_values
+// @param con_handle of hci le connection
+// @param attribute_handle that was written
+// @param value stored in the database
+// @param value_len
+typedef void (*att_value_changed_callback_t)(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t * value, uint16_t value_len);
+
 // Read & Write Callbacks for handle range
 typedef struct att_service_handler {
     btstack_linked_item_t * item;
@@ -155,6 +166,12 @@ typedef struct att_service_handler {
     btstack_packet_handler_t packet_handler;
 } att_service_handler_t;
 
+// Read & Write Callbacks for a single dynamic attribute, see att_server_set_callback_slots
+typedef struct {
+    att_read_callback_t read_callback;
+    att_write_callback_t write_callback;
+} att_callback_slot_t;
+
 // MARK: ATT Operations
 
 /*
@@ -162,6 +179,36 @@ typedef struct att_service_handler {
  */
 void att_set_db(uint8_t const * db);
 
+#ifdef ENABLE_ATT_DB_UUID16_INDEX
+/*
+ * @brief set UUID16 index generated by compile_gatt.py --uuid16-index for the current ATT database
+ * @note att_set_db clears the index, call after att_set_db/att_server_init
+ * @param index or NULL to disable
+ */
+void att_set_db_uuid16_index(uint8_t const * index);
+#endif
+
+#ifdef ENABLE_ATT_DB_INLINE_VALUES
+/*
+ * @brief store values of attributes without ATT_PROPERTY_DYNAMIC in writable ATT database, e.g. created by att_db_util
+ * @note Write Requests and Write Commands to these attributes are stored directly in the database if ATT_PROPERTY_WRITE
+ *       or ATT_PROPERTY_WRITE_WITHOUT_RESPONSE is set and the value length matches. Prepared Writes are not supported.
+ * @note only active while db is the current ATT database, see att_set_db/att_server_init
+ * @param db same as passed to att_set_db/att_server_init or NULL to disable
+ * @param callback called after value was written by remote or NULL
+ */
+void att_set_db_inline_values(uint8_t * db, att_value_changed_callback_t callback);
+
+/*
+ * @brief update value of attribute with inline value storage
+ * @param attribute_handle
+ * @param value
+ * @param value_len has to match the length reserved in the database
+ * @returns true if value was updated
+ */
+bool att_set_inline_value(uint16_t attribute_handle, const uint8_t * value, uint16_t value_len);
+#endif
+
 /*
  * @brief set callback for read of dynamic attributes
  * @param callback
@@ -160,7 +160,12 @@ static void att_db_util_add_attribute_uuid16(uint16_t uuid16, uint16_t flags, ui
 	att_db_next_handle++;
 	little_endian_store_16(att_db, att_db_size, uuid16);
 	att_db_size += 2;
-	(void)memcpy(&att_db[att_db_size], data, data_len);
+	if (data != NULL){
+		(void)memcpy(&att_db[att_db_size], data, data_len);
+	} else {
+		// reserve zero-initialized value storage
+		(void)memset(&att_db[att_db_size], 0, data_len);
+	}
 	att_db_size += data_len;
 	att_db_util_set_end_tag();
 
@@ -184,7 +189,12 @@ static void att_db_util_add_attribute_uuid128(const uint8_t * uuid128, uint16_t
 	att_db_next_handle++;
 	reverse_128(uuid128, &att_db[att_db_size]);
 	att_db_size += 16;
-	(void)memcpy(&att_db[att_db_size], data, data_len);
+	if (data != NULL){
+		(void)memcpy(&att_db[att_db_size], data, data_len);
+	} else {
+		// reserve zero-initialized value storage
+		(void)memset(&att_db[att_db_size], 0, data_len);
+	}
 	att_db_size += data_len;
 	att_db_util_set_end_tag();
 }
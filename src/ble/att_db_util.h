@@ -102,11 +102,13 @@ uint16_t att_db_util_add_included_service_uuid16(uint16_t start_group_handle, ui
  * @param properties        - see ATT_PROPERTY_* in src/bluetooth.h
  * @param read_permissions  - see ATT_SECURITY_* in src/bluetooth.h
  * @param write_permissions - see ATT_SECURITY_* in src/bluetooth.h
- * @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified
+ * @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified, zero-initialized if NULL
  * @param data_len
  * @returns attribute handle of the new characteristic value declaration
  * @note If properties contains ATT_PROPERTY_NOTIFY or ATT_PROPERTY_INDICATE flags, a Client Configuration Characteristic Descriptor (CCCD)
  *       is created as well. The attribute value handle of the CCCD is the attribute value handle plus 1
+ * @note With ENABLE_ATT_DB_INLINE_VALUES and att_set_db_inline_values, data_len bytes are reserved as value storage
+ *       for writes if ATT_PROPERTY_DYNAMIC is not specified
  */
 uint16_t att_db_util_add_characteristic_uuid16(uint16_t uuid16, uint16_t properties, uint8_t read_permission, uint8_t write_permission, uint8_t * data, uint16_t data_len);
 
@@ -116,11 +118,13 @@ uint16_t att_db_util_add_characteristic_uuid16(uint16_t uuid16, uint16_t propert
  * @param properties        - see ATT_PROPERTY_* in src/bluetooth.h
  * @param read_permissions  - see ATT_SECURITY_* in src/bluetooth.h
  * @param write_permissions - see ATT_SECURITY_* in src/bluetooth.h
- * @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified
+ * @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified, zero-initialized if NULL
  * @param data_len
  * @returns attribute handle of the new characteristic value declaration
  * @note If properties contains ATT_PROPERTY_NOTIFY or ATT_PROPERTY_INDICATE flags, a Client Configuration Characteristic Descriptor (CCCD)
  *       is created as well. The attribute value handle of the CCCD is the attribute value handle plus 1
+ * @note With ENABLE_ATT_DB_INLINE_VALUES and att_set_db_inline_values, data_len bytes are reserved as value storage
+ *       for writes if ATT_PROPERTY_DYNAMIC is not specified
  */
 uint16_t att_db_util_add_characteristic_uuid128(const uint8_t * uuid128, uint16_t properties, uint8_t read_permission, uint8_t write_permission, uint8_t * data, uint16_t data_len);
 
@@ -130,7 +134,7 @@ uint16_t att_db_util_add_characteristic_uuid128(const uint8_t * uuid128, uint16_
 * @param properties        - see ATT_PROPERTY_* in src/bluetooth.h
 * @param read_permissions  - see ATT_SECURITY_* in src/bluetooth.h
 * @param write_permissions - see ATT_SECURITY_* in src/bluetooth.h
-* @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified
+* @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified, zero-initialized if NULL
 * @param data_len
 * @returns attribute handle of the new characteristic descriptor declaration
 */
@@ -142,7 +146,7 @@ uint16_t att_db_util_add_descriptor_uuid16(uint16_t uuid16, uint16_t properties,
 * @param properties        - see ATT_PROPERTY_* in src/bluetooth.h
 * @param read_permissions  - see ATT_SECURITY_* in src/bluetooth.h
 * @param write_permissions - see ATT_SECURITY_* in src/bluetooth.h
-* @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified
+* @param data returned in read operations if ATT_PROPERTY_DYNAMIC is not specified, zero-initialized if NULL
 * @param data_len
 * @returns attribute handle of the new characteristic descriptor declaration
 */
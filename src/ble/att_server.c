@@ -61,6 +61,7 @@
 #include "gap.h"
 #include "hci.h"
 #include "hci_dump.h"
+#include "btstack_trace.h"
 #include "l2cap.h"
 #include "btstack_tlv.h"
 #ifdef ENABLE_LE_SIGNED_WRITE
@@ -71,12 +72,25 @@
 #define NVN_NUM_GATT_SERVER_CCC 20
 #endif
 
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+#ifndef ATT_SERVER_MAX_CONNECTIONS
+#ifdef MAX_NR_HCI_CONNECTIONS
+#define ATT_SERVER_MAX_CONNECTIONS MAX_NR_HCI_CONNECTIONS
+#else
+#error "ENABLE_ATT_SERVER_CONNECTION_TABLE requires ATT_SERVER_MAX_CONNECTIONS or MAX_NR_HCI_CONNECTIONS"
+#endif
+#endif
+#endif
+
 static void att_run_for_context(att_server_t * att_server);
 static att_write_callback_t att_server_write_callback_for_handle(uint16_t handle);
 static btstack_packet_handler_t att_server_packet_handler_for_handle(uint16_t handle);
 static void att_server_handle_can_send_now(void);
 static void att_server_persistent_ccc_restore(att_server_t * att_server);
 static void att_server_persistent_ccc_clear(att_server_t * att_server);
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+static void att_server_persistent_ccc_cache_flush(att_server_t * att_server);
+#endif
 static void att_server_handle_att_pdu(att_server_t * att_server, uint8_t * packet, uint16_t size);
 
 typedef enum {
@@ -103,8 +117,21 @@ static btstack_context_callback_registration_t att_client_waiting_for_can_send_r
 static att_read_callback_t                    att_server_client_read_callback;
 static att_write_callback_t                   att_server_client_write_callback;
 
+// per attribute callbacks, see att_server_set_callback_slots
+static const uint8_t *                        att_server_callback_slots;
+static uint16_t                               att_server_callback_slots_num_handles;
+static const att_callback_slot_t *            att_server_callbacks;
+static uint16_t                               att_server_callbacks_num;
+
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+// connected ATT Servers, avoids iterating over all HCI connections
+static att_server_t * att_server_connections[ATT_SERVER_MAX_CONNECTIONS];
+// round robin: last served slot per phase
+static uint16_t       att_server_last_can_send_now_slot[ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS + 1];
+#else
 // round robin
 static hci_con_handle_t att_server_last_can_send_now = HCI_CON_HANDLE_INVALID;
+#endif
 
 static att_server_t * att_server_for_handle(hci_con_handle_t con_handle){
     hci_connection_t * hci_connection = hci_connection_for_handle(con_handle);
@@ -112,8 +139,49 @@ static att_server_t * att_server_for_handle(hci_con_handle_t con_handle){
     return &hci_connection->att_server;
 }
 
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+static bool att_server_connection_table_add(att_server_t * att_server){
+    int free_slot = -1;
+    int i;
+    for (i = 0; i < ATT_SERVER_MAX_CONNECTIONS; i++){
+        if (att_server_connections[i] == att_server) return true;
+        if ((free_slot < 0) && (att_server_connections[i] == NULL)){
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) return false;
+    att_server_connections[free_slot] = att_server;
+    return true;
+}
+
+static void att_server_connection_table_remove(att_server_t * att_server){
+    int i;
+    for (i = 0; i < ATT_SERVER_MAX_CONNECTIONS; i++){
+        if (att_server_connections[i] == att_server){
+            att_server_connections[i] = NULL;
+        }
+    }
+}
+
+// add connection or disconnect if more than ATT_SERVER_MAX_CONNECTIONS are used
+static bool att_server_connection_table_register(att_server_t * att_server, hci_con_handle_t con_handle){
+    if (att_server_connection_table_add(att_server)) return true;
+    log_error("ATT Server: no slot for con handle 0x%04x, ATT_SERVER_MAX_CONNECTIONS %u", con_handle, ATT_SERVER_MAX_CONNECTIONS);
+    gap_disconnect(con_handle);
+    return false;
+}
+#endif
+
 #ifdef ENABLE_GATT_OVER_CLASSIC
 static att_server_t * att_server_for_l2cap_cid(uint16_t l2cap_cid){
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+    int i;
+    for (i = 0; i < ATT_SERVER_MAX_CONNECTIONS; i++){
+        att_server_t * att_server = att_server_connections[i];
+        if ((att_server != NULL) && (att_server->l2cap_cid == l2cap_cid)) return att_server;
+    }
+    return NULL;
+#else
     btstack_linked_list_iterator_t it;
     hci_connections_get_iterator(&it);
     while(btstack_linked_list_iterator_has_next(&it)){
@@ -122,11 +190,20 @@ static att_server_t * att_server_for_l2cap_cid(uint16_t l2cap_cid){
         if (att_server->l2cap_cid == l2cap_cid) return att_server;
     }
     return NULL;
+#endif
 }
 #endif
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static att_server_t * att_server_for_state(att_server_state_t state){
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+    int i;
+    for (i = 0; i < ATT_SERVER_MAX_CONNECTIONS; i++){
+        att_server_t * att_server = att_server_connections[i];
+        if ((att_server != NULL) && (att_server->state == state)) return att_server;
+    }
+    return NULL;
+#else
     btstack_linked_list_iterator_t it;
     hci_connections_get_iterator(&it);
     while(btstack_linked_list_iterator_has_next(&it)){
@@ -135,6 +212,7 @@ static att_server_t * att_server_for_state(att_server_state_t state){
         if (att_server->state == state) return att_server;
     }
     return NULL;
+#endif
 }
 #endif
 
@@ -148,6 +226,143 @@ static void att_server_request_can_send_now(att_server_t * att_server){
     att_dispatch_server_request_can_send_now_event(att_server->connection.con_handle);
 }
 
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+// async entry states
+#define ATT_SERVER_ASYNC_FREE           0
+#define ATT_SERVER_ASYNC_READ_PENDING   1
+#define ATT_SERVER_ASYNC_READ_COMPLETE  2
+#define ATT_SERVER_ASYNC_WRITE_PENDING  3
+#define ATT_SERVER_ASYNC_WRITE_COMPLETE 4
+
+static uint16_t att_server_async_sequence_nr;
+
+static void att_server_async_reset(att_server_t * att_server){
+    memset(att_server->async_entries, 0, sizeof(att_server->async_entries));
+    att_server->async_value_buffer_len = 0;
+    att_server->async_token = 0;
+}
+
+// token: sequence number (16), con handle (16)
+static void att_server_async_prepare_token(att_server_t * att_server){
+    att_server_async_sequence_nr++;
+    if (att_server_async_sequence_nr == 0){
+        att_server_async_sequence_nr = 1;
+    }
+    att_server->async_token = ((uint32_t) att_server_async_sequence_nr << 16) | att_server->connection.con_handle;
+}
+
+static att_server_async_entry_t * att_server_async_entry_for_attribute(att_server_t * att_server, uint16_t attribute_handle, uint16_t transaction_mode, uint8_t state){
+    int i;
+    for (i = 0; i < ATT_SERVER_ASYNC_MAX_PENDING; i++){
+        att_server_async_entry_t * entry = &att_server->async_entries[i];
+        if (entry->state != state) continue;
+        if (entry->attribute_handle != attribute_handle) continue;
+        if (entry->transaction_mode != transaction_mode) continue;
+        return entry;
+    }
+    return NULL;
+}
+
+static att_server_async_entry_t * att_server_async_entry_for_token(att_server_t * att_server, att_server_token_t token){
+    int i;
+    for (i = 0; i < ATT_SERVER_ASYNC_MAX_PENDING; i++){
+        att_server_async_entry_t * entry = &att_server->async_entries[i];
+        if (entry->state == ATT_SERVER_ASYNC_FREE) continue;
+        if (entry->token == token) return entry;
+    }
+    return NULL;
+}
+
+static bool att_server_async_pending(att_server_t * att_server){
+    int i;
+    for (i = 0; i < ATT_SERVER_ASYNC_MAX_PENDING; i++){
+        uint8_t state = att_server->async_entries[i].state;
+        if ((state == ATT_SERVER_ASYNC_READ_PENDING) || (state == ATT_SERVER_ASYNC_WRITE_PENDING)) return true;
+    }
+    return false;
+}
+
+// @returns false if no entry is free
+static bool att_server_async_add(att_server_t * att_server, uint16_t attribute_handle, uint16_t transaction_mode, uint8_t state){
+    // attribute requested again while pending, only latest token is valid
+    att_server_async_entry_t * entry = att_server_async_entry_for_attribute(att_server, attribute_handle, transaction_mode, state);
+    int i;
+    for (i = 0; (entry == NULL) && (i < ATT_SERVER_ASYNC_MAX_PENDING); i++){
+        if (att_server->async_entries[i].state == ATT_SERVER_ASYNC_FREE){
+            entry = &att_server->async_entries[i];
+        }
+    }
+    if (entry == NULL){
+        log_error("ATT Server: no free async entry for handle 0x%04x", attribute_handle);
+        return false;
+    }
+    entry->token = att_server->async_token;
+    entry->attribute_handle = attribute_handle;
+    entry->transaction_mode = transaction_mode;
+    entry->state = state;
+    return true;
+}
+
+// process request again after all pending attributes are complete
+static void att_server_async_complete(att_server_t * att_server){
+    if (att_server_async_pending(att_server)) return;
+    if (att_server->state != ATT_SERVER_RESPONSE_PENDING) return;
+    att_server->state = ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED;
+    att_server_request_can_send_now(att_server);
+}
+
+static bool att_server_command_queue_add(att_server_t * att_server, const uint8_t * packet, uint16_t size){
+    if ((att_server->command_queue_len + 2 + size) > ATT_SERVER_COMMAND_QUEUE_SIZE) return false;
+    little_endian_store_16(att_server->command_queue, att_server->command_queue_len, size);
+    (void)memcpy(&att_server->command_queue[att_server->command_queue_len + 2], packet, size);
+    att_server->command_queue_len += 2 + size;
+    return true;
+}
+
+// handle queued commands in order until a request is in progress again
+static void att_server_command_queue_run(att_server_t * att_server){
+    while ((att_server->state == ATT_SERVER_IDLE) && (att_server->command_queue_len > 0)){
+        uint16_t size = little_endian_read_16(att_server->command_queue, 0);
+        // commands are only queued if state is not idle, entries further back are not touched
+        att_server_handle_att_pdu(att_server, &att_server->command_queue[2], size);
+        att_server->command_queue_len -= 2 + size;
+        (void)memmove(att_server->command_queue, &att_server->command_queue[2 + size], att_server->command_queue_len);
+    }
+}
+
+att_server_token_t att_server_get_token(hci_con_handle_t con_handle){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return 0;
+    return att_server->async_token;
+}
+
+uint8_t att_server_read_response_ready(att_server_token_t token, const uint8_t * value, uint16_t value_len){
+    att_server_t * att_server = att_server_for_handle((hci_con_handle_t) (token & 0xffffu));
+    if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    att_server_async_entry_t * entry = att_server_async_entry_for_token(att_server, token);
+    if ((entry == NULL) || (entry->state != ATT_SERVER_ASYNC_READ_PENDING)) return ERROR_CODE_COMMAND_DISALLOWED;
+    if ((att_server->async_value_buffer_len + value_len) > ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    (void)memcpy(&att_server->async_value_buffer[att_server->async_value_buffer_len], value, value_len);
+    entry->value_offset = att_server->async_value_buffer_len;
+    entry->value_len = value_len;
+    entry->state = ATT_SERVER_ASYNC_READ_COMPLETE;
+    att_server->async_value_buffer_len += value_len;
+    att_server_async_complete(att_server);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t att_server_write_response_ready(att_server_token_t token, uint8_t att_error_code){
+    att_server_t * att_server = att_server_for_handle((hci_con_handle_t) (token & 0xffffu));
+    if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    att_server_async_entry_t * entry = att_server_async_entry_for_token(att_server, token);
+    if ((entry == NULL) || (entry->state != ATT_SERVER_ASYNC_WRITE_PENDING)) return ERROR_CODE_COMMAND_DISALLOWED;
+    entry->error_code = att_error_code;
+    entry->state = ATT_SERVER_ASYNC_WRITE_COMPLETE;
+    att_server_async_complete(att_server);
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 static int att_server_can_send_packet(att_server_t * att_server){
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (att_server->l2cap_cid != 0){
@@ -282,8 +497,22 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     l2cap_event_channel_opened_get_address(packet, att_server->peer_address);
                     att_server->connection.con_handle = con_handle;
                     att_server->l2cap_cid = l2cap_event_channel_opened_get_local_cid(packet);
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+                    if (!att_server_connection_table_register(att_server, con_handle)) break;
+#endif
                     // reset connection properties
                     att_server->state = ATT_SERVER_IDLE;
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+                    att_server_async_reset(att_server);
+                    att_server->command_queue_len = 0;
+#endif
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+                    att_server->notification_queue_len = 0;
+                    att_server->multiple_handle_value_notifications_supported = false;
+#endif
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+                    att_server->persistent_ccc_cache_count = 0;
+#endif
                     att_server->connection.mtu = l2cap_event_channel_opened_get_remote_mtu(packet);
                     att_server->connection.max_mtu = l2cap_max_mtu();
                     if (att_server->connection.max_mtu > ATT_REQUEST_BUFFER_SIZE){
@@ -324,8 +553,22 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                         	att_server->peer_addr_type = packet[7];
                             reverse_bd_addr(&packet[8], att_server->peer_address);
                             att_server->connection.con_handle = con_handle;
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+                            if (!att_server_connection_table_register(att_server, con_handle)) break;
+#endif
                             // reset connection properties
                             att_server->state = ATT_SERVER_IDLE;
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+                            att_server_async_reset(att_server);
+                            att_server->command_queue_len = 0;
+#endif
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+                            att_server->notification_queue_len = 0;
+                            att_server->multiple_handle_value_notifications_supported = false;
+#endif
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+                            att_server->persistent_ccc_cache_count = 0;
+#endif
                             att_server->connection.mtu = ATT_DEFAULT_MTU;
                             att_server->connection.max_mtu = l2cap_max_le_mtu();
                             if (att_server->connection.max_mtu > ATT_REQUEST_BUFFER_SIZE){
@@ -376,7 +619,13 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     con_handle = hci_event_disconnection_complete_get_connection_handle(packet);
                     att_server = att_server_for_handle(con_handle);
                     if (!att_server) break;
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+                    att_server_persistent_ccc_cache_flush(att_server);
+#endif
                     att_clear_transaction_queue(&att_server->connection);
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+                    att_server_connection_table_remove(att_server);
+#endif
                     att_server->connection.con_handle = 0;
                     att_server->pairing_active = 0;
                     att_server->state = ATT_SERVER_IDLE;
@@ -530,6 +779,10 @@ static int att_server_process_validated_request(att_server_t * att_server){
         return 0;
     }
 #endif
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+    // request complete, drop values and results of async reads and writes
+    att_server_async_reset(att_server);
+#endif
 
     // intercept "insufficient authorization" for authenticated connections to allow for user authorization
     if ((att_response_size     >= 4)
@@ -556,6 +809,8 @@ static int att_server_process_validated_request(att_server_t * att_server){
         return 0;
     }
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_ATT_TX, att_server->connection.con_handle, att_response_size);
+
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (att_server->l2cap_cid != 0){
         l2cap_send_prepared(att_server->l2cap_cid, att_response_size);
@@ -654,6 +909,51 @@ static void att_run_for_context(att_server_t * att_server){
     }   
 }
 
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+static void att_server_notification_queue_send(att_server_t * att_server){
+
+    l2cap_reserve_packet_buffer();
+    uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
+
+    uint8_t * queue = att_server->notification_queue;
+    uint16_t first_entry_len = 4 + little_endian_read_16(queue, 2);
+    uint16_t consumed = 0;
+    uint16_t size = 1;
+
+    // check how many notifications fit into a single Multiple Handle Value Notification
+    if (att_server->multiple_handle_value_notifications_supported){
+        while (consumed < att_server->notification_queue_len){
+            uint16_t entry_len = 4 + little_endian_read_16(queue, consumed + 2);
+            if ((size + entry_len) > att_server->connection.mtu) break;
+            size     += entry_len;
+            consumed += entry_len;
+        }
+    }
+
+    if (consumed > first_entry_len){
+        // queue entries use the handle length value tuple format
+        packet_buffer[0] = ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION;
+        (void)memcpy(&packet_buffer[1], queue, consumed);
+    } else {
+        consumed = first_entry_len;
+        size = att_prepare_handle_value_notification(&att_server->connection, little_endian_read_16(queue, 0), &queue[4], first_entry_len - 4, packet_buffer);
+    }
+
+    // remove sent notifications from queue
+    att_server->notification_queue_len -= consumed;
+    (void)memmove(queue, &queue[consumed], att_server->notification_queue_len);
+
+#ifdef ENABLE_GATT_OVER_CLASSIC
+    if (att_server->l2cap_cid != 0){
+        l2cap_send_prepared(att_server->l2cap_cid, size);
+    } else
+#endif
+    {
+        l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
+    }
+}
+#endif
+
 static int att_server_data_ready_for_phase(att_server_t * att_server,  att_server_run_phase_t phase){
     switch (phase){
         case ATT_SERVER_RUN_PHASE_1_REQUESTS:
@@ -661,6 +961,9 @@ static int att_server_data_ready_for_phase(att_server_t * att_server,  att_serve
         case ATT_SERVER_RUN_PHASE_2_INDICATIONS:
              return (!btstack_linked_list_empty(&att_server->indication_requests) && (att_server->value_indication_handle == 0));
         case ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS:
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+            if (att_server->notification_queue_len > 0) return 1;
+#endif
             return (!btstack_linked_list_empty(&att_server->notification_requests));
     }
     // avoid warning
@@ -672,6 +975,9 @@ static void att_server_trigger_send_for_phase(att_server_t * att_server,  att_se
     switch (phase){
         case ATT_SERVER_RUN_PHASE_1_REQUESTS:
             att_server_process_validated_request(att_server);
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+            att_server_command_queue_run(att_server);
+#endif
             break;
         case ATT_SERVER_RUN_PHASE_2_INDICATIONS:
             client = (btstack_context_callback_registration_t*) att_server->indication_requests;
@@ -679,6 +985,13 @@ static void att_server_trigger_send_for_phase(att_server_t * att_server,  att_se
             client->callback(client->context);
             break;
        case ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS:
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+            // queued notifications first, they have been requested before
+            if (att_server->notification_queue_len > 0){
+                att_server_notification_queue_send(att_server);
+                break;
+            }
+#endif
             client = (btstack_context_callback_registration_t*) att_server->notification_requests;
             btstack_linked_list_remove(&att_server->notification_requests, (btstack_linked_item_t *) client);
             client->callback(client->context);
@@ -686,6 +999,46 @@ static void att_server_trigger_send_for_phase(att_server_t * att_server,  att_se
     }
 }
 
+#ifdef ENABLE_ATT_SERVER_CONNECTION_TABLE
+static void att_server_handle_can_send_now(void){
+
+    att_server_t * request_att_server = NULL;
+    bool can_send_now = true;
+    int phase_index;
+
+    for (phase_index = ATT_SERVER_RUN_PHASE_1_REQUESTS; phase_index <= ATT_SERVER_RUN_PHASE_3_NOTIFICATIONS; phase_index++){
+        att_server_run_phase_t phase = (att_server_run_phase_t) phase_index;
+        bool served = true;
+        while (served && (request_att_server == NULL)){
+            served = false;
+            // start after connection served last in this phase
+            uint16_t start_slot = att_server_last_can_send_now_slot[phase_index];
+            uint16_t i;
+            for (i = 1; i <= ATT_SERVER_MAX_CONNECTIONS; i++){
+                uint16_t slot = (start_slot + i) % ATT_SERVER_MAX_CONNECTIONS;
+                att_server_t * att_server = att_server_connections[slot];
+                if (att_server == NULL) continue;
+                if (!att_server_data_ready_for_phase(att_server, phase)) continue;
+                if (!can_send_now){
+                    request_att_server = att_server;
+                    break;
+                }
+                att_server_trigger_send_for_phase(att_server, phase);
+                att_server_last_can_send_now_slot[phase_index] = slot;
+                // connection might have been removed by callback
+                if (att_server_connections[slot] == att_server){
+                    can_send_now = att_server_can_send_packet(att_server) != 0;
+                }
+                served = true;
+            }
+        }
+        if (request_att_server != NULL) break;
+    }
+
+    if (request_att_server == NULL) return;
+    att_server_request_can_send_now(request_att_server);
+}
+#else
 static void att_server_handle_can_send_now(void){
 
     hci_con_handle_t last_send_con_handle = HCI_CON_HANDLE_INVALID;
@@ -755,9 +1108,12 @@ static void att_server_handle_can_send_now(void){
     if (request_att_server == NULL) return;
     att_server_request_can_send_now(request_att_server);
 }
+#endif
 
 static void att_server_handle_att_pdu(att_server_t * att_server, uint8_t * packet, uint16_t size){
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_ATT_RX, att_server->connection.con_handle, size);
+
     // handle value indication confirms
     if ((packet[0] == ATT_HANDLE_VALUE_CONFIRMATION) && att_server->value_indication_handle){
         btstack_run_loop_remove_timer(&att_server->value_indication_timer);
@@ -771,7 +1127,19 @@ static void att_server_handle_att_pdu(att_server_t * att_server, uint8_t * packe
     // directly process command
     // note: signed write cannot be handled directly as authentication needs to be verified
     if (packet[0] == ATT_WRITE_COMMAND){
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+        // keep order with request in progress
+        if ((att_server->state != ATT_SERVER_IDLE) && att_server_command_queue_add(att_server, packet, size)) return;
         att_handle_request(&att_server->connection, packet, size, NULL);
+        if ((att_server->state == ATT_SERVER_IDLE) && att_server_async_pending(att_server) && (size <= sizeof(att_server->request_buffer))){
+            // write callback returned ATT_ERROR_WRITE_RESPONSE_PENDING, handle command again when complete
+            att_server->state = ATT_SERVER_RESPONSE_PENDING;
+            att_server->request_size = size;
+            (void)memcpy(att_server->request_buffer, packet, size);
+        }
+#else
+        att_handle_request(&att_server->connection, packet, size, NULL);
+#endif
         return;
     }
 
@@ -795,6 +1163,9 @@ static void att_server_handle_att_pdu(att_server_t * att_server, uint8_t * packe
 #endif
     // last request still in processing?
     if (att_server->state != ATT_SERVER_IDLE){
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+        if ((packet[0] == ATT_SIGNED_WRITE_COMMAND) && att_server_command_queue_add(att_server, packet, size)) return;
+#endif
         log_info("skip att pdu 0x%02x as server not idle (state %u)", packet[0], att_server->state);
         return;
     }
@@ -843,16 +1214,7 @@ static uint32_t att_server_persistent_ccc_tag_for_index(uint8_t index){
     return ('B' << 24) | ('T' << 16) | ('C' << 8) | index;
 }
 
-static void att_server_persistent_ccc_write(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t value){
-    // lookup att_server instance
-    att_server_t * att_server = att_server_for_handle(con_handle);
-    if (!att_server) return;
-    int le_device_index = att_server->ir_le_device_db_index;
-    log_info("Store CCC value 0x%04x for handle 0x%04x of remote %s, le device id %d", value, att_handle, bd_addr_to_str(att_server->peer_address), le_device_index);
-
-    // check if bonded
-    if (le_device_index < 0) return;
-
+static void att_server_persistent_ccc_store(int le_device_index, uint16_t att_handle, uint16_t value){
     // get btstack_tlv
     const btstack_tlv_t * tlv_impl = NULL;
     void * tlv_context;
@@ -941,6 +1303,11 @@ static void att_server_persistent_ccc_clear(att_server_t * att_server){
     if (!att_server) return;
     int le_device_index = att_server->ir_le_device_db_index;
     log_info("Clear CCC values of remote %s, le device id %d", bd_addr_to_str(att_server->peer_address), le_device_index);
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+    // drop pending writes
+    btstack_run_loop_remove_timer(&att_server->persistent_ccc_cache_timer);
+    att_server->persistent_ccc_cache_count = 0;
+#endif
     // check if bonded
     if (le_device_index < 0) return;
     // get btstack_tlv
@@ -966,6 +1333,10 @@ static void att_server_persistent_ccc_restore(att_server_t * att_server){
     if (!att_server) return;
     int le_device_index = att_server->ir_le_device_db_index;
     log_info("Restore CCC values of remote %s, le device id %d", bd_addr_to_str(att_server->peer_address), le_device_index);
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+    // store pending writes first
+    att_server_persistent_ccc_cache_flush(att_server);
+#endif
     // check if bonded
     if (le_device_index < 0) return;
     // get btstack_tlv
@@ -992,6 +1363,72 @@ static void att_server_persistent_ccc_restore(att_server_t * att_server){
     }
 }
 
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+static void att_server_persistent_ccc_cache_flush(att_server_t * att_server){
+    btstack_run_loop_remove_timer(&att_server->persistent_ccc_cache_timer);
+    uint8_t i;
+    for (i=0;i<att_server->persistent_ccc_cache_count;i++){
+        att_server_persistent_ccc_store(att_server->persistent_ccc_cache_device_index,
+                                        att_server->persistent_ccc_cache_handles[i],
+                                        att_server->persistent_ccc_cache_values[i]);
+    }
+    att_server->persistent_ccc_cache_count = 0;
+}
+
+static void att_server_persistent_ccc_cache_timeout(btstack_timer_source_t * ts){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(ts);
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return;
+    log_info("CCC cache timeout, store %u values", att_server->persistent_ccc_cache_count);
+    att_server_persistent_ccc_cache_flush(att_server);
+}
+
+static void att_server_persistent_ccc_cache_write(att_server_t * att_server, int le_device_index, uint16_t att_handle, uint16_t value){
+    // flush if values of different device are pending, e.g. after re-pairing
+    if ((att_server->persistent_ccc_cache_count > 0) && (att_server->persistent_ccc_cache_device_index != le_device_index)){
+        att_server_persistent_ccc_cache_flush(att_server);
+    }
+    // coalesce writes to same handle
+    uint8_t i;
+    for (i=0;i<att_server->persistent_ccc_cache_count;i++){
+        if (att_server->persistent_ccc_cache_handles[i] == att_handle) break;
+    }
+    if (i == ATT_SERVER_PERSISTENT_CCC_CACHE_SIZE){
+        att_server_persistent_ccc_cache_flush(att_server);
+        i = 0;
+    }
+    if (i == att_server->persistent_ccc_cache_count){
+        att_server->persistent_ccc_cache_count++;
+    }
+    att_server->persistent_ccc_cache_device_index = le_device_index;
+    att_server->persistent_ccc_cache_handles[i] = att_handle;
+    att_server->persistent_ccc_cache_values[i]  = value;
+    // (re)start timer
+    btstack_run_loop_remove_timer(&att_server->persistent_ccc_cache_timer);
+    btstack_run_loop_set_timer_handler(&att_server->persistent_ccc_cache_timer, &att_server_persistent_ccc_cache_timeout);
+    btstack_run_loop_set_timer_context(&att_server->persistent_ccc_cache_timer, (void *) (uintptr_t) att_server->connection.con_handle);
+    btstack_run_loop_set_timer(&att_server->persistent_ccc_cache_timer, ATT_SERVER_PERSISTENT_CCC_CACHE_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&att_server->persistent_ccc_cache_timer);
+}
+#endif
+
+static void att_server_persistent_ccc_write(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t value){
+    // lookup att_server instance
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return;
+    int le_device_index = att_server->ir_le_device_db_index;
+    log_info("Store CCC value 0x%04x for handle 0x%04x of remote %s, le device id %d", value, att_handle, bd_addr_to_str(att_server->peer_address), le_device_index);
+
+    // check if bonded
+    if (le_device_index < 0) return;
+
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+    att_server_persistent_ccc_cache_write(att_server, le_device_index, att_handle, value);
+#else
+    att_server_persistent_ccc_store(le_device_index, att_handle, value);
+#endif
+}
+
 // persistent CCC writes
 // ---------------------
 
@@ -1007,18 +1444,41 @@ static att_service_handler_t * att_service_handler_for_handle(uint16_t handle){
     }
     return NULL;
 }
+static const att_callback_slot_t * att_server_callback_slot_for_handle(uint16_t handle){
+    if (handle >= att_server_callback_slots_num_handles) return NULL;
+    uint8_t slot = att_server_callback_slots[handle];
+    if ((slot == 0) || (slot > att_server_callbacks_num)) return NULL;
+    return &att_server_callbacks[slot - 1];
+}
+
 static att_read_callback_t att_server_read_callback_for_handle(uint16_t handle){
     att_service_handler_t * handler = att_service_handler_for_handle(handle);
     if (handler) return handler->read_callback;
+    const att_callback_slot_t * callback_slot = att_server_callback_slot_for_handle(handle);
+    if ((callback_slot != NULL) && (callback_slot->read_callback != NULL)) return callback_slot->read_callback;
     return att_server_client_read_callback;
 }
 
 static att_write_callback_t att_server_write_callback_for_handle(uint16_t handle){
     att_service_handler_t * handler = att_service_handler_for_handle(handle);
     if (handler) return handler->write_callback;
+    const att_callback_slot_t * callback_slot = att_server_callback_slot_for_handle(handle);
+    if ((callback_slot != NULL) && (callback_slot->write_callback != NULL)) return callback_slot->write_callback;
     return att_server_client_write_callback;
 }
 
+// @returns false if write callback of callback slot was already used by client or an earlier slot
+static bool att_server_callback_slot_write_callback_is_distinct(uint16_t index){
+    att_write_callback_t callback = att_server_callbacks[index].write_callback;
+    if (callback == NULL) return false;
+    if (callback == att_server_client_write_callback) return false;
+    uint16_t i;
+    for (i = 0; i < index; i++){
+        if (att_server_callbacks[i].write_callback == callback) return false;
+    }
+    return true;
+}
+
 static btstack_packet_handler_t att_server_packet_handler_for_handle(uint16_t handle){
     att_service_handler_t * handler = att_service_handler_for_handle(handle);
     if (handler) return handler->packet_handler;
@@ -1034,6 +1494,11 @@ static void att_notify_write_callbacks(hci_con_handle_t con_handle, uint16_t tra
         if (!handler->write_callback) continue;
         (*handler->write_callback)(con_handle, 0, transaction_mode, 0, NULL, 0);
     }
+    uint16_t i;
+    for (i = 0; i < att_server_callbacks_num; i++){
+        if (!att_server_callback_slot_write_callback_is_distinct(i)) continue;
+        (*att_server_callbacks[i].write_callback)(con_handle, 0, transaction_mode, 0, NULL, 0);
+    }
     if (!att_server_client_write_callback) return;
     (*att_server_client_write_callback)(con_handle, 0, transaction_mode, 0, NULL, 0);
 }
@@ -1048,17 +1513,42 @@ static uint8_t att_validate_prepared_write(hci_con_handle_t con_handle){
         uint8_t error_code = (*handler->write_callback)(con_handle, 0, ATT_TRANSACTION_MODE_VALIDATE, 0, NULL, 0);
         if (error_code) return error_code;
     }
+    uint16_t i;
+    for (i = 0; i < att_server_callbacks_num; i++){
+        if (!att_server_callback_slot_write_callback_is_distinct(i)) continue;
+        uint8_t error_code = (*att_server_callbacks[i].write_callback)(con_handle, 0, ATT_TRANSACTION_MODE_VALIDATE, 0, NULL, 0);
+        if (error_code) return error_code;
+    }
     if (!att_server_client_write_callback) return 0;
     return (*att_server_client_write_callback)(con_handle, 0, ATT_TRANSACTION_MODE_VALIDATE, 0, NULL, 0);
 }
 
 static uint16_t att_server_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (att_server != NULL){
+        // value provided by att_server_read_response_ready
+        const att_server_async_entry_t * entry = att_server_async_entry_for_attribute(att_server, attribute_handle, 0, ATT_SERVER_ASYNC_READ_COMPLETE);
+        if (entry != NULL){
+            return att_read_callback_handle_blob(&att_server->async_value_buffer[entry->value_offset], entry->value_len, offset, buffer, buffer_size);
+        }
+        att_server_async_prepare_token(att_server);
+    }
+#endif
     att_read_callback_t callback = att_server_read_callback_for_handle(attribute_handle);
     if (!callback) return 0;
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+    uint16_t value_len = (*callback)(con_handle, attribute_handle, offset, buffer, buffer_size);
+    if ((att_server != NULL) && (value_len == ATT_READ_RESPONSE_PENDING)){
+        if (!att_server_async_add(att_server, attribute_handle, 0, ATT_SERVER_ASYNC_READ_PENDING)) return 0;
+    }
+    return value_len;
+#else
     return (*callback)(con_handle, attribute_handle, offset, buffer, buffer_size);
+#endif
 }
 
-static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+static int att_server_dispatch_write(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
     switch (transaction_mode){
         case ATT_TRANSACTION_MODE_VALIDATE:
             return att_validate_prepared_write(con_handle);
@@ -1080,6 +1570,28 @@ static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attri
     return (*callback)(con_handle, attribute_handle, transaction_mode, offset, buffer, buffer_size);
 }
 
+static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (att_server != NULL){
+        // result provided by att_server_write_response_ready
+        att_server_async_entry_t * entry = att_server_async_entry_for_attribute(att_server, attribute_handle, transaction_mode, ATT_SERVER_ASYNC_WRITE_COMPLETE);
+        if (entry != NULL){
+            entry->state = ATT_SERVER_ASYNC_FREE;
+            return entry->error_code;
+        }
+        att_server_async_prepare_token(att_server);
+    }
+    int error_code = att_server_dispatch_write(con_handle, attribute_handle, transaction_mode, offset, buffer, buffer_size);
+    if ((att_server != NULL) && (error_code == ATT_ERROR_WRITE_RESPONSE_PENDING)){
+        if (!att_server_async_add(att_server, attribute_handle, transaction_mode, ATT_SERVER_ASYNC_WRITE_PENDING)) return ATT_ERROR_INSUFFICIENT_RESOURCES;
+    }
+    return error_code;
+#else
+    return att_server_dispatch_write(con_handle, attribute_handle, transaction_mode, offset, buffer, buffer_size);
+#endif
+}
+
 /**
  * @brief register read/write callbacks for specific handle range
  * @param att_service_handler_t
@@ -1093,6 +1605,13 @@ void att_server_register_service_handler(att_service_handler_t * handler){
     btstack_linked_list_add(&service_handlers, (btstack_linked_item_t*) handler);
 }
 
+void att_server_set_callback_slots(const uint8_t * slots, uint16_t num_handles, const att_callback_slot_t * callbacks, uint16_t num_callbacks){
+    att_server_callback_slots = slots;
+    att_server_callback_slots_num_handles = (slots != NULL) ? num_handles : 0;
+    att_server_callbacks = callbacks;
+    att_server_callbacks_num = (callbacks != NULL) ? num_callbacks : 0;
+}
+
 void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_write_callback_t write_callback){
 
     // store callbacks
@@ -1174,9 +1693,35 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, co
     l2cap_reserve_packet_buffer();
     uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
     uint16_t size = att_prepare_handle_value_notification(&att_server->connection, attribute_handle, value, value_len, packet_buffer);
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_ATT_TX, con_handle, size);
 	return l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
 }
 
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+int att_server_notify_queued(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+
+    uint32_t entry_len = 4u + value_len;
+    if ((att_server->notification_queue_len + entry_len) > ATT_SERVER_NOTIFICATION_QUEUE_SIZE) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    uint8_t * entry = &att_server->notification_queue[att_server->notification_queue_len];
+    little_endian_store_16(entry, 0, attribute_handle);
+    little_endian_store_16(entry, 2, value_len);
+    (void)memcpy(&entry[4], value, value_len);
+    att_server->notification_queue_len += (uint16_t) entry_len;
+
+    att_server_request_can_send_now(att_server);
+    return ERROR_CODE_SUCCESS;
+}
+
+void att_server_set_multiple_handle_value_notifications_supported(hci_con_handle_t con_handle, bool supported){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return;
+    att_server->multiple_handle_value_notifications_supported = supported;
+}
+#endif
+
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len){
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
@@ -1193,6 +1738,7 @@ int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle,
     l2cap_reserve_packet_buffer();
     uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
     uint16_t size = att_prepare_handle_value_indication(&att_server->connection, attribute_handle, value, value_len, packet_buffer);
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_ATT_TX, con_handle, size);
 	l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
     return 0;
 }
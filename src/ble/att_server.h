@@ -70,6 +70,17 @@ void att_server_register_packet_handler(btstack_packet_handler_t handler);
  */
 void att_server_register_service_handler(att_service_handler_t * handler);
 
+/**
+ * @brief register read/write callbacks for individual dynamic attributes
+ * @note slots are generated by compile_gatt.py --callback-slots. Registered service handlers take precedence,
+ *       attributes without slot or slots without callback use the callbacks from att_server_init
+ * @param slots profile_callback_slots: slot + 1 by attribute handle, 0 for static attributes
+ * @param num_handles PROFILE_CALLBACK_NUM_HANDLES
+ * @param callbacks indexed by ATT_*_CALLBACK_SLOT, has to stay valid
+ * @param num_callbacks PROFILE_CALLBACK_NUM_SLOTS
+ */
+void att_server_set_callback_slots(const uint8_t * slots, uint16_t num_handles, const att_callback_slot_t * callbacks, uint16_t num_callbacks);
+
 /**
  * @brief Request callback when sending is possible
  * @note callback might happend during call to this function
@@ -124,6 +135,27 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, co
  */
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
 
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+/*
+ * @brief queue notification about attribute value change, sent as soon as possible
+ * @note value is copied into per-connection queue of ATT_SERVER_NOTIFICATION_QUEUE_SIZE bytes
+ * @param con_handle
+ * @param attribute_handle
+ * @param value
+ * @param value_len
+ * @return ERROR_CODE_SUCCESS if ok, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER if handle unknown, and ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if queue is full
+ */
+int att_server_notify_queued(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
+
+/*
+ * @brief allow to combine queued notifications into a single ATT Multiple Handle Value Notification
+ * @note only enable if the client did set the Multiple Handle Value Notifications bit in the Client Supported Features characteristic
+ * @param con_handle
+ * @param supported
+ */
+void att_server_set_multiple_handle_value_notifications_supported(hci_con_handle_t con_handle, bool supported);
+#endif
+
 #ifdef ENABLE_ATT_DELAYED_RESPONSE
 /*
  * @brief response ready - called after returning ATT_READ__RESPONSE_PENDING in an att_read_callback or
@@ -135,6 +167,37 @@ int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle,
 int att_server_response_ready(hci_con_handle_t con_handle);
 #endif
 
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+typedef uint32_t att_server_token_t;
+
+/*
+ * @brief Get token for the current read or write callback. Call from within att_read_callback or att_write_callback,
+ * return ATT_READ_RESPONSE_PENDING or ATT_ERROR_WRITE_RESPONSE_PENDING and complete the request later.
+ * @note Several attributes can be pending for a single ATT request, e.g. Read Multiple or Execute Write
+ * @param con_handle
+ * @return token, 0 if connection unknown
+ */
+att_server_token_t att_server_get_token(hci_con_handle_t con_handle);
+
+/*
+ * @brief Provide value for pending read. Value is copied, ATT Server sends response when all pending attributes are complete
+ * @param token from att_server_get_token
+ * @param value
+ * @param value_len
+ * @return ERROR_CODE_SUCCESS, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, ERROR_CODE_COMMAND_DISALLOWED if token not pending,
+ *         ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if value does not fit into ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE
+ */
+uint8_t att_server_read_response_ready(att_server_token_t token, const uint8_t * value, uint16_t value_len);
+
+/*
+ * @brief Provide result for pending write. ATT Server sends response when all pending attributes are complete
+ * @param token from att_server_get_token
+ * @param att_error_code 0 for success or ATT_ERROR_x
+ * @return ERROR_CODE_SUCCESS, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, ERROR_CODE_COMMAND_DISALLOWED if token not pending
+ */
+uint8_t att_server_write_response_ready(att_server_token_t token, uint8_t att_error_code);
+#endif
+
 // the following functions will be removed soon
 
 /*
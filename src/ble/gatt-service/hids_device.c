@@ -42,6 +42,8 @@
  * To use with your application, add '#import <hids.gatt>' to your .gatt file
  */
 
+#include <string.h>
+
 #include "hids_device.h"
 
 #include "ble/att_db.h"
@@ -52,6 +54,21 @@
 
 #define HIDS_DEVICE_ERROR_CODE_INAPPROPRIATE_CONNECTION_PARAMETERS    0x80
 
+// queued input reports, merged if link is congested
+#ifndef HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE
+#define HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE 4
+#endif
+
+#ifndef HIDS_DEVICE_INPUT_REPORT_MAX_SIZE
+#define HIDS_DEVICE_INPUT_REPORT_MAX_SIZE 16
+#endif
+
+typedef struct {
+    uint16_t value_handle;
+    uint16_t len;
+    uint8_t  data[HIDS_DEVICE_INPUT_REPORT_MAX_SIZE];
+} hids_device_input_report_t;
+
 typedef struct{
     uint16_t        con_handle;
 
@@ -87,6 +104,13 @@ typedef struct{
     uint8_t         hid_control_point_suspend;
 
     btstack_context_callback_registration_t  battery_callback;
+
+    // input report queue
+    hci_con_handle_t           input_report_con_handle;
+    hids_device_input_report_t input_reports[HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE];
+    uint8_t                    input_reports_head;
+    uint8_t                    input_reports_count;
+    btstack_context_callback_registration_t  input_report_callback;
 } hids_device_t;
 
 static hids_device_t hids_device;
@@ -94,6 +118,14 @@ static hids_device_t hids_device;
 static btstack_packet_handler_t packet_handler;
 static att_service_handler_t hid_service;
 
+static const hids_device_relative_field_t * hids_device_input_report_relative_fields;
+static uint8_t hids_device_input_report_num_relative_fields;
+
+// boot mouse: buttons, x, y, optional wheel
+static const hids_device_relative_field_t hids_device_boot_mouse_relative_fields[] = {
+    { 8, 8}, {16, 8}, {24, 8}
+};
+
 // TODO: store hids device connection into list
 static hids_device_t * hids_device_get_instance_for_con_handle(uint16_t con_handle){
     UNUSED(con_handle);
@@ -420,3 +452,172 @@ void hids_device_send_boot_keyboard_input_report(hci_con_handle_t con_handle, co
     }
     att_server_notify(con_handle, instance->hid_boot_keyboard_input_value_handle, report, report_len);
 }
+
+static int32_t hids_device_field_read(const uint8_t * report, const hids_device_relative_field_t * field){
+    uint32_t value = 0;
+    uint8_t i;
+    for (i = 0; i < field->bit_size; i++){
+        uint16_t bit = field->bit_offset + i;
+        if (report[bit >> 3] & (1u << (bit & 7))){
+            value |= 1u << i;
+        }
+    }
+    // sign extend
+    if (value & (1u << (field->bit_size - 1))){
+        value |= ~((1u << field->bit_size) - 1);
+    }
+    return (int32_t) value;
+}
+
+static void hids_device_field_write(uint8_t * report, const hids_device_relative_field_t * field, int32_t value){
+    uint8_t i;
+    for (i = 0; i < field->bit_size; i++){
+        uint16_t bit = field->bit_offset + i;
+        if (((uint32_t) value) & (1u << i)){
+            report[bit >> 3] |=  (uint8_t) (1u << (bit & 7));
+        } else {
+            report[bit >> 3] &= (uint8_t) ~(1u << (bit & 7));
+        }
+    }
+}
+
+static uint8_t hids_device_relative_fields_for_handle(uint16_t value_handle, const hids_device_relative_field_t ** fields){
+    if (value_handle == hids_device.hid_boot_mouse_input_value_handle){
+        *fields = hids_device_boot_mouse_relative_fields;
+        return sizeof(hids_device_boot_mouse_relative_fields) / sizeof(hids_device_relative_field_t);
+    }
+    if (value_handle == hids_device.hid_report_input_value_handle){
+        *fields = hids_device_input_report_relative_fields;
+        return hids_device_input_report_num_relative_fields;
+    }
+    return 0;
+}
+
+// merge report into queued report by adding up relative fields
+// returns false if other fields differ or a sum does not fit, unless merge is forced
+static bool hids_device_input_report_merge(hids_device_input_report_t * queued, const uint8_t * report, bool force){
+    const hids_device_relative_field_t * fields = NULL;
+    uint8_t num_fields = hids_device_relative_fields_for_handle(queued->value_handle, &fields);
+    if ((num_fields == 0) && !force) return false;
+
+    uint8_t merged[HIDS_DEVICE_INPUT_REPORT_MAX_SIZE];
+    uint8_t masked_queued[HIDS_DEVICE_INPUT_REPORT_MAX_SIZE];
+    uint8_t masked_report[HIDS_DEVICE_INPUT_REPORT_MAX_SIZE];
+    (void)memcpy(merged, report, queued->len);
+    (void)memcpy(masked_queued, queued->data, queued->len);
+    (void)memcpy(masked_report, report, queued->len);
+
+    bool fits = true;
+    uint8_t i;
+    for (i = 0; i < num_fields; i++){
+        const hids_device_relative_field_t * field = &fields[i];
+        // ignore fields outside of report
+        if ((field->bit_offset + field->bit_size) > (queued->len * 8)) continue;
+        int32_t max = (1 << (field->bit_size - 1)) - 1;
+        int32_t min = -max - 1;
+        int32_t sum = hids_device_field_read(queued->data, field) + hids_device_field_read(report, field);
+        if (sum > max){
+            sum = max;
+            fits = false;
+        }
+        if (sum < min){
+            sum = min;
+            fits = false;
+        }
+        hids_device_field_write(merged, field, sum);
+        hids_device_field_write(masked_queued, field, 0);
+        hids_device_field_write(masked_report, field, 0);
+    }
+
+    if (!force){
+        if (!fits) return false;
+        if (memcmp(masked_queued, masked_report, queued->len) != 0) return false;
+    }
+
+    (void)memcpy(queued->data, merged, queued->len);
+    return true;
+}
+
+static void hids_device_input_report_send_queued(void * context){
+    UNUSED(context);
+    hids_device_t * instance = &hids_device;
+    hci_con_handle_t con_handle = instance->input_report_con_handle;
+    while ((instance->input_reports_count > 0) && att_server_can_send_packet_now(con_handle)){
+        hids_device_input_report_t * input_report = &instance->input_reports[instance->input_reports_head];
+        att_server_notify(con_handle, input_report->value_handle, input_report->data, input_report->len);
+        instance->input_reports_head = (instance->input_reports_head + 1) % HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE;
+        instance->input_reports_count--;
+    }
+    if (instance->input_reports_count > 0){
+        att_server_request_to_send_notification(&instance->input_report_callback, con_handle);
+    }
+}
+
+static uint8_t hids_device_queue_report(hci_con_handle_t con_handle, uint16_t value_handle, const uint8_t * report, uint16_t report_len){
+    hids_device_t * instance = hids_device_get_instance_for_con_handle(con_handle);
+    if (!instance){
+        log_error("no instance for handle 0x%02x", con_handle);
+        return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    }
+    if (report_len > HIDS_DEVICE_INPUT_REPORT_MAX_SIZE){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+
+    // drop reports queued for previous connection
+    if (instance->input_report_con_handle != con_handle){
+        instance->input_report_con_handle = con_handle;
+        instance->input_reports_count = 0;
+        instance->input_report_callback.callback = &hids_device_input_report_send_queued;
+    }
+
+    // send directly if possible
+    if ((instance->input_reports_count == 0) && att_server_can_send_packet_now(con_handle)){
+        att_server_notify(con_handle, value_handle, report, report_len);
+        return ERROR_CODE_SUCCESS;
+    }
+
+    // merge with last queued report of same characteristic
+    if (instance->input_reports_count > 0){
+        uint8_t tail = (instance->input_reports_head + instance->input_reports_count - 1) % HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE;
+        hids_device_input_report_t * last = &instance->input_reports[tail];
+        if ((last->value_handle == value_handle) && (last->len == report_len)){
+            bool queue_full = instance->input_reports_count == HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE;
+            if (hids_device_input_report_merge(last, report, queue_full)){
+                return ERROR_CODE_SUCCESS;
+            }
+        }
+    }
+
+    if (instance->input_reports_count == HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE){
+        // replace last report to keep latency bounded
+        log_info("input report queue full, replace last report");
+        instance->input_reports_count--;
+    }
+
+    uint8_t index = (instance->input_reports_head + instance->input_reports_count) % HIDS_DEVICE_INPUT_REPORT_QUEUE_SIZE;
+    hids_device_input_report_t * input_report = &instance->input_reports[index];
+    input_report->value_handle = value_handle;
+    input_report->len = report_len;
+    (void)memcpy(input_report->data, report, report_len);
+    instance->input_reports_count++;
+
+    att_server_request_to_send_notification(&instance->input_report_callback, con_handle);
+    return ERROR_CODE_SUCCESS;
+}
+
+void hids_device_set_input_report_relative_fields(const hids_device_relative_field_t * fields, uint8_t num_fields){
+    hids_device_input_report_relative_fields = fields;
+    hids_device_input_report_num_relative_fields = num_fields;
+}
+
+uint8_t hids_device_queue_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
+    return hids_device_queue_report(con_handle, hids_device.hid_report_input_value_handle, report, report_len);
+}
+
+uint8_t hids_device_queue_boot_mouse_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
+    return hids_device_queue_report(con_handle, hids_device.hid_boot_mouse_input_value_handle, report, report_len);
+}
+
+uint8_t hids_device_queue_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
+    return hids_device_queue_report(con_handle, hids_device.hid_boot_keyboard_input_value_handle, report, report_len);
+}
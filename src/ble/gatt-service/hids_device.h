@@ -50,6 +50,14 @@ extern "C" {
  * To use with your application, add '#import <hids.gatt>' to your .gatt file
  */
 
+/**
+ * Relative field in Input Report, e.g. X/Y movement or wheel of a mouse. Signed value in little endian bit order
+ */
+typedef struct {
+    uint16_t bit_offset;
+    uint8_t  bit_size;      // 2..16
+} hids_device_relative_field_t;
+
 /**
  * @brief Set up HIDS Device
  */
@@ -93,6 +101,42 @@ void hids_device_send_boot_mouse_input_report(hci_con_handle_t con_handle, const
  */
 void hids_device_send_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
 
+/**
+ * @brief Set relative fields of Input Report that are summed up when queued reports are merged
+ * @param fields array, needs to stay valid
+ * @param num_fields
+ */
+void hids_device_set_input_report_relative_fields(const hids_device_relative_field_t * fields, uint8_t num_fields);
+
+/**
+ * @brief Queue HID Report: Input. Queued reports are sent as soon as possible without a can send now event.
+ * If the last queued report only differs in relative fields, the new report is merged into it by adding up the relative fields.
+ * If the queue is full, the last queued report is replaced, keeping the sum of its relative fields.
+ * @param con_handle
+ * @param report
+ * @param report_len
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if report_len > HIDS_DEVICE_INPUT_REPORT_MAX_SIZE
+ */
+uint8_t hids_device_queue_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
+
+/**
+ * @brief Queue HID Boot Mouse Input Report. X, Y and optional wheel are merged as for hids_device_queue_input_report
+ * @param con_handle
+ * @param report
+ * @param report_len
+ * @return status
+ */
+uint8_t hids_device_queue_boot_mouse_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
+
+/**
+ * @brief Queue HID Boot Keyboard Input Report. Reports are sent in order and not merged
+ * @param con_handle
+ * @param report
+ * @param report_len
+ * @return status
+ */
+uint8_t hids_device_queue_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
+
 #if defined __cplusplus
 }
 #endif
@@ -72,26 +72,51 @@ typedef struct {
 
 static btstack_packet_handler_t mesh_proxy_service_packet_handler;
 static att_service_handler_t mesh_proxy_service;
-static mesh_proxy_t mesh_proxy;
+static mesh_proxy_t mesh_proxy[MESH_PROXY_NUM_CONNECTIONS];
 
+// attribute handles are the same for all connections
+static uint16_t mesh_proxy_data_in_client_value_handle;
+static uint16_t mesh_proxy_data_out_client_value_handle;
+static uint16_t mesh_proxy_data_out_client_configuration_descriptor_handle;
 
 static void mesh_proxy_service_emit_connected(hci_con_handle_t con_handle){
+    if (!mesh_proxy_service_packet_handler) return;
     uint8_t event[5] = { HCI_EVENT_MESH_META, 3, MESH_SUBEVENT_PROXY_CONNECTED};
-    little_endian_store_16(event, 4, con_handle);
+    little_endian_store_16(event, 3, con_handle);
     mesh_proxy_service_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
 static void mesh_proxy_service_emit_disconnected(hci_con_handle_t con_handle){
+    if (!mesh_proxy_service_packet_handler) return;
     uint8_t event[5] = { HCI_EVENT_MESH_META, 3, MESH_SUBEVENT_PROXY_DISCONNECTED};
-    little_endian_store_16(event, 4, con_handle);
+    little_endian_store_16(event, 3, con_handle);
     mesh_proxy_service_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
 static mesh_proxy_t * mesh_proxy_service_get_instance_for_con_handle(hci_con_handle_t con_handle){
-    mesh_proxy_t * instance = &mesh_proxy;
     if (con_handle == HCI_CON_HANDLE_INVALID) return NULL;
-    instance->con_handle = con_handle;
-    return instance;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (mesh_proxy[i].con_handle == con_handle) return &mesh_proxy[i];
+    }
+    return NULL;
+}
+
+static mesh_proxy_t * mesh_proxy_service_create_instance_for_con_handle(hci_con_handle_t con_handle){
+    mesh_proxy_t * instance = mesh_proxy_service_get_instance_for_con_handle(con_handle);
+    if (instance) return instance;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        instance = &mesh_proxy[i];
+        if (instance->con_handle != HCI_CON_HANDLE_INVALID) continue;
+        instance->con_handle = con_handle;
+        instance->data_in_client_value_handle = mesh_proxy_data_in_client_value_handle;
+        instance->data_out_client_value_handle = mesh_proxy_data_out_client_value_handle;
+        instance->data_out_client_configuration_descriptor_handle = mesh_proxy_data_out_client_configuration_descriptor_handle;
+        instance->data_out_client_configuration_descriptor_value = 0;
+        return instance;
+    }
+    return NULL;
 }
 
 static uint16_t mesh_proxy_service_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
@@ -100,14 +125,11 @@ static uint16_t mesh_proxy_service_read_callback(hci_con_handle_t con_handle, ui
     UNUSED(offset);
     UNUSED(buffer_size);
     
-    mesh_proxy_t * instance = mesh_proxy_service_get_instance_for_con_handle(con_handle);
-    if (!instance){
-        log_error("mesh_proxy_service_read_callback: instance is null");
-        return 0;
-    }
-    if (attribute_handle == instance->data_out_client_configuration_descriptor_handle){
+    if (attribute_handle == mesh_proxy_data_out_client_configuration_descriptor_handle){
+        mesh_proxy_t * instance = mesh_proxy_service_get_instance_for_con_handle(con_handle);
+        uint16_t value = instance ? instance->data_out_client_configuration_descriptor_value : 0;
         if (buffer && buffer_size >= 2){
-            little_endian_store_16(buffer, 0, instance->data_out_client_configuration_descriptor_value);
+            little_endian_store_16(buffer, 0, value);
         }
         return 2;
     }
@@ -120,10 +142,10 @@ static int mesh_proxy_service_write_callback(hci_con_handle_t con_handle, uint16
     UNUSED(offset);
     UNUSED(buffer_size);
     
-    mesh_proxy_t * instance = mesh_proxy_service_get_instance_for_con_handle(con_handle);
+    mesh_proxy_t * instance = mesh_proxy_service_create_instance_for_con_handle(con_handle);
     if (!instance){
-        log_error("mesh_proxy_service_write_callback: instance is null");
-        return 0;
+        log_error("mesh_proxy_service_write_callback: no free instance, increase MESH_PROXY_NUM_CONNECTIONS");
+        return ATT_ERROR_INSUFFICIENT_RESOURCES;
     }
 
     if (attribute_handle == instance->data_in_client_value_handle){
@@ -136,11 +158,15 @@ static int mesh_proxy_service_write_callback(hci_con_handle_t con_handle, uint16
         if (buffer_size < 2){
             return ATT_ERROR_INVALID_OFFSET;
         }
-        instance->data_out_client_configuration_descriptor_value = little_endian_read_16(buffer, 0);
-        log_info("mesh_proxy_service_write_callback: data out notify enabled %d, con handle 0x%02x", instance->data_out_client_configuration_descriptor_value, con_handle);
-        if (instance->data_out_client_configuration_descriptor_value){
+        uint16_t enable_data_out_notify = little_endian_read_16(buffer, 0);
+        log_info("mesh_proxy_service_write_callback: data out notify enabled %d, con handle 0x%02x", enable_data_out_notify, con_handle);
+        if (enable_data_out_notify){
+            if (instance->data_out_client_configuration_descriptor_value) return 0;
+            instance->data_out_client_configuration_descriptor_value = enable_data_out_notify;
             mesh_proxy_service_emit_connected(con_handle);
         } else {
+            if (!instance->data_out_client_configuration_descriptor_value) return 0;
+            instance->data_out_client_configuration_descriptor_value = enable_data_out_notify;
             mesh_proxy_service_emit_disconnected(con_handle);
         }
         return 0;
@@ -149,11 +175,27 @@ static int mesh_proxy_service_write_callback(hci_con_handle_t con_handle, uint16
     return 0;
 }
 
+static void mesh_proxy_service_server_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_DISCONNECTION_COMPLETE) return;
+    hci_con_handle_t con_handle = hci_event_disconnection_complete_get_connection_handle(packet);
+    mesh_proxy_t * instance = mesh_proxy_service_get_instance_for_con_handle(con_handle);
+    if (!instance) return;
+    // free instance, emit disconnected if client was connected
+    uint16_t notify_enabled = instance->data_out_client_configuration_descriptor_value;
+    instance->con_handle = HCI_CON_HANDLE_INVALID;
+    instance->data_out_client_configuration_descriptor_value = 0;
+    if (notify_enabled){
+        mesh_proxy_service_emit_disconnected(con_handle);
+    }
+}
+
 void mesh_proxy_service_server_init(void){
-    mesh_proxy_t * instance = &mesh_proxy;
-    if (!instance){
-        log_error("mesh_proxy_service_server_init: instance is null");
-        return;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        mesh_proxy[i].con_handle = HCI_CON_HANDLE_INVALID;
     }
 
     // get service handle range
@@ -163,18 +205,19 @@ void mesh_proxy_service_server_init(void){
 
     if (!service_found) return;
 
-    instance->data_in_client_value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(start_handle, end_handle, ORG_BLUETOOTH_CHARACTERISTIC_MESH_PROXY_DATA_IN);
-    instance->data_out_client_value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(start_handle, end_handle, ORG_BLUETOOTH_CHARACTERISTIC_MESH_PROXY_DATA_OUT);
-    instance->data_out_client_configuration_descriptor_handle = gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(start_handle, end_handle, ORG_BLUETOOTH_CHARACTERISTIC_MESH_PROXY_DATA_OUT);
+    mesh_proxy_data_in_client_value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(start_handle, end_handle, ORG_BLUETOOTH_CHARACTERISTIC_MESH_PROXY_DATA_IN);
+    mesh_proxy_data_out_client_value_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(start_handle, end_handle, ORG_BLUETOOTH_CHARACTERISTIC_MESH_PROXY_DATA_OUT);
+    mesh_proxy_data_out_client_configuration_descriptor_handle = gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(start_handle, end_handle, ORG_BLUETOOTH_CHARACTERISTIC_MESH_PROXY_DATA_OUT);
     
-    log_info("DataIn     value handle 0x%02x", instance->data_in_client_value_handle);
-    log_info("DataOut    value handle 0x%02x", instance->data_out_client_value_handle);
-    log_info("DataOut CC value handle 0x%02x", instance->data_out_client_configuration_descriptor_handle);
+    log_info("DataIn     value handle 0x%02x", mesh_proxy_data_in_client_value_handle);
+    log_info("DataOut    value handle 0x%02x", mesh_proxy_data_out_client_value_handle);
+    log_info("DataOut CC value handle 0x%02x", mesh_proxy_data_out_client_configuration_descriptor_handle);
     
     mesh_proxy_service.start_handle   = start_handle;
     mesh_proxy_service.end_handle     = end_handle;
     mesh_proxy_service.read_callback  = &mesh_proxy_service_read_callback;
     mesh_proxy_service.write_callback = &mesh_proxy_service_write_callback;
+    mesh_proxy_service.packet_handler = &mesh_proxy_service_server_packet_handler;
     
     att_server_register_service_handler(&mesh_proxy_service);
 }
@@ -45,6 +45,11 @@
 extern "C" {
 #endif
 
+// number of simultaneous Proxy Clients
+#ifndef MESH_PROXY_NUM_CONNECTIONS
+#define MESH_PROXY_NUM_CONNECTIONS 1
+#endif
+
 /**
  * Implementation of the Mesh Proxy Service Server 
  */
@@ -55,6 +55,7 @@
 #include "btstack_util.h"
 #include "bluetooth_gatt.h"
 #include "btstack_debug.h"
+#include "hci.h"
 
 #include "ble/gatt-service/nordic_spp_service_server.h"
 
@@ -67,6 +68,9 @@ static uint16_t nordic_spp_tx_value_handle;
 static uint16_t nordic_spp_tx_client_configuration_handle;
 static uint16_t nordic_spp_tx_client_configuration_value;
 
+// notification payload for streaming, filled from ring buffer
+static uint8_t  nordic_spp_stream_payload[ATT_REQUEST_BUFFER_SIZE];
+
 static uint16_t nordic_spp_service_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
 	UNUSED(con_handle);
 	UNUSED(offset);
@@ -153,3 +157,54 @@ int nordic_spp_service_server_send(hci_con_handle_t con_handle, const uint8_t *
 	return att_server_notify(con_handle, nordic_spp_tx_value_handle, data, size);
 }
 
+static void nordic_spp_service_server_stream_request(nordic_spp_service_server_stream_t * stream){
+	if (stream->send_request_pending) return;
+	stream->send_request_pending = 1;
+	att_server_request_to_send_notification(&stream->send_request, stream->con_handle);
+}
+
+static void nordic_spp_service_server_stream_send(void * context){
+	nordic_spp_service_server_stream_t * stream = (nordic_spp_service_server_stream_t *) context;
+	stream->send_request_pending = 0;
+
+	// send as many notifications as possible
+	uint32_t payload_size = btstack_min(att_server_get_mtu(stream->con_handle) - 3, sizeof(nordic_spp_stream_payload));
+	int sent = 0;
+	while (!btstack_ring_buffer_empty(&stream->ring_buffer) && att_server_can_send_packet_now(stream->con_handle)){
+		uint32_t bytes_read;
+		btstack_ring_buffer_read(&stream->ring_buffer, nordic_spp_stream_payload, payload_size, &bytes_read);
+		att_server_notify(stream->con_handle, nordic_spp_tx_value_handle, nordic_spp_stream_payload, (uint16_t) bytes_read);
+		sent = 1;
+	}
+
+	if (!btstack_ring_buffer_empty(&stream->ring_buffer)){
+		nordic_spp_service_server_stream_request(stream);
+	}
+
+	if (sent && (stream->space_callback != NULL)){
+		(*stream->space_callback)(stream->con_handle, btstack_ring_buffer_bytes_free(&stream->ring_buffer));
+	}
+}
+
+void nordic_spp_service_server_stream_init(nordic_spp_service_server_stream_t * stream, hci_con_handle_t con_handle, uint8_t * storage, uint32_t storage_size,
+										   void (*space_callback)(hci_con_handle_t con_handle, uint32_t bytes_free)){
+	memset(stream, 0, sizeof(nordic_spp_service_server_stream_t));
+	stream->con_handle = con_handle;
+	stream->space_callback = space_callback;
+	stream->send_request.callback = &nordic_spp_service_server_stream_send;
+	stream->send_request.context  = stream;
+	btstack_ring_buffer_init(&stream->ring_buffer, storage, storage_size);
+}
+
+uint32_t nordic_spp_service_server_stream_write(nordic_spp_service_server_stream_t * stream, const uint8_t * data, uint32_t size){
+	uint32_t bytes_to_write = btstack_min(size, btstack_ring_buffer_bytes_free(&stream->ring_buffer));
+	if (bytes_to_write == 0) return 0;
+	btstack_ring_buffer_write(&stream->ring_buffer, (uint8_t *) data, bytes_to_write);
+	nordic_spp_service_server_stream_request(stream);
+	return bytes_to_write;
+}
+
+uint32_t nordic_spp_service_server_stream_bytes_free(nordic_spp_service_server_stream_t * stream){
+	return btstack_ring_buffer_bytes_free(&stream->ring_buffer);
+}
+
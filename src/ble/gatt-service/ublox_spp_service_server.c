@@ -44,6 +44,8 @@
  * and call all functions below. All strings and blobs need to stay valid after calling the functions.
  */
 
+#include <string.h>
+
 #include "btstack_defines.h"
 #include "btstack_event.h"
 #include "btstack_debug.h"
@@ -93,6 +95,9 @@ typedef struct {
 static att_service_handler_t  ublox_spp_service;
 static ublox_spp_service_t    ublox_spp;
 
+// notification payload for streaming, filled from ring buffer
+static uint8_t ublox_spp_stream_payload[ATT_REQUEST_BUFFER_SIZE];
+
 static int ublox_spp_service_flow_control_enabled(ublox_spp_service_t * instance){
     return instance->credits_client_configuration_descriptor_value;
 }
@@ -274,3 +279,56 @@ int ublox_spp_service_server_send(hci_con_handle_t con_handle, const uint8_t * d
     return att_server_notify(con_handle, instance->fifo_value_handle, &data[0], size);
 }
 
+static void ublox_spp_service_server_stream_request(ublox_spp_service_server_stream_t * stream){
+    if (stream->send_request_pending) return;
+    stream->send_request_pending = 1;
+    ublox_spp_service_server_request_can_send_now(&stream->send_request, stream->con_handle);
+}
+
+static void ublox_spp_service_server_stream_send(void * context){
+    ublox_spp_service_server_stream_t * stream = (ublox_spp_service_server_stream_t *) context;
+    ublox_spp_service_t * instance = &ublox_spp;
+    stream->send_request_pending = 0;
+
+    // send as many notifications as possible and allowed by outgoing credits
+    uint32_t payload_size = btstack_min(att_server_get_mtu(stream->con_handle) - 3, sizeof(ublox_spp_stream_payload));
+    int sent = 0;
+    while (!btstack_ring_buffer_empty(&stream->ring_buffer) && att_server_can_send_packet_now(stream->con_handle)){
+        if (ublox_spp_service_flow_control_enabled(instance) && (instance->outgoing_credits == 0)) break;
+        uint32_t bytes_read;
+        btstack_ring_buffer_read(&stream->ring_buffer, ublox_spp_stream_payload, payload_size, &bytes_read);
+        ublox_spp_service_server_send(stream->con_handle, ublox_spp_stream_payload, (uint16_t) bytes_read);
+        sent = 1;
+    }
+
+    if (!btstack_ring_buffer_empty(&stream->ring_buffer)){
+        ublox_spp_service_server_stream_request(stream);
+    }
+
+    if (sent && (stream->space_callback != NULL)){
+        (*stream->space_callback)(stream->con_handle, btstack_ring_buffer_bytes_free(&stream->ring_buffer));
+    }
+}
+
+void ublox_spp_service_server_stream_init(ublox_spp_service_server_stream_t * stream, hci_con_handle_t con_handle, uint8_t * storage, uint32_t storage_size,
+                                          void (*space_callback)(hci_con_handle_t con_handle, uint32_t bytes_free)){
+    memset(stream, 0, sizeof(ublox_spp_service_server_stream_t));
+    stream->con_handle = con_handle;
+    stream->space_callback = space_callback;
+    stream->send_request.callback = &ublox_spp_service_server_stream_send;
+    stream->send_request.context  = stream;
+    btstack_ring_buffer_init(&stream->ring_buffer, storage, storage_size);
+}
+
+uint32_t ublox_spp_service_server_stream_write(ublox_spp_service_server_stream_t * stream, const uint8_t * data, uint32_t size){
+    uint32_t bytes_to_write = btstack_min(size, btstack_ring_buffer_bytes_free(&stream->ring_buffer));
+    if (bytes_to_write == 0) return 0;
+    btstack_ring_buffer_write(&stream->ring_buffer, (uint8_t *) data, bytes_to_write);
+    ublox_spp_service_server_stream_request(stream);
+    return bytes_to_write;
+}
+
+uint32_t ublox_spp_service_server_stream_bytes_free(ublox_spp_service_server_stream_t * stream){
+    return btstack_ring_buffer_bytes_free(&stream->ring_buffer);
+}
+
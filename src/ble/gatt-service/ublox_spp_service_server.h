@@ -40,6 +40,7 @@
 #include <stdint.h>
 #include "bluetooth.h"
 #include "btstack_defines.h"
+#include "btstack_ring_buffer.h"
 
 #if defined __cplusplus
 extern "C" {
@@ -47,6 +48,14 @@ extern "C" {
 
 /* API_START */
 
+typedef struct {
+    hci_con_handle_t        con_handle;
+    btstack_ring_buffer_t   ring_buffer;
+    btstack_context_callback_registration_t send_request;
+    uint8_t                 send_request_pending;
+    void (*space_callback)(hci_con_handle_t con_handle, uint32_t bytes_free);
+} ublox_spp_service_server_stream_t;
+
 /**
  * Implementation of the ublox SPP-like profile
  *
@@ -77,6 +86,35 @@ void ublox_spp_service_server_request_can_send_now(btstack_context_callback_regi
  */
 int ublox_spp_service_server_send(hci_con_handle_t con_handle, const uint8_t * data, uint16_t size);
 
+/**
+ * @brief Init streaming mode for connection. Data written to the stream is buffered and sent in notifications
+ *        of ATT MTU size as long as the connection can send and outgoing credits are available
+ * @note The stream uses the send request of ublox_spp_service_server_request_can_send_now while waiting for credits
+ * @param stream context, needs to stay valid until disconnect
+ * @param con_handle
+ * @param storage for ring buffer, needs to stay valid until disconnect
+ * @param storage_size
+ * @param space_callback (optional) called after buffered data was sent with number of free bytes in stream
+ */
+void ublox_spp_service_server_stream_init(ublox_spp_service_server_stream_t * stream, hci_con_handle_t con_handle, uint8_t * storage, uint32_t storage_size,
+                                          void (*space_callback)(hci_con_handle_t con_handle, uint32_t bytes_free));
+
+/**
+ * @brief Write data to stream
+ * @param stream
+ * @param data
+ * @param size
+ * @return number of bytes buffered, less than size if stream is full
+ */
+uint32_t ublox_spp_service_server_stream_write(ublox_spp_service_server_stream_t * stream, const uint8_t * data, uint32_t size);
+
+/**
+ * @brief Get free space in stream
+ * @param stream
+ * @return number of bytes that can be written
+ */
+uint32_t ublox_spp_service_server_stream_bytes_free(ublox_spp_service_server_stream_t * stream);
+
 /* API_END */
 
 #if defined __cplusplus
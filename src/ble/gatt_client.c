@@ -53,6 +53,7 @@
 #include "btstack_event.h"
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
+#include "btstack_tlv.h"
 #include "btstack_util.h"
 #include "classic/sdp_util.h"
 #include "hci.h"
@@ -73,6 +74,9 @@ static uint8_t mtu_exchange_enabled;
 static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size);
 static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 static void gatt_client_report_error_if_pending(gatt_client_t *peripheral, uint8_t att_error_code);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+static void gatt_client_run(void);
+#endif
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static void att_signed_write_handle_cmac_result(uint8_t hash[8]);
@@ -286,10 +290,10 @@ static uint8_t att_read_blob_request(uint16_t request_type, uint16_t peripheral_
     return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 5);
 }
 
-static uint8_t att_read_multiple_request(uint16_t peripheral_handle, uint16_t num_value_handles, uint16_t * value_handles){
+static uint8_t att_read_multiple_request(uint8_t request_type, uint16_t peripheral_handle, uint16_t num_value_handles, uint16_t * value_handles){
     l2cap_reserve_packet_buffer();
     uint8_t * request = l2cap_get_outgoing_buffer();
-    request[0] = ATT_READ_MULTIPLE_REQUEST;
+    request[0] = request_type;
     int i;
     int offset = 1;
     for (i=0;i<num_value_handles;i++){
@@ -423,7 +427,23 @@ static void send_gatt_read_blob_request(gatt_client_t *peripheral){
 }
 
 static void send_gatt_read_multiple_request(gatt_client_t * peripheral){
-    att_read_multiple_request(peripheral->con_handle, peripheral->read_multiple_handle_count, peripheral->read_multiple_handles);
+    att_read_multiple_request(ATT_READ_MULTIPLE_REQUEST, peripheral->con_handle, peripheral->read_multiple_handle_count, peripheral->read_multiple_handles);
+}
+
+static void send_gatt_read_multiple_variable_request(gatt_client_t * peripheral){
+    att_read_multiple_request(ATT_READ_MULTIPLE_VARIABLE_REQUEST, peripheral->con_handle, peripheral->read_multiple_handle_count, peripheral->read_multiple_handles);
+}
+
+// number of handles for next Read Multiple Variable Length Request, limited by MTU
+static uint16_t read_long_multiple_num_handles(gatt_client_t * peripheral){
+    uint16_t num_handles = peripheral->read_multiple_handle_count - peripheral->read_multiple_handle_index;
+    uint16_t max_handles = (peripheral_mtu(peripheral) - 1) / 2;
+    return (uint16_t) btstack_min(num_handles, max_handles);
+}
+
+static void send_gatt_read_long_multiple_variable_request(gatt_client_t * peripheral){
+    att_read_multiple_request(ATT_READ_MULTIPLE_VARIABLE_REQUEST, peripheral->con_handle, read_long_multiple_num_handles(peripheral),
+                              &peripheral->read_multiple_handles[peripheral->read_multiple_handle_index]);
 }
 
 static void send_gatt_write_attribute_value_request(gatt_client_t * peripheral){
@@ -477,9 +497,31 @@ static uint16_t get_last_result_handle_from_included_services_list(uint8_t * pac
     return little_endian_read_16(packet, size - attr_length);
 }
 
+static void gatt_client_query_request_handler(btstack_timer_source_t * timer){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(timer);
+    gatt_client_t * peripheral = get_gatt_client_context_for_handle(con_handle);
+    if (peripheral == NULL) return;
+    // start next queued query if ready, callbacks that don't start a query are skipped
+    while (is_ready(peripheral) && !btstack_linked_list_empty(&peripheral->query_requests)){
+        btstack_context_callback_registration_t * request = (btstack_context_callback_registration_t *) btstack_linked_list_pop(&peripheral->query_requests);
+        (*request->callback)(request->context);
+    }
+}
+
+// callbacks are executed from run loop to not start a query while the previous one is completed
+static void gatt_client_query_requests_schedule(gatt_client_t * peripheral){
+    if (btstack_linked_list_empty(&peripheral->query_requests)) return;
+    btstack_run_loop_remove_timer(&peripheral->query_request_timer);
+    btstack_run_loop_set_timer_handler(&peripheral->query_request_timer, gatt_client_query_request_handler);
+    btstack_run_loop_set_timer_context(&peripheral->query_request_timer, (void *) (uintptr_t) peripheral->con_handle);
+    btstack_run_loop_set_timer(&peripheral->query_request_timer, 0);
+    btstack_run_loop_add_timer(&peripheral->query_request_timer);
+}
+
 static void gatt_client_handle_transaction_complete(gatt_client_t * peripheral){
     peripheral->gatt_client_state = P_READY;
     gatt_client_timeout_stop(peripheral);
+    gatt_client_query_requests_schedule(peripheral);
 }
 
 static void emit_event_new(btstack_packet_handler_t callback, uint8_t * packet, uint16_t size){
@@ -514,6 +556,140 @@ static void emit_event_to_registered_listeners(hci_con_handle_t con_handle, uint
     } 
 }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+// MARK: GATT Client Cache
+
+// records: type, payload len, payload
+#define GATT_CLIENT_CACHE_RECORD_SERVICE                    1
+#define GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC             2
+#define GATT_CLIENT_CACHE_RECORD_DESCRIPTOR                 3
+#define GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE          4
+#define GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE   5
+#define GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE       6
+
+static uint32_t gatt_client_cache_tag_for_index(uint8_t index){
+    return ('B' << 24) | ('T' << 16) | ('G' << 8) | index;
+}
+
+static void gatt_client_cache_append(gatt_client_t * peripheral, uint8_t type, const uint8_t * payload, uint8_t payload_len){
+    if (peripheral->cache_record_failed) return;
+    if ((peripheral->cache_len + 2 + payload_len) > GATT_CLIENT_CACHE_SIZE){
+        log_info("GATT Client Cache: full, results not cached");
+        peripheral->cache_record_failed = 1;
+        return;
+    }
+    uint8_t * record = &peripheral->cache_data[GATT_CLIENT_CACHE_HEADER_SIZE + peripheral->cache_len];
+    record[0] = type;
+    record[1] = payload_len;
+    (void)memcpy(&record[2], payload, payload_len);
+    peripheral->cache_len += 2 + payload_len;
+}
+
+// store Bluetooth Base UUIDs as UUID16, @returns new pos
+static uint8_t gatt_client_cache_store_uuid(uint8_t * buffer, uint8_t pos, const uint8_t * uuid128){
+    if (uuid_has_bluetooth_prefix(uuid128)){
+        little_endian_store_16(buffer, pos, big_endian_read_16(uuid128, 2));
+        return pos + 2;
+    }
+    (void)memcpy(&buffer[pos], uuid128, 16);
+    return pos + 16;
+}
+
+static void gatt_client_cache_record_service(gatt_client_t * peripheral, uint16_t start_group_handle, uint16_t end_group_handle, const uint8_t * uuid128){
+    if (peripheral->cache_query != GATT_CLIENT_CACHE_QUERY_SERVICES) return;
+    uint8_t payload[20];
+    little_endian_store_16(payload, 0, start_group_handle);
+    little_endian_store_16(payload, 2, end_group_handle);
+    uint8_t pos = gatt_client_cache_store_uuid(payload, 4, uuid128);
+    gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_SERVICE, payload, pos);
+}
+
+static void gatt_client_cache_record_characteristic(gatt_client_t * peripheral, uint16_t start_handle, uint16_t value_handle, uint16_t end_handle,
+        uint16_t properties, const uint8_t * uuid128){
+    if (peripheral->cache_query != GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS) return;
+    uint8_t payload[23];
+    little_endian_store_16(payload, 0, start_handle);
+    little_endian_store_16(payload, 2, value_handle);
+    little_endian_store_16(payload, 4, end_handle);
+    payload[6] = (uint8_t) properties;
+    uint8_t pos = gatt_client_cache_store_uuid(payload, 7, uuid128);
+    gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC, payload, pos);
+}
+
+static void gatt_client_cache_record_descriptor(gatt_client_t * peripheral, uint16_t descriptor_handle, const uint8_t * uuid128){
+    if (peripheral->cache_query != GATT_CLIENT_CACHE_QUERY_DESCRIPTORS) return;
+    uint8_t payload[18];
+    little_endian_store_16(payload, 0, descriptor_handle);
+    uint8_t pos = gatt_client_cache_store_uuid(payload, 2, uuid128);
+    gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_DESCRIPTOR, payload, pos);
+}
+
+static void gatt_client_cache_store(gatt_client_t * peripheral){
+    int le_device_index = sm_le_device_index(peripheral->con_handle);
+    if (le_device_index < 0) return;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    log_info("GATT Client Cache: store %u bytes for le device id %d", peripheral->cache_len, le_device_index);
+    tlv_impl->store_tag(tlv_context, gatt_client_cache_tag_for_index(le_device_index), peripheral->cache_data,
+                        GATT_CLIENT_CACHE_HEADER_SIZE + peripheral->cache_len);
+}
+
+static void gatt_client_cache_delete(gatt_client_t * peripheral){
+    int le_device_index = sm_le_device_index(peripheral->con_handle);
+    if (le_device_index < 0) return;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    tlv_impl->delete_tag(tlv_context, gatt_client_cache_tag_for_index(le_device_index));
+}
+
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t att_status){
+    gatt_client_cache_query_t query = peripheral->cache_query;
+    peripheral->cache_query = GATT_CLIENT_CACHE_QUERY_NONE;
+    if (query == GATT_CLIENT_CACHE_QUERY_NONE) return;
+
+    // query aborted while reading Database Hash
+    if (peripheral->cache_state != GATT_CLIENT_CACHE_STATE_VALID) return;
+
+    if (att_status == ATT_ERROR_SUCCESS){
+        uint8_t payload[4];
+        little_endian_store_16(payload, 0, peripheral->cache_query_start_handle);
+        little_endian_store_16(payload, 2, peripheral->cache_query_end_handle);
+        switch (query){
+            case GATT_CLIENT_CACHE_QUERY_SERVICES:
+                gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE, payload, 0);
+                break;
+            case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+                gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE, payload, 4);
+                break;
+            case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+                gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE, payload, 4);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if ((att_status != ATT_ERROR_SUCCESS) || peripheral->cache_record_failed){
+        // drop partial results
+        peripheral->cache_len = peripheral->cache_record_start;
+        peripheral->cache_record_failed = 0;
+        return;
+    }
+
+    gatt_client_cache_store(peripheral);
+}
+#endif
+
 static void emit_gatt_complete_event(gatt_client_t * peripheral, uint8_t att_status){
     // @format H1
     uint8_t packet[5];
@@ -521,6 +697,9 @@ static void emit_gatt_complete_event(gatt_client_t * peripheral, uint8_t att_sta
     packet[1] = 3;
     little_endian_store_16(packet, 2, peripheral->con_handle);
     packet[4] = att_status;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_query_complete(peripheral, att_status);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -534,6 +713,9 @@ static void emit_gatt_service_query_result_event(gatt_client_t * peripheral, uin
     little_endian_store_16(packet, 4, start_group_handle);
     little_endian_store_16(packet, 6, end_group_handle);
     reverse_128(uuid128, &packet[8]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_service(peripheral, start_group_handle, end_group_handle, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -565,6 +747,9 @@ static void emit_gatt_characteristic_query_result_event(gatt_client_t * peripher
     little_endian_store_16(packet, 8,  end_handle);
     little_endian_store_16(packet, 10, properties);
     reverse_128(uuid128, &packet[12]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_characteristic(peripheral, start_handle, value_handle, end_handle, properties, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -578,6 +763,9 @@ static void emit_gatt_all_characteristic_descriptors_result_event(
     ///
     little_endian_store_16(packet, 4,  descriptor_handle);
     reverse_128(uuid128, &packet[6]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_descriptor(peripheral, descriptor_handle, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -774,6 +962,252 @@ static void report_gatt_all_characteristic_descriptors(gatt_client_t * periphera
     
 }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+static bool gatt_client_cache_read_uuid(const uint8_t * buffer, uint8_t uuid_len, uint8_t * uuid128){
+    switch (uuid_len){
+        case 2:
+            uuid_add_bluetooth_prefix(uuid128, little_endian_read_16(buffer, 0));
+            return true;
+        case 16:
+            (void)memcpy(uuid128, buffer, 16);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void gatt_client_cache_load(gatt_client_t * peripheral, const uint8_t * database_hash){
+    peripheral->cache_len = 0;
+    peripheral->cache_record_failed = 0;
+    peripheral->cache_state = GATT_CLIENT_CACHE_STATE_VALID;
+
+    // header: identity address type, identity address, database hash
+    int le_device_index = sm_le_device_index(peripheral->con_handle);
+    int identity_addr_type = BD_ADDR_TYPE_UNKNOWN;
+    bd_addr_t identity_addr;
+    memset(identity_addr, 0, 6);
+    if (le_device_index >= 0){
+        le_device_db_info(le_device_index, &identity_addr_type, identity_addr, NULL);
+    }
+    uint8_t header[GATT_CLIENT_CACHE_HEADER_SIZE];
+    header[0] = (uint8_t) identity_addr_type;
+    (void)memcpy(&header[1], identity_addr, 6);
+    (void)memcpy(&header[7], database_hash, 16);
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl && (le_device_index >= 0)){
+        uint32_t tag = gatt_client_cache_tag_for_index(le_device_index);
+        int len = tlv_impl->get_tag(tlv_context, tag, peripheral->cache_data, sizeof(peripheral->cache_data));
+        if ((len >= GATT_CLIENT_CACHE_HEADER_SIZE) && (memcmp(peripheral->cache_data, header, GATT_CLIENT_CACHE_HEADER_SIZE) == 0)){
+            peripheral->cache_len = len - GATT_CLIENT_CACHE_HEADER_SIZE;
+            log_info("GATT Client Cache: restored %u bytes for %s", peripheral->cache_len, bd_addr_to_str(identity_addr));
+            return;
+        }
+        if (len > 0){
+            log_info("GATT Client Cache: Database Hash or identity changed, drop cache");
+            gatt_client_cache_delete(peripheral);
+        }
+    }
+    (void)memcpy(peripheral->cache_data, header, GATT_CLIENT_CACHE_HEADER_SIZE);
+}
+
+static bool gatt_client_cache_has_results(gatt_client_t * peripheral, gatt_client_cache_query_t query){
+    uint8_t complete_type;
+    switch (query){
+        case GATT_CLIENT_CACHE_QUERY_SERVICES:
+        case GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID:
+            complete_type = GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE;
+            break;
+        case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+            complete_type = GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE;
+            break;
+        case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+            complete_type = GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE;
+            break;
+        default:
+            return false;
+    }
+    const uint8_t * records = &peripheral->cache_data[GATT_CLIENT_CACHE_HEADER_SIZE];
+    uint16_t pos = 0;
+    while ((pos + 2) <= peripheral->cache_len){
+        uint8_t type = records[pos];
+        uint8_t len  = records[pos+1];
+        const uint8_t * payload = &records[pos+2];
+        if ((pos + 2 + len) > peripheral->cache_len) break;
+        pos += 2 + len;
+        if (type != complete_type) continue;
+        if (complete_type == GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE) return true;
+        if (len < 4) continue;
+        if (little_endian_read_16(payload, 0) != peripheral->start_group_handle) continue;
+        if (little_endian_read_16(payload, 2) != peripheral->end_group_handle)   continue;
+        return true;
+    }
+    return false;
+}
+
+static void gatt_client_cache_report(gatt_client_t * peripheral, gatt_client_cache_query_t query){
+    log_info("GATT Client Cache: report results for query %u", (int) query);
+    uint16_t start_handle = peripheral->start_group_handle;
+    uint16_t end_handle   = peripheral->end_group_handle;
+    gatt_client_handle_transaction_complete(peripheral);
+
+    const uint8_t * records = &peripheral->cache_data[GATT_CLIENT_CACHE_HEADER_SIZE];
+    uint16_t pos = 0;
+    while ((pos + 2) <= peripheral->cache_len){
+        uint8_t type = records[pos];
+        uint8_t len  = records[pos+1];
+        const uint8_t * payload = &records[pos+2];
+        if ((pos + 2 + len) > peripheral->cache_len) break;
+        pos += 2 + len;
+
+        uint8_t uuid128[16];
+        uint16_t handle;
+        switch (type){
+            case GATT_CLIENT_CACHE_RECORD_SERVICE:
+                if ((query != GATT_CLIENT_CACHE_QUERY_SERVICES) && (query != GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID)) break;
+                if (len < 4) break;
+                if (!gatt_client_cache_read_uuid(&payload[4], len - 4, uuid128)) break;
+                if ((query == GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID) && (memcmp(uuid128, peripheral->uuid128, 16) != 0)) break;
+                emit_gatt_service_query_result_event(peripheral, little_endian_read_16(payload, 0), little_endian_read_16(payload, 2), uuid128);
+                break;
+            case GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC:
+                if (query != GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS) break;
+                if (len < 7) break;
+                handle = little_endian_read_16(payload, 0);
+                if ((handle < start_handle) || (handle > end_handle)) break;
+                if (!gatt_client_cache_read_uuid(&payload[7], len - 7, uuid128)) break;
+                emit_gatt_characteristic_query_result_event(peripheral, handle, little_endian_read_16(payload, 2),
+                                                            little_endian_read_16(payload, 4), payload[6], uuid128);
+                break;
+            case GATT_CLIENT_CACHE_RECORD_DESCRIPTOR:
+                if (query != GATT_CLIENT_CACHE_QUERY_DESCRIPTORS) break;
+                if (len < 2) break;
+                handle = little_endian_read_16(payload, 0);
+                if ((handle < start_handle) || (handle > end_handle)) break;
+                if (!gatt_client_cache_read_uuid(&payload[2], len - 2, uuid128)) break;
+                emit_gatt_all_characteristic_descriptors_result_event(peripheral, handle, uuid128);
+                break;
+            default:
+                break;
+        }
+    }
+    emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
+}
+
+static void gatt_client_cache_start_query(gatt_client_t * peripheral, gatt_client_cache_query_t query);
+
+static void gatt_client_cache_report_handler(btstack_timer_source_t * timer){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(timer);
+    gatt_client_t * peripheral = get_gatt_client_context_for_handle(con_handle);
+    if (peripheral == NULL) return;
+    if (peripheral->gatt_client_state != P_W2_REPORT_CACHED_RESULTS) return;
+    if (peripheral->cache_state == GATT_CLIENT_CACHE_STATE_VALID){
+        gatt_client_cache_report(peripheral, peripheral->cache_report_query);
+        return;
+    }
+    // cache dropped by Service Changed in the meantime, perform query
+    gatt_client_timeout_start(peripheral);
+    peripheral->gatt_client_state = peripheral->cache_pending_state;
+    gatt_client_cache_start_query(peripheral, peripheral->cache_report_query);
+    gatt_client_run();
+}
+
+// results are reported from run loop to not emit events before the query function returned
+static void gatt_client_cache_report_deferred(gatt_client_t * peripheral, gatt_client_cache_query_t query){
+    peripheral->cache_report_query  = query;
+    peripheral->cache_pending_state = peripheral->gatt_client_state;
+    peripheral->gatt_client_state   = P_W2_REPORT_CACHED_RESULTS;
+    btstack_run_loop_remove_timer(&peripheral->cache_report_timer);
+    btstack_run_loop_set_timer_handler(&peripheral->cache_report_timer, gatt_client_cache_report_handler);
+    btstack_run_loop_set_timer_context(&peripheral->cache_report_timer, (void *) (uintptr_t) peripheral->con_handle);
+    btstack_run_loop_set_timer(&peripheral->cache_report_timer, 0);
+    btstack_run_loop_add_timer(&peripheral->cache_report_timer);
+}
+
+// Service Changed indication: drop cache, Database Hash is read again on next query
+static void gatt_client_cache_handle_indication(gatt_client_t * peripheral, uint16_t value_handle){
+    if (peripheral->cache_state != GATT_CLIENT_CACHE_STATE_VALID) return;
+
+    // look up Service Changed characteristic in cache
+    const uint8_t * records = &peripheral->cache_data[GATT_CLIENT_CACHE_HEADER_SIZE];
+    uint16_t pos = 0;
+    bool service_changed = false;
+    while ((pos + 2) <= peripheral->cache_len){
+        uint8_t type = records[pos];
+        uint8_t len  = records[pos+1];
+        const uint8_t * payload = &records[pos+2];
+        if ((pos + 2 + len) > peripheral->cache_len) break;
+        pos += 2 + len;
+        if (type != GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC) continue;
+        if (len < 7) continue;
+        if (little_endian_read_16(payload, 2) != value_handle) continue;
+        uint8_t uuid128[16];
+        if (!gatt_client_cache_read_uuid(&payload[7], len - 7, uuid128)) continue;
+        service_changed = uuid_has_bluetooth_prefix(uuid128) && (big_endian_read_32(uuid128, 0) == GAP_SERVICE_CHANGED);
+        break;
+    }
+    if (!service_changed) return;
+
+    log_info("GATT Client Cache: Service Changed, drop cache");
+    gatt_client_cache_delete(peripheral);
+    peripheral->cache_len = 0;
+    peripheral->cache_record_failed = 0;
+    peripheral->cache_state = GATT_CLIENT_CACHE_STATE_UNKNOWN;
+}
+
+// called after query has been setup, answers query from cache or prepares recording of results
+static void gatt_client_cache_start_query(gatt_client_t * peripheral, gatt_client_cache_query_t query){
+    peripheral->cache_query = GATT_CLIENT_CACHE_QUERY_NONE;
+    switch (peripheral->cache_state){
+        case GATT_CLIENT_CACHE_STATE_UNKNOWN: {
+            // only bonded devices are cached
+            if (sm_le_device_index(peripheral->con_handle) < 0) return;
+            const btstack_tlv_t * tlv_impl = NULL;
+            void * tlv_context;
+            btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+            if (!tlv_impl) return;
+            // read Database Hash first, query is started afterwards
+            peripheral->cache_query = query;
+            peripheral->cache_pending_state = peripheral->gatt_client_state;
+            peripheral->gatt_client_state = P_W2_SEND_READ_DATABASE_HASH_QUERY;
+            return;
+        }
+        case GATT_CLIENT_CACHE_STATE_VALID:
+            break;
+        default:
+            return;
+    }
+
+    if (gatt_client_cache_has_results(peripheral, query)){
+        gatt_client_cache_report_deferred(peripheral, query);
+        return;
+    }
+
+    // only complete lists are recorded
+    if (query == GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID) return;
+    peripheral->cache_query = query;
+    peripheral->cache_query_start_handle = peripheral->start_group_handle;
+    peripheral->cache_query_end_handle   = peripheral->end_group_handle;
+    peripheral->cache_record_start  = peripheral->cache_len;
+    peripheral->cache_record_failed = 0;
+}
+
+// database_hash is NULL if it could not be read
+static void gatt_client_cache_handle_database_hash(gatt_client_t * peripheral, const uint8_t * database_hash){
+    if (database_hash == NULL){
+        log_info("GATT Client Cache: Database Hash not available");
+        peripheral->cache_state = GATT_CLIENT_CACHE_STATE_DISABLED;
+    } else {
+        gatt_client_cache_load(peripheral, database_hash);
+    }
+    peripheral->gatt_client_state = peripheral->cache_pending_state;
+    gatt_client_cache_start_query(peripheral, peripheral->cache_query);
+}
+#endif
+
 static int is_query_done(gatt_client_t * peripheral, uint16_t last_result_handle){
     return last_result_handle >= peripheral->end_group_handle;
 }
@@ -842,6 +1276,63 @@ static void trigger_next_blob_query(gatt_client_t * peripheral, gatt_client_stat
 }
 
 
+// continue with remaining handles of read long multiple
+static void trigger_next_read_long_multiple_query(gatt_client_t * peripheral){
+    if (peripheral->read_multiple_handle_index >= peripheral->read_multiple_handle_count){
+        gatt_client_handle_transaction_complete(peripheral);
+        emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
+        return;
+    }
+    peripheral->attribute_handle = peripheral->read_multiple_handles[peripheral->read_multiple_handle_index];
+    peripheral->attribute_offset = 0;
+    uint16_t num_handles = peripheral->read_multiple_handle_count - peripheral->read_multiple_handle_index;
+    if ((num_handles >= 2) && (peripheral->read_multiple_variable_not_supported == 0)){
+        peripheral->gatt_client_state = P_W2_SEND_READ_LONG_MULTIPLE_VARIABLE_REQUEST;
+    } else {
+        peripheral->gatt_client_state = P_W2_SEND_READ_LONG_MULTIPLE_BLOB_QUERY;
+    }
+}
+
+// Read Response for first or Read Blob Response for following chunks of a single value
+static void handle_read_long_multiple_blob_response(gatt_client_t * peripheral, uint8_t * blob, uint16_t blob_length){
+    report_gatt_long_characteristic_value_blob(peripheral, peripheral->attribute_handle, blob, blob_length, peripheral->attribute_offset);
+    if (blob_length < (peripheral_mtu(peripheral) - 1)){
+        // value complete
+        peripheral->read_multiple_handle_index++;
+        trigger_next_read_long_multiple_query(peripheral);
+        return;
+    }
+    peripheral->attribute_offset += blob_length;
+    peripheral->gatt_client_state = P_W2_SEND_READ_LONG_MULTIPLE_BLOB_QUERY;
+}
+
+static void handle_read_long_multiple_variable_response(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+    uint16_t num_handles = read_long_multiple_num_handles(peripheral);
+    uint16_t offset = 1;
+    uint16_t i;
+    for (i = 0; (i < num_handles) && ((offset + 2) <= size); i++){
+        uint16_t value_handle = peripheral->read_multiple_handles[peripheral->read_multiple_handle_index];
+        uint16_t value_length = little_endian_read_16(packet, offset);
+        offset += 2;
+        uint16_t chunk_length = (uint16_t) btstack_min(value_length, size - offset);
+        report_gatt_long_characteristic_value_blob(peripheral, value_handle, &packet[offset], chunk_length, 0);
+        offset += chunk_length;
+        if (chunk_length < value_length){
+            // value truncated, continue with Read Blob
+            peripheral->attribute_handle = value_handle;
+            peripheral->attribute_offset = chunk_length;
+            peripheral->gatt_client_state = P_W2_SEND_READ_LONG_MULTIPLE_BLOB_QUERY;
+            return;
+        }
+        peripheral->read_multiple_handle_index++;
+    }
+    if (i == 0){
+        // no value in response, avoid sending the same request again
+        peripheral->read_multiple_variable_not_supported = 1;
+    }
+    trigger_next_read_long_multiple_query(peripheral);
+}
+
 static int is_value_valid(gatt_client_t *peripheral, uint8_t *packet, uint16_t size){
     uint16_t attribute_handle = little_endian_read_16(packet, 1);
     uint16_t value_offset = little_endian_read_16(packet, 3);
@@ -851,6 +1342,43 @@ static int is_value_valid(gatt_client_t *peripheral, uint8_t *packet, uint16_t s
     return memcmp(&peripheral->attribute_value[peripheral->attribute_offset], &packet[5], size-5) == 0;
 }
 
+// precondition: can_send_packet_now == TRUE
+static int gatt_client_write_stream_send(gatt_client_t * peripheral){
+    uint16_t max_chunk_len = peripheral_mtu(peripheral) - 3;
+    uint16_t num_packets = 0;
+    while (true){
+        l2cap_reserve_packet_buffer();
+        uint8_t * request = l2cap_get_outgoing_buffer();
+        uint16_t chunk_len = (*peripheral->write_stream_provider)(peripheral->con_handle, peripheral->write_stream_value_handle, &request[3], max_chunk_len);
+        if (chunk_len == 0){
+            l2cap_release_packet_buffer();
+            peripheral->write_stream_paused = 1;
+            break;
+        }
+        if (chunk_len > max_chunk_len){
+            chunk_len = max_chunk_len;
+        }
+        request[0] = ATT_WRITE_COMMAND;
+        little_endian_store_16(request, 1, peripheral->write_stream_value_handle);
+        l2cap_send_prepared_connectionless(peripheral->con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 3 + chunk_len);
+        peripheral->write_stream_bytes_sent += chunk_len;
+        num_packets++;
+        // fill all available buffers
+        if (!att_dispatch_client_can_send_now(peripheral->con_handle)) break;
+    }
+    if (num_packets == 0) return 0;
+
+    // @format H24
+    uint8_t event[10];
+    event[0] = GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event, 2, peripheral->con_handle);
+    little_endian_store_16(event, 4, peripheral->write_stream_value_handle);
+    little_endian_store_32(event, 6, peripheral->write_stream_bytes_sent);
+    emit_event_new(peripheral->write_stream_callback, event, sizeof(event));
+    return 1;
+}
+
 // returns 1 if packet was sent
 static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
     // log_info("- handle_peripheral_list, mtu state %u, client state %u", peripheral->mtu_state, peripheral->gatt_client_state);
@@ -950,6 +1478,25 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             send_gatt_read_multiple_request(peripheral);
             return 1;
 
+        case P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST:
+            peripheral->gatt_client_state = P_W4_READ_MULTIPLE_VARIABLE_RESPONSE;
+            send_gatt_read_multiple_variable_request(peripheral);
+            return 1;
+
+        case P_W2_SEND_READ_LONG_MULTIPLE_VARIABLE_REQUEST:
+            peripheral->gatt_client_state = P_W4_READ_LONG_MULTIPLE_VARIABLE_RESPONSE;
+            send_gatt_read_long_multiple_variable_request(peripheral);
+            return 1;
+
+        case P_W2_SEND_READ_LONG_MULTIPLE_BLOB_QUERY:
+            peripheral->gatt_client_state = P_W4_READ_LONG_MULTIPLE_BLOB_RESULT;
+            if (peripheral->attribute_offset == 0){
+                send_gatt_read_characteristic_value_request(peripheral);
+            } else {
+                send_gatt_read_blob_request(peripheral);
+            }
+            return 1;
+
         case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
             peripheral->gatt_client_state = P_W4_WRITE_CHARACTERISTIC_VALUE_RESULT;
             send_gatt_write_attribute_value_request(peripheral);
@@ -1068,11 +1615,22 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
             return 1;
         }
+#endif
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        case P_W2_SEND_READ_DATABASE_HASH_QUERY:
+            peripheral->gatt_client_state = P_W4_READ_DATABASE_HASH_RESULT;
+            att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GAP_DATABASE_HASH, peripheral->con_handle, 0x0001, 0xffff);
+            return 1;
 #endif
         default:
             break;
     }
 
+    // stream Write Without Response
+    if ((peripheral->write_stream_provider != NULL) && (peripheral->write_stream_paused == 0)){
+        if (gatt_client_write_stream_send(peripheral)) return 1;
+    }
+
     // requested can send snow?
     if (peripheral->write_without_response_callback){
         btstack_packet_handler_t packet_handler = peripheral->write_without_response_callback;
@@ -1132,6 +1690,12 @@ static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t chann
             
             gatt_client_report_error_if_pending(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
             gatt_client_timeout_stop(peripheral);
+            // drop pending query requests, application receives disconnect event
+            peripheral->query_requests = NULL;
+            btstack_run_loop_remove_timer(&peripheral->query_request_timer);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            btstack_run_loop_remove_timer(&peripheral->cache_report_timer);
+#endif
             btstack_linked_list_remove(&gatt_client_connections, (btstack_linked_item_t *) peripheral);
             btstack_memory_gatt_client_free(peripheral);
             break;
@@ -1233,6 +1797,10 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
             break;
         case ATT_HANDLE_VALUE_INDICATION:
             if (size < 3) break;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            // before event is assembled in place
+            gatt_client_cache_handle_indication(peripheral, little_endian_read_16(packet,1));
+#endif
             report_gatt_indication(handle, little_endian_read_16(packet,1), &packet[3], size-3);
             peripheral->send_confirmation = 1;
             break;
@@ -1299,6 +1867,16 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     trigger_next_read_by_type_query(peripheral, last_result_handle);
                     break;
                 }
+#ifdef ENABLE_GATT_CLIENT_CACHE
+                case P_W4_READ_DATABASE_HASH_RESULT:
+                    // single handle value pair with 128-bit hash
+                    if ((size >= 20) && (packet[1] == 18)){
+                        gatt_client_cache_handle_database_hash(peripheral, &packet[4]);
+                    } else {
+                        gatt_client_cache_handle_database_hash(peripheral, NULL);
+                    }
+                    break;
+#endif
                 default:
                     break;
             }
@@ -1319,6 +1897,10 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
                     break;
 
+                case P_W4_READ_LONG_MULTIPLE_BLOB_RESULT:
+                    handle_read_long_multiple_blob_response(peripheral, &packet[1], size-1);
+                    break;
+
                 case P_W4_READ_CHARACTERISTIC_DESCRIPTOR_RESULT:{
                     gatt_client_handle_transaction_complete(peripheral);
                     report_gatt_characteristic_descriptor(peripheral, peripheral->attribute_handle, &packet[1], size-1, 0);
@@ -1424,6 +2006,9 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     trigger_next_blob_query(peripheral, P_W2_SEND_READ_BLOB_CHARACTERISTIC_DESCRIPTOR_QUERY, received_blob_length);
                     // GATT_EVENT_QUERY_COMPLETE is emitted by trigger_next_xxx when done
                     break;
+                case P_W4_READ_LONG_MULTIPLE_BLOB_RESULT:
+                    handle_read_long_multiple_blob_response(peripheral, &packet[1], received_blob_length);
+                    break;
                 default:
                     break;
             }
@@ -1503,8 +2088,48 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
             }
             break;
 
+        case ATT_READ_MULTIPLE_VARIABLE_RESPONSE:
+            switch(peripheral->gatt_client_state){
+                case P_W4_READ_MULTIPLE_VARIABLE_RESPONSE: {
+                    // list of length value tuples in order of requested handles, last value might be truncated
+                    uint16_t offset = 1;
+                    uint16_t i;
+                    for (i = 0; (i < peripheral->read_multiple_handle_count) && ((offset + 2) <= size); i++){
+                        uint16_t value_length = little_endian_read_16(packet, offset);
+                        offset += 2;
+                        if (value_length > (size - offset)){
+                            value_length = size - offset;
+                        }
+                        report_gatt_characteristic_value(peripheral, peripheral->read_multiple_handles[i], &packet[offset], value_length);
+                        offset += value_length;
+                    }
+                    gatt_client_handle_transaction_complete(peripheral);
+                    emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
+                    break;
+                }
+                case P_W4_READ_LONG_MULTIPLE_VARIABLE_RESPONSE:
+                    handle_read_long_multiple_variable_response(peripheral, packet, size);
+                    break;
+                default:
+                    break;
+            }
+            break;
+
         case ATT_ERROR_RESPONSE:
             if (size < 5) return;
+            // Read Multiple Variable Length not supported by peer, continue with Read Blob
+            if ((peripheral->gatt_client_state == P_W4_READ_LONG_MULTIPLE_VARIABLE_RESPONSE) && (packet[4] == ATT_ERROR_REQUEST_NOT_SUPPORTED)){
+                peripheral->read_multiple_variable_not_supported = 1;
+                trigger_next_read_long_multiple_query(peripheral);
+                break;
+            }
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            // Database Hash not available, continue with pending query
+            if (peripheral->gatt_client_state == P_W4_READ_DATABASE_HASH_RESULT){
+                gatt_client_cache_handle_database_hash(peripheral, NULL);
+                break;
+            }
+#endif
             switch (packet[4]){
                 case ATT_ERROR_ATTRIBUTE_NOT_FOUND: {
                     switch(peripheral->gatt_client_state){
@@ -1565,6 +2190,15 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                         case P_W4_READ_MULTIPLE_RESPONSE:
                             peripheral->gatt_client_state = P_W2_SEND_READ_MULTIPLE_REQUEST;
                             break;
+                        case P_W4_READ_MULTIPLE_VARIABLE_RESPONSE:
+                            peripheral->gatt_client_state = P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST;
+                            break;
+                        case P_W4_READ_LONG_MULTIPLE_VARIABLE_RESPONSE:
+                            peripheral->gatt_client_state = P_W2_SEND_READ_LONG_MULTIPLE_VARIABLE_REQUEST;
+                            break;
+                        case P_W4_READ_LONG_MULTIPLE_BLOB_RESULT:
+                            peripheral->gatt_client_state = P_W2_SEND_READ_LONG_MULTIPLE_BLOB_QUERY;
+                            break;
                         case P_W4_WRITE_CHARACTERISTIC_VALUE_RESULT:
                             peripheral->gatt_client_state = P_W2_SEND_WRITE_CHARACTERISTIC_VALUE;
                             break;
@@ -1687,6 +2321,9 @@ uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback,
     peripheral->end_group_handle   = 0xffff;
     peripheral->gatt_client_state = P_W2_SEND_SERVICE_QUERY;
     peripheral->uuid16 = 0;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_start_query(peripheral, GATT_CLIENT_CACHE_QUERY_SERVICES);
+#endif
     gatt_client_run();
     return ERROR_CODE_SUCCESS;
 }
@@ -1703,6 +2340,9 @@ uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t
     peripheral->gatt_client_state = P_W2_SEND_SERVICE_WITH_UUID_QUERY;
     peripheral->uuid16 = uuid16;
     uuid_add_bluetooth_prefix((uint8_t*) &(peripheral->uuid128), peripheral->uuid16);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_start_query(peripheral, GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID);
+#endif
     gatt_client_run();
     return ERROR_CODE_SUCCESS;
 }
@@ -1718,6 +2358,9 @@ uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_
     peripheral->uuid16 = 0;
     (void)memcpy(peripheral->uuid128, uuid128, 16);
     peripheral->gatt_client_state = P_W2_SEND_SERVICE_WITH_UUID_QUERY;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_start_query(peripheral, GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID);
+#endif
     gatt_client_run();
     return ERROR_CODE_SUCCESS;
 }
@@ -1733,6 +2376,9 @@ uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_
     peripheral->filter_with_uuid = 0;
     peripheral->characteristic_start_handle = 0;
     peripheral->gatt_client_state = P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_start_query(peripheral, GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS);
+#endif
     gatt_client_run();
     return ERROR_CODE_SUCCESS;
 }
@@ -1806,6 +2452,9 @@ uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t
     peripheral->start_group_handle = characteristic->value_handle + 1;
     peripheral->end_group_handle   = characteristic->end_handle;
     peripheral->gatt_client_state = P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_start_query(peripheral, GATT_CLIENT_CACHE_QUERY_DESCRIPTORS);
+#endif
     gatt_client_run();
     return ERROR_CODE_SUCCESS;
 }
@@ -1896,6 +2545,33 @@ uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t
     return ERROR_CODE_SUCCESS;
 }
 
+uint8_t gatt_client_read_multiple_variable_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles){
+    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
+    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
+
+    peripheral->callback = callback;
+    peripheral->read_multiple_handle_count = num_value_handles;
+    peripheral->read_multiple_handles = value_handles;
+    peripheral->gatt_client_state = P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST;
+    gatt_client_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gatt_client_read_long_multiple_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles){
+    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
+    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
+
+    peripheral->callback = callback;
+    peripheral->read_multiple_handle_count = num_value_handles;
+    peripheral->read_multiple_handles = value_handles;
+    peripheral->read_multiple_handle_index = 0;
+    trigger_next_read_long_multiple_query(peripheral);
+    gatt_client_run();
+    return ERROR_CODE_SUCCESS;
+}
+
 uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
     gatt_client_t * peripheral = provide_context_for_conn_handle(con_handle);
     if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
@@ -2163,6 +2839,48 @@ uint8_t gatt_client_request_can_write_without_response_event(btstack_packet_hand
     return ERROR_CODE_SUCCESS;
 }
 
+uint8_t gatt_client_write_without_response_stream_start(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, gatt_client_write_without_response_stream_provider_t provider){
+    gatt_client_t * context = provide_context_for_conn_handle(con_handle);
+    if (context == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+    if (context->write_stream_provider != NULL) return GATT_CLIENT_IN_WRONG_STATE;
+    context->write_stream_callback = callback;
+    context->write_stream_provider = provider;
+    context->write_stream_value_handle = value_handle;
+    context->write_stream_bytes_sent = 0;
+    context->write_stream_paused = 0;
+    gatt_client_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gatt_client_write_without_response_stream_resume(hci_con_handle_t con_handle){
+    gatt_client_t * context = get_gatt_client_context_for_handle(con_handle);
+    if (context == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (context->write_stream_provider == NULL) return GATT_CLIENT_IN_WRONG_STATE;
+    context->write_stream_paused = 0;
+    gatt_client_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gatt_client_write_without_response_stream_stop(hci_con_handle_t con_handle){
+    gatt_client_t * context = get_gatt_client_context_for_handle(con_handle);
+    if (context == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (context->write_stream_provider == NULL) return GATT_CLIENT_IN_WRONG_STATE;
+    context->write_stream_provider = NULL;
+    context->write_stream_callback = NULL;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gatt_client_request_to_send_gatt_query(btstack_context_callback_registration_t * callback_registration, hci_con_handle_t con_handle){
+    gatt_client_t * context = provide_context_for_conn_handle(con_handle);
+    if (context == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+    bool added = btstack_linked_list_add_tail(&context->query_requests, (btstack_linked_item_t*) callback_registration);
+    if (!added) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (is_ready(context)){
+        gatt_client_query_requests_schedule(context);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
 void gatt_client_att_packet_handler_fuzz(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size){
     gatt_client_att_packet_handler(packet_type, handle, packet, size);
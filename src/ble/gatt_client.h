@@ -45,6 +45,15 @@
 extern "C" {
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+// size of discovery results cached per bonded device
+#ifndef GATT_CLIENT_CACHE_SIZE
+#define GATT_CLIENT_CACHE_SIZE 512
+#endif
+// identity address type, identity address, database hash
+#define GATT_CLIENT_CACHE_HEADER_SIZE (1 + 6 + 16)
+#endif
+
 typedef enum {
     P_READY,
     P_W2_SEND_SERVICE_QUERY,
@@ -77,6 +86,14 @@ typedef enum {
     P_W2_SEND_READ_MULTIPLE_REQUEST,
     P_W4_READ_MULTIPLE_RESPONSE,
 
+    P_W2_SEND_READ_MULTIPLE_VARIABLE_REQUEST,
+    P_W4_READ_MULTIPLE_VARIABLE_RESPONSE,
+
+    P_W2_SEND_READ_LONG_MULTIPLE_VARIABLE_REQUEST,
+    P_W4_READ_LONG_MULTIPLE_VARIABLE_RESPONSE,
+    P_W2_SEND_READ_LONG_MULTIPLE_BLOB_QUERY,
+    P_W4_READ_LONG_MULTIPLE_BLOB_RESULT,
+
     P_W2_SEND_WRITE_CHARACTERISTIC_VALUE,
     P_W4_WRITE_CHARACTERISTIC_VALUE_RESULT,
     
@@ -126,7 +143,25 @@ typedef enum {
     P_W4_CMAC_RESULT,
     P_W2_SEND_SIGNED_WRITE,
     P_W4_SEND_SINGED_WRITE_DONE,
+
+    P_W2_SEND_READ_DATABASE_HASH_QUERY,
+    P_W4_READ_DATABASE_HASH_RESULT,
+    P_W2_REPORT_CACHED_RESULTS,
 } gatt_client_state_t;
+
+typedef enum {
+    GATT_CLIENT_CACHE_STATE_UNKNOWN,
+    GATT_CLIENT_CACHE_STATE_VALID,
+    GATT_CLIENT_CACHE_STATE_DISABLED,
+} gatt_client_cache_state_t;
+
+typedef enum {
+    GATT_CLIENT_CACHE_QUERY_NONE,
+    GATT_CLIENT_CACHE_QUERY_SERVICES,
+    GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID,
+    GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS,
+    GATT_CLIENT_CACHE_QUERY_DESCRIPTORS,
+} gatt_client_cache_query_t;
     
     
 typedef enum{
@@ -136,6 +171,17 @@ typedef enum{
     MTU_AUTO_EXCHANGE_DISABLED
 } gatt_client_mtu_t;
 
+/**
+ * @brief Provides next chunk for Write Without Response stream
+ * @note called with outgoing packet buffer, only copy data and don't call other BTstack functions
+ * @param con_handle
+ * @param value_handle
+ * @param buffer to store chunk
+ * @param max_len of chunk, MTU - 3
+ * @return chunk len, 0 pauses stream until gatt_client_write_without_response_stream_resume is called
+ */
+typedef uint16_t (*gatt_client_write_without_response_stream_provider_t)(hci_con_handle_t con_handle, uint16_t value_handle, uint8_t * buffer, uint16_t max_len);
+
 typedef struct gatt_client{
     btstack_linked_item_t    item;
     // TODO: rename gatt_client_state -> state
@@ -147,6 +193,13 @@ typedef struct gatt_client{
     // can write without response callback
     btstack_packet_handler_t write_without_response_callback;
 
+    // write without response stream
+    gatt_client_write_without_response_stream_provider_t write_stream_provider;
+    btstack_packet_handler_t write_stream_callback;
+    uint16_t write_stream_value_handle;
+    uint32_t write_stream_bytes_sent;
+    uint8_t  write_stream_paused;
+
     hci_con_handle_t con_handle;
     
     uint8_t   address_type;
@@ -175,6 +228,9 @@ typedef struct gatt_client{
     // read multiple characteristic values
     uint16_t    read_multiple_handle_count;
     uint16_t  * read_multiple_handles;
+    // read long multiple characteristic values: next handle to read, peer rejected Read Multiple Variable Length
+    uint16_t    read_multiple_handle_index;
+    uint8_t     read_multiple_variable_not_supported;
 
     uint16_t client_characteristic_configuration_handle;
     uint8_t  client_characteristic_configuration_value[2];
@@ -187,12 +243,31 @@ typedef struct gatt_client{
 
     btstack_timer_source_t gc_timeout;
 
+    // queued callbacks for gatt_client_request_to_send_gatt_query, served from run loop
+    btstack_linked_list_t query_requests;
+    btstack_timer_source_t query_request_timer;
+
 #ifdef ENABLE_GATT_CLIENT_PAIRING
     uint8_t  security_counter;
     uint8_t  wait_for_pairing_complete;
     uint8_t  pending_error_code;
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_state_t cache_state;
+    gatt_client_cache_query_t cache_query;
+    gatt_client_cache_query_t cache_report_query;
+    gatt_client_state_t       cache_pending_state;
+    btstack_timer_source_t    cache_report_timer;
+    uint16_t cache_query_start_handle;
+    uint16_t cache_query_end_handle;
+    uint16_t cache_record_start;
+    uint8_t  cache_record_failed;
+    uint16_t cache_len;
+    // header followed by records, stored as single TLV tag
+    uint8_t  cache_data[GATT_CLIENT_CACHE_HEADER_SIZE + GATT_CLIENT_CACHE_SIZE];
+#endif
+
 } gatt_client_t;
 
 typedef struct gatt_client_notification {
@@ -467,6 +542,35 @@ uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle_with_of
  */
 uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles);
 
+/*
+ * @brief Read multiple variable length characteristic values with a single ATT Read Multiple Variable Length Request (Bluetooth 5.2).
+ *        For each value, a GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT with its value handle is emitted, followed by a GATT_EVENT_QUERY_COMPLETE.
+ * @note   Values that don't fit into the ATT MTU are truncated, the last values might be missing
+ * @param  callback
+ * @param  con_handle
+ * @param  num_value_handles
+ * @param  value_handles list of handles, has to stay valid until GATT_EVENT_QUERY_COMPLETE
+ * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                ERROR_CODE_SUCCESS         , if query is successfully registered
+ */
+uint8_t gatt_client_read_multiple_variable_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles);
+
+/*
+ * @brief Read complete values of multiple characteristics back-to-back. Values are fetched with ATT Read Multiple Variable Length
+ *        Requests, truncated and missing values are continued with Read Blob Requests. If the peer doesn't support
+ *        Read Multiple Variable Length, only Read Blob Requests are used. For each value chunk, a GATT_EVENT_LONG_CHARACTERISTIC_VALUE_QUERY_RESULT
+ *        with its value handle and value offset is emitted, followed by a GATT_EVENT_QUERY_COMPLETE.
+ * @param  callback
+ * @param  con_handle
+ * @param  num_value_handles
+ * @param  value_handles list of handles, has to stay valid until GATT_EVENT_QUERY_COMPLETE
+ * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                ERROR_CODE_SUCCESS         , if query is successfully registered
+ */
+uint8_t gatt_client_read_long_multiple_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles);
+
 /** 
  * @brief Writes the characteristic value using the characteristic's value handle without an acknowledgment that the write was successfully performed.
  * @param  con_handle   
@@ -710,6 +814,43 @@ void gatt_client_stop_listening_for_characteristic_value_updates(gatt_client_not
  */
 uint8_t gatt_client_request_can_write_without_response_event(btstack_packet_handler_t callback, hci_con_handle_t con_handle);
 
+/**
+ * @brief Start Write Without Response stream. Whenever packets can be sent, provider is asked for chunks until
+ *        it returns 0 or no more packets can be sent, e.g. no ACL buffers in Controller. After each burst,
+ *        GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS with total number of bytes sent is emitted. Queries have priority over stream.
+ * @param  callback for GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS
+ * @param  con_handle
+ * @param  value_handle
+ * @param  provider
+ * @returns status
+ */
+uint8_t gatt_client_write_without_response_stream_start(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, gatt_client_write_without_response_stream_provider_t provider);
+
+/**
+ * @brief Resume Write Without Response stream after provider returned 0 as more data is available
+ * @param  con_handle
+ * @returns status
+ */
+uint8_t gatt_client_write_without_response_stream_resume(hci_con_handle_t con_handle);
+
+/**
+ * @brief Stop Write Without Response stream
+ * @param  con_handle
+ * @returns status
+ */
+uint8_t gatt_client_write_without_response_stream_stop(hci_con_handle_t con_handle);
+
+/**
+ * @brief Request callback when GATT Client is ready to start a new query. Requests are served in order,
+ *        the callback is expected to start the next query, which is sent without waiting for the application
+ * @note callback is called from the run loop after the previous query completed, never during call to this function
+ * @note pending requests are dropped without callback on disconnect
+ * @param callback_registration to point to callback function and context information
+ * @param con_handle
+ * @return ERROR_CODE_SUCCESS if ok, BTSTACK_MEMORY_ALLOC_FAILED if no context, and ERROR_CODE_COMMAND_DISALLOWED if callback already registered
+ */
+uint8_t gatt_client_request_to_send_gatt_query(btstack_context_callback_registration_t * callback_registration, hci_con_handle_t con_handle);
+
 /**
  * @brief Transactional write. It can be called as many times as it is needed to write the characteristics within the same transaction. Call gatt_client_execute_write to commit the transaction.
  * @param  callback   
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "le_advertising_scheduler.c"
+
+/*
+ * le_advertising_scheduler.c
+ */
+
+#include "btstack_config.h"
+
+#include <string.h>
+
+#include "ble/le_advertising_scheduler.h"
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "gap.h"
+
+static btstack_linked_list_t le_advertising_scheduler_payloads;
+static le_advertising_scheduler_payload_t * le_advertising_scheduler_current;
+static btstack_timer_source_t le_advertising_scheduler_timer;
+static bool le_advertising_scheduler_active;
+
+static void le_advertising_scheduler_timeout_handler(btstack_timer_source_t * ts);
+
+static void le_advertising_scheduler_activate(le_advertising_scheduler_payload_t * payload){
+    le_advertising_scheduler_current = payload;
+    btstack_run_loop_remove_timer(&le_advertising_scheduler_timer);
+    if (payload == NULL) return;
+    gap_advertisements_set_data(payload->adv_data_len, payload->adv_data);
+    if (payload->scan_response_data != NULL){
+        gap_scan_response_set_data(payload->scan_response_data_len, payload->scan_response_data);
+    }
+    // single payload does not need to be rotated
+    if (btstack_linked_list_count(&le_advertising_scheduler_payloads) < 2) return;
+    btstack_run_loop_set_timer_handler(&le_advertising_scheduler_timer, &le_advertising_scheduler_timeout_handler);
+    btstack_run_loop_set_timer(&le_advertising_scheduler_timer, payload->duration_ms);
+    btstack_run_loop_add_timer(&le_advertising_scheduler_timer);
+}
+
+static le_advertising_scheduler_payload_t * le_advertising_scheduler_next(le_advertising_scheduler_payload_t * payload){
+    if ((payload != NULL) && (payload->item.next != NULL)){
+        return (le_advertising_scheduler_payload_t *) payload->item.next;
+    }
+    return (le_advertising_scheduler_payload_t *) le_advertising_scheduler_payloads;
+}
+
+static void le_advertising_scheduler_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    if (!le_advertising_scheduler_active) return;
+    le_advertising_scheduler_activate(le_advertising_scheduler_next(le_advertising_scheduler_current));
+}
+
+void le_advertising_scheduler_init(void){
+    le_advertising_scheduler_payloads = NULL;
+    le_advertising_scheduler_current = NULL;
+    le_advertising_scheduler_active = false;
+}
+
+void le_advertising_scheduler_add_payload(le_advertising_scheduler_payload_t * payload, uint8_t adv_data_len, uint8_t * adv_data, uint32_t duration_ms){
+    memset(payload, 0, sizeof(le_advertising_scheduler_payload_t));
+    payload->adv_data_len = adv_data_len;
+    payload->adv_data = adv_data;
+    payload->duration_ms = duration_ms;
+    btstack_linked_list_add_tail(&le_advertising_scheduler_payloads, (btstack_linked_item_t *) payload);
+    if (!le_advertising_scheduler_active) return;
+    // start rotating when second payload is added
+    if (le_advertising_scheduler_current == NULL){
+        le_advertising_scheduler_activate(payload);
+    } else if (btstack_linked_list_count(&le_advertising_scheduler_payloads) == 2){
+        le_advertising_scheduler_activate(le_advertising_scheduler_current);
+    }
+}
+
+void le_advertising_scheduler_set_scan_response_data(le_advertising_scheduler_payload_t * payload, uint8_t scan_response_data_len, uint8_t * scan_response_data){
+    payload->scan_response_data_len = scan_response_data_len;
+    payload->scan_response_data = scan_response_data;
+}
+
+void le_advertising_scheduler_remove_payload(le_advertising_scheduler_payload_t * payload){
+    le_advertising_scheduler_payload_t * next = le_advertising_scheduler_next(payload);
+    btstack_linked_list_remove(&le_advertising_scheduler_payloads, (btstack_linked_item_t *) payload);
+    if (payload != le_advertising_scheduler_current) return;
+    if (next == payload){
+        next = NULL;
+    }
+    if (le_advertising_scheduler_active){
+        le_advertising_scheduler_activate(next);
+    } else {
+        le_advertising_scheduler_current = NULL;
+    }
+}
+
+void le_advertising_scheduler_start(void){
+    le_advertising_scheduler_active = true;
+    le_advertising_scheduler_activate((le_advertising_scheduler_payload_t *) le_advertising_scheduler_payloads);
+}
+
+void le_advertising_scheduler_stop(void){
+    le_advertising_scheduler_active = false;
+    btstack_run_loop_remove_timer(&le_advertising_scheduler_timer);
+}
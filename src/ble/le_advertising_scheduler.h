@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * le_advertising_scheduler.h
+ *
+ * Rotate between several precomputed legacy advertising payloads, e.g. iBeacon, Eddystone, and a custom payload
+ *
+ * Each payload is advertised for its duration, then the next one is set. Only LE Set Advertising Data (and
+ * LE Set Scan Response Data if the payload provides one) is sent per rotation, advertising stays enabled.
+ * Advertising parameters and enable are controlled via gap_advertisements_set_params and gap_advertisements_enable.
+ */
+
+#ifndef LE_ADVERTISING_SCHEDULER_H
+#define LE_ADVERTISING_SCHEDULER_H
+
+#include <stdint.h>
+#include "btstack_linked_list.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    btstack_linked_item_t item;
+    uint8_t         adv_data_len;
+    uint8_t       * adv_data;
+    // NULL to keep current scan response data
+    uint8_t         scan_response_data_len;
+    uint8_t       * scan_response_data;
+    uint32_t        duration_ms;
+} le_advertising_scheduler_payload_t;
+
+/* API_START */
+
+/**
+ * @brief Init advertising scheduler
+ */
+void le_advertising_scheduler_init(void);
+
+/**
+ * @brief Add payload to rotation
+ * @param payload storage, needs to stay valid until payload is removed
+ * @param adv_data_len
+ * @param adv_data (max 31 octets), not copied
+ * @param duration_ms time payload is advertised before the next one is set
+ */
+void le_advertising_scheduler_add_payload(le_advertising_scheduler_payload_t * payload, uint8_t adv_data_len, uint8_t * adv_data, uint32_t duration_ms);
+
+/**
+ * @brief Set scan response data for payload, used with scannable advertising
+ * @param payload
+ * @param scan_response_data_len
+ * @param scan_response_data (max 31 octets), not copied
+ */
+void le_advertising_scheduler_set_scan_response_data(le_advertising_scheduler_payload_t * payload, uint8_t scan_response_data_len, uint8_t * scan_response_data);
+
+/**
+ * @brief Remove payload from rotation
+ * @param payload
+ */
+void le_advertising_scheduler_remove_payload(le_advertising_scheduler_payload_t * payload);
+
+/**
+ * @brief Start rotation with first payload
+ */
+void le_advertising_scheduler_start(void);
+
+/**
+ * @brief Stop rotation, current payload stays set
+ */
+void le_advertising_scheduler_stop(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // LE_ADVERTISING_SCHEDULER_H
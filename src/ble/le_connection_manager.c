@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "le_connection_manager.c"
+
+/*
+ * le_connection_manager.c
+ */
+
+#include "btstack_config.h"
+
+#include <string.h>
+
+#include "ble/le_connection_manager.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "gap.h"
+#include "hci.h"
+
+static btstack_linked_list_t le_connection_manager_targets;
+static btstack_packet_callback_registration_t le_connection_manager_hci_event_callback_registration;
+static btstack_timer_source_t le_connection_manager_timer;
+static bool     le_connection_manager_started;
+static uint8_t  le_connection_manager_num_connecting;
+static uint32_t le_connection_manager_batch_deadline_ms;
+
+static le_connection_manager_target_t * le_connection_manager_target_for_address(const bd_addr_t address){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (bd_addr_cmp(target->address, address) == 0) return target;
+    }
+    return NULL;
+}
+
+static le_connection_manager_target_t * le_connection_manager_target_for_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (target->state != LE_CONNECTION_MANAGER_TARGET_CONNECTED) continue;
+        if (target->con_handle == con_handle) return target;
+    }
+    return NULL;
+}
+
+// highest priority first, then strongest signal
+static le_connection_manager_target_t * le_connection_manager_next_queued_target(void){
+    le_connection_manager_target_t * best = NULL;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (target->state != LE_CONNECTION_MANAGER_TARGET_QUEUED) continue;
+        if ((best == NULL) || (target->priority > best->priority) ||
+            ((target->priority == best->priority) && (target->rssi > best->rssi))){
+            best = target;
+        }
+    }
+    return best;
+}
+
+static void le_connection_manager_stop_connecting(le_connection_manager_target_t * target){
+    gap_auto_connection_stop(target->address_type, target->address);
+    le_connection_manager_num_connecting--;
+}
+
+static void le_connection_manager_backoff(le_connection_manager_target_t * target, uint32_t now){
+    uint32_t delay_ms = LE_CONNECTION_MANAGER_BACKOFF_MAX_MS;
+    if (target->num_attempts < 16){
+        delay_ms = btstack_min(LE_CONNECTION_MANAGER_BACKOFF_MIN_MS << target->num_attempts, LE_CONNECTION_MANAGER_BACKOFF_MAX_MS);
+    }
+    if (target->num_attempts < 0xff){
+        target->num_attempts++;
+    }
+    target->state = LE_CONNECTION_MANAGER_TARGET_BACKOFF;
+    target->retry_time_ms = now + delay_ms;
+    log_info("connection manager: retry %s in %u ms", bd_addr_to_str(target->address), (unsigned int) delay_ms);
+}
+
+static void le_connection_manager_timeout_handler(btstack_timer_source_t * ts);
+
+static void le_connection_manager_run(void){
+    if (!le_connection_manager_started) return;
+    if (hci_get_state() != HCI_STATE_WORKING) return;
+
+    uint32_t now = btstack_run_loop_get_time_ms();
+    btstack_linked_list_iterator_t it;
+
+    // re-queue targets after backoff
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (target->state != LE_CONNECTION_MANAGER_TARGET_BACKOFF) continue;
+        if ((int32_t)(now - target->retry_time_ms) < 0) continue;
+        target->state = LE_CONNECTION_MANAGER_TARGET_QUEUED;
+    }
+
+    // rotate batch if it did not make progress while other targets are waiting
+    if ((le_connection_manager_num_connecting > 0) && ((int32_t)(now - le_connection_manager_batch_deadline_ms) >= 0)){
+        if (le_connection_manager_next_queued_target() != NULL){
+            btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+            while (btstack_linked_list_iterator_has_next(&it)){
+                le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+                if (target->state != LE_CONNECTION_MANAGER_TARGET_CONNECTING) continue;
+                le_connection_manager_stop_connecting(target);
+                le_connection_manager_backoff(target, now);
+            }
+        }
+        le_connection_manager_batch_deadline_ms = now + LE_CONNECTION_MANAGER_BATCH_TIMEOUT_MS;
+    }
+
+    // fill batch
+    while (le_connection_manager_num_connecting < LE_CONNECTION_MANAGER_BATCH_SIZE){
+        le_connection_manager_target_t * target = le_connection_manager_next_queued_target();
+        if (target == NULL) break;
+        if (gap_auto_connection_start(target->address_type, target->address) != ERROR_CODE_SUCCESS) break;
+        if (le_connection_manager_num_connecting == 0){
+            le_connection_manager_batch_deadline_ms = now + LE_CONNECTION_MANAGER_BATCH_TIMEOUT_MS;
+        }
+        target->state = LE_CONNECTION_MANAGER_TARGET_CONNECTING;
+        le_connection_manager_num_connecting++;
+    }
+
+    // wake up for batch timeout or next retry
+    bool timer_needed = false;
+    uint32_t wakeup_ms = 0;
+    if (le_connection_manager_num_connecting > 0){
+        timer_needed = true;
+        wakeup_ms = le_connection_manager_batch_deadline_ms;
+    }
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (target->state != LE_CONNECTION_MANAGER_TARGET_BACKOFF) continue;
+        if (!timer_needed || ((int32_t)(target->retry_time_ms - wakeup_ms) < 0)){
+            timer_needed = true;
+            wakeup_ms = target->retry_time_ms;
+        }
+    }
+    btstack_run_loop_remove_timer(&le_connection_manager_timer);
+    if (!timer_needed) return;
+    int32_t delay_ms = (int32_t)(wakeup_ms - now);
+    btstack_run_loop_set_timer_handler(&le_connection_manager_timer, &le_connection_manager_timeout_handler);
+    btstack_run_loop_set_timer(&le_connection_manager_timer, (delay_ms > 0) ? (uint32_t) delay_ms : 0);
+    btstack_run_loop_add_timer(&le_connection_manager_timer);
+}
+
+static void le_connection_manager_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    le_connection_manager_run();
+}
+
+static void le_connection_manager_handle_connection_complete(const uint8_t * packet){
+    bd_addr_t address;
+    hci_subevent_le_connection_complete_get_peer_address(packet, address);
+    le_connection_manager_target_t * target = le_connection_manager_target_for_address(address);
+    if (target == NULL) return;
+    if (target->state != LE_CONNECTION_MANAGER_TARGET_CONNECTING) return;
+    // HCI removed target from Whitelist
+    le_connection_manager_num_connecting--;
+    uint8_t status = hci_subevent_le_connection_complete_get_status(packet);
+    if (status == ERROR_CODE_SUCCESS){
+        target->state = LE_CONNECTION_MANAGER_TARGET_CONNECTED;
+        target->con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+        target->num_attempts = 0;
+        // progress, give remaining targets of batch full timeout
+        le_connection_manager_batch_deadline_ms = btstack_run_loop_get_time_ms() + LE_CONNECTION_MANAGER_BATCH_TIMEOUT_MS;
+    } else {
+        le_connection_manager_backoff(target, btstack_run_loop_get_time_ms());
+    }
+}
+
+static void le_connection_manager_reset(le_connection_manager_target_state_t state){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (target->state == LE_CONNECTION_MANAGER_TARGET_CONNECTED) continue;
+        target->state = state;
+        target->num_attempts = 0;
+    }
+    le_connection_manager_num_connecting = 0;
+    btstack_run_loop_remove_timer(&le_connection_manager_timer);
+}
+
+static void le_connection_manager_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    le_connection_manager_target_t * target;
+    btstack_linked_list_iterator_t it;
+    bd_addr_t address;
+
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            switch (btstack_event_state_get_state(packet)){
+                case HCI_STATE_WORKING:
+                    le_connection_manager_run();
+                    break;
+                case HCI_STATE_OFF:
+                    // Whitelist and connections are gone
+                    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+                    while (btstack_linked_list_iterator_has_next(&it)){
+                        target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+                        if (target->state == LE_CONNECTION_MANAGER_TARGET_CONNECTED){
+                            target->state = LE_CONNECTION_MANAGER_TARGET_IDLE;
+                        }
+                    }
+                    le_connection_manager_reset(le_connection_manager_started ? LE_CONNECTION_MANAGER_TARGET_QUEUED : LE_CONNECTION_MANAGER_TARGET_IDLE);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case GAP_EVENT_ADVERTISING_REPORT:
+            gap_event_advertising_report_get_address(packet, address);
+            target = le_connection_manager_target_for_address(address);
+            if (target == NULL) break;
+            target->rssi = (int8_t) gap_event_advertising_report_get_rssi(packet);
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            if (hci_subevent_le_connection_complete_get_role(packet) != HCI_ROLE_MASTER) break;
+            le_connection_manager_handle_connection_complete(packet);
+            le_connection_manager_run();
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            target = le_connection_manager_target_for_handle(hci_event_disconnection_complete_get_connection_handle(packet));
+            if (target == NULL) break;
+            target->con_handle = HCI_CON_HANDLE_INVALID;
+            target->state = le_connection_manager_started ? LE_CONNECTION_MANAGER_TARGET_QUEUED : LE_CONNECTION_MANAGER_TARGET_IDLE;
+            le_connection_manager_run();
+            break;
+        default:
+            break;
+    }
+}
+
+void le_connection_manager_init(void){
+    le_connection_manager_targets = NULL;
+    le_connection_manager_started = false;
+    le_connection_manager_num_connecting = 0;
+    le_connection_manager_hci_event_callback_registration.callback = &le_connection_manager_packet_handler;
+    hci_add_event_handler(&le_connection_manager_hci_event_callback_registration);
+}
+
+void le_connection_manager_add_target(le_connection_manager_target_t * target, bd_addr_type_t address_type, const bd_addr_t address, uint8_t priority){
+    memset(target, 0, sizeof(le_connection_manager_target_t));
+    target->address_type = address_type;
+    (void)memcpy(target->address, address, 6);
+    target->priority = priority;
+    target->rssi = -127;
+    target->con_handle = HCI_CON_HANDLE_INVALID;
+    target->state = le_connection_manager_started ? LE_CONNECTION_MANAGER_TARGET_QUEUED : LE_CONNECTION_MANAGER_TARGET_IDLE;
+    btstack_linked_list_add_tail(&le_connection_manager_targets, (btstack_linked_item_t *) target);
+    le_connection_manager_run();
+}
+
+void le_connection_manager_remove_target(le_connection_manager_target_t * target){
+    if (target->state == LE_CONNECTION_MANAGER_TARGET_CONNECTING){
+        le_connection_manager_stop_connecting(target);
+    }
+    btstack_linked_list_remove(&le_connection_manager_targets, (btstack_linked_item_t *) target);
+    le_connection_manager_run();
+}
+
+void le_connection_manager_start(void){
+    if (le_connection_manager_started) return;
+    le_connection_manager_started = true;
+    le_connection_manager_reset(LE_CONNECTION_MANAGER_TARGET_QUEUED);
+    le_connection_manager_run();
+}
+
+void le_connection_manager_stop(void){
+    if (!le_connection_manager_started) return;
+    le_connection_manager_started = false;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_connection_manager_targets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_target_t * target = (le_connection_manager_target_t *) btstack_linked_list_iterator_next(&it);
+        if (target->state != LE_CONNECTION_MANAGER_TARGET_CONNECTING) continue;
+        gap_auto_connection_stop(target->address_type, target->address);
+    }
+    le_connection_manager_reset(LE_CONNECTION_MANAGER_TARGET_IDLE);
+}
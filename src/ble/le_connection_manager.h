@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * le_connection_manager.h
+ *
+ * Connection establishment scheduler for LE Central with many peripherals
+ *
+ * Targets are connected via LE Auto Connection (Whitelist) in batches of up to LE_CONNECTION_MANAGER_BATCH_SIZE
+ * devices, selected by application priority and last seen RSSI. If no device of a batch connects within
+ * LE_CONNECTION_MANAGER_BATCH_TIMEOUT_MS while other targets are waiting, the batch is rotated and its targets
+ * retry with exponential backoff. Targets are reconnected after disconnect.
+ */
+
+#ifndef LE_CONNECTION_MANAGER_H
+#define LE_CONNECTION_MANAGER_H
+
+#include <stdint.h>
+#include "btstack_defines.h"
+#include "btstack_linked_list.h"
+#include "bluetooth.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// max number of targets on Whitelist at the same time, further limited by Whitelist capacity of Controller
+#ifndef LE_CONNECTION_MANAGER_BATCH_SIZE
+#define LE_CONNECTION_MANAGER_BATCH_SIZE 8
+#endif
+
+#ifndef LE_CONNECTION_MANAGER_BATCH_TIMEOUT_MS
+#define LE_CONNECTION_MANAGER_BATCH_TIMEOUT_MS 5000
+#endif
+
+// retry delay doubles with each failed attempt up to max
+#ifndef LE_CONNECTION_MANAGER_BACKOFF_MIN_MS
+#define LE_CONNECTION_MANAGER_BACKOFF_MIN_MS 1000
+#endif
+
+#ifndef LE_CONNECTION_MANAGER_BACKOFF_MAX_MS
+#define LE_CONNECTION_MANAGER_BACKOFF_MAX_MS 60000
+#endif
+
+typedef enum {
+    LE_CONNECTION_MANAGER_TARGET_IDLE,
+    LE_CONNECTION_MANAGER_TARGET_QUEUED,
+    LE_CONNECTION_MANAGER_TARGET_CONNECTING,
+    LE_CONNECTION_MANAGER_TARGET_BACKOFF,
+    LE_CONNECTION_MANAGER_TARGET_CONNECTED,
+} le_connection_manager_target_state_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    bd_addr_type_t   address_type;
+    bd_addr_t        address;
+    // higher priority is connected first
+    uint8_t          priority;
+    // from last advertising report, if scanning is active
+    int8_t           rssi;
+    le_connection_manager_target_state_t state;
+    uint8_t          num_attempts;
+    uint32_t         retry_time_ms;
+    hci_con_handle_t con_handle;
+} le_connection_manager_target_t;
+
+/* API_START */
+
+/**
+ * @brief Init connection manager
+ */
+void le_connection_manager_init(void);
+
+/**
+ * @brief Add target device. Target is queued for connection if connection manager is started
+ * @param target storage, needs to stay valid until target is removed
+ * @param address_type
+ * @param address
+ * @param priority higher value is connected first
+ */
+void le_connection_manager_add_target(le_connection_manager_target_t * target, bd_addr_type_t address_type, const bd_addr_t address, uint8_t priority);
+
+/**
+ * @brief Remove target device, stops connecting to it. An existing connection is not disconnected
+ * @param target
+ */
+void le_connection_manager_remove_target(le_connection_manager_target_t * target);
+
+/**
+ * @brief Start connecting to all targets that are not connected
+ */
+void le_connection_manager_start(void);
+
+/**
+ * @brief Stop connecting, existing connections are kept
+ */
+void le_connection_manager_stop(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // LE_CONNECTION_MANAGER_H
@@ -97,6 +97,44 @@ typedef struct le_device_db_entry_t {
 static uint8_t  entry_map[NVM_NUM_DEVICE_DB_ENTRIES];
 static uint32_t num_valid_entries;
 
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE
+// RAM copy of identification and optionally encryption information, loaded on scan and updated on store
+typedef struct {
+    uint32_t seq_nr;
+    uint8_t  addr_type;
+    bd_addr_t addr;
+    sm_key_t irk;
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE_ENCRYPTION
+    sm_key_t ltk;
+    uint16_t ediv;
+    uint8_t  rand[8];
+    uint8_t  key_size;
+    uint8_t  authenticated;
+    uint8_t  authorized;
+    uint8_t  secure_connection;
+#endif
+} le_device_db_tlv_cache_entry_t;
+
+static le_device_db_tlv_cache_entry_t le_device_db_tlv_cache[NVM_NUM_DEVICE_DB_ENTRIES];
+
+static void le_device_db_tlv_cache_update(int index, const le_device_db_entry_t * entry){
+    le_device_db_tlv_cache_entry_t * cache_entry = &le_device_db_tlv_cache[index];
+    cache_entry->seq_nr    = entry->seq_nr;
+    cache_entry->addr_type = (uint8_t) entry->addr_type;
+    (void)memcpy(cache_entry->addr, entry->addr, 6);
+    (void)memcpy(cache_entry->irk, entry->irk, 16);
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE_ENCRYPTION
+    (void)memcpy(cache_entry->ltk, entry->ltk, 16);
+    cache_entry->ediv = entry->ediv;
+    (void)memcpy(cache_entry->rand, entry->rand, 8);
+    cache_entry->key_size          = entry->key_size;
+    cache_entry->authenticated     = entry->authenticated;
+    cache_entry->authorized        = entry->authorized;
+    cache_entry->secure_connection = entry->secure_connection;
+#endif
+}
+#endif
+
 static const btstack_tlv_t * le_device_db_tlv_btstack_tlv_impl;
 static       void *          le_device_db_tlv_btstack_tlv_context;
 
@@ -130,7 +168,11 @@ static bool le_device_db_tlv_store(int index, le_device_db_entry_t * entry){
 
     uint32_t tag = le_device_db_tlv_tag_for_index(index);
     int result = le_device_db_tlv_btstack_tlv_impl->store_tag(le_device_db_tlv_btstack_tlv_context, tag, (uint8_t*) entry, sizeof(le_device_db_entry_t));
-    return result == 0;
+    if (result != 0) return false;
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE
+    le_device_db_tlv_cache_update(index, entry);
+#endif
+    return true;
 }
 
 // @param index = entry_pos
@@ -153,6 +195,9 @@ static void le_device_db_tlv_scan(void){
         le_device_db_entry_t entry;
         if (!le_device_db_tlv_fetch(i, &entry)) continue;
 
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE
+        le_device_db_tlv_cache_update(i, &entry);
+#endif
         entry_map[i] = 1;
         num_valid_entries++;
     }
@@ -205,20 +250,25 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
     int i;
     for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
          if (entry_map[i]) {
-            le_device_db_entry_t entry;
-            le_device_db_tlv_fetch(i, &entry);
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE
+            const le_device_db_tlv_cache_entry_t * entry = &le_device_db_tlv_cache[i];
+#else
+            le_device_db_entry_t entry_buffer;
+            le_device_db_tlv_fetch(i, &entry_buffer);
+            const le_device_db_entry_t * entry = &entry_buffer;
+#endif
             // found addr?
-            if ((memcmp(addr, entry.addr, 6) == 0) && (addr_type == entry.addr_type)){
+            if ((memcmp(addr, entry->addr, 6) == 0) && (addr_type == entry->addr_type)){
                 index_for_addr = i;
             }
             // update highest seq nr
-            if (entry.seq_nr > highest_seq_nr){
-                highest_seq_nr = entry.seq_nr;
+            if (entry->seq_nr > highest_seq_nr){
+                highest_seq_nr = entry->seq_nr;
             }
             // find entry with lowest seq nr
-            if ((index_for_lowest_seq_nr == -1) || (entry.seq_nr < lowest_seq_nr)){
+            if ((index_for_lowest_seq_nr == -1) || (entry->seq_nr < lowest_seq_nr)){
                 index_for_lowest_seq_nr = i;
-                lowest_seq_nr = entry.seq_nr;
+                lowest_seq_nr = entry->seq_nr;
             }
         } else {
             index_for_empty = i;
@@ -277,6 +327,16 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 // get device information: addr type and address
 void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk){
 
+#ifdef ENABLE_LE_DEVICE_DB_TLV_CACHE
+    if ((index >= 0) && (index < NVM_NUM_DEVICE_DB_ENTRIES) && (entry_map[index] != 0u)){
+        const le_device_db_tlv_cache_entry_t * cache_entry = &le_device_db_tlv_cache[index];
+        if (addr_type) *addr_type = cache_entry->addr_type;
+        if (addr) (void)memcpy(addr, cache_entry->addr, 6);
+        if (irk) (void)memcpy(irk, cache_entry->irk, 16);
+        return;
+    }
+#endif
+
 	// fetch entry
     le_device_db_entry_t entry;
     int ok = le_device_db_tlv_fetch(index, &entry);
@@ -320,21 +380,27 @@ void le_device_db_encryption_set(int index, uint16_t ediv, uint8_t rand[8], sm_k
 
 void le_device_db_encryption_get(int index, uint16_t * ediv, uint8_t rand[8], sm_key_t ltk, int * key_size, int * authenticated, int * authorized, int * secure_connection){
 
+#if defined(ENABLE_LE_DEVICE_DB_TLV_CACHE) && defined(ENABLE_LE_DEVICE_DB_TLV_CACHE_ENCRYPTION)
+    if ((index < 0) || (index >= NVM_NUM_DEVICE_DB_ENTRIES) || (entry_map[index] == 0u)) return;
+    const le_device_db_tlv_cache_entry_t * entry = &le_device_db_tlv_cache[index];
+#else
 	// fetch entry
-	le_device_db_entry_t entry;
-	int ok = le_device_db_tlv_fetch(index, &entry);
+	le_device_db_entry_t entry_buffer;
+	int ok = le_device_db_tlv_fetch(index, &entry_buffer);
 	if (!ok) return;
+    const le_device_db_entry_t * entry = &entry_buffer;
+#endif
 
 	// update user fields
     log_info("LE Device DB encryption for %u, ediv x%04x, keysize %u, authenticated %u, authorized %u, secure connection %u",
-        index, entry.ediv, entry.key_size, entry.authenticated, entry.authorized, entry.secure_connection);
-    if (ediv) *ediv = entry.ediv;
-    if (rand) (void)memcpy(rand, entry.rand, 8);
-    if (ltk)  (void)memcpy(ltk, entry.ltk, 16);    
-    if (key_size) *key_size = entry.key_size;
-    if (authenticated) *authenticated = entry.authenticated;
-    if (authorized) *authorized = entry.authorized;
-    if (secure_connection) *secure_connection = entry.secure_connection;
+        index, entry->ediv, entry->key_size, entry->authenticated, entry->authorized, entry->secure_connection);
+    if (ediv) *ediv = entry->ediv;
+    if (rand) (void)memcpy(rand, entry->rand, 8);
+    if (ltk)  (void)memcpy(ltk, entry->ltk, 16);    
+    if (key_size) *key_size = entry->key_size;
+    if (authenticated) *authenticated = entry->authenticated;
+    if (authorized) *authorized = entry->authorized;
+    if (secure_connection) *secure_connection = entry->secure_connection;
 }
 
 #ifdef ENABLE_LE_SIGNED_WRITE
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "le_duty_cycle_manager.c"
+
+/*
+ * le_duty_cycle_manager.c
+ */
+
+#include "btstack_config.h"
+
+#include <string.h>
+
+#include "ble/le_duty_cycle_manager.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "gap.h"
+#include "hci.h"
+
+// max scan and advertising interval for legacy scanning and advertising, 10.24 s
+#define LE_DUTY_CYCLE_MANAGER_INTERVAL_MAX 0x4000
+
+static btstack_packet_callback_registration_t le_duty_cycle_manager_hci_event_callback_registration;
+static btstack_timer_source_t le_duty_cycle_manager_timer;
+static bool     le_duty_cycle_manager_started;
+static uint8_t  le_duty_cycle_manager_level;
+static uint8_t  le_duty_cycle_manager_power_budget_percent;
+static uint8_t  le_duty_cycle_manager_num_peripheral_connections;
+
+// burst parameters
+static bool     le_duty_cycle_manager_scan_parameters_set;
+static uint8_t  le_duty_cycle_manager_scan_type;
+static uint16_t le_duty_cycle_manager_scan_interval;
+static uint16_t le_duty_cycle_manager_scan_window;
+
+static bool      le_duty_cycle_manager_advertisement_params_set;
+static uint16_t  le_duty_cycle_manager_adv_int_min;
+static uint16_t  le_duty_cycle_manager_adv_int_max;
+static uint8_t   le_duty_cycle_manager_adv_type;
+static uint8_t   le_duty_cycle_manager_adv_direct_address_type;
+static bd_addr_t le_duty_cycle_manager_adv_direct_address;
+static uint8_t   le_duty_cycle_manager_adv_channel_map;
+static uint8_t   le_duty_cycle_manager_adv_filter_policy;
+
+// parameters currently set, 0 = not set yet
+static uint16_t le_duty_cycle_manager_active_scan_interval;
+static uint16_t le_duty_cycle_manager_active_adv_int_min;
+
+static bd_addr_t le_duty_cycle_manager_known_devices[LE_DUTY_CYCLE_MANAGER_NUM_KNOWN_DEVICES];
+static uint8_t   le_duty_cycle_manager_num_known_devices;
+static uint8_t   le_duty_cycle_manager_next_known_device;
+
+static uint16_t le_duty_cycle_manager_scale_interval(uint16_t interval, uint8_t level){
+    uint32_t scaled_interval = ((uint32_t) interval) << level;
+    return (uint16_t) btstack_min(scaled_interval, LE_DUTY_CYCLE_MANAGER_INTERVAL_MAX);
+}
+
+static void le_duty_cycle_manager_apply(void){
+    if (le_duty_cycle_manager_scan_parameters_set){
+        uint16_t scan_interval = le_duty_cycle_manager_scale_interval(le_duty_cycle_manager_scan_interval, le_duty_cycle_manager_level);
+        if (le_duty_cycle_manager_level > 0){
+            // limit duty cycle to power budget
+            uint32_t budget_interval = (((uint32_t) le_duty_cycle_manager_scan_window) * 100u) / le_duty_cycle_manager_power_budget_percent;
+            budget_interval = btstack_min(budget_interval, LE_DUTY_CYCLE_MANAGER_INTERVAL_MAX);
+            scan_interval = (uint16_t) btstack_max(scan_interval, budget_interval);
+        }
+        if (scan_interval != le_duty_cycle_manager_active_scan_interval){
+            log_info("duty cycle manager: level %u, scan interval %u, window %u", le_duty_cycle_manager_level, scan_interval, le_duty_cycle_manager_scan_window);
+            le_duty_cycle_manager_active_scan_interval = scan_interval;
+            gap_set_scan_parameters(le_duty_cycle_manager_scan_type, scan_interval, le_duty_cycle_manager_scan_window);
+        }
+    }
+    if (le_duty_cycle_manager_advertisement_params_set){
+        // already connected as Peripheral, advertise with slowest interval
+        uint8_t level = (le_duty_cycle_manager_num_peripheral_connections > 0) ? LE_DUTY_CYCLE_MANAGER_MAX_LEVEL : le_duty_cycle_manager_level;
+        uint16_t adv_int_min = le_duty_cycle_manager_scale_interval(le_duty_cycle_manager_adv_int_min, level);
+        uint16_t adv_int_max = le_duty_cycle_manager_scale_interval(le_duty_cycle_manager_adv_int_max, level);
+        if (adv_int_min != le_duty_cycle_manager_active_adv_int_min){
+            log_info("duty cycle manager: level %u, advertising interval %u-%u", level, adv_int_min, adv_int_max);
+            le_duty_cycle_manager_active_adv_int_min = adv_int_min;
+            gap_advertisements_set_params(adv_int_min, adv_int_max, le_duty_cycle_manager_adv_type,
+                                          le_duty_cycle_manager_adv_direct_address_type, le_duty_cycle_manager_adv_direct_address,
+                                          le_duty_cycle_manager_adv_channel_map, le_duty_cycle_manager_adv_filter_policy);
+        }
+    }
+}
+
+static void le_duty_cycle_manager_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    if (!le_duty_cycle_manager_started) return;
+    if (le_duty_cycle_manager_level >= LE_DUTY_CYCLE_MANAGER_MAX_LEVEL) return;
+    le_duty_cycle_manager_level++;
+    le_duty_cycle_manager_apply();
+    if (le_duty_cycle_manager_level >= LE_DUTY_CYCLE_MANAGER_MAX_LEVEL) return;
+    btstack_run_loop_set_timer(&le_duty_cycle_manager_timer, LE_DUTY_CYCLE_MANAGER_BACKOFF_STEP_MS);
+    btstack_run_loop_add_timer(&le_duty_cycle_manager_timer);
+}
+
+static void le_duty_cycle_manager_burst(void){
+    le_duty_cycle_manager_level = 0;
+    le_duty_cycle_manager_apply();
+    if (!le_duty_cycle_manager_started) return;
+    btstack_run_loop_remove_timer(&le_duty_cycle_manager_timer);
+    btstack_run_loop_set_timer_handler(&le_duty_cycle_manager_timer, &le_duty_cycle_manager_timeout_handler);
+    btstack_run_loop_set_timer(&le_duty_cycle_manager_timer, LE_DUTY_CYCLE_MANAGER_BURST_DURATION_MS);
+    btstack_run_loop_add_timer(&le_duty_cycle_manager_timer);
+}
+
+// @return true if device was not seen recently
+static bool le_duty_cycle_manager_remember_device(const bd_addr_t address){
+    uint8_t i;
+    for (i = 0; i < le_duty_cycle_manager_num_known_devices; i++){
+        if (bd_addr_cmp(le_duty_cycle_manager_known_devices[i], address) == 0) return false;
+    }
+    // replace oldest entry
+    bd_addr_copy(le_duty_cycle_manager_known_devices[le_duty_cycle_manager_next_known_device], address);
+    le_duty_cycle_manager_next_known_device = (le_duty_cycle_manager_next_known_device + 1) % LE_DUTY_CYCLE_MANAGER_NUM_KNOWN_DEVICES;
+    if (le_duty_cycle_manager_num_known_devices < LE_DUTY_CYCLE_MANAGER_NUM_KNOWN_DEVICES){
+        le_duty_cycle_manager_num_known_devices++;
+    }
+    return true;
+}
+
+static bool le_duty_cycle_manager_is_peripheral_connection(hci_con_handle_t con_handle){
+    if (gap_get_connection_type(con_handle) != GAP_CONNECTION_LE) return false;
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    return (conn != NULL) && (conn->role == HCI_ROLE_SLAVE);
+}
+
+static void le_duty_cycle_manager_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    bd_addr_t address;
+    switch (hci_event_packet_get_type(packet)){
+        case GAP_EVENT_ADVERTISING_REPORT:
+            gap_event_advertising_report_get_address(packet, address);
+            if (!le_duty_cycle_manager_remember_device(address)) break;
+            if (!le_duty_cycle_manager_started) break;
+            log_info("duty cycle manager: discovered %s", bd_addr_to_str(address));
+            le_duty_cycle_manager_burst();
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            if (hci_subevent_le_connection_complete_get_role(packet) != HCI_ROLE_SLAVE) break;
+            le_duty_cycle_manager_num_peripheral_connections++;
+            le_duty_cycle_manager_apply();
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            // connection is still valid while the event is dispatched
+            if (le_duty_cycle_manager_is_peripheral_connection(hci_event_disconnection_complete_get_connection_handle(packet))
+                && (le_duty_cycle_manager_num_peripheral_connections > 0)){
+                le_duty_cycle_manager_num_peripheral_connections--;
+            }
+            // peer might reconnect soon
+            if (!le_duty_cycle_manager_started) break;
+            le_duty_cycle_manager_burst();
+            break;
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_OFF) break;
+            le_duty_cycle_manager_num_peripheral_connections = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+void le_duty_cycle_manager_init(void){
+    le_duty_cycle_manager_started = false;
+    le_duty_cycle_manager_level = 0;
+    le_duty_cycle_manager_power_budget_percent = LE_DUTY_CYCLE_MANAGER_SCAN_POWER_BUDGET_PERCENT;
+    le_duty_cycle_manager_num_peripheral_connections = 0;
+    le_duty_cycle_manager_scan_parameters_set = false;
+    le_duty_cycle_manager_advertisement_params_set = false;
+    le_duty_cycle_manager_active_scan_interval = 0;
+    le_duty_cycle_manager_active_adv_int_min = 0;
+    le_duty_cycle_manager_num_known_devices = 0;
+    le_duty_cycle_manager_next_known_device = 0;
+    le_duty_cycle_manager_hci_event_callback_registration.callback = &le_duty_cycle_manager_packet_handler;
+    hci_add_event_handler(&le_duty_cycle_manager_hci_event_callback_registration);
+}
+
+void le_duty_cycle_manager_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window){
+    le_duty_cycle_manager_scan_type = scan_type;
+    le_duty_cycle_manager_scan_interval = scan_interval;
+    le_duty_cycle_manager_scan_window = scan_window;
+    le_duty_cycle_manager_scan_parameters_set = true;
+    le_duty_cycle_manager_active_scan_interval = 0;
+    le_duty_cycle_manager_apply();
+}
+
+void le_duty_cycle_manager_set_advertisement_params(uint16_t adv_int_min, uint16_t adv_int_max, uint8_t adv_type,
+    uint8_t direct_address_type, bd_addr_t direct_address, uint8_t channel_map, uint8_t filter_policy){
+    le_duty_cycle_manager_adv_int_min = adv_int_min;
+    le_duty_cycle_manager_adv_int_max = adv_int_max;
+    le_duty_cycle_manager_adv_type = adv_type;
+    le_duty_cycle_manager_adv_direct_address_type = direct_address_type;
+    bd_addr_copy(le_duty_cycle_manager_adv_direct_address, direct_address);
+    le_duty_cycle_manager_adv_channel_map = channel_map;
+    le_duty_cycle_manager_adv_filter_policy = filter_policy;
+    le_duty_cycle_manager_advertisement_params_set = true;
+    le_duty_cycle_manager_active_adv_int_min = 0;
+    le_duty_cycle_manager_apply();
+}
+
+void le_duty_cycle_manager_set_power_budget(uint8_t scan_duty_cycle_percent){
+    le_duty_cycle_manager_power_budget_percent = (uint8_t) btstack_max(1, btstack_min(scan_duty_cycle_percent, 100));
+    le_duty_cycle_manager_active_scan_interval = 0;
+    le_duty_cycle_manager_apply();
+}
+
+void le_duty_cycle_manager_trigger_burst(void){
+    le_duty_cycle_manager_burst();
+}
+
+void le_duty_cycle_manager_start(void){
+    le_duty_cycle_manager_started = true;
+    le_duty_cycle_manager_burst();
+}
+
+void le_duty_cycle_manager_stop(void){
+    le_duty_cycle_manager_started = false;
+    btstack_run_loop_remove_timer(&le_duty_cycle_manager_timer);
+    le_duty_cycle_manager_level = 0;
+    le_duty_cycle_manager_apply();
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * le_duty_cycle_manager.h
+ *
+ * Adapt LE scan and advertising intervals to discovery activity and connection state
+ *
+ * After start, after discovery of a new device and after a disconnect, the burst parameters are used for
+ * LE_DUTY_CYCLE_MANAGER_BURST_DURATION_MS. Then, the scan and advertising intervals are doubled every
+ * LE_DUTY_CYCLE_MANAGER_BACKOFF_STEP_MS up to LE_DUTY_CYCLE_MANAGER_MAX_LEVEL doublings. During backoff, the scan
+ * interval is also increased to keep the scan duty cycle (window / interval) within the configured power budget.
+ * While connected as Peripheral, advertising uses the slowest interval.
+ *
+ * Scanning and advertising are still enabled via gap_start_scan / gap_advertisements_enable. The parameters have
+ * to be set with le_duty_cycle_manager_set_scan_parameters / le_duty_cycle_manager_set_advertisement_params
+ * instead of the gap_ functions.
+ */
+
+#ifndef LE_DUTY_CYCLE_MANAGER_H
+#define LE_DUTY_CYCLE_MANAGER_H
+
+#include <stdint.h>
+#include "bluetooth.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// time burst parameters are used after start, new device discovered, or disconnect
+#ifndef LE_DUTY_CYCLE_MANAGER_BURST_DURATION_MS
+#define LE_DUTY_CYCLE_MANAGER_BURST_DURATION_MS 30000
+#endif
+
+// time between two backoff steps
+#ifndef LE_DUTY_CYCLE_MANAGER_BACKOFF_STEP_MS
+#define LE_DUTY_CYCLE_MANAGER_BACKOFF_STEP_MS 30000
+#endif
+
+// max number of interval doublings
+#ifndef LE_DUTY_CYCLE_MANAGER_MAX_LEVEL
+#define LE_DUTY_CYCLE_MANAGER_MAX_LEVEL 4
+#endif
+
+// number of recently seen advertisers, a report from another device counts as discovery
+#ifndef LE_DUTY_CYCLE_MANAGER_NUM_KNOWN_DEVICES
+#define LE_DUTY_CYCLE_MANAGER_NUM_KNOWN_DEVICES 16
+#endif
+
+// max scan duty cycle during backoff in percent
+#ifndef LE_DUTY_CYCLE_MANAGER_SCAN_POWER_BUDGET_PERCENT
+#define LE_DUTY_CYCLE_MANAGER_SCAN_POWER_BUDGET_PERCENT 10
+#endif
+
+/* API_START */
+
+/**
+ * @brief Init duty cycle manager
+ */
+void le_duty_cycle_manager_init(void);
+
+/**
+ * @brief Set scan parameters used during burst
+ * @param scan_type 0 = passive, 1 = active
+ * @param scan_interval unit: 0.625 ms
+ * @param scan_window unit: 0.625 ms
+ */
+void le_duty_cycle_manager_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window);
+
+/**
+ * @brief Set advertisement parameters used during burst, see gap_advertisements_set_params
+ * @param adv_int_min unit: 0.625 ms
+ * @param adv_int_max unit: 0.625 ms
+ * @param adv_type
+ * @param direct_address_type
+ * @param direct_address
+ * @param channel_map
+ * @param filter_policy
+ */
+void le_duty_cycle_manager_set_advertisement_params(uint16_t adv_int_min, uint16_t adv_int_max, uint8_t adv_type,
+    uint8_t direct_address_type, bd_addr_t direct_address, uint8_t channel_map, uint8_t filter_policy);
+
+/**
+ * @brief Set max scan duty cycle during backoff
+ * @param scan_duty_cycle_percent 1..100
+ */
+void le_duty_cycle_manager_set_power_budget(uint8_t scan_duty_cycle_percent);
+
+/**
+ * @brief Use burst parameters again, e.g. on user interaction
+ */
+void le_duty_cycle_manager_trigger_burst(void);
+
+/**
+ * @brief Start adapting scan and advertising parameters, starts with burst
+ */
+void le_duty_cycle_manager_start(void);
+
+/**
+ * @brief Stop adapting, burst parameters are set
+ */
+void le_duty_cycle_manager_stop(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // LE_DUTY_CYCLE_MANAGER_H
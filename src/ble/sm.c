@@ -83,6 +83,11 @@
 #define USE_CMAC_ENGINE
 #endif
 
+// LTK Requests with EDIV and Rand are only handled as responder
+#if defined(ENABLE_SM_LTK_CACHE) && defined(ENABLE_LE_PERIPHERAL)
+#define USE_SM_LTK_CACHE
+#endif
+
 #define BTSTACK_TAG32(A,B,C,D) (((A) << 24) | ((B) << 16) | ((C) << 8) | (D))
 
 //
@@ -251,6 +256,38 @@ static void *    sm_address_resolution_context;
 static address_resolution_mode_t sm_address_resolution_mode;
 static btstack_linked_list_t sm_address_resolution_general_queue;
 
+#ifdef ENABLE_SM_ADDRESS_RESOLUTION_CACHE
+#ifndef SM_ADDRESS_RESOLUTION_CACHE_SIZE
+#define SM_ADDRESS_RESOLUTION_CACHE_SIZE 8
+#endif
+// recently resolved private addresses, le_device_index -1 if no bonded IRK matched
+typedef struct {
+    bd_addr_t address;
+    int       le_device_index;
+    sm_key_t  irk;
+    uint32_t  last_used;
+} sm_address_resolution_cache_entry_t;
+static sm_address_resolution_cache_entry_t sm_address_resolution_cache[SM_ADDRESS_RESOLUTION_CACHE_SIZE];
+static uint8_t  sm_address_resolution_cache_count;
+static uint32_t sm_address_resolution_cache_time;
+#endif
+
+#ifdef USE_SM_LTK_CACHE
+#ifndef SM_LTK_CACHE_SIZE
+#define SM_LTK_CACHE_SIZE 4
+#endif
+// recently reconstructed LTKs for legacy LTK Requests, LTK is already truncated to encryption key size
+typedef struct {
+    uint16_t  ediv;
+    uint8_t   rand[8];
+    sm_key_t  ltk;
+    uint32_t  last_used;
+} sm_ltk_cache_entry_t;
+static sm_ltk_cache_entry_t sm_ltk_cache[SM_LTK_CACHE_SIZE];
+static uint8_t  sm_ltk_cache_count;
+static uint32_t sm_ltk_cache_time;
+#endif
+
 // aes128 crypto engine.
 static sm_aes128_state_t  sm_aes128_state;
 
@@ -261,9 +298,9 @@ static btstack_crypto_aes128_t   sm_crypto_aes128_request;
 static btstack_crypto_ecc_p256_t sm_crypto_ecc_p256_request;
 #endif
 
-// temp storage for random data
-static uint8_t sm_random_data[8];
+#if !defined(ENABLE_SOFTWARE_AES128) && !defined(HAVE_AES128)
 static uint8_t sm_aes128_key[16];
+#endif
 static uint8_t sm_aes128_plaintext[16];
 static uint8_t sm_aes128_ciphertext[16];
 
@@ -291,6 +328,13 @@ typedef struct sm_setup_context {
 
     btstack_timer_source_t sm_timeout;
 
+    // crypto requests and results of the connection that uses this context
+    btstack_crypto_random_t   sm_crypto_random_request;
+    uint8_t                   sm_random_data[8];
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+    btstack_crypto_ecc_p256_t sm_crypto_ecc_p256_request;
+#endif
+
     // used in all phases
     uint8_t   sm_pairing_failed_reason;
 
@@ -365,13 +409,66 @@ typedef struct sm_setup_context {
 
 } sm_setup_context_t;
 
+// number of connections that can pair or re-encrypt at the same time
+#ifndef MAX_NR_SM_SETUP_CONTEXTS
+#define MAX_NR_SM_SETUP_CONTEXTS 1
+#endif
+
 //
-static sm_setup_context_t the_setup;
-static sm_setup_context_t * setup = &the_setup;
+static sm_setup_context_t sm_setup_contexts[MAX_NR_SM_SETUP_CONTEXTS];
+static sm_setup_context_t * setup = &sm_setup_contexts[0];
 
-// active connection - the one for which the_setup is used for
+// connection that uses a setup context, HCI_CON_HANDLE_INVALID if free
+static hci_con_handle_t sm_setup_context_handles[MAX_NR_SM_SETUP_CONTEXTS];
+
+// active connection - the one for which the selected setup context is used for
 static uint16_t sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
 
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+// ec key is renewed after pairings (that used it) once no other pairing is ongoing
+static bool sm_ec_key_renewal_pending;
+#endif
+
+// @returns index of setup context used by connection, or of a free one for HCI_CON_HANDLE_INVALID, -1 if none
+static int sm_setup_context_index_for_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i = 0; i < MAX_NR_SM_SETUP_CONTEXTS; i++){
+        if (sm_setup_context_handles[i] == con_handle) return i;
+    }
+    return -1;
+}
+
+static bool sm_setup_context_available(void){
+    return sm_setup_context_index_for_handle(HCI_CON_HANDLE_INVALID) >= 0;
+}
+
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+static bool sm_setup_context_in_use(void){
+    int i;
+    for (i = 0; i < MAX_NR_SM_SETUP_CONTEXTS; i++){
+        if (sm_setup_context_handles[i] != HCI_CON_HANDLE_INVALID) return true;
+    }
+    return false;
+}
+#endif
+
+// lock free setup context for connection and point setup to it
+static void sm_setup_context_reserve(int index, hci_con_handle_t con_handle){
+    sm_setup_context_handles[index] = con_handle;
+    setup = &sm_setup_contexts[index];
+    sm_active_connection_handle = con_handle;
+}
+
+// point setup to the context used by the connection
+static bool sm_setup_context_select(hci_con_handle_t con_handle){
+    if (con_handle == HCI_CON_HANDLE_INVALID) return false;
+    int index = sm_setup_context_index_for_handle(con_handle);
+    if (index < 0) return false;
+    setup = &sm_setup_contexts[index];
+    sm_active_connection_handle = con_handle;
+    return true;
+}
+
 // @returns 1 if oob data is available
 // stores oob data in provided 16 byte buffer if not null
 static int (*sm_get_oob_data)(uint8_t addres_type, bd_addr_t addr, uint8_t * oob_data) = NULL;
@@ -382,7 +479,9 @@ static void sm_done_for_handle(hci_con_handle_t con_handle);
 static sm_connection_t * sm_get_connection_for_handle(hci_con_handle_t con_handle);
 static inline int sm_calc_actual_encryption_key_size(int other);
 static int sm_validate_stk_generation_method(void);
+#if !defined(ENABLE_SOFTWARE_AES128) && !defined(HAVE_AES128)
 static void sm_handle_encryption_result_address_resolution(void *arg);
+#endif
 static void sm_handle_encryption_result_dkg_dhk(void *arg);
 static void sm_handle_encryption_result_dkg_irk(void *arg);
 static void sm_handle_encryption_result_enc_a(void *arg);
@@ -531,6 +630,7 @@ static int sm_ir_is_default(void){
 static void sm_timeout_handler(btstack_timer_source_t * timer){
     log_info("SM timeout");
     sm_connection_t * sm_conn = (sm_connection_t*) btstack_run_loop_get_timer_context(timer);
+    sm_setup_context_select(sm_conn->sm_handle);
     sm_conn->sm_engine_state = SM_GENERAL_TIMEOUT;
     sm_notify_client_status_reason(sm_conn, ERROR_CODE_CONNECTION_TIMEOUT, 0);
     sm_done_for_handle(sm_conn->sm_handle);
@@ -670,6 +770,7 @@ static void sm_dispatch_event(uint8_t packet_type, uint16_t channel, uint8_t * p
     btstack_linked_list_iterator_init(&it, &sm_event_handlers);
     while (btstack_linked_list_iterator_has_next(&it)){
         btstack_packet_callback_registration_t * entry = (btstack_packet_callback_registration_t*) btstack_linked_list_iterator_next(&it);
+        if (!btstack_event_filter_matches(entry->event_filter, packet[0])) continue;
         entry->callback(packet_type, 0, packet, size);
     }
 }
@@ -844,6 +945,72 @@ static void sm_setup_key_distribution(uint8_t key_set){
 // CSRK Key Lookup
 
 
+#ifdef ENABLE_SM_ADDRESS_RESOLUTION_CACHE
+static void sm_address_resolution_cache_reset(void){
+    sm_address_resolution_cache_count = 0;
+}
+
+static sm_address_resolution_cache_entry_t * sm_address_resolution_cache_for_address(const bd_addr_t address){
+    uint8_t i;
+    for (i=0;i<sm_address_resolution_cache_count;i++){
+        if (memcmp(sm_address_resolution_cache[i].address, address, 6) == 0){
+            return &sm_address_resolution_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static sm_address_resolution_cache_entry_t * sm_address_resolution_cache_get_entry(const bd_addr_t address){
+    sm_address_resolution_cache_entry_t * entry = sm_address_resolution_cache_for_address(address);
+    if (entry != NULL) return entry;
+    if (sm_address_resolution_cache_count < SM_ADDRESS_RESOLUTION_CACHE_SIZE){
+        entry = &sm_address_resolution_cache[sm_address_resolution_cache_count++];
+    } else {
+        // replace least recently used entry
+        uint8_t i;
+        entry = &sm_address_resolution_cache[0];
+        for (i=1;i<SM_ADDRESS_RESOLUTION_CACHE_SIZE;i++){
+            if (sm_address_resolution_cache[i].last_used < entry->last_used){
+                entry = &sm_address_resolution_cache[i];
+            }
+        }
+    }
+    (void)memcpy(entry->address, address, 6);
+    return entry;
+}
+
+static void sm_address_resolution_cache_store(const bd_addr_t address, int le_device_index){
+    sm_address_resolution_cache_entry_t * entry = sm_address_resolution_cache_get_entry(address);
+    entry->le_device_index = le_device_index;
+    entry->last_used = ++sm_address_resolution_cache_time;
+    if (le_device_index < 0) return;
+    int addr_type;
+    bd_addr_t addr;
+    le_device_db_info(le_device_index, &addr_type, addr, entry->irk);
+}
+
+// returns true if address was found in cache and sets sm_address_resolution_test to le device index or end of le device db
+static bool sm_address_resolution_cache_lookup(const bd_addr_t address){
+    sm_address_resolution_cache_entry_t * entry = sm_address_resolution_cache_for_address(address);
+    if (entry == NULL) return false;
+    if (entry->le_device_index < 0){
+        sm_address_resolution_test = le_device_db_max_count();
+        return true;
+    }
+    // validate that le device db entry was not replaced
+    int addr_type = BD_ADDR_TYPE_UNKNOWN;
+    bd_addr_t addr;
+    sm_key_t irk;
+    le_device_db_info(entry->le_device_index, &addr_type, addr, irk);
+    if ((addr_type == BD_ADDR_TYPE_UNKNOWN) || (memcmp(irk, entry->irk, 16) != 0)){
+        sm_address_resolution_cache_reset();
+        return false;
+    }
+    sm_address_resolution_test = entry->le_device_index;
+    return true;
+}
+#endif
+
 static int sm_address_resolution_idle(void){
     return sm_address_resolution_mode == ADDRESS_RESOLUTION_IDLE;
 }
@@ -1002,14 +1169,19 @@ static int sm_key_distribution_all_received(sm_connection_t * sm_conn){
 }
 
 static void sm_done_for_handle(hci_con_handle_t con_handle){
-    if (sm_active_connection_handle == con_handle){
+    if (sm_setup_context_select(con_handle)){
         sm_timeout_stop();
+        sm_setup_context_handles[sm_setup_context_index_for_handle(con_handle)] = HCI_CON_HANDLE_INVALID;
         sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
         log_info("sm: connection 0x%x released setup context", con_handle);
 
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
-        // generate new ec key after each pairing (that used it)
+        // generate new ec key after each pairing (that used it), but not while other pairings still use it
         if (setup->sm_use_secure_connections){
+            sm_ec_key_renewal_pending = true;
+        }
+        if (sm_ec_key_renewal_pending && !sm_setup_context_in_use()){
+            sm_ec_key_renewal_pending = false;
             sm_ec_generate_new_key();
         }
 #endif
@@ -1159,6 +1331,13 @@ static void sm_address_resolution_handle_event(address_resolution_event_t event)
     address_resolution_mode_t mode = sm_address_resolution_mode;
     void * context = sm_address_resolution_context;
 
+#ifdef ENABLE_SM_ADDRESS_RESOLUTION_CACHE
+    // remember result for resolvable private addresses
+    if ((sm_address_resolution_addr_type == BD_ADDR_TYPE_LE_RANDOM) && ((sm_address_resolution_address[0] & 0xc0) == 0x40)){
+        sm_address_resolution_cache_store(sm_address_resolution_address, (event == ADDRESS_RESOLUTION_SUCEEDED) ? matched_device_id : -1);
+    }
+#endif
+
     // reset context
     sm_address_resolution_mode = ADDRESS_RESOLUTION_IDLE;
     sm_address_resolution_context = NULL;
@@ -1305,10 +1484,17 @@ static void sm_key_distribution_handle_all_received(sm_connection_t * sm_conn){
         // if not found, add to db
         if (le_db_index < 0) {
             le_db_index = le_device_db_add(setup->sm_peer_addr_type, setup->sm_peer_address, setup->sm_peer_irk);
+#ifdef ENABLE_SM_ADDRESS_RESOLUTION_CACHE
+            // addresses that did not resolve before might match the new IRK
+            sm_address_resolution_cache_reset();
+#endif
         }
 
         if (le_db_index >= 0){
 
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+            hci_load_le_device_db_entry_into_resolving_list((uint16_t) le_db_index);
+#endif
             sm_notify_client_index(SM_EVENT_IDENTITY_CREATED, sm_conn->sm_handle, setup->sm_peer_addr_type, setup->sm_peer_address, le_db_index);
             sm_conn->sm_irk_lookup_state = IRK_LOOKUP_SUCCEEDED;
 
@@ -1373,7 +1559,7 @@ static void sm_sc_start_calculating_local_confirm(sm_connection_t * sm_conn){
     if (setup->sm_stk_generation_method == OOB){
         sm_conn->sm_engine_state = SM_SC_W2_CMAC_FOR_CONFIRMATION;
     } else {
-        btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_w2_cmac_for_confirmation, (void *)(uintptr_t) sm_conn->sm_handle);
+        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_w2_cmac_for_confirmation, (void *)(uintptr_t) sm_conn->sm_handle);
     }
 }
 
@@ -1383,7 +1569,7 @@ static void sm_sc_state_after_receiving_random(sm_connection_t * sm_conn){
         if (setup->sm_stk_generation_method == OOB){
             // generate Nb
             log_info("Generate Nb");
-            btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_send_pairing_random, (void *)(uintptr_t) sm_conn->sm_handle);
+            btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_send_pairing_random, (void *)(uintptr_t) sm_conn->sm_handle);
         } else {
             sm_conn->sm_engine_state = SM_SC_SEND_PAIRING_RANDOM;
         }
@@ -1425,6 +1611,7 @@ static void sm_sc_cmac_done(uint8_t * hash){
 
     sm_connection_t * sm_conn = sm_cmac_connection;
     sm_cmac_connection = NULL;
+    sm_setup_context_select(sm_conn->sm_handle);
 #ifdef ENABLE_CLASSIC
     link_key_type_t link_key_type;
 #endif
@@ -1822,21 +2009,68 @@ static void sm_load_security_info(sm_connection_t * sm_connection){
 #endif
 
 #ifdef ENABLE_LE_PERIPHERAL
-static void sm_start_calculating_ltk_from_ediv_and_rand(sm_connection_t * sm_connection){
-    (void)memcpy(setup->sm_local_rand, sm_connection->sm_local_rand, 8);
-    setup->sm_local_ediv = sm_connection->sm_local_ediv;
+static void sm_restore_security_level_from_rand(sm_connection_t * sm_connection){
     // re-establish used key encryption size
-    // no db for encryption size hack: encryption size is stored in lowest nibble of setup->sm_local_rand
-    sm_connection->sm_actual_encryption_key_size = (setup->sm_local_rand[7] & 0x0f) + 1;
+    // no db for encryption size hack: encryption size is stored in lowest nibble of sm_local_rand
+    sm_connection->sm_actual_encryption_key_size = (sm_connection->sm_local_rand[7] & 0x0f) + 1;
     // no db for authenticated flag hack: flag is stored in bit 4 of LSB
-    sm_connection->sm_connection_authenticated = (setup->sm_local_rand[7] & 0x10) >> 4;
+    sm_connection->sm_connection_authenticated = (sm_connection->sm_local_rand[7] & 0x10) >> 4;
     // Legacy paring -> not SC
     sm_connection->sm_connection_sc = 0;
     log_info("sm: received ltk request with key size %u, authenticated %u",
             sm_connection->sm_actual_encryption_key_size, sm_connection->sm_connection_authenticated);
+}
+
+static void sm_start_calculating_ltk_from_ediv_and_rand(sm_connection_t * sm_connection){
+    (void)memcpy(setup->sm_local_rand, sm_connection->sm_local_rand, 8);
+    setup->sm_local_ediv = sm_connection->sm_local_ediv;
+    sm_restore_security_level_from_rand(sm_connection);
     sm_connection->sm_engine_state = SM_RESPONDER_PH4_Y_GET_ENC;
     sm_run();
 }
+
+#ifdef USE_SM_LTK_CACHE
+static sm_ltk_cache_entry_t * sm_ltk_cache_for_ediv_and_rand(uint16_t ediv, const uint8_t * rand){
+    uint8_t i;
+    for (i=0;i<sm_ltk_cache_count;i++){
+        if ((sm_ltk_cache[i].ediv == ediv) && (memcmp(sm_ltk_cache[i].rand, rand, 8) == 0)){
+            return &sm_ltk_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static void sm_ltk_cache_store(uint16_t ediv, const uint8_t * rand, const sm_key_t ltk){
+    sm_ltk_cache_entry_t * entry = sm_ltk_cache_for_ediv_and_rand(ediv, rand);
+    if (entry == NULL){
+        if (sm_ltk_cache_count < SM_LTK_CACHE_SIZE){
+            entry = &sm_ltk_cache[sm_ltk_cache_count++];
+        } else {
+            // replace least recently used entry
+            uint8_t i;
+            entry = &sm_ltk_cache[0];
+            for (i=1;i<SM_LTK_CACHE_SIZE;i++){
+                if (sm_ltk_cache[i].last_used < entry->last_used){
+                    entry = &sm_ltk_cache[i];
+                }
+            }
+        }
+    }
+    entry->ediv = ediv;
+    (void)memcpy(entry->rand, rand, 8);
+    (void)memcpy(entry->ltk, ltk, 16);
+    entry->last_used = ++sm_ltk_cache_time;
+}
+
+// returns true if LTK for EDIV and Rand of connection was found in cache
+static bool sm_ltk_cache_lookup(sm_connection_t * sm_connection, sm_key_t ltk){
+    sm_ltk_cache_entry_t * entry = sm_ltk_cache_for_ediv_and_rand(sm_connection->sm_local_ediv, sm_connection->sm_local_rand);
+    if (entry == NULL) return false;
+    entry->last_used = ++sm_ltk_cache_time;
+    (void)memcpy(ltk, entry->ltk, 16);
+    return true;
+}
+#endif
 #endif
 
 // distributed key generation
@@ -1928,6 +2162,17 @@ static bool sm_run_csrk(void){
 
     // -- Continue with CSRK device lookup by public or resolvable private address
     if (!sm_address_resolution_idle()){
+#ifdef ENABLE_SM_ADDRESS_RESOLUTION_CACHE
+        if ((sm_address_resolution_test == 0) && (sm_address_resolution_addr_type == BD_ADDR_TYPE_LE_RANDOM)){
+            if (sm_address_resolution_cache_lookup(sm_address_resolution_address)){
+                log_info("LE Device Lookup: cached result, device %d", sm_address_resolution_test);
+                if (sm_address_resolution_test < le_device_db_max_count()){
+                    sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
+                    return false;
+                }
+            }
+        }
+#endif
         log_info("LE Device Lookup: device %u/%u", sm_address_resolution_test, le_device_db_max_count());
         while (sm_address_resolution_test < le_device_db_max_count()){
             int addr_type = BD_ADDR_TYPE_UNKNOWN;
@@ -1954,6 +2199,19 @@ static bool sm_run_csrk(void){
                 continue;
             }
 
+#if defined(ENABLE_SOFTWARE_AES128) || defined (HAVE_AES128)
+            // test all IRKs in one pass without using the crypto engine
+            sm_key_t r_prime;
+            sm_key_t hash;
+            sm_ah_r_prime(sm_address_resolution_address, r_prime);
+            btstack_aes128_calc(irk, r_prime, hash);
+            if (memcmp(&sm_address_resolution_address[3], &hash[13], 3) == 0){
+                log_info("LE Device Lookup: matched resolvable private address");
+                sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
+                break;
+            }
+            sm_address_resolution_test++;
+#else
             if (sm_aes128_state == SM_AES128_ACTIVE) break;
 
             log_info("LE Device Lookup: calculate AH");
@@ -1965,6 +2223,7 @@ static bool sm_run_csrk(void){
             sm_aes128_state = SM_AES128_ACTIVE;
             btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_aes128_key, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_address_resolution, NULL);
             return true;
+#endif
         }
 
         if (sm_address_resolution_test >= le_device_db_max_count()){
@@ -1994,8 +2253,28 @@ static bool sm_run_oob(void){
 // handle basic actions that don't requires the full context
 static bool sm_run_basic(void){
     btstack_linked_list_iterator_t it;
+
+#ifdef USE_SM_LTK_CACHE
+    // LTK reconstructed before -> reply without setup context, also if all setup contexts are in use
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        sm_connection_t  * sm_connection = &hci_connection->sm_connection;
+        if (sm_connection->sm_engine_state != SM_RESPONDER_PH0_RECEIVED_LTK_REQUEST) continue;
+        sm_key_t ltk;
+        if (!sm_ltk_cache_lookup(sm_connection, ltk)) continue;
+        log_info("LTK Request: using cached LTK for ediv 0x%04x", sm_connection->sm_local_ediv);
+        sm_restore_security_level_from_rand(sm_connection);
+        sm_key_t ltk_flipped;
+        reverse_128(ltk, ltk_flipped);
+        sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
+        hci_send_cmd(&hci_le_long_term_key_request_reply, sm_connection->sm_handle, ltk_flipped);
+        return true;
+    }
+#endif
+
     hci_connections_get_iterator(&it);
-    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_linked_list_iterator_has_next(&it)){
+    while(sm_setup_context_available() && btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         sm_connection_t  * sm_connection = &hci_connection->sm_connection;
         switch(sm_connection->sm_engine_state){
@@ -2026,13 +2305,17 @@ static bool sm_run_basic(void){
 }
 
 static void sm_run_activate_connection(void){
-    // Find connections that requires setup context and make active if no other is locked
+    // Find connections that requires setup context and make active if a setup context is free
     btstack_linked_list_iterator_t it;
     hci_connections_get_iterator(&it);
-    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_linked_list_iterator_has_next(&it)){
+    while(sm_setup_context_available() && btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         sm_connection_t  * sm_connection = &hci_connection->sm_connection;
-        // - if no connection locked and we're ready/waiting for setup context, fetch it and start
+        // skip connections that already use a setup context
+        if (sm_setup_context_index_for_handle(sm_connection->sm_handle) >= 0) continue;
+        // - if a setup context is free and we're ready/waiting for setup context, fetch it and start
+        // - setup is only pointed to the free context once it has been reserved for this connection
+        int index = sm_setup_context_index_for_handle(HCI_CON_HANDLE_INVALID);
         int done = 1;
         int err;
         UNUSED(err);
@@ -2041,6 +2324,10 @@ static void sm_run_activate_connection(void){
         // assert ec key is ready
         if ((sm_connection->sm_engine_state == SM_RESPONDER_PH1_PAIRING_REQUEST_RECEIVED)
             ||  (sm_connection->sm_engine_state == SM_INITIATOR_PH1_W2_SEND_PAIRING_REQUEST)){
+            // wait for renewal of ec key used by previous pairings
+            if (sm_ec_key_renewal_pending){
+                continue;
+            }
             if (ec_key_generation_state == EC_KEY_GENERATION_IDLE){
                 sm_ec_generate_new_key();
             }
@@ -2065,6 +2352,7 @@ static void sm_run_activate_connection(void){
                 done = 0;
                 break;
             case SM_RESPONDER_PH1_PAIRING_REQUEST_RECEIVED:
+                sm_setup_context_reserve(index, sm_connection->sm_handle);
                 sm_reset_setup();
                 sm_init_setup(sm_connection);
                 // recover pairing request
@@ -2087,12 +2375,13 @@ static void sm_run_activate_connection(void){
                 sm_timeout_start(sm_connection);
                 // generate random number first, if we need to show passkey
                 if (setup->sm_stk_generation_method == PK_INIT_INPUT){
-                    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph2_tk, (void *)(uintptr_t) sm_connection->sm_handle);
+                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph2_tk, (void *)(uintptr_t) sm_connection->sm_handle);
                     break;
                 }
                 sm_connection->sm_engine_state = SM_RESPONDER_PH1_SEND_PAIRING_RESPONSE;
                 break;
             case SM_RESPONDER_PH0_RECEIVED_LTK_REQUEST:
+                sm_setup_context_reserve(index, sm_connection->sm_handle);
                 sm_reset_setup();
                 sm_start_calculating_ltk_from_ediv_and_rand(sm_connection);
                 break;
@@ -2103,6 +2392,7 @@ static void sm_run_activate_connection(void){
                     case IRK_LOOKUP_SUCCEEDED:
                         // assuming Secure Connection, we have a stored LTK and the EDIV/RAND are null
                         // start using context by loading security info
+                        sm_setup_context_reserve(index, sm_connection->sm_handle);
                         sm_reset_setup();
                         sm_load_security_info(sm_connection);
                         if ((setup->sm_peer_ediv == 0) && sm_is_null_random(setup->sm_peer_rand) && !sm_is_null_key(setup->sm_peer_ltk)){
@@ -2114,7 +2404,9 @@ static void sm_run_activate_connection(void){
                         log_info("LTK Request: ediv & random are empty, but no stored LTK (IRK Lookup Succeeded)");
                         sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
                         hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
-                        // don't lock setup context yet
+                        // release setup context again
+                        sm_setup_context_handles[index] = HCI_CON_HANDLE_INVALID;
+                        sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
                         return;
                     default:
                         // just wait until IRK lookup is completed
@@ -2128,11 +2420,13 @@ static void sm_run_activate_connection(void){
 
 #ifdef ENABLE_LE_CENTRAL
             case SM_INITIATOR_PH0_HAS_LTK:
+                sm_setup_context_reserve(index, sm_connection->sm_handle);
                 sm_reset_setup();
                 sm_load_security_info(sm_connection);
                 sm_connection->sm_engine_state = SM_INITIATOR_PH0_SEND_START_ENCRYPTION;
                 break;
             case SM_INITIATOR_PH1_W2_SEND_PAIRING_REQUEST:
+                sm_setup_context_reserve(index, sm_connection->sm_handle);
                 sm_reset_setup();
                 sm_init_setup(sm_connection);
                 sm_timeout_start(sm_connection);
@@ -2145,8 +2439,7 @@ static void sm_run_activate_connection(void){
                 break;
         }
         if (done){
-            sm_active_connection_handle = sm_connection->sm_handle;
-            log_info("sm: connection 0x%04x locked setup context as %s, state %u", sm_active_connection_handle, sm_connection->sm_role ? "responder" : "initiator", sm_connection->sm_engine_state);
+            log_info("sm: connection 0x%04x locked setup context %u as %s, state %u", sm_active_connection_handle, index, sm_connection->sm_role ? "responder" : "initiator", sm_connection->sm_engine_state);
         }
     }
 }
@@ -2189,13 +2482,17 @@ static void sm_run(void){
 
     //
     // active connection handling
-    // -- use loop to handle next connection if lock on setup context is released
+    // -- use loop to handle all connections with setup context and the next connection if a setup context is released
 
-    while (true) {
+    int setup_context_index;
+    for (setup_context_index = 0; setup_context_index < MAX_NR_SM_SETUP_CONTEXTS; setup_context_index++) {
 
         sm_run_activate_connection();
 
-        if (sm_active_connection_handle == HCI_CON_HANDLE_INVALID) return;
+        // assert that we can send at least commands - cmd might have been sent for other connection
+        if (!hci_can_send_command_packet_now()) continue;
+
+        if (!sm_setup_context_select(sm_setup_context_handles[setup_context_index])) continue;
 
         //
         // active connection handling
@@ -2204,14 +2501,14 @@ static void sm_run(void){
         sm_connection_t * connection = sm_get_connection_for_handle(sm_active_connection_handle);
         if (!connection) {
             log_info("no connection for handle 0x%04x", sm_active_connection_handle);
-            return;
+            continue;
         }
 
         // assert that we could send a SM PDU - not needed for all of the following
         if (!l2cap_can_send_fixed_channel_packet_now(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)) {
             log_info("cannot send now, requesting can send now event");
             l2cap_request_can_send_fix_channel_now_event(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
-            return;
+            continue;
         }
 
         // send keypress notifications
@@ -2252,7 +2549,7 @@ static void sm_run(void){
 
             // try
             l2cap_request_can_send_fix_channel_now_event(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
-            return;
+            continue;
         }
 
         int key_distribution_flags;
@@ -2340,7 +2637,7 @@ static void sm_run(void){
                 uint32_t rand_high = big_endian_read_32(setup->sm_peer_rand, 0);
                 uint32_t rand_low  = big_endian_read_32(setup->sm_peer_rand, 4);
                 hci_send_cmd(&hci_le_start_encryption, connection->sm_handle,rand_low, rand_high, setup->sm_peer_ediv, peer_ltk_flipped);
-                return;
+                continue;
             }
 
             case SM_INITIATOR_PH1_SEND_PAIRING_REQUEST:
@@ -2521,7 +2818,7 @@ static void sm_run(void){
                 if (!setup->sm_use_secure_connections || (setup->sm_stk_generation_method == JUST_WORKS)){
                     sm_trigger_user_response(connection);
                 }
-                return;
+                continue;
 #endif
 
             case SM_PH2_SEND_PAIRING_RANDOM: {
@@ -2600,7 +2897,7 @@ static void sm_run(void){
                 }
                 l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                 sm_timeout_reset(connection);
-                return;
+                continue;
             }
 #ifdef ENABLE_LE_PERIPHERAL
             case SM_RESPONDER_PH2_SEND_LTK_REPLY: {
@@ -2608,7 +2905,7 @@ static void sm_run(void){
                 reverse_128(setup->sm_ltk, stk_flipped);
                 connection->sm_engine_state = SM_PH2_W4_CONNECTION_ENCRYPTED;
                 hci_send_cmd(&hci_le_long_term_key_request_reply, connection->sm_handle, stk_flipped);
-                return;
+                continue;
             }
             case SM_RESPONDER_PH4_SEND_LTK_REPLY: {
                 sm_key_t ltk_flipped;
@@ -2616,7 +2913,7 @@ static void sm_run(void){
                 connection->sm_engine_state = SM_RESPONDER_IDLE;
                 hci_send_cmd(&hci_le_long_term_key_request_reply, connection->sm_handle, ltk_flipped);
                 sm_done_for_handle(connection->sm_handle);
-                return;
+                continue;
             }
             case SM_RESPONDER_PH4_Y_GET_ENC:
                 // already busy?
@@ -2633,7 +2930,7 @@ static void sm_run(void){
                 connection->sm_engine_state = SM_RESPONDER_PH4_Y_W4_ENC;
                 sm_aes128_state = SM_AES128_ACTIVE;
                 btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_dhk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_enc_ph4_y, (void *)(uintptr_t) connection->sm_handle);
-                return;
+                continue;
 #endif
 #ifdef ENABLE_LE_CENTRAL
             case SM_INITIATOR_PH3_SEND_START_ENCRYPTION: {
@@ -2641,7 +2938,7 @@ static void sm_run(void){
                 reverse_128(setup->sm_ltk, stk_flipped);
                 connection->sm_engine_state = SM_PH2_W4_CONNECTION_ENCRYPTED;
                 hci_send_cmd(&hci_le_start_encryption, connection->sm_handle, 0, 0, 0, stk_flipped);
-                return;
+                continue;
             }
 #endif
 
@@ -2654,7 +2951,7 @@ static void sm_run(void){
                     reverse_128(setup->sm_ltk, &buffer[1]);
                     l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                     sm_timeout_reset(connection);
-                    return;
+                    continue;
                 }
                 if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_MASTER_IDENTIFICATION){
                     setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_MASTER_IDENTIFICATION;
@@ -2665,7 +2962,7 @@ static void sm_run(void){
                     reverse_64(setup->sm_local_rand, &buffer[3]);
                     l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                     sm_timeout_reset(connection);
-                    return;
+                    continue;
                 }
                 if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_IDENTITY_INFORMATION){
                     setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_IDENTITY_INFORMATION;
@@ -2675,7 +2972,7 @@ static void sm_run(void){
                     reverse_128(sm_persistent_irk, &buffer[1]);
                     l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                     sm_timeout_reset(connection);
-                    return;
+                    continue;
                 }
                 if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_IDENTITY_ADDRESS_INFORMATION){
                     setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_IDENTITY_ADDRESS_INFORMATION;
@@ -2699,7 +2996,7 @@ static void sm_run(void){
                     reverse_bd_addr(local_address, &buffer[2]);
                     l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                     sm_timeout_reset(connection);
-                    return;
+                    continue;
                 }
                 if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION){
                     setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION;
@@ -2724,7 +3021,7 @@ static void sm_run(void){
                     reverse_128(setup->sm_local_csrk, &buffer[1]);
                     l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                     sm_timeout_reset(connection);
-                    return;
+                    continue;
                 }
 
                 // keys are sent
@@ -2747,8 +3044,8 @@ static void sm_run(void){
                 break;
         }
 
-        // check again if active connection was released
-        if (sm_active_connection_handle != HCI_CON_HANDLE_INVALID) break;
+        // check again if active connection was released, then use its setup context for next connection
+        if (sm_setup_context_handles[setup_context_index] == HCI_CON_HANDLE_INVALID) setup_context_index--;
     }
 }
 
@@ -2926,11 +3223,15 @@ static void sm_handle_encryption_result_enc_ph4_ltk(void *arg){
 
     sm_truncate_key(setup->sm_ltk, connection->sm_actual_encryption_key_size);
     log_info_key("ltk", setup->sm_ltk);
+#ifdef USE_SM_LTK_CACHE
+    sm_ltk_cache_store(setup->sm_local_ediv, setup->sm_local_rand, setup->sm_ltk);
+#endif
     connection->sm_engine_state = SM_RESPONDER_PH4_SEND_LTK_REPLY;
     sm_run();
 }
 #endif
 
+#if !defined(ENABLE_SOFTWARE_AES128) && !defined(HAVE_AES128)
 static void sm_handle_encryption_result_address_resolution(void *arg){
     UNUSED(arg);
     sm_aes128_state = SM_AES128_IDLE;
@@ -2948,6 +3249,7 @@ static void sm_handle_encryption_result_address_resolution(void *arg){
     sm_address_resolution_test++;
     sm_run();
 }
+#endif
 
 static void sm_handle_encryption_result_dkg_irk(void *arg){
     UNUSED(arg);
@@ -3035,7 +3337,7 @@ static void sm_handle_random_result_ph2_tk(void * arg){
     uint32_t tk;
     if (sm_fixed_passkey_in_display_role == 0xffffffff){
         // map random to 0-999999 without speding much cycles on a modulus operation
-        tk = little_endian_read_32(sm_random_data,0);
+        tk = little_endian_read_32(setup->sm_random_data,0);
         tk = tk & 0xfffff;  // 1048575
         if (tk >= 999999){
             tk = tk - 999999;
@@ -3055,7 +3357,7 @@ static void sm_handle_random_result_ph2_tk(void * arg){
             sm_trigger_user_response(connection);
             // response_idle == nothing <--> sm_trigger_user_response() did not require response
             if (setup->sm_user_response == SM_USER_RESPONSE_IDLE){
-                btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) connection->sm_handle);
+                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) connection->sm_handle);
             }
         }
     }   
@@ -3068,7 +3370,7 @@ static void sm_handle_random_result_ph3_div(void * arg){
     if (connection == NULL) return;
 
     // use 16 bit from random value as div
-    setup->sm_local_div = big_endian_read_16(sm_random_data, 0);
+    setup->sm_local_div = big_endian_read_16(setup->sm_random_data, 0);
     log_info_hex16("div", setup->sm_local_div);
     connection->sm_engine_state = SM_PH3_Y_GET_ENC;
     sm_run();
@@ -3079,12 +3381,12 @@ static void sm_handle_random_result_ph3_random(void * arg){
     sm_connection_t * connection = sm_get_connection_for_handle(con_handle);
     if (connection == NULL) return;
 
-    reverse_64(sm_random_data, setup->sm_local_rand);
+    reverse_64(setup->sm_random_data, setup->sm_local_rand);
     // no db for encryption size hack: encryption size is stored in lowest nibble of setup->sm_local_rand
     setup->sm_local_rand[7] = (setup->sm_local_rand[7] & 0xf0) + (connection->sm_actual_encryption_key_size - 1);
     // no db for authenticated flag hack: store flag in bit 4 of LSB
     setup->sm_local_rand[7] = (setup->sm_local_rand[7] & 0xef) + (connection->sm_connection_authenticated << 4);
-    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 2, &sm_handle_random_result_ph3_div, (void *)(uintptr_t) connection->sm_handle);
+    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 2, &sm_handle_random_result_ph3_div, (void *)(uintptr_t) connection->sm_handle);
 }
 static void sm_validate_er_ir(void){
     // warn about default ER/IR
@@ -3110,6 +3412,9 @@ static void sm_handle_random_result_ir(void *arg){
         log_info("Generated IR key. Store in TLV status: %d", status);
     }
     log_info_key("IR", sm_persistent_ir);
+#ifdef USE_SM_LTK_CACHE
+    sm_ltk_cache_count = 0;
+#endif
     dkg_state = DKG_CALC_IRK;
 
     if (test_use_fixed_local_irk){
@@ -3175,6 +3480,9 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                             }
                         } else {
                             sm_validate_er_ir();
+#ifdef USE_SM_LTK_CACHE
+                            sm_ltk_cache_count = 0;
+#endif
                             dkg_state = DKG_CALC_IRK;
 
                             if (test_use_fixed_local_irk){
@@ -3333,14 +3641,14 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                                 if (setup->sm_use_secure_connections){
                                     sm_conn->sm_engine_state = SM_PH3_DISTRIBUTE_KEYS;
                                 } else {
-                                    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
+                                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
                                 }
                             } else {
                                 // master
                                 if (sm_key_distribution_all_received(sm_conn)){
                                     // skip receiving keys as there are none
                                     sm_key_distribution_handle_all_received(sm_conn);
-                                    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
+                                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
                                 } else {
                                     sm_conn->sm_engine_state = SM_PH3_RECEIVE_KEYS;
                                 }
@@ -3367,7 +3675,7 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                         case SM_PH2_W4_CONNECTION_ENCRYPTED:
                             if (IS_RESPONDER(sm_conn->sm_role)){
                                 // slave
-                                btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
+                                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
                             } else {
                                 // master
                                 sm_conn->sm_engine_state = SM_PH3_RECEIVE_KEYS;
@@ -3390,6 +3698,9 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                         && (sm_conn->sm_engine_state == SM_INITIATOR_PH0_W4_CONNECTION_ENCRYPTED)
                         && (packet[2] == ERROR_CODE_AUTHENTICATION_FAILURE)){
                         le_device_db_remove(sm_conn->sm_le_db_index);
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+                        hci_remove_le_device_db_entry_from_resolving_list((uint16_t) sm_conn->sm_le_db_index);
+#endif
                     }
 
                     // pairing failed, if it was ongoing
@@ -3622,7 +3933,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
 
             // generate random number first, if we need to show passkey
             if (setup->sm_stk_generation_method == PK_RESP_INPUT){
-                btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph2_tk,  (void *)(uintptr_t) sm_conn->sm_handle);
+                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph2_tk,  (void *)(uintptr_t) sm_conn->sm_handle);
                 break;
             }
 
@@ -3645,7 +3956,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             sm_trigger_user_response(sm_conn);
             // response_idle == nothing <--> sm_trigger_user_response() did not require response
             if (setup->sm_user_response == SM_USER_RESPONSE_IDLE){
-                btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
+                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
             }
             break;
 
@@ -3716,7 +4027,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             }
 
             // start calculating dhkey
-            btstack_crypto_ecc_p256_calculate_dhkey(&sm_crypto_ecc_p256_request, setup->sm_peer_q, setup->sm_dhkey, sm_sc_dhkey_calculated, (void*)(uintptr_t) sm_conn->sm_handle);
+            btstack_crypto_ecc_p256_calculate_dhkey(&setup->sm_crypto_ecc_p256_request, setup->sm_peer_q, setup->sm_dhkey, sm_sc_dhkey_calculated, (void*)(uintptr_t) sm_conn->sm_handle);
 
 
             log_info("public key received, generation method %u", setup->sm_stk_generation_method);
@@ -3746,7 +4057,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
                     case OOB:
                         // generate Nx
                         log_info("Generate Na");
-                        btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_send_pairing_random, (void*)(uintptr_t) sm_conn->sm_handle);
+                        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_send_pairing_random, (void*)(uintptr_t) sm_conn->sm_handle);
                         break;
                 }
             }
@@ -3779,7 +4090,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             } else {
                 // initiator
                 if (sm_just_works_or_numeric_comparison(setup->sm_stk_generation_method)){
-                    btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_send_pairing_random, (void*)(uintptr_t) sm_conn->sm_handle);
+                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_next_send_pairing_random, (void*)(uintptr_t) sm_conn->sm_handle);
                 } else {
                     sm_conn->sm_engine_state = SM_SC_SEND_PAIRING_RANDOM;
                 }
@@ -3902,7 +4213,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             }
 
             // calculate and send local_confirm
-            btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
+            btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
             break;
 
         case SM_RESPONDER_PH2_W4_PAIRING_RANDOM:
@@ -3967,7 +4278,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
                     if (setup->sm_use_secure_connections){
                         sm_conn->sm_engine_state = SM_PH3_DISTRIBUTE_KEYS;
                     } else {
-                        btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
+                        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, (void *)(uintptr_t) sm_conn->sm_handle);
                     }
                 }
             }
@@ -4026,10 +4337,18 @@ void sm_set_request_security(int enable){
 
 void sm_set_er(sm_key_t er){
     (void)memcpy(sm_persistent_er, er, 16);
+#ifdef USE_SM_LTK_CACHE
+    // cached LTKs were derived from previous ER
+    sm_ltk_cache_count = 0;
+#endif
 }
 
 void sm_set_ir(sm_key_t ir){
     (void)memcpy(sm_persistent_ir, ir, 16);
+#ifdef USE_SM_LTK_CACHE
+    // cached LTKs were derived with DHK from previous IR
+    sm_ltk_cache_count = 0;
+#endif
 }
 
 // Testing support only
@@ -4089,9 +4408,23 @@ void sm_init(void){
     sm_address_resolution_ah_calculation_active = 0;
     sm_address_resolution_mode = ADDRESS_RESOLUTION_IDLE;
     sm_address_resolution_general_queue = NULL;
+#ifdef ENABLE_SM_ADDRESS_RESOLUTION_CACHE
+    sm_address_resolution_cache_reset();
+#endif
+#ifdef USE_SM_LTK_CACHE
+    sm_ltk_cache_count = 0;
+#endif
 
     gap_random_adress_update_period = 15 * 60 * 1000L;
+    int i;
+    for (i = 0; i < MAX_NR_SM_SETUP_CONTEXTS; i++){
+        sm_setup_context_handles[i] = HCI_CON_HANDLE_INVALID;
+    }
+    setup = &sm_setup_contexts[0];
     sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+    sm_ec_key_renewal_pending = false;
+#endif
 
     test_use_fixed_local_csrk = false;
 
@@ -4124,6 +4457,8 @@ void sm_allow_ltk_reconstruction_without_le_device_db_entry(int allow){
 static sm_connection_t * sm_get_connection_for_handle(hci_con_handle_t con_handle){
     hci_connection_t * hci_con = hci_connection_for_handle(con_handle);
     if (!hci_con) return NULL;
+    // handling a connection uses its setup context, if it has one
+    sm_setup_context_select(con_handle);
     return &hci_con->sm_connection;
 }
 
@@ -4248,7 +4583,7 @@ void sm_just_works_confirm(hci_con_handle_t con_handle){
         if (setup->sm_use_secure_connections){
             sm_conn->sm_engine_state = SM_SC_SEND_PUBLIC_KEY_COMMAND;
         } else {
-            btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
+            btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
         }
     }
 
@@ -4273,7 +4608,7 @@ void sm_passkey_input(hci_con_handle_t con_handle, uint32_t passkey){
     big_endian_store_32(setup->sm_tk, 12, passkey);
     setup->sm_user_response = SM_USER_RESPONSE_PASSKEY;
     if (sm_conn->sm_engine_state == SM_PH1_W4_USER_RESPONSE){
-        btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
+        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, (void *)(uintptr_t) sm_conn->sm_handle);
     }
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
     (void)memcpy(setup->sm_ra, setup->sm_tk, 16);
@@ -81,7 +81,7 @@ void sm_set_ir(sm_key_t ir);
 void sm_register_oob_data_callback( int (*get_oob_data_callback)(uint8_t address_type, bd_addr_t addr, uint8_t * oob_data));
 
 /**
- * @brief Add event packet handler. 
+ * @brief Add event packet handler. Set event_filter in registration to skip events the handler isn't interested in
  */
 void sm_add_event_handler(btstack_packet_callback_registration_t * callback_handler);
 
@@ -125,6 +125,7 @@ typedef enum {
 #define HCI_ACL_DATA_PACKET     0x02
 #define HCI_SCO_DATA_PACKET     0x03
 #define HCI_EVENT_PACKET        0x04
+#define HCI_ISO_DATA_PACKET     0x05
 
 /** 
  * HCI Layer
@@ -200,6 +201,8 @@ typedef enum {
 #define ERROR_CODE_CONNECTION_FAILED_TO_BE_ESTABLISHED     0x3E
 #define ERROR_CODE_MAC_CONNECTION_FAILED                   0x3F
 #define ERROR_CODE_COARSE_CLOCK_ADJUSTMENT_REJECTED_BUT_WILL_TRY_TO_ADJUST_USING_CLOCK_DRAGGING 0x40
+#define ERROR_CODE_TYPE0_SUBMAP_NOT_DEFINED                0x41
+#define ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER          0x42
 
 // BTstack defined ERRORS, mapped into BLuetooth status code range
 
@@ -648,6 +651,7 @@ typedef enum {
 #define GAP_RECONNECTION_ADDRESS_UUID  0x2a03
 #define GAP_PERIPHERAL_PREFERRED_CONNECTION_PARAMETERS_UUID 0x2a04
 #define GAP_SERVICE_CHANGED            0x2a05
+#define GAP_DATABASE_HASH              0x2b2a
 
 // Bluetooth GATT types
 
@@ -98,6 +98,7 @@
 
 #ifdef ENABLE_CLASSIC
 #include "classic/a2dp_sink.h"
+#include "classic/a2dp_sink_playback.h"
 #include "classic/a2dp_source.h"
 #include "classic/avdtp.h"
 #include "classic/avdtp_acceptor.h"
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_buffer.c"
+
+/*
+ *  btstack_buffer.c
+ *
+ */
+
+#include <string.h>
+
+#include "btstack_buffer.h"
+
+static uint8_t * btstack_buffer_storage(const btstack_buffer_t * buffer){
+    return (uint8_t *) (buffer + 1);
+}
+
+void btstack_buffer_pool_init(btstack_buffer_pool_t * pool, void * storage, uint16_t num_buffers, uint16_t buffer_size){
+    pool->buffer_size = buffer_size;
+    pool->num_free = num_buffers;
+    btstack_memory_pool_create(&pool->memory_pool, storage, num_buffers, (int) BTSTACK_BUFFER_BLOCK_SIZE(buffer_size));
+}
+
+uint16_t btstack_buffer_pool_num_free(const btstack_buffer_pool_t * pool){
+    return pool->num_free;
+}
+
+btstack_buffer_t * btstack_buffer_alloc(btstack_buffer_pool_t * pool, uint16_t headroom){
+    if (headroom > pool->buffer_size) return NULL;
+    btstack_buffer_t * buffer = (btstack_buffer_t *) btstack_memory_pool_get(&pool->memory_pool);
+    if (buffer == NULL) return NULL;
+    pool->num_free--;
+    buffer->item.next = NULL;
+    buffer->chain = NULL;
+    buffer->pool = pool;
+    buffer->data = btstack_buffer_storage(buffer) + headroom;
+    buffer->len = 0;
+    buffer->ref_count = 1;
+    return buffer;
+}
+
+void btstack_buffer_retain(btstack_buffer_t * buffer){
+    buffer->ref_count++;
+}
+
+void btstack_buffer_release(btstack_buffer_t * buffer){
+    // iterate over chain instead of recursion
+    while (buffer != NULL){
+        buffer->ref_count--;
+        if (buffer->ref_count > 0) break;
+        btstack_buffer_t * next = buffer->chain;
+        btstack_buffer_pool_t * pool = buffer->pool;
+        btstack_memory_pool_free(&pool->memory_pool, buffer);
+        pool->num_free++;
+        buffer = next;
+    }
+}
+
+uint8_t * btstack_buffer_get_data(const btstack_buffer_t * buffer){
+    return buffer->data;
+}
+
+uint16_t btstack_buffer_get_len(const btstack_buffer_t * buffer){
+    return buffer->len;
+}
+
+uint32_t btstack_buffer_get_total_len(const btstack_buffer_t * buffer){
+    uint32_t total_len = 0;
+    while (buffer != NULL){
+        total_len += buffer->len;
+        buffer = buffer->chain;
+    }
+    return total_len;
+}
+
+uint16_t btstack_buffer_get_headroom(const btstack_buffer_t * buffer){
+    return (uint16_t) (buffer->data - btstack_buffer_storage(buffer));
+}
+
+uint16_t btstack_buffer_get_tailroom(const btstack_buffer_t * buffer){
+    return (uint16_t) (buffer->pool->buffer_size - btstack_buffer_get_headroom(buffer) - buffer->len);
+}
+
+uint8_t * btstack_buffer_add_header(btstack_buffer_t * buffer, uint16_t header_len){
+    if (header_len > btstack_buffer_get_headroom(buffer)) return NULL;
+    buffer->data -= header_len;
+    buffer->len  += header_len;
+    return buffer->data;
+}
+
+uint8_t * btstack_buffer_remove_header(btstack_buffer_t * buffer, uint16_t header_len){
+    if (header_len > buffer->len) return NULL;
+    buffer->data += header_len;
+    buffer->len  -= header_len;
+    return buffer->data;
+}
+
+uint8_t * btstack_buffer_append(btstack_buffer_t * buffer, uint16_t len){
+    if (len > btstack_buffer_get_tailroom(buffer)) return NULL;
+    uint8_t * area = buffer->data + buffer->len;
+    buffer->len += len;
+    return area;
+}
+
+void btstack_buffer_truncate(btstack_buffer_t * buffer, uint16_t len){
+    if (len >= buffer->len) return;
+    buffer->len = len;
+}
+
+void btstack_buffer_chain(btstack_buffer_t * head, btstack_buffer_t * tail){
+    while (head->chain != NULL){
+        head = head->chain;
+    }
+    head->chain = tail;
+}
+
+btstack_buffer_t * btstack_buffer_get_next(const btstack_buffer_t * buffer){
+    return buffer->chain;
+}
+
+uint32_t btstack_buffer_copy(const btstack_buffer_t * buffer, uint32_t offset, uint8_t * dest, uint32_t len){
+    uint32_t bytes_copied = 0;
+    while ((buffer != NULL) && (bytes_copied < len)){
+        if (offset >= buffer->len){
+            offset -= buffer->len;
+        } else {
+            uint32_t bytes_to_copy = buffer->len - offset;
+            if (bytes_to_copy > (len - bytes_copied)){
+                bytes_to_copy = len - bytes_copied;
+            }
+            memcpy(&dest[bytes_copied], &buffer->data[offset], bytes_to_copy);
+            bytes_copied += bytes_to_copy;
+            offset = 0;
+        }
+        buffer = buffer->chain;
+    }
+    return bytes_copied;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_buffer.h
+ *
+ *  Reference counted packet buffers with headroom and chaining, allocated from fixed-size pools.
+ *  Lower layers add their headers in front of the payload, upper layers remove them without copying.
+ *  A buffer can be retained by any layer that needs to keep the packet after returning, e.g. to queue it.
+ *  Not thread-safe: all functions have to be called from the BTstack thread.
+ */
+
+#ifndef BTSTACK_BUFFER_H
+#define BTSTACK_BUFFER_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "btstack_linked_list.h"
+#include "btstack_memory_pool.h"
+
+struct btstack_buffer_pool;
+
+typedef struct btstack_buffer {
+    // used by current owner to queue the buffer, e.g. with btstack_linked_queue_t
+    btstack_linked_item_t item;
+    // next buffer of the same packet
+    struct btstack_buffer * chain;
+    struct btstack_buffer_pool * pool;
+    // valid data: data[0..len-1]
+    uint8_t * data;
+    uint16_t  len;
+    uint16_t  ref_count;
+    // followed by buffer_size bytes of storage
+} btstack_buffer_t;
+
+typedef struct btstack_buffer_pool {
+    btstack_memory_pool_t memory_pool;
+    uint16_t buffer_size;
+    uint16_t num_free;
+} btstack_buffer_pool_t;
+
+// size of storage required for a pool of num_buffers with buffer_size bytes each
+#define BTSTACK_BUFFER_BLOCK_SIZE(buffer_size) \
+    ((sizeof(btstack_buffer_t) + (buffer_size) + sizeof(void *) - 1u) / sizeof(void *) * sizeof(void *))
+#define BTSTACK_BUFFER_POOL_STORAGE_SIZE(num_buffers, buffer_size) ((num_buffers) * BTSTACK_BUFFER_BLOCK_SIZE(buffer_size))
+
+/* API_START */
+
+/**
+ * @brief Init buffer pool
+ * @param pool
+ * @param storage of BTSTACK_BUFFER_POOL_STORAGE_SIZE(num_buffers, buffer_size) bytes, pointer aligned
+ * @param num_buffers
+ * @param buffer_size in bytes, including headroom
+ */
+void btstack_buffer_pool_init(btstack_buffer_pool_t * pool, void * storage, uint16_t num_buffers, uint16_t buffer_size);
+
+/**
+ * @brief Get number of free buffers in pool
+ * @param pool
+ * @return num free
+ */
+uint16_t btstack_buffer_pool_num_free(const btstack_buffer_pool_t * pool);
+
+/**
+ * @brief Allocate buffer with reference count 1 and empty payload
+ * @param pool
+ * @param headroom reserved for headers added by lower layers
+ * @return buffer or NULL if pool empty or headroom larger than buffer size
+ */
+btstack_buffer_t * btstack_buffer_alloc(btstack_buffer_pool_t * pool, uint16_t headroom);
+
+/**
+ * @brief Increment reference count, e.g. to keep a packet after returning from the packet handler
+ * @param buffer
+ */
+void btstack_buffer_retain(btstack_buffer_t * buffer);
+
+/**
+ * @brief Decrement reference count. Buffer is returned to its pool when count reaches zero,
+ *        which also releases the reference to the chained buffers
+ * @param buffer
+ */
+void btstack_buffer_release(btstack_buffer_t * buffer);
+
+/**
+ * @brief Get pointer to valid data
+ * @param buffer
+ * @return data
+ */
+uint8_t * btstack_buffer_get_data(const btstack_buffer_t * buffer);
+
+/**
+ * @brief Get length of valid data in this buffer
+ * @param buffer
+ * @return len
+ */
+uint16_t btstack_buffer_get_len(const btstack_buffer_t * buffer);
+
+/**
+ * @brief Get length of valid data in this buffer and all chained buffers
+ * @param buffer
+ * @return total len
+ */
+uint32_t btstack_buffer_get_total_len(const btstack_buffer_t * buffer);
+
+/**
+ * @brief Get number of bytes available in front of the data
+ * @param buffer
+ * @return headroom
+ */
+uint16_t btstack_buffer_get_headroom(const btstack_buffer_t * buffer);
+
+/**
+ * @brief Get number of bytes available after the data
+ * @param buffer
+ * @return tailroom
+ */
+uint16_t btstack_buffer_get_tailroom(const btstack_buffer_t * buffer);
+
+/**
+ * @brief Add header in front of data, e.g. when passing packet down
+ * @param buffer
+ * @param header_len
+ * @return pointer to header or NULL if not enough headroom
+ */
+uint8_t * btstack_buffer_add_header(btstack_buffer_t * buffer, uint16_t header_len);
+
+/**
+ * @brief Remove header from front of data, e.g. when passing packet up
+ * @param buffer
+ * @param header_len
+ * @return pointer to remaining data or NULL if header_len larger than len
+ */
+uint8_t * btstack_buffer_remove_header(btstack_buffer_t * buffer, uint16_t header_len);
+
+/**
+ * @brief Append data area at the end
+ * @param buffer
+ * @param len
+ * @return pointer to appended area or NULL if not enough tailroom
+ */
+uint8_t * btstack_buffer_append(btstack_buffer_t * buffer, uint16_t len);
+
+/**
+ * @brief Reduce length of data, e.g. to drop a trailer
+ * @param buffer
+ * @param len new length, ignored if larger than current length
+ */
+void btstack_buffer_truncate(btstack_buffer_t * buffer, uint16_t len);
+
+/**
+ * @brief Append buffer to end of chain. Reference of caller to tail is transferred to the chain
+ * @param head
+ * @param tail
+ */
+void btstack_buffer_chain(btstack_buffer_t * head, btstack_buffer_t * tail);
+
+/**
+ * @brief Get next buffer in chain
+ * @param buffer
+ * @return next buffer or NULL
+ */
+btstack_buffer_t * btstack_buffer_get_next(const btstack_buffer_t * buffer);
+
+/**
+ * @brief Copy data from chain into linear buffer
+ * @param buffer
+ * @param offset into data of chain
+ * @param dest
+ * @param len max bytes to copy
+ * @return number of bytes copied
+ */
+uint32_t btstack_buffer_copy(const btstack_buffer_t * buffer, uint32_t offset, uint8_t * dest, uint32_t len);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_BUFFER_H
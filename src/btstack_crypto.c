@@ -43,8 +43,10 @@
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
 #include "btstack_util.h"
 #include "hci.h"
+#include "hci_cmd_builder.h"
 
 //
 // AES128 Configuration
@@ -102,6 +104,24 @@
 #define ENABLE_ECC_P256
 #endif
 
+// Software ECC-P256 calculations can be run from a run loop timer instead of the context that requested them
+#if defined(ENABLE_ECC_P256_DEFERRED_CALCULATION) && defined(USE_SOFTWARE_ECC_P256_IMPLEMENTATION)
+#define USE_ECC_P256_DEFERRED_CALCULATION
+#endif
+
+// Software ECC-P256 calculations can be run on a worker thread
+#if defined(ENABLE_CRYPTO_WORKER) && defined(USE_SOFTWARE_ECC_P256_IMPLEMENTATION)
+#define USE_ECC_P256_WORKER
+#endif
+
+// Pool of pre-computed key pairs requires access to private key, i.e. software ECC-P256 implementation
+#if defined(ENABLE_ECC_P256_KEY_POOL) && defined(USE_SOFTWARE_ECC_P256_IMPLEMENTATION)
+#define USE_ECC_P256_KEY_POOL
+#ifndef ECC_P256_KEY_POOL_SIZE
+#define ECC_P256_KEY_POOL_SIZE 2
+#endif
+#endif
+
 // degbugging
 // #define DEBUG_CCM
 
@@ -128,10 +148,18 @@ static void btstack_crypto_run(void);
 static const uint8_t zero[16] = { 0 };
 
 static uint8_t btstack_crypto_initialized;
-static btstack_linked_list_t btstack_crypto_operations;
+static btstack_linked_queue_t btstack_crypto_operations;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 static uint8_t btstack_crypto_wait_for_hci_result;
 
+#ifdef ENABLE_CRYPTO_BACKEND
+static const btstack_crypto_backend_t * btstack_crypto_backend;
+static uint8_t  btstack_crypto_wait_for_backend_result;
+#ifndef USE_BTSTACK_AES128
+static sm_key_t btstack_crypto_backend_ciphertext;
+#endif
+#endif
+
 // state for AES-CMAC
 #ifndef USE_BTSTACK_AES128
 static btstack_crypto_cmac_state_t btstack_crypto_cmac_state;
@@ -143,20 +171,40 @@ static uint8_t  btstack_crypto_cmac_block_count;
 #endif
 
 // state for AES-CCM
-#ifndef USE_BTSTACK_AES128
 static uint8_t btstack_crypto_ccm_s[16];
-#endif
 
 #ifdef ENABLE_ECC_P256
 
 static uint8_t  btstack_crypto_ecc_p256_public_key[64];
 static uint8_t  btstack_crypto_ecc_p256_random[64];
 static uint8_t  btstack_crypto_ecc_p256_random_len;
-static uint8_t  btstack_crypto_ecc_p256_random_offset;
 static btstack_crypto_ecc_p256_key_generation_state_t btstack_crypto_ecc_p256_key_generation_state;
 
 #ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
 static uint8_t btstack_crypto_ecc_p256_d[32];
+static uint8_t btstack_crypto_ecc_p256_random_offset;
+static const uint8_t * btstack_crypto_ecc_p256_random_source;
+#endif
+
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+static btstack_timer_source_t btstack_crypto_ecc_p256_timer;
+static uint8_t btstack_crypto_wait_for_ecc_p256_calculation;
+#endif
+
+// single calculation on worker thread, other crypto operations wait for it
+#ifdef USE_ECC_P256_WORKER
+static btstack_worker_job_t btstack_crypto_ecc_p256_job;
+static uint8_t btstack_crypto_wait_for_ecc_p256_job;
+#endif
+
+// Key pairs generated in the background, handed out in FIFO order, each used once
+#ifdef USE_ECC_P256_KEY_POOL
+static uint8_t  btstack_crypto_ecc_p256_key_pool_public_key[ECC_P256_KEY_POOL_SIZE][64];
+static uint8_t  btstack_crypto_ecc_p256_key_pool_d[ECC_P256_KEY_POOL_SIZE][32];
+static uint8_t  btstack_crypto_ecc_p256_key_pool_count;
+static uint8_t  btstack_crypto_ecc_p256_key_pool_random[64];
+static uint8_t  btstack_crypto_ecc_p256_key_pool_refill_active;
+static btstack_crypto_random_t btstack_crypto_ecc_p256_key_pool_random_request;
 #endif
 
 // Software ECDH implementation provided by mbedtls
@@ -166,6 +214,15 @@ static mbedtls_ecp_group   mbedtls_ec_group;
 
 #endif /* ENABLE_ECC_P256 */
 
+#ifdef ENABLE_CRYPTO_WORKER
+static const btstack_worker_t * btstack_crypto_worker;
+#endif
+
+static void btstack_crypto_send_le_rand(void){
+    hci_reserve_packet_buffer();
+    hci_send_prepared_cmd_packet(hci_cmd_create_le_rand(hci_get_outgoing_packet_buffer()));
+}
+
 #ifdef ENABLE_SOFTWARE_AES128
 // AES128 using public domain rijndael implementation
 void btstack_aes128_calc(const uint8_t * key, const uint8_t * plaintext, uint8_t * ciphertext){
@@ -176,7 +233,7 @@ void btstack_aes128_calc(const uint8_t * key, const uint8_t * plaintext, uint8_t
 #endif
 
 static void btstack_crypto_done(btstack_crypto_t * btstack_crypto){
-    btstack_linked_list_pop(&btstack_crypto_operations);
+    btstack_linked_queue_dequeue(&btstack_crypto_operations);
     (*btstack_crypto->context_callback.callback)(btstack_crypto->context_callback.context);
 }
 
@@ -272,13 +329,35 @@ static void btstack_crypto_cmac_calc(btstack_crypto_aes128_cmac_t * btstack_cryp
 }
 #else
 
+#ifdef ENABLE_CRYPTO_BACKEND
+static void btstack_crypto_handle_encryption_result(const uint8_t * data);
+
+static void btstack_crypto_backend_handle_aes128_result(void * arg){
+    UNUSED(arg);
+    uint8_t data[16];
+    btstack_crypto_wait_for_backend_result = 0;
+    // provide result in HCI byte order
+    reverse_128(btstack_crypto_backend_ciphertext, data);
+    btstack_crypto_handle_encryption_result(data);
+    btstack_crypto_run();
+}
+#endif
+
 static void btstack_crypto_aes128_start(const sm_key_t key, const sm_key_t plaintext){
+#ifdef ENABLE_CRYPTO_BACKEND
+    if ((btstack_crypto_backend != NULL) && (btstack_crypto_backend->aes128_encrypt != NULL)){
+        btstack_crypto_wait_for_backend_result = 1;
+        (*btstack_crypto_backend->aes128_encrypt)(key, plaintext, btstack_crypto_backend_ciphertext, &btstack_crypto_backend_handle_aes128_result, NULL);
+        return;
+    }
+#endif
     uint8_t key_flipped[16];
     uint8_t plaintext_flipped[16];
     reverse_128(key, key_flipped);
     reverse_128(plaintext, plaintext_flipped);
     btstack_crypto_wait_for_hci_result = 1;
-    hci_send_cmd(&hci_le_encrypt, key_flipped, plaintext_flipped);
+    hci_reserve_packet_buffer();
+    hci_send_prepared_cmd_packet(hci_cmd_create_le_encrypt(hci_get_outgoing_packet_buffer(), key_flipped, plaintext_flipped));
 }
 
 static inline void btstack_crypto_cmac_next_state(void){
@@ -380,7 +459,7 @@ static void btstack_crypto_cmac_handle_encryption_result(btstack_crypto_aes128_c
             btstack_crypto_cmac_state = CMAC_IDLE;
             log_info_key("CMAC", data);
             (void)memcpy(btstack_crypto_cmac->hash, data, 16);
-			btstack_linked_list_pop(&btstack_crypto_operations);
+			btstack_linked_queue_dequeue(&btstack_crypto_operations);
 			(*btstack_crypto_cmac->btstack_crypto.context_callback.callback)(btstack_crypto_cmac->btstack_crypto.context_callback.context);
             break;
         default:
@@ -412,8 +491,6 @@ static void btstack_crypto_cmac_start(btstack_crypto_aes128_cmac_t * btstack_cry
 }
 #endif
 
-#ifndef USE_BTSTACK_AES128
-
 /*
   To encrypt the message data we use Counter (CTR) mode.  We first
   define the key stream blocks by:
@@ -483,7 +560,6 @@ static void btstack_crypto_ccm_setup_b_0(btstack_crypto_ccm_t * btstack_crypto_c
     printf_hexdump(b0, 16);
 #endif
 }
-#endif
 
 #ifdef ENABLE_ECC_P256
 
@@ -497,10 +573,9 @@ static void btstack_crypto_log_ec_publickey(const uint8_t * ec_q){
 #if (defined(USE_MICRO_ECC_P256) && !defined(WICED_VERSION)) || defined(USE_MBEDTLS_ECC_P256)
 // @return OK
 static int sm_generate_f_rng(unsigned char * buffer, unsigned size){
-    if (btstack_crypto_ecc_p256_key_generation_state != ECC_P256_KEY_GENERATION_ACTIVE) return 0;
-    log_info("sm_generate_f_rng: size %u - offset %u", (int) size, btstack_crypto_ecc_p256_random_offset);
+    if (btstack_crypto_ecc_p256_random_source == NULL) return 0;
     while (size) {
-        *buffer++ = btstack_crypto_ecc_p256_random[btstack_crypto_ecc_p256_random_offset++];
+        *buffer++ = btstack_crypto_ecc_p256_random_source[btstack_crypto_ecc_p256_random_offset++];
         size--;
     }
     return 1;
@@ -514,29 +589,29 @@ static int sm_generate_f_rng_mbedtls(void * context, unsigned char * buffer, siz
 }
 #endif /* USE_MBEDTLS_ECC_P256 */
 
-static void btstack_crypto_ecc_p256_generate_key_software(void){
+#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
+static void btstack_crypto_ecc_p256_generate_key_software(const uint8_t * random, uint8_t * public_key, uint8_t * d_out){
 
+    btstack_crypto_ecc_p256_random_source = random;
     btstack_crypto_ecc_p256_random_offset = 0;
     
     // generate EC key
 #ifdef USE_MICRO_ECC_P256
 
 #ifndef WICED_VERSION
-    log_info("set uECC RNG for initial key generation with 64 random bytes");
     // micro-ecc from WICED SDK uses its wiced_crypto_get_random by default - no need to set it
     uECC_set_rng(&sm_generate_f_rng);
 #endif /* WICED_VERSION */
 
 #if uECC_SUPPORTS_secp256r1
     // standard version
-    uECC_make_key(btstack_crypto_ecc_p256_public_key, btstack_crypto_ecc_p256_d, uECC_secp256r1());
+    uECC_make_key(public_key, d_out, uECC_secp256r1());
 
     // disable RNG again, as returning no randmon data lets shared key generation fail
-    log_info("disable uECC RNG in standard version after key generation");
     uECC_set_rng(NULL);
 #else
     // static version
-    uECC_make_key(btstack_crypto_ecc_p256_public_key, btstack_crypto_ecc_p256_d);
+    uECC_make_key(public_key, d_out);
 #endif
 #endif /* USE_MICRO_ECC_P256 */
 
@@ -546,16 +621,17 @@ static void btstack_crypto_ecc_p256_generate_key_software(void){
     mbedtls_mpi_init(&d);
     mbedtls_ecp_point_init(&P);
     int res = mbedtls_ecp_gen_keypair(&mbedtls_ec_group, &d, &P, &sm_generate_f_rng_mbedtls, NULL);
-    log_info("gen keypair %x", res);
-    mbedtls_mpi_write_binary(&P.X, &btstack_crypto_ecc_p256_public_key[0],  32);
-    mbedtls_mpi_write_binary(&P.Y, &btstack_crypto_ecc_p256_public_key[32], 32);
-    mbedtls_mpi_write_binary(&d, btstack_crypto_ecc_p256_d, 32);
+    UNUSED(res);
+    mbedtls_mpi_write_binary(&P.X, &public_key[0],  32);
+    mbedtls_mpi_write_binary(&P.Y, &public_key[32], 32);
+    mbedtls_mpi_write_binary(&d, d_out, 32);
     mbedtls_ecp_point_free(&P);
     mbedtls_mpi_free(&d);
 #endif  /* USE_MBEDTLS_ECC_P256 */
+
+    btstack_crypto_ecc_p256_random_source = NULL;
 }
 
-#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
 static void btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ecc_p256_t * btstack_crypto_ec_p192){
     memset(btstack_crypto_ec_p192->dhkey, 0, 32);
 
@@ -588,16 +664,190 @@ static void btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ecc_
     mbedtls_ecp_point_free(&Q);
 #endif
 
+}
+
+// software calculations might run on worker thread, log results from main thread
+static void btstack_crypto_ecc_p256_log_dhkey(const uint8_t * dhkey){
     log_info("dhkey");
-    log_info_hexdump(btstack_crypto_ec_p192->dhkey, 32);
+    log_info_hexdump(dhkey, 32);
+}
+#endif
+
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+// block crypto operations until calculation was done in timer handler, allowing run loop to process pending events
+static void btstack_crypto_ecc_p256_defer_calculation(void (*handler)(btstack_timer_source_t * ts)){
+    btstack_crypto_wait_for_ecc_p256_calculation = 1;
+    btstack_run_loop_set_timer_handler(&btstack_crypto_ecc_p256_timer, handler);
+    btstack_run_loop_set_timer(&btstack_crypto_ecc_p256_timer, 0);
+    btstack_run_loop_add_timer(&btstack_crypto_ecc_p256_timer);
+}
+
+static void btstack_crypto_ecc_p256_handle_generate_key_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_crypto_wait_for_ecc_p256_calculation = 0;
+    btstack_crypto_ecc_p256_generate_key_software(btstack_crypto_ecc_p256_random, btstack_crypto_ecc_p256_public_key, btstack_crypto_ecc_p256_d);
+    btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_DONE;
+    btstack_crypto_run();
+}
+
+static void btstack_crypto_ecc_p256_handle_calculate_dhkey_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_crypto_wait_for_ecc_p256_calculation = 0;
+    btstack_crypto_ecc_p256_t * btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t *) btstack_linked_queue_first(&btstack_crypto_operations);
+    if (btstack_crypto_ec_p192 == NULL) return;
+    btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ec_p192);
+    btstack_crypto_ecc_p256_log_dhkey(btstack_crypto_ec_p192->dhkey);
+    // done
+    btstack_linked_queue_dequeue(&btstack_crypto_operations);
+    (*btstack_crypto_ec_p192->btstack_crypto.context_callback.callback)(btstack_crypto_ec_p192->btstack_crypto.context_callback.context);
+    btstack_crypto_run();
+}
+#endif
+
+#ifdef USE_ECC_P256_WORKER
+// @return true if calculation was submitted to worker, completion is called on main thread when done
+static bool btstack_crypto_ecc_p256_submit_job(void (*work)(void * context), void (*completion)(void * context), void * context){
+    if (btstack_crypto_worker == NULL) return false;
+    btstack_crypto_wait_for_ecc_p256_job = 1;
+    btstack_crypto_ecc_p256_job.work                = work;
+    btstack_crypto_ecc_p256_job.context             = context;
+    btstack_crypto_ecc_p256_job.completion.callback = completion;
+    btstack_crypto_ecc_p256_job.completion.context  = context;
+    (*btstack_crypto_worker->submit)(&btstack_crypto_ecc_p256_job);
+    return true;
+}
+
+static void btstack_crypto_ecc_p256_generate_key_work(void * context){
+    UNUSED(context);
+    btstack_crypto_ecc_p256_generate_key_software(btstack_crypto_ecc_p256_random, btstack_crypto_ecc_p256_public_key, btstack_crypto_ecc_p256_d);
+}
+
+static void btstack_crypto_ecc_p256_generate_key_completion(void * context){
+    UNUSED(context);
+    btstack_crypto_wait_for_ecc_p256_job = 0;
+    btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_DONE;
+    btstack_crypto_run();
+}
+
+static void btstack_crypto_ecc_p256_calculate_dhkey_work(void * context){
+    btstack_crypto_ecc_p256_calculate_dhkey_software((btstack_crypto_ecc_p256_t *) context);
+}
+
+static void btstack_crypto_ecc_p256_calculate_dhkey_completion(void * context){
+    btstack_crypto_wait_for_ecc_p256_job = 0;
+    btstack_crypto_ecc_p256_t * btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t *) context;
+    // request might be gone after btstack_crypto_reset
+    if (btstack_linked_queue_first(&btstack_crypto_operations) == (btstack_linked_item_t *) btstack_crypto_ec_p192){
+        btstack_crypto_ecc_p256_log_dhkey(btstack_crypto_ec_p192->dhkey);
+        btstack_crypto_done(&btstack_crypto_ec_p192->btstack_crypto);
+    }
+    btstack_crypto_run();
+}
+#endif
+
+#ifdef USE_ECC_P256_KEY_POOL
+static void btstack_crypto_ecc_p256_key_pool_refill(void);
+
+static void btstack_crypto_ecc_p256_key_pool_generate(void * context){
+    UNUSED(context);
+    uint8_t index = btstack_crypto_ecc_p256_key_pool_count;
+    btstack_crypto_ecc_p256_generate_key_software(btstack_crypto_ecc_p256_key_pool_random,
+                                                  btstack_crypto_ecc_p256_key_pool_public_key[index],
+                                                  btstack_crypto_ecc_p256_key_pool_d[index]);
+}
+
+static void btstack_crypto_ecc_p256_key_pool_add(void){
+    btstack_crypto_ecc_p256_key_pool_generate(NULL);
+    btstack_crypto_ecc_p256_key_pool_count++;
+    btstack_crypto_ecc_p256_key_pool_refill_active = 0;
+    log_info("ecc key pool: %u of %u keys ready", btstack_crypto_ecc_p256_key_pool_count, ECC_P256_KEY_POOL_SIZE);
+    btstack_crypto_ecc_p256_key_pool_refill();
+}
+
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+static void btstack_crypto_ecc_p256_key_pool_handle_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_crypto_wait_for_ecc_p256_calculation = 0;
+    btstack_crypto_ecc_p256_key_pool_add();
+    btstack_crypto_run();
+}
+#endif
+
+#ifdef USE_ECC_P256_WORKER
+static void btstack_crypto_ecc_p256_key_pool_completion(void * context){
+    UNUSED(context);
+    btstack_crypto_wait_for_ecc_p256_job = 0;
+    btstack_crypto_ecc_p256_key_pool_count++;
+    btstack_crypto_ecc_p256_key_pool_refill_active = 0;
+    log_info("ecc key pool: %u of %u keys ready", btstack_crypto_ecc_p256_key_pool_count, ECC_P256_KEY_POOL_SIZE);
+    btstack_crypto_ecc_p256_key_pool_refill();
+    btstack_crypto_run();
 }
 #endif
 
+static void btstack_crypto_ecc_p256_key_pool_handle_random(void * arg){
+    UNUSED(arg);
+#ifdef USE_ECC_P256_WORKER
+    if (btstack_crypto_ecc_p256_submit_job(&btstack_crypto_ecc_p256_key_pool_generate, &btstack_crypto_ecc_p256_key_pool_completion, NULL)) return;
+#endif
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+    btstack_crypto_ecc_p256_defer_calculation(&btstack_crypto_ecc_p256_key_pool_handle_timeout);
+#else
+    // called from btstack_crypto_handle_random_data, which continues with btstack_crypto_run
+    btstack_crypto_ecc_p256_key_pool_add();
 #endif
+}
+
+// queue random generation for next pool entry, processed after all pending operations
+// caller is responsible to call btstack_crypto_run
+static void btstack_crypto_ecc_p256_key_pool_refill(void){
+    if (btstack_crypto_ecc_p256_key_pool_refill_active != 0u) return;
+    if (btstack_crypto_ecc_p256_key_pool_count >= ECC_P256_KEY_POOL_SIZE) return;
+    btstack_crypto_ecc_p256_key_pool_refill_active = 1;
+    btstack_crypto_random_t * request = &btstack_crypto_ecc_p256_key_pool_random_request;
+    request->btstack_crypto.context_callback.callback  = &btstack_crypto_ecc_p256_key_pool_handle_random;
+    request->btstack_crypto.context_callback.context   = NULL;
+    request->btstack_crypto.operation                  = BTSTACK_CRYPTO_RANDOM;
+    request->buffer = btstack_crypto_ecc_p256_key_pool_random;
+    request->size   = sizeof(btstack_crypto_ecc_p256_key_pool_random);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+}
+
+// @return true if key pair was taken from pool
+static bool btstack_crypto_ecc_p256_key_pool_take(void){
+    if (btstack_crypto_ecc_p256_key_pool_count == 0u) return false;
+    (void)memcpy(btstack_crypto_ecc_p256_public_key, btstack_crypto_ecc_p256_key_pool_public_key[0], 64);
+    (void)memcpy(btstack_crypto_ecc_p256_d, btstack_crypto_ecc_p256_key_pool_d[0], 32);
+    btstack_crypto_ecc_p256_key_pool_count--;
+    uint8_t i;
+    for (i = 0; i < btstack_crypto_ecc_p256_key_pool_count; i++){
+        (void)memcpy(btstack_crypto_ecc_p256_key_pool_public_key[i], btstack_crypto_ecc_p256_key_pool_public_key[i+1], 64);
+        (void)memcpy(btstack_crypto_ecc_p256_key_pool_d[i], btstack_crypto_ecc_p256_key_pool_d[i+1], 32);
+    }
+    // clear consumed entry
+    memset(btstack_crypto_ecc_p256_key_pool_d[btstack_crypto_ecc_p256_key_pool_count], 0, 32);
+    return true;
+}
+#endif
+
+#endif
+
+static void btstack_crypto_handle_encryption_result(const uint8_t * data);
 
 #ifdef USE_BTSTACK_AES128
-// CCM not implemented using software AES128 yet
+// CCM uses same state machine as with HCI_LE_Encrypt, result provided synchronously in HCI byte order
+static void btstack_crypto_ccm_aes128_start(const sm_key_t key, const sm_key_t plaintext){
+    sm_key_t ciphertext;
+    uint8_t  data[16];
+    btstack_aes128_calc(key, plaintext, ciphertext);
+    reverse_128(ciphertext, data);
+    btstack_crypto_handle_encryption_result(data);
+}
 #else
+static void btstack_crypto_ccm_aes128_start(const sm_key_t key, const sm_key_t plaintext){
+    btstack_crypto_aes128_start(key, plaintext);
+}
+#endif
 
 static void btstack_crypto_ccm_calc_s0(btstack_crypto_ccm_t * btstack_crypto_ccm){
 #ifdef DEBUG_CCM
@@ -605,7 +855,7 @@ static void btstack_crypto_ccm_calc_s0(btstack_crypto_ccm_t * btstack_crypto_ccm
 #endif
     btstack_crypto_ccm->state = CCM_W4_S0;
     btstack_crypto_ccm_setup_a_i(btstack_crypto_ccm, 0);
-    btstack_crypto_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_s);
+    btstack_crypto_ccm_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_s);
 }
 
 static void btstack_crypto_ccm_calc_sn(btstack_crypto_ccm_t * btstack_crypto_ccm){
@@ -614,14 +864,14 @@ static void btstack_crypto_ccm_calc_sn(btstack_crypto_ccm_t * btstack_crypto_ccm
 #endif
     btstack_crypto_ccm->state = CCM_W4_SN;
     btstack_crypto_ccm_setup_a_i(btstack_crypto_ccm, btstack_crypto_ccm->counter);
-    btstack_crypto_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_s);
+    btstack_crypto_ccm_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_s);
 }
 
 static void btstack_crypto_ccm_calc_x1(btstack_crypto_ccm_t * btstack_crypto_ccm){
     uint8_t btstack_crypto_ccm_buffer[16];
     btstack_crypto_ccm->state = CCM_W4_X1;
     btstack_crypto_ccm_setup_b_0(btstack_crypto_ccm, btstack_crypto_ccm_buffer);
-    btstack_crypto_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_buffer);
+    btstack_crypto_ccm_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_buffer);
 }
 
 static void btstack_crypto_ccm_calc_xn(btstack_crypto_ccm_t * btstack_crypto_ccm, const uint8_t * plaintext){
@@ -648,7 +898,7 @@ static void btstack_crypto_ccm_calc_xn(btstack_crypto_ccm_t * btstack_crypto_ccm
     printf_hexdump(btstack_crypto_ccm_buffer, 16);
 #endif
 
-    btstack_crypto_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_buffer);
+    btstack_crypto_ccm_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm_buffer);
 }
 
 static void btstack_crypto_ccm_calc_aad_xn(btstack_crypto_ccm_t * btstack_crypto_ccm){
@@ -691,7 +941,7 @@ static void btstack_crypto_ccm_calc_aad_xn(btstack_crypto_ccm_t * btstack_crypto
 
     btstack_crypto_ccm->aad_remainder_len = 0;
     btstack_crypto_ccm->state = CCM_W4_AAD_XN;
-    btstack_crypto_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm->x_i);
+    btstack_crypto_ccm_aes128_start(btstack_crypto_ccm->key, btstack_crypto_ccm->x_i);
 }
 
 static void btstack_crypto_ccm_handle_s0(btstack_crypto_ccm_t * btstack_crypto_ccm, const uint8_t * data){
@@ -732,6 +982,37 @@ static void btstack_crypto_ccm_next_block(btstack_crypto_ccm_t * btstack_crypto_
         }
     }
 }
+
+#ifdef ENABLE_CRYPTO_BACKEND
+// backend completed operation, results have been stored in request
+static void btstack_crypto_backend_handle_done(void * arg){
+    UNUSED(arg);
+    btstack_crypto_wait_for_backend_result = 0;
+    btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_queue_first(&btstack_crypto_operations);
+    if (btstack_crypto != NULL){
+        btstack_crypto_done(btstack_crypto);
+    }
+    btstack_crypto_run();
+}
+
+#ifdef ENABLE_ECC_P256
+static void btstack_crypto_backend_handle_ecc_p256_key(void * arg){
+    UNUSED(arg);
+    btstack_crypto_wait_for_backend_result = 0;
+    btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_DONE;
+    btstack_crypto_run();
+}
+#endif
+
+void btstack_crypto_set_backend(const btstack_crypto_backend_t * backend){
+    btstack_crypto_backend = backend;
+}
+#endif
+
+#ifdef ENABLE_CRYPTO_WORKER
+void btstack_crypto_set_worker(const btstack_worker_t * worker){
+    btstack_crypto_worker = worker;
+}
 #endif
 
 static void btstack_crypto_run(void){
@@ -750,20 +1031,29 @@ static void btstack_crypto_run(void){
     while (true){
 
         // anything to do?
-        if (btstack_linked_list_empty(&btstack_crypto_operations)) return;
+        if (btstack_linked_queue_empty(&btstack_crypto_operations)) return;
 
         // already active?
         if (btstack_crypto_wait_for_hci_result) return;
+#ifdef ENABLE_CRYPTO_BACKEND
+        if (btstack_crypto_wait_for_backend_result) return;
+#endif
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+        if (btstack_crypto_wait_for_ecc_p256_calculation) return;
+#endif
+#ifdef USE_ECC_P256_WORKER
+        if (btstack_crypto_wait_for_ecc_p256_job) return;
+#endif
 
         // can send a command?
         if (!hci_can_send_command_packet_now()) return;
 
         // ok, find next task
-    	btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+    	btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_queue_first(&btstack_crypto_operations);
     	switch (btstack_crypto->operation){
     		case BTSTACK_CRYPTO_RANDOM:
     			btstack_crypto_wait_for_hci_result = 1;
-    		    hci_send_cmd(&hci_le_rand);
+    		    btstack_crypto_send_le_rand();
     		    break;
     		case BTSTACK_CRYPTO_AES128:
                 btstack_crypto_aes128 = (btstack_crypto_aes128_t *) btstack_crypto;
@@ -778,6 +1068,13 @@ static void btstack_crypto_run(void){
     		case BTSTACK_CRYPTO_CMAC_MESSAGE:
     		case BTSTACK_CRYPTO_CMAC_GENERATOR:
                 btstack_crypto_cmac = (btstack_crypto_aes128_cmac_t *) btstack_crypto;
+#ifdef ENABLE_CRYPTO_BACKEND
+                if ((btstack_crypto->operation == BTSTACK_CRYPTO_CMAC_MESSAGE) && (btstack_crypto_backend != NULL) && (btstack_crypto_backend->aes128_cmac != NULL)){
+                    btstack_crypto_wait_for_backend_result = 1;
+                    (*btstack_crypto_backend->aes128_cmac)(btstack_crypto_cmac->key, btstack_crypto_cmac->size, btstack_crypto_cmac->data.message, btstack_crypto_cmac->hash, &btstack_crypto_backend_handle_done, NULL);
+                    break;
+                }
+#endif
 #ifdef USE_BTSTACK_AES128
                 btstack_crypto_cmac_calc( btstack_crypto_cmac );
                 btstack_crypto_done(btstack_crypto);
@@ -794,11 +1091,6 @@ static void btstack_crypto_run(void){
             case BTSTACK_CRYPTO_CCM_DIGEST_BLOCK:
             case BTSTACK_CRYPTO_CCM_ENCRYPT_BLOCK:
             case BTSTACK_CRYPTO_CCM_DECRYPT_BLOCK:
-#ifdef USE_BTSTACK_AES128
-                UNUSED(btstack_crypto_ccm);
-                // NOTE: infinite output of this message
-                log_error("ccm not implemented for software aes128 yet");
-#else
                 btstack_crypto_ccm = (btstack_crypto_ccm_t *) btstack_crypto;
                 switch (btstack_crypto_ccm->state){
                     case CCM_CALCULATE_AAD_XN:
@@ -819,7 +1111,6 @@ static void btstack_crypto_run(void){
                     default:
                         break;
                 }
-#endif
                 break;
 
 #ifdef ENABLE_ECC_P256
@@ -831,16 +1122,34 @@ static void btstack_crypto_run(void){
                         btstack_crypto_log_ec_publickey(btstack_crypto_ecc_p256_public_key);
                         (void)memcpy(btstack_crypto_ec_p192->public_key,
                                      btstack_crypto_ecc_p256_public_key, 64);
-                        btstack_linked_list_pop(&btstack_crypto_operations);
+                        btstack_linked_queue_dequeue(&btstack_crypto_operations);
                         (*btstack_crypto_ec_p192->btstack_crypto.context_callback.callback)(btstack_crypto_ec_p192->btstack_crypto.context_callback.context);                    
                         break;
                     case ECC_P256_KEY_GENERATION_IDLE:
+#ifdef ENABLE_CRYPTO_BACKEND
+                        if ((btstack_crypto_backend != NULL) && (btstack_crypto_backend->ecc_p256_generate_key != NULL)){
+                            btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_W4_KEY;
+                            btstack_crypto_wait_for_backend_result = 1;
+                            (*btstack_crypto_backend->ecc_p256_generate_key)(btstack_crypto_ecc_p256_public_key, &btstack_crypto_backend_handle_ecc_p256_key, NULL);
+                            break;
+                        }
+#endif
+#ifdef USE_ECC_P256_KEY_POOL
+                        // keep pool filled, random for next pool entry is requested after current operation
+                        if (btstack_crypto_ecc_p256_key_pool_take()){
+                            log_info("ecc key pool: use pre-computed key, %u left", btstack_crypto_ecc_p256_key_pool_count);
+                            btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_DONE;
+                            btstack_crypto_ecc_p256_key_pool_refill();
+                            break;
+                        }
+                        btstack_crypto_ecc_p256_key_pool_refill();
+#endif
 #ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
                         log_info("start ecc random");
                         btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_GENERATING_RANDOM;
                         btstack_crypto_ecc_p256_random_offset = 0;
                         btstack_crypto_wait_for_hci_result = 1;
-                        hci_send_cmd(&hci_le_rand);
+                        btstack_crypto_send_le_rand();
 #else
                         btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_W4_KEY;
                         btstack_crypto_wait_for_hci_result = 1;
@@ -851,7 +1160,7 @@ static void btstack_crypto_run(void){
                     case ECC_P256_KEY_GENERATION_GENERATING_RANDOM:
                         log_info("more ecc random");
                         btstack_crypto_wait_for_hci_result = 1;
-                        hci_send_cmd(&hci_le_rand);
+                        btstack_crypto_send_le_rand();
                         break;
 #endif
                     default:
@@ -860,10 +1169,25 @@ static void btstack_crypto_run(void){
                 break;
             case BTSTACK_CRYPTO_ECC_P256_CALCULATE_DHKEY:
                 btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t *) btstack_crypto;
-#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
+#ifdef ENABLE_CRYPTO_BACKEND
+                if ((btstack_crypto_backend != NULL) && (btstack_crypto_backend->ecc_p256_calculate_dhkey != NULL)){
+                    btstack_crypto_wait_for_backend_result = 1;
+                    (*btstack_crypto_backend->ecc_p256_calculate_dhkey)(btstack_crypto_ec_p192->public_key, btstack_crypto_ec_p192->dhkey, &btstack_crypto_backend_handle_done, NULL);
+                    break;
+                }
+#endif
+#ifdef USE_ECC_P256_WORKER
+                if (btstack_crypto_ecc_p256_submit_job(&btstack_crypto_ecc_p256_calculate_dhkey_work, &btstack_crypto_ecc_p256_calculate_dhkey_completion, btstack_crypto_ec_p192)){
+                    break;
+                }
+#endif
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+                btstack_crypto_ecc_p256_defer_calculation(&btstack_crypto_ecc_p256_handle_calculate_dhkey_timeout);
+#elif defined(USE_SOFTWARE_ECC_P256_IMPLEMENTATION)
                 btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ec_p192);
+                btstack_crypto_ecc_p256_log_dhkey(btstack_crypto_ec_p192->dhkey);
                 // done
-                btstack_linked_list_pop(&btstack_crypto_operations);
+                btstack_linked_queue_dequeue(&btstack_crypto_operations);
                 (*btstack_crypto_ec_p192->btstack_crypto.context_callback.callback)(btstack_crypto_ec_p192->btstack_crypto.context_callback.context);                    
 #else
                 btstack_crypto_wait_for_hci_result = 1;
@@ -881,7 +1205,7 @@ static void btstack_crypto_run(void){
 
 static void btstack_crypto_handle_random_data(const uint8_t * data, uint16_t len){
     btstack_crypto_random_t * btstack_crypto_random;
-    btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+    btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_queue_first(&btstack_crypto_operations);
     uint16_t bytes_to_copy;
 	if (!btstack_crypto) return;
     switch (btstack_crypto->operation){
@@ -894,7 +1218,7 @@ static void btstack_crypto_handle_random_data(const uint8_t * data, uint16_t len
             // data processed, more?
             if (!btstack_crypto_random->size) {
                 // done
-                btstack_linked_list_pop(&btstack_crypto_operations);
+                btstack_linked_queue_dequeue(&btstack_crypto_operations);
                 (*btstack_crypto_random->btstack_crypto.context_callback.callback)(btstack_crypto_random->btstack_crypto.context_callback.context);
             }
             break;
@@ -905,8 +1229,19 @@ static void btstack_crypto_handle_random_data(const uint8_t * data, uint16_t len
             btstack_crypto_ecc_p256_random_len += 8;
             if (btstack_crypto_ecc_p256_random_len >= 64) {
                 btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_ACTIVE;
-                btstack_crypto_ecc_p256_generate_key_software();
+#ifdef USE_ECC_P256_WORKER
+                if (btstack_crypto_ecc_p256_submit_job(&btstack_crypto_ecc_p256_generate_key_work, &btstack_crypto_ecc_p256_generate_key_completion, NULL)){
+                    break;
+                }
+#endif
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+                btstack_crypto_ecc_p256_defer_calculation(&btstack_crypto_ecc_p256_handle_generate_key_timeout);
+#else
+#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
+                btstack_crypto_ecc_p256_generate_key_software(btstack_crypto_ecc_p256_random, btstack_crypto_ecc_p256_public_key, btstack_crypto_ecc_p256_d);
+#endif
                 btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_DONE;
+#endif
             }
             break;
 #endif
@@ -917,29 +1252,34 @@ static void btstack_crypto_handle_random_data(const uint8_t * data, uint16_t len
 	btstack_crypto_run();
 }
 
-#ifndef USE_BTSTACK_AES128
 static void btstack_crypto_handle_encryption_result(const uint8_t * data){
+#ifndef USE_BTSTACK_AES128
 	btstack_crypto_aes128_t      * btstack_crypto_aes128;
 	btstack_crypto_aes128_cmac_t * btstack_crypto_cmac;
-    btstack_crypto_ccm_t         * btstack_crypto_ccm;
+#endif
+#if !defined(USE_BTSTACK_AES128) || defined(DEBUG_CCM)
 	uint8_t result[16];
+#endif
+    btstack_crypto_ccm_t         * btstack_crypto_ccm;
 
-    btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+    btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_queue_first(&btstack_crypto_operations);
 	if (!btstack_crypto) return;
 	switch (btstack_crypto->operation){
+#ifndef USE_BTSTACK_AES128
 		case BTSTACK_CRYPTO_AES128:
-			btstack_crypto_aes128 = (btstack_crypto_aes128_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+			btstack_crypto_aes128 = (btstack_crypto_aes128_t*) btstack_linked_queue_first(&btstack_crypto_operations);
 		    reverse_128(data, btstack_crypto_aes128->ciphertext);
             btstack_crypto_done(btstack_crypto);
 			break;
 		case BTSTACK_CRYPTO_CMAC_GENERATOR:
 		case BTSTACK_CRYPTO_CMAC_MESSAGE:
-			btstack_crypto_cmac = (btstack_crypto_aes128_cmac_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+			btstack_crypto_cmac = (btstack_crypto_aes128_cmac_t*) btstack_linked_queue_first(&btstack_crypto_operations);
 		    reverse_128(data, result);
 		    btstack_crypto_cmac_handle_encryption_result(btstack_crypto_cmac, result);
 			break;
+#endif
         case BTSTACK_CRYPTO_CCM_DIGEST_BLOCK:
-            btstack_crypto_ccm = (btstack_crypto_ccm_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+            btstack_crypto_ccm = (btstack_crypto_ccm_t*) btstack_linked_queue_first(&btstack_crypto_operations);
             switch (btstack_crypto_ccm->state){
                 case CCM_W4_X1:
                     reverse_128(data, btstack_crypto_ccm->x_i);
@@ -969,7 +1309,7 @@ static void btstack_crypto_handle_encryption_result(const uint8_t * data){
             }
             break;                
         case BTSTACK_CRYPTO_CCM_ENCRYPT_BLOCK:
-            btstack_crypto_ccm = (btstack_crypto_ccm_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+            btstack_crypto_ccm = (btstack_crypto_ccm_t*) btstack_linked_queue_first(&btstack_crypto_operations);
             switch (btstack_crypto_ccm->state){
                 case CCM_W4_X1:
                     reverse_128(data, btstack_crypto_ccm->x_i);
@@ -1009,7 +1349,7 @@ static void btstack_crypto_handle_encryption_result(const uint8_t * data){
             }  
             break;      
         case BTSTACK_CRYPTO_CCM_DECRYPT_BLOCK:
-            btstack_crypto_ccm = (btstack_crypto_ccm_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+            btstack_crypto_ccm = (btstack_crypto_ccm_t*) btstack_linked_queue_first(&btstack_crypto_operations);
             switch (btstack_crypto_ccm->state){
                 case CCM_W4_X1:
                     reverse_128(data, btstack_crypto_ccm->x_i);
@@ -1042,7 +1382,6 @@ static void btstack_crypto_handle_encryption_result(const uint8_t * data){
 			break;
 	}
 }
-#endif
 
 static void btstack_crypto_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *packet, uint16_t size){
     UNUSED(cid);         // ok: there is no channel
@@ -1096,7 +1435,7 @@ static void btstack_crypto_event_handler(uint8_t packet_type, uint16_t cid, uint
 #ifdef ENABLE_ECC_P256
 #ifndef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
         case HCI_EVENT_LE_META:
-            btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+            btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t*) btstack_linked_queue_first(&btstack_crypto_operations);
             if (!btstack_crypto_ec_p192) break;
             switch (hci_event_le_meta_get_subevent_code(packet)){
                 case HCI_SUBEVENT_LE_READ_LOCAL_P256_PUBLIC_KEY_COMPLETE:
@@ -1119,7 +1458,7 @@ static void btstack_crypto_event_handler(uint8_t packet_type, uint16_t cid, uint
                     }
                     hci_subevent_le_generate_dhkey_complete_get_dhkey(packet, btstack_crypto_ec_p192->dhkey);
                     // done
-                    btstack_linked_list_pop(&btstack_crypto_operations);
+                    btstack_linked_queue_dequeue(&btstack_crypto_operations);
                     (*btstack_crypto_ec_p192->btstack_crypto.context_callback.callback)(btstack_crypto_ec_p192->btstack_crypto.context_callback.context);                    
                     break;
                 default:
@@ -1156,7 +1495,7 @@ void btstack_crypto_random_generate(btstack_crypto_random_t * request, uint8_t *
 	request->btstack_crypto.operation         		   = BTSTACK_CRYPTO_RANDOM;
 	request->buffer = buffer;
 	request->size   = size;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
 	btstack_crypto_run();
 }
 
@@ -1167,7 +1506,7 @@ void btstack_crypto_aes128_encrypt(btstack_crypto_aes128_t * request, const uint
 	request->key 									   = key;
 	request->plaintext      					       = plaintext;
 	request->ciphertext 							   = ciphertext;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
 	btstack_crypto_run();
 }
 
@@ -1179,7 +1518,7 @@ void btstack_crypto_aes128_cmac_generator(btstack_crypto_aes128_cmac_t * request
 	request->size 									   = size;
 	request->data.get_byte_callback					   = get_byte_callback;
 	request->hash 									   = hash;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
 	btstack_crypto_run();
 }
 
@@ -1191,7 +1530,7 @@ void btstack_crypto_aes128_cmac_message(btstack_crypto_aes128_cmac_t * request,
 	request->size 									   = size;
 	request->data.message      						   = message;
 	request->hash 									   = hash;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
 	btstack_crypto_run();
 }
 
@@ -1203,7 +1542,7 @@ void btstack_crypto_aes128_cmac_zero(btstack_crypto_aes128_cmac_t * request, uin
     request->size                                      = len;
     request->data.message                              = message;
     request->hash                                      = hash;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
     btstack_crypto_run();
 }
 
@@ -1218,7 +1557,7 @@ void btstack_crypto_ecc_p256_generate_key(btstack_crypto_ecc_p256_t * request, u
     request->btstack_crypto.context_callback.context   = callback_arg;
     request->btstack_crypto.operation                  = BTSTACK_CRYPTO_ECC_P256_GENERATE_KEY;
     request->public_key                                = public_key;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
     btstack_crypto_run();
 }
 
@@ -1228,7 +1567,7 @@ void btstack_crypto_ecc_p256_calculate_dhkey(btstack_crypto_ecc_p256_t * request
     request->btstack_crypto.operation                  = BTSTACK_CRYPTO_ECC_P256_CALCULATE_DHKEY;
     request->public_key                                = (uint8_t *) public_key;
     request->dhkey                                     = dhkey;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
     btstack_crypto_run();
 }
 
@@ -1282,7 +1621,7 @@ void btstack_crypto_ccm_digest(btstack_crypto_ccm_t * request, uint8_t * additio
     request->btstack_crypto.operation                  = BTSTACK_CRYPTO_CCM_DIGEST_BLOCK;
     request->block_len                                 = additional_authenticated_data_len;
     request->input                                     = additional_authenticated_data;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
     btstack_crypto_run();
 }
 
@@ -1303,7 +1642,7 @@ void btstack_crypto_ccm_encrypt_block(btstack_crypto_ccm_t * request, uint16_t b
     if (request->state != CCM_CALCULATE_X1){
         request->state  = CCM_CALCULATE_XN;
     }
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
     btstack_crypto_run();
 }
 
@@ -1317,7 +1656,7 @@ void btstack_crypto_ccm_decrypt_block(btstack_crypto_ccm_t * request, uint16_t b
     if (request->state != CCM_CALCULATE_X1){
         request->state  = CCM_CALCULATE_SN;
     }
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_linked_queue_enqueue(&btstack_crypto_operations, (btstack_linked_item_t*) request);
     btstack_crypto_run();
 }
 
@@ -1334,9 +1673,24 @@ void btstack_crypto_ecc_p256_set_key(const uint8_t * public_key, const uint8_t *
 }
 // Unit testing
 int btstack_crypto_idle(void){
-    return btstack_linked_list_empty(&btstack_crypto_operations);
+    return btstack_linked_queue_empty(&btstack_crypto_operations);
 }
 void btstack_crypto_reset(void){
-    btstack_crypto_operations = NULL;
+    btstack_crypto_operations.head = NULL;
+    btstack_crypto_operations.tail = NULL;
     btstack_crypto_wait_for_hci_result = 0;
+#ifdef ENABLE_CRYPTO_BACKEND
+    btstack_crypto_wait_for_backend_result = 0;
+#endif
+#ifdef USE_ECC_P256_KEY_POOL
+    btstack_crypto_ecc_p256_key_pool_refill_active = 0;
+#endif
+#ifdef USE_ECC_P256_DEFERRED_CALCULATION
+    btstack_run_loop_remove_timer(&btstack_crypto_ecc_p256_timer);
+    btstack_crypto_wait_for_ecc_p256_calculation = 0;
+#endif
+#ifdef USE_ECC_P256_WORKER
+    // a calculation already submitted to the worker cannot be cancelled, its completion checks for the request
+    btstack_crypto_wait_for_ecc_p256_job = 0;
+#endif
 }
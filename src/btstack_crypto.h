@@ -48,6 +48,10 @@
 #include "btstack_defines.h"
 #include "btstack_config.h"
 
+#ifdef ENABLE_CRYPTO_WORKER
+#include "btstack_worker.h"
+#endif
+
 #if defined __cplusplus
 extern "C" {
 #endif
@@ -282,6 +286,55 @@ void btstack_crypto_ccm_decrypt_block(btstack_crypto_ccm_t * request, uint16_t l
 void btstack_aes128_calc(const uint8_t * key, const uint8_t * plaintext, uint8_t * ciphertext);
 #endif
 
+#ifdef ENABLE_CRYPTO_BACKEND
+/**
+ * Crypto backend for MCU peripherals like AES or PKA engines
+ * All functions are optional. Operations without backend function are executed as before.
+ * Callback has to be called from the main thread when done, keys and blocks use the same byte order as btstack_aes128_calc.
+ */
+typedef struct {
+    /**
+     * Encrypt single AES128 block, used instead of HCI_LE_Encrypt for AES128, AES-CMAC, and AES-CCM.
+     * @note not used if btstack_aes128_calc is available (ENABLE_SOFTWARE_AES128 or HAVE_AES128)
+     */
+    void (*aes128_encrypt)(const uint8_t * key, const uint8_t * plaintext, uint8_t * ciphertext, void (* callback)(void * arg), void * callback_arg);
+
+    /**
+     * Calculate AES-CMAC over message, used for btstack_crypto_aes128_cmac_message and btstack_crypto_aes128_cmac_zero
+     */
+    void (*aes128_cmac)(const uint8_t * key, uint16_t size, const uint8_t * message, uint8_t * hash, void (* callback)(void * arg), void * callback_arg);
+
+    /**
+     * Generate new P-256 key pair. The private key is kept by the backend
+     * @param public_key (64 bytes, X and Y)
+     */
+    void (*ecc_p256_generate_key)(uint8_t * public_key, void (* callback)(void * arg), void * callback_arg);
+
+    /**
+     * Calculate DHKey for remote public key with private key of last generated key pair
+     * @param public_key (64 bytes, X and Y)
+     * @param dhkey (32 bytes)
+     */
+    void (*ecc_p256_calculate_dhkey)(const uint8_t * public_key, uint8_t * dhkey, void (* callback)(void * arg), void * callback_arg);
+} btstack_crypto_backend_t;
+
+/**
+ * Register crypto backend
+ * @note call after btstack_crypto_init and before crypto operations are requested
+ * @param backend or NULL to use Controller or software implementation
+ */
+void btstack_crypto_set_backend(const btstack_crypto_backend_t * backend);
+#endif
+
+#ifdef ENABLE_CRYPTO_WORKER
+/**
+ * Register worker to run software ECC P-256 key generation and DH Key calculation on another thread
+ * @note call after btstack_crypto_init and before crypto operations are requested
+ * @param worker or NULL to run calculations on main thread
+ */
+void btstack_crypto_set_worker(const btstack_worker_t * worker);
+#endif
+
 // PTS testing only - not possible when using Buetooth Controller for ECC operations
 void btstack_crypto_ecc_p256_set_key(const uint8_t * public_key, const uint8_t * private_key);
 
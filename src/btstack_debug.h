@@ -88,7 +88,12 @@ void btstack_assert_failed(const char * file, uint16_t line_nr);
 #endif
 #endif
 
-#ifdef __AVR__
+#ifdef ENABLE_LOG_DEFERRED
+// file and line are part of format string, formatting is done by tool/decode_deferred_log.py
+#define HCI_DUMP_LOG_STRINGIFY(x) #x
+#define HCI_DUMP_LOG_LINE(x) HCI_DUMP_LOG_STRINGIFY(x)
+#define HCI_DUMP_LOG(log_level, format, ...) hci_dump_log_deferred(log_level, BTSTACK_FILE__ "." HCI_DUMP_LOG_LINE(__LINE__) ": " format, ## __VA_ARGS__)
+#elif defined(__AVR__)
 #define HCI_DUMP_LOG(log_level, format, ...) hci_dump_log_P(log_level, PSTR("%s.%u: " format), BTSTACK_FILE__, __LINE__, ## __VA_ARGS__)
 #else
 #define HCI_DUMP_LOG(log_level, format, ...) hci_dump_log(log_level, "%s.%u: " format, BTSTACK_FILE__, __LINE__, ## __VA_ARGS__)
@@ -58,9 +58,14 @@
 typedef void (*btstack_packet_handler_t) (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 
 // packet callback supporting multiple registrations
+// event filter: bit (event_code & 7) in byte (event_code >> 3) set if events with event_code are delivered
+#define BTSTACK_EVENT_FILTER_SIZE 32
+
 typedef struct {
     btstack_linked_item_t    item;
     btstack_packet_handler_t callback;
+    // optional, BTSTACK_EVENT_FILTER_SIZE bytes, see btstack_event_filter_init. NULL delivers all events
+    const uint8_t *          event_filter;
 } btstack_packet_callback_registration_t;
 
 // context callback supporting multiple registrations
@@ -162,6 +167,9 @@ typedef uint8_t sm_key_t[16];
 // set global Bluetooth state
 #define BTSTACK_SET_BLUETOOTH_ENABLED                      0x08
 
+// forward broadcast HCI event type to this client: param event_type(8), enabled(8)
+#define BTSTACK_SET_EVENT_FILTER                           0x09
+
 // create l2cap channel: param bd_addr(48), psm (16)
 #define L2CAP_CREATE_CHANNEL                               0x20
 
@@ -629,6 +637,103 @@ typedef uint8_t sm_key_t[16];
 // array of advertisements, not handled by event accessor generator
 #define HCI_SUBEVENT_LE_DIRECT_ADVERTISING_REPORT          0x0B
 
+/**
+ * @format 11H11
+ * @param subevent_code
+ * @param status
+ * @param connection_handle
+ * @param tx_phy
+ * @param rx_phy
+ */
+#define HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE                0x0C
+
+// array of advertisements, not handled by event accessor generator
+#define HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT        0x0D
+
+/**
+ * @format 11H33331111111222
+ * @param subevent_code
+ * @param status
+ * @param connection_handle
+ * @param cig_sync_delay
+ * @param cis_sync_delay
+ * @param transport_latency_c_to_p
+ * @param transport_latency_p_to_c
+ * @param phy_c_to_p
+ * @param phy_p_to_c
+ * @param nse
+ * @param bn_c_to_p
+ * @param bn_p_to_c
+ * @param ft_c_to_p
+ * @param ft_p_to_c
+ * @param max_pdu_c_to_p
+ * @param max_pdu_p_to_c
+ * @param iso_interval
+ */
+#define HCI_SUBEVENT_LE_CIS_ESTABLISHED                    0x19
+
+/**
+ * @format 1HH11
+ * @param subevent_code
+ * @param acl_connection_handle
+ * @param cis_connection_handle
+ * @param cig_id
+ * @param cis_id
+ */
+#define HCI_SUBEVENT_LE_CIS_REQUEST                        0x1A
+
+// followed by array of num_bis connection handles, not handled by event accessor generator
+/**
+ * @format 1113311111221
+ * @param subevent_code
+ * @param status
+ * @param big_handle
+ * @param big_sync_delay
+ * @param transport_latency_big
+ * @param phy
+ * @param nse
+ * @param bn
+ * @param pto
+ * @param irc
+ * @param max_pdu
+ * @param iso_interval
+ * @param num_bis
+ */
+#define HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE                0x1B
+
+/**
+ * @format 111
+ * @param subevent_code
+ * @param big_handle
+ * @param reason
+ */
+#define HCI_SUBEVENT_LE_TERMINATE_BIG_COMPLETE             0x1C
+
+// followed by array of num_bis connection handles, not handled by event accessor generator
+/**
+ * @format 11131111221
+ * @param subevent_code
+ * @param status
+ * @param big_handle
+ * @param transport_latency_big
+ * @param nse
+ * @param bn
+ * @param pto
+ * @param irc
+ * @param max_pdu
+ * @param iso_interval
+ * @param num_bis
+ */
+#define HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED               0x1D
+
+/**
+ * @format 111
+ * @param subevent_code
+ * @param big_handle
+ * @param reason
+ */
+#define HCI_SUBEVENT_LE_BIG_SYNC_LOST                      0x1E
+
 
 /**
  * @format 1
@@ -653,6 +758,25 @@ typedef uint8_t sm_key_t[16];
  */
 #define BTSTACK_EVENT_DISCOVERABLE_ENABLED                 0x66
 
+/**
+ * @brief Time spent in the phases of HCI initialization, emitted before HCI_STATE_WORKING if ENABLE_HCI_INIT_PROFILING
+ * @format 44442
+ * @param reset_ms
+ * @param baud_change_ms
+ * @param custom_init_ms
+ * @param configuration_ms
+ * @param num_custom_init_commands
+ */
+#define BTSTACK_EVENT_INIT_PROFILE                         0x6A
+
+/**
+ * @brief Time from sending an HCI Command during HCI initialization until its completion, not emitted for init script commands. Requires ENABLE_HCI_INIT_PROFILING
+ * @format 24
+ * @param opcode
+ * @param duration_ms
+ */
+#define BTSTACK_EVENT_INIT_STEP                            0x6B
+
 // Daemon Events
 
 /**
@@ -735,6 +859,21 @@ typedef uint8_t sm_key_t[16];
  */
 #define HCI_EVENT_TRANSPORT_SLEEP_MODE                     0x69
 
+/**
+ * @brief ACL statistics for connection, emitted periodically after hci_set_statistics_report_interval. Requires ENABLE_HCI_STATISTICS
+ * @format H44444224
+ * @param handle
+ * @param acl_packets_sent
+ * @param acl_bytes_sent
+ * @param acl_fragments_sent
+ * @param acl_packets_received
+ * @param acl_bytes_received
+ * @param acl_packets_outstanding
+ * @param acl_packets_outstanding_max
+ * @param acl_credit_starvation_ms
+ */
+#define HCI_EVENT_CONNECTION_STATISTICS                    0x6C
+
 /**
  * @brief Transport ready 
  */
@@ -751,6 +890,13 @@ typedef uint8_t sm_key_t[16];
  */
 #define HCI_EVENT_SCO_CAN_SEND_NOW                         0x6F
 
+/**
+ * @brief Outgoing ISO SDU can be sent, see hci_request_iso_can_send_now_event. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @format H
+ * @param handle
+ */
+#define HCI_EVENT_ISO_CAN_SEND_NOW                         0xB0
+
 
 // L2CAP EVENTS
     
@@ -1075,6 +1221,14 @@ typedef uint8_t sm_key_t[16];
  */
 #define GATT_EVENT_CAN_WRITE_WITHOUT_RESPONSE                    0xAC
 
+/**
+ * @format H24
+ * @param handle
+ * @param value_handle
+ * @param bytes_sent
+ */
+#define GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS        0xAD
+
 /** 
  * @format 1BH
  * @param address_type
@@ -1364,6 +1518,36 @@ typedef uint8_t sm_key_t[16];
  */
 #define GAP_EVENT_RSSI_MEASUREMENT                            0xE5
 
+/**
+ * @brief Extended Advertising Report with advertising data reassembled from all fragments
+ * @format 21B1111121BJV
+ * @param advertising_event_type (data status in bits 5-6: complete (0) or truncated (2))
+ * @param address_type
+ * @param address
+ * @param primary_phy
+ * @param secondary_phy
+ * @param advertising_sid
+ * @param tx_power
+ * @param rssi
+ * @param periodic_advertising_interval
+ * @param direct_address_type
+ * @param direct_address
+ * @param data_length
+ * @param data
+ */
+#define GAP_EVENT_EXTENDED_ADVERTISING_REPORT                 0xE6
+
+/**
+ * @brief LE connection uses negotiated PHY and data length, emitted if ENABLE_LE_LINK_UPGRADE
+ * @format H1122
+ * @param con_handle
+ * @param tx_phy
+ * @param rx_phy
+ * @param max_tx_octets
+ * @param max_rx_octets
+ */
+#define GAP_EVENT_LE_LINK_READY                               0xE7
+
 // Meta Events, see below for sub events
 #define HCI_EVENT_HSP_META                                 0xE8
 #define HCI_EVENT_HFP_META                                 0xE9
@@ -1675,6 +1859,15 @@ typedef uint8_t sm_key_t[16];
  */ 
 #define ANCS_SUBEVENT_CLIENT_DISCONNECTED                           0xF2
 
+/**
+ * @format 1H4T
+ * @param subevent_code
+ * @param handle
+ * @param notification_uid
+ * @param display_name
+ */ 
+#define ANCS_SUBEVENT_CLIENT_APP_DISPLAY_NAME                       0xF3
+
 
 /** AVDTP Subevent */
 
@@ -1079,6 +1079,71 @@ static inline uint8_t btstack_event_discoverable_enabled_get_discoverable(const
     return event[2];
 }
 
+/**
+ * @brief Get field reset_ms from event BTSTACK_EVENT_INIT_PROFILE
+ * @param event packet
+ * @return reset_ms
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_init_profile_get_reset_ms(const uint8_t * event){
+    return little_endian_read_32(event, 2);
+}
+/**
+ * @brief Get field baud_change_ms from event BTSTACK_EVENT_INIT_PROFILE
+ * @param event packet
+ * @return baud_change_ms
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_init_profile_get_baud_change_ms(const uint8_t * event){
+    return little_endian_read_32(event, 6);
+}
+/**
+ * @brief Get field custom_init_ms from event BTSTACK_EVENT_INIT_PROFILE
+ * @param event packet
+ * @return custom_init_ms
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_init_profile_get_custom_init_ms(const uint8_t * event){
+    return little_endian_read_32(event, 10);
+}
+/**
+ * @brief Get field configuration_ms from event BTSTACK_EVENT_INIT_PROFILE
+ * @param event packet
+ * @return configuration_ms
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_init_profile_get_configuration_ms(const uint8_t * event){
+    return little_endian_read_32(event, 14);
+}
+/**
+ * @brief Get field num_custom_init_commands from event BTSTACK_EVENT_INIT_PROFILE
+ * @param event packet
+ * @return num_custom_init_commands
+ * @note: btstack_type 2
+ */
+static inline uint16_t btstack_event_init_profile_get_num_custom_init_commands(const uint8_t * event){
+    return little_endian_read_16(event, 18);
+}
+
+/**
+ * @brief Get field opcode from event BTSTACK_EVENT_INIT_STEP
+ * @param event packet
+ * @return opcode
+ * @note: btstack_type 2
+ */
+static inline uint16_t btstack_event_init_step_get_opcode(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+/**
+ * @brief Get field duration_ms from event BTSTACK_EVENT_INIT_STEP
+ * @param event packet
+ * @return duration_ms
+ * @note: btstack_type 4
+ */
+static inline uint32_t btstack_event_init_step_get_duration_ms(const uint8_t * event){
+    return little_endian_read_32(event, 4);
+}
+
 /**
  * @brief Get field active from event HCI_EVENT_TRANSPORT_SLEEP_MODE
  * @param event packet
@@ -1089,6 +1154,88 @@ static inline uint8_t hci_event_transport_sleep_mode_get_active(const uint8_t *
     return event[2];
 }
 
+/**
+ * @brief Get field handle from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_event_connection_statistics_get_handle(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+/**
+ * @brief Get field acl_packets_sent from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_packets_sent
+ * @note: btstack_type 4
+ */
+static inline uint32_t hci_event_connection_statistics_get_acl_packets_sent(const uint8_t * event){
+    return little_endian_read_32(event, 4);
+}
+/**
+ * @brief Get field acl_bytes_sent from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_bytes_sent
+ * @note: btstack_type 4
+ */
+static inline uint32_t hci_event_connection_statistics_get_acl_bytes_sent(const uint8_t * event){
+    return little_endian_read_32(event, 8);
+}
+/**
+ * @brief Get field acl_fragments_sent from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_fragments_sent
+ * @note: btstack_type 4
+ */
+static inline uint32_t hci_event_connection_statistics_get_acl_fragments_sent(const uint8_t * event){
+    return little_endian_read_32(event, 12);
+}
+/**
+ * @brief Get field acl_packets_received from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_packets_received
+ * @note: btstack_type 4
+ */
+static inline uint32_t hci_event_connection_statistics_get_acl_packets_received(const uint8_t * event){
+    return little_endian_read_32(event, 16);
+}
+/**
+ * @brief Get field acl_bytes_received from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_bytes_received
+ * @note: btstack_type 4
+ */
+static inline uint32_t hci_event_connection_statistics_get_acl_bytes_received(const uint8_t * event){
+    return little_endian_read_32(event, 20);
+}
+/**
+ * @brief Get field acl_packets_outstanding from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_packets_outstanding
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_event_connection_statistics_get_acl_packets_outstanding(const uint8_t * event){
+    return little_endian_read_16(event, 24);
+}
+/**
+ * @brief Get field acl_packets_outstanding_max from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_packets_outstanding_max
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_event_connection_statistics_get_acl_packets_outstanding_max(const uint8_t * event){
+    return little_endian_read_16(event, 26);
+}
+/**
+ * @brief Get field acl_credit_starvation_ms from event HCI_EVENT_CONNECTION_STATISTICS
+ * @param event packet
+ * @return acl_credit_starvation_ms
+ * @note: btstack_type 4
+ */
+static inline uint32_t hci_event_connection_statistics_get_acl_credit_starvation_ms(const uint8_t * event){
+    return little_endian_read_32(event, 28);
+}
+
 /**
  * @brief Get field handle from event HCI_EVENT_SCO_CAN_SEND_NOW
  * @param event packet
@@ -1099,6 +1246,16 @@ static inline void hci_event_sco_can_send_now_get_handle(const uint8_t * event,
     reverse_bytes(&event[2], handle, 6);
 }
 
+/**
+ * @brief Get field handle from event HCI_EVENT_ISO_CAN_SEND_NOW
+ * @param event packet
+ * @return handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_event_iso_can_send_now_get_handle(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+
 /**
  * @brief Get field status from event L2CAP_EVENT_CHANNEL_OPENED
  * @param event packet
@@ -2215,6 +2372,36 @@ static inline hci_con_handle_t gatt_event_can_write_without_response_get_handle(
 }
 #endif
 
+#ifdef ENABLE_BLE
+/**
+ * @brief Get field handle from event GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS
+ * @param event packet
+ * @return handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t gatt_event_write_without_response_stream_progress_get_handle(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+/**
+ * @brief Get field value_handle from event GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS
+ * @param event packet
+ * @return value_handle
+ * @note: btstack_type 2
+ */
+static inline uint16_t gatt_event_write_without_response_stream_progress_get_value_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
+/**
+ * @brief Get field bytes_sent from event GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS
+ * @param event packet
+ * @return bytes_sent
+ * @note: btstack_type 4
+ */
+static inline uint32_t gatt_event_write_without_response_stream_progress_get_bytes_sent(const uint8_t * event){
+    return little_endian_read_32(event, 6);
+}
+#endif
+
 /**
  * @brief Get field address_type from event ATT_EVENT_CONNECTED
  * @param event packet
@@ -3278,6 +3465,170 @@ static inline uint8_t gap_event_rssi_measurement_get_rssi(const uint8_t * event)
     return event[4];
 }
 
+/**
+ * @brief Get field advertising_event_type from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return advertising_event_type
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_extended_advertising_report_get_advertising_event_type(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+/**
+ * @brief Get field address_type from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return address_type
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_address_type(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field address from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @param Pointer to storage for address
+ * @note: btstack_type B
+ */
+static inline void gap_event_extended_advertising_report_get_address(const uint8_t * event, bd_addr_t address){
+    reverse_bytes(&event[5], address, 6);
+}
+/**
+ * @brief Get field primary_phy from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return primary_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_primary_phy(const uint8_t * event){
+    return event[11];
+}
+/**
+ * @brief Get field secondary_phy from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return secondary_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_secondary_phy(const uint8_t * event){
+    return event[12];
+}
+/**
+ * @brief Get field advertising_sid from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return advertising_sid
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_advertising_sid(const uint8_t * event){
+    return event[13];
+}
+/**
+ * @brief Get field tx_power from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return tx_power
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_tx_power(const uint8_t * event){
+    return event[14];
+}
+/**
+ * @brief Get field rssi from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return rssi
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_rssi(const uint8_t * event){
+    return event[15];
+}
+/**
+ * @brief Get field periodic_advertising_interval from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return periodic_advertising_interval
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_extended_advertising_report_get_periodic_advertising_interval(const uint8_t * event){
+    return little_endian_read_16(event, 16);
+}
+/**
+ * @brief Get field direct_address_type from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return direct_address_type
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_direct_address_type(const uint8_t * event){
+    return event[18];
+}
+/**
+ * @brief Get field direct_address from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @param Pointer to storage for direct_address
+ * @note: btstack_type B
+ */
+static inline void gap_event_extended_advertising_report_get_direct_address(const uint8_t * event, bd_addr_t direct_address){
+    reverse_bytes(&event[19], direct_address, 6);
+}
+/**
+ * @brief Get field data_length from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return data_length
+ * @note: btstack_type J
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_data_length(const uint8_t * event){
+    return event[25];
+}
+/**
+ * @brief Get field data from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return data
+ * @note: btstack_type V
+ */
+static inline const uint8_t * gap_event_extended_advertising_report_get_data(const uint8_t * event){
+    return &event[26];
+}
+
+/**
+ * @brief Get field con_handle from event GAP_EVENT_LE_LINK_READY
+ * @param event packet
+ * @return con_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t gap_event_le_link_ready_get_con_handle(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+/**
+ * @brief Get field tx_phy from event GAP_EVENT_LE_LINK_READY
+ * @param event packet
+ * @return tx_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_le_link_ready_get_tx_phy(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field rx_phy from event GAP_EVENT_LE_LINK_READY
+ * @param event packet
+ * @return rx_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_le_link_ready_get_rx_phy(const uint8_t * event){
+    return event[5];
+}
+/**
+ * @brief Get field max_tx_octets from event GAP_EVENT_LE_LINK_READY
+ * @param event packet
+ * @return max_tx_octets
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_le_link_ready_get_max_tx_octets(const uint8_t * event){
+    return little_endian_read_16(event, 6);
+}
+/**
+ * @brief Get field max_rx_octets from event GAP_EVENT_LE_LINK_READY
+ * @param event packet
+ * @return max_rx_octets
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_le_link_ready_get_max_rx_octets(const uint8_t * event){
+    return little_endian_read_16(event, 8);
+}
+
 /**
  * @brief Get field status from event HCI_SUBEVENT_LE_CONNECTION_COMPLETE
  * @param event packet
@@ -3702,29 +4053,486 @@ static inline uint8_t hci_subevent_le_enhanced_connection_complete_get_master_cl
 }
 
 /**
- * @brief Get field status from event HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE
+ * @brief Get field status from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
  * @param event packet
  * @return status
  * @note: btstack_type 1
  */
-static inline uint8_t hsp_subevent_rfcomm_connection_complete_get_status(const uint8_t * event){
+static inline uint8_t hci_subevent_le_phy_update_complete_get_status(const uint8_t * event){
     return event[3];
 }
-
 /**
- * @brief Get field status from event HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE
+ * @brief Get field connection_handle from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
  * @param event packet
- * @return status
- * @note: btstack_type 1
+ * @return connection_handle
+ * @note: btstack_type H
  */
-static inline uint8_t hsp_subevent_rfcomm_disconnection_complete_get_status(const uint8_t * event){
-    return event[3];
+static inline hci_con_handle_t hci_subevent_le_phy_update_complete_get_connection_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
 }
-
 /**
- * @brief Get field status from event HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE
+ * @brief Get field tx_phy from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
  * @param event packet
- * @return status
+ * @return tx_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_phy_update_complete_get_tx_phy(const uint8_t * event){
+    return event[6];
+}
+/**
+ * @brief Get field rx_phy from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+ * @param event packet
+ * @return rx_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_phy_update_complete_get_rx_phy(const uint8_t * event){
+    return event[7];
+}
+
+/**
+ * @brief Get field status from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_status(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field connection_handle from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return connection_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_subevent_le_cis_established_get_connection_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
+/**
+ * @brief Get field cig_sync_delay from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return cig_sync_delay
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_cis_established_get_cig_sync_delay(const uint8_t * event){
+    return little_endian_read_24(event, 6);
+}
+/**
+ * @brief Get field cis_sync_delay from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return cis_sync_delay
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_cis_established_get_cis_sync_delay(const uint8_t * event){
+    return little_endian_read_24(event, 9);
+}
+/**
+ * @brief Get field transport_latency_c_to_p from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return transport_latency_c_to_p
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_cis_established_get_transport_latency_c_to_p(const uint8_t * event){
+    return little_endian_read_24(event, 12);
+}
+/**
+ * @brief Get field transport_latency_p_to_c from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return transport_latency_p_to_c
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_cis_established_get_transport_latency_p_to_c(const uint8_t * event){
+    return little_endian_read_24(event, 15);
+}
+/**
+ * @brief Get field phy_c_to_p from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return phy_c_to_p
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_phy_c_to_p(const uint8_t * event){
+    return event[18];
+}
+/**
+ * @brief Get field phy_p_to_c from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return phy_p_to_c
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_phy_p_to_c(const uint8_t * event){
+    return event[19];
+}
+/**
+ * @brief Get field nse from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return nse
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_nse(const uint8_t * event){
+    return event[20];
+}
+/**
+ * @brief Get field bn_c_to_p from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return bn_c_to_p
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_bn_c_to_p(const uint8_t * event){
+    return event[21];
+}
+/**
+ * @brief Get field bn_p_to_c from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return bn_p_to_c
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_bn_p_to_c(const uint8_t * event){
+    return event[22];
+}
+/**
+ * @brief Get field ft_c_to_p from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return ft_c_to_p
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_ft_c_to_p(const uint8_t * event){
+    return event[23];
+}
+/**
+ * @brief Get field ft_p_to_c from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return ft_p_to_c
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_established_get_ft_p_to_c(const uint8_t * event){
+    return event[24];
+}
+/**
+ * @brief Get field max_pdu_c_to_p from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return max_pdu_c_to_p
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_cis_established_get_max_pdu_c_to_p(const uint8_t * event){
+    return little_endian_read_16(event, 25);
+}
+/**
+ * @brief Get field max_pdu_p_to_c from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return max_pdu_p_to_c
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_cis_established_get_max_pdu_p_to_c(const uint8_t * event){
+    return little_endian_read_16(event, 27);
+}
+/**
+ * @brief Get field iso_interval from event HCI_SUBEVENT_LE_CIS_ESTABLISHED
+ * @param event packet
+ * @return iso_interval
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_cis_established_get_iso_interval(const uint8_t * event){
+    return little_endian_read_16(event, 29);
+}
+
+/**
+ * @brief Get field acl_connection_handle from event HCI_SUBEVENT_LE_CIS_REQUEST
+ * @param event packet
+ * @return acl_connection_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_subevent_le_cis_request_get_acl_connection_handle(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
+/**
+ * @brief Get field cis_connection_handle from event HCI_SUBEVENT_LE_CIS_REQUEST
+ * @param event packet
+ * @return cis_connection_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_subevent_le_cis_request_get_cis_connection_handle(const uint8_t * event){
+    return little_endian_read_16(event, 5);
+}
+/**
+ * @brief Get field cig_id from event HCI_SUBEVENT_LE_CIS_REQUEST
+ * @param event packet
+ * @return cig_id
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_request_get_cig_id(const uint8_t * event){
+    return event[7];
+}
+/**
+ * @brief Get field cis_id from event HCI_SUBEVENT_LE_CIS_REQUEST
+ * @param event packet
+ * @return cis_id
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_cis_request_get_cis_id(const uint8_t * event){
+    return event[8];
+}
+
+/**
+ * @brief Get field status from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_status(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field big_handle from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return big_handle
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_big_handle(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field big_sync_delay from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return big_sync_delay
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_create_big_complete_get_big_sync_delay(const uint8_t * event){
+    return little_endian_read_24(event, 5);
+}
+/**
+ * @brief Get field transport_latency_big from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return transport_latency_big
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_create_big_complete_get_transport_latency_big(const uint8_t * event){
+    return little_endian_read_24(event, 8);
+}
+/**
+ * @brief Get field phy from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_phy(const uint8_t * event){
+    return event[11];
+}
+/**
+ * @brief Get field nse from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return nse
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_nse(const uint8_t * event){
+    return event[12];
+}
+/**
+ * @brief Get field bn from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return bn
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_bn(const uint8_t * event){
+    return event[13];
+}
+/**
+ * @brief Get field pto from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return pto
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_pto(const uint8_t * event){
+    return event[14];
+}
+/**
+ * @brief Get field irc from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return irc
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_irc(const uint8_t * event){
+    return event[15];
+}
+/**
+ * @brief Get field max_pdu from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return max_pdu
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_create_big_complete_get_max_pdu(const uint8_t * event){
+    return little_endian_read_16(event, 16);
+}
+/**
+ * @brief Get field iso_interval from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return iso_interval
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_create_big_complete_get_iso_interval(const uint8_t * event){
+    return little_endian_read_16(event, 18);
+}
+/**
+ * @brief Get field num_bis from event HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE
+ * @param event packet
+ * @return num_bis
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_create_big_complete_get_num_bis(const uint8_t * event){
+    return event[20];
+}
+
+/**
+ * @brief Get field big_handle from event HCI_SUBEVENT_LE_TERMINATE_BIG_COMPLETE
+ * @param event packet
+ * @return big_handle
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_terminate_big_complete_get_big_handle(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field reason from event HCI_SUBEVENT_LE_TERMINATE_BIG_COMPLETE
+ * @param event packet
+ * @return reason
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_terminate_big_complete_get_reason(const uint8_t * event){
+    return event[4];
+}
+
+/**
+ * @brief Get field status from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_status(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field big_handle from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return big_handle
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_big_handle(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field transport_latency_big from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return transport_latency_big
+ * @note: btstack_type 3
+ */
+static inline uint32_t hci_subevent_le_big_sync_established_get_transport_latency_big(const uint8_t * event){
+    return little_endian_read_24(event, 5);
+}
+/**
+ * @brief Get field nse from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return nse
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_nse(const uint8_t * event){
+    return event[8];
+}
+/**
+ * @brief Get field bn from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return bn
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_bn(const uint8_t * event){
+    return event[9];
+}
+/**
+ * @brief Get field pto from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return pto
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_pto(const uint8_t * event){
+    return event[10];
+}
+/**
+ * @brief Get field irc from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return irc
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_irc(const uint8_t * event){
+    return event[11];
+}
+/**
+ * @brief Get field max_pdu from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return max_pdu
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_big_sync_established_get_max_pdu(const uint8_t * event){
+    return little_endian_read_16(event, 12);
+}
+/**
+ * @brief Get field iso_interval from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return iso_interval
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_subevent_le_big_sync_established_get_iso_interval(const uint8_t * event){
+    return little_endian_read_16(event, 14);
+}
+/**
+ * @brief Get field num_bis from event HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED
+ * @param event packet
+ * @return num_bis
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_established_get_num_bis(const uint8_t * event){
+    return event[16];
+}
+
+/**
+ * @brief Get field big_handle from event HCI_SUBEVENT_LE_BIG_SYNC_LOST
+ * @param event packet
+ * @return big_handle
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_lost_get_big_handle(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field reason from event HCI_SUBEVENT_LE_BIG_SYNC_LOST
+ * @param event packet
+ * @return reason
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_big_sync_lost_get_reason(const uint8_t * event){
+    return event[4];
+}
+
+/**
+ * @brief Get field status from event HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hsp_subevent_rfcomm_connection_complete_get_status(const uint8_t * event){
+    return event[3];
+}
+
+/**
+ * @brief Get field status from event HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hsp_subevent_rfcomm_disconnection_complete_get_status(const uint8_t * event){
+    return event[3];
+}
+
+/**
+ * @brief Get field status from event HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE
+ * @param event packet
+ * @return status
  * @note: btstack_type 1
  */
 static inline uint8_t hsp_subevent_audio_connection_complete_get_status(const uint8_t * event){
@@ -4248,6 +5056,36 @@ static inline hci_con_handle_t ancs_subevent_client_disconnected_get_handle(cons
 }
 #endif
 
+#ifdef ENABLE_BLE
+/**
+ * @brief Get field handle from event ANCS_SUBEVENT_CLIENT_APP_DISPLAY_NAME
+ * @param event packet
+ * @return handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t ancs_subevent_client_app_display_name_get_handle(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
+/**
+ * @brief Get field notification_uid from event ANCS_SUBEVENT_CLIENT_APP_DISPLAY_NAME
+ * @param event packet
+ * @return notification_uid
+ * @note: btstack_type 4
+ */
+static inline uint32_t ancs_subevent_client_app_display_name_get_notification_uid(const uint8_t * event){
+    return little_endian_read_32(event, 5);
+}
+/**
+ * @brief Get field display_name from event ANCS_SUBEVENT_CLIENT_APP_DISPLAY_NAME
+ * @param event packet
+ * @return display_name
+ * @note: btstack_type T
+ */
+static inline const char * ancs_subevent_client_app_display_name_get_display_name(const uint8_t * event){
+    return (const char *) &event[9];
+}
+#endif
+
 /**
  * @brief Get field avdtp_cid from event AVDTP_SUBEVENT_SIGNALING_ACCEPT
  * @param event packet
@@ -354,6 +354,35 @@ int  btstack_hid_parser_has_more(btstack_hid_parser_t * parser){
     return parser->state == BTSTACK_HID_PARSER_USAGES_AVAILABLE;
 }
 
+// advance to next field without reading report
+static void btstack_hid_parser_next_field(btstack_hid_parser_t * parser, int is_variable){
+    parser->required_usages--;
+    parser->report_pos_in_bit += parser->global_report_size;
+
+    // next usage
+    if (is_variable){
+        parser->usage_minimum++;
+        parser->available_usages--;
+    } else {
+        if (parser->required_usages == 0){
+            parser->available_usages = 0;
+        }
+    }
+    if (parser->available_usages) {
+        return;
+    }
+    if (parser->required_usages == 0){
+        hid_post_process_item(parser, &parser->descriptor_item);
+        parser->state = BTSTACK_HID_PARSER_SCAN_FOR_REPORT_ITEM;
+        btstack_hid_parser_find_next_usage(parser);
+    } else {
+        hid_find_next_usage(parser);
+        if (parser->available_usages == 0) {
+            parser->state = BTSTACK_HID_PARSER_COMPLETE;
+        }
+    }
+}
+
 void btstack_hid_parser_get_field(btstack_hid_parser_t * parser, uint16_t * usage_page, uint16_t * usage, int32_t * value){
 
     *usage_page = parser->usage_minimum >> 16;
@@ -382,30 +411,72 @@ void btstack_hid_parser_get_field(btstack_hid_parser_t * parser, uint16_t * usag
         *usage  = unsigned_value;
         *value  = 1;
     }
-    parser->required_usages--;
-    parser->report_pos_in_bit += parser->global_report_size;
+    btstack_hid_parser_next_field(parser, is_variable);
+}
 
-    // next usage
-    if (is_variable){
-        parser->usage_minimum++;
-        parser->available_usages--;
-    } else {
-        if (parser->required_usages == 0){
-            parser->available_usages = 0;
-        }
+int btstack_hid_compile_report(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, hid_report_type_t hid_report_type, uint8_t report_id, btstack_hid_field_t * fields, uint16_t max_fields){
+    // walk descriptor once, the report only needs to provide the Report ID
+    btstack_hid_parser_t parser;
+    btstack_hid_parser_init(&parser, hid_descriptor, hid_descriptor_len, hid_report_type, &report_id, 1);
+    uint16_t num_fields = 0;
+    while (btstack_hid_parser_has_more(&parser)){
+        if (num_fields >= max_fields) return -1;
+        btstack_hid_field_t * field = &fields[num_fields++];
+        int is_variable = parser.descriptor_item.item_value & 2;
+        field->report_pos_in_bit = parser.report_pos_in_bit;
+        field->report_size       = parser.global_report_size;
+        field->is_variable       = is_variable ? 1 : 0;
+        field->usage_page        = parser.usage_minimum >> 16;
+        field->usage             = is_variable ? (parser.usage_minimum & 0xffff) : 0;
+        field->logical_minimum   = parser.global_logical_minimum;
+        field->logical_maximum   = parser.global_logical_maximum;
+        btstack_hid_parser_next_field(&parser, is_variable);
     }
-    if (parser->available_usages) {
-        return;
+    return num_fields;
+}
+
+void btstack_hid_compiled_parser_init(btstack_hid_compiled_parser_t * parser, const btstack_hid_field_t * fields, uint16_t num_fields, const uint8_t * hid_report, uint16_t hid_report_len){
+    parser->fields      = fields;
+    parser->num_fields  = num_fields;
+    parser->field_index = 0;
+    parser->report      = hid_report;
+    parser->report_len  = hid_report_len;
+}
+
+int btstack_hid_compiled_parser_has_more(btstack_hid_compiled_parser_t * parser){
+    if (parser->field_index >= parser->num_fields) return 0;
+    // fields are sorted by position, stop at first field not contained in report
+    const btstack_hid_field_t * field = &parser->fields[parser->field_index];
+    return (field->report_pos_in_bit + field->report_size) <= (parser->report_len * 8);
+}
+
+void btstack_hid_compiled_parser_get_field(btstack_hid_compiled_parser_t * parser, uint16_t * usage_page, uint16_t * usage, int32_t * value){
+    const btstack_hid_field_t * field = &parser->fields[parser->field_index++];
+
+    *usage_page = field->usage_page;
+
+    // read field (up to 32 bit)
+    int pos_start     = field->report_pos_in_bit >> 3;
+    int pos_end       = (field->report_pos_in_bit + field->report_size - 1) >> 3;
+    int bytes_to_read = btstack_min(pos_end - pos_start + 1, 4);
+    int i;
+    uint32_t multi_byte_value = 0;
+    for (i=0;i < bytes_to_read;i++){
+        multi_byte_value |= ((uint32_t) parser->report[pos_start+i]) << (i*8);
     }
-    if (parser->required_usages == 0){
-        hid_post_process_item(parser, &parser->descriptor_item);
-        parser->state = BTSTACK_HID_PARSER_SCAN_FOR_REPORT_ITEM;
-        btstack_hid_parser_find_next_usage(parser);
-    } else {
-        hid_find_next_usage(parser);
-        if (parser->available_usages == 0) {
-            parser->state = BTSTACK_HID_PARSER_COMPLETE;
+    uint32_t mask = (field->report_size < 32) ? ((1u << field->report_size) - 1u) : 0xffffffffu;
+    uint32_t unsigned_value = (multi_byte_value >> (field->report_pos_in_bit & 0x07)) & mask;
+    if (field->is_variable){
+        *usage = field->usage;
+        if ((field->logical_minimum < 0) && (field->report_size > 0) && (unsigned_value & (1u << (field->report_size - 1)))){
+            // sign extend
+            *value = (int32_t) (unsigned_value | ~mask);
+        } else {
+            *value = (int32_t) unsigned_value;
         }
+    } else {
+        *usage = (uint16_t) unsigned_value;
+        *value = 1;
     }
 }
 
@@ -161,6 +161,25 @@ typedef struct {
     uint8_t         global_report_id;
 } btstack_hid_parser_t;
 
+// field of a report, created by btstack_hid_compile_report
+typedef struct {
+    uint16_t        report_pos_in_bit;  // position in report, incl. Report ID if declared
+    uint8_t         report_size;        // size in bits
+    uint8_t         is_variable;        // variable field: usage given by field, array field: value provides usage
+    uint16_t        usage_page;
+    uint16_t        usage;
+    int32_t         logical_minimum;
+    int32_t         logical_maximum;
+} btstack_hid_field_t;
+
+typedef struct {
+    const btstack_hid_field_t * fields;
+    uint16_t        num_fields;
+    uint16_t        field_index;
+    const uint8_t * report;
+    uint16_t        report_len;
+} btstack_hid_compiled_parser_t;
+
 /* API_START */
 
 /**
@@ -189,6 +208,44 @@ int  btstack_hid_parser_has_more(btstack_hid_parser_t * parser);
  */
 void btstack_hid_parser_get_field(btstack_hid_parser_t * parser, uint16_t * usage_page, uint16_t * usage, int32_t * value);
 
+/**
+ * @brief Compile fields of a report described by the HID Descriptor into a table, which can be used with
+ *        btstack_hid_compiled_parser_init to parse reports without walking the descriptor for each report
+ * @param hid_descriptor
+ * @param hid_descriptor_len
+ * @param hid_report_type
+ * @param report_id or 0 if descriptor does not declare Report IDs
+ * @param fields table to store fields
+ * @param max_fields number of entries in fields table
+ * @return number of fields stored or -1 if fields table is too small
+ */
+int btstack_hid_compile_report(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, hid_report_type_t hid_report_type, uint8_t report_id, btstack_hid_field_t * fields, uint16_t max_fields);
+
+/**
+ * @brief Initialize parser for compiled report fields
+ * @param parser state
+ * @param fields table created by btstack_hid_compile_report
+ * @param num_fields
+ * @param hid_report
+ * @param hid_report_len
+ */
+void btstack_hid_compiled_parser_init(btstack_hid_compiled_parser_t * parser, const btstack_hid_field_t * fields, uint16_t num_fields, const uint8_t * hid_report, uint16_t hid_report_len);
+
+/**
+ * @brief Checks if more fields are available in report
+ * @param parser
+ */
+int  btstack_hid_compiled_parser_has_more(btstack_hid_compiled_parser_t * parser);
+
+/**
+ * @brief Get next field, same as btstack_hid_parser_get_field
+ * @param parser
+ * @param usage_page
+ * @param usage
+ * @param value provided in HID report
+ */
+void btstack_hid_compiled_parser_get_field(btstack_hid_compiled_parser_t * parser, uint16_t * usage_page, uint16_t * usage, int32_t * value);
+
 /**
  * @brief Parses descriptor item
  * @param item
@@ -184,3 +184,126 @@ void btstack_linked_list_iterator_remove(btstack_linked_list_iterator_t * it){
     it->prev->next = it->curr;
     it->advance_on_next = 0;
 }
+
+
+//
+// Linked Queue implementation
+//
+
+bool btstack_linked_queue_empty(btstack_linked_queue_t * queue){
+    return queue->head == NULL;
+}
+
+bool btstack_linked_queue_enqueue(btstack_linked_queue_t * queue, btstack_linked_item_t * item){
+    // check if already in queue
+    btstack_linked_item_t * it;
+    for (it = queue->head; it != NULL; it = it->next){
+        if (it == item) {
+            return false;
+        }
+    }
+    item->next = NULL;
+    if (queue->head == NULL){
+        queue->head = item;
+    } else {
+        queue->tail->next = item;
+    }
+    queue->tail = item;
+    return true;
+}
+
+btstack_linked_item_t * btstack_linked_queue_dequeue(btstack_linked_queue_t * queue){
+    btstack_linked_item_t * item = queue->head;
+    if (item == NULL) return NULL;
+    queue->head = item->next;
+    if (queue->head == NULL){
+        queue->tail = NULL;
+    }
+    return item;
+}
+
+btstack_linked_item_t * btstack_linked_queue_first(btstack_linked_queue_t * queue){
+    return queue->head;
+}
+
+bool btstack_linked_queue_remove(btstack_linked_queue_t * queue, btstack_linked_item_t * item){
+    if (!item) return false;
+    btstack_linked_item_t * prev = NULL;
+    btstack_linked_item_t * it;
+    for (it = queue->head; it != NULL; it = it->next){
+        if (it == item){
+            if (prev == NULL){
+                queue->head = item->next;
+            } else {
+                prev->next = item->next;
+            }
+            if (queue->tail == item){
+                queue->tail = prev;
+            }
+            return true;
+        }
+        prev = it;
+    }
+    return false;
+}
+
+
+//
+// Doubly Linked List implementation
+//
+
+bool btstack_linked_dlist_empty(btstack_linked_dlist_t * list){
+    return list->head == NULL;
+}
+
+void btstack_linked_dlist_add(btstack_linked_dlist_t * list, btstack_linked_dlist_item_t * item){
+    item->prev = NULL;
+    item->next = list->head;
+    if (list->head == NULL){
+        list->tail = item;
+    } else {
+        list->head->prev = item;
+    }
+    list->head = item;
+}
+
+void btstack_linked_dlist_add_tail(btstack_linked_dlist_t * list, btstack_linked_dlist_item_t * item){
+    item->next = NULL;
+    item->prev = list->tail;
+    if (list->tail == NULL){
+        list->head = item;
+    } else {
+        list->tail->next = item;
+    }
+    list->tail = item;
+}
+
+void btstack_linked_dlist_remove(btstack_linked_dlist_t * list, btstack_linked_dlist_item_t * item){
+    if (item->prev == NULL){
+        list->head = item->next;
+    } else {
+        item->prev->next = item->next;
+    }
+    if (item->next == NULL){
+        list->tail = item->prev;
+    } else {
+        item->next->prev = item->prev;
+    }
+    item->next = NULL;
+    item->prev = NULL;
+}
+
+btstack_linked_dlist_item_t * btstack_linked_dlist_pop(btstack_linked_dlist_t * list){
+    btstack_linked_dlist_item_t * item = list->head;
+    if (item == NULL) return NULL;
+    btstack_linked_dlist_remove(list, item);
+    return item;
+}
+
+btstack_linked_dlist_item_t * btstack_linked_dlist_get_first_item(btstack_linked_dlist_t * list){
+    return list->head;
+}
+
+btstack_linked_dlist_item_t * btstack_linked_dlist_get_last_item(btstack_linked_dlist_t * list){
+    return list->tail;
+}
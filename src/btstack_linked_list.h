@@ -56,6 +56,23 @@ typedef struct btstack_linked_item {
 
 typedef btstack_linked_item_t * btstack_linked_list_t;
 
+// FIFO queue with O(1) dequeue and tail access, head can be iterated like a btstack_linked_list_t
+typedef struct {
+    btstack_linked_item_t * head;
+    btstack_linked_item_t * tail;
+} btstack_linked_queue_t;
+
+// intrusive doubly linked list with O(1) add, add tail, and remove
+typedef struct btstack_linked_dlist_item {
+    struct btstack_linked_dlist_item * next; // <-- next element in list, or NULL
+    struct btstack_linked_dlist_item * prev; // <-- previous element in list, or NULL
+} btstack_linked_dlist_item_t;
+
+typedef struct {
+    btstack_linked_dlist_item_t * head;
+    btstack_linked_dlist_item_t * tail;
+} btstack_linked_dlist_t;
+
 typedef struct {
 	int advance_on_next;
     btstack_linked_item_t * prev;	// points to the item before the current one
@@ -151,6 +168,94 @@ btstack_linked_item_t * btstack_linked_list_iterator_next(btstack_linked_list_it
  */
 void btstack_linked_list_iterator_remove(btstack_linked_list_iterator_t * it);
 
+
+/**
+ * @brief Test if queue is empty.
+ * @param queue
+ * @returns true if queue is empty
+ */
+bool btstack_linked_queue_empty(btstack_linked_queue_t * queue);
+
+/**
+ * @brief Add item to queue as last element
+ * @param queue
+ * @param item
+ * @returns true if item was added, false if item is already in queue
+ */
+bool btstack_linked_queue_enqueue(btstack_linked_queue_t * queue, btstack_linked_item_t * item);
+
+/**
+ * @brief Pop (get + remove) first element.
+ * @param queue
+ * @returns first element or NULL if queue is empty
+ */
+btstack_linked_item_t * btstack_linked_queue_dequeue(btstack_linked_queue_t * queue);
+
+/**
+ * @brief Get first element.
+ * @param queue
+ * @returns first element or NULL if queue is empty
+ */
+btstack_linked_item_t * btstack_linked_queue_first(btstack_linked_queue_t * queue);
+
+/**
+ * @brief Remove item from queue
+ * @param queue
+ * @param item
+ * @returns true if item was removed, false if it is not in queue
+ */
+bool btstack_linked_queue_remove(btstack_linked_queue_t * queue, btstack_linked_item_t * item);
+
+
+/**
+ * @brief Test if doubly linked list is empty.
+ * @param list
+ * @returns true if list is empty
+ */
+bool btstack_linked_dlist_empty(btstack_linked_dlist_t * list);
+
+/**
+ * @brief Add item to doubly linked list as first element. Item must not be in list already.
+ * @param list
+ * @param item
+ */
+void btstack_linked_dlist_add(btstack_linked_dlist_t * list, btstack_linked_dlist_item_t * item);
+
+/**
+ * @brief Add item to doubly linked list as last element. Item must not be in list already.
+ * @param list
+ * @param item
+ */
+void btstack_linked_dlist_add_tail(btstack_linked_dlist_t * list, btstack_linked_dlist_item_t * item);
+
+/**
+ * @brief Remove item from doubly linked list. Item must be in list.
+ * @param list
+ * @param item
+ */
+void btstack_linked_dlist_remove(btstack_linked_dlist_t * list, btstack_linked_dlist_item_t * item);
+
+/**
+ * @brief Pop (get + remove) first element.
+ * @param list
+ * @returns first element or NULL if list is empty
+ */
+btstack_linked_dlist_item_t * btstack_linked_dlist_pop(btstack_linked_dlist_t * list);
+
+/**
+ * @brief Get first element.
+ * @param list
+ * @returns first element or NULL if list is empty
+ */
+btstack_linked_dlist_item_t * btstack_linked_dlist_get_first_item(btstack_linked_dlist_t * list);
+
+/**
+ * @brief Get last element.
+ * @param list
+ * @returns last element or NULL if list is empty
+ */
+btstack_linked_dlist_item_t * btstack_linked_dlist_get_last_item(btstack_linked_dlist_t * list);
+
 /* API_END */
 
 void test_linked_list(void);
@@ -50,12 +50,144 @@
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
 #include <stdlib.h>
 
+#ifdef ENABLE_BTSTACK_MEMORY_STATISTICS
+static void btstack_memory_track_get(btstack_memory_statistics_t * statistics, const void * buffer){
+    if (buffer == NULL){
+        statistics->failures++;
+        return;
+    }
+    statistics->in_use++;
+    if (statistics->in_use > statistics->peak){
+        statistics->peak = statistics->in_use;
+    }
+}
+static void btstack_memory_track_free(btstack_memory_statistics_t * statistics, const void * buffer){
+    if (buffer == NULL) return;
+    if (statistics->in_use == 0) return;
+    statistics->in_use--;
+}
+#define BTSTACK_MEMORY_STATISTICS(name, pool_size) static btstack_memory_statistics_t name##_statistics = { #name, pool_size, 0, 0, 0 };
+#define BTSTACK_MEMORY_TRACK_GET(name, buffer)     btstack_memory_track_get(&name##_statistics, buffer)
+#define BTSTACK_MEMORY_TRACK_FREE(name, buffer)    btstack_memory_track_free(&name##_statistics, buffer)
+#else
+#define BTSTACK_MEMORY_STATISTICS(name, pool_size)
+#define BTSTACK_MEMORY_TRACK_GET(name, buffer)     (void)(buffer)
+#define BTSTACK_MEMORY_TRACK_FREE(name, buffer)    (void)(buffer)
+#endif
+
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+// Single static arena shared by all types. Blocks are carved from the arena on demand
+// and returned to a free list per size class, which makes get and free O(1).
+// Size classes are multiples of 8 with 4 classes per power of two, e.g. 40, 48, 56, 64, 80, ...
+// MAX_NR_* are optional caps per type
+#ifndef BTSTACK_MEMORY_ARENA_SIZE
+#error "ENABLE_BTSTACK_MEMORY_ARENA requires BTSTACK_MEMORY_ARENA_SIZE in btstack_config.h"
+#endif
+
+#define BTSTACK_MEMORY_ARENA_UNLIMITED        0xffff
+#define BTSTACK_MEMORY_ARENA_NUM_SIZE_CLASSES 48
+#define BTSTACK_MEMORY_ARENA_INVALID_CLASS    0xff
+
+typedef struct btstack_memory_arena_block {
+    struct btstack_memory_arena_block * next;
+} btstack_memory_arena_block_t;
+
+typedef struct {
+    uint32_t item_size;
+    uint32_t block_size;
+    uint16_t max_items;
+    uint16_t num_items;
+    uint8_t  size_class;
+} btstack_memory_arena_type_t;
+
+static union {
+    uint64_t alignment;
+    uint8_t  data[BTSTACK_MEMORY_ARENA_SIZE];
+} btstack_memory_arena_storage;
+static uint32_t btstack_memory_arena_used;
+static btstack_memory_arena_block_t * btstack_memory_arena_free_lists[BTSTACK_MEMORY_ARENA_NUM_SIZE_CLASSES];
+
+static uint32_t btstack_memory_arena_class_size(uint8_t size_class){
+    if (size_class < 4){
+        return (size_class + 1u) * 8u;
+    }
+    uint8_t octave = (size_class - 4u) / 4u;
+    uint8_t step   = (size_class - 4u) % 4u;
+    return (32u << octave) + (step + 1u) * (8u << octave);
+}
+
+static void btstack_memory_arena_init(void){
+    btstack_memory_arena_used = 0;
+    memset(btstack_memory_arena_free_lists, 0, sizeof(btstack_memory_arena_free_lists));
+}
+
+static void btstack_memory_arena_type_init(btstack_memory_arena_type_t * type){
+    type->num_items  = 0;
+    type->size_class = BTSTACK_MEMORY_ARENA_INVALID_CLASS;
+    type->block_size = 0;
+    uint8_t size_class;
+    for (size_class = 0; size_class < BTSTACK_MEMORY_ARENA_NUM_SIZE_CLASSES; size_class++){
+        uint32_t block_size = btstack_memory_arena_class_size(size_class);
+        if (block_size >= type->item_size){
+            type->size_class = size_class;
+            type->block_size = block_size;
+            return;
+        }
+    }
+    log_error("item size %u exceeds largest arena size class", (unsigned int) type->item_size);
+}
+
+static void * btstack_memory_arena_get(btstack_memory_arena_type_t * type){
+    if (type->num_items >= type->max_items) return NULL;
+    if (type->size_class == BTSTACK_MEMORY_ARENA_INVALID_CLASS) return NULL;
+    btstack_memory_arena_block_t * block = btstack_memory_arena_free_lists[type->size_class];
+    if (block != NULL){
+        btstack_memory_arena_free_lists[type->size_class] = block->next;
+    } else {
+        if (type->block_size > (BTSTACK_MEMORY_ARENA_SIZE - btstack_memory_arena_used)) return NULL;
+        block = (btstack_memory_arena_block_t *) &btstack_memory_arena_storage.data[btstack_memory_arena_used];
+        btstack_memory_arena_used += type->block_size;
+    }
+    type->num_items++;
+    memset(block, 0, type->item_size);
+    return block;
+}
+
+static void btstack_memory_arena_free(btstack_memory_arena_type_t * type, void * buffer){
+    if (buffer == NULL) return;
+    btstack_memory_arena_block_t * block = (btstack_memory_arena_block_t *) buffer;
+    block->next = btstack_memory_arena_free_lists[type->size_class];
+    btstack_memory_arena_free_lists[type->size_class] = block;
+    type->num_items--;
+}
+#endif
+
 
 
 // MARK: hci_connection_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_HCI_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(hci_connection, MAX_NR_HCI_CONNECTIONS)
+static btstack_memory_arena_type_t hci_connection_arena_type = { sizeof(hci_connection_t), 0, MAX_NR_HCI_CONNECTIONS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(hci_connection, 0)
+static btstack_memory_arena_type_t hci_connection_arena_type = { sizeof(hci_connection_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+hci_connection_t * btstack_memory_hci_connection_get(void){
+    void * buffer = btstack_memory_arena_get(&hci_connection_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(hci_connection, buffer);
+    return (hci_connection_t *) buffer;
+}
+void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    BTSTACK_MEMORY_TRACK_FREE(hci_connection, hci_connection);
+    btstack_memory_arena_free(&hci_connection_arena_type, hci_connection);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_HCI_CONNECTIONS)
     #if defined(MAX_NO_HCI_CONNECTIONS)
         #error "Deprecated MAX_NO_HCI_CONNECTIONS defined instead of MAX_NR_HCI_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_HCI_CONNECTIONS."
@@ -65,6 +197,7 @@
 #endif
 
 #ifdef MAX_NR_HCI_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(hci_connection, MAX_NR_HCI_CONNECTIONS)
 #if MAX_NR_HCI_CONNECTIONS > 0
 static hci_connection_t hci_connection_storage[MAX_NR_HCI_CONNECTIONS];
 static btstack_memory_pool_t hci_connection_pool;
@@ -73,13 +206,16 @@ hci_connection_t * btstack_memory_hci_connection_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(hci_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(hci_connection, buffer);
     return (hci_connection_t *) buffer;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    BTSTACK_MEMORY_TRACK_FREE(hci_connection, hci_connection);
     btstack_memory_pool_free(&hci_connection_pool, hci_connection);
 }
 #else
 hci_connection_t * btstack_memory_hci_connection_get(void){
+    BTSTACK_MEMORY_TRACK_GET(hci_connection, NULL);
     return NULL;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
@@ -88,21 +224,45 @@ void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(hci_connection, 0)
 hci_connection_t * btstack_memory_hci_connection_get(void){
     void * buffer = malloc(sizeof(hci_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(hci_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(hci_connection, buffer);
     return (hci_connection_t *) buffer;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    BTSTACK_MEMORY_TRACK_FREE(hci_connection, hci_connection);
     free(hci_connection);
 }
 #endif
 
+#endif
+
 
 
 // MARK: l2cap_service_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_L2CAP_SERVICES
+BTSTACK_MEMORY_STATISTICS(l2cap_service, MAX_NR_L2CAP_SERVICES)
+static btstack_memory_arena_type_t l2cap_service_arena_type = { sizeof(l2cap_service_t), 0, MAX_NR_L2CAP_SERVICES, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(l2cap_service, 0)
+static btstack_memory_arena_type_t l2cap_service_arena_type = { sizeof(l2cap_service_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    void * buffer = btstack_memory_arena_get(&l2cap_service_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(l2cap_service, buffer);
+    return (l2cap_service_t *) buffer;
+}
+void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    BTSTACK_MEMORY_TRACK_FREE(l2cap_service, l2cap_service);
+    btstack_memory_arena_free(&l2cap_service_arena_type, l2cap_service);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_L2CAP_SERVICES)
     #if defined(MAX_NO_L2CAP_SERVICES)
         #error "Deprecated MAX_NO_L2CAP_SERVICES defined instead of MAX_NR_L2CAP_SERVICES. Please update your btstack_config.h to use MAX_NR_L2CAP_SERVICES."
@@ -112,6 +272,7 @@ void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
 #endif
 
 #ifdef MAX_NR_L2CAP_SERVICES
+BTSTACK_MEMORY_STATISTICS(l2cap_service, MAX_NR_L2CAP_SERVICES)
 #if MAX_NR_L2CAP_SERVICES > 0
 static l2cap_service_t l2cap_service_storage[MAX_NR_L2CAP_SERVICES];
 static btstack_memory_pool_t l2cap_service_pool;
@@ -120,13 +281,16 @@ l2cap_service_t * btstack_memory_l2cap_service_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_service_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(l2cap_service, buffer);
     return (l2cap_service_t *) buffer;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    BTSTACK_MEMORY_TRACK_FREE(l2cap_service, l2cap_service);
     btstack_memory_pool_free(&l2cap_service_pool, l2cap_service);
 }
 #else
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    BTSTACK_MEMORY_TRACK_GET(l2cap_service, NULL);
     return NULL;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
@@ -135,20 +299,44 @@ void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(l2cap_service, 0)
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
     void * buffer = malloc(sizeof(l2cap_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_service_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(l2cap_service, buffer);
     return (l2cap_service_t *) buffer;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    BTSTACK_MEMORY_TRACK_FREE(l2cap_service, l2cap_service);
     free(l2cap_service);
 }
 #endif
 
+#endif
+
 
 // MARK: l2cap_channel_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_L2CAP_CHANNELS
+BTSTACK_MEMORY_STATISTICS(l2cap_channel, MAX_NR_L2CAP_CHANNELS)
+static btstack_memory_arena_type_t l2cap_channel_arena_type = { sizeof(l2cap_channel_t), 0, MAX_NR_L2CAP_CHANNELS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(l2cap_channel, 0)
+static btstack_memory_arena_type_t l2cap_channel_arena_type = { sizeof(l2cap_channel_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    void * buffer = btstack_memory_arena_get(&l2cap_channel_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(l2cap_channel, buffer);
+    return (l2cap_channel_t *) buffer;
+}
+void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    BTSTACK_MEMORY_TRACK_FREE(l2cap_channel, l2cap_channel);
+    btstack_memory_arena_free(&l2cap_channel_arena_type, l2cap_channel);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_L2CAP_CHANNELS)
     #if defined(MAX_NO_L2CAP_CHANNELS)
         #error "Deprecated MAX_NO_L2CAP_CHANNELS defined instead of MAX_NR_L2CAP_CHANNELS. Please update your btstack_config.h to use MAX_NR_L2CAP_CHANNELS."
@@ -158,6 +346,7 @@ void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
 #endif
 
 #ifdef MAX_NR_L2CAP_CHANNELS
+BTSTACK_MEMORY_STATISTICS(l2cap_channel, MAX_NR_L2CAP_CHANNELS)
 #if MAX_NR_L2CAP_CHANNELS > 0
 static l2cap_channel_t l2cap_channel_storage[MAX_NR_L2CAP_CHANNELS];
 static btstack_memory_pool_t l2cap_channel_pool;
@@ -166,13 +355,16 @@ l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_channel_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(l2cap_channel, buffer);
     return (l2cap_channel_t *) buffer;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    BTSTACK_MEMORY_TRACK_FREE(l2cap_channel, l2cap_channel);
     btstack_memory_pool_free(&l2cap_channel_pool, l2cap_channel);
 }
 #else
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    BTSTACK_MEMORY_TRACK_GET(l2cap_channel, NULL);
     return NULL;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
@@ -181,22 +373,46 @@ void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(l2cap_channel, 0)
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
     void * buffer = malloc(sizeof(l2cap_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(l2cap_channel_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(l2cap_channel, buffer);
     return (l2cap_channel_t *) buffer;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    BTSTACK_MEMORY_TRACK_FREE(l2cap_channel, l2cap_channel);
     free(l2cap_channel);
 }
 #endif
 
+#endif
+
 
 #ifdef ENABLE_CLASSIC
 
 // MARK: rfcomm_multiplexer_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_RFCOMM_MULTIPLEXERS
+BTSTACK_MEMORY_STATISTICS(rfcomm_multiplexer, MAX_NR_RFCOMM_MULTIPLEXERS)
+static btstack_memory_arena_type_t rfcomm_multiplexer_arena_type = { sizeof(rfcomm_multiplexer_t), 0, MAX_NR_RFCOMM_MULTIPLEXERS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(rfcomm_multiplexer, 0)
+static btstack_memory_arena_type_t rfcomm_multiplexer_arena_type = { sizeof(rfcomm_multiplexer_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    void * buffer = btstack_memory_arena_get(&rfcomm_multiplexer_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_multiplexer, buffer);
+    return (rfcomm_multiplexer_t *) buffer;
+}
+void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_multiplexer, rfcomm_multiplexer);
+    btstack_memory_arena_free(&rfcomm_multiplexer_arena_type, rfcomm_multiplexer);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_RFCOMM_MULTIPLEXERS)
     #if defined(MAX_NO_RFCOMM_MULTIPLEXERS)
         #error "Deprecated MAX_NO_RFCOMM_MULTIPLEXERS defined instead of MAX_NR_RFCOMM_MULTIPLEXERS. Please update your btstack_config.h to use MAX_NR_RFCOMM_MULTIPLEXERS."
@@ -206,6 +422,7 @@ void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
 #endif
 
 #ifdef MAX_NR_RFCOMM_MULTIPLEXERS
+BTSTACK_MEMORY_STATISTICS(rfcomm_multiplexer, MAX_NR_RFCOMM_MULTIPLEXERS)
 #if MAX_NR_RFCOMM_MULTIPLEXERS > 0
 static rfcomm_multiplexer_t rfcomm_multiplexer_storage[MAX_NR_RFCOMM_MULTIPLEXERS];
 static btstack_memory_pool_t rfcomm_multiplexer_pool;
@@ -214,13 +431,16 @@ rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_multiplexer_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_multiplexer, buffer);
     return (rfcomm_multiplexer_t *) buffer;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_multiplexer, rfcomm_multiplexer);
     btstack_memory_pool_free(&rfcomm_multiplexer_pool, rfcomm_multiplexer);
 }
 #else
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_multiplexer, NULL);
     return NULL;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
@@ -229,20 +449,44 @@ void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multipl
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(rfcomm_multiplexer, 0)
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
     void * buffer = malloc(sizeof(rfcomm_multiplexer_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_multiplexer_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_multiplexer, buffer);
     return (rfcomm_multiplexer_t *) buffer;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_multiplexer, rfcomm_multiplexer);
     free(rfcomm_multiplexer);
 }
 #endif
 
+#endif
+
 
 // MARK: rfcomm_service_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_RFCOMM_SERVICES
+BTSTACK_MEMORY_STATISTICS(rfcomm_service, MAX_NR_RFCOMM_SERVICES)
+static btstack_memory_arena_type_t rfcomm_service_arena_type = { sizeof(rfcomm_service_t), 0, MAX_NR_RFCOMM_SERVICES, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(rfcomm_service, 0)
+static btstack_memory_arena_type_t rfcomm_service_arena_type = { sizeof(rfcomm_service_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    void * buffer = btstack_memory_arena_get(&rfcomm_service_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_service, buffer);
+    return (rfcomm_service_t *) buffer;
+}
+void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_service, rfcomm_service);
+    btstack_memory_arena_free(&rfcomm_service_arena_type, rfcomm_service);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_RFCOMM_SERVICES)
     #if defined(MAX_NO_RFCOMM_SERVICES)
         #error "Deprecated MAX_NO_RFCOMM_SERVICES defined instead of MAX_NR_RFCOMM_SERVICES. Please update your btstack_config.h to use MAX_NR_RFCOMM_SERVICES."
@@ -252,6 +496,7 @@ void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multipl
 #endif
 
 #ifdef MAX_NR_RFCOMM_SERVICES
+BTSTACK_MEMORY_STATISTICS(rfcomm_service, MAX_NR_RFCOMM_SERVICES)
 #if MAX_NR_RFCOMM_SERVICES > 0
 static rfcomm_service_t rfcomm_service_storage[MAX_NR_RFCOMM_SERVICES];
 static btstack_memory_pool_t rfcomm_service_pool;
@@ -260,13 +505,16 @@ rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_service_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_service, buffer);
     return (rfcomm_service_t *) buffer;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_service, rfcomm_service);
     btstack_memory_pool_free(&rfcomm_service_pool, rfcomm_service);
 }
 #else
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_service, NULL);
     return NULL;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
@@ -275,20 +523,44 @@ void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(rfcomm_service, 0)
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
     void * buffer = malloc(sizeof(rfcomm_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_service_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_service, buffer);
     return (rfcomm_service_t *) buffer;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_service, rfcomm_service);
     free(rfcomm_service);
 }
 #endif
 
+#endif
+
 
 // MARK: rfcomm_channel_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_RFCOMM_CHANNELS
+BTSTACK_MEMORY_STATISTICS(rfcomm_channel, MAX_NR_RFCOMM_CHANNELS)
+static btstack_memory_arena_type_t rfcomm_channel_arena_type = { sizeof(rfcomm_channel_t), 0, MAX_NR_RFCOMM_CHANNELS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(rfcomm_channel, 0)
+static btstack_memory_arena_type_t rfcomm_channel_arena_type = { sizeof(rfcomm_channel_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    void * buffer = btstack_memory_arena_get(&rfcomm_channel_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_channel, buffer);
+    return (rfcomm_channel_t *) buffer;
+}
+void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_channel, rfcomm_channel);
+    btstack_memory_arena_free(&rfcomm_channel_arena_type, rfcomm_channel);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_RFCOMM_CHANNELS)
     #if defined(MAX_NO_RFCOMM_CHANNELS)
         #error "Deprecated MAX_NO_RFCOMM_CHANNELS defined instead of MAX_NR_RFCOMM_CHANNELS. Please update your btstack_config.h to use MAX_NR_RFCOMM_CHANNELS."
@@ -298,6 +570,7 @@ void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
 #endif
 
 #ifdef MAX_NR_RFCOMM_CHANNELS
+BTSTACK_MEMORY_STATISTICS(rfcomm_channel, MAX_NR_RFCOMM_CHANNELS)
 #if MAX_NR_RFCOMM_CHANNELS > 0
 static rfcomm_channel_t rfcomm_channel_storage[MAX_NR_RFCOMM_CHANNELS];
 static btstack_memory_pool_t rfcomm_channel_pool;
@@ -306,13 +579,16 @@ rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_channel_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_channel, buffer);
     return (rfcomm_channel_t *) buffer;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_channel, rfcomm_channel);
     btstack_memory_pool_free(&rfcomm_channel_pool, rfcomm_channel);
 }
 #else
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_channel, NULL);
     return NULL;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
@@ -321,21 +597,45 @@ void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(rfcomm_channel, 0)
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
     void * buffer = malloc(sizeof(rfcomm_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(rfcomm_channel_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(rfcomm_channel, buffer);
     return (rfcomm_channel_t *) buffer;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    BTSTACK_MEMORY_TRACK_FREE(rfcomm_channel, rfcomm_channel);
     free(rfcomm_channel);
 }
 #endif
 
+#endif
+
 
 
 // MARK: btstack_link_key_db_memory_entry_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES
+BTSTACK_MEMORY_STATISTICS(btstack_link_key_db_memory_entry, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
+static btstack_memory_arena_type_t btstack_link_key_db_memory_entry_arena_type = { sizeof(btstack_link_key_db_memory_entry_t), 0, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(btstack_link_key_db_memory_entry, 0)
+static btstack_memory_arena_type_t btstack_link_key_db_memory_entry_arena_type = { sizeof(btstack_link_key_db_memory_entry_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    void * buffer = btstack_memory_arena_get(&btstack_link_key_db_memory_entry_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(btstack_link_key_db_memory_entry, buffer);
+    return (btstack_link_key_db_memory_entry_t *) buffer;
+}
+void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    BTSTACK_MEMORY_TRACK_FREE(btstack_link_key_db_memory_entry, btstack_link_key_db_memory_entry);
+    btstack_memory_arena_free(&btstack_link_key_db_memory_entry_arena_type, btstack_link_key_db_memory_entry);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
     #if defined(MAX_NO_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
         #error "Deprecated MAX_NO_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES defined instead of MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES. Please update your btstack_config.h to use MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES."
@@ -345,6 +645,7 @@ void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
 #endif
 
 #ifdef MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES
+BTSTACK_MEMORY_STATISTICS(btstack_link_key_db_memory_entry, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES)
 #if MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
 static btstack_link_key_db_memory_entry_t btstack_link_key_db_memory_entry_storage[MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES];
 static btstack_memory_pool_t btstack_link_key_db_memory_entry_pool;
@@ -353,13 +654,16 @@ btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_e
     if (buffer){
         memset(buffer, 0, sizeof(btstack_link_key_db_memory_entry_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(btstack_link_key_db_memory_entry, buffer);
     return (btstack_link_key_db_memory_entry_t *) buffer;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    BTSTACK_MEMORY_TRACK_FREE(btstack_link_key_db_memory_entry, btstack_link_key_db_memory_entry);
     btstack_memory_pool_free(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry);
 }
 #else
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    BTSTACK_MEMORY_TRACK_GET(btstack_link_key_db_memory_entry, NULL);
     return NULL;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
@@ -368,21 +672,45 @@ void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_me
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(btstack_link_key_db_memory_entry, 0)
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
     void * buffer = malloc(sizeof(btstack_link_key_db_memory_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(btstack_link_key_db_memory_entry_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(btstack_link_key_db_memory_entry, buffer);
     return (btstack_link_key_db_memory_entry_t *) buffer;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    BTSTACK_MEMORY_TRACK_FREE(btstack_link_key_db_memory_entry, btstack_link_key_db_memory_entry);
     free(btstack_link_key_db_memory_entry);
 }
 #endif
 
+#endif
+
 
 
 // MARK: bnep_service_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_BNEP_SERVICES
+BTSTACK_MEMORY_STATISTICS(bnep_service, MAX_NR_BNEP_SERVICES)
+static btstack_memory_arena_type_t bnep_service_arena_type = { sizeof(bnep_service_t), 0, MAX_NR_BNEP_SERVICES, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(bnep_service, 0)
+static btstack_memory_arena_type_t bnep_service_arena_type = { sizeof(bnep_service_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+bnep_service_t * btstack_memory_bnep_service_get(void){
+    void * buffer = btstack_memory_arena_get(&bnep_service_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(bnep_service, buffer);
+    return (bnep_service_t *) buffer;
+}
+void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    BTSTACK_MEMORY_TRACK_FREE(bnep_service, bnep_service);
+    btstack_memory_arena_free(&bnep_service_arena_type, bnep_service);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_BNEP_SERVICES)
     #if defined(MAX_NO_BNEP_SERVICES)
         #error "Deprecated MAX_NO_BNEP_SERVICES defined instead of MAX_NR_BNEP_SERVICES. Please update your btstack_config.h to use MAX_NR_BNEP_SERVICES."
@@ -392,6 +720,7 @@ void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_me
 #endif
 
 #ifdef MAX_NR_BNEP_SERVICES
+BTSTACK_MEMORY_STATISTICS(bnep_service, MAX_NR_BNEP_SERVICES)
 #if MAX_NR_BNEP_SERVICES > 0
 static bnep_service_t bnep_service_storage[MAX_NR_BNEP_SERVICES];
 static btstack_memory_pool_t bnep_service_pool;
@@ -400,13 +729,16 @@ bnep_service_t * btstack_memory_bnep_service_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(bnep_service_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(bnep_service, buffer);
     return (bnep_service_t *) buffer;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    BTSTACK_MEMORY_TRACK_FREE(bnep_service, bnep_service);
     btstack_memory_pool_free(&bnep_service_pool, bnep_service);
 }
 #else
 bnep_service_t * btstack_memory_bnep_service_get(void){
+    BTSTACK_MEMORY_TRACK_GET(bnep_service, NULL);
     return NULL;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
@@ -415,20 +747,44 @@ void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(bnep_service, 0)
 bnep_service_t * btstack_memory_bnep_service_get(void){
     void * buffer = malloc(sizeof(bnep_service_t));
     if (buffer){
         memset(buffer, 0, sizeof(bnep_service_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(bnep_service, buffer);
     return (bnep_service_t *) buffer;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    BTSTACK_MEMORY_TRACK_FREE(bnep_service, bnep_service);
     free(bnep_service);
 }
 #endif
 
+#endif
+
 
 // MARK: bnep_channel_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_BNEP_CHANNELS
+BTSTACK_MEMORY_STATISTICS(bnep_channel, MAX_NR_BNEP_CHANNELS)
+static btstack_memory_arena_type_t bnep_channel_arena_type = { sizeof(bnep_channel_t), 0, MAX_NR_BNEP_CHANNELS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(bnep_channel, 0)
+static btstack_memory_arena_type_t bnep_channel_arena_type = { sizeof(bnep_channel_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    void * buffer = btstack_memory_arena_get(&bnep_channel_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(bnep_channel, buffer);
+    return (bnep_channel_t *) buffer;
+}
+void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    BTSTACK_MEMORY_TRACK_FREE(bnep_channel, bnep_channel);
+    btstack_memory_arena_free(&bnep_channel_arena_type, bnep_channel);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_BNEP_CHANNELS)
     #if defined(MAX_NO_BNEP_CHANNELS)
         #error "Deprecated MAX_NO_BNEP_CHANNELS defined instead of MAX_NR_BNEP_CHANNELS. Please update your btstack_config.h to use MAX_NR_BNEP_CHANNELS."
@@ -438,6 +794,7 @@ void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
 #endif
 
 #ifdef MAX_NR_BNEP_CHANNELS
+BTSTACK_MEMORY_STATISTICS(bnep_channel, MAX_NR_BNEP_CHANNELS)
 #if MAX_NR_BNEP_CHANNELS > 0
 static bnep_channel_t bnep_channel_storage[MAX_NR_BNEP_CHANNELS];
 static btstack_memory_pool_t bnep_channel_pool;
@@ -446,13 +803,16 @@ bnep_channel_t * btstack_memory_bnep_channel_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(bnep_channel_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(bnep_channel, buffer);
     return (bnep_channel_t *) buffer;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    BTSTACK_MEMORY_TRACK_FREE(bnep_channel, bnep_channel);
     btstack_memory_pool_free(&bnep_channel_pool, bnep_channel);
 }
 #else
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    BTSTACK_MEMORY_TRACK_GET(bnep_channel, NULL);
     return NULL;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
@@ -461,21 +821,45 @@ void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(bnep_channel, 0)
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
     void * buffer = malloc(sizeof(bnep_channel_t));
     if (buffer){
         memset(buffer, 0, sizeof(bnep_channel_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(bnep_channel, buffer);
     return (bnep_channel_t *) buffer;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    BTSTACK_MEMORY_TRACK_FREE(bnep_channel, bnep_channel);
     free(bnep_channel);
 }
 #endif
 
+#endif
+
 
 
 // MARK: hfp_connection_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_HFP_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(hfp_connection, MAX_NR_HFP_CONNECTIONS)
+static btstack_memory_arena_type_t hfp_connection_arena_type = { sizeof(hfp_connection_t), 0, MAX_NR_HFP_CONNECTIONS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(hfp_connection, 0)
+static btstack_memory_arena_type_t hfp_connection_arena_type = { sizeof(hfp_connection_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    void * buffer = btstack_memory_arena_get(&hfp_connection_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(hfp_connection, buffer);
+    return (hfp_connection_t *) buffer;
+}
+void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(hfp_connection, hfp_connection);
+    btstack_memory_arena_free(&hfp_connection_arena_type, hfp_connection);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_HFP_CONNECTIONS)
     #if defined(MAX_NO_HFP_CONNECTIONS)
         #error "Deprecated MAX_NO_HFP_CONNECTIONS defined instead of MAX_NR_HFP_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_HFP_CONNECTIONS."
@@ -485,6 +869,7 @@ void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
 #endif
 
 #ifdef MAX_NR_HFP_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(hfp_connection, MAX_NR_HFP_CONNECTIONS)
 #if MAX_NR_HFP_CONNECTIONS > 0
 static hfp_connection_t hfp_connection_storage[MAX_NR_HFP_CONNECTIONS];
 static btstack_memory_pool_t hfp_connection_pool;
@@ -493,13 +878,16 @@ hfp_connection_t * btstack_memory_hfp_connection_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(hfp_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(hfp_connection, buffer);
     return (hfp_connection_t *) buffer;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(hfp_connection, hfp_connection);
     btstack_memory_pool_free(&hfp_connection_pool, hfp_connection);
 }
 #else
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    BTSTACK_MEMORY_TRACK_GET(hfp_connection, NULL);
     return NULL;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
@@ -508,21 +896,45 @@ void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(hfp_connection, 0)
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
     void * buffer = malloc(sizeof(hfp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(hfp_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(hfp_connection, buffer);
     return (hfp_connection_t *) buffer;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(hfp_connection, hfp_connection);
     free(hfp_connection);
 }
 #endif
 
+#endif
+
 
 
 // MARK: service_record_item_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_SERVICE_RECORD_ITEMS
+BTSTACK_MEMORY_STATISTICS(service_record_item, MAX_NR_SERVICE_RECORD_ITEMS)
+static btstack_memory_arena_type_t service_record_item_arena_type = { sizeof(service_record_item_t), 0, MAX_NR_SERVICE_RECORD_ITEMS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(service_record_item, 0)
+static btstack_memory_arena_type_t service_record_item_arena_type = { sizeof(service_record_item_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+service_record_item_t * btstack_memory_service_record_item_get(void){
+    void * buffer = btstack_memory_arena_get(&service_record_item_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(service_record_item, buffer);
+    return (service_record_item_t *) buffer;
+}
+void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    BTSTACK_MEMORY_TRACK_FREE(service_record_item, service_record_item);
+    btstack_memory_arena_free(&service_record_item_arena_type, service_record_item);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_SERVICE_RECORD_ITEMS)
     #if defined(MAX_NO_SERVICE_RECORD_ITEMS)
         #error "Deprecated MAX_NO_SERVICE_RECORD_ITEMS defined instead of MAX_NR_SERVICE_RECORD_ITEMS. Please update your btstack_config.h to use MAX_NR_SERVICE_RECORD_ITEMS."
@@ -532,6 +944,7 @@ void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
 #endif
 
 #ifdef MAX_NR_SERVICE_RECORD_ITEMS
+BTSTACK_MEMORY_STATISTICS(service_record_item, MAX_NR_SERVICE_RECORD_ITEMS)
 #if MAX_NR_SERVICE_RECORD_ITEMS > 0
 static service_record_item_t service_record_item_storage[MAX_NR_SERVICE_RECORD_ITEMS];
 static btstack_memory_pool_t service_record_item_pool;
@@ -540,13 +953,16 @@ service_record_item_t * btstack_memory_service_record_item_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(service_record_item_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(service_record_item, buffer);
     return (service_record_item_t *) buffer;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    BTSTACK_MEMORY_TRACK_FREE(service_record_item, service_record_item);
     btstack_memory_pool_free(&service_record_item_pool, service_record_item);
 }
 #else
 service_record_item_t * btstack_memory_service_record_item_get(void){
+    BTSTACK_MEMORY_TRACK_GET(service_record_item, NULL);
     return NULL;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
@@ -555,21 +971,45 @@ void btstack_memory_service_record_item_free(service_record_item_t *service_reco
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(service_record_item, 0)
 service_record_item_t * btstack_memory_service_record_item_get(void){
     void * buffer = malloc(sizeof(service_record_item_t));
     if (buffer){
         memset(buffer, 0, sizeof(service_record_item_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(service_record_item, buffer);
     return (service_record_item_t *) buffer;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    BTSTACK_MEMORY_TRACK_FREE(service_record_item, service_record_item);
     free(service_record_item);
 }
 #endif
 
+#endif
+
 
 
 // MARK: avdtp_stream_endpoint_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_AVDTP_STREAM_ENDPOINTS
+BTSTACK_MEMORY_STATISTICS(avdtp_stream_endpoint, MAX_NR_AVDTP_STREAM_ENDPOINTS)
+static btstack_memory_arena_type_t avdtp_stream_endpoint_arena_type = { sizeof(avdtp_stream_endpoint_t), 0, MAX_NR_AVDTP_STREAM_ENDPOINTS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(avdtp_stream_endpoint, 0)
+static btstack_memory_arena_type_t avdtp_stream_endpoint_arena_type = { sizeof(avdtp_stream_endpoint_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    void * buffer = btstack_memory_arena_get(&avdtp_stream_endpoint_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(avdtp_stream_endpoint, buffer);
+    return (avdtp_stream_endpoint_t *) buffer;
+}
+void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    BTSTACK_MEMORY_TRACK_FREE(avdtp_stream_endpoint, avdtp_stream_endpoint);
+    btstack_memory_arena_free(&avdtp_stream_endpoint_arena_type, avdtp_stream_endpoint);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVDTP_STREAM_ENDPOINTS)
     #if defined(MAX_NO_AVDTP_STREAM_ENDPOINTS)
         #error "Deprecated MAX_NO_AVDTP_STREAM_ENDPOINTS defined instead of MAX_NR_AVDTP_STREAM_ENDPOINTS. Please update your btstack_config.h to use MAX_NR_AVDTP_STREAM_ENDPOINTS."
@@ -579,6 +1019,7 @@ void btstack_memory_service_record_item_free(service_record_item_t *service_reco
 #endif
 
 #ifdef MAX_NR_AVDTP_STREAM_ENDPOINTS
+BTSTACK_MEMORY_STATISTICS(avdtp_stream_endpoint, MAX_NR_AVDTP_STREAM_ENDPOINTS)
 #if MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
 static avdtp_stream_endpoint_t avdtp_stream_endpoint_storage[MAX_NR_AVDTP_STREAM_ENDPOINTS];
 static btstack_memory_pool_t avdtp_stream_endpoint_pool;
@@ -587,13 +1028,16 @@ avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_stream_endpoint_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avdtp_stream_endpoint, buffer);
     return (avdtp_stream_endpoint_t *) buffer;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    BTSTACK_MEMORY_TRACK_FREE(avdtp_stream_endpoint, avdtp_stream_endpoint);
     btstack_memory_pool_free(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint);
 }
 #else
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    BTSTACK_MEMORY_TRACK_GET(avdtp_stream_endpoint, NULL);
     return NULL;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
@@ -602,21 +1046,45 @@ void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_st
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(avdtp_stream_endpoint, 0)
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
     void * buffer = malloc(sizeof(avdtp_stream_endpoint_t));
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_stream_endpoint_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avdtp_stream_endpoint, buffer);
     return (avdtp_stream_endpoint_t *) buffer;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    BTSTACK_MEMORY_TRACK_FREE(avdtp_stream_endpoint, avdtp_stream_endpoint);
     free(avdtp_stream_endpoint);
 }
 #endif
 
+#endif
+
 
 
 // MARK: avdtp_connection_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_AVDTP_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(avdtp_connection, MAX_NR_AVDTP_CONNECTIONS)
+static btstack_memory_arena_type_t avdtp_connection_arena_type = { sizeof(avdtp_connection_t), 0, MAX_NR_AVDTP_CONNECTIONS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(avdtp_connection, 0)
+static btstack_memory_arena_type_t avdtp_connection_arena_type = { sizeof(avdtp_connection_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    void * buffer = btstack_memory_arena_get(&avdtp_connection_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(avdtp_connection, buffer);
+    return (avdtp_connection_t *) buffer;
+}
+void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avdtp_connection, avdtp_connection);
+    btstack_memory_arena_free(&avdtp_connection_arena_type, avdtp_connection);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVDTP_CONNECTIONS)
     #if defined(MAX_NO_AVDTP_CONNECTIONS)
         #error "Deprecated MAX_NO_AVDTP_CONNECTIONS defined instead of MAX_NR_AVDTP_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_AVDTP_CONNECTIONS."
@@ -626,6 +1094,7 @@ void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_st
 #endif
 
 #ifdef MAX_NR_AVDTP_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(avdtp_connection, MAX_NR_AVDTP_CONNECTIONS)
 #if MAX_NR_AVDTP_CONNECTIONS > 0
 static avdtp_connection_t avdtp_connection_storage[MAX_NR_AVDTP_CONNECTIONS];
 static btstack_memory_pool_t avdtp_connection_pool;
@@ -634,13 +1103,16 @@ avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avdtp_connection, buffer);
     return (avdtp_connection_t *) buffer;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avdtp_connection, avdtp_connection);
     btstack_memory_pool_free(&avdtp_connection_pool, avdtp_connection);
 }
 #else
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    BTSTACK_MEMORY_TRACK_GET(avdtp_connection, NULL);
     return NULL;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
@@ -649,21 +1121,45 @@ void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(avdtp_connection, 0)
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
     void * buffer = malloc(sizeof(avdtp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avdtp_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avdtp_connection, buffer);
     return (avdtp_connection_t *) buffer;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avdtp_connection, avdtp_connection);
     free(avdtp_connection);
 }
 #endif
 
+#endif
+
 
 
 // MARK: avrcp_connection_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_AVRCP_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(avrcp_connection, MAX_NR_AVRCP_CONNECTIONS)
+static btstack_memory_arena_type_t avrcp_connection_arena_type = { sizeof(avrcp_connection_t), 0, MAX_NR_AVRCP_CONNECTIONS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(avrcp_connection, 0)
+static btstack_memory_arena_type_t avrcp_connection_arena_type = { sizeof(avrcp_connection_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    void * buffer = btstack_memory_arena_get(&avrcp_connection_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(avrcp_connection, buffer);
+    return (avrcp_connection_t *) buffer;
+}
+void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avrcp_connection, avrcp_connection);
+    btstack_memory_arena_free(&avrcp_connection_arena_type, avrcp_connection);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVRCP_CONNECTIONS)
     #if defined(MAX_NO_AVRCP_CONNECTIONS)
         #error "Deprecated MAX_NO_AVRCP_CONNECTIONS defined instead of MAX_NR_AVRCP_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_AVRCP_CONNECTIONS."
@@ -673,6 +1169,7 @@ void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
 #endif
 
 #ifdef MAX_NR_AVRCP_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(avrcp_connection, MAX_NR_AVRCP_CONNECTIONS)
 #if MAX_NR_AVRCP_CONNECTIONS > 0
 static avrcp_connection_t avrcp_connection_storage[MAX_NR_AVRCP_CONNECTIONS];
 static btstack_memory_pool_t avrcp_connection_pool;
@@ -681,13 +1178,16 @@ avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avrcp_connection, buffer);
     return (avrcp_connection_t *) buffer;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avrcp_connection, avrcp_connection);
     btstack_memory_pool_free(&avrcp_connection_pool, avrcp_connection);
 }
 #else
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    BTSTACK_MEMORY_TRACK_GET(avrcp_connection, NULL);
     return NULL;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
@@ -696,21 +1196,45 @@ void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(avrcp_connection, 0)
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avrcp_connection, buffer);
     return (avrcp_connection_t *) buffer;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avrcp_connection, avrcp_connection);
     free(avrcp_connection);
 }
 #endif
 
+#endif
+
 
 
 // MARK: avrcp_browsing_connection_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_AVRCP_BROWSING_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(avrcp_browsing_connection, MAX_NR_AVRCP_BROWSING_CONNECTIONS)
+static btstack_memory_arena_type_t avrcp_browsing_connection_arena_type = { sizeof(avrcp_browsing_connection_t), 0, MAX_NR_AVRCP_BROWSING_CONNECTIONS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(avrcp_browsing_connection, 0)
+static btstack_memory_arena_type_t avrcp_browsing_connection_arena_type = { sizeof(avrcp_browsing_connection_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    void * buffer = btstack_memory_arena_get(&avrcp_browsing_connection_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(avrcp_browsing_connection, buffer);
+    return (avrcp_browsing_connection_t *) buffer;
+}
+void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avrcp_browsing_connection, avrcp_browsing_connection);
+    btstack_memory_arena_free(&avrcp_browsing_connection_arena_type, avrcp_browsing_connection);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS)
     #if defined(MAX_NO_AVRCP_BROWSING_CONNECTIONS)
         #error "Deprecated MAX_NO_AVRCP_BROWSING_CONNECTIONS defined instead of MAX_NR_AVRCP_BROWSING_CONNECTIONS. Please update your btstack_config.h to use MAX_NR_AVRCP_BROWSING_CONNECTIONS."
@@ -720,6 +1244,7 @@ void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
 #endif
 
 #ifdef MAX_NR_AVRCP_BROWSING_CONNECTIONS
+BTSTACK_MEMORY_STATISTICS(avrcp_browsing_connection, MAX_NR_AVRCP_BROWSING_CONNECTIONS)
 #if MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
 static avrcp_browsing_connection_t avrcp_browsing_connection_storage[MAX_NR_AVRCP_BROWSING_CONNECTIONS];
 static btstack_memory_pool_t avrcp_browsing_connection_pool;
@@ -728,13 +1253,16 @@ avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void)
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_browsing_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avrcp_browsing_connection, buffer);
     return (avrcp_browsing_connection_t *) buffer;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avrcp_browsing_connection, avrcp_browsing_connection);
     btstack_memory_pool_free(&avrcp_browsing_connection_pool, avrcp_browsing_connection);
 }
 #else
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    BTSTACK_MEMORY_TRACK_GET(avrcp_browsing_connection, NULL);
     return NULL;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
@@ -743,23 +1271,47 @@ void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(avrcp_browsing_connection, 0)
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_browsing_connection_t));
     if (buffer){
         memset(buffer, 0, sizeof(avrcp_browsing_connection_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(avrcp_browsing_connection, buffer);
     return (avrcp_browsing_connection_t *) buffer;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    BTSTACK_MEMORY_TRACK_FREE(avrcp_browsing_connection, avrcp_browsing_connection);
     free(avrcp_browsing_connection);
 }
 #endif
 
+#endif
+
 
 #endif
 #ifdef ENABLE_BLE
 
 // MARK: gatt_client_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_GATT_CLIENTS
+BTSTACK_MEMORY_STATISTICS(gatt_client, MAX_NR_GATT_CLIENTS)
+static btstack_memory_arena_type_t gatt_client_arena_type = { sizeof(gatt_client_t), 0, MAX_NR_GATT_CLIENTS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(gatt_client, 0)
+static btstack_memory_arena_type_t gatt_client_arena_type = { sizeof(gatt_client_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+gatt_client_t * btstack_memory_gatt_client_get(void){
+    void * buffer = btstack_memory_arena_get(&gatt_client_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(gatt_client, buffer);
+    return (gatt_client_t *) buffer;
+}
+void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    BTSTACK_MEMORY_TRACK_FREE(gatt_client, gatt_client);
+    btstack_memory_arena_free(&gatt_client_arena_type, gatt_client);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_GATT_CLIENTS)
     #if defined(MAX_NO_GATT_CLIENTS)
         #error "Deprecated MAX_NO_GATT_CLIENTS defined instead of MAX_NR_GATT_CLIENTS. Please update your btstack_config.h to use MAX_NR_GATT_CLIENTS."
@@ -769,6 +1321,7 @@ void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *
 #endif
 
 #ifdef MAX_NR_GATT_CLIENTS
+BTSTACK_MEMORY_STATISTICS(gatt_client, MAX_NR_GATT_CLIENTS)
 #if MAX_NR_GATT_CLIENTS > 0
 static gatt_client_t gatt_client_storage[MAX_NR_GATT_CLIENTS];
 static btstack_memory_pool_t gatt_client_pool;
@@ -777,13 +1330,16 @@ gatt_client_t * btstack_memory_gatt_client_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(gatt_client_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(gatt_client, buffer);
     return (gatt_client_t *) buffer;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    BTSTACK_MEMORY_TRACK_FREE(gatt_client, gatt_client);
     btstack_memory_pool_free(&gatt_client_pool, gatt_client);
 }
 #else
 gatt_client_t * btstack_memory_gatt_client_get(void){
+    BTSTACK_MEMORY_TRACK_GET(gatt_client, NULL);
     return NULL;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
@@ -792,20 +1348,44 @@ void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(gatt_client, 0)
 gatt_client_t * btstack_memory_gatt_client_get(void){
     void * buffer = malloc(sizeof(gatt_client_t));
     if (buffer){
         memset(buffer, 0, sizeof(gatt_client_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(gatt_client, buffer);
     return (gatt_client_t *) buffer;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    BTSTACK_MEMORY_TRACK_FREE(gatt_client, gatt_client);
     free(gatt_client);
 }
 #endif
 
+#endif
+
 
 // MARK: whitelist_entry_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_WHITELIST_ENTRIES
+BTSTACK_MEMORY_STATISTICS(whitelist_entry, MAX_NR_WHITELIST_ENTRIES)
+static btstack_memory_arena_type_t whitelist_entry_arena_type = { sizeof(whitelist_entry_t), 0, MAX_NR_WHITELIST_ENTRIES, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(whitelist_entry, 0)
+static btstack_memory_arena_type_t whitelist_entry_arena_type = { sizeof(whitelist_entry_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    void * buffer = btstack_memory_arena_get(&whitelist_entry_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(whitelist_entry, buffer);
+    return (whitelist_entry_t *) buffer;
+}
+void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    BTSTACK_MEMORY_TRACK_FREE(whitelist_entry, whitelist_entry);
+    btstack_memory_arena_free(&whitelist_entry_arena_type, whitelist_entry);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_WHITELIST_ENTRIES)
     #if defined(MAX_NO_WHITELIST_ENTRIES)
         #error "Deprecated MAX_NO_WHITELIST_ENTRIES defined instead of MAX_NR_WHITELIST_ENTRIES. Please update your btstack_config.h to use MAX_NR_WHITELIST_ENTRIES."
@@ -815,6 +1395,7 @@ void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
 #endif
 
 #ifdef MAX_NR_WHITELIST_ENTRIES
+BTSTACK_MEMORY_STATISTICS(whitelist_entry, MAX_NR_WHITELIST_ENTRIES)
 #if MAX_NR_WHITELIST_ENTRIES > 0
 static whitelist_entry_t whitelist_entry_storage[MAX_NR_WHITELIST_ENTRIES];
 static btstack_memory_pool_t whitelist_entry_pool;
@@ -823,13 +1404,16 @@ whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(whitelist_entry_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(whitelist_entry, buffer);
     return (whitelist_entry_t *) buffer;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    BTSTACK_MEMORY_TRACK_FREE(whitelist_entry, whitelist_entry);
     btstack_memory_pool_free(&whitelist_entry_pool, whitelist_entry);
 }
 #else
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    BTSTACK_MEMORY_TRACK_GET(whitelist_entry, NULL);
     return NULL;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
@@ -838,20 +1422,44 @@ void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(whitelist_entry, 0)
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
     void * buffer = malloc(sizeof(whitelist_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(whitelist_entry_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(whitelist_entry, buffer);
     return (whitelist_entry_t *) buffer;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    BTSTACK_MEMORY_TRACK_FREE(whitelist_entry, whitelist_entry);
     free(whitelist_entry);
 }
 #endif
 
+#endif
+
 
 // MARK: sm_lookup_entry_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_SM_LOOKUP_ENTRIES
+BTSTACK_MEMORY_STATISTICS(sm_lookup_entry, MAX_NR_SM_LOOKUP_ENTRIES)
+static btstack_memory_arena_type_t sm_lookup_entry_arena_type = { sizeof(sm_lookup_entry_t), 0, MAX_NR_SM_LOOKUP_ENTRIES, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(sm_lookup_entry, 0)
+static btstack_memory_arena_type_t sm_lookup_entry_arena_type = { sizeof(sm_lookup_entry_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    void * buffer = btstack_memory_arena_get(&sm_lookup_entry_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(sm_lookup_entry, buffer);
+    return (sm_lookup_entry_t *) buffer;
+}
+void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    BTSTACK_MEMORY_TRACK_FREE(sm_lookup_entry, sm_lookup_entry);
+    btstack_memory_arena_free(&sm_lookup_entry_arena_type, sm_lookup_entry);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_SM_LOOKUP_ENTRIES)
     #if defined(MAX_NO_SM_LOOKUP_ENTRIES)
         #error "Deprecated MAX_NO_SM_LOOKUP_ENTRIES defined instead of MAX_NR_SM_LOOKUP_ENTRIES. Please update your btstack_config.h to use MAX_NR_SM_LOOKUP_ENTRIES."
@@ -861,6 +1469,7 @@ void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
 #endif
 
 #ifdef MAX_NR_SM_LOOKUP_ENTRIES
+BTSTACK_MEMORY_STATISTICS(sm_lookup_entry, MAX_NR_SM_LOOKUP_ENTRIES)
 #if MAX_NR_SM_LOOKUP_ENTRIES > 0
 static sm_lookup_entry_t sm_lookup_entry_storage[MAX_NR_SM_LOOKUP_ENTRIES];
 static btstack_memory_pool_t sm_lookup_entry_pool;
@@ -869,13 +1478,16 @@ sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(sm_lookup_entry_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(sm_lookup_entry, buffer);
     return (sm_lookup_entry_t *) buffer;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    BTSTACK_MEMORY_TRACK_FREE(sm_lookup_entry, sm_lookup_entry);
     btstack_memory_pool_free(&sm_lookup_entry_pool, sm_lookup_entry);
 }
 #else
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    BTSTACK_MEMORY_TRACK_GET(sm_lookup_entry, NULL);
     return NULL;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
@@ -884,23 +1496,124 @@ void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(sm_lookup_entry, 0)
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
     void * buffer = malloc(sizeof(sm_lookup_entry_t));
     if (buffer){
         memset(buffer, 0, sizeof(sm_lookup_entry_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(sm_lookup_entry, buffer);
     return (sm_lookup_entry_t *) buffer;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    BTSTACK_MEMORY_TRACK_FREE(sm_lookup_entry, sm_lookup_entry);
     free(sm_lookup_entry);
 }
 #endif
 
+#endif
+
+
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+
+// MARK: hci_iso_stream_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_HCI_ISO_STREAMS
+BTSTACK_MEMORY_STATISTICS(hci_iso_stream, MAX_NR_HCI_ISO_STREAMS)
+static btstack_memory_arena_type_t hci_iso_stream_arena_type = { sizeof(hci_iso_stream_t), 0, MAX_NR_HCI_ISO_STREAMS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(hci_iso_stream, 0)
+static btstack_memory_arena_type_t hci_iso_stream_arena_type = { sizeof(hci_iso_stream_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+hci_iso_stream_t * btstack_memory_hci_iso_stream_get(void){
+    void * buffer = btstack_memory_arena_get(&hci_iso_stream_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(hci_iso_stream, buffer);
+    return (hci_iso_stream_t *) buffer;
+}
+void btstack_memory_hci_iso_stream_free(hci_iso_stream_t *hci_iso_stream){
+    BTSTACK_MEMORY_TRACK_FREE(hci_iso_stream, hci_iso_stream);
+    btstack_memory_arena_free(&hci_iso_stream_arena_type, hci_iso_stream);
+}
+#else
+
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_HCI_ISO_STREAMS)
+    #if defined(MAX_NO_HCI_ISO_STREAMS)
+        #error "Deprecated MAX_NO_HCI_ISO_STREAMS defined instead of MAX_NR_HCI_ISO_STREAMS. Please update your btstack_config.h to use MAX_NR_HCI_ISO_STREAMS."
+    #else
+        #define MAX_NR_HCI_ISO_STREAMS 0
+    #endif
+#endif
+
+#ifdef MAX_NR_HCI_ISO_STREAMS
+BTSTACK_MEMORY_STATISTICS(hci_iso_stream, MAX_NR_HCI_ISO_STREAMS)
+#if MAX_NR_HCI_ISO_STREAMS > 0
+static hci_iso_stream_t hci_iso_stream_storage[MAX_NR_HCI_ISO_STREAMS];
+static btstack_memory_pool_t hci_iso_stream_pool;
+hci_iso_stream_t * btstack_memory_hci_iso_stream_get(void){
+    void * buffer = btstack_memory_pool_get(&hci_iso_stream_pool);
+    if (buffer){
+        memset(buffer, 0, sizeof(hci_iso_stream_t));
+    }
+    BTSTACK_MEMORY_TRACK_GET(hci_iso_stream, buffer);
+    return (hci_iso_stream_t *) buffer;
+}
+void btstack_memory_hci_iso_stream_free(hci_iso_stream_t *hci_iso_stream){
+    BTSTACK_MEMORY_TRACK_FREE(hci_iso_stream, hci_iso_stream);
+    btstack_memory_pool_free(&hci_iso_stream_pool, hci_iso_stream);
+}
+#else
+hci_iso_stream_t * btstack_memory_hci_iso_stream_get(void){
+    BTSTACK_MEMORY_TRACK_GET(hci_iso_stream, NULL);
+    return NULL;
+}
+void btstack_memory_hci_iso_stream_free(hci_iso_stream_t *hci_iso_stream){
+    // silence compiler warning about unused parameter in a portable way
+    (void) hci_iso_stream;
+};
+#endif
+#elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(hci_iso_stream, 0)
+hci_iso_stream_t * btstack_memory_hci_iso_stream_get(void){
+    void * buffer = malloc(sizeof(hci_iso_stream_t));
+    if (buffer){
+        memset(buffer, 0, sizeof(hci_iso_stream_t));
+    }
+    BTSTACK_MEMORY_TRACK_GET(hci_iso_stream, buffer);
+    return (hci_iso_stream_t *) buffer;
+}
+void btstack_memory_hci_iso_stream_free(hci_iso_stream_t *hci_iso_stream){
+    BTSTACK_MEMORY_TRACK_FREE(hci_iso_stream, hci_iso_stream);
+    free(hci_iso_stream);
+}
+#endif
+
+#endif
+
 
 #endif
 #ifdef ENABLE_MESH
 
 // MARK: mesh_network_pdu_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_MESH_NETWORK_PDUS
+BTSTACK_MEMORY_STATISTICS(mesh_network_pdu, MAX_NR_MESH_NETWORK_PDUS)
+static btstack_memory_arena_type_t mesh_network_pdu_arena_type = { sizeof(mesh_network_pdu_t), 0, MAX_NR_MESH_NETWORK_PDUS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(mesh_network_pdu, 0)
+static btstack_memory_arena_type_t mesh_network_pdu_arena_type = { sizeof(mesh_network_pdu_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
+    void * buffer = btstack_memory_arena_get(&mesh_network_pdu_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_pdu, buffer);
+    return (mesh_network_pdu_t *) buffer;
+}
+void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_network_pdu, mesh_network_pdu);
+    btstack_memory_arena_free(&mesh_network_pdu_arena_type, mesh_network_pdu);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_NETWORK_PDUS)
     #if defined(MAX_NO_MESH_NETWORK_PDUS)
         #error "Deprecated MAX_NO_MESH_NETWORK_PDUS defined instead of MAX_NR_MESH_NETWORK_PDUS. Please update your btstack_config.h to use MAX_NR_MESH_NETWORK_PDUS."
@@ -910,6 +1623,7 @@ void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
 #endif
 
 #ifdef MAX_NR_MESH_NETWORK_PDUS
+BTSTACK_MEMORY_STATISTICS(mesh_network_pdu, MAX_NR_MESH_NETWORK_PDUS)
 #if MAX_NR_MESH_NETWORK_PDUS > 0
 static mesh_network_pdu_t mesh_network_pdu_storage[MAX_NR_MESH_NETWORK_PDUS];
 static btstack_memory_pool_t mesh_network_pdu_pool;
@@ -918,13 +1632,16 @@ mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_pdu_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_pdu, buffer);
     return (mesh_network_pdu_t *) buffer;
 }
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_network_pdu, mesh_network_pdu);
     btstack_memory_pool_free(&mesh_network_pdu_pool, mesh_network_pdu);
 }
 #else
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_pdu, NULL);
     return NULL;
 }
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
@@ -933,20 +1650,44 @@ void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(mesh_network_pdu, 0)
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_network_pdu_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_pdu_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_pdu, buffer);
     return (mesh_network_pdu_t *) buffer;
 }
 void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_network_pdu, mesh_network_pdu);
     free(mesh_network_pdu);
 }
 #endif
 
+#endif
+
 
 // MARK: mesh_transport_pdu_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_MESH_TRANSPORT_PDUS
+BTSTACK_MEMORY_STATISTICS(mesh_transport_pdu, MAX_NR_MESH_TRANSPORT_PDUS)
+static btstack_memory_arena_type_t mesh_transport_pdu_arena_type = { sizeof(mesh_transport_pdu_t), 0, MAX_NR_MESH_TRANSPORT_PDUS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(mesh_transport_pdu, 0)
+static btstack_memory_arena_type_t mesh_transport_pdu_arena_type = { sizeof(mesh_transport_pdu_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
+    void * buffer = btstack_memory_arena_get(&mesh_transport_pdu_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_pdu, buffer);
+    return (mesh_transport_pdu_t *) buffer;
+}
+void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_transport_pdu, mesh_transport_pdu);
+    btstack_memory_arena_free(&mesh_transport_pdu_arena_type, mesh_transport_pdu);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_TRANSPORT_PDUS)
     #if defined(MAX_NO_MESH_TRANSPORT_PDUS)
         #error "Deprecated MAX_NO_MESH_TRANSPORT_PDUS defined instead of MAX_NR_MESH_TRANSPORT_PDUS. Please update your btstack_config.h to use MAX_NR_MESH_TRANSPORT_PDUS."
@@ -956,6 +1697,7 @@ void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
 #endif
 
 #ifdef MAX_NR_MESH_TRANSPORT_PDUS
+BTSTACK_MEMORY_STATISTICS(mesh_transport_pdu, MAX_NR_MESH_TRANSPORT_PDUS)
 #if MAX_NR_MESH_TRANSPORT_PDUS > 0
 static mesh_transport_pdu_t mesh_transport_pdu_storage[MAX_NR_MESH_TRANSPORT_PDUS];
 static btstack_memory_pool_t mesh_transport_pdu_pool;
@@ -964,13 +1706,16 @@ mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_pdu_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_pdu, buffer);
     return (mesh_transport_pdu_t *) buffer;
 }
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_transport_pdu, mesh_transport_pdu);
     btstack_memory_pool_free(&mesh_transport_pdu_pool, mesh_transport_pdu);
 }
 #else
 mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_pdu, NULL);
     return NULL;
 }
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
@@ -979,20 +1724,44 @@ void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(mesh_transport_pdu, 0)
 mesh_transport_pdu_t * btstack_memory_mesh_transport_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_transport_pdu_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_pdu_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_pdu, buffer);
     return (mesh_transport_pdu_t *) buffer;
 }
 void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport_pdu){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_transport_pdu, mesh_transport_pdu);
     free(mesh_transport_pdu);
 }
 #endif
 
+#endif
+
 
 // MARK: mesh_network_key_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_MESH_NETWORK_KEYS
+BTSTACK_MEMORY_STATISTICS(mesh_network_key, MAX_NR_MESH_NETWORK_KEYS)
+static btstack_memory_arena_type_t mesh_network_key_arena_type = { sizeof(mesh_network_key_t), 0, MAX_NR_MESH_NETWORK_KEYS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(mesh_network_key, 0)
+static btstack_memory_arena_type_t mesh_network_key_arena_type = { sizeof(mesh_network_key_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
+    void * buffer = btstack_memory_arena_get(&mesh_network_key_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_key, buffer);
+    return (mesh_network_key_t *) buffer;
+}
+void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_network_key, mesh_network_key);
+    btstack_memory_arena_free(&mesh_network_key_arena_type, mesh_network_key);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_NETWORK_KEYS)
     #if defined(MAX_NO_MESH_NETWORK_KEYS)
         #error "Deprecated MAX_NO_MESH_NETWORK_KEYS defined instead of MAX_NR_MESH_NETWORK_KEYS. Please update your btstack_config.h to use MAX_NR_MESH_NETWORK_KEYS."
@@ -1002,6 +1771,7 @@ void btstack_memory_mesh_transport_pdu_free(mesh_transport_pdu_t *mesh_transport
 #endif
 
 #ifdef MAX_NR_MESH_NETWORK_KEYS
+BTSTACK_MEMORY_STATISTICS(mesh_network_key, MAX_NR_MESH_NETWORK_KEYS)
 #if MAX_NR_MESH_NETWORK_KEYS > 0
 static mesh_network_key_t mesh_network_key_storage[MAX_NR_MESH_NETWORK_KEYS];
 static btstack_memory_pool_t mesh_network_key_pool;
@@ -1010,13 +1780,16 @@ mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_key_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_key, buffer);
     return (mesh_network_key_t *) buffer;
 }
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_network_key, mesh_network_key);
     btstack_memory_pool_free(&mesh_network_key_pool, mesh_network_key);
 }
 #else
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_key, NULL);
     return NULL;
 }
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
@@ -1025,20 +1798,44 @@ void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(mesh_network_key, 0)
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     void * buffer = malloc(sizeof(mesh_network_key_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_network_key_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_network_key, buffer);
     return (mesh_network_key_t *) buffer;
 }
 void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_network_key, mesh_network_key);
     free(mesh_network_key);
 }
 #endif
 
+#endif
+
 
 // MARK: mesh_transport_key_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_MESH_TRANSPORT_KEYS
+BTSTACK_MEMORY_STATISTICS(mesh_transport_key, MAX_NR_MESH_TRANSPORT_KEYS)
+static btstack_memory_arena_type_t mesh_transport_key_arena_type = { sizeof(mesh_transport_key_t), 0, MAX_NR_MESH_TRANSPORT_KEYS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(mesh_transport_key, 0)
+static btstack_memory_arena_type_t mesh_transport_key_arena_type = { sizeof(mesh_transport_key_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
+    void * buffer = btstack_memory_arena_get(&mesh_transport_key_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_key, buffer);
+    return (mesh_transport_key_t *) buffer;
+}
+void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_transport_key, mesh_transport_key);
+    btstack_memory_arena_free(&mesh_transport_key_arena_type, mesh_transport_key);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_TRANSPORT_KEYS)
     #if defined(MAX_NO_MESH_TRANSPORT_KEYS)
         #error "Deprecated MAX_NO_MESH_TRANSPORT_KEYS defined instead of MAX_NR_MESH_TRANSPORT_KEYS. Please update your btstack_config.h to use MAX_NR_MESH_TRANSPORT_KEYS."
@@ -1048,6 +1845,7 @@ void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
 #endif
 
 #ifdef MAX_NR_MESH_TRANSPORT_KEYS
+BTSTACK_MEMORY_STATISTICS(mesh_transport_key, MAX_NR_MESH_TRANSPORT_KEYS)
 #if MAX_NR_MESH_TRANSPORT_KEYS > 0
 static mesh_transport_key_t mesh_transport_key_storage[MAX_NR_MESH_TRANSPORT_KEYS];
 static btstack_memory_pool_t mesh_transport_key_pool;
@@ -1056,13 +1854,16 @@ mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_key_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_key, buffer);
     return (mesh_transport_key_t *) buffer;
 }
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_transport_key, mesh_transport_key);
     btstack_memory_pool_free(&mesh_transport_key_pool, mesh_transport_key);
 }
 #else
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_key, NULL);
     return NULL;
 }
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
@@ -1071,20 +1872,44 @@ void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(mesh_transport_key, 0)
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
     void * buffer = malloc(sizeof(mesh_transport_key_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_transport_key_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_transport_key, buffer);
     return (mesh_transport_key_t *) buffer;
 }
 void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_transport_key, mesh_transport_key);
     free(mesh_transport_key);
 }
 #endif
 
+#endif
+
 
 // MARK: mesh_virtual_address_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_MESH_VIRTUAL_ADDRESSS
+BTSTACK_MEMORY_STATISTICS(mesh_virtual_address, MAX_NR_MESH_VIRTUAL_ADDRESSS)
+static btstack_memory_arena_type_t mesh_virtual_address_arena_type = { sizeof(mesh_virtual_address_t), 0, MAX_NR_MESH_VIRTUAL_ADDRESSS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(mesh_virtual_address, 0)
+static btstack_memory_arena_type_t mesh_virtual_address_arena_type = { sizeof(mesh_virtual_address_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
+    void * buffer = btstack_memory_arena_get(&mesh_virtual_address_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(mesh_virtual_address, buffer);
+    return (mesh_virtual_address_t *) buffer;
+}
+void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_virtual_address, mesh_virtual_address);
+    btstack_memory_arena_free(&mesh_virtual_address_arena_type, mesh_virtual_address);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_VIRTUAL_ADDRESSS)
     #if defined(MAX_NO_MESH_VIRTUAL_ADDRESSS)
         #error "Deprecated MAX_NO_MESH_VIRTUAL_ADDRESSS defined instead of MAX_NR_MESH_VIRTUAL_ADDRESSS. Please update your btstack_config.h to use MAX_NR_MESH_VIRTUAL_ADDRESSS."
@@ -1094,6 +1919,7 @@ void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport
 #endif
 
 #ifdef MAX_NR_MESH_VIRTUAL_ADDRESSS
+BTSTACK_MEMORY_STATISTICS(mesh_virtual_address, MAX_NR_MESH_VIRTUAL_ADDRESSS)
 #if MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
 static mesh_virtual_address_t mesh_virtual_address_storage[MAX_NR_MESH_VIRTUAL_ADDRESSS];
 static btstack_memory_pool_t mesh_virtual_address_pool;
@@ -1102,13 +1928,16 @@ mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(mesh_virtual_address_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_virtual_address, buffer);
     return (mesh_virtual_address_t *) buffer;
 }
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_virtual_address, mesh_virtual_address);
     btstack_memory_pool_free(&mesh_virtual_address_pool, mesh_virtual_address);
 }
 #else
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
+    BTSTACK_MEMORY_TRACK_GET(mesh_virtual_address, NULL);
     return NULL;
 }
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
@@ -1117,20 +1946,44 @@ void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtu
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(mesh_virtual_address, 0)
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
     void * buffer = malloc(sizeof(mesh_virtual_address_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_virtual_address_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_virtual_address, buffer);
     return (mesh_virtual_address_t *) buffer;
 }
 void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_virtual_address, mesh_virtual_address);
     free(mesh_virtual_address);
 }
 #endif
 
+#endif
+
 
 // MARK: mesh_subnet_t
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef MAX_NR_MESH_SUBNETS
+BTSTACK_MEMORY_STATISTICS(mesh_subnet, MAX_NR_MESH_SUBNETS)
+static btstack_memory_arena_type_t mesh_subnet_arena_type = { sizeof(mesh_subnet_t), 0, MAX_NR_MESH_SUBNETS, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(mesh_subnet, 0)
+static btstack_memory_arena_type_t mesh_subnet_arena_type = { sizeof(mesh_subnet_t), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
+    void * buffer = btstack_memory_arena_get(&mesh_subnet_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(mesh_subnet, buffer);
+    return (mesh_subnet_t *) buffer;
+}
+void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_subnet, mesh_subnet);
+    btstack_memory_arena_free(&mesh_subnet_arena_type, mesh_subnet);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(MAX_NR_MESH_SUBNETS)
     #if defined(MAX_NO_MESH_SUBNETS)
         #error "Deprecated MAX_NO_MESH_SUBNETS defined instead of MAX_NR_MESH_SUBNETS. Please update your btstack_config.h to use MAX_NR_MESH_SUBNETS."
@@ -1140,6 +1993,7 @@ void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtu
 #endif
 
 #ifdef MAX_NR_MESH_SUBNETS
+BTSTACK_MEMORY_STATISTICS(mesh_subnet, MAX_NR_MESH_SUBNETS)
 #if MAX_NR_MESH_SUBNETS > 0
 static mesh_subnet_t mesh_subnet_storage[MAX_NR_MESH_SUBNETS];
 static btstack_memory_pool_t mesh_subnet_pool;
@@ -1148,13 +2002,16 @@ mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(mesh_subnet_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_subnet, buffer);
     return (mesh_subnet_t *) buffer;
 }
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_subnet, mesh_subnet);
     btstack_memory_pool_free(&mesh_subnet_pool, mesh_subnet);
 }
 #else
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
+    BTSTACK_MEMORY_TRACK_GET(mesh_subnet, NULL);
     return NULL;
 }
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
@@ -1163,97 +2020,219 @@ void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(mesh_subnet, 0)
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
     void * buffer = malloc(sizeof(mesh_subnet_t));
     if (buffer){
         memset(buffer, 0, sizeof(mesh_subnet_t));
     }
+    BTSTACK_MEMORY_TRACK_GET(mesh_subnet, buffer);
     return (mesh_subnet_t *) buffer;
 }
 void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    BTSTACK_MEMORY_TRACK_FREE(mesh_subnet, mesh_subnet);
     free(mesh_subnet);
 }
 #endif
 
+#endif
+
+
+#endif
+#ifdef ENABLE_BTSTACK_MEMORY_STATISTICS
+static btstack_memory_statistics_t * const btstack_memory_statistics[] = {
+    &hci_connection_statistics,
+    &l2cap_service_statistics,
+    &l2cap_channel_statistics,
+#ifdef ENABLE_CLASSIC
+    &rfcomm_multiplexer_statistics,
+    &rfcomm_service_statistics,
+    &rfcomm_channel_statistics,
+    &btstack_link_key_db_memory_entry_statistics,
+    &bnep_service_statistics,
+    &bnep_channel_statistics,
+    &hfp_connection_statistics,
+    &service_record_item_statistics,
+    &avdtp_stream_endpoint_statistics,
+    &avdtp_connection_statistics,
+    &avrcp_connection_statistics,
+    &avrcp_browsing_connection_statistics,
+#endif
+#ifdef ENABLE_BLE
+    &gatt_client_statistics,
+    &whitelist_entry_statistics,
+    &sm_lookup_entry_statistics,
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    &hci_iso_stream_statistics,
+#endif
+#ifdef ENABLE_MESH
+    &mesh_network_pdu_statistics,
+    &mesh_transport_pdu_statistics,
+    &mesh_network_key_statistics,
+    &mesh_transport_key_statistics,
+    &mesh_virtual_address_statistics,
+    &mesh_subnet_statistics,
+#endif
+};
 
+uint16_t btstack_memory_statistics_num_types(void){
+    return (uint16_t) (sizeof(btstack_memory_statistics) / sizeof(btstack_memory_statistics[0]));
+}
+
+const btstack_memory_statistics_t * btstack_memory_statistics_get(uint16_t index){
+    if (index >= btstack_memory_statistics_num_types()) return NULL;
+    return btstack_memory_statistics[index];
+}
+
+void btstack_memory_statistics_dump(void){
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    log_info("arena used %u of %u bytes", (unsigned int) btstack_memory_arena_used, (unsigned int) BTSTACK_MEMORY_ARENA_SIZE);
+#endif
+    uint16_t i;
+    for (i=0;i<btstack_memory_statistics_num_types();i++){
+        const btstack_memory_statistics_t * statistics = btstack_memory_statistics[i];
+        log_info("%-32s pool %3u, in use %3u, peak %3u, failures %u", statistics->name, statistics->pool_size,
+                 statistics->in_use, statistics->peak, (unsigned int) statistics->failures);
+    }
+}
 #endif
+
 // init
 void btstack_memory_init(void){
-#if MAX_NR_HCI_CONNECTIONS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_init();
+#endif
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&hci_connection_arena_type);
+#elif MAX_NR_HCI_CONNECTIONS > 0
     btstack_memory_pool_create(&hci_connection_pool, hci_connection_storage, MAX_NR_HCI_CONNECTIONS, sizeof(hci_connection_t));
 #endif
-#if MAX_NR_L2CAP_SERVICES > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&l2cap_service_arena_type);
+#elif MAX_NR_L2CAP_SERVICES > 0
     btstack_memory_pool_create(&l2cap_service_pool, l2cap_service_storage, MAX_NR_L2CAP_SERVICES, sizeof(l2cap_service_t));
 #endif
-#if MAX_NR_L2CAP_CHANNELS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&l2cap_channel_arena_type);
+#elif MAX_NR_L2CAP_CHANNELS > 0
     btstack_memory_pool_create(&l2cap_channel_pool, l2cap_channel_storage, MAX_NR_L2CAP_CHANNELS, sizeof(l2cap_channel_t));
 #endif
 #ifdef ENABLE_CLASSIC
-#if MAX_NR_RFCOMM_MULTIPLEXERS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&rfcomm_multiplexer_arena_type);
+#elif MAX_NR_RFCOMM_MULTIPLEXERS > 0
     btstack_memory_pool_create(&rfcomm_multiplexer_pool, rfcomm_multiplexer_storage, MAX_NR_RFCOMM_MULTIPLEXERS, sizeof(rfcomm_multiplexer_t));
 #endif
-#if MAX_NR_RFCOMM_SERVICES > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&rfcomm_service_arena_type);
+#elif MAX_NR_RFCOMM_SERVICES > 0
     btstack_memory_pool_create(&rfcomm_service_pool, rfcomm_service_storage, MAX_NR_RFCOMM_SERVICES, sizeof(rfcomm_service_t));
 #endif
-#if MAX_NR_RFCOMM_CHANNELS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&rfcomm_channel_arena_type);
+#elif MAX_NR_RFCOMM_CHANNELS > 0
     btstack_memory_pool_create(&rfcomm_channel_pool, rfcomm_channel_storage, MAX_NR_RFCOMM_CHANNELS, sizeof(rfcomm_channel_t));
 #endif
-#if MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&btstack_link_key_db_memory_entry_arena_type);
+#elif MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
     btstack_memory_pool_create(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry_storage, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, sizeof(btstack_link_key_db_memory_entry_t));
 #endif
-#if MAX_NR_BNEP_SERVICES > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&bnep_service_arena_type);
+#elif MAX_NR_BNEP_SERVICES > 0
     btstack_memory_pool_create(&bnep_service_pool, bnep_service_storage, MAX_NR_BNEP_SERVICES, sizeof(bnep_service_t));
 #endif
-#if MAX_NR_BNEP_CHANNELS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&bnep_channel_arena_type);
+#elif MAX_NR_BNEP_CHANNELS > 0
     btstack_memory_pool_create(&bnep_channel_pool, bnep_channel_storage, MAX_NR_BNEP_CHANNELS, sizeof(bnep_channel_t));
 #endif
-#if MAX_NR_HFP_CONNECTIONS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&hfp_connection_arena_type);
+#elif MAX_NR_HFP_CONNECTIONS > 0
     btstack_memory_pool_create(&hfp_connection_pool, hfp_connection_storage, MAX_NR_HFP_CONNECTIONS, sizeof(hfp_connection_t));
 #endif
-#if MAX_NR_SERVICE_RECORD_ITEMS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&service_record_item_arena_type);
+#elif MAX_NR_SERVICE_RECORD_ITEMS > 0
     btstack_memory_pool_create(&service_record_item_pool, service_record_item_storage, MAX_NR_SERVICE_RECORD_ITEMS, sizeof(service_record_item_t));
 #endif
-#if MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&avdtp_stream_endpoint_arena_type);
+#elif MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
     btstack_memory_pool_create(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint_storage, MAX_NR_AVDTP_STREAM_ENDPOINTS, sizeof(avdtp_stream_endpoint_t));
 #endif
-#if MAX_NR_AVDTP_CONNECTIONS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&avdtp_connection_arena_type);
+#elif MAX_NR_AVDTP_CONNECTIONS > 0
     btstack_memory_pool_create(&avdtp_connection_pool, avdtp_connection_storage, MAX_NR_AVDTP_CONNECTIONS, sizeof(avdtp_connection_t));
 #endif
-#if MAX_NR_AVRCP_CONNECTIONS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&avrcp_connection_arena_type);
+#elif MAX_NR_AVRCP_CONNECTIONS > 0
     btstack_memory_pool_create(&avrcp_connection_pool, avrcp_connection_storage, MAX_NR_AVRCP_CONNECTIONS, sizeof(avrcp_connection_t));
 #endif
-#if MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&avrcp_browsing_connection_arena_type);
+#elif MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
     btstack_memory_pool_create(&avrcp_browsing_connection_pool, avrcp_browsing_connection_storage, MAX_NR_AVRCP_BROWSING_CONNECTIONS, sizeof(avrcp_browsing_connection_t));
 #endif
 #endif
 #ifdef ENABLE_BLE
-#if MAX_NR_GATT_CLIENTS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&gatt_client_arena_type);
+#elif MAX_NR_GATT_CLIENTS > 0
     btstack_memory_pool_create(&gatt_client_pool, gatt_client_storage, MAX_NR_GATT_CLIENTS, sizeof(gatt_client_t));
 #endif
-#if MAX_NR_WHITELIST_ENTRIES > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&whitelist_entry_arena_type);
+#elif MAX_NR_WHITELIST_ENTRIES > 0
     btstack_memory_pool_create(&whitelist_entry_pool, whitelist_entry_storage, MAX_NR_WHITELIST_ENTRIES, sizeof(whitelist_entry_t));
 #endif
-#if MAX_NR_SM_LOOKUP_ENTRIES > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&sm_lookup_entry_arena_type);
+#elif MAX_NR_SM_LOOKUP_ENTRIES > 0
     btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t));
 #endif
 #endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&hci_iso_stream_arena_type);
+#elif MAX_NR_HCI_ISO_STREAMS > 0
+    btstack_memory_pool_create(&hci_iso_stream_pool, hci_iso_stream_storage, MAX_NR_HCI_ISO_STREAMS, sizeof(hci_iso_stream_t));
+#endif
+#endif
 #ifdef ENABLE_MESH
-#if MAX_NR_MESH_NETWORK_PDUS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&mesh_network_pdu_arena_type);
+#elif MAX_NR_MESH_NETWORK_PDUS > 0
     btstack_memory_pool_create(&mesh_network_pdu_pool, mesh_network_pdu_storage, MAX_NR_MESH_NETWORK_PDUS, sizeof(mesh_network_pdu_t));
 #endif
-#if MAX_NR_MESH_TRANSPORT_PDUS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&mesh_transport_pdu_arena_type);
+#elif MAX_NR_MESH_TRANSPORT_PDUS > 0
     btstack_memory_pool_create(&mesh_transport_pdu_pool, mesh_transport_pdu_storage, MAX_NR_MESH_TRANSPORT_PDUS, sizeof(mesh_transport_pdu_t));
 #endif
-#if MAX_NR_MESH_NETWORK_KEYS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&mesh_network_key_arena_type);
+#elif MAX_NR_MESH_NETWORK_KEYS > 0
     btstack_memory_pool_create(&mesh_network_key_pool, mesh_network_key_storage, MAX_NR_MESH_NETWORK_KEYS, sizeof(mesh_network_key_t));
 #endif
-#if MAX_NR_MESH_TRANSPORT_KEYS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&mesh_transport_key_arena_type);
+#elif MAX_NR_MESH_TRANSPORT_KEYS > 0
     btstack_memory_pool_create(&mesh_transport_key_pool, mesh_transport_key_storage, MAX_NR_MESH_TRANSPORT_KEYS, sizeof(mesh_transport_key_t));
 #endif
-#if MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&mesh_virtual_address_arena_type);
+#elif MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
     btstack_memory_pool_create(&mesh_virtual_address_pool, mesh_virtual_address_storage, MAX_NR_MESH_VIRTUAL_ADDRESSS, sizeof(mesh_virtual_address_t));
 #endif
-#if MAX_NR_MESH_SUBNETS > 0
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&mesh_subnet_arena_type);
+#elif MAX_NR_MESH_SUBNETS > 0
     btstack_memory_pool_create(&mesh_subnet_pool, mesh_subnet_storage, MAX_NR_MESH_SUBNETS, sizeof(mesh_subnet_t));
 #endif
 #endif
@@ -87,6 +87,34 @@ extern "C" {
  */
 void btstack_memory_init(void);
 
+// Memory statistics per type, requires ENABLE_BTSTACK_MEMORY_STATISTICS
+typedef struct {
+    const char * name;
+    // number of items in pool, 0 if allocated by malloc
+    uint16_t pool_size;
+    uint16_t in_use;
+    uint16_t peak;
+    uint32_t failures;
+} btstack_memory_statistics_t;
+
+/**
+ * @brief Get number of types with memory statistics. Requires ENABLE_BTSTACK_MEMORY_STATISTICS
+ * @return num types
+ */
+uint16_t btstack_memory_statistics_num_types(void);
+
+/**
+ * @brief Get memory statistics for type. Requires ENABLE_BTSTACK_MEMORY_STATISTICS
+ * @param index < btstack_memory_statistics_num_types()
+ * @return statistics or NULL if index invalid
+ */
+const btstack_memory_statistics_t * btstack_memory_statistics_get(uint16_t index);
+
+/**
+ * @brief Log memory statistics for all types via log_info. Requires ENABLE_BTSTACK_MEMORY_STATISTICS
+ */
+void btstack_memory_statistics_dump(void);
+
 /* API_END */
 
 // hci_connection
@@ -152,6 +180,11 @@ void   btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry);
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void);
 void   btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry);
 #endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+// hci_iso_stream
+hci_iso_stream_t * btstack_memory_hci_iso_stream_get(void);
+void   btstack_memory_hci_iso_stream_free(hci_iso_stream_t *hci_iso_stream);
+#endif
 #ifdef ENABLE_MESH
 // mesh_network_pdu, mesh_transport_pdu, mesh_network_key, mesh_transport_key, mesh_virtual_address, mesh_subnet
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void);
@@ -40,19 +40,175 @@
 #include "btstack_bool.h"
 #include "btstack_resample.h"
 
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RESAMPLE_POLYPHASE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RESAMPLE_POLYPHASE_NEON
+#endif
+
+#define POLYPHASE_TAPS          BTSTACK_RESAMPLE_POLYPHASE_TAPS
+#define POLYPHASE_HISTORY       (POLYPHASE_TAPS - 1)
+#define POLYPHASE_PHASE_BITS    7
+#define POLYPHASE_INTERP_BITS   (16 - POLYPHASE_PHASE_BITS)
+#define POLYPHASE_NUM_PHASES    (1 << POLYPHASE_PHASE_BITS)
+
+// Kaiser windowed sinc, cutoff 0.48 fs, beta 6, centered on tap 7 + phase / 128, each row normalized to 1.0 in Q15.
+// Row 128 is row 0 delayed by one tap and allows to interpolate between adjacent phases.
+static const int16_t polyphase_coefficients[POLYPHASE_NUM_PHASES + 1][POLYPHASE_TAPS] = {
+    {    77,   -195,    375,   -606,    859,  -1090,   1252,  31440,   1252,  -1090,    859,   -606,    375,   -195,     77,    -16},
+    {    75,   -188,    360,   -577,    804,   -984,   1009,  31438,   1497,  -1196,    915,   -635,    389,   -201,     79,    -17},
+    {    73,   -182,    346,   -548,    749,   -879,    770,  31427,   1747,  -1302,    970,   -664,    403,   -207,     82,    -17},
+    {    70,   -176,    332,   -519,    694,   -775,    535,  31415,   1999,  -1409,   1025,   -693,    417,   -213,     84,    -18},
+    {    68,   -169,    317,   -490,    639,   -671,    303,  31395,   2255,  -1516,   1080,   -722,    431,   -219,     86,    -19},
+    {    66,   -163,    303,   -461,    584,   -568,     75,  31368,   2514,  -1624,   1135,   -750,    445,   -225,     88,    -19},
+    {    64,   -157,    288,   -432,    530,   -466,   -149,  31336,   2776,  -1731,   1190,   -779,    459,   -231,     90,    -20},
+    {    61,   -150,    274,   -403,    475,   -365,   -370,  31297,   3041,  -1839,   1245,   -807,    473,   -237,     93,    -20},
+    {    59,   -144,    259,   -374,    421,   -264,   -587,  31255,   3309,  -1947,   1299,   -835,    486,   -243,     95,    -21},
+    {    57,   -138,    245,   -345,    367,   -164,   -800,  31202,   3581,  -2055,   1354,   -863,    500,   -249,     97,    -21},
+    {    55,   -131,    230,   -316,    314,    -65,  -1010,  31146,   3855,  -2163,   1408,   -890,    513,   -255,     99,    -22},
+    {    52,   -125,    216,   -287,    260,     32,  -1215,  31086,   4132,  -2271,   1461,   -918,    526,   -260,    101,    -22},
+    {    50,   -119,    202,   -259,    208,    129,  -1417,  31019,   4411,  -2379,   1515,   -945,    539,   -266,    103,    -23},
+    {    48,   -112,    187,   -230,    155,    225,  -1614,  30945,   4693,  -2486,   1568,   -972,    552,   -272,    105,    -24},
+    {    46,   -106,    173,   -202,    103,    320,  -1808,  30864,   4978,  -2594,   1621,   -998,    565,   -277,    107,    -24},
+    {    43,   -100,    159,   -174,     51,    413,  -1998,  30781,   5266,  -2701,   1673,  -1024,    577,   -282,    109,    -25},
+    {    41,    -93,    145,   -146,      0,    505,  -2183,  30687,   5556,  -2807,   1725,  -1050,    589,   -287,    111,    -25},
+    {    39,    -87,    131,   -118,    -51,    596,  -2365,  30593,   5848,  -2913,   1776,  -1076,    601,   -293,    113,    -26},
+    {    37,    -81,    117,    -90,   -101,    686,  -2542,  30490,   6142,  -3019,   1827,  -1101,    613,   -298,    114,    -26},
+    {    35,    -75,    103,    -63,   -151,    775,  -2715,  30381,   6439,  -3124,   1877,  -1126,    625,   -302,    116,    -27},
+    {    33,    -69,     89,    -36,   -200,    862,  -2885,  30269,   6738,  -3229,   1926,  -1150,    636,   -307,    118,    -27},
+    {    31,    -63,     75,     -9,   -248,    948,  -3050,  30150,   7039,  -3332,   1975,  -1174,    647,   -312,    119,    -28},
+    {    28,    -57,     62,     18,   -296,   1032,  -3210,  30023,   7342,  -3435,   2023,  -1197,    658,   -316,    121,    -28},
+    {    26,    -51,     48,     44,   -344,   1115,  -3367,  29894,   7647,  -3537,   2071,  -1220,    669,   -321,    123,    -29},
+    {    24,    -45,     35,     70,   -390,   1196,  -3519,  29759,   7953,  -3639,   2118,  -1243,    679,   -325,    124,    -29},
+    {    22,    -39,     22,     96,   -436,   1276,  -3668,  29615,   8262,  -3739,   2164,  -1264,    689,   -329,    126,    -29},
+    {    20,    -33,      9,    121,   -482,   1355,  -3811,  29470,   8572,  -3838,   2209,  -1286,    698,   -333,    127,    -30},
+    {    18,    -28,     -4,    146,   -526,   1431,  -3951,  29320,   8883,  -3936,   2253,  -1307,    708,   -337,    128,    -30},
+    {    16,    -22,    -17,    171,   -570,   1507,  -4087,  29161,   9196,  -4033,   2297,  -1327,    717,   -340,    130,    -31},
+    {    15,    -16,    -30,    195,   -614,   1580,  -4218,  29001,   9510,  -4129,   2339,  -1347,    726,   -344,    131,    -31},
+    {    13,    -11,    -42,    219,   -656,   1652,  -4345,  28832,   9826,  -4223,   2381,  -1366,    734,   -347,    132,    -31},
+    {    11,     -5,    -54,    243,   -698,   1723,  -4467,  28660,  10142,  -4316,   2421,  -1385,    742,   -350,    133,    -32},
+    {     9,      0,    -66,    266,   -738,   1791,  -4586,  28482,  10460,  -4408,   2461,  -1402,    750,   -353,    134,    -32},
+    {     7,      5,    -78,    289,   -779,   1858,  -4700,  28301,  10779,  -4498,   2500,  -1420,    757,   -356,    135,    -32},
+    {     6,     10,    -90,    312,   -818,   1923,  -4810,  28114,  11098,  -4587,   2537,  -1436,    764,   -358,    136,    -33},
+    {     4,     16,   -101,    334,   -856,   1987,  -4915,  27920,  11419,  -4674,   2573,  -1452,    770,   -361,    137,    -33},
+    {     2,     21,   -113,    355,   -894,   2049,  -5017,  27725,  11740,  -4759,   2609,  -1468,    777,   -363,    137,    -33},
+    {     1,     26,   -124,    377,   -930,   2108,  -5114,  27524,  12061,  -4843,   2643,  -1482,    782,   -365,    138,    -34},
+    {    -1,     30,   -135,    397,   -966,   2167,  -5206,  27316,  12384,  -4924,   2676,  -1496,    788,   -367,    139,    -34},
+    {    -3,     35,   -145,    418,  -1001,   2223,  -5295,  27107,  12706,  -5004,   2707,  -1509,    793,   -369,    139,    -34},
+    {    -4,     40,   -156,    438,  -1035,   2277,  -5379,  26891,  13029,  -5082,   2738,  -1521,    797,   -370,    139,    -34},
+    {    -6,     44,   -166,    457,  -1068,   2330,  -5460,  26673,  13352,  -5158,   2767,  -1533,    801,   -371,    140,    -34},
+    {    -7,     49,   -176,    476,  -1100,   2381,  -5536,  26448,  13675,  -5231,   2794,  -1544,    805,   -372,    140,    -34},
+    {    -9,     53,   -186,    495,  -1131,   2429,  -5608,  26222,  13998,  -5303,   2821,  -1554,    808,   -373,    140,    -34},
+    {   -10,     57,   -195,    513,  -1161,   2477,  -5675,  25988,  14321,  -5372,   2846,  -1563,    811,   -374,    140,    -35},
+    {   -11,     62,   -205,    530,  -1191,   2522,  -5739,  25751,  14644,  -5439,   2870,  -1571,    814,   -374,    140,    -35},
+    {   -13,     66,   -214,    547,  -1219,   2565,  -5798,  25512,  14967,  -5504,   2892,  -1579,    815,   -374,    140,    -35},
+    {   -14,     70,   -223,    564,  -1246,   2606,  -5854,  25268,  15289,  -5567,   2912,  -1585,    817,   -374,    140,    -35},
+    {   -15,     73,   -231,    580,  -1273,   2646,  -5905,  25020,  15610,  -5626,   2932,  -1591,    818,   -374,    139,    -35},
+    {   -16,     77,   -240,    595,  -1298,   2683,  -5952,  24769,  15931,  -5684,   2949,  -1596,    818,   -373,    139,    -34},
+    {   -17,     81,   -248,    610,  -1322,   2719,  -5995,  24510,  16252,  -5738,   2966,  -1600,    818,   -372,    138,    -34},
+    {   -19,     84,   -256,    625,  -1346,   2753,  -6035,  24254,  16571,  -5791,   2980,  -1603,    818,   -371,    138,    -34},
+    {   -20,     88,   -263,    639,  -1368,   2785,  -6070,  23990,  16889,  -5840,   2993,  -1605,    817,   -370,    137,    -34},
+    {   -21,     91,   -271,    652,  -1390,   2814,  -6102,  23728,  17207,  -5887,   3005,  -1607,    815,   -368,    136,    -34},
+    {   -22,     94,   -278,    665,  -1410,   2842,  -6129,  23457,  17523,  -5930,   3015,  -1607,    814,   -367,    135,    -34},
+    {   -23,     97,   -285,    678,  -1429,   2869,  -6153,  23183,  17838,  -5971,   3023,  -1606,    811,   -365,    134,    -33},
+    {   -24,    100,   -291,    690,  -1448,   2893,  -6173,  22908,  18152,  -6009,   3029,  -1605,    808,   -362,    133,    -33},
+    {   -24,    103,   -298,    701,  -1465,   2915,  -6189,  22629,  18464,  -6044,   3034,  -1602,    805,   -360,    132,    -33},
+    {   -25,    106,   -304,    712,  -1481,   2936,  -6201,  22345,  18775,  -6076,   3037,  -1599,    801,   -357,    131,    -32},
+    {   -26,    109,   -310,    722,  -1497,   2954,  -6210,  22064,  19084,  -6105,   3039,  -1595,    796,   -354,    129,    -32},
+    {   -27,    111,   -315,    732,  -1511,   2971,  -6215,  21775,  19392,  -6130,   3038,  -1589,    791,   -351,    128,    -32},
+    {   -28,    114,   -321,    741,  -1524,   2986,  -6217,  21486,  19697,  -6153,   3036,  -1583,    786,   -347,    126,    -31},
+    {   -28,    116,   -326,    750,  -1537,   2999,  -6215,  21196,  20001,  -6172,   3032,  -1576,    779,   -344,    124,    -31},
+    {   -29,    118,   -331,    758,  -1548,   3010,  -6209,  20899,  20302,  -6188,   3027,  -1567,    773,   -339,    122,    -30},
+    {   -29,    120,   -335,    766,  -1558,   3019,  -6200,  20600,  20602,  -6200,   3019,  -1558,    766,   -335,    120,    -29},
+    {   -30,    122,   -339,    773,  -1567,   3027,  -6188,  20302,  20899,  -6209,   3010,  -1548,    758,   -331,    118,    -29},
+    {   -31,    124,   -344,    779,  -1576,   3032,  -6172,  20001,  21196,  -6215,   2999,  -1537,    750,   -326,    116,    -28},
+    {   -31,    126,   -347,    786,  -1583,   3036,  -6153,  19697,  21486,  -6217,   2986,  -1524,    741,   -321,    114,    -28},
+    {   -32,    128,   -351,    791,  -1589,   3038,  -6130,  19392,  21775,  -6215,   2971,  -1511,    732,   -315,    111,    -27},
+    {   -32,    129,   -354,    796,  -1595,   3039,  -6105,  19084,  22064,  -6210,   2954,  -1497,    722,   -310,    109,    -26},
+    {   -32,    131,   -357,    801,  -1599,   3037,  -6076,  18775,  22345,  -6201,   2936,  -1481,    712,   -304,    106,    -25},
+    {   -33,    132,   -360,    805,  -1602,   3034,  -6044,  18464,  22629,  -6189,   2915,  -1465,    701,   -298,    103,    -24},
+    {   -33,    133,   -362,    808,  -1605,   3029,  -6009,  18152,  22908,  -6173,   2893,  -1448,    690,   -291,    100,    -24},
+    {   -33,    134,   -365,    811,  -1606,   3023,  -5971,  17838,  23183,  -6153,   2869,  -1429,    678,   -285,     97,    -23},
+    {   -34,    135,   -367,    814,  -1607,   3015,  -5930,  17523,  23457,  -6129,   2842,  -1410,    665,   -278,     94,    -22},
+    {   -34,    136,   -368,    815,  -1607,   3005,  -5887,  17207,  23728,  -6102,   2814,  -1390,    652,   -271,     91,    -21},
+    {   -34,    137,   -370,    817,  -1605,   2993,  -5840,  16889,  23990,  -6070,   2785,  -1368,    639,   -263,     88,    -20},
+    {   -34,    138,   -371,    818,  -1603,   2980,  -5791,  16571,  24254,  -6035,   2753,  -1346,    625,   -256,     84,    -19},
+    {   -34,    138,   -372,    818,  -1600,   2966,  -5738,  16252,  24510,  -5995,   2719,  -1322,    610,   -248,     81,    -17},
+    {   -34,    139,   -373,    818,  -1596,   2949,  -5684,  15931,  24769,  -5952,   2683,  -1298,    595,   -240,     77,    -16},
+    {   -35,    139,   -374,    818,  -1591,   2932,  -5626,  15610,  25020,  -5905,   2646,  -1273,    580,   -231,     73,    -15},
+    {   -35,    140,   -374,    817,  -1585,   2912,  -5567,  15289,  25268,  -5854,   2606,  -1246,    564,   -223,     70,    -14},
+    {   -35,    140,   -374,    815,  -1579,   2892,  -5504,  14967,  25512,  -5798,   2565,  -1219,    547,   -214,     66,    -13},
+    {   -35,    140,   -374,    814,  -1571,   2870,  -5439,  14644,  25751,  -5739,   2522,  -1191,    530,   -205,     62,    -11},
+    {   -35,    140,   -374,    811,  -1563,   2846,  -5372,  14321,  25988,  -5675,   2477,  -1161,    513,   -195,     57,    -10},
+    {   -34,    140,   -373,    808,  -1554,   2821,  -5303,  13998,  26222,  -5608,   2429,  -1131,    495,   -186,     53,     -9},
+    {   -34,    140,   -372,    805,  -1544,   2794,  -5231,  13675,  26448,  -5536,   2381,  -1100,    476,   -176,     49,     -7},
+    {   -34,    140,   -371,    801,  -1533,   2767,  -5158,  13352,  26673,  -5460,   2330,  -1068,    457,   -166,     44,     -6},
+    {   -34,    139,   -370,    797,  -1521,   2738,  -5082,  13029,  26891,  -5379,   2277,  -1035,    438,   -156,     40,     -4},
+    {   -34,    139,   -369,    793,  -1509,   2707,  -5004,  12706,  27107,  -5295,   2223,  -1001,    418,   -145,     35,     -3},
+    {   -34,    139,   -367,    788,  -1496,   2676,  -4924,  12384,  27316,  -5206,   2167,   -966,    397,   -135,     30,     -1},
+    {   -34,    138,   -365,    782,  -1482,   2643,  -4843,  12061,  27524,  -5114,   2108,   -930,    377,   -124,     26,      1},
+    {   -33,    137,   -363,    777,  -1468,   2609,  -4759,  11740,  27725,  -5017,   2049,   -894,    355,   -113,     21,      2},
+    {   -33,    137,   -361,    770,  -1452,   2573,  -4674,  11419,  27920,  -4915,   1987,   -856,    334,   -101,     16,      4},
+    {   -33,    136,   -358,    764,  -1436,   2537,  -4587,  11098,  28114,  -4810,   1923,   -818,    312,    -90,     10,      6},
+    {   -32,    135,   -356,    757,  -1420,   2500,  -4498,  10779,  28301,  -4700,   1858,   -779,    289,    -78,      5,      7},
+    {   -32,    134,   -353,    750,  -1402,   2461,  -4408,  10460,  28482,  -4586,   1791,   -738,    266,    -66,      0,      9},
+    {   -32,    133,   -350,    742,  -1385,   2421,  -4316,  10142,  28660,  -4467,   1723,   -698,    243,    -54,     -5,     11},
+    {   -31,    132,   -347,    734,  -1366,   2381,  -4223,   9826,  28832,  -4345,   1652,   -656,    219,    -42,    -11,     13},
+    {   -31,    131,   -344,    726,  -1347,   2339,  -4129,   9510,  29001,  -4218,   1580,   -614,    195,    -30,    -16,     15},
+    {   -31,    130,   -340,    717,  -1327,   2297,  -4033,   9196,  29161,  -4087,   1507,   -570,    171,    -17,    -22,     16},
+    {   -30,    128,   -337,    708,  -1307,   2253,  -3936,   8883,  29320,  -3951,   1431,   -526,    146,     -4,    -28,     18},
+    {   -30,    127,   -333,    698,  -1286,   2209,  -3838,   8572,  29470,  -3811,   1355,   -482,    121,      9,    -33,     20},
+    {   -29,    126,   -329,    689,  -1264,   2164,  -3739,   8262,  29615,  -3668,   1276,   -436,     96,     22,    -39,     22},
+    {   -29,    124,   -325,    679,  -1243,   2118,  -3639,   7953,  29759,  -3519,   1196,   -390,     70,     35,    -45,     24},
+    {   -29,    123,   -321,    669,  -1220,   2071,  -3537,   7647,  29894,  -3367,   1115,   -344,     44,     48,    -51,     26},
+    {   -28,    121,   -316,    658,  -1197,   2023,  -3435,   7342,  30023,  -3210,   1032,   -296,     18,     62,    -57,     28},
+    {   -28,    119,   -312,    647,  -1174,   1975,  -3332,   7039,  30150,  -3050,    948,   -248,     -9,     75,    -63,     31},
+    {   -27,    118,   -307,    636,  -1150,   1926,  -3229,   6738,  30269,  -2885,    862,   -200,    -36,     89,    -69,     33},
+    {   -27,    116,   -302,    625,  -1126,   1877,  -3124,   6439,  30381,  -2715,    775,   -151,    -63,    103,    -75,     35},
+    {   -26,    114,   -298,    613,  -1101,   1827,  -3019,   6142,  30490,  -2542,    686,   -101,    -90,    117,    -81,     37},
+    {   -26,    113,   -293,    601,  -1076,   1776,  -2913,   5848,  30593,  -2365,    596,    -51,   -118,    131,    -87,     39},
+    {   -25,    111,   -287,    589,  -1050,   1725,  -2807,   5556,  30687,  -2183,    505,      0,   -146,    145,    -93,     41},
+    {   -25,    109,   -282,    577,  -1024,   1673,  -2701,   5266,  30781,  -1998,    413,     51,   -174,    159,   -100,     43},
+    {   -24,    107,   -277,    565,   -998,   1621,  -2594,   4978,  30864,  -1808,    320,    103,   -202,    173,   -106,     46},
+    {   -24,    105,   -272,    552,   -972,   1568,  -2486,   4693,  30945,  -1614,    225,    155,   -230,    187,   -112,     48},
+    {   -23,    103,   -266,    539,   -945,   1515,  -2379,   4411,  31019,  -1417,    129,    208,   -259,    202,   -119,     50},
+    {   -22,    101,   -260,    526,   -918,   1461,  -2271,   4132,  31086,  -1215,     32,    260,   -287,    216,   -125,     52},
+    {   -22,     99,   -255,    513,   -890,   1408,  -2163,   3855,  31146,  -1010,    -65,    314,   -316,    230,   -131,     55},
+    {   -21,     97,   -249,    500,   -863,   1354,  -2055,   3581,  31202,   -800,   -164,    367,   -345,    245,   -138,     57},
+    {   -21,     95,   -243,    486,   -835,   1299,  -1947,   3309,  31255,   -587,   -264,    421,   -374,    259,   -144,     59},
+    {   -20,     93,   -237,    473,   -807,   1245,  -1839,   3041,  31297,   -370,   -365,    475,   -403,    274,   -150,     61},
+    {   -20,     90,   -231,    459,   -779,   1190,  -1731,   2776,  31336,   -149,   -466,    530,   -432,    288,   -157,     64},
+    {   -19,     88,   -225,    445,   -750,   1135,  -1624,   2514,  31368,     75,   -568,    584,   -461,    303,   -163,     66},
+    {   -19,     86,   -219,    431,   -722,   1080,  -1516,   2255,  31395,    303,   -671,    639,   -490,    317,   -169,     68},
+    {   -18,     84,   -213,    417,   -693,   1025,  -1409,   1999,  31415,    535,   -775,    694,   -519,    332,   -176,     70},
+    {   -17,     82,   -207,    403,   -664,    970,  -1302,   1747,  31427,    770,   -879,    749,   -548,    346,   -182,     73},
+    {   -17,     79,   -201,    389,   -635,    915,  -1196,   1497,  31438,   1009,   -984,    804,   -577,    360,   -188,     75},
+    {   -16,     77,   -195,    375,   -606,    859,  -1090,   1252,  31440,   1252,  -1090,    859,   -606,    375,   -195,     77}
+};
+#endif
+
 void btstack_resample_init(btstack_resample_t * context, int num_channels){
     context->src_pos = 0;
     context->src_step = 0x10000;  // default resampling 1.0
     context->last_sample[0] = 0;
     context->last_sample[1] = 0;
     context->num_channels   = num_channels;
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+    context->polyphase = 0;
+#endif
 }
 
 void btstack_resample_set_factor(btstack_resample_t * context, uint32_t src_step){
     context->src_step = src_step;
 }
 
-uint16_t btstack_resample_block(btstack_resample_t * context, const int16_t * input_buffer, uint32_t num_frames, int16_t * output_buffer){
+static uint16_t btstack_resample_block_linear(btstack_resample_t * context, const int16_t * input_buffer, uint32_t num_frames, int16_t * output_buffer){
     uint16_t dest_frames = 0;
     uint16_t dest_samples = 0;
     // samples between last sample of previous block and first sample in current block 
@@ -95,3 +251,141 @@ uint16_t btstack_resample_block(btstack_resample_t * context, const int16_t * in
     }
     return dest_frames;
 }
+
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+
+void btstack_resample_init_polyphase(btstack_resample_t * context, int num_channels){
+    btstack_resample_init(context, num_channels);
+    context->polyphase = 1;
+    memset(context->history, 0, sizeof(context->history));
+}
+
+// dot product of POLYPHASE_TAPS frames with coefficients, one Q30 accumulator per channel
+static void btstack_resample_polyphase_fir(const int16_t * frames, const int16_t * coefficients, int num_channels, int32_t * accumulators){
+#if defined(RESAMPLE_POLYPHASE_SSE2)
+    const __m128i h0 = _mm_loadu_si128((const __m128i *) &coefficients[0]);
+    const __m128i h1 = _mm_loadu_si128((const __m128i *) &coefficients[8]);
+    __m128i sum;
+    if (num_channels == 2){
+        // reorder L0 R0 L1 R1 to L0 L1 R0 R1, so madd with h0 h1 h0 h1 keeps channels apart
+        const __m128i c0 = _mm_unpacklo_epi32(h0, h0);
+        const __m128i c1 = _mm_unpackhi_epi32(h0, h0);
+        const __m128i c2 = _mm_unpacklo_epi32(h1, h1);
+        const __m128i c3 = _mm_unpackhi_epi32(h1, h1);
+        __m128i x[4];
+        int i;
+        for (i=0;i<4;i++){
+            __m128i v = _mm_loadu_si128((const __m128i *) &frames[i*8]);
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3,1,2,0));
+            x[i] = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3,1,2,0));
+        }
+        sum = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(x[0], c0), _mm_madd_epi16(x[1], c1)),
+                            _mm_add_epi32(_mm_madd_epi16(x[2], c2), _mm_madd_epi16(x[3], c3)));
+        // lanes L R L R -> L R
+        sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+        accumulators[0] = _mm_cvtsi128_si32(sum);
+        accumulators[1] = _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+    } else {
+        sum = _mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *) &frames[0]), h0),
+                            _mm_madd_epi16(_mm_loadu_si128((const __m128i *) &frames[8]), h1));
+        sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+        sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+        accumulators[0] = _mm_cvtsi128_si32(sum);
+    }
+#elif defined(RESAMPLE_POLYPHASE_NEON)
+    const int16x8_t h0 = vld1q_s16(&coefficients[0]);
+    const int16x8_t h1 = vld1q_s16(&coefficients[8]);
+    if (num_channels == 2){
+        // de-interleave into left and right
+        int16x8x2_t x0 = vld2q_s16(&frames[0]);
+        int16x8x2_t x1 = vld2q_s16(&frames[16]);
+        int i;
+        for (i=0;i<2;i++){
+            int32x4_t sum = vmull_s16(vget_low_s16(x0.val[i]), vget_low_s16(h0));
+            sum = vmlal_s16(sum, vget_high_s16(x0.val[i]), vget_high_s16(h0));
+            sum = vmlal_s16(sum, vget_low_s16(x1.val[i]),  vget_low_s16(h1));
+            sum = vmlal_s16(sum, vget_high_s16(x1.val[i]), vget_high_s16(h1));
+            int32x2_t pair = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+            accumulators[i] = vget_lane_s32(vpadd_s32(pair, pair), 0);
+        }
+    } else {
+        int16x8_t x0 = vld1q_s16(&frames[0]);
+        int16x8_t x1 = vld1q_s16(&frames[8]);
+        int32x4_t sum = vmull_s16(vget_low_s16(x0), vget_low_s16(h0));
+        sum = vmlal_s16(sum, vget_high_s16(x0), vget_high_s16(h0));
+        sum = vmlal_s16(sum, vget_low_s16(x1),  vget_low_s16(h1));
+        sum = vmlal_s16(sum, vget_high_s16(x1), vget_high_s16(h1));
+        int32x2_t pair = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+        accumulators[0] = vget_lane_s32(vpadd_s32(pair, pair), 0);
+    }
+#else
+    int i;
+    for (i=0;i<num_channels;i++){
+        int32_t sum = 0;
+        int k;
+        for (k=0;k<POLYPHASE_TAPS;k++){
+            sum += frames[k * num_channels + i] * coefficients[k];
+        }
+        accumulators[i] = sum;
+    }
+#endif
+}
+
+static uint16_t btstack_resample_block_polyphase(btstack_resample_t * context, const int16_t * input_buffer, uint32_t num_frames, int16_t * output_buffer){
+    const int num_channels = context->num_channels;
+    uint16_t dest_frames = 0;
+    uint16_t dest_samples = 0;
+
+    // filter reaches back POLYPHASE_HISTORY frames, provide them in front of the first input frames
+    int16_t  stitched[2 * POLYPHASE_HISTORY * BTSTACK_RESAMPLE_MAX_CHANNELS];
+    uint32_t num_stitched_frames = (num_frames < POLYPHASE_HISTORY) ? num_frames : POLYPHASE_HISTORY;
+    memcpy(stitched, context->history, POLYPHASE_HISTORY * num_channels * sizeof(int16_t));
+    memcpy(&stitched[POLYPHASE_HISTORY * num_channels], input_buffer, num_stitched_frames * num_channels * sizeof(int16_t));
+
+    while (true){
+        const uint32_t src_pos = context->src_pos >> 16;
+        if (src_pos >= num_frames) break;
+        const int16_t * frames;
+        if (src_pos < POLYPHASE_HISTORY){
+            frames = &stitched[src_pos * num_channels];
+        } else {
+            frames = &input_buffer[(src_pos - POLYPHASE_HISTORY) * num_channels];
+        }
+        const uint16_t phase  = (context->src_pos & 0xffff) >> POLYPHASE_INTERP_BITS;
+        const int32_t  interp = context->src_pos & ((1 << POLYPHASE_INTERP_BITS) - 1);
+        int32_t acc_0[BTSTACK_RESAMPLE_MAX_CHANNELS];
+        int32_t acc_1[BTSTACK_RESAMPLE_MAX_CHANNELS];
+        btstack_resample_polyphase_fir(frames, polyphase_coefficients[phase],     num_channels, acc_0);
+        btstack_resample_polyphase_fir(frames, polyphase_coefficients[phase + 1], num_channels, acc_1);
+        int i;
+        for (i=0;i<num_channels;i++){
+            // interpolate between adjacent phases, round and saturate
+            int64_t acc = acc_0[i] + ((((int64_t) acc_1[i] - acc_0[i]) * interp) >> POLYPHASE_INTERP_BITS);
+            acc = (acc + 0x4000) >> 15;
+            if (acc >  32767) acc =  32767;
+            if (acc < -32768) acc = -32768;
+            output_buffer[dest_samples++] = (int16_t) acc;
+        }
+        dest_frames++;
+        context->src_pos += context->src_step;
+    }
+
+    // keep last POLYPHASE_HISTORY frames for next block
+    if (num_frames >= POLYPHASE_HISTORY){
+        memcpy(context->history, &input_buffer[(num_frames - POLYPHASE_HISTORY) * num_channels], POLYPHASE_HISTORY * num_channels * sizeof(int16_t));
+    } else {
+        memcpy(context->history, &stitched[num_frames * num_channels], POLYPHASE_HISTORY * num_channels * sizeof(int16_t));
+    }
+    context->src_pos -= num_frames << 16;
+    return dest_frames;
+}
+#endif
+
+uint16_t btstack_resample_block(btstack_resample_t * context, const int16_t * input_buffer, uint32_t num_frames, int16_t * output_buffer){
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+    if (context->polyphase){
+        return btstack_resample_block_polyphase(context, input_buffer, num_frames, output_buffer);
+    }
+#endif
+    return btstack_resample_block_linear(context, input_buffer, num_frames, output_buffer);
+}
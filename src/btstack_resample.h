@@ -38,6 +38,8 @@
 #ifndef BTSTACK_RESAMPLE_H
 #define BTSTACK_RESAMPLE_H
 
+#include "btstack_config.h"
+
 #include <stdint.h>
 
 #if defined __cplusplus
@@ -48,15 +50,24 @@ extern "C" {
  *  btstack_resample.h
  *
  *  Linear resampling for 16-bit audio code samples using 16 bit/16 bit fixed point math
+ *
+ *  With ENABLE_RESAMPLE_POLYPHASE, a 16-tap polyphase FIR with 128 phases can be used instead,
+ *  which delays the audio by 7 frames
  */
 
 #define BTSTACK_RESAMPLE_MAX_CHANNELS 2
 
+#define BTSTACK_RESAMPLE_POLYPHASE_TAPS 16
+
 typedef struct {
     uint32_t src_pos;
     uint32_t src_step;
     int16_t  last_sample[BTSTACK_RESAMPLE_MAX_CHANNELS];
     int      num_channels;
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+    int      polyphase;
+    int16_t  history[(BTSTACK_RESAMPLE_POLYPHASE_TAPS - 1) * BTSTACK_RESAMPLE_MAX_CHANNELS];
+#endif
 } btstack_resample_t;
 
 /**
@@ -66,6 +77,14 @@ typedef struct {
  */
 void btstack_resample_init(btstack_resample_t * context, int num_channels);
 
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+/**
+ * @brief Init resample context for polyphase FIR resampling with less aliasing than linear interpolation
+ * @param num_channels
+ */
+void btstack_resample_init_polyphase(btstack_resample_t * context, int num_channels);
+#endif
+
 /**
  * @brief Set resampling factor
  * @param factor as fixed point value, identity is 0x10000
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_ring_buffer_spsc.c"
+
+/*
+ *  btstack_ring_buffer_spsc.c
+ *
+ */
+
+#include <string.h>
+
+#include "btstack_ring_buffer_spsc.h"
+
+#define ERROR_CODE_MEMORY_CAPACITY_EXCEEDED 0x07
+
+// acquire/release on indices: data is written before write index is published and read before read index is released
+#if defined(__GNUC__) || defined(__clang__)
+#define SPSC_LOAD_ACQUIRE(index)         __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define SPSC_STORE_RELEASE(index, value) __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+#elif !defined(__cplusplus) && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+static inline uint32_t spsc_load_acquire(volatile uint32_t * index){
+    uint32_t value = *index;
+    atomic_thread_fence(memory_order_acquire);
+    return value;
+}
+static inline void spsc_store_release(volatile uint32_t * index, uint32_t value){
+    atomic_thread_fence(memory_order_release);
+    *index = value;
+}
+#define SPSC_LOAD_ACQUIRE(index)         spsc_load_acquire(&(index))
+#define SPSC_STORE_RELEASE(index, value) spsc_store_release(&(index), (value))
+#else
+// volatile access only, sufficient for single-core MCUs without store reordering
+#define SPSC_LOAD_ACQUIRE(index)         (index)
+#define SPSC_STORE_RELEASE(index, value) ((index) = (value))
+#endif
+
+static uint32_t btstack_ring_buffer_spsc_min(uint32_t a, uint32_t b){
+    return (a < b) ? a : b;
+}
+
+void btstack_ring_buffer_spsc_init(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * storage, uint32_t storage_size){
+    // use largest power of two that fits into storage
+    uint32_t size = 1;
+    while ((size << 1) != 0 && (size << 1) <= storage_size){
+        size <<= 1;
+    }
+    ring_buffer->storage   = (storage_size == 0) ? NULL : storage;
+    ring_buffer->size_mask = size - 1;
+    btstack_ring_buffer_spsc_reset(ring_buffer);
+}
+
+void btstack_ring_buffer_spsc_reset(btstack_ring_buffer_spsc_t * ring_buffer){
+    ring_buffer->write_index = 0;
+    ring_buffer->read_index  = 0;
+}
+
+static uint32_t btstack_ring_buffer_spsc_size(btstack_ring_buffer_spsc_t * ring_buffer){
+    return (ring_buffer->storage == NULL) ? 0 : (ring_buffer->size_mask + 1);
+}
+
+uint32_t btstack_ring_buffer_spsc_bytes_available(btstack_ring_buffer_spsc_t * ring_buffer){
+    return SPSC_LOAD_ACQUIRE(ring_buffer->write_index) - ring_buffer->read_index;
+}
+
+uint32_t btstack_ring_buffer_spsc_bytes_free(btstack_ring_buffer_spsc_t * ring_buffer){
+    return btstack_ring_buffer_spsc_size(ring_buffer) - (ring_buffer->write_index - SPSC_LOAD_ACQUIRE(ring_buffer->read_index));
+}
+
+uint8_t * btstack_ring_buffer_spsc_get_write_region(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_size){
+    uint32_t offset = ring_buffer->write_index & ring_buffer->size_mask;
+    uint32_t bytes_until_end = btstack_ring_buffer_spsc_size(ring_buffer) - offset;
+    *region_size = btstack_ring_buffer_spsc_min(bytes_until_end, btstack_ring_buffer_spsc_bytes_free(ring_buffer));
+    return &ring_buffer->storage[offset];
+}
+
+void btstack_ring_buffer_spsc_write_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes){
+    SPSC_STORE_RELEASE(ring_buffer->write_index, ring_buffer->write_index + num_bytes);
+}
+
+int btstack_ring_buffer_spsc_write(btstack_ring_buffer_spsc_t * ring_buffer, const uint8_t * data, uint32_t data_length){
+    if (btstack_ring_buffer_spsc_bytes_free(ring_buffer) < data_length){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+
+    // copy first chunk until end of storage, then remaining data from start
+    uint32_t offset = ring_buffer->write_index & ring_buffer->size_mask;
+    uint32_t bytes_to_copy = btstack_ring_buffer_spsc_min(btstack_ring_buffer_spsc_size(ring_buffer) - offset, data_length);
+    (void)memcpy(&ring_buffer->storage[offset], data, bytes_to_copy);
+    (void)memcpy(ring_buffer->storage, &data[bytes_to_copy], data_length - bytes_to_copy);
+
+    btstack_ring_buffer_spsc_write_commit(ring_buffer, data_length);
+    return 0;
+}
+
+const uint8_t * btstack_ring_buffer_spsc_get_read_region(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_size){
+    uint32_t offset = ring_buffer->read_index & ring_buffer->size_mask;
+    uint32_t bytes_until_end = btstack_ring_buffer_spsc_size(ring_buffer) - offset;
+    *region_size = btstack_ring_buffer_spsc_min(bytes_until_end, btstack_ring_buffer_spsc_bytes_available(ring_buffer));
+    return &ring_buffer->storage[offset];
+}
+
+void btstack_ring_buffer_spsc_read_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes){
+    SPSC_STORE_RELEASE(ring_buffer->read_index, ring_buffer->read_index + num_bytes);
+}
+
+uint32_t btstack_ring_buffer_spsc_peek(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * buffer, uint32_t length){
+    length = btstack_ring_buffer_spsc_min(length, btstack_ring_buffer_spsc_bytes_available(ring_buffer));
+
+    // copy first chunk until end of storage, then remaining data from start
+    uint32_t offset = ring_buffer->read_index & ring_buffer->size_mask;
+    uint32_t bytes_to_copy = btstack_ring_buffer_spsc_min(btstack_ring_buffer_spsc_size(ring_buffer) - offset, length);
+    (void)memcpy(buffer, &ring_buffer->storage[offset], bytes_to_copy);
+    (void)memcpy(&buffer[bytes_to_copy], ring_buffer->storage, length - bytes_to_copy);
+    return length;
+}
+
+void btstack_ring_buffer_spsc_read(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * buffer, uint32_t length, uint32_t * number_of_bytes_read){
+    uint32_t bytes_read = btstack_ring_buffer_spsc_peek(ring_buffer, buffer, length);
+    btstack_ring_buffer_spsc_read_commit(ring_buffer, bytes_read);
+    *number_of_bytes_read = bytes_read;
+}
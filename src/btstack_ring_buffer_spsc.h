@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_ring_buffer_spsc.h
+ *
+ *  Lock-free ring buffer for a single producer and a single consumer, e.g. BTstack thread and audio callback.
+ *  Storage size has to be a power of two. Producer only updates write index, consumer only updates read index.
+ */
+
+#ifndef BTSTACK_RING_BUFFER_SPSC_H
+#define BTSTACK_RING_BUFFER_SPSC_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef struct btstack_ring_buffer_spsc {
+    uint8_t  * storage;
+    uint32_t size_mask;
+    // free-running indices, only written by producer resp. consumer
+    volatile uint32_t write_index;
+    volatile uint32_t read_index;
+} btstack_ring_buffer_spsc_t;
+
+/* API_START */
+
+/**
+ * Init ring buffer
+ * @param ring_buffer object
+ * @param storage
+ * @param storage_size in bytes, power of two. Otherwise, only the largest power of two below is used
+ */
+void btstack_ring_buffer_spsc_init(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * storage, uint32_t storage_size);
+
+/**
+ * Reset ring buffer, must not be called while producer or consumer are active
+ * @param ring_buffer object
+ */
+void btstack_ring_buffer_spsc_reset(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get number of bytes available for read, called by consumer
+ * @param ring_buffer object
+ * @return number of bytes available for read
+ */
+uint32_t btstack_ring_buffer_spsc_bytes_available(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get free space available for write, called by producer
+ * @param ring_buffer object
+ * @return number of bytes available for write
+ */
+uint32_t btstack_ring_buffer_spsc_bytes_free(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get contiguous region for writing without copy, called by producer
+ * @param ring_buffer object
+ * @param region_size of free contiguous region
+ * @return pointer to region
+ */
+uint8_t * btstack_ring_buffer_spsc_get_write_region(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_size);
+
+/**
+ * Make bytes written into write region available to consumer, called by producer
+ * @param ring_buffer object
+ * @param num_bytes written, at most region_size
+ */
+void btstack_ring_buffer_spsc_write_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes);
+
+/**
+ * Write bytes into ring buffer, called by producer
+ * @param ring_buffer object
+ * @param data to store
+ * @param data_length
+ * @return 0 if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if not enough space in buffer
+ */
+int btstack_ring_buffer_spsc_write(btstack_ring_buffer_spsc_t * ring_buffer, const uint8_t * data, uint32_t data_length);
+
+/**
+ * Get contiguous region for reading without copy, called by consumer
+ * @param ring_buffer object
+ * @param region_size of available contiguous region
+ * @return pointer to region
+ */
+const uint8_t * btstack_ring_buffer_spsc_get_read_region(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * region_size);
+
+/**
+ * Release bytes read from read region, called by consumer
+ * @param ring_buffer object
+ * @param num_bytes read, at most region_size
+ */
+void btstack_ring_buffer_spsc_read_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t num_bytes);
+
+/**
+ * Copy bytes from ring buffer without removing them, called by consumer
+ * @param ring_buffer object
+ * @param buffer to store data
+ * @param length to copy
+ * @return number of bytes copied
+ */
+uint32_t btstack_ring_buffer_spsc_peek(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * buffer, uint32_t length);
+
+/**
+ * Read from ring buffer, called by consumer
+ * @param ring_buffer object
+ * @param buffer to store read data
+ * @param length to read
+ * @param number_of_bytes_read
+ */
+void btstack_ring_buffer_spsc_read(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * buffer, uint32_t length, uint32_t * number_of_bytes_read);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_RING_BUFFER_SPSC_H
@@ -189,6 +189,15 @@ void btstack_run_loop_execute(void){
     the_run_loop->execute();
 }
 
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    btstack_run_loop_assert();
+    if (the_run_loop->execute_on_main_thread != NULL){
+        the_run_loop->execute_on_main_thread(callback_registration);
+    } else {
+        log_error("btstack_run_loop_execute_on_main_thread not implemented");
+    }
+}
+
 // init must be called before any other run_loop call
 void btstack_run_loop_init(const btstack_run_loop_t * run_loop){
     if (the_run_loop){
@@ -47,6 +47,7 @@
 #include "btstack_config.h"
 
 #include "btstack_bool.h"
+#include "btstack_defines.h"
 #include "btstack_linked_list.h"
 
 #include <stdint.h>
@@ -92,6 +93,9 @@ typedef struct btstack_timer_source {
     // will be called when timer fired
     void  (*process)(struct btstack_timer_source *ts); 
     void * context;
+    // timer heap in btstack_run_loop_base: first child and previous sibling or parent
+    struct btstack_timer_source * heap_child;
+    struct btstack_timer_source * heap_prev;
 } btstack_timer_source_t;
 
 typedef struct btstack_run_loop {
@@ -106,6 +110,7 @@ typedef struct btstack_run_loop {
 	void (*execute)(void);
 	void (*dump_timer)(void);
 	uint32_t (*get_time_ms)(void);
+	void (*execute_on_main_thread)(btstack_context_callback_registration_t * callback_registration);
 } btstack_run_loop_t;
 
 void btstack_run_loop_timer_dump(void);
@@ -220,6 +225,15 @@ int btstack_run_loop_remove_data_source(btstack_data_source_t * data_source);
  */
 void btstack_run_loop_execute(void);
 
+/**
+ * @brief Execute callback from main thread. Can be called from other threads.
+ * @param callback_registration with callback and context, must stay valid until callback was executed
+ * @note Callbacks are executed in the order they were added. A registration is only queued once: calling this again
+ *       before its callback was executed has no effect. As the caller provides the storage, no request gets dropped.
+ * @note Supported by POSIX, Linux, BSD, Windows, FreeRTOS, and Embedded run loops. On FreeRTOS, it must not be called from an ISR
+ */
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -49,13 +49,177 @@
 
 #include "btstack_run_loop_base.h"
 
+#include <string.h>
+
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+#ifndef BTSTACK_RUN_LOOP_PROFILING_MAX_ENTRIES
+#define BTSTACK_RUN_LOOP_PROFILING_MAX_ENTRIES 16
+#endif
+#endif
+
 // private data (access only by run loop implementations)
 btstack_linked_list_t btstack_run_loop_base_timers;
 btstack_linked_list_t btstack_run_loop_base_data_sources;
+btstack_linked_list_t btstack_run_loop_base_callbacks;
 
-void btstack_run_loop_base_init(void){
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+// entries are kept sorted by time_total, most expensive first
+static btstack_run_loop_profiling_entry_t btstack_run_loop_profiling_entries[BTSTACK_RUN_LOOP_PROFILING_MAX_ENTRIES];
+static uint16_t btstack_run_loop_profiling_num_entries;
+static uint32_t btstack_run_loop_profiling_dropped;
+static uint32_t (*btstack_run_loop_profiling_get_timestamp)(void) = &btstack_run_loop_get_time_ms;
+static uint32_t btstack_run_loop_profiling_timestamps_per_second = 1000;
+static uint32_t btstack_run_loop_profiling_budget_us;
+static uint32_t btstack_run_loop_profiling_budget;
+
+static uint32_t btstack_run_loop_profiling_to_us(uint32_t timestamps){
+    return (uint32_t) (((uint64_t) timestamps * 1000000u) / btstack_run_loop_profiling_timestamps_per_second);
+}
+
+static void btstack_run_loop_profiling_account(void (*handler)(void), btstack_run_loop_profiling_type_t type, uint32_t duration){
+    uint16_t index;
+    for (index = 0; index < btstack_run_loop_profiling_num_entries; index++){
+        if ((btstack_run_loop_profiling_entries[index].handler == handler) &&
+            (btstack_run_loop_profiling_entries[index].type == type)) break;
+    }
+    if (index == btstack_run_loop_profiling_num_entries){
+        if (index == BTSTACK_RUN_LOOP_PROFILING_MAX_ENTRIES){
+            btstack_run_loop_profiling_dropped++;
+            return;
+        }
+        btstack_run_loop_profiling_num_entries++;
+        memset(&btstack_run_loop_profiling_entries[index], 0, sizeof(btstack_run_loop_profiling_entry_t));
+        btstack_run_loop_profiling_entries[index].handler = handler;
+        btstack_run_loop_profiling_entries[index].type = type;
+    }
+    btstack_run_loop_profiling_entry_t * entry = &btstack_run_loop_profiling_entries[index];
+    entry->calls++;
+    entry->time_total += duration;
+    if (duration > entry->time_max){
+        entry->time_max = duration;
+    }
+    if ((btstack_run_loop_profiling_budget_us != 0) && (duration > btstack_run_loop_profiling_budget)){
+        entry->over_budget++;
+        log_info("run loop handler %p took %u us, budget %u us", (void *) handler,
+                 (unsigned int) btstack_run_loop_profiling_to_us(duration), (unsigned int) btstack_run_loop_profiling_budget_us);
+    }
+    // keep sorted: move entry towards the front while it is more expensive than its predecessor
+    while (index > 0) {
+        if (btstack_run_loop_profiling_entries[index - 1].time_total >= entry->time_total) break;
+        btstack_run_loop_profiling_entry_t tmp = btstack_run_loop_profiling_entries[index - 1];
+        btstack_run_loop_profiling_entries[index - 1] = *entry;
+        btstack_run_loop_profiling_entries[index] = tmp;
+        index--;
+        entry = &btstack_run_loop_profiling_entries[index];
+    }
+}
+
+void btstack_run_loop_base_profiling_init(uint32_t (*get_timestamp)(void), uint32_t timestamps_per_second){
+    btstack_run_loop_profiling_get_timestamp = get_timestamp;
+    btstack_run_loop_profiling_timestamps_per_second = timestamps_per_second;
+    btstack_run_loop_base_profiling_set_budget_us(btstack_run_loop_profiling_budget_us);
+    btstack_run_loop_base_profiling_reset();
+}
+
+void btstack_run_loop_base_profiling_set_budget_us(uint32_t budget_us){
+    btstack_run_loop_profiling_budget_us = budget_us;
+    btstack_run_loop_profiling_budget = (uint32_t) (((uint64_t) budget_us * btstack_run_loop_profiling_timestamps_per_second) / 1000000u);
+}
+
+const btstack_run_loop_profiling_entry_t * btstack_run_loop_base_profiling_get_entries(uint16_t * num_entries){
+    *num_entries = btstack_run_loop_profiling_num_entries;
+    return btstack_run_loop_profiling_entries;
+}
+
+uint32_t btstack_run_loop_base_profiling_get_dropped(void){
+    return btstack_run_loop_profiling_dropped;
+}
+
+void btstack_run_loop_base_profiling_reset(void){
+    btstack_run_loop_profiling_num_entries = 0;
+    btstack_run_loop_profiling_dropped = 0;
+}
+
+void btstack_run_loop_base_profiling_dump(uint16_t max_entries){
+    static const char * type_names[] = { "data source", "timer", "callback" };
+    log_info("run loop profiling: %u handlers, %u calls dropped, budget %u us", btstack_run_loop_profiling_num_entries,
+             (unsigned int) btstack_run_loop_profiling_dropped, (unsigned int) btstack_run_loop_profiling_budget_us);
+    uint16_t i;
+    for (i = 0; (i < btstack_run_loop_profiling_num_entries) && (i < max_entries); i++){
+        const btstack_run_loop_profiling_entry_t * entry = &btstack_run_loop_profiling_entries[i];
+        log_info("- %-11s %p: calls %u, total %u us, avg %u us, max %u us, over budget %u", type_names[entry->type],
+                 (void *) entry->handler, (unsigned int) entry->calls,
+                 (unsigned int) btstack_run_loop_profiling_to_us(entry->time_total),
+                 (unsigned int) btstack_run_loop_profiling_to_us(entry->time_total / entry->calls),
+                 (unsigned int) btstack_run_loop_profiling_to_us(entry->time_max), (unsigned int) entry->over_budget);
+    }
+}
+#endif
+
+void btstack_run_loop_base_process_data_source(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+    void (*process)(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type) = ds->process;
+    uint32_t start = (*btstack_run_loop_profiling_get_timestamp)();
+    (*process)(ds, callback_type);
+    uint32_t duration = (*btstack_run_loop_profiling_get_timestamp)() - start;
+    btstack_run_loop_profiling_account((void (*)(void)) process, BTSTACK_RUN_LOOP_PROFILING_DATA_SOURCE, duration);
+#else
+    ds->process(ds, callback_type);
+#endif
+}
+
+void btstack_run_loop_base_process_timer(btstack_timer_source_t * ts){
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+    // timer might get re-used by its handler, keep process function
+    void (*process)(btstack_timer_source_t * ts) = ts->process;
+    uint32_t start = (*btstack_run_loop_profiling_get_timestamp)();
+    (*process)(ts);
+    uint32_t duration = (*btstack_run_loop_profiling_get_timestamp)() - start;
+    btstack_run_loop_profiling_account((void (*)(void)) process, BTSTACK_RUN_LOOP_PROFILING_TIMER, duration);
+#else
+    ts->process(ts);
+#endif
+}
+
+void btstack_run_loop_base_execute_callback(btstack_context_callback_registration_t * callback_registration){
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+    void (*callback)(void * context) = callback_registration->callback;
+    uint32_t start = (*btstack_run_loop_profiling_get_timestamp)();
+    (*callback)(callback_registration->context);
+    uint32_t duration = (*btstack_run_loop_profiling_get_timestamp)() - start;
+    btstack_run_loop_profiling_account((void (*)(void)) callback, BTSTACK_RUN_LOOP_PROFILING_CALLBACK, duration);
+#else
+    (*callback_registration->callback)(callback_registration->context);
+#endif
+}
+
+// clear heap links of all timers, so that they can be added again after init
+static void btstack_run_loop_base_reset_timers(void){
+    btstack_timer_source_t * pending = (btstack_timer_source_t *) btstack_run_loop_base_timers;
+    while (pending != NULL){
+        btstack_timer_source_t * ts = pending;
+        pending = (btstack_timer_source_t *) ts->item.next;
+        // visit children next
+        btstack_timer_source_t * child = ts->heap_child;
+        if (child != NULL){
+            btstack_timer_source_t * last_child = child;
+            while (last_child->item.next != NULL){
+                last_child = (btstack_timer_source_t *) last_child->item.next;
+            }
+            last_child->item.next = (btstack_linked_item_t *) pending;
+            pending = child;
+        }
+        ts->item.next  = NULL;
+        ts->heap_prev  = NULL;
+        ts->heap_child = NULL;
+    }
     btstack_run_loop_base_timers = NULL;
+}
+
+void btstack_run_loop_base_init(void){
+    btstack_run_loop_base_reset_timers();
     btstack_run_loop_base_data_sources = NULL;    
+    btstack_run_loop_base_callbacks = NULL;
 }
 
 void btstack_run_loop_base_add_data_source(btstack_data_source_t *ds){
@@ -75,38 +239,140 @@ void btstack_run_loop_base_disable_data_source_callbacks(btstack_data_source_t *
 }
 
 
+/*
+ * Timers are kept in a pairing heap. The root - the timer that expires first - is stored in
+ * btstack_run_loop_base_timers. For each timer, item.next is the next sibling, heap_child the
+ * first child, and heap_prev either the previous sibling or the parent for the first child.
+ * Add is O(1), remove and processing of an expired timer is O(log n) amortized.
+ */
+
+static inline btstack_timer_source_t * btstack_run_loop_base_timer_root(void){
+    return (btstack_timer_source_t *) btstack_run_loop_base_timers;
+}
+
+static inline btstack_timer_source_t * btstack_run_loop_base_timer_next(btstack_timer_source_t * ts){
+    return (btstack_timer_source_t *) ts->item.next;
+}
+
+// meld two heaps given by their roots, returns new root
+static btstack_timer_source_t * btstack_run_loop_base_timer_meld(btstack_timer_source_t * a, btstack_timer_source_t * b){
+    if (a == NULL) return b;
+    if (b == NULL) return a;
+    // root is the timer that expires first
+    if (btstack_time_delta(b->timeout, a->timeout) < 0){
+        btstack_timer_source_t * tmp = a;
+        a = b;
+        b = tmp;
+    }
+    // b becomes first child of a
+    b->heap_prev = a;
+    b->item.next = (btstack_linked_item_t *) a->heap_child;
+    if (a->heap_child != NULL){
+        a->heap_child->heap_prev = b;
+    }
+    a->heap_child = b;
+    return a;
+}
+
+// meld list of siblings into single heap using two-pass pairing
+static btstack_timer_source_t * btstack_run_loop_base_timer_merge_pairs(btstack_timer_source_t * first){
+    // first pass: meld pairs from left to right, collect results in reversed list
+    btstack_timer_source_t * pairs = NULL;
+    while (first != NULL){
+        btstack_timer_source_t * a = first;
+        btstack_timer_source_t * b = btstack_run_loop_base_timer_next(a);
+        first = (b != NULL) ? btstack_run_loop_base_timer_next(b) : NULL;
+        a->item.next = NULL;
+        a->heap_prev = NULL;
+        if (b != NULL){
+            b->item.next = NULL;
+            b->heap_prev = NULL;
+        }
+        btstack_timer_source_t * pair = btstack_run_loop_base_timer_meld(a, b);
+        pair->item.next = (btstack_linked_item_t *) pairs;
+        pairs = pair;
+    }
+    // second pass: meld pairs from right to left
+    btstack_timer_source_t * root = NULL;
+    while (pairs != NULL){
+        btstack_timer_source_t * next = btstack_run_loop_base_timer_next(pairs);
+        pairs->item.next = NULL;
+        root = btstack_run_loop_base_timer_meld(root, pairs);
+        pairs = next;
+    }
+    return root;
+}
+
+static bool btstack_run_loop_base_timer_active(btstack_timer_source_t * ts){
+    return (ts == btstack_run_loop_base_timer_root()) || (ts->heap_prev != NULL);
+}
+
 bool btstack_run_loop_base_remove_timer(btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&btstack_run_loop_base_timers, (btstack_linked_item_t *) ts);
+    if (!btstack_run_loop_base_timer_active(ts)) return false;
+
+    btstack_timer_source_t * root = btstack_run_loop_base_timer_root();
+    btstack_timer_source_t * children = ts->heap_child;
+    if (ts == root){
+        root = NULL;
+    } else {
+        // unlink from siblings / parent
+        btstack_timer_source_t * prev = ts->heap_prev;
+        btstack_timer_source_t * next = btstack_run_loop_base_timer_next(ts);
+        if (prev->heap_child == ts){
+            prev->heap_child = next;
+        } else {
+            prev->item.next = (btstack_linked_item_t *) next;
+        }
+        if (next != NULL){
+            next->heap_prev = prev;
+        }
+    }
+    ts->item.next  = NULL;
+    ts->heap_prev  = NULL;
+    ts->heap_child = NULL;
+
+    // merge children of removed timer back into heap
+    root = btstack_run_loop_base_timer_meld(root, btstack_run_loop_base_timer_merge_pairs(children));
+    btstack_run_loop_base_timers = (btstack_linked_list_t) root;
+    return true;
 }
 
 void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &btstack_run_loop_base_timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        if ((btstack_timer_source_t *) it->next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if list timeout is after new timeout
-        uint32_t list_timeout = ((btstack_timer_source_t *) it->next)->timeout;
-        int32_t delta = btstack_time_delta(ts->timeout, list_timeout);
-        if (delta < 0) break;
+    // don't add timer that's already in there
+    if (btstack_run_loop_base_timer_active(ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
     }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    ts->item.next  = NULL;
+    ts->heap_prev  = NULL;
+    ts->heap_child = NULL;
+    btstack_timer_source_t * root = btstack_run_loop_base_timer_meld(btstack_run_loop_base_timer_root(), ts);
+    btstack_run_loop_base_timers = (btstack_linked_list_t) root;
 }
 
 void  btstack_run_loop_base_process_timers(uint32_t now){
     // process timers, exit when timeout is in the future
     while (btstack_run_loop_base_timers) {
-        btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
+        btstack_timer_source_t * ts = btstack_run_loop_base_timer_root();
         int32_t delta = btstack_time_delta(ts->timeout, now);
         if (delta > 0) break;
+        // remove timer before processing it to allow handler to re-register with run loop
         btstack_run_loop_base_remove_timer(ts);
-        ts->process(ts);
+        btstack_run_loop_base_process_timer(ts);
     }
 }
 
+static void btstack_run_loop_base_dump_timer_heap(btstack_timer_source_t * ts, uint16_t depth){
+    for (; ts != NULL ; ts = btstack_run_loop_base_timer_next(ts)){
+        log_info("timer %p, depth %u, timeout %u", ts, depth, (unsigned int) ts->timeout);
+        btstack_run_loop_base_dump_timer_heap(ts->heap_child, depth + 1);
+    }
+}
+
+void btstack_run_loop_base_dump_timer(void){
+    btstack_run_loop_base_dump_timer_heap(btstack_run_loop_base_timer_root(), 0);
+}
+
 /**
  * @brief Get time until first timer fires
  * @returns -1 if no timers, time until next timeout otherwise
@@ -121,3 +387,12 @@ int32_t btstack_run_loop_base_get_time_until_timeout(uint32_t now){
     }
     return delta;
 }
+
+void btstack_run_loop_base_add_callback(btstack_context_callback_registration_t * callback_registration){
+    // add_tail ignores items that are already in the list
+    (void) btstack_linked_list_add_tail(&btstack_run_loop_base_callbacks, (btstack_linked_item_t *) callback_registration);
+}
+
+btstack_context_callback_registration_t * btstack_run_loop_base_get_next_callback(void){
+    return (btstack_context_callback_registration_t *) btstack_linked_list_pop(&btstack_run_loop_base_callbacks);
+}
@@ -55,8 +55,11 @@ extern "C" {
 #endif
 
 // private data (access only by run loop implementations)
+// timers are organized in a heap, btstack_run_loop_base_timers points to the timer that expires first
 extern btstack_linked_list_t btstack_run_loop_base_timers;
 extern btstack_linked_list_t btstack_run_loop_base_data_sources;
+// callbacks to execute on main thread, access needs to be serialized by run loop implementation
+extern btstack_linked_list_t btstack_run_loop_base_callbacks;
 	
 /**
  * @brief Init
@@ -88,6 +91,11 @@ void  btstack_run_loop_base_process_timers(uint32_t now);
  */
 int32_t btstack_run_loop_base_get_time_until_timeout(uint32_t now);
 
+/**
+ * @brief Log all timers
+ */
+void btstack_run_loop_base_dump_timer(void);
+
 /**
  * @brief Add data source to run loop
  * @param data_source to add
@@ -115,6 +123,97 @@ void btstack_run_loop_base_enable_data_source_callbacks(btstack_data_source_t *
  */
 void btstack_run_loop_base_disable_data_source_callbacks(btstack_data_source_t * data_source, uint16_t callbacks);
 
+/**
+ * @brief Add callback to list of callbacks to execute on main thread, no effect if already in list
+ * @note Not thread-safe, caller has to serialize access
+ * @param callback_registration
+ */
+void btstack_run_loop_base_add_callback(btstack_context_callback_registration_t * callback_registration);
+
+/**
+ * @brief Get and remove first callback to execute on main thread
+ * @note Not thread-safe, caller has to serialize access
+ * @returns callback registration or NULL if none
+ */
+btstack_context_callback_registration_t * btstack_run_loop_base_get_next_callback(void);
+
+/**
+ * @brief Call process function of data source, accounted for with ENABLE_BTSTACK_RUN_LOOP_PROFILING
+ * @param data_source
+ * @param callback_type
+ */
+void btstack_run_loop_base_process_data_source(btstack_data_source_t * data_source, btstack_data_source_callback_type_t callback_type);
+
+/**
+ * @brief Call process function of timer, accounted for with ENABLE_BTSTACK_RUN_LOOP_PROFILING
+ * @param timer
+ */
+void btstack_run_loop_base_process_timer(btstack_timer_source_t * timer);
+
+/**
+ * @brief Call callback registration, accounted for with ENABLE_BTSTACK_RUN_LOOP_PROFILING
+ * @param callback_registration
+ */
+void btstack_run_loop_base_execute_callback(btstack_context_callback_registration_t * callback_registration);
+
+#ifdef ENABLE_BTSTACK_RUN_LOOP_PROFILING
+
+typedef enum {
+    BTSTACK_RUN_LOOP_PROFILING_DATA_SOURCE = 0,
+    BTSTACK_RUN_LOOP_PROFILING_TIMER,
+    BTSTACK_RUN_LOOP_PROFILING_CALLBACK,
+} btstack_run_loop_profiling_type_t;
+
+typedef struct {
+    // process function or callback, identifies the handler
+    void (*handler)(void);
+    btstack_run_loop_profiling_type_t type;
+    uint32_t calls;
+    // in timestamps, see btstack_run_loop_base_profiling_init
+    uint32_t time_total;
+    uint32_t time_max;
+    uint32_t over_budget;
+} btstack_run_loop_profiling_entry_t;
+
+/**
+ * @brief Init profiling and reset all entries
+ * @note Without init, btstack_run_loop_get_time_ms is used, which is too coarse for most handlers
+ * @param get_timestamp e.g. cycle counter
+ * @param timestamps_per_second
+ */
+void btstack_run_loop_base_profiling_init(uint32_t (*get_timestamp)(void), uint32_t timestamps_per_second);
+
+/**
+ * @brief Set latency budget. Each handler call that takes longer is counted and logged
+ * @param budget_us, 0 to disable
+ */
+void btstack_run_loop_base_profiling_set_budget_us(uint32_t budget_us);
+
+/**
+ * @brief Get entries
+ * @param num_entries
+ * @returns entries sorted by time_total, most expensive first
+ */
+const btstack_run_loop_profiling_entry_t * btstack_run_loop_base_profiling_get_entries(uint16_t * num_entries);
+
+/**
+ * @brief Get number of handler calls that could not be accounted for as table is full
+ */
+uint32_t btstack_run_loop_base_profiling_get_dropped(void);
+
+/**
+ * @brief Reset all entries
+ */
+void btstack_run_loop_base_profiling_reset(void);
+
+/**
+ * @brief Log most expensive handlers
+ * @param max_entries
+ */
+void btstack_run_loop_base_profiling_dump(uint16_t max_entries);
+
+#endif
+
 #if defined __cplusplus
 }
 #endif
@@ -42,6 +42,8 @@
  *  SLIP encoder/decoder
  */
 
+#include <string.h>
+
 #include "btstack_slip.h"
 #include "btstack_debug.h"
 
@@ -128,6 +130,44 @@ uint8_t btstack_slip_encoder_get_byte(void){
 	}
 }
 
+// returns number of bytes that can be sent without escaping
+static uint16_t btstack_slip_plain_run_len(const uint8_t * data, uint16_t max_len){
+	uint16_t len = 0;
+	while ((len < max_len) && (data[len] != BTSTACK_SLIP_SOF) && (data[len] != 0xdb)){
+		len++;
+	}
+	return len;
+}
+
+/**
+ * @brief Encode data into buffer, bytes without escaping are copied in bulk
+ * @param buffer for encoded data
+ * @param size of buffer
+ * @return number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_encode_block(uint8_t * buffer, uint16_t size){
+	uint16_t pos = 0;
+	while ((pos < size) && btstack_slip_encoder_has_data()){
+		if (encoder_state == SLIP_ENCODER_DEFAULT){
+			uint16_t run_len = size - pos;
+			if (run_len > encoder_len){
+				run_len = encoder_len;
+			}
+			run_len = btstack_slip_plain_run_len(encoder_data, run_len);
+			if (run_len > 0){
+				(void)memcpy(&buffer[pos], encoder_data, run_len);
+				encoder_data += run_len;
+				encoder_len  -= run_len;
+				pos += run_len;
+				continue;
+			}
+		}
+		// escape sequence, might be split across blocks
+		buffer[pos++] = btstack_slip_encoder_get_byte();
+	}
+	return pos;
+}
+
 // Decoder
 
 static void btstack_slip_decoder_reset(void){
@@ -218,6 +258,42 @@ void btstack_slip_decoder_process(uint8_t input){
     }
 }
 
+/**
+ * @brief Process received bytes until frame is complete, bytes without escaping are copied in bulk
+ * @param data
+ * @param size
+ * @return number of bytes processed. If less than size, frame is complete
+ */
+uint16_t btstack_slip_decoder_process_block(const uint8_t * data, uint16_t size){
+	uint16_t pos = 0;
+	while ((pos < size) && (decoder_state != SLIP_DECODER_COMPLETE)){
+		if (decoder_state == SLIP_DECODER_ACTIVE){
+			uint16_t run_len = btstack_slip_plain_run_len(&data[pos], size - pos);
+			if (run_len > 0){
+				if ((decoder_pos + run_len) > decoder_max_size){
+					log_error("btstack_slip_decoder_process_block: packet to long");
+					btstack_slip_decoder_reset();
+				} else {
+					(void)memcpy(&decoder_buffer[decoder_pos], &data[pos], run_len);
+					decoder_pos += run_len;
+				}
+				pos += run_len;
+				continue;
+			}
+		}
+		btstack_slip_decoder_process(data[pos++]);
+	}
+	return pos;
+}
+
+/**
+ * @brief Get number of bytes decoded for current frame
+ * @return number of bytes
+ */
+uint16_t btstack_slip_decoder_decoded_size(void){
+	return decoder_pos;
+}
+
 /**
  * @brief Get size of decoded frame
  * @return size of frame. Size = 0 => frame not complete
@@ -72,6 +72,14 @@ int  btstack_slip_encoder_has_data(void);
  */
 uint8_t btstack_slip_encoder_get_byte(void);
 
+/**
+ * @brief Encode data into buffer, bytes without escaping are copied in bulk
+ * @param buffer for encoded data
+ * @param size of buffer
+ * @return number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_encode_block(uint8_t * buffer, uint16_t size);
+
 // DECODER
 
 /**
@@ -88,6 +96,20 @@ void btstack_slip_decoder_init(uint8_t * buffer, uint16_t max_size);
 
 void btstack_slip_decoder_process(uint8_t input);
 
+/**
+ * @brief Process received bytes until frame is complete, bytes without escaping are copied in bulk
+ * @param data
+ * @param size
+ * @return number of bytes processed. If less than size, frame is complete
+ */
+uint16_t btstack_slip_decoder_process_block(const uint8_t * data, uint16_t size);
+
+/**
+ * @brief Get number of bytes decoded for current frame
+ * @return number of bytes
+ */
+uint16_t btstack_slip_decoder_decoded_size(void);
+
 /**
  * @brief Get size of decoded frame
  * @return size of frame. Size = 0 => frame not complete
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_trace.c"
+
+/*
+ *  btstack_trace.c
+ *
+ */
+
+#include "btstack_trace.h"
+
+#ifdef ENABLE_BTSTACK_TRACE
+
+#include <stdio.h>
+
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+
+// number of records in RAM, power of two
+#ifndef BTSTACK_TRACE_BUFFER_SIZE
+#define BTSTACK_TRACE_BUFFER_SIZE 128
+#endif
+
+#if (BTSTACK_TRACE_BUFFER_SIZE & (BTSTACK_TRACE_BUFFER_SIZE - 1)) != 0
+#error "BTSTACK_TRACE_BUFFER_SIZE must be a power of two"
+#endif
+
+// records per log message
+#define BTSTACK_TRACE_DUMP_RECORDS 16
+// serialized record: timestamp (4), point (1), id (2), len (2)
+#define BTSTACK_TRACE_RECORD_SIZE 9
+
+static btstack_trace_record_t btstack_trace_records[BTSTACK_TRACE_BUFFER_SIZE];
+// free-running indices
+static uint32_t btstack_trace_write_index;
+static uint32_t btstack_trace_read_index;
+static uint32_t btstack_trace_lost;
+
+static uint32_t (*btstack_trace_get_timestamp)(void) = &btstack_run_loop_get_time_ms;
+static uint32_t btstack_trace_timestamps_per_second = 1000;
+
+void btstack_trace_init(uint32_t (*get_timestamp)(void), uint32_t timestamps_per_second){
+    btstack_trace_get_timestamp = get_timestamp;
+    btstack_trace_timestamps_per_second = timestamps_per_second;
+    btstack_trace_write_index = 0;
+    btstack_trace_read_index = 0;
+    btstack_trace_lost = 0;
+}
+
+void btstack_trace_record(uint8_t point, uint16_t id, uint16_t len){
+    btstack_trace_record_t * record = &btstack_trace_records[btstack_trace_write_index & (BTSTACK_TRACE_BUFFER_SIZE - 1)];
+    record->timestamp = (*btstack_trace_get_timestamp)();
+    record->point = point;
+    record->id = id;
+    record->len = len;
+    btstack_trace_write_index++;
+    // drop oldest record if full
+    if ((btstack_trace_write_index - btstack_trace_read_index) > BTSTACK_TRACE_BUFFER_SIZE){
+        btstack_trace_read_index++;
+        btstack_trace_lost++;
+    }
+}
+
+uint16_t btstack_trace_get_records(btstack_trace_record_t * records, uint16_t max_records){
+    uint16_t num_records = 0;
+    while ((num_records < max_records) && (btstack_trace_read_index != btstack_trace_write_index)){
+        records[num_records++] = btstack_trace_records[btstack_trace_read_index & (BTSTACK_TRACE_BUFFER_SIZE - 1)];
+        btstack_trace_read_index++;
+    }
+    return num_records;
+}
+
+uint32_t btstack_trace_get_lost_records(void){
+    return btstack_trace_lost;
+}
+
+/*
+ * Log message: "btstack_trace <timestamps per second> <lost records> <records>"
+ * Records are hex encoded: timestamp (4), point (1), id (2), len (2), all little endian
+ */
+void btstack_trace_dump(void){
+    static char message[32 + (BTSTACK_TRACE_DUMP_RECORDS * BTSTACK_TRACE_RECORD_SIZE * 2)];
+    btstack_trace_record_t records[BTSTACK_TRACE_DUMP_RECORDS];
+    while (true){
+        uint16_t num_records = btstack_trace_get_records(records, BTSTACK_TRACE_DUMP_RECORDS);
+        if (num_records == 0) break;
+        int pos = snprintf(message, sizeof(message), "btstack_trace %u %u ",
+                           (unsigned int) btstack_trace_timestamps_per_second, (unsigned int) btstack_trace_lost);
+        uint16_t i;
+        for (i=0;i<num_records;i++){
+            uint8_t data[BTSTACK_TRACE_RECORD_SIZE];
+            little_endian_store_32(data, 0, records[i].timestamp);
+            data[4] = records[i].point;
+            little_endian_store_16(data, 5, records[i].id);
+            little_endian_store_16(data, 7, records[i].len);
+            uint8_t j;
+            for (j=0;j<BTSTACK_TRACE_RECORD_SIZE;j++){
+                message[pos++] = char_for_nibble(data[j] >> 4);
+                message[pos++] = char_for_nibble(data[j] & 0x0f);
+            }
+        }
+        hci_dump_packet(LOG_MESSAGE_PACKET, 0, (uint8_t *) message, (uint16_t) pos);
+    }
+}
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_trace.h
+ *
+ *  Lightweight trace points with timestamps along the data path to measure per-layer latency.
+ *  Records are stored in a RAM ring buffer and exported via HCI Dump (file or RTT) with btstack_trace_dump,
+ *  tool/btstack_trace_latency.py calculates latency histograms between trace points.
+ *
+ *  Enabled with ENABLE_BTSTACK_TRACE, trace points compile to nothing otherwise.
+ */
+
+#ifndef BTSTACK_TRACE_H
+#define BTSTACK_TRACE_H
+
+#include "btstack_config.h"
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// trace point ids, ids from BTSTACK_TRACE_POINT_APPLICATION on are free for application use
+typedef enum {
+    BTSTACK_TRACE_POINT_HCI_EVENT_RX = 0,
+    BTSTACK_TRACE_POINT_HCI_ACL_RX,
+    BTSTACK_TRACE_POINT_HCI_SCO_RX,
+    BTSTACK_TRACE_POINT_HCI_COMMAND_TX,
+    BTSTACK_TRACE_POINT_HCI_ACL_TX,
+    BTSTACK_TRACE_POINT_L2CAP_RX,
+    BTSTACK_TRACE_POINT_L2CAP_TX,
+    BTSTACK_TRACE_POINT_RFCOMM_RX,
+    BTSTACK_TRACE_POINT_RFCOMM_TX,
+    BTSTACK_TRACE_POINT_ATT_RX,
+    BTSTACK_TRACE_POINT_ATT_TX,
+    BTSTACK_TRACE_POINT_AVDTP_RX,
+    BTSTACK_TRACE_POINT_AVDTP_TX,
+    BTSTACK_TRACE_POINT_MESH_NETWORK_RX,
+    BTSTACK_TRACE_POINT_MESH_NETWORK_RX_DECODED,
+    BTSTACK_TRACE_POINT_MESH_NETWORK_TX,
+    BTSTACK_TRACE_POINT_MESH_NETWORK_TX_ENCRYPTED,
+    BTSTACK_TRACE_POINT_APPLICATION = 0x80,
+} btstack_trace_point_t;
+
+typedef struct {
+    uint32_t timestamp;
+    // con handle, local cid, or 0
+    uint16_t id;
+    uint16_t len;
+    uint8_t  point;
+} btstack_trace_record_t;
+
+#ifdef ENABLE_BTSTACK_TRACE
+#define BTSTACK_TRACE(point, id, len) btstack_trace_record((point), (uint16_t)(id), (uint16_t)(len))
+#else
+#define BTSTACK_TRACE(point, id, len)
+#endif
+
+/* API_START */
+
+/**
+ * @brief Set timestamp source, e.g. a cycle counter like DWT->CYCCNT on Cortex-M.
+ * @note Without init, btstack_run_loop_get_time_ms is used with 1000 timestamps per second
+ * @param get_timestamp
+ * @param timestamps_per_second used by tool/btstack_trace_latency.py to convert into us
+ */
+void btstack_trace_init(uint32_t (*get_timestamp)(void), uint32_t timestamps_per_second);
+
+/**
+ * @brief Store trace record in ring buffer, oldest record is overwritten if full
+ * @note Not interrupt-safe, only call from BTstack thread. Use BTSTACK_TRACE macro instead.
+ * @param point
+ * @param id
+ * @param len
+ */
+void btstack_trace_record(uint8_t point, uint16_t id, uint16_t len);
+
+/**
+ * @brief Get and remove oldest records from ring buffer
+ * @param records
+ * @param max_records
+ * @return number of records
+ */
+uint16_t btstack_trace_get_records(btstack_trace_record_t * records, uint16_t max_records);
+
+/**
+ * @brief Get number of records that have been overwritten before they were read
+ */
+uint32_t btstack_trace_get_lost_records(void);
+
+/**
+ * @brief Write all records from ring buffer as log messages via HCI Dump. Call outside of the measured path.
+ */
+void btstack_trace_dump(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_TRACE_H
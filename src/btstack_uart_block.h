@@ -143,6 +143,18 @@ typedef struct {
      */
     void (*set_wakeup_handler)(void (*wakeup_handler)(void));
 
+    // optional: support for batched reads
+
+    /**
+     * set callback for bytes received by receive_bytes. NULL disables callback
+     */
+    void (*set_bytes_received)(void (*bytes_handler)(uint16_t num_bytes));
+
+    /**
+     * receive up to max_len bytes. Bytes handler is called as soon as at least one byte was received
+     */
+    void (*receive_bytes)(uint8_t *buffer, uint16_t max_len);
+
 } btstack_uart_block_t;
 
 // common implementations
@@ -71,68 +71,19 @@ void bd_addr_copy(bd_addr_t dest, const bd_addr_t src){
     (void)memcpy(dest, src, BD_ADDR_LEN);
 }
 
-uint16_t little_endian_read_16(const uint8_t * buffer, int pos){
-    return (uint16_t)(((uint16_t) buffer[pos]) | (((uint16_t)buffer[(pos)+1]) << 8));
-}
-uint32_t little_endian_read_24(const uint8_t * buffer, int pos){
-    return ((uint32_t) buffer[pos]) | (((uint32_t)buffer[(pos)+1]) << 8) | (((uint32_t)buffer[(pos)+2]) << 16);
-}
-uint32_t little_endian_read_32(const uint8_t * buffer, int pos){
-    return ((uint32_t) buffer[pos]) | (((uint32_t)buffer[(pos)+1]) << 8) | (((uint32_t)buffer[(pos)+2]) << 16) | (((uint32_t) buffer[(pos)+3]) << 24);
-}
-
-void little_endian_store_16(uint8_t *buffer, uint16_t pos, uint16_t value){
-    buffer[pos++] = (uint8_t)value;
-    buffer[pos++] = (uint8_t)(value >> 8);
-}
-
-void little_endian_store_24(uint8_t *buffer, uint16_t pos, uint32_t value){
-    buffer[pos++] = (uint8_t)(value);
-    buffer[pos++] = (uint8_t)(value >> 8);
-    buffer[pos++] = (uint8_t)(value >> 16);
-}
-
-void little_endian_store_32(uint8_t *buffer, uint16_t pos, uint32_t value){
-    buffer[pos++] = (uint8_t)(value);
-    buffer[pos++] = (uint8_t)(value >> 8);
-    buffer[pos++] = (uint8_t)(value >> 16);
-    buffer[pos++] = (uint8_t)(value >> 24);
-}
-
-uint32_t big_endian_read_16( const uint8_t * buffer, int pos) {
-    return (uint16_t)(((uint16_t) buffer[(pos)+1]) | (((uint16_t)buffer[ pos   ]) << 8));
-}
-
-uint32_t big_endian_read_24( const uint8_t * buffer, int pos) {
-    return ( ((uint32_t)buffer[(pos)+2]) | (((uint32_t)buffer[(pos)+1]) << 8) | (((uint32_t) buffer[pos]) << 16));
-}
-
-uint32_t big_endian_read_32( const uint8_t * buffer, int pos) {
-    return ((uint32_t) buffer[(pos)+3]) | (((uint32_t)buffer[(pos)+2]) << 8) | (((uint32_t)buffer[(pos)+1]) << 16) | (((uint32_t) buffer[pos]) << 24);
-}
-
-void big_endian_store_16(uint8_t *buffer, uint16_t pos, uint16_t value){
-    buffer[pos++] = (uint8_t)(value >> 8);
-    buffer[pos++] = (uint8_t)(value);
-}
-
-void big_endian_store_24(uint8_t *buffer, uint16_t pos, uint32_t value){
-    buffer[pos++] = (uint8_t)(value >> 16);
-    buffer[pos++] = (uint8_t)(value >> 8);
-    buffer[pos++] = (uint8_t)(value);
-}
-
-void big_endian_store_32(uint8_t *buffer, uint16_t pos, uint32_t value){
-    buffer[pos++] = (uint8_t)(value >> 24);
-    buffer[pos++] = (uint8_t)(value >> 16);
-    buffer[pos++] = (uint8_t)(value >> 8);
-    buffer[pos++] = (uint8_t)(value);
-}
-
 // general swap/endianess utils
 void reverse_bytes(const uint8_t *src, uint8_t *dst, int len){
-    int i;
-    for (i = 0; i < len; i++)
+    int i = 0;
+#ifdef BTSTACK_UTIL_BUILTIN_BSWAP
+    // reverse 32 bit words from start of src into end of dst
+    for (; (i + 4) <= len; i += 4){
+        uint32_t word;
+        (void)memcpy(&word, &src[i], 4);
+        word = __builtin_bswap32(word);
+        (void)memcpy(&dst[len - 4 - i], &word, 4);
+    }
+#endif
+    for (; i < len; i++)
         dst[len - 1 - i] = src[i];
 }
 void reverse_24(const uint8_t * src, uint8_t * dst){
@@ -147,12 +98,6 @@ void reverse_56(const uint8_t * src, uint8_t * dst){
 void reverse_64(const uint8_t * src, uint8_t * dst){
     reverse_bytes(src, dst, 8);
 }
-void reverse_128(const uint8_t * src, uint8_t * dst){
-    reverse_bytes(src, dst, 16);
-}
-void reverse_256(const uint8_t * src, uint8_t * dst){
-    reverse_bytes(src, dst, 32);
-}
 
 void reverse_bd_addr(const bd_addr_t src, bd_addr_t dest){
     reverse_bytes(src, dest, 6);
@@ -473,3 +418,12 @@ uint8_t btstack_crc8_calc(uint8_t *data, uint16_t len){
     /* Ones complement */
     return 0xFF - crc8(data, len);
 }
+
+void btstack_event_filter_init(uint8_t * event_filter, const uint8_t * event_codes, uint16_t num_event_codes){
+    (void)memset(event_filter, 0, BTSTACK_EVENT_FILTER_SIZE);
+    uint16_t i;
+    for (i = 0; i < num_event_codes; i++){
+        uint8_t event_code = event_codes[i];
+        event_filter[event_code >> 3] |= (uint8_t) (1u << (event_code & 7));
+    }
+}
@@ -96,15 +96,51 @@ uint32_t btstack_max(uint32_t a, uint32_t b);
  */
 int32_t btstack_time_delta(uint32_t time_a, uint32_t time_b);
 
+// Use compiler builtins for byte swaps and unaligned loads/stores via memcpy if available
+#if defined(__GNUC__) || defined(__clang__)
+#define BTSTACK_UTIL_BUILTIN_BSWAP
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define BTSTACK_UTIL_BUILTIN_ENDIAN
+#define BTSTACK_UTIL_LITTLE_ENDIAN_16(value) (value)
+#define BTSTACK_UTIL_LITTLE_ENDIAN_32(value) (value)
+#define BTSTACK_UTIL_BIG_ENDIAN_16(value)    __builtin_bswap16(value)
+#define BTSTACK_UTIL_BIG_ENDIAN_32(value)    __builtin_bswap32(value)
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define BTSTACK_UTIL_BUILTIN_ENDIAN
+#define BTSTACK_UTIL_LITTLE_ENDIAN_16(value) __builtin_bswap16(value)
+#define BTSTACK_UTIL_LITTLE_ENDIAN_32(value) __builtin_bswap32(value)
+#define BTSTACK_UTIL_BIG_ENDIAN_16(value)    (value)
+#define BTSTACK_UTIL_BIG_ENDIAN_32(value)    (value)
+#endif
+#endif
+
 /** 
  * @brief Read 16/24/32 bit little endian value from buffer
  * @param buffer
  * @param position in buffer
  * @return value
  */
-uint16_t little_endian_read_16(const uint8_t * buffer, int position);
-uint32_t little_endian_read_24(const uint8_t * buffer, int position);
-uint32_t little_endian_read_32(const uint8_t * buffer, int position);
+static inline uint16_t little_endian_read_16(const uint8_t * buffer, int position){
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    uint16_t value;
+    (void)memcpy(&value, &buffer[position], 2);
+    return BTSTACK_UTIL_LITTLE_ENDIAN_16(value);
+#else
+    return (uint16_t)(((uint16_t) buffer[position]) | (((uint16_t)buffer[(position)+1]) << 8));
+#endif
+}
+static inline uint32_t little_endian_read_24(const uint8_t * buffer, int position){
+    return ((uint32_t) buffer[position]) | (((uint32_t)buffer[(position)+1]) << 8) | (((uint32_t)buffer[(position)+2]) << 16);
+}
+static inline uint32_t little_endian_read_32(const uint8_t * buffer, int position){
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    uint32_t value;
+    (void)memcpy(&value, &buffer[position], 4);
+    return BTSTACK_UTIL_LITTLE_ENDIAN_32(value);
+#else
+    return ((uint32_t) buffer[position]) | (((uint32_t)buffer[(position)+1]) << 8) | (((uint32_t)buffer[(position)+2]) << 16) | (((uint32_t) buffer[(position)+3]) << 24);
+#endif
+}
 
 /** 
  * @brief Write 16/32 bit little endian value into buffer
@@ -112,9 +148,31 @@ uint32_t little_endian_read_32(const uint8_t * buffer, int position);
  * @param position in buffer
  * @param value
  */
-void little_endian_store_16(uint8_t *buffer, uint16_t position, uint16_t value);
-void little_endian_store_24(uint8_t *buffer, uint16_t position, uint32_t value);
-void little_endian_store_32(uint8_t *buffer, uint16_t position, uint32_t value);
+static inline void little_endian_store_16(uint8_t *buffer, uint16_t position, uint16_t value){
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    value = BTSTACK_UTIL_LITTLE_ENDIAN_16(value);
+    (void)memcpy(&buffer[position], &value, 2);
+#else
+    buffer[position++] = (uint8_t)value;
+    buffer[position++] = (uint8_t)(value >> 8);
+#endif
+}
+static inline void little_endian_store_24(uint8_t *buffer, uint16_t position, uint32_t value){
+    buffer[position++] = (uint8_t)(value);
+    buffer[position++] = (uint8_t)(value >> 8);
+    buffer[position++] = (uint8_t)(value >> 16);
+}
+static inline void little_endian_store_32(uint8_t *buffer, uint16_t position, uint32_t value){
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    value = BTSTACK_UTIL_LITTLE_ENDIAN_32(value);
+    (void)memcpy(&buffer[position], &value, 4);
+#else
+    buffer[position++] = (uint8_t)(value);
+    buffer[position++] = (uint8_t)(value >> 8);
+    buffer[position++] = (uint8_t)(value >> 16);
+    buffer[position++] = (uint8_t)(value >> 24);
+#endif
+}
 
 /** 
  * @brief Read 16/24/32 bit big endian value from buffer
@@ -122,9 +180,27 @@ void little_endian_store_32(uint8_t *buffer, uint16_t position, uint32_t value);
  * @param position in buffer
  * @return value
  */
-uint32_t big_endian_read_16( const uint8_t * buffer, int pos);
-uint32_t big_endian_read_24( const uint8_t * buffer, int pos);
-uint32_t big_endian_read_32( const uint8_t * buffer, int pos);
+static inline uint32_t big_endian_read_16( const uint8_t * buffer, int pos) {
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    uint16_t value;
+    (void)memcpy(&value, &buffer[pos], 2);
+    return BTSTACK_UTIL_BIG_ENDIAN_16(value);
+#else
+    return (uint16_t)(((uint16_t) buffer[(pos)+1]) | (((uint16_t)buffer[ pos   ]) << 8));
+#endif
+}
+static inline uint32_t big_endian_read_24( const uint8_t * buffer, int pos) {
+    return ( ((uint32_t)buffer[(pos)+2]) | (((uint32_t)buffer[(pos)+1]) << 8) | (((uint32_t) buffer[pos]) << 16));
+}
+static inline uint32_t big_endian_read_32( const uint8_t * buffer, int pos) {
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    uint32_t value;
+    (void)memcpy(&value, &buffer[pos], 4);
+    return BTSTACK_UTIL_BIG_ENDIAN_32(value);
+#else
+    return ((uint32_t) buffer[(pos)+3]) | (((uint32_t)buffer[(pos)+2]) << 8) | (((uint32_t)buffer[(pos)+1]) << 16) | (((uint32_t) buffer[pos]) << 24);
+#endif
+}
 
 /** 
  * @brief Write 16/32 bit big endian value into buffer
@@ -132,10 +208,31 @@ uint32_t big_endian_read_32( const uint8_t * buffer, int pos);
  * @param position in buffer
  * @param value
  */
-void big_endian_store_16(uint8_t *buffer, uint16_t pos, uint16_t value);
-void big_endian_store_24(uint8_t *buffer, uint16_t pos, uint32_t value);
-void big_endian_store_32(uint8_t *buffer, uint16_t pos, uint32_t value);
-
+static inline void big_endian_store_16(uint8_t *buffer, uint16_t pos, uint16_t value){
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    value = BTSTACK_UTIL_BIG_ENDIAN_16(value);
+    (void)memcpy(&buffer[pos], &value, 2);
+#else
+    buffer[pos++] = (uint8_t)(value >> 8);
+    buffer[pos++] = (uint8_t)(value);
+#endif
+}
+static inline void big_endian_store_24(uint8_t *buffer, uint16_t pos, uint32_t value){
+    buffer[pos++] = (uint8_t)(value >> 16);
+    buffer[pos++] = (uint8_t)(value >> 8);
+    buffer[pos++] = (uint8_t)(value);
+}
+static inline void big_endian_store_32(uint8_t *buffer, uint16_t pos, uint32_t value){
+#ifdef BTSTACK_UTIL_BUILTIN_ENDIAN
+    value = BTSTACK_UTIL_BIG_ENDIAN_32(value);
+    (void)memcpy(&buffer[pos], &value, 4);
+#else
+    buffer[pos++] = (uint8_t)(value >> 24);
+    buffer[pos++] = (uint8_t)(value >> 16);
+    buffer[pos++] = (uint8_t)(value >> 8);
+    buffer[pos++] = (uint8_t)(value);
+#endif
+}
 
 /**
  * @brief Swap bytes in 16 bit integer
@@ -179,8 +276,37 @@ void reverse_24 (const uint8_t *src, uint8_t * dest);
 void reverse_48 (const uint8_t *src, uint8_t * dest);
 void reverse_56 (const uint8_t *src, uint8_t * dest);
 void reverse_64 (const uint8_t *src, uint8_t * dest);
-void reverse_128(const uint8_t *src, uint8_t * dest);
-void reverse_256(const uint8_t *src, uint8_t * dest);
+
+/**
+ * @brief Reverse 128/256 bit values, e.g. for AES and ECC operations
+ * @param src
+ * @param dest
+ */
+static inline void reverse_128(const uint8_t *src, uint8_t * dest){
+#ifdef BTSTACK_UTIL_BUILTIN_BSWAP
+    uint64_t words[2];
+    (void)memcpy(words, src, 16);
+    words[0] = __builtin_bswap64(words[0]);
+    words[1] = __builtin_bswap64(words[1]);
+    (void)memcpy(&dest[0], &words[1], 8);
+    (void)memcpy(&dest[8], &words[0], 8);
+#else
+    reverse_bytes(src, dest, 16);
+#endif
+}
+static inline void reverse_256(const uint8_t *src, uint8_t * dest){
+#ifdef BTSTACK_UTIL_BUILTIN_BSWAP
+    uint64_t words[4];
+    (void)memcpy(words, src, 32);
+    int i;
+    for (i = 0; i < 4; i++){
+        uint64_t word = __builtin_bswap64(words[i]);
+        (void)memcpy(&dest[24 - (8 * i)], &word, 8);
+    }
+#else
+    reverse_bytes(src, dest, 32);
+#endif
+}
 
 void reverse_bd_addr(const bd_addr_t src, bd_addr_t dest);
 
@@ -288,6 +414,25 @@ int count_set_bits_uint32(uint32_t x);
 uint8_t btstack_crc8_check(uint8_t *data, uint16_t len, uint8_t check_sum);
 uint8_t btstack_crc8_calc(uint8_t *data, uint16_t len);
 
+/**
+ * @brief Init event filter for btstack_packet_callback_registration_t with list of event codes
+ * @param event_filter of BTSTACK_EVENT_FILTER_SIZE bytes
+ * @param event_codes
+ * @param num_event_codes
+ */
+void btstack_event_filter_init(uint8_t * event_filter, const uint8_t * event_codes, uint16_t num_event_codes);
+
+/**
+ * @brief Check if event passes event filter
+ * @param event_filter or NULL
+ * @param event_code
+ * @return 1 if event_filter is NULL or contains event_code
+ */
+static inline int btstack_event_filter_matches(const uint8_t * event_filter, uint8_t event_code){
+    if (event_filter == NULL) return 1;
+    return (event_filter[event_code >> 3] >> (event_code & 7)) & 1;
+}
+
 /* API_END */
 
 #if defined __cplusplus
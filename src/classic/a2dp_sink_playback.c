@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "a2dp_sink_playback.c"
+
+/*
+ * a2dp_sink_playback.c
+ */
+
+#include <string.h>
+
+#include "classic/a2dp_sink_playback.h"
+#include "btstack_debug.h"
+#include "btstack_util.h"
+
+// resampling factor 1.0 as 16.16 fixed point
+#define NOMINAL_FACTOR 0x10000
+
+// proportional gain: resampling factor deviation for fill level error equal to target latency
+#define KP_COMPENSATION 0x200
+
+// integral is accumulated per block of 128 audio frames and scaled down by target_frames * KI_DIVIDER
+#define KI_DIVIDER 16
+
+// max input frames resampled in one go, output buffer has room for max compensation
+#define RESAMPLE_BLOCK_FRAMES 128
+
+static uint32_t a2dp_sink_playback_bytes_per_frame(a2dp_sink_playback_t * playback){
+    return playback->num_channels * 2;
+}
+
+void a2dp_sink_playback_init(a2dp_sink_playback_t * playback, uint8_t * storage, uint32_t storage_size, uint8_t num_channels, uint32_t sample_rate, uint16_t target_latency_ms){
+    memset(playback, 0, sizeof(a2dp_sink_playback_t));
+    playback->num_channels  = num_channels;
+    playback->target_frames = (sample_rate * target_latency_ms) / 1000;
+    btstack_ring_buffer_init(&playback->pcm_ring_buffer, storage, storage_size);
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+    btstack_resample_init_polyphase(&playback->resample, num_channels);
+#else
+    btstack_resample_init(&playback->resample, num_channels);
+#endif
+    playback->resampling_factor = NOMINAL_FACTOR;
+    if ((playback->target_frames * a2dp_sink_playback_bytes_per_frame(playback)) > storage_size){
+        log_error("a2dp_sink_playback: storage %u bytes too small for target latency %u ms", (int) storage_size, target_latency_ms);
+    }
+}
+
+void a2dp_sink_playback_reset(a2dp_sink_playback_t * playback){
+    uint32_t bytes_read;
+    uint8_t  drop_buffer[64];
+    while (!btstack_ring_buffer_empty(&playback->pcm_ring_buffer)){
+        btstack_ring_buffer_read(&playback->pcm_ring_buffer, drop_buffer, sizeof(drop_buffer), &bytes_read);
+    }
+    // integral holds the clock drift estimate and is kept
+    playback->playing = 0;
+}
+
+uint32_t a2dp_sink_playback_get_buffered_frames(a2dp_sink_playback_t * playback){
+    return btstack_ring_buffer_bytes_available(&playback->pcm_ring_buffer) / a2dp_sink_playback_bytes_per_frame(playback);
+}
+
+void a2dp_sink_playback_write(a2dp_sink_playback_t * playback, const int16_t * pcm_data, uint16_t num_audio_frames){
+    int16_t output_buffer[(RESAMPLE_BLOCK_FRAMES + 16) * BTSTACK_RESAMPLE_MAX_CHANNELS];
+    uint32_t bytes_per_frame = a2dp_sink_playback_bytes_per_frame(playback);
+    while (num_audio_frames){
+        uint16_t block_frames = btstack_min(num_audio_frames, RESAMPLE_BLOCK_FRAMES);
+        uint16_t resampled_frames = btstack_resample_block(&playback->resample, pcm_data, block_frames, output_buffer);
+        uint32_t bytes_to_store = resampled_frames * bytes_per_frame;
+        if (btstack_ring_buffer_bytes_free(&playback->pcm_ring_buffer) < bytes_to_store){
+            playback->num_overruns++;
+            log_error("a2dp_sink_playback: PCM buffer full, drop %u frames", resampled_frames);
+        } else {
+            btstack_ring_buffer_write(&playback->pcm_ring_buffer, (uint8_t *) output_buffer, bytes_to_store);
+        }
+        pcm_data += block_frames * playback->num_channels;
+        num_audio_frames -= block_frames;
+    }
+}
+
+static void a2dp_sink_playback_update_factor(a2dp_sink_playback_t * playback, uint32_t buffered_frames, uint16_t num_audio_frames){
+    int32_t target_frames = (int32_t) btstack_max(playback->target_frames, 1);
+
+    // low-pass filter fill level to ignore burst of media packets and playback requests
+    playback->fill_level_q4 += (((int32_t) buffered_frames << 4) - playback->fill_level_q4) / 16;
+    int32_t error = (playback->fill_level_q4 >> 4) - target_frames;
+
+    // integral with anti-windup, positive error = source is faster, consume more input frames
+    int32_t integral_limit = A2DP_SINK_PLAYBACK_MAX_COMPENSATION * target_frames * KI_DIVIDER;
+    playback->integral += (error * num_audio_frames) / RESAMPLE_BLOCK_FRAMES;
+    if (playback->integral >  integral_limit) playback->integral =  integral_limit;
+    if (playback->integral < -integral_limit) playback->integral = -integral_limit;
+
+    int32_t compensation = ((error * KP_COMPENSATION) / target_frames) + (playback->integral / (target_frames * KI_DIVIDER));
+    if (compensation >  A2DP_SINK_PLAYBACK_MAX_COMPENSATION) compensation =  A2DP_SINK_PLAYBACK_MAX_COMPENSATION;
+    if (compensation < -A2DP_SINK_PLAYBACK_MAX_COMPENSATION) compensation = -A2DP_SINK_PLAYBACK_MAX_COMPENSATION;
+
+    playback->resampling_factor = (uint32_t) (NOMINAL_FACTOR + compensation);
+    btstack_resample_set_factor(&playback->resample, playback->resampling_factor);
+}
+
+void a2dp_sink_playback_fill(a2dp_sink_playback_t * playback, int16_t * buffer, uint16_t num_audio_frames){
+    uint32_t bytes_per_frame = a2dp_sink_playback_bytes_per_frame(playback);
+    uint32_t buffered_frames = a2dp_sink_playback_get_buffered_frames(playback);
+
+    if (!playback->playing){
+        if (buffered_frames < playback->target_frames){
+            memset(buffer, 0, num_audio_frames * bytes_per_frame);
+            return;
+        }
+        // start with measured fill level
+        playback->playing = 1;
+        playback->fill_level_q4 = (int32_t) buffered_frames << 4;
+    }
+
+    a2dp_sink_playback_update_factor(playback, buffered_frames, num_audio_frames);
+
+    uint32_t bytes_read;
+    btstack_ring_buffer_read(&playback->pcm_ring_buffer, (uint8_t *) buffer, num_audio_frames * bytes_per_frame, &bytes_read);
+    if (bytes_read < (num_audio_frames * bytes_per_frame)){
+        // underrun, fill with silence and wait for target latency
+        memset(((uint8_t *) buffer) + bytes_read, 0, (num_audio_frames * bytes_per_frame) - bytes_read);
+        playback->num_underruns++;
+        playback->playing = 0;
+        log_info("a2dp_sink_playback: underrun, %u frames missing", (int) (num_audio_frames - (bytes_read / bytes_per_frame)));
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * a2dp_sink_playback.h
+ *
+ * Jitter buffer and clock drift compensation for A2DP Sink playback
+ *
+ * Decoded PCM audio is resampled into a ring buffer and played from there by the btstack_audio_sink_t
+ * playback callback. The fill level is compared against the target latency and a PI controller
+ * adjusts the resampling factor to follow the clock of the A2DP Source.
+ */
+
+#ifndef A2DP_SINK_PLAYBACK_H
+#define A2DP_SINK_PLAYBACK_H
+
+#include <stdint.h>
+#include "btstack_resample.h"
+#include "btstack_ring_buffer.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// max deviation of resampling factor from 1.0 (0x10000), default about 1.5%
+#ifndef A2DP_SINK_PLAYBACK_MAX_COMPENSATION
+#define A2DP_SINK_PLAYBACK_MAX_COMPENSATION 0x400
+#endif
+
+typedef struct {
+    btstack_ring_buffer_t pcm_ring_buffer;
+    btstack_resample_t    resample;
+    uint8_t  num_channels;
+    uint8_t  playing;
+    uint32_t target_frames;
+    // low-pass filtered fill level in 1/16 frames
+    int32_t  fill_level_q4;
+    int32_t  integral;
+    uint32_t resampling_factor;
+    uint32_t num_underruns;
+    uint32_t num_overruns;
+} a2dp_sink_playback_t;
+
+/* API_START */
+
+/**
+ * @brief Init playback engine
+ * @note  storage should hold about twice the target latency to absorb bursts of media packets
+ * @param playback
+ * @param storage for decoded PCM audio
+ * @param storage_size in bytes
+ * @param num_channels 1 or 2
+ * @param sample_rate
+ * @param target_latency_ms of buffered audio, playback starts when reached
+ */
+void a2dp_sink_playback_init(a2dp_sink_playback_t * playback, uint8_t * storage, uint32_t storage_size, uint8_t num_channels, uint32_t sample_rate, uint16_t target_latency_ms);
+
+/**
+ * @brief Drop buffered audio and wait for target latency again, e.g. on stream suspend
+ * @param playback
+ */
+void a2dp_sink_playback_reset(a2dp_sink_playback_t * playback);
+
+/**
+ * @brief Store decoded PCM audio, call from decoder callback
+ * @param playback
+ * @param pcm_data interleaved samples in host endianess
+ * @param num_audio_frames
+ */
+void a2dp_sink_playback_write(a2dp_sink_playback_t * playback, const int16_t * pcm_data, uint16_t num_audio_frames);
+
+/**
+ * @brief Provide audio for btstack_audio_sink_t playback callback and update drift compensation
+ * @note  Fills buffer with silence until target latency is reached, and again after an underrun
+ * @param playback
+ * @param buffer
+ * @param num_audio_frames
+ */
+void a2dp_sink_playback_fill(a2dp_sink_playback_t * playback, int16_t * buffer, uint16_t num_audio_frames);
+
+/**
+ * @brief Get number of buffered audio frames
+ * @param playback
+ * @return num_audio_frames
+ */
+uint32_t a2dp_sink_playback_get_buffered_frames(a2dp_sink_playback_t * playback);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // A2DP_SINK_PLAYBACK_H
@@ -58,11 +58,24 @@ static const char * default_a2dp_source_service_name = "BTstack A2DP Source Serv
 static const char * default_a2dp_source_service_provider_name = "BTstack A2DP Source Service Provider";
 static avdtp_context_t a2dp_source_context;
 
-static a2dp_state_t app_state = A2DP_IDLE;
-static avdtp_stream_endpoint_context_t sc;
-static avdtp_sep_t remote_seps[AVDTP_MAX_SEP_NUM];
-static int num_remote_seps = 0;
-static btstack_timer_source_t a2dp_source_set_config_timer;
+// max number of sinks connected at the same time, each one needs its own local stream endpoint
+#ifndef A2DP_SOURCE_MAX_NUM_CONNECTIONS
+#define A2DP_SOURCE_MAX_NUM_CONNECTIONS 1
+#endif
+
+typedef struct {
+    bool in_use;
+    a2dp_state_t state;
+    avdtp_stream_endpoint_context_t sc;
+    avdtp_sep_t remote_seps[AVDTP_MAX_SEP_NUM];
+    int num_remote_seps;
+    btstack_timer_source_t set_config_timer;
+    uint16_t delay_100us;
+} a2dp_source_connection_t;
+
+static a2dp_source_connection_t a2dp_source_connections[A2DP_SOURCE_MAX_NUM_CONNECTIONS];
+static avdtp_stream_endpoint_t * a2dp_source_default_stream_endpoint;
+static btstack_linked_list_t a2dp_source_broadcast_groups;
 
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 
@@ -238,23 +251,82 @@ static void a2dp_signaling_emit_reconfigured(btstack_packet_handler_t callback,
     (*callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
+static a2dp_source_connection_t * a2dp_source_connection_for_avdtp_cid(uint16_t avdtp_cid){
+    int i;
+    for (i = 0; i < A2DP_SOURCE_MAX_NUM_CONNECTIONS; i++){
+        if (a2dp_source_connections[i].in_use && (a2dp_source_connections[i].sc.avdtp_cid == avdtp_cid)) return &a2dp_source_connections[i];
+    }
+    return NULL;
+}
+
+static a2dp_source_connection_t * a2dp_source_connection_create(void){
+    int i;
+    for (i = 0; i < A2DP_SOURCE_MAX_NUM_CONNECTIONS; i++){
+        a2dp_source_connection_t * connection = &a2dp_source_connections[i];
+        if (connection->in_use) continue;
+        memset(connection, 0, sizeof(a2dp_source_connection_t));
+        connection->in_use = true;
+        connection->state = A2DP_IDLE;
+        return connection;
+    }
+    log_error("a2dp source: A2DP_SOURCE_MAX_NUM_CONNECTIONS exceeded");
+    return NULL;
+}
+
+static void a2dp_source_connection_finalize(a2dp_source_connection_t * connection){
+    btstack_run_loop_remove_timer(&connection->set_config_timer);
+    connection->in_use = false;
+}
+
+static bool a2dp_source_stream_endpoint_in_use(avdtp_stream_endpoint_t * stream_endpoint){
+    int i;
+    for (i = 0; i < A2DP_SOURCE_MAX_NUM_CONNECTIONS; i++){
+        if (a2dp_source_connections[i].in_use && (a2dp_source_connections[i].sc.local_stream_endpoint == stream_endpoint)) return true;
+    }
+    return false;
+}
+
+// remote initiated connection gets the most recently created stream endpoint, or another one not used yet
+static avdtp_stream_endpoint_t * a2dp_source_get_unused_stream_endpoint(void){
+    if ((a2dp_source_default_stream_endpoint != NULL) && !a2dp_source_stream_endpoint_in_use(a2dp_source_default_stream_endpoint)){
+        return a2dp_source_default_stream_endpoint;
+    }
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &a2dp_source_context.stream_endpoints);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        avdtp_stream_endpoint_t * stream_endpoint = (avdtp_stream_endpoint_t *) btstack_linked_list_iterator_next(&it);
+        if (!a2dp_source_stream_endpoint_in_use(stream_endpoint)) return stream_endpoint;
+    }
+    return a2dp_source_default_stream_endpoint;
+}
+
 static void a2dp_source_set_config_timer_handler(btstack_timer_source_t * ts){
-    UNUSED(ts);
-    log_info("a2dp_source_set_config_timer_handler, app state %u", app_state);
-    if (app_state != A2DP_CONNECTED) return;
-    app_state = A2DP_W2_DISCOVER_SEPS;
-    avdtp_source_discover_stream_endpoints(sc.avdtp_cid);
+    a2dp_source_connection_t * connection = (a2dp_source_connection_t *) btstack_run_loop_get_timer_context(ts);
+    log_info("a2dp_source_set_config_timer_handler, app state %u", connection->state);
+    if (connection->state != A2DP_CONNECTED) return;
+    connection->state = A2DP_W2_DISCOVER_SEPS;
+    avdtp_source_discover_stream_endpoints(connection->sc.avdtp_cid);
 }
-static void a2dp_source_set_config_timer_start(void){
+static void a2dp_source_set_config_timer_start(a2dp_source_connection_t * connection){
     log_info("a2dp_source_set_config_timer_start");
-    btstack_run_loop_remove_timer(&a2dp_source_set_config_timer);
-    btstack_run_loop_set_timer_handler(&a2dp_source_set_config_timer,a2dp_source_set_config_timer_handler);
-    btstack_run_loop_set_timer(&a2dp_source_set_config_timer, A2DP_SET_CONFIG_DELAY_MS);
-    btstack_run_loop_add_timer(&a2dp_source_set_config_timer);
+    btstack_run_loop_remove_timer(&connection->set_config_timer);
+    btstack_run_loop_set_timer_handler(&connection->set_config_timer,a2dp_source_set_config_timer_handler);
+    btstack_run_loop_set_timer_context(&connection->set_config_timer, connection);
+    btstack_run_loop_set_timer(&connection->set_config_timer, A2DP_SET_CONFIG_DELAY_MS);
+    btstack_run_loop_add_timer(&connection->set_config_timer);
 }
-static void a2dp_source_set_config_timer_stop(void){
+static void a2dp_source_set_config_timer_stop(a2dp_source_connection_t * connection){
     log_info("a2dp_source_set_config_timer_stop");
-    btstack_run_loop_remove_timer(&a2dp_source_set_config_timer);
+    btstack_run_loop_remove_timer(&connection->set_config_timer);
+}
+
+static void a2dp_source_broadcast_groups_set_sink_delay(uint16_t avdtp_cid, uint8_t local_seid, uint16_t delay_100us){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &a2dp_source_broadcast_groups);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        avdtp_source_broadcast_group_t * group = (avdtp_source_broadcast_group_t *) btstack_linked_list_iterator_next(&it);
+        (void) avdtp_source_broadcast_group_set_sink_delay(group, avdtp_cid, local_seid, delay_100us);
+    }
 }
 
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
@@ -270,73 +342,91 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
     
     if (packet_type != HCI_EVENT_PACKET) return;
     if (hci_event_packet_get_type(packet) != HCI_EVENT_AVDTP_META) return;
-    
+
+    // all AVDTP subevents start with avdtp_cid
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_avdtp_cid(little_endian_read_16(packet, 3));
+    avdtp_stream_endpoint_context_t * sc = (connection != NULL) ? &connection->sc : NULL;
+
     switch (packet[2]){
         case AVDTP_SUBEVENT_SIGNALING_CONNECTION_ESTABLISHED:{
-            avdtp_subevent_signaling_connection_established_get_bd_addr(packet, sc.remote_addr);
+            avdtp_subevent_signaling_connection_established_get_bd_addr(packet, address);
             cid = avdtp_subevent_signaling_connection_established_get_avdtp_cid(packet);
             status = avdtp_subevent_signaling_connection_established_get_status(packet);
             
             if (status != 0){
                 log_info("AVDTP_SUBEVENT_SIGNALING_CONNECTION failed status %d ---", status);
-                app_state = A2DP_IDLE;
-                a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, sc.remote_addr, status);
+                if (connection != NULL){
+                    a2dp_source_connection_finalize(connection);
+                }
+                a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, address, status);
                 break;
             }
-            log_info("A2DP_SUBEVENT_SIGNALING_CONNECTION established avdtp_cid 0x%02x ---", a2dp_source_context.avdtp_cid);
+            log_info("A2DP_SUBEVENT_SIGNALING_CONNECTION established avdtp_cid 0x%02x ---", cid);
+
+            // remote initiated connection
+            if (connection == NULL){
+                connection = a2dp_source_connection_create();
+                if (connection == NULL){
+                    a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, address, ERROR_CODE_SUCCESS);
+                    break;
+                }
+                connection->sc.avdtp_cid = cid;
+                connection->sc.local_stream_endpoint = a2dp_source_get_unused_stream_endpoint();
+                sc = &connection->sc;
+            }
 
-            sc.avdtp_cid = cid;
-            sc.active_remote_sep = NULL;
-            sc.active_remote_sep_index = 0;
-            num_remote_seps = 0;
-            memset(remote_seps, 0, sizeof(avdtp_sep_t) * AVDTP_MAX_SEP_NUM);
+            (void)memcpy(sc->remote_addr, address, 6);
+            sc->active_remote_sep = NULL;
+            sc->active_remote_sep_index = 0;
+            connection->num_remote_seps = 0;
+            memset(connection->remote_seps, 0, sizeof(avdtp_sep_t) * AVDTP_MAX_SEP_NUM);
 
             // if we initiated the connection, start config right away, else wait a bit to give remote a chance to do it first
-            log_info("A2DP_SUBEVENT_SIGNALING_CONNECTION app_state %u", app_state);
-            if (app_state == A2DP_W4_CONNECTED){
-                app_state = A2DP_W2_DISCOVER_SEPS;
-                avdtp_source_discover_stream_endpoints(sc.avdtp_cid);
+            log_info("A2DP_SUBEVENT_SIGNALING_CONNECTION app_state %u", connection->state);
+            if (connection->state == A2DP_W4_CONNECTED){
+                connection->state = A2DP_W2_DISCOVER_SEPS;
+                avdtp_source_discover_stream_endpoints(cid);
             } else {
-                app_state = A2DP_CONNECTED;
-                a2dp_source_set_config_timer_start();
+                connection->state = A2DP_CONNECTED;
+                a2dp_source_set_config_timer_start(connection);
             }
             
             // notify app
-            a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, sc.remote_addr, ERROR_CODE_SUCCESS);
+            a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, sc->remote_addr, ERROR_CODE_SUCCESS);
             break;
         }
 
         case AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CAPABILITY:{
-            log_info("A2DP received SBC capability, received: local seid %d, remote seid %d, expected: local seid %d, remote seid %d", 
-                avdtp_subevent_signaling_media_codec_sbc_capability_get_local_seid(packet), 
-                avdtp_subevent_signaling_media_codec_sbc_capability_get_remote_seid(packet),
-                avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid );
-            
-            if (!sc.local_stream_endpoint) {
+            if (connection == NULL) break;
+            if (!sc->local_stream_endpoint) {
                 log_error("invalid local seid %d", avdtp_subevent_signaling_media_codec_sbc_capability_get_local_seid(packet));
                 return;
             }
+            log_info("A2DP received SBC capability, received: local seid %d, remote seid %d, expected: local seid %d, remote seid %d", 
+                avdtp_subevent_signaling_media_codec_sbc_capability_get_local_seid(packet), 
+                avdtp_subevent_signaling_media_codec_sbc_capability_get_remote_seid(packet),
+                avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep ? sc->active_remote_sep->seid : 0);
             
-            uint8_t sampling_frequency = avdtp_choose_sbc_sampling_frequency(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap(packet));
-            uint8_t channel_mode = avdtp_choose_sbc_channel_mode(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap(packet));
-            uint8_t block_length = avdtp_choose_sbc_block_length(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_block_length_bitmap(packet));
-            uint8_t subbands = avdtp_choose_sbc_subbands(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_subbands_bitmap(packet));
+            uint8_t sampling_frequency = avdtp_choose_sbc_sampling_frequency(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap(packet));
+            uint8_t channel_mode = avdtp_choose_sbc_channel_mode(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap(packet));
+            uint8_t block_length = avdtp_choose_sbc_block_length(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_block_length_bitmap(packet));
+            uint8_t subbands = avdtp_choose_sbc_subbands(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_subbands_bitmap(packet));
             
-            uint8_t allocation_method = avdtp_choose_sbc_allocation_method(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_allocation_method_bitmap(packet));
-            uint8_t max_bitpool_value = avdtp_choose_sbc_max_bitpool_value(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value(packet));
-            uint8_t min_bitpool_value = avdtp_choose_sbc_min_bitpool_value(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_min_bitpool_value(packet));
+            uint8_t allocation_method = avdtp_choose_sbc_allocation_method(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_allocation_method_bitmap(packet));
+            uint8_t max_bitpool_value = avdtp_choose_sbc_max_bitpool_value(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value(packet));
+            uint8_t min_bitpool_value = avdtp_choose_sbc_min_bitpool_value(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_min_bitpool_value(packet));
 
 
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[0] = (sampling_frequency << 4) | channel_mode;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[1] = (block_length << 4) | (subbands << 2) | allocation_method;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[2] = min_bitpool_value;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[3] = max_bitpool_value;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[0] = (sampling_frequency << 4) | channel_mode;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[1] = (block_length << 4) | (subbands << 2) | allocation_method;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[2] = min_bitpool_value;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[3] = max_bitpool_value;
 
-            sc.local_stream_endpoint->remote_configuration_bitmap = store_bit16(sc.local_stream_endpoint->remote_configuration_bitmap, AVDTP_MEDIA_CODEC, 1);
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_type = AVDTP_AUDIO;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_type = AVDTP_CODEC_SBC;
+            sc->local_stream_endpoint->remote_configuration_bitmap = store_bit16(sc->local_stream_endpoint->remote_configuration_bitmap, AVDTP_MEDIA_CODEC, 1);
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_type = AVDTP_AUDIO;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_type = AVDTP_CODEC_SBC;
 
-            app_state = A2DP_W2_SET_CONFIGURATION;
+            connection->state = A2DP_W2_SET_CONFIGURATION;
             break;
         }
         case AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_OTHER_CAPABILITY:
@@ -369,29 +459,39 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
 
         case AVDTP_SUBEVENT_SIGNALING_DELAY_REPORT:
+            // align playout of sinks in broadcast groups
+            if (connection != NULL){
+                connection->delay_100us = avdtp_subevent_signaling_delay_report_get_delay_100us(packet);
+                a2dp_source_broadcast_groups_set_sink_delay(sc->avdtp_cid, avdtp_subevent_signaling_delay_report_get_local_seid(packet), connection->delay_100us);
+            }
             // forward packet:
             a2dp_signaling_emit_delay_report(a2dp_source_context.a2dp_callback, packet, size);
             break;
         case AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION:{
-            // TODO check cid
-            a2dp_source_set_config_timer_stop();
-            sc.sampling_frequency = avdtp_subevent_signaling_media_codec_sbc_configuration_get_sampling_frequency(packet);
-            sc.channel_mode = avdtp_subevent_signaling_media_codec_sbc_configuration_get_channel_mode(packet);
-            sc.block_length = avdtp_subevent_signaling_media_codec_sbc_configuration_get_block_length(packet);
-            sc.subbands = avdtp_subevent_signaling_media_codec_sbc_configuration_get_subbands(packet);
-            sc.allocation_method = avdtp_subevent_signaling_media_codec_sbc_configuration_get_allocation_method(packet);
-            sc.max_bitpool_value = avdtp_subevent_signaling_media_codec_sbc_configuration_get_max_bitpool_value(packet);
-            sc.min_bitpool_value = avdtp_subevent_signaling_media_codec_sbc_configuration_get_min_bitpool_value(packet);
+            if (connection == NULL) break;
+            a2dp_source_set_config_timer_stop(connection);
+            // remote may have configured another local stream endpoint
+            avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(avdtp_subevent_signaling_media_codec_sbc_configuration_get_local_seid(packet), &a2dp_source_context);
+            if (stream_endpoint != NULL){
+                sc->local_stream_endpoint = stream_endpoint;
+            }
+            sc->sampling_frequency = avdtp_subevent_signaling_media_codec_sbc_configuration_get_sampling_frequency(packet);
+            sc->channel_mode = avdtp_subevent_signaling_media_codec_sbc_configuration_get_channel_mode(packet);
+            sc->block_length = avdtp_subevent_signaling_media_codec_sbc_configuration_get_block_length(packet);
+            sc->subbands = avdtp_subevent_signaling_media_codec_sbc_configuration_get_subbands(packet);
+            sc->allocation_method = avdtp_subevent_signaling_media_codec_sbc_configuration_get_allocation_method(packet);
+            sc->max_bitpool_value = avdtp_subevent_signaling_media_codec_sbc_configuration_get_max_bitpool_value(packet);
+            sc->min_bitpool_value = avdtp_subevent_signaling_media_codec_sbc_configuration_get_min_bitpool_value(packet);
             // TODO: deal with reconfigure: avdtp_subevent_signaling_media_codec_sbc_configuration_get_reconfigure(packet);
-            log_info("A2DP received SBC Config: sample rate %u, max bitpool %u., remote seid %d", sc.sampling_frequency, sc.max_bitpool_value, avdtp_subevent_signaling_media_codec_sbc_configuration_get_remote_seid(packet));
-            app_state = A2DP_W2_OPEN_STREAM_WITH_SEID;
+            log_info("A2DP received SBC Config: sample rate %u, max bitpool %u., remote seid %d", sc->sampling_frequency, sc->max_bitpool_value, avdtp_subevent_signaling_media_codec_sbc_configuration_get_remote_seid(packet));
+            connection->state = A2DP_W2_OPEN_STREAM_WITH_SEID;
             a2dp_signaling_emit_media_codec_sbc(a2dp_source_context.a2dp_callback, packet, size);
             break;
         }  
        
         case AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW: 
             cid = avdtp_subevent_streaming_can_send_media_packet_now_get_avdtp_cid(packet);
-            local_seid = avdtp_subevent_streaming_can_send_media_packet_now_get_avdtp_cid(packet);
+            local_seid = avdtp_subevent_streaming_can_send_media_packet_now_get_local_seid(packet);
             // log_info("A2DP STREAMING_CAN_SEND_MEDIA_PACKET_NOW cid 0x%02x, local_seid %d", cid, local_seid);
             a2dp_streaming_emit_can_send_media_packet_now(a2dp_source_context.a2dp_callback, cid, local_seid);
             break;
@@ -408,92 +508,100 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                 break;
             }
             log_info("A2DP streaming connection established --- avdtp_cid 0x%02x, local seid %d, remote seid %d", cid, local_seid, remote_seid);
-            app_state = A2DP_STREAMING_OPENED;
+            if (connection != NULL){
+                connection->state = A2DP_STREAMING_OPENED;
+            }
             a2dp_streaming_emit_connection_established(a2dp_source_context.a2dp_callback, cid, address, local_seid, remote_seid, 0);
             break;
 
         case AVDTP_SUBEVENT_SIGNALING_SEP_FOUND:{
+            if (connection == NULL) break;
             avdtp_sep_t sep;
             sep.seid = avdtp_subevent_signaling_sep_found_get_remote_seid(packet);;
             sep.in_use = avdtp_subevent_signaling_sep_found_get_in_use(packet);
             sep.media_type = (avdtp_media_type_t) avdtp_subevent_signaling_sep_found_get_media_type(packet);
             sep.type = (avdtp_sep_type_t) avdtp_subevent_signaling_sep_found_get_sep_type(packet);
             log_info("A2DP Found sep: remote seid %u, in_use %d, media type %d, sep type %s (1-SNK), index %d",
-                    sep.seid, sep.in_use, sep.media_type, sep.type == AVDTP_SOURCE ? "source" : "sink", num_remote_seps);
-            if (sep.type == AVDTP_SINK){
-                remote_seps[num_remote_seps++] = sep;
+                    sep.seid, sep.in_use, sep.media_type, sep.type == AVDTP_SOURCE ? "source" : "sink", connection->num_remote_seps);
+            if ((sep.type == AVDTP_SINK) && (connection->num_remote_seps < AVDTP_MAX_SEP_NUM)){
+                connection->remote_seps[connection->num_remote_seps++] = sep;
             }
             break;
         }
         case AVDTP_SUBEVENT_SIGNALING_SEP_DICOVERY_DONE:
-            app_state = A2DP_W2_GET_CAPABILITIES;
-            sc.active_remote_sep_index = 0;
+            if (connection == NULL) break;
+            connection->state = A2DP_W2_GET_CAPABILITIES;
+            sc->active_remote_sep_index = 0;
             break;
 
         case AVDTP_SUBEVENT_SIGNALING_ACCEPT:
-            // TODO check cid
             signal_identifier = avdtp_subevent_signaling_accept_get_signal_identifier(packet);
             cid = avdtp_subevent_signaling_accept_get_avdtp_cid(packet);
             log_info("A2DP cmd %s accepted , cid 0x%2x, local seid %d", avdtp_si2str(signal_identifier), cid, avdtp_subevent_signaling_accept_get_local_seid(packet));
             
             if (avdtp_subevent_signaling_accept_get_is_initiator(packet) != 1) break;
+            if (connection == NULL) break;
             
-            switch (app_state){
+            switch (connection->state){
                 case A2DP_W2_GET_CAPABILITIES:
-                    if (sc.active_remote_sep_index < num_remote_seps){
-                        sc.active_remote_sep = &remote_seps[sc.active_remote_sep_index++];
-                        log_info("A2DP get capabilities for remote seid %d", sc.active_remote_sep->seid);
-                        avdtp_source_get_capabilities(cid, sc.active_remote_sep->seid);
+                    if (sc->active_remote_sep_index < connection->num_remote_seps){
+                        sc->active_remote_sep = &connection->remote_seps[sc->active_remote_sep_index++];
+                        log_info("A2DP get capabilities for remote seid %d", sc->active_remote_sep->seid);
+                        avdtp_source_get_capabilities(cid, sc->active_remote_sep->seid);
                     }
                     break;
                 case A2DP_W2_SET_CONFIGURATION:{
-                    if (!sc.local_stream_endpoint) return;
-                    log_info("A2DP initiate set configuration locally and wait for response ... local seid %d, remote seid %d", avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid);
-                    app_state = A2DP_IDLE;
-                    avdtp_source_set_configuration(cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid, sc.local_stream_endpoint->remote_configuration_bitmap, sc.local_stream_endpoint->remote_configuration);
+                    if (!sc->local_stream_endpoint) return;
+                    log_info("A2DP initiate set configuration locally and wait for response ... local seid %d, remote seid %d", avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid);
+                    connection->state = A2DP_IDLE;
+                    avdtp_source_set_configuration(cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid, sc->local_stream_endpoint->remote_configuration_bitmap, sc->local_stream_endpoint->remote_configuration);
                     break;
                 }
                 case A2DP_W2_RECONFIGURE_WITH_SEID:
-                    log_info("A2DP reconfigured ... local seid %d, active remote seid %d", avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid);
-                    a2dp_signaling_emit_reconfigured(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), 0);
-                    app_state = A2DP_STREAMING_OPENED;
+                    log_info("A2DP reconfigured ... local seid %d, active remote seid %d", avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid);
+                    a2dp_signaling_emit_reconfigured(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), 0);
+                    connection->state = A2DP_STREAMING_OPENED;
                     break;
                 case A2DP_W2_OPEN_STREAM_WITH_SEID:{
-                    log_info("A2DP open stream ... local seid %d, active remote seid %d", avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid);
-                    app_state = A2DP_W4_OPEN_STREAM_WITH_SEID;
-                    avdtp_source_open_stream(cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid);
+                    log_info("A2DP open stream ... local seid %d, active remote seid %d", avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid);
+                    connection->state = A2DP_W4_OPEN_STREAM_WITH_SEID;
+                    avdtp_source_open_stream(cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid);
                     break;
                 }
                 case A2DP_STREAMING_OPENED:
                     if (!a2dp_source_context.a2dp_callback) return;
                     switch (signal_identifier){
                         case  AVDTP_SI_START:
-                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), A2DP_SUBEVENT_STREAM_STARTED);
+                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), A2DP_SUBEVENT_STREAM_STARTED);
                             break;
                         case AVDTP_SI_SUSPEND:
-                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), A2DP_SUBEVENT_STREAM_SUSPENDED);
+                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), A2DP_SUBEVENT_STREAM_SUSPENDED);
                             break;
                         case AVDTP_SI_ABORT:
                         case AVDTP_SI_CLOSE:
-                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), A2DP_SUBEVENT_STREAM_STOPPED);
+                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), A2DP_SUBEVENT_STREAM_STOPPED);
                             break;
                         default:
                             break;
                     }
                     break;
                 default:
-                    app_state = A2DP_IDLE;
+                    connection->state = A2DP_IDLE;
                     break;
             }
             
             break;
         case AVDTP_SUBEVENT_SIGNALING_REJECT:
         case AVDTP_SUBEVENT_SIGNALING_GENERAL_REJECT:
-            app_state = A2DP_IDLE;
+            if (connection != NULL){
+                connection->state = A2DP_IDLE;
+            }
             a2dp_signaling_emit_reject_cmd(a2dp_source_context.a2dp_callback, packet, size);
             break;
         case AVDTP_SUBEVENT_SIGNALING_CONNECTION_RELEASED:{
-            app_state = A2DP_IDLE;
+            if (connection != NULL){
+                a2dp_source_connection_finalize(connection);
+            }
             uint8_t event[6];
             int pos = 0;
             event[pos++] = HCI_EVENT_A2DP_META;
@@ -506,7 +614,9 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
         }
         case AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED:{
-            app_state = A2DP_IDLE;
+            if (connection != NULL){
+                connection->state = A2DP_IDLE;
+            }
             uint8_t event[6];
             int pos = 0;
             event[pos++] = HCI_EVENT_A2DP_META;
@@ -519,7 +629,9 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
         }
         default:
-            app_state = A2DP_IDLE;
+            if (connection != NULL){
+                connection->state = A2DP_IDLE;
+            }
             log_info("not implemented");
             break; 
     }
@@ -550,20 +662,41 @@ avdtp_stream_endpoint_t * a2dp_source_create_stream_endpoint(avdtp_media_type_t
     
     local_stream_endpoint->remote_configuration.media_codec.media_codec_information     = media_codec_info;
     local_stream_endpoint->remote_configuration.media_codec.media_codec_information_len = media_codec_info_len;
-    sc.local_stream_endpoint = local_stream_endpoint;                     
+    a2dp_source_default_stream_endpoint = local_stream_endpoint;
     avdtp_source_register_delay_reporting_category(avdtp_stream_endpoint_seid(local_stream_endpoint));
     return local_stream_endpoint;
 }
 
 uint8_t a2dp_source_establish_stream(bd_addr_t remote_addr, uint8_t loc_seid, uint16_t * a2dp_cid){
-    sc.local_stream_endpoint = avdtp_stream_endpoint_for_seid(loc_seid, &a2dp_source_context);
-    if (!sc.local_stream_endpoint){
+    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(loc_seid, &a2dp_source_context);
+    if (!stream_endpoint){
         log_error(" no local_stream_endpoint for seid %d", loc_seid);
         return AVDTP_SEID_DOES_NOT_EXIST;
     }
-    (void)memcpy(sc.remote_addr, remote_addr, 6);
-    app_state = A2DP_W4_CONNECTED;
-    return avdtp_source_connect(remote_addr, a2dp_cid);
+    a2dp_source_connection_t * connection = a2dp_source_connection_create();
+    if (connection == NULL){
+        return BTSTACK_MEMORY_ALLOC_FAILED;
+    }
+    uint16_t avdtp_cid;
+    uint8_t status = avdtp_source_connect(remote_addr, &avdtp_cid);
+    if (status != ERROR_CODE_SUCCESS){
+        a2dp_source_connection_finalize(connection);
+        return status;
+    }
+    // already known connection to this sink
+    a2dp_source_connection_t * existing_connection = a2dp_source_connection_for_avdtp_cid(avdtp_cid);
+    if (existing_connection != NULL){
+        a2dp_source_connection_finalize(connection);
+        connection = existing_connection;
+    }
+    connection->sc.avdtp_cid = avdtp_cid;
+    connection->sc.local_stream_endpoint = stream_endpoint;
+    (void)memcpy(connection->sc.remote_addr, remote_addr, 6);
+    connection->state = A2DP_W4_CONNECTED;
+    if (a2dp_cid != NULL){
+        *a2dp_cid = avdtp_cid;
+    }
+    return ERROR_CODE_SUCCESS;
 }
 
 uint8_t a2dp_source_disconnect(uint16_t a2dp_cid){
@@ -575,12 +708,21 @@ uint8_t a2dp_source_reconfigure_stream_sampling_frequency(uint16_t a2dp_cid, uin
 
     log_info("a2dp_source_reconfigure_stream");
 
-    (void)memcpy(sc.local_stream_endpoint->reconfigure_media_codec_sbc_info,
-                 sc.local_stream_endpoint->remote_sep.configuration.media_codec.media_codec_information,
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_avdtp_cid(a2dp_cid);
+    if (connection == NULL){
+        return AVDTP_CONNECTION_DOES_NOT_EXIST;
+    }
+    avdtp_stream_endpoint_context_t * sc = &connection->sc;
+    if ((sc->local_stream_endpoint == NULL) || (sc->active_remote_sep == NULL)){
+        return AVDTP_STREAM_ENDPOINT_DOES_NOT_EXIST;
+    }
+
+    (void)memcpy(sc->local_stream_endpoint->reconfigure_media_codec_sbc_info,
+                 sc->local_stream_endpoint->remote_sep.configuration.media_codec.media_codec_information,
                  4);
 
     // update sampling frequency
-    uint8_t config = sc.local_stream_endpoint->reconfigure_media_codec_sbc_info[0] & 0x0f;
+    uint8_t config = sc->local_stream_endpoint->reconfigure_media_codec_sbc_info[0] & 0x0f;
     switch (sampling_frequency){
         case 48000:
             config |= (AVDTP_SBC_48000 << 4);
@@ -598,20 +740,20 @@ uint8_t a2dp_source_reconfigure_stream_sampling_frequency(uint16_t a2dp_cid, uin
             log_error("Unsupported sampling frequency %u", sampling_frequency);
             return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
     }
-    sc.local_stream_endpoint->reconfigure_media_codec_sbc_info[0] = config;
+    sc->local_stream_endpoint->reconfigure_media_codec_sbc_info[0] = config;
 
     avdtp_capabilities_t new_configuration;
     new_configuration.media_codec.media_type = AVDTP_AUDIO;
     new_configuration.media_codec.media_codec_type = AVDTP_CODEC_SBC;
     new_configuration.media_codec.media_codec_information_len = 4;
-    new_configuration.media_codec.media_codec_information = sc.local_stream_endpoint->reconfigure_media_codec_sbc_info;
+    new_configuration.media_codec.media_codec_information = sc->local_stream_endpoint->reconfigure_media_codec_sbc_info;
 
     // sttart reconfigure
-    app_state = A2DP_W2_RECONFIGURE_WITH_SEID;
+    connection->state = A2DP_W2_RECONFIGURE_WITH_SEID;
     return avdtp_source_reconfigure(
         a2dp_cid,
-        avdtp_stream_endpoint_seid(sc.local_stream_endpoint),
-        sc.active_remote_sep->seid,
+        avdtp_stream_endpoint_seid(sc->local_stream_endpoint),
+        sc->active_remote_sep->seid,
         1 << AVDTP_MEDIA_CODEC,
         new_configuration
         );
@@ -629,6 +771,12 @@ void a2dp_source_stream_endpoint_request_can_send_now(uint16_t a2dp_cid, uint8_t
     avdtp_source_stream_endpoint_request_can_send_now(a2dp_cid, local_seid);
 }
 
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+void a2dp_source_set_media_latency_budget(uint8_t local_seid, uint16_t latency_budget_ms){
+    avdtp_source_set_media_latency_budget(local_seid, latency_budget_ms);
+}
+#endif
+
 int a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid){
     return avdtp_max_media_payload_size(a2dp_cid, local_seid);
 }
@@ -636,3 +784,182 @@ int a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid){
 int a2dp_source_stream_send_media_payload(uint16_t a2dp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
     return avdtp_source_stream_send_media_payload(a2dp_cid, local_seid, storage, num_bytes_to_copy, num_frames, marker);
 }
+
+void a2dp_source_broadcast_group_init(avdtp_source_broadcast_group_t * group, uint8_t * storage, uint16_t storage_size){
+    btstack_linked_list_remove(&a2dp_source_broadcast_groups, (btstack_linked_item_t *) group);
+    avdtp_source_broadcast_group_init(group, storage, storage_size);
+    // delay reports of sinks get applied to the group
+    btstack_linked_list_add(&a2dp_source_broadcast_groups, (btstack_linked_item_t *) group);
+}
+
+uint8_t a2dp_source_broadcast_group_add_sink(avdtp_source_broadcast_group_t * group, uint16_t a2dp_cid, uint8_t local_seid){
+    uint8_t status = avdtp_source_broadcast_group_add_sink(group, a2dp_cid, local_seid);
+    if (status != ERROR_CODE_SUCCESS) return status;
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_avdtp_cid(a2dp_cid);
+    if (connection != NULL){
+        (void) avdtp_source_broadcast_group_set_sink_delay(group, a2dp_cid, local_seid, connection->delay_100us);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t a2dp_source_broadcast_group_remove_sink(avdtp_source_broadcast_group_t * group, uint16_t a2dp_cid, uint8_t local_seid){
+    return avdtp_source_broadcast_group_remove_sink(group, a2dp_cid, local_seid);
+}
+
+uint16_t a2dp_source_get_delay_report(uint16_t a2dp_cid){
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_avdtp_cid(a2dp_cid);
+    if (connection == NULL) return 0;
+    return connection->delay_100us;
+}
+
+uint8_t a2dp_source_broadcast_group_add_payload(avdtp_source_broadcast_group_t * group, const uint8_t * data, uint16_t len, uint8_t num_frames, uint8_t marker){
+    return avdtp_source_broadcast_group_add_payload(group, data, len, num_frames, marker);
+}
+
+uint8_t a2dp_source_broadcast_group_send(avdtp_source_broadcast_group_t * group, uint16_t a2dp_cid, uint8_t local_seid){
+    return avdtp_source_broadcast_group_send(group, a2dp_cid, local_seid);
+}
+
+void a2dp_source_bitpool_control_init(a2dp_source_bitpool_control_t * control, uint8_t min_bitpool_value, uint8_t max_bitpool_value){
+    if (min_bitpool_value > max_bitpool_value){
+        min_bitpool_value = max_bitpool_value;
+    }
+    control->min_bitpool_value = min_bitpool_value;
+    control->max_bitpool_value = max_bitpool_value;
+    control->bitpool_value = max_bitpool_value;
+    control->num_updates_without_congestion = 0;
+}
+
+uint8_t a2dp_source_bitpool_control_update(a2dp_source_bitpool_control_t * control, uint16_t a2dp_cid, uint8_t local_seid, uint32_t queued_audio_ms, uint32_t target_audio_ms){
+    UNUSED(a2dp_cid);
+    int free_acl_slots = 1;
+    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, &a2dp_source_context);
+    if (stream_endpoint && stream_endpoint->media_con_handle){
+        free_acl_slots = hci_number_free_acl_slots_for_handle(stream_endpoint->media_con_handle);
+    }
+
+    if (queued_audio_ms > target_audio_ms || free_acl_slots <= 0){
+        // congestion: back off by a quarter of the usable range, at least one
+        uint8_t step = (control->bitpool_value - control->min_bitpool_value) / 4;
+        if (step == 0){
+            step = 1;
+        }
+        if (control->bitpool_value >= control->min_bitpool_value + step){
+            control->bitpool_value -= step;
+        } else {
+            control->bitpool_value = control->min_bitpool_value;
+        }
+        control->num_updates_without_congestion = 0;
+        log_debug("bitpool control: congestion, queued %d ms, free acl %d -> bitpool %u", (int) queued_audio_ms, free_acl_slots, control->bitpool_value);
+    } else if (queued_audio_ms <= target_audio_ms / 2){
+        control->num_updates_without_congestion++;
+        if (control->num_updates_without_congestion >= A2DP_SOURCE_BITPOOL_CONTROL_INCREASE_UPDATES){
+            control->num_updates_without_congestion = 0;
+            if (control->bitpool_value < control->max_bitpool_value){
+                control->bitpool_value++;
+            }
+        }
+    }
+    return control->bitpool_value;
+}
+
+static void a2dp_source_media_pacer_update(a2dp_source_media_pacer_t * pacer){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    uint32_t elapsed_ms = now - pacer->last_update_ms;
+    pacer->last_update_ms = now;
+    // more than a second cannot be caught up anyway, also avoids overflow
+    if (elapsed_ms > 1000){
+        elapsed_ms = 1000;
+    }
+
+    // samples for elapsed time, keep fraction for next update
+    uint32_t product = elapsed_ms * pacer->sample_rate + pacer->remainder;
+    pacer->num_samples_due += product / 1000;
+    pacer->remainder = product % 1000;
+
+    // drop audio that cannot be sent in time anyway
+    uint32_t max_samples_due = (uint32_t) A2DP_SOURCE_MEDIA_PACER_MAX_CATCH_UP_PACKETS * pacer->num_frames_per_packet * pacer->num_samples_per_frame;
+    if (pacer->num_samples_due > max_samples_due){
+        log_info("media pacer: drop %u samples", (int) (pacer->num_samples_due - max_samples_due));
+        pacer->num_samples_due = max_samples_due;
+    }
+}
+
+static void a2dp_source_media_pacer_request_can_send_now(a2dp_source_media_pacer_t * pacer){
+    if (pacer->can_send_now_requested) return;
+    if (pacer->num_samples_due < ((uint32_t) pacer->num_frames_per_packet * pacer->num_samples_per_frame)) return;
+    pacer->can_send_now_requested = 1;
+    a2dp_source_stream_endpoint_request_can_send_now(pacer->a2dp_cid, pacer->local_seid);
+}
+
+static void a2dp_source_media_pacer_timer_handler(btstack_timer_source_t * timer){
+    a2dp_source_media_pacer_t * pacer = (a2dp_source_media_pacer_t *) btstack_run_loop_get_timer_context(timer);
+    btstack_run_loop_set_timer(&pacer->timer, pacer->packet_interval_ms);
+    btstack_run_loop_add_timer(&pacer->timer);
+    a2dp_source_media_pacer_update(pacer);
+    a2dp_source_media_pacer_request_can_send_now(pacer);
+}
+
+void a2dp_source_media_pacer_set_frame_size(a2dp_source_media_pacer_t * pacer, uint16_t frame_size){
+    // media payload starts with SBC header
+    uint16_t num_frames = 1;
+    if ((frame_size > 0) && (pacer->max_payload_size > frame_size)){
+        num_frames = (pacer->max_payload_size - 1) / frame_size;
+    }
+    // SBC header stores number of frames in 4 bits
+    num_frames = btstack_max(1, btstack_min(num_frames, 15));
+    pacer->num_frames_per_packet = (uint8_t) num_frames;
+    // check twice per media packet, so timer jitter does not delay a packet by a full interval
+    uint32_t interval_ms = ((uint32_t) num_frames * pacer->num_samples_per_frame * 1000) / (2 * pacer->sample_rate);
+    pacer->packet_interval_ms = (uint16_t) btstack_max(1, interval_ms);
+}
+
+void a2dp_source_media_pacer_init(a2dp_source_media_pacer_t * pacer, uint16_t a2dp_cid, uint8_t local_seid, uint32_t sample_rate, uint16_t num_samples_per_frame, uint16_t max_payload_size){
+    memset(pacer, 0, sizeof(a2dp_source_media_pacer_t));
+    pacer->a2dp_cid = a2dp_cid;
+    pacer->local_seid = local_seid;
+    pacer->sample_rate = sample_rate;
+    pacer->num_samples_per_frame = num_samples_per_frame;
+    pacer->max_payload_size = max_payload_size;
+    a2dp_source_media_pacer_set_frame_size(pacer, 0);
+}
+
+void a2dp_source_media_pacer_start(a2dp_source_media_pacer_t * pacer){
+    pacer->last_update_ms = btstack_run_loop_get_time_ms();
+    pacer->remainder = 0;
+    pacer->num_samples_due = 0;
+    pacer->can_send_now_requested = 0;
+    pacer->active = 1;
+    btstack_run_loop_remove_timer(&pacer->timer);
+    btstack_run_loop_set_timer_handler(&pacer->timer, &a2dp_source_media_pacer_timer_handler);
+    btstack_run_loop_set_timer_context(&pacer->timer, pacer);
+    btstack_run_loop_set_timer(&pacer->timer, pacer->packet_interval_ms);
+    btstack_run_loop_add_timer(&pacer->timer);
+}
+
+void a2dp_source_media_pacer_stop(a2dp_source_media_pacer_t * pacer){
+    pacer->active = 0;
+    pacer->num_samples_due = 0;
+    pacer->can_send_now_requested = 0;
+    btstack_run_loop_remove_timer(&pacer->timer);
+}
+
+uint8_t a2dp_source_media_pacer_get_num_frames(a2dp_source_media_pacer_t * pacer){
+    pacer->can_send_now_requested = 0;
+    if (!pacer->active) return 0;
+    a2dp_source_media_pacer_update(pacer);
+    uint32_t num_frames = pacer->num_samples_due / pacer->num_samples_per_frame;
+    return (uint8_t) btstack_min(num_frames, pacer->num_frames_per_packet);
+}
+
+uint32_t a2dp_source_media_pacer_get_queued_ms(a2dp_source_media_pacer_t * pacer){
+    return (pacer->num_samples_due * 1000) / pacer->sample_rate;
+}
+
+void a2dp_source_media_pacer_packet_sent(a2dp_source_media_pacer_t * pacer, uint8_t num_frames){
+    uint32_t num_samples = (uint32_t) num_frames * pacer->num_samples_per_frame;
+    pacer->num_samples_due = (num_samples < pacer->num_samples_due) ? (pacer->num_samples_due - num_samples) : 0;
+    if (!pacer->active) return;
+    // catch up without waiting for next timeout
+    a2dp_source_media_pacer_request_can_send_now(pacer);
+}
@@ -53,6 +53,40 @@
 extern "C" {
 #endif
 
+// number of consecutive updates without congestion before bitpool is increased by one
+#ifndef A2DP_SOURCE_BITPOOL_CONTROL_INCREASE_UPDATES
+#define A2DP_SOURCE_BITPOOL_CONTROL_INCREASE_UPDATES 8
+#endif
+
+typedef struct {
+    uint8_t min_bitpool_value;
+    uint8_t max_bitpool_value;
+    uint8_t bitpool_value;
+    uint8_t num_updates_without_congestion;
+} a2dp_source_bitpool_control_t;
+
+// max number of media packets sent back-to-back to catch up after a stall, older audio gets dropped
+#ifndef A2DP_SOURCE_MEDIA_PACER_MAX_CATCH_UP_PACKETS
+#define A2DP_SOURCE_MEDIA_PACER_MAX_CATCH_UP_PACKETS 4
+#endif
+
+typedef struct {
+    btstack_timer_source_t timer;
+    uint16_t a2dp_cid;
+    uint8_t  local_seid;
+    uint32_t sample_rate;
+    uint16_t num_samples_per_frame;
+    uint16_t max_payload_size;
+    uint8_t  num_frames_per_packet;
+    uint16_t packet_interval_ms;
+    // audio samples due according to wall clock but not sent yet
+    uint32_t last_update_ms;
+    uint32_t remainder;
+    uint32_t num_samples_due;
+    uint8_t  can_send_now_requested;
+    uint8_t  active;
+} a2dp_source_media_pacer_t;
+
 /* API_START */
 
 /**
@@ -148,6 +182,14 @@ uint8_t a2dp_source_disconnect(uint16_t a2dp_cid);
  */
 void 	a2dp_source_stream_endpoint_request_can_send_now(uint16_t a2dp_cid, uint8_t local_seid);
 
+/**
+ * @brief Set latency budget for media packets. Late packets are flushed by the Controller instead of delaying newer ones,
+ *        see gap_get_flushed_packets for the number of flushed packets. Requires ENABLE_CLASSIC_MEDIA_QOS
+ * @param local_seid  		ID of a local stream endpoint.
+ * @param latency_budget_ms default AVDTP_MEDIA_LATENCY_BUDGET_MS, max 1279 ms, 0 = no flush
+ */
+void    a2dp_source_set_media_latency_budget(uint8_t local_seid, uint16_t latency_budget_ms);
+
 /**
  * @brief Return maximal media payload size, does not include media header.
  * @param a2dp_cid 			A2DP channel identifyer.
@@ -168,6 +210,134 @@ int 	a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid);
  */
 int  	a2dp_source_stream_send_media_payload(uint16_t a2dp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker);
 
+/**
+ * @brief Init broadcast group that sends the same media payload to several A2DP Sinks
+ * @note  Each sink is a local stream endpoint with own RTP sequence number, pacing and credits
+ * @param group
+ * @param storage for AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS payloads shared by all sinks
+ * @param storage_size
+ */
+void    a2dp_source_broadcast_group_init(avdtp_source_broadcast_group_t * group, uint8_t * storage, uint16_t storage_size);
+
+/**
+ * @brief Add sink to broadcast group. It receives payloads added afterwards
+ * @note  Payloads for sinks with shorter reported delay are held back to align playout with the slowest sink
+ * @param group
+ * @param a2dp_cid
+ * @param local_seid
+ * @return status
+ */
+uint8_t a2dp_source_broadcast_group_add_sink(avdtp_source_broadcast_group_t * group, uint16_t a2dp_cid, uint8_t local_seid);
+
+/**
+ * @brief Remove sink from broadcast group, e.g. on A2DP_SUBEVENT_STREAM_RELEASED
+ * @param group
+ * @param a2dp_cid
+ * @param local_seid
+ * @return status
+ */
+uint8_t a2dp_source_broadcast_group_remove_sink(avdtp_source_broadcast_group_t * group, uint16_t a2dp_cid, uint8_t local_seid);
+
+/**
+ * @brief Add media payload, e.g. SBC frames encoded once, for all sinks
+ * @param group
+ * @param data
+ * @param len
+ * @param num_frames
+ * @param marker
+ * @return status
+ */
+uint8_t a2dp_source_broadcast_group_add_payload(avdtp_source_broadcast_group_t * group, const uint8_t * data, uint16_t len, uint8_t num_frames, uint8_t marker);
+
+/**
+ * @brief Send next payload to sink on A2DP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW
+ * @param group
+ * @param a2dp_cid
+ * @param local_seid
+ * @return status
+ */
+uint8_t a2dp_source_broadcast_group_send(avdtp_source_broadcast_group_t * group, uint16_t a2dp_cid, uint8_t local_seid);
+
+/**
+ * @brief Get last delay reported by A2DP Sink
+ * @param a2dp_cid
+ * @return delay in 0.1 ms, 0 if unknown
+ */
+uint16_t a2dp_source_get_delay_report(uint16_t a2dp_cid);
+
+/**
+ * @brief Init media pacer that requests can send now whenever a full media packet of audio is due
+ * @note  Samples due are tracked against btstack_run_loop_get_time_ms, so timer jitter does not accumulate
+ * @param pacer
+ * @param a2dp_cid
+ * @param local_seid
+ * @param sample_rate
+ * @param num_samples_per_frame e.g. btstack_sbc_encoder_num_audio_frames
+ * @param max_payload_size e.g. a2dp_max_media_payload_size limited by size of application buffer
+ */
+void    a2dp_source_media_pacer_init(a2dp_source_media_pacer_t * pacer, uint16_t a2dp_cid, uint8_t local_seid, uint32_t sample_rate, uint16_t num_samples_per_frame, uint16_t max_payload_size);
+
+/**
+ * @brief Set size of encoded frame to calculate number of frames per media packet, e.g. after bitpool change
+ * @param pacer
+ * @param frame_size e.g. btstack_sbc_encoder_sbc_buffer_length
+ */
+void    a2dp_source_media_pacer_set_frame_size(a2dp_source_media_pacer_t * pacer, uint16_t frame_size);
+
+/**
+ * @brief Start pacing on A2DP_SUBEVENT_STREAM_STARTED
+ * @param pacer
+ */
+void    a2dp_source_media_pacer_start(a2dp_source_media_pacer_t * pacer);
+
+/**
+ * @brief Stop pacing on A2DP_SUBEVENT_STREAM_SUSPENDED or A2DP_SUBEVENT_STREAM_RELEASED
+ * @param pacer
+ */
+void    a2dp_source_media_pacer_stop(a2dp_source_media_pacer_t * pacer);
+
+/**
+ * @brief Get number of frames to encode and send on A2DP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW
+ * @param pacer
+ * @return num_frames, at most one media packet
+ */
+uint8_t a2dp_source_media_pacer_get_num_frames(a2dp_source_media_pacer_t * pacer);
+
+/**
+ * @brief Get audio due but not sent yet, e.g. for a2dp_source_bitpool_control_update
+ * @param pacer
+ * @return queued_audio_ms
+ */
+uint32_t a2dp_source_media_pacer_get_queued_ms(a2dp_source_media_pacer_t * pacer);
+
+/**
+ * @brief Report media packet sent. Requests can send now again if more audio is due
+ * @param pacer
+ * @param num_frames sent
+ */
+void    a2dp_source_media_pacer_packet_sent(a2dp_source_media_pacer_t * pacer, uint8_t num_frames);
+
+/**
+ * @brief Init adaptive bitpool control for SBC stream using negotiated bitpool range
+ * @param control
+ * @param min_bitpool_value from A2DP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION
+ * @param max_bitpool_value from A2DP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION
+ */
+void    a2dp_source_bitpool_control_init(a2dp_source_bitpool_control_t * control, uint8_t min_bitpool_value, uint8_t max_bitpool_value);
+
+/**
+ * @brief Update bitpool based on link quality, call before encoding next media packet
+ * @note  Bitpool is reduced if more audio is queued than targeted or if no ACL buffers are free for the media channel,
+ *        and slowly increased again if the link keeps up. Apply result with btstack_sbc_encoder_state_set_bitpool.
+ * @param control
+ * @param a2dp_cid
+ * @param local_seid
+ * @param queued_audio_ms audio waiting to be encoded and sent
+ * @param target_audio_ms
+ * @return bitpool value within negotiated range
+ */
+uint8_t a2dp_source_bitpool_control_update(a2dp_source_bitpool_control_t * control, uint16_t a2dp_cid, uint8_t local_seid, uint32_t queued_audio_ms, uint32_t target_audio_ms);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -46,6 +46,7 @@
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_memory.h"
+#include "btstack_trace.h"
 #include "classic/avdtp.h"
 #include "classic/avdtp_acceptor.h"
 #include "classic/avdtp_initiator.h"
@@ -315,6 +316,26 @@ avdtp_connection_t * avdtp_create_connection(bd_addr_t remote_addr, avdtp_contex
     return connection;
 }
 
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+// send media flushable and let Controller drop packets that exceed the latency budget instead of delaying newer ones
+static void avdtp_stream_endpoint_setup_media_qos(avdtp_stream_endpoint_t * stream_endpoint){
+    if (stream_endpoint->l2cap_media_cid == 0) return;
+    uint16_t latency_budget_ms = stream_endpoint->media_latency_budget_ms;
+    l2cap_set_flushable(stream_endpoint->l2cap_media_cid, latency_budget_ms != 0);
+    gap_set_automatic_flush_timeout(stream_endpoint->media_con_handle, latency_budget_ms);
+    log_info("media qos: cid 0x%02x, flush timeout %u ms", stream_endpoint->l2cap_media_cid, latency_budget_ms);
+}
+
+void avdtp_set_media_latency_budget(avdtp_stream_endpoint_t * stream_endpoint, uint16_t latency_budget_ms){
+    if (!stream_endpoint){
+        log_error("Stream endpoint with given seid is not registered.");
+        return;
+    }
+    stream_endpoint->media_latency_budget_ms = latency_budget_ms;
+    avdtp_stream_endpoint_setup_media_qos(stream_endpoint);
+}
+#endif
+
 avdtp_stream_endpoint_t * avdtp_create_stream_endpoint(avdtp_sep_type_t sep_type, avdtp_media_type_t media_type, avdtp_context_t * context){
     avdtp_stream_endpoint_t * stream_endpoint = btstack_memory_avdtp_stream_endpoint_get();
     if (!stream_endpoint){
@@ -324,6 +345,9 @@ avdtp_stream_endpoint_t * avdtp_create_stream_endpoint(avdtp_sep_type_t sep_type
     stream_endpoint->sep.seid = avdtp_get_next_local_seid(context);
     stream_endpoint->sep.media_type = media_type;
     stream_endpoint->sep.type = sep_type;
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+    stream_endpoint->media_latency_budget_ms = AVDTP_MEDIA_LATENCY_BUDGET_MS;
+#endif
     btstack_linked_list_add(&context->stream_endpoints, (btstack_linked_item_t *) stream_endpoint);
     return stream_endpoint;
 }
@@ -499,6 +523,7 @@ void avdtp_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet
     // log_info("avdtp_packet_handler packet type %02x, event %02x ", packet_type, hci_event_packet_get_type(packet));
     switch (packet_type) {
         case L2CAP_DATA_PACKET:
+            BTSTACK_TRACE(BTSTACK_TRACE_POINT_AVDTP_RX, channel, size);
             connection = avdtp_connection_for_l2cap_signaling_cid(channel, context);
             if (connection){
                 handle_l2cap_data_packet_for_signaling_connection(connection, packet, size, context);
@@ -671,6 +696,12 @@ void avdtp_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet
                         stream_endpoint->connection = connection;
                         stream_endpoint->l2cap_media_cid = l2cap_event_channel_opened_get_local_cid(packet);
                         stream_endpoint->media_con_handle = l2cap_event_channel_opened_get_handle(packet);
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+                        avdtp_stream_endpoint_setup_media_qos(stream_endpoint);
+#endif
+#ifdef ENABLE_HCI_QOS_ARBITER
+                        l2cap_set_traffic_class(stream_endpoint->l2cap_media_cid, HCI_TRAFFIC_CLASS_MEDIA);
+#endif
 
                         log_info("AVDTP_STREAM_ENDPOINT_OPENED, avdtp cid 0x%02x, l2cap_media_cid 0x%02x, local seid %d, remote seid %d", connection->avdtp_cid, stream_endpoint->l2cap_media_cid, avdtp_local_seid(stream_endpoint), avdtp_remote_seid(stream_endpoint));
                         avdtp_streaming_emit_connection_established(context->avdtp_callback, connection->avdtp_cid, event_addr, avdtp_local_seid(stream_endpoint), avdtp_remote_seid(stream_endpoint), 0);
@@ -690,6 +721,10 @@ void avdtp_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet
                             if (connection) {
                                 avdtp_streaming_emit_connection_released(context->avdtp_callback, connection->avdtp_cid, avdtp_local_seid(stream_endpoint));
                             }
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+                            // restore default if ACL stays up
+                            (void) gap_set_automatic_flush_timeout(stream_endpoint->media_con_handle, 0);
+#endif
                             avdtp_reset_stream_endpoint(stream_endpoint);
                             if (connection && connection->disconnect){
                                 avdtp_request_can_send_now_self(connection, connection->l2cap_signaling_cid);
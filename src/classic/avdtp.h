@@ -62,6 +62,24 @@ extern "C" {
 #define AVDTP_MAX_CSRC_NUM 15
 #define AVDTP_MAX_CONTENT_PROTECTION_TYPE_VALUE_LEN 10
 
+// RTP header of media packet
+#define AVDTP_MEDIA_PAYLOAD_HEADER_SIZE 12
+
+// max number of sinks per broadcast group
+#ifndef AVDTP_SOURCE_BROADCAST_GROUP_MAX_SINKS
+#define AVDTP_SOURCE_BROADCAST_GROUP_MAX_SINKS 4
+#endif
+
+// number of media payloads queued per broadcast group
+#ifndef AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS
+#define AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS 3
+#endif
+
+// default latency budget for media packets with ENABLE_CLASSIC_MEDIA_QOS, used as Automatic Flush Timeout
+#ifndef AVDTP_MEDIA_LATENCY_BUDGET_MS
+#define AVDTP_MEDIA_LATENCY_BUDGET_MS 100
+#endif
+
 // Supported Features
 #define AVDTP_SOURCE_SF_Player      0x0001
 #define AVDTP_SOURCE_SF_Microphone  0x0002
@@ -498,8 +516,48 @@ typedef struct avdtp_stream_endpoint {
     uint8_t abort_stream;
     uint8_t suspend_stream;
     uint16_t sequence_number;
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+    // media packets older than this are flushed by Controller, 0 = no flush
+    uint16_t media_latency_budget_ms;
+#endif
 } avdtp_stream_endpoint_t;
 
+// media payload shared by all sinks of a broadcast group
+typedef struct {
+    uint8_t * data;
+    uint16_t  len;
+    uint8_t   num_frames;
+    uint8_t   marker;
+    // number of sinks that did not send this payload yet
+    uint8_t   ref_count;
+    uint32_t  timestamp_ms;
+} avdtp_source_broadcast_payload_t;
+
+typedef struct {
+    uint16_t avdtp_cid;
+    uint8_t  local_seid;
+    // oldest payload not sent to this sink yet
+    uint8_t  payload_index;
+    uint8_t  num_payloads_pending;
+    // playout delay reported by sink
+    uint16_t delay_100us;
+    // RTP header and SBC media payload header, needs to stay valid until next can send now
+    uint8_t  media_header[AVDTP_MEDIA_PAYLOAD_HEADER_SIZE + 1];
+} avdtp_source_broadcast_sink_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    avdtp_source_broadcast_payload_t payloads[AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS];
+    uint16_t payload_size;
+    uint8_t  payload_write_index;
+    avdtp_source_broadcast_sink_t sinks[AVDTP_SOURCE_BROADCAST_GROUP_MAX_SINKS];
+    uint8_t  num_sinks;
+    // sinks with shorter playout delay are held back to align playout with the slowest one
+    btstack_timer_source_t release_timer;
+    bool     release_timer_active;
+    uint32_t release_timer_deadline_ms;
+} avdtp_source_broadcast_group_t;
+
 typedef struct {
 // to app
     bd_addr_t remote_addr;
@@ -548,6 +606,9 @@ typedef struct {
 void avdtp_register_media_transport_category(avdtp_stream_endpoint_t * stream_endpoint);
 void avdtp_register_reporting_category(avdtp_stream_endpoint_t * stream_endpoint);
 void avdtp_register_delay_reporting_category(avdtp_stream_endpoint_t * stream_endpoint);
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+void avdtp_set_media_latency_budget(avdtp_stream_endpoint_t * stream_endpoint, uint16_t latency_budget_ms);
+#endif
 void avdtp_register_recovery_category(avdtp_stream_endpoint_t * stream_endpoint, uint8_t maximum_recovery_window_size, uint8_t maximum_number_media_packets);
 void avdtp_register_content_protection_category(avdtp_stream_endpoint_t * stream_endpoint, uint16_t cp_type, const uint8_t * cp_type_value, uint8_t cp_type_value_len);
 void avdtp_register_header_compression_category(avdtp_stream_endpoint_t * stream_endpoint, uint8_t back_ch, uint8_t media, uint8_t recovery);
@@ -46,6 +46,7 @@
 #include "bluetooth_sdp.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
+#include "btstack_trace.h"
 #include "l2cap.h"
 
 #include "classic/avdtp.h"
@@ -53,7 +54,6 @@
 #include "classic/avdtp_source.h"
 
 static avdtp_context_t * avdtp_source_context;
-#define AVDTP_MEDIA_PAYLOAD_HEADER_SIZE 12
 
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 
@@ -72,6 +72,13 @@ void avdtp_source_register_delay_reporting_category(uint8_t seid){
     avdtp_register_delay_reporting_category(stream_endpoint);
 }
 
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+void avdtp_source_set_media_latency_budget(uint8_t seid, uint16_t latency_budget_ms){
+    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(seid, avdtp_source_context);
+    avdtp_set_media_latency_budget(stream_endpoint, latency_budget_ms);
+}
+#endif
+
 void avdtp_source_register_recovery_category(uint8_t seid, uint8_t maximum_recovery_window_size, uint8_t maximum_number_media_packets){
     avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(seid, avdtp_source_context);
     avdtp_register_recovery_category(stream_endpoint, maximum_recovery_window_size, maximum_number_media_packets);
@@ -223,16 +230,23 @@ static void avdtp_source_copy_media_payload(uint8_t * media_packet, int size, in
     *offset = pos;
 }
 
-int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
-    if (avdtp_source_context->avdtp_cid != avdtp_cid){
-        log_error("avdtp source: avdtp cid 0x%02x not known, expected 0x%02x", avdtp_cid, avdtp_source_context->avdtp_cid);
-        return 0;
-    }
+// stream endpoints of each connection can be streaming at the same time
+static avdtp_stream_endpoint_t * avdtp_source_stream_endpoint_for_cid_and_seid(uint16_t avdtp_cid, uint8_t local_seid){
     avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, avdtp_source_context);
     if (!stream_endpoint) {
         log_error("avdtp source: no stream_endpoint with seid %d", local_seid);
-        return 0;
+        return NULL;
     }
+    if ((avdtp_source_context->avdtp_cid != avdtp_cid) && ((stream_endpoint->connection == NULL) || (stream_endpoint->connection->avdtp_cid != avdtp_cid))){
+        log_error("avdtp source: avdtp cid 0x%02x not known for seid %d", avdtp_cid, local_seid);
+        return NULL;
+    }
+    return stream_endpoint;
+}
+
+int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
+    avdtp_stream_endpoint_t * stream_endpoint = avdtp_source_stream_endpoint_for_cid_and_seid(avdtp_cid, local_seid);
+    if (!stream_endpoint) return 0;
     
     if (stream_endpoint->l2cap_media_cid == 0){
         log_error("avdtp source: no media connection for seid %d", local_seid);
@@ -248,34 +262,214 @@ int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_sei
     avdtp_source_setup_media_header(media_packet, size, &offset, marker, stream_endpoint->sequence_number);
     avdtp_source_copy_media_payload(media_packet, size, &offset, storage, num_bytes_to_copy, num_frames);
     stream_endpoint->sequence_number++;
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_AVDTP_TX, stream_endpoint->l2cap_media_cid, offset);
     l2cap_send_prepared(stream_endpoint->l2cap_media_cid, offset);
     return size;
 }
 
-void avdtp_source_stream_endpoint_request_can_send_now(uint16_t avdtp_cid, uint8_t local_seid){
-    if (avdtp_source_context->avdtp_cid != avdtp_cid){
-        log_error("AVDTP source: avdtp cid 0x%02x not known, expected 0x%02x", avdtp_cid, avdtp_source_context->avdtp_cid);
-        return;
+void avdtp_source_broadcast_group_init(avdtp_source_broadcast_group_t * group, uint8_t * storage, uint16_t storage_size){
+    memset(group, 0, sizeof(avdtp_source_broadcast_group_t));
+    group->payload_size = storage_size / AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS;
+    int i;
+    for (i=0;i<AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS;i++){
+        group->payloads[i].data = &storage[i * group->payload_size];
+    }
+}
+
+static avdtp_source_broadcast_sink_t * avdtp_source_broadcast_group_get_sink(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid){
+    int i;
+    for (i=0;i<group->num_sinks;i++){
+        avdtp_source_broadcast_sink_t * sink = &group->sinks[i];
+        if ((sink->avdtp_cid == avdtp_cid) && (sink->local_seid == local_seid)) return sink;
+    }
+    return NULL;
+}
+
+static void avdtp_source_broadcast_group_release_payload(avdtp_source_broadcast_group_t * group, avdtp_source_broadcast_sink_t * sink){
+    group->payloads[sink->payload_index].ref_count--;
+    sink->payload_index = (sink->payload_index + 1) % AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS;
+    sink->num_payloads_pending--;
+}
+
+uint8_t avdtp_source_broadcast_group_add_sink(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid){
+    if (avdtp_source_broadcast_group_get_sink(group, avdtp_cid, local_seid)) return ERROR_CODE_SUCCESS;
+    if (group->num_sinks == AVDTP_SOURCE_BROADCAST_GROUP_MAX_SINKS) return BTSTACK_MEMORY_ALLOC_FAILED;
+    avdtp_source_broadcast_sink_t * sink = &group->sinks[group->num_sinks++];
+    memset(sink, 0, sizeof(avdtp_source_broadcast_sink_t));
+    sink->avdtp_cid  = avdtp_cid;
+    sink->local_seid = local_seid;
+    // new sink starts with next payload
+    sink->payload_index = group->payload_write_index;
+    return ERROR_CODE_SUCCESS;
+}
+
+static uint32_t avdtp_source_broadcast_group_hold_back_ms(avdtp_source_broadcast_group_t * group, avdtp_source_broadcast_sink_t * sink){
+    uint16_t max_delay_100us = 0;
+    int i;
+    for (i=0;i<group->num_sinks;i++){
+        if (group->sinks[i].delay_100us > max_delay_100us){
+            max_delay_100us = group->sinks[i].delay_100us;
+        }
+    }
+    return (max_delay_100us - sink->delay_100us) / 10;
+}
+
+static void avdtp_source_broadcast_group_release_timer_handler(btstack_timer_source_t * ts){
+    avdtp_source_broadcast_group_t * group = (avdtp_source_broadcast_group_t *) btstack_run_loop_get_timer_context(ts);
+    group->release_timer_active = false;
+    // held back sinks check their next payload again on can send now
+    int i;
+    for (i=0;i<group->num_sinks;i++){
+        avdtp_source_broadcast_sink_t * sink = &group->sinks[i];
+        if (sink->num_payloads_pending == 0) continue;
+        if (avdtp_source_broadcast_group_hold_back_ms(group, sink) == 0) continue;
+        avdtp_source_stream_endpoint_request_can_send_now(sink->avdtp_cid, sink->local_seid);
+    }
+}
+
+static void avdtp_source_broadcast_group_release_timer_start(avdtp_source_broadcast_group_t * group, uint32_t deadline_ms){
+    if (group->release_timer_active){
+        if ((int32_t)(deadline_ms - group->release_timer_deadline_ms) >= 0) return;
+        btstack_run_loop_remove_timer(&group->release_timer);
+    }
+    uint32_t now = btstack_run_loop_get_time_ms();
+    uint32_t timeout_ms = ((int32_t)(deadline_ms - now) > 0) ? (deadline_ms - now) : 0;
+    group->release_timer_active = true;
+    group->release_timer_deadline_ms = deadline_ms;
+    btstack_run_loop_set_timer_handler(&group->release_timer, &avdtp_source_broadcast_group_release_timer_handler);
+    btstack_run_loop_set_timer_context(&group->release_timer, group);
+    btstack_run_loop_set_timer(&group->release_timer, timeout_ms);
+    btstack_run_loop_add_timer(&group->release_timer);
+}
+
+uint8_t avdtp_source_broadcast_group_set_sink_delay(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid, uint16_t delay_100us){
+    avdtp_source_broadcast_sink_t * sink = avdtp_source_broadcast_group_get_sink(group, avdtp_cid, local_seid);
+    if (!sink) return AVDTP_STREAM_ENDPOINT_DOES_NOT_EXIST;
+    sink->delay_100us = delay_100us;
+    log_info("avdtp source broadcast: avdtp cid 0x%02x, local seid %d, delay %u.%u ms", avdtp_cid, local_seid, delay_100us / 10, delay_100us % 10);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_broadcast_group_remove_sink(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid){
+    avdtp_source_broadcast_sink_t * sink = avdtp_source_broadcast_group_get_sink(group, avdtp_cid, local_seid);
+    if (!sink) return AVDTP_STREAM_ENDPOINT_DOES_NOT_EXIST;
+    while (sink->num_payloads_pending){
+        avdtp_source_broadcast_group_release_payload(group, sink);
     }
+    group->num_sinks--;
+    *sink = group->sinks[group->num_sinks];
+    if ((group->num_sinks == 0) && group->release_timer_active){
+        group->release_timer_active = false;
+        btstack_run_loop_remove_timer(&group->release_timer);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+int avdtp_source_broadcast_group_payload_available(avdtp_source_broadcast_group_t * group){
+    return group->payloads[group->payload_write_index].ref_count == 0;
+}
+
+uint8_t avdtp_source_broadcast_group_add_payload(avdtp_source_broadcast_group_t * group, const uint8_t * data, uint16_t len, uint8_t num_frames, uint8_t marker){
+    if (len > group->payload_size) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    int i;
+    // drop oldest payload for sinks that fell behind, as its buffer gets re-used
+    if (group->payloads[group->payload_write_index].ref_count){
+        for (i=0;i<group->num_sinks;i++){
+            avdtp_source_broadcast_sink_t * sink = &group->sinks[i];
+            if (sink->num_payloads_pending == AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS){
+                log_info("avdtp source broadcast: drop payload for avdtp cid 0x%02x, local seid %d", sink->avdtp_cid, sink->local_seid);
+                avdtp_source_broadcast_group_release_payload(group, sink);
+            }
+        }
+    }
+
+    avdtp_source_broadcast_payload_t * payload = &group->payloads[group->payload_write_index];
+    (void)memcpy(payload->data, data, len);
+    payload->len = len;
+    payload->num_frames = num_frames;
+    payload->marker = marker;
+    payload->ref_count = group->num_sinks;
+    payload->timestamp_ms = btstack_run_loop_get_time_ms();
+    group->payload_write_index = (group->payload_write_index + 1) % AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS;
+
+    for (i=0;i<group->num_sinks;i++){
+        avdtp_source_broadcast_sink_t * sink = &group->sinks[i];
+        sink->num_payloads_pending++;
+        if (sink->num_payloads_pending == 1){
+            avdtp_source_stream_endpoint_request_can_send_now(sink->avdtp_cid, sink->local_seid);
+        }
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_broadcast_group_send(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid){
+    avdtp_source_broadcast_sink_t * sink = avdtp_source_broadcast_group_get_sink(group, avdtp_cid, local_seid);
+    if (!sink) return AVDTP_STREAM_ENDPOINT_DOES_NOT_EXIST;
+    if (sink->num_payloads_pending == 0) return ERROR_CODE_SUCCESS;
+
     avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, avdtp_source_context);
-    if (!stream_endpoint) {
-        log_error("AVDTP source: no stream_endpoint with seid %d", local_seid);
-        return;
+    if (!stream_endpoint || !stream_endpoint->connection || (stream_endpoint->connection->avdtp_cid != avdtp_cid)) {
+        log_error("avdtp source broadcast: no stream_endpoint with seid %d for avdtp cid 0x%02x", local_seid, avdtp_cid);
+        return AVDTP_STREAM_ENDPOINT_DOES_NOT_EXIST;
     }
+    if (stream_endpoint->l2cap_media_cid == 0){
+        log_error("avdtp source broadcast: no media connection for seid %d", local_seid);
+        return AVDTP_MEDIA_CONNECTION_DOES_NOT_EXIST;
+    }
+
+    avdtp_source_broadcast_payload_t * payload = &group->payloads[sink->payload_index];
+
+    // hold back payload until sinks with longer playout delay would play it, too
+    uint32_t hold_back_ms = avdtp_source_broadcast_group_hold_back_ms(group, sink);
+    if (hold_back_ms > 0){
+        uint32_t release_ms = payload->timestamp_ms + hold_back_ms;
+        if ((int32_t)(release_ms - btstack_run_loop_get_time_ms()) > 0){
+            avdtp_source_broadcast_group_release_timer_start(group, release_ms);
+            return ERROR_CODE_SUCCESS;
+        }
+    }
+
+    // per-sink RTP header with own sequence number, payload is shared
+    int offset = 0;
+    avdtp_source_setup_media_header(sink->media_header, sizeof(sink->media_header), &offset, payload->marker, stream_endpoint->sequence_number);
+    sink->media_header[offset++] = payload->num_frames;
+
+    btstack_iovec_t iov[2];
+    iov[0].base = sink->media_header;
+    iov[0].len  = offset;
+    iov[1].base = payload->data;
+    iov[1].len  = payload->len;
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_AVDTP_TX, stream_endpoint->l2cap_media_cid, offset + payload->len);
+    int status = l2cap_send_iov(stream_endpoint->l2cap_media_cid, iov, 2);
+    if (status == BTSTACK_ACL_BUFFERS_FULL){
+        // retry on next can send now
+        avdtp_source_stream_endpoint_request_can_send_now(avdtp_cid, local_seid);
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+    if (status == ERROR_CODE_SUCCESS){
+        stream_endpoint->sequence_number++;
+    } else {
+        log_error("avdtp source broadcast: sending payload failed with status %d, drop it", status);
+    }
+    avdtp_source_broadcast_group_release_payload(group, sink);
+
+    if (sink->num_payloads_pending){
+        avdtp_source_stream_endpoint_request_can_send_now(avdtp_cid, local_seid);
+    }
+    return (status == ERROR_CODE_SUCCESS) ? ERROR_CODE_SUCCESS : ERROR_CODE_UNSPECIFIED_ERROR;
+}
+
+void avdtp_source_stream_endpoint_request_can_send_now(uint16_t avdtp_cid, uint8_t local_seid){
+    avdtp_stream_endpoint_t * stream_endpoint = avdtp_source_stream_endpoint_for_cid_and_seid(avdtp_cid, local_seid);
+    if (!stream_endpoint) return;
     stream_endpoint->send_stream = 1;
     avdtp_request_can_send_now_initiator(stream_endpoint->connection, stream_endpoint->l2cap_media_cid);
 }
 
 int avdtp_max_media_payload_size(uint16_t avdtp_cid, uint8_t local_seid){
-    if (avdtp_source_context->avdtp_cid != avdtp_cid){
-        log_error("A2DP source: a2dp cid 0x%02x not known, expected 0x%02x", avdtp_cid, avdtp_source_context->avdtp_cid);
-        return 0;
-    }
-    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, avdtp_source_context);
-    if (!stream_endpoint) {
-        log_error("A2DP source: no stream_endpoint with seid %d", local_seid);
-        return 0;
-    }
+    avdtp_stream_endpoint_t * stream_endpoint = avdtp_source_stream_endpoint_for_cid_and_seid(avdtp_cid, local_seid);
+    if (!stream_endpoint) return 0;
     
     if (stream_endpoint->l2cap_media_cid == 0){
         log_error("A2DP source: no media connection for seid %d", local_seid);
@@ -73,6 +73,14 @@ void avdtp_source_register_reporting_category(uint8_t seid);
  */
 void avdtp_source_register_delay_reporting_category(uint8_t seid);
 
+/**
+ * @brief Set latency budget for media packets. Media packets are sent as flushable and the Automatic Flush Timeout
+ * of the ACL connection is set to the latency budget when the media channel is open. Requires ENABLE_CLASSIC_MEDIA_QOS
+ * @param seid
+ * @param latency_budget_ms  default AVDTP_MEDIA_LATENCY_BUDGET_MS, max 1279 ms, 0 = packets are not flushed
+ */
+void avdtp_source_set_media_latency_budget(uint8_t seid, uint16_t latency_budget_ms);
+
 /**
  * @brief Register recovery category with local stream endpoint identified by seid
  * @param seid
@@ -243,6 +251,72 @@ avdtp_stream_endpoint_t * avdtp_source_create_stream_endpoint(avdtp_sep_type_t s
  */
 int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker);
 
+/**
+ * @brief Init broadcast group that sends the same media payload to several sinks
+ * @note  Each sink is a local stream endpoint with own RTP sequence number, pacing and credits
+ * @param group
+ * @param storage for AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS payloads shared by all sinks
+ * @param storage_size
+ */
+void avdtp_source_broadcast_group_init(avdtp_source_broadcast_group_t * group, uint8_t * storage, uint16_t storage_size);
+
+/**
+ * @brief Add sink to broadcast group. It receives payloads added afterwards
+ * @param group
+ * @param avdtp_cid
+ * @param local_seid
+ * @return status ERROR_CODE_SUCCESS or BTSTACK_MEMORY_ALLOC_FAILED if AVDTP_SOURCE_BROADCAST_GROUP_MAX_SINKS exceeded
+ */
+uint8_t avdtp_source_broadcast_group_add_sink(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid);
+
+/**
+ * @brief Remove sink from broadcast group, e.g. on stream released
+ * @param group
+ * @param avdtp_cid
+ * @param local_seid
+ * @return status
+ */
+uint8_t avdtp_source_broadcast_group_remove_sink(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid);
+
+/**
+ * @brief Set playout delay of sink, e.g. from AVDTP_SUBEVENT_SIGNALING_DELAY_REPORT
+ * @note  Payloads for sinks with shorter delay are sent later to align playout of all sinks.
+ *        AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS needs to cover the largest delay difference.
+ * @param group
+ * @param avdtp_cid
+ * @param local_seid
+ * @param delay_100us
+ * @return status
+ */
+uint8_t avdtp_source_broadcast_group_set_sink_delay(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid, uint16_t delay_100us);
+
+/**
+ * @brief Check if next payload can be added without dropping a payload for a sink that fell behind
+ * @param group
+ * @return true if all sinks have sent the oldest payload
+ */
+int avdtp_source_broadcast_group_payload_available(avdtp_source_broadcast_group_t * group);
+
+/**
+ * @brief Add media payload, e.g. SBC frames encoded once, for all sinks and request can send now for each sink
+ * @param group
+ * @param data
+ * @param len
+ * @param num_frames
+ * @param marker
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if len exceeds storage_size / AVDTP_SOURCE_BROADCAST_GROUP_NUM_PAYLOADS
+ */
+uint8_t avdtp_source_broadcast_group_add_payload(avdtp_source_broadcast_group_t * group, const uint8_t * data, uint16_t len, uint8_t num_frames, uint8_t marker);
+
+/**
+ * @brief Send next payload to sink on AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW for its local stream endpoint
+ * @param group
+ * @param avdtp_cid
+ * @param local_seid
+ * @return status
+ */
+uint8_t avdtp_source_broadcast_group_send(avdtp_source_broadcast_group_t * group, uint16_t avdtp_cid, uint8_t local_seid);
+
 /**
  * @brief Request to send a media packet. Packet can be then sent on reception of AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW event.
  * @param avdtp_cid         AVDTP channel identifyer.
@@ -543,6 +543,13 @@ static void avrcp_browsing_controller_emit_failed(btstack_packet_handler_t callb
     avrcp_browsing_controller_emit_done_with_uid_counter(callback, browsing_cid, 0, browsing_status, bluetooth_status);
 }
 
+// send Get Folder Items request queued while the previous response was received
+static void avrcp_browsing_controller_send_queued_request(avrcp_browsing_connection_t * connection){
+    if (connection->get_folder_items){
+        l2cap_request_can_send_now_event(connection->l2cap_browsing_cid);
+    }
+}
+
 
 static void avrcp_browsing_controller_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     avrcp_browsing_connection_t * browsing_connection;
@@ -572,6 +579,7 @@ static void avrcp_browsing_controller_packet_handler(uint8_t packet_type, uint16
                     if ((pos + 4) > size){
                         browsing_connection->state = AVCTP_CONNECTION_OPENED;
                         avrcp_browsing_controller_emit_failed(avrcp_controller_context.browsing_avrcp_callback, channel, AVRCP_BROWSING_ERROR_CODE_INVALID_COMMAND, ERROR_CODE_SUCCESS);
+                        avrcp_browsing_controller_send_queued_request(browsing_connection);
                         return;  
                     }
                     browsing_connection->pdu_id = packet[pos++];
@@ -581,6 +589,7 @@ static void avrcp_browsing_controller_packet_handler(uint8_t packet_type, uint16
                     if (browsing_connection->browsing_status != AVRCP_BROWSING_ERROR_CODE_SUCCESS){
                         browsing_connection->state = AVCTP_CONNECTION_OPENED;
                         avrcp_browsing_controller_emit_failed(avrcp_controller_context.browsing_avrcp_callback, channel, browsing_connection->browsing_status, ERROR_CODE_SUCCESS);
+                        avrcp_browsing_controller_send_queued_request(browsing_connection);
                         return;        
                     }
                     break;
@@ -668,6 +677,7 @@ static void avrcp_browsing_controller_packet_handler(uint8_t packet_type, uint16
                     // printf("reset browsing connection state to OPENED\n");
                     browsing_connection->state = AVCTP_CONNECTION_OPENED;
                     avrcp_browsing_controller_emit_done_with_uid_counter(avrcp_controller_context.browsing_avrcp_callback, channel, browsing_connection->uid_counter, browsing_connection->browsing_status, ERROR_CODE_SUCCESS);
+                    avrcp_browsing_controller_send_queued_request(browsing_connection);
                     break;
                 default:
                     break;
@@ -800,9 +810,16 @@ static uint8_t avrcp_browsing_controller_get_folder_items(uint16_t avrcp_browsin
         return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
     }
     avrcp_browsing_connection_t * connection = avrcp_connection->browsing_connection;
-    if (connection->state != AVCTP_CONNECTION_OPENED) {
-        log_error("avrcp_browsing_controller_get_folder_items: connection in wrong state %d, expected %d.", connection->state, AVCTP_CONNECTION_OPENED);
-        return ERROR_CODE_COMMAND_DISALLOWED;
+    switch (connection->state){
+        case AVCTP_CONNECTION_OPENED:
+            break;
+        case AVCTP_W2_RECEIVE_RESPONSE:
+            // prefetch: queue a single request, it is sent when the current response is complete
+            if (connection->get_folder_items == 0) break;
+            /* fall through */
+        default:
+            log_error("avrcp_browsing_controller_get_folder_items: connection in wrong state %d, expected %d.", connection->state, AVCTP_CONNECTION_OPENED);
+            return ERROR_CODE_COMMAND_DISALLOWED;
     }
     
     connection->get_folder_items = 1;
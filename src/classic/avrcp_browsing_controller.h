@@ -147,6 +147,8 @@ uint8_t avrcp_browsing_controller_disconnect(uint16_t avrcp_browsing_cid);
 
 /**
  * @brief Retrieve a list of media players.
+ * @note The Get Folder Items functions below can be called once while a previous Get Folder Items response is still received,
+ *       e.g. to prefetch the next item range. The request is sent after AVRCP_SUBEVENT_BROWSING_DONE for the current response.
  * @param avrcp_browsing_cid
  * @param start_item
  * @param end_item
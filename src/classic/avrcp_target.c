@@ -120,14 +120,16 @@ static uint16_t avrcp_target_pack_single_element_attribute_number(uint8_t * pack
 }
 
 // returns number of bytes stored
-static uint16_t avrcp_target_pack_single_element_attribute_string_fragment(uint8_t * packet, uint16_t pos, avrcp_media_attribute_id_t attr_id, uint8_t * attr_value, uint16_t attr_value_to_copy, uint16_t attr_value_size, bool header){
-    if (attr_value_size == 0) return 0;
+static uint16_t avrcp_target_pack_single_element_attribute_string_fragment(uint8_t * packet, uint16_t pos, avrcp_media_attribute_id_t attr_id, const uint8_t * attr_value, uint16_t attr_value_to_copy, uint16_t attr_value_size, bool header){
     uint16_t bytes_stored = 0;
     if (header){
+        // empty or unset attributes are reported with zero length value
         bytes_stored += avrcp_target_pack_single_element_header(packet, pos, attr_id, attr_value_size);
     }
-    (void)memcpy(packet + pos + bytes_stored, attr_value, attr_value_to_copy);
-    bytes_stored += attr_value_to_copy;
+    if (attr_value_to_copy > 0){
+        (void)memcpy(packet + pos + bytes_stored, attr_value, attr_value_to_copy);
+        bytes_stored += attr_value_to_copy;
+    }
     return bytes_stored;
 }
 
@@ -248,8 +250,13 @@ static int avrcp_target_send_now_playing_info(uint16_t cid, avrcp_connection_t *
                     connection->attribute_value_offset = 0;
                     break;
                 default:{
+                    // attribute values are referenced and copied straight into the outgoing buffer
+                    if (connection->attribute_value_offset > connection->now_playing_info[attr_index].len){
+                        // value changed while fragmented response was sent
+                        connection->attribute_value_offset = connection->now_playing_info[attr_index].len;
+                    }
                     bool      header = connection->attribute_value_offset == 0;
-                    uint8_t * attr_value =     (uint8_t *) (connection->now_playing_info[attr_index].value + connection->attribute_value_offset);
+                    const uint8_t * attr_value = connection->now_playing_info[attr_index].value + connection->attribute_value_offset;
                     uint16_t  attr_value_len = connection->now_playing_info[attr_index].len - connection->attribute_value_offset;
 
                     num_bytes_to_write = attr_value_len + (header * AVRCP_ATTR_HEADER_LEN);
@@ -295,7 +302,7 @@ static int avrcp_target_send_now_playing_info(uint16_t cid, avrcp_connection_t *
     packet[pos_packet_type] = connection->packet_type;
     // store attr value length
     big_endian_store_16(packet, playing_info_buffer_len_position, pos - playing_info_buffer_len_position - 2);
-    return l2cap_send_prepared(cid, size); 
+    return l2cap_send_prepared(cid, pos); 
 }
 
 
@@ -926,6 +933,8 @@ static void avrcp_handle_l2cap_data_packet_for_signaling_connection(avrcp_connec
                 case AVRCP_PDU_ID_REQUEST_ABORT_CONTINUING_RESPONSE:
                     connection->cmd_operands[0] = pdu[4];
                     connection->abort_continue_response = 1;
+                    connection->next_attr_id = AVRCP_MEDIA_ATTR_NONE;
+                    connection->attribute_value_offset = 0;
                     avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
                     break;
                 case AVRCP_PDU_ID_REQUEST_CONTINUING_RESPONSE:
@@ -947,6 +956,7 @@ static void avrcp_handle_l2cap_data_packet_for_signaling_connection(avrcp_connec
                     uint8_t attribute_count = pdu[pos++];
                     // printf("AVRCP_PDU_ID_GET_ELEMENT_ATTRIBUTES attribute count %d\n", attribute_count);
                     connection->next_attr_id = AVRCP_MEDIA_ATTR_NONE;
+                    connection->attribute_value_offset = 0;
                     if (!attribute_count){
                         connection->now_playing_info_attr_bitmap = 0xFE;
                     } else {
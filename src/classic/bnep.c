@@ -432,29 +432,123 @@ void bnep_request_can_send_now_event(uint16_t bnep_cid)
 }
 
 
-static int bnep_filter_protocol(bnep_channel_t *channel, uint16_t network_protocol_type)
+/* Sort network protocol filter ranges by start and merge overlapping or adjacent ranges, returns new count */
+static uint16_t bnep_net_filter_compile(bnep_net_filter_t *filter, uint16_t count)
 {
-	int i;
-    
-    if (channel->net_filter_count == 0) {
-        /* No filter set */
-        return 1;
+    uint16_t i;
+    uint16_t merged;
+
+    /* Insertion sort, the list holds at most MAX_BNEP_NETFILTER entries */
+    for (i = 1; i < count; i++) {
+        bnep_net_filter_t entry = filter[i];
+        uint16_t j = i;
+        while ((j > 0) && (filter[j - 1].range_start > entry.range_start)) {
+            filter[j] = filter[j - 1];
+            j--;
+        }
+        filter[j] = entry;
     }
 
-    for (i = 0; i < channel->net_filter_count; i ++) {
-        if ((network_protocol_type >= channel->net_filter[i].range_start) &&
-            (network_protocol_type <= channel->net_filter[i].range_end)) {
+    if (count == 0) {
+        return 0;
+    }
+    merged = 0;
+    for (i = 1; i < count; i++) {
+        if ((filter[merged].range_end == 0xffff) || (filter[i].range_start <= (filter[merged].range_end + 1))) {
+            if (filter[i].range_end > filter[merged].range_end) {
+                filter[merged].range_end = filter[i].range_end;
+            }
+        } else {
+            merged++;
+            filter[merged] = filter[i];
+        }
+    }
+    return merged + 1;
+}
+
+/* Binary search in sorted, non-overlapping network protocol filter ranges */
+static int bnep_net_filter_match(const bnep_net_filter_t *filter, uint16_t count, uint16_t network_protocol_type)
+{
+    uint16_t low = 0;
+    uint16_t high = count;
+
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (network_protocol_type < filter[mid].range_start) {
+            high = mid;
+        } else if (network_protocol_type > filter[mid].range_end) {
+            low = mid + 1;
+        } else {
             return 1;
         }
     }
+    return 0;
+}
 
+/* Sort multicast address filter ranges by start and merge overlapping ranges, returns new count */
+static uint16_t bnep_multi_filter_compile(bnep_multi_filter_t *filter, uint16_t count)
+{
+    uint16_t i;
+    uint16_t merged;
+
+    for (i = 1; i < count; i++) {
+        bnep_multi_filter_t entry = filter[i];
+        uint16_t j = i;
+        while ((j > 0) && (memcmp(filter[j - 1].addr_start, entry.addr_start, ETHER_ADDR_LEN) > 0)) {
+            filter[j] = filter[j - 1];
+            j--;
+        }
+        filter[j] = entry;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+    merged = 0;
+    for (i = 1; i < count; i++) {
+        if (memcmp(filter[i].addr_start, filter[merged].addr_end, ETHER_ADDR_LEN) <= 0) {
+            if (memcmp(filter[i].addr_end, filter[merged].addr_end, ETHER_ADDR_LEN) > 0) {
+                memcpy(filter[merged].addr_end, filter[i].addr_end, ETHER_ADDR_LEN);
+            }
+        } else {
+            merged++;
+            filter[merged] = filter[i];
+        }
+    }
+    return merged + 1;
+}
+
+/* Binary search in sorted, non-overlapping multicast address filter ranges */
+static int bnep_multi_filter_match(const bnep_multi_filter_t *filter, uint16_t count, const uint8_t *addr)
+{
+    uint16_t low = 0;
+    uint16_t high = count;
+
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (memcmp(addr, filter[mid].addr_start, ETHER_ADDR_LEN) < 0) {
+            high = mid;
+        } else if (memcmp(addr, filter[mid].addr_end, ETHER_ADDR_LEN) > 0) {
+            low = mid + 1;
+        } else {
+            return 1;
+        }
+    }
     return 0;
 }
 
-static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
+static int bnep_filter_protocol(bnep_channel_t *channel, uint16_t network_protocol_type)
 {
-	int i;
+    if (channel->net_filter_count == 0) {
+        /* No filter set */
+        return 1;
+    }
+
+    return bnep_net_filter_match(channel->net_filter, channel->net_filter_count, network_protocol_type);
+}
 
+static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
+{
     /* Check if the multicast flag is set int the destination address */
 	if ((addr_dest[0] & 0x01) == 0x00) {
         /* Not a multicast frame, do not apply filtering and send it in any case */
@@ -466,11 +560,8 @@ static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
         return 1;
     }
 
-	for (i = 0; i < channel->multicast_filter_count; i ++) {
-		if ((memcmp(addr_dest, channel->multicast_filter[i].addr_start, sizeof(bd_addr_t)) >= 0) &&
-		    (memcmp(addr_dest, channel->multicast_filter[i].addr_end, sizeof(bd_addr_t)) <= 0)) {
-			return 1;
-        }
+	if (bnep_multi_filter_match(channel->multicast_filter, channel->multicast_filter_count, addr_dest)) {
+		return 1;
 	}
 
 	return 0;
@@ -478,14 +569,19 @@ static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
 
 
 /* Send BNEP ethernet packet */
-int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
+// BNEP header: packet type, destination address, source address, network protocol type
+#define BNEP_DATA_HEADER_MAX_LEN (1 + (2 * sizeof(bd_addr_t)) + sizeof(uint16_t))
+
+// size of Ethernet header and IEEE 802.1Q tag header
+#define BNEP_ETHERNET_HEADER_LEN      14
+#define BNEP_ETHERNET_VLAN_HEADER_LEN 18
+
+/* Create BNEP header for Ethernet frame, returns header len or 0 if frame is filtered out */
+static uint16_t bnep_create_data_header(bnep_channel_t *channel, const uint8_t *ethernet_header, uint16_t len, uint8_t *bnep_header, uint16_t *out_payload_len)
 {
-    bnep_channel_t *channel;
-    uint8_t        *bnep_out_buffer = NULL;
     uint16_t        pos = 0;
     uint16_t        pos_out = 0;
     uint16_t        payload_len;
-    int             err = 0;
     int             has_source;
     int             has_dest;
 
@@ -493,28 +589,17 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
     bd_addr_t       addr_source;
     uint16_t        network_protocol_type;
 
-    channel = bnep_channel_for_l2cap_cid(bnep_cid);
-    if (channel == NULL) {
-        log_error("bnep_send cid 0x%02x doesn't exist!", bnep_cid);
-        return 1;
-    }
-        
-    if (channel->state != BNEP_CHANNEL_STATE_CONNECTED) {
-        return BNEP_CHANNEL_NOT_CONNECTED;
-    }
-    
-    /* Check for free ACL buffers */
-    if (!l2cap_can_send_packet_now(channel->l2cap_cid)) {
-        return BTSTACK_ACL_BUFFERS_FULL;
+    if (len < BNEP_ETHERNET_HEADER_LEN) {
+        return 0;
     }
 
     /* Extract destination and source address from the ethernet packet */
     pos = 0;
-    bd_addr_copy(addr_dest, &packet[pos]);
+    bd_addr_copy(addr_dest, &ethernet_header[pos]);
     pos += sizeof(bd_addr_t);
-    bd_addr_copy(addr_source, &packet[pos]);
+    bd_addr_copy(addr_source, &ethernet_header[pos]);
     pos += sizeof(bd_addr_t);
-    network_protocol_type = big_endian_read_16(packet, pos);
+    network_protocol_type = big_endian_read_16(ethernet_header, pos);
     pos += sizeof(uint16_t);
 
     payload_len = len - pos;
@@ -525,7 +610,7 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
 			return 0;
         }
         /* The "real" network protocol type is 4 bytes ahead in a VLAN packet */
-		network_protocol_type = big_endian_read_16(packet, pos + 2);
+		network_protocol_type = big_endian_read_16(ethernet_header, pos + 2);
 	}
 
     /* Check network protocol and multicast filters before sending */
@@ -545,10 +630,6 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
         }
     }
 
-    /* Reserve l2cap packet buffer */    
-    l2cap_reserve_packet_buffer();
-    bnep_out_buffer = l2cap_get_outgoing_buffer();
-
     /* Check if source address is the same as our local address and if the 
        destination address is the same as the remote addr. Maybe we can use
        the compressed data format
@@ -556,47 +637,97 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
     has_source = (memcmp(addr_source, channel->local_addr, ETHER_ADDR_LEN) != 0);
     has_dest = (memcmp(addr_dest, channel->remote_addr, ETHER_ADDR_LEN) != 0);
 
-    /* Check for MTU limits */
-    if (payload_len > channel->max_frame_size) {
-        log_error("bnep_send: Max frame size (%d) exceeded: %d", channel->max_frame_size, payload_len);
-        return BNEP_DATA_LEN_EXCEEDS_MTU;
-    }
-    
     /* Fill in the package type depending on the given source and destination address */
     if (has_source && has_dest) {
-        bnep_out_buffer[pos_out++] = BNEP_PKT_TYPE_GENERAL_ETHERNET;
+        bnep_header[pos_out++] = BNEP_PKT_TYPE_GENERAL_ETHERNET;
     } else 
     if (has_source && !has_dest) {
-        bnep_out_buffer[pos_out++] = BNEP_PKT_TYPE_COMPRESSED_ETHERNET_SOURCE_ONLY;
+        bnep_header[pos_out++] = BNEP_PKT_TYPE_COMPRESSED_ETHERNET_SOURCE_ONLY;
     } else 
     if (!has_source && has_dest) {
-        bnep_out_buffer[pos_out++] = BNEP_PKT_TYPE_COMPRESSED_ETHERNET_DEST_ONLY;
+        bnep_header[pos_out++] = BNEP_PKT_TYPE_COMPRESSED_ETHERNET_DEST_ONLY;
     } else {
-        bnep_out_buffer[pos_out++] = BNEP_PKT_TYPE_COMPRESSED_ETHERNET;
+        bnep_header[pos_out++] = BNEP_PKT_TYPE_COMPRESSED_ETHERNET;
     }
 
     /* Add the destination address if needed */
     if (has_dest) {
-        bd_addr_copy(bnep_out_buffer + pos_out, addr_dest);
+        bd_addr_copy(bnep_header + pos_out, addr_dest);
         pos_out += sizeof(bd_addr_t);
     }
 
     /* Add the source address if needed */
     if (has_source) {
-        bd_addr_copy(bnep_out_buffer + pos_out, addr_source);
+        bd_addr_copy(bnep_header + pos_out, addr_source);
         pos_out += sizeof(bd_addr_t);
     }
 
     /* Add protocol type */
-    big_endian_store_16(bnep_out_buffer, pos_out, network_protocol_type);
+    big_endian_store_16(bnep_header, pos_out, network_protocol_type);
     pos_out += 2;
     
     /* TODO: Add extension headers, if we may support them at a later stage */
-    /* Add the payload and then send out the package */
-    (void)memcpy(bnep_out_buffer + pos_out, packet + pos, payload_len);
-    pos_out += payload_len;
+    *out_payload_len = payload_len;
+    return pos_out;
+}
+
+static bnep_channel_t * bnep_channel_for_send(uint16_t bnep_cid, int * out_err)
+{
+    bnep_channel_t *channel = bnep_channel_for_l2cap_cid(bnep_cid);
+    if (channel == NULL) {
+        log_error("bnep_send cid 0x%02x doesn't exist!", bnep_cid);
+        *out_err = 1;
+        return NULL;
+    }
+        
+    if (channel->state != BNEP_CHANNEL_STATE_CONNECTED) {
+        *out_err = BNEP_CHANNEL_NOT_CONNECTED;
+        return NULL;
+    }
+    
+    /* Check for free ACL buffers */
+    if (!l2cap_can_send_packet_now(channel->l2cap_cid)) {
+        *out_err = BTSTACK_ACL_BUFFERS_FULL;
+        return NULL;
+    }
+    return channel;
+}
+
+int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
+{
+    bnep_channel_t *channel;
+    uint8_t        *bnep_out_buffer = NULL;
+    uint8_t         bnep_header[BNEP_DATA_HEADER_MAX_LEN];
+    uint16_t        header_len;
+    uint16_t        payload_len = 0;
+    int             err = 0;
+
+    channel = bnep_channel_for_send(bnep_cid, &err);
+    if (channel == NULL) {
+        return err;
+    }
+
+    header_len = bnep_create_data_header(channel, packet, len, bnep_header, &payload_len);
+    if (header_len == 0) {
+        /* Omit this packet */
+        return 0;
+    }
+
+    /* Check for MTU limits */
+    if (payload_len > channel->max_frame_size) {
+        log_error("bnep_send: Max frame size (%d) exceeded: %d", channel->max_frame_size, payload_len);
+        return BNEP_DATA_LEN_EXCEEDS_MTU;
+    }
+
+    /* Reserve l2cap packet buffer */    
+    l2cap_reserve_packet_buffer();
+    bnep_out_buffer = l2cap_get_outgoing_buffer();
+
+    /* Add the header and the payload and then send out the package */
+    (void)memcpy(bnep_out_buffer, bnep_header, header_len);
+    (void)memcpy(bnep_out_buffer + header_len, packet + BNEP_ETHERNET_HEADER_LEN, payload_len);
 
-    err = l2cap_send_prepared(channel->l2cap_cid, pos_out);
+    err = l2cap_send_prepared(channel->l2cap_cid, header_len + payload_len);
     
     if (err) {
         log_error("bnep_send: error %d", err);
@@ -604,6 +735,77 @@ int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len)
     return err;        
 }
 
+int bnep_send_iov(uint16_t bnep_cid, const btstack_iovec_t *iov, uint16_t iov_count)
+{
+    bnep_channel_t  *channel;
+    uint8_t          ethernet_header[BNEP_ETHERNET_VLAN_HEADER_LEN];
+    btstack_iovec_t  l2cap_iov[HCI_TRANSPORT_IOV_MAX + 1];
+    uint16_t         l2cap_iov_count;
+    uint16_t         header_len;
+    uint16_t         payload_len = 0;
+    uint16_t         len = 0;
+    uint16_t         pos;
+    uint16_t         remaining;
+    uint16_t         i;
+    int              err = 0;
+
+    if (iov_count > HCI_TRANSPORT_IOV_MAX) {
+        return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+    }
+
+    channel = bnep_channel_for_send(bnep_cid, &err);
+    if (channel == NULL) {
+        return err;
+    }
+
+    /* Gather Ethernet header */
+    pos = 0;
+    for (i = 0; i < iov_count; i++) {
+        uint16_t bytes_to_copy = btstack_min(iov[i].len, sizeof(ethernet_header) - pos);
+        (void)memcpy(&ethernet_header[pos], iov[i].base, bytes_to_copy);
+        pos += bytes_to_copy;
+        len += iov[i].len;
+    }
+
+    header_len = bnep_create_data_header(channel, ethernet_header, len, channel->send_iov_header, &payload_len);
+    if (header_len == 0) {
+        /* Omit this packet */
+        return 0;
+    }
+
+    /* Check for MTU limits */
+    if (payload_len > channel->max_frame_size) {
+        log_error("bnep_send_iov: Max frame size (%d) exceeded: %d", channel->max_frame_size, payload_len);
+        return BNEP_DATA_LEN_EXCEEDS_MTU;
+    }
+
+    /* BNEP header followed by payload, Ethernet header is skipped */
+    l2cap_iov[0].base = channel->send_iov_header;
+    l2cap_iov[0].len  = header_len;
+    l2cap_iov_count = 1;
+    pos = BNEP_ETHERNET_HEADER_LEN;
+    remaining = payload_len;
+    for (i = 0; (i < iov_count) && (remaining > 0); i++) {
+        if (pos >= iov[i].len) {
+            pos -= iov[i].len;
+            continue;
+        }
+        uint16_t bytes_to_send = btstack_min(iov[i].len - pos, remaining);
+        l2cap_iov[l2cap_iov_count].base = &iov[i].base[pos];
+        l2cap_iov[l2cap_iov_count].len  = bytes_to_send;
+        l2cap_iov_count++;
+        remaining -= bytes_to_send;
+        pos = 0;
+    }
+
+    err = l2cap_send_iov(channel->l2cap_cid, l2cap_iov, l2cap_iov_count);
+
+    if (err) {
+        log_error("bnep_send_iov: error %d", err);
+    }
+    return err;
+}
+
 
 /* Set BNEP network protocol type filter */
 int bnep_set_net_type_filter(uint16_t bnep_cid, bnep_net_filter_t *filter, uint16_t len)
@@ -748,6 +950,10 @@ static bnep_channel_t * bnep_channel_create_for_addr(bd_addr_t addr)
 
     channel->net_filter_count = 0;
     channel->multicast_filter_count = 0;
+    channel->rx_net_filter_count = 0;
+    channel->rx_net_filter_pending_count = 0;
+    channel->rx_multicast_filter_count = 0;
+    channel->rx_multicast_filter_pending_count = 0;
     channel->retry_count = 0;
 
     /* Finally add it to the channel list */
@@ -981,6 +1187,7 @@ static int bnep_handle_filter_net_type_set(bnep_channel_t *channel, uint8_t *pac
                 channel->net_filter_count ++;
             }
         }
+        channel->net_filter_count = bnep_net_filter_compile(channel->net_filter, channel->net_filter_count);
     }
 
     /* Set flag to send out the set net filter response on next statemachine cycle */
@@ -1011,6 +1218,9 @@ static int bnep_handle_filter_net_type_response(bnep_channel_t *channel, uint8_t
 
     if (response_code == BNEP_RESP_FILTER_SUCCESS) {
         log_info("BNEP_FILTER_NET_TYPE_RESPONSE: Net filter set successfully for %s", bd_addr_to_str(channel->remote_addr));
+        /* Remote accepted our filter, drop received packets that do not match it */
+        channel->rx_net_filter_count = bnep_net_filter_compile(channel->rx_net_filter, channel->rx_net_filter_pending_count);
+        channel->rx_net_filter_pending_count = 0;
     } else {
         log_error("BNEP_FILTER_NET_TYPE_RESPONSE: Net filter setting for %s failed. Err: %d", bd_addr_to_str(channel->remote_addr), response_code);
     }
@@ -1068,6 +1278,7 @@ static int bnep_handle_multi_addr_set(bnep_channel_t *channel, uint8_t *packet,
                 channel->multicast_filter_count ++;
             }
         }
+        channel->multicast_filter_count = bnep_multi_filter_compile(channel->multicast_filter, channel->multicast_filter_count);
     }
     /* Set flag to send out the set multi addr response on next statemachine cycle */
     bnep_channel_state_add(channel, BNEP_CHANNEL_STATE_VAR_SND_FILTER_MULTI_ADDR_RESPONSE);
@@ -1097,6 +1308,9 @@ static int bnep_handle_multi_addr_response(bnep_channel_t *channel, uint8_t *pac
 
     if (response_code == BNEP_RESP_FILTER_SUCCESS) {
         log_info("BNEP_MULTI_ADDR_RESPONSE: Multicast address filter set successfully for %s", bd_addr_to_str(channel->remote_addr));
+        /* Remote accepted our filter, drop received packets that do not match it */
+        channel->rx_multicast_filter_count = bnep_multi_filter_compile(channel->rx_multicast_filter, channel->rx_multicast_filter_pending_count);
+        channel->rx_multicast_filter_pending_count = 0;
     } else {
         log_error("BNEP_MULTI_ADDR_RESPONSE: Multicast address filter setting for %s failed. Err: %d", bd_addr_to_str(channel->remote_addr), response_code);
     }
@@ -1107,6 +1321,23 @@ static int bnep_handle_multi_addr_response(bnep_channel_t *channel, uint8_t *pac
 static int bnep_handle_ethernet_packet(bnep_channel_t *channel, bd_addr_t addr_dest, bd_addr_t addr_source, uint16_t network_protocol_type, uint8_t *payload, uint16_t size)
 {
     uint16_t pos = 0;
+
+    /* Drop packets that do not pass the filters accepted by the remote early */
+    if (channel->rx_net_filter_count > 0) {
+        uint16_t filter_protocol_type = network_protocol_type;
+        if ((network_protocol_type == ETHERTYPE_VLAN) && (size >= 4)) {
+            /* The "real" network protocol type is 2 bytes ahead in a VLAN packet */
+            filter_protocol_type = big_endian_read_16(payload, 2);
+        }
+        if (!bnep_net_filter_match(channel->rx_net_filter, channel->rx_net_filter_count, filter_protocol_type)) {
+            return size;
+        }
+    }
+    if ((channel->rx_multicast_filter_count > 0) && ((addr_dest[0] & 0x01) != 0x00)) {
+        if (!bnep_multi_filter_match(channel->rx_multicast_filter, channel->rx_multicast_filter_count, addr_dest)) {
+            return size;
+        }
+    }
     
 #if defined(HCI_INCOMING_PRE_BUFFER_SIZE) && (HCI_INCOMING_PRE_BUFFER_SIZE >= 14 - 8) // 2 * sizeof(bd_addr_t) + sizeof(uint16_t) - L2CAP Header (4) - ACL Header (4)
     /* In-place modify the package and add the ethernet header in front of the payload.
@@ -1510,6 +1741,13 @@ static void bnep_channel_state_machine(bnep_channel_t* channel, bnep_channel_eve
         if (channel->state_var & BNEP_CHANNEL_STATE_VAR_SND_FILTER_NET_TYPE_SET) {
             bnep_channel_state_remove(channel, BNEP_CHANNEL_STATE_VAR_SND_FILTER_NET_TYPE_SET);
             if ((channel->net_filter_out_count > 0) && (channel->net_filter_out != NULL)) {
+                /* Accept all packets until the remote confirmed the new filter, keep a copy for receive filtering if it fits */
+                channel->rx_net_filter_count = 0;
+                channel->rx_net_filter_pending_count = 0;
+                if (channel->net_filter_out_count <= MAX_BNEP_NETFILTER) {
+                    memcpy(channel->rx_net_filter, channel->net_filter_out, channel->net_filter_out_count * sizeof(bnep_net_filter_t));
+                    channel->rx_net_filter_pending_count = channel->net_filter_out_count;
+                }
                 bnep_send_filter_net_type_set(channel, channel->net_filter_out, channel->net_filter_out_count);
                 channel->net_filter_out_count = 0;
                 channel->net_filter_out = NULL;
@@ -1524,6 +1762,13 @@ static void bnep_channel_state_machine(bnep_channel_t* channel, bnep_channel_eve
         if (channel->state_var & BNEP_CHANNEL_STATE_VAR_SND_FILTER_MULTI_ADDR_SET) {
             bnep_channel_state_remove(channel, BNEP_CHANNEL_STATE_VAR_SND_FILTER_MULTI_ADDR_SET);
             if ((channel->multicast_filter_out_count > 0) && (channel->multicast_filter_out != NULL)) {
+                /* Accept all packets until the remote confirmed the new filter, keep a copy for receive filtering if it fits */
+                channel->rx_multicast_filter_count = 0;
+                channel->rx_multicast_filter_pending_count = 0;
+                if (channel->multicast_filter_out_count <= MAX_BNEP_MULTICAST_FILTER) {
+                    memcpy(channel->rx_multicast_filter, channel->multicast_filter_out, channel->multicast_filter_out_count * sizeof(bnep_multi_filter_t));
+                    channel->rx_multicast_filter_pending_count = channel->multicast_filter_out_count;
+                }
                 bnep_send_filter_multi_addr_set(channel, channel->multicast_filter_out, channel->multicast_filter_out_count);
                 channel->multicast_filter_out_count = 0;
                 channel->multicast_filter_out = NULL;
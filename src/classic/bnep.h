@@ -47,6 +47,7 @@
 #include "btstack_util.h"
 #include "btstack_run_loop.h"
 #include "gap.h"
+#include "hci_transport.h"
  
 #include <stdint.h>
 
@@ -133,6 +134,14 @@ typedef struct {
     bnep_multi_filter_t *multicast_filter_out;                        // outgoing multicast address filter, must be statically allocated in the application
     uint16_t             multicast_filter_out_count;
 
+    bnep_net_filter_t    rx_net_filter[MAX_BNEP_NETFILTER];           // network protocol filter requested by us, applied once accepted by remote
+    uint16_t             rx_net_filter_count;
+    uint16_t             rx_net_filter_pending_count;
+
+    bnep_multi_filter_t  rx_multicast_filter[MAX_BNEP_MULTICAST_FILTER]; // multicast address filter requested by us, applied once accepted by remote
+    uint16_t             rx_multicast_filter_count;
+    uint16_t             rx_multicast_filter_pending_count;
+
 
     btstack_timer_source_t     timer;             // Timeout timer
     int                timer_active;      // Is a timer running?
@@ -142,6 +151,9 @@ typedef struct {
 
     uint8_t   waiting_for_can_send_now;
 
+    // BNEP header of packet sent with bnep_send_iov, needs to stay valid until next can send now
+    uint8_t   send_iov_header[15];
+
 } bnep_channel_t;
 
 /* Internal BNEP service descriptor */
@@ -179,9 +191,21 @@ void bnep_request_can_send_now_event(uint16_t bnep_cid);
 
 /**
  * @brief Send a data packet.
+ * @note The compressed BNEP header types are used automatically: the source address is omitted if it is the
+ *       local address and the destination address is omitted if it is the address of the remote device.
+ *       Each BNEP packet carries a single Ethernet frame.
  */
 int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len);
 
+/**
+ * @brief Send a data packet given by list of buffers without copying them into the outgoing buffer
+ * @note Buffers must stay valid until next BNEP_EVENT_CAN_SEND_NOW
+ * @param bnep_cid
+ * @param iov list of buffers, starting with Ethernet header
+ * @param iov_count max HCI_TRANSPORT_IOV_MAX
+ */
+int bnep_send_iov(uint16_t bnep_cid, const btstack_iovec_t *iov, uint16_t iov_count);
+
 /**
  * @brief Set the network protocol filter.
  */
@@ -66,6 +66,133 @@ float btstack_cvsd_plc_rcos(int index){
     if (index > CVSD_OLAL) return 0;
     return rcos[index];
 }
+static float btstack_cvsd_plc_absolute(float x){
+     if (x < 0) x = -x;
+     return x;
+}
+
+#ifdef ENABLE_PLC_FIXED_POINT
+
+#define PLC_MANTISSA_BITS 24
+
+/* Raised COSine table for OLA in Q15 */
+static const int16_t rcos_q15[CVSD_OLAL] = {
+    32489, 30314,
+    26258, 20868,
+    14872,  9081,
+     4276,  1106
+};
+
+static int64_t btstack_cvsd_plc_dot_product(const BTSTACK_CVSD_PLC_SAMPLE_FORMAT * x, const BTSTACK_CVSD_PLC_SAMPLE_FORMAT * y, int len){
+    int64_t sum = 0;
+    int i;
+    for (i=0;i<len;i++){
+        sum += (int32_t) x[i] * y[i];
+    }
+    return sum;
+}
+
+// reduce value to PLC_MANTISSA_BITS and add dropped bits to exponent
+static uint64_t btstack_cvsd_plc_normalize(uint64_t value, int * exponent){
+    while (value >= (1ULL << PLC_MANTISSA_BITS)){
+        value >>= 1;
+        (*exponent)++;
+    }
+    return value;
+}
+
+// approximate num^2 * energy as mantissa * 2^exponent with mantissa in [2^47, 2^48) or 0
+static uint64_t btstack_cvsd_plc_square_times_energy(int64_t num, int64_t energy, int * exponent){
+    uint64_t abs_num = (uint64_t) (num < 0 ? -num : num);
+    *exponent = 0;
+    uint64_t m = btstack_cvsd_plc_normalize(abs_num, exponent);
+    *exponent *= 2;
+    m = btstack_cvsd_plc_normalize(m * m, exponent);
+    m = m * btstack_cvsd_plc_normalize((uint64_t) energy, exponent);
+    if (m == 0) return 0;
+    while (m < (1ULL << (2 * PLC_MANTISSA_BITS - 1))){
+        m <<= 1;
+        (*exponent)--;
+    }
+    return m;
+}
+
+// compare num_a / sqrt(energy_a) with num_b / sqrt(energy_b) without division and square root
+static int btstack_cvsd_plc_compare_correlation(int64_t num_a, int64_t energy_a, int64_t num_b, int64_t energy_b){
+    if ((num_a >= 0) && (num_b < 0)) return 1;
+    if ((num_a < 0) && (num_b >= 0)) return -1;
+    int exponent_a;
+    int exponent_b;
+    uint64_t mantissa_a = btstack_cvsd_plc_square_times_energy(num_a, energy_b, &exponent_a);
+    uint64_t mantissa_b = btstack_cvsd_plc_square_times_energy(num_b, energy_a, &exponent_b);
+    int result;
+    if (mantissa_a == 0 || mantissa_b == 0){
+        result = (mantissa_a > mantissa_b) - (mantissa_a < mantissa_b);
+    } else if (exponent_a != exponent_b){
+        result = exponent_a > exponent_b ? 1 : -1;
+    } else {
+        result = (mantissa_a > mantissa_b) - (mantissa_a < mantissa_b);
+    }
+    // for negative correlation, larger magnitude is worse
+    return num_a < 0 ? -result : result;
+}
+
+// find best match for template at end of history. Template energy is constant and cancels out in the comparison,
+// window energy is updated incrementally, so only the cross term needs a dot product per lag
+int btstack_cvsd_plc_pattern_match(BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y){
+    const BTSTACK_CVSD_PLC_SAMPLE_FORMAT * x = &y[CVSD_LHIST-CVSD_M];
+    if (btstack_cvsd_plc_dot_product(x, x, CVSD_M) == 0) return 0;
+    int64_t energy = btstack_cvsd_plc_dot_product(y, y, CVSD_M);
+    int64_t best_num = 0;
+    int64_t best_energy = 0;
+    int     bestmatch = -1;
+    int     n;
+    for (n=0;n<CVSD_N;n++){
+        if (energy > 0){
+            int64_t num = btstack_cvsd_plc_dot_product(x, &y[n], CVSD_M);
+            if ((bestmatch < 0) || (btstack_cvsd_plc_compare_correlation(num, energy, best_num, best_energy) > 0)){
+                bestmatch   = n;
+                best_num    = num;
+                best_energy = energy;
+            }
+        }
+        energy += ((int32_t) y[n+CVSD_M] * y[n+CVSD_M]) - ((int32_t) y[n] * y[n]);
+    }
+    return bestmatch < 0 ? 0 : bestmatch;
+}
+
+// scale factor in Q15 to match amplitude of substitution packet to that of preceding packet
+static int32_t btstack_cvsd_plc_amplitude_match_q15(uint16_t num_samples, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y, BTSTACK_CVSD_PLC_SAMPLE_FORMAT bestmatch){
+    int      i;
+    uint32_t sumx = 0;
+    uint32_t sumy = 0;
+    int32_t  sf;
+
+    for (i=0;i<num_samples;i++){
+        sumx += (uint32_t) abs(y[CVSD_LHIST-num_samples+i]);
+        sumy += (uint32_t) abs(y[bestmatch+i]);
+    }
+    if (sumy == 0){
+        sf = (sumx > 0) ? 32768 : 0;
+    } else {
+        sf = (int32_t) (((uint64_t) sumx << 15) / sumy);
+    }
+    // This is not in the paper, but limit the scaling factor to something reasonable to avoid creating artifacts
+    if (sf < 24576) sf = 24576;
+    if (sf > 32768) sf = 32768;
+    return sf;
+}
+
+// Q30 overlap-add of left and right sample, each scaled by a Q15 factor, truncating like the float version
+static BTSTACK_CVSD_PLC_SAMPLE_FORMAT btstack_cvsd_plc_overlap_add_q15(BTSTACK_CVSD_PLC_SAMPLE_FORMAT left, int32_t sf_left, int16_t rcos_left, BTSTACK_CVSD_PLC_SAMPLE_FORMAT right, int32_t sf_right, int16_t rcos_right){
+    int64_t val = ((int64_t) left * sf_left * rcos_left) + ((int64_t) right * sf_right * rcos_right);
+    val /= (1 << 30);
+    if (val > 32767)  val = 32767;
+    if (val < -32768) val = -32768;
+    return (BTSTACK_CVSD_PLC_SAMPLE_FORMAT) val;
+}
+
+#else
 // taken from http://www.codeproject.com/Articles/69941/Best-Square-Root-Method-Algorithm-Function-Precisi
 // Algorithm: Babylonian Method + some manipulations on IEEE 32 bit floating point representation
 static float sqrt3(const float x){
@@ -85,11 +212,6 @@ static float sqrt3(const float x){
     return u.x;
 }
 
-static float btstack_cvsd_plc_absolute(float x){
-     if (x < 0) x = -x;
-     return x;
-}
-
 static float btstack_cvsd_plc_cross_correlation(BTSTACK_CVSD_PLC_SAMPLE_FORMAT *x, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y){
     float num = 0;
     float den = 0;
@@ -119,6 +241,7 @@ int btstack_cvsd_plc_pattern_match(BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y){
     }
     return bestmatch;
 }
+#endif
 
 float btstack_cvsd_plc_amplitude_match(btstack_cvsd_plc_state_t *plc_state, uint16_t num_samples, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *y, BTSTACK_CVSD_PLC_SAMPLE_FORMAT bestmatch){
     UNUSED(plc_state);
@@ -297,9 +420,13 @@ static void octave_fprintf_plot_output(btstack_cvsd_plc_state_t *plc_state, FILE
 #endif
 
 void btstack_cvsd_plc_bad_frame(btstack_cvsd_plc_state_t *plc_state, uint16_t num_samples, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *out){
-    float val;
     int   i = 0;
+#ifdef ENABLE_PLC_FIXED_POINT
+    int32_t sf = 32768;
+#else
+    float val;
     float sf = 1;
+#endif
     plc_state->nbf++;
     
     if (plc_state->max_consecutive_bad_frames_nr < plc_state->nbf){
@@ -323,6 +450,17 @@ void btstack_cvsd_plc_bad_frame(btstack_cvsd_plc_state_t *plc_state, uint16_t nu
         plc_state->bestlag += CVSD_M; 
         
         // Compute Scale Factor to Match Amplitude of Substitution Packet to that of Preceding Packet
+#ifdef ENABLE_PLC_FIXED_POINT
+        sf = btstack_cvsd_plc_amplitude_match_q15(num_samples, plc_state->hist, plc_state->bestlag);
+        for (i=0;i<num_samples;i++){
+            plc_state->hist[CVSD_LHIST+i] = (BTSTACK_CVSD_PLC_SAMPLE_FORMAT) ((sf * plc_state->hist[plc_state->bestlag+i]) / 32768);
+        }
+
+        for (;i<(num_samples+CVSD_OLAL);i++){
+            plc_state->hist[CVSD_LHIST+i] = btstack_cvsd_plc_overlap_add_q15(plc_state->hist[plc_state->bestlag+i], sf, rcos_q15[i-num_samples],
+                plc_state->hist[plc_state->bestlag+i], 32768, rcos_q15[CVSD_OLAL-1-i+num_samples]);
+        }
+#else
         sf = btstack_cvsd_plc_amplitude_match(plc_state, num_samples, plc_state->hist, plc_state->bestlag);
         for (i=0;i<CVSD_OLAL;i++){
             val = sf*plc_state->hist[plc_state->bestlag+i];
@@ -340,6 +478,7 @@ void btstack_cvsd_plc_bad_frame(btstack_cvsd_plc_state_t *plc_state, uint16_t nu
             val = (left*rcos[i-num_samples]) + (right*rcos[CVSD_OLAL-1-i+num_samples]);
             plc_state->hist[CVSD_LHIST+i] = btstack_cvsd_plc_crop_sample(val);
         }
+#endif
 
         for (;i<(num_samples+CVSD_RT+CVSD_OLAL);i++){
             plc_state->hist[CVSD_LHIST+i] = plc_state->hist[plc_state->bestlag+i];
@@ -368,7 +507,9 @@ void btstack_cvsd_plc_bad_frame(btstack_cvsd_plc_state_t *plc_state, uint16_t nu
 }
 
 void btstack_cvsd_plc_good_frame(btstack_cvsd_plc_state_t *plc_state, uint16_t num_samples, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *in, BTSTACK_CVSD_PLC_SAMPLE_FORMAT *out){
+#ifndef ENABLE_PLC_FIXED_POINT
     float val;
+#endif
     int i = 0;
 #ifdef OCTAVE_OUTPUT
     FILE * oct_file = NULL;
@@ -385,10 +526,14 @@ void btstack_cvsd_plc_good_frame(btstack_cvsd_plc_state_t *plc_state, uint16_t n
         }
             
         for (i=CVSD_RT;i<(CVSD_RT+CVSD_OLAL);i++){
+#ifdef ENABLE_PLC_FIXED_POINT
+            out[i] = btstack_cvsd_plc_overlap_add_q15(plc_state->hist[CVSD_LHIST+i], 32768, rcos_q15[i-CVSD_RT], in[i], 32768, rcos_q15[CVSD_OLAL+CVSD_RT-1-i]);
+#else
             float left  = plc_state->hist[CVSD_LHIST+i];
             float right = in[i];
             val = (left * rcos[i-CVSD_RT]) + (right *rcos[CVSD_OLAL+CVSD_RT-1-i]);
             out[i] = btstack_cvsd_plc_crop_sample((BTSTACK_CVSD_PLC_SAMPLE_FORMAT)val);
+#endif
         }
     }
 
@@ -79,7 +79,7 @@ typedef struct {
 
 /* BTstack SBC decoder */
 /**
- * @brief Init SBC decoder
+ * @brief Init SBC decoder. Each state gets its own decoder, up to SBC_DECODER_MAX_INSTANCES.
  * @param state
  * @param mode
  * @param callback for decoded PCM data in host endianess
@@ -88,6 +88,12 @@ typedef struct {
 
 void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_mode_t mode, void (*callback)(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context), void * context);
 
+/**
+ * @brief De-Init SBC decoder and release its decoder
+ * @param state
+ */
+void btstack_sbc_decoder_deinit(btstack_sbc_decoder_state_t * state);
+
 /**
  * @brief Process received SBC data
  * @param state
@@ -115,7 +121,8 @@ int btstack_sbc_decoder_sample_rate(btstack_sbc_decoder_state_t * state);
 
 /* BTstack SBC Encoder */
 /**
- * @brief Init SBC encoder
+ * @brief Init SBC encoder. Each state gets its own encoder, up to SBC_ENCODER_MAX_INSTANCES.
+ * @note  Encoders of different states can be used concurrently, init and deinit must not be called concurrently
  * @param state
  * @param mode 
  * @param blocks
@@ -129,7 +136,53 @@ void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t * state, btstack_sbc_m
                         int blocks, int subbands, int allocation_method, int sample_rate, int bitpool, int channel_mode);
 
 /**
- * @brief Encode PCM data
+ * @brief De-Init SBC encoder and release its encoder
+ * @param state
+ */
+void btstack_sbc_encoder_deinit(btstack_sbc_encoder_state_t * state);
+
+/**
+ * @brief Encode PCM data with encoder of given state
+ * @param state
+ * @param buffer with samples in host endianess
+ */
+void btstack_sbc_encoder_state_process_data(btstack_sbc_encoder_state_t * state, int16_t * input_buffer);
+
+/**
+ * @brief Return SBC frame of given state
+ * @param state
+ */
+uint8_t * btstack_sbc_encoder_state_sbc_buffer(btstack_sbc_encoder_state_t * state);
+
+/**
+ * @brief Return SBC frame length of given state
+ * @param state
+ */
+uint16_t  btstack_sbc_encoder_state_sbc_buffer_length(btstack_sbc_encoder_state_t * state);
+
+/**
+ * @brief Return number of audio frames required for one SBC packet of given state
+ * @param state
+ * @note  each audio frame contains 2 sample values in stereo modes
+ */
+int  btstack_sbc_encoder_state_num_audio_frames(btstack_sbc_encoder_state_t * state);
+
+/**
+ * @brief Set bitpool for next SBC frames of given state, e.g. to adapt bitrate to link quality
+ * @note  ignored for mSBC. Frame length changes with bitpool, see btstack_sbc_encoder_state_sbc_buffer_length
+ * @param state
+ * @param bitpool
+ */
+void btstack_sbc_encoder_state_set_bitpool(btstack_sbc_encoder_state_t * state, uint8_t bitpool);
+
+/**
+ * @brief Return bitpool used for SBC frames of given state
+ * @param state
+ */
+uint8_t btstack_sbc_encoder_state_get_bitpool(btstack_sbc_encoder_state_t * state);
+
+/**
+ * @brief Encode PCM data with encoder of last initialized state
  * @param buffer with samples in host endianess
  */
 void btstack_sbc_encoder_process_data(int16_t * input_buffer);
@@ -76,10 +76,33 @@ typedef struct {
     int       first_good_frame_found; 
     int       h2_sequence_nr;
     uint16_t  msbc_bad_bytes;
+    btstack_sbc_decoder_state_t * owner;
 } bludroid_decoder_state_t;
 
+// number of decoders that can be used at the same time
+#ifndef SBC_DECODER_MAX_INSTANCES
+#define SBC_DECODER_MAX_INSTANCES 1
+#endif
+
 static btstack_sbc_decoder_state_t * sbc_decoder_state_singleton = NULL;
-static bludroid_decoder_state_t bd_decoder_state;
+static bludroid_decoder_state_t bd_decoder_states[SBC_DECODER_MAX_INSTANCES];
+
+static bludroid_decoder_state_t * btstack_sbc_decoder_bluedroid_for_state(btstack_sbc_decoder_state_t * state){
+    int i;
+    for (i=0;i<SBC_DECODER_MAX_INSTANCES;i++){
+        if (bd_decoder_states[i].owner == state) return &bd_decoder_states[i];
+    }
+    return NULL;
+}
+
+static bludroid_decoder_state_t * btstack_sbc_decoder_bluedroid_allocate(btstack_sbc_decoder_state_t * state){
+    bludroid_decoder_state_t * decoder_state = btstack_sbc_decoder_bluedroid_for_state(state);
+    if (decoder_state) return decoder_state;
+    decoder_state = btstack_sbc_decoder_bluedroid_for_state(NULL);
+    if (decoder_state == NULL) return NULL;
+    decoder_state->owner = state;
+    return decoder_state;
+}
 
 // Testing only - START
 static int plc_enabled = 1;
@@ -159,17 +182,27 @@ void OI_AssertFail(const char* file, int line, const char* reason){
 #endif
 
 void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_mode_t mode, void (*callback)(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context), void * context){
-    if (sbc_decoder_state_singleton && (sbc_decoder_state_singleton != state) ){
-        log_error("SBC decoder: different sbc decoder state already registered");
-    } 
+    bludroid_decoder_state_t * bd_decoder_state = btstack_sbc_decoder_bluedroid_allocate(state);
+    if (!bd_decoder_state && sbc_decoder_state_singleton){
+        // all decoders in use, take over the one of the last initialized state as before
+        log_error("SBC decoder: all %u decoders in use, see SBC_DECODER_MAX_INSTANCES", SBC_DECODER_MAX_INSTANCES);
+        bd_decoder_state = btstack_sbc_decoder_bluedroid_for_state(sbc_decoder_state_singleton);
+        bd_decoder_state->owner = state;
+    }
+    if (!bd_decoder_state){
+        log_error("SBC decoder: no decoder available");
+        state->decoder_state = NULL;
+        return;
+    }
+
     OI_STATUS status = OI_STATUS_SUCCESS;
     switch (mode){
         case SBC_MODE_STANDARD:
             // note: we always request stereo output, even for mono input
-            status = OI_CODEC_SBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data), 2, 2, FALSE);
+            status = OI_CODEC_SBC_DecoderReset(&(bd_decoder_state->decoder_context), bd_decoder_state->decoder_data, sizeof(bd_decoder_state->decoder_data), 2, 2, FALSE);
             break;
         case SBC_MODE_mSBC:
-            status = OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data));
+            status = OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state->decoder_context), bd_decoder_state->decoder_data, sizeof(bd_decoder_state->decoder_data));
             break;
         default:
             break;
@@ -181,19 +214,31 @@ void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_m
     
     sbc_decoder_state_singleton = state;
     
-    bd_decoder_state.bytes_in_frame_buffer = 0;
-    bd_decoder_state.pcm_bytes = sizeof(bd_decoder_state.pcm_data);
-    bd_decoder_state.h2_sequence_nr = -1;
-    bd_decoder_state.first_good_frame_found = 0;
+    bd_decoder_state->bytes_in_frame_buffer = 0;
+    bd_decoder_state->pcm_bytes = sizeof(bd_decoder_state->pcm_data);
+    bd_decoder_state->h2_sequence_nr = -1;
+    bd_decoder_state->first_good_frame_found = 0;
 
     memset(state, 0, sizeof(btstack_sbc_decoder_state_t));
     state->handle_pcm_data = callback;
     state->mode = mode;
     state->context = context;
-    state->decoder_state = &bd_decoder_state;
+    state->decoder_state = bd_decoder_state;
     btstack_sbc_plc_init(&state->plc_state);
 }
 
+void btstack_sbc_decoder_deinit(btstack_sbc_decoder_state_t * state){
+    if (!state) return;
+    bludroid_decoder_state_t * bd_decoder_state = btstack_sbc_decoder_bluedroid_for_state(state);
+    if (bd_decoder_state){
+        bd_decoder_state->owner = NULL;
+    }
+    state->decoder_state = NULL;
+    if (sbc_decoder_state_singleton == state){
+        sbc_decoder_state_singleton = NULL;
+    }
+}
+
 static void append_received_sbc_data(bludroid_decoder_state_t * state, uint8_t * buffer, int size){
     int numFreeBytes = sizeof(state->frame_buffer) - state->bytes_in_frame_buffer;
 
@@ -299,7 +344,7 @@ static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * s
                 // The codec apparently does not recover from this.
                 // Re-initialize the codec.
                 log_info("SBC decode: invalid parameters: resetting codec");
-                if (OI_CODEC_SBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data), 2, 2, FALSE) != OI_STATUS_SUCCESS){
+                if (OI_CODEC_SBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data), 2, 2, FALSE) != OI_STATUS_SUCCESS){
                     log_info("SBC decode: resetting codec failed");
                     
                 }
@@ -505,7 +550,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                 // The codec apparently does not recover from this.
                 // Re-initialize the codec.
                 log_info("SBC decode: invalid parameters: resetting codec");
-                if (OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data)) != OI_STATUS_SUCCESS){
+                if (OI_CODEC_mSBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data)) != OI_STATUS_SUCCESS){
                     log_info("SBC decode: resetting codec failed");
                 }
                 break;
@@ -523,6 +568,10 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
 }
 
 void btstack_sbc_decoder_process_data(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size){
+    if (!state->decoder_state){
+        log_error("SBC decoder: no decoder, call btstack_sbc_decoder_init to initialize it");
+        return;
+    }
     if (state->mode == SBC_MODE_mSBC){
         btstack_sbc_decoder_process_msbc_data(state, packet_status_flag, buffer, size);
     } else {
@@ -62,75 +62,119 @@
 // #define LOG_FRAME_STATUS
 
 
+// number of encoders that can be used at the same time
+#ifndef SBC_ENCODER_MAX_INSTANCES
+#define SBC_ENCODER_MAX_INSTANCES 1
+#endif
+
 typedef struct {
     SBC_ENC_PARAMS context;
     int num_data_bytes;
     uint8_t sbc_packet[1000];
+    btstack_sbc_encoder_state_t * owner;
 } bludroid_encoder_state_t;
 
+// used by API without state argument
 static btstack_sbc_encoder_state_t * sbc_encoder_state_singleton = NULL;
-static bludroid_encoder_state_t bd_encoder_state;
+static bludroid_encoder_state_t bd_encoder_states[SBC_ENCODER_MAX_INSTANCES];
 
+static bludroid_encoder_state_t * btstack_sbc_encoder_bluedroid_for_state(btstack_sbc_encoder_state_t * state){
+    int i;
+    for (i=0;i<SBC_ENCODER_MAX_INSTANCES;i++){
+        if (bd_encoder_states[i].owner == state) return &bd_encoder_states[i];
+    }
+    return NULL;
+}
+
+static bludroid_encoder_state_t * btstack_sbc_encoder_bluedroid_allocate(btstack_sbc_encoder_state_t * state){
+    bludroid_encoder_state_t * encoder_state = btstack_sbc_encoder_bluedroid_for_state(state);
+    if (encoder_state) return encoder_state;
+    encoder_state = btstack_sbc_encoder_bluedroid_for_state(NULL);
+    if (encoder_state == NULL) return NULL;
+    encoder_state->owner = state;
+    return encoder_state;
+}
 
 void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t * state, btstack_sbc_mode_t mode, 
                         int blocks, int subbands, int allmethod, int sample_rate, int bitpool, int channel_mode){
 
-    if (sbc_encoder_state_singleton && (sbc_encoder_state_singleton != state) ){
-        log_error("SBC encoder: different sbc decoder state is allready registered");
-    } 
-    
-    sbc_encoder_state_singleton = state;
-
-    if (!sbc_encoder_state_singleton){
+    if (!state){
         log_error("SBC encoder init: sbc state is NULL");
+        return;
+    }
+
+    bludroid_encoder_state_t * bd_encoder_state = btstack_sbc_encoder_bluedroid_allocate(state);
+    if (!bd_encoder_state && sbc_encoder_state_singleton){
+        // all encoders in use, take over the one of the last initialized state as before
+        log_error("SBC encoder init: all %u encoders in use, see SBC_ENCODER_MAX_INSTANCES", SBC_ENCODER_MAX_INSTANCES);
+        bd_encoder_state = btstack_sbc_encoder_bluedroid_for_state(sbc_encoder_state_singleton);
+        bd_encoder_state->owner = state;
+    }
+    if (!bd_encoder_state){
+        log_error("SBC encoder init: no encoder available");
+        state->encoder_state = NULL;
+        return;
     }
 
-    sbc_encoder_state_singleton->mode = mode;
+    sbc_encoder_state_singleton = state;
 
-    switch (sbc_encoder_state_singleton->mode){
+    state->mode = mode;
+
+    switch (state->mode){
         case SBC_MODE_STANDARD:
-            bd_encoder_state.context.s16NumOfBlocks = blocks;                          
-            bd_encoder_state.context.s16NumOfSubBands = subbands;                       
-            bd_encoder_state.context.s16AllocationMethod = allmethod;                     
-            bd_encoder_state.context.s16BitPool = bitpool;  
-            bd_encoder_state.context.mSBCEnabled = 0;
-            bd_encoder_state.context.s16ChannelMode = channel_mode;
-            bd_encoder_state.context.s16NumOfChannels = 2;
-            if (bd_encoder_state.context.s16ChannelMode == SBC_MONO){
-                bd_encoder_state.context.s16NumOfChannels = 1;
+            bd_encoder_state->context.s16NumOfBlocks = blocks;                          
+            bd_encoder_state->context.s16NumOfSubBands = subbands;                       
+            bd_encoder_state->context.s16AllocationMethod = allmethod;                     
+            bd_encoder_state->context.s16BitPool = bitpool;  
+            bd_encoder_state->context.mSBCEnabled = 0;
+            bd_encoder_state->context.s16ChannelMode = channel_mode;
+            bd_encoder_state->context.s16NumOfChannels = 2;
+            if (bd_encoder_state->context.s16ChannelMode == SBC_MONO){
+                bd_encoder_state->context.s16NumOfChannels = 1;
             }
             switch(sample_rate){
-                case 16000: bd_encoder_state.context.s16SamplingFreq = SBC_sf16000; break;
-                case 32000: bd_encoder_state.context.s16SamplingFreq = SBC_sf32000; break;
-                case 44100: bd_encoder_state.context.s16SamplingFreq = SBC_sf44100; break;
-                case 48000: bd_encoder_state.context.s16SamplingFreq = SBC_sf48000; break;
-                default: bd_encoder_state.context.s16SamplingFreq = 0; break;
+                case 16000: bd_encoder_state->context.s16SamplingFreq = SBC_sf16000; break;
+                case 32000: bd_encoder_state->context.s16SamplingFreq = SBC_sf32000; break;
+                case 44100: bd_encoder_state->context.s16SamplingFreq = SBC_sf44100; break;
+                case 48000: bd_encoder_state->context.s16SamplingFreq = SBC_sf48000; break;
+                default: bd_encoder_state->context.s16SamplingFreq = 0; break;
             }
             break;
         case SBC_MODE_mSBC:
-            bd_encoder_state.context.s16NumOfBlocks    = 15;
-            bd_encoder_state.context.s16NumOfSubBands  = 8;
-            bd_encoder_state.context.s16AllocationMethod = SBC_LOUDNESS;
-            bd_encoder_state.context.s16BitPool   = 26;
-            bd_encoder_state.context.s16ChannelMode = SBC_MONO;
-            bd_encoder_state.context.s16NumOfChannels = 1;
-            bd_encoder_state.context.mSBCEnabled = 1;
-            bd_encoder_state.context.s16SamplingFreq = SBC_sf16000;
+            bd_encoder_state->context.s16NumOfBlocks    = 15;
+            bd_encoder_state->context.s16NumOfSubBands  = 8;
+            bd_encoder_state->context.s16AllocationMethod = SBC_LOUDNESS;
+            bd_encoder_state->context.s16BitPool   = 26;
+            bd_encoder_state->context.s16ChannelMode = SBC_MONO;
+            bd_encoder_state->context.s16NumOfChannels = 1;
+            bd_encoder_state->context.mSBCEnabled = 1;
+            bd_encoder_state->context.s16SamplingFreq = SBC_sf16000;
             break;
     }
-    bd_encoder_state.context.pu8Packet = bd_encoder_state.sbc_packet;
+    bd_encoder_state->context.pu8Packet = bd_encoder_state->sbc_packet;
     
-    sbc_encoder_state_singleton->encoder_state = &bd_encoder_state;
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
-    SBC_Encoder_Init(context);
+    state->encoder_state = bd_encoder_state;
+    SBC_Encoder_Init(&bd_encoder_state->context);
 }
 
+void btstack_sbc_encoder_deinit(btstack_sbc_encoder_state_t * state){
+    if (!state) return;
+    bludroid_encoder_state_t * bd_encoder_state = btstack_sbc_encoder_bluedroid_for_state(state);
+    if (bd_encoder_state){
+        bd_encoder_state->owner = NULL;
+    }
+    state->encoder_state = NULL;
+    if (sbc_encoder_state_singleton == state){
+        sbc_encoder_state_singleton = NULL;
+    }
+}
 
-void btstack_sbc_encoder_process_data(int16_t * input_buffer){
-    if (!sbc_encoder_state_singleton){
+void btstack_sbc_encoder_state_process_data(btstack_sbc_encoder_state_t * state, int16_t * input_buffer){
+    if (!state || !state->encoder_state){
         log_error("SBC encoder: sbc state is NULL, call btstack_sbc_encoder_init to initialize it");
+        return;
     }
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)state->encoder_state)->context;
     context->ps16PcmBuffer = input_buffer;
     if (context->mSBCEnabled){
         context->pu8Packet[0] = 0xad;
@@ -138,17 +182,45 @@ void btstack_sbc_encoder_process_data(int16_t * input_buffer){
     SBC_Encoder(context);
 }
 
-int btstack_sbc_encoder_num_audio_frames(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+int btstack_sbc_encoder_state_num_audio_frames(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)state->encoder_state)->context;
     return context->s16NumOfSubBands * context->s16NumOfBlocks;
 }
 
-uint8_t * btstack_sbc_encoder_sbc_buffer(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+uint8_t * btstack_sbc_encoder_state_sbc_buffer(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)state->encoder_state)->context;
     return context->pu8Packet;
 }
 
-uint16_t  btstack_sbc_encoder_sbc_buffer_length(void){
-    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)sbc_encoder_state_singleton->encoder_state)->context;
+uint16_t  btstack_sbc_encoder_state_sbc_buffer_length(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)state->encoder_state)->context;
     return context->u16PacketLength;
 }
+
+void btstack_sbc_encoder_state_set_bitpool(btstack_sbc_encoder_state_t * state, uint8_t bitpool){
+    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)state->encoder_state)->context;
+    if (context->mSBCEnabled) return;
+    // bitpool is evaluated per frame by bit allocation and header packing
+    context->s16BitPool = bitpool;
+}
+
+uint8_t btstack_sbc_encoder_state_get_bitpool(btstack_sbc_encoder_state_t * state){
+    SBC_ENC_PARAMS * context = &((bludroid_encoder_state_t *)state->encoder_state)->context;
+    return (uint8_t) context->s16BitPool;
+}
+
+void btstack_sbc_encoder_process_data(int16_t * input_buffer){
+    btstack_sbc_encoder_state_process_data(sbc_encoder_state_singleton, input_buffer);
+}
+
+int btstack_sbc_encoder_num_audio_frames(void){
+    return btstack_sbc_encoder_state_num_audio_frames(sbc_encoder_state_singleton);
+}
+
+uint8_t * btstack_sbc_encoder_sbc_buffer(void){
+    return btstack_sbc_encoder_state_sbc_buffer(sbc_encoder_state_singleton);
+}
+
+uint16_t  btstack_sbc_encoder_sbc_buffer_length(void){
+    return btstack_sbc_encoder_state_sbc_buffer_length(sbc_encoder_state_singleton);
+}
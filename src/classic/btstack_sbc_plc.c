@@ -58,6 +58,134 @@ static uint8_t indices0[] = { 0xad, 0x00, 0x00, 0xc5, 0x00, 0x00, 0x00, 0x00, 0x
 0xb6, 0xdd, 0xdb, 0x6d, 0xb7, 0x76, 0xdb, 0x6d, 0xdd, 0xb6, 0xdb, 0x77, 0x6d,
 0xb6, 0xdd, 0xdb, 0x6d, 0xb7, 0x76, 0xdb, 0x6c};
 
+#ifdef ENABLE_PLC_FIXED_POINT
+
+#define PLC_MANTISSA_BITS 24
+
+/* Raised COSine table for OLA in Q15 */
+static const int16_t rcos_q15[SBC_OLAL] = {
+    32489, 31662, 30314, 28492,
+    26258, 23687, 20868, 17896,
+    14872, 11900,  9081,  6510,
+     4276,  2454,  1106,   279
+};
+
+static int64_t btstack_sbc_plc_dot_product(const SAMPLE_FORMAT * x, const SAMPLE_FORMAT * y, int len){
+    int64_t sum = 0;
+    int i;
+    for (i=0;i<len;i++){
+        sum += (int32_t) x[i] * y[i];
+    }
+    return sum;
+}
+
+// reduce value to PLC_MANTISSA_BITS and add dropped bits to exponent
+static uint64_t btstack_sbc_plc_normalize(uint64_t value, int * exponent){
+    while (value >= (1ULL << PLC_MANTISSA_BITS)){
+        value >>= 1;
+        (*exponent)++;
+    }
+    return value;
+}
+
+// approximate num^2 * energy as mantissa * 2^exponent with mantissa in [2^47, 2^48) or 0
+static uint64_t btstack_sbc_plc_square_times_energy(int64_t num, int64_t energy, int * exponent){
+    uint64_t abs_num = (uint64_t) (num < 0 ? -num : num);
+    *exponent = 0;
+    uint64_t m = btstack_sbc_plc_normalize(abs_num, exponent);
+    *exponent *= 2;
+    m = btstack_sbc_plc_normalize(m * m, exponent);
+    m = m * btstack_sbc_plc_normalize((uint64_t) energy, exponent);
+    if (m == 0) return 0;
+    while (m < (1ULL << (2 * PLC_MANTISSA_BITS - 1))){
+        m <<= 1;
+        (*exponent)--;
+    }
+    return m;
+}
+
+// compare num_a / sqrt(energy_a) with num_b / sqrt(energy_b) without division and square root
+static int btstack_sbc_plc_compare_correlation(int64_t num_a, int64_t energy_a, int64_t num_b, int64_t energy_b){
+    if ((num_a >= 0) && (num_b < 0)) return 1;
+    if ((num_a < 0) && (num_b >= 0)) return -1;
+    int exponent_a;
+    int exponent_b;
+    uint64_t mantissa_a = btstack_sbc_plc_square_times_energy(num_a, energy_b, &exponent_a);
+    uint64_t mantissa_b = btstack_sbc_plc_square_times_energy(num_b, energy_a, &exponent_b);
+    int result;
+    if (mantissa_a == 0 || mantissa_b == 0){
+        result = (mantissa_a > mantissa_b) - (mantissa_a < mantissa_b);
+    } else if (exponent_a != exponent_b){
+        result = exponent_a > exponent_b ? 1 : -1;
+    } else {
+        result = (mantissa_a > mantissa_b) - (mantissa_a < mantissa_b);
+    }
+    // for negative correlation, larger magnitude is worse
+    return num_a < 0 ? -result : result;
+}
+
+// find best match for template at end of history. Template energy is constant and cancels out in the comparison,
+// window energy is updated incrementally, so only the cross term needs a dot product per lag
+static int PatternMatch(SAMPLE_FORMAT *y){
+    const SAMPLE_FORMAT * x = &y[SBC_LHIST-SBC_M];
+    if (btstack_sbc_plc_dot_product(x, x, SBC_M) == 0) return 0;
+    int64_t energy = btstack_sbc_plc_dot_product(y, y, SBC_M);
+    int64_t best_num = 0;
+    int64_t best_energy = 0;
+    int     bestmatch = -1;
+    int     n;
+    for (n=0;n<SBC_N;n++){
+        if (energy > 0){
+            int64_t num = btstack_sbc_plc_dot_product(x, &y[n], SBC_M);
+            if ((bestmatch < 0) || (btstack_sbc_plc_compare_correlation(num, energy, best_num, best_energy) > 0)){
+                bestmatch   = n;
+                best_num    = num;
+                best_energy = energy;
+            }
+        }
+        energy += ((int32_t) y[n+SBC_M] * y[n+SBC_M]) - ((int32_t) y[n] * y[n]);
+    }
+    return bestmatch < 0 ? 0 : bestmatch;
+}
+
+// scale factor in Q15 to match amplitude of substitution packet to that of preceding packet
+static int32_t AmplitudeMatch(SAMPLE_FORMAT *y, SAMPLE_FORMAT bestmatch) {
+    int      i;
+    uint32_t sumx = 0;
+    uint32_t sumy = 0;
+    int32_t  sf;
+
+    for (i=0;i<SBC_FS;i++){
+        sumx += (uint32_t) abs(y[SBC_LHIST-SBC_FS+i]);
+        sumy += (uint32_t) abs(y[bestmatch+i]);
+    }
+    if (sumy == 0){
+        sf = (sumx > 0) ? 32768 : 0;
+    } else {
+        sf = (int32_t) (((uint64_t) sumx << 15) / sumy);
+    }
+    // This is not in the paper, but limit the scaling factor to something reasonable to avoid creating artifacts
+    if (sf < 24576) sf = 24576;
+    if (sf > 32768) sf = 32768;
+    return sf;
+}
+
+// convert Q30 value to sample, truncating like the float version
+static SAMPLE_FORMAT crop_sample_q30(int64_t val){
+    val /= (1 << 30);
+    if (val > 32767)  val = 32767;
+    if (val < -32768) val = -32768;
+    return (SAMPLE_FORMAT) val;
+}
+
+// Q30 overlap-add of left and right sample, each scaled by a Q15 factor
+static SAMPLE_FORMAT overlap_add_q15(SAMPLE_FORMAT left, int32_t sf_left, int16_t rcos_left, SAMPLE_FORMAT right, int32_t sf_right, int16_t rcos_right){
+    int64_t val = ((int64_t) left * sf_left * rcos_left) + ((int64_t) right * sf_right * rcos_right);
+    return crop_sample_q30(val);
+}
+
+#else
+
 /* Raised COSine table for OLA */
 static float rcos[SBC_OLAL] = {
     0.99148655f,0.96623611f,0.92510857f,0.86950446f,
@@ -142,6 +270,7 @@ static SAMPLE_FORMAT crop_sample(float val){
     if (croped_val < -32768.0) croped_val=-32768.0; 
     return (SAMPLE_FORMAT) croped_val;
 }
+#endif
 
 uint8_t * btstack_sbc_plc_zero_signal_frame(void){
     return (uint8_t *)&indices0;
@@ -303,9 +432,13 @@ static void octave_fprintf_plot_output(btstack_sbc_plc_state_t *plc_state, FILE
 
 
 void btstack_sbc_plc_bad_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMAT *ZIRbuf, SAMPLE_FORMAT *out){
-    float val;
     int   i = 0;
+#ifdef ENABLE_PLC_FIXED_POINT
+    int32_t sf = 32768;
+#else
+    float val;
     float sf = 1;
+#endif
     plc_state->nbf++;
    
     plc_state->bad_frames_nr++;
@@ -334,6 +467,19 @@ void btstack_sbc_plc_bad_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMAT
         // Compute Scale Factor to Match Amplitude of Substitution Packet to that of Preceding Packet
         sf = AmplitudeMatch(plc_state->hist, plc_state->bestlag);
         // printf("sf Apmlitude Match %f, new data %d, bestlag+M %d\n", sf, ZIRbuf[0], plc_state->hist[plc_state->bestlag]);
+#ifdef ENABLE_PLC_FIXED_POINT
+        for (i=0;i<SBC_OLAL;i++){
+            plc_state->hist[SBC_LHIST+i] = overlap_add_q15(ZIRbuf[i], 32768, rcos_q15[i], plc_state->hist[plc_state->bestlag+i], sf, rcos_q15[SBC_OLAL-1-i]);
+        }
+
+        for (;i<SBC_FS;i++){
+            plc_state->hist[SBC_LHIST+i] = (SAMPLE_FORMAT) ((sf * plc_state->hist[plc_state->bestlag+i]) / 32768);
+        }
+
+        for (;i<(SBC_FS+SBC_OLAL);i++){
+            plc_state->hist[SBC_LHIST+i] = overlap_add_q15(plc_state->hist[plc_state->bestlag+i], sf, rcos_q15[i-SBC_FS], plc_state->hist[plc_state->bestlag+i], 32768, rcos_q15[SBC_OLAL-1-i+SBC_FS]);
+        }
+#else
         for (i=0;i<SBC_OLAL;i++){
             float left  = ZIRbuf[i];
             float right = sf*plc_state->hist[plc_state->bestlag+i];
@@ -353,6 +499,7 @@ void btstack_sbc_plc_bad_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMAT
             val = (left*rcos[i-SBC_FS])+(right*rcos[SBC_OLAL-1-i+SBC_FS]);
             plc_state->hist[SBC_LHIST+i] = crop_sample(val);
         }
+#endif
 
         for (;i<(SBC_FS+SBC_RT+SBC_OLAL);i++){
             plc_state->hist[SBC_LHIST+i] = plc_state->hist[plc_state->bestlag+i];
@@ -381,7 +528,9 @@ void btstack_sbc_plc_bad_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMAT
 }
 
 void btstack_sbc_plc_good_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMAT *in, SAMPLE_FORMAT *out){
+#ifndef ENABLE_PLC_FIXED_POINT
     float val;
+#endif
     int i = 0;
     plc_state->good_frames_nr++;
     plc_state->frame_count++;
@@ -402,10 +551,14 @@ void btstack_sbc_plc_good_frame(btstack_sbc_plc_state_t *plc_state, SAMPLE_FORMA
         }
             
         for (i = SBC_RT;i<(SBC_RT+SBC_OLAL);i++){
+#ifdef ENABLE_PLC_FIXED_POINT
+            out[i] = overlap_add_q15(plc_state->hist[SBC_LHIST+i], 32768, rcos_q15[i-SBC_RT], in[i], 32768, rcos_q15[SBC_OLAL+SBC_RT-1-i]);
+#else
             float left  = plc_state->hist[SBC_LHIST+i];
             float right = in[i];  
             val = (left*rcos[i-SBC_RT]) + (right*rcos[SBC_OLAL+SBC_RT-1-i]);
             out[i] = crop_sample(val);
+#endif
         }
     }
 
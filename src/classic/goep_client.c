@@ -101,18 +101,43 @@ static goep_client_t * goep_client = &_goep_client;
 static uint8_t            attribute_value[30];
 static const unsigned int attribute_value_buffer_size = sizeof(attribute_value);
 
-static uint8_t goep_packet_buffer[100];
+// outgoing OBEX requests over L2CAP are assembled here, RFCOMM uses its outgoing buffer
+#ifndef GOEP_CLIENT_L2CAP_PACKET_BUFFER_SIZE
+#define GOEP_CLIENT_L2CAP_PACKET_BUFFER_SIZE 100
+#endif
+
+static uint8_t goep_packet_buffer[GOEP_CLIENT_L2CAP_PACKET_BUFFER_SIZE];
 
 #ifdef ENABLE_GOEP_L2CAP
-static uint8_t ertm_buffer[1000];
+
+// max OBEX packet size over L2CAP, ERTM reassembles SDUs up to this size
+#ifndef GOEP_CLIENT_ERTM_MTU
+#define GOEP_CLIENT_ERTM_MTU 512
+#endif
+
+// rx window offered to remote, more buffers allow remote to stream SRM responses without waiting for acks
+#ifndef GOEP_CLIENT_ERTM_NUM_RX_BUFFERS
+#define GOEP_CLIENT_ERTM_NUM_RX_BUFFERS 2
+#endif
+
+#ifndef GOEP_CLIENT_ERTM_NUM_TX_BUFFERS
+#define GOEP_CLIENT_ERTM_NUM_TX_BUFFERS 2
+#endif
+
+// ERTM buffer for reassembly, rx and tx packets. Default fits I-frames of full MTU size incl. packet states
+#ifndef GOEP_CLIENT_ERTM_BUFFER_SIZE
+#define GOEP_CLIENT_ERTM_BUFFER_SIZE ((GOEP_CLIENT_ERTM_MTU * (1 + GOEP_CLIENT_ERTM_NUM_RX_BUFFERS + GOEP_CLIENT_ERTM_NUM_TX_BUFFERS)) + 200)
+#endif
+
+static uint8_t ertm_buffer[GOEP_CLIENT_ERTM_BUFFER_SIZE];
 static l2cap_ertm_config_t ertm_config = {
     1,  // ertm mandatory
     2,  // max transmit, some tests require > 1
     2000,
     12000,
-    512,    // l2cap ertm mtu
-    2,
-    2,
+    GOEP_CLIENT_ERTM_MTU,    // l2cap ertm mtu
+    GOEP_CLIENT_ERTM_NUM_TX_BUFFERS,
+    GOEP_CLIENT_ERTM_NUM_RX_BUFFERS,
     0,      // No FCS
 };
 #endif
@@ -354,7 +379,7 @@ static uint8_t * goep_client_get_outgoing_buffer(goep_client_t * context){
 
 static uint16_t goep_client_get_outgoing_buffer_len(goep_client_t * context){
     if (context->l2cap_psm){
-        return sizeof(goep_packet_buffer);
+        return btstack_min(sizeof(goep_packet_buffer), context->bearer_mtu);
     } else {
         return rfcomm_get_max_frame_size(context->bearer_cid);
     }
@@ -398,9 +423,21 @@ uint32_t goep_client_get_pbap_supported_features(uint16_t goep_cid){
     return context->pbap_supported_features;
 }
 
+int goep_client_version_20_or_higher(uint16_t goep_cid){
+    UNUSED(goep_cid);
+    goep_client_t * context = goep_client;
+    return context->l2cap_psm != 0;
+}
+
 uint8_t goep_client_disconnect(uint16_t goep_cid){
     UNUSED(goep_cid);
     goep_client_t * context = goep_client;
+#ifdef ENABLE_GOEP_L2CAP
+    if (context->l2cap_psm){
+        l2cap_disconnect(context->bearer_cid, 0);
+        return 0;
+    }
+#endif
     rfcomm_disconnect(context->bearer_cid);
     return 0;
 }
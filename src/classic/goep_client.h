@@ -102,6 +102,14 @@ uint8_t goep_client_get_request_opcode(uint16_t goep_cid);
  */
 uint32_t goep_client_get_pbap_supported_features(uint16_t goep_cid); 
 
+/**
+ * @brief Check if GOEP 2.0 or higher features can be used, i.e. connection is over L2CAP
+ * @note Single Response Mode (SRM) is only allowed over L2CAP
+ * @param goep_cid
+ * @return true if connected via L2CAP
+ */
+int goep_client_version_20_or_higher(uint16_t goep_cid);
+
 /**
  * @brief Set Connection ID used for newly created requests
  * @param goep_cid
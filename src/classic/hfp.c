@@ -420,6 +420,10 @@ static hfp_connection_t * create_hfp_connection_context(void){
 
 static void remove_hfp_connection_context(hfp_connection_t * hfp_connection){
     btstack_linked_list_remove(&hfp_connections, (btstack_linked_item_t*) hfp_connection);
+#ifdef ENABLE_HFP_MSBC_PER_CONNECTION
+    hfp_msbc_encoder_deinit(&hfp_connection->msbc_encoder);
+    btstack_sbc_decoder_deinit(&hfp_connection->msbc_decoder);
+#endif
     btstack_memory_hfp_connection_free(hfp_connection);
 }
 
@@ -721,6 +725,11 @@ void hfp_handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet
             hfp_connection->sco_handle = sco_handle;
             hfp_connection->establish_audio_connection = 0;
             hfp_connection->state = HFP_AUDIO_CONNECTION_ESTABLISHED;
+#ifdef ENABLE_HFP_MSBC_PER_CONNECTION
+            if (hfp_connection->negotiated_codec == HFP_CODEC_MSBC){
+                hfp_msbc_encoder_init(&hfp_connection->msbc_encoder);
+            }
+#endif
             hfp_emit_sco_event(hfp_connection, status, sco_handle, event_addr, hfp_connection->negotiated_codec);
             break;                
         }
@@ -734,6 +743,10 @@ void hfp_handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet
             hfp_connection->sco_handle = HCI_CON_HANDLE_INVALID;
             hfp_connection->release_audio_connection = 0;
             hfp_connection->state = HFP_SERVICE_LEVEL_CONNECTION_ESTABLISHED;
+#ifdef ENABLE_HFP_MSBC_PER_CONNECTION
+            hfp_msbc_encoder_deinit(&hfp_connection->msbc_encoder);
+            btstack_sbc_decoder_deinit(&hfp_connection->msbc_decoder);
+#endif
             hfp_emit_event(hfp_connection, HFP_SUBEVENT_AUDIO_CONNECTION_RELEASED, 0);
 
             if (hfp_connection->release_slc_connection){
@@ -835,44 +848,98 @@ void hfp_handle_rfcomm_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
             break;
     }
 }
-// translates command string into hfp_command_t CMD
-static hfp_command_t parse_command(const char * line_buffer, int isHandsFree){
-    log_info("command '%s', handsfree %u", line_buffer, isHandsFree);
-    int offset = isHandsFree ? 0 : 2;
-
-    if (strncmp(line_buffer+offset, HFP_LIST_CURRENT_CALLS, strlen(HFP_LIST_CURRENT_CALLS)) == 0){
-        return HFP_CMD_LIST_CURRENT_CALLS;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_SUBSCRIBER_NUMBER_INFORMATION, strlen(HFP_SUBSCRIBER_NUMBER_INFORMATION)) == 0){
-        return HFP_CMD_GET_SUBSCRIBER_NUMBER_INFORMATION;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_PHONE_NUMBER_FOR_VOICE_TAG, strlen(HFP_PHONE_NUMBER_FOR_VOICE_TAG)) == 0){
-        if (isHandsFree) return HFP_CMD_AG_SENT_PHONE_NUMBER;
-        return HFP_CMD_HF_REQUEST_PHONE_NUMBER;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_TRANSMIT_DTMF_CODES, strlen(HFP_TRANSMIT_DTMF_CODES)) == 0){
-        return HFP_CMD_TRANSMIT_DTMF_CODES;
-    }
+typedef struct {
+    const char *  name;
+    uint8_t       name_len;
+    hfp_command_t hf_command;  // command when received by HF, HFP_CMD_NONE if not valid for HF
+    hfp_command_t ag_command;  // command when received by AG, HFP_CMD_NONE if not valid for AG
+} hfp_command_entry_t;
+
+#define HFP_COMMAND_ENTRY(name, hf_command, ag_command) { name, sizeof(name) - 1, hf_command, ag_command }
+
+// sorted by name for binary search, no name is a prefix of another one
+static const hfp_command_entry_t hfp_command_table[] = {
+    HFP_COMMAND_ENTRY(HFP_AVAILABLE_CODECS,                                  HFP_CMD_AVAILABLE_CODECS,                           HFP_CMD_AVAILABLE_CODECS),
+    HFP_COMMAND_ENTRY(HFP_TRIGGER_CODEC_CONNECTION_SETUP,                    HFP_CMD_TRIGGER_CODEC_CONNECTION_SETUP,             HFP_CMD_TRIGGER_CODEC_CONNECTION_SETUP),
+    HFP_COMMAND_ENTRY(HFP_CONFIRM_COMMON_CODEC,                              HFP_CMD_AG_SUGGESTED_CODEC,                         HFP_CMD_HF_CONFIRMED_CODEC),
+    HFP_COMMAND_ENTRY(HFP_UPDATE_ENABLE_STATUS_FOR_INDIVIDUAL_AG_INDICATORS, HFP_CMD_ENABLE_INDIVIDUAL_AG_INDICATOR_STATUS_UPDATE, HFP_CMD_ENABLE_INDIVIDUAL_AG_INDICATOR_STATUS_UPDATE),
+    HFP_COMMAND_ENTRY(HFP_TRANSFER_HF_INDICATOR_STATUS,                      HFP_CMD_HF_INDICATOR_STATUS,                        HFP_CMD_HF_INDICATOR_STATUS),
+    HFP_COMMAND_ENTRY(HFP_GENERIC_STATUS_INDICATOR,                          HFP_CMD_SET_GENERIC_STATUS_INDICATOR_STATUS,        HFP_CMD_RETRIEVE_GENERIC_STATUS_INDICATORS_STATE),
+    HFP_COMMAND_ENTRY(HFP_PHONE_NUMBER_FOR_VOICE_TAG,                        HFP_CMD_AG_SENT_PHONE_NUMBER,                       HFP_CMD_HF_REQUEST_PHONE_NUMBER),
+    HFP_COMMAND_ENTRY(HFP_REDIAL_LAST_NUMBER,                                HFP_CMD_REDIAL_LAST_NUMBER,                         HFP_CMD_REDIAL_LAST_NUMBER),
+    HFP_COMMAND_ENTRY(HFP_SUPPORTED_FEATURES,                                HFP_CMD_SUPPORTED_FEATURES,                         HFP_CMD_SUPPORTED_FEATURES),
+    HFP_COMMAND_ENTRY(HFP_CHANGE_IN_BAND_RING_TONE_SETTING,                  HFP_CMD_CHANGE_IN_BAND_RING_TONE_SETTING,           HFP_CMD_CHANGE_IN_BAND_RING_TONE_SETTING),
+    HFP_COMMAND_ENTRY(HFP_RESPONSE_AND_HOLD,                                 HFP_CMD_RESPONSE_AND_HOLD_STATUS,                   HFP_CMD_RESPONSE_AND_HOLD_STATUS),
+    HFP_COMMAND_ENTRY(HFP_ACTIVATE_VOICE_RECOGNITION,                        HFP_CMD_AG_ACTIVATE_VOICE_RECOGNITION,              HFP_CMD_HF_ACTIVATE_VOICE_RECOGNITION),
+    HFP_COMMAND_ENTRY(HFP_ENABLE_CALL_WAITING_NOTIFICATION,                  HFP_CMD_AG_SENT_CALL_WAITING_NOTIFICATION_UPDATE,   HFP_CMD_ENABLE_CALL_WAITING_NOTIFICATION),
+    HFP_COMMAND_ENTRY(HFP_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES,         HFP_CMD_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES,  HFP_CMD_CALL_HOLD),
+    HFP_COMMAND_ENTRY(HFP_HANG_UP_CALL,                                      HFP_CMD_HANG_UP_CALL,                               HFP_CMD_HANG_UP_CALL),
+    HFP_COMMAND_ENTRY(HFP_TRANSFER_AG_INDICATOR_STATUS,                      HFP_CMD_TRANSFER_AG_INDICATOR_STATUS,               HFP_CMD_TRANSFER_AG_INDICATOR_STATUS),
+    HFP_COMMAND_ENTRY(HFP_INDICATOR,                                         HFP_CMD_RETRIEVE_AG_INDICATORS,                     HFP_CMD_RETRIEVE_AG_INDICATORS),
+    HFP_COMMAND_ENTRY(HFP_LIST_CURRENT_CALLS,                                HFP_CMD_LIST_CURRENT_CALLS,                         HFP_CMD_LIST_CURRENT_CALLS),
+    HFP_COMMAND_ENTRY(HFP_ENABLE_CLIP,                                       HFP_CMD_AG_SENT_CLIP_INFORMATION,                   HFP_CMD_ENABLE_CLIP),
+    HFP_COMMAND_ENTRY(HFP_EXTENDED_AUDIO_GATEWAY_ERROR,                      HFP_CMD_EXTENDED_AUDIO_GATEWAY_ERROR,               HFP_CMD_NONE),
+    HFP_COMMAND_ENTRY(HFP_ENABLE_EXTENDED_AUDIO_GATEWAY_ERROR,               HFP_CMD_NONE,                                       HFP_CMD_ENABLE_EXTENDED_AUDIO_GATEWAY_ERROR),
+    HFP_COMMAND_ENTRY(HFP_ENABLE_STATUS_UPDATE_FOR_AG_INDICATORS,            HFP_CMD_ENABLE_INDICATOR_STATUS_UPDATE,             HFP_CMD_ENABLE_INDICATOR_STATUS_UPDATE),
+    HFP_COMMAND_ENTRY(HFP_SUBSCRIBER_NUMBER_INFORMATION,                     HFP_CMD_GET_SUBSCRIBER_NUMBER_INFORMATION,          HFP_CMD_GET_SUBSCRIBER_NUMBER_INFORMATION),
+    HFP_COMMAND_ENTRY(HFP_QUERY_OPERATOR_SELECTION,                          HFP_CMD_QUERY_OPERATOR_SELECTION_NAME,              HFP_CMD_QUERY_OPERATOR_SELECTION_NAME),
+    HFP_COMMAND_ENTRY(HFP_TURN_OFF_EC_AND_NR,                                HFP_CMD_TURN_OFF_EC_AND_NR,                         HFP_CMD_TURN_OFF_EC_AND_NR),
+    HFP_COMMAND_ENTRY(HFP_SET_MICROPHONE_GAIN,                               HFP_CMD_SET_MICROPHONE_GAIN,                        HFP_CMD_SET_MICROPHONE_GAIN),
+    HFP_COMMAND_ENTRY(HFP_SET_SPEAKER_GAIN,                                  HFP_CMD_SET_SPEAKER_GAIN,                           HFP_CMD_SET_SPEAKER_GAIN),
+    HFP_COMMAND_ENTRY(HFP_TRANSMIT_DTMF_CODES,                               HFP_CMD_TRANSMIT_DTMF_CODES,                        HFP_CMD_TRANSMIT_DTMF_CODES),
+    HFP_COMMAND_ENTRY(HFP_ERROR,                                             HFP_CMD_ERROR,                                      HFP_CMD_ERROR),
+    HFP_COMMAND_ENTRY(HFP_OK,                                                HFP_CMD_OK,                                         HFP_CMD_NONE),
+    HFP_COMMAND_ENTRY(HFP_RING,                                              HFP_CMD_RING,                                       HFP_CMD_RING),
+};
 
-    if (strncmp(line_buffer+offset, HFP_SET_MICROPHONE_GAIN, strlen(HFP_SET_MICROPHONE_GAIN)) == 0){
-        return HFP_CMD_SET_MICROPHONE_GAIN;
+static const hfp_command_entry_t * hfp_command_table_lookup(const char * command){
+    int low  = 0;
+    int high = (int) (sizeof(hfp_command_table) / sizeof(hfp_command_entry_t));
+    while (low < high){
+        int mid = (low + high) / 2;
+        const hfp_command_entry_t * entry = &hfp_command_table[mid];
+        int res = strncmp(command, entry->name, entry->name_len);
+        if (res == 0) return entry;
+        if (res < 0){
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
     }
+    return NULL;
+}
 
-    if (strncmp(line_buffer+offset, HFP_SET_SPEAKER_GAIN, strlen(HFP_SET_SPEAKER_GAIN)) == 0){
-        return HFP_CMD_SET_SPEAKER_GAIN;
-    }
-    
-    if (strncmp(line_buffer+offset, HFP_ACTIVATE_VOICE_RECOGNITION, strlen(HFP_ACTIVATE_VOICE_RECOGNITION)) == 0){
-        if (isHandsFree) return HFP_CMD_AG_ACTIVATE_VOICE_RECOGNITION;
-        return HFP_CMD_HF_ACTIVATE_VOICE_RECOGNITION;
+// resolve commands that depend on the characters following the command name
+static hfp_command_t hfp_command_resolve_suffix(hfp_command_t command, const char * suffix){
+    switch (command){
+        case HFP_CMD_RESPONSE_AND_HOLD_STATUS:
+            if (suffix[0] == '?') return HFP_CMD_RESPONSE_AND_HOLD_QUERY;
+            if (suffix[0] == '=') return HFP_CMD_RESPONSE_AND_HOLD_COMMAND;
+            return HFP_CMD_RESPONSE_AND_HOLD_STATUS;
+        case HFP_CMD_RETRIEVE_AG_INDICATORS:
+            if (suffix[0] == '?') return HFP_CMD_RETRIEVE_AG_INDICATORS_STATUS;
+            if (strncmp(suffix, "=?", 2) == 0) return HFP_CMD_RETRIEVE_AG_INDICATORS;
+            return HFP_CMD_UNKNOWN;
+        case HFP_CMD_CALL_HOLD:
+            if (strncmp(suffix, "=?", 2) == 0) return HFP_CMD_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES;
+            if (suffix[0] == '=') return HFP_CMD_CALL_HOLD;
+            return HFP_CMD_UNKNOWN;
+        case HFP_CMD_RETRIEVE_GENERIC_STATUS_INDICATORS_STATE:
+            if (strncmp(suffix, "=?", 2) == 0) return HFP_CMD_RETRIEVE_GENERIC_STATUS_INDICATORS;
+            if (suffix[0] == '=') return HFP_CMD_LIST_GENERIC_STATUS_INDICATORS;
+            return HFP_CMD_RETRIEVE_GENERIC_STATUS_INDICATORS_STATE;
+        case HFP_CMD_QUERY_OPERATOR_SELECTION_NAME:
+            if (suffix[0] == '=') return HFP_CMD_QUERY_OPERATOR_SELECTION_NAME_FORMAT;
+            return HFP_CMD_QUERY_OPERATOR_SELECTION_NAME;
+        default:
+            return command;
     }
+}
 
-    if (strncmp(line_buffer+offset, HFP_TURN_OFF_EC_AND_NR, strlen(HFP_TURN_OFF_EC_AND_NR)) == 0){
-        return HFP_CMD_TURN_OFF_EC_AND_NR;
-    }
+// translates command string into hfp_command_t CMD
+static hfp_command_t parse_command(const char * line_buffer, int isHandsFree){
+    log_info("command '%s', handsfree %u", line_buffer, isHandsFree);
+    int offset = isHandsFree ? 0 : 2;
 
     if (strncmp(line_buffer, HFP_ANSWER_CALL, strlen(HFP_ANSWER_CALL)) == 0){
         return HFP_CMD_CALL_ANSWERED;
@@ -882,139 +949,14 @@ static hfp_command_t parse_command(const char * line_buffer, int isHandsFree){
         return HFP_CMD_CALL_PHONE_NUMBER;
     }
 
-    if (strncmp(line_buffer+offset, HFP_REDIAL_LAST_NUMBER, strlen(HFP_REDIAL_LAST_NUMBER)) == 0){
-        return HFP_CMD_REDIAL_LAST_NUMBER;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_CHANGE_IN_BAND_RING_TONE_SETTING, strlen(HFP_CHANGE_IN_BAND_RING_TONE_SETTING)) == 0){
-        return HFP_CMD_CHANGE_IN_BAND_RING_TONE_SETTING;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_HANG_UP_CALL, strlen(HFP_HANG_UP_CALL)) == 0){
-        return HFP_CMD_HANG_UP_CALL;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_ERROR, strlen(HFP_ERROR)) == 0){
-        return HFP_CMD_ERROR;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_RING, strlen(HFP_RING)) == 0){
-        return HFP_CMD_RING;
-    }
-
-    if (isHandsFree && (strncmp(line_buffer+offset, HFP_OK, strlen(HFP_OK)) == 0)){
-        return HFP_CMD_OK;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_SUPPORTED_FEATURES, strlen(HFP_SUPPORTED_FEATURES)) == 0){
-        return HFP_CMD_SUPPORTED_FEATURES;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_TRANSFER_HF_INDICATOR_STATUS, strlen(HFP_TRANSFER_HF_INDICATOR_STATUS)) == 0){
-        return HFP_CMD_HF_INDICATOR_STATUS;
-    }
-    
-    if (strncmp(line_buffer+offset, HFP_RESPONSE_AND_HOLD, strlen(HFP_RESPONSE_AND_HOLD)) == 0){
-        if (strncmp(line_buffer+strlen(HFP_RESPONSE_AND_HOLD)+offset, "?", 1) == 0){
-            return HFP_CMD_RESPONSE_AND_HOLD_QUERY;
-        }
-        if (strncmp(line_buffer+strlen(HFP_RESPONSE_AND_HOLD)+offset, "=", 1) == 0){
-            return HFP_CMD_RESPONSE_AND_HOLD_COMMAND;
-        }
-        return HFP_CMD_RESPONSE_AND_HOLD_STATUS;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_INDICATOR, strlen(HFP_INDICATOR)) == 0){
-        if (strncmp(line_buffer+strlen(HFP_INDICATOR)+offset, "?", 1) == 0){
-            return HFP_CMD_RETRIEVE_AG_INDICATORS_STATUS;
+    const hfp_command_entry_t * entry = hfp_command_table_lookup(line_buffer+offset);
+    if (entry != NULL){
+        hfp_command_t command = isHandsFree ? entry->hf_command : entry->ag_command;
+        if (command != HFP_CMD_NONE){
+            return hfp_command_resolve_suffix(command, line_buffer + offset + entry->name_len);
         }
-
-        if (strncmp(line_buffer+strlen(HFP_INDICATOR)+offset, "=?", 2) == 0){
-            return HFP_CMD_RETRIEVE_AG_INDICATORS;
-        }
-    }
-
-    if (strncmp(line_buffer+offset, HFP_AVAILABLE_CODECS, strlen(HFP_AVAILABLE_CODECS)) == 0){
-        return HFP_CMD_AVAILABLE_CODECS;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_ENABLE_STATUS_UPDATE_FOR_AG_INDICATORS, strlen(HFP_ENABLE_STATUS_UPDATE_FOR_AG_INDICATORS)) == 0){
-        return HFP_CMD_ENABLE_INDICATOR_STATUS_UPDATE;
     }
 
-    if (strncmp(line_buffer+offset, HFP_ENABLE_CLIP, strlen(HFP_ENABLE_CLIP)) == 0){
-        if (isHandsFree) return HFP_CMD_AG_SENT_CLIP_INFORMATION;
-        return HFP_CMD_ENABLE_CLIP;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_ENABLE_CALL_WAITING_NOTIFICATION, strlen(HFP_ENABLE_CALL_WAITING_NOTIFICATION)) == 0){
-        if (isHandsFree) return HFP_CMD_AG_SENT_CALL_WAITING_NOTIFICATION_UPDATE;
-        return HFP_CMD_ENABLE_CALL_WAITING_NOTIFICATION;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES, strlen(HFP_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES)) == 0){
-        
-        if (isHandsFree) return HFP_CMD_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES;
-
-        if (strncmp(line_buffer+strlen(HFP_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES)+offset, "=?", 2) == 0){
-            return HFP_CMD_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES;
-        }
-        if (strncmp(line_buffer+strlen(HFP_SUPPORT_CALL_HOLD_AND_MULTIPARTY_SERVICES)+offset, "=", 1) == 0){
-            return HFP_CMD_CALL_HOLD;    
-        }
-
-        return HFP_CMD_UNKNOWN;
-    } 
-
-    if (strncmp(line_buffer+offset, HFP_GENERIC_STATUS_INDICATOR, strlen(HFP_GENERIC_STATUS_INDICATOR)) == 0){
-        if (isHandsFree) {
-            return HFP_CMD_SET_GENERIC_STATUS_INDICATOR_STATUS;
-        }
-        if (strncmp(line_buffer+strlen(HFP_GENERIC_STATUS_INDICATOR)+offset, "=?", 2) == 0){
-            return HFP_CMD_RETRIEVE_GENERIC_STATUS_INDICATORS;
-        } 
-        if (strncmp(line_buffer+strlen(HFP_GENERIC_STATUS_INDICATOR)+offset, "=", 1) == 0){
-            return HFP_CMD_LIST_GENERIC_STATUS_INDICATORS;    
-        }
-        return HFP_CMD_RETRIEVE_GENERIC_STATUS_INDICATORS_STATE;
-    } 
-
-    if (strncmp(line_buffer+offset, HFP_UPDATE_ENABLE_STATUS_FOR_INDIVIDUAL_AG_INDICATORS, strlen(HFP_UPDATE_ENABLE_STATUS_FOR_INDIVIDUAL_AG_INDICATORS)) == 0){
-        return HFP_CMD_ENABLE_INDIVIDUAL_AG_INDICATOR_STATUS_UPDATE;
-    } 
-    
-
-    if (strncmp(line_buffer+offset, HFP_QUERY_OPERATOR_SELECTION, strlen(HFP_QUERY_OPERATOR_SELECTION)) == 0){
-        if (strncmp(line_buffer+strlen(HFP_QUERY_OPERATOR_SELECTION)+offset, "=", 1) == 0){
-            return HFP_CMD_QUERY_OPERATOR_SELECTION_NAME_FORMAT;
-        } 
-        return HFP_CMD_QUERY_OPERATOR_SELECTION_NAME;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_TRANSFER_AG_INDICATOR_STATUS, strlen(HFP_TRANSFER_AG_INDICATOR_STATUS)) == 0){
-        return HFP_CMD_TRANSFER_AG_INDICATOR_STATUS;
-    } 
-
-    if (isHandsFree && (strncmp(line_buffer+offset, HFP_EXTENDED_AUDIO_GATEWAY_ERROR, strlen(HFP_EXTENDED_AUDIO_GATEWAY_ERROR)) == 0)){
-        return HFP_CMD_EXTENDED_AUDIO_GATEWAY_ERROR;
-    }
-
-    if (!isHandsFree && (strncmp(line_buffer+offset, HFP_ENABLE_EXTENDED_AUDIO_GATEWAY_ERROR, strlen(HFP_ENABLE_EXTENDED_AUDIO_GATEWAY_ERROR)) == 0)){
-        return HFP_CMD_ENABLE_EXTENDED_AUDIO_GATEWAY_ERROR;
-    }
-
-    if (strncmp(line_buffer+offset, HFP_TRIGGER_CODEC_CONNECTION_SETUP, strlen(HFP_TRIGGER_CODEC_CONNECTION_SETUP)) == 0){
-        return HFP_CMD_TRIGGER_CODEC_CONNECTION_SETUP;
-    } 
-
-    if (strncmp(line_buffer+offset, HFP_CONFIRM_COMMON_CODEC, strlen(HFP_CONFIRM_COMMON_CODEC)) == 0){
-        if (isHandsFree){
-            return HFP_CMD_AG_SUGGESTED_CODEC;
-        } else {
-            return HFP_CMD_HF_CONFIRMED_CODEC;
-        }
-    } 
-
     if (strncmp(line_buffer+offset, "AT+", 3) == 0){
         log_info("process unknown HF command %s \n", line_buffer);
         return HFP_CMD_UNKNOWN;
@@ -47,6 +47,10 @@
 
 #include "hci.h"
 #include "classic/sdp_client_rfcomm.h"
+#ifdef ENABLE_HFP_MSBC_PER_CONNECTION
+#include "classic/btstack_sbc.h"
+#include "classic/hfp_msbc.h"
+#endif
 
 #if defined __cplusplus
 extern "C" {
@@ -553,6 +557,13 @@ typedef struct hfp_connection {
     uint8_t suggested_codec;
     uint8_t codec_confirmed;
     uint8_t sco_for_msbc_failed;
+
+#ifdef ENABLE_HFP_MSBC_PER_CONNECTION
+    // mSBC encoder is initialized when mSBC audio connection is established,
+    // decoder needs to be initialized by application. Both are released with audio connection
+    hfp_msbc_encoder_t          msbc_encoder;
+    btstack_sbc_decoder_state_t msbc_decoder;
+#endif
     
     hfp_link_setttings_t link_setting;
 
@@ -59,59 +59,98 @@
 static const uint8_t msbc_header_h2_byte_0         = 1;
 static const uint8_t msbc_header_h2_byte_1_table[] = { 0x08, 0x38, 0xc8, 0xf8 };
 
-static btstack_sbc_encoder_state_t state;
-static int msbc_sequence_number;
+// used by API without encoder argument
+static hfp_msbc_encoder_t hfp_msbc_default_encoder;
 
-static uint8_t msbc_buffer[2*(MSBC_FRAME_SIZE + MSBC_EXTRA_SIZE)];
-static int msbc_buffer_offset = 0; 
-
-void hfp_msbc_init(void){
-    btstack_sbc_encoder_init(&state, SBC_MODE_mSBC, 16, 8, 0, 16000, 26, 0);
-    msbc_buffer_offset = 0;
-    msbc_sequence_number = 0;
+void hfp_msbc_encoder_init(hfp_msbc_encoder_t * msbc_encoder){
+    btstack_sbc_encoder_init(&msbc_encoder->sbc_encoder_state, SBC_MODE_mSBC, 16, 8, 0, 16000, 26, 0);
+    msbc_encoder->buffer_offset = 0;
+    msbc_encoder->sequence_number = 0;
 }
 
-int hfp_msbc_can_encode_audio_frame_now(void){
-    return (sizeof(msbc_buffer) - msbc_buffer_offset) >= (MSBC_FRAME_SIZE + MSBC_EXTRA_SIZE); 
+void hfp_msbc_encoder_deinit(hfp_msbc_encoder_t * msbc_encoder){
+    btstack_sbc_encoder_deinit(&msbc_encoder->sbc_encoder_state);
+    msbc_encoder->buffer_offset = 0;
 }
 
-void hfp_msbc_encode_audio_frame(int16_t * pcm_samples){
-    if (!hfp_msbc_can_encode_audio_frame_now()) return;
-
-    // Synchronization Header H2
-    msbc_buffer[msbc_buffer_offset++] = msbc_header_h2_byte_0;
-    msbc_buffer[msbc_buffer_offset++] = msbc_header_h2_byte_1_table[msbc_sequence_number];
-    msbc_sequence_number = (msbc_sequence_number + 1) & 3;
+int hfp_msbc_encoder_num_frames_can_encode_now(hfp_msbc_encoder_t * msbc_encoder){
+    return (sizeof(msbc_encoder->buffer) - msbc_encoder->buffer_offset) / (MSBC_FRAME_SIZE + MSBC_EXTRA_SIZE);
+}
 
-    // SBC Frame
-    btstack_sbc_encoder_process_data(pcm_samples);
-    (void)memcpy(msbc_buffer + msbc_buffer_offset,
-                 btstack_sbc_encoder_sbc_buffer(), MSBC_FRAME_SIZE);
-    msbc_buffer_offset += MSBC_FRAME_SIZE;
+int hfp_msbc_encoder_encode_audio_frames(hfp_msbc_encoder_t * msbc_encoder, int16_t * pcm_samples, int num_frames){
+    int num_frames_free = hfp_msbc_encoder_num_frames_can_encode_now(msbc_encoder);
+    if (num_frames > num_frames_free){
+        num_frames = num_frames_free;
+    }
 
-    // Final padding to use 60 bytes for 120 audio samples
-    msbc_buffer[msbc_buffer_offset++] = 0;
+    btstack_sbc_encoder_state_t * sbc_encoder_state = &msbc_encoder->sbc_encoder_state;
+    if (sbc_encoder_state->encoder_state == NULL){
+        log_error("mSBC encoder: call hfp_msbc_encoder_init first");
+        return 0;
+    }
+    int num_samples_per_frame = btstack_sbc_encoder_state_num_audio_frames(sbc_encoder_state);
+    uint8_t * sbc_buffer = btstack_sbc_encoder_state_sbc_buffer(sbc_encoder_state);
+    uint8_t * msbc_buffer = &msbc_encoder->buffer[msbc_encoder->buffer_offset];
+    int i;
+    for (i=0;i<num_frames;i++){
+        // Synchronization Header H2
+        *msbc_buffer++ = msbc_header_h2_byte_0;
+        *msbc_buffer++ = msbc_header_h2_byte_1_table[msbc_encoder->sequence_number];
+        msbc_encoder->sequence_number = (msbc_encoder->sequence_number + 1) & 3;
+
+        // SBC Frame
+        btstack_sbc_encoder_state_process_data(sbc_encoder_state, pcm_samples);
+        (void)memcpy(msbc_buffer, sbc_buffer, MSBC_FRAME_SIZE);
+        msbc_buffer += MSBC_FRAME_SIZE;
+        pcm_samples += num_samples_per_frame;
+
+        // Final padding to use 60 bytes for 120 audio samples
+        *msbc_buffer++ = 0;
+    }
+    msbc_encoder->buffer_offset += num_frames * (MSBC_FRAME_SIZE + MSBC_EXTRA_SIZE);
+    return num_frames;
 }
 
-void hfp_msbc_read_from_stream(uint8_t * buf, int size){
-    int bytes_to_copy = size;
-    if (size > msbc_buffer_offset){
-        bytes_to_copy = msbc_buffer_offset;
+void hfp_msbc_encoder_read_from_stream(hfp_msbc_encoder_t * msbc_encoder, uint8_t * buf, int size){
+    if (size > msbc_encoder->buffer_offset){
         log_error("sbc frame storage is smaller then the output buffer");
         return;
     }
 
-    (void)memcpy(buf, msbc_buffer, bytes_to_copy);
-    memmove(msbc_buffer, msbc_buffer + bytes_to_copy, sizeof(msbc_buffer) - bytes_to_copy);
-    msbc_buffer_offset -= bytes_to_copy;
+    (void)memcpy(buf, msbc_encoder->buffer, size);
+    memmove(msbc_encoder->buffer, msbc_encoder->buffer + size, msbc_encoder->buffer_offset - size);
+    msbc_encoder->buffer_offset -= size;
+}
+
+int hfp_msbc_encoder_num_bytes_in_stream(hfp_msbc_encoder_t * msbc_encoder){
+    return msbc_encoder->buffer_offset;
+}
+
+int hfp_msbc_encoder_num_audio_samples_per_frame(hfp_msbc_encoder_t * msbc_encoder){
+    return btstack_sbc_encoder_state_num_audio_frames(&msbc_encoder->sbc_encoder_state);
+}
+
+void hfp_msbc_init(void){
+    hfp_msbc_encoder_init(&hfp_msbc_default_encoder);
+}
+
+int hfp_msbc_can_encode_audio_frame_now(void){
+    return hfp_msbc_encoder_num_frames_can_encode_now(&hfp_msbc_default_encoder) > 0;
+}
+
+void hfp_msbc_encode_audio_frame(int16_t * pcm_samples){
+    (void) hfp_msbc_encoder_encode_audio_frames(&hfp_msbc_default_encoder, pcm_samples, 1);
+}
+
+void hfp_msbc_read_from_stream(uint8_t * buf, int size){
+    hfp_msbc_encoder_read_from_stream(&hfp_msbc_default_encoder, buf, size);
 }
 
 int hfp_msbc_num_bytes_in_stream(void){
-    return msbc_buffer_offset;
+    return hfp_msbc_default_encoder.buffer_offset;
 }
 
 int hfp_msbc_num_audio_samples_per_frame(void){
-    return btstack_sbc_encoder_num_audio_frames();
+    return hfp_msbc_encoder_num_audio_samples_per_frame(&hfp_msbc_default_encoder);
 }
 
-
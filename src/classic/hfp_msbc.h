@@ -48,14 +48,79 @@
 
 #include <stdint.h>
 
+#include "btstack_sbc.h"
+
 #if defined __cplusplus
 extern "C" {
 #endif
 
+// number of mSBC frames that can be buffered per encoder, i.e. max batch size
+#ifndef HFP_MSBC_ENCODER_NUM_FRAMES
+#define HFP_MSBC_ENCODER_NUM_FRAMES 2
+#endif
+
+// mSBC frame with H2 header and padding
+#define HFP_MSBC_ENCODED_FRAME_SIZE 60
+
+typedef struct {
+    // private
+    btstack_sbc_encoder_state_t sbc_encoder_state;
+    int      sequence_number;
+    uint8_t  buffer[HFP_MSBC_ENCODER_NUM_FRAMES * HFP_MSBC_ENCODED_FRAME_SIZE];
+    uint16_t buffer_offset;
+} hfp_msbc_encoder_t;
+
 /* API_START */
 
 /**
- *
+ * @brief Init mSBC encoder context, e.g. one per HFP connection
+ * @param msbc_encoder
+ */
+void hfp_msbc_encoder_init(hfp_msbc_encoder_t * msbc_encoder);
+
+/**
+ * @brief De-Init mSBC encoder context and release its SBC encoder
+ * @param msbc_encoder
+ */
+void hfp_msbc_encoder_deinit(hfp_msbc_encoder_t * msbc_encoder);
+
+/**
+ * @brief Get number of audio samples per mSBC frame
+ * @param msbc_encoder
+ */
+int  hfp_msbc_encoder_num_audio_samples_per_frame(hfp_msbc_encoder_t * msbc_encoder);
+
+/**
+ * @brief Get number of mSBC frames that can be encoded before the stream needs to be read
+ * @param msbc_encoder
+ */
+int  hfp_msbc_encoder_num_frames_can_encode_now(hfp_msbc_encoder_t * msbc_encoder);
+
+/**
+ * @brief Encode a batch of audio frames, e.g. all frames needed for the next SCO transmit interval
+ * @param msbc_encoder
+ * @param pcm_samples - num_frames consecutive audio frames of hfp_msbc_num_audio_samples_per_frame int16 samples
+ * @param num_frames
+ * @return number of frames encoded, limited by free space in stream buffer
+ */
+int  hfp_msbc_encoder_encode_audio_frames(hfp_msbc_encoder_t * msbc_encoder, int16_t * pcm_samples, int num_frames);
+
+/**
+ * @brief Get number of encoded bytes ready to be sent
+ * @param msbc_encoder
+ */
+int  hfp_msbc_encoder_num_bytes_in_stream(hfp_msbc_encoder_t * msbc_encoder);
+
+/**
+ * @brief Read encoded bytes from stream
+ * @param msbc_encoder
+ * @param buffer to store stream
+ * @param size num bytes to read from stream
+ */
+void hfp_msbc_encoder_read_from_stream(hfp_msbc_encoder_t * msbc_encoder, uint8_t * buffer, int size);
+
+/**
+ * @brief Init default mSBC encoder context used by functions below
  */
 void hfp_msbc_init(void);
 
@@ -145,9 +145,14 @@ typedef struct pbap_client {
     uint8_t  authentication_options;
     uint16_t authentication_nonce[16];
     const char * authentication_password;
-    /* xml parser */
+    /* xml parser, state is kept across OBEX packets */
     yxml_t  xml_parser;
     uint8_t xml_buffer[50];
+    uint8_t xml_card_found;
+    uint8_t xml_name_found;
+    uint8_t xml_handle_found;
+    char    xml_name[PBAP_MAX_NAME_LEN];
+    char    xml_handle[PBAP_MAX_HANDLE_LEN];
     /* flow control mode */
     uint8_t flow_control_enabled;
     uint8_t flow_next_triggered;
@@ -258,6 +263,16 @@ static void pbap_client_emit_card_result_event(pbap_client_t * context, const ch
 
 static const uint8_t collon = (uint8_t) ':';
 
+// request SRM for first GET request of an operation
+static void pbap_client_add_srm_header(pbap_client_t * context){
+    context->srm_state = SRM_DISABLED;
+    // SRM is only allowed over L2CAP. With flow control, each packet needs to be requested with a separate GET
+    if (context->flow_control_enabled) return;
+    if (!goep_client_version_20_or_higher(context->goep_cid)) return;
+    goep_client_header_add_srm_enable(context->goep_cid);
+    context->srm_state = SRM_W4_CONFIRM;
+}
+
 static void pbap_handle_can_send_now(void){
     uint8_t  path_element[20];
     uint16_t path_element_start;
@@ -324,10 +339,7 @@ static void pbap_handle_can_send_now(void){
         case PBAP_W2_GET_PHONEBOOK_SIZE:
             goep_client_request_create_get(pbap_client->goep_cid);
             if (pbap_client->request_number == 0){
-                if (!pbap_client->flow_control_enabled){
-                    goep_client_header_add_srm_enable(pbap_client->goep_cid);
-                    pbap_client->srm_state = SRM_W4_CONFIRM;
-                }
+                pbap_client_add_srm_header(pbap_client);
                 goep_client_header_add_name(pbap_client->goep_cid, pbap_client->phonebook_path);
                 goep_client_header_add_type(pbap_client->goep_cid, pbap_phonebook_type);
                 i = 0;
@@ -373,10 +385,11 @@ static void pbap_handle_can_send_now(void){
         case PBAP_W2_GET_CARD_LIST:
             goep_client_request_create_get(pbap_client->goep_cid);
             if (pbap_client->request_number == 0){
-                if (!pbap_client->flow_control_enabled){
-                    goep_client_header_add_srm_enable(pbap_client->goep_cid);
-                    pbap_client->srm_state = SRM_W4_CONFIRM;
-                }
+                pbap_client_add_srm_header(pbap_client);
+                yxml_init(&pbap_client->xml_parser, pbap_client->xml_buffer, sizeof(pbap_client->xml_buffer));
+                pbap_client->xml_card_found = 0;
+                pbap_client->xml_name_found = 0;
+                pbap_client->xml_handle_found = 0;
                 goep_client_header_add_name(pbap_client->goep_cid, pbap_client->phonebook_path);
                 goep_client_header_add_type(pbap_client->goep_cid, pbap_vcard_listing_type);
                 i = 0;
@@ -421,10 +434,7 @@ static void pbap_handle_can_send_now(void){
         case PBAP_W2_GET_CARD_ENTRY:
             goep_client_request_create_get(pbap_client->goep_cid);
             if (pbap_client->request_number == 0){
-                if (!pbap_client->flow_control_enabled){
-                    goep_client_header_add_srm_enable(pbap_client->goep_cid);
-                    pbap_client->srm_state = SRM_W4_CONFIRM;
-                }
+                pbap_client_add_srm_header(pbap_client);
                 goep_client_header_add_name(pbap_client->goep_cid, pbap_client->vcard_name);
                 goep_client_header_add_type(pbap_client->goep_cid, pbap_vcard_entry_type);
                 i = 0;
@@ -433,9 +443,9 @@ static void pbap_handle_can_send_now(void){
                     // TODO: support format
                     goep_client_header_add_application_parameters(pbap_client->goep_cid, &application_parameters[0], i);
                 }
-                pbap_client->state = PBAP_W4_GET_CARD_ENTRY_COMPLETE;
             }
             // send packet
+            pbap_client->state = PBAP_W4_GET_CARD_ENTRY_COMPLETE;
             pbap_client->request_number++;
             goep_client_execute(pbap_client->goep_cid);
             break;
@@ -585,55 +595,53 @@ static void pbap_client_process_vcard_listing(uint8_t *packet, uint16_t size){
             (hi == OBEX_HEADER_BODY)){
             uint16_t     data_len = obex_iterator_get_data_len(&it);
             const uint8_t  * data =  obex_iterator_get_data(&it);
-            // now try parsing it
-            yxml_init(&pbap_client->xml_parser, pbap_client->xml_buffer, sizeof(pbap_client->xml_buffer));
-            int card_found = 0;
-            int name_found = 0;
-            int handle_found = 0;
-            char name[PBAP_MAX_NAME_LEN];
-            char handle[PBAP_MAX_HANDLE_LEN];
+            // continue parsing, a card can be split across packets
             while (data_len--){
                 yxml_ret_t r = yxml_parse(&pbap_client->xml_parser, *data++);
                 switch (r){
                     case YXML_ELEMSTART:
-                        card_found = strcmp("card", pbap_client->xml_parser.elem) == 0;
+                        pbap_client->xml_card_found = strcmp("card", pbap_client->xml_parser.elem) == 0;
+                        if (pbap_client->xml_card_found){
+                            pbap_client->xml_name[0] = 0;
+                            pbap_client->xml_handle[0] = 0;
+                        }
                         break;
                     case YXML_ELEMEND:
-                        if (card_found){
-                            pbap_client_emit_card_result_event(pbap_client, name, handle);
+                        if (pbap_client->xml_card_found){
+                            pbap_client_emit_card_result_event(pbap_client, pbap_client->xml_name, pbap_client->xml_handle);
                         }
-                        card_found = 0;
+                        pbap_client->xml_card_found = 0;
                         break;
                     case YXML_ATTRSTART:
-                        if (!card_found) break;
+                        if (!pbap_client->xml_card_found) break;
                         if (strcmp("name", pbap_client->xml_parser.attr) == 0){
-                            name_found = 1;
-                            name[0]    = 0;
+                            pbap_client->xml_name_found = 1;
+                            pbap_client->xml_name[0]    = 0;
                             break;
                         }
                         if (strcmp("handle", pbap_client->xml_parser.attr) == 0){
-                            handle_found = 1;
-                            handle[0]    = 0;
+                            pbap_client->xml_handle_found = 1;
+                            pbap_client->xml_handle[0]    = 0;
                             break;
                         }
                         break;
                     case YXML_ATTRVAL:
-                        if (name_found) {
+                        if (pbap_client->xml_name_found) {
                             // "In UTF-8, characters from the U+0000..U+10FFFF range (the UTF-16 accessible range) are encoded using sequences of 1 to 4 octets."
-                            if ((strlen(name) + 4 + 1) >= sizeof(name)) break;
-                            strcat(name, pbap_client->xml_parser.data);
+                            if ((strlen(pbap_client->xml_name) + 4 + 1) >= sizeof(pbap_client->xml_name)) break;
+                            strcat(pbap_client->xml_name, pbap_client->xml_parser.data);
                             break;
                         }
-                        if (handle_found) {
+                        if (pbap_client->xml_handle_found) {
                             // "In UTF-8, characters from the U+0000..U+10FFFF range (the UTF-16 accessible range) are encoded using sequences of 1 to 4 octets."
-                            if ((strlen(handle) + 4 + 1) >= sizeof(handle)) break;
-                            strcat(handle, pbap_client->xml_parser.data);
+                            if ((strlen(pbap_client->xml_handle) + 4 + 1) >= sizeof(pbap_client->xml_handle)) break;
+                            strcat(pbap_client->xml_handle, pbap_client->xml_parser.data);
                             break;
                         }
                         break;
                     case YXML_ATTREND:
-                        name_found = 0;
-                        handle_found = 0;
+                        pbap_client->xml_name_found = 0;
+                        pbap_client->xml_handle_found = 0;
                         break;
                     default:
                         break;
@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "pbap_vcard_parser.c"
+
+// *****************************************************************************
+//
+// PBAP vCard Parser
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#include "classic/pbap_vcard_parser.h"
+
+typedef enum {
+    PBAP_VCARD_PARSER_STATE_LINE_START = 0,
+    PBAP_VCARD_PARSER_STATE_NAME,
+    PBAP_VCARD_PARSER_STATE_PARAMETERS,
+    PBAP_VCARD_PARSER_STATE_PARAMETERS_QUOTED,
+    PBAP_VCARD_PARSER_STATE_VALUE,
+    PBAP_VCARD_PARSER_STATE_VALUE_QP_EQUAL,
+    PBAP_VCARD_PARSER_STATE_VALUE_QP_SOFT_LINE_BREAK,
+    PBAP_VCARD_PARSER_STATE_LINE_END,
+} pbap_vcard_parser_state_t;
+
+// value is quoted-printable
+#define PBAP_VCARD_PARSER_FLAG_QUOTED_PRINTABLE 1
+// BEGIN or END property, value is collected in marker instead of being reported
+#define PBAP_VCARD_PARSER_FLAG_MARKER_BEGIN     2
+#define PBAP_VCARD_PARSER_FLAG_MARKER_END       4
+
+static char pbap_vcard_parser_to_upper(char c){
+    if ((c >= 'a') && (c <= 'z')){
+        return (char) (c - 'a' + 'A');
+    }
+    return c;
+}
+
+// case-insensitive search of upper case needle
+static int pbap_vcard_parser_contains(const char * haystack, const char * needle){
+    uint16_t needle_len = (uint16_t) strlen(needle);
+    uint16_t i;
+    for (i = 0; haystack[i] != 0; i++){
+        uint16_t j;
+        for (j = 0; j < needle_len; j++){
+            if (pbap_vcard_parser_to_upper(haystack[i + j]) != needle[j]) break;
+        }
+        if (j == needle_len) return 1;
+    }
+    return 0;
+}
+
+static void pbap_vcard_parser_start_line(pbap_vcard_parser_t * parser){
+    parser->flags = 0;
+    parser->name_len = 0;
+    parser->name[0] = 0;
+    parser->parameters_len = 0;
+    parser->parameters[0] = 0;
+    parser->marker_len = 0;
+    parser->marker[0] = 0;
+}
+
+static void pbap_vcard_parser_add_parameter(pbap_vcard_parser_t * parser, char c){
+    if (parser->parameters_len >= PBAP_VCARD_PARSER_MAX_PARAMETERS_LEN) return;
+    parser->parameters[parser->parameters_len++] = c;
+    parser->parameters[parser->parameters_len] = 0;
+}
+
+static pbap_vcard_parser_ret_t pbap_vcard_parser_start_value(pbap_vcard_parser_t * parser){
+    parser->state = PBAP_VCARD_PARSER_STATE_VALUE;
+    if (strcmp(parser->name, "BEGIN") == 0){
+        parser->flags |= PBAP_VCARD_PARSER_FLAG_MARKER_BEGIN;
+        return PBAP_VCARD_PARSER_OK;
+    }
+    if (strcmp(parser->name, "END") == 0){
+        parser->flags |= PBAP_VCARD_PARSER_FLAG_MARKER_END;
+        return PBAP_VCARD_PARSER_OK;
+    }
+    if (pbap_vcard_parser_contains(parser->parameters, "QUOTED-PRINTABLE")){
+        parser->flags |= PBAP_VCARD_PARSER_FLAG_QUOTED_PRINTABLE;
+    }
+    return PBAP_VCARD_PARSER_PROPERTY_START;
+}
+
+static pbap_vcard_parser_ret_t pbap_vcard_parser_value(pbap_vcard_parser_t * parser, char c){
+    if ((parser->flags & (PBAP_VCARD_PARSER_FLAG_MARKER_BEGIN | PBAP_VCARD_PARSER_FLAG_MARKER_END)) != 0){
+        if (parser->marker_len < (sizeof(parser->marker) - 1)){
+            parser->marker[parser->marker_len++] = pbap_vcard_parser_to_upper(c);
+            parser->marker[parser->marker_len] = 0;
+        }
+        return PBAP_VCARD_PARSER_OK;
+    }
+    parser->data[0] = c;
+    parser->data[1] = 0;
+    return PBAP_VCARD_PARSER_PROPERTY_VALUE;
+}
+
+static pbap_vcard_parser_ret_t pbap_vcard_parser_end_property(pbap_vcard_parser_t * parser){
+    parser->state = PBAP_VCARD_PARSER_STATE_LINE_START;
+    if (strcmp(parser->marker, "VCARD") == 0){
+        if ((parser->flags & PBAP_VCARD_PARSER_FLAG_MARKER_BEGIN) != 0) return PBAP_VCARD_PARSER_CARD_START;
+        if ((parser->flags & PBAP_VCARD_PARSER_FLAG_MARKER_END)   != 0) return PBAP_VCARD_PARSER_CARD_END;
+    }
+    if ((parser->flags & (PBAP_VCARD_PARSER_FLAG_MARKER_BEGIN | PBAP_VCARD_PARSER_FLAG_MARKER_END)) != 0){
+        return PBAP_VCARD_PARSER_OK;
+    }
+    return PBAP_VCARD_PARSER_PROPERTY_END;
+}
+
+void pbap_vcard_parser_init(pbap_vcard_parser_t * parser){
+    memset(parser, 0, sizeof(pbap_vcard_parser_t));
+    parser->state = PBAP_VCARD_PARSER_STATE_LINE_START;
+}
+
+pbap_vcard_parser_ret_t pbap_vcard_parser_parse(pbap_vcard_parser_t * parser, uint8_t byte){
+    char c = (char) byte;
+    pbap_vcard_parser_ret_t ret;
+    switch ((pbap_vcard_parser_state_t) parser->state){
+        case PBAP_VCARD_PARSER_STATE_LINE_START:
+            if ((c == '\r') || (c == '\n')) break;
+            pbap_vcard_parser_start_line(parser);
+            parser->state = PBAP_VCARD_PARSER_STATE_NAME;
+            /* fall through */
+        case PBAP_VCARD_PARSER_STATE_NAME:
+            switch (c){
+                case ':':
+                    return pbap_vcard_parser_start_value(parser);
+                case ';':
+                    parser->state = PBAP_VCARD_PARSER_STATE_PARAMETERS;
+                    break;
+                case '.':
+                    // drop group prefix
+                    parser->name_len = 0;
+                    parser->name[0] = 0;
+                    break;
+                case '\r':
+                    break;
+                case '\n':
+                    // line without value, ignore
+                    parser->state = PBAP_VCARD_PARSER_STATE_LINE_START;
+                    break;
+                default:
+                    if (parser->name_len >= PBAP_VCARD_PARSER_MAX_NAME_LEN) break;
+                    parser->name[parser->name_len++] = pbap_vcard_parser_to_upper(c);
+                    parser->name[parser->name_len] = 0;
+                    break;
+            }
+            break;
+        case PBAP_VCARD_PARSER_STATE_PARAMETERS:
+            switch (c){
+                case ':':
+                    return pbap_vcard_parser_start_value(parser);
+                case '"':
+                    parser->state = PBAP_VCARD_PARSER_STATE_PARAMETERS_QUOTED;
+                    pbap_vcard_parser_add_parameter(parser, c);
+                    break;
+                case '\r':
+                    break;
+                case '\n':
+                    parser->state = PBAP_VCARD_PARSER_STATE_LINE_START;
+                    break;
+                default:
+                    pbap_vcard_parser_add_parameter(parser, c);
+                    break;
+            }
+            break;
+        case PBAP_VCARD_PARSER_STATE_PARAMETERS_QUOTED:
+            switch (c){
+                case '"':
+                    parser->state = PBAP_VCARD_PARSER_STATE_PARAMETERS;
+                    pbap_vcard_parser_add_parameter(parser, c);
+                    break;
+                case '\r':
+                    break;
+                case '\n':
+                    parser->state = PBAP_VCARD_PARSER_STATE_LINE_START;
+                    break;
+                default:
+                    pbap_vcard_parser_add_parameter(parser, c);
+                    break;
+            }
+            break;
+        case PBAP_VCARD_PARSER_STATE_VALUE:
+            switch (c){
+                case '\r':
+                    break;
+                case '\n':
+                    parser->state = PBAP_VCARD_PARSER_STATE_LINE_END;
+                    break;
+                case '=':
+                    if ((parser->flags & PBAP_VCARD_PARSER_FLAG_QUOTED_PRINTABLE) != 0){
+                        parser->state = PBAP_VCARD_PARSER_STATE_VALUE_QP_EQUAL;
+                        break;
+                    }
+                    return pbap_vcard_parser_value(parser, c);
+                default:
+                    return pbap_vcard_parser_value(parser, c);
+            }
+            break;
+        case PBAP_VCARD_PARSER_STATE_VALUE_QP_EQUAL:
+            switch (c){
+                case '\r':
+                    parser->state = PBAP_VCARD_PARSER_STATE_VALUE_QP_SOFT_LINE_BREAK;
+                    break;
+                case '\n':
+                    parser->state = PBAP_VCARD_PARSER_STATE_VALUE;
+                    break;
+                case '=':
+                    // report previous '=', keep current one pending
+                    return pbap_vcard_parser_value(parser, '=');
+                default:
+                    parser->state = PBAP_VCARD_PARSER_STATE_VALUE;
+                    parser->data[0] = '=';
+                    parser->data[1] = c;
+                    parser->data[2] = 0;
+                    return PBAP_VCARD_PARSER_PROPERTY_VALUE;
+            }
+            break;
+        case PBAP_VCARD_PARSER_STATE_VALUE_QP_SOFT_LINE_BREAK:
+            parser->state = PBAP_VCARD_PARSER_STATE_VALUE;
+            if (c == '\n') break;
+            return pbap_vcard_parser_parse(parser, byte);
+        case PBAP_VCARD_PARSER_STATE_LINE_END:
+            if ((c == ' ') || (c == '\t')){
+                // folded line
+                parser->state = PBAP_VCARD_PARSER_STATE_VALUE;
+                break;
+            }
+            ret = pbap_vcard_parser_end_property(parser);
+            // first byte of a line does not complete a token
+            (void) pbap_vcard_parser_parse(parser, byte);
+            return ret;
+        default:
+            break;
+    }
+    return PBAP_VCARD_PARSER_OK;
+}
+
+pbap_vcard_parser_ret_t pbap_vcard_parser_eof(pbap_vcard_parser_t * parser){
+    switch ((pbap_vcard_parser_state_t) parser->state){
+        case PBAP_VCARD_PARSER_STATE_VALUE:
+        case PBAP_VCARD_PARSER_STATE_VALUE_QP_EQUAL:
+        case PBAP_VCARD_PARSER_STATE_VALUE_QP_SOFT_LINE_BREAK:
+        case PBAP_VCARD_PARSER_STATE_LINE_END:
+            return pbap_vcard_parser_end_property(parser);
+        default:
+            parser->state = PBAP_VCARD_PARSER_STATE_LINE_START;
+            return PBAP_VCARD_PARSER_OK;
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// *****************************************************************************
+//
+// PBAP vCard Parser
+//
+// Incremental vCard 2.1/3.0 tokenizer, fed one byte at a time with PBAP_DATA_PACKET
+// data, similar to yxml used for the vCard listing. The phonebook is not buffered:
+// property name and parameters are kept in fixed size buffers, values are returned
+// byte by byte. Folded lines are unfolded, quoted-printable soft line breaks are
+// removed, the value itself is not decoded.
+//
+// *****************************************************************************
+
+#ifndef PBAP_VCARD_PARSER_H
+#define PBAP_VCARD_PARSER_H
+
+#include "btstack_config.h"
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// max length of property name without group, longer names are truncated
+#ifndef PBAP_VCARD_PARSER_MAX_NAME_LEN
+#define PBAP_VCARD_PARSER_MAX_NAME_LEN 24
+#endif
+
+// max length of property parameters, longer parameters are truncated
+#ifndef PBAP_VCARD_PARSER_MAX_PARAMETERS_LEN
+#define PBAP_VCARD_PARSER_MAX_PARAMETERS_LEN 48
+#endif
+
+/* API_START */
+
+typedef enum {
+    PBAP_VCARD_PARSER_OK = 0,           // byte consumed, nothing to report
+    PBAP_VCARD_PARSER_CARD_START,       // BEGIN:VCARD
+    PBAP_VCARD_PARSER_CARD_END,         // END:VCARD
+    PBAP_VCARD_PARSER_PROPERTY_START,   // name and parameters of new property are available
+    PBAP_VCARD_PARSER_PROPERTY_VALUE,   // next byte(s) of property value are available in data
+    PBAP_VCARD_PARSER_PROPERTY_END,     // property value complete
+} pbap_vcard_parser_ret_t;
+
+typedef struct {
+    uint8_t state;
+    uint8_t flags;
+    uint8_t name_len;
+    uint8_t parameters_len;
+    uint8_t marker_len;
+    char    marker[6];
+    // property name in upper case without group prefix, e.g. "TEL"
+    char    name[PBAP_VCARD_PARSER_MAX_NAME_LEN + 1];
+    // property parameters without leading ';', e.g. "TYPE=CELL"
+    char    parameters[PBAP_VCARD_PARSER_MAX_PARAMETERS_LEN + 1];
+    // value data for PBAP_VCARD_PARSER_PROPERTY_VALUE, nul-terminated
+    char    data[3];
+} pbap_vcard_parser_t;
+
+/**
+ * @brief Init vCard parser, e.g. before pulling phonebook or vCard entry
+ * @param parser
+ */
+void pbap_vcard_parser_init(pbap_vcard_parser_t * parser);
+
+/**
+ * @brief Process next byte of vCard data
+ * @param parser
+ * @param c
+ * @return result, see pbap_vcard_parser_ret_t
+ */
+pbap_vcard_parser_ret_t pbap_vcard_parser_parse(pbap_vcard_parser_t * parser, uint8_t c);
+
+/**
+ * @brief Signal end of vCard data, completes last property if it was not terminated by a line break
+ * @param parser
+ * @return PBAP_VCARD_PARSER_PROPERTY_END, PBAP_VCARD_PARSER_CARD_END or PBAP_VCARD_PARSER_OK
+ */
+pbap_vcard_parser_ret_t pbap_vcard_parser_eof(pbap_vcard_parser_t * parser);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+#endif // PBAP_VCARD_PARSER_H
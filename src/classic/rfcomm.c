@@ -56,6 +56,7 @@
 #include "hci.h"
 #include "hci_cmd.h"
 #include "hci_dump.h"
+#include "btstack_trace.h"
 #include "l2cap.h"
 
 // workaround for missing PRIxPTR on mspgcc (16/20-bit MCU)
@@ -79,10 +80,60 @@
 #endif
 #endif
 
+// ENABLE_RFCOMM_HIGH_THROUGHPUT provides ERTM buffers from built-in pool and requires ERTM for RFCOMM
+#ifdef ENABLE_RFCOMM_HIGH_THROUGHPUT
+#ifndef RFCOMM_USE_ERTM
+#error "ENABLE_RFCOMM_HIGH_THROUGHPUT requires ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE_FOR_RFCOMM"
+#endif
+// L2CAP MTU for incoming SDUs, i.e. RFCOMM frames
+#ifndef RFCOMM_HIGH_THROUGHPUT_MTU
+#define RFCOMM_HIGH_THROUGHPUT_MTU 1691
+#endif
+// max size of single I-frame payload, 1010 lets I-frame with SDU length and FCS fit into a 3-DH5 packet
+#ifndef RFCOMM_HIGH_THROUGHPUT_MPS
+#define RFCOMM_HIGH_THROUGHPUT_MPS 1010
+#endif
+#ifndef RFCOMM_HIGH_THROUGHPUT_NUM_TX_BUFFERS
+#define RFCOMM_HIGH_THROUGHPUT_NUM_TX_BUFFERS 8
+#endif
+#ifndef RFCOMM_HIGH_THROUGHPUT_NUM_RX_BUFFERS
+#define RFCOMM_HIGH_THROUGHPUT_NUM_RX_BUFFERS 8
+#endif
+// number of multiplexers that can use ERTM at the same time
+#ifndef RFCOMM_HIGH_THROUGHPUT_NUM_MULTIPLEXERS
+#define RFCOMM_HIGH_THROUGHPUT_NUM_MULTIPLEXERS 1
+#endif
+// layout of l2cap_ertm_configure_channel: alignment, rx state, reassembly buffer, rx packets, tx state alignment, tx state, tx packets
+#define RFCOMM_HIGH_THROUGHPUT_BUFFER_SIZE (16 + 8 \
+    + (RFCOMM_HIGH_THROUGHPUT_NUM_RX_BUFFERS * sizeof(l2cap_ertm_rx_packet_state_t)) \
+    + (RFCOMM_HIGH_THROUGHPUT_NUM_TX_BUFFERS * sizeof(l2cap_ertm_tx_packet_state_t)) \
+    + RFCOMM_HIGH_THROUGHPUT_MTU \
+    + ((RFCOMM_HIGH_THROUGHPUT_NUM_RX_BUFFERS + RFCOMM_HIGH_THROUGHPUT_NUM_TX_BUFFERS) * RFCOMM_HIGH_THROUGHPUT_MPS))
+#endif
+
 #define RFCOMM_MULIPLEXER_TIMEOUT_MS 60000
 
 #define RFCOMM_CREDITS 10
 
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+#ifndef RFCOMM_CREDIT_WINDOW_MIN
+#define RFCOMM_CREDIT_WINDOW_MIN RFCOMM_CREDITS
+#endif
+#ifndef RFCOMM_CREDIT_WINDOW_MAX
+#define RFCOMM_CREDIT_WINDOW_MAX 64
+#endif
+#if RFCOMM_CREDIT_WINDOW_MAX > 255
+#error "RFCOMM_CREDIT_WINDOW_MAX must not exceed 255"
+#endif
+#if RFCOMM_CREDIT_WINDOW_MIN > RFCOMM_CREDIT_WINDOW_MAX
+#error "RFCOMM_CREDIT_WINDOW_MIN must not exceed RFCOMM_CREDIT_WINDOW_MAX"
+#endif
+// RTT samples above this are caused by a paused sender and ignored
+#define RFCOMM_CREDIT_RTT_MAX_MS 1000
+// min number of packets received before consumption rate is evaluated
+#define RFCOMM_CREDIT_RATE_MIN_PACKETS 4
+#endif
+
 // FCS calc 
 #define BT_RFCOMM_CODE_WORD         0xE0 // pol = x8+x2+x1+1
 #define BT_RFCOMM_CRC_CHECK_LEN     3
@@ -179,8 +230,28 @@ void (*rfcomm_ertm_released_callback)(uint16_t ertm_id);
 #endif
 
 #ifdef RFCOMM_USE_OUTGOING_BUFFER
+#if defined(ENABLE_RFCOMM_HIGH_THROUGHPUT) && (RFCOMM_HIGH_THROUGHPUT_MTU > 1030)
+static uint8_t outgoing_buffer[RFCOMM_HIGH_THROUGHPUT_MTU];
+#else
 static uint8_t outgoing_buffer[1030];
 #endif
+#endif
+
+#ifdef ENABLE_RFCOMM_HIGH_THROUGHPUT
+static l2cap_ertm_config_t rfcomm_high_throughput_ertm_config = {
+    0,       // ertm mandatory, fall back to basic mode if not supported by remote
+    8,       // max transmit
+    2000,    // retransmission timeout ms
+    12000,   // monitor timeout ms
+    RFCOMM_HIGH_THROUGHPUT_MTU,
+    RFCOMM_HIGH_THROUGHPUT_NUM_TX_BUFFERS,
+    RFCOMM_HIGH_THROUGHPUT_NUM_RX_BUFFERS,
+    0,       // no FCS, ACL already protected by CRC
+};
+static uint8_t  rfcomm_high_throughput_buffers[RFCOMM_HIGH_THROUGHPUT_NUM_MULTIPLEXERS][RFCOMM_HIGH_THROUGHPUT_BUFFER_SIZE];
+// ertm id of multiplexer using the buffer, 0 if free
+static uint16_t rfcomm_high_throughput_buffer_ertm_ids[RFCOMM_HIGH_THROUGHPUT_NUM_MULTIPLEXERS];
+#endif
 
 static int  rfcomm_channel_can_send(rfcomm_channel_t * channel);
 static int  rfcomm_channel_ready_for_open(rfcomm_channel_t *channel);
@@ -190,6 +261,9 @@ static void rfcomm_channel_state_machine_with_dlci(rfcomm_multiplexer_t * multip
 static void rfcomm_emit_can_send_now(rfcomm_channel_t *channel);
 static int rfcomm_multiplexer_ready_to_send(rfcomm_multiplexer_t * multiplexer);
 static void rfcomm_multiplexer_state_machine(rfcomm_multiplexer_t * multiplexer, RFCOMM_MULTIPLEXER_EVENT event);
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+static void rfcomm_channel_credit_window_init(rfcomm_channel_t * channel);
+#endif
 
 // MARK: RFCOMM CLIENT EVENTS
 
@@ -228,6 +302,30 @@ static rfcomm_multiplexer_t * rfcomm_multiplexer_for_ertm_id(uint16_t ertm_id) {
     return NULL;
 }
 
+#ifdef ENABLE_RFCOMM_HIGH_THROUGHPUT
+static void rfcomm_high_throughput_ertm_request_handler(rfcomm_ertm_request_t * request){
+    int i;
+    for (i = 0; i < RFCOMM_HIGH_THROUGHPUT_NUM_MULTIPLEXERS; i++){
+        if (rfcomm_high_throughput_buffer_ertm_ids[i] != 0) continue;
+        rfcomm_high_throughput_buffer_ertm_ids[i] = request->ertm_id;
+        request->ertm_config      = &rfcomm_high_throughput_ertm_config;
+        request->ertm_buffer      = rfcomm_high_throughput_buffers[i];
+        request->ertm_buffer_size = RFCOMM_HIGH_THROUGHPUT_BUFFER_SIZE;
+        return;
+    }
+    log_info("no ERTM buffer available for ertm id %u, use basic mode", request->ertm_id);
+}
+
+static void rfcomm_high_throughput_ertm_released_handler(uint16_t ertm_id){
+    int i;
+    for (i = 0; i < RFCOMM_HIGH_THROUGHPUT_NUM_MULTIPLEXERS; i++){
+        if (rfcomm_high_throughput_buffer_ertm_ids[i] == ertm_id){
+            rfcomm_high_throughput_buffer_ertm_ids[i] = 0;
+        }
+    }
+}
+#endif
+
 static uint16_t rfcomm_next_ertm_id(void){
     do {
         if (rfcomm_ertm_id == 0xffff) {
@@ -385,7 +483,12 @@ static void rfcomm_multiplexer_initialize(rfcomm_multiplexer_t *multiplexer){
     multiplexer->state = RFCOMM_MULTIPLEXER_CLOSED;
     multiplexer->fcon = 1;
     multiplexer->send_dm_for_dlci = 0;
+#ifdef ENABLE_RFCOMM_HIGH_THROUGHPUT
+    // upper bound until L2CAP channel is open, allows new channels to offer large frames in PN
+    multiplexer->max_frame_size = rfcomm_max_frame_size_for_l2cap_mtu(btstack_max(l2cap_max_mtu(), RFCOMM_HIGH_THROUGHPUT_MTU));
+#else
     multiplexer->max_frame_size = rfcomm_max_frame_size_for_l2cap_mtu(l2cap_max_mtu());
+#endif
     multiplexer->test_data_len = 0;
     multiplexer->nsc_command = 0;
 }
@@ -489,6 +592,9 @@ static void rfcomm_channel_initialize(rfcomm_channel_t *channel, rfcomm_multiple
 		// outgoing connection
 		channel->dlci = (server_channel << 1) | (multiplexer->outgoing ^ 1);
 	}
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+    rfcomm_channel_credit_window_init(channel);
+#endif
 }
 
 // service == NULL -> outgoing channel
@@ -554,6 +660,8 @@ static rfcomm_service_t * rfcomm_service_for_channel(uint8_t server_channel){
 static int rfcomm_send_packet_for_multiplexer(rfcomm_multiplexer_t *multiplexer, uint8_t address, uint8_t control, uint8_t credits, uint8_t *data, uint16_t len){
 
     if (!l2cap_can_send_packet_now(multiplexer->l2cap_cid)) return BTSTACK_ACL_BUFFERS_FULL;
+
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_RFCOMM_TX, multiplexer->l2cap_cid, len);
     
 #ifdef RFCOMM_USE_OUTGOING_BUFFER
     uint8_t * rfcomm_out_buffer = outgoing_buffer;
@@ -609,6 +717,8 @@ static int rfcomm_send_uih_prepared(rfcomm_multiplexer_t *multiplexer, uint8_t d
     uint8_t address = (1 << 0) | (multiplexer->outgoing << 1) | (dlci << 2); 
     uint8_t control = BT_RFCOMM_UIH;
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_RFCOMM_TX, multiplexer->l2cap_cid, len);
+
 #ifdef RFCOMM_USE_OUTGOING_BUFFER
     uint8_t * rfcomm_out_buffer = outgoing_buffer;
 #else
@@ -1140,6 +1250,17 @@ static int rfcomm_hci_event_handler(uint8_t *packet, uint16_t size){
 
             // set max frame size based on l2cap MTU
             multiplexer->max_frame_size = rfcomm_max_frame_size_for_l2cap_mtu(little_endian_read_16(packet, 17));
+#ifdef ENABLE_RFCOMM_HIGH_THROUGHPUT
+            {
+                // frames are also received, limit by local MTU, by ACL reassembly in basic mode, and by outgoing buffer
+                uint16_t l2cap_mtu = btstack_min(l2cap_event_channel_opened_get_remote_mtu(packet), l2cap_event_channel_opened_get_local_mtu(packet));
+                if (l2cap_event_channel_opened_get_mode(packet) != L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+                    l2cap_mtu = btstack_min(l2cap_mtu, l2cap_max_mtu());
+                }
+                l2cap_mtu = btstack_min(l2cap_mtu, sizeof(outgoing_buffer));
+                multiplexer->max_frame_size = rfcomm_max_frame_size_for_l2cap_mtu(l2cap_mtu);
+            }
+#endif
 
             if (multiplexer->state == RFCOMM_MULTIPLEXER_W4_CONNECT) {
                 log_info("L2CAP_EVENT_CHANNEL_OPENED: outgoing connection");
@@ -1382,10 +1503,105 @@ static void rfcomm_multiplexer_state_machine(rfcomm_multiplexer_t * multiplexer,
 // MARK: RFCOMM CHANNEL
 
 static void rfcomm_channel_send_credits(rfcomm_channel_t *channel, uint8_t credits){
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+    // remote stalled without credits: next packet arrives one round trip after this grant
+    if ((channel->credits_incoming == 0) && (channel->credit_packets_received > 0)){
+        channel->credit_rtt_pending   = 1;
+        channel->credit_grant_time_ms = btstack_run_loop_get_time_ms();
+    }
+#endif
     channel->credits_incoming += credits;
     rfcomm_send_uih_credits(channel->multiplexer, channel->dlci, credits);
 }
 
+#ifdef ENABLE_RFCOMM_RECEIVE_BUFFERS
+static void rfcomm_channel_deliver_to_receive_buffer(rfcomm_channel_t * channel, const uint8_t * data, uint16_t len){
+    uint8_t   index  = channel->receive_buffers_head;
+    uint8_t * buffer = channel->receive_buffers[index];
+    if (len > channel->receive_buffer_sizes[index]){
+        // keep buffer for next packet and return the credit used by the remote
+        log_error("RFCOMM #%u: packet of %u bytes exceeds receive buffer, dropped", channel->dlci, len);
+        channel->new_credits_incoming++;
+        l2cap_request_can_send_now_event(channel->multiplexer->l2cap_cid);
+        return;
+    }
+    // buffer belongs to application until it is provided again
+    channel->receive_buffers_head = (index + 1u) % RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL;
+    channel->receive_buffers_count--;
+    (void) memcpy(buffer, data, len);
+    (channel->packet_handler)(RFCOMM_DATA_PACKET, channel->rfcomm_cid, buffer, len);
+}
+#endif
+
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+static void rfcomm_channel_credit_window_init(rfcomm_channel_t * channel){
+    uint16_t window = channel->new_credits_incoming;
+    if (window < RFCOMM_CREDIT_WINDOW_MIN) {
+        window = RFCOMM_CREDIT_WINDOW_MIN;
+    }
+    if (window > RFCOMM_CREDIT_WINDOW_MAX) {
+        window = RFCOMM_CREDIT_WINDOW_MAX;
+    }
+    channel->credit_window           = (uint8_t) window;
+    channel->credit_rtt_pending      = 0;
+    channel->credit_srtt_ms          = 0;
+    channel->credit_packets_received = 0;
+    channel->credit_rate_start_ms    = btstack_run_loop_get_time_ms();
+}
+
+static void rfcomm_channel_credit_window_received_packet(rfcomm_channel_t * channel){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    if (channel->credit_rtt_pending){
+        channel->credit_rtt_pending = 0;
+        uint32_t sample = now - channel->credit_grant_time_ms;
+        if (sample <= RFCOMM_CREDIT_RTT_MAX_MS){
+            if (channel->credit_srtt_ms == 0){
+                channel->credit_srtt_ms = (uint16_t) sample;
+            } else {
+                // srtt = 7/8 srtt + 1/8 sample
+                channel->credit_srtt_ms = (uint16_t) (((7u * channel->credit_srtt_ms) + sample) / 8u);
+            }
+        }
+    }
+    if (channel->credit_packets_received < 0xffffu){
+        channel->credit_packets_received++;
+    }
+    // remote used all credits and has to wait for next grant: window too small
+    if (channel->credits_incoming == 0){
+        uint16_t window = channel->credit_window * 2u;
+        channel->credit_window = (window > RFCOMM_CREDIT_WINDOW_MAX) ? RFCOMM_CREDIT_WINDOW_MAX : (uint8_t) window;
+    }
+}
+
+// returns number of credits to grant in one batch, or 0 if remote still has enough credits
+static uint8_t rfcomm_channel_credit_window_update(rfcomm_channel_t * channel){
+    if (channel->credits_incoming > (channel->credit_window / 2u)) return 0;
+
+    // credits needed to cover one round trip at current consumption rate, twice for margin
+    uint32_t now     = btstack_run_loop_get_time_ms();
+    uint32_t elapsed = now - channel->credit_rate_start_ms;
+    if ((channel->credit_srtt_ms > 0) && (elapsed > 0) && (channel->credit_packets_received >= RFCOMM_CREDIT_RATE_MIN_PACKETS)){
+        uint32_t target = (2u * channel->credit_packets_received * channel->credit_srtt_ms) / elapsed;
+        if (target > RFCOMM_CREDIT_WINDOW_MAX){
+            target = RFCOMM_CREDIT_WINDOW_MAX;
+        }
+        if (target > channel->credit_window){
+            channel->credit_window = (uint8_t) target;
+        } else {
+            // shrink slowly, starvation doubles window again
+            uint32_t window = (channel->credit_window + target) / 2u;
+            channel->credit_window = (window < RFCOMM_CREDIT_WINDOW_MIN) ? RFCOMM_CREDIT_WINDOW_MIN : (uint8_t) window;
+        }
+        log_debug("RFCOMM #%u: srtt %u ms, %u packets in %u ms -> credit window %u", channel->dlci, channel->credit_srtt_ms,
+                  channel->credit_packets_received, (unsigned int) elapsed, channel->credit_window);
+    }
+    channel->credit_packets_received = 0;
+    channel->credit_rate_start_ms    = now;
+
+    return channel->credit_window - channel->credits_incoming;
+}
+#endif
+
 static int rfcomm_channel_can_send(rfcomm_channel_t * channel){
     if (!channel->credits_outgoing) return 0;
     if ((channel->multiplexer->fcon & 1) == 0) return 0;
@@ -1454,17 +1670,39 @@ static void rfcomm_channel_packet_handler_uih(rfcomm_multiplexer_t *multiplexer,
         if (channel->credits_incoming > 0){
             channel->credits_incoming--;
         }
-        
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+        if (!channel->incoming_flow_control){
+            rfcomm_channel_credit_window_received_packet(channel);
+        }
+#endif
+
         // deliver payload
-        (channel->packet_handler)(RFCOMM_DATA_PACKET, channel->rfcomm_cid,
-                              &packet[payload_offset], size-payload_offset-1);
+#ifdef ENABLE_RFCOMM_RECEIVE_BUFFERS
+        if (channel->receive_buffers_count > 0){
+            rfcomm_channel_deliver_to_receive_buffer(channel, &packet[payload_offset], size-payload_offset-1);
+        } else
+#endif
+        {
+            (channel->packet_handler)(RFCOMM_DATA_PACKET, channel->rfcomm_cid,
+                                      &packet[payload_offset], size-payload_offset-1);
+        }
     }
     
     // automatically provide new credits to remote device, if no incoming flow control
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+    if (!channel->incoming_flow_control && (channel->new_credits_incoming == 0)){
+        uint8_t credits = rfcomm_channel_credit_window_update(channel);
+        if (credits > 0){
+            channel->new_credits_incoming = credits;
+            request_can_send_now = 1;
+        }
+    }
+#else
     if (!channel->incoming_flow_control && (channel->credits_incoming < 5)){
         channel->new_credits_incoming = RFCOMM_CREDITS;
         request_can_send_now = 1;
     }    
+#endif
 
     if (request_can_send_now){
         l2cap_request_can_send_now_event(multiplexer->l2cap_cid);
@@ -1726,6 +1964,8 @@ static void rfcomm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t
     // we only handle l2cap packets for:
     if (packet_type != L2CAP_DATA_PACKET) return;
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_RFCOMM_RX, channel, size);
+
     //  - multiplexer itself
     int handled = rfcomm_multiplexer_l2cap_packet_handler(channel, packet, size);
 
@@ -2187,6 +2427,11 @@ void rfcomm_init(void){
     rfcomm_services     = NULL;
     rfcomm_channels     = NULL;
     rfcomm_security_level = gap_get_security_level();
+#ifdef ENABLE_RFCOMM_HIGH_THROUGHPUT
+    memset(rfcomm_high_throughput_buffer_ertm_ids, 0, sizeof(rfcomm_high_throughput_buffer_ertm_ids));
+    rfcomm_ertm_request_callback  = &rfcomm_high_throughput_ertm_request_handler;
+    rfcomm_ertm_released_callback = &rfcomm_high_throughput_ertm_released_handler;
+#endif
 }
 
 void rfcomm_set_required_security_level(gap_security_level_t security_level){
@@ -2435,6 +2680,9 @@ static uint8_t rfcomm_channel_create_internal(btstack_packet_handler_t packet_ha
     channel->incoming_flow_control = incoming_flow_control;
     channel->new_credits_incoming  = initial_credits;
     channel->packet_handler = packet_handler;
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+    rfcomm_channel_credit_window_init(channel);
+#endif
     
     // return rfcomm_cid
     if (out_rfcomm_cid){
@@ -2465,6 +2713,13 @@ static uint8_t rfcomm_channel_create_internal(btstack_packet_handler_t packet_ha
             status = l2cap_create_channel(rfcomm_packet_handler, addr, BLUETOOTH_PROTOCOL_RFCOMM, l2cap_max_mtu(), &l2cap_cid);
         }
         if (status) {
+#ifdef RFCOMM_USE_ERTM
+            // ERTM buffer was not used
+            if (multiplexer->ertm_id && rfcomm_ertm_released_callback){
+                (*rfcomm_ertm_released_callback)(multiplexer->ertm_id);
+                multiplexer->ertm_id = 0;
+            }
+#endif
             if (new_multiplexer) btstack_memory_rfcomm_multiplexer_free(multiplexer);
             btstack_memory_rfcomm_channel_free(channel);
             return status;
@@ -2608,6 +2863,24 @@ void rfcomm_grant_credits(uint16_t rfcomm_cid, uint8_t credits){
     l2cap_request_can_send_now_event(channel->multiplexer->l2cap_cid);
 }
 
+#ifdef ENABLE_RFCOMM_RECEIVE_BUFFERS
+uint8_t rfcomm_provide_receive_buffer(uint16_t rfcomm_cid, uint8_t * buffer, uint16_t size){
+    rfcomm_channel_t * channel = rfcomm_channel_for_rfcomm_cid(rfcomm_cid);
+    if (!channel) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (!channel->incoming_flow_control) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (channel->receive_buffers_count >= RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    uint8_t index = (channel->receive_buffers_head + channel->receive_buffers_count) % RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL;
+    channel->receive_buffers[index]      = buffer;
+    channel->receive_buffer_sizes[index] = size;
+    channel->receive_buffers_count++;
+
+    // one credit per buffer
+    rfcomm_grant_credits(rfcomm_cid, 1);
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 #ifdef RFCOMM_USE_ERTM
 void rfcomm_enable_l2cap_ertm(void request_callback(rfcomm_ertm_request_t * request), void released_callback(uint16_t ertm_id)){
     rfcomm_ertm_request_callback  = request_callback;
@@ -59,6 +59,12 @@ extern "C" {
 
 #define RFCOMM_RLS_STATUS_INVALID 0xff
 
+#ifdef ENABLE_RFCOMM_RECEIVE_BUFFERS
+#ifndef RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL
+#define RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL 4
+#endif
+#endif
+
 
 // private structs
 typedef enum {
@@ -246,6 +252,31 @@ typedef struct {
 
     //
     uint8_t   waiting_for_can_send_now;
+
+#ifdef ENABLE_RFCOMM_RECEIVE_BUFFERS
+    // ring of application buffers for incoming packets, each one backed by one credit
+    uint8_t * receive_buffers[RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL];
+    uint16_t  receive_buffer_sizes[RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL];
+    uint8_t   receive_buffers_head;
+    uint8_t   receive_buffers_count;
+#endif
+
+#ifdef ENABLE_RFCOMM_CREDIT_AUTO_TUNING
+    // credits the remote may have outstanding, adapted to round trip time and consumption rate
+    uint8_t   credit_window;
+
+    // credit grant sent while remote was out of credits, next packet provides RTT sample
+    uint8_t   credit_rtt_pending;
+
+    // smoothed round trip time between credit grant and first packet using it
+    uint16_t  credit_srtt_ms;
+
+    // packets received since credit_rate_start_ms
+    uint16_t  credit_packets_received;
+    uint32_t  credit_rate_start_ms;
+
+    uint32_t  credit_grant_time_ms;
+#endif
         
 } rfcomm_channel_t;
 
@@ -343,6 +374,21 @@ void rfcomm_decline_connection(uint16_t rfcomm_cid);
  */
 void rfcomm_grant_credits(uint16_t rfcomm_cid, uint8_t credits);
 
+#ifdef ENABLE_RFCOMM_RECEIVE_BUFFERS
+/**
+ * @brief Provide application buffer for the next incoming packet on a channel with manual credits and grant one credit for it.
+ * @note The RFCOMM_DATA_PACKET for an incoming packet points into the oldest provided buffer. The buffer belongs to the
+ *       application until it is provided again, which also returns the credit. Without provided buffers, packets are
+ *       delivered from the stack buffer as usual.
+ * @param rfcomm_cid
+ * @param buffer
+ * @param size of buffer, should be at least the max frame size of the channel
+ * @return status ERROR_CODE_SUCCESS, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, ERROR_CODE_COMMAND_DISALLOWED if channel
+ *         uses automatic credits, or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if RFCOMM_RECEIVE_BUFFERS_PER_CHANNEL are queued
+ */
+uint8_t rfcomm_provide_receive_buffer(uint16_t rfcomm_cid, uint8_t * buffer, uint16_t size);
+#endif
+
 /** 
  * @brief Checks if RFCOMM can send packet. 
  * @param rfcomm_cid
@@ -53,6 +53,10 @@
 #include "hci_cmd.h"
 #include "l2cap.h"
 
+
+// service search patterns up to this size are copied, e.g. patterns created by sdp_service_search_pattern_for_uuid128
+#define SDP_CLIENT_SERVICE_SEARCH_PATTERN_STORAGE_SIZE 19
+
 // Types SDP Parser - Data Element stream helper
 typedef enum { 
     GET_LIST_LENGTH = 1,
@@ -68,6 +72,40 @@ typedef enum {
     INIT, W4_CONNECT, W2_SEND, W4_RESPONSE, QUERY_COMPLETE
 } sdp_client_state_t;
 
+typedef struct {
+    // State DES Parser
+    de_state_t de_header_state;
+
+    // State SDP Parser
+    sdp_parser_state_t  state;
+    uint16_t attribute_id;
+    uint16_t attribute_bytes_received;
+    uint16_t attribute_bytes_delivered;
+    uint16_t list_offset;
+    uint16_t list_size;
+    uint16_t record_offset;
+    uint16_t record_size;
+    uint16_t attribute_value_size;
+    int record_counter;
+    btstack_packet_handler_t sdp_parser_callback;
+
+    // State SDP Client
+    bd_addr_t remote;
+    uint16_t  mtu;
+    uint16_t  sdp_cid;
+    const uint8_t * service_search_pattern;
+    const uint8_t * attribute_id_list;
+    uint8_t   service_search_pattern_storage[SDP_CLIENT_SERVICE_SEARCH_PATTERN_STORAGE_SIZE];
+    uint16_t  transactionID;
+    uint8_t   continuationState[16];
+    uint8_t   continuationStateLen;
+    sdp_client_state_t sdp_client_state;
+    SDP_PDU_ID_t PDU_ID;
+#ifdef ENABLE_SDP_EXTRA_QUERIES
+    uint32_t serviceRecordHandle;
+    uint32_t record_handle;
+#endif
+} sdp_client_context_t;
 
 // Prototypes SDP Parser
 void sdp_parser_init(btstack_packet_handler_t callback);
@@ -80,46 +118,18 @@ void sdp_parser_handle_service_search(uint8_t * data, uint16_t total_count, uint
 // Prototypes SDP Client
 void sdp_client_reset(void);
 void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
-static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data);
+static uint16_t sdp_client_setup_service_search_attribute_request(sdp_client_context_t * context, uint8_t * data);
 #ifdef ENABLE_SDP_EXTRA_QUERIES
-static uint16_t sdp_client_setup_service_search_request(uint8_t * data);
-static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data);
-static void     sdp_client_parse_service_search_response(uint8_t* packet, uint16_t size);
-static void     sdp_client_parse_service_attribute_response(uint8_t* packet, uint16_t size);
+static uint16_t sdp_client_setup_service_search_request(sdp_client_context_t * context, uint8_t * data);
+static uint16_t sdp_client_setup_service_attribute_request(sdp_client_context_t * context, uint8_t * data);
+static void     sdp_client_parse_service_search_response(sdp_client_context_t * context, uint8_t* packet, uint16_t size);
+static void     sdp_client_parse_service_attribute_response(sdp_client_context_t * context, uint8_t* packet, uint16_t size);
 #endif
 
 static uint8_t des_attributeIDList[] = { 0x35, 0x05, 0x0A, 0x00, 0x00, 0xff, 0xff};  // Attribute: 0x0000 - 0xffff
 
-// State DES Parser
-static de_state_t de_header_state;
-
-// State SDP Parser
-static sdp_parser_state_t  state = GET_LIST_LENGTH;
-static uint16_t attribute_id = 0;
-static uint16_t attribute_bytes_received = 0;
-static uint16_t attribute_bytes_delivered = 0;
-static uint16_t list_offset = 0;
-static uint16_t list_size;
-static uint16_t record_offset = 0;
-static uint16_t record_size;
-static uint16_t attribute_value_size;
-static int record_counter = 0;
-static btstack_packet_handler_t sdp_parser_callback;
-
-// State SDP Client
-static uint16_t  mtu;
-static uint16_t  sdp_cid = 0x40;
-static const uint8_t * service_search_pattern;
-static const uint8_t * attribute_id_list;
-static uint16_t  transactionID = 0;
-static uint8_t   continuationState[16];
-static uint8_t   continuationStateLen;
-static sdp_client_state_t sdp_client_state = INIT;
-static SDP_PDU_ID_t PDU_ID = SDP_Invalid;
-#ifdef ENABLE_SDP_EXTRA_QUERIES
-static uint32_t serviceRecordHandle;
-static uint32_t record_handle;
-#endif
+static sdp_client_context_t sdp_client_contexts[SDP_CLIENT_MAX_CONCURRENT_QUERIES];
+static uint16_t sdp_client_transaction_id = 0;
 
 // DES Parser
 void de_state_init(de_state_t * de_state){
@@ -158,101 +168,101 @@ int de_state_size(uint8_t eventByte, de_state_t *de_state){
 }
 
 // SDP Parser
-static void sdp_parser_emit_value_byte(uint8_t event_byte){
+static void sdp_parser_emit_value_byte(sdp_client_context_t * context, uint8_t event_byte){
     uint8_t event[11];
     event[0] = SDP_EVENT_QUERY_ATTRIBUTE_VALUE;
     event[1] = 9;
-    little_endian_store_16(event, 2, record_counter);
-    little_endian_store_16(event, 4, attribute_id);
-    little_endian_store_16(event, 6, attribute_value_size);
-    little_endian_store_16(event, 8, attribute_bytes_delivered);
+    little_endian_store_16(event, 2, context->record_counter);
+    little_endian_store_16(event, 4, context->attribute_id);
+    little_endian_store_16(event, 6, context->attribute_value_size);
+    little_endian_store_16(event, 8, context->attribute_bytes_delivered);
     event[10] = event_byte;
-    (*sdp_parser_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
+    (*context->sdp_parser_callback)(HCI_EVENT_PACKET, context->sdp_cid, event, sizeof(event));
 }
 
-static void sdp_parser_process_byte(uint8_t eventByte){
+static void sdp_parser_process_byte(sdp_client_context_t * context, uint8_t eventByte){
     // count all bytes
-    list_offset++;
-    record_offset++;
+    context->list_offset++;
+    context->record_offset++;
 
     // log_info(" parse BYTE_RECEIVED %02x", eventByte);
-    switch(state){
+    switch(context->state){
         case GET_LIST_LENGTH:
-            if (!de_state_size(eventByte, &de_header_state)) break;
-            list_offset = de_header_state.de_offset;
-            list_size = de_header_state.de_size;
+            if (!de_state_size(eventByte, &context->de_header_state)) break;
+            context->list_offset = context->de_header_state.de_offset;
+            context->list_size = context->de_header_state.de_size;
             // log_info("parser: List offset %u, list size %u", list_offset, list_size);
             
-            record_counter = 0;
-            state = GET_RECORD_LENGTH;
+            context->record_counter = 0;
+            context->state = GET_RECORD_LENGTH;
             break;
 
         case GET_RECORD_LENGTH:
             // check size
-            if (!de_state_size(eventByte, &de_header_state)) break;
+            if (!de_state_size(eventByte, &context->de_header_state)) break;
             // log_info("parser: Record payload is %d bytes.", de_header_state.de_size);
-            record_offset = de_header_state.de_offset;
-            record_size = de_header_state.de_size;
-            state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
+            context->record_offset = context->de_header_state.de_offset;
+            context->record_size = context->de_header_state.de_size;
+            context->state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
             break;
 
         case GET_ATTRIBUTE_ID_HEADER_LENGTH:
-            if (!de_state_size(eventByte, &de_header_state)) break;
-            attribute_id = 0;
-            log_debug("ID data is stored in %d bytes.", (int) de_header_state.de_size);
-            state = GET_ATTRIBUTE_ID;
+            if (!de_state_size(eventByte, &context->de_header_state)) break;
+            context->attribute_id = 0;
+            log_debug("ID data is stored in %d bytes.", (int) context->de_header_state.de_size);
+            context->state = GET_ATTRIBUTE_ID;
             break;
         
         case GET_ATTRIBUTE_ID:
-            attribute_id = (attribute_id << 8) | eventByte;
-            de_header_state.de_size--;
-            if (de_header_state.de_size > 0) break;
-            log_debug("parser: Attribute ID: %04x.", attribute_id);
-
-            state = GET_ATTRIBUTE_VALUE_LENGTH;
-            attribute_bytes_received  = 0;
-            attribute_bytes_delivered = 0;
-            attribute_value_size      = 0;
-            de_state_init(&de_header_state);
+            context->attribute_id = (context->attribute_id << 8) | eventByte;
+            context->de_header_state.de_size--;
+            if (context->de_header_state.de_size > 0) break;
+            log_debug("parser: Attribute ID: %04x.", context->attribute_id);
+
+            context->state = GET_ATTRIBUTE_VALUE_LENGTH;
+            context->attribute_bytes_received  = 0;
+            context->attribute_bytes_delivered = 0;
+            context->attribute_value_size      = 0;
+            de_state_init(&context->de_header_state);
             break;
         
         case GET_ATTRIBUTE_VALUE_LENGTH:
-            attribute_bytes_received++;
-            sdp_parser_emit_value_byte(eventByte);
-            attribute_bytes_delivered++;
-            if (!de_state_size(eventByte, &de_header_state)) break;
+            context->attribute_bytes_received++;
+            sdp_parser_emit_value_byte(context, eventByte);
+            context->attribute_bytes_delivered++;
+            if (!de_state_size(eventByte, &context->de_header_state)) break;
 
-            attribute_value_size = de_header_state.de_size + attribute_bytes_received;
+            context->attribute_value_size = context->de_header_state.de_size + context->attribute_bytes_received;
 
-            state = GET_ATTRIBUTE_VALUE;
+            context->state = GET_ATTRIBUTE_VALUE;
             break;
         
         case GET_ATTRIBUTE_VALUE: 
-            attribute_bytes_received++;
-            sdp_parser_emit_value_byte(eventByte);
-            attribute_bytes_delivered++;
+            context->attribute_bytes_received++;
+            sdp_parser_emit_value_byte(context, eventByte);
+            context->attribute_bytes_delivered++;
             // log_debug("paser: attribute_bytes_received %u, attribute_value_size %u", attribute_bytes_received, attribute_value_size);
 
-            if (attribute_bytes_received < attribute_value_size) break;
+            if (context->attribute_bytes_received < context->attribute_value_size) break;
             // log_debug("parser: Record offset %u, record size %u", record_offset, record_size);
-            if (record_offset != record_size){
-                state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
+            if (context->record_offset != context->record_size){
+                context->state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
                 // log_debug("Get next attribute");
                 break;
             } 
-            record_offset = 0;
+            context->record_offset = 0;
             // log_debug("parser: List offset %u, list size %u", list_offset, list_size);
             
-            if ((list_size > 0) && (list_offset != list_size)){
-                record_counter++;
-                state = GET_RECORD_LENGTH;
+            if ((context->list_size > 0) && (context->list_offset != context->list_size)){
+                context->record_counter++;
+                context->state = GET_RECORD_LENGTH;
                 log_debug("parser: END_OF_RECORD");
                 break;
             }
-            list_offset = 0;
-            de_state_init(&de_header_state);
-            state = GET_LIST_LENGTH;
-            record_counter = 0;
+            context->list_offset = 0;
+            de_state_init(&context->de_header_state);
+            context->state = GET_LIST_LENGTH;
+            context->record_counter = 0;
             log_debug("parser: END_OF_RECORD & DONE");
             break;
         default:
@@ -260,103 +270,148 @@ static void sdp_parser_process_byte(uint8_t eventByte){
     }
 }
 
-void sdp_parser_init(btstack_packet_handler_t callback){
+static void sdp_parser_init_context(sdp_client_context_t * context, btstack_packet_handler_t callback){
     // init
-    sdp_parser_callback = callback;
-    de_state_init(&de_header_state);
-    state = GET_LIST_LENGTH;
-    list_offset = 0;
-    record_offset = 0;
-    record_counter = 0;
+    context->sdp_parser_callback = callback;
+    de_state_init(&context->de_header_state);
+    context->state = GET_LIST_LENGTH;
+    context->list_offset = 0;
+    context->record_offset = 0;
+    context->record_counter = 0;
 }
 
-void sdp_parser_handle_chunk(uint8_t * data, uint16_t size){
+static void sdp_parser_handle_chunk_for_context(sdp_client_context_t * context, uint8_t * data, uint16_t size){
     int i;
     for (i=0;i<size;i++){
-        sdp_parser_process_byte(data[i]);
+        sdp_parser_process_byte(context, data[i]);
     }
 }
 
 #ifdef ENABLE_SDP_EXTRA_QUERIES
-void sdp_parser_init_service_attribute_search(void){
+static void sdp_parser_init_service_attribute_search_for_context(sdp_client_context_t * context){
     // init
-    de_state_init(&de_header_state);
-    state = GET_RECORD_LENGTH;
-    list_offset = 0;
-    record_offset = 0;
-    record_counter = 0;
+    de_state_init(&context->de_header_state);
+    context->state = GET_RECORD_LENGTH;
+    context->list_offset = 0;
+    context->record_offset = 0;
+    context->record_counter = 0;
 }
 
-void sdp_parser_init_service_search(void){
-    record_offset = 0;
-}
-
-void sdp_parser_handle_service_search(uint8_t * data, uint16_t total_count, uint16_t record_handle_count){
+static void sdp_parser_handle_service_search_for_context(sdp_client_context_t * context, uint8_t * data, uint16_t total_count, uint16_t record_handle_count){
     int i;
     for (i=0;i<record_handle_count;i++){
-        record_handle = big_endian_read_32(data, i*4);
-        record_counter++;
+        context->record_handle = big_endian_read_32(data, i*4);
+        context->record_counter++;
         uint8_t event[10];
         event[0] = SDP_EVENT_QUERY_SERVICE_RECORD_HANDLE;
         event[1] = 8;
         little_endian_store_16(event, 2, total_count);
-        little_endian_store_16(event, 4, record_counter);
-        little_endian_store_32(event, 6, record_handle);
-        (*sdp_parser_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
+        little_endian_store_16(event, 4, context->record_counter);
+        little_endian_store_32(event, 6, context->record_handle);
+        (*context->sdp_parser_callback)(HCI_EVENT_PACKET, context->sdp_cid, event, sizeof(event));
     }        
 }
 #endif
 
-void sdp_parser_handle_done(uint8_t status){
+static void sdp_parser_handle_done_for_context(sdp_client_context_t * context, uint8_t status){
     uint8_t event[3];
     event[0] = SDP_EVENT_QUERY_COMPLETE;
     event[1] = 1;
     event[2] = status;
-    (*sdp_parser_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
+    (*context->sdp_parser_callback)(HCI_EVENT_PACKET, context->sdp_cid, event, sizeof(event));
+}
+
+// SDP Parser API for test/sdp_client, operates on first query context
+
+void sdp_parser_init(btstack_packet_handler_t callback){
+    sdp_parser_init_context(&sdp_client_contexts[0], callback);
+}
+
+void sdp_parser_handle_chunk(uint8_t * data, uint16_t size){
+    sdp_parser_handle_chunk_for_context(&sdp_client_contexts[0], data, size);
+}
+
+#ifdef ENABLE_SDP_EXTRA_QUERIES
+void sdp_parser_init_service_attribute_search(void){
+    sdp_parser_init_service_attribute_search_for_context(&sdp_client_contexts[0]);
+}
+
+void sdp_parser_init_service_search(void){
+    sdp_client_contexts[0].record_offset = 0;
+}
+
+void sdp_parser_handle_service_search(uint8_t * data, uint16_t total_count, uint16_t record_handle_count){
+    sdp_parser_handle_service_search_for_context(&sdp_client_contexts[0], data, total_count, record_handle_count);
+}
+#endif
+
+void sdp_parser_handle_done(uint8_t status){
+    sdp_parser_handle_done_for_context(&sdp_client_contexts[0], status);
 }
 
 // SDP Client
 
-// TODO: inline if not needed (des(des))
+static sdp_client_context_t * sdp_client_context_for_cid(uint16_t sdp_cid){
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        sdp_client_context_t * context = &sdp_client_contexts[i];
+        if (context->sdp_client_state == INIT) continue;
+        if (context->sdp_cid == sdp_cid) return context;
+    }
+    return NULL;
+}
 
-static void sdp_client_parse_attribute_lists(uint8_t* packet, uint16_t length){
-    sdp_parser_handle_chunk(packet, length);
+static sdp_client_context_t * sdp_client_context_for_address(bd_addr_t remote){
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        sdp_client_context_t * context = &sdp_client_contexts[i];
+        if (context->sdp_client_state == INIT) continue;
+        if (bd_addr_cmp(context->remote, remote) == 0) return context;
+    }
+    return NULL;
 }
 
+static sdp_client_context_t * sdp_client_context_get_free(void){
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        if (sdp_client_contexts[i].sdp_client_state == INIT) return &sdp_client_contexts[i];
+    }
+    return NULL;
+}
 
-static void sdp_client_send_request(uint16_t channel){
+static void sdp_client_send_request(sdp_client_context_t * context){
 
-    if (sdp_client_state != W2_SEND) return;
+    if (context->sdp_client_state != W2_SEND) return;
 
     l2cap_reserve_packet_buffer();
     uint8_t * data = l2cap_get_outgoing_buffer();
     uint16_t request_len = 0;
 
-    switch (PDU_ID){
+    switch (context->PDU_ID){
 #ifdef ENABLE_SDP_EXTRA_QUERIES
         case SDP_ServiceSearchResponse:
-            request_len = sdp_client_setup_service_search_request(data);
+            request_len = sdp_client_setup_service_search_request(context, data);
             break;
         case SDP_ServiceAttributeResponse:
-            request_len = sdp_client_setup_service_attribute_request(data);
+            request_len = sdp_client_setup_service_attribute_request(context, data);
             break;
 #endif
         case SDP_ServiceSearchAttributeResponse:
-            request_len = sdp_client_setup_service_search_attribute_request(data);
+            request_len = sdp_client_setup_service_search_attribute_request(context, data);
             break;
         default:
-            log_error("SDP Client sdp_client_send_request :: PDU ID invalid. %u", PDU_ID);
+            log_error("SDP Client sdp_client_send_request :: PDU ID invalid. %u", context->PDU_ID);
             return;
     }
 
     // prevent re-entrance
-    sdp_client_state = W4_RESPONSE;
-    PDU_ID = SDP_Invalid;
-    l2cap_send_prepared(channel, request_len);
+    context->sdp_client_state = W4_RESPONSE;
+    context->PDU_ID = SDP_Invalid;
+    l2cap_send_prepared(context->sdp_cid, request_len);
 }
 
 
-static void sdp_client_parse_service_search_attribute_response(uint8_t* packet, uint16_t size){
+static void sdp_client_parse_service_search_attribute_response(sdp_client_context_t * context, uint8_t* packet, uint16_t size){
 
     uint16_t offset = 3;
     if ((offset + 2 + 2) > size) return;  // parameterLength + attributeListByteCount
@@ -367,75 +422,78 @@ static void sdp_client_parse_service_search_attribute_response(uint8_t* packet,
     // AttributeListByteCount <= mtu
     uint16_t attributeListByteCount = big_endian_read_16(packet,offset);
     offset+=2;
-    if (attributeListByteCount > mtu){
+    if (attributeListByteCount > context->mtu){
         log_error("Error parsing ServiceSearchAttributeResponse: Number of bytes in found attribute list is larger then the MaximumAttributeByteCount.");
         return;
     }
 
     // AttributeLists
     if ((offset + attributeListByteCount) > size) return;
-    sdp_client_parse_attribute_lists(packet+offset, attributeListByteCount);
+    sdp_parser_handle_chunk_for_context(context, packet+offset, attributeListByteCount);
     offset+=attributeListByteCount;
 
     // continuation state len
     if ((offset + 1) > size) return;
-    continuationStateLen = packet[offset];
+    context->continuationStateLen = packet[offset];
     offset++;
-    if (continuationStateLen > 16){
-        continuationStateLen = 0;
+    if (context->continuationStateLen > 16){
+        context->continuationStateLen = 0;
         log_error("Error parsing ServiceSearchAttributeResponse: Number of bytes in continuation state exceedes 16.");
         return;
     }
 
     // continuation state
-    if ((offset + continuationStateLen) > size) return;
-    (void)memcpy(continuationState, packet + offset, continuationStateLen);
+    if ((offset + context->continuationStateLen) > size) return;
+    (void)memcpy(context->continuationState, packet + offset, context->continuationStateLen);
     // offset+=continuationStateLen;
 }
 
 void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-    
+    sdp_client_context_t * context;
+
     // uint16_t handle;
     if (packet_type == L2CAP_DATA_PACKET){
+        context = sdp_client_context_for_cid(channel);
+        if (!context) return;
         if (size < 3) return;
         uint16_t responseTransactionID = big_endian_read_16(packet,1);
-        if (responseTransactionID != transactionID){
-            log_error("Mismatching transaction ID, expected %u, found %u.", transactionID, responseTransactionID);
+        if (responseTransactionID != context->transactionID){
+            log_error("Mismatching transaction ID, expected %u, found %u.", context->transactionID, responseTransactionID);
             return;
         } 
         
-        PDU_ID = (SDP_PDU_ID_t)packet[0];
-        switch (PDU_ID){
+        context->PDU_ID = (SDP_PDU_ID_t)packet[0];
+        switch (context->PDU_ID){
             case SDP_ErrorResponse:
                 log_error("Received error response with code %u, disconnecting", packet[2]);
-                l2cap_disconnect(sdp_cid, 0);
+                l2cap_disconnect(context->sdp_cid, 0);
                 return;
 #ifdef ENABLE_SDP_EXTRA_QUERIES
             case SDP_ServiceSearchResponse:
-                sdp_client_parse_service_search_response(packet, size);
+                sdp_client_parse_service_search_response(context, packet, size);
                 break;
             case SDP_ServiceAttributeResponse:
-                sdp_client_parse_service_attribute_response(packet, size);
+                sdp_client_parse_service_attribute_response(context, packet, size);
                 break;
 #endif
             case SDP_ServiceSearchAttributeResponse:
-                sdp_client_parse_service_search_attribute_response(packet, size);
+                sdp_client_parse_service_search_attribute_response(context, packet, size);
                 break;
             default:
-                log_error("PDU ID %u unexpected/invalid", PDU_ID);
+                log_error("PDU ID %u unexpected/invalid", context->PDU_ID);
                 return;
         }
 
         // continuation set or DONE?
-        if (continuationStateLen == 0){
+        if (context->continuationStateLen == 0){
             log_debug("SDP Client Query DONE! ");
-            sdp_client_state = QUERY_COMPLETE;
-            l2cap_disconnect(sdp_cid, 0);
+            context->sdp_client_state = QUERY_COMPLETE;
+            l2cap_disconnect(context->sdp_cid, 0);
             return;
         }
         // prepare next request and send
-        sdp_client_state = W2_SEND;
-        l2cap_request_can_send_now_event(sdp_cid);
+        context->sdp_client_state = W2_SEND;
+        l2cap_request_can_send_now_event(context->sdp_cid);
         return;
     }
     
@@ -443,37 +501,39 @@ void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
     
     switch(hci_event_packet_get_type(packet)){
         case L2CAP_EVENT_CHANNEL_OPENED:
-            if (sdp_client_state != W4_CONNECT) break;
+            context = sdp_client_context_for_cid(channel);
+            if (!context) break;
+            if (context->sdp_client_state != W4_CONNECT) break;
             // data: event (8), len(8), status (8), address(48), handle (16), psm (16), local_cid(16), remote_cid (16), local_mtu(16), remote_mtu(16) 
             if (packet[2]) {
                 log_info("SDP Client Connection failed, status 0x%02x.", packet[2]);
-                sdp_client_state = INIT;
-                sdp_parser_handle_done(packet[2]);
+                context->sdp_client_state = INIT;
+                sdp_parser_handle_done_for_context(context, packet[2]);
                 break;
             }
-            sdp_cid = channel;
-            mtu = little_endian_read_16(packet, 17);
+            context->mtu = little_endian_read_16(packet, 17);
             // handle = little_endian_read_16(packet, 9);
-            log_debug("SDP Client Connected, cid %x, mtu %u.", sdp_cid, mtu);
+            log_debug("SDP Client Connected, cid %x, mtu %u.", context->sdp_cid, context->mtu);
 
-            sdp_client_state = W2_SEND;
-            l2cap_request_can_send_now_event(sdp_cid);
+            context->sdp_client_state = W2_SEND;
+            l2cap_request_can_send_now_event(context->sdp_cid);
             break;
 
         case L2CAP_EVENT_CAN_SEND_NOW:
-            if(l2cap_event_can_send_now_get_local_cid(packet) == sdp_cid){
-                sdp_client_send_request(sdp_cid);
-            }
+            context = sdp_client_context_for_cid(l2cap_event_can_send_now_get_local_cid(packet));
+            if (!context) break;
+            sdp_client_send_request(context);
             break;
         case L2CAP_EVENT_CHANNEL_CLOSED: {
-            if (sdp_cid != little_endian_read_16(packet, 2)) {
-                // log_info("Received L2CAP_EVENT_CHANNEL_CLOSED for cid %x, current cid %x\n",  little_endian_read_16(packet, 2),sdp_cid);
+            context = sdp_client_context_for_cid(little_endian_read_16(packet, 2));
+            if (!context) {
+                // log_info("Received L2CAP_EVENT_CHANNEL_CLOSED for cid %x",  little_endian_read_16(packet, 2));
                 break;
             }
             log_info("SDP Client disconnected.");
-            uint8_t status = (sdp_client_state == QUERY_COMPLETE) ? 0 : SDP_QUERY_INCOMPLETE;
-            sdp_client_state = INIT;
-            sdp_parser_handle_done(status);
+            uint8_t status = (context->sdp_client_state == QUERY_COMPLETE) ? 0 : SDP_QUERY_INCOMPLETE;
+            context->sdp_client_state = INIT;
+            sdp_parser_handle_done_for_context(context, status);
             break;
         }
         default:
@@ -482,14 +542,14 @@ void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
 }
 
 
-static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data){
+static uint16_t sdp_client_setup_service_search_attribute_request(sdp_client_context_t * context, uint8_t * data){
 
     uint16_t offset = 0;
-    transactionID++;
+    context->transactionID = ++sdp_client_transaction_id;
     // uint8_t SDP_PDU_ID_t.SDP_ServiceSearchRequest;
     data[offset++] = SDP_ServiceSearchAttributeRequest;
     // uint16_t transactionID
-    big_endian_store_16(data, offset, transactionID);
+    big_endian_store_16(data, offset, context->transactionID);
     offset += 2;
 
     // param legnth
@@ -497,25 +557,25 @@ static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data
 
     // parameters: 
     //     Service_search_pattern - DES (min 1 UUID, max 12)
-    uint16_t service_search_pattern_len = de_get_len(service_search_pattern);
-    (void)memcpy(data + offset, service_search_pattern,
+    uint16_t service_search_pattern_len = de_get_len(context->service_search_pattern);
+    (void)memcpy(data + offset, context->service_search_pattern,
                  service_search_pattern_len);
     offset += service_search_pattern_len;
 
     //     MaximumAttributeByteCount - uint16_t  0x0007 - 0xffff -> mtu
-    big_endian_store_16(data, offset, mtu);
+    big_endian_store_16(data, offset, context->mtu);
     offset += 2;
 
     //     AttibuteIDList  
-    uint16_t attribute_id_list_len = de_get_len(attribute_id_list);
-    (void)memcpy(data + offset, attribute_id_list, attribute_id_list_len);
+    uint16_t attribute_id_list_len = de_get_len(context->attribute_id_list);
+    (void)memcpy(data + offset, context->attribute_id_list, attribute_id_list_len);
     offset += attribute_id_list_len;
 
     //     ContinuationState - uint8_t number of cont. bytes N<=16 
-    data[offset++] = continuationStateLen;
+    data[offset++] = context->continuationStateLen;
     //                       - N-bytes previous response from server
-    (void)memcpy(data + offset, continuationState, continuationStateLen);
-    offset += continuationStateLen;
+    (void)memcpy(data + offset, context->continuationState, context->continuationStateLen);
+    offset += context->continuationStateLen;
 
     // uint16_t paramLength 
     big_endian_store_16(data, 3, offset - 5);
@@ -528,13 +588,13 @@ void sdp_client_parse_service_record_handle_list(uint8_t* packet, uint16_t total
     sdp_parser_handle_service_search(packet, total_count, current_count);
 }
 
-static uint16_t sdp_client_setup_service_search_request(uint8_t * data){
+static uint16_t sdp_client_setup_service_search_request(sdp_client_context_t * context, uint8_t * data){
     uint16_t offset = 0;
-    transactionID++;
+    context->transactionID = ++sdp_client_transaction_id;
     // uint8_t SDP_PDU_ID_t.SDP_ServiceSearchRequest;
     data[offset++] = SDP_ServiceSearchRequest;
     // uint16_t transactionID
-    big_endian_store_16(data, offset, transactionID);
+    big_endian_store_16(data, offset, context->transactionID);
     offset += 2;
 
     // param legnth
@@ -542,20 +602,20 @@ static uint16_t sdp_client_setup_service_search_request(uint8_t * data){
 
     // parameters: 
     //     Service_search_pattern - DES (min 1 UUID, max 12)
-    uint16_t service_search_pattern_len = de_get_len(service_search_pattern);
-    (void)memcpy(data + offset, service_search_pattern,
+    uint16_t service_search_pattern_len = de_get_len(context->service_search_pattern);
+    (void)memcpy(data + offset, context->service_search_pattern,
                  service_search_pattern_len);
     offset += service_search_pattern_len;
 
     //     MaximumAttributeByteCount - uint16_t  0x0007 - 0xffff -> mtu
-    big_endian_store_16(data, offset, mtu);
+    big_endian_store_16(data, offset, context->mtu);
     offset += 2;
 
     //     ContinuationState - uint8_t number of cont. bytes N<=16 
-    data[offset++] = continuationStateLen;
+    data[offset++] = context->continuationStateLen;
     //                       - N-bytes previous response from server
-    (void)memcpy(data + offset, continuationState, continuationStateLen);
-    offset += continuationStateLen;
+    (void)memcpy(data + offset, context->continuationState, context->continuationStateLen);
+    offset += context->continuationStateLen;
 
     // uint16_t paramLength 
     big_endian_store_16(data, 3, offset - 5);
@@ -564,14 +624,14 @@ static uint16_t sdp_client_setup_service_search_request(uint8_t * data){
 }
 
 
-static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data){
+static uint16_t sdp_client_setup_service_attribute_request(sdp_client_context_t * context, uint8_t * data){
 
     uint16_t offset = 0;
-    transactionID++;
+    context->transactionID = ++sdp_client_transaction_id;
     // uint8_t SDP_PDU_ID_t.SDP_ServiceSearchRequest;
     data[offset++] = SDP_ServiceAttributeRequest;
     // uint16_t transactionID
-    big_endian_store_16(data, offset, transactionID);
+    big_endian_store_16(data, offset, context->transactionID);
     offset += 2;
 
     // param legnth
@@ -579,23 +639,23 @@ static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data){
 
     // parameters: 
     //     ServiceRecordHandle
-    big_endian_store_32(data, offset, serviceRecordHandle);
+    big_endian_store_32(data, offset, context->serviceRecordHandle);
     offset += 4;
 
     //     MaximumAttributeByteCount - uint16_t  0x0007 - 0xffff -> mtu
-    big_endian_store_16(data, offset, mtu);
+    big_endian_store_16(data, offset, context->mtu);
     offset += 2;
 
     //     AttibuteIDList  
-    uint16_t attribute_id_list_len = de_get_len(attribute_id_list);
-    (void)memcpy(data + offset, attribute_id_list, attribute_id_list_len);
+    uint16_t attribute_id_list_len = de_get_len(context->attribute_id_list);
+    (void)memcpy(data + offset, context->attribute_id_list, attribute_id_list_len);
     offset += attribute_id_list_len;
 
     //     ContinuationState - uint8_t number of cont. bytes N<=16 
-    data[offset++] = continuationStateLen;
+    data[offset++] = context->continuationStateLen;
     //                       - N-bytes previous response from server
-    (void)memcpy(data + offset, continuationState, continuationStateLen);
-    offset += continuationStateLen;
+    (void)memcpy(data + offset, context->continuationState, context->continuationStateLen);
+    offset += context->continuationStateLen;
 
     // uint16_t paramLength 
     big_endian_store_16(data, 3, offset - 5);
@@ -603,7 +663,7 @@ static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data){
     return offset;
 }
 
-static void sdp_client_parse_service_search_response(uint8_t* packet, uint16_t size){
+static void sdp_client_parse_service_search_response(sdp_client_context_t * context, uint8_t* packet, uint16_t size){
 
     uint16_t offset = 3;
     if (offset + 2 + 2 + 2 > size) return;  // parameterLength, totalServiceRecordCount, currentServiceRecordCount
@@ -623,23 +683,23 @@ static void sdp_client_parse_service_search_response(uint8_t* packet, uint16_t s
     }
     
     if (offset + currentServiceRecordCount * 4 > size) return;
-    sdp_client_parse_service_record_handle_list(packet+offset, totalServiceRecordCount, currentServiceRecordCount);
+    sdp_parser_handle_service_search_for_context(context, packet+offset, totalServiceRecordCount, currentServiceRecordCount);
     offset+= currentServiceRecordCount * 4;
 
     if (offset + 1 > size) return;
-    continuationStateLen = packet[offset];
+    context->continuationStateLen = packet[offset];
     offset++;
-    if (continuationStateLen > 16){
-        continuationStateLen = 0;
+    if (context->continuationStateLen > 16){
+        context->continuationStateLen = 0;
         log_error("Error parsing ServiceSearchResponse: Number of bytes in continuation state exceedes 16.");
         return;
     }
-    if (offset + continuationStateLen > size) return;
-    (void)memcpy(continuationState, packet + offset, continuationStateLen);
+    if (offset + context->continuationStateLen > size) return;
+    (void)memcpy(context->continuationState, packet + offset, context->continuationStateLen);
     // offset+=continuationStateLen;
 }
 
-static void sdp_client_parse_service_attribute_response(uint8_t* packet, uint16_t size){
+static void sdp_client_parse_service_attribute_response(sdp_client_context_t * context, uint8_t* packet, uint16_t size){
 
     uint16_t offset = 3;
     if (offset + 2 + 2 > size) return;  // parameterLength, attributeListByteCount
@@ -650,53 +710,92 @@ static void sdp_client_parse_service_attribute_response(uint8_t* packet, uint16_
     // AttributeListByteCount <= mtu
     uint16_t attributeListByteCount = big_endian_read_16(packet,offset);
     offset+=2;
-    if (attributeListByteCount > mtu){
+    if (attributeListByteCount > context->mtu){
         log_error("Error parsing ServiceSearchAttributeResponse: Number of bytes in found attribute list is larger then the MaximumAttributeByteCount.");
         return;
     }
 
     // AttributeLists
     if (offset+attributeListByteCount > size) return;
-    sdp_client_parse_attribute_lists(packet+offset, attributeListByteCount);
+    sdp_parser_handle_chunk_for_context(context, packet+offset, attributeListByteCount);
     offset+=attributeListByteCount;
 
     // continuationStateLen
     if (offset + 1 > size) return;
-    continuationStateLen = packet[offset];
+    context->continuationStateLen = packet[offset];
     offset++;
-    if (continuationStateLen > 16){
-        continuationStateLen = 0;
+    if (context->continuationStateLen > 16){
+        context->continuationStateLen = 0;
         log_error("Error parsing ServiceAttributeResponse: Number of bytes in continuation state exceedes 16.");
         return;
     }
-    if (offset + continuationStateLen > size) return;
-    (void)memcpy(continuationState, packet + offset, continuationStateLen);
+    if (offset + context->continuationStateLen > size) return;
+    (void)memcpy(context->continuationState, packet + offset, context->continuationStateLen);
     // offset+=continuationStateLen;
 }
 #endif
 
 // for testing only
 void sdp_client_reset(void){
-    sdp_client_state = INIT;
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        sdp_client_contexts[i].sdp_client_state = INIT;
+    }
+}
+
+// @returns context for new query to remote or NULL if busy
+static sdp_client_context_t * sdp_client_context_for_query(bd_addr_t remote){
+    // only a single query per remote device
+    if (sdp_client_context_for_address(remote) != NULL) return NULL;
+    return sdp_client_context_get_free();
+}
+
+static uint8_t sdp_client_start_query(sdp_client_context_t * context, bd_addr_t remote, SDP_PDU_ID_t pdu_id, uint16_t * out_sdp_cid){
+    (void)memcpy(context->remote, remote, 6);
+    context->continuationStateLen = 0;
+    context->PDU_ID = pdu_id;
+    context->sdp_cid = 0;
+
+    context->sdp_client_state = W4_CONNECT;
+    uint8_t status = l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PSM_SDP, l2cap_max_mtu(), &context->sdp_cid);
+    if (status != ERROR_CODE_SUCCESS){
+        context->sdp_client_state = INIT;
+    }
+    if (out_sdp_cid != NULL){
+        *out_sdp_cid = context->sdp_cid;
+    }
+    return status;
+}
+
+static void sdp_client_set_service_search_pattern(sdp_client_context_t * context, const uint8_t * des_service_search_pattern){
+    // copy short patterns, as patterns created by sdp_service_search_pattern_for_uuid16/128 are shared by all queries
+    uint16_t service_search_pattern_len = de_get_len(des_service_search_pattern);
+    if (service_search_pattern_len <= SDP_CLIENT_SERVICE_SEARCH_PATTERN_STORAGE_SIZE){
+        (void)memcpy(context->service_search_pattern_storage, des_service_search_pattern, service_search_pattern_len);
+        context->service_search_pattern = context->service_search_pattern_storage;
+    } else {
+        context->service_search_pattern = des_service_search_pattern;
+    }
 }
 
 // Public API
 
 int sdp_client_ready(void){
-    return sdp_client_state == INIT;
+    return sdp_client_context_get_free() != NULL;
 }
 
-uint8_t sdp_client_query(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list){
-    if (!sdp_client_ready()) return SDP_QUERY_BUSY;
+uint8_t sdp_client_query_with_cid(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list, uint16_t * out_sdp_cid){
+    sdp_client_context_t * context = sdp_client_context_for_query(remote);
+    if (context == NULL) return SDP_QUERY_BUSY;
 
-    sdp_parser_init(callback);
-    service_search_pattern = des_service_search_pattern;
-    attribute_id_list = des_attribute_id_list;
-    continuationStateLen = 0;
-    PDU_ID = SDP_ServiceSearchAttributeResponse;
+    sdp_parser_init_context(context, callback);
+    sdp_client_set_service_search_pattern(context, des_service_search_pattern);
+    context->attribute_id_list = des_attribute_id_list;
+    return sdp_client_start_query(context, remote, SDP_ServiceSearchAttributeResponse, out_sdp_cid);
+}
 
-    sdp_client_state = W4_CONNECT;
-    return l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PSM_SDP, l2cap_max_mtu(), NULL);
+uint8_t sdp_client_query(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list){
+    return sdp_client_query_with_cid(callback, remote, des_service_search_pattern, des_attribute_id_list, NULL);
 }
 
 uint8_t sdp_client_query_uuid16(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid){
@@ -711,31 +810,23 @@ uint8_t sdp_client_query_uuid128(btstack_packet_handler_t callback, bd_addr_t re
 
 #ifdef ENABLE_SDP_EXTRA_QUERIES
 uint8_t sdp_client_service_attribute_search(btstack_packet_handler_t callback, bd_addr_t remote, uint32_t search_service_record_handle, const uint8_t * des_attribute_id_list){
-    if (!sdp_client_ready()) return SDP_QUERY_BUSY;
-
-    sdp_parser_init(callback);
-    serviceRecordHandle = search_service_record_handle;
-    attribute_id_list = des_attribute_id_list;
-    continuationStateLen = 0;
-    PDU_ID = SDP_ServiceAttributeResponse;
+    sdp_client_context_t * context = sdp_client_context_for_query(remote);
+    if (context == NULL) return SDP_QUERY_BUSY;
 
-    sdp_client_state = W4_CONNECT;
-    l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PSM_SDP, l2cap_max_mtu(), NULL);
+    sdp_parser_init_context(context, callback);
+    context->serviceRecordHandle = search_service_record_handle;
+    context->attribute_id_list = des_attribute_id_list;
+    sdp_client_start_query(context, remote, SDP_ServiceAttributeResponse, NULL);
     return 0;
 }
 
 uint8_t sdp_client_service_search(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern){
+    sdp_client_context_t * context = sdp_client_context_for_query(remote);
+    if (context == NULL) return SDP_QUERY_BUSY;
 
-    if (!sdp_client_ready()) return SDP_QUERY_BUSY;
-
-    sdp_parser_init(callback);
-    service_search_pattern = des_service_search_pattern;
-    continuationStateLen = 0;
-    PDU_ID = SDP_ServiceSearchResponse;
-
-    sdp_client_state = W4_CONNECT;
-    l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PSM_SDP, l2cap_max_mtu(), NULL);
+    sdp_parser_init_context(context, callback);
+    sdp_client_set_service_search_pattern(context, des_service_search_pattern);
+    sdp_client_start_query(context, remote, SDP_ServiceSearchResponse, NULL);
     return 0;
 }
 #endif
-
@@ -46,6 +46,11 @@
 
 #include "btstack_util.h"
 
+// max number of SDP queries to different remote devices that can be active at the same time
+#ifndef SDP_CLIENT_MAX_CONCURRENT_QUERIES
+#define SDP_CLIENT_MAX_CONCURRENT_QUERIES 1
+#endif
+
 #if defined __cplusplus
 extern "C" {
 #endif
@@ -64,7 +69,8 @@ int  de_state_size(uint8_t eventByte, de_state_t *de_state);
 
 /** 
  * @brief Checks if the SDP Client is ready
- * @return 1 when no query is active
+ * @note with SDP_CLIENT_MAX_CONCURRENT_QUERIES > 1, queries to different remote devices can be active at the same time
+ * @return 1 when a new query can be started
  */
 int sdp_client_ready(void);
 
@@ -78,6 +84,18 @@ int sdp_client_ready(void);
  */
 uint8_t sdp_client_query(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list);
 
+/** 
+ * @brief Queries the SDP service of the remote device given a service search pattern and a list of attribute IDs.
+ * Same as sdp_client_query, but also provides the L2CAP channel ID of the query, which is passed as channel to the callback.
+ * This allows to use a single callback for concurrent queries.
+ * @param callback for attributes values and done event
+ * @param remote address
+ * @param des_service_search_pattern 
+ * @param des_attribute_id_list
+ * @param out_sdp_cid L2CAP channel ID of the query
+ */
+uint8_t sdp_client_query_with_cid(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list, uint16_t * out_sdp_cid);
+
 /*
  * @brief Searches SDP records on a remote device for all services with a given UUID.
  * @note calls sdp_client_query with service search pattern based on uuid16
@@ -55,6 +55,38 @@
 #include "classic/sdp_util.h"
 #include "hci_cmd.h"
 
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+#include "btstack_run_loop.h"
+#include "btstack_tlv.h"
+#include "gap.h"
+
+// number of cached query results in TLV
+#ifndef SDP_CLIENT_RFCOMM_CACHE_NUM_ENTRIES
+#define SDP_CLIENT_RFCOMM_CACHE_NUM_ENTRIES 4
+#endif
+
+// max number of RFCOMM services per cached query result
+#ifndef SDP_CLIENT_RFCOMM_CACHE_MAX_SERVICES
+#define SDP_CLIENT_RFCOMM_CACHE_MAX_SERVICES 2
+#endif
+
+// number of queries answered from cache before SDP query is repeated
+#ifndef SDP_CLIENT_RFCOMM_CACHE_TTL
+#define SDP_CLIENT_RFCOMM_CACHE_TTL 16
+#endif
+
+// cache entry: bd_addr (6), link key hash (4), ttl (1), sequence number (4), pattern len (1), pattern (19),
+//              num services (1), services: rfcomm channel (1), name len (1), name (SDP_SERVICE_NAME_LEN)
+#define SDP_CLIENT_RFCOMM_CACHE_PATTERN_MAX_LEN  19
+#define SDP_CLIENT_RFCOMM_CACHE_OFFSET_HASH      6
+#define SDP_CLIENT_RFCOMM_CACHE_OFFSET_TTL       10
+#define SDP_CLIENT_RFCOMM_CACHE_OFFSET_SEQ       11
+#define SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN   15
+#define SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES  (SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN + 1 + SDP_CLIENT_RFCOMM_CACHE_PATTERN_MAX_LEN)
+#define SDP_CLIENT_RFCOMM_CACHE_SERVICE_SIZE     (2 + SDP_SERVICE_NAME_LEN)
+#define SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE       (SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES + 1 + (SDP_CLIENT_RFCOMM_CACHE_MAX_SERVICES * SDP_CLIENT_RFCOMM_CACHE_SERVICE_SIZE))
+#endif
+
 // called by test/sdp_client
 void sdp_client_query_rfcomm_init(void);
 
@@ -73,128 +105,316 @@ typedef enum {
 // All attributes: 0x0001 - 0x0100
 static const uint8_t des_attributeIDList[]    = { 0x35, 0x05, 0x0A, 0x00, 0x01, 0x01, 0x00};  
 
-static uint8_t sdp_service_name[SDP_SERVICE_NAME_LEN+1];
-static uint8_t sdp_service_name_len = 0;
-static uint8_t sdp_rfcomm_channel_nr = 0;
-static uint8_t sdp_service_name_header_size;
-
-static pdl_state_t pdl_state = GET_PROTOCOL_LIST_LENGTH;
-static int protocol_value_bytes_received = 0;
-static uint16_t protocol_id = 0;
-static int protocol_offset;
-static int protocol_size;
-static int protocol_id_bytes_to_read;
-static int protocol_value_size;
-static de_state_t de_header_state;
-static de_state_t sn_de_header_state;
-static btstack_packet_handler_t sdp_app_callback;
+typedef struct {
+    // L2CAP channel ID of SDP query, valid if sdp_app_callback is set
+    uint16_t sdp_cid;
+    btstack_packet_handler_t sdp_app_callback;
+
+    uint8_t sdp_service_name[SDP_SERVICE_NAME_LEN+1];
+    uint8_t sdp_service_name_len;
+    uint8_t sdp_rfcomm_channel_nr;
+    uint8_t sdp_service_name_header_size;
+
+    pdl_state_t pdl_state;
+    int protocol_value_bytes_received;
+    uint16_t protocol_id;
+    int protocol_offset;
+    int protocol_size;
+    int protocol_id_bytes_to_read;
+    int protocol_value_size;
+    de_state_t de_header_state;
+    de_state_t sn_de_header_state;
+
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+    // query result is delivered from cache entry
+    uint8_t cached;
+    // collected services do not fit into cache entry
+    uint8_t cache_overflow;
+    btstack_timer_source_t cache_timer;
+    uint8_t cache_entry[SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE];
+#endif
+} sdp_client_rfcomm_query_t;
+
+static sdp_client_rfcomm_query_t sdp_client_rfcomm_queries[SDP_CLIENT_MAX_CONCURRENT_QUERIES];
 //
 
-static void sdp_rfcomm_query_emit_service(void){
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+static void sdp_rfcomm_query_emit_service(sdp_client_rfcomm_query_t * query);
+
+static uint32_t sdp_client_rfcomm_cache_tag_for_index(int index){
+    return ((uint32_t) 'S' << 24) | ((uint32_t) 'D' << 16) | ((uint32_t) 'R' << 8) | (uint32_t) index;
+}
+
+// @returns 0 if device is not bonded
+static int sdp_client_rfcomm_cache_link_key_hash(bd_addr_t remote, uint32_t * hash){
+    link_key_t link_key;
+    link_key_type_t link_key_type;
+    if (!gap_get_link_key_for_bd_addr(remote, link_key, &link_key_type)) return 0;
+    // FNV-1a
+    uint32_t value = 2166136261u;
+    int i;
+    for (i = 0; i < 16; i++){
+        value = (value ^ link_key[i]) * 16777619u;
+    }
+    *hash = value ^ (uint32_t) link_key_type;
+    return 1;
+}
+
+static int sdp_client_rfcomm_cache_entry_matches(const uint8_t * entry, bd_addr_t remote, const uint8_t * service_search_pattern, uint16_t service_search_pattern_len){
+    if (bd_addr_cmp((uint8_t *) entry, remote) != 0) return 0;
+    if (entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN] != service_search_pattern_len) return 0;
+    return memcmp(&entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN + 1], service_search_pattern, service_search_pattern_len) == 0;
+}
+
+// @returns 1 if query result was loaded into query->cache_entry
+static int sdp_client_rfcomm_cache_lookup(sdp_client_rfcomm_query_t * query, bd_addr_t remote, const uint8_t * service_search_pattern){
+    uint16_t service_search_pattern_len = de_get_len(service_search_pattern);
+    if (service_search_pattern_len > SDP_CLIENT_RFCOMM_CACHE_PATTERN_MAX_LEN) return 0;
+
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return 0;
+
+    int i;
+    for (i = 0; i < SDP_CLIENT_RFCOMM_CACHE_NUM_ENTRIES; i++){
+        uint32_t tag = sdp_client_rfcomm_cache_tag_for_index(i);
+        int size = tlv_impl->get_tag(tlv_context, tag, query->cache_entry, SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE);
+        if (size != SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE) continue;
+        if (!sdp_client_rfcomm_cache_entry_matches(query->cache_entry, remote, service_search_pattern, service_search_pattern_len)) continue;
+
+        // drop entry if bonding information changed or TTL expired
+        uint32_t hash;
+        if (!sdp_client_rfcomm_cache_link_key_hash(remote, &hash)
+            || (little_endian_read_32(query->cache_entry, SDP_CLIENT_RFCOMM_CACHE_OFFSET_HASH) != hash)
+            || (query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_TTL] == 0)){
+            log_info("SDP RFCOMM Cache: drop entry %u for %s", i, bd_addr_to_str(remote));
+            tlv_impl->delete_tag(tlv_context, tag);
+            return 0;
+        }
+
+        query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_TTL]--;
+        tlv_impl->store_tag(tlv_context, tag, query->cache_entry, SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE);
+        log_info("SDP RFCOMM Cache: use entry %u for %s", i, bd_addr_to_str(remote));
+        return 1;
+    }
+    return 0;
+}
+
+static void sdp_client_rfcomm_cache_prepare(sdp_client_rfcomm_query_t * query, bd_addr_t remote, const uint8_t * service_search_pattern){
+    memset(query->cache_entry, 0, SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE);
+    uint16_t service_search_pattern_len = de_get_len(service_search_pattern);
+    query->cache_overflow = service_search_pattern_len > SDP_CLIENT_RFCOMM_CACHE_PATTERN_MAX_LEN;
+    if (query->cache_overflow) return;
+    (void)memcpy(query->cache_entry, remote, 6);
+    query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN] = (uint8_t) service_search_pattern_len;
+    (void)memcpy(&query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN + 1], service_search_pattern, service_search_pattern_len);
+}
+
+static void sdp_client_rfcomm_cache_add_service(sdp_client_rfcomm_query_t * query){
+    uint8_t num_services = query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES];
+    if (num_services >= SDP_CLIENT_RFCOMM_CACHE_MAX_SERVICES){
+        query->cache_overflow = 1;
+        return;
+    }
+    uint8_t * service = &query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES + 1 + (num_services * SDP_CLIENT_RFCOMM_CACHE_SERVICE_SIZE)];
+    service[0] = query->sdp_rfcomm_channel_nr;
+    service[1] = query->sdp_service_name_len;
+    (void)memcpy(&service[2], query->sdp_service_name, query->sdp_service_name_len);
+    query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES] = num_services + 1;
+}
+
+static void sdp_client_rfcomm_cache_store(sdp_client_rfcomm_query_t * query){
+    if (query->cache_overflow) return;
+    // only cache found services
+    if (query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES] == 0) return;
+
+    // only cache results of bonded devices
+    uint32_t hash;
+    if (!sdp_client_rfcomm_cache_link_key_hash(query->cache_entry, &hash)) return;
+
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    // use entry for same query, a free entry, or replace oldest entry
+    uint8_t entry[SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE];
+    int index_free = -1;
+    int index_oldest = 0;
+    uint32_t seq_oldest = 0xffffffffu;
+    uint32_t seq_newest = 0;
+    int index;
+    for (index = 0; index < SDP_CLIENT_RFCOMM_CACHE_NUM_ENTRIES; index++){
+        int size = tlv_impl->get_tag(tlv_context, sdp_client_rfcomm_cache_tag_for_index(index), entry, sizeof(entry));
+        if (size != SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE){
+            if (index_free < 0){
+                index_free = index;
+            }
+            continue;
+        }
+        if (sdp_client_rfcomm_cache_entry_matches(entry, query->cache_entry, &query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN + 1],
+                                                  query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_PATTERN])){
+            index_free = index;
+        }
+        uint32_t seq = little_endian_read_32(entry, SDP_CLIENT_RFCOMM_CACHE_OFFSET_SEQ);
+        if (seq < seq_oldest){
+            seq_oldest = seq;
+            index_oldest = index;
+        }
+        if (seq > seq_newest){
+            seq_newest = seq;
+        }
+    }
+    if (index_free < 0){
+        index_free = index_oldest;
+    }
+
+    little_endian_store_32(query->cache_entry, SDP_CLIENT_RFCOMM_CACHE_OFFSET_HASH, hash);
+    query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_TTL] = SDP_CLIENT_RFCOMM_CACHE_TTL;
+    little_endian_store_32(query->cache_entry, SDP_CLIENT_RFCOMM_CACHE_OFFSET_SEQ, seq_newest + 1);
+    log_info("SDP RFCOMM Cache: store entry %u for %s", index_free, bd_addr_to_str(query->cache_entry));
+    tlv_impl->store_tag(tlv_context, sdp_client_rfcomm_cache_tag_for_index(index_free), query->cache_entry, SDP_CLIENT_RFCOMM_CACHE_ENTRY_SIZE);
+}
+
+static void sdp_client_rfcomm_cache_handle_timeout(btstack_timer_source_t * ts){
+    sdp_client_rfcomm_query_t * query = (sdp_client_rfcomm_query_t *) btstack_run_loop_get_timer_context(ts);
+
+    // emit cached services
+    uint8_t num_services = query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES];
+    uint8_t i;
+    for (i = 0; i < num_services; i++){
+        const uint8_t * service = &query->cache_entry[SDP_CLIENT_RFCOMM_CACHE_OFFSET_SERVICES + 1 + (i * SDP_CLIENT_RFCOMM_CACHE_SERVICE_SIZE)];
+        query->sdp_rfcomm_channel_nr = service[0];
+        query->sdp_service_name_len  = btstack_min(service[1], SDP_SERVICE_NAME_LEN);
+        (void)memcpy(query->sdp_service_name, &service[2], query->sdp_service_name_len);
+        query->sdp_service_name[query->sdp_service_name_len] = 0;
+        sdp_rfcomm_query_emit_service(query);
+    }
+
+    // free query before emitting event, callback might start new query
+    btstack_packet_handler_t callback = query->sdp_app_callback;
+    query->sdp_app_callback = NULL;
+    query->cached = 0;
+
+    uint8_t event[3];
+    event[0] = SDP_EVENT_QUERY_COMPLETE;
+    event[1] = 1;
+    event[2] = ERROR_CODE_SUCCESS;
+    (*callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+#endif
+
+static void sdp_rfcomm_query_emit_service(sdp_client_rfcomm_query_t * query){
     uint8_t event[3+SDP_SERVICE_NAME_LEN+1];
     event[0] = SDP_EVENT_QUERY_RFCOMM_SERVICE;
-    event[1] = sdp_service_name_len + 1;
-    event[2] = sdp_rfcomm_channel_nr;
-    (void)memcpy(&event[3], sdp_service_name, sdp_service_name_len);
-    event[3+sdp_service_name_len] = 0;
-    (*sdp_app_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
-    sdp_rfcomm_channel_nr = 0;
+    event[1] = query->sdp_service_name_len + 1;
+    event[2] = query->sdp_rfcomm_channel_nr;
+    (void)memcpy(&event[3], query->sdp_service_name, query->sdp_service_name_len);
+    event[3+query->sdp_service_name_len] = 0;
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+    if (!query->cached){
+        sdp_client_rfcomm_cache_add_service(query);
+    }
+#endif
+    (*query->sdp_app_callback)(HCI_EVENT_PACKET, query->sdp_cid, event, sizeof(event));
+    query->sdp_rfcomm_channel_nr = 0;
 }
 
-static void sdp_client_query_rfcomm_handle_protocol_descriptor_list_data(uint32_t attribute_value_length, uint32_t data_offset, uint8_t data){
+static void sdp_client_query_rfcomm_handle_protocol_descriptor_list_data(sdp_client_rfcomm_query_t * query, uint32_t attribute_value_length, uint32_t data_offset, uint8_t data){
     UNUSED(attribute_value_length);
     
     // init state on first byte
     if (data_offset == 0){
-        pdl_state = GET_PROTOCOL_LIST_LENGTH;
+        query->pdl_state = GET_PROTOCOL_LIST_LENGTH;
     }
 
     // log_info("sdp_client_query_rfcomm_handle_protocol_descriptor_list_data (%u,%u) %02x", attribute_value_length, data_offset, data);
 
-    switch(pdl_state){
+    switch(query->pdl_state){
         
         case GET_PROTOCOL_LIST_LENGTH:
-            if (!de_state_size(data, &de_header_state)) break;
+            if (!de_state_size(data, &query->de_header_state)) break;
             // log_info("   query: PD List payload is %d bytes.", de_header_state.de_size);
             // log_info("   query: PD List offset %u, list size %u", de_header_state.de_offset, de_header_state.de_size);
 
-            pdl_state = GET_PROTOCOL_LENGTH;
+            query->pdl_state = GET_PROTOCOL_LENGTH;
             break;
         
         case GET_PROTOCOL_LENGTH:
             // check size
-            if (!de_state_size(data, &de_header_state)) break;
+            if (!de_state_size(data, &query->de_header_state)) break;
             // log_info("   query: PD Record payload is %d bytes.", de_header_state.de_size);
             
             // cache protocol info
-            protocol_offset = de_header_state.de_offset;
-            protocol_size   = de_header_state.de_size;
+            query->protocol_offset = query->de_header_state.de_offset;
+            query->protocol_size   = query->de_header_state.de_size;
 
-            pdl_state = GET_PROTOCOL_ID_HEADER_LENGTH;
+            query->pdl_state = GET_PROTOCOL_ID_HEADER_LENGTH;
             break;
         
        case GET_PROTOCOL_ID_HEADER_LENGTH:
-            protocol_offset++;
-            if (!de_state_size(data, &de_header_state)) break;
+            query->protocol_offset++;
+            if (!de_state_size(data, &query->de_header_state)) break;
             
-            protocol_id = 0;
-            protocol_id_bytes_to_read = de_header_state.de_size;
+            query->protocol_id = 0;
+            query->protocol_id_bytes_to_read = query->de_header_state.de_size;
             // log_info("   query: ID data is stored in %d bytes.", protocol_id_bytes_to_read);
-            pdl_state = GET_PROTOCOL_ID;
+            query->pdl_state = GET_PROTOCOL_ID;
             
             break;
         
         case GET_PROTOCOL_ID:
-            protocol_offset++;
+            query->protocol_offset++;
 
-            protocol_id = (protocol_id << 8) | data;
-            protocol_id_bytes_to_read--;
-            if (protocol_id_bytes_to_read > 0) break;
+            query->protocol_id = (query->protocol_id << 8) | data;
+            query->protocol_id_bytes_to_read--;
+            if (query->protocol_id_bytes_to_read > 0) break;
 
             // log_info("   query: Protocol ID: %04x.", protocol_id);
 
-            if (protocol_offset >= protocol_size){
-                pdl_state = GET_PROTOCOL_LENGTH;
+            if (query->protocol_offset >= query->protocol_size){
+                query->pdl_state = GET_PROTOCOL_LENGTH;
                 // log_info("   query: Get next protocol");
                 break;
             } 
             
-            pdl_state = GET_PROTOCOL_VALUE_LENGTH;
-            protocol_value_bytes_received = 0;
+            query->pdl_state = GET_PROTOCOL_VALUE_LENGTH;
+            query->protocol_value_bytes_received = 0;
             break;
         
         case GET_PROTOCOL_VALUE_LENGTH:
-            protocol_offset++;
+            query->protocol_offset++;
 
-            if (!de_state_size(data, &de_header_state)) break;
+            if (!de_state_size(data, &query->de_header_state)) break;
 
-            protocol_value_size = de_header_state.de_size;
-            pdl_state = GET_PROTOCOL_VALUE;
-            sdp_rfcomm_channel_nr = 0;
+            query->protocol_value_size = query->de_header_state.de_size;
+            query->pdl_state = GET_PROTOCOL_VALUE;
+            query->sdp_rfcomm_channel_nr = 0;
             break;
         
         case GET_PROTOCOL_VALUE:
-            protocol_offset++;
-            protocol_value_bytes_received++;
+            query->protocol_offset++;
+            query->protocol_value_bytes_received++;
            
             // log_info("   query: protocol_value_bytes_received %u, protocol_value_size %u", protocol_value_bytes_received, protocol_value_size);
 
-            if (protocol_value_bytes_received < protocol_value_size) break;
+            if (query->protocol_value_bytes_received < query->protocol_value_size) break;
 
-            if (protocol_id == BLUETOOTH_PROTOCOL_RFCOMM){
+            if (query->protocol_id == BLUETOOTH_PROTOCOL_RFCOMM){
                 //  log_info("\n\n *******  Data ***** %02x\n\n", data);
-                sdp_rfcomm_channel_nr = data;
+                query->sdp_rfcomm_channel_nr = data;
             }
 
             // log_info("   query: protocol done");
             // log_info("   query: Protocol offset %u, protocol size %u", protocol_offset, protocol_size);
 
-            if (protocol_offset >= protocol_size) {
-                pdl_state = GET_PROTOCOL_LENGTH;
+            if (query->protocol_offset >= query->protocol_size) {
+                query->pdl_state = GET_PROTOCOL_LENGTH;
                 break;
 
             }
-            pdl_state = GET_PROTOCOL_ID_HEADER_LENGTH;
+            query->pdl_state = GET_PROTOCOL_ID_HEADER_LENGTH;
             // log_info("   query: Get next protocol");
             break;
         default:
@@ -202,62 +422,77 @@ static void sdp_client_query_rfcomm_handle_protocol_descriptor_list_data(uint32_
     }
 }
 
-static void sdp_client_query_rfcomm_handle_service_name_data(uint32_t attribute_value_length, uint32_t data_offset, uint8_t data){
+static void sdp_client_query_rfcomm_handle_service_name_data(sdp_client_rfcomm_query_t * query, uint32_t attribute_value_length, uint32_t data_offset, uint8_t data){
 
     // Get Header Len
     if (data_offset == 0){
-        de_state_size(data, &sn_de_header_state);
-        sdp_service_name_header_size = sn_de_header_state.addon_header_bytes + 1;
+        de_state_size(data, &query->sn_de_header_state);
+        query->sdp_service_name_header_size = query->sn_de_header_state.addon_header_bytes + 1;
         return;
     }
 
     // Get Header
-    if (data_offset < sdp_service_name_header_size){
-        de_state_size(data, &sn_de_header_state);
+    if (data_offset < query->sdp_service_name_header_size){
+        de_state_size(data, &query->sn_de_header_state);
         return;
     }
 
     // Process payload
-    int name_len = attribute_value_length - sdp_service_name_header_size;
-    int name_pos = data_offset - sdp_service_name_header_size;
+    int name_len = attribute_value_length - query->sdp_service_name_header_size;
+    int name_pos = data_offset - query->sdp_service_name_header_size;
 
     if (name_pos < SDP_SERVICE_NAME_LEN){
-        sdp_service_name[name_pos] = data;
+        query->sdp_service_name[name_pos] = data;
         name_pos++;
 
         // terminate if name complete
         if (name_pos >= name_len){
-            sdp_service_name[name_pos] = 0;
-            sdp_service_name_len = name_pos;            
+            query->sdp_service_name[name_pos] = 0;
+            query->sdp_service_name_len = name_pos;
         } 
 
         // terminate if buffer full
         if (name_pos == SDP_SERVICE_NAME_LEN){
-            sdp_service_name[name_pos] = 0;            
-            sdp_service_name_len = name_pos;            
+            query->sdp_service_name[name_pos] = 0;
+            query->sdp_service_name_len = name_pos;
         }
     }
 
     // notify on last char
-    if ((data_offset == (attribute_value_length - 1)) && (sdp_rfcomm_channel_nr!=0)){
-        sdp_rfcomm_query_emit_service();
+    if ((data_offset == (attribute_value_length - 1)) && (query->sdp_rfcomm_channel_nr!=0)){
+        sdp_rfcomm_query_emit_service(query);
     }
 }
 
+static sdp_client_rfcomm_query_t * sdp_client_query_rfcomm_for_cid(uint16_t sdp_cid){
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        sdp_client_rfcomm_query_t * query = &sdp_client_rfcomm_queries[i];
+        if (query->sdp_app_callback == NULL) continue;
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+        if (query->cached) continue;
+#endif
+        if (query->sdp_cid == sdp_cid) return query;
+    }
+    return NULL;
+}
+
 static void sdp_client_query_rfcomm_handle_sdp_parser_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     UNUSED(packet_type);
-    UNUSED(channel);
+
+    sdp_client_rfcomm_query_t * query = sdp_client_query_rfcomm_for_cid(channel);
+    if (query == NULL) return;
 
     switch (hci_event_packet_get_type(packet)){
         case SDP_EVENT_QUERY_SERVICE_RECORD_HANDLE:
             // handle service without a name
-            if (sdp_rfcomm_channel_nr){
-                sdp_rfcomm_query_emit_service();
+            if (query->sdp_rfcomm_channel_nr){
+                sdp_rfcomm_query_emit_service(query);
             }
 
             // prepare for new record
-            sdp_rfcomm_channel_nr = 0;
-            sdp_service_name[0] = 0;
+            query->sdp_rfcomm_channel_nr = 0;
+            query->sdp_service_name[0] = 0;
             break;
         case SDP_EVENT_QUERY_ATTRIBUTE_VALUE:
             // log_info("sdp_client_query_rfcomm_handle_sdp_parser_event [ AID, ALen, DOff, Data] : [%x, %u, %u] BYTE %02x", 
@@ -266,13 +501,13 @@ static void sdp_client_query_rfcomm_handle_sdp_parser_event(uint8_t packet_type,
             switch (sdp_event_query_attribute_byte_get_attribute_id(packet)){
                 case BLUETOOTH_ATTRIBUTE_PROTOCOL_DESCRIPTOR_LIST:
                     // find rfcomm channel
-                    sdp_client_query_rfcomm_handle_protocol_descriptor_list_data(sdp_event_query_attribute_byte_get_attribute_length(packet),
+                    sdp_client_query_rfcomm_handle_protocol_descriptor_list_data(query, sdp_event_query_attribute_byte_get_attribute_length(packet),
                         sdp_event_query_attribute_byte_get_data_offset(packet),
                         sdp_event_query_attribute_byte_get_data(packet));
                     break;
                 case 0x0100:
                     // get service name
-                    sdp_client_query_rfcomm_handle_service_name_data(sdp_event_query_attribute_byte_get_attribute_length(packet),
+                    sdp_client_query_rfcomm_handle_service_name_data(query, sdp_event_query_attribute_byte_get_attribute_length(packet),
                         sdp_event_query_attribute_byte_get_data_offset(packet),
                         sdp_event_query_attribute_byte_get_data(packet));
                     break;
@@ -281,25 +516,51 @@ static void sdp_client_query_rfcomm_handle_sdp_parser_event(uint8_t packet_type,
                     return;
             }
             break;
-        case SDP_EVENT_QUERY_COMPLETE:
+        case SDP_EVENT_QUERY_COMPLETE: {
             // handle service without a name
-            if (sdp_rfcomm_channel_nr){
-                sdp_rfcomm_query_emit_service();
+            if (query->sdp_rfcomm_channel_nr){
+                sdp_rfcomm_query_emit_service(query);
+            }
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+            if (sdp_event_query_complete_get_status(packet) == ERROR_CODE_SUCCESS){
+                sdp_client_rfcomm_cache_store(query);
             }
-            (*sdp_app_callback)(HCI_EVENT_PACKET, 0, packet, size); 
+#endif
+            // free query before emitting event, callback might start new query
+            btstack_packet_handler_t callback = query->sdp_app_callback;
+            query->sdp_app_callback = NULL;
+            (*callback)(HCI_EVENT_PACKET, channel, packet, size);
+            break;
+        }
+        default:
             break;
     }
     // insert higher level code HERE
 }
 
+static void sdp_client_query_rfcomm_init_query(sdp_client_rfcomm_query_t * query){
+    de_state_init(&query->de_header_state);
+    de_state_init(&query->sn_de_header_state);
+    query->pdl_state = GET_PROTOCOL_LIST_LENGTH;
+    query->protocol_offset = 0;
+    query->sdp_rfcomm_channel_nr = 0;
+    query->sdp_service_name_len = 0;
+    query->sdp_service_name[0] = 0;
+}
+
 void sdp_client_query_rfcomm_init(void){
     // init
-    de_state_init(&de_header_state);
-    de_state_init(&sn_de_header_state);
-    pdl_state = GET_PROTOCOL_LIST_LENGTH;
-    protocol_offset = 0;
-    sdp_rfcomm_channel_nr = 0;
-    sdp_service_name[0] = 0;
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        sdp_client_rfcomm_queries[i].sdp_app_callback = NULL;
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+        if (sdp_client_rfcomm_queries[i].cached){
+            btstack_run_loop_remove_timer(&sdp_client_rfcomm_queries[i].cache_timer);
+            sdp_client_rfcomm_queries[i].cached = 0;
+        }
+#endif
+        sdp_client_query_rfcomm_init_query(&sdp_client_rfcomm_queries[i]);
+    }
 }
 
 // Public API
@@ -307,9 +568,38 @@ void sdp_client_query_rfcomm_init(void){
 uint8_t sdp_client_query_rfcomm_channel_and_name_for_search_pattern(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * service_search_pattern){
     if (!sdp_client_ready()) return SDP_QUERY_BUSY;
 
-    sdp_app_callback = callback;
-    sdp_client_query_rfcomm_init();
-    return sdp_client_query(&sdp_client_query_rfcomm_handle_sdp_parser_event, remote, service_search_pattern, (uint8_t*)&des_attributeIDList[0]);
+    sdp_client_rfcomm_query_t * query = NULL;
+    int i;
+    for (i = 0; i < SDP_CLIENT_MAX_CONCURRENT_QUERIES; i++){
+        if (sdp_client_rfcomm_queries[i].sdp_app_callback == NULL){
+            query = &sdp_client_rfcomm_queries[i];
+            break;
+        }
+    }
+    if (query == NULL) return SDP_QUERY_BUSY;
+
+    sdp_client_query_rfcomm_init_query(query);
+
+#ifdef ENABLE_SDP_CLIENT_RFCOMM_CACHE
+    // deliver result from cache via run loop
+    if (sdp_client_rfcomm_cache_lookup(query, remote, service_search_pattern)){
+        query->sdp_app_callback = callback;
+        query->sdp_cid = 0;
+        query->cached = 1;
+        btstack_run_loop_set_timer_handler(&query->cache_timer, &sdp_client_rfcomm_cache_handle_timeout);
+        btstack_run_loop_set_timer_context(&query->cache_timer, query);
+        btstack_run_loop_set_timer(&query->cache_timer, 0);
+        btstack_run_loop_add_timer(&query->cache_timer);
+        return ERROR_CODE_SUCCESS;
+    }
+    sdp_client_rfcomm_cache_prepare(query, remote, service_search_pattern);
+#endif
+
+    uint8_t status = sdp_client_query_with_cid(&sdp_client_query_rfcomm_handle_sdp_parser_event, remote, service_search_pattern, (uint8_t*)&des_attributeIDList[0], &query->sdp_cid);
+    if (status == ERROR_CODE_SUCCESS){
+        query->sdp_app_callback = callback;
+    }
+    return status;
 }
 
 uint8_t sdp_client_query_rfcomm_channel_and_name_for_uuid(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid16){
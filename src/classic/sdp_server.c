@@ -70,6 +70,17 @@
 #define SDP_RESPONSE_BUFFER_SIZE (HCI_ACL_PAYLOAD_SIZE-L2CAP_HEADER_SIZE)
 #endif
 
+#ifdef ENABLE_SDP_SERVER_RESPONSE_CACHE
+// size of cached ServiceSearchAttribute response (complete AttributeLists)
+#ifndef SDP_SERVER_RESPONSE_CACHE_SIZE
+#define SDP_SERVER_RESPONSE_CACHE_SIZE 512
+#endif
+// max size of ServiceSearchPattern and AttributeIDList of cached response
+#ifndef SDP_SERVER_RESPONSE_CACHE_KEY_SIZE
+#define SDP_SERVER_RESPONSE_CACHE_KEY_SIZE 64
+#endif
+#endif
+
 static void sdp_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 
 // registered service records
@@ -85,6 +96,15 @@ static uint16_t sdp_response_size = 0;
 static uint16_t l2cap_waiting_list_cids[SDP_WAITING_LIST_MAX_COUNT];
 static int      l2cap_waiting_list_count;
 
+#ifdef ENABLE_SDP_SERVER_RESPONSE_CACHE
+// AttributeLists of last ServiceSearchAttribute response, invalid if len == 0
+static uint8_t  sdp_response_cache[SDP_SERVER_RESPONSE_CACHE_SIZE];
+static uint16_t sdp_response_cache_len;
+// ServiceSearchPattern followed by AttributeIDList
+static uint8_t  sdp_response_cache_key[SDP_SERVER_RESPONSE_CACHE_KEY_SIZE];
+static uint16_t sdp_response_cache_key_len;
+#endif
+
 void sdp_init(void){
     // register with l2cap psm sevices - max MTU
     l2cap_register_service(sdp_packet_handler, BLUETOOTH_PSM_SDP, 0xffff, LEVEL_0);
@@ -117,6 +137,171 @@ uint8_t * sdp_get_record_for_handle(uint32_t handle){
     return record_item->service_record;
 }
 
+#ifdef ENABLE_SDP_SERVER_UUID_INDEX
+// @returns 0 if UUIDs of record cannot be indexed
+static int sdp_server_uuid_index_add_sequence(service_record_item_t * item, uint8_t * des){
+    des_iterator_t it;
+    if (!des_iterator_init(&it, des)) return 1;
+    for ( ; des_iterator_has_more(&it) ; des_iterator_next(&it)){
+        uint8_t * element = des_iterator_get_element(&it);
+        switch (des_iterator_get_type(&it)){
+            case DE_DES:
+                if (!sdp_server_uuid_index_add_sequence(item, element)) return 0;
+                break;
+            case DE_UUID: {
+                // 128-bit UUIDs without Bluetooth Base UUID are not indexed
+                uint32_t uuid32 = de_get_uuid32(element);
+                if (uuid32 == 0) return 0;
+                int i;
+                for (i = 0; i < item->uuid_count; i++){
+                    if (item->uuids[i] == uuid32) break;
+                }
+                if (i < item->uuid_count) break;
+                if (item->uuid_count >= SDP_SERVER_UUID_INDEX_SIZE) return 0;
+                item->uuids[item->uuid_count++] = uuid32;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return 1;
+}
+
+static void sdp_server_uuid_index_build(service_record_item_t * item){
+    item->uuid_count = 0;
+    item->uuid_index_valid = sdp_server_uuid_index_add_sequence(item, item->service_record);
+}
+#endif
+
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+// record index generated by compile_sdp.py:
+// - version (8), flags (8), num UUIDs (8), UUID32 (32) of all UUIDs in record
+// - num attributes (16), attribute ID (16) and offset of attribute in record (16) for all attributes, record size (16)
+// all values are little endian
+#define SDP_SERVER_RECORD_INDEX_VERSION 1
+// record contains 128-bit UUIDs that are not based on the Bluetooth Base UUID
+#define SDP_SERVER_RECORD_INDEX_FLAG_UUID128 0x01
+
+static const uint8_t * sdp_server_record_index_attributes(const uint8_t * record_index, uint16_t * num_attributes){
+    uint16_t pos = 3 + (4 * record_index[2]);
+    *num_attributes = little_endian_read_16(record_index, pos);
+    return &record_index[pos + 2];
+}
+
+static int sdp_server_record_index_matches_service_search_pattern(service_record_item_t * item, uint8_t * serviceSearchPattern){
+    const uint8_t * record_index = item->record_index;
+    des_iterator_t it;
+    if (!des_iterator_init(&it, serviceSearchPattern)) return 1;
+    for ( ; des_iterator_has_more(&it) ; des_iterator_next(&it)){
+        uint32_t uuid32 = de_get_uuid32(des_iterator_get_element(&it));
+        if (uuid32 == 0){
+            // 128-bit UUID is only in record if it has such UUIDs
+            if ((record_index[1] & SDP_SERVER_RECORD_INDEX_FLAG_UUID128) == 0) return 0;
+            return sdp_record_matches_service_search_pattern(item->service_record, serviceSearchPattern);
+        }
+        uint16_t i;
+        for (i = 0; i < record_index[2]; i++){
+            if (little_endian_read_32(record_index, 3 + (4 * i)) == uuid32) break;
+        }
+        if (i == record_index[2]) return 0;
+    }
+    return 1;
+}
+
+// attribute ends at start of next attribute, last one at end of record
+static uint16_t sdp_server_record_index_attribute_len(const uint8_t * attributes, uint16_t num_attributes, uint16_t i){
+    uint16_t end_offset = (i + 1 < num_attributes) ? little_endian_read_16(attributes, (4 * i) + 6) : little_endian_read_16(attributes, 4 * num_attributes);
+    return end_offset - little_endian_read_16(attributes, (4 * i) + 2);
+}
+
+// attribute ID and value are stored contiguously in the record, as they are sent in an AttributeList
+static uint16_t sdp_server_record_index_get_filtered_size(service_record_item_t * item, uint8_t * attributeIDList){
+    uint16_t num_attributes;
+    const uint8_t * attributes = sdp_server_record_index_attributes(item->record_index, &num_attributes);
+    uint16_t size = 0;
+    uint16_t i;
+    for (i = 0; i < num_attributes; i++){
+        if (!sdp_attribute_list_constains_id(attributeIDList, little_endian_read_16(attributes, 4 * i))) continue;
+        size += sdp_server_record_index_attribute_len(attributes, num_attributes, i);
+    }
+    return size;
+}
+
+static int sdp_server_record_index_filter_attributes(service_record_item_t * item, uint8_t * attributeIDList, uint16_t startOffset, uint16_t maxBytes, uint16_t *usedBytes, uint8_t *buffer){
+    uint16_t num_attributes;
+    const uint8_t * attributes = sdp_server_record_index_attributes(item->record_index, &num_attributes);
+    uint16_t used_bytes = 0;
+    int complete = 1;
+    uint16_t i;
+    for (i = 0; i < num_attributes; i++){
+        if (!sdp_attribute_list_constains_id(attributeIDList, little_endian_read_16(attributes, 4 * i))) continue;
+        uint16_t attribute_offset = little_endian_read_16(attributes, (4 * i) + 2);
+        uint16_t attribute_len    = sdp_server_record_index_attribute_len(attributes, num_attributes, i);
+        if (startOffset >= attribute_len){
+            startOffset -= attribute_len;
+            continue;
+        }
+        uint16_t bytes_to_copy = attribute_len - startOffset;
+        if (bytes_to_copy > maxBytes){
+            bytes_to_copy = maxBytes;
+            complete = 0;
+        }
+        (void)memcpy(&buffer[used_bytes], &item->service_record[attribute_offset + startOffset], bytes_to_copy);
+        used_bytes += bytes_to_copy;
+        maxBytes   -= bytes_to_copy;
+        startOffset = 0;
+        if (!complete) break;
+    }
+    *usedBytes = used_bytes;
+    return complete;
+}
+#endif
+
+static uint16_t sdp_server_get_filtered_size(service_record_item_t * item, uint8_t * attributeIDList){
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+    if (item->record_index != NULL){
+        return sdp_server_record_index_get_filtered_size(item, attributeIDList);
+    }
+#endif
+    return spd_get_filtered_size(item->service_record, attributeIDList);
+}
+
+static int sdp_server_filter_attributes(service_record_item_t * item, uint8_t * attributeIDList, uint16_t startOffset, uint16_t maxBytes, uint16_t *usedBytes, uint8_t *buffer){
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+    if (item->record_index != NULL){
+        return sdp_server_record_index_filter_attributes(item, attributeIDList, startOffset, maxBytes, usedBytes, buffer);
+    }
+#endif
+    return sdp_filter_attributes_in_attributeIDList(item->service_record, attributeIDList, startOffset, maxBytes, usedBytes, buffer);
+}
+
+static int sdp_server_record_matches_service_search_pattern(service_record_item_t * item, uint8_t * serviceSearchPattern){
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+    if (item->record_index != NULL){
+        return sdp_server_record_index_matches_service_search_pattern(item, serviceSearchPattern);
+    }
+#endif
+#ifdef ENABLE_SDP_SERVER_UUID_INDEX
+    if (item->uuid_index_valid){
+        des_iterator_t it;
+        if (!des_iterator_init(&it, serviceSearchPattern)) return 1;
+        for ( ; des_iterator_has_more(&it) ; des_iterator_next(&it)){
+            // record only contains UUIDs based on Bluetooth Base UUID
+            uint32_t uuid32 = de_get_uuid32(des_iterator_get_element(&it));
+            if (uuid32 == 0) return 0;
+            int i;
+            for (i = 0; i < item->uuid_count; i++){
+                if (item->uuids[i] == uuid32) break;
+            }
+            if (i == item->uuid_count) return 0;
+        }
+        return 1;
+    }
+#endif
+    return sdp_record_matches_service_search_pattern(item->service_record, serviceSearchPattern);
+}
+
 // get next free, unregistered service record handle
 uint32_t sdp_create_service_record_handle(void){
     uint32_t handle = 0;
@@ -149,7 +334,17 @@ uint8_t sdp_register_service(const uint8_t * record){
     // set handle and record
     newRecordItem->service_record_handle = record_handle;
     newRecordItem->service_record = (uint8_t*) record;
-    
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+    newRecordItem->record_index = NULL;
+#endif
+
+#ifdef ENABLE_SDP_SERVER_UUID_INDEX
+    sdp_server_uuid_index_build(newRecordItem);
+#endif
+#ifdef ENABLE_SDP_SERVER_RESPONSE_CACHE
+    sdp_response_cache_len = 0;
+#endif
+
     // add to linked list
     btstack_linked_list_add(&sdp_service_records, (btstack_linked_item_t *) newRecordItem);
     
@@ -164,8 +359,32 @@ void sdp_unregister_service(uint32_t service_record_handle){
     if (!record_item) return;
     btstack_linked_list_remove(&sdp_service_records, (btstack_linked_item_t *) record_item);
     btstack_memory_service_record_item_free(record_item);
+#ifdef ENABLE_SDP_SERVER_RESPONSE_CACHE
+    sdp_response_cache_len = 0;
+#endif
 }
 
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+uint8_t sdp_register_service_with_index(const uint8_t * record, const uint8_t * record_index){
+    if (record_index[0] != SDP_SERVER_RECORD_INDEX_VERSION){
+        log_error("SDP record index version differs, please regenerate .h from .sdp file");
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+    // index has to describe this record
+    uint16_t num_attributes;
+    const uint8_t * attributes = sdp_server_record_index_attributes(record_index, &num_attributes);
+    if (little_endian_read_16(attributes, 4 * num_attributes) != de_get_len(record)){
+        log_error("SDP record index does not match record");
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+    uint8_t status = sdp_register_service(record);
+    if (status != ERROR_CODE_SUCCESS) return status;
+    service_record_item_t * item = sdp_get_record_item_for_handle(sdp_get_service_record_handle(record));
+    item->record_index = record_index;
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 // PDU
 // PDU ID (1), Transaction ID (2), Param Length (2), Param 1, Param 2, ..
 
@@ -212,7 +431,7 @@ int sdp_handle_service_search_request(uint8_t * packet, uint16_t remote_mtu){
     uint16_t total_service_count   = 0;
     for (it = (btstack_linked_item_t *) sdp_service_records; it ; it = it->next){
         service_record_item_t * item = (service_record_item_t *) it;
-        if (!sdp_record_matches_service_search_pattern(item->service_record, serviceSearchPattern)) continue;
+        if (!sdp_server_record_matches_service_search_pattern(item, serviceSearchPattern)) continue;
         total_service_count++;
     }
     if (total_service_count > maximumServiceRecordCount){
@@ -227,7 +446,7 @@ int sdp_handle_service_search_request(uint8_t * packet, uint16_t remote_mtu){
     for (it = (btstack_linked_item_t *) sdp_service_records; it ; it = it->next, ++current_service_index){
         service_record_item_t * item = (service_record_item_t *) it;
 
-        if (!sdp_record_matches_service_search_pattern(item->service_record, serviceSearchPattern)) continue;
+        if (!sdp_server_record_matches_service_search_pattern(item, serviceSearchPattern)) continue;
         matching_service_count++;
         
         if (current_service_index < continuation_index) continue;
@@ -311,7 +530,7 @@ int sdp_handle_service_attribute_request(uint8_t * packet, uint16_t remote_mtu){
     if (continuation_offset == 0){
         
         // get size of this record
-        uint16_t filtered_attributes_size = spd_get_filtered_size(item->service_record, attributeIDList);
+        uint16_t filtered_attributes_size = sdp_server_get_filtered_size(item, attributeIDList);
         
         // store DES
         de_store_descriptor_with_len(&sdp_response_buffer[pos], DE_DES, DE_SIZE_VAR_16, filtered_attributes_size);
@@ -321,7 +540,7 @@ int sdp_handle_service_attribute_request(uint8_t * packet, uint16_t remote_mtu){
 
     // copy maximumAttributeByteCount from record
     uint16_t bytes_used;
-    int complete = sdp_filter_attributes_in_attributeIDList(item->service_record, attributeIDList, continuation_offset, maximumAttributeByteCount, &bytes_used, &sdp_response_buffer[pos]);
+    int complete = sdp_server_filter_attributes(item, attributeIDList, continuation_offset, maximumAttributeByteCount, &bytes_used, &sdp_response_buffer[pos]);
     pos += bytes_used;
     
     uint16_t attributeListByteCount = pos - 7;
@@ -350,14 +569,79 @@ static uint16_t sdp_get_size_for_service_search_attribute_response(uint8_t * ser
     for (it = (btstack_linked_item_t *) sdp_service_records; it ; it = it->next){
         service_record_item_t * item = (service_record_item_t *) it;
         
-        if (!sdp_record_matches_service_search_pattern(item->service_record, serviceSearchPattern)) continue;
+        if (!sdp_server_record_matches_service_search_pattern(item, serviceSearchPattern)) continue;
         
         // for all service records that match
-        total_response_size += 3 + spd_get_filtered_size(item->service_record, attributeIDList);
+        total_response_size += 3 + sdp_server_get_filtered_size(item, attributeIDList);
     }
     return total_response_size;
 }
 
+#ifdef ENABLE_SDP_SERVER_RESPONSE_CACHE
+static int sdp_response_cache_matches(const uint8_t * serviceSearchPattern, uint16_t serviceSearchPatternLen, const uint8_t * attributeIDList, uint16_t attributeIDListLen){
+    if (sdp_response_cache_len == 0) return 0;
+    if (sdp_response_cache_key_len != (serviceSearchPatternLen + attributeIDListLen)) return 0;
+    if (memcmp(sdp_response_cache_key, serviceSearchPattern, serviceSearchPatternLen) != 0) return 0;
+    return memcmp(&sdp_response_cache_key[serviceSearchPatternLen], attributeIDList, attributeIDListLen) == 0;
+}
+
+// serialize complete AttributeLists into cache, @returns 0 if it doesn't fit
+static int sdp_response_cache_fill(uint8_t * serviceSearchPattern, uint16_t serviceSearchPatternLen, uint8_t * attributeIDList, uint16_t attributeIDListLen){
+    sdp_response_cache_len = 0;
+    if ((serviceSearchPatternLen + attributeIDListLen) > SDP_SERVER_RESPONSE_CACHE_KEY_SIZE) return 0;
+    uint16_t total_response_size = sdp_get_size_for_service_search_attribute_response(serviceSearchPattern, attributeIDList);
+    if ((total_response_size + 3) > SDP_SERVER_RESPONSE_CACHE_SIZE) return 0;
+
+    de_store_descriptor_with_len(&sdp_response_cache[0], DE_DES, DE_SIZE_VAR_16, total_response_size);
+    uint16_t pos = 3;
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) sdp_service_records; it ; it = it->next){
+        service_record_item_t * item = (service_record_item_t *) it;
+        if (!sdp_server_record_matches_service_search_pattern(item, serviceSearchPattern)) continue;
+        uint16_t filtered_attributes_size = sdp_server_get_filtered_size(item, attributeIDList);
+        de_store_descriptor_with_len(&sdp_response_cache[pos], DE_DES, DE_SIZE_VAR_16, filtered_attributes_size);
+        pos += 3;
+        uint16_t bytes_used;
+        (void) sdp_server_filter_attributes(item, attributeIDList, 0, SDP_SERVER_RESPONSE_CACHE_SIZE - pos, &bytes_used, &sdp_response_cache[pos]);
+        pos += bytes_used;
+    }
+
+    (void)memcpy(sdp_response_cache_key, serviceSearchPattern, serviceSearchPatternLen);
+    (void)memcpy(&sdp_response_cache_key[serviceSearchPatternLen], attributeIDList, attributeIDListLen);
+    sdp_response_cache_key_len = serviceSearchPatternLen + attributeIDListLen;
+    sdp_response_cache_len = pos;
+    return 1;
+}
+
+// continuation state for cached response contains: offset into AttributeLists
+static int sdp_response_cache_create_response(uint16_t transaction_id, uint16_t offset, uint16_t maximumAttributeByteCount){
+    uint16_t attributeListsByteCount = sdp_response_cache_len - offset;
+    if (attributeListsByteCount > maximumAttributeByteCount){
+        attributeListsByteCount = maximumAttributeByteCount;
+    }
+    uint16_t pos = 7;
+    (void)memcpy(&sdp_response_buffer[pos], &sdp_response_cache[offset], attributeListsByteCount);
+    pos += attributeListsByteCount;
+    offset += attributeListsByteCount;
+
+    // Continuation State
+    if (offset < sdp_response_cache_len){
+        sdp_response_buffer[pos++] = 2;
+        big_endian_store_16(sdp_response_buffer, pos, offset);
+        pos += 2;
+    } else {
+        sdp_response_buffer[pos++] = 0;
+    }
+
+    // create SDP header
+    sdp_response_buffer[0] = SDP_ServiceSearchAttributeResponse;
+    big_endian_store_16(sdp_response_buffer, 1, transaction_id);
+    big_endian_store_16(sdp_response_buffer, 3, pos - 5);  // size of variable payload
+    big_endian_store_16(sdp_response_buffer, 5, attributeListsByteCount);
+    return pos;
+}
+#endif
+
 int sdp_handle_service_search_attribute_request(uint8_t * packet, uint16_t remote_mtu){
     
     // SDP header before attribute sevice list: 7
@@ -391,6 +675,25 @@ int sdp_handle_service_search_attribute_request(uint8_t * packet, uint16_t remot
         maximumAttributeByteCount = maximumAttributeByteCount2;
     }
     
+#ifdef ENABLE_SDP_SERVER_RESPONSE_CACHE
+    if (maximumAttributeByteCount > 0){
+        if (continuationState[0] == 2){
+            uint16_t cache_offset = big_endian_read_16(continuationState, 1);
+            if (!sdp_response_cache_matches(serviceSearchPattern, serviceSearchPatternLen, attributeIDList, attributeIDListLen) || (cache_offset >= sdp_response_cache_len)){
+                // cache invalidated by service record (un)registration
+                return sdp_create_error_response(transaction_id, 0x0005); /// invalid Continuation State
+            }
+            return sdp_response_cache_create_response(transaction_id, cache_offset, maximumAttributeByteCount);
+        }
+        if (continuationState[0] == 0){
+            if (sdp_response_cache_matches(serviceSearchPattern, serviceSearchPatternLen, attributeIDList, attributeIDListLen) ||
+                sdp_response_cache_fill(serviceSearchPattern, serviceSearchPatternLen, attributeIDList, attributeIDListLen)){
+                return sdp_response_cache_create_response(transaction_id, 0, maximumAttributeByteCount);
+            }
+        }
+    }
+#endif
+
     // continuation state contains: index of next service record to examine
     // continuation state contains: byte offset into this service record
     uint16_t continuation_service_index = 0;
@@ -423,12 +726,12 @@ int sdp_handle_service_search_attribute_request(uint8_t * packet, uint16_t remot
         service_record_item_t * item = (service_record_item_t *) it;
         
         if (current_service_index < continuation_service_index ) continue;
-        if (!sdp_record_matches_service_search_pattern(item->service_record, serviceSearchPattern)) continue;
+        if (!sdp_server_record_matches_service_search_pattern(item, serviceSearchPattern)) continue;
 
         if (continuation_offset == 0){
             
             // get size of this record
-            uint16_t filtered_attributes_size = spd_get_filtered_size(item->service_record, attributeIDList);
+            uint16_t filtered_attributes_size = sdp_server_get_filtered_size(item, attributeIDList);
             
             // stop if complete record doesn't fits into response but we already have a partial response
             if (((filtered_attributes_size + 3) > maximumAttributeByteCount) && !first_answer) {
@@ -446,7 +749,7 @@ int sdp_handle_service_search_attribute_request(uint8_t * packet, uint16_t remot
     
         // copy maximumAttributeByteCount from record
         uint16_t bytes_used;
-        int complete = sdp_filter_attributes_in_attributeIDList(item->service_record, attributeIDList, continuation_offset, maximumAttributeByteCount, &bytes_used, &sdp_response_buffer[pos]);
+        int complete = sdp_server_filter_attributes(item, attributeIDList, continuation_offset, maximumAttributeByteCount, &bytes_used, &sdp_response_buffer[pos]);
         pos += bytes_used;
         maximumAttributeByteCount -= bytes_used;
         
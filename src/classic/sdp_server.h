@@ -42,6 +42,13 @@
 
 #include "btstack_config.h"
 
+#ifdef ENABLE_SDP_SERVER_UUID_INDEX
+// max number of different UUIDs per service record, records with more UUIDs or 128-bit UUIDs are matched against pattern directly
+#ifndef SDP_SERVER_UUID_INDEX_SIZE
+#define SDP_SERVER_UUID_INDEX_SIZE 12
+#endif
+#endif
+
 #if defined __cplusplus
 extern "C" {
 #endif
@@ -52,6 +59,16 @@ typedef struct {
 
     uint32_t        service_record_handle;
     uint8_t *       service_record;
+#ifdef ENABLE_SDP_SERVER_UUID_INDEX
+    // UUID16/UUID32 of all UUIDs in record, only used if uuid_index_valid
+    uint8_t         uuid_index_valid;
+    uint8_t         uuid_count;
+    uint32_t        uuids[SDP_SERVER_UUID_INDEX_SIZE];
+#endif
+#ifdef ENABLE_SDP_SERVER_RECORD_INDEX
+    // UUIDs and attribute offsets generated by compile_sdp.py, NULL if not provided
+    const uint8_t * record_index;
+#endif
 } service_record_item_t;
 
 int sdp_handle_service_search_request(uint8_t * packet, uint16_t remote_mtu);
@@ -74,6 +91,16 @@ void sdp_init(void);
  */
 uint8_t sdp_register_service(const uint8_t * record);
 
+/**
+ * @brief Register Service Record generated by compile_sdp.py together with its record index
+ * @note requires ENABLE_SDP_SERVER_RECORD_INDEX. UUID matching and attribute responses use the
+ *       precomputed index instead of parsing the record
+ * @param record is not copied!
+ * @param record_index generated for record, is not copied!
+ * @result status
+ */
+uint8_t sdp_register_service_with_index(const uint8_t * record, const uint8_t * record_index);
+
 /** 
  * @brief Unregister service record internally.
  */
@@ -42,10 +42,22 @@
 extern "C" {
 #endif
 
+#include "btstack_config.h"
 #include "btstack_defines.h"
+#include "btstack_linked_list.h"
 #include "btstack_util.h"
 #include "classic/btstack_link_key_db.h"
 
+// max number of CIS per CIG for gap_cig_create
+#ifndef MAX_NR_CIS
+#define MAX_NR_CIS 4
+#endif
+
+// max number of BIS per BIG for gap_big_create and gap_big_sync_create
+#ifndef MAX_NR_BIS
+#define MAX_NR_BIS 4
+#endif
+
 typedef enum {
 
 	// MITM protection not required
@@ -97,6 +109,11 @@ typedef struct le_connection_parameter_range{
     uint16_t le_supervision_timeout_max;
 } le_connection_parameter_range_t;
 
+typedef enum {
+    PAGE_SCAN_TYPE_STANDARD = 0,
+    PAGE_SCAN_TYPE_INTERLACED,
+} page_scan_type_t;
+
 typedef enum {
     GAP_RANDOM_ADDRESS_TYPE_OFF = 0,
     GAP_RANDOM_ADDRESS_TYPE_STATIC,
@@ -104,6 +121,146 @@ typedef enum {
     GAP_RANDOM_ADDRESS_RESOLVABLE,
 } gap_random_address_type_t;
 
+// Filter applied to LE Advertising Reports before GAP_EVENT_ADVERTISING_REPORT is emitted
+typedef struct {
+    // drop reports with same address, event type, and data received within window, 0 = no deduplication
+    uint16_t dedup_window_ms;
+    // drop reports with lower RSSI, -127 = any
+    int8_t   rssi_min;
+    // only pass reports that contain AD type, 0 = any
+    uint8_t  ad_type;
+    // only pass reports that list 16-bit Service UUID, 0 = any
+    uint16_t uuid16;
+    // only pass reports with Manufacturer Specific Data of company_id
+    bool     company_id_match;
+    uint16_t company_id;
+} gap_le_advertising_report_filter_t;
+
+// Automatic LE 2M PHY and Data Length upgrade, requires ENABLE_LE_LINK_UPGRADE
+typedef enum {
+    GAP_LE_LINK_UPGRADE_DISABLED = 0,
+    GAP_LE_LINK_UPGRADE_AFTER_CONNECTION,
+    GAP_LE_LINK_UPGRADE_AFTER_ENCRYPTION,
+} gap_le_link_upgrade_mode_t;
+
+// LE Connection Parameter Profiles, requires ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+typedef enum {
+    GAP_LE_CONNECTION_PROFILE_NONE = 0,
+    GAP_LE_CONNECTION_PROFILE_BULK_TRANSFER,
+    GAP_LE_CONNECTION_PROFILE_LOW_LATENCY,
+    GAP_LE_CONNECTION_PROFILE_LOW_POWER,
+    // bulk transfer while ACL data is exchanged, low power after GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS
+    GAP_LE_CONNECTION_PROFILE_AUTO,
+} gap_le_connection_profile_t;
+
+// LE Connected Isochronous Group (CIG), requires ENABLE_LE_ISOCHRONOUS_STREAMS
+typedef struct {
+    uint8_t  cis_id;
+    uint16_t max_sdu_c_to_p;
+    uint16_t max_sdu_p_to_c;
+    uint8_t  phy_c_to_p;
+    uint8_t  phy_p_to_c;
+    uint8_t  rtn_c_to_p;
+    uint8_t  rtn_p_to_c;
+} le_audio_cis_params_t;
+
+typedef struct {
+    uint8_t  cig_id;
+    uint32_t sdu_interval_c_to_p;
+    uint32_t sdu_interval_p_to_c;
+    uint8_t  worst_case_sca;
+    uint8_t  packing;
+    uint8_t  framing;
+    uint16_t max_transport_latency_c_to_p;
+    uint16_t max_transport_latency_p_to_c;
+    uint8_t  num_cis;
+    le_audio_cis_params_t cis_params[MAX_NR_CIS];
+} le_audio_cig_params_t;
+
+typedef enum {
+    LE_AUDIO_CIG_STATE_W2_CREATE,
+    LE_AUDIO_CIG_STATE_W4_CREATED,
+    LE_AUDIO_CIG_STATE_CREATED,
+    LE_AUDIO_CIG_STATE_W2_CREATE_CIS,
+    LE_AUDIO_CIG_STATE_W2_REMOVE,
+    LE_AUDIO_CIG_STATE_W4_REMOVED,
+} le_audio_cig_state_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    le_audio_cig_state_t state;
+    const le_audio_cig_params_t * params;
+    uint8_t cig_id;
+    uint8_t num_cis;
+    // valid after LE Set CIG Parameters completed
+    hci_con_handle_t cis_con_handles[MAX_NR_CIS];
+    hci_con_handle_t acl_con_handles[MAX_NR_CIS];
+} le_audio_cig_t;
+
+// LE Broadcast Isochronous Group (BIG), requires ENABLE_LE_ISOCHRONOUS_STREAMS
+typedef struct {
+    uint8_t  big_handle;
+    uint8_t  advertising_handle;
+    uint8_t  num_bis;
+    uint32_t sdu_interval_us;
+    uint16_t max_sdu;
+    uint16_t max_transport_latency_ms;
+    uint8_t  rtn;
+    uint8_t  phy;
+    uint8_t  packing;
+    uint8_t  framing;
+    uint8_t  encryption;
+    uint8_t  broadcast_code[16];
+} le_audio_big_params_t;
+
+typedef enum {
+    LE_AUDIO_BIG_STATE_W2_CREATE,
+    LE_AUDIO_BIG_STATE_W4_CREATED,
+    LE_AUDIO_BIG_STATE_CREATED,
+    LE_AUDIO_BIG_STATE_W2_TERMINATE,
+    LE_AUDIO_BIG_STATE_W4_TERMINATED,
+} le_audio_big_state_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    le_audio_big_state_t state;
+    const le_audio_big_params_t * params;
+    uint8_t big_handle;
+    uint8_t num_bis;
+    // valid after LE Create BIG Complete
+    hci_con_handle_t bis_con_handles[MAX_NR_BIS];
+} le_audio_big_t;
+
+typedef struct {
+    uint8_t  big_handle;
+    // periodic advertising train sync handle
+    hci_con_handle_t sync_handle;
+    uint8_t  encryption;
+    uint8_t  broadcast_code[16];
+    uint8_t  mse;
+    uint16_t big_sync_timeout_10ms;
+    uint8_t  num_bis;
+    uint8_t  bis_indices[MAX_NR_BIS];
+} le_audio_big_sync_params_t;
+
+typedef enum {
+    LE_AUDIO_BIG_SYNC_STATE_W2_CREATE,
+    LE_AUDIO_BIG_SYNC_STATE_W4_ESTABLISHED,
+    LE_AUDIO_BIG_SYNC_STATE_ESTABLISHED,
+    LE_AUDIO_BIG_SYNC_STATE_W2_TERMINATE,
+    LE_AUDIO_BIG_SYNC_STATE_W4_TERMINATED,
+} le_audio_big_sync_state_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    le_audio_big_sync_state_t state;
+    const le_audio_big_sync_params_t * params;
+    uint8_t big_handle;
+    uint8_t num_bis;
+    // valid after LE BIG Sync Established
+    hci_con_handle_t bis_con_handles[MAX_NR_BIS];
+} le_audio_big_sync_t;
+
 // Authorization state
 typedef enum {
     AUTHORIZATION_UNKNOWN,
@@ -176,6 +333,43 @@ void gap_set_allow_role_switch(bool allow_role_switch);
  */
 void gap_set_link_supervision_timeout(uint16_t link_supervision_timeout);
 
+/**
+ * @brief Set page timeout for outgoing classic ACL links
+ * @param page_timeout * 0.625 ms, default 0x6000 = ca. 15 seconds
+ * @note With ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING, this is the upper bound for the adapted per-device page timeout
+ */
+void gap_set_page_timeout(uint16_t page_timeout);
+
+/**
+ * @brief Set page scan interval and window
+ * @param page_scan_interval * 0.625 ms, range 0x0012..0x1000, default 0x0800 = 1.28 s
+ * @param page_scan_window * 0.625 ms, range 0x0011..page_scan_interval, default 0x0012 = 11.25 ms
+ */
+void gap_set_page_scan_activity(uint16_t page_scan_interval, uint16_t page_scan_window);
+
+/**
+ * @brief Set page scan type
+ * @note Interlaced page scan reduces the time to be found with the default page scan window by half
+ * @param page_scan_type
+ */
+void gap_set_page_scan_type(page_scan_type_t page_scan_type);
+
+/**
+ * @brief Add device to reconnection scheduler, requires ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+ * @note Targets are paged one after the other, most recently seen and strongest first. After each target has been
+ *       paged without success, the next round starts after GAP_RECONNECT_INTERVAL_MS. A target is removed when an ACL
+ *       connection to it has been established, which is reported by HCI_EVENT_CONNECTION_COMPLETE.
+ * @param addr
+ * @return status ERROR_CODE_SUCCESS, or BTSTACK_MEMORY_ALLOC_FAILED if all entries are used by other targets
+ */
+uint8_t gap_reconnect_add_device(const bd_addr_t addr);
+
+/**
+ * @brief Remove device from reconnection scheduler
+ * @param addr
+ */
+void gap_reconnect_remove_device(const bd_addr_t addr);
+
 /**
  * @brief Enable/disable bonding. Default is enabled.
  * @param enabled
@@ -283,6 +477,24 @@ void gap_start_scan(void);
  */
 void gap_stop_scan(void);
 
+/**
+ * @brief Use LE Extended Scan commands with given PHYs and parameters if supported by Controller. Requires ENABLE_LE_EXTENDED_SCANNING
+ * @note Extended Advertising Reports are emitted as GAP_EVENT_EXTENDED_ADVERTISING_REPORT, legacy PDUs as GAP_EVENT_ADVERTISING_REPORT
+ * @note Controllers may reject legacy advertising commands after extended scan commands have been used
+ * @param scan_phys bitmask of LE 1M PHY (0x01) and LE Coded PHY (0x04), 0 to use legacy scan commands
+ * @param scan_type passive (0), active (1)
+ * @param scan_interval unit: 0.625 msec, used for all PHYs
+ * @param scan_window unit: 0.625 msec, used for all PHYs
+ */
+void gap_set_extended_scan_parameters(uint8_t scan_phys, uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window);
+
+/**
+ * @brief Filter LE Advertising Reports before they are emitted as GAP_EVENT_ADVERTISING_REPORT. Requires ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+ * @note Deduplication uses a direct-mapped table of size GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE
+ * @param filter or NULL to disable filtering, has to stay valid while set
+ */
+void gap_set_advertising_report_filter(const gap_le_advertising_report_filter_t * filter);
+
 /**
  * @brief Enable privacy by using random addresses
  * @param random_address_type to use (incl. OFF)
@@ -313,6 +525,7 @@ void gap_random_address_set(bd_addr_t addr);
  * @param advertising_data (max 31 octets)
  * @note data is not copied, pointer has to stay valid
  * @note '00:00:00:00:00:00' in advertising_data will be replaced with actual bd addr
+ * @note advertising is not disabled for the update
  */
 void gap_advertisements_set_data(uint8_t advertising_data_length, uint8_t * advertising_data);
 
@@ -448,6 +661,13 @@ int gap_auto_connection_stop(bd_addr_type_t address_typ, bd_addr_t address);
  */
 void gap_auto_connection_stop_all(void);
 
+/**
+ * @brief Load LE Device DB entries into Controller Resolving List and enable address resolution in Controller.
+ * @note Done automatically on power up. Requires ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+ * @note Scanning, advertising, and connecting are paused while the Resolving List is updated
+ */
+void gap_load_resolving_list_from_le_device_db(void);
+
 /**
  * @brief Set LE PHY
  * @param con_handle
@@ -459,6 +679,134 @@ void gap_auto_connection_stop_all(void);
  */
 uint8_t gap_le_set_phy(hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys, uint8_t phy_options);
 
+/**
+ * @brief Request maximal Data Length and LE 2M PHY for new LE connections. Requires ENABLE_LE_LINK_UPGRADE
+ * @note GAP_EVENT_LE_LINK_READY is emitted with the resulting PHYs and data length, also if the upgrade failed
+ * @note Max Data Length is only requested with ENABLE_LE_DATA_LENGTH_EXTENSION
+ * @param mode default: GAP_LE_LINK_UPGRADE_AFTER_CONNECTION
+ */
+void gap_le_set_link_upgrade_mode(gap_le_link_upgrade_mode_t mode);
+
+/**
+ * @brief Configure connection parameters used for a connection parameter profile. Requires ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+ * @param profile GAP_LE_CONNECTION_PROFILE_BULK_TRANSFER, GAP_LE_CONNECTION_PROFILE_LOW_LATENCY, or GAP_LE_CONNECTION_PROFILE_LOW_POWER
+ * @param conn_interval_min (unit: 1.25ms)
+ * @param conn_interval_max (unit: 1.25ms)
+ * @param conn_latency
+ * @param supervision_timeout (unit: 10ms)
+ */
+void gap_set_connection_parameter_profile(gap_le_connection_profile_t profile, uint16_t conn_interval_min,
+    uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout);
+
+/**
+ * @brief Select connection parameter profile for LE connection. Requires ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+ * @note As Central, connection is updated directly, as Peripheral, a L2CAP Connection Parameter Update Request is sent
+ * @param con_handle
+ * @param profile GAP_LE_CONNECTION_PROFILE_NONE stops automatic updates
+ * @returns 0 if ok
+ */
+uint8_t gap_le_set_connection_profile(hci_con_handle_t con_handle, gap_le_connection_profile_t profile);
+
+/**
+ * @brief Set CE length hint for LE connection used by following connection parameter updates
+ * @note As Central, connection is updated directly with current connection parameters
+ * @param con_handle
+ * @param min_ce_length (unit: 0.625ms), default: 0
+ * @param max_ce_length (unit: 0.625ms), default: 0xffff
+ * @returns 0 if ok
+ */
+uint8_t gap_le_set_connection_ce_length(hci_con_handle_t con_handle, uint16_t min_ce_length, uint16_t max_ce_length);
+
+/**
+ * @brief Align connection intervals requested for new connections and connection updates as Central
+ *        to multiples of a common interval to simplify scheduling of multiple links by the Controller.
+ *        Requested ranges that do not contain a multiple are used as is.
+ * @param interval_unit (unit: 1.25ms), 0 = no alignment (default)
+ */
+void gap_le_set_connection_interval_alignment(uint16_t interval_unit);
+
+/**
+ * @brief Set relative throughput demand for LE connection as Central. Requires ENABLE_LE_CE_LENGTH_ALLOCATOR
+ * @note All connections with demand use GAP_LE_CE_LENGTH_ALLOCATOR_CONNECTION_INTERVAL and get a share
+ *       of the connection interval as CE length proportional to their demand
+ * @param con_handle
+ * @param demand 0 = release connection from allocator
+ * @returns 0 if ok
+ */
+uint8_t gap_le_set_connection_throughput_demand(hci_con_handle_t con_handle, uint8_t demand);
+
+/**
+ * @brief Create Connected Isochronous Group (CIG) as Central. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @note The CIS connection handles are stored in storage when the HCI Command Complete event
+ *       for LE Set CIG Parameters is received
+ * @param storage for CIG, has to stay valid until gap_cig_remove completed
+ * @param params with CIS configuration, has to stay valid until CIG is created
+ * @returns 0 if ok
+ */
+uint8_t gap_cig_create(le_audio_cig_t * storage, const le_audio_cig_params_t * params);
+
+/**
+ * @brief Connect all CIS of a CIG. HCI_SUBEVENT_LE_CIS_ESTABLISHED is emitted for each CIS.
+ *        Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param cig_id
+ * @param acl_con_handles LE ACL connection for each CIS in order of CIG params
+ * @returns 0 if ok
+ */
+uint8_t gap_cis_create(uint8_t cig_id, const hci_con_handle_t * acl_con_handles);
+
+/**
+ * @brief Remove CIG and its CIS configuration. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param cig_id
+ * @returns 0 if ok
+ */
+uint8_t gap_cig_remove(uint8_t cig_id);
+
+/**
+ * @brief Accept CIS requested by Central with HCI_SUBEVENT_LE_CIS_REQUEST as Peripheral. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param cis_con_handle
+ * @returns 0 if ok
+ */
+uint8_t gap_cis_accept(hci_con_handle_t cis_con_handle);
+
+/**
+ * @brief Reject CIS requested by Central with HCI_SUBEVENT_LE_CIS_REQUEST as Peripheral. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param cis_con_handle
+ * @returns 0 if ok
+ */
+uint8_t gap_cis_reject(hci_con_handle_t cis_con_handle);
+
+/**
+ * @brief Create Broadcast Isochronous Group (BIG) on top of the periodic advertising train of an advertising set.
+ *        HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE is emitted on completion. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param storage for BIG, has to stay valid until gap_big_terminate completed
+ * @param params has to stay valid until BIG is created
+ * @returns 0 if ok
+ */
+uint8_t gap_big_create(le_audio_big_t * storage, const le_audio_big_params_t * params);
+
+/**
+ * @brief Terminate BIG. HCI_SUBEVENT_LE_TERMINATE_BIG_COMPLETE is emitted on completion. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param big_handle
+ * @returns 0 if ok
+ */
+uint8_t gap_big_terminate(uint8_t big_handle);
+
+/**
+ * @brief Synchronize to BIS of a BIG described by the periodic advertising train for sync handle.
+ *        HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED is emitted on completion. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param storage for BIG Sync, has to stay valid until gap_big_sync_terminate completed or sync was lost
+ * @param params has to stay valid until BIG Sync is established
+ * @returns 0 if ok
+ */
+uint8_t gap_big_sync_create(le_audio_big_sync_t * storage, const le_audio_big_sync_params_t * params);
+
+/**
+ * @brief Stop BIG Sync. Requires ENABLE_LE_ISOCHRONOUS_STREAMS
+ * @param big_handle
+ * @returns 0 if ok
+ */
+uint8_t gap_big_sync_terminate(uint8_t big_handle);
+
 /**
  * @brief Get connection interval
  * @return connection interval, otherwise 0 if error 
@@ -524,6 +872,15 @@ void gap_drop_link_key_for_bd_addr(bd_addr_t addr);
  */
 void gap_delete_all_link_keys(void);
 
+/**
+ * @brief Get link key for remote device with baseband address
+ * @param addr
+ * @param link_key
+ * @param link_key_type
+ * @returns 1 if link key found
+ */
+int gap_get_link_key_for_bd_addr(bd_addr_t addr, link_key_t link_key, link_key_type_t * type);
+
 /** 
  * @brief Store link key for remote device with baseband address
  * @param addr
@@ -578,9 +935,32 @@ int gap_inquiry_stop(void);
  * @param page_scan_repetition_mode
  * @param clock_offset only used when bit 15 is set - pass 0 if not known
  * @events: HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE
+ * @note With ENABLE_GAP_INQUIRY_RESULT_CACHE, the event is emitted directly if the complete name was received via EIR
+ * @note With ENABLE_GAP_REMOTE_NAME_CACHE, the event is emitted directly if the name is stored in the Remote Name Cache
  */
 int gap_remote_name_request(bd_addr_t addr, uint8_t page_scan_repetition_mode, uint16_t clock_offset);
 
+/**
+ * @brief Get name and class of device from Remote Name Cache, requires ENABLE_GAP_REMOTE_NAME_CACHE
+ * @param addr
+ * @param class_of_device 0 if not known yet, can be NULL
+ * @param name buffer for zero-terminated name, empty if not known yet, can be NULL
+ * @param name_size of name buffer
+ * @return true if device is in cache
+ */
+bool gap_remote_name_cache_get(const bd_addr_t addr, uint32_t * class_of_device, char * name, uint16_t name_size);
+
+/**
+ * @brief Remove device from Remote Name Cache, e.g. to fetch name again with next Remote Name Request
+ * @param addr
+ */
+void gap_remote_name_cache_remove(const bd_addr_t addr);
+
+/**
+ * @brief Delete all entries of Remote Name Cache
+ */
+void gap_remote_name_cache_flush(void);
+
 /**
  * @brief Read RSSI
  * @param con_handle
@@ -654,6 +1034,41 @@ uint8_t gap_sniff_mode_enter(hci_con_handle_t con_handle, uint16_t sniff_min_int
  */
 uint8_t gap_sniff_mode_exit(hci_con_handle_t con_handle);
 
+/**
+ * @brief Enter Sniff mode automatically after ACL link was idle, exit Sniff mode before sending ACL data. Requires ENABLE_CLASSIC_AUTO_SNIFF_MODE
+ * @param idle_timeout_ms time without ACL data before Sniff mode is requested, 0 = off
+ * @param sniff_min_interval range: 0x0002 to 0xFFFE; only even values are valid, Time = N * 0.625 ms
+ * @param sniff_max_interval range: 0x0002 to 0xFFFE; only even values are valid, Time = N * 0.625 ms
+ * @param sniff_attempt Number of Baseband receive slots for sniff attempt.
+ * @param sniff_timeout Number of Baseband receive slots for sniff timeout.
+ * @note Sniff mode needs to be allowed by link policy, see gap_set_default_link_policy_settings
+ */
+void gap_set_auto_sniff_mode(uint32_t idle_timeout_ms, uint16_t sniff_min_interval, uint16_t sniff_max_interval, uint16_t sniff_attempt, uint16_t sniff_timeout);
+
+/**
+ * @brief Configure Sniff Subrating after automatic Sniff mode was entered, if supported by Controller. Requires ENABLE_CLASSIC_AUTO_SNIFF_MODE
+ * @param max_latency Time = N * 0.625 ms, 0 = don't configure Sniff Subrating
+ * @param min_remote_timeout Time = N * 0.625 ms
+ * @param min_local_timeout Time = N * 0.625 ms
+ */
+void gap_set_auto_sniff_subrating(uint16_t max_latency, uint16_t min_remote_timeout, uint16_t min_local_timeout);
+
+/**
+ * @brief Set Automatic Flush Timeout for flushable ACL packets on a Classic connection. Requires ENABLE_CLASSIC_MEDIA_QOS
+ * @param con_handle
+ * @param flush_timeout_ms time after which Controller discards a not yet acknowledged flushable packet, max 1279 ms, 0 = no flush
+ * @return status
+ * @note Only affects packets sent on L2CAP channels marked flushable, see l2cap_set_flushable
+ */
+uint8_t gap_set_automatic_flush_timeout(hci_con_handle_t con_handle, uint16_t flush_timeout_ms);
+
+/**
+ * @brief Get number of packets flushed by Controller on a Classic connection. Requires ENABLE_CLASSIC_MEDIA_QOS
+ * @param con_handle
+ * @return number of Flush Occurred events since connection was established
+ */
+uint32_t gap_get_flushed_packets(hci_con_handle_t con_handle);
+
 // LE
 
 /**
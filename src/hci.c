@@ -61,6 +61,10 @@
 #include "gap.h"
 #endif
 
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+#include "ble/le_device_db.h"
+#endif
+
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
@@ -75,8 +79,13 @@
 #include "gap.h"
 #include "hci.h"
 #include "hci_cmd.h"
+#include "hci_cmd_builder.h"
 #include "hci_dump.h"
+#include "btstack_trace.h"
 #include "ad_parser.h"
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+#include "btstack_tlv.h"
+#endif
 
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
 #ifndef HCI_HOST_ACL_PACKET_NUM
@@ -93,15 +102,29 @@
 #endif
 #endif
 
+// report completed packets when watermark is reached or after timeout
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING
+#ifndef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
+#error "ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING requires ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL"
+#endif
+#ifndef HCI_HOST_NUM_COMPLETED_PACKETS_WATERMARK
+#define HCI_HOST_NUM_COMPLETED_PACKETS_WATERMARK ((HCI_HOST_ACL_PACKET_NUM + 1) / 2)
+#endif
+#ifndef HCI_HOST_NUM_COMPLETED_PACKETS_TIMEOUT_MS
+#define HCI_HOST_NUM_COMPLETED_PACKETS_TIMEOUT_MS 10
+#endif
+#endif
+
 #define HCI_CONNECTION_TIMEOUT_MS 10000
 
 #ifndef HCI_RESET_RESEND_TIMEOUT_MS
 #define HCI_RESET_RESEND_TIMEOUT_MS 200
 #endif
 
-// Names are arbitrarily shortened to 32 bytes if not requested otherwise
-#ifndef GAP_INQUIRY_MAX_NAME_LEN
-#define GAP_INQUIRY_MAX_NAME_LEN 32
+#ifdef ENABLE_HCI_STATISTICS
+#define HCI_STATISTICS_INC(field) hci_stack->statistics.field++
+#else
+#define HCI_STATISTICS_INC(field)
 #endif
 
 // GAP inquiry state: 0 = off, 0x01 - 0x30 = requested duration, 0xfe = active, 0xff = stop requested
@@ -141,6 +164,15 @@ static void hci_connection_timeout_handler(btstack_timer_source_t *timer);
 static void hci_connection_timestamp(hci_connection_t *connection);
 static void hci_emit_l2cap_check_timeout(hci_connection_t *conn);
 static void gap_inquiry_explode(uint8_t *packet, uint16_t size);
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+static uint8_t * gap_paging_create_connection(uint8_t * packet, int * size);
+static void gap_paging_handle_connection_complete(const bd_addr_t addr, uint8_t status);
+static void gap_paging_handle_inquiry_result(const uint8_t * event);
+static void gap_reconnect_run(void);
+#endif
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+static void gap_remote_name_cache_store(const bd_addr_t addr, const uint8_t * class_of_device, const uint8_t * name, uint8_t name_len, bool refresh);
+#endif
 #endif
 
 static int  hci_power_control_on(void);
@@ -161,6 +193,22 @@ static int  hci_number_free_acl_slots_for_connection_type( bd_addr_type_t addres
 static int hci_have_usb_transport(void);
 #endif
 
+#ifdef ENABLE_HCI_INIT_PROFILING
+static void hci_init_profile_enter_phase(hci_init_profile_phase_t phase);
+#endif
+
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+static void hci_le_connection_profile_activity(hci_connection_t * conn, const uint8_t * packet);
+#endif
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+static void hci_auto_sniff_start_timer(hci_connection_t * conn);
+static void hci_auto_sniff_activity(hci_connection_t * conn);
+#endif
+
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+static void hci_le_ce_length_allocator_update(void);
+#endif
+
 #ifdef ENABLE_BLE
 #ifdef ENABLE_LE_CENTRAL
 // called from test/ble_client/advertising_data_parser.c
@@ -176,6 +224,12 @@ static hci_stack_t   hci_stack_static;
 #endif
 static hci_stack_t * hci_stack = NULL;
 
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+static uint8_t hci_acl_tx_buffer_pool[HCI_ACL_TX_BUFFER_POOL_SIZE][HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_ACL_BUFFER_SIZE];
+static bool    hci_acl_tx_buffer_pool_used[HCI_ACL_TX_BUFFER_POOL_SIZE];
+static uint8_t * hci_acl_tx_buffer_in_flight;
+#endif
+
 #ifdef ENABLE_CLASSIC
 // default name
 static const char * default_classic_name = "BTstack 00:00:00:00:00:00";
@@ -184,6 +238,125 @@ static const char * default_classic_name = "BTstack 00:00:00:00:00:00";
 static uint8_t disable_l2cap_timeouts = 0;
 #endif
 
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+static inline uint16_t hci_connection_handle_table_index(hci_con_handle_t con_handle){
+    return con_handle & (HCI_CONNECTION_HANDLE_TABLE_SIZE - 1);
+}
+
+static uint16_t hci_connection_address_table_index(const bd_addr_t addr, bd_addr_type_t addr_type){
+    // lower address bytes are random for random addresses and NAP/UAP/LAP are well distributed
+    uint16_t hash = (uint16_t) addr_type;
+    int i;
+    for (i=0;i<6;i++){
+        hash = (uint16_t)((hash * 31u) + addr[i]);
+    }
+    return hash & (HCI_CONNECTION_ADDRESS_TABLE_SIZE - 1);
+}
+
+static void hci_connection_lookup_table_remove(hci_connection_t * conn){
+    // handle or address might have changed since entry was cached, clear all references
+    uint16_t index;
+    for (index = 0; index < HCI_CONNECTION_HANDLE_TABLE_SIZE; index++){
+        if (hci_stack->connection_for_handle[index] == conn){
+            hci_stack->connection_for_handle[index] = NULL;
+        }
+    }
+    for (index = 0; index < HCI_CONNECTION_ADDRESS_TABLE_SIZE; index++){
+        if (hci_stack->connection_for_address[index] == conn){
+            hci_stack->connection_for_address[index] = NULL;
+        }
+    }
+}
+#endif
+
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+static void hci_acl_buffer_provider_abort(hci_connection_t * conn){
+    uint8_t * buffer = conn->acl_provider_buffer;
+    if (buffer == NULL) return;
+    conn->acl_provider_buffer = NULL;
+    (*hci_stack->acl_buffer_provider->buffer_aborted)(conn->con_handle, conn->acl_provider_cid, buffer);
+}
+
+// @returns true if provider accepted first fragment
+static bool hci_acl_buffer_provider_start(hci_connection_t * conn, uint8_t * packet, uint16_t acl_length, uint16_t l2cap_length){
+    if (hci_stack->acl_buffer_provider == NULL) return false;
+    if (acl_length < 4) return false;
+    uint16_t cid          = READ_L2CAP_CHANNEL_ID(packet);
+    uint16_t fragment_len = acl_length - 4;
+    uint8_t * buffer = (*hci_stack->acl_buffer_provider->get_buffer)(conn->con_handle, cid, l2cap_length, &packet[8], fragment_len);
+    if (buffer == NULL) return false;
+    conn->acl_provider_buffer = buffer;
+    conn->acl_provider_cid    = cid;
+    conn->acl_provider_pos    = 0;
+    conn->acl_provider_len    = l2cap_length - fragment_len;
+    return true;
+}
+
+static void hci_acl_buffer_provider_continue(hci_connection_t * conn, uint8_t * fragment, uint16_t fragment_len){
+    if ((conn->acl_provider_pos + fragment_len) > conn->acl_provider_len){
+        log_error("ACL Cont Fragment to large: combined payload %u > provided buffer %u for handle 0x%02x",
+            conn->acl_provider_pos + fragment_len, conn->acl_provider_len, conn->con_handle);
+        hci_acl_buffer_provider_abort(conn);
+        return;
+    }
+    (void)memcpy(&conn->acl_provider_buffer[conn->acl_provider_pos], fragment, fragment_len);
+    conn->acl_provider_pos += fragment_len;
+    if (conn->acl_provider_pos < conn->acl_provider_len) return;
+    uint8_t * buffer = conn->acl_provider_buffer;
+    conn->acl_provider_buffer = NULL;
+    (*hci_stack->acl_buffer_provider->buffer_complete)(conn->con_handle, conn->acl_provider_cid, buffer, conn->acl_provider_len);
+}
+#endif
+
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+static uint8_t * hci_acl_tx_buffer_get(void){
+    int i;
+    for (i = 0; i < HCI_ACL_TX_BUFFER_POOL_SIZE; i++){
+        if (hci_acl_tx_buffer_pool_used[i]) continue;
+        hci_acl_tx_buffer_pool_used[i] = true;
+        return &hci_acl_tx_buffer_pool[i][HCI_OUTGOING_PRE_BUFFER_SIZE];
+    }
+    return NULL;
+}
+
+static void hci_acl_tx_buffer_free(const uint8_t * buffer){
+    int i;
+    for (i = 0; i < HCI_ACL_TX_BUFFER_POOL_SIZE; i++){
+        if (&hci_acl_tx_buffer_pool[i][HCI_OUTGOING_PRE_BUFFER_SIZE] == buffer){
+            hci_acl_tx_buffer_pool_used[i] = false;
+        }
+    }
+}
+
+static void hci_acl_tx_buffer_release(hci_connection_t * conn){
+    if (conn->acl_tx_buffer == NULL) return;
+    // buffer used by asynchronous transport is freed on HCI_EVENT_TRANSPORT_PACKET_SENT
+    if (conn->acl_tx_buffer != hci_acl_tx_buffer_in_flight){
+        hci_acl_tx_buffer_free(conn->acl_tx_buffer);
+    }
+    conn->acl_tx_buffer = NULL;
+}
+
+// connection has outgoing ACL fragments queued in tx buffer
+static bool hci_acl_tx_buffer_pending(hci_connection_t * conn){
+    return (conn->acl_tx_buffer != NULL) && (conn->acl_tx_pos < conn->acl_tx_size);
+}
+#endif
+
+static void hci_connection_free(hci_connection_t * conn){
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+    hci_acl_tx_buffer_release(conn);
+#endif
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+    hci_acl_buffer_provider_abort(conn);
+#endif
+    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+    hci_connection_lookup_table_remove(conn);
+#endif
+    btstack_memory_hci_connection_free( conn );
+}
+
 /**
  * create connection for given address
  *
@@ -206,16 +379,47 @@ static hci_connection_t * create_connection_for_bd_addr_and_type(bd_addr_t addr,
 #endif
     conn->acl_recombination_length = 0;
     conn->acl_recombination_pos = 0;
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+    conn->acl_tx_buffer = NULL;
+#endif
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+    conn->acl_provider_buffer = NULL;
+#endif
     conn->num_packets_sent = 0;
 
     conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
 #ifdef ENABLE_BLE
     conn->le_phy_update_all_phys = 0xff;
+    conn->le_min_ce_length = 0x0000;
+    conn->le_max_ce_length = 0xffff;
+#endif
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+    conn->le_throughput_demand = 0;
 #endif
 #ifdef ENABLE_LE_LIMIT_ACL_FRAGMENT_BY_MAX_OCTETS
     conn->le_max_tx_octets = 27;
+#endif
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    conn->le_connection_profile = GAP_LE_CONNECTION_PROFILE_NONE;
+    conn->le_connection_profile_applied = GAP_LE_CONNECTION_PROFILE_NONE;
+    conn->le_connection_profile_timer_active = false;
+#endif
+#ifdef ENABLE_LE_LINK_UPGRADE
+    conn->le_link_upgrade_state = LE_LINK_UPGRADE_IDLE;
+    conn->le_tx_phy = 1;
+    conn->le_rx_phy = 1;
+    conn->le_link_max_tx_octets = 27;
+    conn->le_link_max_rx_octets = 27;
+#endif
+#ifdef ENABLE_L2CAP_WEIGHTED_SCHEDULING
+    conn->l2cap_scheduling_weight = 1;
+    conn->l2cap_scheduling_deficit = 0;
+    conn->l2cap_scheduling_low_latency = false;
 #endif
     btstack_linked_list_add(&hci_stack->connections, (btstack_linked_item_t *) conn);
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+    hci_stack->connection_for_address[hci_connection_address_table_index(addr, addr_type)] = conn;
+#endif
     return conn;
 }
 
@@ -286,11 +490,22 @@ void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+    // entries are only a hint as con_handle gets set after connection was created
+    uint16_t index = hci_connection_handle_table_index(con_handle);
+    hci_connection_t * cached = hci_stack->connection_for_handle[index];
+    if ((cached != NULL) && (cached->con_handle == con_handle)){
+        return cached;
+    }
+#endif
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->connections);
     while (btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * item = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         if ( item->con_handle == con_handle ) {
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+            hci_stack->connection_for_handle[index] = item;
+#endif
             return item;
         }
     } 
@@ -303,12 +518,22 @@ hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t  addr, bd_addr_type_t addr_type){
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+    uint16_t index = hci_connection_address_table_index(addr, addr_type);
+    hci_connection_t * cached = hci_stack->connection_for_address[index];
+    if ((cached != NULL) && (cached->address_type == addr_type) && (memcmp(addr, cached->address, 6) == 0)){
+        return cached;
+    }
+#endif
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->connections);
     while (btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         if (connection->address_type != addr_type)  continue;
         if (memcmp(addr, connection->address, 6) != 0) continue;
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+        hci_stack->connection_for_address[index] = connection;
+#endif
         return connection;   
     } 
     return NULL;
@@ -361,6 +586,81 @@ static void hci_connection_timestamp(hci_connection_t *connection){
 #endif
 }
 
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+static bool hci_connection_idle_for_ms(hci_connection_t *connection, uint32_t timeout_ms){
+#ifdef HAVE_EMBEDDED_TICK
+    return (btstack_run_loop_embedded_get_ticks() - connection->timestamp) >= btstack_run_loop_embedded_ticks_for_ms(timeout_ms);
+#else
+    return (btstack_run_loop_get_time_ms() - connection->timestamp) >= timeout_ms;
+#endif
+}
+
+static int hci_sniff_subrating_supported(void){
+    // No. 41, byte 5, bit 1
+    return (hci_stack->local_supported_features[5] & (1 << 1)) != 0;
+}
+
+static void hci_auto_sniff_timeout_handler(btstack_timer_source_t * timer){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(timer);
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return;
+    // timer is restarted on mode change to active
+    if (conn->connection_mode != ACL_CONNECTION_MODE_ACTIVE) return;
+    if (hci_stack->auto_sniff_idle_timeout_ms == 0) return;
+    if ((conn->sniff_min_interval == 0) && hci_connection_idle_for_ms(conn, hci_stack->auto_sniff_idle_timeout_ms)){
+        log_info("Auto Sniff: handle 0x%04x idle, enter sniff mode", con_handle);
+        conn->sniff_min_interval = hci_stack->auto_sniff_min_interval;
+        conn->sniff_max_interval = hci_stack->auto_sniff_max_interval;
+        conn->sniff_attempt      = hci_stack->auto_sniff_attempt;
+        conn->sniff_timeout      = hci_stack->auto_sniff_timeout;
+        hci_run();
+    }
+    // check again, e.g. if sniff mode was rejected
+    hci_auto_sniff_start_timer(conn);
+}
+
+static void hci_auto_sniff_start_timer(hci_connection_t * conn){
+    btstack_run_loop_remove_timer(&conn->auto_sniff_timer);
+    if (hci_stack->auto_sniff_idle_timeout_ms == 0) return;
+    btstack_run_loop_set_timer_handler(&conn->auto_sniff_timer, hci_auto_sniff_timeout_handler);
+    btstack_run_loop_set_timer_context(&conn->auto_sniff_timer, (void *) (uintptr_t) conn->con_handle);
+    btstack_run_loop_set_timer(&conn->auto_sniff_timer, hci_stack->auto_sniff_idle_timeout_ms);
+    btstack_run_loop_add_timer(&conn->auto_sniff_timer);
+}
+
+// called for each outgoing ACL packet, exit sniff mode is sent on next hci_run
+static void hci_auto_sniff_activity(hci_connection_t * conn){
+    if (hci_stack->auto_sniff_idle_timeout_ms == 0) return;
+    if (conn->connection_mode != ACL_CONNECTION_MODE_SNIFF) return;
+    if (conn->sniff_min_interval != 0) return;
+    log_info("Auto Sniff: handle 0x%04x has data, exit sniff mode", conn->con_handle);
+    conn->sniff_min_interval = 0xffff;
+}
+
+void gap_set_auto_sniff_mode(uint32_t idle_timeout_ms, uint16_t sniff_min_interval, uint16_t sniff_max_interval, uint16_t sniff_attempt, uint16_t sniff_timeout){
+    hci_stack->auto_sniff_idle_timeout_ms = idle_timeout_ms;
+    hci_stack->auto_sniff_min_interval = sniff_min_interval;
+    hci_stack->auto_sniff_max_interval = sniff_max_interval;
+    hci_stack->auto_sniff_attempt = sniff_attempt;
+    hci_stack->auto_sniff_timeout = sniff_timeout;
+    // (re-)start idle check for existing connections
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (conn->address_type != BD_ADDR_TYPE_ACL) continue;
+        if (conn->state != OPEN) continue;
+        hci_auto_sniff_start_timer(conn);
+    }
+}
+
+void gap_set_auto_sniff_subrating(uint16_t max_latency, uint16_t min_remote_timeout, uint16_t min_local_timeout){
+    hci_stack->auto_sniff_subrating_max_latency = max_latency;
+    hci_stack->auto_sniff_subrating_min_remote_timeout = min_remote_timeout;
+    hci_stack->auto_sniff_subrating_min_local_timeout = min_local_timeout;
+}
+#endif
+
 /**
  * add authentication flags and reset timer
  * @note: assumes classic connection
@@ -390,6 +690,11 @@ void gap_drop_link_key_for_bd_addr(bd_addr_t addr){
     hci_stack->link_key_db->delete_link_key(addr);
 }
 
+int gap_get_link_key_for_bd_addr(bd_addr_t addr, link_key_t link_key, link_key_type_t * type){
+    if (!hci_stack->link_key_db) return 0;
+    return hci_stack->link_key_db->get_link_key(addr, link_key, type);
+}
+
 void gap_store_link_key_for_bd_addr(bd_addr_t addr, link_key_t link_key, link_key_type_t type){
     if (!hci_stack->link_key_db) return;
     log_info("gap_store_link_key_for_bd_addr: %s, type %u", bd_addr_to_str(addr), type);
@@ -507,6 +812,108 @@ static int hci_number_free_acl_slots_for_connection_type(bd_addr_type_t address_
     }
 }
 
+#ifdef ENABLE_HCI_STATISTICS
+// index of Controller ACL buffer pool used by connection: 0 = Classic or shared, 1 = LE
+static int hci_statistics_pool_index(hci_connection_t * connection){
+    return (hci_is_le_connection(connection) && (hci_stack->le_acl_packets_total_num > 0)) ? 1 : 0;
+}
+
+// called for each ACL fragment sent to Controller
+static void hci_statistics_acl_fragment_sent(hci_connection_t * connection){
+    connection->statistics.acl_fragments_sent++;
+    if (connection->num_packets_sent > connection->statistics.acl_packets_outstanding_max){
+        connection->statistics.acl_packets_outstanding_max = connection->num_packets_sent;
+    }
+    int index = hci_statistics_pool_index(connection);
+    if (hci_stack->acl_credit_starvation_start_ms[index] != 0) return;
+    if (hci_number_free_acl_slots_for_connection_type(connection->address_type) > 0) return;
+    hci_stack->statistics.acl_credit_starvation_count[index]++;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    hci_stack->acl_credit_starvation_start_ms[index] = btstack_max(now, 1);
+}
+
+// called when Controller ACL buffers have been freed
+static void hci_statistics_acl_credits_returned(void){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    int index;
+    for (index = 0; index < 2; index++){
+        uint32_t start_ms = hci_stack->acl_credit_starvation_start_ms[index];
+        if (start_ms == 0) continue;
+        bd_addr_type_t address_type = (index == 0) ? BD_ADDR_TYPE_ACL : BD_ADDR_TYPE_LE_PUBLIC;
+        if (hci_number_free_acl_slots_for_connection_type(address_type) <= 0) continue;
+        uint32_t duration_ms = now - start_ms;
+        hci_stack->statistics.acl_credit_starvation_ms[index] += duration_ms;
+        hci_stack->statistics.acl_credit_starvation_max_ms[index] = btstack_max(hci_stack->statistics.acl_credit_starvation_max_ms[index], duration_ms);
+        hci_stack->acl_credit_starvation_start_ms[index] = 0;
+    }
+}
+
+static void hci_statistics_emit_connection(hci_connection_t * connection){
+    uint8_t event[32];
+    event[0] = HCI_EVENT_CONNECTION_STATISTICS;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event,  2, connection->con_handle);
+    little_endian_store_32(event,  4, connection->statistics.acl_packets_sent);
+    little_endian_store_32(event,  8, connection->statistics.acl_bytes_sent);
+    little_endian_store_32(event, 12, connection->statistics.acl_fragments_sent);
+    little_endian_store_32(event, 16, connection->statistics.acl_packets_received);
+    little_endian_store_32(event, 20, connection->statistics.acl_bytes_received);
+    little_endian_store_16(event, 24, connection->num_packets_sent);
+    little_endian_store_16(event, 26, connection->statistics.acl_packets_outstanding_max);
+    little_endian_store_32(event, 28, hci_stack->statistics.acl_credit_starvation_ms[hci_statistics_pool_index(connection)]);
+    hci_emit_event(event, sizeof(event), 1);
+}
+
+static void hci_statistics_report_handler(btstack_timer_source_t * ts){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (connection->address_type == BD_ADDR_TYPE_SCO) continue;
+        hci_statistics_emit_connection(connection);
+    }
+    btstack_run_loop_set_timer(ts, hci_stack->statistics_report_interval_ms);
+    btstack_run_loop_add_timer(ts);
+}
+
+const hci_statistics_t * hci_get_statistics(void){
+    return &hci_stack->statistics;
+}
+
+const hci_connection_statistics_t * hci_get_connection_statistics(hci_con_handle_t con_handle){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (connection == NULL) return NULL;
+    return &connection->statistics;
+}
+
+void hci_reset_statistics(void){
+    memset(&hci_stack->statistics, 0, sizeof(hci_statistics_t));
+    // ongoing starvation periods are counted from now on
+    uint32_t now = btstack_run_loop_get_time_ms();
+    int index;
+    for (index = 0; index < 2; index++){
+        if (hci_stack->acl_credit_starvation_start_ms[index] == 0) continue;
+        hci_stack->statistics.acl_credit_starvation_count[index] = 1;
+        hci_stack->acl_credit_starvation_start_ms[index] = btstack_max(now, 1);
+    }
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        memset(&connection->statistics, 0, sizeof(hci_connection_statistics_t));
+    }
+}
+
+void hci_set_statistics_report_interval(uint32_t interval_ms){
+    btstack_run_loop_remove_timer(&hci_stack->statistics_report_timer);
+    hci_stack->statistics_report_interval_ms = interval_ms;
+    if (interval_ms == 0) return;
+    btstack_run_loop_set_timer_handler(&hci_stack->statistics_report_timer, &hci_statistics_report_handler);
+    btstack_run_loop_set_timer(&hci_stack->statistics_report_timer, interval_ms);
+    btstack_run_loop_add_timer(&hci_stack->statistics_report_timer);
+}
+#endif
+
 int hci_number_free_acl_slots_for_handle(hci_con_handle_t con_handle){
     // get connection type
     hci_connection_t * connection = hci_connection_for_handle(con_handle);
@@ -573,28 +980,154 @@ static int hci_transport_can_send_prepared_packet_now(uint8_t packet_type){
 }
 
 static int hci_can_send_prepared_acl_packet_for_address_type(bd_addr_type_t address_type){
-    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
-    return hci_number_free_acl_slots_for_connection_type(address_type) > 0;
+    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) {
+        HCI_STATISTICS_INC(acl_refused_transport_busy);
+        return 0;
+    }
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+    // caller might send on any connection of this type, fragments of queued packet have to be sent first
+    int is_le = (address_type == BD_ADDR_TYPE_ACL) ? 0 : 1;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (hci_is_le_connection(connection) != is_le) continue;
+        if (hci_acl_tx_buffer_pending(connection)) {
+            HCI_STATISTICS_INC(acl_refused_tx_buffer_pending);
+            return 0;
+        }
+    }
+#endif
+    if (hci_number_free_acl_slots_for_connection_type(address_type) <= 0) {
+        HCI_STATISTICS_INC(acl_refused_no_credits);
+        return 0;
+    }
+    return 1;
 }
 
 int hci_can_send_acl_le_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (hci_stack->hci_packet_buffer_reserved) {
+        HCI_STATISTICS_INC(acl_refused_packet_buffer_reserved);
+        return 0;
+    }
     return hci_can_send_prepared_acl_packet_for_address_type(BD_ADDR_TYPE_LE_PUBLIC);
 }
 
 int hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle) {
-    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
-    return hci_number_free_acl_slots_for_handle(con_handle) > 0;
+    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) {
+        HCI_STATISTICS_INC(acl_refused_transport_busy);
+        return 0;
+    }
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+    // new packet has to wait for fragments of queued packet
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if ((connection != NULL) && hci_acl_tx_buffer_pending(connection)) {
+        HCI_STATISTICS_INC(acl_refused_tx_buffer_pending);
+        return 0;
+    }
+#endif
+    if (hci_number_free_acl_slots_for_handle(con_handle) <= 0) {
+        HCI_STATISTICS_INC(acl_refused_no_credits);
+        return 0;
+    }
+    return 1;
 }
 
 int hci_can_send_acl_packet_now(hci_con_handle_t con_handle){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (hci_stack->hci_packet_buffer_reserved) {
+        HCI_STATISTICS_INC(acl_refused_packet_buffer_reserved);
+        return 0;
+    }
     return hci_can_send_prepared_acl_packet_now(con_handle);
 }
 
+#ifdef ENABLE_HCI_QOS_ARBITER
+// transport of channels registered with traffic class: 0 = Classic, 1 = LE
+static int hci_qos_transport_for_address_type(bd_addr_type_t address_type){
+    return (address_type == BD_ADDR_TYPE_ACL) ? 0 : 1;
+}
+
+// voice is active with SCO connections, interactive with LE connections (ATT, SM), all with registered channels
+static bool hci_qos_traffic_class_active(int transport, hci_traffic_class_t traffic_class){
+    if (hci_stack->qos_num_channels[transport][traffic_class] > 0) return true;
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) hci_stack->connections; it != NULL; it = it->next){
+        hci_connection_t * connection = (hci_connection_t *) it;
+        switch (traffic_class){
+            case HCI_TRAFFIC_CLASS_VOICE:
+                if ((transport == 0) && (connection->address_type == BD_ADDR_TYPE_SCO)) return true;
+                break;
+            case HCI_TRAFFIC_CLASS_INTERACTIVE:
+                if ((transport == 1) && hci_is_le_connection(connection)) return true;
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+// ACL buffers of the pool used by address type that are reserved for active higher priority traffic classes
+static int hci_qos_reserved_acl_slots(bd_addr_type_t address_type, hci_traffic_class_t traffic_class){
+    int transport = hci_qos_transport_for_address_type(address_type);
+    bool shared_pool = hci_stack->le_acl_packets_total_num == 0;
+    int total_slots = (shared_pool || (transport == 0)) ? hci_stack->acl_packets_total_num : hci_stack->le_acl_packets_total_num;
+    int reserved_slots = 0;
+    int higher_class;
+    for (higher_class = 0; higher_class < (int) traffic_class; higher_class++){
+        if (hci_stack->qos_acl_reserved[higher_class] == 0) continue;
+        bool active = hci_qos_traffic_class_active(transport, (hci_traffic_class_t) higher_class);
+        if (!active && shared_pool){
+            active = hci_qos_traffic_class_active(1 - transport, (hci_traffic_class_t) higher_class);
+        }
+        if (active){
+            reserved_slots += hci_stack->qos_acl_reserved[higher_class];
+        }
+    }
+    // always leave one buffer to lower priority traffic
+    return btstack_min(reserved_slots, total_slots - 1);
+}
+
+static int hci_qos_acl_slots_available(bd_addr_type_t address_type, hci_traffic_class_t traffic_class){
+    return hci_number_free_acl_slots_for_connection_type(address_type) > hci_qos_reserved_acl_slots(address_type, traffic_class);
+}
+
+void hci_qos_set_acl_reservation(hci_traffic_class_t traffic_class, uint8_t num_acl_packets){
+    if (traffic_class >= HCI_TRAFFIC_CLASS_NUM) return;
+    hci_stack->qos_acl_reserved[traffic_class] = num_acl_packets;
+}
+
+void hci_qos_register_traffic_class(bd_addr_type_t address_type, hci_traffic_class_t traffic_class){
+    if (traffic_class >= HCI_TRAFFIC_CLASS_NUM) return;
+    hci_stack->qos_num_channels[hci_qos_transport_for_address_type(address_type)][traffic_class]++;
+}
+
+void hci_qos_unregister_traffic_class(bd_addr_type_t address_type, hci_traffic_class_t traffic_class){
+    if (traffic_class >= HCI_TRAFFIC_CLASS_NUM) return;
+    int transport = hci_qos_transport_for_address_type(address_type);
+    if (hci_stack->qos_num_channels[transport][traffic_class] == 0) return;
+    hci_stack->qos_num_channels[transport][traffic_class]--;
+}
+
+int hci_qos_can_send_acl_packet_now(hci_con_handle_t con_handle, hci_traffic_class_t traffic_class){
+    if (!hci_can_send_acl_packet_now(con_handle)) return 0;
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (connection == NULL) return 0;
+    return hci_qos_acl_slots_available(connection->address_type, traffic_class) ? 1 : 0;
+}
+
+int hci_qos_can_send_acl_le_packet_now(hci_traffic_class_t traffic_class){
+    if (!hci_can_send_acl_le_packet_now()) return 0;
+    return hci_qos_acl_slots_available(BD_ADDR_TYPE_LE_PUBLIC, traffic_class) ? 1 : 0;
+}
+#endif
+
 #ifdef ENABLE_CLASSIC
 int hci_can_send_acl_classic_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (hci_stack->hci_packet_buffer_reserved) {
+        HCI_STATISTICS_INC(acl_refused_packet_buffer_reserved);
+        return 0;
+    }
     return hci_can_send_prepared_acl_packet_for_address_type(BD_ADDR_TYPE_ACL);
 }
 
@@ -627,6 +1160,7 @@ int hci_is_packet_buffer_reserved(void){
 int hci_reserve_packet_buffer(void){
     if (hci_stack->hci_packet_buffer_reserved) {
         log_error("hci_reserve_packet_buffer called but buffer already reserved");
+        HCI_STATISTICS_INC(reserve_packet_buffer_failed);
         return 0;
     }
     hci_stack->hci_packet_buffer_reserved = 1;
@@ -642,11 +1176,8 @@ static int hci_transport_synchronous(void){
     return hci_stack->hci_transport->can_send_packet_now == NULL;
 }
 
-static int hci_send_acl_packet_fragments(hci_connection_t *connection){
-
-    // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, connection->con_handle);
-
-    // max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
+// max ACL data packet length depends on connection type (LE vs. Classic) and available buffers
+static uint16_t hci_max_acl_data_packet_length_for_connection(hci_connection_t * connection){
     uint16_t max_acl_data_packet_length = hci_stack->acl_data_packet_length;
     if (hci_is_le_connection(connection) && (hci_stack->le_data_packets_length > 0)){
         max_acl_data_packet_length = hci_stack->le_data_packets_length;
@@ -657,47 +1188,153 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
         max_acl_data_packet_length = connection->le_max_tx_octets;
     }
 #endif
+    return max_acl_data_packet_length;
+}
 
-    log_debug("hci_send_acl_packet_fragments entered");
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+static void hci_acl_tx_buffer_queue_fragments(hci_connection_t * connection){
+    uint8_t * buffer = hci_acl_tx_buffer_get();
+    if (buffer == NULL) return;
 
-    int err;
-    // multiple packets could be send on a synchronous HCI transport
-    while (true){
+    (void)memcpy(buffer, hci_stack->hci_packet_buffer, hci_stack->acl_fragmentation_total_size);
+    connection->acl_tx_buffer = buffer;
+    connection->acl_tx_pos    = hci_stack->acl_fragmentation_pos;
+    connection->acl_tx_size   = hci_stack->acl_fragmentation_total_size;
+    log_debug("hci_acl_tx_buffer_queue_fragments handle 0x%04x, pos %u, size %u", connection->con_handle, connection->acl_tx_pos, connection->acl_tx_size);
 
-        log_debug("hci_send_acl_packet_fragments loop entered");
+    // packet buffer can be released as soon as current fragment was sent
+    hci_stack->acl_fragmentation_pos = 0;
+    hci_stack->acl_fragmentation_total_size = 0;
+    if (hci_transport_synchronous()){
+        hci_stack->acl_fragmentation_tx_active = 0;
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+}
 
-        // get current data
-        const uint16_t acl_header_pos = hci_stack->acl_fragmentation_pos - 4;
-        int current_acl_data_packet_length = hci_stack->acl_fragmentation_total_size - hci_stack->acl_fragmentation_pos;
-        int more_fragments = 0;
+// pre: transport can send, packet buffer not reserved
+static void hci_acl_tx_buffer_send_fragments(hci_connection_t * connection){
+    uint16_t max_acl_data_packet_length = hci_max_acl_data_packet_length_for_connection(connection);
+    uint8_t * buffer = connection->acl_tx_buffer;
 
-        // if ACL packet is larger than Bluetooth packet buffer, only send max_acl_data_packet_length
-        if (current_acl_data_packet_length > max_acl_data_packet_length){
-            more_fragments = 1;
-            current_acl_data_packet_length = max_acl_data_packet_length;
-        }
+    // block hci packet buffer while transport is busy
+    hci_reserve_packet_buffer();
 
-        // copy handle_and_flags if not first fragment and update packet boundary flags to be 01 (continuing fragmnent)
-        if (acl_header_pos > 0){
-            uint16_t handle_and_flags = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
-            handle_and_flags = (handle_and_flags & 0xcfff) | (1 << 12);
-            little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos, handle_and_flags);
+    while (true){
+        const uint16_t acl_header_pos = connection->acl_tx_pos - 4;
+        uint16_t current_acl_data_packet_length = connection->acl_tx_size - connection->acl_tx_pos;
+        bool more_fragments = current_acl_data_packet_length > max_acl_data_packet_length;
+        if (more_fragments){
+            current_acl_data_packet_length = max_acl_data_packet_length;
         }
 
-        // update header len
-        little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos + 2, current_acl_data_packet_length);
+        // continuation fragment header
+        uint16_t handle_and_flags = little_endian_read_16(buffer, 0);
+        handle_and_flags = (handle_and_flags & 0xcfff) | (1 << 12);
+        little_endian_store_16(buffer, acl_header_pos, handle_and_flags);
+        little_endian_store_16(buffer, acl_header_pos + 2, current_acl_data_packet_length);
 
-        // count packet
         connection->num_packets_sent++;
-        log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", more_fragments);
+        connection->acl_tx_pos += current_acl_data_packet_length;
+#ifdef ENABLE_HCI_STATISTICS
+        hci_statistics_acl_fragment_sent(connection);
+#endif
 
-        // update state for next fragment (if any) as "transport done" might be sent during send_packet already
-        if (more_fragments){
-            // update start of next fragment to send
-            hci_stack->acl_fragmentation_pos += current_acl_data_packet_length;
-        } else {
-            // done
-            hci_stack->acl_fragmentation_pos = 0;
+        uint8_t * packet = &buffer[acl_header_pos];
+        const int size = current_acl_data_packet_length + 4;
+        hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, size);
+        hci_stack->acl_fragmentation_tx_active = 1;
+        (void) hci_stack->hci_transport->send_packet(HCI_ACL_DATA_PACKET, packet, size);
+
+        // asynchronous transport: continue on HCI_EVENT_TRANSPORT_PACKET_SENT
+        if (!hci_transport_synchronous()) {
+            hci_acl_tx_buffer_in_flight = buffer;
+            return;
+        }
+
+        hci_stack->acl_fragmentation_tx_active = 0;
+        if (!more_fragments) break;
+        if (hci_number_free_acl_slots_for_handle(connection->con_handle) == 0) break;
+    }
+
+    if (!hci_acl_tx_buffer_pending(connection)){
+        hci_acl_tx_buffer_release(connection);
+    }
+    hci_release_packet_buffer();
+    hci_emit_transport_packet_sent();
+}
+
+static void hci_acl_tx_buffer_packet_sent(void){
+    uint8_t * buffer = hci_acl_tx_buffer_in_flight;
+    if (buffer == NULL) return;
+    hci_acl_tx_buffer_in_flight = NULL;
+
+    // release buffer if all fragments have been sent
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (connection->acl_tx_buffer != buffer) continue;
+        if (!hci_acl_tx_buffer_pending(connection)){
+            hci_acl_tx_buffer_release(connection);
+        }
+        return;
+    }
+
+    // connection was closed
+    hci_acl_tx_buffer_free(buffer);
+}
+#endif
+
+static int hci_send_acl_packet_fragments(hci_connection_t *connection){
+
+    // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, connection->con_handle);
+
+    uint16_t max_acl_data_packet_length = hci_max_acl_data_packet_length_for_connection(connection);
+
+    log_debug("hci_send_acl_packet_fragments entered");
+
+    int err;
+    // multiple packets could be send on a synchronous HCI transport
+    while (true){
+
+        log_debug("hci_send_acl_packet_fragments loop entered");
+
+        // get current data
+        const uint16_t acl_header_pos = hci_stack->acl_fragmentation_pos - 4;
+        int current_acl_data_packet_length = hci_stack->acl_fragmentation_total_size - hci_stack->acl_fragmentation_pos;
+        int more_fragments = 0;
+
+        // if ACL packet is larger than Bluetooth packet buffer, only send max_acl_data_packet_length
+        if (current_acl_data_packet_length > max_acl_data_packet_length){
+            more_fragments = 1;
+            current_acl_data_packet_length = max_acl_data_packet_length;
+        }
+
+        // copy handle_and_flags if not first fragment and update packet boundary flags to be 01 (continuing fragmnent)
+        if (acl_header_pos > 0){
+            uint16_t handle_and_flags = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
+            handle_and_flags = (handle_and_flags & 0xcfff) | (1 << 12);
+            little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos, handle_and_flags);
+        }
+
+        // update header len
+        little_endian_store_16(hci_stack->hci_packet_buffer, acl_header_pos + 2, current_acl_data_packet_length);
+
+        // count packet
+        connection->num_packets_sent++;
+#ifdef ENABLE_HCI_STATISTICS
+        hci_statistics_acl_fragment_sent(connection);
+#endif
+        log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", more_fragments);
+
+        // update state for next fragment (if any) as "transport done" might be sent during send_packet already
+        if (more_fragments){
+            // update start of next fragment to send
+            hci_stack->acl_fragmentation_pos += current_acl_data_packet_length;
+        } else {
+            // done
+            hci_stack->acl_fragmentation_pos = 0;
             hci_stack->acl_fragmentation_total_size = 0;
         }
 
@@ -714,7 +1351,15 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
         if (!more_fragments) break;
 
         // can send more?
-        if (!hci_can_send_prepared_acl_packet_now(connection->con_handle)) return err;
+        if (!hci_can_send_prepared_acl_packet_now(connection->con_handle)) {
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+            // no controller buffers: queue remaining fragments to release hci packet buffer for other connections
+            if (hci_number_free_acl_slots_for_handle(connection->con_handle) == 0){
+                hci_acl_tx_buffer_queue_fragments(connection);
+            }
+#endif
+            return err;
+        }
     }
 
     log_debug("hci_send_acl_packet_fragments loop over");
@@ -762,8 +1407,23 @@ int hci_send_acl_packet_buffer(int size){
     hci_connection_timestamp(connection);
 #endif
 
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+    hci_auto_sniff_activity(connection);
+#endif
+
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    hci_le_connection_profile_activity(connection, packet);
+#endif
+
     // hci_dump_packet( HCI_ACL_DATA_PACKET, 0, packet, size);
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_HCI_ACL_TX, con_handle, size);
+
+#ifdef ENABLE_HCI_STATISTICS
+    connection->statistics.acl_packets_sent++;
+    connection->statistics.acl_bytes_sent += size;
+#endif
+
     // setup data
     hci_stack->acl_fragmentation_total_size = size;
     hci_stack->acl_fragmentation_pos = 4;   // start of L2CAP packet
@@ -771,6 +1431,80 @@ int hci_send_acl_packet_buffer(int size){
     return hci_send_acl_packet_fragments(connection);
 }
 
+int hci_send_acl_iov(const btstack_iovec_t * iov, uint16_t iov_count){
+
+    if ((iov_count == 0) || (iov[0].len < 4)){
+        log_error("hci_send_acl_iov called without ACL header");
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(iov[0].base);
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) {
+        log_error("hci_send_acl_iov called but no connection for handle 0x%04x", con_handle);
+        return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    }
+
+    if (!hci_can_send_acl_packet_now(con_handle)){
+        log_error("hci_send_acl_iov called but cannot send packet now");
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    uint32_t total_size = 0;
+    uint16_t i;
+    for (i = 0; i < iov_count; i++){
+        total_size += iov[i].len;
+    }
+    if (total_size > HCI_ACL_BUFFER_SIZE){
+        log_error("hci_send_acl_iov called with packet larger than ACL buffer, %u > %u", (unsigned int) total_size, HCI_ACL_BUFFER_SIZE);
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+    uint16_t size = (uint16_t) total_size;
+
+    // packet buffer is not used for tx, but reserved until transport is done with the buffers
+    hci_reserve_packet_buffer();
+
+    // gather into packet buffer for logging or if transport cannot send packet as is
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    bool zero_copy = (hci_stack->hci_transport->send_packet_iov != NULL) && (iov_count <= HCI_TRANSPORT_IOV_MAX)
+            && ((size - 4) <= hci_max_acl_data_packet_length_for_connection(connection));
+    if (!zero_copy || hci_dump_active()){
+        uint16_t pos = 0;
+        for (i = 0; i < iov_count; i++){
+            (void)memcpy(&packet[pos], iov[i].base, iov[i].len);
+            pos += iov[i].len;
+        }
+    }
+    if (!zero_copy){
+        return hci_send_acl_packet_buffer(size);
+    }
+
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_HCI_ACL_TX, con_handle, size);
+
+#ifdef ENABLE_CLASSIC
+    hci_connection_timestamp(connection);
+#endif
+
+    // send as single ACL fragment
+    connection->num_packets_sent++;
+#ifdef ENABLE_HCI_STATISTICS
+    connection->statistics.acl_packets_sent++;
+    connection->statistics.acl_bytes_sent += size;
+    hci_statistics_acl_fragment_sent(connection);
+#endif
+    if (hci_dump_active()){
+        hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, size);
+    }
+    int err = hci_stack->hci_transport->send_packet_iov(HCI_ACL_DATA_PACKET, iov, iov_count);
+
+    // release buffer now for synchronous transport
+    if (hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+    return err;
+}
+
 #ifdef ENABLE_CLASSIC
 // pre: caller has reserved the packet buffer
 int hci_send_sco_packet_buffer(int size){
@@ -817,15 +1551,848 @@ int hci_send_sco_packet_buffer(int size){
         }
     }
 
-    hci_dump_packet( HCI_SCO_DATA_PACKET, 0, packet, size);
-    int err = hci_stack->hci_transport->send_packet(HCI_SCO_DATA_PACKET, packet, size);
+    hci_dump_packet( HCI_SCO_DATA_PACKET, 0, packet, size);
+    int err = hci_stack->hci_transport->send_packet(HCI_SCO_DATA_PACKET, packet, size);
+
+    if (hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+
+    return err;
+}
+#endif
+
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+static hci_iso_stream_t * hci_iso_stream_for_con_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+        if (iso_stream->con_handle == con_handle) return iso_stream;
+    }
+    return NULL;
+}
+
+static hci_iso_stream_t * hci_iso_stream_create(hci_iso_type_t iso_type, hci_iso_stream_state_t state, hci_con_handle_t con_handle, uint8_t group_id){
+    hci_iso_stream_t * iso_stream = btstack_memory_hci_iso_stream_get();
+    if (iso_stream == NULL){
+        log_error("hci_iso_stream_create: no memory for stream 0x%04x", con_handle);
+        return NULL;
+    }
+    iso_stream->iso_type = iso_type;
+    iso_stream->state = state;
+    iso_stream->con_handle = con_handle;
+    iso_stream->group_id = group_id;
+    iso_stream->acl_con_handle = HCI_CON_HANDLE_INVALID;
+    btstack_linked_list_add(&hci_stack->iso_streams, (btstack_linked_item_t *) iso_stream);
+    return iso_stream;
+}
+
+static void hci_iso_stream_finalize(hci_iso_stream_t * iso_stream){
+    btstack_linked_list_remove(&hci_stack->iso_streams, (btstack_linked_item_t *) iso_stream);
+    btstack_memory_hci_iso_stream_free(iso_stream);
+}
+
+static void hci_iso_stream_finalize_by_type_and_group_id(hci_iso_type_t iso_type, uint8_t group_id){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+        if (iso_stream->iso_type != iso_type) continue;
+        if (iso_stream->group_id != group_id) continue;
+        btstack_linked_list_iterator_remove(&it);
+        btstack_memory_hci_iso_stream_free(iso_stream);
+    }
+}
+
+// reset stream for CIS of local CIG that can be connected again
+static void hci_iso_stream_configured(hci_iso_stream_t * iso_stream){
+    iso_stream->state = HCI_ISO_STREAM_STATE_CONFIGURED;
+    iso_stream->data_path_setup_todo = 0;
+    iso_stream->data_path_setup_active = false;
+    iso_stream->tx_sdu = NULL;
+    iso_stream->tx_can_send_now_requested = false;
+    iso_stream->num_packets_sent = 0;
+    iso_stream->rx_pos = 0;
+}
+
+static void hci_iso_stream_established(hci_iso_stream_t * iso_stream, uint8_t data_path_setup){
+    iso_stream->state = HCI_ISO_STREAM_STATE_ESTABLISHED;
+    iso_stream->data_path_setup_todo = data_path_setup;
+    iso_stream->tx_sequence_number = 0;
+    iso_stream->rx_pos = 0;
+    iso_stream->rx_discard = false;
+}
+
+static bool hci_iso_stream_ready(const hci_iso_stream_t * iso_stream){
+    if (iso_stream->state != HCI_ISO_STREAM_STATE_ESTABLISHED) return false;
+    if (iso_stream->data_path_setup_todo != 0) return false;
+    return iso_stream->data_path_setup_active == false;
+}
+
+static int hci_number_free_iso_slots(void){
+    unsigned int num_packets_sent = 0;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+        num_packets_sent += iso_stream->num_packets_sent;
+    }
+    if (num_packets_sent > hci_stack->iso_packets_total_num){
+        log_error("hci_number_free_iso_slots: outgoing packets (%u) > total packets (%u)", num_packets_sent, hci_stack->iso_packets_total_num);
+        return 0;
+    }
+    return hci_stack->iso_packets_total_num - num_packets_sent;
+}
+
+// pre: packet buffer not reserved, transport and Controller can accept ISO packet
+static void hci_iso_stream_send_fragment(hci_iso_stream_t * iso_stream){
+    hci_reserve_packet_buffer();
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+
+    // ISO Data Load header in first fragment
+    const bool first_fragment = iso_stream->tx_sdu_pos == 0;
+    uint16_t flags = 0;
+    uint16_t pos = HCI_ISO_HEADER_SIZE;
+    if (first_fragment){
+        if (iso_stream->tx_time_stamp_valid){
+            little_endian_store_32(packet, pos, iso_stream->tx_time_stamp);
+            pos += 4;
+            flags |= 1u << 14;
+        }
+        little_endian_store_16(packet, pos, iso_stream->tx_sequence_number);
+        pos += 2;
+        little_endian_store_16(packet, pos, iso_stream->tx_sdu_len);
+        pos += 2;
+    }
+
+    uint16_t fragment_len = iso_stream->tx_sdu_len - iso_stream->tx_sdu_pos;
+    uint16_t max_fragment_len = hci_stack->iso_data_packet_length - (pos - HCI_ISO_HEADER_SIZE);
+    if (fragment_len > max_fragment_len){
+        fragment_len = max_fragment_len;
+    }
+    (void)memcpy(&packet[pos], &iso_stream->tx_sdu[iso_stream->tx_sdu_pos], fragment_len);
+    iso_stream->tx_sdu_pos += fragment_len;
+    const bool last_fragment = iso_stream->tx_sdu_pos == iso_stream->tx_sdu_len;
+
+    // packet boundary flag: first fragment (0), continuation (1), complete SDU (2), last fragment (3)
+    uint16_t pb_flag;
+    if (first_fragment){
+        pb_flag = last_fragment ? 2 : 0;
+    } else {
+        pb_flag = last_fragment ? 3 : 1;
+    }
+    flags |= pb_flag << 12;
+    little_endian_store_16(packet, 0, iso_stream->con_handle | flags);
+    little_endian_store_16(packet, 2, pos - HCI_ISO_HEADER_SIZE + fragment_len);
+    pos += fragment_len;
+
+    iso_stream->num_packets_sent++;
+    if (last_fragment){
+        // SDU has been copied, buffer can be reused by application
+        iso_stream->tx_sdu = NULL;
+        iso_stream->tx_sequence_number++;
+    }
+
+    hci_dump_packet(HCI_ISO_DATA_PACKET, 0, packet, pos);
+    int err = hci_stack->hci_transport->send_packet(HCI_ISO_DATA_PACKET, packet, pos);
+
+    // release packet buffer on error or for synchronous transport implementations
+    if ((err < 0) || hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+}
+
+static bool hci_run_iso_fragments(void){
+    if (hci_stack->hci_packet_buffer_reserved) return false;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+        if (iso_stream->tx_sdu == NULL) continue;
+        if (!hci_transport_can_send_prepared_packet_now(HCI_ISO_DATA_PACKET)) return false;
+        if (hci_number_free_iso_slots() == 0) return false;
+        hci_iso_stream_send_fragment(iso_stream);
+        return true;
+    }
+    return false;
+}
+
+static void hci_iso_notify_can_send_now(void){
+    if (hci_stack->iso_packet_handler == NULL) return;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+        if (!iso_stream->tx_can_send_now_requested) continue;
+        if (iso_stream->tx_sdu != NULL) continue;
+        if (!hci_iso_stream_ready(iso_stream)) continue;
+        if (hci_number_free_iso_slots() == 0) return;
+        iso_stream->tx_can_send_now_requested = false;
+        uint8_t event[4];
+        event[0] = HCI_EVENT_ISO_CAN_SEND_NOW;
+        event[1] = sizeof(event) - 2;
+        little_endian_store_16(event, 2, iso_stream->con_handle);
+        hci_stack->iso_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    }
+}
+
+static void hci_iso_emit_sdu(uint8_t * packet, uint16_t size){
+    if (hci_stack->iso_packet_handler == NULL) return;
+    hci_stack->iso_packet_handler(HCI_ISO_DATA_PACKET, 0, packet, size);
+}
+
+static void hci_iso_packet_handler(hci_iso_stream_t * iso_stream, uint8_t * packet, uint16_t size){
+    if (size < HCI_ISO_HEADER_SIZE) return;
+    uint16_t handle_and_flags = little_endian_read_16(packet, 0);
+    uint16_t data_len = little_endian_read_16(packet, 2) & 0x3fff;
+    if ((HCI_ISO_HEADER_SIZE + data_len) != size){
+        log_error("hci_iso_packet_handler: invalid ISO data length %u for packet size %u", data_len, size);
+        return;
+    }
+
+    uint16_t pos;
+    uint8_t pb_flag = (handle_and_flags >> 12) & 0x03;
+    switch (pb_flag){
+        case 2:
+            // complete SDU, deliver in place
+            iso_stream->rx_pos = 0;
+            iso_stream->rx_discard = false;
+            hci_iso_emit_sdu(packet, size);
+            break;
+        case 0:
+            // first fragment with ISO Data Load header
+            iso_stream->rx_pos = 0;
+            iso_stream->rx_discard = size > sizeof(iso_stream->rx_buffer);
+            if (iso_stream->rx_discard){
+                log_error("hci_iso_packet_handler: SDU of stream 0x%04x larger than HCI_ISO_SDU_MAX_SIZE", iso_stream->con_handle);
+                break;
+            }
+            (void)memcpy(iso_stream->rx_buffer, packet, size);
+            iso_stream->rx_pos = size;
+            break;
+        default:
+            // continuation or last fragment, drop if first fragment is missing
+            if (iso_stream->rx_discard || (iso_stream->rx_pos == 0)){
+                iso_stream->rx_discard = pb_flag == 1;
+                break;
+            }
+            pos = iso_stream->rx_pos;
+            if ((pos + data_len) > sizeof(iso_stream->rx_buffer)){
+                log_error("hci_iso_packet_handler: SDU of stream 0x%04x larger than HCI_ISO_SDU_MAX_SIZE", iso_stream->con_handle);
+                iso_stream->rx_pos = 0;
+                iso_stream->rx_discard = pb_flag == 1;
+                break;
+            }
+            (void)memcpy(&iso_stream->rx_buffer[pos], &packet[HCI_ISO_HEADER_SIZE], data_len);
+            iso_stream->rx_pos += data_len;
+            if (pb_flag == 1) break;
+            // last fragment: mark as complete SDU, keep time stamp flag of first fragment
+            handle_and_flags = little_endian_read_16(iso_stream->rx_buffer, 0);
+            little_endian_store_16(iso_stream->rx_buffer, 0, (handle_and_flags & 0x4fff) | (2u << 12));
+            little_endian_store_16(iso_stream->rx_buffer, 2, iso_stream->rx_pos - HCI_ISO_HEADER_SIZE);
+            size = iso_stream->rx_pos;
+            iso_stream->rx_pos = 0;
+            hci_iso_emit_sdu(iso_stream->rx_buffer, size);
+            break;
+    }
+}
+
+static le_audio_cig_t * hci_cig_for_id(uint8_t cig_id){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_cigs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_audio_cig_t * cig = (le_audio_cig_t *) btstack_linked_list_iterator_next(&it);
+        if (cig->cig_id == cig_id) return cig;
+    }
+    return NULL;
+}
+
+static le_audio_big_t * hci_big_for_handle(uint8_t big_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_bigs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_audio_big_t * big = (le_audio_big_t *) btstack_linked_list_iterator_next(&it);
+        if (big->big_handle == big_handle) return big;
+    }
+    return NULL;
+}
+
+static le_audio_big_sync_t * hci_big_sync_for_handle(uint8_t big_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_big_syncs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_audio_big_sync_t * big_sync = (le_audio_big_sync_t *) btstack_linked_list_iterator_next(&it);
+        if (big_sync->big_handle == big_handle) return big_sync;
+    }
+    return NULL;
+}
+
+// create packets manually as arrays are not supported by BTstack command generator
+static void hci_iso_send_prepared_command(uint16_t size){
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    packet[2] = size - 3;
+    int err = hci_send_cmd_packet(packet, size);
+
+    // release packet buffer on error or for synchronous transport implementations
+    if ((err < 0) || hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+}
+
+static uint16_t hci_iso_prepare_command(uint16_t opcode){
+    hci_reserve_packet_buffer();
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    little_endian_store_16(packet, 0, opcode);
+    // param len set by hci_iso_send_prepared_command
+    return 3;
+}
+
+static void hci_send_le_set_cig_parameters(const le_audio_cig_params_t * params){
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    uint16_t pos = hci_iso_prepare_command(hci_le_set_cig_parameters.opcode);
+    packet[pos++] = params->cig_id;
+    little_endian_store_24(packet, pos, params->sdu_interval_c_to_p);
+    pos += 3;
+    little_endian_store_24(packet, pos, params->sdu_interval_p_to_c);
+    pos += 3;
+    packet[pos++] = params->worst_case_sca;
+    packet[pos++] = params->packing;
+    packet[pos++] = params->framing;
+    little_endian_store_16(packet, pos, params->max_transport_latency_c_to_p);
+    pos += 2;
+    little_endian_store_16(packet, pos, params->max_transport_latency_p_to_c);
+    pos += 2;
+    packet[pos++] = params->num_cis;
+    uint8_t i;
+    for (i = 0; i < params->num_cis; i++){
+        const le_audio_cis_params_t * cis_params = &params->cis_params[i];
+        packet[pos++] = cis_params->cis_id;
+        little_endian_store_16(packet, pos, cis_params->max_sdu_c_to_p);
+        pos += 2;
+        little_endian_store_16(packet, pos, cis_params->max_sdu_p_to_c);
+        pos += 2;
+        packet[pos++] = cis_params->phy_c_to_p;
+        packet[pos++] = cis_params->phy_p_to_c;
+        packet[pos++] = cis_params->rtn_c_to_p;
+        packet[pos++] = cis_params->rtn_p_to_c;
+    }
+    hci_iso_send_prepared_command(pos);
+}
+
+static void hci_send_le_create_cis(const le_audio_cig_t * cig){
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    uint16_t pos = hci_iso_prepare_command(hci_le_create_cis.opcode);
+    packet[pos++] = cig->num_cis;
+    uint8_t i;
+    for (i = 0; i < cig->num_cis; i++){
+        little_endian_store_16(packet, pos, cig->cis_con_handles[i]);
+        pos += 2;
+        little_endian_store_16(packet, pos, cig->acl_con_handles[i]);
+        pos += 2;
+    }
+    hci_iso_send_prepared_command(pos);
+}
+
+static void hci_send_le_big_create_sync(const le_audio_big_sync_params_t * params){
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    uint16_t pos = hci_iso_prepare_command(hci_le_big_create_sync.opcode);
+    packet[pos++] = params->big_handle;
+    little_endian_store_16(packet, pos, params->sync_handle);
+    pos += 2;
+    packet[pos++] = params->encryption;
+    (void)memcpy(&packet[pos], params->broadcast_code, 16);
+    pos += 16;
+    packet[pos++] = params->mse;
+    little_endian_store_16(packet, pos, params->big_sync_timeout_10ms);
+    pos += 2;
+    packet[pos++] = params->num_bis;
+    (void)memcpy(&packet[pos], params->bis_indices, params->num_bis);
+    pos += params->num_bis;
+    hci_iso_send_prepared_command(pos);
+}
+
+static bool hci_run_iso_commands(void){
+    btstack_linked_list_iterator_t it;
+
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_cigs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_audio_cig_t * cig = (le_audio_cig_t *) btstack_linked_list_iterator_next(&it);
+        switch (cig->state){
+            case LE_AUDIO_CIG_STATE_W2_CREATE:
+                cig->state = LE_AUDIO_CIG_STATE_W4_CREATED;
+                hci_send_le_set_cig_parameters(cig->params);
+                return true;
+            case LE_AUDIO_CIG_STATE_W2_CREATE_CIS:
+                cig->state = LE_AUDIO_CIG_STATE_CREATED;
+                hci_send_le_create_cis(cig);
+                return true;
+            case LE_AUDIO_CIG_STATE_W2_REMOVE:
+                cig->state = LE_AUDIO_CIG_STATE_W4_REMOVED;
+                hci_send_cmd(&hci_le_remove_cig, cig->cig_id);
+                return true;
+            default:
+                break;
+        }
+    }
+
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_bigs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_audio_big_t * big = (le_audio_big_t *) btstack_linked_list_iterator_next(&it);
+        const le_audio_big_params_t * params = big->params;
+        switch (big->state){
+            case LE_AUDIO_BIG_STATE_W2_CREATE:
+                big->state = LE_AUDIO_BIG_STATE_W4_CREATED;
+                hci_send_cmd(&hci_le_create_big, params->big_handle, params->advertising_handle, params->num_bis,
+                             params->sdu_interval_us, params->max_sdu, params->max_transport_latency_ms, params->rtn,
+                             params->phy, params->packing, params->framing, params->encryption, params->broadcast_code);
+                return true;
+            case LE_AUDIO_BIG_STATE_W2_TERMINATE:
+                big->state = LE_AUDIO_BIG_STATE_W4_TERMINATED;
+                hci_send_cmd(&hci_le_terminate_big, big->big_handle, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+                return true;
+            default:
+                break;
+        }
+    }
+
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_big_syncs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_audio_big_sync_t * big_sync = (le_audio_big_sync_t *) btstack_linked_list_iterator_next(&it);
+        switch (big_sync->state){
+            case LE_AUDIO_BIG_SYNC_STATE_W2_CREATE:
+                big_sync->state = LE_AUDIO_BIG_SYNC_STATE_W4_ESTABLISHED;
+                hci_send_le_big_create_sync(big_sync->params);
+                return true;
+            case LE_AUDIO_BIG_SYNC_STATE_W2_TERMINATE:
+                big_sync->state = LE_AUDIO_BIG_SYNC_STATE_W4_TERMINATED;
+                hci_send_cmd(&hci_le_big_terminate_sync, big_sync->big_handle);
+                return true;
+            default:
+                break;
+        }
+    }
+
+    btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+        hci_con_handle_t con_handle = iso_stream->con_handle;
+        switch (iso_stream->state){
+            case HCI_ISO_STREAM_STATE_W2_ACCEPT:
+                iso_stream->state = HCI_ISO_STREAM_STATE_W4_ESTABLISHED;
+                hci_send_cmd(&hci_le_accept_cis_request, con_handle);
+                return true;
+            case HCI_ISO_STREAM_STATE_W2_REJECT:
+                hci_iso_stream_finalize(iso_stream);
+                hci_send_cmd(&hci_le_reject_cis_request, con_handle, ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES);
+                return true;
+            case HCI_ISO_STREAM_STATE_ESTABLISHED:
+                if (iso_stream->data_path_setup_active) break;
+                if (iso_stream->data_path_setup_todo == 0) break;
+                // HCI data path (0) with transparent coding format (0x03), i.e. codec in Host
+                if ((iso_stream->data_path_setup_todo & HCI_ISO_DATA_PATH_SETUP_INPUT) != 0){
+                    iso_stream->data_path_setup_todo &= ~HCI_ISO_DATA_PATH_SETUP_INPUT;
+                    iso_stream->data_path_setup_active = true;
+                    hci_send_cmd(&hci_le_setup_iso_data_path, con_handle, 0, 0, 0x03, 0, 0, 0, 0);
+                } else {
+                    iso_stream->data_path_setup_todo &= ~HCI_ISO_DATA_PATH_SETUP_OUTPUT;
+                    iso_stream->data_path_setup_active = true;
+                    hci_send_cmd(&hci_le_setup_iso_data_path, con_handle, 1, 0, 0x03, 0, 0, 0, 0);
+                }
+                return true;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+static void hci_iso_handle_command_complete(const uint8_t * packet, uint16_t size){
+    uint16_t opcode = little_endian_read_16(packet, 3);
+    uint8_t status = packet[5];
+    le_audio_cig_t * cig;
+    le_audio_big_sync_t * big_sync;
+    hci_iso_stream_t * iso_stream;
+    uint8_t i;
+    if (opcode == hci_le_set_cig_parameters.opcode){
+        if (size < 8) return;
+        cig = hci_cig_for_id(packet[6]);
+        if ((cig == NULL) || (cig->state != LE_AUDIO_CIG_STATE_W4_CREATED)) return;
+        if ((status != ERROR_CODE_SUCCESS) || (packet[7] != cig->num_cis) || (size < (8 + 2 * cig->num_cis))){
+            btstack_linked_list_remove(&hci_stack->le_audio_cigs, (btstack_linked_item_t *) cig);
+            return;
+        }
+        for (i = 0; i < cig->num_cis; i++){
+            hci_con_handle_t cis_con_handle = little_endian_read_16(packet, 8 + 2 * i);
+            cig->cis_con_handles[i] = cis_con_handle;
+            // CIG parameters may be updated while CIS are not connected
+            if (hci_iso_stream_for_con_handle(cis_con_handle) == NULL){
+                (void) hci_iso_stream_create(HCI_ISO_TYPE_CIS, HCI_ISO_STREAM_STATE_CONFIGURED, cis_con_handle, cig->cig_id);
+            }
+        }
+        cig->state = LE_AUDIO_CIG_STATE_CREATED;
+    } else if (opcode == hci_le_remove_cig.opcode){
+        if (size < 7) return;
+        cig = hci_cig_for_id(packet[6]);
+        if ((cig == NULL) || (cig->state != LE_AUDIO_CIG_STATE_W4_REMOVED)) return;
+        if (status != ERROR_CODE_SUCCESS){
+            cig->state = LE_AUDIO_CIG_STATE_CREATED;
+            return;
+        }
+        hci_iso_stream_finalize_by_type_and_group_id(HCI_ISO_TYPE_CIS, cig->cig_id);
+        btstack_linked_list_remove(&hci_stack->le_audio_cigs, (btstack_linked_item_t *) cig);
+    } else if (opcode == hci_le_big_terminate_sync.opcode){
+        if (size < 7) return;
+        big_sync = hci_big_sync_for_handle(packet[6]);
+        if ((big_sync == NULL) || (big_sync->state != LE_AUDIO_BIG_SYNC_STATE_W4_TERMINATED)) return;
+        hci_iso_stream_finalize_by_type_and_group_id(HCI_ISO_TYPE_BIS, big_sync->big_handle);
+        btstack_linked_list_remove(&hci_stack->le_audio_big_syncs, (btstack_linked_item_t *) big_sync);
+    } else if (opcode == hci_le_setup_iso_data_path.opcode){
+        if (size < 8) return;
+        iso_stream = hci_iso_stream_for_con_handle(little_endian_read_16(packet, 6));
+        if (iso_stream == NULL) return;
+        if (status != ERROR_CODE_SUCCESS){
+            log_error("LE Setup ISO Data Path for stream 0x%04x failed, status 0x%02x", iso_stream->con_handle, status);
+        }
+        iso_stream->data_path_setup_active = false;
+        hci_iso_notify_can_send_now();
+    }
+}
+
+static void hci_iso_handle_command_status(const uint8_t * packet){
+    uint8_t status = packet[2];
+    if (status == ERROR_CODE_SUCCESS) return;
+    uint16_t opcode = little_endian_read_16(packet, 4);
+    btstack_linked_list_iterator_t it;
+    if (opcode == hci_le_create_big.opcode){
+        btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_bigs);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            le_audio_big_t * big = (le_audio_big_t *) btstack_linked_list_iterator_next(&it);
+            if (big->state == LE_AUDIO_BIG_STATE_W4_CREATED){
+                btstack_linked_list_iterator_remove(&it);
+            }
+        }
+    } else if (opcode == hci_le_terminate_big.opcode){
+        btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_bigs);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            le_audio_big_t * big = (le_audio_big_t *) btstack_linked_list_iterator_next(&it);
+            if (big->state == LE_AUDIO_BIG_STATE_W4_TERMINATED){
+                big->state = LE_AUDIO_BIG_STATE_CREATED;
+            }
+        }
+    } else if (opcode == hci_le_big_create_sync.opcode){
+        btstack_linked_list_iterator_init(&it, &hci_stack->le_audio_big_syncs);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            le_audio_big_sync_t * big_sync = (le_audio_big_sync_t *) btstack_linked_list_iterator_next(&it);
+            if (big_sync->state == LE_AUDIO_BIG_SYNC_STATE_W4_ESTABLISHED){
+                btstack_linked_list_iterator_remove(&it);
+            }
+        }
+    } else if ((opcode == hci_le_create_cis.opcode) || (opcode == hci_le_accept_cis_request.opcode)){
+        // no LE CIS Established events will follow
+        btstack_linked_list_iterator_init(&it, &hci_stack->iso_streams);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            hci_iso_stream_t * iso_stream = (hci_iso_stream_t *) btstack_linked_list_iterator_next(&it);
+            if (iso_stream->state != HCI_ISO_STREAM_STATE_W4_ESTABLISHED) continue;
+            if (hci_cig_for_id(iso_stream->group_id) != NULL){
+                if (opcode == hci_le_create_cis.opcode){
+                    hci_iso_stream_configured(iso_stream);
+                }
+            } else if (opcode == hci_le_accept_cis_request.opcode){
+                btstack_linked_list_iterator_remove(&it);
+                btstack_memory_hci_iso_stream_free(iso_stream);
+            }
+        }
+    }
+}
+
+static void hci_iso_handle_le_meta_event(const uint8_t * packet, uint16_t size){
+    hci_iso_stream_t * iso_stream;
+    le_audio_big_t * big;
+    le_audio_big_sync_t * big_sync;
+    uint8_t data_path_setup;
+    uint8_t num_bis;
+    uint8_t i;
+    switch (packet[2]){
+        case HCI_SUBEVENT_LE_CIS_REQUEST:
+            if (size < 9) break;
+            iso_stream = hci_iso_stream_create(HCI_ISO_TYPE_CIS, HCI_ISO_STREAM_STATE_REQUESTED, little_endian_read_16(packet, 5), packet[7]);
+            if (iso_stream == NULL) break;
+            iso_stream->acl_con_handle = little_endian_read_16(packet, 3);
+            break;
+        case HCI_SUBEVENT_LE_CIS_ESTABLISHED:
+            if (size < 31) break;
+            iso_stream = hci_iso_stream_for_con_handle(hci_subevent_le_cis_established_get_connection_handle(packet));
+            if (iso_stream == NULL) break;
+            // CIG is local as Central
+            if (hci_cig_for_id(iso_stream->group_id) != NULL){
+                if (hci_subevent_le_cis_established_get_status(packet) != ERROR_CODE_SUCCESS){
+                    hci_iso_stream_configured(iso_stream);
+                    break;
+                }
+                data_path_setup = 0;
+                if (hci_subevent_le_cis_established_get_bn_c_to_p(packet) > 0) data_path_setup |= HCI_ISO_DATA_PATH_SETUP_INPUT;
+                if (hci_subevent_le_cis_established_get_bn_p_to_c(packet) > 0) data_path_setup |= HCI_ISO_DATA_PATH_SETUP_OUTPUT;
+            } else {
+                if (hci_subevent_le_cis_established_get_status(packet) != ERROR_CODE_SUCCESS){
+                    hci_iso_stream_finalize(iso_stream);
+                    break;
+                }
+                data_path_setup = 0;
+                if (hci_subevent_le_cis_established_get_bn_p_to_c(packet) > 0) data_path_setup |= HCI_ISO_DATA_PATH_SETUP_INPUT;
+                if (hci_subevent_le_cis_established_get_bn_c_to_p(packet) > 0) data_path_setup |= HCI_ISO_DATA_PATH_SETUP_OUTPUT;
+            }
+            hci_iso_stream_established(iso_stream, data_path_setup);
+            break;
+        case HCI_SUBEVENT_LE_CREATE_BIG_COMPLETE:
+            if (size < 21) break;
+            big = hci_big_for_handle(hci_subevent_le_create_big_complete_get_big_handle(packet));
+            if ((big == NULL) || (big->state != LE_AUDIO_BIG_STATE_W4_CREATED)) break;
+            num_bis = hci_subevent_le_create_big_complete_get_num_bis(packet);
+            if ((hci_subevent_le_create_big_complete_get_status(packet) != ERROR_CODE_SUCCESS) || (num_bis > MAX_NR_BIS) || (size < (21 + 2 * num_bis))){
+                btstack_linked_list_remove(&hci_stack->le_audio_bigs, (btstack_linked_item_t *) big);
+                break;
+            }
+            big->num_bis = num_bis;
+            for (i = 0; i < num_bis; i++){
+                big->bis_con_handles[i] = little_endian_read_16(packet, 21 + 2 * i);
+                iso_stream = hci_iso_stream_create(HCI_ISO_TYPE_BIS, HCI_ISO_STREAM_STATE_ESTABLISHED, big->bis_con_handles[i], big->big_handle);
+                if (iso_stream == NULL) continue;
+                hci_iso_stream_established(iso_stream, HCI_ISO_DATA_PATH_SETUP_INPUT);
+            }
+            big->state = LE_AUDIO_BIG_STATE_CREATED;
+            break;
+        case HCI_SUBEVENT_LE_TERMINATE_BIG_COMPLETE:
+            if (size < 5) break;
+            big = hci_big_for_handle(hci_subevent_le_terminate_big_complete_get_big_handle(packet));
+            if (big == NULL) break;
+            hci_iso_stream_finalize_by_type_and_group_id(HCI_ISO_TYPE_BIS, big->big_handle);
+            btstack_linked_list_remove(&hci_stack->le_audio_bigs, (btstack_linked_item_t *) big);
+            break;
+        case HCI_SUBEVENT_LE_BIG_SYNC_ESTABLISHED:
+            if (size < 17) break;
+            big_sync = hci_big_sync_for_handle(hci_subevent_le_big_sync_established_get_big_handle(packet));
+            if ((big_sync == NULL) || (big_sync->state != LE_AUDIO_BIG_SYNC_STATE_W4_ESTABLISHED)) break;
+            num_bis = hci_subevent_le_big_sync_established_get_num_bis(packet);
+            if ((hci_subevent_le_big_sync_established_get_status(packet) != ERROR_CODE_SUCCESS) || (num_bis > MAX_NR_BIS) || (size < (17 + 2 * num_bis))){
+                btstack_linked_list_remove(&hci_stack->le_audio_big_syncs, (btstack_linked_item_t *) big_sync);
+                break;
+            }
+            big_sync->num_bis = num_bis;
+            for (i = 0; i < num_bis; i++){
+                big_sync->bis_con_handles[i] = little_endian_read_16(packet, 17 + 2 * i);
+                iso_stream = hci_iso_stream_create(HCI_ISO_TYPE_BIS, HCI_ISO_STREAM_STATE_ESTABLISHED, big_sync->bis_con_handles[i], big_sync->big_handle);
+                if (iso_stream == NULL) continue;
+                hci_iso_stream_established(iso_stream, HCI_ISO_DATA_PATH_SETUP_OUTPUT);
+            }
+            big_sync->state = LE_AUDIO_BIG_SYNC_STATE_ESTABLISHED;
+            break;
+        case HCI_SUBEVENT_LE_BIG_SYNC_LOST:
+            if (size < 5) break;
+            big_sync = hci_big_sync_for_handle(hci_subevent_le_big_sync_lost_get_big_handle(packet));
+            if (big_sync == NULL) break;
+            hci_iso_stream_finalize_by_type_and_group_id(HCI_ISO_TYPE_BIS, big_sync->big_handle);
+            btstack_linked_list_remove(&hci_stack->le_audio_big_syncs, (btstack_linked_item_t *) big_sync);
+            break;
+        default:
+            break;
+    }
+}
+
+// @return true if handle belongs to CIS
+static bool hci_iso_handle_disconnection_complete(hci_con_handle_t con_handle){
+    hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(con_handle);
+    if (iso_stream == NULL) return false;
+    if (hci_cig_for_id(iso_stream->group_id) != NULL){
+        // CIS of local CIG can be created again
+        hci_iso_stream_configured(iso_stream);
+    } else {
+        hci_iso_stream_finalize(iso_stream);
+    }
+    return true;
+}
+
+static void hci_iso_reset(void){
+    while (hci_stack->iso_streams != NULL){
+        hci_iso_stream_finalize((hci_iso_stream_t *) hci_stack->iso_streams);
+    }
+    hci_stack->le_audio_cigs = NULL;
+    hci_stack->le_audio_bigs = NULL;
+    hci_stack->le_audio_big_syncs = NULL;
+}
+
+void hci_register_iso_packet_handler(btstack_packet_handler_t handler){
+    hci_stack->iso_packet_handler = handler;
+}
+
+uint8_t hci_request_iso_can_send_now_event(hci_con_handle_t con_handle){
+    hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(con_handle);
+    if (iso_stream == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    iso_stream->tx_can_send_now_requested = true;
+    hci_iso_notify_can_send_now();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t hci_send_iso_sdu(hci_con_handle_t con_handle, const uint8_t * sdu, uint16_t sdu_len, bool time_stamp_valid, uint32_t time_stamp){
+    hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(con_handle);
+    if (iso_stream == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (!hci_iso_stream_ready(iso_stream)) return ERROR_CODE_COMMAND_DISALLOWED;
+    // ISO Data Load header with time stamp has to fit into first fragment
+    if (hci_stack->iso_data_packet_length <= HCI_ISO_DATA_LOAD_HEADER_SIZE) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (iso_stream->tx_sdu != NULL) return ERROR_CODE_CONTROLLER_BUSY;
+    if (sdu_len > 0x0fff) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    iso_stream->tx_sdu = sdu;
+    iso_stream->tx_sdu_len = sdu_len;
+    iso_stream->tx_sdu_pos = 0;
+    iso_stream->tx_time_stamp_valid = time_stamp_valid;
+    iso_stream->tx_time_stamp = time_stamp;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_cig_create(le_audio_cig_t * storage, const le_audio_cig_params_t * params){
+    if ((params->num_cis == 0) || (params->num_cis > MAX_NR_CIS)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    // LE Set CIG Parameters has to fit into outgoing packet buffer
+    if ((18u + 9u * params->num_cis) > HCI_OUTGOING_PACKET_BUFFER_SIZE) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (hci_cig_for_id(params->cig_id) != NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    memset(storage, 0, sizeof(le_audio_cig_t));
+    storage->state = LE_AUDIO_CIG_STATE_W2_CREATE;
+    storage->params = params;
+    storage->cig_id = params->cig_id;
+    storage->num_cis = params->num_cis;
+    btstack_linked_list_add(&hci_stack->le_audio_cigs, (btstack_linked_item_t *) storage);
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_cis_create(uint8_t cig_id, const hci_con_handle_t * acl_con_handles){
+    le_audio_cig_t * cig = hci_cig_for_id(cig_id);
+    if (cig == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (cig->state != LE_AUDIO_CIG_STATE_CREATED) return ERROR_CODE_COMMAND_DISALLOWED;
+    uint8_t i;
+    for (i = 0; i < cig->num_cis; i++){
+        hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(cig->cis_con_handles[i]);
+        if ((iso_stream == NULL) || (iso_stream->state != HCI_ISO_STREAM_STATE_CONFIGURED)) return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    for (i = 0; i < cig->num_cis; i++){
+        hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(cig->cis_con_handles[i]);
+        iso_stream->acl_con_handle = acl_con_handles[i];
+        iso_stream->state = HCI_ISO_STREAM_STATE_W4_ESTABLISHED;
+        cig->acl_con_handles[i] = acl_con_handles[i];
+    }
+    cig->state = LE_AUDIO_CIG_STATE_W2_CREATE_CIS;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_cig_remove(uint8_t cig_id){
+    le_audio_cig_t * cig = hci_cig_for_id(cig_id);
+    if (cig == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (cig->state != LE_AUDIO_CIG_STATE_CREATED) return ERROR_CODE_COMMAND_DISALLOWED;
+    cig->state = LE_AUDIO_CIG_STATE_W2_REMOVE;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+static uint8_t gap_cis_respond(hci_con_handle_t cis_con_handle, hci_iso_stream_state_t state){
+    hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(cis_con_handle);
+    if (iso_stream == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (iso_stream->state != HCI_ISO_STREAM_STATE_REQUESTED) return ERROR_CODE_COMMAND_DISALLOWED;
+    iso_stream->state = state;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_cis_accept(hci_con_handle_t cis_con_handle){
+    return gap_cis_respond(cis_con_handle, HCI_ISO_STREAM_STATE_W2_ACCEPT);
+}
+
+uint8_t gap_cis_reject(hci_con_handle_t cis_con_handle){
+    return gap_cis_respond(cis_con_handle, HCI_ISO_STREAM_STATE_W2_REJECT);
+}
+
+uint8_t gap_big_create(le_audio_big_t * storage, const le_audio_big_params_t * params){
+    if ((params->num_bis == 0) || (params->num_bis > MAX_NR_BIS)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (hci_big_for_handle(params->big_handle) != NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (hci_big_sync_for_handle(params->big_handle) != NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    memset(storage, 0, sizeof(le_audio_big_t));
+    storage->state = LE_AUDIO_BIG_STATE_W2_CREATE;
+    storage->params = params;
+    storage->big_handle = params->big_handle;
+    btstack_linked_list_add(&hci_stack->le_audio_bigs, (btstack_linked_item_t *) storage);
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_big_terminate(uint8_t big_handle){
+    le_audio_big_t * big = hci_big_for_handle(big_handle);
+    if (big == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (big->state != LE_AUDIO_BIG_STATE_CREATED) return ERROR_CODE_COMMAND_DISALLOWED;
+    big->state = LE_AUDIO_BIG_STATE_W2_TERMINATE;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_big_sync_create(le_audio_big_sync_t * storage, const le_audio_big_sync_params_t * params){
+    if ((params->num_bis == 0) || (params->num_bis > MAX_NR_BIS)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (hci_big_for_handle(params->big_handle) != NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (hci_big_sync_for_handle(params->big_handle) != NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    memset(storage, 0, sizeof(le_audio_big_sync_t));
+    storage->state = LE_AUDIO_BIG_SYNC_STATE_W2_CREATE;
+    storage->params = params;
+    storage->big_handle = params->big_handle;
+    btstack_linked_list_add(&hci_stack->le_audio_big_syncs, (btstack_linked_item_t *) storage);
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_big_sync_terminate(uint8_t big_handle){
+    le_audio_big_sync_t * big_sync = hci_big_sync_for_handle(big_handle);
+    if (big_sync == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    switch (big_sync->state){
+        case LE_AUDIO_BIG_SYNC_STATE_W2_CREATE:
+            // not requested yet
+            btstack_linked_list_remove(&hci_stack->le_audio_big_syncs, (btstack_linked_item_t *) big_sync);
+            return ERROR_CODE_SUCCESS;
+        case LE_AUDIO_BIG_SYNC_STATE_W4_ESTABLISHED:
+        case LE_AUDIO_BIG_SYNC_STATE_ESTABLISHED:
+            // HCI_LE_BIG_Terminate_Sync also cancels pending HCI_LE_BIG_Create_Sync
+            big_sync->state = LE_AUDIO_BIG_SYNC_STATE_W2_TERMINATE;
+            hci_run();
+            return ERROR_CODE_SUCCESS;
+        default:
+            return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+}
+#endif
+
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING
+static void hci_host_num_completed_packets_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    hci_stack->host_completed_packets = 1;
+    hci_run();
+}
+#endif
 
-    if (hci_transport_synchronous()){
-        hci_release_packet_buffer();
-        hci_emit_transport_packet_sent();
+static void hci_host_completed_packet(hci_connection_t * conn){
+    conn->num_packets_completed++;
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING
+    hci_stack->host_completed_packets_pending++;
+    if (hci_stack->host_completed_packets_pending >= HCI_HOST_NUM_COMPLETED_PACKETS_WATERMARK){
+        btstack_run_loop_remove_timer(&hci_stack->host_completed_packets_timer);
+        hci_stack->host_completed_packets = 1;
+    } else if (hci_stack->host_completed_packets_pending == 1){
+        btstack_run_loop_set_timer_handler(&hci_stack->host_completed_packets_timer, &hci_host_num_completed_packets_timeout_handler);
+        btstack_run_loop_set_timer(&hci_stack->host_completed_packets_timer, HCI_HOST_NUM_COMPLETED_PACKETS_TIMEOUT_MS);
+        btstack_run_loop_add_timer(&hci_stack->host_completed_packets_timer);
     }
-
-    return err;
+#else
+    hci_stack->host_completed_packets = 1;
+#endif
 }
 #endif
 
@@ -856,24 +2423,40 @@ static void acl_handler(uint8_t *packet, int size){
     hci_connection_timestamp(conn);
 #endif
 
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    hci_le_connection_profile_activity(conn, packet);
+#endif
+
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
-    hci_stack->host_completed_packets = 1;
-    conn->num_packets_completed++;
+    hci_host_completed_packet(conn);
+#endif
+
+#ifdef ENABLE_HCI_STATISTICS
+    conn->statistics.acl_packets_received++;
+    conn->statistics.acl_bytes_received += acl_length;
 #endif
 
     // handle different packet types
     switch (acl_flags & 0x03) {
             
         case 0x01: // continuation fragment
-            
+
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+            // append fragment payload to provided buffer
+            if (conn->acl_provider_buffer != NULL){
+                hci_acl_buffer_provider_continue(conn, &packet[4], acl_length);
+                break;
+            }
+#endif
+
             // sanity checks
             if (conn->acl_recombination_pos == 0) {
                 log_error( "ACL Cont Fragment but no first fragment for handle 0x%02x", con_handle);
                 return;
             }
-            if ((conn->acl_recombination_pos + acl_length) > (4 + HCI_ACL_BUFFER_SIZE)){
+            if ((conn->acl_recombination_pos + acl_length) > (4 + HCI_ACL_RECOMBINATION_BUFFER_SIZE)){
                 log_error( "ACL Cont Fragment to large: combined packet %u > buffer size %u for handle 0x%02x",
-                    conn->acl_recombination_pos + acl_length, 4 + HCI_ACL_BUFFER_SIZE, con_handle);
+                    conn->acl_recombination_pos + acl_length, 4 + HCI_ACL_RECOMBINATION_BUFFER_SIZE, con_handle);
                 conn->acl_recombination_pos = 0;
                 return;
             }
@@ -902,6 +2485,12 @@ static void acl_handler(uint8_t *packet, int size){
                 log_error( "ACL First Fragment but data in buffer for handle 0x%02x, dropping stale fragments", con_handle);
                 conn->acl_recombination_pos = 0;
             }
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+            if (conn->acl_provider_buffer != NULL){
+                log_error( "ACL First Fragment but provided buffer pending for handle 0x%02x, dropping stale fragments", con_handle);
+                hci_acl_buffer_provider_abort(conn);
+            }
+#endif
 
             // peek into L2CAP packet!
             uint16_t l2cap_length = READ_L2CAP_LENGTH( packet );
@@ -914,9 +2503,14 @@ static void acl_handler(uint8_t *packet, int size){
                 hci_emit_acl_packet(packet, acl_length + 4);
             } else {
 
-                if (acl_length > HCI_ACL_BUFFER_SIZE){
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+                // reassemble directly into buffer from provider
+                if (hci_acl_buffer_provider_start(conn, packet, acl_length, l2cap_length)) break;
+#endif
+
+                if (acl_length > HCI_ACL_RECOMBINATION_BUFFER_SIZE){
                     log_error( "ACL First Fragment to large: fragment %u > buffer size %u for handle 0x%02x",
-                        4 + acl_length, 4 + HCI_ACL_BUFFER_SIZE, con_handle);
+                        4 + acl_length, 4 + HCI_ACL_RECOMBINATION_BUFFER_SIZE, con_handle);
                     return;
                 }
 
@@ -949,13 +2543,33 @@ static void hci_shutdown_connection(hci_connection_t *conn){
 #endif
 
     btstack_run_loop_remove_timer(&conn->timeout);
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+    btstack_run_loop_remove_timer(&conn->auto_sniff_timer);
+#endif
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    btstack_run_loop_remove_timer(&conn->le_connection_profile_timer);
+#endif
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+    bool le_ce_length_reallocate = conn->le_throughput_demand != 0;
+#endif
     
-    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free(conn);
+
+#ifdef ENABLE_HCI_STATISTICS
+    // outstanding packets of connection are gone, too
+    hci_statistics_acl_credits_returned();
+#endif
     
     // now it's gone
     hci_emit_nr_connections_changed();
 
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+    // share radio time of closed connection with remaining ones
+    if (le_ce_length_reallocate){
+        hci_le_ce_length_allocator_update();
+    }
+#endif
+
 #ifdef ENABLE_CLASSIC
 #ifdef ENABLE_SCO_OVER_HCI
     // update SCO
@@ -1078,12 +2692,92 @@ void gap_le_get_own_address(uint8_t * addr_type, bd_addr_t addr){
 }
 
 #ifdef ENABLE_LE_CENTRAL
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+void gap_set_advertising_report_filter(const gap_le_advertising_report_filter_t * filter){
+    hci_stack->le_advertising_report_filter = filter;
+    memset(hci_stack->le_advertising_report_dedup_table, 0, sizeof(hci_stack->le_advertising_report_dedup_table));
+}
+
+static bool hci_le_advertising_report_contains_ad_type(uint8_t ad_len, const uint8_t * ad_data, uint8_t ad_type){
+    ad_context_t context;
+    for (ad_iterator_init(&context, ad_len, ad_data) ; ad_iterator_has_more(&context) ; ad_iterator_next(&context)){
+        if (ad_iterator_get_data_type(&context) == ad_type) return true;
+    }
+    return false;
+}
+
+static bool hci_le_advertising_report_contains_company_id(uint8_t ad_len, const uint8_t * ad_data, uint16_t company_id){
+    ad_context_t context;
+    for (ad_iterator_init(&context, ad_len, ad_data) ; ad_iterator_has_more(&context) ; ad_iterator_next(&context)){
+        if (ad_iterator_get_data_type(&context) != BLUETOOTH_DATA_TYPE_MANUFACTURER_SPECIFIC_DATA) continue;
+        if (ad_iterator_get_data_len(&context) < 2) continue;
+        if (little_endian_read_16(ad_iterator_get_data(&context), 0) == company_id) return true;
+    }
+    return false;
+}
+
+// @returns false if report has been seen within dedup window, records report otherwise
+static bool hci_le_advertising_report_dedup(uint8_t event_type, uint8_t address_type, const uint8_t * address,
+                                            const uint8_t * ad_data, uint8_t ad_len, uint32_t now, uint16_t window_ms){
+    // same address hash as connection address table
+    uint16_t index = (uint16_t) address_type;
+    int i;
+    for (i=0;i<6;i++){
+        index = (uint16_t)((index * 31u) + address[i]);
+    }
+    index &= (GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE - 1);
+
+    // FNV-1a over event type and advertising data
+    uint32_t content_hash = (2166136261u ^ event_type) * 16777619u;
+    for (i=0;i<ad_len;i++){
+        content_hash = (content_hash ^ ad_data[i]) * 16777619u;
+    }
+
+    le_advertising_report_dedup_entry_t * entry = &hci_stack->le_advertising_report_dedup_table[index];
+    if (entry->valid
+        && (entry->address_type == address_type)
+        && (memcmp(entry->address, address, 6) == 0)
+        && (entry->content_hash == content_hash)
+        && ((uint32_t)(now - entry->timestamp_ms) < window_ms)){
+        return false;
+    }
+
+    // new or changed report, or collision: replace entry
+    (void)memcpy(entry->address, address, 6);
+    entry->address_type = address_type;
+    entry->content_hash = content_hash;
+    entry->timestamp_ms = now;
+    entry->valid = true;
+    return true;
+}
+
+// @param address in little endian as in HCI event
+static bool hci_le_advertising_report_passes_filter(uint8_t event_type, uint8_t address_type, const uint8_t * address,
+                                                    int8_t rssi, const uint8_t * ad_data, uint8_t ad_len, uint32_t now){
+    const gap_le_advertising_report_filter_t * filter = hci_stack->le_advertising_report_filter;
+    if (rssi < filter->rssi_min) return false;
+    if ((filter->ad_type != 0) && !hci_le_advertising_report_contains_ad_type(ad_len, ad_data, filter->ad_type)) return false;
+    if ((filter->uuid16 != 0)  && !ad_data_contains_uuid16(ad_len, ad_data, filter->uuid16)) return false;
+    if (filter->company_id_match && !hci_le_advertising_report_contains_company_id(ad_len, ad_data, filter->company_id)) return false;
+    // dedup last to not record reports that get dropped anyway
+    if (filter->dedup_window_ms == 0) return true;
+    return hci_le_advertising_report_dedup(event_type, address_type, address, ad_data, ad_len, now, filter->dedup_window_ms);
+}
+#endif
+
 void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
 
     int offset = 3;
     int num_reports = packet[offset];
     offset += 1;
 
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+    uint32_t now = 0;
+    if (hci_stack->le_advertising_report_filter != NULL){
+        now = btstack_run_loop_get_time_ms();
+    }
+#endif
+
     int i;
     // log_info("HCI: handle adv report with num reports: %d", num_reports);
     uint8_t event[12 + LE_ADVERTISING_DATA_SIZE]; // use upper bound to avoid var size automatic var
@@ -1092,6 +2786,15 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
         uint8_t data_length = packet[offset + 8];
         if (data_length > LE_ADVERTISING_DATA_SIZE) return;
         if ((offset + 9 + data_length + 1) > size)    return;
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+        if (hci_stack->le_advertising_report_filter != NULL){
+            int8_t rssi = (int8_t) packet[offset + 9 + data_length];
+            if (!hci_le_advertising_report_passes_filter(packet[offset], packet[offset+1], &packet[offset+2], rssi, &packet[offset+9], data_length, now)){
+                offset += 9 + data_length + 1;
+                continue;
+            }
+        }
+#endif
         // setup event
         uint8_t event_size = 10 + data_length;
         int pos = 0;
@@ -1109,8 +2812,564 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
         hci_emit_event(event, pos, 1);
     }
 }
+
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+// map event type of legacy PDU in Extended Advertising Report to event type in Advertising Report
+static uint8_t hci_le_legacy_advertising_event_type(uint16_t event_type){
+    switch (event_type & 0x1f){
+        case 0x13:  // ADV_IND
+            return 0;
+        case 0x15:  // ADV_DIRECT_IND
+            return 1;
+        case 0x12:  // ADV_SCAN_IND
+            return 2;
+        case 0x1a:  // SCAN_RSP to ADV_SCAN_IND
+        case 0x1b:  // SCAN_RSP to ADV_IND
+            return 4;
+        default:    // ADV_NONCONN_IND
+            return 3;
+    }
+}
+
+// @param report in Extended Advertising Report with legacy PDU
+static void hci_le_emit_legacy_advertising_report(const uint8_t * report, uint8_t data_length){
+    uint8_t event[12 + LE_ADVERTISING_DATA_SIZE];
+    int pos = 0;
+    event[pos++] = GAP_EVENT_ADVERTISING_REPORT;
+    event[pos++] = 10 + data_length;
+    event[pos++] = hci_le_legacy_advertising_event_type(little_endian_read_16(report, 0));
+    (void)memcpy(&event[pos], &report[2], 1 + 6); // address type + address
+    pos += 7;
+    event[pos++] = report[13]; // rssi
+    event[pos++] = data_length;
+    (void)memcpy(&event[pos], &report[24], data_length);
+    pos += data_length;
+    hci_emit_event(event, pos, 1);
+}
+
+static void hci_le_extended_advertising_report_complete(uint32_t now){
+    uint8_t * event = hci_stack->le_extended_advertising_report;
+    uint8_t data_len = hci_stack->le_extended_advertising_report_data_len;
+    hci_stack->le_extended_advertising_report_active = false;
+    // data status: complete (0) or incomplete, truncated (2)
+    event[2] &= 0x9f;
+    if (hci_stack->le_extended_advertising_report_truncated){
+        event[2] |= 0x40;
+    }
+    event[1]  = 24 + data_len;
+    event[25] = data_len;
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+    if ((hci_stack->le_advertising_report_filter != NULL)
+        && !hci_le_advertising_report_passes_filter(event[2], event[4], &event[5], (int8_t) event[15], &event[26], data_len, now)) return;
+#else
+    UNUSED(now);
+#endif
+    hci_emit_event(event, 2 + 24 + data_len, 1);
+}
+
+static void le_handle_extended_advertisement_report(uint8_t *packet, uint16_t size){
+
+    int offset = 3;
+    int num_reports = packet[offset];
+    offset += 1;
+
+    uint32_t now = 0;
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+    if (hci_stack->le_advertising_report_filter != NULL){
+        now = btstack_run_loop_get_time_ms();
+    }
+#endif
+
+    int i;
+    for (i=0; (i<num_reports) && (offset < size);i++){
+        // sanity checks on data_length:
+        if ((offset + 24) > size) return;
+        const uint8_t * report = &packet[offset];
+        uint16_t event_type  = little_endian_read_16(report, 0);
+        uint8_t  data_length = report[23];
+        if ((offset + 24 + data_length) > size) return;
+        offset += 24 + data_length;
+        const uint8_t * data = &report[24];
+
+        // legacy PDUs are reported as GAP_EVENT_ADVERTISING_REPORT
+        if ((event_type & 0x10) != 0){
+            if (data_length > LE_ADVERTISING_DATA_SIZE) continue;
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+            if ((hci_stack->le_advertising_report_filter != NULL)
+                && !hci_le_advertising_report_passes_filter(hci_le_legacy_advertising_event_type(event_type), report[2], &report[3], (int8_t) report[13], data, data_length, now)) continue;
+#endif
+            hci_le_emit_legacy_advertising_report(report, data_length);
+            continue;
+        }
+
+        // fragment from other advertiser: report previous one as truncated
+        uint8_t * event = hci_stack->le_extended_advertising_report;
+        if (hci_stack->le_extended_advertising_report_active
+            && ((memcmp(&event[4], &report[2], 1 + 6) != 0) || (event[13] != report[11]))){
+            hci_stack->le_extended_advertising_report_truncated = true;
+            hci_le_extended_advertising_report_complete(now);
+        }
+
+        // first fragment provides all fields but data
+        if (!hci_stack->le_extended_advertising_report_active){
+            event[0] = GAP_EVENT_EXTENDED_ADVERTISING_REPORT;
+            (void)memcpy(&event[2], report, 23);
+            hci_stack->le_extended_advertising_report_active = true;
+            hci_stack->le_extended_advertising_report_truncated = false;
+            hci_stack->le_extended_advertising_report_data_len = 0;
+        }
+
+        uint8_t data_len = hci_stack->le_extended_advertising_report_data_len;
+        uint8_t bytes_to_copy = (uint8_t) btstack_min(data_length, GAP_LE_EXTENDED_ADVERTISING_REPORT_DATA_SIZE - data_len);
+        (void)memcpy(&event[26 + data_len], data, bytes_to_copy);
+        hci_stack->le_extended_advertising_report_data_len = data_len + bytes_to_copy;
+        if (bytes_to_copy < data_length){
+            hci_stack->le_extended_advertising_report_truncated = true;
+        }
+
+        // data status: complete (0), incomplete with more data to come (1), incomplete and truncated (2)
+        uint8_t data_status = (event_type >> 5) & 0x03;
+        if (data_status == 1) continue;
+        if (data_status != 0){
+            hci_stack->le_extended_advertising_report_truncated = true;
+        }
+        hci_le_extended_advertising_report_complete(now);
+    }
+}
+
+void gap_set_extended_scan_parameters(uint8_t scan_phys, uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window){
+    // only LE 1M and LE Coded PHY
+    hci_stack->le_scan_phys = scan_phys & 0x05;
+    gap_set_scan_parameters(scan_type, scan_interval, scan_window);
+}
+
+static bool hci_le_extended_scanning_used(void){
+    if (hci_stack->le_scan_phys == 0) return false;
+    return (hci_stack->local_supported_commands[1] & 0x04) != 0;
+}
+
+static void hci_send_le_set_extended_scan_parameters(uint8_t scan_type){
+    // create packet manually as arrays are not supported by BTstack command generator
+    hci_reserve_packet_buffer();
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    uint16_t opcode = hci_le_set_extended_scan_parameters.opcode;
+    uint16_t pos = 0;
+    packet[pos++] = opcode & 0xff;
+    packet[pos++] = opcode >> 8;
+    pos++;  // skip param len
+    packet[pos++] = hci_stack->le_own_addr_type;
+    packet[pos++] = 0;  // scanning filter policy: accept all
+    packet[pos++] = hci_stack->le_scan_phys;
+    uint8_t phy;
+    for (phy = 0; phy < 3; phy++){
+        if ((hci_stack->le_scan_phys & (1u << phy)) == 0) continue;
+        packet[pos++] = scan_type;
+        little_endian_store_16(packet, pos, hci_stack->le_scan_interval);
+        pos += 2;
+        little_endian_store_16(packet, pos, hci_stack->le_scan_window);
+        pos += 2;
+    }
+    packet[2] = pos - 3;
+    int err = hci_send_cmd_packet(packet, pos);
+
+    // release packet buffer on error or for synchronous transport implementations
+    if ((err < 0) || hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+}
+#endif
+#endif
+#endif
+
+#ifdef ENABLE_LE_LINK_UPGRADE
+void gap_le_set_link_upgrade_mode(gap_le_link_upgrade_mode_t mode){
+    hci_stack->le_link_upgrade_mode = mode;
+}
+
+static void hci_le_link_upgrade_emit_ready(hci_connection_t * conn){
+    uint8_t event[10];
+    event[0] = GAP_EVENT_LE_LINK_READY;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event, 2, conn->con_handle);
+    event[4] = conn->le_tx_phy;
+    event[5] = conn->le_rx_phy;
+    little_endian_store_16(event, 6, conn->le_link_max_tx_octets);
+    little_endian_store_16(event, 8, conn->le_link_max_rx_octets);
+    hci_emit_event(event, sizeof(event), 1);
+}
+
+static void hci_le_link_upgrade_done(hci_connection_t * conn){
+    log_info("LE Link Upgrade done: handle 0x%04x, phy tx %u / rx %u, octets tx %u / rx %u", conn->con_handle,
+             conn->le_tx_phy, conn->le_rx_phy, conn->le_link_max_tx_octets, conn->le_link_max_rx_octets);
+    conn->le_link_upgrade_state = LE_LINK_UPGRADE_DONE;
+    hci_le_link_upgrade_emit_ready(conn);
+}
+
+static void hci_le_link_upgrade_request_phy(hci_connection_t * conn){
+    // LE Set PHY support is indicated together with LE Set Default PHY
+    if ((hci_stack->local_supported_commands[0] & 0x40) != 0){
+        conn->le_link_upgrade_state = LE_LINK_UPGRADE_W2_SET_PHY;
+    } else {
+        hci_le_link_upgrade_done(conn);
+    }
+}
+
+static void hci_le_link_upgrade_start(hci_connection_t * conn){
+#ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
+    // LE Set Data Length support is indicated together with LE Read Maximum Data Length
+    if (((hci_stack->local_supported_commands[0] & 0x20) != 0) && (hci_stack->le_supported_max_tx_octets > 27)){
+        conn->le_link_upgrade_state = LE_LINK_UPGRADE_W2_SET_DATA_LENGTH;
+        return;
+    }
+#endif
+    hci_le_link_upgrade_request_phy(conn);
+}
+
+static void hci_le_link_upgrade_handle_connection_complete(hci_connection_t * conn){
+    switch (hci_stack->le_link_upgrade_mode){
+        case GAP_LE_LINK_UPGRADE_AFTER_CONNECTION:
+            hci_le_link_upgrade_start(conn);
+            break;
+        case GAP_LE_LINK_UPGRADE_AFTER_ENCRYPTION:
+            conn->le_link_upgrade_state = LE_LINK_UPGRADE_W4_ENCRYPTION;
+            break;
+        default:
+            break;
+    }
+}
+
+static void hci_le_link_upgrade_handle_set_phy_status(uint8_t status){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (conn->le_link_upgrade_state != LE_LINK_UPGRADE_W4_SET_PHY_STATUS) continue;
+        if (status == ERROR_CODE_SUCCESS){
+            conn->le_link_upgrade_state = LE_LINK_UPGRADE_W4_PHY_UPDATE_COMPLETE;
+        } else {
+            // e.g. remote does not support LE 2M PHY, stay on current PHY
+            log_info("LE Link Upgrade: set phy failed, status 0x%02x", status);
+            hci_le_link_upgrade_done(conn);
+        }
+        break;
+    }
+}
+#endif
+
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+void gap_set_connection_parameter_profile(gap_le_connection_profile_t profile, uint16_t conn_interval_min,
+    uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout){
+    if ((profile < GAP_LE_CONNECTION_PROFILE_BULK_TRANSFER) || (profile > GAP_LE_CONNECTION_PROFILE_LOW_POWER)) return;
+    le_connection_profile_parameters_t * parameters = &hci_stack->le_connection_profile_parameters[profile - 1];
+    parameters->le_conn_interval_min   = conn_interval_min;
+    parameters->le_conn_interval_max   = conn_interval_max;
+    parameters->le_conn_latency        = conn_latency;
+    parameters->le_supervision_timeout = supervision_timeout;
+}
+
+// @returns false if another connection parameter update is pending
+static bool hci_le_connection_profile_apply(hci_connection_t * conn, gap_le_connection_profile_t profile){
+    if (conn->le_connection_profile_applied == profile) return true;
+    if (conn->le_con_parameter_update_state != CON_PARAMETER_UPDATE_NONE) return false;
+    log_info("LE Connection Profile: handle 0x%04x, profile %u -> %u", conn->con_handle, conn->le_connection_profile_applied, profile);
+    const le_connection_profile_parameters_t * parameters = &hci_stack->le_connection_profile_parameters[profile - 1];
+    conn->le_connection_profile_applied = profile;
+    conn->le_conn_interval_min   = parameters->le_conn_interval_min;
+    conn->le_conn_interval_max   = parameters->le_conn_interval_max;
+    conn->le_conn_latency        = parameters->le_conn_latency;
+    conn->le_supervision_timeout = parameters->le_supervision_timeout;
+    if (conn->role == HCI_ROLE_MASTER){
+        conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS;
+        hci_run();
+    } else {
+        conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_SEND_REQUEST;
+        uint8_t l2cap_trigger_run_event[2] = { L2CAP_EVENT_TRIGGER_RUN, 0};
+        hci_emit_event(l2cap_trigger_run_event, sizeof(l2cap_trigger_run_event), 0);
+    }
+    return true;
+}
+
+static void hci_le_connection_profile_timeout_handler(btstack_timer_source_t * timer);
+
+static void hci_le_connection_profile_start_timer(hci_connection_t * conn, uint32_t timeout_ms){
+    btstack_run_loop_remove_timer(&conn->le_connection_profile_timer);
+    btstack_run_loop_set_timer_handler(&conn->le_connection_profile_timer, hci_le_connection_profile_timeout_handler);
+    btstack_run_loop_set_timer_context(&conn->le_connection_profile_timer, (void *) (uintptr_t) conn->con_handle);
+    btstack_run_loop_set_timer(&conn->le_connection_profile_timer, timeout_ms);
+    btstack_run_loop_add_timer(&conn->le_connection_profile_timer);
+    conn->le_connection_profile_timer_active = true;
+}
+
+static void hci_le_connection_profile_timeout_handler(btstack_timer_source_t * timer){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(timer);
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return;
+    conn->le_connection_profile_timer_active = false;
+    if (conn->le_connection_profile != GAP_LE_CONNECTION_PROFILE_AUTO) return;
+    uint32_t idle_ms = btstack_run_loop_get_time_ms() - conn->le_connection_profile_activity_ms;
+    if (idle_ms < GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS){
+        // active: use bulk transfer profile and check again when idle timeout would expire
+        hci_le_connection_profile_apply(conn, GAP_LE_CONNECTION_PROFILE_BULK_TRANSFER);
+        hci_le_connection_profile_start_timer(conn, GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS - idle_ms);
+    } else if (!hci_le_connection_profile_apply(conn, GAP_LE_CONNECTION_PROFILE_LOW_POWER)){
+        // retry later
+        hci_le_connection_profile_start_timer(conn, GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS);
+    }
+}
+
+// called for each ACL packet, switch profile from timer to avoid sending commands while handling ACL packets
+static void hci_le_connection_profile_activity(hci_connection_t * conn, const uint8_t * packet){
+    if (conn->le_connection_profile != GAP_LE_CONNECTION_PROFILE_AUTO) return;
+    // ignore LE Signaling, e.g. for connection parameter update itself
+    if (READ_L2CAP_CHANNEL_ID(packet) == L2CAP_CID_SIGNALING_LE) return;
+    conn->le_connection_profile_activity_ms = btstack_run_loop_get_time_ms();
+    if (conn->le_connection_profile_timer_active) return;
+    if (conn->le_connection_profile_applied == GAP_LE_CONNECTION_PROFILE_BULK_TRANSFER) return;
+    hci_le_connection_profile_start_timer(conn, 0);
+}
+
+uint8_t gap_le_set_connection_profile(hci_con_handle_t con_handle, gap_le_connection_profile_t profile){
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (!hci_is_le_connection(conn)) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (profile > GAP_LE_CONNECTION_PROFILE_AUTO) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    bool fixed_profile = (profile != GAP_LE_CONNECTION_PROFILE_NONE) && (profile != GAP_LE_CONNECTION_PROFILE_AUTO);
+    if (fixed_profile && (conn->le_con_parameter_update_state != CON_PARAMETER_UPDATE_NONE)) return ERROR_CODE_CONTROLLER_BUSY;
+    conn->le_connection_profile = profile;
+    btstack_run_loop_remove_timer(&conn->le_connection_profile_timer);
+    conn->le_connection_profile_timer_active = false;
+    switch (profile){
+        case GAP_LE_CONNECTION_PROFILE_NONE:
+            conn->le_connection_profile_applied = GAP_LE_CONNECTION_PROFILE_NONE;
+            break;
+        case GAP_LE_CONNECTION_PROFILE_AUTO:
+            // start with low power profile until ACL data is exchanged
+            conn->le_connection_profile_activity_ms = btstack_run_loop_get_time_ms() - GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS;
+            hci_le_connection_profile_start_timer(conn, 0);
+            break;
+        default:
+            (void) hci_le_connection_profile_apply(conn, profile);
+            break;
+    }
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+#ifdef ENABLE_BLE
+static void hci_le_align_connection_interval(uint16_t * conn_interval_min, uint16_t * conn_interval_max){
+    uint32_t unit = hci_stack->le_connection_interval_alignment;
+    if (unit == 0) return;
+    uint32_t aligned_min = ((*conn_interval_min + unit - 1) / unit) * unit;
+    uint32_t aligned_max = (*conn_interval_max / unit) * unit;
+    // keep requested range if it does not contain a multiple of the alignment
+    if (aligned_min > aligned_max) return;
+    *conn_interval_min = (uint16_t) aligned_min;
+    *conn_interval_max = (uint16_t) aligned_max;
+}
+
+void gap_le_set_connection_interval_alignment(uint16_t interval_unit){
+    hci_stack->le_connection_interval_alignment = interval_unit;
+}
+
+uint8_t gap_le_set_connection_ce_length(hci_con_handle_t con_handle, uint16_t min_ce_length, uint16_t max_ce_length){
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (!hci_is_le_connection(conn)) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (min_ce_length > max_ce_length) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    conn->le_min_ce_length = min_ce_length;
+    conn->le_max_ce_length = max_ce_length;
+    if ((conn->role == HCI_ROLE_MASTER) && (conn->le_con_parameter_update_state == CON_PARAMETER_UPDATE_NONE)){
+        conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS;
+        hci_run();
+    }
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+// split connection interval between all Central links with throughput demand
+static void hci_le_ce_length_allocator_update(void){
+    btstack_linked_list_iterator_t it;
+    uint32_t total_demand = 0;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        total_demand += conn->le_throughput_demand;
+    }
+    if (total_demand == 0) return;
+
+    const uint16_t conn_interval = GAP_LE_CE_LENGTH_ALLOCATOR_CONNECTION_INTERVAL;
+    // CE length unit is 0.625 ms, connection interval unit 1.25 ms
+    const uint32_t timeline = 2u * conn_interval;
+    bool update_pending = false;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * conn = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (conn->le_throughput_demand == 0) continue;
+        // at least 1.25 ms for a single packet exchange
+        uint16_t ce_length = (uint16_t) btstack_max(2, (timeline * conn->le_throughput_demand) / total_demand);
+        if ((conn->le_min_ce_length == ce_length) && (conn->le_max_ce_length == ce_length) &&
+            (conn->le_connection_interval == conn_interval)) continue;
+        // don't interfere with reply to remote connection parameter request
+        if ((conn->le_con_parameter_update_state != CON_PARAMETER_UPDATE_NONE) &&
+            (conn->le_con_parameter_update_state != CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS)) continue;
+        log_info("LE CE Length Allocator: handle 0x%04x, demand %u/%u, ce length %u", conn->con_handle,
+                 conn->le_throughput_demand, (unsigned int) total_demand, ce_length);
+        conn->le_min_ce_length = ce_length;
+        conn->le_max_ce_length = ce_length;
+        conn->le_conn_interval_min = conn_interval;
+        conn->le_conn_interval_max = conn_interval;
+        conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS;
+        update_pending = true;
+    }
+    if (update_pending){
+        hci_run();
+    }
+}
+
+uint8_t gap_le_set_connection_throughput_demand(hci_con_handle_t con_handle, uint8_t demand){
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (!hci_is_le_connection(conn)) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (conn->role != HCI_ROLE_MASTER) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (conn->le_throughput_demand == demand) return ERROR_CODE_SUCCESS;
+    conn->le_throughput_demand = demand;
+    if (demand == 0){
+        // keep current connection parameters, drop CE length hint
+        conn->le_min_ce_length = 0x0000;
+        conn->le_max_ce_length = 0xffff;
+    }
+    hci_le_ce_length_allocator_update();
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+static bool hci_le_controller_address_resolution_supported(void){
+    return (hci_stack->local_supported_commands[1] & 0x08) != 0;
+}
+
+static int hci_le_resolving_list_num_db_entries(void){
+    return (int) btstack_min(MAX_NUM_RESOLVING_LIST_ENTRIES, le_device_db_max_count());
+}
+
+static bool hci_le_resolving_list_irk_is_null(const sm_key_t irk){
+    int i;
+    for (i=0; i < 16; i++){
+        if (irk[i] != 0) return false;
+    }
+    return true;
+}
+
+// full sync: clear Resolving List and add all LE Device DB entries, starting at given state
+static void hci_le_resolving_list_load_all(le_resolving_list_state_t start_state){
+    if (!hci_le_controller_address_resolution_supported()) return;
+    memset(hci_stack->le_resolving_list_add_entries, 0xff, sizeof(hci_stack->le_resolving_list_add_entries));
+    if (hci_stack->le_resolving_list_state > start_state){
+        hci_stack->le_resolving_list_state = start_state;
+    }
+}
+
+void gap_load_resolving_list_from_le_device_db(void){
+    if (hci_stack->state != HCI_STATE_WORKING) return;
+    hci_le_resolving_list_load_all(LE_RESOLVING_LIST_SEND_CLEAR);
+    hci_run();
+}
+
+void hci_load_le_device_db_entry_into_resolving_list(uint16_t le_device_db_index){
+    if (hci_stack->state != HCI_STATE_WORKING) return;
+    if (!hci_le_controller_address_resolution_supported()) return;
+    if (le_device_db_index >= MAX_NUM_RESOLVING_LIST_ENTRIES) return;
+    uint8_t mask = 1 << (le_device_db_index & 7);
+    if ((hci_stack->le_resolving_list_entries_on_controller[le_device_db_index >> 3] & mask) != 0){
+        // IRK or address might have changed
+        hci_le_resolving_list_load_all(LE_RESOLVING_LIST_SEND_CLEAR);
+    } else {
+        hci_stack->le_resolving_list_add_entries[le_device_db_index >> 3] |= mask;
+        if (hci_stack->le_resolving_list_state == LE_RESOLVING_LIST_DONE){
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_ADD_ENTRIES;
+        }
+    }
+    hci_run();
+}
+
+void hci_remove_le_device_db_entry_from_resolving_list(uint16_t le_device_db_index){
+    if (hci_stack->state != HCI_STATE_WORKING) return;
+    if (le_device_db_index >= MAX_NUM_RESOLVING_LIST_ENTRIES) return;
+    uint8_t mask = 1 << (le_device_db_index & 7);
+    hci_stack->le_resolving_list_add_entries[le_device_db_index >> 3] &= ~mask;
+    // identity address of removed entry is not available anymore
+    if ((hci_stack->le_resolving_list_entries_on_controller[le_device_db_index >> 3] & mask) == 0) return;
+    hci_le_resolving_list_load_all(LE_RESOLVING_LIST_SEND_CLEAR);
+    hci_run();
+}
+
+// @returns index of next LE Device DB entry to add or -1, skips and clears entries without IRK
+static int hci_le_resolving_list_next_entry(void){
+    int i;
+    for (i=0; i < hci_le_resolving_list_num_db_entries(); i++){
+        uint8_t mask = 1 << (i & 7);
+        if ((hci_stack->le_resolving_list_add_entries[i >> 3] & mask) == 0) continue;
+        int addr_type = BD_ADDR_TYPE_UNKNOWN;
+        sm_key_t irk;
+        le_device_db_info(i, &addr_type, NULL, irk);
+        if ((addr_type != BD_ADDR_TYPE_UNKNOWN) && !hci_le_resolving_list_irk_is_null(irk)){
+            if (hci_stack->le_resolving_list_num_entries < hci_stack->le_resolving_list_size) return i;
+            log_info("Resolving List full, skip LE Device DB entry %u", i);
+        }
+        hci_stack->le_resolving_list_add_entries[i >> 3] &= ~mask;
+    }
+    return -1;
+}
+
+static bool hci_le_resolving_list_modification_pending(void){
+    if ((hci_stack->le_resolving_list_state == LE_RESOLVING_LIST_ADD_ENTRIES) && (hci_le_resolving_list_next_entry() < 0)){
+        hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_DONE;
+    }
+    return hci_stack->le_resolving_list_state != LE_RESOLVING_LIST_DONE;
+}
+
+static bool hci_run_le_resolving_list(void){
+    int index;
+    int addr_type;
+    bd_addr_t addr;
+    sm_key_t peer_irk;
+    sm_key_t peer_irk_flipped;
+    sm_key_t local_irk_flipped;
+    switch (hci_stack->le_resolving_list_state){
+        case LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION:
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_READ_SIZE;
+            hci_send_cmd(&hci_le_set_address_resolution_enable, 1);
+            return true;
+        case LE_RESOLVING_LIST_READ_SIZE:
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_SEND_CLEAR;
+            hci_send_cmd(&hci_le_read_resolving_list_size);
+            return true;
+        case LE_RESOLVING_LIST_SEND_CLEAR:
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_ADD_ENTRIES;
+            hci_stack->le_resolving_list_num_entries = 0;
+            memset(hci_stack->le_resolving_list_entries_on_controller, 0, sizeof(hci_stack->le_resolving_list_entries_on_controller));
+            hci_send_cmd(&hci_le_clear_resolving_list);
+            return true;
+        case LE_RESOLVING_LIST_ADD_ENTRIES:
+            index = hci_le_resolving_list_next_entry();
+            if (index < 0) break;
+            hci_stack->le_resolving_list_add_entries[index >> 3] &= ~(1 << (index & 7));
+            hci_stack->le_resolving_list_entries_on_controller[index >> 3] |= 1 << (index & 7);
+            hci_stack->le_resolving_list_num_entries++;
+            le_device_db_info(index, &addr_type, addr, peer_irk);
+            reverse_128(peer_irk, peer_irk_flipped);
+            // local address is not resolved by Controller
+            memset(local_irk_flipped, 0, sizeof(local_irk_flipped));
+            hci_send_cmd(&hci_le_add_device_to_resolving_list, addr_type, addr, peer_irk_flipped, local_irk_flipped);
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
 #endif
-#endif
 
 #ifdef ENABLE_BLE
 #ifdef ENABLE_LE_PERIPHERAL
@@ -1191,6 +3450,9 @@ static void hci_initialization_timeout_handler(btstack_timer_source_t * ds){
             break;
         case HCI_INIT_W4_CUSTOM_INIT_BCM_DELAY:
             // otherwise continue
+#ifdef ENABLE_HCI_INIT_PROFILING
+            hci_init_profile_enter_phase(HCI_INIT_PROFILE_PHASE_CONFIGURATION);
+#endif
             hci_stack->substate = HCI_INIT_W4_READ_LOCAL_SUPPORTED_COMMANDS;
             hci_send_cmd(&hci_read_local_supported_commands);
             break;
@@ -1204,6 +3466,117 @@ static void hci_initializing_next_state(void){
     hci_stack->substate = (hci_substate_t )( ((int) hci_stack->substate) + 1);
 }
 
+#ifdef ENABLE_HCI_INIT_PROFILING
+// account time since last phase change to current phase
+static void hci_init_profile_enter_phase(hci_init_profile_phase_t phase){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    hci_stack->init_profile_phase_ms[hci_stack->init_profile_phase] += now - hci_stack->init_profile_timestamp_ms;
+    hci_stack->init_profile_timestamp_ms = now;
+    hci_stack->init_profile_phase = (uint8_t) phase;
+}
+
+static void hci_init_profile_start(void){
+    memset(hci_stack->init_profile_phase_ms, 0, sizeof(hci_stack->init_profile_phase_ms));
+    hci_stack->init_profile_num_custom_init_commands = 0;
+    hci_stack->init_profile_phase = HCI_INIT_PROFILE_PHASE_RESET;
+    hci_stack->init_profile_timestamp_ms = btstack_run_loop_get_time_ms();
+}
+
+static void hci_emit_init_profile(void){
+    log_info("Init profile: reset %"PRIu32" ms, baud change %"PRIu32" ms, custom init %"PRIu32" ms (%u commands), configuration %"PRIu32" ms",
+             hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_RESET],
+             hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_BAUD_CHANGE],
+             hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_CUSTOM_INIT],
+             hci_stack->init_profile_num_custom_init_commands,
+             hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_CONFIGURATION]);
+    uint8_t event[20];
+    event[0] = BTSTACK_EVENT_INIT_PROFILE;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_32(event,  2, hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_RESET]);
+    little_endian_store_32(event,  6, hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_BAUD_CHANGE]);
+    little_endian_store_32(event, 10, hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_CUSTOM_INIT]);
+    little_endian_store_32(event, 14, hci_stack->init_profile_phase_ms[HCI_INIT_PROFILE_PHASE_CONFIGURATION]);
+    little_endian_store_16(event, 18, hci_stack->init_profile_num_custom_init_commands);
+    hci_emit_event(event, sizeof(event), 1);
+}
+
+static void hci_emit_init_step(uint16_t opcode){
+    // init script commands are only accounted for in total
+    if (hci_stack->init_profile_phase == HCI_INIT_PROFILE_PHASE_CUSTOM_INIT) return;
+    uint32_t duration_ms = btstack_run_loop_get_time_ms() - hci_stack->init_profile_step_timestamp_ms;
+    log_info("Init step: opcode 0x%04x, %"PRIu32" ms", opcode, duration_ms);
+    uint8_t event[8];
+    event[0] = BTSTACK_EVENT_INIT_STEP;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event, 2, opcode);
+    little_endian_store_32(event, 4, duration_ms);
+    hci_emit_event(event, sizeof(event), 1);
+}
+#endif
+
+#if !defined(HAVE_PLATFORM_IPHONE_OS) && !defined (HAVE_HOST_CONTROLLER_API)
+// Init script done: Broadcom chipsets require baud rate reset and delay, returns true if delay was started
+static bool hci_initializing_custom_init_done(void){
+    log_info("Init script done");
+
+    // Init script download on Broadcom chipsets causes:
+    if ( (hci_stack->chipset_result != BTSTACK_CHIPSET_NO_INIT_SCRIPT) &&
+       (  (hci_stack->manufacturer == BLUETOOTH_COMPANY_ID_BROADCOM_CORPORATION) 
+    ||    (hci_stack->manufacturer == BLUETOOTH_COMPANY_ID_EM_MICROELECTRONIC_MARIN_SA)) ){
+
+        // - baud rate to reset, restore UART baud rate if needed
+        int need_baud_change = hci_stack->config
+            && hci_stack->chipset
+            && hci_stack->chipset->set_baudrate_command
+            && hci_stack->hci_transport->set_baudrate
+            && ((hci_transport_config_uart_t *)hci_stack->config)->baudrate_main;
+        if (need_baud_change) {
+            uint32_t baud_rate = ((hci_transport_config_uart_t *)hci_stack->config)->baudrate_init;
+            log_info("Local baud rate change to %"PRIu32" after init script (bcm)", baud_rate);
+            hci_stack->hci_transport->set_baudrate(baud_rate);
+        }
+
+        uint16_t bcm_delay_ms = 300;
+        // - UART may or may not be disabled during update and Controller RTS may or may not be high during this time
+        //   -> Work around: wait here.
+        log_info("BCM delay (%u ms) after init script", bcm_delay_ms);
+        hci_stack->substate = HCI_INIT_W4_CUSTOM_INIT_BCM_DELAY;
+        btstack_run_loop_set_timer(&hci_stack->timeout, bcm_delay_ms);
+        btstack_run_loop_set_timer_handler(&hci_stack->timeout, hci_initialization_timeout_handler);
+        btstack_run_loop_add_timer(&hci_stack->timeout);
+        return true;
+    }
+    return false;
+}
+
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+// CSR signals completion of its vendor commands with vendor-specific events
+static bool hci_initializing_custom_init_pipelined(void){
+    return hci_stack->manufacturer != BLUETOOTH_COMPANY_ID_CAMBRIDGE_SILICON_RADIO;
+}
+
+// count Command Complete for pipelined init script commands, returns true if event was consumed
+static bool hci_initializing_custom_init_pipeline_handle_event(const uint8_t * packet){
+    if (hci_stack->init_script_cmds_outstanding == 0) return false;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_COMMAND_COMPLETE) return false;
+    hci_stack->init_script_cmds_outstanding--;
+    switch (hci_stack->substate){
+        case HCI_INIT_W4_CUSTOM_INIT:
+            hci_stack->substate = HCI_INIT_CUSTOM_INIT;
+            break;
+        case HCI_INIT_W4_CUSTOM_INIT_PIPELINE_DRAIN:
+            if (hci_stack->init_script_cmds_outstanding == 0){
+                hci_stack->substate = HCI_INIT_CUSTOM_INIT_DONE;
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+#endif
+#endif
+
 // assumption: hci_can_send_command_packet_now() == true
 static void hci_initializing_run(void){
     log_debug("hci_initializing_run: substate %u, can send %u", hci_stack->substate, hci_can_send_command_packet_now());
@@ -1247,6 +3620,9 @@ static void hci_initializing_run(void){
             hci_send_cmd(&hci_reset);
             break;
         case HCI_INIT_SEND_BAUD_CHANGE: {
+#ifdef ENABLE_HCI_INIT_PROFILING
+            hci_init_profile_enter_phase(HCI_INIT_PROFILE_PHASE_BAUD_CHANGE);
+#endif
             uint32_t baud_rate = hci_transport_uart_get_main_baud_rate();
             hci_stack->chipset->set_baudrate_command(baud_rate, hci_stack->hci_packet_buffer);
             hci_stack->last_cmd_opcode = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
@@ -1269,14 +3645,36 @@ static void hci_initializing_run(void){
             break;
         }
         case HCI_INIT_CUSTOM_INIT:
+#ifdef ENABLE_HCI_INIT_PROFILING
+            hci_init_profile_enter_phase(HCI_INIT_PROFILE_PHASE_CUSTOM_INIT);
+#endif
             // Custom initialization
             if (hci_stack->chipset && hci_stack->chipset->next_command){
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+                // Controller cannot accept more commands, wait for Command Complete
+                if ((hci_stack->init_script_cmds_outstanding > 0) && (hci_stack->init_script_num_cmd_packets == 0)){
+                    hci_stack->substate = HCI_INIT_W4_CUSTOM_INIT;
+                    break;
+                }
+#endif
                 hci_stack->chipset_result = (*hci_stack->chipset->next_command)(hci_stack->hci_packet_buffer);
                 int send_cmd = 0;
                 switch (hci_stack->chipset_result){
                     case BTSTACK_CHIPSET_VALID_COMMAND:
                         send_cmd = 1;
                         hci_stack->substate = HCI_INIT_W4_CUSTOM_INIT;
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+                        // send next command without waiting for Command Complete if Controller has room for it
+                        if (hci_initializing_custom_init_pipelined()){
+                            hci_stack->init_script_cmds_outstanding++;
+                            if (hci_stack->init_script_num_cmd_packets > 0){
+                                hci_stack->init_script_num_cmd_packets--;
+                            }
+                            if (hci_stack->init_script_num_cmd_packets > 0){
+                                hci_stack->substate = HCI_INIT_CUSTOM_INIT;
+                            }
+                        }
+#endif
                         break;
                     case BTSTACK_CHIPSET_WARMSTART_REQUIRED:
                         send_cmd = 1;
@@ -1303,44 +3701,37 @@ static void hci_initializing_run(void){
                 if (send_cmd){
                     int size = 3 + hci_stack->hci_packet_buffer[2];
                     hci_stack->last_cmd_opcode = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
+#ifdef ENABLE_HCI_INIT_PROFILING
+                    hci_stack->init_profile_num_custom_init_commands++;
+#endif
                     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, hci_stack->hci_packet_buffer, size);
                     hci_stack->hci_transport->send_packet(HCI_COMMAND_DATA_PACKET, hci_stack->hci_packet_buffer, size);
                     break;
                 }
-                log_info("Init script done");
-
-                // Init script download on Broadcom chipsets causes:
-                if ( (hci_stack->chipset_result != BTSTACK_CHIPSET_NO_INIT_SCRIPT) &&
-                   (  (hci_stack->manufacturer == BLUETOOTH_COMPANY_ID_BROADCOM_CORPORATION) 
-                ||    (hci_stack->manufacturer == BLUETOOTH_COMPANY_ID_EM_MICROELECTRONIC_MARIN_SA)) ){
-
-                    // - baud rate to reset, restore UART baud rate if needed
-                    int need_baud_change = hci_stack->config
-                        && hci_stack->chipset
-                        && hci_stack->chipset->set_baudrate_command
-                        && hci_stack->hci_transport->set_baudrate
-                        && ((hci_transport_config_uart_t *)hci_stack->config)->baudrate_main;
-                    if (need_baud_change) {
-                        uint32_t baud_rate = ((hci_transport_config_uart_t *)hci_stack->config)->baudrate_init;
-                        log_info("Local baud rate change to %"PRIu32" after init script (bcm)", baud_rate);
-                        hci_stack->hci_transport->set_baudrate(baud_rate);
-                    }
-
-                    uint16_t bcm_delay_ms = 300;
-                    // - UART may or may not be disabled during update and Controller RTS may or may not be high during this time
-                    //   -> Work around: wait here.
-                    log_info("BCM delay (%u ms) after init script", bcm_delay_ms);
-                    hci_stack->substate = HCI_INIT_W4_CUSTOM_INIT_BCM_DELAY;
-                    btstack_run_loop_set_timer(&hci_stack->timeout, bcm_delay_ms);
-                    btstack_run_loop_set_timer_handler(&hci_stack->timeout, hci_initialization_timeout_handler);
-                    btstack_run_loop_add_timer(&hci_stack->timeout);
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+                // wait for Command Complete of all pipelined commands
+                if (hci_stack->init_script_cmds_outstanding > 0){
+                    hci_stack->substate = HCI_INIT_W4_CUSTOM_INIT_PIPELINE_DRAIN;
                     break;
                 }
+#endif
+                if (hci_initializing_custom_init_done()) break;
             }
             // otherwise continue
+#ifdef ENABLE_HCI_INIT_PROFILING
+            hci_init_profile_enter_phase(HCI_INIT_PROFILE_PHASE_CONFIGURATION);
+#endif
             hci_stack->substate = HCI_INIT_W4_READ_LOCAL_SUPPORTED_COMMANDS;
             hci_send_cmd(&hci_read_local_supported_commands);
             break;            
+        case HCI_INIT_CUSTOM_INIT_DONE:
+            if (hci_initializing_custom_init_done()) break;
+#ifdef ENABLE_HCI_INIT_PROFILING
+            hci_init_profile_enter_phase(HCI_INIT_PROFILE_PHASE_CONFIGURATION);
+#endif
+            hci_stack->substate = HCI_INIT_W4_READ_LOCAL_SUPPORTED_COMMANDS;
+            hci_send_cmd(&hci_read_local_supported_commands);
+            break;
         case HCI_INIT_SET_BD_ADDR:
             log_info("Set Public BD ADDR to %s", bd_addr_to_str(hci_stack->custom_bd_addr));
             hci_stack->chipset->set_bd_addr_command(hci_stack->custom_bd_addr, hci_stack->hci_packet_buffer);
@@ -1397,7 +3788,10 @@ static void hci_initializing_run(void){
             break;
         case HCI_INIT_WRITE_PAGE_TIMEOUT:
             hci_stack->substate = HCI_INIT_W4_WRITE_PAGE_TIMEOUT;
-            hci_send_cmd(&hci_write_page_timeout, 0x6000);  // ca. 15 sec
+            hci_send_cmd(&hci_write_page_timeout, hci_stack->page_timeout);
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+            hci_stack->gap_paging_page_timeout_active = hci_stack->page_timeout;
+#endif
             break;
         case HCI_INIT_WRITE_DEFAULT_LINK_POLICY_SETTING:
             hci_stack->substate = HCI_INIT_W4_WRITE_DEFAULT_LINK_POLICY_SETTING;
@@ -1502,12 +3896,34 @@ static void hci_initializing_run(void){
         // LE INIT
         case HCI_INIT_LE_READ_BUFFER_SIZE:
             hci_stack->substate = HCI_INIT_W4_LE_READ_BUFFER_SIZE;
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            // LE Read Buffer Size v2 also reports ISO buffers
+            if ((hci_stack->local_supported_commands[1] & 0x10) != 0){
+                hci_send_cmd(&hci_le_read_buffer_size_v2);
+                break;
+            }
+#endif
             hci_send_cmd(&hci_le_read_buffer_size);
             break;
-        case HCI_INIT_LE_SET_EVENT_MASK:
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+        case HCI_INIT_LE_SET_HOST_FEATURE:
+            // Connected Isochronous Stream (Host Support) = feature bit 32
+            hci_stack->substate = HCI_INIT_W4_LE_SET_HOST_FEATURE;
+            hci_send_cmd(&hci_le_set_host_feature, 32, 1);
+            break;
+#endif
+        case HCI_INIT_LE_SET_EVENT_MASK:{
             hci_stack->substate = HCI_INIT_W4_LE_SET_EVENT_MASK;
-            hci_send_cmd(&hci_le_set_event_mask, 0x809FF, 0x0); // bits 0-8, 11, 19 
+            uint32_t le_event_mask_lo = 0x809FF;    // bits 0-8, 11, 19
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+            le_event_mask_lo |= 0x1000;             // bit 12
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            le_event_mask_lo |= 0x3F000000;         // bits 24-29
+#endif
+            hci_send_cmd(&hci_le_set_event_mask, le_event_mask_lo, 0x0);
             break;
+        }
         case HCI_INIT_WRITE_LE_HOST_SUPPORTED:
             // LE Supported Host = 1, Simultaneous Host = 0
             hci_stack->substate = HCI_INIT_W4_WRITE_LE_HOST_SUPPORTED;
@@ -1545,8 +3961,15 @@ static void hci_initializing_run(void){
 static void hci_init_done(void){
     // done. tell the app
     log_info("hci_init_done -> HCI_STATE_WORKING");
+#ifdef ENABLE_HCI_INIT_PROFILING
+    hci_init_profile_enter_phase(HCI_INIT_PROFILE_PHASE_CONFIGURATION);
+    hci_emit_init_profile();
+#endif
     hci_stack->state = HCI_STATE_WORKING;
     hci_emit_state();
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+    hci_le_resolving_list_load_all(LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION);
+#endif
     hci_run();
 }
 
@@ -1598,7 +4021,11 @@ static bool hci_initializing_event_handler_command_completed(const uint8_t * pac
 static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size){
 
     UNUSED(size);   // ok: less than 6 bytes are read from our buffer
-    
+
+#if defined(ENABLE_HCI_INIT_SCRIPT_PIPELINING) && !defined(HAVE_PLATFORM_IPHONE_OS) && !defined (HAVE_HOST_CONTROLLER_API)
+    if (hci_initializing_custom_init_pipeline_handle_event(packet)) return;
+#endif
+
     bool command_completed =  hci_initializing_event_handler_command_completed(packet);
 
 #if !defined(HAVE_PLATFORM_IPHONE_OS) && !defined (HAVE_HOST_CONTROLLER_API)
@@ -1658,6 +4085,10 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
 
     if (!command_completed) return;
 
+#ifdef ENABLE_HCI_INIT_PROFILING
+    hci_emit_init_step(hci_stack->last_cmd_opcode);
+#endif
+
     bool need_baud_change = false;
     bool need_addr_change = false;
 
@@ -1685,6 +4116,12 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
         case HCI_INIT_W4_SEND_RESET:
             btstack_run_loop_remove_timer(&hci_stack->timeout);
             break;
+#ifdef ENABLE_HCI_INIT_SKIP_READ_LOCAL_NAME
+        case HCI_INIT_W4_SEND_READ_LOCAL_VERSION_INFORMATION:
+            // local name is only logged, skip reading it at the init baud rate
+            /* fall through */
+
+#endif
         case HCI_INIT_W4_SEND_READ_LOCAL_NAME:
             log_info("Received local name, need baud change %d", (int) need_baud_change);
             if (need_baud_change){
@@ -1787,6 +4224,13 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
             break;
 #ifdef ENABLE_BLE            
         case HCI_INIT_W4_LE_READ_BUFFER_SIZE:
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            // set host feature if supported
+            if ((hci_stack->local_supported_commands[1] & 0x20) != 0) break;
+            hci_stack->substate = HCI_INIT_W4_LE_SET_HOST_FEATURE;
+            /* fall through */
+        case HCI_INIT_W4_LE_SET_HOST_FEATURE:
+#endif
             // skip write le host if not supported (e.g. on LE only EM9301)
             if (hci_stack->local_supported_commands[0] & 0x02) break;
             hci_stack->substate = HCI_INIT_LE_SET_EVENT_MASK;
@@ -1888,8 +4332,7 @@ static void hci_handle_connection_failed(hci_connection_t * conn, uint8_t status
 #endif
     
     // connection failed, remove entry
-    btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-    btstack_memory_hci_connection_free( conn );
+    hci_connection_free(conn);
 
 #ifdef ENABLE_CLASSIC
     // notify client if dedicated bonding
@@ -1919,6 +4362,67 @@ static void handle_event_for_current_stack_state(const uint8_t * packet, uint16_
     }
 }
 
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+// complete request at head of queue if it was sent and the event is for its opcode
+static void hci_command_queue_handle_event(uint16_t opcode, const uint8_t * packet, int size){
+    if (!hci_stack->command_queue_sent) return;
+    if (hci_stack->command_queue_opcode != opcode) return;
+    hci_stack->command_queue_sent = false;
+    hci_command_request_t * request = (hci_command_request_t *) btstack_linked_queue_dequeue(&hci_stack->command_queue);
+    (*request->callback)(request, packet, (uint16_t) size);
+}
+
+// abort sent and pending requests, callbacks might queue new requests only after the stack is working again
+static void hci_command_queue_abort(void){
+    btstack_linked_queue_t aborted = hci_stack->command_queue;
+    hci_stack->command_queue.head = NULL;
+    hci_stack->command_queue.tail = NULL;
+    hci_stack->command_queue_sent = false;
+    while (!btstack_linked_queue_empty(&aborted)){
+        hci_command_request_t * request = (hci_command_request_t *) btstack_linked_queue_dequeue(&aborted);
+        (*request->callback)(request, NULL, 0);
+    }
+}
+
+// assumption: hci_can_send_command_packet_now() == true
+static void hci_command_queue_run(void){
+    // only a single queued command is in flight, so its completion can be identified by its opcode
+    while (!btstack_linked_queue_empty(&hci_stack->command_queue)){
+        if (hci_stack->command_queue_sent) return;
+        hci_command_request_t * request = (hci_command_request_t *) btstack_linked_queue_first(&hci_stack->command_queue);
+        hci_stack->command_queue_sent = true;
+        hci_stack->command_queue_opcode = little_endian_read_16(request->packet, 0);
+        int err = hci_send_cmd_packet(request->packet, request->size);
+        if (err >= 0) return;
+        // not sent, report and try next one
+        hci_stack->command_queue_sent = false;
+        (void) btstack_linked_queue_dequeue(&hci_stack->command_queue);
+        (*request->callback)(request, NULL, 0);
+        if (!hci_can_send_command_packet_now()) return;
+    }
+}
+
+uint8_t hci_send_cmd_queued(hci_command_request_t * request, uint8_t * buffer, const hci_cmd_t *cmd, ...){
+    if (hci_stack->state != HCI_STATE_WORKING) return ERROR_CODE_COMMAND_DISALLOWED;
+    btstack_linked_item_t * it;
+    for (it = hci_stack->command_queue.head; it != NULL; it = it->next){
+        if (it == (btstack_linked_item_t *) request) return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+
+    va_list argptr;
+    va_start(argptr, cmd);
+    uint16_t size = hci_cmd_create_from_template(buffer, cmd, argptr);
+    va_end(argptr);
+
+    request->packet = buffer;
+    request->size   = size;
+    btstack_linked_queue_enqueue(&hci_stack->command_queue, (btstack_linked_item_t *) request);
+
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 static void event_handler(uint8_t *packet, int size){
 
     uint16_t event_length = packet[1];
@@ -1947,6 +4451,15 @@ static void event_handler(uint8_t *packet, int size){
         case HCI_EVENT_COMMAND_COMPLETE:
             // get num cmd packets - limit to 1 to reduce complexity
             hci_stack->num_cmd_packets = packet[2] ? 1 : 0;
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+            hci_stack->init_script_num_cmd_packets = packet[2];
+#endif
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+            hci_command_queue_handle_event(little_endian_read_16(packet, 3), packet, size);
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            hci_iso_handle_command_complete(packet, size);
+#endif
 
             if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_read_local_name)){
                 if (packet[5]) break;
@@ -1992,6 +4505,23 @@ static void event_handler(uint8_t *packet, int size){
                 log_info("hci_le_read_buffer_size: size %u, count %u", hci_stack->le_data_packets_length, hci_stack->le_acl_packets_total_num);
             }
 #endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            else if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_read_buffer_size_v2)){
+                hci_stack->le_data_packets_length = little_endian_read_16(packet, 6);
+                hci_stack->le_acl_packets_total_num  = packet[8];
+                hci_stack->iso_data_packet_length = little_endian_read_16(packet, 9);
+                hci_stack->iso_packets_total_num = packet[11];
+                // determine usable ACL and ISO payload size
+                if (HCI_ACL_PAYLOAD_SIZE < hci_stack->le_data_packets_length){
+                    hci_stack->le_data_packets_length = HCI_ACL_PAYLOAD_SIZE;
+                }
+                if (HCI_ACL_PAYLOAD_SIZE < hci_stack->iso_data_packet_length){
+                    hci_stack->iso_data_packet_length = HCI_ACL_PAYLOAD_SIZE;
+                }
+                log_info("hci_le_read_buffer_size_v2: acl size %u, count %u - iso size %u, count %u", hci_stack->le_data_packets_length,
+                         hci_stack->le_acl_packets_total_num, hci_stack->iso_data_packet_length, hci_stack->iso_packets_total_num);
+            }
+#endif
 #ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
             else if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_read_maximum_data_length)){
                 hci_stack->le_supported_max_tx_octets = little_endian_read_16(packet, 6);
@@ -1999,11 +4529,27 @@ static void event_handler(uint8_t *packet, int size){
                 log_info("hci_le_read_maximum_data_length: tx octets %u, tx time %u us", hci_stack->le_supported_max_tx_octets, hci_stack->le_supported_max_tx_time);
             }
 #endif
+#ifdef ENABLE_LE_LINK_UPGRADE
+            else if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_set_data_length)){
+                // continue with PHY, Data Length Change event reports new values
+                handle = little_endian_read_16(packet, OFFSET_OF_DATA_IN_COMMAND_COMPLETE + 1);
+                conn = hci_connection_for_handle(handle);
+                if (conn && (conn->le_link_upgrade_state == LE_LINK_UPGRADE_W4_SET_DATA_LENGTH_COMPLETE)){
+                    hci_le_link_upgrade_request_phy(conn);
+                }
+            }
+#endif
 #ifdef ENABLE_LE_CENTRAL
             else if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_read_white_list_size)){
                 hci_stack->le_whitelist_capacity = packet[6];
                 log_info("hci_le_read_white_list_size: size %u", hci_stack->le_whitelist_capacity);
             }   
+#endif
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+            else if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_read_resolving_list_size)){
+                hci_stack->le_resolving_list_size = packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE + 1];
+                log_info("hci_le_read_resolving_list_size: size %u", hci_stack->le_resolving_list_size);
+            }
 #endif
             else if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_read_bd_addr)) {
                 reverse_bd_addr(&packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE + 1],
@@ -2070,7 +4616,11 @@ static void event_handler(uint8_t *packet, int size){
                     ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+20] & 0x10) << 3);   // bit 7 = Octet 20, bit 4 / Read Encryption Key Size
                 hci_stack->local_supported_commands[1] =
                     ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+ 2] & 0x40) >> 6) |  // bit 8 = Octet  2, bit 6 / Read Remote Extended Features
-                    ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+32] & 0x08) >> 2);   // bit 9 = Octet 32, bit 3 / Write Secure Connections Host
+                    ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+32] & 0x08) >> 2) |  // bit 9 = Octet 32, bit 3 / Write Secure Connections Host
+                    ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+37] & 0x20) >> 3) |  // bit 10 = Octet 37, bit 5 / LE Set Extended Scan Parameters
+                    ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+34] & 0x08)     ) |  // bit 11 = Octet 34, bit 3 / LE Add Device To Resolving List
+                    ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+41] & 0x20) >> 1) |  // bit 12 = Octet 41, bit 5 / LE Read Buffer Size v2
+                    ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+44] & 0x01) << 5);   // bit 13 = Octet 44, bit 0 / LE Set Host Feature
                 log_info("Local supported commands summary %02x - %02x", hci_stack->local_supported_commands[0],  hci_stack->local_supported_commands[1]);
             }
 #ifdef ENABLE_CLASSIC
@@ -2101,18 +4651,37 @@ static void event_handler(uint8_t *packet, int size){
         case HCI_EVENT_COMMAND_STATUS:
             // get num cmd packets - limit to 1 to reduce complexity
             hci_stack->num_cmd_packets = packet[3] ? 1 : 0;
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+            hci_stack->init_script_num_cmd_packets = packet[3];
+#endif
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+            hci_command_queue_handle_event(little_endian_read_16(packet, 4), packet, size);
+#endif
 
             // check command status to detected failed outgoing connections
             create_connection_cmd = 0;
 #ifdef ENABLE_CLASSIC
             if (HCI_EVENT_IS_COMMAND_STATUS(packet, hci_create_connection)){
                 create_connection_cmd = 1;
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+                if (hci_event_command_status_get_status(packet) != ERROR_CODE_SUCCESS){
+                    gap_paging_handle_connection_complete(hci_stack->gap_paging_addr, hci_event_command_status_get_status(packet));
+                }
+#endif
             }
 #endif
 #ifdef ENABLE_LE_CENTRAL
             if (HCI_EVENT_IS_COMMAND_STATUS(packet, hci_le_create_connection)){
                 create_connection_cmd = 1;
             }
+#endif
+#ifdef ENABLE_LE_LINK_UPGRADE
+            if (HCI_EVENT_IS_COMMAND_STATUS(packet, hci_le_set_phy)){
+                hci_le_link_upgrade_handle_set_phy_status(hci_event_command_status_get_status(packet));
+            }
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            hci_iso_handle_command_status(packet);
 #endif
             if (create_connection_cmd) {
                 uint8_t status = hci_event_command_status_get_status(packet);
@@ -2140,6 +4709,19 @@ static void event_handler(uint8_t *packet, int size){
                 offset += 2;
                 uint16_t num_packets = little_endian_read_16(packet, offset);
                 offset += 2;
+
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+                hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(handle);
+                if (iso_stream != NULL){
+                    if (iso_stream->num_packets_sent >= num_packets){
+                        iso_stream->num_packets_sent -= num_packets;
+                    } else {
+                        log_error("hci_number_completed_packets, more ISO packet slots freed then sent.");
+                        iso_stream->num_packets_sent = 0;
+                    }
+                    continue;
+                }
+#endif
                 
                 conn = hci_connection_for_handle(handle);
                 if (!conn){
@@ -2156,10 +4738,20 @@ static void event_handler(uint8_t *packet, int size){
                 // log_info("hci_number_completed_packet %u processed for handle %u, outstanding %u", num_packets, handle, conn->num_packets_sent);
 
 #ifdef ENABLE_CLASSIC
+                if (conn->address_type == BD_ADDR_TYPE_SCO){
+                    conn->sco_rx_count_since_completed_packets = 0;
+                }
+
                 // For SCO, we do the can_send_now_check here
                 hci_notify_if_sco_can_send_now();
 #endif
             }
+#ifdef ENABLE_HCI_STATISTICS
+            hci_statistics_acl_credits_returned();
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            hci_iso_notify_can_send_now();
+#endif
             break;
         }
 
@@ -2175,9 +4767,24 @@ static void event_handler(uint8_t *packet, int size){
             if (hci_stack->remote_name_state == GAP_REMOTE_NAME_STATE_W4_COMPLETE){
                 hci_stack->remote_name_state = GAP_REMOTE_NAME_STATE_IDLE;
             }
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+            if ((size >= 9) && (packet[2] == ERROR_CODE_SUCCESS)){
+                reverse_bd_addr(&packet[3], addr);
+                // name is zero-terminated if shorter than 248 bytes
+                const uint8_t * remote_name = &packet[9];
+                uint16_t remote_name_len = 0;
+                while ((remote_name_len < (size - 9)) && (remote_name_len < 248) && (remote_name[remote_name_len] != 0)){
+                    remote_name_len++;
+                }
+                gap_remote_name_cache_store(addr, NULL, remote_name, (uint8_t) remote_name_len, true);
+            }
+#endif
             break;
         case HCI_EVENT_CONNECTION_REQUEST:
             reverse_bd_addr(&packet[2], addr);
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+            gap_remote_name_cache_store(addr, &packet[8], NULL, 0, false);
+#endif
             if (hci_stack->gap_classic_accept_callback != NULL){
                 if ((*hci_stack->gap_classic_accept_callback)(addr) == 0){
                     hci_stack->decline_reason = ERROR_CODE_CONNECTION_REJECTED_DUE_TO_UNACCEPTABLE_BD_ADDR;
@@ -2213,6 +4820,9 @@ static void event_handler(uint8_t *packet, int size){
             // Connection management
             reverse_bd_addr(&packet[5], addr);
             log_info("Connection_complete (status=%u) %s", packet[2], bd_addr_to_str(addr));
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+            gap_paging_handle_connection_complete(addr, packet[2]);
+#endif
             addr_type = BD_ADDR_TYPE_ACL;
             conn = hci_connection_for_bd_addr_and_type(addr, addr_type);
             if (conn) {
@@ -2231,6 +4841,10 @@ static void event_handler(uint8_t *packet, int size){
                     // restart timer
                     btstack_run_loop_set_timer(&conn->timeout, HCI_CONNECTION_TIMEOUT_MS);
                     btstack_run_loop_add_timer(&conn->timeout);
+
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+                    hci_auto_sniff_start_timer(conn);
+#endif
                     
                     log_info("New connection: handle %u, %s", conn->con_handle, bd_addr_to_str(conn->address));
                     
@@ -2346,12 +4960,36 @@ static void event_handler(uint8_t *packet, int size){
             if (!hci_stack->ssp_auto_accept) break;
             hci_add_connection_flags_for_flipped_bd_addr(&packet[2], SEND_USER_PASSKEY_REPLY);
             break;
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+        case HCI_EVENT_FLUSH_OCCURRED:
+            // Controller discarded packet after automatic flush timeout
+            handle = little_endian_read_16(packet, 2);
+            conn = hci_connection_for_handle(handle);
+            if (!conn) break;
+            conn->flushed_packets++;
+            break;
+#endif
         case HCI_EVENT_MODE_CHANGE:
             handle = hci_event_mode_change_get_handle(packet);
             conn = hci_connection_for_handle(handle);
             if (!conn) break;
             conn->connection_mode = hci_event_mode_change_get_mode(packet);
             log_info("HCI_EVENT_MODE_CHANGE, handle 0x%04x, mode %u", handle, conn->connection_mode);
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+            switch (conn->connection_mode){
+                case ACL_CONNECTION_MODE_ACTIVE:
+                    hci_auto_sniff_start_timer(conn);
+                    break;
+                case ACL_CONNECTION_MODE_SNIFF:
+                    if (hci_stack->auto_sniff_idle_timeout_ms == 0) break;
+                    if (hci_stack->auto_sniff_subrating_max_latency == 0) break;
+                    if (!hci_sniff_subrating_supported()) break;
+                    conn->auto_sniff_subrating_pending = true;
+                    break;
+                default:
+                    break;
+            }
+#endif
             break;
 #endif
 
@@ -2365,6 +5003,11 @@ static void event_handler(uint8_t *packet, int size){
                     if (hci_is_le_connection(conn)){
                         // For LE, we accept connection as encrypted
                         conn->authentication_flags |= CONNECTION_ENCRYPTED;
+#ifdef ENABLE_LE_LINK_UPGRADE
+                        if (conn->le_link_upgrade_state == LE_LINK_UPGRADE_W4_ENCRYPTION){
+                            hci_le_link_upgrade_start(conn);
+                        }
+#endif
                     }
 #ifdef ENABLE_CLASSIC
                     else {
@@ -2425,6 +5068,10 @@ static void event_handler(uint8_t *packet, int size){
         case HCI_EVENT_DISCONNECTION_COMPLETE:
             if (packet[2]) break;   // status != 0
             handle = little_endian_read_16(packet, 3);
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            // CIS disconnected
+            if (hci_iso_handle_disconnection_complete(handle)) break;
+#endif
             // drop outgoing ACL fragments if it is for closed connection and release buffer if tx not active
             if (hci_stack->acl_fragmentation_total_size > 0) {
                 if (handle == READ_ACL_CONNECTION_HANDLE(hci_stack->hci_packet_buffer)){
@@ -2487,6 +5134,9 @@ static void event_handler(uint8_t *packet, int size){
                 return; // instead of break: to avoid re-entering hci_run()
             }
             hci_stack->acl_fragmentation_tx_active = 0;
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+            hci_acl_tx_buffer_packet_sent();
+#endif
             if (hci_stack->acl_fragmentation_total_size) break;
             hci_release_packet_buffer();
             
@@ -2495,6 +5145,9 @@ static void event_handler(uint8_t *packet, int size){
 #ifdef ENABLE_CLASSIC
             // For SCO, we do the can_send_now_check here
             hci_notify_if_sco_can_send_now();
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            hci_iso_notify_can_send_now();
 #endif
             break;
 
@@ -2515,6 +5168,9 @@ static void event_handler(uint8_t *packet, int size){
 
 #ifdef ENABLE_BLE
         case HCI_EVENT_LE_META:
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            hci_iso_handle_le_meta_event(packet, size);
+#endif
             switch (packet[2]){
 #ifdef ENABLE_LE_CENTRAL
                 case HCI_SUBEVENT_LE_ADVERTISING_REPORT:
@@ -2522,6 +5178,12 @@ static void event_handler(uint8_t *packet, int size){
                     if (!hci_stack->le_scanning_enabled) break;
                     le_handle_advertisement_report(packet, size);
                     break;
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+                case HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT:
+                    if (!hci_stack->le_scanning_enabled) break;
+                    le_handle_extended_advertisement_report(packet, size);
+                    break;
+#endif
 #endif
                 case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
                     // Connection management
@@ -2550,8 +5212,7 @@ static void event_handler(uint8_t *packet, int size){
                         hci_stack->le_connecting_state = LE_CONNECTING_IDLE;
                         // remove entry
                         if (conn){
-                            btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-                            btstack_memory_hci_connection_free( conn );
+                            hci_connection_free(conn);
                         }
                         break;
                     }
@@ -2596,6 +5257,9 @@ static void event_handler(uint8_t *packet, int size){
                     
                     log_info("New connection: handle %u, %s", conn->con_handle, bd_addr_to_str(conn->address));
                     
+#ifdef ENABLE_LE_LINK_UPGRADE
+                    hci_le_link_upgrade_handle_connection_complete(conn);
+#endif
                     hci_emit_nr_connections_changed();
                     break;
 
@@ -2633,12 +5297,32 @@ static void event_handler(uint8_t *packet, int size){
                         }
                     }
                     break;
-#ifdef ENABLE_LE_LIMIT_ACL_FRAGMENT_BY_MAX_OCTETS
+#if defined(ENABLE_LE_LIMIT_ACL_FRAGMENT_BY_MAX_OCTETS) || defined(ENABLE_LE_LINK_UPGRADE)
                 case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
                     handle = hci_subevent_le_data_length_change_get_connection_handle(packet);
                     conn = hci_connection_for_handle(handle);
                     if (conn) {
+#ifdef ENABLE_LE_LIMIT_ACL_FRAGMENT_BY_MAX_OCTETS
                         conn->le_max_tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+#endif
+#ifdef ENABLE_LE_LINK_UPGRADE
+                        conn->le_link_max_tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+                        conn->le_link_max_rx_octets = hci_subevent_le_data_length_change_get_max_rx_octets(packet);
+#endif
+                    }
+                    break;
+#endif
+#ifdef ENABLE_LE_LINK_UPGRADE
+                case HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE:
+                    handle = hci_subevent_le_phy_update_complete_get_connection_handle(packet);
+                    conn = hci_connection_for_handle(handle);
+                    if (!conn) break;
+                    if (hci_subevent_le_phy_update_complete_get_status(packet) == ERROR_CODE_SUCCESS){
+                        conn->le_tx_phy = hci_subevent_le_phy_update_complete_get_tx_phy(packet);
+                        conn->le_rx_phy = hci_subevent_le_phy_update_complete_get_rx_phy(packet);
+                    }
+                    if (conn->le_link_upgrade_state == LE_LINK_UPGRADE_W4_PHY_UPDATE_COMPLETE){
+                        hci_le_link_upgrade_done(conn);
                     }
                     break;
 #endif
@@ -2723,6 +5407,26 @@ static void sco_schedule_tx(hci_connection_t * conn){
     btstack_run_loop_add_timer(timer);
 }
 
+// number of received SCO packets without Number Of Completed Packets for outstanding SCO packets,
+// after which we assume that the controller does not report them and fall back to SCO TX pacing
+#ifndef HCI_SCO_FLOW_CONTROL_FALLBACK_RX_PACKETS
+#define HCI_SCO_FLOW_CONTROL_FALLBACK_RX_PACKETS 20
+#endif
+
+static void sco_flow_control_fallback_to_tx_pacing(void){
+    log_info("SCO: no Number Of Completed Packets for SCO, fall back to SCO TX pacing");
+    hci_stack->synchronous_flow_control_enabled = 0;
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) hci_stack->connections; it ; it = it->next){
+        hci_connection_t * connection = (hci_connection_t *) it;
+        if (connection->address_type != BD_ADDR_TYPE_SCO) continue;
+        connection->num_packets_sent = 0;
+        connection->sco_tx_ready = 0;
+        connection->sco_rx_count = 0;
+        connection->sco_rx_valid = 0;
+    }
+}
+
 static void sco_handler(uint8_t * packet, uint16_t size){
     // lookup connection struct
     hci_con_handle_t con_handle = READ_SCO_CONNECTION_HANDLE(packet);
@@ -2742,6 +5446,18 @@ static void sco_handler(uint8_t * packet, uint16_t size){
         // Nothing to do
     } else {
         // log_debug("sco flow %u, handle 0x%04x, packets sent %u, bytes send %u", hci_stack->synchronous_flow_control_enabled, (int) con_handle, conn->num_packets_sent, conn->num_sco_bytes_sent);
+        if (hci_stack->synchronous_flow_control_enabled){
+            // packets are paced by Number Of Completed Packets, verify that controller reports them
+            if (conn->num_packets_sent == 0){
+                conn->sco_rx_count_since_completed_packets = 0;
+            } else {
+                conn->sco_rx_count_since_completed_packets++;
+                if (conn->sco_rx_count_since_completed_packets >= HCI_SCO_FLOW_CONTROL_FALLBACK_RX_PACKETS){
+                    conn->sco_rx_count_since_completed_packets = 0;
+                    sco_flow_control_fallback_to_tx_pacing();
+                }
+            }
+        }
         if (hci_stack->synchronous_flow_control_enabled == 0){
             uint32_t now = btstack_run_loop_get_time_ms();
 
@@ -2775,8 +5491,7 @@ static void sco_handler(uint8_t * packet, uint16_t size){
     }
 
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
-    conn->num_packets_completed++;
-    hci_stack->host_completed_packets = 1;
+    hci_host_completed_packet(conn);
     hci_run();
 #endif    
 }
@@ -2786,15 +5501,40 @@ static void packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
     hci_dump_packet(packet_type, 1, packet, size);
     switch (packet_type) {
         case HCI_EVENT_PACKET:
+            BTSTACK_TRACE(BTSTACK_TRACE_POINT_HCI_EVENT_RX, packet[0], size);
             event_handler(packet, size);
             break;
         case HCI_ACL_DATA_PACKET:
+            BTSTACK_TRACE(BTSTACK_TRACE_POINT_HCI_ACL_RX, READ_ACL_CONNECTION_HANDLE(packet), size);
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+            // transports without dedicated ISO channel, e.g. USB, deliver ISO packets as ACL
+            if (size >= HCI_ISO_HEADER_SIZE){
+                hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(READ_ACL_CONNECTION_HANDLE(packet));
+                if (iso_stream != NULL){
+                    hci_iso_packet_handler(iso_stream, packet, size);
+                    break;
+                }
+            }
+#endif
             acl_handler(packet, size);
             break;
 #ifdef ENABLE_CLASSIC
         case HCI_SCO_DATA_PACKET:
+            BTSTACK_TRACE(BTSTACK_TRACE_POINT_HCI_SCO_RX, READ_SCO_CONNECTION_HANDLE(packet), size);
             sco_handler(packet, size);
             break;
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+        case HCI_ISO_DATA_PACKET:{
+            if (size < HCI_ISO_HEADER_SIZE) break;
+            hci_iso_stream_t * iso_stream = hci_iso_stream_for_con_handle(little_endian_read_16(packet, 0) & 0x0fff);
+            if (iso_stream == NULL){
+                log_info("ISO packet for unknown stream 0x%04x", little_endian_read_16(packet, 0) & 0x0fff);
+                break;
+            }
+            hci_iso_packet_handler(iso_stream, packet, size);
+            break;
+        }
 #endif
         default:
             break;
@@ -2814,6 +5554,12 @@ void hci_register_acl_packet_handler(btstack_packet_handler_t handler){
     hci_stack->acl_packet_handler = handler;
 }
 
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+void hci_register_acl_buffer_provider(const hci_acl_buffer_provider_t * provider){
+    hci_stack->acl_buffer_provider = provider;
+}
+#endif
+
 #ifdef ENABLE_CLASSIC
 /**
  * @brief Registers a packet handler for SCO data. Used for HSP and HFP profiles.
@@ -2827,6 +5573,11 @@ static void hci_state_reset(void){
     // no connections yet
     hci_stack->connections = NULL;
 
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING
+    hci_stack->host_completed_packets_pending = 0;
+    btstack_run_loop_remove_timer(&hci_stack->host_completed_packets_timer);
+#endif
+
     // keep discoverable/connectable as this has been requested by the client(s)
     // hci_stack->discoverable = 0;
     // hci_stack->connectable = 0;
@@ -2836,9 +5587,34 @@ static void hci_state_reset(void){
     // buffer is free
     hci_stack->hci_packet_buffer_reserved = 0;
 
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+    // commands sent before reset will not complete
+    hci_command_queue_abort();
+#endif
+
     // no pending cmds
     hci_stack->decline_reason = 0;
     hci_stack->new_scan_enable_value = 0xff;
+
+#ifdef ENABLE_CLASSIC
+    // SCO flow control is enabled again during init if supported
+    hci_stack->synchronous_flow_control_enabled = 0;
+
+    // page timeout is written during init, configured page scan parameters after init
+    hci_stack->gap_classic_tasks = 0;
+    if (hci_stack->page_scan_interval != 0){
+        hci_stack->gap_classic_tasks |= GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_ACTIVITY;
+    }
+    if (hci_stack->page_scan_type != PAGE_SCAN_TYPE_STANDARD){
+        hci_stack->gap_classic_tasks |= GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_TYPE;
+    }
+#endif
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+    hci_stack->gap_paging_create_connection_deferred = false;
+    hci_stack->gap_paging_active = false;
+    btstack_run_loop_remove_timer(&hci_stack->gap_reconnect_timer);
+    hci_stack->gap_reconnect_timer_active = false;
+#endif
     
     // LE
 #ifdef ENABLE_BLE
@@ -2848,10 +5624,23 @@ static void hci_state_reset(void){
 #ifdef ENABLE_LE_CENTRAL
     hci_stack->le_scanning_active  = 0;
     hci_stack->le_scan_type = 0xff; 
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+    hci_stack->le_extended_scanning_active = false;
+    hci_stack->le_extended_advertising_report_active = false;
+#endif
     hci_stack->le_connecting_state = LE_CONNECTING_IDLE;
     hci_stack->le_whitelist = 0;
     hci_stack->le_whitelist_capacity = 0;
 #endif
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+    hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_DONE;
+#endif
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    // ISO buffers are reported by LE Read Buffer Size v2 during init
+    hci_stack->iso_data_packet_length = 0;
+    hci_stack->iso_packets_total_num = 0;
+    hci_iso_reset();
+#endif
 }
 
 #ifdef ENABLE_CLASSIC
@@ -2895,6 +5684,14 @@ void hci_init(const hci_transport_t *transport, const void *config){
 
     hci_stack->state = HCI_STATE_OFF;
 
+    hci_stack->pending_commands_last_handle = HCI_CON_HANDLE_INVALID;
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+    hci_stack->qos_acl_reserved[HCI_TRAFFIC_CLASS_VOICE] = HCI_QOS_ACL_RESERVED_VOICE;
+    hci_stack->qos_acl_reserved[HCI_TRAFFIC_CLASS_MEDIA] = HCI_QOS_ACL_RESERVED_MEDIA;
+    hci_stack->qos_acl_reserved[HCI_TRAFFIC_CLASS_INTERACTIVE] = HCI_QOS_ACL_RESERVED_INTERACTIVE;
+#endif
+
     // class of device
     hci_stack->class_of_device = 0x007a020c; // Smartphone 
 
@@ -2911,6 +5708,9 @@ void hci_init(const hci_transport_t *transport, const void *config){
     // Allow Role Switch
     hci_stack->allow_role_switch = 1;
 
+    // Page Timeout: ca. 15 sec
+    hci_stack->page_timeout = 0x6000;
+
     // Default / minimum security level = 2
     hci_stack->gap_security_level = LEVEL_2;
 
@@ -2950,6 +5750,17 @@ void hci_init(const hci_transport_t *transport, const void *config){
     hci_stack->le_max_number_peripheral_connections = 1; // only single connection as peripheral
 #endif
 
+#ifdef ENABLE_LE_LINK_UPGRADE
+    hci_stack->le_link_upgrade_mode = GAP_LE_LINK_UPGRADE_AFTER_CONNECTION;
+#endif
+
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    // default profiles: bulk transfer 7.5-15 ms, low latency 15-30 ms, low power 100-200 ms with slave latency 4
+    gap_set_connection_parameter_profile(GAP_LE_CONNECTION_PROFILE_BULK_TRANSFER,  6,  12, 0, 200);
+    gap_set_connection_parameter_profile(GAP_LE_CONNECTION_PROFILE_LOW_LATENCY,   12,  24, 0, 200);
+    gap_set_connection_parameter_profile(GAP_LE_CONNECTION_PROFILE_LOW_POWER,     80, 160, 4, 600);
+#endif
+
     // connection parameter range used to answer connection parameter update requests in l2cap
     hci_stack->le_connection_parameter_range.le_conn_interval_min =          6; 
     hci_stack->le_connection_parameter_range.le_conn_interval_max =       3200;
@@ -3044,6 +5855,25 @@ void gap_set_link_supervision_timeout(uint16_t link_supervision_timeout){
     hci_stack->link_supervision_timeout = link_supervision_timeout;
 }
 
+void gap_set_page_timeout(uint16_t page_timeout){
+    hci_stack->page_timeout = page_timeout;
+    hci_stack->gap_classic_tasks |= GAP_CLASSIC_TASK_WRITE_PAGE_TIMEOUT;
+    hci_run();
+}
+
+void gap_set_page_scan_activity(uint16_t page_scan_interval, uint16_t page_scan_window){
+    hci_stack->page_scan_interval = page_scan_interval;
+    hci_stack->page_scan_window = page_scan_window;
+    hci_stack->gap_classic_tasks |= GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_ACTIVITY;
+    hci_run();
+}
+
+void gap_set_page_scan_type(page_scan_type_t page_scan_type){
+    hci_stack->page_scan_type = (uint8_t) page_scan_type;
+    hci_stack->gap_classic_tasks |= GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_TYPE;
+    hci_run();
+}
+
 void hci_disable_l2cap_timeout_check(void){
     disable_l2cap_timeouts = 1;
 }
@@ -3119,6 +5949,10 @@ static void hci_power_control_off(void){
     log_info("hci_power_control_off - control closed");
 
     hci_stack->state = HCI_STATE_OFF;
+
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+    hci_command_queue_abort();
+#endif
 }
 
 static void hci_power_control_sleep(void){
@@ -3171,6 +6005,13 @@ static void hci_power_transition_to_initializing(void){
     hci_stack->hci_packet_buffer_reserved = 0;
     hci_stack->state = HCI_STATE_INITIALIZING;
     hci_stack->substate = HCI_INIT_SEND_RESET;
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+    hci_stack->init_script_num_cmd_packets = 1;
+    hci_stack->init_script_cmds_outstanding = 0;
+#endif
+#ifdef ENABLE_HCI_INIT_PROFILING
+    hci_init_profile_start();
+#endif
 }
 
 int hci_power_control(HCI_POWER_MODE power_mode){
@@ -3380,6 +6221,10 @@ static void hci_host_num_completed_packets(void){
     packet[3] = num_handles;
 
     hci_stack->host_completed_packets = 0;
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING
+    hci_stack->host_completed_packets_pending = 0;
+    btstack_run_loop_remove_timer(&hci_stack->host_completed_packets_timer);
+#endif
 
     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet, size);
     hci_stack->hci_transport->send_packet(HCI_COMMAND_DATA_PACKET, packet, size);
@@ -3416,12 +6261,33 @@ static bool hci_run_acl_fragments(void){
             hci_stack->acl_fragmentation_pos = 0;
         }
     }
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+    // send queued fragments
+    if (hci_stack->hci_packet_buffer_reserved) return false;
+    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return false;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (!hci_acl_tx_buffer_pending(connection)) continue;
+        if (hci_number_free_acl_slots_for_handle(connection->con_handle) == 0) continue;
+        hci_acl_tx_buffer_send_fragments(connection);
+        return true;
+    }
+#endif
     return false;
 }
 
 #ifdef ENABLE_CLASSIC
 static bool hci_run_general_gap_classic(void){
 
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+    // send Create Connection after Write Page Timeout
+    if (hci_stack->gap_paging_create_connection_deferred){
+        hci_send_cmd_packet(hci_stack->gap_paging_create_connection, sizeof(hci_stack->gap_paging_create_connection));
+        return true;
+    }
+#endif
     // decline incoming connections
     if (hci_stack->decline_reason){
         uint8_t reason = hci_stack->decline_reason;
@@ -3439,6 +6305,9 @@ static bool hci_run_general_gap_classic(void){
     if ((hci_stack->inquiry_state >= GAP_INQUIRY_DURATION_MIN) && (hci_stack->inquiry_state <= GAP_INQUIRY_DURATION_MAX)){
         uint8_t duration = hci_stack->inquiry_state;
         hci_stack->inquiry_state = GAP_INQUIRY_STATE_ACTIVE;
+#ifdef ENABLE_GAP_INQUIRY_RESULT_CACHE
+        hci_stack->gap_inquiry_id++;
+#endif
         hci_send_cmd(&hci_inquiry, GAP_IAC_GENERAL_INQUIRY, duration, 0);
         return true;
     }
@@ -3482,11 +6351,49 @@ static bool hci_run_general_gap_classic(void){
         }
         return true;
     }
+    // page timeout and page scan configuration
+    if ((hci_stack->state == HCI_STATE_WORKING) && (hci_stack->gap_classic_tasks != 0)){
+        if ((hci_stack->gap_classic_tasks & GAP_CLASSIC_TASK_WRITE_PAGE_TIMEOUT) != 0){
+            hci_stack->gap_classic_tasks &= ~GAP_CLASSIC_TASK_WRITE_PAGE_TIMEOUT;
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+            hci_stack->gap_paging_page_timeout_active = hci_stack->page_timeout;
+#endif
+            hci_send_cmd(&hci_write_page_timeout, hci_stack->page_timeout);
+            return true;
+        }
+        if ((hci_stack->gap_classic_tasks & GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_ACTIVITY) != 0){
+            hci_stack->gap_classic_tasks &= ~GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_ACTIVITY;
+            hci_send_cmd(&hci_write_page_scan_activity, hci_stack->page_scan_interval, hci_stack->page_scan_window);
+            return true;
+        }
+        if ((hci_stack->gap_classic_tasks & GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_TYPE) != 0){
+            hci_stack->gap_classic_tasks &= ~GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_TYPE;
+            hci_send_cmd(&hci_write_page_scan_type, hci_stack->page_scan_type);
+            return true;
+        }
+    }
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+    // prepares outgoing connection that is sent by hci_run_general_pending_commmands
+    gap_reconnect_run();
+#endif
     return false;
 }
 #endif
 
 #ifdef ENABLE_BLE
+#ifdef ENABLE_LE_CENTRAL
+static void hci_le_scan_stop(void){
+    hci_stack->le_scanning_active = 0;
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+    if (hci_stack->le_extended_scanning_active){
+        hci_send_cmd(&hci_le_set_extended_scan_enable, 0, 0, 0, 0);
+        return;
+    }
+#endif
+    hci_send_cmd(&hci_le_set_scan_enable, 0, 0);
+}
+#endif
+
 static bool hci_run_general_gap_le(void){
 
     // advertisements, active scanning, and creating connections requires random address to be set if using private address
@@ -3494,22 +6401,74 @@ static bool hci_run_general_gap_le(void){
     if (hci_stack->state != HCI_STATE_WORKING) return false;
     if ( (hci_stack->le_own_addr_type != BD_ADDR_TYPE_LE_PUBLIC) && (hci_stack->le_random_address_set == 0) ) return false;
 
+    // collect pending Whitelist and Resolving List changes to apply them all within a single pause
+#ifdef ENABLE_LE_CENTRAL
+    btstack_linked_list_iterator_t lit;
+    bool whitelist_modification_pending = false;
+    btstack_linked_list_iterator_init(&lit, &hci_stack->le_whitelist);
+    while (btstack_linked_list_iterator_has_next(&lit)){
+        whitelist_entry_t * entry = (whitelist_entry_t*) btstack_linked_list_iterator_next(&lit);
+        if (entry->state & (LE_WHITELIST_REMOVE_FROM_CONTROLLER | LE_WHITELIST_ADD_TO_CONTROLLER)){
+            whitelist_modification_pending = true;
+            break;
+        }
+    }
+#endif
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+    bool resolving_list_modification_pending = hci_le_resolving_list_modification_pending();
+#else
+    bool resolving_list_modification_pending = false;
+#endif
+
+    // Resolving List changes require scanning, advertising, and connecting to be stopped,
+    // Whitelist changes only connecting, and advertising if its filter policy uses the Whitelist
+#ifdef ENABLE_LE_CENTRAL
+    bool scanning_stop   = resolving_list_modification_pending;
+    bool connecting_stop = resolving_list_modification_pending || whitelist_modification_pending;
+#endif
+#ifdef ENABLE_LE_PERIPHERAL
+    bool advertising_stop = resolving_list_modification_pending;
+#ifdef ENABLE_LE_CENTRAL
+    if (whitelist_modification_pending && (hci_stack->le_advertisements_filter_policy != 0)){
+        advertising_stop = true;
+    }
+#endif
+#endif
+
 #ifdef ENABLE_LE_CENTRAL
+    if (scanning_stop && hci_stack->le_scanning_active){
+        hci_le_scan_stop();
+        return true;
+    }
     // parameter change requires scanning to be stopped first
     if (hci_stack->le_scan_type != 0xff) {
         if (hci_stack->le_scanning_active){
-            hci_stack->le_scanning_active = 0;
-            hci_send_cmd(&hci_le_set_scan_enable, 0, 0);
+            hci_le_scan_stop();
         } else {
             int scan_type = (int) hci_stack->le_scan_type;
             hci_stack->le_scan_type = 0xff;
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+            if (hci_le_extended_scanning_used()){
+                hci_send_le_set_extended_scan_parameters((uint8_t) scan_type);
+                return true;
+            }
+#endif
             hci_send_cmd(&hci_le_set_scan_parameters, scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window, hci_stack->le_own_addr_type, 0);
         }
         return true;
     }
     // finally, we can enable/disable le scan
-    if ((hci_stack->le_scanning_enabled != hci_stack->le_scanning_active)){
+    if (!scanning_stop && (hci_stack->le_scanning_enabled != hci_stack->le_scanning_active)){
         hci_stack->le_scanning_active = hci_stack->le_scanning_enabled;
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+        if (hci_stack->le_scanning_enabled){
+            hci_stack->le_extended_scanning_active = hci_le_extended_scanning_used();
+        }
+        if (hci_stack->le_extended_scanning_active){
+            hci_send_cmd(&hci_le_set_extended_scan_enable, hci_stack->le_scanning_enabled, 0, 0, 0);
+            return true;
+        }
+#endif
         hci_send_cmd(&hci_le_set_scan_enable, hci_stack->le_scanning_enabled, 0);
         return true;
     }
@@ -3519,6 +6478,12 @@ static bool hci_run_general_gap_le(void){
     if (hci_stack->le_advertisements_todo){
         log_info("hci_run: gap_le: adv todo: %x", hci_stack->le_advertisements_todo );
     }
+    if (advertising_stop && hci_stack->le_advertisements_active){
+        // re-enable after lists have been updated
+        hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_ENABLE;
+        hci_send_cmd(&hci_le_set_advertise_enable, 0);
+        return true;
+    }
     if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_DISABLE){
         hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_DISABLE;
         hci_send_cmd(&hci_le_set_advertise_enable, 0);
@@ -3557,7 +6522,7 @@ static bool hci_run_general_gap_le(void){
         hci_send_cmd(&hci_le_set_scan_response_data, hci_stack->le_scan_response_data_len, scan_data_clean);
         return true;
     }
-    if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_ENABLE){
+    if (!advertising_stop && (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_ENABLE)){
         hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_ENABLE;
         hci_send_cmd(&hci_le_set_advertise_enable, 1);
         return true;
@@ -3569,25 +6534,13 @@ static bool hci_run_general_gap_le(void){
     // LE Whitelist Management
     //
 
-    // check if whitelist needs modification
-    btstack_linked_list_iterator_t lit;
-    int modification_pending = 0;
-    btstack_linked_list_iterator_init(&lit, &hci_stack->le_whitelist);
-    while (btstack_linked_list_iterator_has_next(&lit)){
-        whitelist_entry_t * entry = (whitelist_entry_t*) btstack_linked_list_iterator_next(&lit);
-        if (entry->state & (LE_WHITELIST_REMOVE_FROM_CONTROLLER | LE_WHITELIST_ADD_TO_CONTROLLER)){
-            modification_pending = 1;
-            break;
-        }
+    // stop connnecting if modification pending
+    if (connecting_stop && (hci_stack->le_connecting_state != LE_CONNECTING_IDLE)){
+        hci_send_cmd(&hci_le_create_connection_cancel);
+        return true;
     }
 
-    if (modification_pending){
-        // stop connnecting if modification pending
-        if (hci_stack->le_connecting_state != LE_CONNECTING_IDLE){
-            hci_send_cmd(&hci_le_create_connection_cancel);
-            return true;
-        }
-
+    if (whitelist_modification_pending){
         // add/remove entries
         btstack_linked_list_iterator_init(&lit, &hci_stack->le_whitelist);
         while (btstack_linked_list_iterator_has_next(&lit)){
@@ -3608,12 +6561,23 @@ static bool hci_run_general_gap_le(void){
             }
         }
     }
+#endif
+
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+    if (resolving_list_modification_pending && hci_run_le_resolving_list()){
+        return true;
+    }
+#endif
 
+#ifdef ENABLE_LE_CENTRAL
     // start connecting
-    if ( (hci_stack->le_connecting_state == LE_CONNECTING_IDLE) &&
+    if ( !connecting_stop && (hci_stack->le_connecting_state == LE_CONNECTING_IDLE) &&
          !btstack_linked_list_empty(&hci_stack->le_whitelist)){
         bd_addr_t null_addr;
         memset(null_addr, 0, 6);
+        uint16_t conn_interval_min = hci_stack->le_connection_interval_min;
+        uint16_t conn_interval_max = hci_stack->le_connection_interval_max;
+        hci_le_align_connection_interval(&conn_interval_min, &conn_interval_max);
         hci_send_cmd(&hci_le_create_connection,
                      hci_stack->le_connection_scan_interval,    // scan interval: 60 ms
                      hci_stack->le_connection_scan_window,    // scan interval: 30 ms
@@ -3621,8 +6585,8 @@ static bool hci_run_general_gap_le(void){
                      0,         // peer address type
                      null_addr, // peer bd addr
                      hci_stack->le_own_addr_type, // our addr type:
-                     hci_stack->le_connection_interval_min,    // conn interval min
-                     hci_stack->le_connection_interval_max,    // conn interval max
+                     conn_interval_min,    // conn interval min
+                     conn_interval_max,    // conn interval max
                      hci_stack->le_connection_latency,         // conn latency
                      hci_stack->le_supervision_timeout,        // conn latency
                      hci_stack->le_minimum_ce_length,          // min ce length
@@ -3635,10 +6599,30 @@ static bool hci_run_general_gap_le(void){
 }
 #endif
 
-static bool hci_run_general_pending_commmands(void){
+// round robin: start after connection that sent the last command, so that connections further back are not starved
+static btstack_linked_item_t * hci_run_general_pending_commands_start(void){
     btstack_linked_item_t * it;
     for (it = (btstack_linked_item_t *) hci_stack->connections; it != NULL; it = it->next){
+        if (((hci_connection_t *) it)->con_handle != hci_stack->pending_commands_last_handle) continue;
+        if (it->next != NULL) return it->next;
+        break;
+    }
+    return (btstack_linked_item_t *) hci_stack->connections;
+}
+
+static bool hci_run_general_pending_commmands(void){
+    btstack_linked_item_t * it;
+#ifdef ENABLE_BLE
+    uint16_t conn_interval_min;
+    uint16_t conn_interval_max;
+#endif
+    int num_connections = btstack_linked_list_count(&hci_stack->connections);
+    int i;
+    for (i = 0, it = hci_run_general_pending_commands_start(); i < num_connections;
+         i++, it = (it->next != NULL) ? it->next : (btstack_linked_item_t *) hci_stack->connections){
         hci_connection_t * connection = (hci_connection_t *) it;
+        // if a command gets sent, the next run starts with the following connection
+        hci_stack->pending_commands_last_handle = connection->con_handle;
 
         switch(connection->state){
             case SEND_CREATE_CONNECTION:
@@ -3657,6 +6641,9 @@ static bool hci_run_general_pending_commmands(void){
                         (void)memcpy(hci_stack->outgoing_addr,
                                      connection->address, 6);
                         log_info("sending hci_le_create_connection");
+                        conn_interval_min = hci_stack->le_connection_interval_min;
+                        conn_interval_max = hci_stack->le_connection_interval_max;
+                        hci_le_align_connection_interval(&conn_interval_min, &conn_interval_max);
                         hci_send_cmd(&hci_le_create_connection,
                                      hci_stack->le_connection_scan_interval,    // conn scan interval
                                      hci_stack->le_connection_scan_window,      // conn scan windows
@@ -3664,8 +6651,8 @@ static bool hci_run_general_pending_commmands(void){
                                      connection->address_type, // peer address type
                                      connection->address,      // peer bd addr
                                      hci_stack->le_own_addr_type, // our addr type:
-                                     hci_stack->le_connection_interval_min,    // conn interval min
-                                     hci_stack->le_connection_interval_max,    // conn interval max
+                                     conn_interval_min,    // conn interval min
+                                     conn_interval_max,    // conn interval max
                                      hci_stack->le_connection_latency,         // conn latency
                                      hci_stack->le_supervision_timeout,        // conn latency
                                      hci_stack->le_minimum_ce_length,          // min ce length
@@ -3723,6 +6710,14 @@ static bool hci_run_general_pending_commmands(void){
             return true;
         }
 
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+        if (connection->authentication_flags & WRITE_AUTOMATIC_FLUSH_TIMEOUT){
+            connectionClearAuthenticationFlags(connection, WRITE_AUTOMATIC_FLUSH_TIMEOUT);
+            hci_send_cmd(&hci_write_automatic_flush_timeout, connection->con_handle, connection->automatic_flush_timeout);
+            return true;
+        }
+#endif
+
         if (connection->authentication_flags & HANDLE_LINK_KEY_REQUEST){
             log_info("responding to link key request");
             connectionClearAuthenticationFlags(connection, HANDLE_LINK_KEY_REQUEST);
@@ -3831,20 +6826,35 @@ static bool hci_run_general_pending_commmands(void){
         }
 #endif
 
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+        if (connection->auto_sniff_subrating_pending){
+            connection->auto_sniff_subrating_pending = false;
+            hci_send_cmd(&hci_sniff_subrating, connection->con_handle, hci_stack->auto_sniff_subrating_max_latency,
+                         hci_stack->auto_sniff_subrating_min_remote_timeout, hci_stack->auto_sniff_subrating_min_local_timeout);
+            return true;
+        }
+#endif
+
 #ifdef ENABLE_BLE
         switch (connection->le_con_parameter_update_state){
             // response to L2CAP CON PARAMETER UPDATE REQUEST
             case CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                hci_send_cmd(&hci_le_connection_update, connection->con_handle, connection->le_conn_interval_min,
-                             connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
-                             0x0000, 0xffff);
+                conn_interval_min = connection->le_conn_interval_min;
+                conn_interval_max = connection->le_conn_interval_max;
+                hci_le_align_connection_interval(&conn_interval_min, &conn_interval_max);
+                hci_reserve_packet_buffer();
+                hci_send_prepared_cmd_packet(hci_cmd_create_le_connection_update(hci_stack->hci_packet_buffer, connection->con_handle,
+                             conn_interval_min, conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
+                             connection->le_min_ce_length, connection->le_max_ce_length));
                 return true;
             case CON_PARAMETER_UPDATE_REPLY:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                hci_send_cmd(&hci_le_remote_connection_parameter_request_reply, connection->con_handle, connection->le_conn_interval_min,
-                             connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
-                             0x0000, 0xffff);
+                hci_reserve_packet_buffer();
+                hci_send_prepared_cmd_packet(hci_cmd_create_le_remote_connection_parameter_request_reply(hci_stack->hci_packet_buffer,
+                             connection->con_handle, connection->le_conn_interval_min, connection->le_conn_interval_max,
+                             connection->le_conn_latency, connection->le_supervision_timeout,
+                             connection->le_min_ce_length, connection->le_max_ce_length));
                 return true;
             case CON_PARAMETER_UPDATE_NEGATIVE_REPLY:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
@@ -3859,6 +6869,23 @@ static bool hci_run_general_pending_commmands(void){
             hci_send_cmd(&hci_le_set_phy, connection->con_handle, all_phys, connection->le_phy_update_tx_phys, connection->le_phy_update_rx_phys, connection->le_phy_update_phy_options);
             return true;
         }
+#ifdef ENABLE_LE_LINK_UPGRADE
+        switch (connection->le_link_upgrade_state){
+#ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
+            case LE_LINK_UPGRADE_W2_SET_DATA_LENGTH:
+                connection->le_link_upgrade_state = LE_LINK_UPGRADE_W4_SET_DATA_LENGTH_COMPLETE;
+                hci_send_cmd(&hci_le_set_data_length, connection->con_handle, hci_stack->le_supported_max_tx_octets, hci_stack->le_supported_max_tx_time);
+                return true;
+#endif
+            case LE_LINK_UPGRADE_W2_SET_PHY:
+                // prefer LE 2M PHY for tx and rx
+                connection->le_link_upgrade_state = LE_LINK_UPGRADE_W4_SET_PHY_STATUS;
+                hci_send_cmd(&hci_le_set_phy, connection->con_handle, 0, 0x02, 0x02, 0);
+                return true;
+            default:
+                break;
+        }
+#endif
 #endif
     }
     return false;
@@ -3871,6 +6898,12 @@ static void hci_run(void){
     // send continuation fragments first, as they block the prepared packet buffer
     done = hci_run_acl_fragments();
     if (done) return;
+
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    // send next ISO SDU fragment
+    done = hci_run_iso_fragments();
+    if (done) return;
+#endif
     
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     // send host num completed packets next as they don't require num_cmd_packets > 0
@@ -3883,6 +6916,14 @@ static void hci_run(void){
 
     if (!hci_can_send_command_packet_now()) return;
 
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+    // send next queued command
+    if (hci_stack->state == HCI_STATE_WORKING){
+        hci_command_queue_run();
+        if (!hci_can_send_command_packet_now()) return;
+    }
+#endif
+
     // global/non-connection oriented commands
 
 
@@ -3898,6 +6939,14 @@ static void hci_run(void){
     if (done) return;
 #endif
 
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    // CIG, BIG and ISO data path configuration
+    if (hci_stack->state == HCI_STATE_WORKING){
+        done = hci_run_iso_commands();
+        if (done) return;
+    }
+#endif
+
     // send pending HCI commands
     done = hci_run_general_pending_commmands();
     if (done) return;
@@ -4053,8 +7102,16 @@ static void hci_run(void){
 }
 
 int hci_send_cmd_packet(uint8_t *packet, int size){
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_HCI_COMMAND_TX, little_endian_read_16(packet, 0), size);
+
     // house-keeping
     
+#ifdef ENABLE_HCI_INIT_PROFILING
+    if (hci_stack->state == HCI_STATE_INITIALIZING){
+        hci_stack->init_profile_step_timestamp_ms = btstack_run_loop_get_time_ms();
+    }
+#endif
+
     if (IS_COMMAND(packet, hci_write_loopback_mode)){
         hci_stack->loopback_mode = packet[3];
     }
@@ -4091,6 +7148,13 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
             case SEND_CREATE_CONNECTION:
                 // connection created by hci, e.g. dedicated bonding, but not executed yet, let's do it now
                 break;
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+            case SENT_CREATE_CONNECTION:
+                // Create Connection was deferred for Write Page Timeout, let's do it now
+                if (hci_stack->gap_paging_create_connection_deferred
+                    && (memcmp(&packet[3], &hci_stack->gap_paging_create_connection[3], 6) == 0)) break;
+                return -1; // packet not sent to controller
+#endif
             default:
                 // otherwise, just ignore as it is already in the open process
                 return -1; // packet not sent to controller
@@ -4100,6 +7164,11 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
         // track outgoing connection
         hci_stack->outgoing_addr_type = BD_ADDR_TYPE_ACL;
         (void)memcpy(hci_stack->outgoing_addr, addr, 6);
+
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+        // adds page parameters, might send Write Page Timeout instead
+        packet = gap_paging_create_connection(packet, &size);
+#endif
     }
 
     else if (IS_COMMAND(packet, hci_link_key_request_reply)){
@@ -4236,13 +7305,18 @@ int hci_send_cmd_va_arg(const hci_cmd_t *cmd, va_list argptr){
         return 0;
     }
 
-    // for HCI INITIALIZATION
-    // log_info("hci_send_cmd: opcode %04x", cmd->opcode);
-    hci_stack->last_cmd_opcode = cmd->opcode;
-
     hci_reserve_packet_buffer();
     uint8_t * packet = hci_stack->hci_packet_buffer;
     uint16_t size = hci_cmd_create_from_template(packet, cmd, argptr);
+    return hci_send_prepared_cmd_packet(size);
+}
+
+int hci_send_prepared_cmd_packet(uint16_t size){
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+
+    // for HCI INITIALIZATION
+    hci_stack->last_cmd_opcode = little_endian_read_16(packet, 0);
+
     int err = hci_send_cmd_packet(packet, size);
 
     // release packet buffer on error or for synchronous transport implementations
@@ -4279,6 +7353,7 @@ static void hci_emit_event(uint8_t * event, uint16_t size, int dump){
     btstack_linked_list_iterator_init(&it, &hci_stack->event_handlers);
     while (btstack_linked_list_iterator_has_next(&it)){
         btstack_packet_callback_registration_t * entry = (btstack_packet_callback_registration_t*) btstack_linked_list_iterator_next(&it);
+        if (!btstack_event_filter_matches(entry->event_filter, event[0])) continue;
         entry->callback(HCI_EVENT_PACKET, 0, event, size);
     }
 }
@@ -4301,6 +7376,465 @@ static void hci_notify_if_sco_can_send_now(void){
 }
 
 // parsing end emitting has been merged to reduce code size
+#ifdef ENABLE_GAP_INQUIRY_RESULT_CACHE
+static gap_inquiry_cache_entry_t * gap_inquiry_cache_lookup(const uint8_t * address){
+    int i;
+    for (i=0; i < GAP_INQUIRY_RESULT_CACHE_SIZE; i++){
+        gap_inquiry_cache_entry_t * entry = &hci_stack->gap_inquiry_cache[i];
+        if (entry->last_seen == 0) continue;
+        if (memcmp(entry->address, address, 6) == 0) return entry;
+    }
+    return NULL;
+}
+
+// @returns true if GAP_EVENT_INQUIRY_RESULT should be emitted. Adds cached name to event if it has none
+static bool gap_inquiry_cache_update(uint8_t * event, uint8_t * event_size, bool name_complete){
+    gap_inquiry_cache_entry_t * entry = gap_inquiry_cache_lookup(&event[2]);
+    if (entry == NULL){
+        // use free or least recently seen entry
+        int i;
+        for (i=0; i < GAP_INQUIRY_RESULT_CACHE_SIZE; i++){
+            gap_inquiry_cache_entry_t * candidate = &hci_stack->gap_inquiry_cache[i];
+            if (candidate->last_seen == 0) {
+                entry = candidate;
+                break;
+            }
+            uint16_t age = hci_stack->gap_inquiry_cache_time - candidate->last_seen;
+            if ((entry == NULL) || (age > (uint16_t)(hci_stack->gap_inquiry_cache_time - entry->last_seen))){
+                entry = candidate;
+            }
+        }
+        memset(entry, 0, sizeof(gap_inquiry_cache_entry_t));
+        (void)memcpy(entry->address, &event[2], 6);
+        entry->inquiry_id = hci_stack->gap_inquiry_id - 1u;
+    }
+    hci_stack->gap_inquiry_cache_time++;
+    if (hci_stack->gap_inquiry_cache_time == 0){
+        hci_stack->gap_inquiry_cache_time = 1;
+    }
+    entry->last_seen = hci_stack->gap_inquiry_cache_time;
+
+    // report each device once per inquiry, and again if its name changed
+    bool emit = entry->inquiry_id != hci_stack->gap_inquiry_id;
+    entry->inquiry_id = hci_stack->gap_inquiry_id;
+    if (event[16] != 0){
+        uint8_t name_len = event[17];
+        if ((name_len != entry->name_len) || (memcmp(&event[18], entry->name, name_len) != 0)){
+            entry->name_len = name_len;
+            (void)memcpy(entry->name, &event[18], name_len);
+            emit = true;
+        }
+        entry->name_complete = name_complete;
+    } else if (emit && (entry->name_len > 0)){
+        // merge name received with earlier EIR
+        event[16] = 1;
+        event[17] = entry->name_len;
+        (void)memcpy(&event[18], entry->name, entry->name_len);
+        *event_size += entry->name_len;
+    }
+    return emit;
+}
+
+// @returns true if remote name was available in cache and HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE was emitted
+static bool gap_inquiry_cache_emit_remote_name(const bd_addr_t addr){
+    uint8_t address[6];
+    reverse_bd_addr(addr, address);
+    const gap_inquiry_cache_entry_t * entry = gap_inquiry_cache_lookup(address);
+    if (entry == NULL) return false;
+    if (!entry->name_complete) return false;
+    uint8_t event[2+1+6+248];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = ERROR_CODE_SUCCESS;
+    (void)memcpy(&event[3], address, 6);
+    (void)memcpy(&event[9], entry->name, entry->name_len);
+    log_info("Remote name for %s from inquiry cache", bd_addr_to_str(addr));
+    hci_emit_event(event, sizeof(event), 1);
+    return true;
+}
+#endif
+
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+// cache entry: bd_addr (6), class of device (3), ttl (1), sequence number (4), name len (1), name (GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN)
+#define GAP_REMOTE_NAME_CACHE_OFFSET_COD       6
+#define GAP_REMOTE_NAME_CACHE_OFFSET_TTL       9
+#define GAP_REMOTE_NAME_CACHE_OFFSET_SEQ      10
+#define GAP_REMOTE_NAME_CACHE_OFFSET_NAME_LEN 14
+#define GAP_REMOTE_NAME_CACHE_OFFSET_NAME     15
+#define GAP_REMOTE_NAME_CACHE_ENTRY_SIZE      (GAP_REMOTE_NAME_CACHE_OFFSET_NAME + GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN)
+
+static uint32_t gap_remote_name_cache_tag_for_index(int index){
+    return ((uint32_t) 'R' << 24) | ((uint32_t) 'N' << 16) | ((uint32_t) 'C' << 8) | (uint32_t) index;
+}
+
+// @returns index of entry for addr loaded into entry or -1. index_store is set to entry for addr, a free or the oldest entry
+static int gap_remote_name_cache_find(const btstack_tlv_t * tlv_impl, void * tlv_context, const bd_addr_t addr,
+                                      uint8_t * entry, int * index_store, uint32_t * seq_newest){
+    int index_match = -1;
+    int index_free = -1;
+    int index_oldest = 0;
+    uint32_t seq_oldest = 0xffffffffu;
+    *seq_newest = 0;
+    int index;
+    for (index = 0; index < GAP_REMOTE_NAME_CACHE_NUM_ENTRIES; index++){
+        int size = tlv_impl->get_tag(tlv_context, gap_remote_name_cache_tag_for_index(index), entry, GAP_REMOTE_NAME_CACHE_ENTRY_SIZE);
+        if (size != GAP_REMOTE_NAME_CACHE_ENTRY_SIZE){
+            if (index_free < 0){
+                index_free = index;
+            }
+            continue;
+        }
+        if (bd_addr_cmp(entry, addr) == 0){
+            index_match = index;
+        }
+        uint32_t seq = little_endian_read_32(entry, GAP_REMOTE_NAME_CACHE_OFFSET_SEQ);
+        if (seq < seq_oldest){
+            seq_oldest = seq;
+            index_oldest = index;
+        }
+        if (seq > *seq_newest){
+            *seq_newest = seq;
+        }
+    }
+    if (index_match >= 0){
+        *index_store = index_match;
+        tlv_impl->get_tag(tlv_context, gap_remote_name_cache_tag_for_index(index_match), entry, GAP_REMOTE_NAME_CACHE_ENTRY_SIZE);
+        return index_match;
+    }
+    *index_store = (index_free >= 0) ? index_free : index_oldest;
+    return -1;
+}
+
+// class_of_device in little endian or NULL, name NULL to only update class of device of known device
+// refresh resets TTL of unchanged name, e.g. after Remote Name Request. Entries are only written if changed
+static void gap_remote_name_cache_store(const bd_addr_t addr, const uint8_t * class_of_device, const uint8_t * name, uint8_t name_len, bool refresh){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    uint8_t entry[GAP_REMOTE_NAME_CACHE_ENTRY_SIZE];
+    int index_store;
+    uint32_t seq_newest;
+    bool changed = false;
+    if (gap_remote_name_cache_find(tlv_impl, tlv_context, addr, entry, &index_store, &seq_newest) < 0){
+        if (name == NULL) return;
+        memset(entry, 0, sizeof(entry));
+        bd_addr_copy(entry, addr);
+        changed = true;
+    }
+    if ((class_of_device != NULL) && (memcmp(&entry[GAP_REMOTE_NAME_CACHE_OFFSET_COD], class_of_device, 3) != 0)){
+        (void)memcpy(&entry[GAP_REMOTE_NAME_CACHE_OFFSET_COD], class_of_device, 3);
+        changed = true;
+    }
+    if (name != NULL){
+        uint8_t len = btstack_min(name_len, GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN);
+        if ((entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME_LEN] != len) || (memcmp(&entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME], name, len) != 0)){
+            memset(&entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME], 0, GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN);
+            (void)memcpy(&entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME], name, len);
+            entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME_LEN] = len;
+            entry[GAP_REMOTE_NAME_CACHE_OFFSET_TTL] = GAP_REMOTE_NAME_CACHE_TTL;
+            changed = true;
+        }
+        if (refresh && (entry[GAP_REMOTE_NAME_CACHE_OFFSET_TTL] != GAP_REMOTE_NAME_CACHE_TTL)){
+            entry[GAP_REMOTE_NAME_CACHE_OFFSET_TTL] = GAP_REMOTE_NAME_CACHE_TTL;
+            changed = true;
+        }
+    }
+    if (!changed) return;
+
+    little_endian_store_32(entry, GAP_REMOTE_NAME_CACHE_OFFSET_SEQ, seq_newest + 1);
+    log_info("Remote Name Cache: store entry %u for %s", index_store, bd_addr_to_str(addr));
+    tlv_impl->store_tag(tlv_context, gap_remote_name_cache_tag_for_index(index_store), entry, GAP_REMOTE_NAME_CACHE_ENTRY_SIZE);
+}
+
+// @returns true if remote name was available in cache and HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE was emitted
+static bool gap_remote_name_cache_emit_remote_name(const bd_addr_t addr){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return false;
+
+    uint8_t entry[GAP_REMOTE_NAME_CACHE_ENTRY_SIZE];
+    int index_store;
+    uint32_t seq_newest;
+    int index = gap_remote_name_cache_find(tlv_impl, tlv_context, addr, entry, &index_store, &seq_newest);
+    if (index < 0) return false;
+    // name not known yet or TTL expired
+    if (entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME_LEN] == 0) return false;
+    if (entry[GAP_REMOTE_NAME_CACHE_OFFSET_TTL] == 0) return false;
+
+    entry[GAP_REMOTE_NAME_CACHE_OFFSET_TTL]--;
+    tlv_impl->store_tag(tlv_context, gap_remote_name_cache_tag_for_index(index), entry, GAP_REMOTE_NAME_CACHE_ENTRY_SIZE);
+
+    uint8_t event[2+1+6+248];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = ERROR_CODE_SUCCESS;
+    reverse_bd_addr(addr, &event[3]);
+    (void)memcpy(&event[9], &entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME], entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME_LEN]);
+    log_info("Remote name for %s from remote name cache entry %u", bd_addr_to_str(addr), index);
+    hci_emit_event(event, sizeof(event), 1);
+    return true;
+}
+
+bool gap_remote_name_cache_get(const bd_addr_t addr, uint32_t * class_of_device, char * name, uint16_t name_size){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return false;
+
+    uint8_t entry[GAP_REMOTE_NAME_CACHE_ENTRY_SIZE];
+    int index_store;
+    uint32_t seq_newest;
+    if (gap_remote_name_cache_find(tlv_impl, tlv_context, addr, entry, &index_store, &seq_newest) < 0) return false;
+
+    if (class_of_device != NULL){
+        *class_of_device = little_endian_read_24(entry, GAP_REMOTE_NAME_CACHE_OFFSET_COD);
+    }
+    if ((name != NULL) && (name_size > 0)){
+        uint16_t len = btstack_min(entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME_LEN], name_size - 1);
+        (void)memcpy(name, &entry[GAP_REMOTE_NAME_CACHE_OFFSET_NAME], len);
+        name[len] = 0;
+    }
+    return true;
+}
+
+void gap_remote_name_cache_remove(const bd_addr_t addr){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    uint8_t entry[GAP_REMOTE_NAME_CACHE_ENTRY_SIZE];
+    int index_store;
+    uint32_t seq_newest;
+    int index = gap_remote_name_cache_find(tlv_impl, tlv_context, addr, entry, &index_store, &seq_newest);
+    if (index < 0) return;
+    tlv_impl->delete_tag(tlv_context, gap_remote_name_cache_tag_for_index(index));
+}
+
+void gap_remote_name_cache_flush(void){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    int index;
+    for (index = 0; index < GAP_REMOTE_NAME_CACHE_NUM_ENTRIES; index++){
+        tlv_impl->delete_tag(tlv_context, gap_remote_name_cache_tag_for_index(index));
+    }
+}
+#endif
+
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+static gap_paging_history_entry_t * gap_paging_history_lookup(const bd_addr_t addr){
+    int i;
+    for (i = 0; i < GAP_PAGING_HISTORY_SIZE; i++){
+        gap_paging_history_entry_t * entry = &hci_stack->gap_paging_history[i];
+        if (!entry->in_use) continue;
+        if (bd_addr_cmp(entry->address, addr) == 0) return entry;
+    }
+    return NULL;
+}
+
+// @returns entry for addr, a free, or the least recently seen entry that is not a reconnection target
+static gap_paging_history_entry_t * gap_paging_history_get(const bd_addr_t addr){
+    gap_paging_history_entry_t * entry = gap_paging_history_lookup(addr);
+    if (entry != NULL) return entry;
+    int i;
+    for (i = 0; i < GAP_PAGING_HISTORY_SIZE; i++){
+        gap_paging_history_entry_t * candidate = &hci_stack->gap_paging_history[i];
+        if (!candidate->in_use){
+            entry = candidate;
+            break;
+        }
+        if (candidate->reconnect) continue;
+        if ((entry == NULL) || (candidate->last_seen_ms < entry->last_seen_ms)){
+            entry = candidate;
+        }
+    }
+    if (entry == NULL) return NULL;
+    memset(entry, 0, sizeof(gap_paging_history_entry_t));
+    bd_addr_copy(entry->address, addr);
+    entry->page_timeout = hci_stack->page_timeout;
+    entry->rssi = -128;
+    entry->in_use = true;
+    return entry;
+}
+
+static void gap_paging_handle_inquiry_result(const uint8_t * event){
+    // event: GAP_EVENT_INQUIRY_RESULT prepared by gap_inquiry_explode
+    bd_addr_t addr;
+    reverse_bd_addr(&event[2], addr);
+    gap_paging_history_entry_t * entry = gap_paging_history_get(addr);
+    if (entry == NULL) return;
+    entry->last_seen_ms = btstack_run_loop_get_time_ms();
+    entry->page_scan_repetition_mode = event[8];
+    entry->clock_offset = little_endian_read_16(event, 12) | 0x8000u;
+    if (event[14] != 0){
+        entry->rssi = (int8_t) event[15];
+    }
+    // device is in range, use default page timeout again
+    entry->page_timeout = hci_stack->page_timeout;
+    entry->failures = 0;
+}
+
+// @returns packet to send: Create Connection with page parameters, or Write Page Timeout if Create Connection has been deferred
+static uint8_t * gap_paging_create_connection(uint8_t * packet, int * size){
+    if (hci_stack->gap_paging_create_connection_deferred){
+        if (memcmp(&packet[3], &hci_stack->gap_paging_create_connection[3], 6) == 0){
+            hci_stack->gap_paging_create_connection_deferred = false;
+        }
+    } else {
+        bd_addr_t addr;
+        reverse_bd_addr(&packet[3], addr);
+        uint16_t page_timeout = hci_stack->page_timeout;
+        gap_paging_history_entry_t * entry = gap_paging_history_lookup(addr);
+        if (entry != NULL){
+            page_timeout = entry->page_timeout;
+            // Page Scan Repetition Mode and Clock Offset from inquiry, if not provided
+            if (((entry->clock_offset & 0x8000u) != 0) && (little_endian_read_16(packet, 13) == 0)){
+                packet[11] = entry->page_scan_repetition_mode;
+                little_endian_store_16(packet, 13, entry->clock_offset);
+            }
+        }
+        if (page_timeout != hci_stack->gap_paging_page_timeout_active){
+            log_info("Adaptive Paging: page timeout %u for %s", page_timeout, bd_addr_to_str(addr));
+            (void)memcpy(hci_stack->gap_paging_create_connection, packet, sizeof(hci_stack->gap_paging_create_connection));
+            hci_stack->gap_paging_create_connection_deferred = true;
+            hci_stack->gap_paging_page_timeout_active = page_timeout;
+            uint8_t * command = hci_stack->gap_paging_write_page_timeout;
+            little_endian_store_16(command, 0, hci_write_page_timeout.opcode);
+            command[2] = 2;
+            little_endian_store_16(command, 3, page_timeout);
+            *size = sizeof(hci_stack->gap_paging_write_page_timeout);
+            return command;
+        }
+    }
+    reverse_bd_addr(&packet[3], hci_stack->gap_paging_addr);
+    hci_stack->gap_paging_active = true;
+    hci_stack->gap_paging_start_ms = btstack_run_loop_get_time_ms();
+    return packet;
+}
+
+static void gap_paging_handle_connection_complete(const bd_addr_t addr, uint8_t status){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    gap_paging_history_entry_t * entry;
+    if (hci_stack->gap_paging_active && (bd_addr_cmp(addr, hci_stack->gap_paging_addr) == 0)){
+        hci_stack->gap_paging_active = false;
+        switch (status){
+            case ERROR_CODE_SUCCESS:
+                entry = gap_paging_history_get(addr);
+                if (entry == NULL) break;
+                // four times the observed paging time in 0.625 ms units
+                entry->page_timeout = (uint16_t) btstack_min(hci_stack->page_timeout,
+                                                              btstack_max(GAP_PAGE_TIMEOUT_MIN, ((now - hci_stack->gap_paging_start_ms) * 32u) / 5u));
+                entry->failures = 0;
+                break;
+            case ERROR_CODE_PAGE_TIMEOUT:
+                entry = gap_paging_history_get(addr);
+                if (entry == NULL) break;
+                // device probably out of range, don't block paging for others
+                entry->page_timeout = (uint16_t) btstack_min(hci_stack->page_timeout,
+                                                              btstack_max(GAP_PAGE_TIMEOUT_MIN, entry->page_timeout / 2u));
+                if (entry->failures < 0xff){
+                    entry->failures++;
+                }
+                log_info("Adaptive Paging: page timeout %u after %u failures for %s", entry->page_timeout, entry->failures, bd_addr_to_str(addr));
+                break;
+            default:
+                break;
+        }
+    }
+    if (status != ERROR_CODE_SUCCESS) return;
+    // incoming or outgoing connection established
+    entry = gap_paging_history_lookup(addr);
+    if (entry == NULL) return;
+    entry->last_seen_ms = now;
+    entry->reconnect = false;
+}
+
+static void gap_reconnect_timeout_handler(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    hci_stack->gap_reconnect_timer_active = false;
+    hci_run();
+}
+
+static bool gap_reconnect_outgoing_connection_pending(void){
+    if (hci_stack->gap_paging_active) return true;
+    if (hci_stack->outgoing_addr_type == BD_ADDR_TYPE_ACL) return true;
+    btstack_linked_item_t * it;
+    for (it = (btstack_linked_item_t *) hci_stack->connections; it != NULL; it = it->next){
+        hci_connection_t * conn = (hci_connection_t *) it;
+        if (conn->address_type != BD_ADDR_TYPE_ACL) continue;
+        if ((conn->state == SEND_CREATE_CONNECTION) || (conn->state == SENT_CREATE_CONNECTION)) return true;
+    }
+    return false;
+}
+
+// start outgoing connection to next reconnection target: most recently seen first, then higher RSSI
+static void gap_reconnect_run(void){
+    if (hci_stack->state != HCI_STATE_WORKING) return;
+    if (hci_stack->gap_reconnect_timer_active) return;
+    if (hci_stack->inquiry_state != GAP_INQUIRY_STATE_IDLE) return;
+    if (hci_stack->remote_name_state != GAP_REMOTE_NAME_STATE_IDLE) return;
+    if (gap_reconnect_outgoing_connection_pending()) return;
+
+    gap_paging_history_entry_t * next = NULL;
+    bool targets_pending = false;
+    int i;
+    for (i = 0; i < GAP_PAGING_HISTORY_SIZE; i++){
+        gap_paging_history_entry_t * entry = &hci_stack->gap_paging_history[i];
+        if (!entry->in_use) continue;
+        if (!entry->reconnect) continue;
+        if (hci_connection_for_bd_addr_and_type(entry->address, BD_ADDR_TYPE_ACL) != NULL) continue;
+        targets_pending = true;
+        if (entry->reconnect_attempted) continue;
+        if ((next == NULL) || (entry->last_seen_ms > next->last_seen_ms)
+            || ((entry->last_seen_ms == next->last_seen_ms) && (entry->rssi > next->rssi))){
+            next = entry;
+        }
+    }
+
+    if (next == NULL){
+        if (!targets_pending) return;
+        // all targets paged without success, start next round later
+        for (i = 0; i < GAP_PAGING_HISTORY_SIZE; i++){
+            hci_stack->gap_paging_history[i].reconnect_attempted = false;
+        }
+        btstack_run_loop_set_timer_handler(&hci_stack->gap_reconnect_timer, &gap_reconnect_timeout_handler);
+        btstack_run_loop_set_timer(&hci_stack->gap_reconnect_timer, GAP_RECONNECT_INTERVAL_MS);
+        btstack_run_loop_add_timer(&hci_stack->gap_reconnect_timer);
+        hci_stack->gap_reconnect_timer_active = true;
+        return;
+    }
+
+    hci_connection_t * conn = create_connection_for_bd_addr_and_type(next->address, BD_ADDR_TYPE_ACL);
+    if (conn == NULL) return;
+    next->reconnect_attempted = true;
+    conn->state = SEND_CREATE_CONNECTION;
+    log_info("Reconnect to %s", bd_addr_to_str(next->address));
+}
+
+uint8_t gap_reconnect_add_device(const bd_addr_t addr){
+    gap_paging_history_entry_t * entry = gap_paging_history_get(addr);
+    if (entry == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+    entry->reconnect = true;
+    entry->reconnect_attempted = false;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+void gap_reconnect_remove_device(const bd_addr_t addr){
+    gap_paging_history_entry_t * entry = gap_paging_history_lookup(addr);
+    if (entry == NULL) return;
+    entry->reconnect = false;
+}
+#endif
+
 static void gap_inquiry_explode(uint8_t *packet, uint16_t size) {
     uint8_t event[19+GAP_INQUIRY_MAX_NAME_LEN];
 
@@ -4308,6 +7842,10 @@ static void gap_inquiry_explode(uint8_t *packet, uint16_t size) {
     ad_context_t context;
     const uint8_t * name;
     uint8_t         name_len;
+    bool            name_complete;
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+    bd_addr_t       addr;
+#endif
 
     if (size < 3) return;
 
@@ -4334,6 +7872,7 @@ static void gap_inquiry_explode(uint8_t *packet, uint16_t size) {
         memset(event, 0, sizeof(event));
         event[0] = GAP_EVENT_INQUIRY_RESULT;
         uint8_t event_size = 18;    // if name is not set by EIR
+        name_complete = false;
 
         (void)memcpy(&event[2], &packet[3 + (i * 6)], 6); // bd_addr
         event[8] =          packet[3 + (num_responses*(6))                         + (i*1)];     // page_scan_repetition_mode
@@ -4368,10 +7907,13 @@ static void gap_inquiry_explode(uint8_t *packet, uint16_t size) {
                     switch (data_type){
                         case BLUETOOTH_DATA_TYPE_SHORTENED_LOCAL_NAME:
                             if (name) continue;
-                            /* fall through */
+                            name = data;
+                            name_len = data_size;
+                            break;
                         case BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME:
                             name = data;
                             name_len = data_size;
+                            name_complete = true;
                             break;
                         default:
                             break;
@@ -4384,9 +7926,29 @@ static void gap_inquiry_explode(uint8_t *packet, uint16_t size) {
                     event[17] = len;
                     (void)memcpy(&event[18], name, len);
                     event_size += len;
+                    if (len < name_len){
+                        name_complete = false;
+                    }
                 }
                 break;
         }
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+        gap_paging_handle_inquiry_result(event);
+#endif
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+        // store complete name from EIR, update class of device of known devices
+        reverse_bd_addr(&event[2], addr);
+        if (name_complete){
+            gap_remote_name_cache_store(addr, &event[9], &event[18], event[17], false);
+        } else {
+            gap_remote_name_cache_store(addr, &event[9], NULL, 0, false);
+        }
+#endif
+#ifdef ENABLE_GAP_INQUIRY_RESULT_CACHE
+        if (!gap_inquiry_cache_update(event, &event_size, name_complete)) continue;
+#else
+        UNUSED(name_complete);
+#endif
         event[1] = event_size - 2;
         hci_emit_event(event, event_size, 1);
     }
@@ -4797,8 +8359,7 @@ uint8_t gap_connect_cancel(void){
         case SEND_CREATE_CONNECTION:
             // skip sending create connection and emit event instead
             hci_emit_le_connection_complete(conn->address_type, conn->address, 0, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
-            btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
-            btstack_memory_hci_connection_free( conn );
+            hci_connection_free(conn);
             break;            
         case SENT_CREATE_CONNECTION:
             // request to send cancel connection
@@ -4903,8 +8464,9 @@ static void gap_advertisments_changed(void){
 void gap_advertisements_set_data(uint8_t advertising_data_length, uint8_t * advertising_data){
     hci_stack->le_advertisements_data_len = advertising_data_length;
     hci_stack->le_advertisements_data = advertising_data;
+    // legacy advertising data can be updated while advertising is enabled
     hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
-    gap_advertisments_changed();
+    hci_run();
 }
 
 /** 
@@ -4917,7 +8479,7 @@ void gap_scan_response_set_data(uint8_t scan_response_data_length, uint8_t * sca
     hci_stack->le_scan_response_data_len = scan_response_data_length;
     hci_stack->le_scan_response_data = scan_response_data;
     hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
-    gap_advertisments_changed();
+    hci_run();
 }
 
 /**
@@ -5051,6 +8613,17 @@ uint8_t gap_le_set_phy(hci_con_handle_t connection_handle, uint8_t all_phys, uin
  * @returns 0 if ok
  */
 int gap_auto_connection_start(bd_addr_type_t address_type, bd_addr_t address){
+    // keep existing entry, e.g. if its removal is still pending
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_whitelist);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        whitelist_entry_t * entry = (whitelist_entry_t*) btstack_linked_list_iterator_next(&it);
+        if (entry->address_type != address_type) continue;
+        if (memcmp(entry->address, address, 6) != 0) continue;
+        entry->state &= ~LE_WHITELIST_REMOVE_FROM_CONTROLLER;
+        hci_run();
+        return 0;
+    }
     // check capacity
     int num_entries = btstack_linked_list_count(&hci_stack->le_whitelist);
     if (num_entries >= hci_stack->le_whitelist_capacity) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
@@ -5177,6 +8750,12 @@ int gap_inquiry_stop(void){
  */
 int gap_remote_name_request(bd_addr_t addr, uint8_t page_scan_repetition_mode, uint16_t clock_offset){
     if (hci_stack->remote_name_state != GAP_REMOTE_NAME_STATE_IDLE) return ERROR_CODE_COMMAND_DISALLOWED;
+#ifdef ENABLE_GAP_INQUIRY_RESULT_CACHE
+    if (gap_inquiry_cache_emit_remote_name(addr)) return 0;
+#endif
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+    if (gap_remote_name_cache_emit_remote_name(addr)) return 0;
+#endif
     (void)memcpy(hci_stack->remote_name_addr, addr, 6);
     hci_stack->remote_name_page_scan_repetition_mode = page_scan_repetition_mode;
     hci_stack->remote_name_clock_offset = clock_offset;
@@ -5462,6 +9041,29 @@ uint8_t gap_sniff_mode_exit(hci_con_handle_t con_handle){
     hci_run();
     return 0;
 }
+
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+uint8_t gap_set_automatic_flush_timeout(hci_con_handle_t con_handle, uint16_t flush_timeout_ms){
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return GAP_CONNECTION_INVALID;
+    // 0.625 ms units, max 0x07ff = 1279 ms
+    uint32_t flush_timeout = ((uint32_t) flush_timeout_ms * 8u) / 5u;
+    if (flush_timeout > 0x07ffu){
+        flush_timeout = 0x07ffu;
+    }
+    if (conn->automatic_flush_timeout == flush_timeout) return ERROR_CODE_SUCCESS;
+    conn->automatic_flush_timeout = (uint16_t) flush_timeout;
+    connectionSetAuthenticationFlags(conn, WRITE_AUTOMATIC_FLUSH_TIMEOUT);
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint32_t gap_get_flushed_packets(hci_con_handle_t con_handle){
+    hci_connection_t * conn = hci_connection_for_handle(con_handle);
+    if (!conn) return 0;
+    return conn->flushed_packets;
+}
+#endif
 #endif
 
 void hci_halting_defer(void){
@@ -5529,12 +9131,8 @@ void hci_setup_test_connections_fuzz(void){
 }
 
 void hci_free_connections_fuzz(void){
-    btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, &hci_stack->connections);
-    while (btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * con = (hci_connection_t*) btstack_linked_list_iterator_next(&it);
-        btstack_linked_list_iterator_remove(&it);
-        btstack_memory_hci_connection_free(con);
+    while (hci_stack->connections != NULL){
+        hci_connection_free((hci_connection_t *) hci_stack->connections);
     }
 }
 void hci_simulate_working_fuzz(void){
@@ -73,6 +73,7 @@ extern "C" {
 #define HCI_CMD_HEADER_SIZE          3
 #define HCI_ACL_HEADER_SIZE          4
 #define HCI_SCO_HEADER_SIZE          3
+#define HCI_ISO_HEADER_SIZE          4
 #define HCI_EVENT_HEADER_SIZE        2
 
 #define HCI_EVENT_PAYLOAD_SIZE     255
@@ -149,6 +150,136 @@ extern "C" {
 #endif
 #endif
 
+// connection lookup tables, sizes must be power of two. HCI_CONNECTION_HANDLE_TABLE_SIZE 0x1000 maps all 12-bit handles
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+#ifndef HCI_CONNECTION_HANDLE_TABLE_SIZE
+#define HCI_CONNECTION_HANDLE_TABLE_SIZE 64
+#endif
+#ifndef HCI_CONNECTION_ADDRESS_TABLE_SIZE
+#define HCI_CONNECTION_ADDRESS_TABLE_SIZE 16
+#endif
+#if (HCI_CONNECTION_HANDLE_TABLE_SIZE & (HCI_CONNECTION_HANDLE_TABLE_SIZE - 1)) || (HCI_CONNECTION_ADDRESS_TABLE_SIZE & (HCI_CONNECTION_ADDRESS_TABLE_SIZE - 1))
+#error "HCI_CONNECTION_HANDLE_TABLE_SIZE and HCI_CONNECTION_ADDRESS_TABLE_SIZE must be a power of two"
+#endif
+#endif
+
+// advertising report deduplication table, size must be power of two
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+#ifndef GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE
+#define GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE 64
+#endif
+#if (GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE & (GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE - 1))
+#error "GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE must be a power of two"
+#endif
+#endif
+
+// reassembled advertising data of Extended Advertising Reports, limited by size of GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+#ifndef GAP_LE_EXTENDED_ADVERTISING_REPORT_DATA_SIZE
+#define GAP_LE_EXTENDED_ADVERTISING_REPORT_DATA_SIZE 231
+#endif
+#if GAP_LE_EXTENDED_ADVERTISING_REPORT_DATA_SIZE > 231
+#error "GAP_LE_EXTENDED_ADVERTISING_REPORT_DATA_SIZE must not exceed 231"
+#endif
+#endif
+
+// Names are arbitrarily shortened to 32 bytes if not requested otherwise
+#ifndef GAP_INQUIRY_MAX_NAME_LEN
+#define GAP_INQUIRY_MAX_NAME_LEN 32
+#endif
+
+// Inquiry Result Cache: devices and names seen during inquiries, least recently seen entry is replaced
+#ifdef ENABLE_GAP_INQUIRY_RESULT_CACHE
+#ifndef GAP_INQUIRY_RESULT_CACHE_SIZE
+#define GAP_INQUIRY_RESULT_CACHE_SIZE 16
+#endif
+#endif
+
+// Adaptive Paging: per-device page timeout and page parameters, reconnection scheduler
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+#ifndef GAP_PAGING_HISTORY_SIZE
+#define GAP_PAGING_HISTORY_SIZE 8
+#endif
+// lower bound for adapted page timeout in 0.625 ms units, covers two page scan intervals of R2
+#ifndef GAP_PAGE_TIMEOUT_MIN
+#define GAP_PAGE_TIMEOUT_MIN 0x2000
+#endif
+// pause between reconnection rounds after all targets have been paged without success
+#ifndef GAP_RECONNECT_INTERVAL_MS
+#define GAP_RECONNECT_INTERVAL_MS 10000
+#endif
+#endif
+
+// Remote Name Cache: names and class of device of remote devices stored in TLV, oldest entry is replaced
+#ifdef ENABLE_GAP_REMOTE_NAME_CACHE
+#ifndef GAP_REMOTE_NAME_CACHE_NUM_ENTRIES
+#define GAP_REMOTE_NAME_CACHE_NUM_ENTRIES 8
+#endif
+#ifndef GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN
+#define GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN 64
+#endif
+// number of remote name requests answered from cache before name is requested again
+#ifndef GAP_REMOTE_NAME_CACHE_TTL
+#define GAP_REMOTE_NAME_CACHE_TTL 16
+#endif
+#if GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN > 248
+#error "GAP_REMOTE_NAME_CACHE_MAX_NAME_LEN must not exceed 248"
+#endif
+#endif
+
+// LE Connection Parameter Profiles: switch from bulk transfer to low power profile after idle timeout
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+#ifndef GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS
+#define GAP_LE_CONNECTION_PROFILE_IDLE_TIMEOUT_MS 2000
+#endif
+#endif
+
+// LE CE Length Allocator: connection interval shared by links with throughput demand, unit: 1.25 ms
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+#ifndef GAP_LE_CE_LENGTH_ALLOCATOR_CONNECTION_INTERVAL
+#define GAP_LE_CE_LENGTH_ALLOCATOR_CONNECTION_INTERVAL 24
+#endif
+#endif
+
+// LE Resolving List mirrors entries of LE Device DB with index below MAX_NUM_RESOLVING_LIST_ENTRIES
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+#ifndef MAX_NUM_RESOLVING_LIST_ENTRIES
+#define MAX_NUM_RESOLVING_LIST_ENTRIES 16
+#endif
+#endif
+
+// pool of buffers for outgoing ACL fragments that wait for controller buffers
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+#ifndef HCI_ACL_TX_BUFFER_POOL_SIZE
+#define HCI_ACL_TX_BUFFER_POOL_SIZE 2
+#endif
+#endif
+
+// size of per-connection ACL recombination buffer, can be reduced if large L2CAP packets use an ACL buffer provider
+#ifndef HCI_ACL_RECOMBINATION_BUFFER_SIZE
+#define HCI_ACL_RECOMBINATION_BUFFER_SIZE HCI_ACL_BUFFER_SIZE
+#endif
+
+// max size of incoming ISO SDU that is reassembled from fragments, e.g. two LC3 frames of 155 bytes
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+#ifndef HCI_ISO_SDU_MAX_SIZE
+#define HCI_ISO_SDU_MAX_SIZE 310
+#endif
+#endif
+
+// Controller ACL buffers kept free for traffic classes while they are active, see hci_qos_set_acl_reservation
+#ifdef ENABLE_HCI_QOS_ARBITER
+#ifndef HCI_QOS_ACL_RESERVED_VOICE
+#define HCI_QOS_ACL_RESERVED_VOICE 1
+#endif
+#ifndef HCI_QOS_ACL_RESERVED_MEDIA
+#define HCI_QOS_ACL_RESERVED_MEDIA 2
+#endif
+#ifndef HCI_QOS_ACL_RESERVED_INTERACTIVE
+#define HCI_QOS_ACL_RESERVED_INTERACTIVE 1
+#endif
+#endif
+
 // 
 #define IS_COMMAND(packet, command) ( little_endian_read_16(packet,0) == command.opcode )
 
@@ -185,6 +316,24 @@ typedef enum {
     CON_PARAMETER_UPDATE_NEGATIVE_REPLY,
 } le_con_parameter_update_state_t;
 
+typedef enum {
+    LE_LINK_UPGRADE_IDLE,
+    LE_LINK_UPGRADE_W4_ENCRYPTION,
+    LE_LINK_UPGRADE_W2_SET_DATA_LENGTH,
+    LE_LINK_UPGRADE_W4_SET_DATA_LENGTH_COMPLETE,
+    LE_LINK_UPGRADE_W2_SET_PHY,
+    LE_LINK_UPGRADE_W4_SET_PHY_STATUS,
+    LE_LINK_UPGRADE_W4_PHY_UPDATE_COMPLETE,
+    LE_LINK_UPGRADE_DONE,
+} le_link_upgrade_state_t;
+
+typedef struct {
+    uint16_t le_conn_interval_min;
+    uint16_t le_conn_interval_max;
+    uint16_t le_conn_latency;
+    uint16_t le_supervision_timeout;
+} le_connection_profile_parameters_t;
+
 // Authentication flags
 typedef enum {
     AUTH_FLAGS_NONE                = 0x0000,
@@ -209,6 +358,7 @@ typedef enum {
     // errands
     READ_RSSI                      = 0x10000,
     WRITE_SUPERVISION_TIMEOUT      = 0x20000,
+    WRITE_AUTOMATIC_FLUSH_TIMEOUT  = 0x40000,
 
 } hci_authentication_flags_t;
 
@@ -417,6 +567,52 @@ typedef struct sm_connection {
 #define ATT_REQUEST_BUFFER_SIZE HCI_ACL_PAYLOAD_SIZE
 #endif
 
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+// per-connection queue for notifications, each takes 4 + value len bytes
+#ifndef ATT_SERVER_NOTIFICATION_QUEUE_SIZE
+#define ATT_SERVER_NOTIFICATION_QUEUE_SIZE 128
+#endif
+#endif
+
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+// per-connection cache for CCC writes of bonded devices, flushed to TLV on disconnect, timeout, or if full
+#ifndef ATT_SERVER_PERSISTENT_CCC_CACHE_SIZE
+#define ATT_SERVER_PERSISTENT_CCC_CACHE_SIZE 8
+#endif
+#ifndef ATT_SERVER_PERSISTENT_CCC_CACHE_TIMEOUT_MS
+#define ATT_SERVER_PERSISTENT_CCC_CACHE_TIMEOUT_MS 5000
+#endif
+#endif
+
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+#ifndef ENABLE_ATT_DELAYED_RESPONSE
+#error "ENABLE_ATT_SERVER_ASYNC_RESPONSE requires ENABLE_ATT_DELAYED_RESPONSE"
+#endif
+// max number of attributes with pending read or write in a single ATT request, e.g. Read Multiple
+#ifndef ATT_SERVER_ASYNC_MAX_PENDING
+#define ATT_SERVER_ASYNC_MAX_PENDING 4
+#endif
+// storage for values provided by att_server_read_response_ready until the ATT request is complete
+#ifndef ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE
+#define ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE 64
+#endif
+// Write Commands received while an ATT request is in progress: len (16), pdu
+#ifndef ATT_SERVER_COMMAND_QUEUE_SIZE
+#define ATT_SERVER_COMMAND_QUEUE_SIZE 64
+#endif
+
+typedef struct {
+    uint32_t token;
+    uint16_t attribute_handle;
+    uint16_t transaction_mode;
+    // read value in async_value_buffer
+    uint16_t value_offset;
+    uint16_t value_len;
+    uint8_t  error_code;
+    uint8_t  state;     // see att_server.c for state defines
+} att_server_async_entry_t;
+#endif
+
 typedef enum {
     ATT_SERVER_IDLE,
     ATT_SERVER_REQUEST_RECEIVED,
@@ -443,10 +639,36 @@ typedef struct {
     btstack_linked_list_t   notification_requests;
     btstack_linked_list_t   indication_requests;
 
+#ifdef ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
+    // queued notifications: handle (16), value len (16), value
+    uint16_t                notification_queue_len;
+    uint8_t                 notification_queue[ATT_SERVER_NOTIFICATION_QUEUE_SIZE];
+    bool                    multiple_handle_value_notifications_supported;
+#endif
+
+#ifdef ENABLE_ATT_SERVER_PERSISTENT_CCC_CACHE
+    // pending CCC writes for le device index
+    int                     persistent_ccc_cache_device_index;
+    uint8_t                 persistent_ccc_cache_count;
+    uint16_t                persistent_ccc_cache_handles[ATT_SERVER_PERSISTENT_CCC_CACHE_SIZE];
+    uint16_t                persistent_ccc_cache_values[ATT_SERVER_PERSISTENT_CCC_CACHE_SIZE];
+    btstack_timer_source_t  persistent_ccc_cache_timer;
+#endif
+
 #ifdef ENABLE_GATT_OVER_CLASSIC
     uint16_t                l2cap_cid;
 #endif
 
+#ifdef ENABLE_ATT_SERVER_ASYNC_RESPONSE
+    // token for read/write callback in progress, see att_server_get_token
+    uint32_t                async_token;
+    att_server_async_entry_t async_entries[ATT_SERVER_ASYNC_MAX_PENDING];
+    uint16_t                async_value_buffer_len;
+    uint8_t                 async_value_buffer[ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE];
+    uint16_t                command_queue_len;
+    uint8_t                 command_queue[ATT_SERVER_COMMAND_QUEUE_SIZE];
+#endif
+
     uint16_t                request_size;
     uint8_t                 request_buffer[ATT_REQUEST_BUFFER_SIZE];
 
@@ -468,6 +690,35 @@ typedef struct {
 } l2cap_state_t;
 #endif
 
+// ACL flow control statistics per connection, requires ENABLE_HCI_STATISTICS
+typedef struct {
+    // L2CAP PDUs and bytes passed to hci_send_acl_packet_buffer / hci_send_acl_iov
+    uint32_t acl_packets_sent;
+    uint32_t acl_bytes_sent;
+    // ACL fragments sent to Controller
+    uint32_t acl_fragments_sent;
+    // ACL fragments and bytes received from Controller
+    uint32_t acl_packets_received;
+    uint32_t acl_bytes_received;
+    // max number of ACL packets in Controller waiting for Number Of Completed Packets
+    uint16_t acl_packets_outstanding_max;
+} hci_connection_statistics_t;
+
+// HCI flow control and buffer statistics, requires ENABLE_HCI_STATISTICS
+typedef struct {
+    // hci_can_send_(prepared_)acl_packet_now refused by reason
+    uint32_t acl_refused_packet_buffer_reserved;
+    uint32_t acl_refused_transport_busy;
+    uint32_t acl_refused_no_credits;
+    uint32_t acl_refused_tx_buffer_pending;
+    // hci_reserve_packet_buffer failed as buffer was already reserved
+    uint32_t reserve_packet_buffer_failed;
+    // periods without free Controller ACL buffers, index 0: Classic (or shared), 1: LE
+    uint32_t acl_credit_starvation_count[2];
+    uint32_t acl_credit_starvation_ms[2];
+    uint32_t acl_credit_starvation_max_ms[2];
+} hci_statistics_t;
+
 //
 typedef struct {
     // linked list - assert: first field
@@ -514,11 +765,27 @@ typedef struct {
     uint16_t sniff_attempt;
     uint16_t sniff_timeout;
 
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+    // automatic flush timeout * 0.625 ms, 0 = no automatic flush
+    uint16_t automatic_flush_timeout;
+    // number of Flush Occurred events
+    uint32_t flushed_packets;
+#endif
+
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+    // checks for idle ACL link while in active mode
+    btstack_timer_source_t auto_sniff_timer;
+    bool auto_sniff_subrating_pending;
+#endif
+
     // track SCO rx event
     uint32_t sco_rx_ms;
     uint8_t  sco_rx_count;
     uint8_t  sco_rx_valid;
 
+    // SCO packets received while waiting for Number Of Completed Packets with Synchronous Flow Control
+    uint8_t  sco_rx_count_since_completed_packets;
+
     // generate sco can send now based on received packets, using timeout below
     uint8_t  sco_tx_ready;
     
@@ -534,9 +801,24 @@ typedef struct {
     uint32_t timestamp;
 
     // ACL packet recombination - PRE_BUFFER + ACL Header + ACL payload
-    uint8_t  acl_recombination_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 4 + HCI_ACL_BUFFER_SIZE];
+    uint8_t  acl_recombination_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 4 + HCI_ACL_RECOMBINATION_BUFFER_SIZE];
     uint16_t acl_recombination_pos;
     uint16_t acl_recombination_length;
+
+#ifdef ENABLE_HCI_ACL_TX_BUFFER_POOL
+    // outgoing ACL packet with remaining fragments moved from hci packet buffer - PRE_BUFFER + ACL Header + ACL payload
+    uint8_t * acl_tx_buffer;
+    uint16_t  acl_tx_pos;
+    uint16_t  acl_tx_size;
+#endif
+
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+    // L2CAP payload reassembly into buffer from hci_acl_buffer_provider_t
+    uint8_t * acl_provider_buffer;
+    uint16_t  acl_provider_cid;
+    uint16_t  acl_provider_pos;
+    uint16_t  acl_provider_len;
+#endif
     
 
     // number packets sent to controller
@@ -557,12 +839,39 @@ typedef struct {
 #ifdef ENABLE_BLE
     uint16_t le_connection_interval;
 
+    // CE length hint for connection update and connection parameter request reply, unit: 0.625 ms
+    uint16_t le_min_ce_length;
+    uint16_t le_max_ce_length;
+
+#ifdef ENABLE_LE_CE_LENGTH_ALLOCATOR
+    // relative throughput demand, 0 = not managed by allocator
+    uint8_t  le_throughput_demand;
+#endif
+
     // LE PHY Update via set phy command
     uint8_t le_phy_update_all_phys;      // 0xff for idle
     uint8_t le_phy_update_tx_phys;
     uint8_t le_phy_update_rx_phys;
     int8_t  le_phy_update_phy_options;
 
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    // selected profile and profile of last requested parameters
+    gap_le_connection_profile_t le_connection_profile;
+    gap_le_connection_profile_t le_connection_profile_applied;
+    uint32_t le_connection_profile_activity_ms;
+    bool     le_connection_profile_timer_active;
+    btstack_timer_source_t le_connection_profile_timer;
+#endif
+
+#ifdef ENABLE_LE_LINK_UPGRADE
+    // LE Link Upgrade: Data Length and 2M PHY
+    le_link_upgrade_state_t le_link_upgrade_state;
+    uint8_t  le_tx_phy;
+    uint8_t  le_rx_phy;
+    uint16_t le_link_max_tx_octets;
+    uint16_t le_link_max_rx_octets;
+#endif
+
     // LE Security Manager
     sm_connection_t sm_connection;
 
@@ -578,8 +887,133 @@ typedef struct {
     l2cap_state_t l2cap_state;
 #endif
 
+#ifdef ENABLE_L2CAP_WEIGHTED_SCHEDULING
+    // share of Controller buffers for outgoing L2CAP data, deficit of current round-robin round
+    uint8_t l2cap_scheduling_weight;
+    uint8_t l2cap_scheduling_deficit;
+    bool    l2cap_scheduling_low_latency;
+#endif
+
+#ifdef ENABLE_HCI_STATISTICS
+    hci_connection_statistics_t statistics;
+#endif
+
 } hci_connection_t;
 
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+/**
+ * Buffer provider for L2CAP packets that span multiple ACL fragments. Continuation fragments are
+ * written directly into the provided buffer instead of the per-connection recombination buffer.
+ */
+typedef struct {
+    /**
+     * @brief Called for first fragment of an L2CAP packet that is not complete
+     * @param con_handle
+     * @param cid L2CAP channel id
+     * @param payload_len of complete L2CAP packet without L2CAP header
+     * @param fragment with first part of payload, consumed by provider
+     * @param fragment_len
+     * @return buffer for remaining payload_len - fragment_len bytes or NULL to use recombination buffer
+     */
+    uint8_t * (*get_buffer)(hci_con_handle_t con_handle, uint16_t cid, uint16_t payload_len, const uint8_t * fragment, uint16_t fragment_len);
+    /**
+     * @brief Called when remaining payload has been written into provided buffer
+     */
+    void (*buffer_complete)(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer, uint16_t len);
+    /**
+     * @brief Called when reassembly into provided buffer failed or connection was closed
+     */
+    void (*buffer_aborted)(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer);
+} hci_acl_buffer_provider_t;
+#endif
+
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+typedef enum {
+    HCI_ISO_TYPE_CIS,
+    HCI_ISO_TYPE_BIS,
+} hci_iso_type_t;
+
+typedef enum {
+    // CIS configured in local CIG, not connected
+    HCI_ISO_STREAM_STATE_CONFIGURED,
+    // CIS requested by remote Central
+    HCI_ISO_STREAM_STATE_REQUESTED,
+    HCI_ISO_STREAM_STATE_W2_ACCEPT,
+    HCI_ISO_STREAM_STATE_W2_REJECT,
+    HCI_ISO_STREAM_STATE_W4_ESTABLISHED,
+    HCI_ISO_STREAM_STATE_ESTABLISHED,
+} hci_iso_stream_state_t;
+
+// pending LE Setup ISO Data Path commands
+#define HCI_ISO_DATA_PATH_SETUP_INPUT  0x01
+#define HCI_ISO_DATA_PATH_SETUP_OUTPUT 0x02
+
+// max size of ISO Data Load header: time stamp, packet sequence number, ISO SDU length
+#define HCI_ISO_DATA_LOAD_HEADER_SIZE 8
+
+typedef struct {
+    btstack_linked_item_t item;
+
+    hci_iso_type_t iso_type;
+    hci_iso_stream_state_t state;
+    hci_con_handle_t con_handle;
+    // CIG ID or BIG Handle
+    uint8_t group_id;
+    // ACL connection for CIS
+    hci_con_handle_t acl_con_handle;
+
+    uint8_t data_path_setup_todo;
+    // LE Setup ISO Data Path sent, waiting for Command Complete
+    bool    data_path_setup_active;
+
+    // outgoing SDU, sent in fragments of iso_data_packet_length
+    const uint8_t * tx_sdu;
+    uint16_t tx_sdu_len;
+    uint16_t tx_sdu_pos;
+    uint32_t tx_time_stamp;
+    bool     tx_time_stamp_valid;
+    uint16_t tx_sequence_number;
+    bool     tx_can_send_now_requested;
+
+    // ISO packets sent but not completed by Controller
+    uint8_t num_packets_sent;
+
+    // incoming SDU reassembled as complete HCI ISO Data packet
+    uint8_t  rx_buffer[HCI_ISO_HEADER_SIZE + HCI_ISO_DATA_LOAD_HEADER_SIZE + HCI_ISO_SDU_MAX_SIZE];
+    uint16_t rx_pos;
+    bool     rx_discard;
+} hci_iso_stream_t;
+#endif
+
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+/**
+ * Request to send a HCI Command via the HCI Command Queue, see hci_send_cmd_queued
+ */
+typedef struct hci_command_request {
+    btstack_linked_item_t item;
+    // complete HCI Command packet, has to stay valid until callback was called
+    uint8_t * packet;
+    uint16_t  size;
+    /**
+     * @brief Called with Command Complete or Command Status event, or with event == NULL
+     *        if the command was not sent or the stack was reset before it completed
+     */
+    void (*callback)(struct hci_command_request * request, const uint8_t * event, uint16_t size);
+    void * context;
+} hci_command_request_t;
+#endif
+
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+// last report per address, content identified by hash over event type and data
+typedef struct {
+    bd_addr_t address;
+    uint8_t   address_type;
+    bool      valid;
+    uint32_t  content_hash;
+    uint32_t  timestamp_ms;
+} le_advertising_report_dedup_entry_t;
+#endif
+
 
 /** 
  * HCI Inititizlization State Machine
@@ -600,6 +1034,8 @@ typedef enum hci_init_state{
     HCI_INIT_W4_CUSTOM_INIT_CSR_WARM_BOOT,
     HCI_INIT_W4_CUSTOM_INIT_CSR_WARM_BOOT_LINK_RESET,
     HCI_INIT_W4_CUSTOM_INIT_BCM_DELAY,
+    HCI_INIT_W4_CUSTOM_INIT_PIPELINE_DRAIN,
+    HCI_INIT_CUSTOM_INIT_DONE,
 
     HCI_INIT_READ_LOCAL_SUPPORTED_COMMANDS,
     HCI_INIT_W4_READ_LOCAL_SUPPORTED_COMMANDS,
@@ -663,6 +1099,10 @@ typedef enum hci_init_state{
 #ifdef ENABLE_BLE
     HCI_INIT_LE_READ_BUFFER_SIZE,
     HCI_INIT_W4_LE_READ_BUFFER_SIZE,
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    HCI_INIT_LE_SET_HOST_FEATURE,
+    HCI_INIT_W4_LE_SET_HOST_FEATURE,
+#endif
     HCI_INIT_WRITE_LE_HOST_SUPPORTED,
     HCI_INIT_W4_WRITE_LE_HOST_SUPPORTED,
     HCI_INIT_LE_SET_EVENT_MASK,
@@ -699,6 +1139,14 @@ typedef enum hci_init_state{
 
 } hci_substate_t;
 
+// phases reported by BTSTACK_EVENT_INIT_PROFILE
+typedef enum {
+    HCI_INIT_PROFILE_PHASE_RESET = 0,
+    HCI_INIT_PROFILE_PHASE_BAUD_CHANGE,
+    HCI_INIT_PROFILE_PHASE_CUSTOM_INIT,
+    HCI_INIT_PROFILE_PHASE_CONFIGURATION,
+} hci_init_profile_phase_t;
+
 enum {
     LE_ADVERTISEMENT_TASKS_DISABLE       = 1 << 0,
     LE_ADVERTISEMENT_TASKS_SET_ADV_DATA  = 1 << 1,
@@ -707,6 +1155,12 @@ enum {
     LE_ADVERTISEMENT_TASKS_ENABLE        = 1 << 4,
 };
 
+enum {
+    GAP_CLASSIC_TASK_WRITE_PAGE_TIMEOUT       = 1 << 0,
+    GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_ACTIVITY = 1 << 1,
+    GAP_CLASSIC_TASK_WRITE_PAGE_SCAN_TYPE     = 1 << 2,
+};
+
 enum {
     LE_WHITELIST_ON_CONTROLLER          = 1 << 0,
     LE_WHITELIST_ADD_TO_CONTROLLER      = 1 << 1,
@@ -720,6 +1174,51 @@ typedef struct {
     uint8_t        state;   
 } whitelist_entry_t;
 
+typedef struct {
+    bd_addr_t address;          // in HCI byte order
+    uint8_t   inquiry_id;       // of last inquiry the device was reported in
+    uint8_t   name_len;         // 0 = no name
+    bool      name_complete;    // name from Complete Local Name and not truncated
+    uint16_t  last_seen;
+    uint8_t   name[GAP_INQUIRY_MAX_NAME_LEN];
+} gap_inquiry_cache_entry_t;
+
+typedef struct {
+    bd_addr_t address;
+    uint32_t  last_seen_ms;
+    // adapted page timeout in 0.625 ms units
+    uint16_t  page_timeout;
+    // from inquiry results, bit 15 set if valid
+    uint16_t  clock_offset;
+    uint8_t   page_scan_repetition_mode;
+    // -128 if not known
+    int8_t    rssi;
+    // consecutive page timeouts
+    uint8_t   failures;
+    bool      in_use;
+    bool      reconnect;
+    bool      reconnect_attempted;
+} gap_paging_history_entry_t;
+
+typedef enum {
+    LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION,
+    LE_RESOLVING_LIST_READ_SIZE,
+    LE_RESOLVING_LIST_SEND_CLEAR,
+    LE_RESOLVING_LIST_ADD_ENTRIES,
+    LE_RESOLVING_LIST_DONE
+} le_resolving_list_state_t;
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+// traffic classes for outgoing data, in order of priority
+typedef enum {
+    HCI_TRAFFIC_CLASS_VOICE = 0,        // isochronous voice, active while SCO connection exists
+    HCI_TRAFFIC_CLASS_MEDIA,            // e.g. A2DP media
+    HCI_TRAFFIC_CLASS_INTERACTIVE,      // e.g. ATT and SM, active while LE connection exists
+    HCI_TRAFFIC_CLASS_BULK,             // default
+    HCI_TRAFFIC_CLASS_NUM
+} hci_traffic_class_t;
+#endif
+
 /**
  * main data structure
  */
@@ -740,12 +1239,37 @@ typedef struct {
     // list of existing baseband connections
     btstack_linked_list_t     connections;
 
+#ifdef ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+    // direct-mapped caches for hci_connection_for_handle and hci_connection_for_bd_addr_and_type
+    hci_connection_t *        connection_for_handle[HCI_CONNECTION_HANDLE_TABLE_SIZE];
+    hci_connection_t *        connection_for_address[HCI_CONNECTION_ADDRESS_TABLE_SIZE];
+#endif
+
+    // round robin for per-connection commands in hci_run
+    hci_con_handle_t          pending_commands_last_handle;
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+    // ACL buffers reserved per traffic class, number of registered channels per class for Classic and LE
+    uint8_t                   qos_acl_reserved[HCI_TRAFFIC_CLASS_NUM];
+    uint8_t                   qos_num_channels[2][HCI_TRAFFIC_CLASS_NUM];
+#endif
+
     /* callback to L2CAP layer */
     btstack_packet_handler_t acl_packet_handler;
 
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+    /* buffers for fragmented L2CAP packets */
+    const hci_acl_buffer_provider_t * acl_buffer_provider;
+#endif
+
     /* callback for SCO data */
     btstack_packet_handler_t sco_packet_handler;
 
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    /* callback for ISO data */
+    btstack_packet_handler_t iso_packet_handler;
+#endif
+
     /* callbacks for events */
     btstack_linked_list_t event_handlers;
 
@@ -776,6 +1300,18 @@ typedef struct {
     uint16_t           link_supervision_timeout;
     gap_security_level_t gap_security_level;
 #endif
+#ifdef ENABLE_CLASSIC_AUTO_SNIFF_MODE
+    // 0 = off
+    uint32_t           auto_sniff_idle_timeout_ms;
+    uint16_t           auto_sniff_min_interval;
+    uint16_t           auto_sniff_max_interval;
+    uint16_t           auto_sniff_attempt;
+    uint16_t           auto_sniff_timeout;
+    // 0 = don't configure sniff subrating
+    uint16_t           auto_sniff_subrating_max_latency;
+    uint16_t           auto_sniff_subrating_min_remote_timeout;
+    uint16_t           auto_sniff_subrating_min_local_timeout;
+#endif
 
     // single buffer for HCI packet assembly + additional prebuffer for H4 drivers
     uint8_t   * hci_packet_buffer;
@@ -797,6 +1333,15 @@ typedef struct {
     uint8_t  sco_waiting_for_can_send_now;
     uint8_t  sco_can_send_now;
 
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+    uint8_t  iso_packets_total_num;
+    uint16_t iso_data_packet_length;
+    btstack_linked_list_t iso_streams;
+    btstack_linked_list_t le_audio_cigs;
+    btstack_linked_list_t le_audio_bigs;
+    btstack_linked_list_t le_audio_big_syncs;
+#endif
+
     /* local supported features */
     uint8_t local_supported_features[8];
 
@@ -811,6 +1356,10 @@ typedef struct {
     /* 7 - Read Encryption Key Size                (Octet 20/bit 4) */
     /* 8 - Read Remote Extended Features           (Octet  2/bit 5) */
     /* 9 - Write Secure Connections Host           (Octet 32/bit 3) */
+    /* 10 - LE Set Extended Scan Parameters        (Octet 37/bit 5) */
+    /* 11 - LE Add Device To Resolving List        (Octet 34/bit 3) */
+    /* 12 - LE Read Buffer Size v2                 (Octet 41/bit 5) */
+    /* 13 - LE Set Host Feature                    (Octet 44/bit 0) */
     uint8_t local_supported_commands[2];
 
     /* bluetooth device information from hci read local version information */
@@ -832,6 +1381,27 @@ typedef struct {
 
     uint16_t  last_cmd_opcode;
 
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+    // requests in order, head is in flight if command_queue_sent is set
+    btstack_linked_queue_t command_queue;
+    bool      command_queue_sent;
+    uint16_t  command_queue_opcode;
+#endif
+
+#ifdef ENABLE_HCI_INIT_SCRIPT_PIPELINING
+    // Num_HCI_Command_Packets as reported by Controller, init script commands without Command Complete
+    uint8_t   init_script_num_cmd_packets;
+    uint8_t   init_script_cmds_outstanding;
+#endif
+
+#ifdef ENABLE_HCI_INIT_PROFILING
+    uint8_t   init_profile_phase;
+    uint32_t  init_profile_timestamp_ms;
+    uint32_t  init_profile_phase_ms[4];
+    uint16_t  init_profile_num_custom_init_commands;
+    uint32_t  init_profile_step_timestamp_ms;
+#endif
+
     uint8_t   cmds_ready;
 
     /* buffer for scan enable cmd - 0xff no change */
@@ -843,6 +1413,32 @@ typedef struct {
 
     uint8_t   inquiry_state;    // see hci.c for state defines
 
+#ifdef ENABLE_GAP_INQUIRY_RESULT_CACHE
+    gap_inquiry_cache_entry_t gap_inquiry_cache[GAP_INQUIRY_RESULT_CACHE_SIZE];
+    uint8_t   gap_inquiry_id;
+    uint16_t  gap_inquiry_cache_time;
+#endif
+
+    uint16_t  page_timeout;
+    uint16_t  page_scan_interval;
+    uint16_t  page_scan_window;
+    uint8_t   page_scan_type;
+    uint8_t   gap_classic_tasks;
+
+#ifdef ENABLE_GAP_CLASSIC_ADAPTIVE_PAGING
+    gap_paging_history_entry_t gap_paging_history[GAP_PAGING_HISTORY_SIZE];
+    // Create Connection deferred until Write Page Timeout with adapted page timeout is complete
+    uint8_t   gap_paging_create_connection[HCI_CMD_HEADER_SIZE + 13];
+    uint8_t   gap_paging_write_page_timeout[HCI_CMD_HEADER_SIZE + 2];
+    bool      gap_paging_create_connection_deferred;
+    uint16_t  gap_paging_page_timeout_active;
+    bd_addr_t gap_paging_addr;
+    bool      gap_paging_active;
+    uint32_t  gap_paging_start_ms;
+    btstack_timer_source_t gap_reconnect_timer;
+    bool      gap_reconnect_timer_active;
+#endif
+
     bd_addr_t remote_name_addr;
     uint16_t  remote_name_clock_offset;
     uint8_t   remote_name_page_scan_repetition_mode;
@@ -867,6 +1463,10 @@ typedef struct {
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     uint8_t   host_completed_packets;
 #endif
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL_COALESCING
+    uint16_t  host_completed_packets_pending;
+    btstack_timer_source_t host_completed_packets_timer;
+#endif
 
 #ifdef ENABLE_BLE
     uint8_t   le_own_addr_type;
@@ -885,6 +1485,22 @@ typedef struct {
     uint16_t le_scan_interval;  
     uint16_t le_scan_window;
 
+#ifdef ENABLE_LE_EXTENDED_SCANNING
+    // 0 = use legacy scan commands
+    uint8_t  le_scan_phys;
+    bool     le_extended_scanning_active;
+    // GAP_EVENT_EXTENDED_ADVERTISING_REPORT under reassembly
+    bool     le_extended_advertising_report_active;
+    bool     le_extended_advertising_report_truncated;
+    uint8_t  le_extended_advertising_report_data_len;
+    uint8_t  le_extended_advertising_report[2 + 24 + GAP_LE_EXTENDED_ADVERTISING_REPORT_DATA_SIZE];
+#endif
+
+#ifdef ENABLE_GAP_LE_ADVERTISING_REPORT_FILTER
+    const gap_le_advertising_report_filter_t * le_advertising_report_filter;
+    le_advertising_report_dedup_entry_t le_advertising_report_dedup_table[GAP_LE_ADVERTISING_REPORT_DEDUP_TABLE_SIZE];
+#endif
+
     // LE Whitelist Management
     uint8_t               le_whitelist_capacity;
     btstack_linked_list_t le_whitelist;
@@ -902,6 +1518,23 @@ typedef struct {
 
     le_connection_parameter_range_t le_connection_parameter_range;
 
+#ifdef ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+    le_resolving_list_state_t le_resolving_list_state;
+    uint8_t  le_resolving_list_size;
+    uint8_t  le_resolving_list_num_entries;
+    // bitmaps of LE Device DB entries to add and already on Controller
+    uint8_t  le_resolving_list_add_entries[(MAX_NUM_RESOLVING_LIST_ENTRIES + 7) / 8];
+    uint8_t  le_resolving_list_entries_on_controller[(MAX_NUM_RESOLVING_LIST_ENTRIES + 7) / 8];
+#endif
+
+#ifdef ENABLE_LE_CONNECTION_PARAMETER_PROFILES
+    // indexed by gap_le_connection_profile_t - 1
+    le_connection_profile_parameters_t le_connection_profile_parameters[3];
+#endif
+
+    // requested connection intervals are aligned to multiples of this value, 0 = no alignment
+    uint16_t le_connection_interval_alignment;
+
 #ifdef ENABLE_LE_PERIPHERAL
     uint8_t  * le_advertisements_data;
     uint8_t    le_advertisements_data_len;
@@ -930,6 +1563,10 @@ typedef struct {
     uint16_t le_supported_max_tx_time;
 #endif
 
+#ifdef ENABLE_LE_LINK_UPGRADE
+    gap_le_link_upgrade_mode_t le_link_upgrade_mode;
+#endif
+
     // custom BD ADDR
     bd_addr_t custom_bd_addr; 
     uint8_t   custom_bd_addr_set;
@@ -941,6 +1578,14 @@ typedef struct {
     // address and address_type of active create connection command (ACL, SCO, LE)
     bd_addr_t      outgoing_addr;
     bd_addr_type_t outgoing_addr_type;
+
+#ifdef ENABLE_HCI_STATISTICS
+    hci_statistics_t       statistics;
+    // start of current credit starvation period, 0 if ACL buffers available
+    uint32_t               acl_credit_starvation_start_ms[2];
+    btstack_timer_source_t statistics_report_timer;
+    uint32_t               statistics_report_interval_ms;
+#endif
 } hci_stack_t;
 
 
@@ -1012,7 +1657,7 @@ void hci_close(void);
 
 
 /**
- * @brief Add event packet handler. 
+ * @brief Add event packet handler. Set event_filter in registration to skip events the handler isn't interested in
  */
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler);
 
@@ -1021,11 +1666,27 @@ void hci_add_event_handler(btstack_packet_callback_registration_t * callback_han
  */
 void hci_register_acl_packet_handler(btstack_packet_handler_t handler);
 
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+/**
+ * @brief Registers a provider for buffers that fragmented L2CAP packets are reassembled into. Used by L2CAP
+ */
+void hci_register_acl_buffer_provider(const hci_acl_buffer_provider_t * provider);
+#endif
+
 /**
  * @brief Registers a packet handler for SCO data. Used for HSP and HFP profiles.
  */
 void hci_register_sco_packet_handler(btstack_packet_handler_t handler);
 
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+/**
+ * @brief Registers a packet handler for ISO data and HCI_EVENT_ISO_CAN_SEND_NOW.
+ * @note Fragmented SDUs are reassembled and delivered as a single HCI ISO Data packet with
+ *       Packet Boundary flag = complete SDU
+ */
+void hci_register_iso_packet_handler(btstack_packet_handler_t handler);
+#endif
+
 
 // Sending HCI Commands
 
@@ -1039,6 +1700,20 @@ int hci_can_send_command_packet_now(void);
  */
 int hci_send_cmd(const hci_cmd_t *cmd, ...);
 
+#ifdef ENABLE_HCI_COMMAND_QUEUE
+/**
+ * @brief Creates HCI command packet in buffer and adds it to HCI Command Queue. Queued commands are sent one at a time
+ *        as soon as the Controller accepts a command, and request->callback is called with the Command Complete or
+ *        Command Status event of each command. On power off or reset, callbacks of all queued requests are called
+ *        with event == NULL.
+ * @param request with callback and context set
+ * @param buffer of size HCI_CMD_HEADER_SIZE + command parameters, has to stay valid until callback was called
+ * @param cmd
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_COMMAND_DISALLOWED if request is already queued or HCI is not working
+ */
+uint8_t hci_send_cmd_queued(hci_command_request_t * request, uint8_t * buffer, const hci_cmd_t *cmd, ...);
+#endif
+
 
 // Sending SCO Packets
 
@@ -1071,6 +1746,31 @@ int hci_can_send_prepared_sco_packet_now(void);
 int hci_send_sco_packet_buffer(int size);
 
 
+#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS
+// Sending ISO SDUs
+
+/**
+ * @brief Request emission of HCI_EVENT_ISO_CAN_SEND_NOW to ISO packet handler as soon as
+ *        the previous SDU of the CIS or BIS has been sent and the Controller has a free ISO buffer
+ * @param con_handle of CIS or BIS
+ * @return status
+ */
+uint8_t hci_request_iso_can_send_now_event(hci_con_handle_t con_handle);
+
+/**
+ * @brief Send ISO SDU over established CIS or BIS. SDUs larger than the Controller ISO buffers are
+ *        fragmented. The Packet Sequence Number is incremented for each SDU.
+ * @param con_handle
+ * @param sdu has to stay valid until HCI_EVENT_ISO_CAN_SEND_NOW or the stream was closed
+ * @param sdu_len
+ * @param time_stamp_valid
+ * @param time_stamp in us, Controller clock
+ * @return status
+ */
+uint8_t hci_send_iso_sdu(hci_con_handle_t con_handle, const uint8_t * sdu, uint16_t sdu_len, bool time_stamp_valid, uint32_t time_stamp);
+#endif
+
+
 // Outgoing packet buffer, also used for SCO packets
 // see hci_can_send_prepared_sco_packet_now amn hci_send_sco_packet_buffer
 
@@ -1097,6 +1797,30 @@ void hci_release_packet_buffer(void);
 */
 void hci_set_master_slave_policy(uint8_t policy);
 
+/**
+ * @brief Get HCI flow control and buffer statistics. Requires ENABLE_HCI_STATISTICS
+ * @return statistics
+ */
+const hci_statistics_t * hci_get_statistics(void);
+
+/**
+ * @brief Get ACL statistics for connection. Requires ENABLE_HCI_STATISTICS
+ * @param con_handle
+ * @return statistics or NULL if connection does not exist
+ */
+const hci_connection_statistics_t * hci_get_connection_statistics(hci_con_handle_t con_handle);
+
+/**
+ * @brief Reset HCI and connection statistics. Requires ENABLE_HCI_STATISTICS
+ */
+void hci_reset_statistics(void);
+
+/**
+ * @brief Emit HCI_EVENT_CONNECTION_STATISTICS for each ACL connection periodically. Requires ENABLE_HCI_STATISTICS
+ * @param interval_ms or 0 to disable
+ */
+void hci_set_statistics_report_interval(uint32_t interval_ms);
+
 /* API_END */
 
 
@@ -1105,6 +1829,14 @@ void hci_set_master_slave_policy(uint8_t policy);
  */
 int hci_send_cmd_va_arg(const hci_cmd_t *cmd, va_list argtr);
 
+/**
+ * Send HCI Command created in outgoing packet buffer, e.g. with hci_cmd_create_* from hci_cmd_builder.h.
+ * Requires hci_can_send_command_packet_now and hci_reserve_packet_buffer
+ * @param size of command packet
+ * @return 0 if command was successfully sent to HCI Transport layer
+ */
+int hci_send_prepared_cmd_packet(uint16_t size);
+
 /**
  * Get connection iterator. Only used by l2cap.c and sm.c
  */
@@ -1150,6 +1882,12 @@ int hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle);
  */
 int hci_send_acl_packet_buffer(int size);
 
+/**
+ * Send acl packet given by list of buffers, iov[0] starts with ACL header incl. length
+ * buffers need to stay valid until HCI_EVENT_TRANSPORT_PACKET_SENT, falls back to copy into hci packet buffer if transport does not support scatter-gather
+ */
+int hci_send_acl_iov(const btstack_iovec_t * iov, uint16_t iov_count);
+
 /**
  * Check if authentication is active. It delays automatic disconnect while no L2CAP connection
  * Called by l2cap.
@@ -1212,6 +1950,36 @@ void hci_disconnect_all(void);
  */
 int hci_number_free_acl_slots_for_handle(hci_con_handle_t con_handle);
 
+#ifdef ENABLE_HCI_QOS_ARBITER
+/**
+ * @brief Set number of Controller ACL buffers that are kept free for a traffic class while it is active.
+ * @note Traffic of lower priority classes can only use the remaining buffers
+ * @param traffic_class
+ * @param num_acl_packets
+ */
+void hci_qos_set_acl_reservation(hci_traffic_class_t traffic_class, uint8_t num_acl_packets);
+
+/**
+ * @brief Register/unregister channel with traffic class, called by L2CAP
+ * @param address_type of connection
+ * @param traffic_class
+ */
+void hci_qos_register_traffic_class(bd_addr_type_t address_type, hci_traffic_class_t traffic_class);
+void hci_qos_unregister_traffic_class(bd_addr_type_t address_type, hci_traffic_class_t traffic_class);
+
+/**
+ * Check hci packet buffer is free and an acl packet for the given handle and traffic class can be sent to controller
+ * without using buffers reserved for active higher priority traffic classes
+ */
+int hci_qos_can_send_acl_packet_now(hci_con_handle_t con_handle, hci_traffic_class_t traffic_class);
+
+/**
+ * Check hci packet buffer is free and an LE acl packet of the given traffic class can be sent to controller
+ * without using buffers reserved for active higher priority traffic classes
+ */
+int hci_qos_can_send_acl_le_packet_now(hci_traffic_class_t traffic_class);
+#endif
+
 /**
  * @brief Set Advertisement Parameters
  * @param adv_int_min
@@ -1233,6 +2001,18 @@ void hci_le_advertisements_set_params(uint16_t adv_int_min, uint16_t adv_int_max
  */
 void hci_le_set_own_address_type(uint8_t own_address_type);
 
+/**
+ * @brief Add LE Device DB entry to Resolving List after it was added or its IRK was updated
+ * @note internal use by sm.c, requires ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+ */
+void hci_load_le_device_db_entry_into_resolving_list(uint16_t le_device_db_index);
+
+/**
+ * @brief Remove LE Device DB entry from Resolving List, to be called after the entry was removed
+ * @note internal use by sm.c, requires ENABLE_LE_CONTROLLER_ADDRESS_RESOLUTION
+ */
+void hci_remove_le_device_db_entry_from_resolving_list(uint16_t le_device_db_index);
+
 /**
  * @brief Get Manufactured
  * @return manufacturer id
@@ -575,6 +575,16 @@ const hci_cmd_t hci_write_default_link_policy_setting = {
     OPCODE(OGF_LINK_POLICY, 0x0F), "2"
 };
 
+/**
+ * @param handle
+ * @param max_latency
+ * @param min_remote_timeout
+ * @param min_local_timeout
+ */
+const hci_cmd_t hci_sniff_subrating = {
+OPCODE(OGF_LINK_POLICY, 0x11), "H222"
+};
+
 
 /**
  *  Controller & Baseband Commands 
@@ -701,6 +711,14 @@ const hci_cmd_t hci_write_class_of_device = {
 OPCODE(OGF_CONTROLLER_BASEBAND, 0x24), "3"
 };
 
+/**
+ * @param handle
+ * @param flush_timeout (0x0000 = no automatic flush, 0x0001 - 0x07FF Time -> Range: 0.625ms - 1279.375 ms)
+ */
+const hci_cmd_t hci_write_automatic_flush_timeout = {
+OPCODE(OGF_CONTROLLER_BASEBAND, 0x28), "H2"
+};
+
 /** 
  */
 const hci_cmd_t hci_read_num_broadcast_retransmissions = {
@@ -797,6 +815,13 @@ const hci_cmd_t hci_write_inquiry_mode = {
 OPCODE(OGF_CONTROLLER_BASEBAND, 0x45), "1"
 };
 
+/**
+ * @param page_scan_type (0x00 = standard, 0x01 = interlaced)
+ */
+const hci_cmd_t hci_write_page_scan_type = {
+OPCODE(OGF_CONTROLLER_BASEBAND, 0x47), "1"
+};
+
 /**
  * @param fec_required
  * @param exstended_inquiry_response
@@ -1274,6 +1299,48 @@ OPCODE(OGF_LE_CONTROLLER, 0x26), "QQ"
 // LE Generate DHKey Complete is generated on completion
 };
 
+/**
+ * @param peer_identity_address_type
+ * @param peer_identity_address
+ * @param peer_irk (little endian)
+ * @param local_irk (little endian)
+ */
+const hci_cmd_t hci_le_add_device_to_resolving_list = {
+OPCODE(OGF_LE_CONTROLLER, 0x27), "1BPP"
+// return: status
+};
+
+/**
+ * @param peer_identity_address_type
+ * @param peer_identity_address
+ */
+const hci_cmd_t hci_le_remove_device_from_resolving_list = {
+OPCODE(OGF_LE_CONTROLLER, 0x28), "1B"
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_clear_resolving_list = {
+OPCODE(OGF_LE_CONTROLLER, 0x29), ""
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_resolving_list_size = {
+OPCODE(OGF_LE_CONTROLLER, 0x2A), ""
+// return: status, resolving list size
+};
+
+/**
+ * @param address_resolution_enable
+ */
+const hci_cmd_t hci_le_set_address_resolution_enable = {
+OPCODE(OGF_LE_CONTROLLER, 0x2D), "1"
+// return: status
+};
+
 /**
  */
 const hci_cmd_t hci_le_read_maximum_data_length = {
@@ -1311,6 +1378,173 @@ OPCODE(OGF_LE_CONTROLLER, 0x32), "H1111"
 // LE PHY Update Complete is generated on completion
 };
 
+/**
+ * @note only single PHY supported by BTstack command generator
+ * @param own_address_type
+ * @param scanning_filter_policy
+ * @param scanning_phys (LE 1M PHY (0x01) or LE Coded PHY (0x04))
+ * @param scan_type (passive (0), active (1))
+ * @param scan_interval ([0x0004,0xffff], unit: 0.625 msec)
+ * @param scan_window   ([0x0004,0xffff], unit: 0.625 msec)
+ */
+const hci_cmd_t hci_le_set_extended_scan_parameters = {
+OPCODE(OGF_LE_CONTROLLER, 0x41), "111122"
+// return: status
+};
+
+/**
+ * @param enable (off: 0, on: 1)
+ * @param filter_duplicates (disabled (0), enabled (1), enabled and reset for each scan period (2))
+ * @param duration (0 = scan continuously, unit: 10 msec)
+ * @param period (0 = scan continuously, unit: 1.28 sec)
+ */
+const hci_cmd_t hci_le_set_extended_scan_enable = {
+OPCODE(OGF_LE_CONTROLLER, 0x42), "1122"
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_buffer_size_v2 = {
+OPCODE(OGF_LE_CONTROLLER, 0x60), ""
+// return: status, le acl data packet length, total num le acl data packets, iso data packet length, total num iso data packets
+};
+
+/**
+ * @note arrays are not supported by BTstack command generator, parameters are created by hci.c
+ * @param cig_id
+ * @param sdu_interval_c_to_p
+ * @param sdu_interval_p_to_c
+ * @param worst_case_sca
+ * @param packing
+ * @param framing
+ * @param max_transport_latency_c_to_p
+ * @param max_transport_latency_p_to_c
+ * @param cis_count
+ */
+const hci_cmd_t hci_le_set_cig_parameters = {
+OPCODE(OGF_LE_CONTROLLER, 0x62), "1331122"
+// return: status, cig_id, cis_count, cis connection handles
+};
+
+/**
+ * @note arrays are not supported by BTstack command generator, parameters are created by hci.c
+ * @param cis_count
+ */
+const hci_cmd_t hci_le_create_cis = {
+OPCODE(OGF_LE_CONTROLLER, 0x64), "1"
+// LE CIS Established is generated on completion
+};
+
+/**
+ * @param cig_id
+ */
+const hci_cmd_t hci_le_remove_cig = {
+OPCODE(OGF_LE_CONTROLLER, 0x65), "1"
+// return: status, cig_id
+};
+
+/**
+ * @param cis_con_handle
+ */
+const hci_cmd_t hci_le_accept_cis_request = {
+OPCODE(OGF_LE_CONTROLLER, 0x66), "H"
+// LE CIS Established is generated on completion
+};
+
+/**
+ * @param cis_con_handle
+ * @param reason
+ */
+const hci_cmd_t hci_le_reject_cis_request = {
+OPCODE(OGF_LE_CONTROLLER, 0x67), "H1"
+// return: status, cis connection handle
+};
+
+/**
+ * @param big_handle
+ * @param advertising_handle
+ * @param num_bis
+ * @param sdu_interval
+ * @param max_sdu
+ * @param max_transport_latency
+ * @param rtn
+ * @param phy
+ * @param packing
+ * @param framing
+ * @param encryption
+ * @param broadcast_code
+ */
+const hci_cmd_t hci_le_create_big = {
+OPCODE(OGF_LE_CONTROLLER, 0x68), "11132211111P"
+// LE Create BIG Complete is generated on completion
+};
+
+/**
+ * @param big_handle
+ * @param reason
+ */
+const hci_cmd_t hci_le_terminate_big = {
+OPCODE(OGF_LE_CONTROLLER, 0x6A), "11"
+// LE Terminate BIG Complete is generated on completion
+};
+
+/**
+ * @note arrays are not supported by BTstack command generator, parameters are created by hci.c
+ * @param big_handle
+ * @param sync_handle
+ * @param encryption
+ * @param broadcast_code
+ * @param mse
+ * @param big_sync_timeout
+ * @param num_bis
+ */
+const hci_cmd_t hci_le_big_create_sync = {
+OPCODE(OGF_LE_CONTROLLER, 0x6B), "1H1P121"
+// LE BIG Sync Established is generated on completion
+};
+
+/**
+ * @param big_handle
+ */
+const hci_cmd_t hci_le_big_terminate_sync = {
+OPCODE(OGF_LE_CONTROLLER, 0x6C), "1"
+// return: status, big_handle
+};
+
+/**
+ * @param con_handle
+ * @param data_path_direction (input, host to controller (0), output, controller to host (1))
+ * @param data_path_id (HCI (0))
+ * @param coding_format
+ * @param company_id
+ * @param vendor_codec_id
+ * @param controller_delay (unit: us)
+ * @param codec_configuration_length
+ */
+const hci_cmd_t hci_le_setup_iso_data_path = {
+OPCODE(OGF_LE_CONTROLLER, 0x6E), "H1112231"
+// return: status, connection handle
+};
+
+/**
+ * @param con_handle
+ * @param data_path_direction (bit 0: input, bit 1: output)
+ */
+const hci_cmd_t hci_le_remove_iso_data_path = {
+OPCODE(OGF_LE_CONTROLLER, 0x6F), "H1"
+// return: status, connection handle
+};
+
+/**
+ * @param bit_number
+ * @param bit_value
+ */
+const hci_cmd_t hci_le_set_host_feature = {
+OPCODE(OGF_LE_CONTROLLER, 0x74), "11"
+// return: status
+};
+
 
 #endif
 
@@ -145,12 +145,14 @@ extern const hci_cmd_t hci_set_controller_to_host_flow_control;
 extern const hci_cmd_t hci_set_event_mask;
 extern const hci_cmd_t hci_setup_synchronous_connection;
 extern const hci_cmd_t hci_sniff_mode;
+extern const hci_cmd_t hci_sniff_subrating;
 extern const hci_cmd_t hci_switch_role_command;
 extern const hci_cmd_t hci_user_confirmation_request_negative_reply;
 extern const hci_cmd_t hci_user_confirmation_request_reply;
 extern const hci_cmd_t hci_user_passkey_request_negative_reply;
 extern const hci_cmd_t hci_user_passkey_request_reply;
 extern const hci_cmd_t hci_write_authentication_enable;
+extern const hci_cmd_t hci_write_automatic_flush_timeout;
 extern const hci_cmd_t hci_write_class_of_device;
 extern const hci_cmd_t hci_write_current_iac_lap_two_iacs;
 extern const hci_cmd_t hci_write_default_erroneous_data_reporting;
@@ -167,6 +169,7 @@ extern const hci_cmd_t hci_write_num_broadcast_retransmissions;
 extern const hci_cmd_t hci_write_page_timeout;
 extern const hci_cmd_t hci_write_pin_type;
 extern const hci_cmd_t hci_write_page_scan_activity;
+extern const hci_cmd_t hci_write_page_scan_type;
 extern const hci_cmd_t hci_write_scan_enable;
 extern const hci_cmd_t hci_write_secure_connections_host_support;
 extern const hci_cmd_t hci_write_secure_connections_test_mode;
@@ -174,10 +177,17 @@ extern const hci_cmd_t hci_write_simple_pairing_debug_mode;
 extern const hci_cmd_t hci_write_simple_pairing_mode;
 extern const hci_cmd_t hci_write_synchronous_flow_control_enable;
 
+extern const hci_cmd_t hci_le_add_device_to_resolving_list;
 extern const hci_cmd_t hci_le_add_device_to_white_list;
+extern const hci_cmd_t hci_le_accept_cis_request;
+extern const hci_cmd_t hci_le_big_create_sync;
+extern const hci_cmd_t hci_le_big_terminate_sync;
+extern const hci_cmd_t hci_le_clear_resolving_list;
 extern const hci_cmd_t hci_le_clear_white_list;
 extern const hci_cmd_t hci_le_connection_update;
 extern const hci_cmd_t hci_le_create_connection;
+extern const hci_cmd_t hci_le_create_big;
+extern const hci_cmd_t hci_le_create_cis;
 extern const hci_cmd_t hci_le_create_connection_cancel;
 extern const hci_cmd_t hci_le_encrypt;
 extern const hci_cmd_t hci_le_generate_dhkey;
@@ -186,11 +196,13 @@ extern const hci_cmd_t hci_le_long_term_key_request_reply;
 extern const hci_cmd_t hci_le_rand;
 extern const hci_cmd_t hci_le_read_advertising_channel_tx_power;
 extern const hci_cmd_t hci_le_read_buffer_size ;
+extern const hci_cmd_t hci_le_read_buffer_size_v2;
 extern const hci_cmd_t hci_le_read_channel_map;
 extern const hci_cmd_t hci_le_read_local_p256_public_key;
 extern const hci_cmd_t hci_le_read_maximum_data_length;
 extern const hci_cmd_t hci_le_read_phy;
 extern const hci_cmd_t hci_le_read_remote_used_features;
+extern const hci_cmd_t hci_le_read_resolving_list_size;
 extern const hci_cmd_t hci_le_read_suggested_default_data_length;
 extern const hci_cmd_t hci_le_read_supported_features;
 extern const hci_cmd_t hci_le_read_supported_states;
@@ -198,20 +210,31 @@ extern const hci_cmd_t hci_le_read_white_list_size;
 extern const hci_cmd_t hci_le_receiver_test;
 extern const hci_cmd_t hci_le_remote_connection_parameter_request_negative_reply;
 extern const hci_cmd_t hci_le_remote_connection_parameter_request_reply;
+extern const hci_cmd_t hci_le_reject_cis_request;
+extern const hci_cmd_t hci_le_remove_cig;
+extern const hci_cmd_t hci_le_remove_device_from_resolving_list;
 extern const hci_cmd_t hci_le_remove_device_from_white_list;
+extern const hci_cmd_t hci_le_remove_iso_data_path;
+extern const hci_cmd_t hci_le_set_address_resolution_enable;
 extern const hci_cmd_t hci_le_set_advertise_enable;
 extern const hci_cmd_t hci_le_set_advertising_data;
 extern const hci_cmd_t hci_le_set_advertising_parameters;
+extern const hci_cmd_t hci_le_set_cig_parameters;
 extern const hci_cmd_t hci_le_set_data_length;
 extern const hci_cmd_t hci_le_set_default_phy;
 extern const hci_cmd_t hci_le_set_event_mask;
+extern const hci_cmd_t hci_le_set_extended_scan_enable;
+extern const hci_cmd_t hci_le_set_extended_scan_parameters;
+extern const hci_cmd_t hci_le_set_host_feature;
 extern const hci_cmd_t hci_le_set_host_channel_classification;
 extern const hci_cmd_t hci_le_set_phy;
 extern const hci_cmd_t hci_le_set_random_address;
 extern const hci_cmd_t hci_le_set_scan_enable;
 extern const hci_cmd_t hci_le_set_scan_parameters;
 extern const hci_cmd_t hci_le_set_scan_response_data;
+extern const hci_cmd_t hci_le_setup_iso_data_path;
 extern const hci_cmd_t hci_le_start_encryption;
+extern const hci_cmd_t hci_le_terminate_big;
 extern const hci_cmd_t hci_le_test_end;
 extern const hci_cmd_t hci_le_transmitter_test;
 extern const hci_cmd_t hci_le_write_suggested_default_data_length;
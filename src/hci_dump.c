@@ -68,6 +68,33 @@
 #include <sys/stat.h>     // for mode flags
 #endif
 
+#ifdef HAVE_POSIX_FILE_IO
+// max length of log file path incl. segment suffix for rotating log
+#ifndef HCI_DUMP_MAX_PATH_LEN
+#define HCI_DUMP_MAX_PATH_LEN 128
+#endif
+#endif
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+#ifndef HAVE_POSIX_FILE_IO
+#error "ENABLE_HCI_DUMP_ASYNC requires HAVE_POSIX_FILE_IO"
+#endif
+#include <pthread.h>
+#include <string.h>
+
+// ring buffer between BTstack thread and writer thread, needs to be power of two
+#ifndef HCI_DUMP_ASYNC_BUFFER_SIZE
+#define HCI_DUMP_ASYNC_BUFFER_SIZE 65536
+#endif
+#if (HCI_DUMP_ASYNC_BUFFER_SIZE & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1)) != 0
+#error "HCI_DUMP_ASYNC_BUFFER_SIZE must be a power of two"
+#endif
+
+#ifndef HCI_DUMP_ASYNC_FLUSH_INTERVAL_MS
+#define HCI_DUMP_ASYNC_FLUSH_INTERVAL_MS 10
+#endif
+#endif
+
 #ifdef ENABLE_SEGGER_RTT
 #include "SEGGER_RTT.h"
 
@@ -84,6 +111,31 @@
 #endif
 
 static char segger_rtt_packetlog_buffer[SEGGER_RTT_PACKETLOG_BUFFER_SIZE];
+
+#ifdef ENABLE_LOG_DEFERRED
+// binary log records for tool/decode_deferred_log.py, records are skipped if buffer is full
+#ifndef SEGGER_RTT_DEFERRED_LOG_BUFFER_SIZE
+#define SEGGER_RTT_DEFERRED_LOG_BUFFER_SIZE 1024
+#endif
+#ifndef SEGGER_RTT_DEFERRED_LOG_CHANNEL
+#define SEGGER_RTT_DEFERRED_LOG_CHANNEL 2
+#endif
+static char segger_rtt_deferred_log_buffer[SEGGER_RTT_DEFERRED_LOG_BUFFER_SIZE];
+static bool segger_rtt_deferred_log_configured;
+#endif
+#endif
+
+#ifdef ENABLE_LOG_DEFERRED
+#ifndef ENABLE_SEGGER_RTT
+#error "ENABLE_LOG_DEFERRED requires ENABLE_SEGGER_RTT"
+#endif
+#include <string.h>
+#ifndef HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE
+#define HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE 128
+#endif
+#if HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE > 255
+#error "HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE must not exceed 255"
+#endif
 #endif
 
 // BLUEZ hcidump - struct not used directly, but left here as documentation
@@ -114,6 +166,11 @@ static int dump_format;
 static char time_string[40];
 static int  max_nr_packets = -1;
 static int  nr_packets = 0;
+// rotating log: dump_path is current segment, older segments have suffix .1 to .(num_segments-1)
+static char     dump_path[HCI_DUMP_MAX_PATH_LEN];
+static uint8_t  rotation_num_segments;
+static uint32_t rotation_max_segment_size;
+static uint32_t segment_size;
 #endif
 
 #if defined(HAVE_POSIX_FILE_IO) || defined (ENABLE_SEGGER_RTT)
@@ -123,6 +180,80 @@ static char log_message_buffer[256];
 // levels: debug, info, error
 static int log_level_enabled[3] = { 1, 1, 1};
 
+#ifdef ENABLE_HCI_DUMP_ASYNC
+// single producer (BTstack thread), single consumer (writer thread), positions wrap around at 2^32
+static uint8_t   hci_dump_async_buffer[HCI_DUMP_ASYNC_BUFFER_SIZE];
+static uint32_t  hci_dump_async_write_pos;
+static uint32_t  hci_dump_async_read_pos;
+static bool      hci_dump_async_running;
+static pthread_t hci_dump_async_thread;
+// packets dropped since last note in log and in total
+static uint32_t  hci_dump_async_dropped;
+static uint32_t  hci_dump_async_dropped_total;
+
+static void hci_dump_async_start(void);
+static void hci_dump_async_stop(void);
+#endif
+
+#ifdef HAVE_POSIX_FILE_IO
+static int hci_dump_open_file(const char * filename){
+    int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef _WIN32
+    oflags |= O_BINARY;
+#endif
+    return open(filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+}
+
+static void hci_dump_segment_path(char * buffer, uint16_t buffer_size, int segment){
+    if (segment == 0){
+        (void)snprintf(buffer, buffer_size, "%s", dump_path);
+    } else {
+        (void)snprintf(buffer, buffer_size, "%s.%u", dump_path, segment);
+    }
+}
+
+// start new segment, oldest segment is overwritten
+static void hci_dump_rotate(void){
+    char from[HCI_DUMP_MAX_PATH_LEN + 4];
+    char to[HCI_DUMP_MAX_PATH_LEN + 4];
+    int segment;
+    for (segment = rotation_num_segments - 1; segment > 0; segment--){
+        hci_dump_segment_path(from, sizeof(from), segment - 1);
+        hci_dump_segment_path(to,   sizeof(to),   segment);
+        // older segments might not exist yet
+        (void) rename(from, to);
+    }
+    close(dump_file);
+    dump_file = hci_dump_open_file(dump_path);
+}
+
+// @return true if log has to be truncated or rotated before writing record
+static bool hci_dump_file_restart_required(int max_packets, uint32_t record_len){
+    if (rotation_num_segments > 0){
+        return (segment_size > 0) && ((segment_size + record_len) > rotation_max_segment_size);
+    }
+    return (max_packets > 0) && (nr_packets >= max_packets);
+}
+
+static void hci_dump_file_restart(void){
+    if (rotation_num_segments > 0){
+        hci_dump_rotate();
+    } else {
+        lseek(dump_file, 0, SEEK_SET);
+        // avoid -Wunused-result
+        int res = ftruncate(dump_file, 0);
+        UNUSED(res);
+    }
+    nr_packets = 0;
+    segment_size = 0;
+}
+
+static void hci_dump_file_account(uint32_t record_len){
+    nr_packets++;
+    segment_size += record_len;
+}
+#endif
+
 void hci_dump_open(const char *filename, hci_dump_format_t format){
 
     dump_format = format;
@@ -132,14 +263,18 @@ void hci_dump_open(const char *filename, hci_dump_format_t format){
         dump_file = fileno(stdout);
     } else {
 
-        int oflags = O_WRONLY | O_CREAT | O_TRUNC;
-#ifdef _WIN32
-        oflags |= O_BINARY;
-#endif
-        dump_file = open(filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+        (void)snprintf(dump_path, sizeof(dump_path), "%s", filename);
+        nr_packets = 0;
+        segment_size = 0;
+        dump_file = hci_dump_open_file(filename);
         if (dump_file < 0){
             printf("hci_dump_open: failed to open file %s\n", filename);
         }
+#ifdef ENABLE_HCI_DUMP_ASYNC
+        else {
+            hci_dump_async_start();
+        }
+#endif
     }
 #else
 
@@ -162,7 +297,17 @@ void hci_dump_open(const char *filename, hci_dump_format_t format){
 
 #ifdef HAVE_POSIX_FILE_IO
 void hci_dump_set_max_packets(int packets){
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    // used by writer thread
+    __atomic_store_n(&max_nr_packets, packets, __ATOMIC_RELAXED);
+#else
     max_nr_packets = packets;
+#endif
+}
+
+void hci_dump_set_rotation(uint32_t max_segment_size, uint8_t num_segments){
+    rotation_max_segment_size = max_segment_size;
+    rotation_num_segments = (max_segment_size > 0) ? num_segments : 0;
 }
 #endif
 
@@ -181,6 +326,9 @@ static void hci_dump_packetlogger_setup_header(uint8_t * buffer, uint32_t tv_sec
         case HCI_SCO_DATA_PACKET:
             packet_logger_type = in ? 0x09 : 0x08;
             break;
+        case HCI_ISO_DATA_PACKET:
+            packet_logger_type = in ? 0x0d : 0x0c;
+            break;
         case HCI_EVENT_PACKET:
             packet_logger_type = 0x01;
             break;
@@ -202,6 +350,162 @@ static void hci_dump_bluez_setup_header(uint8_t * buffer, uint32_t tv_sec, uint3
     buffer[12] = packet_type;
 }
 
+// @return header len, 0 for stdout format
+static uint16_t hci_dump_setup_header(uint8_t * buffer, uint32_t tv_sec, uint32_t tv_us, uint8_t packet_type, uint8_t in, uint16_t len){
+    switch (dump_format){
+        case HCI_DUMP_BLUEZ:
+            hci_dump_bluez_setup_header(buffer, tv_sec, tv_us, packet_type, in, len);
+            return HCIDUMP_HDR_SIZE;
+        case HCI_DUMP_PACKETLOGGER:
+            hci_dump_packetlogger_setup_header(buffer, tv_sec, tv_us, packet_type, in, len);
+            return PKTLOG_HDR_SIZE;
+        default:
+            return 0;
+    }
+}
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+
+static void hci_dump_async_store(uint32_t pos, const uint8_t * data, uint32_t len){
+    uint32_t offset = pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1);
+    uint32_t bytes_to_end = HCI_DUMP_ASYNC_BUFFER_SIZE - offset;
+    if (len <= bytes_to_end){
+        (void)memcpy(&hci_dump_async_buffer[offset], data, len);
+    } else {
+        (void)memcpy(&hci_dump_async_buffer[offset], data, bytes_to_end);
+        (void)memcpy(&hci_dump_async_buffer[0], &data[bytes_to_end], len - bytes_to_end);
+    }
+}
+
+// called on BTstack thread, header and packet are stored as one record or dropped
+static bool hci_dump_async_enqueue(const uint8_t * header, uint16_t header_len, const uint8_t * packet, uint16_t len){
+    uint32_t write_pos = hci_dump_async_write_pos;
+    uint32_t read_pos  = __atomic_load_n(&hci_dump_async_read_pos, __ATOMIC_ACQUIRE);
+    uint32_t bytes_free = HCI_DUMP_ASYNC_BUFFER_SIZE - (write_pos - read_pos);
+    if (((uint32_t) header_len + len) > bytes_free) return false;
+    hci_dump_async_store(write_pos, header, header_len);
+    hci_dump_async_store(write_pos + header_len, packet, len);
+    __atomic_store_n(&hci_dump_async_write_pos, write_pos + header_len + len, __ATOMIC_RELEASE);
+    return true;
+}
+
+// @return false if note could not be stored
+static bool hci_dump_async_report_dropped(uint32_t tv_sec, uint32_t tv_us){
+    if (hci_dump_async_dropped == 0) return true;
+    uint8_t note_header[PKTLOG_HDR_SIZE];
+    char note[50];
+    int note_len = snprintf(note, sizeof(note), "hci_dump: %u packet(s) dropped", (unsigned int) hci_dump_async_dropped);
+    uint16_t note_header_len = hci_dump_setup_header(note_header, tv_sec, tv_us, LOG_MESSAGE_PACKET, 0, (uint16_t) note_len);
+    if (!hci_dump_async_enqueue(note_header, note_header_len, (const uint8_t *) note, (uint16_t) note_len)) return false;
+    hci_dump_async_dropped = 0;
+    return true;
+}
+
+static void hci_dump_async_packet(uint32_t tv_sec, uint32_t tv_us, const uint8_t * header, uint16_t header_len, const uint8_t * packet, uint16_t len){
+    // report dropped packets before next packet
+    if (!hci_dump_async_report_dropped(tv_sec, tv_us) || !hci_dump_async_enqueue(header, header_len, packet, len)){
+        hci_dump_async_dropped++;
+        hci_dump_async_dropped_total++;
+    }
+}
+
+// total size of record at pos from length field in BlueZ or PacketLogger header
+static uint32_t hci_dump_async_record_len(uint32_t pos){
+    uint8_t header[4];
+    int i;
+    for (i=0;i<4;i++){
+        header[i] = hci_dump_async_buffer[(pos + i) & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1)];
+    }
+    if (dump_format == HCI_DUMP_BLUEZ){
+        return (HCIDUMP_HDR_SIZE - 1) + little_endian_read_16(header, 0);
+    } else {
+        return 4 + big_endian_read_32(header, 0);
+    }
+}
+
+static void hci_dump_async_write(uint32_t pos, uint32_t len){
+    while (len > 0){
+        uint32_t offset = pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1);
+        uint32_t chunk  = btstack_min(len, HCI_DUMP_ASYNC_BUFFER_SIZE - offset);
+        ssize_t res = write(dump_file, &hci_dump_async_buffer[offset], chunk);
+        // drop rest of chunk on error
+        if (res <= 0){
+            res = chunk;
+        }
+        pos += (uint32_t) res;
+        len -= (uint32_t) res;
+    }
+}
+
+// called on writer thread, writes all complete records in one or two write calls
+static void hci_dump_async_flush(void){
+    uint32_t read_pos  = hci_dump_async_read_pos;
+    uint32_t write_pos = __atomic_load_n(&hci_dump_async_write_pos, __ATOMIC_ACQUIRE);
+    if (read_pos == write_pos) return;
+
+    int max_packets = __atomic_load_n(&max_nr_packets, __ATOMIC_RELAXED);
+    if ((max_packets <= 0) && (rotation_num_segments == 0)){
+        hci_dump_async_write(read_pos, write_pos - read_pos);
+    } else {
+        // don't grow bigger than max_nr_packets or max segment size
+        uint32_t batch_pos = read_pos;
+        uint32_t pos = read_pos;
+        while (pos != write_pos){
+            uint32_t record_len = hci_dump_async_record_len(pos);
+            if (hci_dump_file_restart_required(max_packets, record_len)){
+                hci_dump_async_write(batch_pos, pos - batch_pos);
+                batch_pos = pos;
+                hci_dump_file_restart();
+            }
+            pos += record_len;
+            hci_dump_file_account(record_len);
+        }
+        hci_dump_async_write(batch_pos, pos - batch_pos);
+    }
+    __atomic_store_n(&hci_dump_async_read_pos, write_pos, __ATOMIC_RELEASE);
+}
+
+static void * hci_dump_async_writer(void * context){
+    UNUSED(context);
+    const struct timespec interval = {
+        .tv_sec  = HCI_DUMP_ASYNC_FLUSH_INTERVAL_MS / 1000,
+        .tv_nsec = (HCI_DUMP_ASYNC_FLUSH_INTERVAL_MS % 1000) * 1000000L
+    };
+    while (__atomic_load_n(&hci_dump_async_running, __ATOMIC_ACQUIRE)){
+        hci_dump_async_flush();
+        nanosleep(&interval, NULL);
+    }
+    hci_dump_async_flush();
+    return NULL;
+}
+
+static void hci_dump_async_start(void){
+    hci_dump_async_write_pos = 0;
+    hci_dump_async_read_pos  = 0;
+    hci_dump_async_dropped   = 0;
+    hci_dump_async_running = true;
+    if (pthread_create(&hci_dump_async_thread, NULL, &hci_dump_async_writer, NULL) != 0){
+        // fallback to synchronous writes
+        hci_dump_async_running = false;
+    }
+}
+
+static void hci_dump_async_stop(void){
+    if (!hci_dump_async_running) return;
+    __atomic_store_n(&hci_dump_async_running, false, __ATOMIC_RELEASE);
+    pthread_join(hci_dump_async_thread, NULL);
+    // writer thread has emptied ring buffer, report packets dropped since last packet
+    struct timeval curr_time;
+    gettimeofday(&curr_time, NULL);
+    (void) hci_dump_async_report_dropped(curr_time.tv_sec, curr_time.tv_usec);
+    hci_dump_async_flush();
+}
+
+uint32_t hci_dump_get_dropped_packets(void){
+    return hci_dump_async_dropped_total;
+}
+#endif
+
 static void printf_packet(uint8_t packet_type, uint8_t in, uint8_t * packet, uint16_t len){
     switch (packet_type){
         case HCI_COMMAND_DATA_PACKET:
@@ -224,6 +528,13 @@ static void printf_packet(uint8_t packet_type, uint8_t in, uint8_t * packet, uin
                 printf("SCO => ");
             }
             break;
+        case HCI_ISO_DATA_PACKET:
+            if (in) {
+                printf("ISO <= ");
+            } else {
+                printf("ISO => ");
+            }
+            break;
         case LOG_MESSAGE_PACKET:
             printf("LOG -- %s\n", (char*) packet);
             return;
@@ -271,20 +582,6 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
 
     if (dump_file < 0) return; // not activated yet
 
-#ifdef HAVE_POSIX_FILE_IO
-    // don't grow bigger than max_nr_packets
-    if (dump_format != HCI_DUMP_STDOUT && max_nr_packets > 0){
-        if (nr_packets >= max_nr_packets){
-            lseek(dump_file, 0, SEEK_SET);
-            // avoid -Wunused-result
-            int res = ftruncate(dump_file, 0);
-            UNUSED(res);
-            nr_packets = 0;
-        }
-        nr_packets++;
-    }
-#endif
-
     if (dump_format == HCI_DUMP_STDOUT){
         printf_timestamp();
         printf_packet(packet_type, in, packet, len);
@@ -320,21 +617,24 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
 #endif
 #endif
 
-    uint16_t header_len = 0;
-    switch (dump_format){
-        case HCI_DUMP_BLUEZ:
-            hci_dump_bluez_setup_header(header.header_bluez, tv_sec, tv_us, packet_type, in, len);
-            header_len = HCIDUMP_HDR_SIZE;
-            break;
-        case HCI_DUMP_PACKETLOGGER:
-            hci_dump_packetlogger_setup_header(header.header_packetlogger, tv_sec, tv_us, packet_type, in, len);
-            header_len = PKTLOG_HDR_SIZE;
-            break;
-        default:
-            return;
+    uint16_t header_len = hci_dump_setup_header((uint8_t *) &header, tv_sec, tv_us, packet_type, in, len);
+    if (header_len == 0) return;
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    if (hci_dump_async_running){
+        hci_dump_async_packet(tv_sec, tv_us, (const uint8_t *) &header, header_len, packet, len);
+        return;
     }
+#endif
 
 #ifdef HAVE_POSIX_FILE_IO
+    // don't grow bigger than max_nr_packets or max segment size
+    if (hci_dump_file_restart_required(max_nr_packets, header_len + len)){
+        hci_dump_file_restart();
+        if (dump_file < 0) return;
+    }
+    hci_dump_file_account(header_len + len);
+
     // avoid -Wunused-result
     int res = 0;
     res = write (dump_file, &header, header_len);
@@ -359,6 +659,10 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
     UNUSED(header_len);
 }
 
+int hci_dump_active(void){
+    return dump_file >= 0;
+}
+
 static int hci_dump_log_level_active(int log_level){
     if (log_level < HCI_DUMP_LOG_LEVEL_DEBUG) return 0;
     if (log_level > HCI_DUMP_LOG_LEVEL_ERROR) return 0;
@@ -382,6 +686,141 @@ void hci_dump_log_va_arg(int log_level, const char * format, va_list argptr){
     printf("\n");
 }
 
+#ifdef ENABLE_LOG_DEFERRED
+
+static uint16_t hci_dump_log_deferred_store(uint8_t * buffer, uint16_t pos, const void * value, uint16_t size){
+    if ((pos + size) > HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE) return pos;
+    // arguments are stored in little endian
+#ifdef __BIG_ENDIAN__
+    uint16_t i;
+    for (i=0;i<size;i++){
+        buffer[pos + i] = ((const uint8_t *) value)[size - 1 - i];
+    }
+#else
+    (void)memcpy(&buffer[pos], value, size);
+#endif
+    return pos + size;
+}
+
+/*
+ * Record: len (1), log level (1), time ms (4), address of format string (sizeof(void*)), arguments
+ * Arguments are identified by scanning the format string without formatting:
+ * - integers: 4 bytes, 'l' sizeof(long), 'll'/'j' 8 bytes, 'z'/'t' sizeof(size_t), 'p' sizeof(void*)
+ * - floating point: 8 bytes
+ * - strings: len (1) + characters, truncated to fit into record
+ */
+void hci_dump_log_deferred(int log_level, const char * format, ...){
+    if (!hci_dump_log_level_active(log_level)) return;
+
+    if (!segger_rtt_deferred_log_configured){
+        SEGGER_RTT_ConfigUpBuffer(SEGGER_RTT_DEFERRED_LOG_CHANNEL, "btstack_log", &segger_rtt_deferred_log_buffer[0],
+                                  SEGGER_RTT_DEFERRED_LOG_BUFFER_SIZE, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+        segger_rtt_deferred_log_configured = true;
+    }
+
+    uint8_t record[HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE];
+    uint32_t time_ms = btstack_run_loop_get_time_ms();
+    uintptr_t format_address = (uintptr_t) format;
+    uint16_t pos = 1;
+    record[pos++] = (uint8_t) log_level;
+    pos = hci_dump_log_deferred_store(record, pos, &time_ms, 4);
+    pos = hci_dump_log_deferred_store(record, pos, &format_address, sizeof(format_address));
+
+    va_list argptr;
+    va_start(argptr, format);
+    const char * p = format;
+    while (*p){
+        if (*p++ != '%') continue;
+        if (*p == '%'){
+            p++;
+            continue;
+        }
+        // flags, width, precision
+        while ((*p != 0) && (strchr("-+ #0123456789.*", *p) != NULL)){
+            if (*p == '*'){
+                int value = va_arg(argptr, int);
+                pos = hci_dump_log_deferred_store(record, pos, &value, 4);
+            }
+            p++;
+        }
+        // length modifier
+        uint8_t int_size = 4;
+        uint8_t num_l = 0;
+        while ((*p != 0) && (strchr("hlLjzt", *p) != NULL)){
+            switch (*p){
+                case 'l':
+                    num_l++;
+                    int_size = (num_l == 1) ? sizeof(long) : 8;
+                    break;
+                case 'j':
+                case 'L':
+                    int_size = 8;
+                    break;
+                case 'z':
+                case 't':
+                    int_size = sizeof(size_t);
+                    break;
+                default:
+                    break;
+            }
+            p++;
+        }
+        if (*p == 0) break;
+        switch (*p++){
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+            case 'c':
+                if (int_size == 8){
+                    unsigned long long value = va_arg(argptr, unsigned long long);
+                    pos = hci_dump_log_deferred_store(record, pos, &value, 8);
+                } else if (int_size == sizeof(long)){
+                    unsigned long value = va_arg(argptr, unsigned long);
+                    pos = hci_dump_log_deferred_store(record, pos, &value, sizeof(long));
+                } else {
+                    unsigned int value = va_arg(argptr, unsigned int);
+                    pos = hci_dump_log_deferred_store(record, pos, &value, 4);
+                }
+                break;
+            case 'p': {
+                uintptr_t value = (uintptr_t) va_arg(argptr, void *);
+                pos = hci_dump_log_deferred_store(record, pos, &value, sizeof(value));
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                double value = va_arg(argptr, double);
+                pos = hci_dump_log_deferred_store(record, pos, &value, 8);
+                break;
+            }
+            case 's': {
+                const char * value = va_arg(argptr, const char *);
+                if (pos >= HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE) break;
+                uint16_t len = (uint16_t) btstack_min(strlen(value), HCI_DUMP_DEFERRED_LOG_MAX_RECORD_SIZE - pos - 1);
+                record[pos++] = (uint8_t) len;
+                (void)memcpy(&record[pos], value, len);
+                pos += len;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    va_end(argptr);
+
+    record[0] = (uint8_t) pos;
+    // skip record if buffer is full
+    SEGGER_RTT_Write(SEGGER_RTT_DEFERRED_LOG_CHANNEL, record, pos);
+}
+#endif
+
 void hci_dump_log(int log_level, const char * format, ...){
     va_list argptr;
     va_start(argptr, format);
@@ -402,6 +841,10 @@ void hci_dump_log_P(int log_level, PGM_P format, ...){
 #endif
 
 void hci_dump_close(void){
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    // write pending packets
+    hci_dump_async_stop();
+#endif
 #ifdef HAVE_POSIX_FILE_IO
     close(dump_file);
 #endif
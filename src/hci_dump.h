@@ -79,11 +79,32 @@ void hci_dump_open(const char *filename, hci_dump_format_t format);
  */
 void hci_dump_set_max_packets(int packets); // -1 for unlimited
 
+/*
+ * @brief Write BlueZ or PacketLogger log into rotating segments instead of truncating it. The current segment uses
+ *        the filename given to hci_dump_open, older segments get suffix .1 (most recent) to .(num_segments-1).
+ *        Replaces hci_dump_set_max_packets. Call before hci_dump_open.
+ * @param max_segment_size in bytes, 0 to disable rotation
+ * @param num_segments incl. current segment
+ */
+void hci_dump_set_rotation(uint32_t max_segment_size, uint8_t num_segments);
+
 /*
  * @brief 
  */
 void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len);
 
+/*
+ * @brief Get number of packets dropped as ring buffer towards writer thread was full. Requires ENABLE_HCI_DUMP_ASYNC
+ * @return number of dropped packets since start
+ */
+uint32_t hci_dump_get_dropped_packets(void);
+
+/*
+ * @brief Check if packet log has been opened
+ * @return 1 if packets are logged
+ */
+int hci_dump_active(void);
+
 /*
  * @brief 
  */
@@ -107,6 +128,9 @@ void hci_dump_close(void);
 
 void hci_dump_log_va_arg(int log_level, const char * format, va_list argtr);
 
+// store address of format string and raw arguments in binary log, requires ENABLE_LOG_DEFERRED
+void hci_dump_log_deferred(int log_level, const char * format, ...);
+
 #ifdef __AVR__
 void hci_dump_log_P(int log_level, PGM_P format, ...);
 #endif
@@ -58,6 +58,17 @@ extern "C" {
     
 /* API_START */
 
+// max number of buffers passed to send_packet_iov
+#ifndef HCI_TRANSPORT_IOV_MAX
+#define HCI_TRANSPORT_IOV_MAX 4
+#endif
+
+/* buffer descriptor for scatter-gather send */
+typedef struct {
+    const uint8_t * base;
+    uint16_t        len;
+} btstack_iovec_t;
+
 /* HCI packet types */
 typedef struct {
     /**
@@ -111,6 +122,12 @@ typedef struct {
      */
     void   (*set_sco_config)(uint16_t voice_setting, int num_connections);
 
+    /**
+     * optional: send packet given by up to HCI_TRANSPORT_IOV_MAX buffers without copying them into a single buffer
+     * iov array can be discarded after the call, buffers must stay valid until HCI_EVENT_TRANSPORT_PACKET_SENT
+     */
+    int    (*send_packet_iov)(uint8_t packet_type, const btstack_iovec_t * iov, uint16_t iov_count);
+
 } hci_transport_t;
 
 typedef enum {
@@ -139,6 +156,31 @@ typedef struct {
  */
 const hci_transport_t * hci_transport_h4_instance(const btstack_uart_block_t * uart_driver);
 
+typedef struct {
+    // sleep periods entered after GO_TO_SLEEP_ACK was sent
+    uint32_t num_sleeps;
+    // sleep periods ended by host or controller
+    uint32_t num_host_wakeups;
+    uint32_t num_controller_wakeups;
+    // sleep periods ended by controller within HCI_TRANSPORT_H4_EHCILL_SHORT_SLEEP_MS
+    uint32_t num_short_sleeps;
+    // GO_TO_SLEEP_IND cancelled by controller WAKE_UP_IND before GO_TO_SLEEP_ACK was sent
+    uint32_t num_sleeps_avoided;
+    // total time in sleep
+    uint32_t sleep_time_ms;
+    // host initiated wake-up: WAKE_UP_IND sent until WAKE_UP_IND/ACK received
+    uint32_t wake_latency_total_ms;
+    uint32_t wake_latency_max_ms;
+    // current delay between GO_TO_SLEEP_IND and GO_TO_SLEEP_ACK
+    uint16_t sleep_ack_delay_ms;
+} hci_transport_h4_ehcill_statistics_t;
+
+/*
+ * @brief Get eHCILL sleep statistics of H4 instance, requires ENABLE_EHCILL
+ * @return statistics
+ */
+const hci_transport_h4_ehcill_statistics_t * hci_transport_h4_ehcill_get_statistics(void);
+
 /*
  * @brief Setup H5 instance with uart_driver
  * @param uart_driver to use 
@@ -172,6 +214,13 @@ const hci_transport_t * hci_transport_usb_instance(void);
  */
 void hci_transport_usb_set_path(int len, uint8_t * port_numbers);
 
+/**
+ * @brief Set number of USB transfers queued for HCI Events and incoming ACL packets, call before hci_power_control
+ * @param num_event_in
+ * @param num_acl_in
+ */
+void hci_transport_usb_set_in_transfer_count(int num_event_in, int num_acl_in);
+
 /* API_END */
     
 #if defined __cplusplus
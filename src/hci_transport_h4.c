@@ -46,6 +46,7 @@
  */
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "btstack_config.h"
 
@@ -78,6 +79,7 @@ static void hci_transport_h4_ehcill_reset_statemachine(void);
 static void hci_transport_h4_ehcill_send_ehcill_command(void);
 static void hci_transport_h4_ehcill_sleep_ack_timer_setup(void);
 static void hci_transport_h4_ehcill_trigger_wakeup(void);
+static void hci_transport_h4_ehcill_shorten_sleep_ack_delay(void);
 
 typedef enum {
     EHCILL_STATE_W2_SEND_SLEEP_ACK,
@@ -95,6 +97,28 @@ static btstack_uart_sleep_mode_t btstack_uart_sleep_mode;
 // work around for eHCILL problem
 static btstack_timer_source_t ehcill_sleep_ack_timer;
 
+// adaptive delay before GO_TO_SLEEP_ACK: doubled if controller wakes up shortly after sleep, halved otherwise
+#ifndef HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS
+#define HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS 50
+#endif
+#ifndef HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MAX_MS
+#define HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MAX_MS 800
+#endif
+#ifndef HCI_TRANSPORT_H4_EHCILL_SHORT_SLEEP_MS
+#define HCI_TRANSPORT_H4_EHCILL_SHORT_SLEEP_MS 200
+#endif
+
+#if HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS > HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MAX_MS
+#error "HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS > HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MAX_MS"
+#endif
+
+static hci_transport_h4_ehcill_statistics_t ehcill_statistics;
+static uint32_t ehcill_sleep_ind_ms;
+static uint32_t ehcill_sleep_start_ms;
+static uint32_t ehcill_wakeup_start_ms;
+static int      ehcill_wakeup_pending;
+static int      ehcill_sleep_ack_timer_active;
+
 #endif
 
 
@@ -111,6 +135,7 @@ typedef enum {
     H4_W4_EVENT_HEADER,
     H4_W4_ACL_HEADER,
     H4_W4_SCO_HEADER,
+    H4_W4_ISO_HEADER,
     H4_W4_PAYLOAD,
 } H4_STATE;
 
@@ -118,6 +143,9 @@ typedef enum {
     TX_OFF,
     TX_IDLE,
     TX_W4_PACKET_SENT,
+#ifndef ENABLE_EHCILL
+    TX_W4_IOV_SENT,
+#endif
 #ifdef ENABLE_EHCILL
     TX_W4_WAKEUP, 
     TX_W2_EHCILL_SEND,
@@ -134,6 +162,12 @@ static TX_STATE tx_state;
 #ifdef ENABLE_EHCILL
 static uint8_t * ehcill_tx_data;
 static uint16_t  ehcill_tx_len;   // 0 == no outgoing packet
+#else
+// scatter-gather write state
+static uint8_t         tx_iov_packet_type;
+static btstack_iovec_t tx_iov[HCI_TRANSPORT_IOV_MAX];
+static uint16_t        tx_iov_count;
+static uint16_t        tx_iov_pos;
 #endif
 
 static  void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size) = dummy_handler;
@@ -161,6 +195,28 @@ static const uint8_t baud_rate_command_prefix[]   = { 0x01, 0x36, 0xff, 0x04};
 static const uint8_t baud_rate_command_prefix[]   = { 0x01, 0x18, 0xfc, 0x06};
 #endif
 
+#ifdef ENABLE_H4_RX_BATCH
+#ifdef ENABLE_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND
+#error "ENABLE_H4_RX_BATCH cannot be combined with the baudrate change flowcontrol bug workaround"
+#endif
+
+// size of batch receive buffer, needs to hold at least one complete packet
+#ifndef HCI_TRANSPORT_H4_RX_BUFFER_SIZE
+#define HCI_TRANSPORT_H4_RX_BUFFER_SIZE (2 * (HCI_INCOMING_PACKET_BUFFER_SIZE + 1))
+#endif
+
+#if HCI_TRANSPORT_H4_RX_BUFFER_SIZE < (HCI_INCOMING_PACKET_BUFFER_SIZE + 1)
+#error "HCI_TRANSPORT_H4_RX_BUFFER_SIZE too small - needs to hold packet type + HCI_INCOMING_PACKET_BUFFER_SIZE"
+#endif
+
+// batch receive buffer: bytes [rx_batch_pos, rx_batch_len) have been received but not processed yet
+static uint8_t  rx_batch_buffer_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_TRANSPORT_H4_RX_BUFFER_SIZE];
+static uint8_t * rx_batch_buffer = &rx_batch_buffer_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+static uint16_t rx_batch_pos;
+static uint16_t rx_batch_len;
+static int      rx_batch_active;
+#endif
+
 #ifdef ENABLE_BAUDRATE_CHANGE_FLOWCONTROL_BUG_WORKAROUND
 static const uint8_t local_version_event_prefix[] = { 0x04, 0x0e, 0x0c, 0x01, 0x01, 0x10};
 static enum {
@@ -241,6 +297,10 @@ static void hci_transport_h4_block_read(void){
                     bytes_to_read = HCI_SCO_HEADER_SIZE;
                     h4_state = H4_W4_SCO_HEADER;
                     break;
+                case HCI_ISO_DATA_PACKET:
+                    bytes_to_read = HCI_ISO_HEADER_SIZE;
+                    h4_state = H4_W4_ISO_HEADER;
+                    break;
 #ifdef ENABLE_EHCILL
                 case EHCILL_GO_TO_SLEEP_IND:
                 case EHCILL_GO_TO_SLEEP_ACK:
@@ -290,6 +350,17 @@ static void hci_transport_h4_block_read(void){
             h4_state = H4_W4_PAYLOAD;
             break;
 
+        case H4_W4_ISO_HEADER:
+            bytes_to_read = little_endian_read_16( hci_packet, 3) & 0x3fff;
+            // check ISO length
+            if (bytes_to_read > (HCI_INCOMING_PACKET_BUFFER_SIZE - HCI_ISO_HEADER_SIZE)){
+                log_error("hci_transport_h4: invalid ISO payload len %d - only space for %u", bytes_to_read, HCI_INCOMING_PACKET_BUFFER_SIZE - HCI_ISO_HEADER_SIZE);
+                hci_transport_h4_reset_statemachine();
+                break;
+            }
+            h4_state = H4_W4_PAYLOAD;
+            break;
+
         case H4_W4_PAYLOAD:
             hci_transport_h4_packet_complete();
             break;
@@ -318,11 +389,105 @@ static void hci_transport_h4_block_read(void){
     }
 }
 
+#ifdef ENABLE_H4_RX_BATCH
+static void hci_transport_h4_rx_batch_trigger_next_read(void){
+    // move incomplete packet to start of buffer
+    if (rx_batch_pos > 0){
+        rx_batch_len -= rx_batch_pos;
+        memmove(rx_batch_buffer, &rx_batch_buffer[rx_batch_pos], rx_batch_len);
+        rx_batch_pos = 0;
+    }
+    btstack_uart->receive_bytes(&rx_batch_buffer[rx_batch_len], HCI_TRANSPORT_H4_RX_BUFFER_SIZE - rx_batch_len);
+}
+
+static void hci_transport_h4_rx_batch_bytes_received(uint16_t num_bytes){
+
+    rx_batch_len += num_bytes;
+
+    // deliver all complete packets in place, stop if transport gets closed by packet handler
+    while ((h4_state != H4_OFF) && (rx_batch_pos < rx_batch_len)){
+        uint8_t * packet   = &rx_batch_buffer[rx_batch_pos];
+        uint16_t available = rx_batch_len - rx_batch_pos;
+        uint16_t header_size;
+        uint16_t payload_len = 0;
+        switch (packet[0]){
+            case HCI_EVENT_PACKET:
+                header_size = 1 + HCI_EVENT_HEADER_SIZE;
+                if (available < header_size) break;
+                payload_len = packet[2];
+                break;
+            case HCI_ACL_DATA_PACKET:
+                header_size = 1 + HCI_ACL_HEADER_SIZE;
+                if (available < header_size) break;
+                payload_len = little_endian_read_16(packet, 3);
+                break;
+            case HCI_SCO_DATA_PACKET:
+                header_size = 1 + HCI_SCO_HEADER_SIZE;
+                if (available < header_size) break;
+                payload_len = packet[3];
+                break;
+            case HCI_ISO_DATA_PACKET:
+                header_size = 1 + HCI_ISO_HEADER_SIZE;
+                if (available < header_size) break;
+                payload_len = little_endian_read_16(packet, 3) & 0x3fff;
+                break;
+#ifdef ENABLE_EHCILL
+            case EHCILL_GO_TO_SLEEP_IND:
+            case EHCILL_GO_TO_SLEEP_ACK:
+            case EHCILL_WAKE_UP_IND:
+            case EHCILL_WAKE_UP_ACK:
+                rx_batch_pos++;
+                hci_transport_h4_ehcill_handle_command(packet[0]);
+                continue;
+#endif
+            default:
+                log_error("hci_transport_h4: invalid packet type 0x%02x", packet[0]);
+                rx_batch_pos++;
+                continue;
+        }
+
+        // header incomplete
+        if (available < header_size) break;
+
+        // check packet length, skip packet type to resync
+        if ((header_size - 1 + payload_len) > HCI_INCOMING_PACKET_BUFFER_SIZE){
+            log_error("hci_transport_h4: invalid len %u for packet type 0x%02x", payload_len, packet[0]);
+            rx_batch_pos++;
+            continue;
+        }
+
+        // payload incomplete
+        if (available < (header_size + payload_len)) break;
+
+        // consume packet before delivering it to stack as it might close the transport
+        rx_batch_pos += header_size + payload_len;
+        packet_handler(packet[0], &packet[1], header_size - 1 + payload_len);
+    }
+
+    if (h4_state != H4_OFF) {
+        hci_transport_h4_rx_batch_trigger_next_read();
+    }
+}
+#endif
+
 static void hci_transport_h4_block_sent(void){
 
     static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
 
     switch (tx_state){
+#ifndef ENABLE_EHCILL
+        case TX_W4_IOV_SENT:
+            // send next non-empty buffer
+            while (tx_iov_pos < tx_iov_count){
+                const btstack_iovec_t * iov = &tx_iov[tx_iov_pos++];
+                if (iov->len == 0) continue;
+                btstack_uart->send_block(iov->base, iov->len);
+                return;
+            }
+            tx_state = TX_IDLE;
+            packet_handler(HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+            break;
+#endif
         case TX_W4_PACKET_SENT:
             // packet fully sent, reset state
 #ifdef ENABLE_EHCILL
@@ -352,6 +517,12 @@ static void hci_transport_h4_block_sent(void){
 
 static int hci_transport_h4_can_send_now(uint8_t packet_type){
     UNUSED(packet_type);
+#ifdef ENABLE_EHCILL
+    // HCI has a packet to send: don't block it longer than the minimal delay before GO_TO_SLEEP_ACK
+    if ((tx_state == TX_W2_EHCILL_SEND) && (ehcill_state == EHCILL_STATE_W2_SEND_SLEEP_ACK)){
+        hci_transport_h4_ehcill_shorten_sleep_ack_delay();
+    }
+#endif
     return tx_state == TX_IDLE;
 }
 
@@ -380,6 +551,8 @@ static int hci_transport_h4_send_packet(uint8_t packet_type, uint8_t * packet, i
             return 0;
         case EHCILL_STATE_W2_SEND_SLEEP_ACK:
             log_info("eHILL: send next packet, state EHCILL_STATE_W2_SEND_SLEEP_ACK");
+            // don't hold packet longer than the minimal delay, wake up follows GO_TO_SLEEP_ACK
+            hci_transport_h4_ehcill_shorten_sleep_ack_delay();
             return 0;
         default:
             break;    
@@ -392,6 +565,22 @@ static int hci_transport_h4_send_packet(uint8_t packet_type, uint8_t * packet, i
     return 0;
 }
 
+#ifndef ENABLE_EHCILL
+static int hci_transport_h4_send_packet_iov(uint8_t packet_type, const btstack_iovec_t * iov, uint16_t iov_count){
+    if (iov_count > HCI_TRANSPORT_IOV_MAX) return -1;
+
+    // send packet type first, then buffers from hci_transport_h4_block_sent
+    tx_iov_packet_type = packet_type;
+    (void)memcpy(tx_iov, iov, iov_count * sizeof(btstack_iovec_t));
+    tx_iov_count = iov_count;
+    tx_iov_pos   = 0;
+
+    tx_state = TX_W4_IOV_SENT;
+    btstack_uart->send_block(&tx_iov_packet_type, 1);
+    return 0;
+}
+#endif
+
 static void hci_transport_h4_init(const void * transport_config){
     // check for hci_transport_config_uart_t
     if (!transport_config) {
@@ -417,6 +606,14 @@ static void hci_transport_h4_init(const void * transport_config){
     btstack_uart->init(&uart_config);
     btstack_uart->set_block_received(&hci_transport_h4_block_read);
     btstack_uart->set_block_sent(&hci_transport_h4_block_sent);
+#ifdef ENABLE_H4_RX_BATCH
+    // use batched reads if supported by UART driver
+    rx_batch_active = btstack_uart->receive_bytes != NULL;
+    if (rx_batch_active){
+        btstack_uart->set_bytes_received(&hci_transport_h4_rx_batch_bytes_received);
+    }
+    log_info("hci_transport_h4: batched reads %s", rx_batch_active ? "active" : "not supported by UART driver");
+#endif
 }
 
 static int hci_transport_h4_open(void){
@@ -428,7 +625,17 @@ static int hci_transport_h4_open(void){
 
     // init rx + tx state machines
     hci_transport_h4_reset_statemachine();
+#ifdef ENABLE_H4_RX_BATCH
+    if (rx_batch_active){
+        rx_batch_pos = 0;
+        rx_batch_len = 0;
+        hci_transport_h4_rx_batch_trigger_next_read();
+    } else {
+        hci_transport_h4_trigger_next_read();
+    }
+#else
     hci_transport_h4_trigger_next_read();
+#endif
     tx_state = TX_IDLE;
 
 #ifdef ENABLE_EHCILL
@@ -482,8 +689,49 @@ static void hci_transport_h4_ehcill_wakeup_handler(void){
     hci_transport_h4_ehcill_handle_command(EHCILL_WAKEUP_SIGNAL);
 }
 
+const hci_transport_h4_ehcill_statistics_t * hci_transport_h4_ehcill_get_statistics(void){
+    return &ehcill_statistics;
+}
+
+static void hci_transport_h4_ehcill_sleep_ended(int by_controller){
+    uint32_t duration_ms = btstack_run_loop_get_time_ms() - ehcill_sleep_start_ms;
+    ehcill_statistics.sleep_time_ms += duration_ms;
+    if (!by_controller){
+        ehcill_statistics.num_host_wakeups++;
+        return;
+    }
+    ehcill_statistics.num_controller_wakeups++;
+
+    // controller had traffic shortly after going to sleep: keep it awake longer next time
+    uint16_t delay_ms = ehcill_statistics.sleep_ack_delay_ms;
+    if (duration_ms < HCI_TRANSPORT_H4_EHCILL_SHORT_SLEEP_MS){
+        ehcill_statistics.num_short_sleeps++;
+        delay_ms = btstack_min(delay_ms * 2, HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MAX_MS);
+    } else {
+        delay_ms = btstack_max(delay_ms / 2, HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS);
+    }
+    if (delay_ms != ehcill_statistics.sleep_ack_delay_ms){
+#ifdef ENABLE_LOG_EHCILL
+        log_info("eHCILL: slept %"PRIu32" ms, sleep ack delay %u ms", duration_ms, delay_ms);
+#endif
+        ehcill_statistics.sleep_ack_delay_ms = delay_ms;
+    }
+}
+
+static void hci_transport_h4_ehcill_wakeup_complete(void){
+    if (!ehcill_wakeup_pending) return;
+    ehcill_wakeup_pending = 0;
+    uint32_t latency_ms = btstack_run_loop_get_time_ms() - ehcill_wakeup_start_ms;
+    ehcill_statistics.wake_latency_total_ms += latency_ms;
+    ehcill_statistics.wake_latency_max_ms = btstack_max(ehcill_statistics.wake_latency_max_ms, latency_ms);
+}
+
 static void hci_transport_h4_ehcill_open(void){
     hci_transport_h4_ehcill_reset_statemachine();
+    memset(&ehcill_statistics, 0, sizeof(ehcill_statistics));
+    ehcill_statistics.sleep_ack_delay_ms = HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS;
+    ehcill_wakeup_pending = 0;
+    ehcill_sleep_ack_timer_active = 0;
 
     // find best sleep mode to use: wake on CTS, wake on RX, none
     btstack_uart_sleep_mode = BTSTACK_UART_SLEEP_OFF;
@@ -512,6 +760,8 @@ static void hci_transport_h4_echill_send_wakeup_ind(void){
     // update state
     tx_state     = TX_W4_WAKEUP;
     ehcill_state = EHCILL_STATE_W4_WAKEUP_IND_OR_ACK;
+    ehcill_wakeup_start_ms = btstack_run_loop_get_time_ms();
+    ehcill_wakeup_pending  = 1;
     ehcill_command_to_send = EHCILL_WAKE_UP_IND;
     btstack_uart->send_block(&ehcill_command_to_send, 1);
 }
@@ -531,6 +781,8 @@ static void hci_transport_h4_ehcill_send_ehcill_command(void){
     tx_state = TX_W4_EHCILL_SENT;
     if (ehcill_command_to_send == EHCILL_GO_TO_SLEEP_ACK){
         ehcill_state = EHCILL_STATE_SLEEP;
+        ehcill_sleep_start_ms = btstack_run_loop_get_time_ms();
+        ehcill_statistics.num_sleeps++;
     }
     btstack_uart->send_block(&ehcill_command_to_send, 1);
 }
@@ -540,6 +792,7 @@ static void hci_transport_h4_ehcill_sleep_ack_timer_handler(btstack_timer_source
 #ifdef ENABLE_LOG_EHCILL
     log_info("eHCILL: timer triggered");
 #endif
+    ehcill_sleep_ack_timer_active = 0;
     hci_transport_h4_ehcill_send_ehcill_command();
 }
 
@@ -549,7 +802,21 @@ static void hci_transport_h4_ehcill_sleep_ack_timer_setup(void){
     log_info("eHCILL: set timer for sending command %02x", ehcill_command_to_send);
 #endif
     btstack_run_loop_set_timer_handler(&ehcill_sleep_ack_timer, &hci_transport_h4_ehcill_sleep_ack_timer_handler);
-    btstack_run_loop_set_timer(&ehcill_sleep_ack_timer, 50);
+    btstack_run_loop_set_timer(&ehcill_sleep_ack_timer, ehcill_statistics.sleep_ack_delay_ms);
+    btstack_run_loop_add_timer(&ehcill_sleep_ack_timer);
+    ehcill_sleep_ack_timer_active = 1;
+}
+
+static void hci_transport_h4_ehcill_shorten_sleep_ack_delay(void){
+    if (!ehcill_sleep_ack_timer_active) return;
+    if (ehcill_statistics.sleep_ack_delay_ms <= HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS) return;
+    uint32_t elapsed_ms = btstack_run_loop_get_time_ms() - ehcill_sleep_ind_ms;
+    uint32_t remaining_ms = 0;
+    if (elapsed_ms < HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS){
+        remaining_ms = HCI_TRANSPORT_H4_EHCILL_SLEEP_ACK_DELAY_MIN_MS - elapsed_ms;
+    }
+    btstack_run_loop_remove_timer(&ehcill_sleep_ack_timer);
+    btstack_run_loop_set_timer(&ehcill_sleep_ack_timer, remaining_ms);
     btstack_run_loop_add_timer(&ehcill_sleep_ack_timer);
 }
 
@@ -565,6 +832,7 @@ static void hci_transport_h4_ehcill_trigger_wakeup(void){
             break;
     }
     // UART needed again
+    hci_transport_h4_ehcill_sleep_ended(0);
     hci_transport_h4_ehcill_emit_sleep_state(0);
     if (btstack_uart_sleep_mode){
         btstack_uart->set_sleep(BTSTACK_UART_SLEEP_OFF);
@@ -600,6 +868,7 @@ static void hci_transport_h4_ehcill_handle_command(uint8_t action){
             switch(action){
                 case EHCILL_GO_TO_SLEEP_IND:
                     ehcill_state = EHCILL_STATE_W2_SEND_SLEEP_ACK;
+                    ehcill_sleep_ind_ms = btstack_run_loop_get_time_ms();
 #ifdef ENABLE_LOG_EHCILL
                     log_info("eHCILL: Received GO_TO_SLEEP_IND RX");
 #endif
@@ -614,6 +883,15 @@ static void hci_transport_h4_ehcill_handle_command(uint8_t action){
             switch(action){
                 case EHCILL_WAKE_UP_IND:
                     ehcill_state = EHCILL_STATE_AWAKE;
+                    ehcill_statistics.num_sleeps_avoided++;
+                    // GO_TO_SLEEP_ACK not sent yet, answer with WAKE_UP_ACK right away
+                    if (ehcill_sleep_ack_timer_active){
+                        btstack_run_loop_remove_timer(&ehcill_sleep_ack_timer);
+                        ehcill_sleep_ack_timer_active = 0;
+                        if (tx_state == TX_W2_EHCILL_SEND){
+                            tx_state = TX_IDLE;
+                        }
+                    }
                     hci_transport_h4_ehcill_emit_sleep_state(0);
                     if (btstack_uart_sleep_mode){
                         btstack_uart->set_sleep(BTSTACK_UART_SLEEP_OFF);
@@ -639,6 +917,7 @@ static void hci_transport_h4_ehcill_handle_command(uint8_t action){
                     break;
                 case EHCILL_WAKE_UP_IND:
                     ehcill_state = EHCILL_STATE_AWAKE;
+                    hci_transport_h4_ehcill_sleep_ended(1);
                     hci_transport_h4_ehcill_emit_sleep_state(0);
                     if (btstack_uart_sleep_mode){
                         btstack_uart->set_sleep(BTSTACK_UART_SLEEP_OFF);
@@ -661,6 +940,7 @@ static void hci_transport_h4_ehcill_handle_command(uint8_t action){
 #ifdef ENABLE_LOG_EHCILL
                     log_info("eHCILL: Received WAKE_UP (%02x)", action);
 #endif
+                    hci_transport_h4_ehcill_wakeup_complete();
                     tx_state = TX_W4_PACKET_SENT;
                     ehcill_state = EHCILL_STATE_AWAKE;
                     btstack_uart->send_block(ehcill_tx_data, ehcill_tx_len);
@@ -710,6 +990,9 @@ static void hci_transport_h4_ehcill_handle_ehcill_command_sent(void){
     }
     // already packet ready? then start wakeup
     if (hci_transport_h4_ehcill_outgoing_packet_ready()){
+        if (command == EHCILL_GO_TO_SLEEP_ACK){
+            hci_transport_h4_ehcill_sleep_ended(0);
+        }
         hci_transport_h4_ehcill_emit_sleep_state(0);
         if (btstack_uart_sleep_mode != BTSTACK_UART_SLEEP_OFF){
             btstack_uart->set_sleep(BTSTACK_UART_SLEEP_OFF);
@@ -738,6 +1021,11 @@ const hci_transport_t * hci_transport_h4_instance(const btstack_uart_block_t * u
             /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_h4_set_baudrate,
             /* void   (*reset_link)(void); */                               NULL,
             /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+#ifdef ENABLE_EHCILL
+            /* int    (*send_packet_iov)(...); */                           NULL,
+#else
+            /* int    (*send_packet_iov)(...); */                           &hci_transport_h4_send_packet_iov,
+#endif
     };
 
     btstack_uart = uart_driver;
@@ -74,8 +74,17 @@ typedef enum {
 
 } hci_transport_link_actions_t;
 
-// Configuration Field. No packet buffers -> sliding window = 1, no OOF flow control, support data integrity check
-#define LINK_CONFIG_SLIDING_WINDOW_SIZE 1
+// Number of reliable packets sent before waiting for an acknowledgement. Packets are copied for sliding window > 1
+#ifndef HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 1
+#endif
+
+#if (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE < 1) || (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 7)
+#error "HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE must be in range 1..7"
+#endif
+
+// Configuration Field. Sliding window = HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE, no OOF flow control, support data integrity check
+#define LINK_CONFIG_SLIDING_WINDOW_SIZE HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
 #define LINK_CONFIG_OOF_FLOW_CONTROL 0
 #define LINK_CONFIG_DATA_INTEGRITY_CHECK 1
 #define LINK_CONFIG_VERSION_NR 0
@@ -94,6 +103,9 @@ typedef enum {
 // max size of write requests
 #define LINK_SLIP_TX_CHUNK_LEN 64
 
+// max size of read requests
+#define LINK_SLIP_RX_CHUNK_LEN 64
+
 // ---
 static const uint8_t link_control_sync[] =   { 0x01, 0x7e};
 static const uint8_t link_control_sync_response[] = { 0x02, 0x7d};
@@ -128,10 +140,27 @@ static uint8_t  link_peer_supports_data_integrity_check;
 static btstack_timer_source_t inactivity_timer;
 static uint16_t link_inactivity_timeout_ms; // auto-sleep if set
 
-// Outgoing packet
-static uint8_t   hci_packet_type;
-static uint16_t  hci_packet_size;
-static uint8_t * hci_packet;
+// Outgoing reliable packets, slot of oldest unacknowledged packet with seq nr link_seq_nr is link_window_start
+typedef struct {
+    uint8_t * packet;
+    uint16_t  size;
+    uint8_t   type;
+} hci_transport_link_window_slot_t;
+
+static hci_transport_link_window_slot_t link_window_slots[LINK_CONFIG_SLIDING_WINDOW_SIZE];
+#if LINK_CONFIG_SLIDING_WINDOW_SIZE > 1
+// HCI re-uses its packet buffer after HCI_EVENT_TRANSPORT_PACKET_SENT
+static uint8_t link_window_buffers[LINK_CONFIG_SLIDING_WINDOW_SIZE][HCI_OUTGOING_PACKET_BUFFER_SIZE];
+#endif
+static uint8_t link_window_start;
+// unacknowledged packets
+static uint8_t link_window_count;
+// packets sent since first transmission or last retransmission timeout
+static uint8_t link_window_sent;
+// min of own and peer sliding window size
+static uint8_t link_window_size;
+// HCI_EVENT_TRANSPORT_PACKET_SENT for last queued packet not emitted yet
+static uint8_t link_packet_sent_pending;
 
 // hci packet handler
 static  void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
@@ -154,43 +183,52 @@ static void hci_transport_link_run(void);
 static void hci_transport_slip_init(void);
 
 // -----------------------------
-// CRC16-CCITT Calculation - compromise: use 32 byte table - 512 byte table would be faster, but that's too large
-
-
-static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
-
-    static const uint16_t crc16_ccitt_table[] ={
-            0x0000, 0x1081, 0x2102, 0x3183,
-            0x4204, 0x5285, 0x6306, 0x7387,
-            0x8408, 0x9489, 0xa50a, 0xb58b,
-            0xc60c, 0xd68d, 0xe70e, 0xf78f
-    };
-
-    crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ ch) & 0x000f];
-    crc = (crc >> 4) ^ crc16_ccitt_table[(crc ^ (ch >> 4)) & 0x000f];
+// CRC16-CCITT Calculation, reflected with byte table for generator polynom D^16 + D^12 + D^5 + 1
+
+static const uint16_t crc16_ccitt_table[256] = {
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf, 0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e, 0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd, 0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c, 0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb, 0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a, 0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9, 0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738, 0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7, 0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036, 0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5, 0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134, 0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3, 0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232, 0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1, 0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330, 0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
+
+};
+
+static uint16_t crc16_ccitt_update_block(uint16_t crc, const uint8_t * data, uint16_t len){
+    while (len--){
+        crc = (crc >> 8) ^ crc16_ccitt_table[(crc ^ *data++) & 0x00ff];
+    }
     return crc;
 }
 
 static uint16_t btstack_reverse_bits_16(uint16_t value){
-    int reverse = 0;
+    static const uint8_t reverse_bits_4[] = {
+        0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe, 0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
+    };
+    uint16_t reverse = 0;
     int i;
-    for (i = 0; i < 16; i++) { 
-        reverse = reverse << 1;
-        reverse |= value & 1;
-        value = value >> 1;
+    for (i = 0; i < 4; i++) {
+        reverse = (reverse << 4) | reverse_bits_4[value & 0x0f];
+        value >>= 4;
     }
     return reverse;
 }
 
 static uint16_t crc16_calc_for_slip_frame(const uint8_t * header, const uint8_t * payload, uint16_t len){
-    int i;
     uint16_t crc = 0xffff;
-    for (i=0 ; i < 4 ; i++){
-        crc = crc16_ccitt_update(crc, header[i]);
-    }
-    for (i=0 ; i < len ; i++){
-        crc = crc16_ccitt_update(crc, payload[i]);
-    }
+    crc = crc16_ccitt_update_block(crc, header, 4);
+    crc = crc16_ccitt_update_block(crc, payload, len);
     return btstack_reverse_bits_16(crc);
 }
 
@@ -220,9 +258,7 @@ static void hci_transport_inactivity_timer_set(void){
 
 // Fill chunk and write
 static void hci_transport_slip_encode_chunk_and_send(int pos){
-    while (btstack_slip_encoder_has_data() & (pos < LINK_SLIP_TX_CHUNK_LEN)) {
-        slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+    pos += btstack_slip_encoder_encode_block(&slip_outgoing_buffer[pos], LINK_SLIP_TX_CHUNK_LEN - pos);
 
     if (!btstack_slip_encoder_has_data()){
         // Payload encoded, append DIC if present.
@@ -231,9 +267,7 @@ static void hci_transport_slip_encode_chunk_and_send(int pos){
             uint8_t dic_buffer[2];
             big_endian_store_16(dic_buffer, 0, slip_outgoing_dic);
             btstack_slip_encoder_start(dic_buffer, 2);
-            while (btstack_slip_encoder_has_data()){
-                slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-            } 
+            pos += btstack_slip_encoder_encode_block(&slip_outgoing_buffer[pos], 4);
         }
         // Start of Frame
         slip_outgoing_buffer[pos++] = BTSTACK_SLIP_SOF;
@@ -262,9 +296,7 @@ static void hci_transport_slip_send_frame(const uint8_t * header, const uint8_t
 
     // Header
     btstack_slip_encoder_start(header, 4);
-    while (btstack_slip_encoder_has_data()){
-        slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+    pos += btstack_slip_encoder_encode_block(&slip_outgoing_buffer[pos], 8);
 
     // Packet
     btstack_slip_encoder_start(packet, packet_size);
@@ -350,17 +382,22 @@ static void hci_transport_link_send_sleep(void){
 
 static void hci_transport_link_send_queued_packet(void){
 
+    // send next packet in window
+    const hci_transport_link_window_slot_t * slot = &link_window_slots[(link_window_start + link_window_sent) % LINK_CONFIG_SLIDING_WINDOW_SIZE];
+    uint8_t seq_nr = (link_seq_nr + link_window_sent) & 0x07;
+    link_window_sent++;
+
     uint8_t header[4];
-    hci_transport_link_calc_header(header, link_seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, hci_packet_type, hci_packet_size);
+    hci_transport_link_calc_header(header, seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, slot->type, slot->size);
 
     uint16_t data_integrity_check = 0;
     if (link_peer_supports_data_integrity_check){
-        data_integrity_check = crc16_calc_for_slip_frame(header, hci_packet, hci_packet_size);
+        data_integrity_check = crc16_calc_for_slip_frame(header, slot->packet, slot->size);
     }
-    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", link_seq_nr, link_ack_nr, hci_packet_size, link_peer_supports_data_integrity_check, data_integrity_check);
-    log_debug_hexdump(hci_packet, hci_packet_size);
+    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", seq_nr, link_ack_nr, slot->size, link_peer_supports_data_integrity_check, data_integrity_check);
+    log_debug_hexdump(slot->packet, slot->size);
 
-    hci_transport_slip_send_frame(header, hci_packet, hci_packet_size, data_integrity_check);
+    hci_transport_slip_send_frame(header, slot->packet, slot->size, data_integrity_check);
 
     // reset inactvitiy timer
     hci_transport_inactivity_timer_set();
@@ -415,11 +452,17 @@ static void hci_transport_link_run(void){
         return;
     }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET){
+        if (link_window_sent < link_window_count){
+            // packet already contains ack, no need to send addtitional one
+            hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+            hci_transport_link_send_queued_packet();
+            // keep sending until all packets in window are sent
+            if (link_window_sent == link_window_count){
+                hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
+            }
+            return;
+        }
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        // packet already contains ack, no need to send addtitional one
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
-        hci_transport_link_send_queued_packet();
-        return;
     }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
@@ -462,7 +505,9 @@ static void hci_transport_link_timeout_handler(btstack_timer_source_t * ts){
                 hci_transport_link_set_timer(LINK_WAKEUP_MS);
                 return;
             }
-            // resend packet
+            // resend all unacknowledged packets
+            log_info("h5 resend %u packets starting with seq %u", link_window_count, link_seq_nr);
+            link_window_sent = 0;
             hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
             hci_transport_link_set_timer(link_resend_timeout_ms);
             break;
@@ -477,6 +522,7 @@ static void hci_transport_link_init(void){
     link_state = LINK_UNINITIALIZED;
     link_peer_asleep = 0;
     link_peer_supports_data_integrity_check = 0;
+    link_window_size = 1;
  
     // get started
     hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
@@ -489,18 +535,43 @@ static int hci_transport_link_inc_seq_nr(int seq_nr){
 }
 
 static int hci_transport_link_have_outgoing_packet(void){
-    return hci_packet != NULL;
+    return link_window_count > 0;
 }
 
 static void hci_transport_link_clear_queue(void){
     btstack_run_loop_remove_timer(&link_timer);
-    hci_packet = NULL;
+    link_window_start = 0;
+    link_window_count = 0;
+    link_window_sent  = 0;
+    link_packet_sent_pending = 0;
 }
 
 static void hci_transport_h5_queue_packet(uint8_t packet_type, uint8_t *packet, int size){
-    hci_packet = packet;
-    hci_packet_type = packet_type;
-    hci_packet_size = size;
+    uint8_t index = (link_window_start + link_window_count) % LINK_CONFIG_SLIDING_WINDOW_SIZE;
+    hci_transport_link_window_slot_t * slot = &link_window_slots[index];
+#if LINK_CONFIG_SLIDING_WINDOW_SIZE > 1
+    (void)memcpy(link_window_buffers[index], packet, size);
+    slot->packet = link_window_buffers[index];
+#else
+    slot->packet = packet;
+#endif
+    slot->type = packet_type;
+    slot->size = size;
+    link_window_count++;
+    link_packet_sent_pending = 1;
+}
+
+static void hci_transport_link_emit_packet_sent_if_ready(void){
+    if (link_packet_sent_pending == 0) return;
+    // wait until last queued packet has been sent and window has a free slot
+    if (link_window_sent < link_window_count) return;
+    if (slip_write_active) return;
+    if (link_window_count >= link_window_size) return;
+    link_packet_sent_pending = 0;
+
+    // notify upper stack that it can send again
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
 }
 
 static void hci_transport_h5_emit_sleep_state(int sleep_active){
@@ -609,15 +680,21 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
                 break;
             }
             if (memcmp(slip_payload, link_control_config_response, link_control_config_response_prefix_len) == 0){
-                uint8_t config = slip_payload[2];
+                uint8_t config = 0;
+                if (link_payload_len > link_control_config_response_prefix_len){
+                    config = slip_payload[2];
+                }
                 link_peer_supports_data_integrity_check = (config & 0x10) != 0;
-                log_info("link received config response 0x%02x, data integrity check supported %u", config, link_peer_supports_data_integrity_check);
+                // send window limited by peer, config response without config field implies sliding window = 1
+                link_window_size = btstack_max(1, btstack_min(config & 0x07, LINK_CONFIG_SLIDING_WINDOW_SIZE));
+                log_info("link received config response 0x%02x, data integrity check supported %u, sliding window %u", config, link_peer_supports_data_integrity_check, link_window_size);
                 link_state = LINK_ACTIVE;
                 btstack_run_loop_remove_timer(&link_timer);
                 log_info("link activated");
                 // 
                 link_seq_nr = 0;
                 link_ack_nr = 0;
+                hci_transport_link_clear_queue();
                 // notify upper stack that it can start
                 uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
                 packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
@@ -640,16 +717,22 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
 
             // Process ACKs in reliable packet and explicit ack packets
             if (reliable_packet || (link_packet_type == LINK_ACKNOWLEDGEMENT_TYPE)){
-                // our packet is good if the remote expects our seq nr + 1
-                int next_seq_nr = hci_transport_link_inc_seq_nr(link_seq_nr);
-                if (hci_transport_link_have_outgoing_packet() && (next_seq_nr == ack_nr)){
-                    log_debug("outoing packet with seq %u ack'ed", link_seq_nr);
-                    link_seq_nr = next_seq_nr;
-                    hci_transport_link_clear_queue();
-
-                    // notify upper stack that it can send again
-                    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+                // cumulative ack: remote expects seq nr ack_nr next, our packets before are good
+                uint8_t num_acked = (ack_nr - link_seq_nr) & 0x07;
+                if ((num_acked > 0) && (num_acked <= link_window_count)){
+                    log_debug("%u outgoing packets with seq %u.. ack'ed", num_acked, link_seq_nr);
+                    link_seq_nr = ack_nr;
+                    link_window_start = (link_window_start + num_acked) % LINK_CONFIG_SLIDING_WINDOW_SIZE;
+                    link_window_count -= num_acked;
+                    link_window_sent = (link_window_sent > num_acked) ? (link_window_sent - num_acked) : 0;
+
+                    // restart resend timer if packets are left
+                    btstack_run_loop_remove_timer(&link_timer);
+                    if (link_window_count > 0){
+                        hci_transport_link_set_timer(link_resend_timeout_ms);
+                    }
+
+                    hci_transport_link_emit_packet_sent_if_ready();
                 }
             } 
 
@@ -732,11 +815,39 @@ static void hci_transport_link_update_resend_timeout(uint32_t baudrate){
 
 /// H5 Interface
 
-static uint8_t hci_transport_link_read_byte;
+static uint8_t  hci_transport_link_read_buffer[LINK_SLIP_RX_CHUNK_LEN];
+static uint16_t hci_transport_link_read_len;
 static int hci_transport_h5_active;
 
-static void hci_transport_h5_read_next_byte(void){
-    btstack_uart->receive_block(&hci_transport_link_read_byte, 1);    
+// end of SLIP frame is only known after decoding. to not read into next frame, request bytes frame has at least left
+static uint16_t hci_transport_h5_min_bytes_left_in_frame(void){
+    const uint8_t * slip_header = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    uint16_t decoded_size = btstack_slip_decoder_decoded_size();
+
+    // wait for start of frame and first header byte
+    if (decoded_size == 0) return 1;
+
+    // rest of header
+    if (decoded_size < 4) return 4 - decoded_size;
+
+    // read byte by byte until end of frame if header is invalid
+    uint8_t header_checksum = slip_header[0] + slip_header[1] + slip_header[2] + slip_header[3];
+    if (header_checksum != 0xff) return 1;
+
+    uint16_t frame_size = 4 + ((slip_header[1] >> 4) | (slip_header[2] << 4));
+    if (slip_header[0] & 0x40){
+        frame_size += 2;
+    }
+    if (frame_size > (6 + HCI_INCOMING_PACKET_BUFFER_SIZE)) return 1;
+    if (decoded_size >= frame_size) return 1;
+
+    // remaining bytes + SOF
+    return frame_size - decoded_size + 1;
+}
+
+static void hci_transport_h5_read_next_block(void){
+    hci_transport_link_read_len = btstack_min(hci_transport_h5_min_bytes_left_in_frame(), LINK_SLIP_RX_CHUNK_LEN);
+    btstack_uart->receive_block(hci_transport_link_read_buffer, hci_transport_link_read_len);
 }
 
 // track time receiving SLIP frame
@@ -745,12 +856,14 @@ static void hci_transport_h5_block_received(void){
     if (hci_transport_h5_active == 0) return;
 
     // track start time when receiving first byte // a bit hackish
-    if ((hci_transport_h5_receive_start == 0) && (hci_transport_link_read_byte != BTSTACK_SLIP_SOF)){
+    if ((hci_transport_h5_receive_start == 0) && (hci_transport_link_read_buffer[0] != BTSTACK_SLIP_SOF)){
         hci_transport_h5_receive_start = btstack_run_loop_get_time_ms();
     }
-    btstack_slip_decoder_process(hci_transport_link_read_byte);
-    uint16_t frame_size = btstack_slip_decoder_frame_size();
-    if (frame_size) {
+    uint16_t pos = 0;
+    while (pos < hci_transport_link_read_len){
+        pos += btstack_slip_decoder_process_block(&hci_transport_link_read_buffer[pos], hci_transport_link_read_len - pos);
+        uint16_t frame_size = btstack_slip_decoder_frame_size();
+        if (frame_size == 0) continue;
         // track time
         uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
         uint32_t nominal_time = (frame_size + 6) * 10 * 1000 / uart_config.baudrate;
@@ -763,7 +876,7 @@ static void hci_transport_h5_block_received(void){
         hci_transport_h5_process_frame(frame_size);
         hci_transport_slip_init();
     }
-    hci_transport_h5_read_next_byte();
+    hci_transport_h5_read_next_block();
 }
 
 static void hci_transport_h5_block_sent(void){
@@ -778,6 +891,9 @@ static void hci_transport_h5_block_sent(void){
     // done
     slip_write_active = 0;
 
+    // sliding window > 1: packet was copied and upper stack can continue
+    hci_transport_link_emit_packet_sent_if_ready();
+
     // enter sleep mode after sending sleep message
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_ENTER_SLEEP){
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_ENTER_SLEEP;
@@ -854,7 +970,7 @@ static int hci_transport_h5_open(void){
 
     // start receiving
     hci_transport_h5_active = 1;
-    hci_transport_h5_read_next_byte();
+    hci_transport_h5_read_next_block();
 
     return 0;
 }
@@ -869,7 +985,7 @@ static void hci_transport_h5_register_packet_handler(void (*handler)(uint8_t pac
 }
 
 static int hci_transport_h5_can_send_packet_now(uint8_t packet_type){
-    int res = !hci_transport_link_have_outgoing_packet() && (link_state == LINK_ACTIVE);
+    int res = (link_state == LINK_ACTIVE) && (link_packet_sent_pending == 0) && (link_window_count < link_window_size);
     // log_info("can_send_packet_now: %u", res);
     return res;
 }
@@ -879,6 +995,12 @@ static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, in
         log_error("hci_transport_h5_send_packet called but in state %d", link_state);
         return -1;
     }
+#if LINK_CONFIG_SLIDING_WINDOW_SIZE > 1
+    if (size > HCI_OUTGOING_PACKET_BUFFER_SIZE){
+        log_error("hci_transport_h5_send_packet: packet with size %u too large", size);
+        return -1;
+    }
+#endif
 
     // store request
     hci_transport_h5_queue_packet(packet_type, packet, size);
@@ -894,7 +1016,10 @@ static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, in
         hci_transport_link_set_timer(LINK_WAKEUP_MS);
     } else {
         hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        hci_transport_link_set_timer(link_resend_timeout_ms);
+        // resend timer already running for earlier unacknowledged packets
+        if (link_window_count == 1){
+            hci_transport_link_set_timer(link_resend_timeout_ms);
+        }
     }
     hci_transport_link_run();
     return 0;
@@ -939,6 +1064,7 @@ const hci_transport_t * hci_transport_h5_instance(const btstack_uart_block_t * u
             /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_h5_set_baudrate,
             /* void   (*reset_link)(void); */                               &hci_transport_h5_reset_link,
             /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+            /* int    (*send_packet_iov)(...); */                           NULL,
     };
 
     btstack_uart = uart_driver;
@@ -48,6 +48,7 @@
 #include "l2cap.h"
 #include "hci.h"
 #include "hci_dump.h"
+#include "btstack_trace.h"
 #include "bluetooth_sdp.h"
 #include "bluetooth_psm.h"
 #include "btstack_bool.h"
@@ -119,7 +120,24 @@ typedef enum {
 #define NR_BUFFERED_ACL_PACKETS 3
 
 // used to cache l2cap rejects, echo, and informational requests
+#ifndef NR_PENDING_SIGNALING_RESPONSES
 #define NR_PENDING_SIGNALING_RESPONSES 3
+#endif
+
+// max ERTM TxWindow with Standard Control Field and with Extended Window Size option / Extended Control Field
+#define L2CAP_ERTM_WINDOW_SIZE_MAX          63
+#define L2CAP_ERTM_EXTENDED_WINDOW_SIZE_MAX 0x3fff
+
+// alignment of ERTM tx state stored after rx buffers
+#define L2CAP_ERTM_TX_STATE_ALIGNMENT 8
+
+#if defined(ENABLE_L2CAP_STREAMING_MODE) && !defined(ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE)
+#error "ENABLE_L2CAP_STREAMING_MODE requires ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE"
+#endif
+
+#if defined(ENABLE_HCI_QOS_ARBITER) && defined(ENABLE_L2CAP_WEIGHTED_SCHEDULING)
+#error "ENABLE_HCI_QOS_ARBITER cannot be combined with ENABLE_L2CAP_WEIGHTED_SCHEDULING"
+#endif
 
 // nr of credits provided to remote if credits fall below watermark
 #define L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_WATERMARK 5
@@ -135,6 +153,16 @@ typedef enum {
 #define L2CAP_USES_CHANNELS
 #endif
 
+// slot table for lookup by local cid, size must be power of two
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+#ifndef L2CAP_LOCAL_CID_TABLE_SIZE
+#define L2CAP_LOCAL_CID_TABLE_SIZE 32
+#endif
+#if L2CAP_LOCAL_CID_TABLE_SIZE & (L2CAP_LOCAL_CID_TABLE_SIZE - 1)
+#error "L2CAP_LOCAL_CID_TABLE_SIZE must be a power of two"
+#endif
+#endif
+
 // prototypes
 static void l2cap_run(void);
 static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
@@ -161,6 +189,11 @@ static void l2cap_le_notify_channel_can_send(l2cap_channel_t *channel);
 static void l2cap_le_finialize_channel_close(l2cap_channel_t *channel);
 static void l2cap_le_send_pdu(l2cap_channel_t *channel);
 static inline l2cap_service_t * l2cap_le_get_service(uint16_t psm);
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+static uint8_t * l2cap_le_acl_get_buffer(hci_con_handle_t con_handle, uint16_t cid, uint16_t payload_len, const uint8_t * fragment, uint16_t fragment_len);
+static void l2cap_le_acl_buffer_complete(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer, uint16_t len);
+static void l2cap_le_acl_buffer_aborted(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer);
+#endif
 #endif
 #ifdef L2CAP_USES_CHANNELS
 static uint16_t l2cap_next_local_cid(void);
@@ -171,6 +204,9 @@ static l2cap_channel_t * l2cap_get_channel_for_local_cid(uint16_t local_cid);
 static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t packet_handler, l2cap_channel_type_t channel_type, bd_addr_t address, bd_addr_type_t address_type, 
         uint16_t psm, uint16_t local_mtu, gap_security_level_t security_level);
 static void l2cap_free_channel_entry(l2cap_channel_t * channel);
+static void l2cap_add_channel(l2cap_channel_t * channel);
+static void l2cap_remove_channel(l2cap_channel_t * channel);
+static void l2cap_local_cid_table_remove(l2cap_channel_t * channel);
 #endif
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 static void l2cap_ertm_notify_channel_can_send(l2cap_channel_t * channel);
@@ -195,6 +231,14 @@ static bd_addr_t l2cap_outgoing_classic_addr;
 
 #ifdef ENABLE_LE_DATA_CHANNELS
 static btstack_linked_list_t l2cap_le_services;
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+// reassemble K-frames that span multiple ACL fragments directly into SDU buffer
+static const hci_acl_buffer_provider_t l2cap_le_acl_buffer_provider = {
+    &l2cap_le_acl_get_buffer,
+    &l2cap_le_acl_buffer_complete,
+    &l2cap_le_acl_buffer_aborted
+};
+#endif
 #endif
 
 // single list of channels for Classic Channels, LE Data Channels, Classic Connectionless, ATT, and SM
@@ -203,14 +247,29 @@ static btstack_linked_list_t l2cap_channels;
 // next channel id for new connections
 static uint16_t  local_source_cid  = 0x40;
 #endif
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+// dynamic channels indexed by local cid modulo table size
+static l2cap_channel_t * l2cap_local_cid_table[L2CAP_LOCAL_CID_TABLE_SIZE];
+#endif
 // next signaling sequence number
 static uint8_t   sig_seq_nr  = 0xff;
 
 // used to cache l2cap rejects, echo, and informational requests
 static l2cap_signaling_response_t signaling_responses[NR_PENDING_SIGNALING_RESPONSES];
 static int signaling_responses_pending;
+#ifdef ENABLE_BLE
+// round robin for connection parameter update requests/responses
+static hci_con_handle_t l2cap_le_con_parameter_update_last_handle = HCI_CON_HANDLE_INVALID;
+#endif
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
+#ifdef ENABLE_L2CAP_STATISTICS
+static l2cap_statistics_t l2cap_statistics;
+#define L2CAP_STATISTICS_ADD(channel, field, value) (channel)->statistics.field += (value)
+#else
+#define L2CAP_STATISTICS_ADD(channel, field, value)
+#endif
+
 #ifdef ENABLE_BLE
 // only used for connection parameter update events
 static btstack_packet_handler_t l2cap_event_packet_handler;
@@ -252,16 +311,57 @@ static uint16_t crc16_calc(uint8_t * data, uint16_t len){
     return crc;
 }
 
-static inline uint16_t l2cap_encanced_control_field_for_information_frame(uint8_t tx_seq, int final, uint8_t req_seq, l2cap_segmentation_and_reassembly_t sar){
+static inline uint32_t l2cap_encanced_control_field_for_information_frame(l2cap_channel_t * channel, uint16_t tx_seq, int final, uint16_t req_seq, l2cap_segmentation_and_reassembly_t sar){
+    if (channel->extended_control){
+        return (((uint32_t) tx_seq) << 18) | (((uint32_t) sar) << 16) | (((uint32_t) req_seq) << 2) | (final << 1) | 0;
+    }
     return (((uint16_t) sar) << 14) | (req_seq << 8) | (final << 7) | (tx_seq << 1) | 0; 
 }
 
-static inline uint16_t l2cap_encanced_control_field_for_supevisor_frame(l2cap_supervisory_function_t supervisory_function, int poll, int final, uint8_t req_seq){
+static inline uint32_t l2cap_encanced_control_field_for_supevisor_frame(l2cap_channel_t * channel, l2cap_supervisory_function_t supervisory_function, int poll, int final, uint16_t req_seq){
+    if (channel->extended_control){
+        return (((uint32_t) poll) << 18) | (((uint32_t) supervisory_function) << 16) | (((uint32_t) req_seq) << 2) | (final << 1) | 1;
+    }
     return (req_seq << 8) | (final << 7) | (poll << 4) | (((int) supervisory_function) << 2) | 1; 
 }
 
-static int l2cap_next_ertm_seq_nr(int seq_nr){
-    return (seq_nr + 1) & 0x3f;
+static inline uint16_t l2cap_ertm_control_field_size(l2cap_channel_t * channel){
+    return channel->extended_control ? 4 : 2;
+}
+
+static inline uint16_t l2cap_ertm_seq_nr_mask(l2cap_channel_t * channel){
+    return channel->extended_control ? 0x3fff : 0x3f;
+}
+
+static uint16_t l2cap_next_ertm_seq_nr(l2cap_channel_t * channel, uint16_t seq_nr){
+    return (seq_nr + 1) & l2cap_ertm_seq_nr_mask(channel);
+}
+
+static inline bool l2cap_streaming_mode(l2cap_channel_t * channel){
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+    return channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE;
+#else
+    UNUSED(channel);
+    return false;
+#endif
+}
+
+// ERTM and Streaming Mode use I-frames stored in the ERTM buffer
+static inline bool l2cap_ertm_framing(l2cap_channel_t * channel){
+    return (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) || l2cap_streaming_mode(channel);
+}
+
+// extended feature mask bit of remote required for channel mode
+static uint16_t l2cap_ertm_extended_feature_for_mode(l2cap_channel_t * channel){
+    return l2cap_streaming_mode(channel) ? 0x10 : 0x08;
+}
+
+static void l2cap_ertm_store_control_field(l2cap_channel_t * channel, uint8_t * buffer, uint32_t control){
+    if (channel->extended_control){
+        little_endian_store_32(buffer, 0, control);
+    } else {
+        little_endian_store_16(buffer, 0, (uint16_t) control);
+    }
 }
 
 static int l2cap_ertm_can_store_packet_now(l2cap_channel_t * channel){
@@ -283,6 +383,7 @@ static int l2cap_ertm_can_store_packet_now(l2cap_channel_t * channel){
 
 static void l2cap_ertm_retransmit_unacknowleded_frames(l2cap_channel_t * l2cap_channel){
     log_info("Retransmit unacknowleged frames");
+    L2CAP_STATISTICS_ADD(l2cap_channel, ertm_retransmissions, l2cap_channel->unacked_frames);
     l2cap_channel->unacked_frames = 0;;
     l2cap_channel->tx_send_index  = l2cap_channel->tx_read_index;
 }
@@ -324,6 +425,7 @@ static void l2cap_ertm_stop_retransmission_timer(l2cap_channel_t * l2cap_channel
 static void l2cap_ertm_monitor_timeout_callback(btstack_timer_source_t * ts){
     log_info("Monitor timeout");
     l2cap_channel_t * l2cap_channel = (l2cap_channel_t *) btstack_run_loop_get_timer_context(ts);
+    L2CAP_STATISTICS_ADD(l2cap_channel, ertm_timeouts, 1);
 
     // TODO: we assume that it's the oldest packet
     l2cap_ertm_tx_packet_state_t * tx_state;
@@ -352,6 +454,7 @@ static void l2cap_ertm_monitor_timeout_callback(btstack_timer_source_t * ts){
 static void l2cap_ertm_retransmission_timeout_callback(btstack_timer_source_t * ts){
     log_info("Retransmission timeout");
     l2cap_channel_t * l2cap_channel = (l2cap_channel_t *) btstack_run_loop_get_timer_context(ts);
+    L2CAP_STATISTICS_ADD(l2cap_channel, ertm_timeouts, 1);
     
     // TODO: we assume that it's the oldest packet
     l2cap_ertm_tx_packet_state_t * tx_state;
@@ -375,16 +478,21 @@ static int l2cap_ertm_send_information_frame(l2cap_channel_t * channel, int inde
     l2cap_ertm_tx_packet_state_t * tx_state = &channel->tx_packets_state[index];
     hci_reserve_packet_buffer();
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
-    uint16_t control = l2cap_encanced_control_field_for_information_frame(tx_state->tx_seq, final, channel->req_seq, tx_state->sar);
-    log_info("I-Frame: control 0x%04x", control);
-    little_endian_store_16(acl_buffer, 8, control);
-    (void)memcpy(&acl_buffer[8 + 2],
-                 &channel->tx_packets_data[index * channel->local_mps],
+    // streaming mode: ReqSeq shall be set to 0
+    uint16_t req_seq = l2cap_streaming_mode(channel) ? 0 : channel->req_seq;
+    uint32_t control = l2cap_encanced_control_field_for_information_frame(channel, tx_state->tx_seq, final, req_seq, tx_state->sar);
+    log_info("I-Frame: control 0x%04x", (unsigned int) control);
+    uint16_t control_size = l2cap_ertm_control_field_size(channel);
+    l2cap_ertm_store_control_field(channel, &acl_buffer[8], control);
+    (void)memcpy(&acl_buffer[8 + control_size],
+                 &channel->tx_packets_data[index * channel->tx_mps],
                  tx_state->len);
     // (re-)start retransmission timer on 
-    l2cap_ertm_start_retransmission_timer(channel);
+    if (!l2cap_streaming_mode(channel)){
+        l2cap_ertm_start_retransmission_timer(channel);
+    }
     // send
-    return l2cap_send_prepared(channel->local_cid, 2 + tx_state->len);
+    return l2cap_send_prepared(channel->local_cid, control_size + tx_state->len);
 }
 
 static void l2cap_ertm_store_fragment(l2cap_channel_t * channel, l2cap_segmentation_and_reassembly_t sar, uint16_t sdu_length, uint8_t * data, uint16_t len){
@@ -396,7 +504,7 @@ static void l2cap_ertm_store_fragment(l2cap_channel_t * channel, l2cap_segmentat
     tx_state->sar = sar;
     tx_state->retry_count = 0;
 
-    uint8_t * tx_packet = &channel->tx_packets_data[index * channel->local_mps];
+    uint8_t * tx_packet = &channel->tx_packets_data[index * channel->tx_mps];
     log_debug("index %u, local mps %u, remote mps %u, packet tx %p, len %u", index, channel->local_mps, channel->remote_mps, tx_packet, len);
     int pos = 0;
     if (sar == L2CAP_SEGMENTATION_AND_REASSEMBLY_START_OF_L2CAP_SDU){
@@ -408,7 +516,10 @@ static void l2cap_ertm_store_fragment(l2cap_channel_t * channel, l2cap_segmentat
 
     // update
     channel->num_stored_tx_frames++;
-    channel->next_tx_seq = l2cap_next_ertm_seq_nr(channel->next_tx_seq);
+#ifdef ENABLE_L2CAP_STATISTICS
+    channel->statistics.ertm_tx_queue_max = btstack_max(channel->statistics.ertm_tx_queue_max, channel->num_stored_tx_frames);
+#endif
+    channel->next_tx_seq = l2cap_next_ertm_seq_nr(channel, channel->next_tx_seq);
     l2cap_ertm_next_tx_write_index(channel);
 
     log_info("l2cap_ertm_store_fragment: tx_read_index %u, tx_write_index %u, num stored %u", channel->tx_read_index, channel->tx_write_index, channel->num_stored_tx_frames);
@@ -468,7 +579,7 @@ static uint16_t l2cap_setup_options_ertm_request(l2cap_channel_t * channel, uint
     config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL;
     config_options[pos++] = 9;      // length
     config_options[pos++] = (uint8_t) channel->mode;
-    config_options[pos++] = channel->num_rx_buffers;    // == TxWindows size
+    config_options[pos++] = (uint8_t) btstack_min(channel->num_rx_buffers, L2CAP_ERTM_WINDOW_SIZE_MAX);    // == TxWindows size
     config_options[pos++] = channel->local_max_transmit;
     little_endian_store_16( config_options, pos, channel->local_retransmission_timeout_ms);
     pos += 2;
@@ -487,7 +598,20 @@ static uint16_t l2cap_setup_options_ertm_request(l2cap_channel_t * channel, uint
     config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_FRAME_CHECK_SEQUENCE;
     config_options[pos++] = 1;     // length
     config_options[pos++] = channel->fcs_option;
-    return pos; // 11+4+3=18
+
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+    // request Extended Control Field for windows larger than 63 frames, if supported by remote
+    hci_connection_t * connection = hci_connection_for_handle(channel->con_handle);
+    if (((channel->num_rx_buffers > L2CAP_ERTM_WINDOW_SIZE_MAX) || channel->extended_control)
+        && (connection != NULL) && (connection->l2cap_state.extended_feature_mask & 0x0100)){
+        channel->extended_control = 1;
+        config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE;
+        config_options[pos++] = 2;     // length
+        little_endian_store_16(config_options, pos, btstack_min(channel->num_rx_buffers, L2CAP_ERTM_EXTENDED_WINDOW_SIZE_MAX));
+        pos += 2;
+    }
+#endif
+    return pos; // 11+4+3+4=22
 }
 
 static uint16_t l2cap_setup_options_ertm_response(l2cap_channel_t * channel, uint8_t * config_options){
@@ -496,7 +620,8 @@ static uint16_t l2cap_setup_options_ertm_response(l2cap_channel_t * channel, uin
     config_options[pos++] = 9;      // length
     config_options[pos++] = (uint8_t) channel->mode;
     // less or equal to remote tx window size
-    config_options[pos++] = btstack_min(channel->num_tx_buffers, channel->remote_tx_window_size);
+    uint16_t tx_window_size = btstack_min(channel->num_tx_buffers, channel->remote_tx_window_size);
+    config_options[pos++] = (uint8_t) btstack_min(tx_window_size, L2CAP_ERTM_WINDOW_SIZE_MAX);
     // max transmit in response shall be ignored -> use sender values
     config_options[pos++] = channel->remote_max_transmit;
     // A value for the Retransmission time-out shall be sent in a positive Configuration Response
@@ -522,15 +647,23 @@ static uint16_t l2cap_setup_options_ertm_response(l2cap_channel_t * channel, uin
     config_options[pos++] = 1;     // length
     config_options[pos++] = channel->fcs_option;
 #endif
-    return pos; // 11+4=15
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+    if (channel->extended_control){
+        config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE;
+        config_options[pos++] = 2;     // length
+        little_endian_store_16(config_options, pos, tx_window_size);
+        pos += 2;
+    }
+#endif
+    return pos; // 11+4+4=19
 }
 
-static int l2cap_ertm_send_supervisor_frame(l2cap_channel_t * channel, uint16_t control){
+static int l2cap_ertm_send_supervisor_frame(l2cap_channel_t * channel, uint32_t control){
     hci_reserve_packet_buffer();
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
-    log_info("S-Frame: control 0x%04x", control);
-    little_endian_store_16(acl_buffer, 8, control);
-    return l2cap_send_prepared(channel->local_cid, 2);
+    log_info("S-Frame: control 0x%04x", (unsigned int) control);
+    l2cap_ertm_store_control_field(channel, &acl_buffer[8], control);
+    return l2cap_send_prepared(channel->local_cid, l2cap_ertm_control_field_size(channel));
 }
 
 static uint8_t l2cap_ertm_validate_local_config(l2cap_ertm_config_t * ertm_config){
@@ -556,6 +689,17 @@ static uint8_t l2cap_ertm_validate_local_config(l2cap_ertm_config_t * ertm_confi
         log_error("num_rx_buffers must be >= 1");
         result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
     }
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+    if (ertm_config->num_rx_buffers > L2CAP_ERTM_EXTENDED_WINDOW_SIZE_MAX){
+        log_error("num_rx_buffers must be <= %u", L2CAP_ERTM_EXTENDED_WINDOW_SIZE_MAX);
+        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+#else
+    if (ertm_config->num_rx_buffers > L2CAP_ERTM_WINDOW_SIZE_MAX){
+        log_error("num_rx_buffers must be <= %u", L2CAP_ERTM_WINDOW_SIZE_MAX);
+        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+#endif
     if (ertm_config->num_tx_buffers < 1){
         log_error("num_rx_buffers must be >= 1");
         result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
@@ -563,9 +707,43 @@ static uint8_t l2cap_ertm_validate_local_config(l2cap_ertm_config_t * ertm_confi
     return result;
 }
 
-static void l2cap_ertm_configure_channel(l2cap_channel_t * channel, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
+// max number of frames sent without acknowledgement, and max number of buffers so that tx_seq of stored frames is unique
+static uint16_t l2cap_ertm_max_window_size(l2cap_channel_t * channel){
+    return channel->extended_control ? L2CAP_ERTM_EXTENDED_WINDOW_SIZE_MAX : L2CAP_ERTM_WINDOW_SIZE_MAX;
+}
 
-    channel->mode  = L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION;
+// receive window offered to remote as TxWindow
+static uint16_t l2cap_ertm_rx_window_size(l2cap_channel_t * channel){
+    return btstack_min(channel->num_rx_buffers, l2cap_ertm_max_window_size(channel));
+}
+
+// split tx buffer into tx states and buffers of effective mps, smaller remote mps allows for more tx buffers
+static void l2cap_ertm_setup_tx_buffers(l2cap_channel_t * channel){
+    uint16_t tx_mps = channel->local_mps;
+    if ((channel->remote_mps > 0) && (channel->remote_mps < tx_mps)){
+        tx_mps = channel->remote_mps;
+    }
+
+    uint8_t * buffer = channel->tx_buffer;
+    uint32_t  size   = channel->tx_buffer_size;
+    uint32_t  bytes_till_alignment = (L2CAP_ERTM_TX_STATE_ALIGNMENT - (((uintptr_t) buffer) & (L2CAP_ERTM_TX_STATE_ALIGNMENT - 1))) & (L2CAP_ERTM_TX_STATE_ALIGNMENT - 1);
+    buffer += bytes_till_alignment;
+    size   -= bytes_till_alignment;
+
+    uint32_t num_tx_buffers = size / (sizeof(l2cap_ertm_tx_packet_state_t) + tx_mps);
+    num_tx_buffers = btstack_min(num_tx_buffers, l2cap_ertm_max_window_size(channel));
+
+    // use void cast to avoid -Wcast-align warning
+    channel->num_tx_buffers   = (uint16_t) num_tx_buffers;
+    channel->tx_mps           = tx_mps;
+    channel->tx_packets_state = (l2cap_ertm_tx_packet_state_t *) (void *) buffer;
+    channel->tx_packets_data  = &buffer[num_tx_buffers * sizeof(l2cap_ertm_tx_packet_state_t)];
+    log_info("ERTM tx buffers: %u of %u bytes", channel->num_tx_buffers, channel->tx_mps);
+}
+
+static void l2cap_ertm_configure_channel(l2cap_channel_t * channel, l2cap_channel_mode_t mode, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
+
+    channel->mode  = mode;
     channel->ertm_mandatory = ertm_config->ertm_mandatory;
     channel->local_max_transmit = ertm_config->max_transmit;
     channel->local_retransmission_timeout_ms = ertm_config->retransmission_timeout_ms;
@@ -574,6 +752,14 @@ static void l2cap_ertm_configure_channel(l2cap_channel_t * channel, l2cap_ertm_c
     channel->num_rx_buffers = ertm_config->num_rx_buffers;
     channel->num_tx_buffers = ertm_config->num_tx_buffers;
 
+    if (l2cap_streaming_mode(channel)){
+        // no retransmissions and no out-of-order frames, Max Transmit and time-outs shall be set to 0
+        channel->local_max_transmit = 0;
+        channel->local_retransmission_timeout_ms = 0;
+        channel->local_monitor_timeout_ms = 0;
+        channel->num_rx_buffers = 0;
+    }
+
     // align buffer to 16-byte boundary to assert l2cap_ertm_rx_packet_state_t is aligned
     int bytes_till_alignment = 16 - (((uintptr_t) buffer) & 0x0f);
     buffer += bytes_till_alignment;
@@ -582,43 +768,40 @@ static void l2cap_ertm_configure_channel(l2cap_channel_t * channel, l2cap_ertm_c
     // setup state buffers - use void cast to avoid -Wcast-align warning
     uint32_t pos = 0;
     channel->rx_packets_state = (l2cap_ertm_rx_packet_state_t *) (void *) &buffer[pos];
-    pos += ertm_config->num_rx_buffers * sizeof(l2cap_ertm_rx_packet_state_t);
-    channel->tx_packets_state = (l2cap_ertm_tx_packet_state_t *) (void *) &buffer[pos];
-    pos += ertm_config->num_tx_buffers * sizeof(l2cap_ertm_tx_packet_state_t);
+    pos += channel->num_rx_buffers * sizeof(l2cap_ertm_rx_packet_state_t);
 
     // setup reassembly buffer
     channel->reassembly_buffer = &buffer[pos];
     pos += ertm_config->local_mtu;
 
-    // divide rest of data equally
-    channel->local_mps = (size - pos) / (ertm_config->num_rx_buffers + ertm_config->num_tx_buffers);
+    // divide rest of data equally, after tx state and alignment of tx state
+    uint32_t tx_state_size = (ertm_config->num_tx_buffers * sizeof(l2cap_ertm_tx_packet_state_t)) + L2CAP_ERTM_TX_STATE_ALIGNMENT;
+    channel->local_mps = (size - pos - tx_state_size) / (channel->num_rx_buffers + ertm_config->num_tx_buffers);
     log_info("Local MPS: %u", channel->local_mps);
     channel->rx_packets_data = &buffer[pos];
-    pos += ertm_config->num_rx_buffers * channel->local_mps;
-    channel->tx_packets_data = &buffer[pos];
+    pos += channel->num_rx_buffers * channel->local_mps;
+
+    // remaining data for tx state and tx buffers, split again when remote mps is known
+    channel->tx_buffer      = &buffer[pos];
+    channel->tx_buffer_size = size - pos;
+    l2cap_ertm_setup_tx_buffers(channel);
 
     channel->fcs_option = ertm_config->fcs_option;
 }
 
-uint8_t l2cap_create_ertm_channel(btstack_packet_handler_t packet_handler, bd_addr_t address, uint16_t psm, 
+static uint8_t l2cap_create_channel_with_ertm_framing(btstack_packet_handler_t packet_handler, bd_addr_t address, uint16_t psm, l2cap_channel_mode_t mode,
     l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size, uint16_t * out_local_cid){
 
-    log_info("L2CAP_CREATE_ERTM_CHANNEL addr %s, psm 0x%x, local mtu %u", bd_addr_to_str(address), psm, ertm_config->local_mtu);
-
-    // validate local config
-    uint8_t result = l2cap_ertm_validate_local_config(ertm_config);
-    if (result) return result;
-
     l2cap_channel_t * channel = l2cap_create_channel_entry(packet_handler, L2CAP_CHANNEL_TYPE_CLASSIC, address, BD_ADDR_TYPE_ACL, psm, ertm_config->local_mtu, LEVEL_0);
     if (!channel) {
         return BTSTACK_MEMORY_ALLOC_FAILED;
     }
 
-    // configure ERTM
-    l2cap_ertm_configure_channel(channel, ertm_config, buffer, size);
+    // configure ERTM / Streaming Mode
+    l2cap_ertm_configure_channel(channel, mode, ertm_config, buffer, size);
 
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // store local_cid
     if (out_local_cid){
@@ -641,37 +824,65 @@ uint8_t l2cap_create_ertm_channel(btstack_packet_handler_t packet_handler, bd_ad
     return 0;     
 }
 
-static void l2cap_ertm_notify_channel_can_send(l2cap_channel_t * channel){
-    if (l2cap_ertm_can_store_packet_now(channel)){
-        channel->waiting_for_can_send_now = 0;
-        l2cap_emit_can_send_now(channel->packet_handler, channel->local_cid);
+uint8_t l2cap_create_ertm_channel(btstack_packet_handler_t packet_handler, bd_addr_t address, uint16_t psm, 
+    l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size, uint16_t * out_local_cid){
+
+    log_info("L2CAP_CREATE_ERTM_CHANNEL addr %s, psm 0x%x, local mtu %u", bd_addr_to_str(address), psm, ertm_config->local_mtu);
+
+    // validate local config
+    uint8_t result = l2cap_ertm_validate_local_config(ertm_config);
+    if (result) return result;
+
+    return l2cap_create_channel_with_ertm_framing(packet_handler, address, psm, L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION, ertm_config, buffer, size, out_local_cid);
+}
+
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+static uint8_t l2cap_streaming_validate_local_config(l2cap_ertm_config_t * ertm_config){
+    uint8_t result = ERROR_CODE_SUCCESS;
+    if (ertm_config->local_mtu < 48){
+        log_error("local_mtu must be >= 48");
+        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+    if (ertm_config->num_tx_buffers < 1){
+        log_error("num_tx_buffers must be >= 1");
+        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
     }
+    return result;
 }
 
-uint8_t l2cap_accept_ertm_connection(uint16_t local_cid, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
+uint8_t l2cap_create_streaming_channel(btstack_packet_handler_t packet_handler, bd_addr_t address, uint16_t psm, 
+    l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size, uint16_t * out_local_cid){
 
-    log_info("L2CAP_ACCEPT_ERTM_CONNECTION local_cid 0x%x", local_cid);
-    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
-    if (!channel) {
-        log_error("l2cap_accept_connection called but local_cid 0x%x not found", local_cid);
-        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
-    }
+    log_info("L2CAP_CREATE_STREAMING_CHANNEL addr %s, psm 0x%x, local mtu %u", bd_addr_to_str(address), psm, ertm_config->local_mtu);
 
     // validate local config
-    uint8_t result = l2cap_ertm_validate_local_config(ertm_config);
+    uint8_t result = l2cap_streaming_validate_local_config(ertm_config);
     if (result) return result;
 
-    // configure L2CAP ERTM
-    l2cap_ertm_configure_channel(channel, ertm_config, buffer, size);
+    return l2cap_create_channel_with_ertm_framing(packet_handler, address, psm, L2CAP_CHANNEL_MODE_STREAMING_MODE, ertm_config, buffer, size, out_local_cid);
+}
+#endif
+
+static void l2cap_ertm_notify_channel_can_send(l2cap_channel_t * channel){
+    if (l2cap_ertm_can_store_packet_now(channel)){
+        channel->waiting_for_can_send_now = 0;
+        l2cap_emit_can_send_now(channel->packet_handler, channel->local_cid);
+    }
+}
+
+static uint8_t l2cap_accept_connection_with_ertm_framing(l2cap_channel_t * channel, l2cap_channel_mode_t mode, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
+
+    // configure L2CAP ERTM / Streaming Mode
+    l2cap_ertm_configure_channel(channel, mode, ertm_config, buffer, size);
 
     // default: continue
     channel->state = L2CAP_STATE_WILL_SEND_CONNECTION_RESPONSE_ACCEPT;
 
-    // verify remote ERTM support
+    // verify remote ERTM / Streaming Mode support
     hci_connection_t * connection = hci_connection_for_handle(channel->con_handle);
     if (connection == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
 
-    if ((channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) && ((connection->l2cap_state.extended_feature_mask & 0x08) == 0)){
+    if ((connection->l2cap_state.extended_feature_mask & l2cap_ertm_extended_feature_for_mode(channel)) == 0){
         // ERTM not possible, select basic mode and release buffer
         channel->mode = L2CAP_CHANNEL_MODE_BASIC;
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
@@ -693,6 +904,40 @@ uint8_t l2cap_accept_ertm_connection(uint16_t local_cid, l2cap_ertm_config_t * e
     return ERROR_CODE_SUCCESS;
 }
 
+uint8_t l2cap_accept_ertm_connection(uint16_t local_cid, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
+
+    log_info("L2CAP_ACCEPT_ERTM_CONNECTION local_cid 0x%x", local_cid);
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_accept_connection called but local_cid 0x%x not found", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    // validate local config
+    uint8_t result = l2cap_ertm_validate_local_config(ertm_config);
+    if (result) return result;
+
+    return l2cap_accept_connection_with_ertm_framing(channel, L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION, ertm_config, buffer, size);
+}
+
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+uint8_t l2cap_accept_streaming_connection(uint16_t local_cid, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
+
+    log_info("L2CAP_ACCEPT_STREAMING_CONNECTION local_cid 0x%x", local_cid);
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_accept_connection called but local_cid 0x%x not found", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    // validate local config
+    uint8_t result = l2cap_streaming_validate_local_config(ertm_config);
+    if (result) return result;
+
+    return l2cap_accept_connection_with_ertm_framing(channel, L2CAP_CHANNEL_MODE_STREAMING_MODE, ertm_config, buffer, size);
+}
+#endif
+
 uint8_t l2cap_ertm_set_busy(uint16_t local_cid){
     l2cap_channel_t * channel = l2cap_get_channel_for_local_cid( local_cid);
     if (!channel) {
@@ -737,17 +982,18 @@ static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint8_t
 
         tx_state = &l2cap_channel->tx_packets_state[l2cap_channel->tx_read_index];
         // calc delta
-        int delta = (req_seq - tx_state->tx_seq) & 0x03f;
+        int delta = (req_seq - tx_state->tx_seq) & l2cap_ertm_seq_nr_mask(l2cap_channel);
         if (delta == 0) break;  // all packets acknowledged
         if (delta > l2cap_channel->remote_tx_window_size) break;   
 
         num_buffers_acked++;
         l2cap_channel->num_stored_tx_frames--;
         l2cap_channel->unacked_frames--;
+        tx_state->retransmission_requested = 0;
         log_info("RR seq %u => packet with tx_seq %u done", req_seq, tx_state->tx_seq);
 
         l2cap_channel->tx_read_index++;
-        if (l2cap_channel->tx_read_index >= l2cap_channel->num_rx_buffers){
+        if (l2cap_channel->tx_read_index >= l2cap_channel->num_tx_buffers){
             l2cap_channel->tx_read_index = 0;
         }
     }
@@ -757,36 +1003,79 @@ static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint8_t
 }     
 }     
 
-static l2cap_ertm_tx_packet_state_t * l2cap_ertm_get_tx_state(l2cap_channel_t * l2cap_channel, uint8_t tx_seq){
+// only stored frames are searched, as tx_seq of older frames could have been used again
+static l2cap_ertm_tx_packet_state_t * l2cap_ertm_get_tx_state(l2cap_channel_t * l2cap_channel, uint16_t tx_seq){
     int i;
-    for (i=0;i<l2cap_channel->num_tx_buffers;i++){
-        l2cap_ertm_tx_packet_state_t * tx_state = &l2cap_channel->tx_packets_state[i];
+    int index = l2cap_channel->tx_read_index;
+    for (i=0;i<l2cap_channel->num_stored_tx_frames;i++){
+        l2cap_ertm_tx_packet_state_t * tx_state = &l2cap_channel->tx_packets_state[index];
         if (tx_state->tx_seq == tx_seq) return tx_state;
+        index++;
+        if (index >= l2cap_channel->num_tx_buffers){
+            index = 0;
+        }
     }
     return NULL;
 }
 
-// @param delta number of frames in the future, >= 1
+static int l2cap_ertm_rx_index_for_delta(l2cap_channel_t * l2cap_channel, int delta){
+    int index = l2cap_channel->rx_store_index + delta;
+    if (index >= l2cap_channel->num_rx_buffers){
+        index -= l2cap_channel->num_rx_buffers;
+    }
+    return index;
+}
+
+// @param delta number of frames in the future, >= 1 and < rx window size
 // @assumption size <= l2cap_channel->local_mps (checked in l2cap_acl_classic_handler)
 static void l2cap_ertm_handle_out_of_sequence_sdu(l2cap_channel_t * l2cap_channel, l2cap_segmentation_and_reassembly_t sar, int delta, const uint8_t * payload, uint16_t size){
     log_info("Store SDU with delta %u", delta);
     // get rx state for packet to store
-    int index = l2cap_channel->rx_store_index + delta - 1;
-    if (index > l2cap_channel->num_rx_buffers){
-        index -= l2cap_channel->num_rx_buffers;
-    }
+    int index = l2cap_ertm_rx_index_for_delta(l2cap_channel, delta);
     log_info("Index of packet to store %u", index);
     l2cap_ertm_rx_packet_state_t * rx_state = &l2cap_channel->rx_packets_state[index];
     // check if buffer is free
     if (rx_state->valid){
-        log_error("Packet buffer already used");
+        log_info("Duplicate frame with delta %u", delta);
         return;
     }
+    if (rx_state->srej_pending){
+        // retransmission not needed anymore
+        rx_state->srej_pending = 0;
+        l2cap_channel->num_pending_srej_frames--;
+    }
+    rx_state->srej_requested = 0;
     rx_state->valid = 1;
     rx_state->sar = sar;
     rx_state->len = size;
-    uint8_t * rx_buffer = &l2cap_channel->rx_packets_data[index];
+    uint8_t * rx_buffer = &l2cap_channel->rx_packets_data[index * l2cap_channel->local_mps];
     (void)memcpy(rx_buffer, payload, size);
+
+    // request selective retransmission of all missing frames before this one, that haven't been requested yet
+    int i;
+    for (i = 0; i < delta; i++){
+        index = l2cap_ertm_rx_index_for_delta(l2cap_channel, i);
+        rx_state = &l2cap_channel->rx_packets_state[index];
+        if (rx_state->valid) continue;
+        if (rx_state->srej_requested) continue;
+        rx_state->srej_requested = 1;
+        rx_state->srej_pending   = 1;
+        l2cap_channel->num_pending_srej_frames++;
+    }
+}
+
+// advance receive window by one frame
+static void l2cap_ertm_next_rx_store_index(l2cap_channel_t * l2cap_channel){
+    l2cap_ertm_rx_packet_state_t * rx_state = &l2cap_channel->rx_packets_state[l2cap_channel->rx_store_index];
+    if (rx_state->srej_pending){
+        l2cap_channel->num_pending_srej_frames--;
+    }
+    rx_state->valid          = 0;
+    rx_state->srej_requested = 0;
+    rx_state->srej_pending   = 0;
+    l2cap_channel->rx_store_index = l2cap_ertm_rx_index_for_delta(l2cap_channel, 1);
+    l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel, l2cap_channel->expected_tx_seq);
+    l2cap_channel->req_seq         = l2cap_channel->expected_tx_seq;
 }
 
 // @assumption size <= l2cap_channel->local_mps (checked in l2cap_acl_classic_handler)
@@ -845,18 +1134,72 @@ static void l2cap_ertm_channel_send_information_frame(l2cap_channel_t * channel)
     l2cap_ertm_send_information_frame(channel, index, 0);   // final = 0
 }
 
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+// frames are sent once and released right away
+static void l2cap_streaming_channel_send_information_frame(l2cap_channel_t * channel){
+    int index = channel->tx_read_index;
+    channel->tx_read_index++;
+    if (channel->tx_read_index >= channel->num_tx_buffers){
+        channel->tx_read_index = 0;
+    }
+    channel->tx_send_index = channel->tx_read_index;
+    channel->num_stored_tx_frames--;
+    l2cap_ertm_send_information_frame(channel, index, 0);   // final = 0
+    if (channel->waiting_for_can_send_now){
+        l2cap_ertm_notify_channel_can_send(channel);
+    }
+}
+#endif
+
 #endif
 
 #ifdef L2CAP_USES_CHANNELS
 static uint16_t l2cap_next_local_cid(void){
-    do {
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+    // prefer local cid with free slot in table to keep lookups constant-time
+    uint16_t attempts = L2CAP_LOCAL_CID_TABLE_SIZE;
+#endif
+    while (true){
         if (local_source_cid == 0xffff) {
             local_source_cid = 0x40;
         } else {
             local_source_cid++;
         }
-    } while (l2cap_get_channel_for_local_cid(local_source_cid) != NULL);
-    return local_source_cid;
+        if (l2cap_get_channel_for_local_cid(local_source_cid) != NULL) continue;
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+        if (attempts > 0){
+            attempts--;
+            if (l2cap_local_cid_table[local_source_cid & (L2CAP_LOCAL_CID_TABLE_SIZE - 1)] != NULL) continue;
+        }
+#endif
+        return local_source_cid;
+    }
+}
+
+static void l2cap_add_channel(l2cap_channel_t * channel){
+    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+    uint16_t index = channel->local_cid & (L2CAP_LOCAL_CID_TABLE_SIZE - 1);
+    if (l2cap_local_cid_table[index] == NULL){
+        l2cap_local_cid_table[index] = channel;
+    }
+#endif
+}
+
+static void l2cap_local_cid_table_remove(l2cap_channel_t * channel){
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+    uint16_t index = channel->local_cid & (L2CAP_LOCAL_CID_TABLE_SIZE - 1);
+    if (l2cap_local_cid_table[index] == channel){
+        l2cap_local_cid_table[index] = NULL;
+    }
+#else
+    UNUSED(channel);
+#endif
+}
+
+static void l2cap_remove_channel(l2cap_channel_t * channel){
+    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_local_cid_table_remove(channel);
 }
 #endif
 
@@ -873,6 +1216,9 @@ void l2cap_init(void){
     signaling_responses_pending = 0;
     
     l2cap_channels = NULL;
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+    memset(l2cap_local_cid_table, 0, sizeof(l2cap_local_cid_table));
+#endif
 
 #ifdef ENABLE_CLASSIC
     l2cap_services = NULL;
@@ -910,6 +1256,9 @@ void l2cap_init(void){
     hci_add_event_handler(&hci_event_callback_registration);
 
     hci_register_acl_packet_handler(&l2cap_acl_handler);
+#if defined(ENABLE_LE_DATA_CHANNELS) && defined(ENABLE_HCI_ACL_BUFFER_PROVIDER)
+    hci_register_acl_buffer_provider(&l2cap_le_acl_buffer_provider);
+#endif
 
 #ifdef ENABLE_CLASSIC
     gap_connectable_control(0); // no services yet
@@ -924,19 +1273,61 @@ void l2cap_register_packet_handler(void (*handler)(uint8_t packet_type, uint16_t
 #endif
 }
 
+#ifdef ENABLE_L2CAP_STATISTICS
+static uint16_t l2cap_statistics_num_channels_waiting(void){
+    uint16_t num_waiting = 0;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_fixed_channel_t * channel = (l2cap_fixed_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (channel->waiting_for_can_send_now){
+            num_waiting++;
+        }
+    }
+    return num_waiting;
+}
+
+static void l2cap_statistics_can_send_now_requested(void){
+    l2cap_statistics.can_send_now_requests++;
+    l2cap_statistics.can_send_now_waiting = l2cap_statistics_num_channels_waiting();
+    l2cap_statistics.can_send_now_waiting_max = btstack_max(l2cap_statistics.can_send_now_waiting_max, l2cap_statistics.can_send_now_waiting);
+}
+
+#ifdef ENABLE_LE_DATA_CHANNELS
+static void l2cap_statistics_credit_starvation_start(l2cap_channel_t * channel){
+    if (channel->statistics.credit_starvation_start_ms != 0) return;
+    channel->statistics.credit_starvation_count++;
+    channel->statistics.credit_starvation_start_ms = btstack_max(btstack_run_loop_get_time_ms(), 1);
+}
+
+static void l2cap_statistics_credit_starvation_end(l2cap_channel_t * channel){
+    if (channel->statistics.credit_starvation_start_ms == 0) return;
+    channel->statistics.credit_starvation_ms += btstack_run_loop_get_time_ms() - channel->statistics.credit_starvation_start_ms;
+    channel->statistics.credit_starvation_start_ms = 0;
+}
+#endif
+#endif
+
 void l2cap_request_can_send_fix_channel_now_event(hci_con_handle_t con_handle, uint16_t channel_id){
     UNUSED(con_handle);  // ok: there is no con handle
 
     l2cap_fixed_channel_t * channel = l2cap_fixed_channel_for_channel_id(channel_id);
     if (!channel) return;
     channel->waiting_for_can_send_now = 1;
+#ifdef ENABLE_L2CAP_STATISTICS
+    l2cap_statistics_can_send_now_requested();
+#endif
     l2cap_notify_channel_can_send();
 }
 
 int  l2cap_can_send_fixed_channel_packet_now(hci_con_handle_t con_handle, uint16_t channel_id){
     UNUSED(channel_id); // ok: only depends on Controller LE buffers
 
+#ifdef ENABLE_HCI_QOS_ARBITER
+    return hci_qos_can_send_acl_packet_now(con_handle, HCI_TRAFFIC_CLASS_INTERACTIVE);
+#else
     return hci_can_send_acl_packet_now(con_handle);
+#endif
 }
 
 uint8_t *l2cap_get_outgoing_buffer(void){
@@ -979,6 +1370,8 @@ int l2cap_send_prepared_connectionless(hci_con_handle_t con_handle, uint16_t cid
     
     log_debug("l2cap_send_prepared_connectionless handle %u, cid 0x%02x", con_handle, cid);
     
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_L2CAP_TX, cid, len);
+
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
     l2cap_setup_header(acl_buffer, con_handle, 0, cid, len);
     // send
@@ -1013,6 +1406,12 @@ static void l2cap_emit_can_send_now(btstack_packet_handler_t packet_handler, uin
 
 #ifdef L2CAP_USES_CHANNELS
 static void l2cap_dispatch_to_channel(l2cap_channel_t *channel, uint8_t type, uint8_t * data, uint16_t size){
+#ifdef ENABLE_L2CAP_STATISTICS
+    if (type == L2CAP_DATA_PACKET){
+        channel->statistics.packets_received++;
+        channel->statistics.bytes_received += size;
+    }
+#endif
     (* (channel->packet_handler))(type, channel->local_cid, data, size);
 }
 
@@ -1080,7 +1479,7 @@ static void l2cap_emit_incoming_connection(l2cap_channel_t *channel) {
 static void l2cap_handle_channel_open_failed(l2cap_channel_t * channel, uint8_t status){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // emit ertm buffer released, as it's not needed. if in basic mode, it was either not allocated or already released
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(channel)){
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
     }
 #endif
@@ -1090,7 +1489,7 @@ static void l2cap_handle_channel_open_failed(l2cap_channel_t * channel, uint8_t
 static void l2cap_handle_channel_closed(l2cap_channel_t * channel){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // emit ertm buffer released, as it's not needed anymore. if in basic mode, it was either not allocated or already released
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(channel)){
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
     }
 #endif
@@ -1120,15 +1519,58 @@ static l2cap_fixed_channel_t * l2cap_fixed_channel_for_channel_id(uint16_t local
 #ifdef L2CAP_USES_CHANNELS
 static l2cap_channel_t * l2cap_get_channel_for_local_cid(uint16_t local_cid){
     if (local_cid < 0x40) return NULL;
+#ifdef ENABLE_L2CAP_LOCAL_CID_TABLE
+    l2cap_channel_t * channel = l2cap_local_cid_table[local_cid & (L2CAP_LOCAL_CID_TABLE_SIZE - 1)];
+    if ((channel != NULL) && (channel->local_cid == local_cid)) return channel;
+#endif
     return (l2cap_channel_t*) l2cap_channel_item_by_cid(local_cid);
 }
 
+// check Controller buffers, without buffers reserved for higher priority traffic classes with ENABLE_HCI_QOS_ARBITER
+static int l2cap_channel_can_send_acl_packet_now(l2cap_channel_t * channel){
+#ifdef ENABLE_HCI_QOS_ARBITER
+    return hci_qos_can_send_acl_packet_now(channel->con_handle, channel->traffic_class);
+#else
+    return hci_can_send_acl_packet_now(channel->con_handle);
+#endif
+}
+
+// check Controller buffers for channel served by l2cap_notify_channel_can_send
+// with ENABLE_L2CAP_CAN_SEND_NOW_PER_CONNECTION, a connection does not wait for outgoing packets of other connections
+static int l2cap_channel_ready_to_send_acl_packet(l2cap_channel_t * channel){
+#if defined(ENABLE_L2CAP_CAN_SEND_NOW_PER_CONNECTION) || defined(ENABLE_HCI_QOS_ARBITER)
+    return l2cap_channel_can_send_acl_packet_now(channel);
+#else
+#ifdef ENABLE_CLASSIC
+    if (channel->address_type == BD_ADDR_TYPE_ACL){
+        return hci_can_send_acl_classic_packet_now();
+    }
+#endif
+    return hci_can_send_acl_le_packet_now();
+#endif
+}
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+uint8_t l2cap_set_traffic_class(uint16_t local_cid, hci_traffic_class_t traffic_class){
+    if (traffic_class >= HCI_TRAFFIC_CLASS_NUM) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    hci_qos_unregister_traffic_class(channel->address_type, channel->traffic_class);
+    channel->traffic_class = traffic_class;
+    hci_qos_register_traffic_class(channel->address_type, channel->traffic_class);
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 void l2cap_request_can_send_now_event(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return;
     channel->waiting_for_can_send_now = 1;
+#ifdef ENABLE_L2CAP_STATISTICS
+    l2cap_statistics_can_send_now_requested();
+#endif
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(channel)){
         l2cap_ertm_notify_channel_can_send(channel);
         return;
     }
@@ -1140,18 +1582,18 @@ int  l2cap_can_send_packet_now(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return 0;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(channel)){
         return l2cap_ertm_can_store_packet_now(channel);
     }
 #endif    
-    return hci_can_send_acl_packet_now(channel->con_handle);
+    return l2cap_channel_can_send_acl_packet_now(channel);
 }
 
 int  l2cap_can_send_prepared_packet_now(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return 0;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(channel)){
         return 0;
     }
 #endif
@@ -1165,6 +1607,29 @@ uint16_t l2cap_get_remote_mtu_for_local_cid(uint16_t local_cid){
     } 
     return 0;
 }
+
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+uint8_t l2cap_set_flushable(uint16_t local_cid, bool flushable){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    channel->flushable = flushable;
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+static uint8_t l2cap_classic_packet_boundary_flag(l2cap_channel_t * channel){
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+    // first automatically flushable packet, late media data is dropped by Controller after automatic flush timeout
+    if (channel->flushable) return 0x02;
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+    if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE) return 0x02;
+#endif
+#else
+    UNUSED(channel);
+#endif
+    // set non-flushable packet boundary flag if supported on Controller
+    return hci_non_flushable_packet_boundary_flag_supported() ? 0x00 : 0x02;
+}
 #endif
 
 #ifdef L2CAP_USES_CHANNELS
@@ -1179,6 +1644,45 @@ static int l2cap_is_dynamic_channel_type(l2cap_channel_type_t channel_type){
 }
 #endif
 
+#ifdef ENABLE_L2CAP_STATISTICS
+const l2cap_statistics_t * l2cap_get_statistics(void){
+    l2cap_statistics.can_send_now_waiting = l2cap_statistics_num_channels_waiting();
+    return &l2cap_statistics;
+}
+
+const l2cap_channel_statistics_t * l2cap_get_channel_statistics(uint16_t local_cid){
+#ifdef L2CAP_USES_CHANNELS
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (channel == NULL) return NULL;
+    return &channel->statistics;
+#else
+    UNUSED(local_cid);
+    return NULL;
+#endif
+}
+
+void l2cap_statistics_dump(void){
+    l2cap_statistics.can_send_now_waiting = l2cap_statistics_num_channels_waiting();
+    log_info("can send now: requests %u, waiting %u, max waiting %u", (unsigned int) l2cap_statistics.can_send_now_requests,
+             l2cap_statistics.can_send_now_waiting, l2cap_statistics.can_send_now_waiting_max);
+#ifdef L2CAP_USES_CHANNELS
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
+        log_info("cid 0x%04x: tx %u packets / %u bytes, rx %u packets / %u bytes, ertm retransmissions %u, timeouts %u, max tx queue %u, credit starvation %u times / %u ms",
+                 channel->local_cid,
+                 (unsigned int) channel->statistics.packets_sent, (unsigned int) channel->statistics.bytes_sent,
+                 (unsigned int) channel->statistics.packets_received, (unsigned int) channel->statistics.bytes_received,
+                 (unsigned int) channel->statistics.ertm_retransmissions, (unsigned int) channel->statistics.ertm_timeouts,
+                 channel->statistics.ertm_tx_queue_max,
+                 (unsigned int) channel->statistics.credit_starvation_count, (unsigned int) channel->statistics.credit_starvation_ms);
+    }
+#endif
+}
+#endif
+
 #ifdef ENABLE_CLASSIC
 // RTX Timer only exist for dynamic channels
 static l2cap_channel_t * l2cap_channel_for_rtx_timer(btstack_timer_source_t * ts){
@@ -1206,7 +1710,7 @@ static void l2cap_rtx_timeout(btstack_timer_source_t * ts){
     l2cap_handle_channel_open_failed(channel, L2CAP_CONNECTION_RESPONSE_RESULT_RTX_TIMEOUT);
 
     // discard channel
-    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_remove_channel(channel);
     l2cap_free_channel_entry(channel);
 }
 
@@ -1283,18 +1787,21 @@ int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
     }
     
     log_debug("l2cap_send_prepared cid 0x%02x, handle %u, 1 credit used", local_cid, channel->con_handle);
-    
+
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_L2CAP_TX, local_cid, len);
+    L2CAP_STATISTICS_ADD(channel, packets_sent, 1);
+    L2CAP_STATISTICS_ADD(channel, bytes_sent, len);
+
     int fcs_size = 0;
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION && channel->fcs_option){
+    if (l2cap_ertm_framing(channel) && channel->fcs_option){
         fcs_size = 2;
     }
 #endif
 
-    // set non-flushable packet boundary flag if supported on Controller
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
-    uint8_t packet_boundary_flag = hci_non_flushable_packet_boundary_flag_supported() ? 0x00 : 0x02;
+    uint8_t packet_boundary_flag = l2cap_classic_packet_boundary_flag(channel);
     l2cap_setup_header(acl_buffer, channel->con_handle, packet_boundary_flag, channel->remote_cid, len + fcs_size);
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
@@ -1320,7 +1827,7 @@ int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // send in ERTM
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(channel)){
         return l2cap_ertm_send(channel, data, len);
     }
 #endif
@@ -1341,6 +1848,68 @@ int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
     return l2cap_send_prepared(local_cid, len);
 }
 
+// assumption - only on Classic connections
+// cannot be used for L2CAP ERTM
+int l2cap_send_iov(uint16_t local_cid, const btstack_iovec_t * iov, uint16_t iov_count){
+    // ACL and L2CAP header for packet in flight
+    static uint8_t l2cap_iov_header[8];
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send_iov no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+    if (l2cap_ertm_framing(channel)){
+        log_error("l2cap_send_iov cid 0x%02x, not supported in ERTM", local_cid);
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+#endif
+
+    // sum up in 32 bit to detect iov lists exceeding 64 kB
+    uint32_t total_len = 0;
+    uint16_t i;
+    for (i = 0; i < iov_count; i++){
+        total_len += iov[i].len;
+    }
+    if (total_len > channel->remote_mtu){
+        log_error("l2cap_send_iov cid 0x%02x, data length exceeds remote MTU.", local_cid);
+        return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
+    }
+    uint16_t len = (uint16_t) total_len;
+
+    if (!hci_can_send_acl_packet_now(channel->con_handle)){
+        log_info("l2cap_send_iov cid 0x%02x, cannot send", local_cid);
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    // too many buffers for transport, gather into outgoing buffer
+    if (iov_count >= HCI_TRANSPORT_IOV_MAX){
+        hci_reserve_packet_buffer();
+        uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
+        uint16_t pos = 8;
+        for (i = 0; i < iov_count; i++){
+            (void)memcpy(&acl_buffer[pos], iov[i].base, iov[i].len);
+            pos += iov[i].len;
+        }
+        return l2cap_send_prepared(local_cid, len);
+    }
+
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_L2CAP_TX, local_cid, len);
+    L2CAP_STATISTICS_ADD(channel, packets_sent, 1);
+    L2CAP_STATISTICS_ADD(channel, bytes_sent, len);
+
+    uint8_t packet_boundary_flag = l2cap_classic_packet_boundary_flag(channel);
+    l2cap_setup_header(l2cap_iov_header, channel->con_handle, packet_boundary_flag, channel->remote_cid, len);
+
+    btstack_iovec_t acl_iov[HCI_TRANSPORT_IOV_MAX];
+    acl_iov[0].base = l2cap_iov_header;
+    acl_iov[0].len  = sizeof(l2cap_iov_header);
+    (void)memcpy(&acl_iov[1], iov, iov_count * sizeof(btstack_iovec_t));
+    return hci_send_acl_iov(acl_iov, iov_count + 1);
+}
+
 int l2cap_send_echo_request(hci_con_handle_t con_handle, uint8_t *data, uint16_t len){
     return l2cap_send_signaling_packet(con_handle, ECHO_REQUEST, 0x77, len, data);
 }
@@ -1405,14 +1974,14 @@ static uint16_t l2cap_setup_options_mtu(uint8_t * config_options, uint16_t mtu){
 static int l2cap_ertm_mode(l2cap_channel_t * channel){
     hci_connection_t * connection = hci_connection_for_handle(channel->con_handle);
     return ((connection->l2cap_state.information_state == L2CAP_INFORMATION_STATE_DONE) 
-        &&  (connection->l2cap_state.extended_feature_mask & 0x08));
+        &&  (connection->l2cap_state.extended_feature_mask & l2cap_ertm_extended_feature_for_mode(channel)));
 }
 #endif
 
 static uint16_t l2cap_setup_options_request(l2cap_channel_t * channel, uint8_t * config_options){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // use ERTM options if supported by remote and channel ready to use it
-    if (l2cap_ertm_mode(channel) && channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_mode(channel) && l2cap_ertm_framing(channel)){
         return l2cap_setup_options_ertm_request(channel, config_options);
     }
 #endif
@@ -1430,6 +1999,14 @@ static uint32_t l2cap_extended_features_mask(void){
     uint32_t features = 0x280;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     features |= 0x0028;
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+    // Streaming Mode
+    features |= 0x0010;
+#endif
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+    // Extended Window Size
+    features |= 0x0100;
+#endif
 #endif
     return features;
 }
@@ -1442,7 +2019,7 @@ static uint32_t l2cap_extended_features_mask(void){
 static bool l2cap_run_for_classic_channel(l2cap_channel_t * channel){
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    uint8_t  config_options[18];
+    uint8_t  config_options[22];
 #else
     uint8_t  config_options[10];
 #endif
@@ -1472,7 +2049,7 @@ static bool l2cap_run_for_classic_channel(l2cap_channel_t * channel){
             channel->state = L2CAP_STATE_INVALID;
             l2cap_send_signaling_packet(channel->con_handle, CONNECTION_RESPONSE, channel->remote_sig_id, channel->local_cid, channel->remote_cid, channel->reason, 0);
             // discard channel - l2cap_finialize_channel_close without sending l2cap close event
-            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+            l2cap_remove_channel(channel);
             l2cap_free_channel_entry(channel);
             channel = NULL;
             break;
@@ -1497,7 +2074,7 @@ static bool l2cap_run_for_classic_channel(l2cap_channel_t * channel){
             if (!hci_can_send_acl_packet_now(channel->con_handle)) return false;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
             // fallback to basic mode if ERTM requested but not not supported by remote
-            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+            if (l2cap_ertm_framing(channel)){
                 if (!l2cap_ertm_mode(channel)){
                     l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
                     channel->mode = L2CAP_CHANNEL_MODE_BASIC;
@@ -1586,7 +2163,7 @@ static void l2cap_run_for_classic_channel_ertm(l2cap_channel_t * channel){
     if (channel->send_supervisor_frame_receiver_ready){
         channel->send_supervisor_frame_receiver_ready = 0;
         log_info("Send S-Frame: RR %u, final %u", channel->req_seq, channel->set_final_bit_after_packet_with_poll_bit_set);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 0,  channel->set_final_bit_after_packet_with_poll_bit_set, channel->req_seq);
+        uint32_t control = l2cap_encanced_control_field_for_supevisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 0,  channel->set_final_bit_after_packet_with_poll_bit_set, channel->req_seq);
         channel->set_final_bit_after_packet_with_poll_bit_set = 0;
         l2cap_ertm_send_supervisor_frame(channel, control);
         return;
@@ -1594,46 +2171,70 @@ static void l2cap_run_for_classic_channel_ertm(l2cap_channel_t * channel){
     if (channel->send_supervisor_frame_receiver_ready_poll){
         channel->send_supervisor_frame_receiver_ready_poll = 0;
         log_info("Send S-Frame: RR %u with poll=1 ", channel->req_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 1, 0, channel->req_seq);
+        uint32_t control = l2cap_encanced_control_field_for_supevisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 1, 0, channel->req_seq);
         l2cap_ertm_send_supervisor_frame(channel, control);
         return;
     }
     if (channel->send_supervisor_frame_receiver_not_ready){
         channel->send_supervisor_frame_receiver_not_ready = 0;
         log_info("Send S-Frame: RNR %u", channel->req_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_RNR_RECEIVER_NOT_READY, 0, 0, channel->req_seq);
+        uint32_t control = l2cap_encanced_control_field_for_supevisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_RNR_RECEIVER_NOT_READY, 0, 0, channel->req_seq);
         l2cap_ertm_send_supervisor_frame(channel, control);
         return;
     }
     if (channel->send_supervisor_frame_reject){
         channel->send_supervisor_frame_reject = 0;
         log_info("Send S-Frame: REJ %u", channel->req_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_REJ_REJECT, 0, 0, channel->req_seq);
+        uint32_t control = l2cap_encanced_control_field_for_supevisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_REJ_REJECT, 0, 0, channel->req_seq);
         l2cap_ertm_send_supervisor_frame(channel, control);
         return;
     }
     if (channel->send_supervisor_frame_selective_reject){
         channel->send_supervisor_frame_selective_reject = 0;
         log_info("Send S-Frame: SREJ %u", channel->expected_tx_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_SREJ_SELECTIVE_REJECT, 0, channel->set_final_bit_after_packet_with_poll_bit_set, channel->expected_tx_seq);
+        uint32_t control = l2cap_encanced_control_field_for_supevisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_SREJ_SELECTIVE_REJECT, 0, channel->set_final_bit_after_packet_with_poll_bit_set, channel->expected_tx_seq);
         channel->set_final_bit_after_packet_with_poll_bit_set = 0;
         l2cap_ertm_send_supervisor_frame(channel, control);
         return;
     }
+    if (channel->num_pending_srej_frames){
+        // request missing frames one by one, oldest first
+        int i;
+        uint16_t rx_window_size = l2cap_ertm_rx_window_size(channel);
+        for (i=0;i<rx_window_size;i++){
+            l2cap_ertm_rx_packet_state_t * rx_state = &channel->rx_packets_state[l2cap_ertm_rx_index_for_delta(channel, i)];
+            if (!rx_state->srej_pending) continue;
+            rx_state->srej_pending = 0;
+            channel->num_pending_srej_frames--;
+            uint16_t tx_seq = (channel->expected_tx_seq + i) & l2cap_ertm_seq_nr_mask(channel);
+            log_info("Send S-Frame: SREJ %u", tx_seq);
+            uint32_t control = l2cap_encanced_control_field_for_supevisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_SREJ_SELECTIVE_REJECT, 0, 0, tx_seq);
+            l2cap_ertm_send_supervisor_frame(channel, control);
+            return;
+        }
+        channel->num_pending_srej_frames = 0;
+    }
 
     if (channel->srej_active){
+        // retransmit requested frames in order
         int i;
-        for (i=0;i<channel->num_tx_buffers;i++){
-            l2cap_ertm_tx_packet_state_t * tx_state = &channel->tx_packets_state[i];
+        int index = channel->tx_read_index;
+        for (i=0;i<channel->num_stored_tx_frames;i++){
+            l2cap_ertm_tx_packet_state_t * tx_state = &channel->tx_packets_state[index];
             if (tx_state->retransmission_requested) {
                 tx_state->retransmission_requested = 0;
+                L2CAP_STATISTICS_ADD(channel, ertm_retransmissions, 1);
                 uint8_t final = channel->set_final_bit_after_packet_with_poll_bit_set;
                 channel->set_final_bit_after_packet_with_poll_bit_set = 0;
-                l2cap_ertm_send_information_frame(channel, i, final);
+                l2cap_ertm_send_information_frame(channel, index, final);
                 break;
             }
+            index++;
+            if (index >= channel->num_tx_buffers){
+                index = 0;
+            }
         }
-        if (i == channel->num_tx_buffers){
+        if (i == channel->num_stored_tx_frames){
             // no retransmission request found
             channel->srej_active = 0;
         } else {
@@ -1645,31 +2246,46 @@ static void l2cap_run_for_classic_channel_ertm(l2cap_channel_t * channel){
 #endif /* ERTM */
 #endif /* Classic */
 
+static void l2cap_remove_signaling_response(int index){
+    signaling_responses_pending--;
+    int i;
+    for (i=index; i < signaling_responses_pending; i++){
+        (void)memcpy(&signaling_responses[i],
+                     &signaling_responses[i + 1],
+                     sizeof(l2cap_signaling_response_t));
+    }
+}
+
 static void l2cap_run_signaling_response(void) {
 
-    // check pending signaling responses
-    while (signaling_responses_pending){
+    // send all pending signaling responses that can be sent now. responses for a connection without
+    // ACL buffers are kept in order, while responses for other connections go out in the same pass
+    int index = 0;
+    while (index < signaling_responses_pending){
 
-        hci_con_handle_t handle = signaling_responses[0].handle;
+        hci_con_handle_t handle = signaling_responses[index].handle;
 
-        if (!hci_can_send_acl_packet_now(handle)) break;
+        // drop responses for closed connections, they would block the queue otherwise
+        if (hci_connection_for_handle(handle) == NULL){
+            l2cap_remove_signaling_response(index);
+            continue;
+        }
 
-        uint8_t  sig_id        = signaling_responses[0].sig_id;
-        uint8_t  response_code = signaling_responses[0].code;
-        uint16_t result        = signaling_responses[0].data;  // CONNECTION_REQUEST, COMMAND_REJECT
+        if (!hci_can_send_acl_packet_now(handle)) {
+            index++;
+            continue;
+        }
+
+        uint8_t  sig_id        = signaling_responses[index].sig_id;
+        uint8_t  response_code = signaling_responses[index].code;
+        uint16_t result        = signaling_responses[index].data;  // CONNECTION_REQUEST, COMMAND_REJECT
 #ifdef ENABLE_CLASSIC
-        uint16_t info_type     = signaling_responses[0].data;  // INFORMATION_REQUEST
-        uint16_t source_cid    = signaling_responses[0].cid;   // CONNECTION_REQUEST
+        uint16_t info_type     = signaling_responses[index].data;  // INFORMATION_REQUEST
+        uint16_t source_cid    = signaling_responses[index].cid;   // CONNECTION_REQUEST
 #endif
 
-        // remove first item before sending (to avoid sending response mutliple times)
-        signaling_responses_pending--;
-        int i;
-        for (i=0; i < signaling_responses_pending; i++){
-            (void)memcpy(&signaling_responses[i],
-                         &signaling_responses[i + 1],
-                         sizeof(l2cap_signaling_response_t));
-        }
+        // remove item before sending (to avoid sending response mutliple times)
+        l2cap_remove_signaling_response(index);
 
         switch (response_code){
 #ifdef ENABLE_CLASSIC
@@ -1729,21 +2345,22 @@ static void l2cap_run_signaling_response(void) {
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 static bool l2ap_run_ertm(void){
-    // send l2cap information request if neccessary
+    // send l2cap information request if neccessary, for all connections that can send now
+    bool sent = false;
     btstack_linked_list_iterator_t it;
     hci_connections_get_iterator(&it);
     while(btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         if (connection->l2cap_state.information_state == L2CAP_INFORMATION_STATE_W2_SEND_EXTENDED_FEATURE_REQUEST){
-            if (!hci_can_send_acl_packet_now(connection->con_handle)) break;
+            if (!hci_can_send_acl_packet_now(connection->con_handle)) continue;
             connection->l2cap_state.information_state = L2CAP_INFORMATION_STATE_W4_EXTENDED_FEATURE_RESPONSE;
             uint8_t sig_id = l2cap_next_sig_id();
             uint8_t info_type = L2CAP_INFO_TYPE_EXTENDED_FEATURES_SUPPORTED;
             l2cap_send_signaling_packet(connection->con_handle, INFORMATION_REQUEST, sig_id, info_type);
-            return true;
+            sent = true;
         }
     }
-    return false;
+    return sent;
 }
 #endif
 
@@ -1786,6 +2403,7 @@ static void l2cap_run_le_data_channels(void){
                 l2cap_send_le_signaling_packet(channel->con_handle, LE_CREDIT_BASED_CONNECTION_RESPONSE, channel->remote_sig_id, 0, 0, 0, 0, channel->reason);
                 // discard channel - l2cap_finialize_channel_close without sending l2cap close event
                 btstack_linked_list_iterator_remove(&it);
+                l2cap_local_cid_table_remove(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             case L2CAP_STATE_OPEN:
@@ -1821,6 +2439,60 @@ static void l2cap_run_le_data_channels(void){
 }
 #endif
 
+#ifdef ENABLE_BLE
+// @return true if signaling packet was sent
+static bool l2cap_run_le_con_parameter_update_for_connection(hci_connection_t * connection){
+    if ((connection->address_type != BD_ADDR_TYPE_LE_PUBLIC) && (connection->address_type != BD_ADDR_TYPE_LE_RANDOM)) return false;
+    if (!hci_can_send_acl_packet_now(connection->con_handle)) return false;
+    switch (connection->le_con_parameter_update_state){
+        case CON_PARAMETER_UPDATE_SEND_REQUEST:
+            connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
+            l2cap_send_le_signaling_packet(connection->con_handle, CONNECTION_PARAMETER_UPDATE_REQUEST, l2cap_next_sig_id(),
+                                           connection->le_conn_interval_min, connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout);
+            return true;
+        case CON_PARAMETER_UPDATE_SEND_RESPONSE:
+            connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS;
+            l2cap_send_le_signaling_packet(connection->con_handle, CONNECTION_PARAMETER_UPDATE_RESPONSE, connection->le_con_param_update_identifier, 0);
+            return true;
+        case CON_PARAMETER_UPDATE_DENY:
+            connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
+            l2cap_send_le_signaling_packet(connection->con_handle, CONNECTION_PARAMETER_UPDATE_RESPONSE, connection->le_con_param_update_identifier, 1);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// send l2cap con parameter updates for all connections as ACL buffers allow. LE ACL buffers are shared,
+// so start after connection served last, connections further back in the list are not starved after mass reconnects
+static void l2cap_run_le_con_parameter_updates(void){
+    hci_con_handle_t start_after = l2cap_le_con_parameter_update_last_handle;
+    bool found = false;
+    btstack_linked_list_iterator_t it;
+    // connections after the last served one
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (!found){
+            found = (connection->con_handle == start_after);
+            continue;
+        }
+        if (l2cap_run_le_con_parameter_update_for_connection(connection)){
+            l2cap_le_con_parameter_update_last_handle = connection->con_handle;
+        }
+    }
+    // remaining connections, all of them if last served one is gone
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (l2cap_run_le_con_parameter_update_for_connection(connection)){
+            l2cap_le_con_parameter_update_last_handle = connection->con_handle;
+        }
+        if (found && (connection->con_handle == start_after)) break;
+    }
+}
+#endif
+
 // MARK: L2CAP_RUN
 // process outstanding signaling tasks
 static void l2cap_run(void){
@@ -1833,11 +2505,8 @@ static void l2cap_run(void){
     if (done) return;
 #endif
 
-#if defined(ENABLE_CLASSIC) || defined(ENABLE_BLE)
-    btstack_linked_list_iterator_t it;
-#endif
-
 #ifdef ENABLE_CLASSIC
+    btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &l2cap_channels);
     while (btstack_linked_list_iterator_has_next(&it)){
 
@@ -1856,35 +2525,13 @@ static void l2cap_run(void){
     }
 #endif
 
-#ifdef ENABLE_LE_DATA_CHANNELS
-    l2cap_run_le_data_channels();
-    #endif
-
-#ifdef ENABLE_BLE
-    // send l2cap con paramter update if necessary
-    hci_connections_get_iterator(&it);
-    while(btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
-        if ((connection->address_type != BD_ADDR_TYPE_LE_PUBLIC) && (connection->address_type != BD_ADDR_TYPE_LE_RANDOM)) continue;
-        if (!hci_can_send_acl_packet_now(connection->con_handle)) continue;
-        switch (connection->le_con_parameter_update_state){
-            case CON_PARAMETER_UPDATE_SEND_REQUEST:
-                connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                l2cap_send_le_signaling_packet(connection->con_handle, CONNECTION_PARAMETER_UPDATE_REQUEST, l2cap_next_sig_id(),
-                                               connection->le_conn_interval_min, connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout);
-                break;
-            case CON_PARAMETER_UPDATE_SEND_RESPONSE:
-                connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS;
-                l2cap_send_le_signaling_packet(connection->con_handle, CONNECTION_PARAMETER_UPDATE_RESPONSE, connection->le_con_param_update_identifier, 0);
-                break;
-            case CON_PARAMETER_UPDATE_DENY:
-                connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                l2cap_send_le_signaling_packet(connection->con_handle, CONNECTION_PARAMETER_UPDATE_RESPONSE, connection->le_con_param_update_identifier, 1);
-                break;
-            default:
-                break;
-        }
-    }
+#ifdef ENABLE_LE_DATA_CHANNELS
+    l2cap_run_le_data_channels();
+    #endif
+
+#ifdef ENABLE_BLE
+    // send l2cap con paramter update if necessary
+    l2cap_run_le_con_parameter_updates();
 #endif
 
     // log_info("l2cap_run: exit");
@@ -1963,6 +2610,11 @@ static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t pac
     channel->remote_sig_id = L2CAP_SIG_ID_INVALID;
     channel->local_sig_id = L2CAP_SIG_ID_INVALID;
 
+#ifdef ENABLE_HCI_QOS_ARBITER
+    channel->traffic_class = HCI_TRAFFIC_CLASS_BULK;
+    hci_qos_register_traffic_class(channel->address_type, channel->traffic_class);
+#endif
+
     log_info("create channel %p, local_cid 0x%04x", channel, channel->local_cid);
 
     return channel;
@@ -1975,6 +2627,9 @@ static void l2cap_free_channel_entry(l2cap_channel_t * channel){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     l2cap_ertm_stop_retransmission_timer(channel);
     l2cap_ertm_stop_monitor_timer(channel);
+#endif
+#ifdef ENABLE_HCI_QOS_ARBITER
+    hci_qos_unregister_traffic_class(channel->address_type, channel->traffic_class);
 #endif
     // free  memory
     btstack_memory_l2cap_channel_free(channel);
@@ -2008,7 +2663,7 @@ uint8_t l2cap_create_channel(btstack_packet_handler_t channel_packet_handler, bd
 #endif    
 
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // store local_cid
     if (out_local_cid){
@@ -2073,7 +2728,7 @@ static void l2cap_handle_connection_failed_for_addr(bd_addr_t address, uint8_t s
                 // failure, forward error code
                 l2cap_handle_channel_open_failed(channel, status);
                 // discard channel
-                btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             }
@@ -2105,11 +2760,18 @@ static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
             // send if we have more data and remote windows isn't full yet
             if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) {
                 if (channel->unacked_frames >= btstack_min(channel->num_stored_tx_frames, channel->remote_tx_window_size)) return false;
-                return hci_can_send_acl_classic_packet_now() != 0;
+                return l2cap_channel_ready_to_send_acl_packet(channel) != 0;
+            }
+#endif
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+            // send if we have more data, no window in streaming mode
+            if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE) {
+                if (channel->num_stored_tx_frames == 0) return false;
+                return l2cap_channel_ready_to_send_acl_packet(channel) != 0;
             }
 #endif
             if (!channel->waiting_for_can_send_now) return false;
-            return (hci_can_send_acl_classic_packet_now() != 0);
+            return (l2cap_channel_ready_to_send_acl_packet(channel) != 0);
         case L2CAP_CHANNEL_TYPE_CONNECTIONLESS:
             if (!channel->waiting_for_can_send_now) return false;
             return hci_can_send_acl_classic_packet_now() != 0;
@@ -2117,12 +2779,21 @@ static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
 #ifdef ENABLE_BLE
         case L2CAP_CHANNEL_TYPE_LE_FIXED:
             if (!channel->waiting_for_can_send_now) return false;
+#ifdef ENABLE_HCI_QOS_ARBITER
+            return hci_qos_can_send_acl_le_packet_now(HCI_TRAFFIC_CLASS_INTERACTIVE) != 0;
+#else
             return hci_can_send_acl_le_packet_now() != 0;
+#endif
 #ifdef ENABLE_LE_DATA_CHANNELS
         case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
             if (channel->send_sdu_buffer == NULL) return false;
-            if (channel->credits_outgoing == 0) return false;
-            return hci_can_send_acl_le_packet_now() != 0;
+            if (channel->credits_outgoing == 0) {
+#ifdef ENABLE_L2CAP_STATISTICS
+                l2cap_statistics_credit_starvation_start(channel);
+#endif
+                return false;
+            }
+            return l2cap_channel_ready_to_send_acl_packet(channel) != 0;
 #endif
 #endif
         default:
@@ -2139,6 +2810,12 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
                 l2cap_ertm_channel_send_information_frame(channel);
                 return;
             }
+#endif
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+            if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE) {
+                l2cap_streaming_channel_send_information_frame(channel);
+                return;
+            }
 #endif
             channel->waiting_for_can_send_now = 0;
             l2cap_emit_can_send_now(channel->packet_handler, channel->local_cid);
@@ -2164,7 +2841,127 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
     }
 }
 
+#ifdef ENABLE_L2CAP_WEIGHTED_SCHEDULING
+static hci_connection_t * l2cap_scheduling_connection_for_channel(l2cap_channel_t * channel){
+#ifdef L2CAP_USES_CHANNELS
+    if (!l2cap_is_dynamic_channel_type(channel->channel_type)) return NULL;
+    return hci_connection_for_handle(channel->con_handle);
+#else
+    UNUSED(channel);    // ok: no dynamic channels
+    return NULL;
+#endif
+}
+
+// low latency connections first, then deficit round-robin weighted per connection. Fixed channels are always eligible
+static l2cap_channel_t * l2cap_scheduling_next_channel(void){
+    while (true){
+        l2cap_channel_t * eligible = NULL;
+        bool ready_without_deficit = false;
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &l2cap_channels);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            if (!l2cap_channel_ready_to_send(channel)) continue;
+            hci_connection_t * connection = l2cap_scheduling_connection_for_channel(channel);
+            if (connection == NULL){
+                if (eligible == NULL) eligible = channel;
+                continue;
+            }
+            if (connection->l2cap_scheduling_low_latency) return channel;
+            if (connection->l2cap_scheduling_deficit > 0){
+                if (eligible == NULL) eligible = channel;
+            } else {
+                ready_without_deficit = true;
+            }
+        }
+        if (eligible != NULL) return eligible;
+        if (!ready_without_deficit) return NULL;
+
+        // start next round
+        btstack_linked_list_iterator_init(&it, &l2cap_channels);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            hci_connection_t * connection = l2cap_scheduling_connection_for_channel(channel);
+            if (connection == NULL) continue;
+            connection->l2cap_scheduling_deficit = connection->l2cap_scheduling_weight;
+        }
+    }
+}
+
+uint8_t l2cap_set_connection_scheduling(hci_con_handle_t con_handle, uint8_t weight, bool low_latency){
+    if (weight == 0) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (connection == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    connection->l2cap_scheduling_weight = weight;
+    connection->l2cap_scheduling_low_latency = low_latency;
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+static hci_traffic_class_t l2cap_channel_traffic_class(l2cap_channel_t * channel){
+    switch (channel->channel_type){
+        case L2CAP_CHANNEL_TYPE_LE_FIXED:
+            return HCI_TRAFFIC_CLASS_INTERACTIVE;
+        case L2CAP_CHANNEL_TYPE_CONNECTIONLESS:
+            return HCI_TRAFFIC_CLASS_BULK;
+        default:
+            // only dynamic channels have a traffic class field
+            return channel->traffic_class;
+    }
+}
+
+// ready channel with highest priority traffic class, first in list for equal priority
+static l2cap_channel_t * l2cap_qos_next_channel(void){
+    l2cap_channel_t * next_channel = NULL;
+    hci_traffic_class_t next_traffic_class = HCI_TRAFFIC_CLASS_NUM;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        hci_traffic_class_t traffic_class = l2cap_channel_traffic_class(channel);
+        if (traffic_class >= next_traffic_class) continue;
+        if (!l2cap_channel_ready_to_send(channel)) continue;
+        next_channel = channel;
+        next_traffic_class = traffic_class;
+        if (traffic_class == HCI_TRAFFIC_CLASS_VOICE) break;
+    }
+    return next_channel;
+}
+#endif
+
 static void l2cap_notify_channel_can_send(void){
+#ifdef ENABLE_L2CAP_WEIGHTED_SCHEDULING
+    while (true){
+        l2cap_channel_t * channel = l2cap_scheduling_next_channel();
+        if (channel == NULL) break;
+
+        // charge connection
+        hci_connection_t * connection = l2cap_scheduling_connection_for_channel(channel);
+        if ((connection != NULL) && (connection->l2cap_scheduling_deficit > 0)){
+            connection->l2cap_scheduling_deficit--;
+        }
+
+        // requeue channel for fairness
+        btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+        btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+
+        // trigger sending
+        l2cap_channel_trigger_send(channel);
+    }
+#elif defined(ENABLE_HCI_QOS_ARBITER)
+    while (true){
+        l2cap_channel_t * channel = l2cap_qos_next_channel();
+        if (channel == NULL) break;
+
+        // requeue channel for fairness within traffic class
+        btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+        btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+
+        // trigger sending
+        l2cap_channel_trigger_send(channel);
+    }
+#else
     bool done = false;
     while (!done){
         done = true;
@@ -2187,6 +2984,7 @@ static void l2cap_notify_channel_can_send(void){
             break;
         }
     }
+#endif
 }
 
 #ifdef L2CAP_USES_CHANNELS
@@ -2332,6 +3130,7 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
                 if (channel->con_handle != handle) continue;
                 btstack_linked_list_iterator_remove(&it);
+                l2cap_local_cid_table_remove(channel);
                 switch(channel->channel_type){
 #ifdef ENABLE_CLASSIC
                     case L2CAP_CHANNEL_TYPE_CLASSIC:
@@ -2501,7 +3300,7 @@ static void l2cap_handle_connection_request(hci_con_handle_t handle, uint8_t sig
     channel->state_var  = (L2CAP_CHANNEL_STATE_VAR) (L2CAP_CHANNEL_STATE_VAR_SEND_CONN_RESP_PEND | L2CAP_CHANNEL_STATE_VAR_INCOMING);
     
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // assert security requirements
     gap_request_security_level(handle, channel->required_security_level);
@@ -2544,6 +3343,9 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     uint8_t use_fcs = 1;
 #endif
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+    uint16_t extended_window_size = 0;
+#endif
 
     channel->remote_sig_id = command[L2CAP_SIGNALING_COMMAND_SIGID_OFFSET];
 
@@ -2583,6 +3385,9 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
             l2cap_channel_mode_t mode = (l2cap_channel_mode_t) command[pos];
             switch(channel->mode){
                 case L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION:
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+                case L2CAP_CHANNEL_MODE_STREAMING_MODE:
+#endif
                     // Store remote config
                     channel->remote_tx_window_size = command[pos+1];
                     channel->remote_max_transmit   = command[pos+2];
@@ -2595,8 +3400,8 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
                         channel->remote_retransmission_timeout_ms,
                         channel->remote_monitor_timeout_ms,
                         channel->remote_mps);
-                    // If ERTM mandatory, but remote doens't offer ERTM -> disconnect
-                    if (channel->ertm_mandatory && mode != L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+                    // If ERTM / Streaming Mode mandatory, but remote doens't offer it -> disconnect
+                    if (channel->ertm_mandatory && mode != channel->mode){
                         channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
                     } else {
                         channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_SEND_CONF_RSP_ERTM);
@@ -2605,6 +3410,9 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
                 case L2CAP_CHANNEL_MODE_BASIC:
                     switch (mode){
                         case L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION:
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+                        case L2CAP_CHANNEL_MODE_STREAMING_MODE:
+#endif
                             // remote asks for ERTM, but we want basic mode. disconnect if this happens a second time
                             if (channel->state_var & L2CAP_CHANNEL_STATE_VAR_BASIC_FALLBACK_TRIED){
                                 channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
@@ -2626,6 +3434,12 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
             use_fcs = command[pos];
         }        
 #endif        
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+        // Extended Window Size { type(8): 7, len(8): 2, Max Window Size(16) }
+        if ((option_type == L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE) && (length == 2)){
+            extended_window_size = little_endian_read_16(command, pos);
+        }
+#endif
         // check for unknown options
         if ((option_hint == 0) && ((option_type < L2CAP_CONFIG_OPTION_TYPE_MAX_TRANSMISSION_UNIT) || (option_type > L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE))){
             log_info("l2cap cid %u, unknown options", channel->local_cid);
@@ -2643,6 +3457,18 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
         if (((channel->state_var & L2CAP_CHANNEL_STATE_VAR_SEND_CONF_RSP_ERTM) == 0) & (channel->ertm_mandatory)){
             channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
         }
+#ifdef ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE
+        // Extended Window Size option overrides TxWindow of Retransmission and Flow Control option
+        if ((channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) && (extended_window_size > 0)){
+            channel->remote_tx_window_size = btstack_min(extended_window_size, L2CAP_ERTM_EXTENDED_WINDOW_SIZE_MAX);
+            channel->extended_control = 1;
+            log_info("Extended window size %u", channel->remote_tx_window_size);
+        }
+#endif
+        // split tx buffer into frames of remote MPS
+        if (l2cap_ertm_framing(channel) && (channel->state != L2CAP_STATE_OPEN) && (channel->num_stored_tx_frames == 0)){
+            l2cap_ertm_setup_tx_buffers(channel);
+        }
 #endif
 }
 
@@ -2663,6 +3489,9 @@ static void l2cap_signaling_handle_configure_response(l2cap_channel_t *channel,
         if (option_type == L2CAP_CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL && length == 9){
             switch (channel->mode){
                 case L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION:
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+                case L2CAP_CHANNEL_MODE_STREAMING_MODE:
+#endif
                     if (channel->ertm_mandatory){
                         // ??
                     } else {
@@ -2772,7 +3601,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
                             }
                             
                             // discard channel
-                            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                            l2cap_remove_channel(channel);
                             l2cap_free_channel_entry(channel);
                             break;
                     }
@@ -2817,7 +3646,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
                             break;
                         default:
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-                            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION && channel->ertm_mandatory){
+                            if (l2cap_ertm_framing(channel) && channel->ertm_mandatory){
                                 // remote does not offer ertm but it's required
                                 channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
                                 break;
@@ -2835,7 +3664,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
                 // assert that packet can be stored in fragment buffers in ertm
-                if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+                if (l2cap_ertm_framing(channel)){
                     uint16_t effective_mps = btstack_min(channel->remote_mps, channel->local_mps);
                     uint16_t usable_mtu = channel->num_tx_buffers == 1 ? effective_mps : channel->num_tx_buffers * effective_mps - 2;
                     if (usable_mtu < channel->remote_mtu){
@@ -2953,7 +3782,7 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
                 if (channel->state == L2CAP_STATE_WAIT_OUTGOING_EXTENDED_FEATURES){
 
                     // if ERTM was requested, but is not listed in extended feature mask:
-                    if ((channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) && ((connection->l2cap_state.extended_feature_mask & 0x08) == 0)){
+                    if (l2cap_ertm_framing(channel) && ((connection->l2cap_state.extended_feature_mask & l2cap_ertm_extended_feature_for_mode(channel)) == 0)){
 
                         if (channel->ertm_mandatory){
                             // bail if ERTM is mandatory
@@ -2961,7 +3790,7 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
                             // map l2cap connection response result to BTstack status enumeration
                             l2cap_handle_channel_open_failed(channel, L2CAP_CONNECTION_RESPONSE_RESULT_ERTM_NOT_SUPPORTED);
                             // discard channel
-                            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                            l2cap_remove_channel(channel);
                             l2cap_free_channel_entry(channel);
                             continue;
 
@@ -3117,7 +3946,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 l2cap_emit_le_channel_opened(channel, 0x0002);
                                 
                 // discard channel
-                btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             }
@@ -3206,10 +4035,10 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
 
                 // set initial state
                 channel->state      = L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT;
-                channel->state_var |= L2CAP_CHANNEL_STATE_VAR_INCOMING;
+                channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_INCOMING);
 
                 // add to connections list
-                btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_add_channel(channel);
 
                 // post connection request event
                 l2cap_emit_le_incoming_connection(channel);
@@ -3245,7 +4074,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 l2cap_emit_le_channel_opened(channel, result);
                                 
                 // discard channel
-                btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+                l2cap_remove_channel(channel);
                 l2cap_free_channel_entry(channel);
                 break;
             }
@@ -3280,6 +4109,11 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 break;
             }            
             log_info("l2cap: %u credits for 0x%02x, now %u", new_credits, local_cid, channel->credits_outgoing);
+#ifdef ENABLE_L2CAP_STATISTICS
+            l2cap_statistics_credit_starvation_end(channel);
+#endif
+            // continue sending without waiting for next hci event
+            l2cap_notify_channel_can_send();
             break;
 
         case DISCONNECTION_REQUEST:
@@ -3314,12 +4148,13 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
 #ifdef ENABLE_CLASSIC
 static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channel, uint8_t * packet, uint16_t size){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (l2cap_channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_framing(l2cap_channel)){
 
         int fcs_size = l2cap_channel->fcs_option ? 2 : 0;
+        uint16_t control_size = l2cap_ertm_control_field_size(l2cap_channel);
 
         // assert control + FCS fields are inside
-        if (size < COMPLETE_L2CAP_HEADER+2+fcs_size) return;
+        if (size < COMPLETE_L2CAP_HEADER+control_size+fcs_size) return;
 
         if (l2cap_channel->fcs_option){
             // verify FCS (required if one side requested it)
@@ -3346,14 +4181,69 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
         }
 
         // switch on packet type
-        uint16_t control = little_endian_read_16(packet, COMPLETE_L2CAP_HEADER);
-        uint8_t  req_seq = (control >> 8) & 0x3f;
-        int final = (control >> 7) & 0x01;
+        uint32_t control;
+        uint16_t req_seq;
+        int final;
+        if (l2cap_channel->extended_control){
+            control = little_endian_read_32(packet, COMPLETE_L2CAP_HEADER);
+            req_seq = (control >> 2) & 0x3fff;
+            final   = (control >> 1) & 0x01;
+        } else {
+            control = little_endian_read_16(packet, COMPLETE_L2CAP_HEADER);
+            req_seq = (control >> 8) & 0x3f;
+            final   = (control >> 7) & 0x01;
+        }
+#ifdef ENABLE_L2CAP_STREAMING_MODE
+        if (l2cap_channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+            // S-Frames are not used in Streaming Mode
+            if (control & 1) return;
+            l2cap_segmentation_and_reassembly_t sar;
+            uint16_t tx_seq;
+            if (l2cap_channel->extended_control){
+                sar    = (l2cap_segmentation_and_reassembly_t) ((control >> 16) & 0x03);
+                tx_seq = (control >> 18) & 0x3fff;
+            } else {
+                sar    = (l2cap_segmentation_and_reassembly_t) ((control >> 14) & 0x03);
+                tx_seq = (control >> 1) & 0x3f;
+            }
+            const uint8_t * payload_data = &packet[COMPLETE_L2CAP_HEADER+control_size];
+            uint16_t        payload_len  = size-(COMPLETE_L2CAP_HEADER+control_size+fcs_size);
+            if (payload_len > l2cap_channel->local_mps){
+                log_info("payload len %u > max payload %u -> drop packet", payload_len, l2cap_channel->local_mps);
+                return;
+            }
+            if (tx_seq != l2cap_channel->expected_tx_seq){
+                // frames lost, drop partially received SDU
+                log_info("Streaming: received TxSeq %u but expected %u -> drop incomplete SDU", tx_seq, l2cap_channel->expected_tx_seq);
+                l2cap_channel->reassembly_pos = 0;
+                l2cap_channel->reassembly_sdu_length = 0;
+            }
+            l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel, tx_seq);
+            switch (sar){
+                case L2CAP_SEGMENTATION_AND_REASSEMBLY_CONTINUATION_OF_L2CAP_SDU:
+                case L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU:
+                    // ignore remaining segments of dropped SDU until next start segment
+                    if (l2cap_channel->reassembly_sdu_length == 0) return;
+                    break;
+                default:
+                    break;
+            }
+            l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, sar, payload_data, payload_len);
+            return;
+        }
+#endif
         if (control & 1){
             // S-Frame
-            int poll  = (control >> 4) & 0x01;
-            l2cap_supervisory_function_t s = (l2cap_supervisory_function_t) ((control >> 2) & 0x03);
-            log_info("Control: 0x%04x => Supervisory function %u, ReqSeq %02u", control, (int) s, req_seq);
+            int poll;
+            l2cap_supervisory_function_t s;
+            if (l2cap_channel->extended_control){
+                poll = (control >> 18) & 0x01;
+                s    = (l2cap_supervisory_function_t) ((control >> 16) & 0x03);
+            } else {
+                poll = (control >> 4) & 0x01;
+                s    = (l2cap_supervisory_function_t) ((control >> 2) & 0x03);
+            }
+            log_info("Control: 0x%04x => Supervisory function %u, ReqSeq %02u", (unsigned int) control, (int) s, req_seq);
             l2cap_ertm_tx_packet_state_t * tx_state;
             switch (s){
                 case L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY:
@@ -3424,9 +4314,16 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
         } else {
             // I-Frame
             // get control
-            l2cap_segmentation_and_reassembly_t sar = (l2cap_segmentation_and_reassembly_t) (control >> 14);
-            uint8_t tx_seq = (control >> 1) & 0x3f;
-            log_info("Control: 0x%04x => SAR %u, ReqSeq %02u, R?, TxSeq %02u", control, (int) sar, req_seq, tx_seq);
+            l2cap_segmentation_and_reassembly_t sar;
+            uint16_t tx_seq;
+            if (l2cap_channel->extended_control){
+                sar    = (l2cap_segmentation_and_reassembly_t) ((control >> 16) & 0x03);
+                tx_seq = (control >> 18) & 0x3fff;
+            } else {
+                sar    = (l2cap_segmentation_and_reassembly_t) ((control >> 14) & 0x03);
+                tx_seq = (control >> 1) & 0x3f;
+            }
+            log_info("Control: 0x%04x => SAR %u, ReqSeq %02u, R?, TxSeq %02u", (unsigned int) control, (int) sar, req_seq, tx_seq);
             log_info("SAR: pos %u", l2cap_channel->reassembly_pos);
             log_info("State: expected_tx_seq %02u, req_seq %02u", l2cap_channel->expected_tx_seq, l2cap_channel->req_seq);
             l2cap_ertm_process_req_seq(l2cap_channel, req_seq);
@@ -3436,32 +4333,23 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
             }
 
             // get SDU
-            const uint8_t * payload_data = &packet[COMPLETE_L2CAP_HEADER+2];
-            uint16_t        payload_len  = size-(COMPLETE_L2CAP_HEADER+2+fcs_size);
+            const uint8_t * payload_data = &packet[COMPLETE_L2CAP_HEADER+control_size];
+            uint16_t        payload_len  = size-(COMPLETE_L2CAP_HEADER+control_size+fcs_size);
 
-            // assert SDU size is smaller or equal to our buffers
-            uint16_t max_payload_size = 0;
-            switch (sar){
-                case L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU:
-                case L2CAP_SEGMENTATION_AND_REASSEMBLY_START_OF_L2CAP_SDU:
-                    // SDU Length + MPS
-                    max_payload_size = l2cap_channel->local_mps + 2;
-                    break;
-                case L2CAP_SEGMENTATION_AND_REASSEMBLY_CONTINUATION_OF_L2CAP_SDU:
-                case L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU:
-                    max_payload_size = l2cap_channel->local_mps;
-                    break;
-            }
+            // assert SDU size is smaller or equal to our buffers, MPS includes SDU Length of start frame
+            uint16_t max_payload_size = l2cap_channel->local_mps;
             if (payload_len > max_payload_size){
                 log_info("payload len %u > max payload %u -> drop packet", payload_len, max_payload_size);
                 return;
             }
 
             // check ordering
-            if (l2cap_channel->expected_tx_seq == tx_seq){
+            uint16_t seq_nr_mask    = l2cap_ertm_seq_nr_mask(l2cap_channel);
+            uint16_t rx_window_size = l2cap_ertm_rx_window_size(l2cap_channel);
+            int delta = (tx_seq - l2cap_channel->expected_tx_seq) & seq_nr_mask;
+            if (delta == 0){
                 log_info("Received expected frame with TxSeq == ExpectedTxSeq == %02u", tx_seq);
-                l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel->expected_tx_seq);
-                l2cap_channel->req_seq         = l2cap_channel->expected_tx_seq;
+                l2cap_ertm_next_rx_store_index(l2cap_channel);
 
                 // process SDU
                 l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, sar, payload_data, payload_len);
@@ -3473,35 +4361,28 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
                     if (!rx_state->valid) break;
 
                     log_info("Processing stored frame with TxSeq == ExpectedTxSeq == %02u", l2cap_channel->expected_tx_seq);
-                    l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel->expected_tx_seq);
-                    l2cap_channel->req_seq         = l2cap_channel->expected_tx_seq;
-
-                    rx_state->valid = 0;
-                    l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, rx_state->sar, &l2cap_channel->rx_packets_data[index], rx_state->len);
-
-                    // update rx store index
-                    index++;
-                    if (index >= l2cap_channel->num_rx_buffers){
-                        index = 0;
-                    }
-                    l2cap_channel->rx_store_index = index;
+                    l2cap_segmentation_and_reassembly_t stored_sar = rx_state->sar;
+                    uint16_t stored_len = rx_state->len;
+                    l2cap_ertm_next_rx_store_index(l2cap_channel);
+                    l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, stored_sar, &l2cap_channel->rx_packets_data[index * l2cap_channel->local_mps], stored_len);
                 }
 
                 //
                 l2cap_channel->send_supervisor_frame_receiver_ready = 1;
 
-            } else {
-                int delta = (tx_seq - l2cap_channel->expected_tx_seq) & 0x3f;
-                if (delta < 2){
-                    // store segment
-                    l2cap_ertm_handle_out_of_sequence_sdu(l2cap_channel, sar, delta, payload_data, payload_len);
+            } else if (delta < rx_window_size){
+                // store segment and request missing frames
+                log_info("Received unexpected frame TxSeq %u but expected %u -> send S-SREJ for missing frames", tx_seq, l2cap_channel->expected_tx_seq);
+                l2cap_ertm_handle_out_of_sequence_sdu(l2cap_channel, sar, delta, payload_data, payload_len);
 
-                    log_info("Received unexpected frame TxSeq %u but expected %u -> send S-SREJ", tx_seq, l2cap_channel->expected_tx_seq);
-                    l2cap_channel->send_supervisor_frame_selective_reject = 1;
-                } else {
-                    log_info("Received unexpected frame TxSeq %u but expected %u -> send S-REJ", tx_seq, l2cap_channel->expected_tx_seq);
-                    l2cap_channel->send_supervisor_frame_reject = 1;
-                }
+            } else if (((l2cap_channel->expected_tx_seq - tx_seq) & seq_nr_mask) <= rx_window_size){
+                // already received, e.g. retransmission after lost acknowledgement -> acknowledge again
+                log_info("Received duplicate frame TxSeq %u, expected %u -> ignore", tx_seq, l2cap_channel->expected_tx_seq);
+                l2cap_channel->send_supervisor_frame_receiver_ready = 1;
+
+            } else {
+                log_info("Received unexpected frame TxSeq %u but expected %u -> send S-REJ", tx_seq, l2cap_channel->expected_tx_seq);
+                l2cap_channel->send_supervisor_frame_reject = 1;
             }
         }
         return;
@@ -3559,6 +4440,155 @@ static void l2cap_acl_classic_handler(hci_con_handle_t handle, uint8_t *packet,
 #endif
 }
 
+#ifdef ENABLE_LE_DATA_CHANNELS
+static uint16_t l2cap_le_local_mps(l2cap_channel_t * channel){
+    return btstack_min(l2cap_max_le_mtu(), channel->local_mtu);
+}
+
+// number of credits remote should hold according to credit policy
+static uint16_t l2cap_le_credit_policy_window(l2cap_channel_t * channel){
+    const l2cap_le_credit_policy_t * policy = channel->credit_policy;
+    uint32_t window;
+    switch (policy->type){
+        case L2CAP_LE_CREDIT_POLICY_CONSUMPTION_RATE:
+            window = channel->credit_window;
+            break;
+        case L2CAP_LE_CREDIT_POLICY_RX_MEMORY:
+            window = btstack_min(policy->window, channel->rx_memory_available / l2cap_le_local_mps(channel));
+            break;
+        default:
+            window = policy->window;
+            break;
+    }
+    return (uint16_t) window;
+}
+
+static void l2cap_le_credit_policy_update_rate(l2cap_channel_t * channel){
+    const l2cap_le_credit_policy_t * policy = channel->credit_policy;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    if ((now - channel->credit_interval_start_ms) < policy->interval_ms) return;
+    uint32_t window;
+    if (channel->credits_consumed >= channel->credit_window){
+        // remote used complete window, might be limited by us
+        window = channel->credit_window * 2;
+    } else {
+        // consumption plus 50% headroom
+        window = channel->credits_consumed + (channel->credits_consumed / 2);
+    }
+    window = btstack_max(window, policy->min_window);
+    window = btstack_min(window, policy->window);
+    channel->credit_window = (uint16_t) btstack_max(window, 1);
+    channel->credits_consumed = 0;
+    channel->credit_interval_start_ms = now;
+    log_debug("LE credit window %u", channel->credit_window);
+}
+
+// grant missing credits in batches
+static void l2cap_le_credit_policy_grant(l2cap_channel_t * channel){
+    uint16_t window = l2cap_le_credit_policy_window(channel);
+    uint32_t outstanding = channel->credits_incoming + channel->new_credits_incoming;
+    if (outstanding >= window) return;
+    uint16_t missing = window - outstanding;
+    uint16_t batch   = channel->credit_policy->batch;
+    if (batch == 0){
+        batch = window / 2;
+    }
+    batch = btstack_max(1, btstack_min(batch, window));
+    // avoid stalling the sender
+    if ((missing < batch) && (outstanding > 0)) return;
+    channel->new_credits_incoming += missing;
+}
+
+// grant credits up to window
+static void l2cap_le_credit_policy_fill_window(l2cap_channel_t * channel){
+    if ((channel->credit_policy->type == L2CAP_LE_CREDIT_POLICY_RX_MEMORY) && (channel->rx_memory_available == 0)){
+        // assume receive buffer is available until reported otherwise
+        channel->rx_memory_available = channel->local_mtu;
+    }
+    uint16_t window = l2cap_le_credit_policy_window(channel);
+    uint32_t outstanding = channel->credits_incoming + channel->new_credits_incoming;
+    if (outstanding < window){
+        channel->new_credits_incoming += window - outstanding;
+    }
+}
+
+static void l2cap_le_consume_incoming_credit(l2cap_channel_t * channel){
+    channel->credits_incoming--;
+
+    // credit policy
+    if (channel->credit_policy != NULL){
+        channel->credits_consumed++;
+        if (channel->credit_policy->type == L2CAP_LE_CREDIT_POLICY_CONSUMPTION_RATE){
+            l2cap_le_credit_policy_update_rate(channel);
+        }
+        l2cap_le_credit_policy_grant(channel);
+        return;
+    }
+
+    // automatic credits
+    if ((channel->credits_incoming < L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_WATERMARK) && channel->automatic_credits){
+        channel->new_credits_incoming = L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_INCREMENT;
+    }
+}
+
+#ifdef ENABLE_HCI_ACL_BUFFER_PROVIDER
+static l2cap_channel_t * l2cap_le_get_data_channel(hci_con_handle_t con_handle, uint16_t cid){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(cid);
+    if (channel == NULL) return NULL;
+    if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL) return NULL;
+    if (channel->con_handle != con_handle) return NULL;
+    return channel;
+}
+
+// returns SDU buffer for remaining K-frame payload, or NULL to process K-frame after recombination in HCI
+static uint8_t * l2cap_le_acl_get_buffer(hci_con_handle_t con_handle, uint16_t cid, uint16_t payload_len, const uint8_t * fragment, uint16_t fragment_len){
+    l2cap_channel_t * channel = l2cap_le_get_data_channel(con_handle, cid);
+    if (channel == NULL) return NULL;
+    if (channel->credits_incoming == 0) return NULL;
+
+    // first K-frame of SDU starts with SDU length
+    uint16_t sdu_len = channel->receive_sdu_len;
+    uint16_t sdu_pos = channel->receive_sdu_pos;
+    uint16_t pos = 0;
+    if (sdu_len == 0){
+        if (fragment_len < 2) return NULL;
+        sdu_len = little_endian_read_16(fragment, 0);
+        if (sdu_len > channel->local_mtu) return NULL;
+        sdu_pos = 0;
+        pos = 2;
+    }
+    if ((payload_len - pos) > (channel->local_mtu - sdu_pos)) return NULL;
+
+    l2cap_le_consume_incoming_credit(channel);
+    channel->receive_sdu_len = sdu_len;
+    (void)memcpy(&channel->receive_sdu_buffer[sdu_pos], &fragment[pos], fragment_len - pos);
+    channel->receive_sdu_pos = sdu_pos + fragment_len - pos;
+    return &channel->receive_sdu_buffer[channel->receive_sdu_pos];
+}
+
+static void l2cap_le_acl_buffer_complete(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer, uint16_t len){
+    UNUSED(buffer);
+    l2cap_channel_t * channel = l2cap_le_get_data_channel(con_handle, cid);
+    if (channel == NULL) return;
+    channel->receive_sdu_pos += len;
+    log_debug("le packet pos %u, len %u", channel->receive_sdu_pos, channel->receive_sdu_len);
+    if (channel->receive_sdu_pos >= channel->receive_sdu_len){
+        l2cap_dispatch_to_channel(channel, L2CAP_DATA_PACKET, channel->receive_sdu_buffer, channel->receive_sdu_len);
+        channel->receive_sdu_len = 0;
+    }
+    l2cap_run();
+}
+
+static void l2cap_le_acl_buffer_aborted(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer){
+    UNUSED(buffer);
+    l2cap_channel_t * channel = l2cap_le_get_data_channel(con_handle, cid);
+    if (channel == NULL) return;
+    // drop partial SDU
+    channel->receive_sdu_len = 0;
+}
+#endif
+#endif
+
 static void l2cap_acl_le_handler(hci_con_handle_t handle, uint8_t *packet, uint16_t size){
 #ifdef ENABLE_BLE
 
@@ -3606,12 +4636,7 @@ static void l2cap_acl_le_handler(hci_con_handle_t handle, uint8_t *packet, uint1
                     l2cap_channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
                     break;
                 }
-                l2cap_channel->credits_incoming--;
-
-                // automatic credits
-                if ((l2cap_channel->credits_incoming < L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_WATERMARK) && l2cap_channel->automatic_credits){
-                    l2cap_channel->new_credits_incoming = L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_INCREMENT;
-                }
+                l2cap_le_consume_incoming_credit(l2cap_channel);
 
                 // first fragment
                 uint16_t pos = 0;
@@ -3660,6 +4685,7 @@ static void l2cap_acl_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
     hci_con_handle_t handle = READ_ACL_CONNECTION_HANDLE(packet);
     hci_connection_t *conn = hci_connection_for_handle(handle);
     if (!conn) return;
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_L2CAP_RX, READ_L2CAP_CHANNEL_ID(packet), READ_L2CAP_LENGTH(packet));
     if (conn->address_type == BD_ADDR_TYPE_ACL){
         l2cap_acl_classic_handler(handle, packet, size);
     } else {
@@ -3682,7 +4708,7 @@ void l2cap_finialize_channel_close(l2cap_channel_t * channel){
     channel->state = L2CAP_STATE_CLOSED;
     l2cap_handle_channel_closed(channel);
     // discard channel
-    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_remove_channel(channel);
     l2cap_free_channel_entry(channel);
 }
 #endif
@@ -3832,10 +4858,12 @@ static void l2cap_le_send_pdu(l2cap_channel_t *channel){
         little_endian_store_16(l2cap_payload, pos, channel->send_sdu_len);
         pos += 2;
     }
-    uint16_t payload_size = btstack_min(channel->send_sdu_len + 2 - channel->send_sdu_pos, channel->remote_mps - pos);
+    // PDU ends with current chunk
+    uint16_t chunk_end = channel->send_sdu_chunk_offset + channel->send_sdu_chunk_len + 2;
+    uint16_t payload_size = btstack_min(chunk_end - channel->send_sdu_pos, channel->remote_mps - pos);
     log_info("len %u, pos %u => payload %u, credits %u", channel->send_sdu_len, channel->send_sdu_pos, payload_size, channel->credits_outgoing);
     (void)memcpy(&l2cap_payload[pos],
-                 &channel->send_sdu_buffer[channel->send_sdu_pos - 2],
+                 &channel->send_sdu_buffer[channel->send_sdu_pos - 2 - channel->send_sdu_chunk_offset],
                  payload_size); // -2 for virtual SDU len
     pos += payload_size;
     channel->send_sdu_pos += payload_size;
@@ -3843,23 +4871,36 @@ static void l2cap_le_send_pdu(l2cap_channel_t *channel){
 
     channel->credits_outgoing--;
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_L2CAP_TX, channel->local_cid, pos);
+    L2CAP_STATISTICS_ADD(channel, packets_sent, 1);
+    L2CAP_STATISTICS_ADD(channel, bytes_sent, pos);
     hci_send_acl_packet_buffer(8 + pos);
 
     if (channel->send_sdu_pos >= (channel->send_sdu_len + 2)){
         channel->send_sdu_buffer = NULL;
+        channel->send_sdu_pos    = 0;
         // send done event
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_LE_PACKET_SENT);
         // inform about can send now
         l2cap_le_notify_channel_can_send(channel);
+    } else if (channel->send_sdu_pos >= chunk_end){
+        // chunk sent, wait for next chunk
+        channel->send_sdu_buffer = NULL;
+        l2cap_le_notify_channel_can_send(channel);
     }
 }
 
+// SDU started but not completely provided yet
+static bool l2cap_le_send_sdu_active(l2cap_channel_t * channel){
+    return (channel->send_sdu_buffer != NULL) || (channel->send_sdu_pos != 0);
+}
+
 // finalize closed channel - l2cap_handle_disconnect_request & DISCONNECTION_RESPONSE
 void l2cap_le_finialize_channel_close(l2cap_channel_t * channel){
     channel->state = L2CAP_STATE_CLOSED;
     l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_CHANNEL_CLOSED);
     // discard channel
-    btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_remove_channel(channel);
     l2cap_free_channel_entry(channel);
 }
 
@@ -3921,8 +4962,13 @@ uint8_t l2cap_le_accept_connection(uint16_t local_cid, uint8_t * receive_sdu_buf
     channel->state = L2CAP_STATE_WILL_SEND_LE_CONNECTION_RESPONSE_ACCEPT;
     channel->receive_sdu_buffer = receive_sdu_buffer;
     channel->local_mtu = mtu;
-    channel->new_credits_incoming = initial_credits;
-    channel->automatic_credits  = initial_credits == L2CAP_LE_AUTOMATIC_CREDITS;
+    if (channel->credit_policy != NULL){
+        // initial credits from credit policy
+        l2cap_le_credit_policy_fill_window(channel);
+    } else {
+        channel->new_credits_incoming = initial_credits;
+        channel->automatic_credits  = initial_credits == L2CAP_LE_AUTOMATIC_CREDITS;
+    }
 
     // test
     // channel->new_credits_incoming = 1;
@@ -3986,7 +5032,7 @@ uint8_t l2cap_le_create_channel(btstack_packet_handler_t packet_handler, hci_con
     channel->automatic_credits    = initial_credits == L2CAP_LE_AUTOMATIC_CREDITS;
 
     // add to connections list
-    btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    l2cap_add_channel(channel);
 
     // go
     l2cap_run();
@@ -4028,6 +5074,55 @@ uint8_t l2cap_le_provide_credits(uint16_t local_cid, uint16_t credits){
     return ERROR_CODE_SUCCESS;
 }
 
+uint8_t l2cap_le_set_credit_policy(uint16_t local_cid, const l2cap_le_credit_policy_t * credit_policy){
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_le_set_credit_policy no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    if ((credit_policy != NULL) && (credit_policy->window == 0)){
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    channel->credit_policy = credit_policy;
+    if (credit_policy == NULL) return ERROR_CODE_SUCCESS;
+
+    channel->automatic_credits = 0;
+    channel->credits_consumed  = 0;
+    channel->credit_interval_start_ms = btstack_run_loop_get_time_ms();
+    channel->credit_window = btstack_max(1, btstack_min(credit_policy->window, btstack_max(credit_policy->min_window, credit_policy->window / 2)));
+
+    // local MTU is not known before incoming connection gets accepted, window is filled then
+    if (channel->state == L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT) return ERROR_CODE_SUCCESS;
+
+    l2cap_le_credit_policy_fill_window(channel);
+
+    // go
+    l2cap_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_le_set_rx_memory_available(uint16_t local_cid, uint32_t rx_memory_available){
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_le_set_rx_memory_available no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    channel->rx_memory_available = rx_memory_available;
+    if (channel->credit_policy == NULL) return ERROR_CODE_SUCCESS;
+    if (channel->state == L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT) return ERROR_CODE_SUCCESS;
+
+    l2cap_le_credit_policy_grant(channel);
+
+    // go
+    l2cap_run();
+    return ERROR_CODE_SUCCESS;
+}
+
 /**
  * @brief Check if outgoing buffer is available and that there's space on the Bluetooth module
  * @param local_cid             L2CAP LE Data Channel Identifier
@@ -4043,7 +5138,7 @@ int l2cap_le_can_send_now(uint16_t local_cid){
     if (channel->state != L2CAP_STATE_OPEN) return 0;
 
     // check queue
-    if (channel->send_sdu_buffer) return 0;    
+    if (l2cap_le_send_sdu_active(channel)) return 0;    
 
     // fine, go ahead
     return 1;
@@ -4062,6 +5157,9 @@ uint8_t l2cap_le_request_can_send_now_event(uint16_t local_cid){
         return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
     }
     channel->waiting_for_can_send_now = 1;
+#ifdef ENABLE_L2CAP_STATISTICS
+    l2cap_statistics_can_send_now_requested();
+#endif
     l2cap_le_notify_channel_can_send(channel);
     return ERROR_CODE_SUCCESS;
 }
@@ -4086,7 +5184,7 @@ uint8_t l2cap_le_send_data(uint16_t local_cid, uint8_t * data, uint16_t len){
         return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
     }
 
-    if (channel->send_sdu_buffer){
+    if (l2cap_le_send_sdu_active(channel)){
         log_info("l2cap_send cid 0x%02x, cannot send", local_cid);
         return BTSTACK_ACL_BUFFERS_FULL;
     }
@@ -4094,6 +5192,71 @@ uint8_t l2cap_le_send_data(uint16_t local_cid, uint8_t * data, uint16_t len){
     channel->send_sdu_buffer = data;
     channel->send_sdu_len    = len;
     channel->send_sdu_pos    = 0;
+    channel->send_sdu_chunk_offset = 0;
+    channel->send_sdu_chunk_len    = len;
+
+    l2cap_notify_channel_can_send();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_le_send_sdu_start(uint16_t local_cid, uint16_t sdu_len, uint8_t * data, uint16_t len){
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    if (sdu_len > channel->remote_mtu){
+        log_error("l2cap_send cid 0x%02x, data length exceeds remote MTU.", local_cid);
+        return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
+    }
+
+    if (len > sdu_len){
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    if (l2cap_le_send_sdu_active(channel)){
+        log_info("l2cap_send cid 0x%02x, cannot send", local_cid);
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    channel->send_sdu_buffer = data;
+    channel->send_sdu_len    = sdu_len;
+    channel->send_sdu_pos    = 0;
+    channel->send_sdu_chunk_offset = 0;
+    channel->send_sdu_chunk_len    = len;
+
+    l2cap_notify_channel_can_send();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_le_send_sdu_continue(uint16_t local_cid, uint8_t * data, uint16_t len){
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    // previous chunk still in use
+    if (channel->send_sdu_buffer){
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+    // no SDU started
+    if (channel->send_sdu_pos == 0){
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+
+    uint16_t chunk_offset = channel->send_sdu_pos - 2;
+    if ((len == 0) || ((chunk_offset + len) > channel->send_sdu_len)){
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    channel->send_sdu_buffer = data;
+    channel->send_sdu_chunk_offset = chunk_offset;
+    channel->send_sdu_chunk_len    = len;
 
     l2cap_notify_channel_can_send();
     return ERROR_CODE_SUCCESS;
@@ -139,12 +139,16 @@ typedef struct {
     l2cap_segmentation_and_reassembly_t sar;
     uint16_t len;
     uint8_t  valid;
+    // missing frame: SREJ requested - flag
+    uint8_t  srej_requested;
+    // missing frame: SREJ not sent yet - flag
+    uint8_t  srej_pending;
 } l2cap_ertm_rx_packet_state_t;
 
 typedef struct {
     l2cap_segmentation_and_reassembly_t sar;
     uint16_t len;
-    uint8_t tx_seq;
+    uint16_t tx_seq;
     uint8_t retry_count;
     uint8_t retransmission_requested;
 } l2cap_ertm_tx_packet_state_t;
@@ -165,17 +169,44 @@ typedef struct {
     // MTU for incoming SDUs
     uint16_t local_mtu;
 
-    // Number of buffers for outgoing data
-    uint8_t num_tx_buffers;
+    // Number of buffers for outgoing data, more are used if remote MPS is smaller than local MPS
+    uint16_t num_tx_buffers;
 
     // Number of packets that can be received out of order (-> our tx_window size)
-    uint8_t num_rx_buffers;
+    // Up to 63, or up to 0x3fff with ENABLE_L2CAP_ERTM_EXTENDED_WINDOW_SIZE if supported by remote
+    uint16_t num_rx_buffers;
 
     // Frame Check Sequence (FCS) Option
     uint8_t fcs_option;
 
 } l2cap_ertm_config_t;
 
+typedef enum {
+    // keep credits of remote at window
+    L2CAP_LE_CREDIT_POLICY_FIXED_WINDOW = 0,
+    // window between min_window and window, adapted to credits consumed per interval
+    L2CAP_LE_CREDIT_POLICY_CONSUMPTION_RATE,
+    // window limited by rx memory reported with l2cap_le_set_rx_memory_available
+    L2CAP_LE_CREDIT_POLICY_RX_MEMORY,
+} l2cap_le_credit_policy_type_t;
+
+typedef struct {
+    l2cap_le_credit_policy_type_t type;
+
+    // max number of credits remote may hold
+    uint16_t window;
+
+    // consumption rate: lower bound for window
+    uint16_t min_window;
+
+    // credits are granted once this many are missing from the window, 0 = half of window
+    uint16_t batch;
+
+    // consumption rate: measurement interval in ms
+    uint16_t interval_ms;
+
+} l2cap_le_credit_policy_t;
+
 // info regarding an actual channel
 // note: l2cap_fixed_channel and l2cap_channel_t share commmon fields
 
@@ -199,6 +230,34 @@ typedef struct l2cap_fixed_channel {
 
 } l2cap_fixed_channel_t;
 
+// per channel statistics, requires ENABLE_L2CAP_STATISTICS
+typedef struct {
+    // PDUs and bytes sent to HCI
+    uint32_t packets_sent;
+    uint32_t bytes_sent;
+    // packets and bytes delivered to packet handler
+    uint32_t packets_received;
+    uint32_t bytes_received;
+    // ERTM: retransmitted I-frames, retransmission and monitor timeouts, max number of stored outgoing I-frames
+    uint32_t ertm_retransmissions;
+    uint32_t ertm_timeouts;
+    uint16_t ertm_tx_queue_max;
+    // LE Credit-Based: periods with outgoing data but no credits and their total duration
+    uint32_t credit_starvation_count;
+    uint32_t credit_starvation_ms;
+    // start of current starvation period, 0 if credits available
+    uint32_t credit_starvation_start_ms;
+} l2cap_channel_statistics_t;
+
+// can send now statistics, requires ENABLE_L2CAP_STATISTICS
+typedef struct {
+    // calls to l2cap_request_can_send_now_event, l2cap_request_can_send_fix_channel_now_event, l2cap_le_request_can_send_now_event
+    uint32_t can_send_now_requests;
+    // channels waiting for can send now, current value is updated by l2cap_get_statistics
+    uint16_t can_send_now_waiting;
+    uint16_t can_send_now_waiting_max;
+} l2cap_statistics_t;
+
 typedef struct {
     // linked list - assert: first field
     btstack_linked_item_t    item;
@@ -239,6 +298,16 @@ typedef struct {
 
     uint16_t  flush_timeout;    // default 0xffff
 
+#ifdef ENABLE_CLASSIC_MEDIA_QOS
+    // send as automatically flushable packets, see l2cap_set_flushable
+    bool      flushable;
+#endif
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+    // priority and Controller buffer share, see l2cap_set_traffic_class
+    hci_traffic_class_t traffic_class;
+#endif
+
     uint16_t  psm;
     
     gap_security_level_t required_security_level;
@@ -252,10 +321,12 @@ typedef struct {
     uint16_t  receive_sdu_len;
     uint16_t  receive_sdu_pos;
 
-    // outgoing SDU
+    // outgoing SDU, send_sdu_buffer holds SDU data from send_sdu_chunk_offset on
     uint8_t  * send_sdu_buffer;
     uint16_t   send_sdu_len;
     uint16_t   send_sdu_pos;
+    uint16_t   send_sdu_chunk_offset;
+    uint16_t   send_sdu_chunk_len;
 
     // max PDU size
     uint16_t  remote_mps;
@@ -272,9 +343,16 @@ typedef struct {
     // automatic credits incoming
     uint16_t automatic_credits;
 
+    // credit policy, replaces automatic credits if set
+    const l2cap_le_credit_policy_t * credit_policy;
+    uint16_t credit_window;
+    uint16_t credits_consumed;
+    uint32_t credit_interval_start_ms;
+    uint32_t rx_memory_available;
+
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 
-    // l2cap channel mode: basic or enhanced retransmission mode
+    // l2cap channel mode: basic, enhanced retransmission or streaming mode
     l2cap_channel_mode_t mode;
     
     // local mps = size of rx/tx buffers
@@ -293,7 +371,7 @@ typedef struct {
     uint16_t remote_retransmission_timeout_ms;
     uint16_t remote_monitor_timeout_ms;
 
-    uint8_t remote_tx_window_size;
+    uint16_t remote_tx_window_size;
 
     uint8_t local_max_transmit;
     uint8_t remote_max_transmit;
@@ -304,42 +382,55 @@ typedef struct {
     // Frame Chech Sequence (crc16) is present in both directions
     uint8_t fcs_option;
 
+    // 32-bit Extended Control Field with 14-bit sequence numbers is used, negotiated by Extended Window Size option
+    uint8_t extended_control;
+
     // sender: max num of stored outgoing frames
-    uint8_t num_tx_buffers;
+    uint16_t num_tx_buffers;
 
     // sender: num stored outgoing frames
-    uint8_t num_stored_tx_frames;
+    uint16_t num_stored_tx_frames;
 
     // sender: number of unacknowledeged I-Frames - frames have been sent, but not acknowledged yet
-    uint8_t unacked_frames;
+    uint16_t unacked_frames;
 
     // sender: buffer index of oldest packet
-    uint8_t tx_read_index;
+    uint16_t tx_read_index;
 
     // sender: buffer index to store next tx packet
-    uint8_t tx_write_index;
+    uint16_t tx_write_index;
 
     // sender: buffer index of packet to send next
-    uint8_t tx_send_index;
+    uint16_t tx_send_index;
 
     // sender: next seq nr used for sending
-    uint8_t next_tx_seq;
+    uint16_t next_tx_seq;
 
     // sender: selective retransmission requested
     uint8_t srej_active;
 
+    // sender: size of tx buffers = effective mps
+    uint16_t tx_mps;
+
+    // sender: memory for tx state and tx buffers, divided once remote mps and tx window are known
+    uint8_t * tx_buffer;
+    uint32_t  tx_buffer_size;
+
 
     // receiver: max num out-of-order packets // tx_window
-    uint8_t num_rx_buffers;
+    uint16_t num_rx_buffers;
 
-    // receiver: buffer index of to store packet with delta = 1
-    uint8_t rx_store_index;
+    // receiver: buffer index of packet with tx_seq == expected_tx_seq
+    uint16_t rx_store_index;
 
     // receiver: value of tx_seq in next expected i-frame
-    uint8_t expected_tx_seq;
+    uint16_t expected_tx_seq;
 
     // receiver: request transmission with tx_seq = req_seq and ack up to and including req_seq
-    uint8_t req_seq;
+    uint16_t req_seq;
+
+    // receiver: number of missing frames with SREJ not sent yet
+    uint16_t num_pending_srej_frames;
 
     // receiver: local busy condition
     uint8_t local_busy;
@@ -380,10 +471,14 @@ typedef struct {
     // receiver: num_rx_buffers of size local_mps
     uint8_t * rx_packets_data;
 
-    // sender: num_tx_buffers of size local_mps
+    // sender: num_tx_buffers of size tx_mps
     uint8_t * tx_packets_data;
 
 #endif    
+
+#ifdef ENABLE_L2CAP_STATISTICS
+    l2cap_channel_statistics_t statistics;
+#endif
 } l2cap_channel_t;
 
 // info regarding potential connections
@@ -493,6 +588,23 @@ uint8_t l2cap_create_channel(btstack_packet_handler_t packet_handler, bd_addr_t
 uint8_t l2cap_create_ertm_channel(btstack_packet_handler_t packet_handler, bd_addr_t address, uint16_t psm, 
     l2cap_ertm_config_t * ertm_contig, uint8_t * buffer, uint32_t size, uint16_t * out_local_cid);
 
+/** 
+ * @brief Creates L2CAP channel to the PSM of a remote device with baseband address using Streaming Mode.
+ *        Outgoing frames are sent once and not acknowledged, incoming SDUs with missing frames are dropped.
+ *        A new baseband connection will be initiated if necessary.
+ * @note requires ENABLE_L2CAP_STREAMING_MODE, max_transmit, retransmission/monitor timeout and num_rx_buffers of ertm_config are ignored
+ * @param packet_handler
+ * @param address
+ * @param psm
+ * @param ertm_config with ertm_mandatory == streaming mode mandatory
+ * @param buffer to store reassembled rx packet and outgoing packets
+ * @param size of buffer
+ * @param local_cid
+ * @return status
+ */
+uint8_t l2cap_create_streaming_channel(btstack_packet_handler_t packet_handler, bd_addr_t address, uint16_t psm, 
+    l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size, uint16_t * out_local_cid);
+
 /** 
  * @brief Disconnects L2CAP channel with given identifier. 
  */
@@ -503,6 +615,16 @@ void l2cap_disconnect(uint16_t local_cid, uint8_t reason);
  */
 uint16_t l2cap_get_remote_mtu_for_local_cid(uint16_t local_cid);
 
+/**
+ * @brief Send outgoing packets of Classic L2CAP channel as automatically flushable. Requires ENABLE_CLASSIC_MEDIA_QOS
+ * @param local_cid
+ * @param flushable
+ * @return status
+ * @note Controller discards flushable packets after the Automatic Flush Timeout, see gap_set_automatic_flush_timeout.
+ *       Channels in Streaming Mode are always sent as flushable
+ */
+uint8_t l2cap_set_flushable(uint16_t local_cid, bool flushable);
+
 /** 
  * @brief Sends L2CAP data packet to the channel with given identifier.
  */
@@ -533,6 +655,17 @@ void l2cap_accept_connection(uint16_t local_cid);
  */
 uint8_t l2cap_accept_ertm_connection(uint16_t local_cid, l2cap_ertm_config_t * ertm_contig, uint8_t * buffer, uint32_t size);
 
+/** 
+ * @brief Accepts incoming L2CAP connection for Streaming Mode
+ * @note requires ENABLE_L2CAP_STREAMING_MODE, see l2cap_create_streaming_channel
+ * @param local_cid
+ * @param ertm_config
+ * @param buffer to store reassembled rx packet and outgoing packets
+ * @param size of buffer
+ * @return status
+ */
+uint8_t l2cap_accept_streaming_connection(uint16_t local_cid, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size);
+
 /** 
  * @brief Deny incoming L2CAP connection.
  */
@@ -551,6 +684,48 @@ int  l2cap_can_send_packet_now(uint16_t local_cid);
  */
 void l2cap_request_can_send_now_event(uint16_t local_cid);
 
+#ifdef ENABLE_L2CAP_WEIGHTED_SCHEDULING
+/**
+ * @brief Configure how Controller buffers are shared when channels on several connections want to send
+ * @note Connections get weight packets per round-robin round, low latency connections are always served first
+ * @param con_handle
+ * @param weight > 0, default 1
+ * @param low_latency
+ * @return status
+ */
+uint8_t l2cap_set_connection_scheduling(hci_con_handle_t con_handle, uint8_t weight, bool low_latency);
+#endif
+
+#ifdef ENABLE_HCI_QOS_ARBITER
+/**
+ * @brief Set traffic class of L2CAP channel. Requires ENABLE_HCI_QOS_ARBITER
+ * @note Can send now events are emitted in order of traffic class priority, default HCI_TRAFFIC_CLASS_BULK.
+ *       LE ATT and SM use HCI_TRAFFIC_CLASS_INTERACTIVE. See hci_qos_set_acl_reservation
+ * @param local_cid
+ * @param traffic_class
+ * @return status
+ */
+uint8_t l2cap_set_traffic_class(uint16_t local_cid, hci_traffic_class_t traffic_class);
+#endif
+
+/**
+ * @brief Get can send now statistics. Requires ENABLE_L2CAP_STATISTICS
+ * @return statistics
+ */
+const l2cap_statistics_t * l2cap_get_statistics(void);
+
+/**
+ * @brief Get statistics for channel. Requires ENABLE_L2CAP_STATISTICS
+ * @param local_cid
+ * @return statistics or NULL if channel does not exist
+ */
+const l2cap_channel_statistics_t * l2cap_get_channel_statistics(uint16_t local_cid);
+
+/**
+ * @brief Log statistics of all channels via log_info. Requires ENABLE_L2CAP_STATISTICS
+ */
+void l2cap_statistics_dump(void);
+
 /** 
  * @brief Reserve outgoing buffer
  * @note Only for L2CAP Basic Mode Channels
@@ -569,6 +744,13 @@ uint8_t *l2cap_get_outgoing_buffer(void);
  */
 int l2cap_send_prepared(uint16_t local_cid, uint16_t len);
 
+/**
+ * @brief Send L2CAP packet given by list of buffers to channel without copying them into the outgoing buffer
+ * @note Only for L2CAP Basic Mode Channels. Buffers must stay valid until next can send now event
+ * @return status
+ */
+int l2cap_send_iov(uint16_t local_cid, const btstack_iovec_t * iov, uint16_t iov_count);
+
 /** 
  * @brief Release outgoing buffer (only needed if l2cap_send_prepared is not called)
  * @note Only for L2CAP Basic Mode Channels
@@ -636,6 +818,24 @@ uint8_t l2cap_le_create_channel(btstack_packet_handler_t packet_handler, hci_con
  */
 uint8_t l2cap_le_provide_credits(uint16_t cid, uint16_t credits);
 
+/**
+ * @brief Set credit policy for LE Data Channel. Credits are granted in batches to keep remote credits at the policy window
+ * @note Call before l2cap_le_accept_connection, which then ignores initial_credits, or right after l2cap_le_create_channel with initial_credits = 0
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param credit_policy         policy, needs to stay valid while channel is open; NULL to grant credits manually again
+ * @return status
+ */
+uint8_t l2cap_le_set_credit_policy(uint16_t cid, const l2cap_le_credit_policy_t * credit_policy);
+
+/**
+ * @brief Report free memory for incoming SDUs for L2CAP_LE_CREDIT_POLICY_RX_MEMORY, one credit per local MPS bytes
+ * @note Includes memory for data that remote can send with credits it already holds
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param rx_memory_available   number of bytes
+ * @return status
+ */
+uint8_t l2cap_le_set_rx_memory_available(uint16_t cid, uint32_t rx_memory_available);
+
 /**
  * @brief Check if packet can be scheduled for transmission
  * @param local_cid             L2CAP LE Data Channel Identifier
@@ -659,6 +859,26 @@ uint8_t l2cap_le_request_can_send_now_event(uint16_t cid);
  */
 uint8_t l2cap_le_send_data(uint16_t cid, uint8_t * data, uint16_t size);
 
+/**
+ * @brief Start sending SDU via LE Data Channel that is provided in chunks
+ * @note The chunk is segmented into PDUs without waiting for the next chunk, PDUs don't span chunks.
+ *       L2CAP_EVENT_LE_CAN_SEND_NOW is emitted when the chunk was sent, if requested, and
+ *       L2CAP_EVENT_LE_PACKET_SENT after the last chunk was sent. Chunks need to stay valid until then.
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param sdu_len               total size of SDU
+ * @param data                  first chunk
+ * @param size                  chunk size
+ */
+uint8_t l2cap_le_send_sdu_start(uint16_t cid, uint16_t sdu_len, uint8_t * data, uint16_t size);
+
+/**
+ * @brief Provide next chunk of SDU started by l2cap_le_send_sdu_start
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param data                  next chunk
+ * @param size                  chunk size
+ */
+uint8_t l2cap_le_send_sdu_continue(uint16_t cid, uint8_t * data, uint16_t size);
+
 /**
  * @brief Disconnect from LE Data Channel
  * @param local_cid             L2CAP LE Data Channel Identifier
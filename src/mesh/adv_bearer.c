@@ -65,6 +65,24 @@
 // num adv bearer message types
 #define NUM_TYPES 3
 
+// number of messages that can be scheduled for transmission at the same time
+#ifndef ADV_BEARER_TX_QUEUE_SIZE
+#define ADV_BEARER_TX_QUEUE_SIZE 4
+#endif
+
+// max random delay added to each transmission to avoid collisions with other relays
+#ifndef ADV_BEARER_TX_JITTER_MS
+#define ADV_BEARER_TX_JITTER_MS 10
+#endif
+
+#define ADV_BEARER_TX_ENTRY_NONE 0xff
+
+#if ADV_BEARER_TX_QUEUE_SIZE >= ADV_BEARER_TX_ENTRY_NONE
+#error "ADV_BEARER_TX_QUEUE_SIZE must be less than 255"
+#endif
+
+#define LFSR(a) ((a >> 1) ^ (uint32_t)((0 - (a & 1u)) & 0xd0000001u))
+
 typedef enum {
     MESH_NETWORK_ID,
     MESH_BEACON_ID,
@@ -78,6 +96,27 @@ typedef enum {
     STATE_GAP,
 } state_t;
 
+// advertising parameters last passed to gap
+typedef enum {
+    ADV_PARAMS_NONE,
+    ADV_PARAMS_GAP,
+    ADV_PARAMS_BEARER,
+} adv_params_t;
+
+// scheduled adv bearer message
+typedef struct {
+    uint8_t  buffer[31];
+    uint8_t  buffer_length;
+    // remaining transmissions, 0 = unused
+    uint8_t  count;
+    uint16_t interval_ms;
+    uint32_t next_ms;
+#ifdef ENABLE_MESH_STATISTICS
+    uint32_t queued_ms;
+    uint8_t  transmitted;
+#endif
+} adv_bearer_tx_entry_t;
+
 
 // prototypes
 static void adv_bearer_run(void);
@@ -98,10 +137,18 @@ static state_t    adv_bearer_state;
 static uint32_t   gap_adv_next_ms;
 
 // adv bearer packets
-static uint8_t   adv_bearer_buffer[31];
-static uint8_t   adv_bearer_buffer_length;
-static uint8_t   adv_bearer_count;
-static uint16_t  adv_bearer_interval;
+static adv_bearer_tx_entry_t adv_bearer_tx_queue[ADV_BEARER_TX_QUEUE_SIZE];
+static uint8_t   adv_bearer_tx_current;
+static uint32_t  adv_bearer_tx_start_ms;
+static uint32_t  adv_bearer_lfsr = 0x12345678;
+
+#ifdef ENABLE_MESH_STATISTICS
+static adv_bearer_statistics_t adv_bearer_statistics;
+#endif
+
+// avoid HCI commands for unchanged advertising parameters and data
+static adv_params_t    adv_bearer_programmed_params;
+static const uint8_t * adv_bearer_programmed_data;
 
 // gap advertising
 static int       gap_advertising_enabled;
@@ -127,6 +174,8 @@ static void adv_bearer_packet_handler (uint8_t packet_type, uint16_t channel, ui
             switch(packet[0]){
                 case BTSTACK_EVENT_STATE:
                     if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) break;
+                    adv_bearer_programmed_params = ADV_PARAMS_NONE;
+                    adv_bearer_programmed_data   = NULL;
                     adv_bearer_run();
                     break;
                 case GAP_EVENT_ADVERTISING_REPORT:
@@ -146,17 +195,23 @@ static void adv_bearer_packet_handler (uint8_t packet_type, uint16_t channel, ui
                             type_id = PB_ADV_ID;
                             break;
                         default:
+                            MESH_STATISTICS_INC(adv_bearer_statistics.rx_ignored);
                             return;
                     }
-                    if (client_callbacks[type_id]){
+                    if (client_callbacks[type_id] == NULL){
+                        MESH_STATISTICS_INC(adv_bearer_statistics.rx_ignored);
+                    } else {
                         switch (type_id){
                             case PB_ADV_ID:
+                                MESH_STATISTICS_INC(adv_bearer_statistics.rx_provisioning_pdus);
                                 (*client_callbacks[type_id])(packet_type, channel, packet, size);
                                 break;
                             case MESH_NETWORK_ID:
+                                MESH_STATISTICS_INC(adv_bearer_statistics.rx_network_pdus);
                                 (*client_callbacks[type_id])(MESH_NETWORK_PACKET, 0, (uint8_t*) &data[2], data_len-2);
                                 break;
                             case MESH_BEACON_ID:
+                                MESH_STATISTICS_INC(adv_bearer_statistics.rx_beacons);
                                 (*client_callbacks[type_id])(MESH_BEACON_PACKET, 0, (uint8_t*) &data[2], data_len-2);
                                 break;
                             default:
@@ -173,10 +228,37 @@ static void adv_bearer_packet_handler (uint8_t packet_type, uint16_t channel, ui
     }
 }
 
+// poor man's random number generator
+static uint32_t adv_bearer_jitter_ms(void){
+    adv_bearer_lfsr = LFSR(adv_bearer_lfsr);
+    return adv_bearer_lfsr % (ADV_BEARER_TX_JITTER_MS + 1);
+}
+
+static int adv_bearer_tx_queue_free_index(void){
+    int i;
+    for (i=0;i<ADV_BEARER_TX_QUEUE_SIZE;i++){
+        if (adv_bearer_tx_queue[i].count == 0) return i;
+    }
+    return -1;
+}
+
+// returns scheduled message with earliest transmission time or ADV_BEARER_TX_ENTRY_NONE
+static uint8_t adv_bearer_tx_queue_next_index(void){
+    uint8_t next = ADV_BEARER_TX_ENTRY_NONE;
+    uint8_t i;
+    for (i=0;i<ADV_BEARER_TX_QUEUE_SIZE;i++){
+        if (adv_bearer_tx_queue[i].count == 0) continue;
+        if ((next == ADV_BEARER_TX_ENTRY_NONE) || ((int32_t)(adv_bearer_tx_queue[i].next_ms - adv_bearer_tx_queue[next].next_ms) < 0)){
+            next = i;
+        }
+    }
+    return next;
+}
+
 // round-robin
 static void adv_bearer_emit_can_send_now(void){
 
-    if (adv_bearer_count > 0) return;
+    if (adv_bearer_tx_queue_free_index() < 0) return;
 
     int countdown = NUM_TYPES;
     while (countdown--) {
@@ -200,6 +282,7 @@ static void adv_bearer_emit_can_send_now(void){
 
 static void adv_bearer_timeout_handler(btstack_timer_source_t * ts){
     UNUSED(ts);
+    adv_bearer_tx_entry_t * entry;
     adv_timer_active = 0;
     uint32_t now = btstack_run_loop_get_time_ms();
     switch (adv_bearer_state){
@@ -215,11 +298,15 @@ static void adv_bearer_timeout_handler(btstack_timer_source_t * ts){
         case STATE_BEARER:
             log_debug("Timeout (state bearer)");
             gap_advertisements_enable(0);
-            adv_bearer_count--;
-            if (adv_bearer_count == 0){
+            adv_bearer_state = STATE_IDLE;
+            entry = &adv_bearer_tx_queue[adv_bearer_tx_current];
+            entry->count--;
+            if (entry->count == 0){
                 adv_bearer_emit_can_send_now();
+            } else {
+                // other messages can be sent until next retransmission is due
+                entry->next_ms = adv_bearer_tx_start_ms + entry->interval_ms + adv_bearer_jitter_ms();
             }
-            adv_bearer_state = STATE_IDLE;
             break;
         default:
             break;
@@ -227,6 +314,26 @@ static void adv_bearer_timeout_handler(btstack_timer_source_t * ts){
     adv_bearer_run();
 }
 
+static void adv_bearer_set_params_gap(void){
+    if (adv_bearer_programmed_params == ADV_PARAMS_GAP) return;
+    adv_bearer_programmed_params = ADV_PARAMS_GAP;
+    gap_advertisements_set_params(ADVERTISING_INTERVAL_CONNECTABLE_MIN, ADVERTISING_INTERVAL_CONNECTABLE_MIN, gap_adv_type, gap_direct_address_typ, gap_direct_address, gap_channel_map, gap_filter_policy);
+}
+
+static void adv_bearer_set_params_bearer(void){
+    if (adv_bearer_programmed_params == ADV_PARAMS_BEARER) return;
+    adv_bearer_programmed_params = ADV_PARAMS_BEARER;
+    // configure LE advertisments: non-conn ind
+    gap_advertisements_set_params(ADVERTISING_INTERVAL_NONCONNECTABLE_MIN, ADVERTISING_INTERVAL_NONCONNECTABLE_MIN, 3, 0, null_addr, 0x07, 0);
+}
+
+static void adv_bearer_set_data_bearer(adv_bearer_tx_entry_t * entry){
+    // skip for retransmissions
+    if (adv_bearer_programmed_data == entry->buffer) return;
+    adv_bearer_programmed_data = entry->buffer;
+    gap_advertisements_set_data(entry->buffer_length, entry->buffer);
+}
+
 static void adv_bearer_set_timeout(uint32_t time_ms){
     btstack_run_loop_set_timer_handler(&adv_timer, &adv_bearer_timeout_handler);
     btstack_run_loop_set_timer(&adv_timer, time_ms);    // compile time constants
@@ -238,9 +345,17 @@ static void adv_bearer_set_timeout(uint32_t time_ms){
 static void adv_bearer_run(void){
 
     if (hci_get_state() != HCI_STATE_WORKING) return;
-    if (adv_timer_active) return;
+    if (adv_timer_active) {
+        // advertisement in progress
+        if (adv_bearer_state != STATE_IDLE) return;
+        // waiting, re-evaluate schedule
+        btstack_run_loop_remove_timer(&adv_timer);
+        adv_timer_active = 0;
+    }
     
     uint32_t now = btstack_run_loop_get_time_ms();
+    uint8_t  next_index;
+    uint32_t wait_ms;
     switch (adv_bearer_state){
         case STATE_IDLE:
             if (gap_advertising_enabled){
@@ -254,7 +369,9 @@ static void adv_bearer_run(void){
                         btstack_linked_list_add_tail(&gap_connectable_advertisements, (void*) item);                        
                         // time to advertise again
                         log_debug("Start GAP ADV, %p", item);
-                        gap_advertisements_set_params(ADVERTISING_INTERVAL_CONNECTABLE_MIN, ADVERTISING_INTERVAL_CONNECTABLE_MIN, gap_adv_type, gap_direct_address_typ, gap_direct_address, gap_channel_map, gap_filter_policy);
+                        adv_bearer_set_params_gap();
+                        // item data might have changed since last use
+                        adv_bearer_programmed_data = NULL;
                         gap_advertisements_set_data(item->adv_length, item->adv_data);
                         gap_advertisements_enable(1);
                         adv_bearer_state = STATE_GAP;
@@ -263,22 +380,37 @@ static void adv_bearer_run(void){
                     }
                 }
             }
-            if (adv_bearer_count > 0){
-                // schedule adv bearer message if enough time
-                // if ((gap_advertising_enabled) == 0 || ((int32_t)(gap_adv_next_ms - now) >= ADVERTISING_INTERVAL_NONCONNECTABLE_MIN_MS)){
-                log_debug("Send ADV Bearer message");
-                // configure LE advertisments: non-conn ind
-                gap_advertisements_set_params(ADVERTISING_INTERVAL_NONCONNECTABLE_MIN, ADVERTISING_INTERVAL_NONCONNECTABLE_MIN, 3, 0, null_addr, 0x07, 0);
-                gap_advertisements_set_data(adv_bearer_buffer_length, adv_bearer_buffer);
-                gap_advertisements_enable(1);
-                adv_bearer_state = STATE_BEARER;
-                adv_bearer_set_timeout(ADVERTISING_INTERVAL_NONCONNECTABLE_MIN_MS);
-                break;
-                // }
+            next_index = adv_bearer_tx_queue_next_index();
+            if (next_index != ADV_BEARER_TX_ENTRY_NONE){
+                adv_bearer_tx_entry_t * entry = &adv_bearer_tx_queue[next_index];
+                if ((int32_t)(now - entry->next_ms) >= 0){
+                    log_debug("Send ADV Bearer message %u", next_index);
+                    adv_bearer_set_params_bearer();
+                    adv_bearer_set_data_bearer(entry);
+                    gap_advertisements_enable(1);
+                    adv_bearer_state = STATE_BEARER;
+                    adv_bearer_tx_current  = next_index;
+                    adv_bearer_tx_start_ms = now;
+#ifdef ENABLE_MESH_STATISTICS
+                    adv_bearer_statistics.tx_advertisements++;
+                    if (entry->transmitted == 0){
+                        entry->transmitted = 1;
+                        mesh_statistics_latency_add(&adv_bearer_statistics.tx_latency, now - entry->queued_ms);
+                    }
+#endif
+                    adv_bearer_set_timeout(ADVERTISING_INTERVAL_NONCONNECTABLE_MIN_MS);
+                    break;
+                }
             }
+            // use timer to wait for next adv or next adv bearer message
             if (gap_advertising_enabled){
-                // use timer to wait for next adv
-                adv_bearer_set_timeout(gap_adv_next_ms - now);
+                wait_ms = gap_adv_next_ms - now;
+                if (next_index != ADV_BEARER_TX_ENTRY_NONE){
+                    wait_ms = btstack_min(wait_ms, adv_bearer_tx_queue[next_index].next_ms - now);
+                }
+                adv_bearer_set_timeout(wait_ms);
+            } else if (next_index != ADV_BEARER_TX_ENTRY_NONE){
+                adv_bearer_set_timeout(adv_bearer_tx_queue[next_index].next_ms - now);
             }
             break;
         default:
@@ -286,19 +418,38 @@ static void adv_bearer_run(void){
     }
 }
 
-//
+// queue message, transmissions of queued messages are interleaved
 static void adv_bearer_prepare_message(const uint8_t * data, uint16_t data_len, uint8_t type, uint8_t count, uint16_t interval){
-    btstack_assert(data_len <= (sizeof(adv_bearer_buffer)-2));
-    log_debug("adv bearer message, type 0x%x\n", type);
+    int index = adv_bearer_tx_queue_free_index();
+    // only called after can send now
+    btstack_assert(index >= 0);
+    adv_bearer_tx_entry_t * entry = &adv_bearer_tx_queue[index];
+    btstack_assert(data_len <= (sizeof(entry->buffer)-2));
+    if (adv_bearer_programmed_data == entry->buffer){
+        adv_bearer_programmed_data = NULL;
+    }
+    log_debug("adv bearer message, type 0x%x, slot %u\n", type, index);
     // prepare message
-    adv_bearer_buffer[0] = data_len+1;
-    adv_bearer_buffer[1] = type;
-    (void)memcpy(&adv_bearer_buffer[2], data, data_len);
-    adv_bearer_buffer_length = data_len + 2;
+    entry->buffer[0] = data_len+1;
+    entry->buffer[1] = type;
+    (void)memcpy(&entry->buffer[2], data, data_len);
+    entry->buffer_length = data_len + 2;
 
     // setup trasmission schedule
-    adv_bearer_count    = count;
-    adv_bearer_interval = interval;
+    entry->count       = btstack_max(count, 1);
+    entry->interval_ms = interval;
+    entry->next_ms     = btstack_run_loop_get_time_ms() + adv_bearer_jitter_ms();
+
+#ifdef ENABLE_MESH_STATISTICS
+    entry->queued_ms   = btstack_run_loop_get_time_ms();
+    entry->transmitted = 0;
+    uint16_t num_queued = 0;
+    int i;
+    for (i=0;i<ADV_BEARER_TX_QUEUE_SIZE;i++){
+        if (adv_bearer_tx_queue[i].count != 0) num_queued++;
+    }
+    MESH_STATISTICS_MAX(adv_bearer_statistics.max_tx_queued, num_queued);
+#endif
 }
 
 //////
@@ -317,6 +468,16 @@ void adv_bearer_init(void){
     memset(null_addr, 0, 6);
 }
 
+#ifdef ENABLE_MESH_STATISTICS
+const adv_bearer_statistics_t * adv_bearer_get_statistics(void){
+    return &adv_bearer_statistics;
+}
+
+void adv_bearer_reset_statistics(void){
+    memset(&adv_bearer_statistics, 0, sizeof(adv_bearer_statistics));
+}
+#endif
+
 // adv bearer packet handler regisration
 
 void adv_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
@@ -344,18 +505,24 @@ void adv_bearer_request_can_send_now_for_provisioning_pdu(void){
 // adv bearer send message
 
 void adv_bearer_send_network_pdu(const uint8_t * data, uint16_t data_len, uint8_t count, uint16_t interval){
-    btstack_assert(data_len <= (sizeof(adv_bearer_buffer)-2));
+    btstack_assert(data_len <= (sizeof(adv_bearer_tx_queue[0].buffer)-2));
+    MESH_STATISTICS_INC(adv_bearer_statistics.tx_network_pdus);
     adv_bearer_prepare_message(data, data_len, BLUETOOTH_DATA_TYPE_MESH_MESSAGE, count, interval);
+    adv_bearer_emit_can_send_now();
     adv_bearer_run();
 }
 void adv_bearer_send_beacon(const uint8_t * data, uint16_t data_len){
-    btstack_assert(data_len <= (sizeof(adv_bearer_buffer)-2));
+    btstack_assert(data_len <= (sizeof(adv_bearer_tx_queue[0].buffer)-2));
+    MESH_STATISTICS_INC(adv_bearer_statistics.tx_beacons);
     adv_bearer_prepare_message(data, data_len, BLUETOOTH_DATA_TYPE_MESH_BEACON, 3, 100);
+    adv_bearer_emit_can_send_now();
     adv_bearer_run();
 }
 void adv_bearer_send_provisioning_pdu(const uint8_t * data, uint16_t data_len){
-    btstack_assert(data_len <= (sizeof(adv_bearer_buffer)-2));
+    btstack_assert(data_len <= (sizeof(adv_bearer_tx_queue[0].buffer)-2));
+    MESH_STATISTICS_INC(adv_bearer_statistics.tx_provisioning_pdus);
     adv_bearer_prepare_message(data, data_len, BLUETOOTH_DATA_TYPE_PB_ADV, 3, 100);
+    adv_bearer_emit_can_send_now();
     adv_bearer_run();
 }
 
@@ -391,6 +558,9 @@ void adv_bearer_advertisements_set_params(uint16_t adv_int_min, uint16_t adv_int
     (void)memcpy(gap_direct_address, &direct_address, 6);
     gap_channel_map        = channel_map; 
     gap_filter_policy      = filter_policy; 
+    if (adv_bearer_programmed_params == ADV_PARAMS_GAP){
+        adv_bearer_programmed_params = ADV_PARAMS_NONE;
+    }
 
     log_info("GAP Adv interval %u ms", gap_adv_int_ms);
 }
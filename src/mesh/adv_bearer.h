@@ -43,11 +43,32 @@
 
 #include "btstack_defines.h"
 #include "bluetooth.h"
+#include "mesh/mesh_statistics.h"
 
 #if defined __cplusplus
 extern "C" {
 #endif
 
+// advertising bearer statistics, updated with ENABLE_MESH_STATISTICS
+typedef struct {
+    // received advertisements by type
+    uint32_t rx_network_pdus;
+    uint32_t rx_beacons;
+    uint32_t rx_provisioning_pdus;
+    // received non-connectable advertisements with other type or without registered handler
+    uint32_t rx_ignored;
+    // messages queued for transmission by type
+    uint32_t tx_network_pdus;
+    uint32_t tx_beacons;
+    uint32_t tx_provisioning_pdus;
+    // advertisements sent incl. retransmissions
+    uint32_t tx_advertisements;
+    // transmission queue high-water mark
+    uint16_t max_tx_queued;
+    // queued to start of first transmission
+    mesh_statistics_latency_t tx_latency;
+} adv_bearer_statistics_t;
+
 typedef struct {
 	void * next;
 	uint8_t adv_length;
@@ -130,6 +151,19 @@ void adv_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size, uin
  */
 void adv_bearer_send_beacon(const uint8_t * beacon_update, uint16_t size);
 void adv_bearer_send_provisioning_pdu(const uint8_t * pb_adv_pdu, uint16_t size); 
+
+#ifdef ENABLE_MESH_STATISTICS
+/**
+ * @brief Get advertising bearer statistics
+ * @return statistics
+ */
+const adv_bearer_statistics_t * adv_bearer_get_statistics(void);
+
+/**
+ * @brief Reset advertising bearer statistics
+ */
+void adv_bearer_reset_statistics(void);
+#endif
  
 
 #if defined __cplusplus
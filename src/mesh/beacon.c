@@ -71,7 +71,17 @@ static void mesh_secure_network_beacon_run(btstack_timer_source_t * ts);
 
 // bearers
 #ifdef ENABLE_MESH_GATT_BEARER
-static hci_con_handle_t gatt_bearer_con_handle;
+static hci_con_handle_t gatt_bearer_con_handles[MESH_PROXY_NUM_CONNECTIONS];
+// Proxy Client the secure network beacon is currently sent to
+static int gatt_bearer_beacon_connection_index;
+
+static int beacon_gatt_next_connection(int start_index){
+    int i;
+    for (i=start_index;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (gatt_bearer_con_handles[i] != HCI_CON_HANDLE_INVALID) return i;
+    }
+    return -1;
+}
 #endif
 
 // beacon
@@ -236,9 +246,16 @@ static void mesh_secure_network_beacon_run(btstack_timer_source_t * ts){
             case MESH_SECURE_NETWORK_BEACON_ADV_SENT:
 
 #ifdef ENABLE_MESH_GATT_BEARER
-                if (gatt_bearer_con_handle != HCI_CON_HANDLE_INVALID && mesh_foundation_gatt_proxy_get() != 0){
+                // send to all Proxy Clients, one after the other
+                if ((gatt_bearer_beacon_connection_index >= 0) && (mesh_foundation_gatt_proxy_get() != 0)){
+                    // already sending to Proxy Clients
+                    subnet->beacon_state = MESH_SECURE_NETWORK_BEACON_W2_SEND_GATT;
+                    break;
+                }
+                gatt_bearer_beacon_connection_index = beacon_gatt_next_connection(0);
+                if ((gatt_bearer_beacon_connection_index >= 0) && (mesh_foundation_gatt_proxy_get() != 0)){
                     subnet->beacon_state = MESH_SECURE_NETWORK_BEACON_W2_SEND_GATT;
-                    gatt_bearer_request_can_send_now_for_beacon();
+                    gatt_bearer_request_can_send_now_for_beacon(gatt_bearer_con_handles[gatt_bearer_beacon_connection_index]);
                     break;
                 }
 #endif 
@@ -395,8 +412,8 @@ static void beacon_adv_packet_handler (uint8_t packet_type, uint16_t channel, ui
 #endif
 
 #ifdef ENABLE_MESH_GATT_BEARER
-// handle MESH_SUBEVENT_PROXY_DISCONNECTED and MESH_SUBEVENT_CAN_SEND_NOW
-static void beacon_gatt_handle_mesh_event(uint8_t mesh_subevent){
+// handle MESH_SUBEVENT_PROXY_DISCONNECTED and MESH_SUBEVENT_CAN_SEND_NOW for current Proxy Client
+static void beacon_gatt_handle_mesh_event(uint8_t mesh_subevent, hci_con_handle_t con_handle){
     mesh_subnet_iterator_t it;
     mesh_subnet_iterator_init(&it);
     while (mesh_subnet_iterator_has_more(&it)){
@@ -405,20 +422,42 @@ static void beacon_gatt_handle_mesh_event(uint8_t mesh_subevent){
             case MESH_SECURE_NETWORK_BEACON_W2_SEND_GATT:
                 // skip send on MESH_SUBEVENT_PROXY_DISCONNECTED 
                 if (mesh_subevent == MESH_SUBEVENT_CAN_SEND_NOW){
-                    gatt_bearer_send_beacon(mesh_beacon_data, mesh_beacon_len);
+                    gatt_bearer_send_beacon(con_handle, mesh_beacon_data, mesh_beacon_len);
                 }
-                subnet->beacon_state = MESH_SECURE_NETWORK_BEACON_GATT_SENT;
-                mesh_secure_network_beacon_run(NULL);
                 break;
             default:
                 break;
         }
     }
 
+    // continue with next Proxy Client
+    gatt_bearer_beacon_connection_index = beacon_gatt_next_connection(gatt_bearer_beacon_connection_index + 1);
+    if (gatt_bearer_beacon_connection_index >= 0){
+        gatt_bearer_request_can_send_now_for_beacon(gatt_bearer_con_handles[gatt_bearer_beacon_connection_index]);
+        return;
+    }
+
+    mesh_subnet_iterator_init(&it);
+    while (mesh_subnet_iterator_has_more(&it)){
+        mesh_subnet_t * subnet = mesh_subnet_iterator_get_next(&it);
+        if (subnet->beacon_state != MESH_SECURE_NETWORK_BEACON_W2_SEND_GATT) continue;
+        subnet->beacon_state = MESH_SECURE_NETWORK_BEACON_GATT_SENT;
+    }
+    mesh_secure_network_beacon_run(NULL);
+}
+
+static int beacon_gatt_index_for_con_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (gatt_bearer_con_handles[i] == con_handle) return i;
+    }
+    return -1;
 }
 
 static void beacon_gatt_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     uint8_t mesh_subevent;
+    hci_con_handle_t con_handle;
+    int index;
     switch (packet_type){
         case HCI_EVENT_PACKET:
             switch(packet[0]){
@@ -426,14 +465,25 @@ static void beacon_gatt_packet_handler (uint8_t packet_type, uint16_t channel, u
                     mesh_subevent = packet[2];
                     switch(mesh_subevent){
                         case MESH_SUBEVENT_PROXY_CONNECTED:
-                            gatt_bearer_con_handle = mesh_subevent_proxy_connected_get_con_handle(packet);
+                            con_handle = mesh_subevent_proxy_connected_get_con_handle(packet);
+                            if (beacon_gatt_index_for_con_handle(con_handle) >= 0) break;
+                            index = beacon_gatt_index_for_con_handle(HCI_CON_HANDLE_INVALID);
+                            if (index < 0) break;
+                            gatt_bearer_con_handles[index] = con_handle;
                             break;
                         case MESH_SUBEVENT_PROXY_DISCONNECTED:
-                            gatt_bearer_con_handle = HCI_CON_HANDLE_INVALID;
-                            beacon_gatt_handle_mesh_event(mesh_subevent);
+                            con_handle = mesh_subevent_proxy_disconnected_get_con_handle(packet);
+                            index = beacon_gatt_index_for_con_handle(con_handle);
+                            if (index < 0) break;
+                            gatt_bearer_con_handles[index] = HCI_CON_HANDLE_INVALID;
+                            if (index != gatt_bearer_beacon_connection_index) break;
+                            beacon_gatt_handle_mesh_event(mesh_subevent, con_handle);
                             break;
                         case MESH_SUBEVENT_CAN_SEND_NOW:
-                            beacon_gatt_handle_mesh_event(mesh_subevent);
+                            con_handle = little_endian_read_16(packet, 3);
+                            index = beacon_gatt_index_for_con_handle(con_handle);
+                            if ((index < 0) || (index != gatt_bearer_beacon_connection_index)) break;
+                            beacon_gatt_handle_mesh_event(mesh_subevent, con_handle);
                             break;
                         default:
                             break;
@@ -457,7 +507,11 @@ void beacon_init(void){
     adv_bearer_register_for_beacon(&beacon_adv_packet_handler);
 #endif
 #ifdef ENABLE_MESH_GATT_BEARER    
-    gatt_bearer_con_handle = HCI_CON_HANDLE_INVALID;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        gatt_bearer_con_handles[i] = HCI_CON_HANDLE_INVALID;
+    }
+    gatt_bearer_beacon_connection_index = -1;
     gatt_bearer_register_for_beacon(&beacon_gatt_packet_handler);
 #endif
 }
@@ -57,57 +57,86 @@
 #define NUM_TYPES 3
 
 static btstack_packet_handler_t client_callbacks[NUM_TYPES];
-static int request_can_send_now[NUM_TYPES];
-static int last_sender;
 
-// share buffer for reassembly and segmentation - protocol is half-duplex
-static union {
+typedef struct {
+    hci_con_handle_t con_handle;
+    uint16_t mtu;
+
+    // round-robin over message types
+    int request_can_send_now[NUM_TYPES];
+    int last_sender;
+
     uint8_t  reassembly_buffer[MESH_PROV_MAX_PROXY_PDU];
-    uint8_t  segmentation_buffer[MESH_PROV_MAX_PROXY_PDU];
-} sar_buffer;
-
-static const uint8_t * proxy_pdu;
-static uint16_t proxy_pdu_size;
-static uint8_t outgoing_ready;
-static uint16_t reassembly_offset;
-static uint16_t segmentation_offset;
-static mesh_msg_sar_field_t segmentation_state;
-static mesh_msg_type_t msg_type;
-static uint16_t gatt_bearer_mtu;
-static hci_con_handle_t gatt_bearer_con_handle;
+
+    const uint8_t * proxy_pdu;
+    uint16_t proxy_pdu_size;
+    uint8_t outgoing_ready;
+    uint16_t reassembly_offset;
+    uint16_t segmentation_offset;
+    mesh_msg_sar_field_t segmentation_state;
+    mesh_msg_type_t outgoing_msg_type;
+} gatt_bearer_connection_t;
+
+static gatt_bearer_connection_t gatt_bearer_connections[MESH_PROXY_NUM_CONNECTIONS];
+
+// segments are copied by att_server_notify, so a single buffer is used for all connections
+static uint8_t gatt_bearer_segment_buffer[1 + MESH_PROV_MAX_PROXY_PDU];
+
+static gatt_bearer_connection_t * gatt_bearer_connection_for_con_handle(hci_con_handle_t con_handle){
+    if (con_handle == HCI_CON_HANDLE_INVALID) return NULL;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (gatt_bearer_connections[i].con_handle == con_handle) return &gatt_bearer_connections[i];
+    }
+    return NULL;
+}
+
+static gatt_bearer_connection_t * gatt_bearer_connection_create(hci_con_handle_t con_handle){
+    gatt_bearer_connection_t * connection = gatt_bearer_connection_for_con_handle(con_handle);
+    if (connection) return connection;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        connection = &gatt_bearer_connections[i];
+        if (connection->con_handle != HCI_CON_HANDLE_INVALID) continue;
+        memset(connection, 0, sizeof(gatt_bearer_connection_t));
+        connection->con_handle = con_handle;
+        connection->mtu = ATT_DEFAULT_MTU;
+        return connection;
+    }
+    return NULL;
+}
 
 // round-robin
-static void gatt_bearer_emit_can_send_now(void){
-    // if (gatt_active) return;
+static void gatt_bearer_emit_can_send_now(gatt_bearer_connection_t * connection){
     int countdown = NUM_TYPES;
     while (countdown--) {
-        last_sender++;
-        if (last_sender == NUM_TYPES) {
-            last_sender = 0;
+        connection->last_sender++;
+        if (connection->last_sender == NUM_TYPES) {
+            connection->last_sender = 0;
         }
-        if (request_can_send_now[last_sender]){
-            request_can_send_now[last_sender] = 0;
+        if (connection->request_can_send_now[connection->last_sender]){
+            connection->request_can_send_now[connection->last_sender] = 0;
             // emit can send now
             uint8_t event[5];
             int pos = 0;
             event[pos++] = HCI_EVENT_MESH_META;
             event[pos++] = 1;
             event[pos++] = MESH_SUBEVENT_CAN_SEND_NOW;
-            little_endian_store_16(event, pos, gatt_bearer_con_handle);
+            little_endian_store_16(event, pos, connection->con_handle);
             pos += 2;
-            (*client_callbacks[last_sender])(HCI_EVENT_PACKET, 0, &event[0], pos);
+            (*client_callbacks[connection->last_sender])(HCI_EVENT_PACKET, 0, &event[0], pos);
             return;
         }
     }
 }
 
-static void gatt_bearer_emit_message_sent(mesh_msg_type_t type_id){
+static void gatt_bearer_emit_message_sent(hci_con_handle_t con_handle, mesh_msg_type_t type_id){
     uint8_t event[5];
     int pos = 0;
     event[pos++] = HCI_EVENT_MESH_META;
     event[pos++] = 1;
     event[pos++] = MESH_SUBEVENT_MESSAGE_SENT;
-    little_endian_store_16(event, pos, gatt_bearer_con_handle);
+    little_endian_store_16(event, pos, con_handle);
     pos += 2;
     (*client_callbacks[type_id])(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
 }
@@ -116,57 +145,70 @@ static void gatt_bearer_emit_event_for_all(uint8_t * packet, uint16_t size){
     unsigned int i;
     for (i=0; i < NUM_TYPES; i++){
         if ( client_callbacks[i] == NULL) continue;
-        (*client_callbacks[last_sender])(HCI_EVENT_PACKET, 0, packet, size);
+        (*client_callbacks[i])(HCI_EVENT_PACKET, 0, packet, size);
     }
 }
 
-static void gatt_bearer_request(mesh_msg_type_t type_id){
-    request_can_send_now[type_id] = 1;
-    mesh_proxy_service_server_request_can_send_now(gatt_bearer_con_handle);
+static void gatt_bearer_request(hci_con_handle_t con_handle, mesh_msg_type_t type_id){
+    gatt_bearer_connection_t * connection = gatt_bearer_connection_for_con_handle(con_handle);
+    if (connection == NULL) return;
+    connection->request_can_send_now[type_id] = 1;
+    mesh_proxy_service_server_request_can_send_now(con_handle);
 }
 
+static void gatt_bearer_start_sending(gatt_bearer_connection_t * connection){
+    // send segments back to back while ATT Server has buffers, wait for can send now otherwise
+    while (true){
+        uint16_t pdu_segment_len = btstack_min(connection->proxy_pdu_size - connection->segmentation_offset, connection->mtu - 1 - 3);
+        gatt_bearer_segment_buffer[0] = (connection->segmentation_state << 6) | connection->outgoing_msg_type;
+        (void)memcpy(&gatt_bearer_segment_buffer[1],
+                     &connection->proxy_pdu[connection->segmentation_offset], pdu_segment_len);
+        connection->segmentation_offset += pdu_segment_len;
+        mesh_proxy_service_server_send_proxy_pdu(connection->con_handle, gatt_bearer_segment_buffer, pdu_segment_len + 1);
+        
+        switch (connection->segmentation_state){
+            case MESH_MSG_SAR_FIELD_COMPLETE_MSG:
+            case MESH_MSG_SAR_FIELD_LAST_SEGMENT:
+                connection->outgoing_ready = 0;
+                gatt_bearer_emit_message_sent(connection->con_handle, connection->outgoing_msg_type);
+                return;
+            case MESH_MSG_SAR_FIELD_CONTINUE:
+            case MESH_MSG_SAR_FIELD_FIRST_SEGMENT:
+                if ((connection->proxy_pdu_size - connection->segmentation_offset) > (connection->mtu - 1 - 3)){
+                    connection->segmentation_state = MESH_MSG_SAR_FIELD_CONTINUE;
+                } else {
+                    connection->segmentation_state = MESH_MSG_SAR_FIELD_LAST_SEGMENT;
+                }
+                break;
+            default:
+                return;
+        }
 
-static void gatt_bearer_start_sending(hci_con_handle_t con_handle){
-    uint16_t pdu_segment_len = btstack_min(proxy_pdu_size - segmentation_offset, gatt_bearer_mtu - 1 - 3);
-    sar_buffer.segmentation_buffer[0] = (segmentation_state << 6) | msg_type;
-    (void)memcpy(&sar_buffer.segmentation_buffer[1],
-                 &proxy_pdu[segmentation_offset], pdu_segment_len);
-    segmentation_offset += pdu_segment_len;
-    mesh_proxy_service_server_send_proxy_pdu(con_handle, sar_buffer.segmentation_buffer, pdu_segment_len + 1);
-    
-    switch (segmentation_state){
-        case MESH_MSG_SAR_FIELD_COMPLETE_MSG:
-        case MESH_MSG_SAR_FIELD_LAST_SEGMENT:
-            // gatt_bearer_emit_pdu_sent(0);
-            outgoing_ready = 0;
-            gatt_bearer_emit_message_sent(msg_type);
-            break;
-        case MESH_MSG_SAR_FIELD_CONTINUE:
-        case MESH_MSG_SAR_FIELD_FIRST_SEGMENT:
-            if ((proxy_pdu_size - segmentation_offset) > (gatt_bearer_mtu - 1 - 3)){
-                segmentation_state = MESH_MSG_SAR_FIELD_CONTINUE;
-            } else {
-                segmentation_state = MESH_MSG_SAR_FIELD_LAST_SEGMENT;
-            }
-            mesh_proxy_service_server_request_can_send_now(con_handle);
-            break;
-        default:
-            break;
+        if (!att_server_can_send_packet_now(connection->con_handle)){
+            mesh_proxy_service_server_request_can_send_now(connection->con_handle);
+            return;
+        }
     }
 }
 
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-    UNUSED(channel);
-    UNUSED(size);
     mesh_msg_sar_field_t msg_sar_field;
+    mesh_msg_type_t msg_type;
     
     uint16_t pdu_segment_len;
     uint16_t pos;
     hci_con_handle_t con_handle;
     int send_to_mesh_network;
+    gatt_bearer_connection_t * connection;
 
     switch (packet_type) {
         case MESH_PROXY_DATA_PACKET:
+            // channel is the connection handle
+            connection = gatt_bearer_connection_for_con_handle(channel);
+            if (connection == NULL){
+                log_info("gatt bearer: data from unknown connection 0x%04x", channel);
+                return;
+            }
             pos = 0;
             // on provisioning PDU call packet handler with PROVISIONG_DATA type
             msg_sar_field = packet[pos] >> 6;
@@ -188,43 +230,37 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             }
             pdu_segment_len = size - pos;
 
-            if (sizeof(sar_buffer.reassembly_buffer) - reassembly_offset < pdu_segment_len) {
-                log_error("sar buffer too small left %d, new to store %d", MESH_PROV_MAX_PROXY_PDU - reassembly_offset, pdu_segment_len);
+            // complete message: pass on without copy
+            if (msg_sar_field == MESH_MSG_SAR_FIELD_COMPLETE_MSG){
+                connection->reassembly_offset = 0;
+                (*client_callbacks[msg_type])(MESH_PROXY_DATA_PACKET, connection->con_handle, &packet[pos], pdu_segment_len);
                 break;
             }
 
-            // update mtu if incoming packet is larger than default
-            if (size > (ATT_DEFAULT_MTU - 1)){
-                log_info("Remote uses larger MTU, enable long PDUs");
-                gatt_bearer_mtu = att_server_get_mtu(channel);
-            }
-
             switch (msg_sar_field){
-                case MESH_MSG_SAR_FIELD_COMPLETE_MSG:
                 case MESH_MSG_SAR_FIELD_FIRST_SEGMENT:
-                    memset(sar_buffer.reassembly_buffer, 0, sizeof(sar_buffer.reassembly_buffer));
-                    if (sizeof(sar_buffer.reassembly_buffer) < pdu_segment_len) return;
-                    (void)memcpy(sar_buffer.reassembly_buffer, packet + pos,
+                    if (sizeof(connection->reassembly_buffer) < pdu_segment_len) return;
+                    (void)memcpy(connection->reassembly_buffer, packet + pos,
                                  pdu_segment_len);
-                    reassembly_offset = pdu_segment_len;
+                    connection->reassembly_offset = pdu_segment_len;
                     break;
                 case MESH_MSG_SAR_FIELD_CONTINUE:
-                    if ((sizeof(sar_buffer.reassembly_buffer) - reassembly_offset) < pdu_segment_len) return;
-                    (void)memcpy(sar_buffer.reassembly_buffer + reassembly_offset,
+                    if ((sizeof(connection->reassembly_buffer) - connection->reassembly_offset) < pdu_segment_len) return;
+                    (void)memcpy(connection->reassembly_buffer + connection->reassembly_offset,
                                  packet + pos, pdu_segment_len);
-                    reassembly_offset += pdu_segment_len;
+                    connection->reassembly_offset += pdu_segment_len;
                     return;
                 case MESH_MSG_SAR_FIELD_LAST_SEGMENT:
-                    if ((sizeof(sar_buffer.reassembly_buffer) - reassembly_offset) < pdu_segment_len) return;
-                    (void)memcpy(sar_buffer.reassembly_buffer + reassembly_offset,
+                    if ((sizeof(connection->reassembly_buffer) - connection->reassembly_offset) < pdu_segment_len) return;
+                    (void)memcpy(connection->reassembly_buffer + connection->reassembly_offset,
                                  packet + pos, pdu_segment_len);
-                    reassembly_offset += pdu_segment_len;
+                    connection->reassembly_offset += pdu_segment_len;
                     break;
                 default:
                     break;
             }
             
-            send_to_mesh_network = (msg_sar_field == MESH_MSG_SAR_FIELD_COMPLETE_MSG) || (msg_sar_field == MESH_MSG_SAR_FIELD_LAST_SEGMENT);
+            send_to_mesh_network = (msg_sar_field == MESH_MSG_SAR_FIELD_LAST_SEGMENT);
                     
             if (!send_to_mesh_network) break;
             switch (msg_type){
@@ -232,9 +268,9 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                 case MESH_MSG_TYPE_BEACON:
                 case MESH_MSG_TYPE_PROXY_CONFIGURATION:
                     if ((*client_callbacks[msg_type])){
-                        (*client_callbacks[msg_type])(MESH_PROXY_DATA_PACKET, 0, sar_buffer.reassembly_buffer, reassembly_offset);
+                        (*client_callbacks[msg_type])(MESH_PROXY_DATA_PACKET, connection->con_handle, connection->reassembly_buffer, connection->reassembly_offset);
                     }
-                    reassembly_offset = 0;
+                    connection->reassembly_offset = 0;
                     break;
                 default:
                     log_info("gatt bearer: message type %d not supported", msg_type);
@@ -248,27 +284,38 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                 case HCI_EVENT_MESH_META:
                     switch (hci_event_mesh_meta_get_subevent_code(packet)){
                         case MESH_SUBEVENT_PROXY_CONNECTED:
-                            gatt_bearer_mtu = ATT_DEFAULT_MTU;
-                            gatt_bearer_con_handle = mesh_subevent_proxy_connected_get_con_handle(packet);
+                            con_handle = mesh_subevent_proxy_connected_get_con_handle(packet);
+                            connection = gatt_bearer_connection_create(con_handle);
+                            if (connection == NULL){
+                                log_error("gatt bearer: no free connection for 0x%04x", con_handle);
+                                return;
+                            }
                             gatt_bearer_emit_event_for_all(packet, size);
                             break;
                         case MESH_SUBEVENT_PROXY_DISCONNECTED:
-                            gatt_bearer_con_handle = HCI_CON_HANDLE_INVALID;
+                            con_handle = mesh_subevent_proxy_disconnected_get_con_handle(packet);
+                            connection = gatt_bearer_connection_for_con_handle(con_handle);
+                            if (connection == NULL) return;
+                            connection->con_handle = HCI_CON_HANDLE_INVALID;
                             gatt_bearer_emit_event_for_all(packet, size);
                             break;
                         case MESH_SUBEVENT_CAN_SEND_NOW:
                             con_handle = little_endian_read_16(packet, 3); 
-                            if (con_handle == HCI_CON_HANDLE_INVALID) return;
+                            connection = gatt_bearer_connection_for_con_handle(con_handle);
+                            if (connection == NULL) return;
 
-                            if (!outgoing_ready){
-                                gatt_bearer_emit_can_send_now();
+                            if (!connection->outgoing_ready){
+                                gatt_bearer_emit_can_send_now(connection);
                                 return;
                             }
-                            gatt_bearer_start_sending(con_handle);
+                            gatt_bearer_start_sending(connection);
                             return;
                         default:
                             break;
                     }
+                    break;
+                default:
+                    break;
             }
             break;
         default:
@@ -277,6 +324,10 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
 }
 
 void gatt_bearer_init(void){
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        gatt_bearer_connections[i].con_handle = HCI_CON_HANDLE_INVALID;
+    }
     mesh_proxy_service_server_init();
     mesh_proxy_service_server_register_packet_handler(packet_handler);
 }
@@ -291,46 +342,50 @@ void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t
     client_callbacks[MESH_MSG_TYPE_PROXY_CONFIGURATION] = _packet_handler;
 }
 
-void gatt_bearer_request_can_send_now_for_network_pdu(void){
-    gatt_bearer_request(MESH_MSG_TYPE_NETWORK_PDU);
+void gatt_bearer_request_can_send_now_for_network_pdu(hci_con_handle_t con_handle){
+    gatt_bearer_request(con_handle, MESH_MSG_TYPE_NETWORK_PDU);
 }
-void gatt_bearer_request_can_send_now_for_beacon(void){
-    gatt_bearer_request(MESH_MSG_TYPE_BEACON);
+void gatt_bearer_request_can_send_now_for_beacon(hci_con_handle_t con_handle){
+    gatt_bearer_request(con_handle, MESH_MSG_TYPE_BEACON);
 }
-void gatt_bearer_request_can_send_now_for_mesh_proxy_configuration(void){
-    gatt_bearer_request(MESH_MSG_TYPE_PROXY_CONFIGURATION);
+void gatt_bearer_request_can_send_now_for_mesh_proxy_configuration(hci_con_handle_t con_handle){
+    gatt_bearer_request(con_handle, MESH_MSG_TYPE_PROXY_CONFIGURATION);
 }
 
-static void gatt_bearer_send_pdu(uint16_t con_handle, const uint8_t * pdu, uint16_t size){
+static void gatt_bearer_send_pdu(hci_con_handle_t con_handle, mesh_msg_type_t type, const uint8_t * pdu, uint16_t size){
     if (!pdu || size <= 0) return; 
-    if (con_handle == HCI_CON_HANDLE_INVALID) return;
+    gatt_bearer_connection_t * connection = gatt_bearer_connection_for_con_handle(con_handle);
+    if (connection == NULL) return;
+    // use current ATT MTU for segmentation
+    uint16_t mtu = att_server_get_mtu(con_handle);
+    if (mtu >= ATT_DEFAULT_MTU){
+        connection->mtu = mtu;
+    }
+
     // store pdu, request to send
-    proxy_pdu = pdu;
-    proxy_pdu_size = size;
-    segmentation_offset = 0;
+    connection->outgoing_msg_type = type;
+    connection->proxy_pdu = pdu;
+    connection->proxy_pdu_size = size;
+    connection->segmentation_offset = 0;
 
     // check if segmentation is necessary
-    if (proxy_pdu_size > (gatt_bearer_mtu - 1 - 3)){
-        segmentation_state = MESH_MSG_SAR_FIELD_FIRST_SEGMENT;
+    if (connection->proxy_pdu_size > (connection->mtu - 1 - 3)){
+        connection->segmentation_state = MESH_MSG_SAR_FIELD_FIRST_SEGMENT;
     } else {
-        segmentation_state = MESH_MSG_SAR_FIELD_COMPLETE_MSG;
+        connection->segmentation_state = MESH_MSG_SAR_FIELD_COMPLETE_MSG;
     }
-    outgoing_ready = 1;
-    gatt_bearer_start_sending(con_handle);
+    connection->outgoing_ready = 1;
+    gatt_bearer_start_sending(connection);
 }
 
-void gatt_bearer_send_network_pdu(const uint8_t * data, uint16_t data_len){
-    msg_type = MESH_MSG_TYPE_NETWORK_PDU;
-    gatt_bearer_send_pdu(gatt_bearer_con_handle, data, data_len);
+void gatt_bearer_send_network_pdu(hci_con_handle_t con_handle, const uint8_t * data, uint16_t data_len){
+    gatt_bearer_send_pdu(con_handle, MESH_MSG_TYPE_NETWORK_PDU, data, data_len);
 }
 
-void gatt_bearer_send_beacon(const uint8_t * data, uint16_t data_len){
-    msg_type = MESH_MSG_TYPE_BEACON;
-    gatt_bearer_send_pdu(gatt_bearer_con_handle, data, data_len);
+void gatt_bearer_send_beacon(hci_con_handle_t con_handle, const uint8_t * data, uint16_t data_len){
+    gatt_bearer_send_pdu(con_handle, MESH_MSG_TYPE_BEACON, data, data_len);
 }
 
-void gatt_bearer_send_mesh_proxy_configuration(const uint8_t * data, uint16_t data_len){
-    msg_type = MESH_MSG_TYPE_PROXY_CONFIGURATION;
-    gatt_bearer_send_pdu(gatt_bearer_con_handle, data, data_len);
+void gatt_bearer_send_mesh_proxy_configuration(hci_con_handle_t con_handle, const uint8_t * data, uint16_t data_len){
+    gatt_bearer_send_pdu(con_handle, MESH_MSG_TYPE_PROXY_CONFIGURATION, data, data_len);
 }
-
@@ -42,6 +42,8 @@
 #include <stdint.h>
 
 #include "btstack_defines.h"
+#include "bluetooth.h"
+#include "ble/gatt-service/mesh_proxy_service_server.h"
 
 #if defined __cplusplus
 extern "C" {
@@ -60,20 +62,23 @@ void gatt_bearer_register_for_beacon(btstack_packet_handler_t packet_handler);
 void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t _packet_handler);
 
 /**
- * Request can send now event for particular message type: Mesh Message, Mesh Beacon, proxy configuration
+ * Request can send now event for particular message type on a Proxy connection: Mesh Message, Mesh Beacon, proxy configuration
+ * @note MESH_SUBEVENT_CAN_SEND_NOW and MESH_SUBEVENT_MESSAGE_SENT contain the con_handle
+ * @param con_handle
  */
-void gatt_bearer_request_can_send_now_for_network_pdu(void);
-void gatt_bearer_request_can_send_now_for_beacon(void);
-void gatt_bearer_request_can_send_now_for_mesh_proxy_configuration(void);
+void gatt_bearer_request_can_send_now_for_network_pdu(hci_con_handle_t con_handle);
+void gatt_bearer_request_can_send_now_for_beacon(hci_con_handle_t con_handle);
+void gatt_bearer_request_can_send_now_for_mesh_proxy_configuration(hci_con_handle_t con_handle);
 
 /**
- * Send particular message type: Mesh Message, Mesh Beacon, proxy configuration
+ * Send particular message type on a Proxy connection: Mesh Message, Mesh Beacon, proxy configuration
+ * @param con_handle
  * @param data to send 
  * @param data_len max 29 bytes
  */
-void gatt_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size); 
-void gatt_bearer_send_beacon(const uint8_t * beacon_update, uint16_t size); 
-void gatt_bearer_send_mesh_proxy_configuration(const uint8_t * proxy_configuration, uint16_t size); 
+void gatt_bearer_send_network_pdu(hci_con_handle_t con_handle, const uint8_t * network_pdu, uint16_t size); 
+void gatt_bearer_send_beacon(hci_con_handle_t con_handle, const uint8_t * beacon_update, uint16_t size); 
+void gatt_bearer_send_mesh_proxy_configuration(hci_con_handle_t con_handle, const uint8_t * proxy_configuration, uint16_t size); 
 
 #if defined __cplusplus
 }
@@ -56,6 +56,7 @@
 #include "mesh/mesh_configuration_server.h"
 #include "mesh/mesh_health_server.h"
 #include "mesh/mesh_foundation.h"
+#include "mesh/mesh_friend.h"
 #include "mesh/mesh_generic_model.h"
 #include "mesh/mesh_generic_on_off_server.h"
 #include "mesh/mesh_iv_index_seq_number.h"
@@ -69,8 +70,25 @@
 #include "mesh/provisioning.h"
 #include "mesh/provisioning_device.h"
 
+// configuration changes are written to TLV after this quiet period, 0 = write immediately
+#ifndef MESH_NODE_STORAGE_DELAY_MS
+#define MESH_NODE_STORAGE_DELAY_MS 500
+#endif
+
+// max delay between first configuration change and write to TLV
+#ifndef MESH_NODE_STORAGE_MAX_DELAY_MS
+#define MESH_NODE_STORAGE_MAX_DELAY_MS 5000
+#endif
+
+// mesh_model_t.storage_pending
+#define MESH_NODE_STORAGE_PENDING_SUBSCRIPTIONS 1
+#define MESH_NODE_STORAGE_PENDING_PUBLICATION   2
+#define MESH_NODE_STORAGE_PENDING_APPKEY_LIST   4
+
 static void mesh_node_store_provisioning_data(mesh_provisioning_data_t * provisioning_data);
 static int mesh_node_startup_from_tlv(void);
+static void mesh_node_storage_mark_model(mesh_model_t * mesh_model, uint8_t pending);
+static void mesh_node_storage_mark_foundation(void);
 
 // Persistent storage structures
 
@@ -155,10 +173,6 @@ static uint8_t random_device_uuid[16];
 static const btstack_tlv_t * btstack_tlv_singleton_impl;
 static void *                btstack_tlv_singleton_context;
 
-// IV Index persistence
-static uint32_t sequence_number_last_stored;
-static uint32_t sequence_number_storage_trigger;
-
 // Attention Timer
 static uint8_t                attention_timer_timeout_s;
 static btstack_timer_source_t attention_timer_timer;
@@ -360,6 +374,10 @@ void mesh_foundation_state_load(void){
 }
 
 void mesh_foundation_state_store(void){
+    mesh_node_storage_mark_foundation();
+}
+
+static void mesh_foundation_state_write(void){
     mesh_persistent_foundation_t data;
     data.gatt_proxy       = mesh_foundation_gatt_proxy_get();
     data.beacon           = mesh_foundation_beacon_get();
@@ -453,10 +471,11 @@ static void mesh_model_load_subscriptions(mesh_model_t * mesh_model){
     btstack_tlv_singleton_impl->get_tag(btstack_tlv_singleton_context, tag, (uint8_t *) &mesh_model->subscriptions, sizeof(mesh_model->subscriptions));
     // update ref count
 
-    // increase ref counts for virtual subscriptions
+    // add to subscription filter and increase ref counts for virtual subscriptions
     uint16_t i;
     for (i = 0; i<MAX_NR_MESH_SUBSCRIPTION_PER_MODEL ; i++){
         uint16_t src = mesh_model->subscriptions[i];
+        mesh_node_subscription_add(src);
         if (mesh_network_address_virtual(src)){
             mesh_virtual_address_t * virtual_address = mesh_virtual_address_for_pseudo_dst(src);
             mesh_virtual_address_increase_refcount(virtual_address);
@@ -465,6 +484,10 @@ static void mesh_model_load_subscriptions(mesh_model_t * mesh_model){
 }
 
 void mesh_model_store_subscriptions(mesh_model_t * model){
+    mesh_node_storage_mark_model(model, MESH_NODE_STORAGE_PENDING_SUBSCRIPTIONS);
+}
+
+static void mesh_model_write_subscriptions(mesh_model_t * model){
     uint32_t tag = mesh_model_subscription_tag_for_index(model->mid);
     int result = btstack_tlv_singleton_impl->store_tag(btstack_tlv_singleton_context, tag, (uint8_t *) &model->subscriptions, sizeof(model->subscriptions));
     report_store_error(result, "subscription");
@@ -541,6 +564,10 @@ static void mesh_model_load_publication(mesh_model_t * mesh_model){
 }
 
 void mesh_model_store_publication(mesh_model_t * mesh_model){
+    mesh_node_storage_mark_model(mesh_model, MESH_NODE_STORAGE_PENDING_PUBLICATION);
+}
+
+static void mesh_model_write_publication(mesh_model_t * mesh_model){
     mesh_publication_model_t * publication = mesh_model->publication_model;
     if (publication == NULL) return;
 
@@ -746,6 +773,10 @@ static void mesh_load_appkey_list(mesh_model_t * model){
 }
 
 static void mesh_store_appkey_list(mesh_model_t * model){
+    mesh_node_storage_mark_model(model, MESH_NODE_STORAGE_PENDING_APPKEY_LIST);
+}
+
+static void mesh_write_appkey_list(mesh_model_t * model){
     uint32_t tag = mesh_model_tag_for_index(model->mid);
     int result = btstack_tlv_singleton_impl->store_tag(btstack_tlv_singleton_context, tag, (uint8_t *) &model->appkey_indices, sizeof(model->appkey_indices));
     report_store_error(result, "appkey list");
@@ -870,8 +901,8 @@ static void mesh_store_iv_index_and_sequence_number(uint32_t iv_index, uint32_t
     int result = btstack_tlv_singleton_impl->store_tag(btstack_tlv_singleton_context, mesh_tag_for_iv_index_and_seq_number, (uint8_t *) &data, sizeof(data));
     report_store_error(result, "index and sequence number");
 
-    sequence_number_last_stored = data.seq_number;
-    sequence_number_storage_trigger = sequence_number_last_stored + MESH_SEQUENCE_NUMBER_STORAGE_INTERVAL;
+    // sequence numbers up to the next interval are used without storing, the interval is skipped on startup
+    mesh_sequence_number_set_reserved_limit(data.seq_number + MESH_SEQUENCE_NUMBER_STORAGE_INTERVAL);
 }
 
 static void mesh_persist_iv_index_and_sequence_number(void){
@@ -879,13 +910,6 @@ static void mesh_persist_iv_index_and_sequence_number(void){
 }
 
 
-// higher layer - only store if sequence number is higher than trigger
-static void mesh_persist_iv_index_and_sequence_number_if_needed(void){
-    if (mesh_sequence_number_peek() >= sequence_number_storage_trigger){
-        mesh_persist_iv_index_and_sequence_number();
-    }
-}
-
 static void mesh_access_secure_network_beacon_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
     UNUSED(channel);
     UNUSED(size);
@@ -1009,7 +1033,111 @@ static void mesh_access_secure_network_beacon_handler(uint8_t packet_type, uint1
 
 static const uint32_t mesh_tag_for_prov_data = ((uint32_t) 'P' << 24) | ((uint32_t) 'R' << 16) | ((uint32_t) 'O' <<  8) | (uint32_t)'V';
 
+// Write-behind for configuration changes, sequence number and IV Index are stored directly
+static btstack_timer_source_t mesh_node_storage_timer;
+static int      mesh_node_storage_timer_active;
+static uint32_t mesh_node_storage_first_pending_ms;
+static int      mesh_node_storage_foundation_pending;
+
+static void mesh_node_storage_write_model(mesh_model_t * mesh_model){
+    uint8_t pending = mesh_model->storage_pending;
+    mesh_model->storage_pending = 0;
+    if (pending & MESH_NODE_STORAGE_PENDING_SUBSCRIPTIONS){
+        mesh_model_write_subscriptions(mesh_model);
+    }
+    if (pending & MESH_NODE_STORAGE_PENDING_PUBLICATION){
+        mesh_model_write_publication(mesh_model);
+    }
+    if (pending & MESH_NODE_STORAGE_PENDING_APPKEY_LIST){
+        mesh_write_appkey_list(mesh_model);
+    }
+}
+
+static void mesh_node_storage_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    mesh_node_storage_timer_active = 0;
+    mesh_node_storage_flush();
+}
+
+static void mesh_node_storage_schedule(void){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    if (mesh_node_storage_timer_active){
+        // restart quiet period, but don't delay write beyond MESH_NODE_STORAGE_MAX_DELAY_MS
+        if ((now - mesh_node_storage_first_pending_ms) >= (MESH_NODE_STORAGE_MAX_DELAY_MS - MESH_NODE_STORAGE_DELAY_MS)) return;
+        btstack_run_loop_remove_timer(&mesh_node_storage_timer);
+    } else {
+        mesh_node_storage_timer_active = 1;
+        mesh_node_storage_first_pending_ms = now;
+    }
+    btstack_run_loop_set_timer_handler(&mesh_node_storage_timer, &mesh_node_storage_timeout);
+    btstack_run_loop_set_timer(&mesh_node_storage_timer, MESH_NODE_STORAGE_DELAY_MS);
+    btstack_run_loop_add_timer(&mesh_node_storage_timer);
+}
+
+static void mesh_node_storage_mark_model(mesh_model_t * mesh_model, uint8_t pending){
+    mesh_model->storage_pending |= pending;
+    if (MESH_NODE_STORAGE_DELAY_MS == 0){
+        mesh_node_storage_write_model(mesh_model);
+        return;
+    }
+    mesh_node_storage_schedule();
+}
+
+static void mesh_node_storage_mark_foundation(void){
+    mesh_node_storage_foundation_pending = 1;
+    if (MESH_NODE_STORAGE_DELAY_MS == 0){
+        mesh_node_storage_flush();
+        return;
+    }
+    mesh_node_storage_schedule();
+}
+
+// pending changes of models are dropped, e.g. before node reset
+static void mesh_node_storage_discard(void){
+    if (mesh_node_storage_timer_active){
+        mesh_node_storage_timer_active = 0;
+        btstack_run_loop_remove_timer(&mesh_node_storage_timer);
+    }
+    mesh_node_storage_foundation_pending = 0;
+    mesh_element_iterator_t element_it;
+    mesh_element_iterator_init(&element_it);
+    while (mesh_element_iterator_has_next(&element_it)){
+        mesh_element_t * element = mesh_element_iterator_next(&element_it);
+        mesh_model_iterator_t model_it;
+        mesh_model_iterator_init(&model_it, element);
+        while (mesh_model_iterator_has_next(&model_it)){
+            mesh_model_t * model = mesh_model_iterator_next(&model_it);
+            model->storage_pending = 0;
+        }
+    }
+}
+
+void mesh_node_storage_flush(void){
+    if (mesh_node_storage_timer_active){
+        mesh_node_storage_timer_active = 0;
+        btstack_run_loop_remove_timer(&mesh_node_storage_timer);
+    }
+    if (mesh_node_storage_foundation_pending){
+        mesh_node_storage_foundation_pending = 0;
+        mesh_foundation_state_write();
+    }
+    mesh_element_iterator_t element_it;
+    mesh_element_iterator_init(&element_it);
+    while (mesh_element_iterator_has_next(&element_it)){
+        mesh_element_t * element = mesh_element_iterator_next(&element_it);
+        mesh_model_iterator_t model_it;
+        mesh_model_iterator_init(&model_it, element);
+        while (mesh_model_iterator_has_next(&model_it)){
+            mesh_model_t * model = mesh_model_iterator_next(&model_it);
+            if (model->storage_pending == 0) continue;
+            mesh_node_storage_write_model(model);
+        }
+    }
+}
+
 void mesh_node_reset(void){
+    // drop pending configuration writes
+    mesh_node_storage_discard();
     // PROV
     btstack_tlv_singleton_impl->delete_tag(btstack_tlv_singleton_context, mesh_tag_for_prov_data);
     // everything else
@@ -1019,6 +1147,9 @@ void mesh_node_reset(void){
     mesh_delete_virtual_addresses();
     mesh_delete_subscriptions();
     mesh_delete_publications();
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+    mesh_peer_delete_from_tlv();
+#endif
 }
 
 typedef struct {
@@ -1133,6 +1264,11 @@ static int mesh_node_startup_from_tlv(void){
         // load model publications
         mesh_load_publications();
 
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+        // load replay protection list
+        mesh_peer_load_from_tlv();
+#endif
+
 #if defined(ENABLE_MESH_ADV_BEARER) || defined(ENABLE_MESH_PB_ADV)
         // start sending Secure Network Beacon
         mesh_subnet_t * subnet = mesh_subnet_get_by_netkey_index(0);
@@ -1203,6 +1339,63 @@ static void mesh_node_setup_default_models(void){
     mesh_health_server_set_publication_model(&mesh_health_server_model, &mesh_health_server_publication);
 }
 
+#ifdef ENABLE_MESH_STATISTICS
+static void mesh_dump_latency(const char * name, const mesh_statistics_latency_t * latency){
+    uint32_t average_ms = (latency->count > 0) ? (latency->total_ms / latency->count) : 0;
+    printf("%-24s count %u, avg %u ms, max %u ms, <1,2,4..ms:", name, (int) latency->count, (int) average_ms, (int) latency->max_ms);
+    uint16_t i;
+    for (i=0;i<MESH_STATISTICS_LATENCY_BUCKETS;i++){
+        printf(" %u", (int) latency->buckets[i]);
+    }
+    printf("\n");
+}
+
+void mesh_dump_statistics(void){
+    const adv_bearer_statistics_t * adv = adv_bearer_get_statistics();
+    printf("ADV Bearer:      rx network %u, beacon %u, pb-adv %u, ignored %u - tx network %u, beacon %u, pb-adv %u, advertisements %u, max queued %u\n",
+           (int) adv->rx_network_pdus, (int) adv->rx_beacons, (int) adv->rx_provisioning_pdus, (int) adv->rx_ignored,
+           (int) adv->tx_network_pdus, (int) adv->tx_beacons, (int) adv->tx_provisioning_pdus, (int) adv->tx_advertisements, adv->max_tx_queued);
+    mesh_dump_latency("ADV Bearer TX", &adv->tx_latency);
+
+    const mesh_network_statistics_t * network = mesh_network_get_statistics();
+    printf("Network:         rx adv %u, gatt %u, proxy %u, delivered %u - cache hits %u/%u (obfuscated/decrypted)\n",
+           (int) network->rx_adv, (int) network->rx_gatt, (int) network->rx_proxy_configuration, (int) network->rx_delivered,
+           (int) network->cache_hits_obfuscated, (int) network->cache_hits);
+    printf("Network:         dropped length %u, no buffer %u, no network key %u, invalid address %u\n",
+           (int) network->rx_dropped_length, (int) network->rx_dropped_no_buffer, (int) network->rx_dropped_no_network_key, (int) network->rx_dropped_invalid_address);
+    printf("Network:         tx local %u, relay %u, gatt %u, adv %u - aes128 %u, ccm %u - max received %u, validations %u, queued %u\n",
+           (int) network->tx_local, (int) network->tx_relay, (int) network->tx_gatt, (int) network->tx_adv,
+           (int) network->aes128_operations, (int) network->ccm_operations,
+           network->max_received_queued, network->max_validations_active, network->max_outgoing_queued);
+    mesh_dump_latency("Network RX", &network->rx_latency);
+    mesh_dump_latency("Network TX", &network->tx_latency);
+
+    const mesh_lower_transport_statistics_t * lower = mesh_lower_transport_get_statistics();
+    printf("Lower Transport: rx unsegmented %u, segments %u, complete %u, incomplete %u - dropped seq %u, segments %u, unsubscribed %u\n",
+           (int) lower->rx_unsegmented, (int) lower->rx_segments, (int) lower->rx_segmented_complete, (int) lower->rx_segmented_incomplete,
+           (int) lower->rx_dropped_seq, (int) lower->rx_dropped_segments, (int) lower->rx_dropped_unsubscribed);
+    printf("Lower Transport: acks tx %u, rx %u - tx unsegmented %u, segmented %u, segments %u, retransmissions %u, complete %u, failed %u, max queued %u\n",
+           (int) lower->tx_acks, (int) lower->rx_acks, (int) lower->tx_unsegmented, (int) lower->tx_segmented, (int) lower->tx_segments,
+           (int) lower->tx_retransmissions, (int) lower->tx_segmented_complete, (int) lower->tx_segmented_failed, lower->max_outgoing_queued);
+    mesh_dump_latency("Lower Transport RX", &lower->rx_reassembly_latency);
+    mesh_dump_latency("Lower Transport TX", &lower->tx_segmented_latency);
+
+    const mesh_upper_transport_statistics_t * upper = mesh_upper_transport_get_statistics();
+    printf("Upper Transport: rx access %u, control %u, decrypt failed %u - tx access %u, control %u - ccm %u\n",
+           (int) upper->rx_access, (int) upper->rx_control, (int) upper->rx_decrypt_failed,
+           (int) upper->tx_access, (int) upper->tx_control, (int) upper->ccm_operations);
+    mesh_dump_latency("Upper Transport RX", &upper->rx_latency);
+    mesh_dump_latency("Upper Transport TX", &upper->tx_latency);
+}
+
+void mesh_reset_statistics(void){
+    adv_bearer_reset_statistics();
+    mesh_network_reset_statistics();
+    mesh_lower_transport_reset_statistics();
+    mesh_upper_transport_reset_statistics();
+}
+#endif
+
 void mesh_init(void){
 
     // register for HCI events
@@ -1228,6 +1421,9 @@ void mesh_init(void){
     // Node Configuration
     mesh_node_init();
 
+    // all model subscription changes are tracked by Configuration Server and subscription load
+    mesh_node_subscription_filter_enable(1);
+
     // Network layer
     mesh_network_init();
 
@@ -1235,6 +1431,11 @@ void mesh_init(void){
     mesh_lower_transport_init();
     mesh_upper_transport_init();
 
+#ifdef ENABLE_MESH_FRIEND
+    // Friend feature
+    mesh_friend_init();
+#endif
+
     // Access layer
     mesh_access_init();
 
@@ -1245,7 +1446,7 @@ void mesh_init(void){
     beacon_register_for_secure_network_beacons(&mesh_access_secure_network_beacon_handler);
 
     // register for seq number updates
-    mesh_sequence_number_set_update_callback(&mesh_persist_iv_index_and_sequence_number_if_needed);
+    mesh_sequence_number_set_update_callback(&mesh_persist_iv_index_and_sequence_number);
 
     // register for control messages
     mesh_upper_transport_register_control_message_handler(&mesh_control_message_handler);
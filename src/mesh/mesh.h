@@ -101,10 +101,29 @@ int mesh_model_contains_appkey(mesh_model_t * mesh_model, uint16_t appkey_index)
 // Mesh Node Reset
 void mesh_node_reset(void);
 
+/**
+ * @brief Write pending foundation state and model configuration to TLV now
+ * @note Configuration changes are collected and written MESH_NODE_STORAGE_DELAY_MS after the last change
+ */
+void mesh_node_storage_flush(void);
+
 // Attention Timer
 void    mesh_attention_timer_set(uint8_t timer_s);
 uint8_t mesh_attention_timer_get(void);
 
+#ifdef ENABLE_MESH_STATISTICS
+/**
+ * @brief Print counters and latency histograms of ADV bearer, network, lower and upper transport
+ * @note per layer statistics are available via adv_bearer_get_statistics, mesh_network_get_statistics, ...
+ */
+void mesh_dump_statistics(void);
+
+/**
+ * @brief Reset statistics of all layers
+ */
+void mesh_reset_statistics(void);
+#endif
+
 // temp
 void mesh_access_key_refresh_revoke_keys(mesh_subnet_t * subnet);
 void mesh_access_netkey_finalize(mesh_network_key_t * network_key);
@@ -69,6 +69,12 @@ static btstack_linked_list_t  mesh_access_acknowledged_messages;
 static btstack_timer_source_t mesh_access_acknowledged_timer;
 static int                    mesh_access_acknowledged_timer_active;
 
+// active model transitions, driven by a shared timer
+static btstack_linked_list_t  mesh_access_transitions;
+static btstack_linked_list_t  mesh_access_transitions_due;
+static btstack_timer_source_t mesh_access_transitions_timer;
+static int                    mesh_access_transitions_timer_active;
+
 // Transitions
 static uint8_t mesh_transaction_id_counter = 0;
 
@@ -301,15 +307,49 @@ void mesh_access_transitions_init_transaction(mesh_transition_t * transition, ui
     transition->dst_address = dst_address;
 }
 
-static void mesh_server_transition_timeout(btstack_timer_source_t * ts){
-    mesh_transition_t * base_transition = (mesh_transition_t*) btstack_run_loop_get_timer_context(ts);
+static void mesh_access_transitions_run(btstack_timer_source_t * ts);
+
+static void mesh_access_transitions_update_timer(void){
+    if (mesh_access_transitions_timer_active){
+        btstack_run_loop_remove_timer(&mesh_access_transitions_timer);
+        mesh_access_transitions_timer_active = 0;
+    }
+    if (btstack_linked_list_empty(&mesh_access_transitions)) return;
+
+    // find earliest timeout and set timer
+    uint32_t now = btstack_run_loop_get_time_ms();
+    int32_t next_timeout_ms = INT32_MAX;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &mesh_access_transitions);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        mesh_transition_t * transition = (mesh_transition_t *) btstack_linked_list_iterator_next(&it);
+        int32_t timeout_delta_ms = btstack_time_delta(transition->timeout_ms, now);
+        if (timeout_delta_ms < next_timeout_ms){
+            next_timeout_ms = timeout_delta_ms;
+        }
+    }
+    if (next_timeout_ms < 0){
+        next_timeout_ms = 0;
+    }
+
+    btstack_run_loop_set_timer(&mesh_access_transitions_timer, (uint32_t) next_timeout_ms);
+    btstack_run_loop_set_timer_handler(&mesh_access_transitions_timer, &mesh_access_transitions_run);
+    btstack_run_loop_add_timer(&mesh_access_transitions_timer);
+    mesh_access_transitions_timer_active = 1;
+}
+
+static void mesh_access_transitions_schedule(mesh_transition_t * base_transition, uint32_t timeout_ms){
+    base_transition->timeout_ms = timeout_ms;
+    btstack_linked_list_add_tail(&mesh_access_transitions, (btstack_linked_item_t *) base_transition);
+}
+
+static void mesh_server_transition_timeout(mesh_transition_t * base_transition){
     switch (base_transition->state){
         case MESH_TRANSITION_STATE_DELAYED:
             base_transition->state = MESH_TRANSITION_STATE_ACTIVE;
             (*base_transition->transition_callback)(base_transition, MODEL_STATE_UPDATE_REASON_TRANSITION_START);
             if (base_transition->num_steps > 0){
-                btstack_run_loop_set_timer(&base_transition->timer, base_transition->step_duration_ms);
-                btstack_run_loop_add_timer(&base_transition->timer);
+                mesh_access_transitions_schedule(base_transition, base_transition->timeout_ms + base_transition->step_duration_ms);
                 return;
             }
             base_transition->state = MESH_TRANSITION_STATE_IDLE;
@@ -321,8 +361,8 @@ static void mesh_server_transition_timeout(btstack_timer_source_t * ts){
             }
             (*base_transition->transition_callback)(base_transition, MODEL_STATE_UPDATE_REASON_TRANSITION_ACTIVE);
             if (base_transition->num_steps > 0){
-                btstack_run_loop_set_timer(&base_transition->timer, base_transition->step_duration_ms);
-                btstack_run_loop_add_timer(&base_transition->timer);
+                // next step relative to last deadline keeps transitions started together in sync
+                mesh_access_transitions_schedule(base_transition, base_transition->timeout_ms + base_transition->step_duration_ms);
                 return;
             }
             base_transition->state = MESH_TRANSITION_STATE_IDLE;
@@ -333,30 +373,58 @@ static void mesh_server_transition_timeout(btstack_timer_source_t * ts){
     }
 }
 
+static void mesh_access_transitions_run(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    mesh_access_transitions_timer_active = 0;
+
+    uint32_t now = btstack_run_loop_get_time_ms();
+
+    // collect all due transitions first, callbacks may setup or abort transitions
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &mesh_access_transitions);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        mesh_transition_t * transition = (mesh_transition_t *) btstack_linked_list_iterator_next(&it);
+        if (btstack_time_delta(now, transition->timeout_ms) < 0) continue;
+        btstack_linked_list_iterator_remove(&it);
+        btstack_linked_list_add_tail(&mesh_access_transitions_due, (btstack_linked_item_t *) transition);
+    }
+
+    // update all due transitions in one batch
+    while (!btstack_linked_list_empty(&mesh_access_transitions_due)){
+        mesh_transition_t * transition = (mesh_transition_t *) btstack_linked_list_pop(&mesh_access_transitions_due);
+        mesh_server_transition_timeout(transition);
+    }
+
+    mesh_access_transitions_update_timer();
+}
+
 void mesh_access_transition_setup(mesh_model_t *mesh_model, mesh_transition_t * base_transition, uint8_t transition_time_gdtt, uint8_t delay_time_gdtt, void (*transition_callback)(mesh_transition_t * base_transition, model_state_update_reason_t event)){
     
+    // stop ongoing transition
+    btstack_linked_list_remove(&mesh_access_transitions, (btstack_linked_item_t *) base_transition);
+    btstack_linked_list_remove(&mesh_access_transitions_due, (btstack_linked_item_t *) base_transition);
+
     base_transition->mesh_model          = mesh_model;
     base_transition->num_steps           = mesh_access_transitions_num_steps_from_gdtt(transition_time_gdtt);
     base_transition->step_resolution     = (mesh_default_transition_step_resolution_t) (transition_time_gdtt >> 6);
     base_transition->step_duration_ms    = mesh_access_transitions_step_ms_from_gdtt(transition_time_gdtt);
     base_transition->transition_callback = transition_callback;
 
-    btstack_run_loop_set_timer_context(&base_transition->timer, base_transition);
-    btstack_run_loop_set_timer_handler(&base_transition->timer, &mesh_server_transition_timeout);
+    uint32_t now = btstack_run_loop_get_time_ms();
 
     // delayed
     if (delay_time_gdtt > 0){
         base_transition->state = MESH_TRANSITION_STATE_DELAYED;
-        btstack_run_loop_set_timer(&base_transition->timer, delay_time_gdtt * 5);
-        btstack_run_loop_add_timer(&base_transition->timer);
+        mesh_access_transitions_schedule(base_transition, now + (delay_time_gdtt * 5));
+        mesh_access_transitions_update_timer();
         return;
     }
 
     // started
     if (base_transition->num_steps > 0){
         base_transition->state = MESH_TRANSITION_STATE_ACTIVE;
-        btstack_run_loop_set_timer(&base_transition->timer, base_transition->step_duration_ms);
-        btstack_run_loop_add_timer(&base_transition->timer);
+        mesh_access_transitions_schedule(base_transition, now + base_transition->step_duration_ms);
+        mesh_access_transitions_update_timer();
         return;
     }
     
@@ -367,7 +435,11 @@ void mesh_access_transition_setup(mesh_model_t *mesh_model, mesh_transition_t *
 }
 
 void mesh_access_transitions_abort_transaction(mesh_transition_t * base_transition){
-    btstack_run_loop_add_timer(&base_transition->timer);
+    btstack_linked_list_remove(&mesh_access_transitions_due, (btstack_linked_item_t *) base_transition);
+    if (btstack_linked_list_remove(&mesh_access_transitions, (btstack_linked_item_t *) base_transition)){
+        mesh_access_transitions_update_timer();
+    }
+    base_transition->state = MESH_TRANSITION_STATE_IDLE;
 }
 
 uint16_t mesh_pdu_ctl(mesh_pdu_t * pdu){
@@ -831,6 +903,58 @@ void mesh_access_message_processed(mesh_pdu_t * pdu){
     }
 }
 
+static void mesh_access_message_deliver(mesh_model_t * model, const mesh_operation_t * operation, mesh_pdu_t * pdu, uint32_t opcode){
+    if (mesh_access_validate_appkey_index(model, mesh_pdu_appkey_index(pdu)) == 0) return;
+    mesh_access_acknowledged_received(mesh_pdu_src(pdu), opcode);
+    mesh_access_received_pdu_refcount++;
+    operation->handler(model, pdu);
+}
+
+// deliver to models of given element, or to models subscribed to dst if element is NULL
+static void mesh_access_message_dispatch(mesh_element_t * element, uint16_t dst, mesh_pdu_t * pdu, uint32_t opcode, uint16_t opcode_size){
+    mesh_model_t * model;
+
+    if (mesh_node_opcode_index_complete()){
+        uint16_t len = mesh_pdu_len(pdu);
+        mesh_model_t * last_model = NULL;
+        mesh_model_operation_iterator_t it;
+        mesh_model_operation_iterator_init(&it, opcode);
+        while (mesh_model_operation_iterator_has_next(&it)){
+            const mesh_model_operation_t * model_operation = mesh_model_operation_iterator_next(&it);
+            model = model_operation->model;
+            // use first operation with sufficient length per model, entries of a model are adjacent
+            if (model == last_model) continue;
+            if (element != NULL){
+                if (model->element != element) continue;
+            } else {
+                if (mesh_model_contains_subscription(model, dst) == 0) continue;
+            }
+            if ((opcode_size + model_operation->operation->minimum_length) > len) continue;
+            last_model = model;
+            mesh_access_message_deliver(model, model_operation->operation, pdu, opcode);
+        }
+        return;
+    }
+
+    // opcode index incomplete, search models
+    mesh_element_iterator_t element_it;
+    mesh_element_iterator_init(&element_it);
+    while (mesh_element_iterator_has_next(&element_it)){
+        mesh_element_t * current_element = mesh_element_iterator_next(&element_it);
+        if ((element != NULL) && (current_element != element)) continue;
+        mesh_model_iterator_t model_it;
+        mesh_model_iterator_init(&model_it, current_element);
+        while (mesh_model_iterator_has_next(&model_it)){
+            model = mesh_model_iterator_next(&model_it);
+            if ((element == NULL) && (mesh_model_contains_subscription(model, dst) == 0)) continue;
+            // find opcode in table
+            const mesh_operation_t * operation = mesh_model_lookup_operation(model, pdu);
+            if (operation == NULL) continue;
+            mesh_access_message_deliver(model, operation, pdu, opcode);
+        }
+    }
+}
+
 static void mesh_access_message_process_handler(mesh_pdu_t * pdu){
 
     // init use count
@@ -850,26 +974,12 @@ static void mesh_access_message_process_handler(mesh_pdu_t * pdu){
     printf("MESH Access Message, Opcode = %x: ", opcode);
     printf_hexdump(mesh_pdu_data(pdu), len);
 
-    uint16_t src = mesh_pdu_src(pdu);
     uint16_t dst = mesh_pdu_dst(pdu);
-    uint16_t appkey_index = mesh_pdu_appkey_index(pdu);
     if (mesh_network_address_unicast(dst)){
         // loookup element by unicast address
         mesh_element_t * element = mesh_node_element_for_unicast_address(dst);
         if (element != NULL){
-            // iterate over models, look for operation
-            mesh_model_iterator_t model_it;
-            mesh_model_iterator_init(&model_it, element);
-            while (mesh_model_iterator_has_next(&model_it)){
-                mesh_model_t * model = mesh_model_iterator_next(&model_it);
-                // find opcode in table
-                const mesh_operation_t * operation = mesh_model_lookup_operation(model, pdu);
-                if (operation == NULL) continue;
-                if (mesh_access_validate_appkey_index(model, appkey_index) == 0) continue;
-                mesh_access_acknowledged_received(src, opcode);
-                mesh_access_received_pdu_refcount++;
-                operation->handler(model, pdu);
-            }
+            mesh_access_message_dispatch(element, dst, pdu, opcode, opcode_size);
         }
     }
     else if (mesh_network_address_group(dst)){
@@ -898,41 +1008,12 @@ static void mesh_access_message_process_handler(mesh_pdu_t * pdu){
                     break;
             }
             if (deliver_to_primary_element){
-                mesh_model_iterator_t model_it;
-                mesh_model_iterator_init(&model_it, mesh_node_get_primary_element());
-                while (mesh_model_iterator_has_next(&model_it)){
-                    mesh_model_t * model = mesh_model_iterator_next(&model_it);
-                    // find opcode in table
-                    const mesh_operation_t * operation = mesh_model_lookup_operation(model, pdu);
-                    if (operation == NULL) continue;
-                    if (mesh_access_validate_appkey_index(model, appkey_index) == 0) continue;
-                    mesh_access_acknowledged_received(src, opcode);
-                    mesh_access_received_pdu_refcount++;
-                    operation->handler(model, pdu);
-                }
+                mesh_access_message_dispatch(mesh_node_get_primary_element(), dst, pdu, opcode, opcode_size);
             }
         }
         else {
-            // iterate over all elements / models, check subscription list
-            mesh_element_iterator_t it;
-            mesh_element_iterator_init(&it);
-            while (mesh_element_iterator_has_next(&it)){
-                mesh_element_t * element = (mesh_element_t *) mesh_element_iterator_next(&it);
-                mesh_model_iterator_t model_it;
-                mesh_model_iterator_init(&model_it, element);
-                while (mesh_model_iterator_has_next(&model_it)){
-                    mesh_model_t * model = mesh_model_iterator_next(&model_it);
-                    if (mesh_model_contains_subscription(model, dst)){
-                        // find opcode in table
-                        const mesh_operation_t * operation = mesh_model_lookup_operation(model, pdu);
-                        if (operation == NULL) continue;
-                        if (mesh_access_validate_appkey_index(model, appkey_index) == 0) continue;
-                        mesh_access_acknowledged_received(src, opcode);
-                        mesh_access_received_pdu_refcount++;
-                        operation->handler(model, pdu);
-                    }
-                }
-            }
+            // check subscription list of all models
+            mesh_access_message_dispatch(NULL, dst, pdu, opcode, opcode_size);
         }
     }
 
@@ -53,7 +53,10 @@ extern "C"
 {
 #endif
 
+// sequence numbers are reserved in blocks of this size, stored sequence number is updated when block is used up
+#ifndef MESH_SEQUENCE_NUMBER_STORAGE_INTERVAL
 #define MESH_SEQUENCE_NUMBER_STORAGE_INTERVAL 1000
+#endif
 
 typedef enum {
     MESH_DEFAULT_TRANSITION_STEP_RESOLUTION_100ms = 0x00u,
@@ -127,7 +130,9 @@ typedef enum {
 } mesh_transaction_status_t;
 
 typedef struct mesh_transition {
-    btstack_timer_source_t timer;
+    // all active transitions are driven by a shared timer
+    btstack_linked_item_t item;
+    uint32_t timeout_ms;
 
     mesh_transition_state_t state;
 
@@ -54,6 +54,7 @@
 #include "mesh/mesh_access.h"
 #include "mesh/mesh_crypto.h"
 #include "mesh/mesh_foundation.h"
+#include "mesh/mesh_friend.h"
 #include "mesh/mesh_iv_index_seq_number.h"
 #include "mesh/mesh_keys.h"
 #include "mesh/mesh_network.h"
@@ -104,6 +105,7 @@ static uint8_t mesh_model_add_subscription(mesh_model_t * mesh_model, uint16_t a
     for (i=0;i<MAX_NR_MESH_SUBSCRIPTION_PER_MODEL;i++){
         if (mesh_model->subscriptions[i] == MESH_ADDRESS_UNSASSIGNED) {
             mesh_model->subscriptions[i] = address;
+            mesh_node_subscription_add(address);
             return MESH_FOUNDATION_STATUS_SUCCESS;
         }
     }
@@ -115,6 +117,7 @@ static void mesh_model_delete_subscription(mesh_model_t * mesh_model, uint16_t a
     for (i=0;i<MAX_NR_MESH_SUBSCRIPTION_PER_MODEL;i++){
         if (mesh_model->subscriptions[i] == address) {
             mesh_model->subscriptions[i] = MESH_ADDRESS_UNSASSIGNED;
+            mesh_node_subscription_remove(address);
         }
     }
 }
@@ -122,6 +125,7 @@ static void mesh_model_delete_subscription(mesh_model_t * mesh_model, uint16_t a
 static void mesh_model_delete_all_subscriptions(mesh_model_t * mesh_model){
     uint16_t i;
     for (i=0;i<MAX_NR_MESH_SUBSCRIPTION_PER_MODEL;i++){
+        mesh_node_subscription_remove(mesh_model->subscriptions[i]);
         mesh_model->subscriptions[i] = MESH_ADDRESS_UNSASSIGNED;
     }
 }
@@ -266,6 +270,9 @@ static void config_composition_data_status(uint16_t netkey_index, uint16_t dest)
 #endif
 #ifdef ENABLE_MESH_PROXY_SERVER
     features |= 2;
+#endif
+#ifdef ENABLE_MESH_FRIEND
+    features |= 4;
 #endif
     mesh_access_transport_add_uint16(transport_pdu, features);
 
@@ -414,6 +421,12 @@ static void config_friend_set_handler(mesh_model_t *mesh_model, mesh_pdu_t * pdu
         if (mesh_foundation_friend_get() != MESH_FOUNDATION_STATE_NOT_SUPPORTED){
             mesh_foundation_friend_set(new_friend_state);
             mesh_foundation_state_store();
+#ifdef ENABLE_MESH_FRIEND
+            // disabling Friend feature terminates all friendships
+            if (new_friend_state == 0){
+                mesh_friend_reset();
+            }
+#endif
         }
 
         // send status
@@ -2122,16 +2135,14 @@ static void config_node_reset_handler(mesh_model_t *mesh_model, mesh_pdu_t * pdu
     mesh_access_message_processed(pdu);
 }
 
-static void low_power_node_poll_timeout_status(mesh_model_t *mesh_model, uint16_t netkey_index_dest, uint16_t dest, uint8_t status){
+static void low_power_node_poll_timeout_status(mesh_model_t *mesh_model, uint16_t netkey_index_dest, uint16_t dest, uint16_t lpn_address, uint32_t poll_timeout){
     UNUSED(mesh_model);
 
     mesh_transport_pdu_t * transport_pdu = mesh_access_setup_segmented_message(
         &mesh_foundation_low_power_node_poll_timeout_status,
-        status,
-        0,  // The unicast address of the Low Power node
-        0); // The current value of the PollTimeout timer of the Low Power node
+        lpn_address,
+        poll_timeout);
     if (!transport_pdu) return;
-    printf("TODO: send unicast address of the Low Power node and the current value of the PollTimeout timer, instead of 0s\n");
     // send as segmented access pdu
     config_server_send_message(netkey_index_dest, dest, (mesh_pdu_t *) transport_pdu);
 }
@@ -2139,8 +2150,14 @@ static void low_power_node_poll_timeout_status(mesh_model_t *mesh_model, uint16_
 static void config_low_power_node_poll_timeout_get_handler(mesh_model_t *mesh_model, mesh_pdu_t * pdu){
     mesh_access_parser_state_t parser;
     mesh_access_parser_init(&parser, (mesh_pdu_t*) pdu);
-    printf("TODO: implement get the current value of PollTimeout timer of the Low Power node within a Friend node\n");
-    low_power_node_poll_timeout_status(mesh_model, mesh_pdu_netkey_index(pdu), mesh_pdu_src(pdu), MESH_FOUNDATION_STATUS_SUCCESS);
+    uint16_t lpn_address = mesh_access_parser_get_u16(&parser);
+
+    // current value of PollTimeout timer in units of 100 ms, 0 if node is not Friend of this Low Power node
+    uint32_t poll_timeout = 0;
+#ifdef ENABLE_MESH_FRIEND
+    poll_timeout = mesh_friend_get_poll_timeout(lpn_address);
+#endif
+    low_power_node_poll_timeout_status(mesh_model, mesh_pdu_netkey_index(pdu), mesh_pdu_src(pdu), lpn_address, poll_timeout);
 
     mesh_access_message_processed(pdu);
 }
@@ -66,6 +66,17 @@ void mesh_k1(btstack_crypto_aes128_cmac_t * request, const uint8_t * n, uint16_t
  */
 void mesh_k2(btstack_crypto_aes128_cmac_t * request, const uint8_t * n, uint8_t * result, void (* callback)(void * arg), void * callback_arg);
 
+// max len of P for k2, friendship credentials use 0x01 || LPNAddress || FriendAddress || LPNCounter || FriendCounter
+#define MESH_K2_P_MAX_LEN 9
+
+/**
+ * Calculate mesh k2 function with custom P, e.g. for friendship security credentials
+ * @param p
+ * @param p_len <= MESH_K2_P_MAX_LEN
+ * @param result 33 bytes (7 bit NID + 16 byte Encryption Key + 16 byte Privacy Key)
+ */
+void mesh_k2_with_p(btstack_crypto_aes128_cmac_t * request, const uint8_t * n, const uint8_t * p, uint16_t p_len, uint8_t * result, void (* callback)(void * arg), void * callback_arg);
+
 /**
  * Calculate mesh k3 function
  */
@@ -102,7 +102,11 @@ void mesh_foundation_friend_set(uint8_t value){
     printf("MESH: Friend = 0x%x\n", mesh_foundation_friend);
 }
 uint8_t mesh_foundation_friend_get(void){
+#ifdef ENABLE_MESH_FRIEND
+    return mesh_foundation_friend;
+#else
     return MESH_FOUNDATION_STATE_NOT_SUPPORTED;
+#endif
 }
 
 void mesh_foundation_network_transmit_set(uint8_t network_transmit){
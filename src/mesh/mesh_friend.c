@@ -0,0 +1,675 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "mesh_friend.c"
+
+#include "mesh/mesh_friend.h"
+
+#include <string.h>
+#include <stdio.h>
+
+#include "btstack_debug.h"
+#include "btstack_linked_list.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+
+#include "mesh/mesh_crypto.h"
+#include "mesh/mesh_foundation.h"
+#include "mesh/mesh_iv_index_seq_number.h"
+#include "mesh/mesh_lower_transport.h"
+#include "mesh/mesh_node.h"
+
+// number of Low Power nodes we can be Friend for
+#ifndef MESH_FRIEND_NUM_LPNS
+#define MESH_FRIEND_NUM_LPNS 1
+#endif
+
+// number of Network PDUs stored per Low Power node, 2^MinQueueSizeLog requested by LPN must fit
+#ifndef MESH_FRIEND_QUEUE_SIZE
+#define MESH_FRIEND_QUEUE_SIZE 8
+#endif
+
+// number of group and virtual addresses in Friend Subscription List per Low Power node
+#ifndef MESH_FRIEND_SUBSCRIPTION_LIST_SIZE
+#define MESH_FRIEND_SUBSCRIPTION_LIST_SIZE 4
+#endif
+
+// time Friend keeps sending to LPN after ReceiveDelay, 1..255 ms
+#ifndef MESH_FRIEND_RECEIVE_WINDOW_MS
+#define MESH_FRIEND_RECEIVE_WINDOW_MS 255
+#endif
+
+#if (MESH_FRIEND_QUEUE_SIZE < 2) || (MESH_FRIEND_QUEUE_SIZE > 255)
+#error "MESH_FRIEND_QUEUE_SIZE must be in range 2..255"
+#endif
+
+#if (MESH_FRIEND_RECEIVE_WINDOW_MS < 1) || (MESH_FRIEND_RECEIVE_WINDOW_MS > 255)
+#error "MESH_FRIEND_RECEIVE_WINDOW_MS must be in range 1..255"
+#endif
+
+// LPN has to send first Friend Poll within 1 second after Friend Offer
+#define MESH_FRIEND_OFFER_TIMEOUT_MS 1000
+// Friend Offer is sent at least 100 ms after Friend Request
+#define MESH_FRIEND_OFFER_DELAY_MIN_MS 100
+// RSSI not available
+#define MESH_FRIEND_RSSI_NOT_AVAILABLE 0x7f
+
+// pending messages
+#define MESH_FRIEND_PENDING_OFFER                  0x01
+#define MESH_FRIEND_PENDING_POLL_RESPONSE          0x02
+#define MESH_FRIEND_PENDING_SUBSCRIPTION_CONFIRM   0x04
+#define MESH_FRIEND_PENDING_CLEAR                  0x08
+#define MESH_FRIEND_PENDING_CLEAR_CONFIRM          0x10
+
+typedef enum {
+    MESH_FRIEND_LPN_STATE_IDLE = 0,
+    MESH_FRIEND_LPN_STATE_W4_CREDENTIALS,
+    MESH_FRIEND_LPN_STATE_OFFER_DELAY,
+    MESH_FRIEND_LPN_STATE_W4_POLL,
+    MESH_FRIEND_LPN_STATE_ESTABLISHED,
+} mesh_friend_lpn_state_t;
+
+typedef struct {
+    mesh_friend_lpn_state_t state;
+
+    // friendship parameters from Friend Request
+    uint16_t netkey_index;
+    uint16_t lpn_address;
+    uint8_t  num_elements;
+    uint16_t lpn_counter;
+    uint16_t friend_counter;
+    uint16_t previous_address;
+    uint8_t  receive_delay_ms;
+    uint32_t poll_timeout_ms;
+    uint32_t poll_timeout_started_ms;
+
+    // friendship security credentials, registered for NID lookup while friendship is active
+    mesh_network_key_t credentials;
+    uint8_t  credentials_added;
+
+    // last received FSN and what was sent in response
+    uint8_t  fsn;
+    uint8_t  head_sent;
+    uint8_t  update_sent;
+    uint8_t  send_update;
+    uint8_t  offer_delay_expired;
+
+    // Friend Queue with decrypted Network PDUs to deliver, oldest first
+    btstack_linked_list_t queue;
+    uint16_t queue_len;
+
+    // Friend Subscription List
+    uint16_t subscription_list[MESH_FRIEND_SUBSCRIPTION_LIST_SIZE];
+    uint8_t  subscription_transaction_number;
+
+    // MESH_FRIEND_PENDING_* messages scheduled after ReceiveDelay and ready to send
+    uint8_t  scheduled;
+    uint8_t  pending;
+
+    // Friend Clear Confirm
+    uint16_t clear_confirm_dest;
+    uint16_t clear_confirm_lpn_counter;
+
+    // network pdu currently sent to or for this LPN
+    mesh_network_pdu_t * tx_pdu;
+    uint8_t  tx_pdu_friendship_credentials;
+
+    // Friend Offer delay / ReceiveDelay
+    btstack_timer_source_t response_timer;
+    // Offer timeout / PollTimeout
+    btstack_timer_source_t poll_timer;
+} mesh_friend_lpn_t;
+
+static mesh_friend_lpn_t mesh_friend_lpns[MESH_FRIEND_NUM_LPNS];
+static uint16_t          mesh_friend_counter;
+
+// friendship credentials are calculated one at a time
+static btstack_crypto_aes128_cmac_t mesh_friend_cmac_request;
+static mesh_friend_lpn_t *          mesh_friend_k2_lpn;
+static uint8_t                      mesh_friend_k2_p[9];
+static uint8_t                      mesh_friend_k2_result[33];
+
+static void mesh_friend_run(mesh_friend_lpn_t * lpn);
+
+static int mesh_friend_lpn_address_match(const mesh_friend_lpn_t * lpn, uint16_t address){
+    return (address >= lpn->lpn_address) && (address < (lpn->lpn_address + lpn->num_elements));
+}
+
+static mesh_friend_lpn_t * mesh_friend_lpn_for_address(uint16_t lpn_address){
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        mesh_friend_lpn_t * lpn = &mesh_friend_lpns[i];
+        if (lpn->state == MESH_FRIEND_LPN_STATE_IDLE) continue;
+        if (lpn->lpn_address == lpn_address) return lpn;
+    }
+    return NULL;
+}
+
+static mesh_friend_lpn_t * mesh_friend_lpn_free(void){
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        mesh_friend_lpn_t * lpn = &mesh_friend_lpns[i];
+        if (lpn->state != MESH_FRIEND_LPN_STATE_IDLE) continue;
+        // wait until Friend Clear Confirm was sent
+        if (lpn->pending != 0) continue;
+        if (lpn->tx_pdu != NULL) continue;
+        if (lpn == mesh_friend_k2_lpn) continue;
+        return lpn;
+    }
+    return NULL;
+}
+
+static void mesh_friend_queue_pop(mesh_friend_lpn_t * lpn){
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&lpn->queue);
+    if (network_pdu == NULL) return;
+    lpn->queue_len--;
+    lpn->head_sent = 0;
+    mesh_network_pdu_free(network_pdu);
+}
+
+static void mesh_friend_lpn_terminate(mesh_friend_lpn_t * lpn){
+    log_info("Friend: terminate friendship with LPN 0x%04x", lpn->lpn_address);
+    btstack_run_loop_remove_timer(&lpn->response_timer);
+    btstack_run_loop_remove_timer(&lpn->poll_timer);
+    // credentials might still be used by network layer for ongoing transmission, only remove them from lookup
+    if (lpn->credentials_added){
+        mesh_network_key_friendship_credentials_remove(&lpn->credentials);
+        lpn->credentials_added = 0;
+    }
+    while (lpn->queue_len > 0){
+        mesh_friend_queue_pop(lpn);
+    }
+    memset(lpn->subscription_list, 0, sizeof(lpn->subscription_list));
+    lpn->scheduled = 0;
+    lpn->pending   = 0;
+    lpn->state     = MESH_FRIEND_LPN_STATE_IDLE;
+}
+
+static void mesh_friend_poll_timer_start(mesh_friend_lpn_t * lpn, uint32_t timeout_ms){
+    btstack_run_loop_remove_timer(&lpn->poll_timer);
+    btstack_run_loop_set_timer(&lpn->poll_timer, timeout_ms);
+    btstack_run_loop_add_timer(&lpn->poll_timer);
+    lpn->poll_timeout_started_ms = btstack_run_loop_get_time_ms();
+}
+
+static void mesh_friend_poll_timer_handler(btstack_timer_source_t * ts){
+    mesh_friend_lpn_t * lpn = (mesh_friend_lpn_t *) btstack_run_loop_get_timer_context(ts);
+    // Friend Offer not accepted or PollTimeout expired
+    mesh_friend_lpn_terminate(lpn);
+}
+
+static void mesh_friend_response_timer_handler(btstack_timer_source_t * ts){
+    mesh_friend_lpn_t * lpn = (mesh_friend_lpn_t *) btstack_run_loop_get_timer_context(ts);
+    if (lpn->state == MESH_FRIEND_LPN_STATE_W4_CREDENTIALS){
+        lpn->offer_delay_expired = 1;
+        return;
+    }
+    if (lpn->state == MESH_FRIEND_LPN_STATE_OFFER_DELAY){
+        lpn->pending |= MESH_FRIEND_PENDING_OFFER;
+    } else {
+        lpn->pending |= lpn->scheduled;
+        lpn->scheduled = 0;
+    }
+    mesh_friend_run(lpn);
+}
+
+static void mesh_friend_schedule_response(mesh_friend_lpn_t * lpn, uint8_t response){
+    // respond after ReceiveDelay when LPN starts listening
+    if (lpn->scheduled == 0){
+        btstack_run_loop_set_timer(&lpn->response_timer, lpn->receive_delay_ms);
+        btstack_run_loop_add_timer(&lpn->response_timer);
+    }
+    lpn->scheduled |= response;
+}
+
+// Friendship Security Credentials: k2(NetKey, 0x01 || LPNAddress || FriendAddress || LPNCounter || FriendCounter)
+static void mesh_friend_credentials_calculated(void * arg){
+    UNUSED(arg);
+    mesh_friend_lpn_t * lpn = mesh_friend_k2_lpn;
+    mesh_friend_k2_lpn = NULL;
+    if (lpn->state != MESH_FRIEND_LPN_STATE_W4_CREDENTIALS) return;
+
+    lpn->credentials.friendship_credentials = 1;
+    lpn->credentials.netkey_index = lpn->netkey_index;
+    lpn->credentials.nid = mesh_friend_k2_result[0];
+    (void)memcpy(lpn->credentials.encryption_key, &mesh_friend_k2_result[1], 16);
+    (void)memcpy(lpn->credentials.privacy_key, &mesh_friend_k2_result[17], 16);
+    mesh_network_key_friendship_credentials_add(&lpn->credentials);
+    lpn->credentials_added = 1;
+
+    // send Friend Offer after Offer Delay
+    lpn->state = MESH_FRIEND_LPN_STATE_OFFER_DELAY;
+    if (lpn->offer_delay_expired){
+        lpn->pending |= MESH_FRIEND_PENDING_OFFER;
+        mesh_friend_run(lpn);
+    }
+}
+
+static void mesh_friend_setup_pdu(mesh_friend_lpn_t * lpn, mesh_network_pdu_t * network_pdu, int friendship_credentials, uint8_t ttl, uint16_t dest,
+    const uint8_t * control_pdu, uint8_t control_pdu_len){
+    uint8_t nid;
+    if (friendship_credentials){
+        nid = lpn->credentials.nid;
+    } else {
+        mesh_subnet_t * subnet = mesh_subnet_get_by_netkey_index(lpn->netkey_index);
+        nid = mesh_subnet_get_outgoing_network_key(subnet)->nid;
+    }
+    mesh_network_setup_pdu(network_pdu, lpn->netkey_index, nid, 1, ttl, mesh_sequence_number_next(),
+        mesh_node_get_primary_element_address(), dest, control_pdu, control_pdu_len);
+    lpn->tx_pdu_friendship_credentials = friendship_credentials;
+}
+
+static void mesh_friend_setup_update(mesh_friend_lpn_t * lpn, mesh_network_pdu_t * network_pdu){
+    mesh_subnet_t * subnet = mesh_subnet_get_by_netkey_index(lpn->netkey_index);
+    uint8_t flags = 0;
+    if (subnet->key_refresh != MESH_KEY_REFRESH_NOT_ACTIVE){
+        flags |= 1;
+    }
+    if (mesh_iv_update_active()){
+        flags |= 2;
+    }
+    uint8_t control_pdu[7];
+    control_pdu[0] = MESH_TRANSPORT_OPCODE_FRIEND_UPDATE;
+    control_pdu[1] = flags;
+    big_endian_store_32(control_pdu, 2, mesh_get_iv_index());
+    control_pdu[6] = lpn->queue_len > 0 ? 1 : 0;
+    mesh_friend_setup_pdu(lpn, network_pdu, 1, 0, lpn->lpn_address, control_pdu, sizeof(control_pdu));
+}
+
+static void mesh_friend_setup_queued_pdu(mesh_friend_lpn_t * lpn, mesh_network_pdu_t * network_pdu){
+    // send stored pdu with friendship credentials, SRC and SEQ are kept
+    mesh_network_pdu_t * queued_pdu = (mesh_network_pdu_t *) btstack_linked_list_get_first_item(&lpn->queue);
+    network_pdu->netkey_index = queued_pdu->netkey_index;
+    network_pdu->len = queued_pdu->len;
+    (void)memcpy(network_pdu->data, queued_pdu->data, queued_pdu->len);
+    network_pdu->data[0] = (network_pdu->data[0] & 0x80) | lpn->credentials.nid;
+    lpn->tx_pdu_friendship_credentials = 1;
+}
+
+static void mesh_friend_run(mesh_friend_lpn_t * lpn){
+    if (lpn->tx_pdu != NULL) return;
+    if (lpn->pending == 0) return;
+
+    mesh_subnet_t * subnet = mesh_subnet_get_by_netkey_index(lpn->netkey_index);
+    if (subnet == NULL){
+        mesh_friend_lpn_terminate(lpn);
+        return;
+    }
+
+    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get_for_purpose(MESH_NETWORK_PDU_PURPOSE_FRIEND);
+    if (network_pdu == NULL) return;
+
+    uint8_t control_pdu[7];
+    if (lpn->pending & MESH_FRIEND_PENDING_CLEAR_CONFIRM){
+        lpn->pending &= ~MESH_FRIEND_PENDING_CLEAR_CONFIRM;
+        control_pdu[0] = MESH_TRANSPORT_OPCODE_FRIEND_CLEAR_CONFIRM;
+        big_endian_store_16(control_pdu, 1, lpn->lpn_address);
+        big_endian_store_16(control_pdu, 3, lpn->clear_confirm_lpn_counter);
+        mesh_friend_setup_pdu(lpn, network_pdu, 0, mesh_foundation_default_ttl_get(), lpn->clear_confirm_dest, control_pdu, 5);
+    } else if (lpn->pending & MESH_FRIEND_PENDING_OFFER){
+        lpn->pending &= ~MESH_FRIEND_PENDING_OFFER;
+        control_pdu[0] = MESH_TRANSPORT_OPCODE_FRIEND_OFFER;
+        control_pdu[1] = MESH_FRIEND_RECEIVE_WINDOW_MS;
+        control_pdu[2] = MESH_FRIEND_QUEUE_SIZE;
+        control_pdu[3] = MESH_FRIEND_SUBSCRIPTION_LIST_SIZE;
+        control_pdu[4] = MESH_FRIEND_RSSI_NOT_AVAILABLE;
+        big_endian_store_16(control_pdu, 5, lpn->friend_counter);
+        mesh_friend_setup_pdu(lpn, network_pdu, 0, 0, lpn->lpn_address, control_pdu, 7);
+    } else if (lpn->pending & MESH_FRIEND_PENDING_POLL_RESPONSE){
+        lpn->pending &= ~MESH_FRIEND_PENDING_POLL_RESPONSE;
+        // repeat last response until LPN toggles FSN
+        if ((lpn->send_update == 0) && (lpn->queue_len > 0)){
+            mesh_friend_setup_queued_pdu(lpn, network_pdu);
+            lpn->head_sent = 1;
+        } else {
+            mesh_friend_setup_update(lpn, network_pdu);
+            lpn->update_sent = 1;
+        }
+    } else if (lpn->pending & MESH_FRIEND_PENDING_SUBSCRIPTION_CONFIRM){
+        lpn->pending &= ~MESH_FRIEND_PENDING_SUBSCRIPTION_CONFIRM;
+        control_pdu[0] = MESH_TRANSPORT_OPCODE_FRIEND_FRIEND_SUBSCRIPTION_LIST_CONFIRM;
+        control_pdu[1] = lpn->subscription_transaction_number;
+        mesh_friend_setup_pdu(lpn, network_pdu, 1, 0, lpn->lpn_address, control_pdu, 2);
+    } else {
+        // MESH_FRIEND_PENDING_CLEAR: inform previous Friend
+        lpn->pending &= ~MESH_FRIEND_PENDING_CLEAR;
+        control_pdu[0] = MESH_TRANSPORT_OPCODE_FRIEND_CLEAR;
+        big_endian_store_16(control_pdu, 1, lpn->lpn_address);
+        big_endian_store_16(control_pdu, 3, lpn->lpn_counter);
+        mesh_friend_setup_pdu(lpn, network_pdu, 0, mesh_foundation_default_ttl_get(), lpn->previous_address, control_pdu, 5);
+    }
+
+    lpn->tx_pdu = network_pdu;
+    mesh_network_send_pdu(network_pdu);
+}
+
+static void mesh_friend_handle_request(mesh_network_pdu_t * network_pdu, const uint8_t * control_pdu, uint8_t control_pdu_len){
+    if (mesh_foundation_friend_get() != 1) return;
+    if (control_pdu_len != 11) return;
+    if (mesh_network_dst(network_pdu) != MESH_ADDRESS_ALL_FRIENDS) return;
+    if (network_pdu->flags & MESH_NETWORK_PDU_FLAGS_FRIENDSHIP_CREDENTIALS) return;
+
+    uint8_t  criteria         = control_pdu[1];
+    uint8_t  receive_delay_ms = control_pdu[2];
+    uint32_t poll_timeout     = big_endian_read_24(control_pdu, 3);
+    uint16_t previous_address = big_endian_read_16(control_pdu, 6);
+    uint8_t  num_elements     = control_pdu[8];
+    uint16_t lpn_counter      = big_endian_read_16(control_pdu, 9);
+    uint16_t lpn_address      = mesh_network_src(network_pdu);
+
+    // validate
+    uint8_t min_queue_size_log = criteria & 0x07;
+    if (min_queue_size_log == 0) return;
+    if ((1u << min_queue_size_log) > MESH_FRIEND_QUEUE_SIZE) return;
+    if (receive_delay_ms < 0x0a) return;
+    if ((poll_timeout < 0x00000a) || (poll_timeout > 0x34bbff)) return;
+    if (num_elements == 0) return;
+    if (!mesh_network_address_unicast(lpn_address)) return;
+
+    // credentials are calculated one at a time, LPN will retry
+    if (mesh_friend_k2_lpn != NULL) return;
+
+    mesh_subnet_t * subnet = mesh_subnet_get_by_netkey_index(network_pdu->netkey_index);
+    if (subnet == NULL) return;
+
+    // LPN looks for new friend, terminate existing friendship
+    mesh_friend_lpn_t * lpn = mesh_friend_lpn_for_address(lpn_address);
+    if (lpn != NULL){
+        mesh_friend_lpn_terminate(lpn);
+    }
+    lpn = mesh_friend_lpn_free();
+    if (lpn == NULL) return;
+
+    lpn->state            = MESH_FRIEND_LPN_STATE_W4_CREDENTIALS;
+    lpn->netkey_index     = network_pdu->netkey_index;
+    lpn->lpn_address      = lpn_address;
+    lpn->num_elements     = num_elements;
+    lpn->lpn_counter      = lpn_counter;
+    lpn->friend_counter   = mesh_friend_counter++;
+    lpn->previous_address = previous_address;
+    lpn->receive_delay_ms = receive_delay_ms;
+    lpn->poll_timeout_ms  = poll_timeout * 100;
+    lpn->head_sent        = 0;
+    lpn->update_sent      = 0;
+    lpn->send_update      = 1;
+    lpn->offer_delay_expired = 0;
+
+    // Offer Delay = ReceiveWindowFactor * ReceiveWindow - RSSIFactor * RSSI, factors are 1, 1.5, 2, 2.5. RSSI is not available
+    uint32_t receive_window_factor_x2 = 2 + ((criteria >> 3) & 0x03);
+    uint32_t offer_delay_ms = (receive_window_factor_x2 * MESH_FRIEND_RECEIVE_WINDOW_MS) / 2;
+    if (offer_delay_ms < MESH_FRIEND_OFFER_DELAY_MIN_MS){
+        offer_delay_ms = MESH_FRIEND_OFFER_DELAY_MIN_MS;
+    }
+    btstack_run_loop_set_timer(&lpn->response_timer, offer_delay_ms);
+    btstack_run_loop_add_timer(&lpn->response_timer);
+
+    log_info("Friend: request from LPN 0x%04x, receive delay %u ms, poll timeout %u ms", lpn_address, receive_delay_ms, (int) lpn->poll_timeout_ms);
+
+    // calculate friendship credentials
+    const mesh_network_key_t * network_key = mesh_subnet_get_outgoing_network_key(subnet);
+    mesh_friend_k2_p[0] = 0x01;
+    big_endian_store_16(mesh_friend_k2_p, 1, lpn->lpn_address);
+    big_endian_store_16(mesh_friend_k2_p, 3, mesh_node_get_primary_element_address());
+    big_endian_store_16(mesh_friend_k2_p, 5, lpn->lpn_counter);
+    big_endian_store_16(mesh_friend_k2_p, 7, lpn->friend_counter);
+    mesh_friend_k2_lpn = lpn;
+    mesh_k2_with_p(&mesh_friend_cmac_request, network_key->net_key, mesh_friend_k2_p, sizeof(mesh_friend_k2_p),
+        mesh_friend_k2_result, &mesh_friend_credentials_calculated, NULL);
+}
+
+static void mesh_friend_handle_poll(mesh_friend_lpn_t * lpn, const uint8_t * control_pdu, uint8_t control_pdu_len){
+    if (control_pdu_len != 2) return;
+    uint8_t fsn = control_pdu[1] & 1;
+
+    switch (lpn->state){
+        case MESH_FRIEND_LPN_STATE_W4_POLL:
+            // friendship established
+            log_info("Friend: friendship with LPN 0x%04x established", lpn->lpn_address);
+            lpn->state = MESH_FRIEND_LPN_STATE_ESTABLISHED;
+            lpn->fsn   = fsn;
+            if (mesh_network_address_unicast(lpn->previous_address) && (lpn->previous_address != mesh_node_get_primary_element_address())){
+                lpn->pending |= MESH_FRIEND_PENDING_CLEAR;
+            }
+            break;
+        case MESH_FRIEND_LPN_STATE_ESTABLISHED:
+            if (fsn != lpn->fsn){
+                // last response was received, drop it from queue
+                lpn->fsn = fsn;
+                if (lpn->head_sent){
+                    mesh_friend_queue_pop(lpn);
+                }
+                if (lpn->update_sent){
+                    lpn->update_sent = 0;
+                    lpn->send_update = 0;
+                }
+            }
+            break;
+        default:
+            return;
+    }
+
+    mesh_friend_poll_timer_start(lpn, lpn->poll_timeout_ms);
+    mesh_friend_schedule_response(lpn, MESH_FRIEND_PENDING_POLL_RESPONSE);
+}
+
+static void mesh_friend_handle_subscription_list(mesh_friend_lpn_t * lpn, int add, const uint8_t * control_pdu, uint8_t control_pdu_len){
+    if (lpn->state != MESH_FRIEND_LPN_STATE_ESTABLISHED) return;
+    if (control_pdu_len < 2) return;
+
+    uint16_t pos;
+    for (pos = 2; (pos + 1) < control_pdu_len; pos += 2){
+        uint16_t address = big_endian_read_16(control_pdu, pos);
+        int free_index = -1;
+        int i;
+        for (i=0;i<MESH_FRIEND_SUBSCRIPTION_LIST_SIZE;i++){
+            if (lpn->subscription_list[i] == address) break;
+            if ((free_index < 0) && (lpn->subscription_list[i] == MESH_ADDRESS_UNSASSIGNED)){
+                free_index = i;
+            }
+        }
+        if (add){
+            if ((i == MESH_FRIEND_SUBSCRIPTION_LIST_SIZE) && (free_index >= 0)){
+                lpn->subscription_list[free_index] = address;
+            }
+        } else {
+            if (i < MESH_FRIEND_SUBSCRIPTION_LIST_SIZE){
+                lpn->subscription_list[i] = MESH_ADDRESS_UNSASSIGNED;
+            }
+        }
+    }
+
+    lpn->subscription_transaction_number = control_pdu[1];
+    mesh_friend_poll_timer_start(lpn, lpn->poll_timeout_ms);
+    mesh_friend_schedule_response(lpn, MESH_FRIEND_PENDING_SUBSCRIPTION_CONFIRM);
+}
+
+static void mesh_friend_handle_clear(mesh_network_pdu_t * network_pdu, const uint8_t * control_pdu, uint8_t control_pdu_len){
+    if (control_pdu_len != 5) return;
+    uint16_t lpn_address = big_endian_read_16(control_pdu, 1);
+    uint16_t lpn_counter = big_endian_read_16(control_pdu, 3);
+
+    mesh_friend_lpn_t * lpn = mesh_friend_lpn_for_address(lpn_address);
+    if (lpn == NULL) return;
+    if (lpn->state != MESH_FRIEND_LPN_STATE_ESTABLISHED) return;
+
+    // valid if LPNCounter is within 255 of the one from Friend Request
+    if ((uint16_t)(lpn_counter - lpn->lpn_counter) > 255) return;
+
+    mesh_friend_lpn_terminate(lpn);
+    lpn->clear_confirm_dest = mesh_network_src(network_pdu);
+    lpn->clear_confirm_lpn_counter = lpn_counter;
+    lpn->pending = MESH_FRIEND_PENDING_CLEAR_CONFIRM;
+    mesh_friend_run(lpn);
+}
+
+void mesh_friend_process_control_message(mesh_network_pdu_t * network_pdu){
+    const uint8_t * control_pdu     = mesh_network_pdu_data(network_pdu);
+    uint8_t         control_pdu_len = mesh_network_pdu_len(network_pdu);
+    if (control_pdu_len == 0) return;
+
+    uint8_t opcode = control_pdu[0] & 0x7f;
+    mesh_friend_lpn_t * lpn;
+    switch (opcode){
+        case MESH_TRANSPORT_OPCODE_FRIEND_REQUEST:
+            mesh_friend_handle_request(network_pdu, control_pdu, control_pdu_len);
+            break;
+        case MESH_TRANSPORT_OPCODE_FRIEND_CLEAR:
+            mesh_friend_handle_clear(network_pdu, control_pdu, control_pdu_len);
+            break;
+        case MESH_TRANSPORT_OPCODE_FRIEND_POLL:
+        case MESH_TRANSPORT_OPCODE_FRIEND_FRIEND_SUBSCRIPTION_LIST_ADD:
+        case MESH_TRANSPORT_OPCODE_FRIEND_FRIEND_SUBSCRIPTION_LIST_REMOVE:
+            // sent by LPN with friendship credentials
+            if ((network_pdu->flags & MESH_NETWORK_PDU_FLAGS_FRIENDSHIP_CREDENTIALS) == 0) break;
+            if (mesh_network_dst(network_pdu) != mesh_node_get_primary_element_address()) break;
+            lpn = mesh_friend_lpn_for_address(mesh_network_src(network_pdu));
+            if (lpn == NULL) break;
+            if (opcode == MESH_TRANSPORT_OPCODE_FRIEND_POLL){
+                mesh_friend_handle_poll(lpn, control_pdu, control_pdu_len);
+            } else {
+                mesh_friend_handle_subscription_list(lpn, opcode == MESH_TRANSPORT_OPCODE_FRIEND_FRIEND_SUBSCRIPTION_LIST_ADD, control_pdu, control_pdu_len);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static int mesh_friend_lpn_subscribed(const mesh_friend_lpn_t * lpn, uint16_t dest){
+    if (mesh_friend_lpn_address_match(lpn, dest)) return 1;
+    if (dest == MESH_ADDRESS_ALL_NODES) return 1;
+    int i;
+    for (i=0;i<MESH_FRIEND_SUBSCRIPTION_LIST_SIZE;i++){
+        if (lpn->subscription_list[i] == dest) return 1;
+    }
+    return 0;
+}
+
+void mesh_friend_network_pdu_received(mesh_network_pdu_t * network_pdu){
+    // messages with TTL >= 2 are stored with TTL decremented
+    uint8_t ttl = mesh_network_ttl(network_pdu);
+    if (ttl < 2) return;
+    if (network_pdu->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION) return;
+
+    uint16_t src  = mesh_network_src(network_pdu);
+    uint16_t dest = mesh_network_dst(network_pdu);
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        mesh_friend_lpn_t * lpn = &mesh_friend_lpns[i];
+        if (lpn->state != MESH_FRIEND_LPN_STATE_ESTABLISHED) continue;
+        if (lpn->netkey_index != network_pdu->netkey_index) continue;
+        if (mesh_friend_lpn_address_match(lpn, src)) continue;
+        if (!mesh_friend_lpn_subscribed(lpn, dest)) continue;
+
+        // queue full: discard oldest entry
+        if (lpn->queue_len >= MESH_FRIEND_QUEUE_SIZE){
+            mesh_friend_queue_pop(lpn);
+        }
+
+        mesh_network_pdu_t * queued_pdu = mesh_network_pdu_get_for_purpose(MESH_NETWORK_PDU_PURPOSE_FRIEND);
+        if (queued_pdu == NULL) return;
+        queued_pdu->netkey_index = network_pdu->netkey_index;
+        queued_pdu->len = network_pdu->len;
+        (void)memcpy(queued_pdu->data, network_pdu->data, network_pdu->len);
+        queued_pdu->data[1] = (network_pdu->data[1] & 0x80) | (ttl - 1);
+        btstack_linked_list_add_tail(&lpn->queue, (btstack_linked_item_t *) queued_pdu);
+        lpn->queue_len++;
+    }
+}
+
+const mesh_network_key_t * mesh_friend_get_friendship_credentials(mesh_network_pdu_t * network_pdu){
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        mesh_friend_lpn_t * lpn = &mesh_friend_lpns[i];
+        if (lpn->tx_pdu != network_pdu) continue;
+        if (lpn->tx_pdu_friendship_credentials == 0) return NULL;
+        return &lpn->credentials;
+    }
+    return NULL;
+}
+
+void mesh_friend_network_pdu_sent(mesh_network_pdu_t * network_pdu){
+    mesh_friend_lpn_t * lpn = NULL;
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        if (mesh_friend_lpns[i].tx_pdu == network_pdu){
+            lpn = &mesh_friend_lpns[i];
+            break;
+        }
+    }
+    mesh_network_pdu_free(network_pdu);
+    if (lpn == NULL) return;
+    lpn->tx_pdu = NULL;
+
+    if (lpn->state == MESH_FRIEND_LPN_STATE_OFFER_DELAY){
+        // offer sent, wait for first Friend Poll
+        lpn->state = MESH_FRIEND_LPN_STATE_W4_POLL;
+        mesh_friend_poll_timer_start(lpn, MESH_FRIEND_OFFER_TIMEOUT_MS);
+    }
+    mesh_friend_run(lpn);
+}
+
+uint32_t mesh_friend_get_poll_timeout(uint16_t lpn_address){
+    mesh_friend_lpn_t * lpn = mesh_friend_lpn_for_address(lpn_address);
+    if (lpn == NULL) return 0;
+    if (lpn->state != MESH_FRIEND_LPN_STATE_ESTABLISHED) return 0;
+    uint32_t elapsed_ms = btstack_run_loop_get_time_ms() - lpn->poll_timeout_started_ms;
+    if (elapsed_ms >= lpn->poll_timeout_ms) return 0;
+    return (lpn->poll_timeout_ms - elapsed_ms) / 100;
+}
+
+void mesh_friend_reset(void){
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        mesh_friend_lpn_t * lpn = &mesh_friend_lpns[i];
+        if (lpn->state == MESH_FRIEND_LPN_STATE_IDLE) continue;
+        mesh_friend_lpn_terminate(lpn);
+    }
+}
+
+void mesh_friend_init(void){
+    int i;
+    for (i=0;i<MESH_FRIEND_NUM_LPNS;i++){
+        mesh_friend_lpn_t * lpn = &mesh_friend_lpns[i];
+        memset(lpn, 0, sizeof(mesh_friend_lpn_t));
+        btstack_run_loop_set_timer_context(&lpn->response_timer, lpn);
+        btstack_run_loop_set_timer_handler(&lpn->response_timer, &mesh_friend_response_timer_handler);
+        btstack_run_loop_set_timer_context(&lpn->poll_timer, lpn);
+        btstack_run_loop_set_timer_handler(&lpn->poll_timer, &mesh_friend_poll_timer_handler);
+    }
+    mesh_friend_k2_lpn = NULL;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#ifndef __MESH_FRIEND_H
+#define __MESH_FRIEND_H
+
+#include <stdint.h>
+
+#include "mesh/mesh_keys.h"
+#include "mesh/mesh_network.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Init Friend feature
+ */
+void mesh_friend_init(void);
+
+/**
+ * @brief Terminate all friendships and free friend queues
+ */
+void mesh_friend_reset(void);
+
+/**
+ * @brief Process Friend Poll, Friend Request, Friend Clear, Friend Subscription List Add/Remove
+ * @param network_pdu with unsegmented control message, not freed
+ */
+void mesh_friend_process_control_message(mesh_network_pdu_t * network_pdu);
+
+/**
+ * @brief Store copy of received Network PDU in Friend Queue if it is addressed to a Low Power node
+ * @param network_pdu decrypted network pdu, not freed
+ */
+void mesh_friend_network_pdu_received(mesh_network_pdu_t * network_pdu);
+
+/**
+ * @brief Get friendship security credentials for outgoing Network PDU sent by Friend
+ * @param network_pdu
+ * @return network key or NULL
+ */
+const mesh_network_key_t * mesh_friend_get_friendship_credentials(mesh_network_pdu_t * network_pdu);
+
+/**
+ * @brief Network PDU with purpose MESH_NETWORK_PDU_PURPOSE_FRIEND was sent
+ * @param network_pdu
+ */
+void mesh_friend_network_pdu_sent(mesh_network_pdu_t * network_pdu);
+
+/**
+ * @brief Get current value of PollTimeout timer for Low Power node
+ * @param lpn_address
+ * @return remaining poll timeout in units of 100 ms, or 0 if no friendship with Low Power node
+ */
+uint32_t mesh_friend_get_poll_timeout(uint16_t lpn_address);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __MESH_FRIEND_H
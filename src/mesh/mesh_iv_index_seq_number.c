@@ -45,6 +45,7 @@ static uint32_t global_iv_index;
 static int global_iv_update_active;
 
 static uint32_t  sequence_number_current;
+static uint32_t  sequence_number_reserved_limit;
 
 void mesh_set_iv_index(uint32_t iv_index){
     global_iv_index = iv_index;
@@ -106,6 +107,10 @@ void mesh_sequence_number_set_update_callback(void (*callback)(void)){
 	seq_num_callback = callback;
 }
 
+void mesh_sequence_number_set_reserved_limit(uint32_t limit){
+    sequence_number_reserved_limit = limit;
+}
+
 void mesh_sequence_number_set(uint32_t seq){
     sequence_number_current = seq;
 }
@@ -113,7 +118,8 @@ void mesh_sequence_number_set(uint32_t seq){
 uint32_t mesh_sequence_number_next(void){
 	uint32_t seq_number = sequence_number_current++;
 
-	if (seq_num_callback){
+	// reserved block used up, persist
+	if ((sequence_number_current >= sequence_number_reserved_limit) && seq_num_callback){
 		(*seq_num_callback)();
 	}
 
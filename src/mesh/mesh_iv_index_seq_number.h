@@ -78,9 +78,16 @@ void mesh_iv_index_recovered(uint8_t iv_update_active, uint32_t iv_index);
 
 /**
  * @brief Set callback for sequence number update
+ * @note callback is only called if sequence number reaches the limit set with mesh_sequence_number_set_reserved_limit
  */
 void mesh_sequence_number_set_update_callback(void (*callback)(void));
 
+/**
+ * @brief Set first sequence number that is not covered by persisted reservation
+ * @param limit
+ */
+void mesh_sequence_number_set_reserved_limit(uint32_t limit);
+
 /**
  * Sequence Number
  */
@@ -50,8 +50,33 @@
 static btstack_linked_list_t network_keys;
 static uint8_t mesh_network_key_used[MAX_NR_MESH_NETWORK_KEYS];
 
+// network keys by 7-bit nid, keys with same nid are chained via nid_next in order of addition
+static mesh_network_key_t * mesh_network_keys_by_nid[128];
+
 void mesh_network_key_init(void){
     network_keys = NULL;
+    memset(mesh_network_keys_by_nid, 0, sizeof(mesh_network_keys_by_nid));
+}
+
+static void mesh_network_key_nid_index_add(mesh_network_key_t * network_key){
+    mesh_network_key_t ** it = &mesh_network_keys_by_nid[network_key->nid & 0x7f];
+    while (*it != NULL){
+        it = &(*it)->nid_next;
+    }
+    network_key->nid_next = NULL;
+    *it = network_key;
+}
+
+static void mesh_network_key_nid_index_remove(mesh_network_key_t * network_key){
+    mesh_network_key_t ** it = &mesh_network_keys_by_nid[network_key->nid & 0x7f];
+    while (*it != NULL){
+        if (*it == network_key){
+            *it = network_key->nid_next;
+            network_key->nid_next = NULL;
+            return;
+        }
+        it = &(*it)->nid_next;
+    }
 }
 
 uint16_t mesh_network_key_get_free_index(void){
@@ -67,13 +92,23 @@ uint16_t mesh_network_key_get_free_index(void){
 void mesh_network_key_add(mesh_network_key_t * network_key){
     mesh_network_key_used[network_key->internal_index] = 1;
     btstack_linked_list_add_tail(&network_keys, (btstack_linked_item_t *) network_key);
+    mesh_network_key_nid_index_add(network_key);
 }
 
 bool mesh_network_key_remove(mesh_network_key_t * network_key){
     mesh_network_key_used[network_key->internal_index] = 0;
+    mesh_network_key_nid_index_remove(network_key);
     return btstack_linked_list_remove(&network_keys, (btstack_linked_item_t *) network_key);
 }
 
+void mesh_network_key_friendship_credentials_add(mesh_network_key_t * network_key){
+    mesh_network_key_nid_index_add(network_key);
+}
+
+void mesh_network_key_friendship_credentials_remove(mesh_network_key_t * network_key){
+    mesh_network_key_nid_index_remove(network_key);
+}
+
 mesh_network_key_t * mesh_network_key_list_get(uint16_t netkey_index){
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &network_keys);
@@ -103,24 +138,17 @@ mesh_network_key_t * mesh_network_key_iterator_get_next(mesh_network_key_iterato
 
 // mesh network key iterator for a given nid
 void mesh_network_key_nid_iterator_init(mesh_network_key_iterator_t *it, uint8_t nid){
-    btstack_linked_list_iterator_init(&it->it, &network_keys);
-    it->key = NULL;
+    it->key = mesh_network_keys_by_nid[nid & 0x7f];
     it->nid = nid;
 }
 
 int mesh_network_key_nid_iterator_has_more(mesh_network_key_iterator_t *it){
-    // find next matching key
-    while (true){
-        if (it->key && it->key->nid == it->nid) return 1;
-        if (!btstack_linked_list_iterator_has_next(&it->it)) break;
-        it->key = (mesh_network_key_t *) btstack_linked_list_iterator_next(&it->it);
-    }
-    return 0;
+    return it->key != NULL;
 }
 
 mesh_network_key_t * mesh_network_key_nid_iterator_get_next(mesh_network_key_iterator_t *it){
     mesh_network_key_t * key = it->key;
-    it->key = NULL;
+    it->key = key->nid_next;
     return key;
 }
 
@@ -133,6 +161,36 @@ static btstack_linked_list_t  application_keys;
 
 static uint8_t mesh_transport_key_used[MAX_NR_MESH_TRANSPORT_KEYS];
 
+// application keys by 6-bit aid, keys with same aid are chained via aid_next in order of addition
+static mesh_transport_key_t * mesh_transport_keys_by_aid[64];
+
+static void mesh_transport_key_aid_index_remove(mesh_transport_key_t * transport_key){
+    // search all buckets, aid might have changed since key was added
+    uint16_t aid;
+    for (aid = 0; aid < 64; aid++){
+        mesh_transport_key_t ** it = &mesh_transport_keys_by_aid[aid];
+        while (*it != NULL){
+            if (*it == transport_key){
+                *it = transport_key->aid_next;
+                transport_key->aid_next = NULL;
+                return;
+            }
+            it = &(*it)->aid_next;
+        }
+    }
+}
+
+static void mesh_transport_key_aid_index_add(mesh_transport_key_t * transport_key){
+    // re-adding a key moves it to the bucket of its current aid
+    mesh_transport_key_aid_index_remove(transport_key);
+    mesh_transport_key_t ** it = &mesh_transport_keys_by_aid[transport_key->aid & 0x3f];
+    while (*it != NULL){
+        it = &(*it)->aid_next;
+    }
+    transport_key->aid_next = NULL;
+    *it = transport_key;
+}
+
 void mesh_transport_set_device_key(const uint8_t * device_key){
     mesh_transport_device_key.appkey_index = MESH_DEVICE_KEY_INDEX;
     mesh_transport_device_key.aid   = 0;
@@ -159,10 +217,12 @@ uint16_t mesh_transport_key_get_free_index(void){
 void mesh_transport_key_add(mesh_transport_key_t * transport_key){
     mesh_transport_key_used[transport_key->internal_index] = 1;
     btstack_linked_list_add_tail(&application_keys, (btstack_linked_item_t *) transport_key);
+    mesh_transport_key_aid_index_add(transport_key);
 }
 
 bool mesh_transport_key_remove(mesh_transport_key_t * transport_key){
     mesh_transport_key_used[transport_key->internal_index] = 0;
+    mesh_transport_key_aid_index_remove(transport_key);
     return btstack_linked_list_remove(&application_keys, (btstack_linked_item_t *) transport_key);
 }
 
@@ -202,14 +262,14 @@ mesh_transport_key_t * mesh_transport_key_iterator_get_next(mesh_transport_key_i
     return key;
 }
 
+// key iterator for a given aid, only visits keys with matching aid
 void
 mesh_transport_key_aid_iterator_init(mesh_transport_key_iterator_t *it, uint16_t netkey_index, uint8_t akf, uint8_t aid) {
-    btstack_linked_list_iterator_init(&it->it, &application_keys);
     it->netkey_index = netkey_index;
     it->aid      = aid;
     it->akf      = akf;
     if (it->akf){
-        it->key = NULL;
+        it->key = mesh_transport_keys_by_aid[aid & 0x3f];
     } else {
         it->key = &mesh_transport_device_key;
     }
@@ -219,17 +279,20 @@ int mesh_transport_key_aid_iterator_has_more(mesh_transport_key_iterator_t *it){
     if (it->akf == 0){
         return it->key != NULL;
     }
-    // find next matching key
-    while (true){
-        if (it->key && it->key->aid == it->aid && it->key->netkey_index == it->netkey_index) return 1;
-        if (!btstack_linked_list_iterator_has_next(&it->it)) break;
-        it->key = (mesh_transport_key_t *) btstack_linked_list_iterator_next(&it->it);
+    // skip keys of other subnets
+    while (it->key != NULL){
+        if (it->key->netkey_index == it->netkey_index) return 1;
+        it->key = it->key->aid_next;
     }
     return 0;
 }
 
 mesh_transport_key_t * mesh_transport_key_aid_iterator_get_next(mesh_transport_key_iterator_t *it){
     mesh_transport_key_t * key = it->key;
-    it->key = NULL;
+    if (it->akf == 0){
+        it->key = NULL;
+    } else {
+        it->key = key->aid_next;
+    }
     return key;
 }
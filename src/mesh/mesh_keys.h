@@ -51,9 +51,12 @@ extern "C"
 
 #define MESH_KEYS_INVALID_INDEX 0xffff
 
-typedef struct {
+typedef struct mesh_network_key {
     btstack_linked_item_t item;
 
+    // next key with same nid
+    struct mesh_network_key * nid_next;
+
     // internal index [0..MAX_NR_MESH_NETWORK_KEYS-1]
     uint16_t internal_index;
 
@@ -63,6 +66,9 @@ typedef struct {
     // internal version - allows for newer-than relation between keys with same netkey_index
     uint8_t version;
 
+    // friendship security credentials derived from net_key, only used for NID lookup
+    uint8_t friendship_credentials;
+
     // net_key from provisioner or Config Model Client
     uint8_t net_key[16];
 
@@ -88,9 +94,12 @@ typedef struct {
     uint8_t nid;
 } mesh_network_key_iterator_t;
 
-typedef struct {
+typedef struct mesh_transport_key {
     btstack_linked_item_t item;
 
+    // next key with same aid
+    struct mesh_transport_key * aid_next;
+
     // internal index [0..MAX_NR_MESH_TRANSPORT_KEYS-1]
     uint16_t internal_index;
 
@@ -155,6 +164,18 @@ void mesh_network_key_add(mesh_network_key_t * network_key);
  */
 bool mesh_network_key_remove(mesh_network_key_t * network_key);
 
+/**
+ * @brief Add friendship security credentials for lookup by NID, they are not added to the network key list
+ * @param network_key with friendship_credentials set
+ */
+void mesh_network_key_friendship_credentials_add(mesh_network_key_t * network_key);
+
+/**
+ * @brief Remove friendship security credentials
+ * @param network_key
+ */
+void mesh_network_key_friendship_credentials_remove(mesh_network_key_t * network_key);
+
 /**
  * @brief Get network_key for netkey_index
  * @param netkey_index
@@ -189,7 +210,7 @@ int mesh_network_key_iterator_has_more(mesh_network_key_iterator_t *it);
 mesh_network_key_t * mesh_network_key_iterator_get_next(mesh_network_key_iterator_t *it);
 
 /**
- * @brief Iterate over all network keys with a given NID
+ * @brief Iterate over all network keys with a given NID, keys are looked up via NID index
  * @param it
  * @param nid
  */
@@ -47,6 +47,9 @@
 #include "mesh/beacon.h"
 #include "mesh/mesh_iv_index_seq_number.h"
 #include "mesh/mesh_lower_transport.h"
+#ifdef ENABLE_MESH_FRIEND
+#include "mesh/mesh_friend.h"
+#endif
 #include "mesh/mesh_node.h"
 #include "mesh/mesh_peer.h"
 
@@ -107,40 +110,97 @@ void mesh_transport_set_dest(mesh_transport_pdu_t * transport_pdu, uint16_t dest
 
 // lower transport
 
+// number of segmented transport PDUs sent concurrently, at most one per destination
+#ifndef MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED
+#define MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED 1
+#endif
+
+// outgoing segmented transaction
+typedef struct {
+    mesh_transport_pdu_t * pdu;
+    // network pdu used to send segments
+    mesh_network_pdu_t   * segment;
+    uint16_t               seg_o;
+    int                    retry_count;
+    // segment at network layer
+    int                    segment_queued;
+    // transmission timeout occured (while outgoing segment queued at network layer)
+    int                    transmission_timeout;
+    // transmission completed either fully acked or remote aborted (while outgoing segment queued at network layer)
+    int                    transmission_complete;
+} mesh_lower_transport_outgoing_segmented_t;
+
 // prototypes
 
 static void mesh_lower_transport_run(void);
-static void mesh_lower_transport_outgoing_complete(void);
+static void mesh_lower_transport_outgoing_complete(mesh_lower_transport_outgoing_segmented_t * outgoing);
 static void mesh_lower_transport_network_pdu_sent(mesh_network_pdu_t *network_pdu);
 static void mesh_lower_transport_segment_transmission_timeout(btstack_timer_source_t * ts);
 
-// state
-static int                    lower_transport_retry_count;
-
 // lower transport incoming
 static btstack_linked_list_t  lower_transport_incoming;
 
 // lower transport ougoing
 static btstack_linked_list_t lower_transport_outgoing;
 
-static mesh_transport_pdu_t * lower_transport_outgoing_pdu;
-static mesh_network_pdu_t   * lower_transport_outgoing_segment;
-static uint16_t               lower_transport_outgoing_seg_o;
-// segment at network layer
-static int                    lower_transport_outgoing_segment_queued;
-// transmission timeout occured (while outgoing segment queued at network layer)
-static int                    lower_transport_outgoing_transmission_timeout;
-// transmission completed either fully acked or remote aborted (while outgoing segment queued at network layer)
-static int                    lower_transport_outgoing_trasnmission_complete;
+static mesh_lower_transport_outgoing_segmented_t lower_transport_outgoing_segmented[MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED];
 
-static void mesh_lower_transport_process_segment_acknowledgement_message(mesh_network_pdu_t *network_pdu){
-    if (lower_transport_outgoing_pdu == NULL) return;
+#ifdef ENABLE_MESH_STATISTICS
+static mesh_lower_transport_statistics_t mesh_lower_transport_statistics;
+#endif
+
+static mesh_lower_transport_outgoing_segmented_t * mesh_lower_transport_outgoing_segmented_for_dest(uint16_t dest){
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        mesh_lower_transport_outgoing_segmented_t * outgoing = &lower_transport_outgoing_segmented[i];
+        if (outgoing->pdu == NULL) continue;
+        if (mesh_transport_dst(outgoing->pdu) == dest) return outgoing;
+    }
+    return NULL;
+}
+
+static mesh_lower_transport_outgoing_segmented_t * mesh_lower_transport_outgoing_segmented_free(void){
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        mesh_lower_transport_outgoing_segmented_t * outgoing = &lower_transport_outgoing_segmented[i];
+        if (outgoing->pdu != NULL) continue;
+        if (outgoing->segment == NULL){
+            // allocate network_pdu for segmentation
+            outgoing->segment = mesh_network_pdu_get();
+            if (outgoing->segment == NULL) continue;
+        }
+        return outgoing;
+    }
+    return NULL;
+}
+
+static mesh_lower_transport_outgoing_segmented_t * mesh_lower_transport_outgoing_segmented_for_ack(uint16_t src, uint16_t seq_zero){
+    // Segment Acknowledgment is sent by destination of segmented message
+    mesh_lower_transport_outgoing_segmented_t * outgoing = mesh_lower_transport_outgoing_segmented_for_dest(src);
+    if (outgoing != NULL) return outgoing;
+    // or by Friend on behalf of Low Power node
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        outgoing = &lower_transport_outgoing_segmented[i];
+        if (outgoing->pdu == NULL) continue;
+        if ((mesh_transport_seq(outgoing->pdu) & 0x1fff) == seq_zero) return outgoing;
+    }
+    return NULL;
+}
 
+static void mesh_lower_transport_process_segment_acknowledgement_message(mesh_network_pdu_t *network_pdu){
     uint8_t * lower_transport_pdu     = mesh_network_pdu_data(network_pdu);
     uint16_t seq_zero_pdu = big_endian_read_16(lower_transport_pdu, 1) >> 2;
+
+    mesh_lower_transport_outgoing_segmented_t * outgoing = mesh_lower_transport_outgoing_segmented_for_ack(mesh_network_src(network_pdu), seq_zero_pdu & 0x1fff);
+    if (outgoing == NULL) return;
+    mesh_transport_pdu_t * lower_transport_outgoing_pdu = outgoing->pdu;
+
     uint16_t seq_zero_out = mesh_transport_seq(lower_transport_outgoing_pdu) & 0x1fff;
     uint32_t block_ack = big_endian_read_32(lower_transport_pdu, 3);
 
+    MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_acks);
+
 #ifdef LOG_LOWER_TRANSPORT
     printf("[+] Segment Acknowledgment message with seq_zero %06x, block_ack %08x - outgoing seq %06x, block_ack %08x\n",
            seq_zero_pdu, block_ack, seq_zero_out, lower_transport_outgoing_pdu->block_ack);
@@ -153,10 +213,10 @@ static void mesh_lower_transport_process_segment_acknowledgement_message(mesh_ne
 #ifdef LOG_LOWER_TRANSPORT
         printf("[+] Block Ack == 0 => Abort\n");
 #endif
-        if (lower_transport_outgoing_segment_queued){
-            lower_transport_outgoing_trasnmission_complete = 1;
+        if (outgoing->segment_queued){
+            outgoing->transmission_complete = 1;
         } else {
-            mesh_lower_transport_outgoing_complete();
+            mesh_lower_transport_outgoing_complete(outgoing);
         }
         return;
     }
@@ -178,10 +238,10 @@ static void mesh_lower_transport_process_segment_acknowledgement_message(mesh_ne
         printf("[+] Sent complete\n");
 #endif
 
-        if (lower_transport_outgoing_segment_queued){
-            lower_transport_outgoing_trasnmission_complete = 1;
+        if (outgoing->segment_queued){
+            outgoing->transmission_complete = 1;
         } else {
-            mesh_lower_transport_outgoing_complete();
+            mesh_lower_transport_outgoing_complete(outgoing);
         }
     }
 }
@@ -191,7 +251,7 @@ static void mesh_lower_transport_process_unsegmented_control_message(mesh_networ
     uint8_t  opcode = lower_transport_pdu[0];
 
 #ifdef LOG_LOWER_TRANSPORT
-    printf("Unsegmented Control message, outgoing message %p, opcode %x\n", lower_transport_outgoing_pdu, opcode);
+    printf("Unsegmented Control message, opcode %x\n", opcode);
 #endif
 
     switch (opcode){
@@ -199,6 +259,16 @@ static void mesh_lower_transport_process_unsegmented_control_message(mesh_networ
             mesh_lower_transport_process_segment_acknowledgement_message(network_pdu);
             mesh_network_message_processed_by_higher_layer(network_pdu);
             break;
+#ifdef ENABLE_MESH_FRIEND
+        case MESH_TRANSPORT_OPCODE_FRIEND_POLL:
+        case MESH_TRANSPORT_OPCODE_FRIEND_REQUEST:
+        case MESH_TRANSPORT_OPCODE_FRIEND_CLEAR:
+        case MESH_TRANSPORT_OPCODE_FRIEND_FRIEND_SUBSCRIPTION_LIST_ADD:
+        case MESH_TRANSPORT_OPCODE_FRIEND_FRIEND_SUBSCRIPTION_LIST_REMOVE:
+            mesh_friend_process_control_message(network_pdu);
+            mesh_network_message_processed_by_higher_layer(network_pdu);
+            break;
+#endif
         default:
             higher_layer_handler(MESH_TRANSPORT_PDU_RECEIVED, MESH_TRANSPORT_STATUS_SUCCESS, (mesh_pdu_t *) network_pdu);
             break;
@@ -238,6 +308,8 @@ static void mesh_lower_transport_send_ack(uint16_t netkey_index, uint8_t ttl, ui
     // setup network_pdu
     mesh_network_setup_pdu(network_pdu, netkey_index, network_key->nid, 1, ttl, mesh_sequence_number_next(), mesh_node_get_primary_element_address(), dest, ack_msg, sizeof(ack_msg));
 
+    MESH_STATISTICS_INC(mesh_lower_transport_statistics.tx_acks);
+
     // send network_pdu
     mesh_network_send_pdu(network_pdu);
 }
@@ -305,6 +377,7 @@ static void mesh_lower_transport_rx_incomplete_timeout(btstack_timer_source_t *t
 #ifdef LOG_LOWER_TRANSPORT
     printf("mesh_transport_rx_incomplete_timeout for %p - give up\n", transport_pdu);
 #endif
+    MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_segmented_incomplete);
     mesh_lower_transport_rx_segmented_message_complete(transport_pdu);
     // free message
     btstack_memory_mesh_transport_pdu_free(transport_pdu);
@@ -321,7 +394,8 @@ static void mesh_lower_transport_start_rx_acknowledgment_timer(mesh_transport_pd
     transport_pdu->acknowledgement_timer_active = 1;
 }
 
-static void mesh_lower_transport_tx_restart_segment_transmission_timer(void){
+static void mesh_lower_transport_tx_restart_segment_transmission_timer(mesh_lower_transport_outgoing_segmented_t * outgoing){
+    mesh_transport_pdu_t * lower_transport_outgoing_pdu = outgoing->pdu;
     // restart segment transmission timer for unicast dst
     // - "This timer shall be set to a minimum of 200 + 50 * TTL milliseconds."
     uint32_t timeout = 200 + 50 * mesh_transport_ttl(lower_transport_outgoing_pdu);
@@ -335,6 +409,7 @@ static void mesh_lower_transport_tx_restart_segment_transmission_timer(void){
 
     btstack_run_loop_set_timer(&lower_transport_outgoing_pdu->acknowledgement_timer, timeout);
     btstack_run_loop_set_timer_handler(&lower_transport_outgoing_pdu->acknowledgement_timer, &mesh_lower_transport_segment_transmission_timeout);
+    btstack_run_loop_set_timer_context(&lower_transport_outgoing_pdu->acknowledgement_timer, outgoing);
     btstack_run_loop_add_timer(&lower_transport_outgoing_pdu->acknowledgement_timer);
     lower_transport_outgoing_pdu->acknowledgement_timer_active = 1;
 }
@@ -354,7 +429,8 @@ static void mesh_lower_transport_restart_incomplete_timer(mesh_transport_pdu_t *
     transport_pdu->incomplete_timer_active = 1;
 }
 
-static void mesh_lower_transport_outgoing_complete(void){
+static void mesh_lower_transport_outgoing_complete(mesh_lower_transport_outgoing_segmented_t * outgoing){
+    mesh_transport_pdu_t * lower_transport_outgoing_pdu = outgoing->pdu;
 #ifdef LOG_LOWER_TRANSPORT
     printf("mesh_lower_transport_outgoing_complete %p, ack timer active %u, incomplete active %u\n", lower_transport_outgoing_pdu,
         lower_transport_outgoing_pdu->acknowledgement_timer_active, lower_transport_outgoing_pdu->incomplete_timer_active);
@@ -362,10 +438,22 @@ static void mesh_lower_transport_outgoing_complete(void){
     // stop timers
     mesh_lower_transport_stop_acknowledgment_timer(lower_transport_outgoing_pdu);
     mesh_lower_transport_stop_incomplete_timer(lower_transport_outgoing_pdu);
+#ifdef ENABLE_MESH_STATISTICS
+    // messages to unicast addresses are complete if all segments have been acknowledged
+    if ((lower_transport_outgoing_pdu->block_ack == 0) || !mesh_network_address_unicast(mesh_transport_dst(lower_transport_outgoing_pdu))){
+        mesh_lower_transport_statistics.tx_segmented_complete++;
+    } else {
+        mesh_lower_transport_statistics.tx_segmented_failed++;
+    }
+    MESH_STATISTICS_LATENCY(mesh_lower_transport_statistics.tx_segmented_latency, lower_transport_outgoing_pdu->timestamp_ms);
+#endif
     // notify upper transport
-    mesh_transport_pdu_t * pdu   = lower_transport_outgoing_pdu;
-    lower_transport_outgoing_pdu = NULL;
-    higher_layer_handler(MESH_TRANSPORT_PDU_SENT, MESH_TRANSPORT_STATUS_SEND_ABORT_BY_REMOTE, (mesh_pdu_t *) pdu);
+    outgoing->pdu = NULL;
+    outgoing->transmission_timeout  = 0;
+    outgoing->transmission_complete = 0;
+    higher_layer_handler(MESH_TRANSPORT_PDU_SENT, MESH_TRANSPORT_STATUS_SEND_ABORT_BY_REMOTE, (mesh_pdu_t *) lower_transport_outgoing_pdu);
+    // slot available for next segmented pdu
+    mesh_lower_transport_run();
 }
 
 static mesh_transport_pdu_t * mesh_lower_transport_pdu_for_segmented_message(mesh_network_pdu_t *network_pdu){
@@ -396,6 +484,7 @@ static mesh_transport_pdu_t * mesh_lower_transport_pdu_for_segmented_message(mes
 #ifdef LOG_LOWER_TRANSPORT
             printf("mesh_transport_pdu_for_segmented_message: drop segment. current transport pdu SeqZero %x, now %x\n", active_seq_zero, seq_zero);
 #endif
+            MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_dropped_segments);
             return NULL;
         }
     }
@@ -432,6 +521,7 @@ static mesh_transport_pdu_t * mesh_lower_transport_pdu_for_segmented_message(mes
         pdu->acknowledgement_timer_active = 0;
         pdu->message_complete = 0;
         pdu->seq_zero = seq_zero;
+        MESH_STATISTICS_TIMESTAMP(pdu->timestamp_ms);
 
         // update peer info
         peer->transport_pdu = pdu;
@@ -448,6 +538,7 @@ static mesh_transport_pdu_t * mesh_lower_transport_pdu_for_segmented_message(mes
 #ifdef LOG_LOWER_TRANSPORT
         printf("mesh_transport_pdu_for_segmented_message: drop segment for old seq %x\n", seq_zero);
 #endif
+        MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_dropped_segments);
         return NULL;
     }
 }
@@ -499,6 +590,8 @@ static void mesh_lower_transport_process_segment( mesh_transport_pdu_t * transpo
 
     // mark as done
     mesh_lower_transport_rx_segmented_message_complete(transport_pdu);
+    MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_segmented_complete);
+    MESH_STATISTICS_LATENCY(mesh_lower_transport_statistics.rx_reassembly_latency, transport_pdu->timestamp_ms);
 
     // store block ack in peer info
     mesh_peer_t * peer = mesh_peer_for_addr(mesh_transport_src(transport_pdu));
@@ -530,19 +623,19 @@ void mesh_lower_transport_message_processed_by_higher_layer(mesh_pdu_t * pdu){
 void mesh_lower_transport_received_message(mesh_network_callback_type_t callback_type, mesh_network_pdu_t *network_pdu){
     mesh_peer_t * peer;
     uint16_t src;
-    uint16_t seq;
+    uint32_t seq;
     switch (callback_type){
         case MESH_NETWORK_PDU_RECEIVED:
             src = mesh_network_src(network_pdu);
             seq = mesh_network_seq(network_pdu);
             peer = mesh_peer_for_addr(src);
 #ifdef LOG_LOWER_TRANSPORT
-            printf("Transport: received message. SRC %x, SEQ %x\n", src, seq);
+            printf("Transport: received message. SRC %x, SEQ %x\n", src, (int) seq);
 #endif
             // validate seq
             if (peer && seq > peer->seq){
                 // track seq
-                peer->seq = seq;
+                mesh_peer_set_seq(peer, seq);
                 // add to list and go
                 btstack_linked_list_add_tail(&lower_transport_incoming, (btstack_linked_item_t *) network_pdu);
                 mesh_lower_transport_run();
@@ -551,6 +644,7 @@ void mesh_lower_transport_received_message(mesh_network_callback_type_t callback
 #ifdef LOG_LOWER_TRANSPORT
                 printf("Transport: drop packet - src/seq auth failed\n");
 #endif
+                MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_dropped_seq);
                 mesh_network_message_processed_by_higher_layer(network_pdu);
             }
             break;
@@ -597,7 +691,8 @@ static void mesh_lower_transport_setup_segment(mesh_transport_pdu_t *transport_p
     mesh_network_setup_pdu(network_pdu, transport_pdu->netkey_index, nid, 0, ttl, seq, src, dest, lower_transport_pdu_data, lower_transport_pdu_len);
 }
 
-static void mesh_lower_transport_send_next_segment(void){
+static void mesh_lower_transport_send_next_segment(mesh_lower_transport_outgoing_segmented_t * outgoing){
+    mesh_transport_pdu_t * lower_transport_outgoing_pdu = outgoing->pdu;
     if (!lower_transport_outgoing_pdu) return;
 
     #ifdef LOG_LOWER_TRANSPORT
@@ -609,68 +704,72 @@ static void mesh_lower_transport_send_next_segment(void){
     uint8_t  seg_n = (lower_transport_outgoing_pdu->len - 1) / max_segment_len;
 
     // find next unacknowledged segement
-    while ((lower_transport_outgoing_seg_o <= seg_n) && ((lower_transport_outgoing_pdu->block_ack & (1 << lower_transport_outgoing_seg_o)) == 0)){
-        lower_transport_outgoing_seg_o++;
+    while ((outgoing->seg_o <= seg_n) && ((lower_transport_outgoing_pdu->block_ack & (1 << outgoing->seg_o)) == 0)){
+        outgoing->seg_o++;
     }
 
-    if (lower_transport_outgoing_seg_o > seg_n){
+    if (outgoing->seg_o > seg_n){
 #ifdef LOG_LOWER_TRANSPORT
         printf("[+] Lower Transport, segmented pdu %p, seq %06x: send complete (dst %x)\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu), mesh_transport_dst(lower_transport_outgoing_pdu));
 #endif
-        lower_transport_outgoing_seg_o   = 0;
+        outgoing->seg_o   = 0;
 
         // done for unicast, ack timer already set, too
         if (mesh_network_address_unicast(mesh_transport_dst(lower_transport_outgoing_pdu))) return;
 
         // done, more?
-        if (lower_transport_retry_count == 0){
+        if (outgoing->retry_count == 0){
 #ifdef LOG_LOWER_TRANSPORT
             printf("[+] Lower Transport, message unacknowledged -> free\n");
 #endif
             // notify upper transport
-            mesh_lower_transport_outgoing_complete();
+            mesh_lower_transport_outgoing_complete(outgoing);
             return;
         }
 
         // start retry
 #ifdef LOG_LOWER_TRANSPORT
-        printf("[+] Lower Transport, message unacknowledged retry count %u\n", lower_transport_retry_count);
+        printf("[+] Lower Transport, message unacknowledged retry count %u\n", outgoing->retry_count);
 #endif
-        lower_transport_retry_count--;
+        outgoing->retry_count--;
+        MESH_STATISTICS_INC(mesh_lower_transport_statistics.tx_retransmissions);
     }
 
     // restart segment transmission timer for unicast dst
     if (mesh_network_address_unicast(mesh_transport_dst(lower_transport_outgoing_pdu))){
-        mesh_lower_transport_tx_restart_segment_transmission_timer();
+        mesh_lower_transport_tx_restart_segment_transmission_timer(outgoing);
     }
 
-    mesh_lower_transport_setup_segment(lower_transport_outgoing_pdu, lower_transport_outgoing_seg_o,
-                                       lower_transport_outgoing_segment);
+    mesh_lower_transport_setup_segment(lower_transport_outgoing_pdu, outgoing->seg_o,
+                                       outgoing->segment);
 
 #ifdef LOG_LOWER_TRANSPORT
-    printf("[+] Lower Transport, segmented pdu %p, seq %06x: send seg_o %x, seg_n %x\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu), lower_transport_outgoing_seg_o, seg_n);
-    mesh_print_hex("LowerTransportPDU", &lower_transport_outgoing_segment->data[9], lower_transport_outgoing_segment->len-9);
+    printf("[+] Lower Transport, segmented pdu %p, seq %06x: send seg_o %x, seg_n %x\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu), outgoing->seg_o, seg_n);
+    mesh_print_hex("LowerTransportPDU", &outgoing->segment->data[9], outgoing->segment->len-9);
 #endif
 
     // next segment
-    lower_transport_outgoing_seg_o++;
+    outgoing->seg_o++;
 
     // send network pdu
-    lower_transport_outgoing_segment_queued = 1;
-    mesh_network_send_pdu(lower_transport_outgoing_segment);
+    outgoing->segment_queued = 1;
+    MESH_STATISTICS_INC(mesh_lower_transport_statistics.tx_segments);
+    mesh_network_send_pdu(outgoing->segment);
 }
 
-static void mesh_lower_transport_setup_sending_segmented_pdus(void){
-    printf("[+] Lower Transport, segmented pdu %p, seq %06x: send retry count %u\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu), lower_transport_retry_count);
-    lower_transport_retry_count--;
-    lower_transport_outgoing_seg_o   = 0;
+static void mesh_lower_transport_setup_sending_segmented_pdus(mesh_lower_transport_outgoing_segmented_t * outgoing){
+    mesh_transport_pdu_t * lower_transport_outgoing_pdu = outgoing->pdu;
+    printf("[+] Lower Transport, segmented pdu %p, seq %06x: send retry count %u\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu), outgoing->retry_count);
+    outgoing->retry_count--;
+    outgoing->seg_o   = 0;
 }
 
-static void mesh_lower_transport_segment_transmission_fired(void){
+static void mesh_lower_transport_segment_transmission_fired(mesh_lower_transport_outgoing_segmented_t * outgoing){
+    mesh_transport_pdu_t * lower_transport_outgoing_pdu = outgoing->pdu;
     // once more?
-    if (lower_transport_retry_count == 0){
+    if (outgoing->retry_count == 0){
         printf("[!] Lower transport, segmented pdu %p, seq %06x: send failed, retries exhausted\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu));
-        mesh_lower_transport_outgoing_complete();
+        mesh_lower_transport_outgoing_complete(outgoing);
         return;
     }
 
@@ -679,44 +778,46 @@ static void mesh_lower_transport_segment_transmission_fired(void){
 #endif
 
     // send remaining segments again
-    mesh_lower_transport_setup_sending_segmented_pdus();
+    MESH_STATISTICS_INC(mesh_lower_transport_statistics.tx_retransmissions);
+    mesh_lower_transport_setup_sending_segmented_pdus(outgoing);
     // send next segment
-    mesh_lower_transport_send_next_segment();
+    mesh_lower_transport_send_next_segment(outgoing);
 }
 
 static void mesh_lower_transport_network_pdu_sent(mesh_network_pdu_t *network_pdu){
     // figure out what pdu was sent
 
     // single segment of segmented message?
-    if (lower_transport_outgoing_segment == network_pdu){
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        mesh_lower_transport_outgoing_segmented_t * outgoing = &lower_transport_outgoing_segmented[i];
+        if (outgoing->segment != network_pdu) continue;
 
 #ifdef LOG_LOWER_TRANSPORT
-        printf("[+] Lower transport, segmented pdu %p, seq %06x: network pdu %p sent\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu), network_pdu);
+        printf("[+] Lower transport, segmented pdu %p, seq %06x: network pdu %p sent\n", outgoing->pdu, mesh_transport_seq(outgoing->pdu), network_pdu);
 #endif
 
-        lower_transport_outgoing_segment_queued = 0;
-        if (lower_transport_outgoing_trasnmission_complete){
+        outgoing->segment_queued = 0;
+        if (outgoing->transmission_complete){
             // handle complete
-            lower_transport_outgoing_trasnmission_complete = 0;
-            lower_transport_outgoing_transmission_timeout  = 0;
-            mesh_lower_transport_outgoing_complete();
+            mesh_lower_transport_outgoing_complete(outgoing);
             return;
         }
-        if (lower_transport_outgoing_transmission_timeout){
+        if (outgoing->transmission_timeout){
             // handle timeout
-            lower_transport_outgoing_transmission_timeout = 0;
-            mesh_lower_transport_segment_transmission_fired();
+            outgoing->transmission_timeout = 0;
+            mesh_lower_transport_segment_transmission_fired(outgoing);
             return;
         }
 
         // send next segment
-        mesh_lower_transport_send_next_segment();
+        mesh_lower_transport_send_next_segment(outgoing);
         return;
     }
 
     // Segment Acknowledgment message sent by us?
     if (mesh_network_control(network_pdu) && network_pdu->data[0] == 0){
-        btstack_memory_mesh_network_pdu_free(network_pdu);
+        mesh_network_pdu_free(network_pdu);
         return;
     }
 
@@ -744,22 +845,25 @@ void mesh_lower_transport_send_pdu(mesh_pdu_t *pdu){
             printf("too short, %u\n", network_pdu->len);
             while (true);
         }
+    } else {
+        MESH_STATISTICS_TIMESTAMP(((mesh_transport_pdu_t *) pdu)->timestamp_ms);
     }
     btstack_linked_list_add_tail(&lower_transport_outgoing, (btstack_linked_item_t*) pdu);
+    MESH_STATISTICS_MAX(mesh_lower_transport_statistics.max_outgoing_queued, btstack_linked_list_count(&lower_transport_outgoing));
     mesh_lower_transport_run();
 }
 
 static void mesh_lower_transport_segment_transmission_timeout(btstack_timer_source_t * ts){
-    UNUSED(ts);
+    mesh_lower_transport_outgoing_segmented_t * outgoing = (mesh_lower_transport_outgoing_segmented_t *) btstack_run_loop_get_timer_context(ts);
 #ifdef LOG_LOWER_TRANSPORT
-    printf("[+] Lower transport, segmented pdu %p, seq %06x: transmission timer fired\n", lower_transport_outgoing_pdu, mesh_transport_seq(lower_transport_outgoing_pdu));
+    printf("[+] Lower transport, segmented pdu %p, seq %06x: transmission timer fired\n", outgoing->pdu, mesh_transport_seq(outgoing->pdu));
 #endif
-    lower_transport_outgoing_pdu->acknowledgement_timer_active = 0;
+    outgoing->pdu->acknowledgement_timer_active = 0;
     
-    if (lower_transport_outgoing_segment_queued){
-        lower_transport_outgoing_transmission_timeout = 1;
+    if (outgoing->segment_queued){
+        outgoing->transmission_timeout = 1;
     } else {
-        mesh_lower_transport_segment_transmission_fired();
+        mesh_lower_transport_segment_transmission_fired(outgoing);
     }
 }
 
@@ -767,8 +871,15 @@ static void mesh_lower_transport_run(void){
     while(!btstack_linked_list_empty(&lower_transport_incoming)){
         // get next message
         mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&lower_transport_incoming);
+        // drop access messages to group or virtual addresses without subscribed model before reassembly and decryption
+        if ((mesh_network_control(network_pdu) == 0) && (mesh_node_subscription_filter_accepts(mesh_network_dst(network_pdu)) == 0)){
+            MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_dropped_unsubscribed);
+            mesh_network_message_processed_by_higher_layer(network_pdu);
+            continue;
+        }
         // segmented?
         if (mesh_network_segmented(network_pdu)){
+            MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_segments);
             mesh_transport_pdu_t * transport_pdu = mesh_lower_transport_pdu_for_segmented_message(network_pdu);
             if (transport_pdu) {
                 // start acknowledgment timer if inactive
@@ -783,6 +894,7 @@ static void mesh_lower_transport_run(void){
             }
             mesh_network_message_processed_by_higher_layer(network_pdu);
         } else {
+            MESH_STATISTICS_INC(mesh_lower_transport_statistics.rx_unsegmented);
             // control?
             if (mesh_network_control(network_pdu)){
                 // unsegmented control message (not encrypted)
@@ -794,33 +906,39 @@ static void mesh_lower_transport_run(void){
         }
     }
 
-    // check if outgoing segmented pdu is active
-    if (lower_transport_outgoing_pdu) return;
-
+    // send queued pdus in order, segmented pdus wait for a free slot and for the previous one to the same destination
     while(!btstack_linked_list_empty(&lower_transport_outgoing)) {
         // get next message
         mesh_transport_pdu_t * transport_pdu;
         mesh_network_pdu_t   * network_pdu;
-        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_pop(&lower_transport_outgoing);
+        mesh_lower_transport_outgoing_segmented_t * outgoing;
+        mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_get_first_item(&lower_transport_outgoing);
         switch (pdu->pdu_type) {
             case MESH_PDU_TYPE_NETWORK:
+                (void) btstack_linked_list_pop(&lower_transport_outgoing);
                 network_pdu = (mesh_network_pdu_t *) pdu;
+                MESH_STATISTICS_INC(mesh_lower_transport_statistics.tx_unsegmented);
                 mesh_network_send_pdu(network_pdu);
                 break;
             case MESH_PDU_TYPE_TRANSPORT:
                 transport_pdu = (mesh_transport_pdu_t *) pdu;
+                if (mesh_lower_transport_outgoing_segmented_for_dest(mesh_transport_dst(transport_pdu)) != NULL) return;
+                outgoing = mesh_lower_transport_outgoing_segmented_free();
+                if (outgoing == NULL) return;
+                (void) btstack_linked_list_pop(&lower_transport_outgoing);
                 printf("[+] Lower transport, segmented pdu %p, seq %06x: run start sending now\n", transport_pdu, mesh_transport_seq(transport_pdu));
                 // start sending segmented pdu
-                lower_transport_retry_count = 3;
-                lower_transport_outgoing_pdu = transport_pdu;
-                lower_transport_outgoing_transmission_timeout  = 0;
-                lower_transport_outgoing_trasnmission_complete = 0;
+                outgoing->retry_count = 3;
+                outgoing->pdu = transport_pdu;
+                outgoing->transmission_timeout  = 0;
+                outgoing->transmission_complete = 0;
+                MESH_STATISTICS_INC(mesh_lower_transport_statistics.tx_segmented);
                 mesh_lower_transport_setup_block_ack(transport_pdu);
-                mesh_lower_transport_setup_sending_segmented_pdus();
-                mesh_lower_transport_send_next_segment();
-
-                return;
+                mesh_lower_transport_setup_sending_segmented_pdus(outgoing);
+                mesh_lower_transport_send_next_segment(outgoing);
+                break;
             default:
+                (void) btstack_linked_list_pop(&lower_transport_outgoing);
                 break;
         }
     }
@@ -838,13 +956,18 @@ static void mesh_lower_transport_dump_network_pdus(const char *name, btstack_lin
 static void mesh_lower_transport_reset_network_pdus(btstack_linked_list_t *list){
     while (!btstack_linked_list_empty(list)){
         mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(list);
-        btstack_memory_mesh_network_pdu_free(pdu);
+        mesh_network_pdu_free(pdu);
     }
 }
 
 bool mesh_lower_transport_can_send_to_dest(uint16_t dest){
-    UNUSED(dest);
-    return (lower_transport_outgoing_pdu == NULL) && btstack_linked_list_empty(&lower_transport_outgoing);
+    if (btstack_linked_list_empty(&lower_transport_outgoing) == 0) return false;
+    if (mesh_lower_transport_outgoing_segmented_for_dest(dest) != NULL) return false;
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        if (lower_transport_outgoing_segmented[i].pdu == NULL) return true;
+    }
+    return false;
 }
 
 void mesh_lower_transport_reserve_slot(void){
@@ -856,23 +979,43 @@ void mesh_lower_transport_dump(void){
 
 void mesh_lower_transport_reset(void){
     mesh_lower_transport_reset_network_pdus(&lower_transport_incoming);
-    if (lower_transport_outgoing_pdu){
-        mesh_transport_pdu_free(lower_transport_outgoing_pdu);
-        lower_transport_outgoing_pdu = NULL;
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        mesh_lower_transport_outgoing_segmented_t * outgoing = &lower_transport_outgoing_segmented[i];
+        if (outgoing->pdu){
+            mesh_lower_transport_stop_acknowledgment_timer(outgoing->pdu);
+            mesh_transport_pdu_free(outgoing->pdu);
+            outgoing->pdu = NULL;
+        }
+        if (outgoing->segment){
+            mesh_network_pdu_free(outgoing->segment);
+            outgoing->segment = NULL;
+        }
+        outgoing->segment_queued = 0;
     }
-    mesh_network_pdu_free(lower_transport_outgoing_segment);
-    lower_transport_outgoing_segment_queued = 0;
-    lower_transport_outgoing_segment = NULL;
 }
 
 void mesh_lower_transport_init(){
     // register with network layer
     mesh_network_set_higher_layer_handler(&mesh_lower_transport_received_message);
     // allocate network_pdu for segmentation
-    lower_transport_outgoing_segment_queued = 0;
-    lower_transport_outgoing_segment = mesh_network_pdu_get();
+    int i;
+    for (i=0;i<MESH_LOWER_TRANSPORT_NUM_OUTGOING_SEGMENTED;i++){
+        lower_transport_outgoing_segmented[i].segment_queued = 0;
+        lower_transport_outgoing_segmented[i].segment = mesh_network_pdu_get();
+    }
+}
+
+#ifdef ENABLE_MESH_STATISTICS
+const mesh_lower_transport_statistics_t * mesh_lower_transport_get_statistics(void){
+    return &mesh_lower_transport_statistics;
 }
 
+void mesh_lower_transport_reset_statistics(void){
+    memset(&mesh_lower_transport_statistics, 0, sizeof(mesh_lower_transport_statistics));
+}
+#endif
+
 void mesh_lower_transport_set_higher_layer_handler(void (*pdu_handler)( mesh_transport_callback_type_t callback_type, mesh_transport_status_t status, mesh_pdu_t * pdu)){
     higher_layer_handler = pdu_handler;
 }
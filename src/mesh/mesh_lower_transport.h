@@ -75,6 +75,38 @@ typedef enum {
     MESH_TRANSPORT_STATUS_SEND_ABORT_BY_REMOTE,
 } mesh_transport_status_t;
 
+// lower transport statistics, updated with ENABLE_MESH_STATISTICS
+typedef struct {
+    // received unsegmented messages and segments
+    uint32_t rx_unsegmented;
+    uint32_t rx_segments;
+    // segmented messages reassembled / given up by incomplete timer
+    uint32_t rx_segmented_complete;
+    uint32_t rx_segmented_incomplete;
+    // dropped network pdus: seq not greater than last seq from src, segment not for current message
+    uint32_t rx_dropped_seq;
+    uint32_t rx_dropped_segments;
+    // dropped access messages without subscribed model
+    uint32_t rx_dropped_unsubscribed;
+    // segment acknowledgment messages
+    uint32_t tx_acks;
+    uint32_t rx_acks;
+    // sent unsegmented messages, segmented messages and segments
+    uint32_t tx_unsegmented;
+    uint32_t tx_segmented;
+    uint32_t tx_segments;
+    // segmented messages: retransmission rounds, acknowledged or sent to group, failed or cancelled
+    uint32_t tx_retransmissions;
+    uint32_t tx_segmented_complete;
+    uint32_t tx_segmented_failed;
+    // queue high-water mark
+    uint16_t max_outgoing_queued;
+    // first segment to reassembled message
+    mesh_statistics_latency_t rx_reassembly_latency;
+    // segmented message queued to completed
+    mesh_statistics_latency_t tx_segmented_latency;
+} mesh_lower_transport_statistics_t;
+
 // allocator
 mesh_transport_pdu_t * mesh_transport_pdu_get(void);
 void mesh_transport_pdu_free(mesh_transport_pdu_t * transport_pdu);
@@ -105,6 +137,11 @@ bool mesh_lower_transport_can_send_to_dest(uint16_t dest);
 void mesh_lower_transport_reserve_slot(void);
 void mesh_lower_transport_send_pdu(mesh_pdu_t * pdu);
 
+#ifdef ENABLE_MESH_STATISTICS
+const mesh_lower_transport_statistics_t * mesh_lower_transport_get_statistics(void);
+void mesh_lower_transport_reset_statistics(void);
+#endif
+
 // test
 void mesh_lower_transport_received_message(mesh_network_callback_type_t callback_type, mesh_network_pdu_t *network_pdu);
 void mesh_lower_transport_dump(void);
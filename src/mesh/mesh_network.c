@@ -44,6 +44,7 @@
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_memory.h"
+#include "btstack_trace.h"
 #include "btstack_util.h"
 
 #include "mesh/beacon.h"
@@ -62,13 +63,57 @@
 #include "mesh/gatt_bearer.h"
 #endif
 
+#ifdef ENABLE_MESH_FRIEND
+#include "mesh/mesh_friend.h"
+#endif
+
 // configuration
+
+// number of network PDUs remembered by the network message cache
+#ifndef MESH_NETWORK_CACHE_SIZE
 #define MESH_NETWORK_CACHE_SIZE 2
+#endif
+
+#if MESH_NETWORK_CACHE_SIZE > 0x7fff
+#error "MESH_NETWORK_CACHE_SIZE must be less than 32768"
+#endif
+
+// number of received network PDUs that can be validated concurrently
+#ifndef MESH_NETWORK_NUM_VALIDATIONS
+#define MESH_NETWORK_NUM_VALIDATIONS 2
+#endif
+
+#if MESH_NETWORK_NUM_VALIDATIONS < 1
+#error "MESH_NETWORK_NUM_VALIDATIONS must be at least 1"
+#endif
+
+// number of PECB results cached by privacy key, IV Index and Privacy Random, 0 to disable
+#ifndef MESH_NETWORK_PECB_CACHE_SIZE
+#define MESH_NETWORK_PECB_CACHE_SIZE 4
+#endif
+
+// max number of network pdus allocated per purpose, local pdus are not limited
+#ifndef MESH_NETWORK_PDU_QUOTA_RX
+#define MESH_NETWORK_PDU_QUOTA_RX 0xffff
+#endif
+
+#ifndef MESH_NETWORK_PDU_QUOTA_RELAY
+#define MESH_NETWORK_PDU_QUOTA_RELAY 0xffff
+#endif
+
+#ifndef MESH_NETWORK_PDU_QUOTA_PROXY
+#define MESH_NETWORK_PDU_QUOTA_PROXY 0xffff
+#endif
+
+// open addressing hash table with load factor below 0.5
+#define MESH_NETWORK_CACHE_HASH_TABLE_SIZE ((2 * MESH_NETWORK_CACHE_SIZE) + 1)
+#define MESH_NETWORK_CACHE_ENTRY_NONE 0xffff
 
 // debug config
 // #define LOG_NETWORK
 
-static void mesh_network_dump_network_pdus(const char * name, btstack_linked_list_t * list);
+static void mesh_network_dump_network_pdus(const char * name, btstack_linked_queue_t * queue);
+static void mesh_network_received_message_from(const uint8_t * pdu_data, uint8_t pdu_len, uint8_t flags, hci_con_handle_t con_handle);
 
 // structs
 
@@ -78,17 +123,21 @@ static void (*mesh_network_higher_layer_handler)(mesh_network_callback_type_t ca
 static void (*mesh_network_proxy_message_handler)(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu);
 
 #ifdef ENABLE_MESH_GATT_BEARER
-static hci_con_handle_t gatt_bearer_con_handle;
+// connected Proxy Clients
+static hci_con_handle_t gatt_bearer_con_handles[MESH_PROXY_NUM_CONNECTIONS];
+static const mesh_network_proxy_filter_t * mesh_network_proxy_filter;
 #endif
 
-// shared send/receive crypto
+// send crypto
 static int mesh_crypto_active;
 
 // crypto requests
-static union {
+typedef union {
     btstack_crypto_ccm_t         ccm;
     btstack_crypto_aes128_t      aes128;
-} mesh_network_crypto_request;
+} mesh_network_crypto_request_t;
+
+static mesh_network_crypto_request_t mesh_network_crypto_request;
 
 static const mesh_network_key_t *  current_network_key;
 
@@ -99,50 +148,113 @@ static uint8_t obfuscation_block[16];
 // Subnets
 static btstack_linked_list_t subnets;
 
+// Network PDU allocation
+static const uint16_t mesh_network_pdu_quota[MESH_NETWORK_PDU_PURPOSE_NUM] = {
+    0xffff,
+    MESH_NETWORK_PDU_QUOTA_RX,
+    MESH_NETWORK_PDU_QUOTA_RELAY,
+    MESH_NETWORK_PDU_QUOTA_PROXY,
+    // bounded by friend queue size
+    0xffff,
+};
+static mesh_network_pdu_stats_t mesh_network_pdu_stats;
+
+#ifdef ENABLE_MESH_STATISTICS
+static mesh_network_statistics_t mesh_network_statistics;
+#endif
+
 // Network Nonce
 static uint8_t network_nonce[13];
 
 // INCOMING //
 
 // unprocessed network pdu - added by mesh_network_pdus_received_message
-static btstack_linked_list_t        network_pdus_received;
+static btstack_linked_queue_t        network_pdus_received;
 
 // in validation
-static mesh_network_pdu_t *         incoming_pdu_raw;
-static mesh_network_pdu_t *         incoming_pdu_decoded;
-static mesh_network_key_iterator_t  validation_network_key_it;
+typedef enum {
+    MESH_NETWORK_VALIDATION_IDLE = 0,
+    MESH_NETWORK_VALIDATION_ACTIVE,
+    MESH_NETWORK_VALIDATION_DONE,
+} mesh_network_validation_state_t;
+
+typedef struct {
+    mesh_network_validation_state_t state;
+    mesh_network_pdu_t *            raw_pdu;
+    // NULL if no network key matched
+    mesh_network_pdu_t *            decoded_pdu;
+    mesh_network_key_iterator_t     network_key_it;
+    const mesh_network_key_t *      network_key;
+    mesh_network_crypto_request_t   crypto_request;
+    uint8_t                         encryption_block[16];
+    uint8_t                         obfuscation_block[16];
+    uint8_t                         network_nonce[13];
+} mesh_network_validation_t;
+
+// validations are started and delivered in order of reception; crypto operations get queued by btstack_crypto
+static mesh_network_validation_t mesh_network_validations[MESH_NETWORK_NUM_VALIDATIONS];
+static uint8_t mesh_network_validations_head;
+static uint8_t mesh_network_validations_count;
+static int     mesh_network_validations_delivering;
 
 // OUTGOING //
 
 // Network PDUs queued by mesh_network_send
-static btstack_linked_list_t network_pdus_queued;
+static btstack_linked_queue_t network_pdus_queued;
 
 // Network PDU about to get send via all bearers when encrypted
 static mesh_network_pdu_t * outgoing_pdu;
 
 // Network PDUs ready to send via GATT Bearer
-static btstack_linked_list_t network_pdus_outgoing_gatt;
+static btstack_linked_queue_t network_pdus_outgoing_gatt;
 
 #ifdef ENABLE_MESH_GATT_BEARER
+// Network PDU currently sent to all Proxy Clients marked as pending
 static mesh_network_pdu_t * gatt_bearer_network_pdu;
+static uint8_t gatt_bearer_network_pdu_pending[MESH_PROXY_NUM_CONNECTIONS];
 #endif
 
 // Network PDUs ready to send via ADV Bearer
-static btstack_linked_list_t network_pdus_outgoing_adv;
+static btstack_linked_queue_t network_pdus_outgoing_adv;
 
 #ifdef ENABLE_MESH_ADV_BEARER
 static mesh_network_pdu_t * adv_bearer_network_pdu;
 #endif
 
 
-// mesh network cache - we use 32-bit 'hashes'
-static uint32_t mesh_network_cache[MESH_NETWORK_CACHE_SIZE];
-static int      mesh_network_cache_index;
+// mesh network cache - we use 32-bit 'hashes', entries are kept in LRU order
+typedef struct {
+    uint32_t hash;
+    uint16_t prev;  // more recently used entry
+    uint16_t next;  // less recently used entry
+} mesh_network_cache_entry_t;
+
+static mesh_network_cache_entry_t mesh_network_cache_entries[MESH_NETWORK_CACHE_SIZE];
+// entry index + 1, 0 = free slot
+static uint16_t mesh_network_cache_table[MESH_NETWORK_CACHE_HASH_TABLE_SIZE];
+static uint16_t mesh_network_cache_num_entries;
+static uint16_t mesh_network_cache_most_recent;
+static uint16_t mesh_network_cache_least_recent;
+
+#if MESH_NETWORK_PECB_CACHE_SIZE > 0
+// PECB = e(PrivacyKey, 0x0000000000 || IV Index || Privacy Random), retransmissions of a Network PDU share it
+typedef struct {
+    uint8_t privacy_key[16];
+    // IV Index || Privacy Random, bytes 5..15 of PECB input
+    uint8_t iv_index_and_privacy_random[11];
+    uint8_t valid;
+    uint8_t pecb[6];
+} mesh_network_pecb_cache_entry_t;
+
+static mesh_network_pecb_cache_entry_t mesh_network_pecb_cache[MESH_NETWORK_PECB_CACHE_SIZE];
+static uint16_t mesh_network_pecb_cache_next;
+#endif
 
 // prototypes
 
 static void mesh_network_run(void);
-static void process_network_pdu_validate(void);
+static void process_network_pdu_validate(mesh_network_validation_t * validation);
+static mesh_network_pdu_t * mesh_network_pdu_allocate(mesh_network_pdu_purpose_t purpose, bool enforce_quota);
 
 // network caching
 static uint32_t mesh_network_cache_hash(mesh_network_pdu_t * network_pdu){
@@ -156,22 +268,134 @@ static uint32_t mesh_network_cache_hash(mesh_network_pdu_t * network_pdu){
     return (src << 16) | (ivi << 15) | (seq & 0x7fff);
 }
 
-static int mesh_network_cache_find(uint32_t hash){
-    int i;
-    for (i = 0; i < MESH_NETWORK_CACHE_SIZE; i++) {
-        if (mesh_network_cache[i] == hash) {
-            return 1;
+static uint32_t mesh_network_cache_home_slot(uint32_t hash){
+    // multiplicative hashing spreads sequence numbers of a single source over the table
+    return (hash * 2654435761u) % MESH_NETWORK_CACHE_HASH_TABLE_SIZE;
+}
+
+static uint32_t mesh_network_cache_next_slot(uint32_t slot){
+    slot++;
+    if (slot == MESH_NETWORK_CACHE_HASH_TABLE_SIZE){
+        slot = 0;
+    }
+    return slot;
+}
+
+// returns slot containing hash, or free slot where it would be stored
+static uint32_t mesh_network_cache_lookup_slot(uint32_t hash){
+    uint32_t slot = mesh_network_cache_home_slot(hash);
+    while (mesh_network_cache_table[slot] != 0){
+        if (mesh_network_cache_entries[mesh_network_cache_table[slot] - 1].hash == hash) break;
+        slot = mesh_network_cache_next_slot(slot);
+    }
+    return slot;
+}
+
+static void mesh_network_cache_table_remove(uint32_t slot){
+    // backward shift deletion: move following entries of the probe sequence into the gap
+    uint32_t free_slot = slot;
+    mesh_network_cache_table[free_slot] = 0;
+    slot = mesh_network_cache_next_slot(slot);
+    while (mesh_network_cache_table[slot] != 0){
+        uint32_t home = mesh_network_cache_home_slot(mesh_network_cache_entries[mesh_network_cache_table[slot] - 1].hash);
+        // entry can be moved if its home slot is not cyclically in (free_slot, slot]
+        int can_move;
+        if (free_slot <= slot){
+            can_move = (home <= free_slot) || (home > slot);
+        } else {
+            can_move = (home <= free_slot) && (home > slot);
         }
+        if (can_move){
+            mesh_network_cache_table[free_slot] = mesh_network_cache_table[slot];
+            mesh_network_cache_table[slot] = 0;
+            free_slot = slot;
+        }
+        slot = mesh_network_cache_next_slot(slot);
     }
-    return 0;
+}
+
+static void mesh_network_cache_lru_unlink(uint16_t index){
+    mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[index];
+    if (entry->prev == MESH_NETWORK_CACHE_ENTRY_NONE){
+        mesh_network_cache_most_recent = entry->next;
+    } else {
+        mesh_network_cache_entries[entry->prev].next = entry->next;
+    }
+    if (entry->next == MESH_NETWORK_CACHE_ENTRY_NONE){
+        mesh_network_cache_least_recent = entry->prev;
+    } else {
+        mesh_network_cache_entries[entry->next].prev = entry->prev;
+    }
+}
+
+static void mesh_network_cache_lru_add_most_recent(uint16_t index){
+    mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[index];
+    entry->prev = MESH_NETWORK_CACHE_ENTRY_NONE;
+    entry->next = MESH_NETWORK_CACHE_ENTRY_NONE;
+    if (mesh_network_cache_num_entries == 1){
+        // first entry
+        mesh_network_cache_least_recent = index;
+    } else {
+        entry->next = mesh_network_cache_most_recent;
+        mesh_network_cache_entries[mesh_network_cache_most_recent].prev = index;
+    }
+    mesh_network_cache_most_recent = index;
+}
+
+static int mesh_network_cache_find(uint32_t hash){
+    uint32_t slot = mesh_network_cache_lookup_slot(hash);
+    if (mesh_network_cache_table[slot] == 0) return 0;
+    // mark as most recently used
+    uint16_t index = mesh_network_cache_table[slot] - 1;
+    if (index != mesh_network_cache_most_recent){
+        mesh_network_cache_lru_unlink(index);
+        mesh_network_cache_lru_add_most_recent(index);
+    }
+    return 1;
 }
 
 static void mesh_network_cache_add(uint32_t hash){
-    mesh_network_cache[mesh_network_cache_index++] = hash;
-    if (mesh_network_cache_index >= MESH_NETWORK_CACHE_SIZE){
-        mesh_network_cache_index = 0;
+    uint16_t index;
+    if (mesh_network_cache_num_entries < MESH_NETWORK_CACHE_SIZE){
+        index = mesh_network_cache_num_entries++;
+    } else {
+        // evict least recently used entry
+        index = mesh_network_cache_least_recent;
+        mesh_network_cache_table_remove(mesh_network_cache_lookup_slot(mesh_network_cache_entries[index].hash));
+        mesh_network_cache_lru_unlink(index);
+    }
+    mesh_network_cache_entries[index].hash = hash;
+    mesh_network_cache_table[mesh_network_cache_lookup_slot(hash)] = index + 1;
+    mesh_network_cache_lru_add_most_recent(index);
+}
+
+#if MESH_NETWORK_PECB_CACHE_SIZE > 0
+static bool mesh_network_pecb_cache_get(const uint8_t * privacy_key, const uint8_t * pecb_input, uint8_t * pecb){
+    uint16_t i;
+    for (i=0;i<MESH_NETWORK_PECB_CACHE_SIZE;i++){
+        mesh_network_pecb_cache_entry_t * entry = &mesh_network_pecb_cache[i];
+        if (entry->valid == 0) continue;
+        if (memcmp(entry->iv_index_and_privacy_random, &pecb_input[5], 11) != 0) continue;
+        if (memcmp(entry->privacy_key, privacy_key, 16) != 0) continue;
+        (void)memcpy(pecb, entry->pecb, 6);
+        return true;
+    }
+    return false;
+}
+
+static void mesh_network_pecb_cache_add(const uint8_t * privacy_key, const uint8_t * pecb_input, const uint8_t * pecb){
+    // replace oldest entry
+    mesh_network_pecb_cache_entry_t * entry = &mesh_network_pecb_cache[mesh_network_pecb_cache_next];
+    mesh_network_pecb_cache_next++;
+    if (mesh_network_pecb_cache_next == MESH_NETWORK_PECB_CACHE_SIZE){
+        mesh_network_pecb_cache_next = 0;
     }
+    (void)memcpy(entry->privacy_key, privacy_key, 16);
+    (void)memcpy(entry->iv_index_and_privacy_random, &pecb_input[5], 11);
+    (void)memcpy(entry->pecb, pecb, 6);
+    entry->valid = 1;
 }
+#endif
 
 // common helper
 int mesh_network_address_unicast(uint16_t addr){
@@ -258,11 +482,17 @@ static void mesh_proxy_create_nonce(uint8_t * nonce, const mesh_network_pdu_t *
 // NID/IVI | obfuscated (CTL/TTL, SEQ (24), SRC (16) ), encrypted ( DST(16), TransportPDU), MIC(32 or 64)
 
 static void mesh_network_send_complete(mesh_network_pdu_t * network_pdu){
+    MESH_STATISTICS_LATENCY(mesh_network_statistics.tx_latency, network_pdu->timestamp_ms);
     if (network_pdu->flags & MESH_NETWORK_PDU_FLAGS_RELAY){
 #ifdef LOG_NETWORK
         printf("TX-F-NetworkPDU (%p): relay -> free packet\n", network_pdu);
 #endif
         mesh_network_pdu_free(network_pdu);
+#ifdef ENABLE_MESH_FRIEND
+    } else if (network_pdu->purpose == MESH_NETWORK_PDU_PURPOSE_FRIEND){
+        // sent by friend feature on behalf of Low Power node
+        mesh_friend_network_pdu_sent(network_pdu);
+#endif
     } else {
 #ifdef LOG_NETWORK
         printf("TX-F-NetworkPDU (%p): notify lower transport\n", network_pdu);
@@ -274,13 +504,15 @@ static void mesh_network_send_complete(mesh_network_pdu_t * network_pdu){
 
 static void mesh_network_send_d(mesh_network_pdu_t * network_pdu){
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_MESH_NETWORK_TX_ENCRYPTED, 0, network_pdu->len);
+
 #ifdef LOG_NETWORK
     printf("TX-D-NetworkPDU (%p): ", network_pdu);
     printf_hexdump(network_pdu->data, network_pdu->len);
 #endif
 
     // add to queue
-    btstack_linked_list_add_tail(&network_pdus_outgoing_gatt, (btstack_linked_item_t *) network_pdu);
+    btstack_linked_queue_enqueue(&network_pdus_outgoing_gatt, (btstack_linked_item_t *) network_pdu);
 
     // go
     mesh_network_run();
@@ -290,6 +522,11 @@ static void mesh_network_send_d(mesh_network_pdu_t * network_pdu){
 static void mesh_network_send_c(void *arg){
     UNUSED(arg);
 
+#if MESH_NETWORK_PECB_CACHE_SIZE > 0
+    // relays might echo our PDU
+    mesh_network_pecb_cache_add(current_network_key->privacy_key, encryption_block, obfuscation_block);
+#endif
+
     // obfuscate
     unsigned int i;
     for (i=0;i<6;i++){
@@ -335,6 +572,7 @@ static void mesh_network_send_b(void *arg){
     memset(encryption_block, 0, 5);
     big_endian_store_32(encryption_block, 5, iv_index);
     (void)memcpy(&encryption_block[9], &outgoing_pdu->data[7], 7);
+    MESH_STATISTICS_INC(mesh_network_statistics.aes128_operations);
     btstack_crypto_aes128_encrypt(&mesh_network_crypto_request.aes128, current_network_key->privacy_key, encryption_block, obfuscation_block, &mesh_network_send_c, NULL);
 }
 
@@ -342,6 +580,9 @@ static void mesh_network_send_a(void){
 
     mesh_crypto_active = 1;
 
+    // DST gets encrypted, keep copy for Proxy Filter
+    outgoing_pdu->dst = mesh_network_dst(outgoing_pdu);
+
     uint32_t iv_index = mesh_get_iv_index_for_tx();
 
     // lookup subnet by netkey_index
@@ -360,6 +601,16 @@ static void mesh_network_send_a(void){
     // get network key to use for sending
     current_network_key = mesh_subnet_get_outgoing_network_key(subnet);
 
+#ifdef ENABLE_MESH_FRIEND
+    // messages from Friend to Low Power node use friendship credentials
+    if (outgoing_pdu->purpose == MESH_NETWORK_PDU_PURPOSE_FRIEND){
+        const mesh_network_key_t * friendship_credentials = mesh_friend_get_friendship_credentials(outgoing_pdu);
+        if (friendship_credentials != NULL){
+            current_network_key = friendship_credentials;
+        }
+    }
+#endif
+
 #ifdef LOG_NETWORK
     printf("TX-A-NetworkPDU (%p): ", outgoing_pdu);
     printf_hexdump(outgoing_pdu->data, outgoing_pdu->len);
@@ -388,6 +639,7 @@ static void mesh_network_send_a(void){
     // start ccm
     uint8_t cypher_len  = outgoing_pdu->len - 7;
     uint8_t net_mic_len = outgoing_pdu->data[1] & 0x80 ? 8 : 4;
+    MESH_STATISTICS_INC(mesh_network_statistics.ccm_operations);
     btstack_crypto_ccm_init(&mesh_network_crypto_request.ccm, current_network_key->encryption_key, network_nonce, cypher_len, 0, net_mic_len);
     btstack_crypto_ccm_encrypt_block(&mesh_network_crypto_request.ccm, cypher_len, &outgoing_pdu->data[7], &outgoing_pdu->data[7], &mesh_network_send_b, NULL);
 }
@@ -399,6 +651,16 @@ static void mesh_network_relay_message(mesh_network_pdu_t * network_pdu){
     uint8_t ctl_in_bit_7 = ctl_ttl & 0x80;
     uint8_t ttl          = ctl_ttl & 0x7f;
 
+    // drop if too many pdus are already queued for relaying
+    if (mesh_network_pdu_set_purpose(network_pdu, MESH_NETWORK_PDU_PURPOSE_RELAY) == false){
+#ifdef LOG_NETWORK
+        printf("TX-Relay-NetworkPDU (%p): relay quota reached -> drop\n", network_pdu);
+#endif
+        mesh_network_pdu_stats.relay_dropped++;
+        mesh_network_pdu_free(network_pdu);
+        return;
+    }
+
 #ifdef LOG_NETWORK
     printf("TX-Relay-NetworkPDU (%p): ", network_pdu);
     printf_hexdump(network_pdu->data, network_pdu->len);
@@ -409,9 +671,23 @@ static void mesh_network_relay_message(mesh_network_pdu_t * network_pdu){
     network_pdu->data[1] = ctl_in_bit_7 | (ttl - 1);
     network_pdu->flags |= MESH_NETWORK_PDU_FLAGS_RELAY;
 
+#ifdef ENABLE_MESH_FRIEND
+    // relay messages received with friendship credentials using master security credentials
+    if (network_pdu->flags & MESH_NETWORK_PDU_FLAGS_FRIENDSHIP_CREDENTIALS){
+        network_pdu->flags &= ~MESH_NETWORK_PDU_FLAGS_FRIENDSHIP_CREDENTIALS;
+        mesh_subnet_t * subnet = mesh_subnet_get_by_netkey_index(network_pdu->netkey_index);
+        if (subnet != NULL){
+            network_pdu->data[0] = (network_pdu->data[0] & 0x80) | mesh_subnet_get_outgoing_network_key(subnet)->nid;
+        }
+    }
+#endif
+
     // queue up
     network_pdu->callback = &mesh_network_send_d;
-    btstack_linked_list_add_tail(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    MESH_STATISTICS_INC(mesh_network_statistics.tx_relay);
+    MESH_STATISTICS_TIMESTAMP(network_pdu->timestamp_ms);
+    btstack_linked_queue_enqueue(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    MESH_STATISTICS_MAX(mesh_network_statistics.max_outgoing_queued, btstack_linked_list_count(&network_pdus_queued.head));
 }
 #endif
 
@@ -455,7 +731,7 @@ void mesh_network_message_processed_by_higher_layer(mesh_network_pdu_t * network
 
 #ifdef ENABLE_MESH_PROXY_SERVER
             if (mesh_foundation_gatt_proxy_get() != 0){
-                // - to ADV bearer, if Proxy supported and enabled
+                // - to ADV bearer and other Proxy Clients, if Proxy supported and enabled
                 mesh_network_relay_message(network_pdu);
                 mesh_network_run();
                 return;
@@ -467,28 +743,122 @@ void mesh_network_message_processed_by_higher_layer(mesh_network_pdu_t * network
 #endif
 
     // otherwise, we're done
-    btstack_memory_mesh_network_pdu_free(network_pdu);
+    mesh_network_pdu_free(network_pdu);
 }
 
-static void process_network_pdu_done(void){
-    btstack_memory_mesh_network_pdu_free(incoming_pdu_raw);
-    incoming_pdu_raw = NULL;
-    mesh_crypto_active = 0;
+static void process_network_pdu_forward(mesh_network_pdu_t * decoded_pdu){
+
+    if (decoded_pdu->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
 
+        // no additional checks for proxy messages
+        (*mesh_network_proxy_message_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
+        return;
+    }
+
+    // validate src/dest addresses
+    uint8_t  ctl = decoded_pdu->data[1] >> 7;
+    uint16_t src = big_endian_read_16(decoded_pdu->data, 5);
+    uint16_t dst = big_endian_read_16(decoded_pdu->data, 7);
+    int valid = mesh_network_addresses_valid(ctl, src, dst);
+    if (!valid){
+#ifdef LOG_NETWORK
+        printf("RX Address invalid (%p)\n", decoded_pdu);
+#endif
+        MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_invalid_address);
+        mesh_network_pdu_free(decoded_pdu);
+        return;
+    }
+
+    // check cache
+    uint32_t hash = mesh_network_cache_hash(decoded_pdu);
+#ifdef LOG_NETWORK
+    printf("RX-Hash (%p): %08x\n", decoded_pdu, hash);
+#endif
+    if (mesh_network_cache_find(hash)){
+        // found in cache, drop
+#ifdef LOG_NETWORK
+        printf("Found in cache -> drop packet (%p)\n", decoded_pdu);
+#endif
+        MESH_STATISTICS_INC(mesh_network_statistics.cache_hits);
+        mesh_network_pdu_free(decoded_pdu);
+        return;
+    }
+
+    // store in network cache
+    mesh_network_cache_add(hash);
+
+#ifdef ENABLE_MESH_GATT_BEARER
+    // Proxy Server adds/removes SRC of messages from Proxy Client to/from its filter
+    if ((decoded_pdu->flags & MESH_NETWORK_PDU_FLAGS_GATT_BEARER) && (mesh_network_proxy_filter != NULL)){
+        (*mesh_network_proxy_filter->received)(decoded_pdu->con_handle, src);
+    }
+#endif
+
+#ifdef ENABLE_MESH_FRIEND
+    // store copy in Friend Queue if addressed to a Low Power node
+    mesh_friend_network_pdu_received(decoded_pdu);
+#endif
+
+#ifdef LOG_NETWORK
+    printf("RX-Validated (%p) - forward to lower transport\n", decoded_pdu);
+#endif
+
+    MESH_STATISTICS_INC(mesh_network_statistics.rx_delivered);
+    MESH_STATISTICS_LATENCY(mesh_network_statistics.rx_latency, decoded_pdu->timestamp_ms);
+
+    // forward to lower transport layer. message is freed by call to mesh_network_message_processed_by_upper_layer
+    (*mesh_network_higher_layer_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
+}
+
+static void process_network_pdu_deliver(void){
+    // avoid re-entrant delivery from higher layer handlers, outer loop continues
+    if (mesh_network_validations_delivering) return;
+    mesh_network_validations_delivering = 1;
+
+    // deliver completed validations in order of reception
+    while (mesh_network_validations_count > 0){
+        mesh_network_validation_t * validation = &mesh_network_validations[mesh_network_validations_head];
+        if (validation->state != MESH_NETWORK_VALIDATION_DONE) break;
+
+        // release validation before forwarding, higher layer might trigger new validations
+        mesh_network_pdu_t * raw_pdu     = validation->raw_pdu;
+        mesh_network_pdu_t * decoded_pdu = validation->decoded_pdu;
+        validation->state       = MESH_NETWORK_VALIDATION_IDLE;
+        validation->raw_pdu     = NULL;
+        validation->decoded_pdu = NULL;
+        mesh_network_validations_head++;
+        if (mesh_network_validations_head == MESH_NETWORK_NUM_VALIDATIONS){
+            mesh_network_validations_head = 0;
+        }
+        mesh_network_validations_count--;
+
+        mesh_network_pdu_free(raw_pdu);
+        if (decoded_pdu != NULL){
+            BTSTACK_TRACE(BTSTACK_TRACE_POINT_MESH_NETWORK_RX_DECODED, 0, decoded_pdu->len);
+            process_network_pdu_forward(decoded_pdu);
+        }
+    }
+
+    mesh_network_validations_delivering = 0;
+}
+
+static void process_network_pdu_done(mesh_network_validation_t * validation){
+    validation->state = MESH_NETWORK_VALIDATION_DONE;
+    process_network_pdu_deliver();
     mesh_network_run();
 }
 
 static void process_network_pdu_validate_d(void * arg){
-    UNUSED(arg);
-    // mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) arg;
+    mesh_network_validation_t * validation = (mesh_network_validation_t *) arg;
+    mesh_network_pdu_t * incoming_pdu_raw     = validation->raw_pdu;
+    mesh_network_pdu_t * incoming_pdu_decoded = validation->decoded_pdu;
 
     uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
-    uint8_t ctl         = ctl_ttl >> 7;
     uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
 
     // store NetMIC
     uint8_t net_mic[8];
-    btstack_crypto_ccm_get_authentication_value(&mesh_network_crypto_request.ccm, net_mic);
+    btstack_crypto_ccm_get_authentication_value(&validation->crypto_request.ccm, net_mic);
 #ifdef LOG_NETWORK
     printf("RX-NetMIC (%p): ", incoming_pdu_decoded); 
     printf_hexdump(net_mic, net_mic_len);
@@ -510,7 +880,7 @@ static void process_network_pdu_validate_d(void * arg){
     if (memcmp(net_mic, &incoming_pdu_raw->data[incoming_pdu_decoded->len-net_mic_len], net_mic_len) != 0){
         // fail
         printf("RX-NetMIC mismatch, try next key (%p)\n", incoming_pdu_decoded);
-        process_network_pdu_validate();
+        process_network_pdu_validate(validation);
         return;
     }    
 
@@ -524,63 +894,17 @@ static void process_network_pdu_validate_d(void * arg){
 #endif
 
     // set netkey_index
-    incoming_pdu_decoded->netkey_index = current_network_key->netkey_index;
-
-    if (incoming_pdu_decoded->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
-
-        mesh_network_pdu_t * decoded_pdu = incoming_pdu_decoded;
-        incoming_pdu_decoded = NULL;
-
-        // no additional checks for proxy messages
-        (*mesh_network_proxy_message_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
- 
-    } else {
-
-        // validate src/dest addresses
-        uint16_t src = big_endian_read_16(incoming_pdu_decoded->data, 5);
-        uint16_t dst = big_endian_read_16(incoming_pdu_decoded->data, 7);
-        int valid = mesh_network_addresses_valid(ctl, src, dst);
-        if (!valid){
-#ifdef LOG_NETWORK
-            printf("RX Address invalid (%p)\n", incoming_pdu_decoded);
-#endif
-            btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
-            incoming_pdu_decoded = NULL;
-            process_network_pdu_done();
-            return;
-        }
-
-        // check cache
-        uint32_t hash = mesh_network_cache_hash(incoming_pdu_decoded);
-#ifdef LOG_NETWORK
-        printf("RX-Hash (%p): %08x\n", incoming_pdu_decoded, hash);
-#endif
-        if (mesh_network_cache_find(hash)){
-            // found in cache, drop
-#ifdef LOG_NETWORK
-            printf("Found in cache -> drop packet (%p)\n", incoming_pdu_decoded);
-#endif
-            btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
-            incoming_pdu_decoded = NULL;
-            process_network_pdu_done();
-            return;
-        }
-
-        // store in network cache
-        mesh_network_cache_add(hash);
+    incoming_pdu_decoded->netkey_index = validation->network_key->netkey_index;
 
-#ifdef LOG_NETWORK
-            printf("RX-Validated (%p) - forward to lower transport\n", incoming_pdu_decoded);
-#endif
-
-        // forward to lower transport layer. message is freed by call to mesh_network_message_processed_by_upper_layer
-        mesh_network_pdu_t * decoded_pdu = incoming_pdu_decoded;
-        incoming_pdu_decoded = NULL;
-        (*mesh_network_higher_layer_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
+#ifdef ENABLE_MESH_FRIEND
+    // mark message received with friendship credentials
+    if (validation->network_key->friendship_credentials){
+        incoming_pdu_decoded->flags |= MESH_NETWORK_PDU_FLAGS_FRIENDSHIP_CREDENTIALS;
     }
+#endif
 
     // done
-    process_network_pdu_done();
+    process_network_pdu_done(validation);
 }
 
 static uint32_t iv_index_for_pdu(const mesh_network_pdu_t * network_pdu){
@@ -599,34 +923,51 @@ static uint32_t iv_index_for_pdu(const mesh_network_pdu_t * network_pdu){
 }
 
 static void process_network_pdu_validate_b(void * arg){
-    UNUSED(arg);
+    mesh_network_validation_t * validation = (mesh_network_validation_t *) arg;
+    mesh_network_pdu_t * incoming_pdu_raw     = validation->raw_pdu;
+    mesh_network_pdu_t * incoming_pdu_decoded = validation->decoded_pdu;
 
 #ifdef LOG_NETWORK
     printf("RX-PECB: ");
-    printf_hexdump(obfuscation_block, 6);
+    printf_hexdump(validation->obfuscation_block, 6);
 #endif
 
     // de-obfuscate
     unsigned int i;
     for (i=0;i<6;i++){
-        incoming_pdu_decoded->data[1+i] = incoming_pdu_raw->data[1+i] ^ obfuscation_block[i];
+        incoming_pdu_decoded->data[1+i] = incoming_pdu_raw->data[1+i] ^ validation->obfuscation_block[i];
+    }
+
+    // SRC and SEQ are known now: drop retransmissions without decrypting them. only done if no other key
+    // with same NID remains, as de-obfuscation with a wrong key could collide with a cached entry
+    if (((incoming_pdu_decoded->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION) == 0) &&
+        (mesh_network_key_nid_iterator_has_more(&validation->network_key_it) == 0) &&
+        (mesh_network_cache_find(mesh_network_cache_hash(incoming_pdu_decoded)) != 0)){
+#ifdef LOG_NETWORK
+        printf("Found in cache -> drop packet before decryption (%p)\n", incoming_pdu_decoded);
+#endif
+        MESH_STATISTICS_INC(mesh_network_statistics.cache_hits_obfuscated);
+        mesh_network_pdu_free(incoming_pdu_decoded);
+        validation->decoded_pdu = NULL;
+        process_network_pdu_done(validation);
+        return;
     }
 
     uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
 
     if (incoming_pdu_decoded->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
         // create network nonce
-        mesh_proxy_create_nonce(network_nonce, incoming_pdu_decoded, iv_index);
+        mesh_proxy_create_nonce(validation->network_nonce, incoming_pdu_decoded, iv_index);
 #ifdef LOG_NETWORK
         printf("RX-Proxy Nonce: ");
-        printf_hexdump(network_nonce, 13);
+        printf_hexdump(validation->network_nonce, 13);
 #endif
     } else {
         // create network nonce
-        mesh_network_create_nonce(network_nonce, incoming_pdu_decoded, iv_index);
+        mesh_network_create_nonce(validation->network_nonce, incoming_pdu_decoded, iv_index);
 #ifdef LOG_NETWORK
         printf("RX-Network Nonce: ");
-        printf_hexdump(network_nonce, 13);
+        printf_hexdump(validation->network_nonce, 13);
 #endif
     }
 
@@ -639,54 +980,78 @@ static void process_network_pdu_validate_b(void * arg){
     printf("RX-Cyper len %u, mic len %u\n", cypher_len, net_mic_len);
 
     printf("RX-Encryption Key: ");
-    printf_hexdump(current_network_key->encryption_key, 16);
+    printf_hexdump(validation->network_key->encryption_key, 16);
 
 #endif
 
-    btstack_crypto_ccm_init(&mesh_network_crypto_request.ccm, current_network_key->encryption_key, network_nonce, cypher_len, 0, net_mic_len);
-    btstack_crypto_ccm_decrypt_block(&mesh_network_crypto_request.ccm, cypher_len, &incoming_pdu_raw->data[7], &incoming_pdu_decoded->data[7], &process_network_pdu_validate_d, incoming_pdu_decoded);
+    MESH_STATISTICS_INC(mesh_network_statistics.ccm_operations);
+    btstack_crypto_ccm_init(&validation->crypto_request.ccm, validation->network_key->encryption_key, validation->network_nonce, cypher_len, 0, net_mic_len);
+    btstack_crypto_ccm_decrypt_block(&validation->crypto_request.ccm, cypher_len, &incoming_pdu_raw->data[7], &incoming_pdu_decoded->data[7], &process_network_pdu_validate_d, validation);
 }
 
-static void process_network_pdu_validate(void){
-    if (!mesh_network_key_nid_iterator_has_more(&validation_network_key_it)){
+#if MESH_NETWORK_PECB_CACHE_SIZE > 0
+static void process_network_pdu_validate_a(void * arg){
+    mesh_network_validation_t * validation = (mesh_network_validation_t *) arg;
+    mesh_network_pecb_cache_add(validation->network_key->privacy_key, validation->encryption_block, validation->obfuscation_block);
+    process_network_pdu_validate_b(validation);
+}
+#endif
+
+static void process_network_pdu_validate(mesh_network_validation_t * validation){
+    if (!mesh_network_key_nid_iterator_has_more(&validation->network_key_it)){
         printf("No valid network key found\n");
-        btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
-        incoming_pdu_decoded = NULL;
-        process_network_pdu_done();
+        MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_no_network_key);
+        mesh_network_pdu_free(validation->decoded_pdu);
+        validation->decoded_pdu = NULL;
+        process_network_pdu_done(validation);
         return;
     }
 
-    current_network_key = mesh_network_key_nid_iterator_get_next(&validation_network_key_it);
+    validation->network_key = mesh_network_key_nid_iterator_get_next(&validation->network_key_it);
 
     // calc PECB
-    uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
-    memset(encryption_block, 0, 5);
-    big_endian_store_32(encryption_block, 5, iv_index);
-    (void)memcpy(&encryption_block[9], &incoming_pdu_raw->data[7], 7);
-    btstack_crypto_aes128_encrypt(&mesh_network_crypto_request.aes128, current_network_key->privacy_key, encryption_block, obfuscation_block, &process_network_pdu_validate_b, NULL);
+    uint32_t iv_index = iv_index_for_pdu(validation->raw_pdu);
+    memset(validation->encryption_block, 0, 5);
+    big_endian_store_32(validation->encryption_block, 5, iv_index);
+    (void)memcpy(&validation->encryption_block[9], &validation->raw_pdu->data[7], 7);
+#if MESH_NETWORK_PECB_CACHE_SIZE > 0
+    if (mesh_network_pecb_cache_get(validation->network_key->privacy_key, validation->encryption_block, validation->obfuscation_block)){
+        process_network_pdu_validate_b(validation);
+        return;
+    }
+    MESH_STATISTICS_INC(mesh_network_statistics.aes128_operations);
+    btstack_crypto_aes128_encrypt(&validation->crypto_request.aes128, validation->network_key->privacy_key, validation->encryption_block, validation->obfuscation_block, &process_network_pdu_validate_a, validation);
+#else
+    MESH_STATISTICS_INC(mesh_network_statistics.aes128_operations);
+    btstack_crypto_aes128_encrypt(&validation->crypto_request.aes128, validation->network_key->privacy_key, validation->encryption_block, validation->obfuscation_block, &process_network_pdu_validate_b, validation);
+#endif
 }
 
 
-static void process_network_pdu(void){
+static void process_network_pdu(mesh_network_validation_t * validation){
     //
-    uint8_t nid_ivi = incoming_pdu_raw->data[0];
+    uint8_t nid_ivi = validation->raw_pdu->data[0];
 
     // setup pdu object
-    incoming_pdu_decoded->data[0] = nid_ivi;
-    incoming_pdu_decoded->len     = incoming_pdu_raw->len;
-    incoming_pdu_decoded->flags   = incoming_pdu_raw->flags;
+    validation->decoded_pdu->data[0] = nid_ivi;
+    validation->decoded_pdu->len     = validation->raw_pdu->len;
+    validation->decoded_pdu->flags   = validation->raw_pdu->flags;
+    validation->decoded_pdu->con_handle = validation->raw_pdu->con_handle;
+#ifdef ENABLE_MESH_STATISTICS
+    validation->decoded_pdu->timestamp_ms = validation->raw_pdu->timestamp_ms;
+#endif
 
-    // init provisioning data iterator
+    // init network key iterator, candidate keys are looked up by nid
     uint8_t nid = nid_ivi & 0x7f;
     // uint8_t iv_index = network_pdu_data[0] >> 7;
-    mesh_network_key_nid_iterator_init(&validation_network_key_it, nid);
+    mesh_network_key_nid_iterator_init(&validation->network_key_it, nid);
 
-    process_network_pdu_validate();
+    process_network_pdu_validate(validation);
 }
 
 // returns true if done
 static bool mesh_network_run_gatt(void){
-    if (btstack_linked_list_empty(&network_pdus_outgoing_gatt)){
+    if (btstack_linked_queue_empty(&network_pdus_outgoing_gatt)){
         return true;
     }
 
@@ -696,31 +1061,45 @@ static bool mesh_network_run_gatt(void){
     }
 
     // move to 'gatt bearer queue'
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_gatt);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(&network_pdus_outgoing_gatt);
 
 #ifdef LOG_NETWORK
     printf("network run 1: pop %p from network_pdus_outgoing_gatt\n", network_pdu);
 #endif
-    // request to send via gatt if:
+    // request to send via gatt to each Proxy Client if:
     // proxy active and connected
-    // packet wasn't received via gatt bearer
-    int send_via_gatt = ((mesh_foundation_gatt_proxy_get() != 0) &&
-                        (gatt_bearer_con_handle != HCI_CON_HANDLE_INVALID) &&
-                        ((network_pdu->flags & MESH_NETWORK_PDU_FLAGS_GATT_BEARER) == 0));
+    // packet wasn't received from this client
+    // proxy filter of this client accepts dst
+    int send_via_gatt = 0;
+    if (mesh_foundation_gatt_proxy_get() != 0){
+        int i;
+        for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+            hci_con_handle_t con_handle = gatt_bearer_con_handles[i];
+            if (con_handle == HCI_CON_HANDLE_INVALID) continue;
+            if (((network_pdu->flags & MESH_NETWORK_PDU_FLAGS_GATT_BEARER) != 0) && (network_pdu->con_handle == con_handle)) continue;
+            if ((mesh_network_proxy_filter != NULL) && !(*mesh_network_proxy_filter->accepts)(con_handle, network_pdu->dst)) continue;
+            gatt_bearer_network_pdu_pending[i] = 1;
+            send_via_gatt = 1;
+        }
+    }
     if (send_via_gatt){
 
 #ifdef LOG_NETWORK
         printf("network run 2: set %p as gatt_bearer_network_pdu\n", network_pdu);
 #endif
         gatt_bearer_network_pdu = network_pdu;
-        gatt_bearer_request_can_send_now_for_network_pdu();
+        int i;
+        for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+            if (gatt_bearer_network_pdu_pending[i] == 0) continue;
+            gatt_bearer_request_can_send_now_for_network_pdu(gatt_bearer_con_handles[i]);
+        }
 
     } else {
 
 #ifdef LOG_NETWORK
         printf("network run 3: push %p to network_pdus_outgoing_adv\n", network_pdu);
 #endif
-        btstack_linked_list_add_tail(&network_pdus_outgoing_adv, (btstack_linked_item_t *) network_pdu);
+        btstack_linked_queue_enqueue(&network_pdus_outgoing_adv, (btstack_linked_item_t *) network_pdu);
 
 #ifdef LOG_NETWORK
         mesh_network_dump_network_pdus("network_pdus_outgoing_adv (1)", &network_pdus_outgoing_adv);
@@ -728,8 +1107,8 @@ static bool mesh_network_run_gatt(void){
     }
 #else
     // directly move to 'outgoing adv bearer queue'
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_gatt);
-    btstack_linked_list_add_tail(&network_pdus_outgoing_adv, (btstack_linked_item_t *) network_pdu);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(&network_pdus_outgoing_gatt);
+    btstack_linked_queue_enqueue(&network_pdus_outgoing_adv, (btstack_linked_item_t *) network_pdu);
 #endif
     return false;
 }
@@ -737,7 +1116,7 @@ static bool mesh_network_run_gatt(void){
 // returns true if done
 static bool mesh_network_run_adv(void){
 
-    if (btstack_linked_list_empty(&network_pdus_outgoing_adv)){
+    if (btstack_linked_queue_empty(&network_pdus_outgoing_adv)){
         return true;
     }
     
@@ -747,7 +1126,7 @@ static bool mesh_network_run_adv(void){
     }
 
     // move to 'adv bearer queue'
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_adv);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(&network_pdus_outgoing_adv);
 
 #ifdef LOG_NETWORK
     printf("network run 4: pop %p from network_pdus_outgoing_adv\n", network_pdu);
@@ -778,7 +1157,7 @@ static bool mesh_network_run_adv(void){
     }
 #else
     // done
-    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_outgoing_adv);
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(&network_pdus_outgoing_adv);
     // directly notify upper layer
     mesh_network_send_complete(network_pdu);
 #endif
@@ -787,22 +1166,33 @@ static bool mesh_network_run_adv(void){
 
 // returns true if done
 static bool mesh_network_run_received(void){
-    if (mesh_crypto_active) {
+    if (mesh_network_validations_count == MESH_NETWORK_NUM_VALIDATIONS) {
         return true;
     }
 
-    if (btstack_linked_list_empty(&network_pdus_received)) {
+    if (btstack_linked_queue_empty(&network_pdus_received)) {
         return true;
     }
 
-    incoming_pdu_decoded = mesh_network_pdu_get();
-    if (incoming_pdu_decoded == NULL) return true;
+    // decoded pdu replaces raw pdu, don't enforce quota to avoid stalling validation
+    mesh_network_pdu_t * decoded_pdu = mesh_network_pdu_allocate(MESH_NETWORK_PDU_PURPOSE_RX, false);
+    if (decoded_pdu == NULL) return true;
 
-    // get encoded network pdu and start processing
-    mesh_crypto_active = 1;
-    incoming_pdu_raw = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_received);
-    process_network_pdu();
-    return true;
+    // get encoded network pdu and start processing in next free validation
+    uint16_t index = mesh_network_validations_head + mesh_network_validations_count;
+    if (index >= MESH_NETWORK_NUM_VALIDATIONS){
+        index -= MESH_NETWORK_NUM_VALIDATIONS;
+    }
+    mesh_network_validation_t * validation = &mesh_network_validations[index];
+    mesh_network_validations_count++;
+    MESH_STATISTICS_MAX(mesh_network_statistics.max_validations_active, mesh_network_validations_count);
+    validation->state       = MESH_NETWORK_VALIDATION_ACTIVE;
+    validation->decoded_pdu = decoded_pdu;
+    validation->raw_pdu     = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(&network_pdus_received);
+    process_network_pdu(validation);
+
+    // check if more pdus can be validated
+    return false;
 }
 
 // returns true if done
@@ -811,12 +1201,12 @@ static bool mesh_network_run_queued(void){
         return true;
     }
 
-    if (btstack_linked_list_empty(&network_pdus_queued)){
+    if (btstack_linked_queue_empty(&network_pdus_queued)){
         return true;
     }
     
     // get queued network pdu and start processing
-    outgoing_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_queued);
+    outgoing_pdu = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(&network_pdus_queued);
 
 #ifdef LOG_NETWORK
     printf("network run 5: pop %p from network_pdus_queued\n", outgoing_pdu);
@@ -848,7 +1238,11 @@ static void mesh_adv_bearer_handle_network_event(uint8_t packet_type, uint16_t c
     switch (packet_type){
         case MESH_NETWORK_PACKET:
             // check len. minimal transport PDU len = 1, 32 bit NetMIC -> 13 bytes
-            if (size < 13) break;
+            if (size < 13) {
+                MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_length);
+                break;
+            }
+            MESH_STATISTICS_INC(mesh_network_statistics.rx_adv);
 
 #ifdef LOG_NETWORK
             printf("received network pdu from adv (len %u): ", size);
@@ -878,6 +1272,7 @@ static void mesh_adv_bearer_handle_network_event(uint8_t packet_type, uint16_t c
                             printf_hexdump(adv_bearer_network_pdu->data, adv_bearer_network_pdu->len);
 #endif
 
+                            MESH_STATISTICS_INC(mesh_network_statistics.tx_adv);
                             adv_bearer_send_network_pdu(adv_bearer_network_pdu->data, adv_bearer_network_pdu->len, transmission_count, transmission_interval);
                             network_pdu = adv_bearer_network_pdu;
                             adv_bearer_network_pdu = NULL;
@@ -901,12 +1296,27 @@ static void mesh_adv_bearer_handle_network_event(uint8_t packet_type, uint16_t c
 #endif
 
 #ifdef ENABLE_MESH_GATT_BEARER
-static void mesh_network_gatt_bearer_outgoing_complete(void){
+static int mesh_network_gatt_bearer_index_for_con_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (gatt_bearer_con_handles[i] == con_handle) return i;
+    }
+    return -1;
+}
+
+static void mesh_network_gatt_bearer_outgoing_complete(int index){
 
     if (gatt_bearer_network_pdu == NULL) return;
 
+    // wait for other Proxy Clients
+    gatt_bearer_network_pdu_pending[index] = 0;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (gatt_bearer_network_pdu_pending[i] != 0) return;
+    }
+
     // forward to adv bearer
-    btstack_linked_list_add_tail(&network_pdus_outgoing_adv, (btstack_linked_item_t*) gatt_bearer_network_pdu);
+    btstack_linked_queue_enqueue(&network_pdus_outgoing_adv, (btstack_linked_item_t*) gatt_bearer_network_pdu);
     gatt_bearer_network_pdu = NULL;
 
     mesh_network_run();
@@ -914,38 +1324,64 @@ static void mesh_network_gatt_bearer_outgoing_complete(void){
 }
 
 static void mesh_network_gatt_bearer_handle_network_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-    UNUSED(channel);
+    hci_con_handle_t con_handle;
+    int index;
     switch (packet_type){
         case MESH_PROXY_DATA_PACKET:
             if (mesh_foundation_gatt_proxy_get() == 0) break;
+            MESH_STATISTICS_INC(mesh_network_statistics.rx_gatt);
 #ifdef LOG_NETWORK
             printf("received network pdu from gatt (len %u): ", size);
             printf_hexdump(packet, size);
 #endif
-            mesh_network_received_message(packet, size, MESH_NETWORK_PDU_FLAGS_GATT_BEARER);
+            // channel is the con_handle of the Proxy Client
+            mesh_network_received_message_from(packet, size, MESH_NETWORK_PDU_FLAGS_GATT_BEARER, channel);
             break;
         case HCI_EVENT_PACKET:
             switch (hci_event_packet_get_type(packet)){
                 case HCI_EVENT_MESH_META:
                     switch (hci_event_mesh_meta_get_subevent_code(packet)){
                         case MESH_SUBEVENT_PROXY_CONNECTED:
-                            gatt_bearer_con_handle = mesh_subevent_proxy_connected_get_con_handle(packet);
+                            con_handle = mesh_subevent_proxy_connected_get_con_handle(packet);
+                            if (mesh_network_gatt_bearer_index_for_con_handle(con_handle) >= 0) break;
+                            index = mesh_network_gatt_bearer_index_for_con_handle(HCI_CON_HANDLE_INVALID);
+                            if (index < 0) break;
+                            gatt_bearer_con_handles[index] = con_handle;
+                            gatt_bearer_network_pdu_pending[index] = 0;
+                            if (mesh_network_proxy_filter != NULL){
+                                (*mesh_network_proxy_filter->connected)(con_handle);
+                            }
                             break;
                         case MESH_SUBEVENT_PROXY_DISCONNECTED:
-                            gatt_bearer_con_handle = HCI_CON_HANDLE_INVALID;
-                            mesh_network_gatt_bearer_outgoing_complete();
+                            con_handle = mesh_subevent_proxy_disconnected_get_con_handle(packet);
+                            index = mesh_network_gatt_bearer_index_for_con_handle(con_handle);
+                            if (index < 0) break;
+                            gatt_bearer_con_handles[index] = HCI_CON_HANDLE_INVALID;
+                            if (mesh_network_proxy_filter != NULL){
+                                (*mesh_network_proxy_filter->disconnected)(con_handle);
+                            }
+                            if (gatt_bearer_network_pdu_pending[index] == 0) break;
+                            mesh_network_gatt_bearer_outgoing_complete(index);
                             break;
                         case MESH_SUBEVENT_CAN_SEND_NOW:
                             if (gatt_bearer_network_pdu == NULL) break;
+                            con_handle = little_endian_read_16(packet, 3);
+                            index = mesh_network_gatt_bearer_index_for_con_handle(con_handle);
+                            if (index < 0) break;
+                            if (gatt_bearer_network_pdu_pending[index] == 0) break;
 #ifdef LOG_NETWORK
-                            printf("G-TX-E-NetworkPDU (%p): ", gatt_bearer_network_pdu);
+                            printf("G-TX-E-NetworkPDU (%p) to 0x%04x: ", gatt_bearer_network_pdu, con_handle);
                             printf_hexdump(gatt_bearer_network_pdu->data, gatt_bearer_network_pdu->len);
 #endif
-                            gatt_bearer_send_network_pdu(gatt_bearer_network_pdu->data, gatt_bearer_network_pdu->len);
+                            MESH_STATISTICS_INC(mesh_network_statistics.tx_gatt);
+                            gatt_bearer_send_network_pdu(con_handle, gatt_bearer_network_pdu->data, gatt_bearer_network_pdu->len);
                             break;
 
                         case MESH_SUBEVENT_MESSAGE_SENT:
-                            mesh_network_gatt_bearer_outgoing_complete();
+                            con_handle = little_endian_read_16(packet, 3);
+                            index = mesh_network_gatt_bearer_index_for_con_handle(con_handle);
+                            if (index < 0) break;
+                            mesh_network_gatt_bearer_outgoing_complete(index);
                             break;
                         default:
                             break;
@@ -963,10 +1399,11 @@ static void mesh_network_gatt_bearer_handle_network_event(uint8_t packet_type, u
 
 #ifdef ENABLE_MESH_GATT_BEARER
 static void mesh_netework_gatt_bearer_handle_proxy_configuration(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-    UNUSED(channel);
     switch (packet_type){
         case MESH_PROXY_DATA_PACKET:
-            mesh_network_process_proxy_configuration_message(packet, size);
+            MESH_STATISTICS_INC(mesh_network_statistics.rx_proxy_configuration);
+            // channel is the con_handle of the Proxy Client
+            mesh_network_process_proxy_configuration_message(channel, packet, size);
             break;
         case HCI_EVENT_PACKET:
             switch (hci_event_packet_get_type(packet)){
@@ -976,6 +1413,10 @@ static void mesh_netework_gatt_bearer_handle_proxy_configuration(uint8_t packet_
                             // forward to higher layer
                             (*mesh_network_proxy_message_handler)(MESH_NETWORK_CAN_SEND_NOW, NULL);
                             break;
+                        case MESH_SUBEVENT_MESSAGE_SENT:
+                            // forward to higher layer
+                            (*mesh_network_proxy_message_handler)(MESH_NETWORK_PDU_SENT, NULL);
+                            break;
                         default:
                             break;
                     }
@@ -995,7 +1436,10 @@ void mesh_network_init(void){
     adv_bearer_register_for_network_pdu(&mesh_adv_bearer_handle_network_event);
 #endif
 #ifdef ENABLE_MESH_GATT_BEARER
-    gatt_bearer_con_handle = HCI_CON_HANDLE_INVALID;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        gatt_bearer_con_handles[i] = HCI_CON_HANDLE_INVALID;
+    }
     gatt_bearer_register_for_network_pdu(&mesh_network_gatt_bearer_handle_network_event);
     gatt_bearer_register_for_mesh_proxy_configuration(&mesh_netework_gatt_bearer_handle_proxy_configuration);
 #endif
@@ -1009,40 +1453,72 @@ void mesh_network_set_proxy_message_handler(void (*packet_handler)(mesh_network_
     mesh_network_proxy_message_handler = packet_handler;
 }
 
-void mesh_network_received_message(const uint8_t * pdu_data, uint8_t pdu_len, uint8_t flags){
+void mesh_network_set_proxy_filter(const mesh_network_proxy_filter_t * proxy_filter){
+#ifdef ENABLE_MESH_GATT_BEARER
+    mesh_network_proxy_filter = proxy_filter;
+#else
+    UNUSED(proxy_filter);
+#endif
+}
+
+static void mesh_network_received_message_from(const uint8_t * pdu_data, uint8_t pdu_len, uint8_t flags, hci_con_handle_t con_handle){
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_MESH_NETWORK_RX, 0, pdu_len);
+
     // verify len
-    if (pdu_len > 29) return;
+    if (pdu_len > 29) {
+        MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_length);
+        return;
+    }
 
     // allocate network_pdu
-    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get();
-    if (!network_pdu) return;
+    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get_for_purpose(MESH_NETWORK_PDU_PURPOSE_RX);
+    if (!network_pdu) {
+        MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_no_buffer);
+        return;
+    }
+    MESH_STATISTICS_TIMESTAMP(network_pdu->timestamp_ms);
 
     // store data
     (void)memcpy(network_pdu->data, pdu_data, pdu_len);
     network_pdu->len = pdu_len;
     network_pdu->flags = flags;
+    network_pdu->con_handle = con_handle;
 
     // add to list and go
-    btstack_linked_list_add_tail(&network_pdus_received, (btstack_linked_item_t *) network_pdu);
+    btstack_linked_queue_enqueue(&network_pdus_received, (btstack_linked_item_t *) network_pdu);
+    MESH_STATISTICS_MAX(mesh_network_statistics.max_received_queued, btstack_linked_list_count(&network_pdus_received.head));
     mesh_network_run();
 
 }
 
-void mesh_network_process_proxy_configuration_message(const uint8_t * pdu_data, uint8_t pdu_len){
+void mesh_network_received_message(const uint8_t * pdu_data, uint8_t pdu_len, uint8_t flags){
+    mesh_network_received_message_from(pdu_data, pdu_len, flags, HCI_CON_HANDLE_INVALID);
+}
+
+void mesh_network_process_proxy_configuration_message(uint16_t con_handle, const uint8_t * pdu_data, uint8_t pdu_len){
     // verify len
-    if (pdu_len > 29) return;
+    if (pdu_len > 29) {
+        MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_length);
+        return;
+    }
 
     // allocate network_pdu
-    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get();
-    if (!network_pdu) return;
+    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get_for_purpose(MESH_NETWORK_PDU_PURPOSE_RX);
+    if (!network_pdu) {
+        MESH_STATISTICS_INC(mesh_network_statistics.rx_dropped_no_buffer);
+        return;
+    }
+    MESH_STATISTICS_TIMESTAMP(network_pdu->timestamp_ms);
 
     // store data
     (void)memcpy(network_pdu->data, pdu_data, pdu_len);
     network_pdu->len = pdu_len;
     network_pdu->flags = MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION; // Network PDU
+    network_pdu->con_handle = con_handle;
 
     // add to list and go
-    btstack_linked_list_add_tail(&network_pdus_received, (btstack_linked_item_t *) network_pdu);
+    btstack_linked_queue_enqueue(&network_pdus_received, (btstack_linked_item_t *) network_pdu);
+    MESH_STATISTICS_MAX(mesh_network_statistics.max_received_queued, btstack_linked_list_count(&network_pdus_received.head));
     mesh_network_run();
 }
 
@@ -1056,12 +1532,19 @@ void mesh_network_send_pdu(mesh_network_pdu_t * network_pdu){
     btstack_assert((network_pdu->len + (network_pdu->data[1] & 0x80 ? 8 : 4)) <= 29);
     btstack_assert(network_pdu->len >= 9);
 
+    BTSTACK_TRACE(BTSTACK_TRACE_POINT_MESH_NETWORK_TX, 0, network_pdu->len);
+
     // setup callback
     network_pdu->callback = &mesh_network_send_d;
     network_pdu->flags    = 0;
+    network_pdu->con_handle = HCI_CON_HANDLE_INVALID;
+
+    MESH_STATISTICS_INC(mesh_network_statistics.tx_local);
+    MESH_STATISTICS_TIMESTAMP(network_pdu->timestamp_ms);
 
     // queue up
-    btstack_linked_list_add_tail(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    btstack_linked_queue_enqueue(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    MESH_STATISTICS_MAX(mesh_network_statistics.max_outgoing_queued, btstack_linked_list_count(&network_pdus_queued.head));
 #ifdef LOG_NETWORK
     mesh_network_dump_network_pdus("network_pdus_queued", &network_pdus_queued);
 #endif
@@ -1079,7 +1562,7 @@ void mesh_network_encrypt_proxy_configuration_message(mesh_network_pdu_t * netwo
     network_pdu->flags    = MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION;
 
     // queue up
-    btstack_linked_list_add_tail(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
+    btstack_linked_queue_enqueue(&network_pdus_queued, (btstack_linked_item_t *) network_pdu);
 
     // go
     mesh_network_run();
@@ -1094,7 +1577,10 @@ void mesh_network_encrypt_proxy_configuration_message(mesh_network_pdu_t * netwo
  * @param dest
  */
 void mesh_network_setup_pdu(mesh_network_pdu_t * network_pdu, uint16_t netkey_index, uint8_t nid, uint8_t ctl, uint8_t ttl, uint32_t seq, uint16_t src, uint16_t dest, const uint8_t * transport_pdu_data, uint8_t transport_pdu_len){
+    // keep allocation purpose for accounting in mesh_network_pdu_free
+    uint8_t purpose = network_pdu->purpose;
     memset(network_pdu, 0, sizeof(mesh_network_pdu_t));
+    network_pdu->purpose = purpose;
     // set netkey_index
     network_pdu->netkey_index = netkey_index;
     // setup header
@@ -1173,19 +1659,19 @@ static void mesh_network_dump_network_pdu(mesh_network_pdu_t * network_pdu){
         printf("- %p: ", network_pdu); printf_hexdump(network_pdu->data, network_pdu->len);
     }
 }
-static void mesh_network_dump_network_pdus(const char * name, btstack_linked_list_t * list){
+static void mesh_network_dump_network_pdus(const char * name, btstack_linked_queue_t * queue){
     printf("List: %s:\n", name);
     btstack_linked_list_iterator_t it;
-    btstack_linked_list_iterator_init(&it, list);
+    btstack_linked_list_iterator_init(&it, &queue->head);
     while (btstack_linked_list_iterator_has_next(&it)){
         mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t*) btstack_linked_list_iterator_next(&it);
         mesh_network_dump_network_pdu(network_pdu);
     }
 }
-static void mesh_network_reset_network_pdus(btstack_linked_list_t * list){
-    while (!btstack_linked_list_empty(list)){
-        mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(list);
-        btstack_memory_mesh_network_pdu_free(pdu);
+static void mesh_network_reset_network_pdus(btstack_linked_queue_t * queue){
+    while (!btstack_linked_queue_empty(queue)){
+        mesh_network_pdu_t * pdu = (mesh_network_pdu_t *) btstack_linked_queue_dequeue(queue);
+        mesh_network_pdu_free(pdu);
     }
 }
 void mesh_network_dump(void){
@@ -1195,8 +1681,12 @@ void mesh_network_dump(void){
     mesh_network_dump_network_pdus("network_pdus_outgoing_adv", &network_pdus_outgoing_adv);
     printf("outgoing_pdu: \n");
     mesh_network_dump_network_pdu(outgoing_pdu);
-    printf("incoming_pdu_raw: \n");
-    mesh_network_dump_network_pdu(incoming_pdu_raw);
+    uint8_t i;
+    for (i=0;i<MESH_NETWORK_NUM_VALIDATIONS;i++){
+        if (mesh_network_validations[i].state == MESH_NETWORK_VALIDATION_IDLE) continue;
+        printf("validation %u raw pdu: \n", i);
+        mesh_network_dump_network_pdu(mesh_network_validations[i].raw_pdu);
+    }
 #ifdef ENABLE_MESH_GATT_BEARER
     printf("gatt_bearer_network_pdu: \n");
     mesh_network_dump_network_pdu(gatt_bearer_network_pdu);
@@ -1222,34 +1712,94 @@ void mesh_network_reset(void){
 #endif
 #ifdef ENABLE_MESH_GATT_BEARER
     gatt_bearer_network_pdu = NULL;
+    memset(gatt_bearer_network_pdu_pending, 0, sizeof(gatt_bearer_network_pdu_pending));
 #endif
     outgoing_pdu = NULL;
     
-    if (incoming_pdu_raw){
-        mesh_network_pdu_free(incoming_pdu_raw);
-        incoming_pdu_raw = NULL;
-    }
-    if (incoming_pdu_decoded){
-        mesh_network_pdu_free(incoming_pdu_decoded);
-        incoming_pdu_decoded = NULL;
+    uint8_t i;
+    for (i=0;i<MESH_NETWORK_NUM_VALIDATIONS;i++){
+        mesh_network_validation_t * validation = &mesh_network_validations[i];
+        if (validation->raw_pdu){
+            mesh_network_pdu_free(validation->raw_pdu);
+            validation->raw_pdu = NULL;
+        }
+        if (validation->decoded_pdu){
+            mesh_network_pdu_free(validation->decoded_pdu);
+            validation->decoded_pdu = NULL;
+        }
+        validation->state = MESH_NETWORK_VALIDATION_IDLE;
     }
+    mesh_network_validations_head  = 0;
+    mesh_network_validations_count = 0;
     mesh_crypto_active = 0;
+
+    // forget received network pdus
+    memset(mesh_network_cache_table, 0, sizeof(mesh_network_cache_table));
+    mesh_network_cache_num_entries = 0;
 }
 
 // buffer pool
-mesh_network_pdu_t * mesh_network_pdu_get(void){
-    mesh_network_pdu_t * network_pdu = btstack_memory_mesh_network_pdu_get();
-    if (network_pdu) {
-        memset(network_pdu, 0, sizeof(mesh_network_pdu_t));
-        network_pdu->pdu_header.pdu_type = MESH_PDU_TYPE_NETWORK;
+bool mesh_network_pdu_congested(mesh_network_pdu_purpose_t purpose){
+    return mesh_network_pdu_stats.in_use[purpose] >= mesh_network_pdu_quota[purpose];
+}
+
+static mesh_network_pdu_t * mesh_network_pdu_allocate(mesh_network_pdu_purpose_t purpose, bool enforce_quota){
+    mesh_network_pdu_t * network_pdu = NULL;
+    if ((enforce_quota == false) || (mesh_network_pdu_congested(purpose) == false)){
+        network_pdu = btstack_memory_mesh_network_pdu_get();
     }
+    if (network_pdu == NULL){
+        mesh_network_pdu_stats.alloc_failed[purpose]++;
+        return NULL;
+    }
+    memset(network_pdu, 0, sizeof(mesh_network_pdu_t));
+    network_pdu->pdu_header.pdu_type = MESH_PDU_TYPE_NETWORK;
+    network_pdu->purpose = (uint8_t) purpose;
+    mesh_network_pdu_stats.in_use[purpose]++;
     return network_pdu;
 }
 
+mesh_network_pdu_t * mesh_network_pdu_get_for_purpose(mesh_network_pdu_purpose_t purpose){
+    return mesh_network_pdu_allocate(purpose, true);
+}
+
+mesh_network_pdu_t * mesh_network_pdu_get(void){
+    return mesh_network_pdu_get_for_purpose(MESH_NETWORK_PDU_PURPOSE_LOCAL);
+}
+
+bool mesh_network_pdu_set_purpose(mesh_network_pdu_t * network_pdu, mesh_network_pdu_purpose_t purpose){
+    if (network_pdu->purpose == (uint8_t) purpose) return true;
+    if (mesh_network_pdu_congested(purpose)) return false;
+    if (mesh_network_pdu_stats.in_use[network_pdu->purpose] > 0){
+        mesh_network_pdu_stats.in_use[network_pdu->purpose]--;
+    }
+    network_pdu->purpose = (uint8_t) purpose;
+    mesh_network_pdu_stats.in_use[purpose]++;
+    return true;
+}
+
 void mesh_network_pdu_free(mesh_network_pdu_t * network_pdu){
+    // pdus not allocated via mesh_network_pdu_get have purpose local and might not be accounted for
+    if ((network_pdu->purpose < MESH_NETWORK_PDU_PURPOSE_NUM) && (mesh_network_pdu_stats.in_use[network_pdu->purpose] > 0)){
+        mesh_network_pdu_stats.in_use[network_pdu->purpose]--;
+    }
     btstack_memory_mesh_network_pdu_free(network_pdu);
 }
 
+const mesh_network_pdu_stats_t * mesh_network_pdu_get_stats(void){
+    return &mesh_network_pdu_stats;
+}
+
+#ifdef ENABLE_MESH_STATISTICS
+const mesh_network_statistics_t * mesh_network_get_statistics(void){
+    return &mesh_network_statistics;
+}
+
+void mesh_network_reset_statistics(void){
+    memset(&mesh_network_statistics, 0, sizeof(mesh_network_statistics));
+}
+#endif
+
 // Mesh Subnet Management
 
 void mesh_subnet_add(mesh_subnet_t * subnet){
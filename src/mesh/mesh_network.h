@@ -43,6 +43,7 @@
 
 #include "mesh/provisioning.h"
 #include "mesh/mesh_keys.h"
+#include "mesh/mesh_statistics.h"
 
 #if defined __cplusplus
 extern "C" {
@@ -87,6 +88,60 @@ typedef struct mesh_pdu {
 #define MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION 1
 #define MESH_NETWORK_PDU_FLAGS_GATT_BEARER         2
 #define MESH_NETWORK_PDU_FLAGS_RELAY               4
+#define MESH_NETWORK_PDU_FLAGS_FRIENDSHIP_CREDENTIALS 8
+
+// purpose of allocated network pdu, used for per-purpose quotas and statistics
+typedef enum {
+    MESH_NETWORK_PDU_PURPOSE_LOCAL = 0,
+    MESH_NETWORK_PDU_PURPOSE_RX,
+    MESH_NETWORK_PDU_PURPOSE_RELAY,
+    MESH_NETWORK_PDU_PURPOSE_PROXY,
+    MESH_NETWORK_PDU_PURPOSE_FRIEND,
+    MESH_NETWORK_PDU_PURPOSE_NUM,
+} mesh_network_pdu_purpose_t;
+
+typedef struct {
+    // currently allocated network pdus
+    uint16_t in_use[MESH_NETWORK_PDU_PURPOSE_NUM];
+    // allocations rejected by quota or empty pool
+    uint32_t alloc_failed[MESH_NETWORK_PDU_PURPOSE_NUM];
+    // received network pdus not relayed as relay quota was reached
+    uint32_t relay_dropped;
+} mesh_network_pdu_stats_t;
+
+// network layer statistics, updated with ENABLE_MESH_STATISTICS
+typedef struct {
+    // received network pdus by bearer
+    uint32_t rx_adv;
+    uint32_t rx_gatt;
+    uint32_t rx_proxy_configuration;
+    // validated network pdus forwarded to lower transport
+    uint32_t rx_delivered;
+    // received network pdus dropped
+    uint32_t rx_dropped_length;
+    uint32_t rx_dropped_no_buffer;
+    uint32_t rx_dropped_no_network_key;
+    uint32_t rx_dropped_invalid_address;
+    // network cache hits, before decryption and after decryption
+    uint32_t cache_hits_obfuscated;
+    uint32_t cache_hits;
+    // sent network pdus by origin and bearer
+    uint32_t tx_local;
+    uint32_t tx_relay;
+    uint32_t tx_gatt;
+    uint32_t tx_adv;
+    // crypto operations started for network pdus, rx and tx
+    uint32_t aes128_operations;
+    uint32_t ccm_operations;
+    // queue high-water marks
+    uint16_t max_received_queued;
+    uint16_t max_validations_active;
+    uint16_t max_outgoing_queued;
+    // reception to delivery to lower transport
+    mesh_statistics_latency_t rx_latency;
+    // queued for sending to sent via all bearers, includes relay queueing
+    mesh_statistics_latency_t tx_latency;
+} mesh_network_statistics_t;
 
 typedef struct mesh_network_pdu {
     mesh_pdu_t pdu_header;
@@ -100,12 +155,33 @@ typedef struct mesh_network_pdu {
     uint16_t              appkey_index;
     // MESH_NETWORK_PDU_FLAGS
     uint16_t              flags;
+    // mesh_network_pdu_purpose_t
+    uint8_t               purpose;
+    // GATT bearer: Proxy Client the PDU was received from or, for proxy configuration messages, is sent to
+    uint16_t              con_handle;
+    // plaintext DST for Proxy Filter, set before encryption
+    uint16_t              dst;
+#ifdef ENABLE_MESH_STATISTICS
+    // time of reception or of queueing for transmission
+    uint32_t              timestamp_ms;
+#endif
 
     // pdu
     uint16_t              len;
     uint8_t               data[MESH_NETWORK_PAYLOAD_MAX];
 } mesh_network_pdu_t;
 
+typedef struct {
+    // Proxy Client connected
+    void (*connected)(uint16_t con_handle);
+    // Proxy Client disconnected
+    void (*disconnected)(uint16_t con_handle);
+    // Network PDU with SRC received from Proxy Client
+    void (*received)(uint16_t con_handle, uint16_t src);
+    // return true if Network PDU with DST should be sent to Proxy Client
+    bool (*accepts)(uint16_t con_handle, uint16_t dst);
+} mesh_network_proxy_filter_t;
+
 #define MESH_TRANSPORT_FLAG_SEQ_RESERVED    1
 
 typedef struct {
@@ -137,6 +213,10 @@ typedef struct {
     uint8_t               message_complete;
     // seq_zero for segmented messages
     uint16_t              seq_zero;
+#ifdef ENABLE_MESH_STATISTICS
+    // time of first received segment or of queueing for transmission
+    uint32_t              timestamp_ms;
+#endif
     // pdu
     uint16_t              len;
     uint8_t               data[MESH_ACCESS_PAYLOAD_MAX];
@@ -213,6 +293,13 @@ void mesh_network_set_higher_layer_handler(void (*packet_handler)(mesh_network_c
  */
 void mesh_network_set_proxy_message_handler(void (*packet_handler)(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu));
 
+/**
+ * @brief Set Proxy Filter used to select Proxy Clients for outgoing Network PDUs
+ * @note without filter, Network PDUs are sent to all Proxy Clients
+ * @param proxy_filter
+ */
+void mesh_network_set_proxy_filter(const mesh_network_proxy_filter_t * proxy_filter);
+
 /**
  * @brief Mark packet as processed
  * @param newtork_pdu received via call packet_handler
@@ -371,6 +458,47 @@ mesh_network_key_t * mesh_subnet_get_outgoing_network_key(mesh_subnet_t * subnet
 mesh_network_pdu_t * mesh_network_pdu_get(void);
 void mesh_network_pdu_free(mesh_network_pdu_t * network_pdu);
 
+/**
+ * @brief Get network pdu for given purpose, fails if quota for purpose is reached
+ * @param purpose
+ * @return network_pdu or NULL
+ */
+mesh_network_pdu_t * mesh_network_pdu_get_for_purpose(mesh_network_pdu_purpose_t purpose);
+
+/**
+ * @brief Account network pdu for different purpose, e.g. received pdu that gets relayed
+ * @param network_pdu
+ * @param purpose
+ * @return true if quota for new purpose allowed change
+ */
+bool mesh_network_pdu_set_purpose(mesh_network_pdu_t * network_pdu, mesh_network_pdu_purpose_t purpose);
+
+/**
+ * @brief Check if quota for purpose is reached, i.e. next allocation would fail
+ * @param purpose
+ * @return true if congested
+ */
+bool mesh_network_pdu_congested(mesh_network_pdu_purpose_t purpose);
+
+/**
+ * @brief Get network pdu allocation statistics
+ * @return stats
+ */
+const mesh_network_pdu_stats_t * mesh_network_pdu_get_stats(void);
+
+#ifdef ENABLE_MESH_STATISTICS
+/**
+ * @brief Get network layer statistics
+ * @return statistics
+ */
+const mesh_network_statistics_t * mesh_network_get_statistics(void);
+
+/**
+ * @brief Reset network layer statistics
+ */
+void mesh_network_reset_statistics(void);
+#endif
+
 // Mesh Network PDU Getter
 uint16_t  mesh_network_control(mesh_network_pdu_t * network_pdu);
 uint8_t   mesh_network_nid(mesh_network_pdu_t * network_pdu);
@@ -388,7 +516,7 @@ void mesh_network_pdu_set_seq(mesh_network_pdu_t * network_pdu, uint32_t seq);
 
 // Testing only
 void mesh_network_received_message(const uint8_t * pdu_data, uint8_t pdu_len, uint8_t flags);
-void mesh_network_process_proxy_configuration_message(const uint8_t * pdu_data, uint8_t pdu_len);
+void mesh_network_process_proxy_configuration_message(uint16_t con_handle, const uint8_t * pdu_data, uint8_t pdu_len);
 void mesh_network_encrypt_proxy_configuration_message(mesh_network_pdu_t * network_pdu, void (* callback)(mesh_network_pdu_t * callback));
 void mesh_network_dump(void);
 void mesh_network_reset(void);
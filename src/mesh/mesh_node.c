@@ -38,7 +38,9 @@
 #define BTSTACK_FILE__ "mesh_node.c"
 
 #include "bluetooth_company_id.h"
+#include "btstack_debug.h"
 #include "mesh/mesh_foundation.h"
+#include "mesh/mesh_virtual_addresses.h"
 
 #include "mesh/mesh_node.h"
 
@@ -55,6 +57,31 @@ static btstack_linked_list_t mesh_elements;
 
 static uint16_t mid_counter;
 
+// number of model operations indexed by opcode, access layer searches all models if exceeded
+#ifndef MESH_NODE_OPCODE_INDEX_SIZE
+#define MESH_NODE_OPCODE_INDEX_SIZE 128
+#endif
+
+// sorted by opcode, then by mid
+static mesh_model_operation_t mesh_node_opcode_index[MESH_NODE_OPCODE_INDEX_SIZE];
+static uint16_t mesh_node_opcode_index_count;
+static int      mesh_node_opcode_index_overflow;
+
+// number of different group addresses and virtual addresses in all model subscription lists, filter is disabled if exceeded
+#ifndef MESH_NODE_SUBSCRIPTION_TABLE_SIZE
+#define MESH_NODE_SUBSCRIPTION_TABLE_SIZE 16
+#endif
+
+typedef struct {
+    uint16_t address;
+    uint16_t ref_count;
+} mesh_node_subscription_t;
+
+// open addressing with linear probing, address MESH_ADDRESS_UNSASSIGNED marks free slot
+static mesh_node_subscription_t mesh_node_subscriptions[MESH_NODE_SUBSCRIPTION_TABLE_SIZE];
+static int mesh_node_subscription_overflow;
+static int mesh_node_subscription_filter_enabled;
+
 static uint8_t mesh_node_device_uuid[16];
 static int     mesh_node_have_device_uuid;
 
@@ -189,6 +216,73 @@ void mesh_model_reset_appkeys(mesh_model_t * mesh_model){
     }
 }
 
+// returns index of first entry with opcode > given opcode
+static uint16_t mesh_node_opcode_index_upper_bound(uint32_t opcode){
+    uint16_t low  = 0;
+    uint16_t high = mesh_node_opcode_index_count;
+    while (low < high){
+        uint16_t mid = (low + high) / 2;
+        if (mesh_node_opcode_index[mid].operation->opcode <= opcode){
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// returns index of first entry with opcode >= given opcode
+static uint16_t mesh_node_opcode_index_lower_bound(uint32_t opcode){
+    uint16_t low  = 0;
+    uint16_t high = mesh_node_opcode_index_count;
+    while (low < high){
+        uint16_t mid = (low + high) / 2;
+        if (mesh_node_opcode_index[mid].operation->opcode < opcode){
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void mesh_node_opcode_index_add_model(mesh_model_t * mesh_model){
+    const mesh_operation_t * operation = mesh_model->operations;
+    if (operation == NULL) return;
+    for ( ; operation->handler != NULL ; operation++){
+        if (mesh_node_opcode_index_count >= MESH_NODE_OPCODE_INDEX_SIZE){
+            log_error("opcode index full, increase MESH_NODE_OPCODE_INDEX_SIZE");
+            mesh_node_opcode_index_overflow = 1;
+            return;
+        }
+        // models are added in mid order, insert after existing entries for same opcode
+        uint16_t pos = mesh_node_opcode_index_upper_bound(operation->opcode);
+        memmove(&mesh_node_opcode_index[pos + 1], &mesh_node_opcode_index[pos],
+                (mesh_node_opcode_index_count - pos) * sizeof(mesh_model_operation_t));
+        mesh_node_opcode_index[pos].model     = mesh_model;
+        mesh_node_opcode_index[pos].operation = operation;
+        mesh_node_opcode_index_count++;
+    }
+}
+
+int mesh_node_opcode_index_complete(void){
+    return mesh_node_opcode_index_overflow == 0;
+}
+
+void mesh_model_operation_iterator_init(mesh_model_operation_iterator_t * iterator, uint32_t opcode){
+    iterator->opcode = opcode;
+    iterator->index  = mesh_node_opcode_index_lower_bound(opcode);
+}
+
+int mesh_model_operation_iterator_has_next(mesh_model_operation_iterator_t * iterator){
+    if (iterator->index >= mesh_node_opcode_index_count) return 0;
+    return mesh_node_opcode_index[iterator->index].operation->opcode == iterator->opcode;
+}
+
+const mesh_model_operation_t * mesh_model_operation_iterator_next(mesh_model_operation_iterator_t * iterator){
+    return &mesh_node_opcode_index[iterator->index++];
+}
+
 void mesh_element_add_model(mesh_element_t * element, mesh_model_t * mesh_model){
     // reset app keys
     mesh_model_reset_appkeys(mesh_model);
@@ -201,6 +295,7 @@ void mesh_element_add_model(mesh_element_t * element, mesh_model_t * mesh_model)
     mesh_model->mid = mid_counter++;
     mesh_model->element = element;
     btstack_linked_list_add_tail(&element->models, (btstack_linked_item_t *) mesh_model);
+    mesh_node_opcode_index_add_model(mesh_model);
 }
 
 void mesh_model_iterator_init(mesh_model_iterator_t * iterator, mesh_element_t * element){
@@ -249,6 +344,108 @@ int mesh_model_contains_subscription(mesh_model_t * mesh_model, uint16_t address
     return 0;
 }
 
+// Mesh Node Subscription Filter
+static uint16_t mesh_node_subscription_home_slot(uint16_t address){
+    return (uint16_t)(((uint32_t) address * 2654435761u) % MESH_NODE_SUBSCRIPTION_TABLE_SIZE);
+}
+
+static uint16_t mesh_node_subscription_next_slot(uint16_t slot){
+    slot++;
+    if (slot == MESH_NODE_SUBSCRIPTION_TABLE_SIZE){
+        slot = 0;
+    }
+    return slot;
+}
+
+static mesh_node_subscription_t * mesh_node_subscription_find(uint16_t address){
+    uint16_t slot = mesh_node_subscription_home_slot(address);
+    uint16_t i;
+    for (i=0;i<MESH_NODE_SUBSCRIPTION_TABLE_SIZE;i++){
+        mesh_node_subscription_t * entry = &mesh_node_subscriptions[slot];
+        if (entry->address == address) return entry;
+        if (entry->address == MESH_ADDRESS_UNSASSIGNED) return NULL;
+        slot = mesh_node_subscription_next_slot(slot);
+    }
+    return NULL;
+}
+
+void mesh_node_subscription_add(uint16_t address){
+    if (address == MESH_ADDRESS_UNSASSIGNED) return;
+    mesh_node_subscription_t * entry = mesh_node_subscription_find(address);
+    if (entry != NULL){
+        entry->ref_count++;
+        return;
+    }
+    uint16_t slot = mesh_node_subscription_home_slot(address);
+    uint16_t i;
+    for (i=0;i<MESH_NODE_SUBSCRIPTION_TABLE_SIZE;i++){
+        entry = &mesh_node_subscriptions[slot];
+        if (entry->address == MESH_ADDRESS_UNSASSIGNED){
+            entry->address   = address;
+            entry->ref_count = 1;
+            return;
+        }
+        slot = mesh_node_subscription_next_slot(slot);
+    }
+    log_error("subscription table full, increase MESH_NODE_SUBSCRIPTION_TABLE_SIZE");
+    mesh_node_subscription_overflow = 1;
+}
+
+void mesh_node_subscription_remove(uint16_t address){
+    if (address == MESH_ADDRESS_UNSASSIGNED) return;
+    mesh_node_subscription_t * entry = mesh_node_subscription_find(address);
+    if (entry == NULL) return;
+    entry->ref_count--;
+    if (entry->ref_count > 0) return;
+
+    // backward shift deletion keeps probe sequences intact
+    uint16_t hole = (uint16_t) (entry - mesh_node_subscriptions);
+    uint16_t slot = mesh_node_subscription_next_slot(hole);
+    while (mesh_node_subscriptions[slot].address != MESH_ADDRESS_UNSASSIGNED){
+        uint16_t home = mesh_node_subscription_home_slot(mesh_node_subscriptions[slot].address);
+        // move entry into hole unless its home slot lies cyclically in (hole, slot]
+        int stays;
+        if (hole <= slot){
+            stays = (home > hole) && (home <= slot);
+        } else {
+            stays = (home > hole) || (home <= slot);
+        }
+        if (!stays){
+            mesh_node_subscriptions[hole] = mesh_node_subscriptions[slot];
+            hole = slot;
+        }
+        slot = mesh_node_subscription_next_slot(slot);
+    }
+    mesh_node_subscriptions[hole].address   = MESH_ADDRESS_UNSASSIGNED;
+    mesh_node_subscriptions[hole].ref_count = 0;
+}
+
+void mesh_node_subscription_filter_enable(int enabled){
+    mesh_node_subscription_filter_enabled = enabled;
+}
+
+int mesh_node_subscription_filter_accepts(uint16_t dst){
+    if (mesh_node_subscription_filter_enabled == 0) return 1;
+    if (mesh_node_subscription_overflow) return 1;
+    // no dependency on mesh_network.c, checks match mesh_network_address_virtual/group
+    if ((dst & 0xC000u) == 0x8000u){
+        // dst is hash, check pseudo dst of all virtual addresses with this hash
+        mesh_virtual_address_iterator_t it;
+        mesh_virtual_address_iterator_init(&it, dst);
+        while (mesh_virtual_address_iterator_has_more(&it)){
+            const mesh_virtual_address_t * virtual_address = mesh_virtual_address_iterator_get_next(&it);
+            if (mesh_node_subscription_find(virtual_address->pseudo_dst) != NULL) return 1;
+        }
+        return 0;
+    }
+    if ((dst & 0xC000u) == 0xC000u){
+        // fixed group addresses are handled by access layer
+        if (dst >= 0xff00u) return 1;
+        return mesh_node_subscription_find(dst) != NULL;
+    }
+    return 1;
+}
+
 void mesh_node_set_device_uuid(const uint8_t * device_uuid){
     (void)memcpy(mesh_node_device_uuid, device_uuid, 16);
     mesh_node_have_device_uuid = 1;
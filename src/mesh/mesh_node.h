@@ -149,6 +149,9 @@ typedef struct mesh_model {
 
     // packet handler for transition events in server, event callback handler in client
     btstack_packet_handler_t model_packet_handler;
+
+    // model state modified but not written to TLV yet
+    uint8_t storage_pending;
 } mesh_model_t;
 
 typedef struct {
@@ -176,6 +179,16 @@ typedef struct {
     btstack_linked_list_iterator_t it;
 } mesh_element_iterator_t;
 
+typedef struct {
+    mesh_model_t * model;
+    const mesh_operation_t * operation;
+} mesh_model_operation_t;
+
+typedef struct {
+    uint32_t opcode;
+    uint16_t index;
+} mesh_model_operation_iterator_t;
+
 
 void mesh_node_init(void);
 
@@ -247,6 +260,7 @@ uint16_t mesh_access_get_element_address(mesh_model_t * mesh_model);
 
 /**
  * @brief Add model to element
+ * @note model operations need to be set before, they are added to opcode index
  * @param element
  * @param mesh_model
  */
@@ -267,6 +281,20 @@ int mesh_model_iterator_has_next(mesh_model_iterator_t * iterator);
 
 mesh_model_t * mesh_model_iterator_next(mesh_model_iterator_t * iterator);
 
+// Mesh Model Operation Iterator over all models that handle an opcode, in order of model registration
+
+/**
+ * @brief Check if operations of all models fit into opcode index of size MESH_NODE_OPCODE_INDEX_SIZE
+ * @returns 1 if model operation iterator can be used, 0 if models need to be searched
+ */
+int mesh_node_opcode_index_complete(void);
+
+void mesh_model_operation_iterator_init(mesh_model_operation_iterator_t * iterator, uint32_t opcode);
+
+int mesh_model_operation_iterator_has_next(mesh_model_operation_iterator_t * iterator);
+
+const mesh_model_operation_t * mesh_model_operation_iterator_next(mesh_model_operation_iterator_t * iterator);
+
 // Mesh Model Utility
 
 mesh_model_t * mesh_model_get_by_identifier(mesh_element_t * element, uint32_t model_identifier);
@@ -292,6 +320,34 @@ void mesh_model_reset_appkeys(mesh_model_t * mesh_model);
 // Mesh Model Subscriptions
 int mesh_model_contains_subscription(mesh_model_t * mesh_model, uint16_t address);
 
+// Mesh Node Subscription Filter: ref counted set of group addresses and virtual address pseudo dsts used in model subscription lists
+
+/**
+ * @brief Add address to subscription set, called for each address added to a model subscription list
+ * @param address group address or pseudo dst of virtual address
+ */
+void mesh_node_subscription_add(uint16_t address);
+
+/**
+ * @brief Remove address from subscription set, called for each address removed from a model subscription list
+ * @param address group address or pseudo dst of virtual address
+ */
+void mesh_node_subscription_remove(uint16_t address);
+
+/**
+ * @brief Drop access messages to group and virtual addresses no model is subscribed to
+ * @note requires all changes to model subscription lists to be reported via mesh_node_subscription_add/remove
+ * @param enabled
+ */
+void mesh_node_subscription_filter_enable(int enabled);
+
+/**
+ * @brief Check if access message for destination address should be processed
+ * @param dst of network pdu, group address or virtual address hash
+ * @returns 0 if filter is enabled and no model is subscribed to dst
+ */
+int mesh_node_subscription_filter_accepts(uint16_t dst);
+
 /**
  * @brief Set Device UUID
  * @param device_uuid
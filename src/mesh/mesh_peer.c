@@ -41,36 +41,278 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "btstack_debug.h"
 #include "btstack_memory.h"
 #include "btstack_util.h"
 
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+#include "btstack_run_loop.h"
+#include "btstack_tlv.h"
+#endif
+
 #include "mesh/beacon.h"
 #include "mesh/mesh_upper_transport.h"
 
+// number of peers tracked by the replay protection list
+#ifndef MESH_NUM_PEERS
 #define MESH_NUM_PEERS 5
+#endif
 
-static mesh_peer_t mesh_peers[MESH_NUM_PEERS];
+#if MESH_NUM_PEERS > 0x7fff
+#error "MESH_NUM_PEERS must be less than 32768"
+#endif
 
-void mesh_seq_auth_reset(void){
-    int i;
-    for(i=0;i<MESH_NUM_PEERS;i++){
-        memset(&mesh_peers[i], 0, sizeof(mesh_peer_t));
+// delay before modified replay protection list entries are written to TLV
+#ifndef MESH_PEER_STORAGE_DELAY_MS
+#define MESH_PEER_STORAGE_DELAY_MS 1000
+#endif
+
+// hash table with load factor <= 0.5 for short probe sequences
+#define MESH_PEER_HASH_TABLE_SIZE ((2 * MESH_NUM_PEERS) + 1)
+#define MESH_PEER_ENTRY_NONE 0xffff
+
+// replay protection list entry, entries are kept in LRU order
+typedef struct {
+    mesh_peer_t peer;
+    uint16_t prev;  // more recently used entry
+    uint16_t next;  // less recently used entry
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+    uint8_t  dirty;
+#endif
+} mesh_peer_entry_t;
+
+static mesh_peer_entry_t mesh_peers[MESH_NUM_PEERS];
+// entry index + 1, 0 = free slot
+static uint16_t mesh_peers_table[MESH_PEER_HASH_TABLE_SIZE];
+static uint16_t mesh_peers_num_entries;
+static uint16_t mesh_peers_most_recent;
+static uint16_t mesh_peers_least_recent;
+
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+typedef struct {
+    uint16_t address;
+    uint32_t seq;
+} mesh_persistent_peer_t;
+
+static const btstack_tlv_t * btstack_tlv_singleton_impl;
+static void *                btstack_tlv_singleton_context;
+static btstack_timer_source_t mesh_peers_storage_timer;
+static int                    mesh_peers_storage_timer_active;
+
+static void mesh_peer_mark_dirty(uint16_t index);
+#endif
+
+static uint32_t mesh_peer_home_slot(uint16_t address){
+    // multiplicative hashing spreads consecutive unicast addresses over the table
+    return ((uint32_t) address * 2654435761u) % MESH_PEER_HASH_TABLE_SIZE;
+}
+
+static uint32_t mesh_peer_next_slot(uint32_t slot){
+    slot++;
+    if (slot == MESH_PEER_HASH_TABLE_SIZE){
+        slot = 0;
     }
+    return slot;
 }
 
-mesh_peer_t * mesh_peer_for_addr(uint16_t address){
-    int i;
-    for (i=0;i<MESH_NUM_PEERS;i++){
-        if (mesh_peers[i].address == address){
-            return &mesh_peers[i];
+// returns slot containing address, or free slot where it would be stored
+static uint32_t mesh_peer_lookup_slot(uint16_t address){
+    uint32_t slot = mesh_peer_home_slot(address);
+    while (mesh_peers_table[slot] != 0){
+        if (mesh_peers[mesh_peers_table[slot] - 1].peer.address == address) break;
+        slot = mesh_peer_next_slot(slot);
+    }
+    return slot;
+}
+
+static void mesh_peer_table_remove(uint32_t slot){
+    // backward shift deletion: move following entries of the probe sequence into the gap
+    uint32_t free_slot = slot;
+    mesh_peers_table[free_slot] = 0;
+    slot = mesh_peer_next_slot(slot);
+    while (mesh_peers_table[slot] != 0){
+        uint32_t home = mesh_peer_home_slot(mesh_peers[mesh_peers_table[slot] - 1].peer.address);
+        // entry can be moved if its home slot is not cyclically in (free_slot, slot]
+        int can_move;
+        if (free_slot <= slot){
+            can_move = (home <= free_slot) || (home > slot);
+        } else {
+            can_move = (home <= free_slot) && (home > slot);
+        }
+        if (can_move){
+            mesh_peers_table[free_slot] = mesh_peers_table[slot];
+            mesh_peers_table[slot] = 0;
+            free_slot = slot;
         }
+        slot = mesh_peer_next_slot(slot);
+    }
+}
+
+static void mesh_peer_lru_unlink(uint16_t index){
+    mesh_peer_entry_t * entry = &mesh_peers[index];
+    if (entry->prev == MESH_PEER_ENTRY_NONE){
+        mesh_peers_most_recent = entry->next;
+    } else {
+        mesh_peers[entry->prev].next = entry->next;
+    }
+    if (entry->next == MESH_PEER_ENTRY_NONE){
+        mesh_peers_least_recent = entry->prev;
+    } else {
+        mesh_peers[entry->next].prev = entry->prev;
+    }
+}
+
+static void mesh_peer_lru_add_most_recent(uint16_t index){
+    mesh_peer_entry_t * entry = &mesh_peers[index];
+    entry->prev = MESH_PEER_ENTRY_NONE;
+    entry->next = MESH_PEER_ENTRY_NONE;
+    if (mesh_peers_num_entries == 1){
+        // first entry
+        mesh_peers_least_recent = index;
+    } else {
+        entry->next = mesh_peers_most_recent;
+        mesh_peers[mesh_peers_most_recent].prev = index;
     }
-    for (i=0;i<MESH_NUM_PEERS;i++){
-        if (mesh_peers[i].address== MESH_ADDRESS_UNSASSIGNED){
-            memset(&mesh_peers[i], 0, sizeof(mesh_peer_t));
-            mesh_peers[i].address = address;
-            return &mesh_peers[i];
+    mesh_peers_most_recent = index;
+}
+
+// returns least recently used entry without ongoing segmented reception, or MESH_PEER_ENTRY_NONE
+static uint16_t mesh_peer_find_victim(void){
+    uint16_t index = mesh_peers_least_recent;
+    while (index != MESH_PEER_ENTRY_NONE){
+        if (mesh_peers[index].peer.transport_pdu == NULL) break;
+        index = mesh_peers[index].prev;
+    }
+    return index;
+}
+
+static mesh_peer_t * mesh_peer_add(uint16_t address, uint32_t slot){
+    uint16_t index;
+    if (mesh_peers_num_entries < MESH_NUM_PEERS){
+        index = mesh_peers_num_entries++;
+    } else {
+        // evict least recently used peer, replay protection for it is lost
+        index = mesh_peer_find_victim();
+        if (index == MESH_PEER_ENTRY_NONE){
+            return NULL;
         }
+        log_info("RPL full, evict peer %04x", mesh_peers[index].peer.address);
+        mesh_peer_table_remove(mesh_peer_lookup_slot(mesh_peers[index].peer.address));
+        mesh_peer_lru_unlink(index);
+        // removal might have moved the free slot for the new address
+        slot = mesh_peer_lookup_slot(address);
     }
-    return NULL;
+    memset(&mesh_peers[index].peer, 0, sizeof(mesh_peer_t));
+    mesh_peers[index].peer.address = address;
+    mesh_peers_table[slot] = index + 1;
+    mesh_peer_lru_add_most_recent(index);
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+    mesh_peer_mark_dirty(index);
+#endif
+    return &mesh_peers[index].peer;
 }
+
+void mesh_seq_auth_reset(void){
+    memset(mesh_peers, 0, sizeof(mesh_peers));
+    memset(mesh_peers_table, 0, sizeof(mesh_peers_table));
+    mesh_peers_num_entries  = 0;
+    mesh_peers_most_recent  = MESH_PEER_ENTRY_NONE;
+    mesh_peers_least_recent = MESH_PEER_ENTRY_NONE;
+}
+
+mesh_peer_t * mesh_peer_for_addr(uint16_t address){
+    if (address == MESH_ADDRESS_UNSASSIGNED) return NULL;
+    uint32_t slot = mesh_peer_lookup_slot(address);
+    if (mesh_peers_table[slot] == 0){
+        return mesh_peer_add(address, slot);
+    }
+    // mark as most recently used
+    uint16_t index = mesh_peers_table[slot] - 1;
+    if (index != mesh_peers_most_recent){
+        mesh_peer_lru_unlink(index);
+        mesh_peer_lru_add_most_recent(index);
+    }
+    return &mesh_peers[index].peer;
+}
+
+void mesh_peer_set_seq(mesh_peer_t * peer, uint32_t seq){
+    peer->seq = seq;
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+    // mesh_peer_t is the first member of mesh_peer_entry_t
+    mesh_peer_mark_dirty((uint16_t) (((mesh_peer_entry_t *) peer) - mesh_peers));
+#endif
+}
+
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+
+// one tag per replay protection list entry
+static uint32_t mesh_peer_tag_for_index(uint16_t index){
+    return ((uint32_t) 'M' << 24) | ((uint32_t) 'R' << 16) | ((uint32_t) index);
+}
+
+static void mesh_peer_storage_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    mesh_peers_storage_timer_active = 0;
+    btstack_tlv_get_instance(&btstack_tlv_singleton_impl, &btstack_tlv_singleton_context);
+    if (btstack_tlv_singleton_impl == NULL) return;
+    uint16_t index;
+    for (index = 0; index < mesh_peers_num_entries; index++){
+        if (mesh_peers[index].dirty == 0) continue;
+        mesh_peers[index].dirty = 0;
+        mesh_persistent_peer_t data;
+        data.address = mesh_peers[index].peer.address;
+        data.seq     = mesh_peers[index].peer.seq;
+        int result = btstack_tlv_singleton_impl->store_tag(btstack_tlv_singleton_context, mesh_peer_tag_for_index(index), (uint8_t *) &data, sizeof(data));
+        if (result != 0){
+            log_error("Store RPL entry %u failed", index);
+        }
+    }
+}
+
+static void mesh_peer_mark_dirty(uint16_t index){
+    mesh_peers[index].dirty = 1;
+    // batch updates of all peers into a single write after MESH_PEER_STORAGE_DELAY_MS
+    if (mesh_peers_storage_timer_active) return;
+    mesh_peers_storage_timer_active = 1;
+    btstack_run_loop_set_timer_handler(&mesh_peers_storage_timer, &mesh_peer_storage_timeout);
+    btstack_run_loop_set_timer(&mesh_peers_storage_timer, MESH_PEER_STORAGE_DELAY_MS);
+    btstack_run_loop_add_timer(&mesh_peers_storage_timer);
+}
+
+void mesh_peer_load_from_tlv(void){
+    btstack_tlv_get_instance(&btstack_tlv_singleton_impl, &btstack_tlv_singleton_context);
+    mesh_seq_auth_reset();
+    if (btstack_tlv_singleton_impl == NULL) return;
+    uint16_t index;
+    for (index = 0; index < MESH_NUM_PEERS; index++){
+        mesh_persistent_peer_t data;
+        int len = btstack_tlv_singleton_impl->get_tag(btstack_tlv_singleton_context, mesh_peer_tag_for_index(index), (uint8_t *) &data, sizeof(data));
+        // entries are stored densely, stop at first missing one
+        if (len != sizeof(data)) break;
+        if (data.address == MESH_ADDRESS_UNSASSIGNED) break;
+        uint32_t slot = mesh_peer_lookup_slot(data.address);
+        if (mesh_peers_table[slot] != 0) break;
+        mesh_peers_num_entries++;
+        mesh_peers[index].peer.address = data.address;
+        mesh_peers[index].peer.seq     = data.seq;
+        mesh_peers_table[slot] = index + 1;
+        mesh_peer_lru_add_most_recent(index);
+    }
+    log_info("RPL: loaded %u entries", mesh_peers_num_entries);
+}
+
+void mesh_peer_delete_from_tlv(void){
+    if (mesh_peers_storage_timer_active){
+        mesh_peers_storage_timer_active = 0;
+        btstack_run_loop_remove_timer(&mesh_peers_storage_timer);
+    }
+    mesh_seq_auth_reset();
+    btstack_tlv_get_instance(&btstack_tlv_singleton_impl, &btstack_tlv_singleton_context);
+    if (btstack_tlv_singleton_impl == NULL) return;
+    uint16_t index;
+    for (index = 0; index < MESH_NUM_PEERS; index++){
+        btstack_tlv_singleton_impl->delete_tag(btstack_tlv_singleton_context, mesh_peer_tag_for_index(index));
+    }
+}
+
+#endif
@@ -61,12 +61,24 @@ typedef struct {
     uint32_t block_ack;
 } mesh_peer_t;
 
-// get peer info for address
+// get peer info for address, adds new peer and evicts least recently used one if needed
+// returns NULL if all peers have an ongoing segmented reception
 mesh_peer_t * mesh_peer_for_addr(uint16_t address);
 
 // reset seq auth == replay protection
 void mesh_seq_auth_reset(void);
 
+// update last seen seq number of peer, schedules storage if ENABLE_MESH_RPL_PERSISTENCE
+void mesh_peer_set_seq(mesh_peer_t * peer, uint32_t seq);
+
+#ifdef ENABLE_MESH_RPL_PERSISTENCE
+// load replay protection list from TLV
+void mesh_peer_load_from_tlv(void);
+
+// clear replay protection list and delete it from TLV
+void mesh_peer_delete_from_tlv(void);
+#endif
+
 #if defined __cplusplus
 }
 #endif
@@ -333,73 +333,279 @@ typedef enum {
     MESH_PROXY_CONFIGURATION_FILTER_TYPE_BLACK_LIST
 } mesh_proxy_configuration_filter_type_t;
 
-static mesh_network_pdu_t * encrypted_proxy_configuration_ready_to_send;
+typedef struct {
+    hci_con_handle_t                       con_handle;
+    mesh_proxy_configuration_filter_type_t filter_type;
+    uint16_t                               filter_list_len;
+    // open addressing hash set, MESH_ADDRESS_UNSASSIGNED marks free slot
+    uint16_t                               filter_addresses[MESH_PROXY_FILTER_LIST_SIZE];
+} mesh_proxy_filter_t;
+
+// proxy filter per Proxy Client
+static mesh_proxy_filter_t mesh_proxy_filters[MESH_PROXY_NUM_CONNECTIONS];
+
+// encrypted Filter Status messages, head is sent to its Proxy Client next
+static btstack_linked_list_t mesh_proxy_configuration_messages_encrypted;
+static int mesh_proxy_configuration_message_active;
 
-// Used to answer configuration request
-static uint16_t proxy_configuration_filter_list_len;
-static mesh_proxy_configuration_filter_type_t proxy_configuration_filter_type;
 static uint16_t primary_element_address;
 
+static mesh_proxy_filter_t * mesh_proxy_filter_for_con_handle(hci_con_handle_t con_handle){
+    if (con_handle == HCI_CON_HANDLE_INVALID) return NULL;
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        if (mesh_proxy_filters[i].con_handle == con_handle) return &mesh_proxy_filters[i];
+    }
+    return NULL;
+}
+
+static void mesh_proxy_filter_clear(mesh_proxy_filter_t * filter){
+    uint16_t i;
+    for (i=0;i<MESH_PROXY_FILTER_LIST_SIZE;i++){
+        filter->filter_addresses[i] = MESH_ADDRESS_UNSASSIGNED;
+    }
+    filter->filter_list_len = 0;
+}
+
+static uint16_t mesh_proxy_filter_home_slot(uint16_t address){
+    return (uint16_t)(((uint32_t) address * 2654435761u) % MESH_PROXY_FILTER_LIST_SIZE);
+}
+
+static uint16_t mesh_proxy_filter_next_slot(uint16_t slot){
+    slot++;
+    if (slot == MESH_PROXY_FILTER_LIST_SIZE){
+        slot = 0;
+    }
+    return slot;
+}
+
+static int mesh_proxy_filter_find(const mesh_proxy_filter_t * filter, uint16_t address){
+    uint16_t slot = mesh_proxy_filter_home_slot(address);
+    uint16_t i;
+    for (i=0;i<MESH_PROXY_FILTER_LIST_SIZE;i++){
+        if (filter->filter_addresses[slot] == address) return slot;
+        if (filter->filter_addresses[slot] == MESH_ADDRESS_UNSASSIGNED) return -1;
+        slot = mesh_proxy_filter_next_slot(slot);
+    }
+    return -1;
+}
+
+static void mesh_proxy_filter_add(mesh_proxy_filter_t * filter, uint16_t address){
+    if (address == MESH_ADDRESS_UNSASSIGNED) return;
+    if (mesh_proxy_filter_find(filter, address) >= 0) return;
+    uint16_t slot = mesh_proxy_filter_home_slot(address);
+    uint16_t i;
+    for (i=0;i<MESH_PROXY_FILTER_LIST_SIZE;i++){
+        if (filter->filter_addresses[slot] == MESH_ADDRESS_UNSASSIGNED){
+            filter->filter_addresses[slot] = address;
+            filter->filter_list_len++;
+            return;
+        }
+        slot = mesh_proxy_filter_next_slot(slot);
+    }
+    log_info("proxy filter full, increase MESH_PROXY_FILTER_LIST_SIZE");
+}
+
+static void mesh_proxy_filter_remove(mesh_proxy_filter_t * filter, uint16_t address){
+    if (address == MESH_ADDRESS_UNSASSIGNED) return;
+    int found = mesh_proxy_filter_find(filter, address);
+    if (found < 0) return;
+
+    // backward shift deletion keeps probe sequences intact
+    uint16_t hole = (uint16_t) found;
+    uint16_t slot = mesh_proxy_filter_next_slot(hole);
+    while (filter->filter_addresses[slot] != MESH_ADDRESS_UNSASSIGNED){
+        uint16_t home = mesh_proxy_filter_home_slot(filter->filter_addresses[slot]);
+        // move entry into hole unless its home slot lies cyclically in (hole, slot]
+        int stays;
+        if (hole <= slot){
+            stays = (home > hole) && (home <= slot);
+        } else {
+            stays = (home > hole) || (home <= slot);
+        }
+        if (!stays){
+            filter->filter_addresses[hole] = filter->filter_addresses[slot];
+            hole = slot;
+        }
+        slot = mesh_proxy_filter_next_slot(slot);
+    }
+    filter->filter_addresses[hole] = MESH_ADDRESS_UNSASSIGNED;
+    filter->filter_list_len--;
+}
+
+static void mesh_proxy_filter_connected(uint16_t con_handle){
+    mesh_proxy_filter_t * filter = mesh_proxy_filter_for_con_handle(con_handle);
+    if (filter == NULL){
+        int i;
+        for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+            if (mesh_proxy_filters[i].con_handle != HCI_CON_HANDLE_INVALID) continue;
+            filter = &mesh_proxy_filters[i];
+            break;
+        }
+    }
+    if (filter == NULL) return;
+    // upon connection, filter is an empty white list
+    filter->con_handle  = con_handle;
+    filter->filter_type = MESH_PROXY_CONFIGURATION_FILTER_TYPE_SET_WHITE_LIST;
+    mesh_proxy_filter_clear(filter);
+}
+
+static void mesh_proxy_configuration_request_can_send_now(void){
+    if (mesh_proxy_configuration_message_active) return;
+    mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_get_first_item(&mesh_proxy_configuration_messages_encrypted);
+    if (network_pdu == NULL) return;
+    mesh_proxy_configuration_message_active = 1;
+    gatt_bearer_request_can_send_now_for_mesh_proxy_configuration(network_pdu->con_handle);
+}
+
+static void mesh_proxy_filter_disconnected(uint16_t con_handle){
+    mesh_proxy_filter_t * filter = mesh_proxy_filter_for_con_handle(con_handle);
+    if (filter == NULL) return;
+    filter->con_handle = HCI_CON_HANDLE_INVALID;
+
+    // drop pending Filter Status messages for this Proxy Client
+    mesh_network_pdu_t * head = (mesh_network_pdu_t *) btstack_linked_list_get_first_item(&mesh_proxy_configuration_messages_encrypted);
+    if ((head != NULL) && (head->con_handle == con_handle)){
+        mesh_proxy_configuration_message_active = 0;
+    }
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &mesh_proxy_configuration_messages_encrypted);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) btstack_linked_list_iterator_next(&it);
+        if (network_pdu->con_handle != con_handle) continue;
+        btstack_linked_list_iterator_remove(&it);
+        mesh_network_pdu_free(network_pdu);
+    }
+    mesh_proxy_configuration_request_can_send_now();
+}
+
+static void mesh_proxy_filter_received(uint16_t con_handle, uint16_t src){
+    mesh_proxy_filter_t * filter = mesh_proxy_filter_for_con_handle(con_handle);
+    if (filter == NULL) return;
+    // white list: add src of Proxy Client, black list: remove it
+    if (filter->filter_type == MESH_PROXY_CONFIGURATION_FILTER_TYPE_SET_WHITE_LIST){
+        mesh_proxy_filter_add(filter, src);
+    } else {
+        mesh_proxy_filter_remove(filter, src);
+    }
+}
+
+static bool mesh_proxy_filter_accepts(uint16_t con_handle, uint16_t dst){
+    const mesh_proxy_filter_t * filter = mesh_proxy_filter_for_con_handle(con_handle);
+    if (filter == NULL) return false;
+    bool listed = mesh_proxy_filter_find(filter, dst) >= 0;
+    if (filter->filter_type == MESH_PROXY_CONFIGURATION_FILTER_TYPE_SET_WHITE_LIST){
+        return listed;
+    } else {
+        return !listed;
+    }
+}
+
+static const mesh_network_proxy_filter_t mesh_proxy_filter = {
+    &mesh_proxy_filter_connected,
+    &mesh_proxy_filter_disconnected,
+    &mesh_proxy_filter_received,
+    &mesh_proxy_filter_accepts,
+};
+
 static void request_can_send_now_proxy_configuration_callback_handler(mesh_network_pdu_t * network_pdu){
-    encrypted_proxy_configuration_ready_to_send = network_pdu;
-    gatt_bearer_request_can_send_now_for_mesh_proxy_configuration();
+    // Proxy Client disconnected while encrypting
+    if (mesh_proxy_filter_for_con_handle(network_pdu->con_handle) == NULL){
+        mesh_network_pdu_free(network_pdu);
+        return;
+    }
+    btstack_linked_list_add_tail(&mesh_proxy_configuration_messages_encrypted, (btstack_linked_item_t *) network_pdu);
+    mesh_proxy_configuration_request_can_send_now();
+}
+
+static void mesh_proxy_configuration_send_filter_status(mesh_network_pdu_t * received_network_pdu, const mesh_proxy_filter_t * filter){
+    uint8_t  data[4];
+    uint8_t  ctl          = 1;
+    uint8_t  ttl          = 0;
+    uint16_t src          = primary_element_address;
+    uint16_t dest         = 0; // unassigned address
+    uint8_t  nid          = mesh_network_nid(received_network_pdu);
+    uint16_t netkey_index = received_network_pdu->netkey_index; 
+
+    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get_for_purpose(MESH_NETWORK_PDU_PURPOSE_PROXY);
+    if (network_pdu == NULL) return;
+
+    uint32_t seq = mesh_sequence_number_next();
+    int pos = 0;
+    data[pos++] = MESH_PROXY_CONFIGURATION_MESSAGE_OPCODE_FILTER_STATUS;
+    data[pos++] = filter->filter_type;
+    big_endian_store_16(data, pos, filter->filter_list_len);
+
+    mesh_network_setup_pdu(network_pdu, netkey_index, nid, ctl, ttl, seq, src, dest, data, sizeof(data));
+    network_pdu->con_handle = received_network_pdu->con_handle;
+    mesh_network_encrypt_proxy_configuration_message(network_pdu, &request_can_send_now_proxy_configuration_callback_handler);
 }
 
 static void proxy_configuration_message_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * received_network_pdu){
     mesh_proxy_configuration_message_opcode_t opcode;
-    uint8_t data[4];
+    mesh_proxy_filter_t * filter;
     mesh_network_pdu_t * network_pdu;
     uint8_t * network_pdu_data;
+    uint8_t   network_pdu_len;
+    uint8_t   pos;
 
     switch (callback_type){
         case MESH_NETWORK_PDU_RECEIVED:
-            printf("proxy_configuration_message_handler: MESH_PROXY_PDU_RECEIVED\n");
+            filter = mesh_proxy_filter_for_con_handle(received_network_pdu->con_handle);
             network_pdu_data = mesh_network_pdu_data(received_network_pdu);
+            network_pdu_len  = mesh_network_pdu_len(received_network_pdu);
+            if ((filter == NULL) || (network_pdu_len == 0)){
+                mesh_network_pdu_free(received_network_pdu);
+                break;
+            }
             opcode = network_pdu_data[0];
             switch (opcode){
-                case MESH_PROXY_CONFIGURATION_MESSAGE_OPCODE_SET_FILTER_TYPE:{
+                case MESH_PROXY_CONFIGURATION_MESSAGE_OPCODE_SET_FILTER_TYPE:
+                    if (network_pdu_len < 2) break;
                     switch (network_pdu_data[1]){
                         case MESH_PROXY_CONFIGURATION_FILTER_TYPE_SET_WHITE_LIST:
                         case MESH_PROXY_CONFIGURATION_FILTER_TYPE_BLACK_LIST:
-                            proxy_configuration_filter_type = network_pdu_data[1];
+                            // setting filter type clears the filter list
+                            filter->filter_type = network_pdu_data[1];
+                            mesh_proxy_filter_clear(filter);
+                            break;
+                        default:
                             break;
                     }
-                    
-                    uint8_t  ctl          = 1;
-                    uint8_t  ttl          = 0;
-                    uint16_t src          = primary_element_address;
-                    uint16_t dest         = 0; // unassigned address
-                    uint32_t seq          = mesh_sequence_number_next();
-                    uint8_t  nid          = mesh_network_nid(received_network_pdu);
-                    uint16_t netkey_index = received_network_pdu->netkey_index; 
-                    printf("netkey index 0x%02x\n", netkey_index);
-
-                    network_pdu = btstack_memory_mesh_network_pdu_get();
-                    int pos = 0;
-                    data[pos++] = MESH_PROXY_CONFIGURATION_MESSAGE_OPCODE_FILTER_STATUS;
-                    data[pos++] = proxy_configuration_filter_type;
-                    big_endian_store_16(data, pos, proxy_configuration_filter_list_len);
-
-                    mesh_network_setup_pdu(network_pdu, netkey_index, nid, ctl, ttl, seq, src, dest, data, sizeof(data));
-                    mesh_network_encrypt_proxy_configuration_message(network_pdu, &request_can_send_now_proxy_configuration_callback_handler);
-                    
-                    // received_network_pdu is processed
-                    btstack_memory_mesh_network_pdu_free(received_network_pdu);
+                    mesh_proxy_configuration_send_filter_status(received_network_pdu, filter);
+                    break;
+                case MESH_PROXY_CONFIGURATION_MESSAGE_OPCODE_ADD_ADDRESSES:
+                    for (pos = 1; (pos + 2) <= network_pdu_len; pos += 2){
+                        mesh_proxy_filter_add(filter, big_endian_read_16(network_pdu_data, pos));
+                    }
+                    mesh_proxy_configuration_send_filter_status(received_network_pdu, filter);
+                    break;
+                case MESH_PROXY_CONFIGURATION_MESSAGE_OPCODE_REMOVE_ADDRESSES:
+                    for (pos = 1; (pos + 2) <= network_pdu_len; pos += 2){
+                        mesh_proxy_filter_remove(filter, big_endian_read_16(network_pdu_data, pos));
+                    }
+                    mesh_proxy_configuration_send_filter_status(received_network_pdu, filter);
                     break;
-                }
                 default:
-                    printf("proxy config not implemented, opcode %d\n", opcode);
+                    log_info("proxy config not implemented, opcode %d", opcode);
                     break;
             }
+            // received_network_pdu is processed
+            mesh_network_pdu_free(received_network_pdu);
             break;
         case MESH_NETWORK_CAN_SEND_NOW:
-            printf("MESH_SUBEVENT_CAN_SEND_NOW mesh_netework_gatt_bearer_handle_proxy_configuration len %d\n", encrypted_proxy_configuration_ready_to_send->len);
-            printf_hexdump(encrypted_proxy_configuration_ready_to_send->data, encrypted_proxy_configuration_ready_to_send->len);
-            gatt_bearer_send_mesh_proxy_configuration(encrypted_proxy_configuration_ready_to_send->data, encrypted_proxy_configuration_ready_to_send->len); 
+            network_pdu = (mesh_network_pdu_t *) btstack_linked_list_get_first_item(&mesh_proxy_configuration_messages_encrypted);
+            if (network_pdu == NULL) break;
+            gatt_bearer_send_mesh_proxy_configuration(network_pdu->con_handle, network_pdu->data, network_pdu->len); 
             break;
         case MESH_NETWORK_PDU_SENT:
-            // printf("test MESH_PROXY_PDU_SENT\n");
-            // mesh_lower_transport_received_mesage(MESH_NETWORK_PDU_SENT, network_pdu);
+            // Filter Status sent, continue with next one
+            network_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&mesh_proxy_configuration_messages_encrypted);
+            if (network_pdu != NULL){
+                mesh_network_pdu_free(network_pdu);
+            }
+            mesh_proxy_configuration_message_active = 0;
+            mesh_proxy_configuration_request_can_send_now();
             break;
         default:
             break;
@@ -409,8 +615,14 @@ static void proxy_configuration_message_handler(mesh_network_callback_type_t cal
 void mesh_proxy_init(uint16_t primary_unicast_address){
     primary_element_address = primary_unicast_address;
 
+    int i;
+    for (i=0;i<MESH_PROXY_NUM_CONNECTIONS;i++){
+        mesh_proxy_filters[i].con_handle = HCI_CON_HANDLE_INVALID;
+    }
+
     // mesh proxy configuration
     mesh_network_set_proxy_message_handler(proxy_configuration_message_handler);
+    mesh_network_set_proxy_filter(&mesh_proxy_filter);
 }
 #endif
 
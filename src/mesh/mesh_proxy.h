@@ -48,6 +48,11 @@ extern "C"
 {
 #endif
 
+// number of addresses in proxy filter of each Proxy Client
+#ifndef MESH_PROXY_FILTER_LIST_SIZE
+#define MESH_PROXY_FILTER_LIST_SIZE 16
+#endif
+
 /**
  * @brief Init Mesh Proxy
  */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#ifndef __MESH_STATISTICS_H
+#define __MESH_STATISTICS_H
+
+#include <stdint.h>
+
+#include "btstack_config.h"
+#include "btstack_run_loop.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// bucket i counts latencies below 2^i ms, last bucket counts all longer ones
+#define MESH_STATISTICS_LATENCY_BUCKETS 12
+
+typedef struct {
+    uint32_t count;
+    uint32_t total_ms;
+    uint32_t max_ms;
+    uint32_t buckets[MESH_STATISTICS_LATENCY_BUCKETS];
+} mesh_statistics_latency_t;
+
+static inline void mesh_statistics_latency_add(mesh_statistics_latency_t * latency, uint32_t latency_ms){
+    uint16_t bucket = 0;
+    while ((bucket < (MESH_STATISTICS_LATENCY_BUCKETS - 1)) && (latency_ms >= (1u << bucket))){
+        bucket++;
+    }
+    latency->buckets[bucket]++;
+    latency->count++;
+    latency->total_ms += latency_ms;
+    if (latency_ms > latency->max_ms){
+        latency->max_ms = latency_ms;
+    }
+}
+
+// counters are only updated with ENABLE_MESH_STATISTICS, arguments are not evaluated otherwise
+#ifdef ENABLE_MESH_STATISTICS
+#define MESH_STATISTICS_INC(counter)                 ((counter)++)
+#define MESH_STATISTICS_MAX(counter, value)          do { uint32_t mesh_statistics_value = (value); if (mesh_statistics_value > (counter)) { (counter) = mesh_statistics_value; } } while (0)
+#define MESH_STATISTICS_LATENCY(latency, start_ms)   mesh_statistics_latency_add(&(latency), btstack_run_loop_get_time_ms() - (start_ms))
+#define MESH_STATISTICS_TIMESTAMP(timestamp_ms)      ((timestamp_ms) = btstack_run_loop_get_time_ms())
+#else
+#define MESH_STATISTICS_INC(counter)
+#define MESH_STATISTICS_MAX(counter, value)
+#define MESH_STATISTICS_LATENCY(latency, start_ms)
+#define MESH_STATISTICS_TIMESTAMP(timestamp_ms)
+#endif
+
+#ifdef __cplusplus
+} /* end of extern "C" */
+#endif
+
+#endif // __MESH_STATISTICS_H
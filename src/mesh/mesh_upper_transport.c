@@ -145,6 +145,12 @@ static uint8_t application_nonce[13];
 static btstack_crypto_ccm_t ccm;
 static mesh_transport_key_and_virtual_address_iterator_t mesh_transport_key_it;
 
+#ifdef ENABLE_MESH_STATISTICS
+static mesh_upper_transport_statistics_t mesh_upper_transport_statistics;
+// start of current decryption or encryption, only one is active at a time
+static uint32_t mesh_upper_transport_crypto_start_ms;
+#endif
+
 // upper transport callbacks - in access layer
 static void (*mesh_access_message_handler)(mesh_pdu_t * pdu);
 static void (*mesh_control_message_handler)(mesh_pdu_t * pdu);
@@ -171,7 +177,7 @@ static void mesh_upper_transport_reset_pdus(btstack_linked_list_t *list){
         mesh_pdu_t * pdu = (mesh_pdu_t *) btstack_linked_list_pop(list);
         switch (pdu->pdu_type){
             case MESH_PDU_TYPE_NETWORK:
-                btstack_memory_mesh_network_pdu_free((mesh_network_pdu_t *) pdu);
+                mesh_network_pdu_free((mesh_network_pdu_t *) pdu);
                 break;
             case MESH_PDU_TYPE_TRANSPORT:
                 btstack_memory_mesh_transport_pdu_free((mesh_transport_pdu_t *) pdu);
@@ -204,6 +210,7 @@ void mesh_upper_transport_reset(void){
 static void mesh_upper_unsegmented_control_message_received(mesh_network_pdu_t * network_pdu){
     uint8_t * lower_transport_pdu     = mesh_network_pdu_data(network_pdu);
     uint8_t  opcode = lower_transport_pdu[0];
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_control);
     if (mesh_control_message_handler){
         mesh_control_message_handler((mesh_pdu_t*) network_pdu);
     } else {
@@ -312,6 +319,9 @@ static void mesh_upper_transport_validate_unsegmented_message_ccm(void * arg){
             big_endian_store_16(incoming_network_pdu_decoded->data, 7, mesh_transport_key_it.address->pseudo_dst);
         }
 
+        MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_access);
+        MESH_STATISTICS_LATENCY(mesh_upper_transport_statistics.rx_latency, mesh_upper_transport_crypto_start_ms);
+
         // pass to upper layer
         if (mesh_access_message_handler){
             mesh_pdu_t * pdu = (mesh_pdu_t*) incoming_network_pdu_decoded;
@@ -331,6 +341,7 @@ static void mesh_upper_transport_validate_unsegmented_message_ccm(void * arg){
             mesh_upper_transport_validate_unsegmented_message();
         } else {
             printf("TransMIC does not match device key, done\n");
+            MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_decrypt_failed);
             // done
             mesh_upper_transport_process_unsegmented_message_done(incoming_network_pdu_decoded);
         }
@@ -361,6 +372,9 @@ static void mesh_upper_transport_validate_segmented_message_ccm(void * arg){
             big_endian_store_16(incoming_transport_pdu_decoded->network_header, 7, mesh_transport_key_it.address->pseudo_dst);
         }
 
+        MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_access);
+        MESH_STATISTICS_LATENCY(mesh_upper_transport_statistics.rx_latency, mesh_upper_transport_crypto_start_ms);
+
         // pass to upper layer
         if (mesh_access_message_handler){
             mesh_pdu_t * pdu = (mesh_pdu_t*) incoming_transport_pdu_decoded;
@@ -381,6 +395,7 @@ static void mesh_upper_transport_validate_segmented_message_ccm(void * arg){
             mesh_upper_transport_validate_segmented_message();
         } else {
             printf("TransMIC does not match device key, done\n");
+            MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_decrypt_failed);
             // done
             mesh_upper_transport_process_segmented_message_done(incoming_transport_pdu_decoded);
         }
@@ -423,6 +438,7 @@ static void mesh_upper_transport_validate_unsegmented_message(void){
 
     if (!mesh_transport_key_and_virtual_address_iterator_has_more(&mesh_transport_key_it)){
         printf("No valid transport key found\n");
+        MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_decrypt_failed);
         mesh_upper_transport_process_unsegmented_message_done(incoming_network_pdu_decoded);
         return;
     }
@@ -455,6 +471,7 @@ static void mesh_upper_transport_validate_unsegmented_message(void){
     if (mesh_network_address_virtual(mesh_network_dst(incoming_network_pdu_decoded))){
         aad_len  = 16;
     }
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.ccm_operations);
     btstack_crypto_ccm_init(&ccm, message_key->key, application_nonce, upper_transport_pdu_len, aad_len, trans_mic_len);
     if (aad_len){
         btstack_crypto_ccm_digest(&ccm, (uint8_t*) mesh_transport_key_it.address->label_uuid, aad_len, &mesh_upper_transport_validate_unsegmented_message_digest, NULL);
@@ -469,6 +486,7 @@ static void mesh_upper_transport_validate_segmented_message(void){
 
     if (!mesh_transport_key_and_virtual_address_iterator_has_more(&mesh_transport_key_it)){
         printf("No valid transport key found\n");
+        MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_decrypt_failed);
         mesh_upper_transport_process_segmented_message_done(incoming_transport_pdu_decoded);
         return;
     }
@@ -493,6 +511,7 @@ static void mesh_upper_transport_validate_segmented_message(void){
     if (mesh_network_address_virtual(mesh_transport_dst(incoming_transport_pdu_decoded))){
         aad_len  = 16;
     }
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.ccm_operations);
     btstack_crypto_ccm_init(&ccm, message_key->key, application_nonce, upper_transport_pdu_len, aad_len, incoming_transport_pdu_decoded->transmic_len);
 
     if (aad_len){
@@ -520,6 +539,7 @@ static void mesh_upper_transport_process_unsegmented_access_message(void){
     printf("AKF: %u\n",   akf);
     printf("AID: %02x\n", aid);
 
+    MESH_STATISTICS_TIMESTAMP(mesh_upper_transport_crypto_start_ms);
     mesh_transport_key_and_virtual_address_iterator_init(&mesh_transport_key_it, mesh_network_dst(incoming_network_pdu_decoded),
             incoming_network_pdu_decoded->netkey_index, akf, aid);
     mesh_upper_transport_validate_unsegmented_message();
@@ -541,6 +561,7 @@ static void mesh_upper_transport_process_message(void){
     printf("AKF: %u\n",   akf);
     printf("AID: %02x\n", aid);
 
+    MESH_STATISTICS_TIMESTAMP(mesh_upper_transport_crypto_start_ms);
     mesh_transport_key_and_virtual_address_iterator_init(&mesh_transport_key_it, mesh_transport_dst(incoming_transport_pdu_decoded),
             incoming_transport_pdu_decoded->netkey_index, akf, aid);
     mesh_upper_transport_validate_segmented_message();
@@ -599,6 +620,7 @@ static void mesh_upper_transport_send_unsegmented_access_pdu_ccm(void * arg){
     network_pdu->len        += 4;
     upper_transport_pdu_len += 4;
     mesh_print_hex("UpperTransportPDU", upper_transport_pdu, upper_transport_pdu_len);
+    MESH_STATISTICS_LATENCY(mesh_upper_transport_statistics.tx_latency, mesh_upper_transport_crypto_start_ms);
     // send network pdu
     mesh_lower_transport_send_pdu((mesh_pdu_t*) network_pdu);
 }
@@ -613,6 +635,7 @@ static void mesh_upper_transport_send_segmented_access_pdu_ccm(void * arg){
     mesh_print_hex("TransMIC", &transport_pdu->data[transport_pdu->len], transport_pdu->transmic_len);
     transport_pdu->len += transport_pdu->transmic_len;
     mesh_print_hex("UpperTransportPDU", transport_pdu->data, transport_pdu->len);
+    MESH_STATISTICS_LATENCY(mesh_upper_transport_statistics.tx_latency, mesh_upper_transport_crypto_start_ms);
     mesh_lower_transport_send_pdu((mesh_pdu_t*) transport_pdu);
 }
 
@@ -826,7 +849,7 @@ static void mesh_upper_transport_send_unsegmented_access_pdu(mesh_network_pdu_t
         virtual_address = mesh_virtual_address_for_pseudo_dst(dst);
         if (!virtual_address){
             printf("No virtual address register for pseudo dst %4x\n", dst);
-            btstack_memory_mesh_network_pdu_free(network_pdu);
+            mesh_network_pdu_free(network_pdu);
             return;
         }
         aad_len = 16;
@@ -860,7 +883,10 @@ static void mesh_upper_transport_send_unsegmented_access_pdu(mesh_network_pdu_t
     uint8_t   trans_mic_len = 4;
     uint16_t  access_pdu_len  = mesh_network_pdu_len(network_pdu)  - 1;
     crypto_active = 1;
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.tx_access);
+    MESH_STATISTICS_TIMESTAMP(mesh_upper_transport_crypto_start_ms);
 
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.ccm_operations);
     btstack_crypto_ccm_init(&ccm, appkey->key, application_nonce, access_pdu_len, aad_len, trans_mic_len);
     if (virtual_address){
         mesh_print_hex("LabelUUID", virtual_address->label_uuid, 16);
@@ -931,6 +957,9 @@ static void mesh_upper_transport_send_segmented_access_pdu(mesh_transport_pdu_t
     uint8_t   transmic_len    = transport_pdu->transmic_len;
     uint16_t  access_pdu_len  = transport_pdu->len;
     crypto_active = 1;
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.tx_access);
+    MESH_STATISTICS_TIMESTAMP(mesh_upper_transport_crypto_start_ms);
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.ccm_operations);
     btstack_crypto_ccm_init(&ccm, appkey->key, application_nonce, access_pdu_len, aad_len, transmic_len);
     if (virtual_address){
         mesh_print_hex("LabelUUID", virtual_address->label_uuid, 16);
@@ -950,6 +979,7 @@ static void mesh_upper_transport_send_unsegmented_control_pdu(mesh_network_pdu_t
     uint8_t opcode = network_pdu->data[9];
     printf("[+] Upper transport, send unsegmented Control PDU %p - seq %06x opcode %02x\n", network_pdu, seq, opcode);
     mesh_print_hex("Access Payload", &network_pdu->data[10], network_pdu->len - 10);
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.tx_control);
     // send
     mesh_lower_transport_send_pdu((mesh_pdu_t *) network_pdu);
 }
@@ -965,6 +995,7 @@ static void mesh_upper_transport_send_segmented_control_pdu(mesh_transport_pdu_t
     uint8_t opcode = transport_pdu->data[0];
     printf("[+] Upper transport, send segmented Control PDU %p - seq %06x opcode %02x\n", transport_pdu, seq, opcode);
     mesh_print_hex("Access Payload", &transport_pdu->data[1], transport_pdu->len - 1);
+    MESH_STATISTICS_INC(mesh_upper_transport_statistics.tx_control);
     // send
     mesh_lower_transport_send_pdu((mesh_pdu_t *) transport_pdu);
 }
@@ -1000,6 +1031,7 @@ static void mesh_upper_transport_run(void){
                 uint8_t ctl = mesh_transport_ctl(transport_pdu);
                 if (ctl){
                     printf("Ignoring Segmented Control Message\n");
+                    MESH_STATISTICS_INC(mesh_upper_transport_statistics.rx_control);
                     (void) btstack_linked_list_pop(&upper_transport_incoming);
                     mesh_lower_transport_message_processed_by_higher_layer((mesh_pdu_t *) transport_pdu);
                 } else {
@@ -1051,6 +1083,16 @@ static void mesh_upper_transport_run(void){
     }
 }
 
+#ifdef ENABLE_MESH_STATISTICS
+const mesh_upper_transport_statistics_t * mesh_upper_transport_get_statistics(void){
+    return &mesh_upper_transport_statistics;
+}
+
+void mesh_upper_transport_reset_statistics(void){
+    memset(&mesh_upper_transport_statistics, 0, sizeof(mesh_upper_transport_statistics));
+}
+#endif
+
 void mesh_upper_transport_register_access_message_handler(void (*callback)(mesh_pdu_t *pdu)){
     mesh_access_message_handler = callback;
 }
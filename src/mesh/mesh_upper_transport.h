@@ -48,6 +48,24 @@ extern "C"
 {
 #endif
 
+// upper transport statistics, updated with ENABLE_MESH_STATISTICS
+typedef struct {
+    // received messages, access messages are counted after successful decryption
+    uint32_t rx_access;
+    uint32_t rx_control;
+    // access messages dropped as no key matched
+    uint32_t rx_decrypt_failed;
+    // sent messages
+    uint32_t tx_access;
+    uint32_t tx_control;
+    // ccm operations started, rx and tx
+    uint32_t ccm_operations;
+    // start of decryption to delivery to access layer, includes tried keys
+    mesh_statistics_latency_t rx_latency;
+    // start of encryption to handover to lower transport
+    mesh_statistics_latency_t tx_latency;
+} mesh_upper_transport_statistics_t;
+
 void mesh_upper_transport_init(void);
 
 void mesh_upper_transport_message_processed_by_higher_layer(mesh_pdu_t * pdu);
@@ -79,6 +97,11 @@ void mesh_upper_transport_send_access_pdu(mesh_pdu_t * pdu);
 
 void mesh_upper_transport_pdu_free(mesh_pdu_t * pdu);
 
+#ifdef ENABLE_MESH_STATISTICS
+const mesh_upper_transport_statistics_t * mesh_upper_transport_get_statistics(void);
+void mesh_upper_transport_reset_statistics(void);
+#endif
+
 // test
 void mesh_upper_transport_dump(void);
 void mesh_upper_transport_reset(void);
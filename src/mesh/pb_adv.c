@@ -53,9 +53,8 @@
 #include "mesh/mesh_node.h"
 #include "mesh/provisioning.h"
 
-#define PB_ADV_LINK_OPEN_RETRANSMIT_MS 1000
 
-static void pb_adv_run(void);
+#define PB_ADV_LINK_OPEN_RETRANSMIT_MS 1000
 
 /* taps: 32 31 29 1; characteristic polynomial: x^32 + x^31 + x^29 + x + 1 */
 #define LFSR(a) ((a >> 1) ^ (uint32_t)((0 - (a & 1u)) & 0xd0000001u))
@@ -87,46 +86,57 @@ typedef enum {
     LINK_STATE_OPEN,
     LINK_STATE_CLOSING,
 } link_state_t;
-static link_state_t link_state;
 
+typedef struct {
+    // link state
+    link_state_t link_state;
+    uint16_t     cid;
+    uint8_t      provisioner_role;
 #ifdef ENABLE_MESH_PROVISIONER
-static const uint8_t * pb_adv_peer_device_uuid;
+    const uint8_t * peer_device_uuid;
 #endif
-
-static uint8_t  pb_adv_msg_in_buffer[MESH_PB_ADV_MAX_PDU_SIZE];   // TODO: how large are prov messages?
-
-// single adv link
-static uint16_t pb_adv_cid = 1;
-static uint8_t  pb_adv_provisioner_role;
-
-// link state
-static uint32_t pb_adv_link_id;
-static uint8_t  pb_adv_link_close_reason;
-static uint8_t  pb_adv_link_close_countdown;
-
-// random delay for outgoing packets
+    uint32_t     link_id;
+    uint8_t      link_close_reason;
+    uint8_t      link_close_countdown;
+
+    // pending can send now request
+    uint8_t      send_requested;
+
+    // random delay for outgoing packets, also used for link open retransmissions
+    uint8_t                random_delay_active;
+    btstack_timer_source_t random_delay_timer;
+
+    // incoming message
+    uint8_t  msg_in_buffer[MESH_PB_ADV_MAX_PDU_SIZE];   // TODO: how large are prov messages?
+    uint8_t  msg_in_transaction_nr_prev;
+    uint16_t msg_in_len;
+    uint8_t  msg_in_fcs;
+    uint8_t  msg_in_last_segment;
+    uint8_t  msg_in_segments_missing; // bitfield for segmentes 1-n
+    uint8_t  msg_in_transaction_nr;
+    uint8_t  msg_in_send_ack;
+
+    // oputgoing message
+    uint8_t         msg_out_active;
+    uint8_t         msg_out_transaction_nr;
+    uint8_t         msg_out_completed_transaction_nr;
+    uint16_t        msg_out_len;
+    uint16_t        msg_out_pos;
+    uint8_t         msg_out_seg;
+    uint32_t        msg_out_start;
+    const uint8_t * msg_out_buffer;
+} pb_adv_link_t;
+
+static void pb_adv_run(pb_adv_link_t * link);
+
+// adv links, pb_transport_cid = index + 1
+static pb_adv_link_t pb_adv_links[MESH_PB_ADV_NUM_LINKS];
+
+// round robin for can send now
+static uint8_t pb_adv_next_link_index;
+
+// link ids and random delays
 static uint32_t pb_adv_lfsr;
-static uint8_t                pb_adv_random_delay_active;
-static btstack_timer_source_t pb_adv_random_delay_timer;
-
-// incoming message
-static uint8_t  pb_adv_msg_in_transaction_nr_prev;
-static uint16_t pb_adv_msg_in_len;   // 
-static uint8_t  pb_adv_msg_in_fcs;
-static uint8_t  pb_adv_msg_in_last_segment; 
-static uint8_t  pb_adv_msg_in_segments_missing; // bitfield for segmentes 1-n
-static uint8_t  pb_adv_msg_in_transaction_nr;
-static uint8_t  pb_adv_msg_in_send_ack;
-
-// oputgoing message
-static uint8_t         pb_adv_msg_out_active;
-static uint8_t         pb_adv_msg_out_transaction_nr;
-static uint8_t         pb_adv_msg_out_completed_transaction_nr;
-static uint16_t        pb_adv_msg_out_len;
-static uint16_t        pb_adv_msg_out_pos;
-static uint8_t         pb_adv_msg_out_seg;
-static uint32_t        pb_adv_msg_out_start;
-static const uint8_t * pb_adv_msg_out_buffer;
 
 static btstack_packet_handler_t pb_adv_packet_handler;
 
@@ -136,26 +146,68 @@ static uint32_t pb_adv_random(void){
     return pb_adv_lfsr;
 }
 
-static void pb_adv_emit_pdu_sent(uint8_t status){
+static pb_adv_link_t * pb_adv_link_for_cid(uint16_t pb_transport_cid){
+    if (pb_transport_cid == 0) return NULL;
+    if (pb_transport_cid > MESH_PB_ADV_NUM_LINKS) return NULL;
+    return &pb_adv_links[pb_transport_cid - 1];
+}
+
+static pb_adv_link_t * pb_adv_link_for_link_id(uint32_t link_id){
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        pb_adv_link_t * link = &pb_adv_links[i];
+        if (link->link_state == LINK_STATE_W4_OPEN) continue;
+        if (link->link_id != link_id) continue;
+        return link;
+    }
+    return NULL;
+}
+
+static pb_adv_link_t * pb_adv_link_get_free(void){
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        pb_adv_link_t * link = &pb_adv_links[i];
+        if (link->link_state == LINK_STATE_W4_OPEN) return link;
+    }
+    return NULL;
+}
+
+static void pb_adv_request_can_send_now(pb_adv_link_t * link){
+    link->send_requested = 1;
+    adv_bearer_request_can_send_now_for_provisioning_pdu();
+}
+
+static void pb_adv_emit_pdu_sent(pb_adv_link_t * link, uint8_t status){
     uint8_t event[] = { HCI_EVENT_MESH_META, 2, MESH_SUBEVENT_PB_TRANSPORT_PDU_SENT, status};
-    pb_adv_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    pb_adv_packet_handler(HCI_EVENT_PACKET, link->cid, event, sizeof(event));
 }
 
 static void pb_adv_emit_link_open(uint8_t status, uint16_t pb_transport_cid){
     uint8_t event[7] = { HCI_EVENT_MESH_META, 5, MESH_SUBEVENT_PB_TRANSPORT_LINK_OPEN, status};
     little_endian_store_16(event, 4, pb_transport_cid);
     event[6] = MESH_PB_TYPE_ADV;
-    pb_adv_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    pb_adv_packet_handler(HCI_EVENT_PACKET, pb_transport_cid, event, sizeof(event));
 }
 
 static void pb_adv_emit_link_close(uint16_t pb_transport_cid, uint8_t reason){
     uint8_t event[6] = { HCI_EVENT_MESH_META, 3, MESH_SUBEVENT_PB_TRANSPORT_LINK_CLOSED};
     little_endian_store_16(event, 3, pb_transport_cid);
     event[5] = reason;
-    pb_adv_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    pb_adv_packet_handler(HCI_EVENT_PACKET, pb_transport_cid, event, sizeof(event));
 }
 
-static void pb_adv_handle_bearer_control(uint32_t link_id, uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
+static int pb_adv_device_link_active(void){
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        pb_adv_link_t * link = &pb_adv_links[i];
+        if (link->link_state == LINK_STATE_W4_OPEN) continue;
+        if (link->provisioner_role) continue;
+        return 1;
+    }
+    return 0;
+}
+
+static void pb_adv_handle_bearer_control(pb_adv_link_t * link, uint32_t link_id, uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
     UNUSED(transaction_nr);
     UNUSED(size);
 
@@ -168,48 +220,55 @@ static void pb_adv_handle_bearer_control(uint32_t link_id, uint8_t transaction_n
             own_device_uuid = mesh_node_get_device_uuid();
             if (!own_device_uuid) break;
             if (memcmp(&pdu[1], own_device_uuid, 16) != 0) break;
-            switch(link_state){
-                case LINK_STATE_W4_OPEN:
-                    pb_adv_link_id = link_id;
-                    pb_adv_provisioner_role = 0;
-                    pb_adv_msg_in_transaction_nr = 0xff;  // first transaction nr will be 0x00 
-                    pb_adv_msg_in_transaction_nr_prev = 0xff;
-                    log_info("link open, id %08x", pb_adv_link_id);
-                    printf("PB-ADV: Link Open %08x\n", pb_adv_link_id);
-                    link_state = LINK_STATE_W2_SEND_ACK;
-                    adv_bearer_request_can_send_now_for_provisioning_pdu();
-                    pb_adv_emit_link_open(0, pb_adv_cid);
-                    break;
-                case LINK_STATE_OPEN:
-                    if (pb_adv_link_id != link_id) break;
-                    log_info("link open, resend ACK");
-                    link_state = LINK_STATE_W2_SEND_ACK;
-                    adv_bearer_request_can_send_now_for_provisioning_pdu();
-                    break;
-                default:
-                    break;
+            if (link == NULL){
+                // only a single link in device role
+                if (pb_adv_device_link_active()) break;
+                link = pb_adv_link_get_free();
+                if (link == NULL) break;
+                link->link_id = link_id;
+                link->provisioner_role = 0;
+                link->msg_in_transaction_nr = 0xff;  // first transaction nr will be 0x00 
+                link->msg_in_transaction_nr_prev = 0xff;
+                log_info("link open, id %08x", link->link_id);
+                printf("PB-ADV: Link Open %08x\n", link->link_id);
+                link->link_state = LINK_STATE_W2_SEND_ACK;
+                pb_adv_request_can_send_now(link);
+                pb_adv_emit_link_open(0, link->cid);
+                break;
+            }
+            if (link->link_state == LINK_STATE_OPEN){
+                log_info("link open, resend ACK");
+                link->link_state = LINK_STATE_W2_SEND_ACK;
+                pb_adv_request_can_send_now(link);
             }
             break;
 #ifdef ENABLE_MESH_PROVISIONER
         case MESH_GENERIC_PROVISIONING_LINK_ACK:   // Acknowledge a session on a bearer
-            if (link_state != LINK_STATE_W4_ACK) break;
-            link_state = LINK_STATE_OPEN;
-            pb_adv_msg_out_transaction_nr = 0;
-            pb_adv_msg_in_transaction_nr = 0x7f;    // first transaction nr will be 0x80
-            pb_adv_msg_in_transaction_nr_prev = 0x7f;
-            btstack_run_loop_remove_timer(&pb_adv_random_delay_timer);
-            log_info("link open, id %08x", pb_adv_link_id);
-            printf("PB-ADV: Link Open %08x\n", pb_adv_link_id);
-            pb_adv_emit_link_open(0, pb_adv_cid);
+            if (link == NULL) break;
+            if (link->link_state != LINK_STATE_W4_ACK) break;
+            link->link_state = LINK_STATE_OPEN;
+            link->msg_out_transaction_nr = 0;
+            link->msg_in_transaction_nr = 0x7f;    // first transaction nr will be 0x80
+            link->msg_in_transaction_nr_prev = 0x7f;
+            btstack_run_loop_remove_timer(&link->random_delay_timer);
+            link->random_delay_active = 0;
+            log_info("link open, id %08x", link->link_id);
+            printf("PB-ADV: Link Open %08x\n", link->link_id);
+            pb_adv_emit_link_open(0, link->cid);
             break;
 #endif
         case MESH_GENERIC_PROVISIONING_LINK_CLOSE: // Close a session on a bearer
             // does it match link id
-            if (link_id != pb_adv_link_id) break;
+            if (link == NULL) break;
             reason = pdu[1];
-            link_state = LINK_STATE_W4_OPEN;
+            btstack_run_loop_remove_timer(&link->random_delay_timer);
+            link->random_delay_active = 0;
+            link->msg_out_active = 0;
+            link->msg_in_send_ack = 0;
+            link->send_requested = 0;
+            link->link_state = LINK_STATE_W4_OPEN;
             log_info("link close, reason %x", reason);
-            pb_adv_emit_link_close(pb_adv_cid, reason);
+            pb_adv_emit_link_close(link->cid, reason);
             break;
         default:
             log_info("BearerOpcode %x reserved for future use\n", bearer_opcode);
@@ -217,44 +276,44 @@ static void pb_adv_handle_bearer_control(uint32_t link_id, uint8_t transaction_n
     }
 }
 
-static void pb_adv_pdu_complete(void){
+static void pb_adv_pdu_complete(pb_adv_link_t * link){
 
     // Verify FCS
-    uint8_t pdu_crc = btstack_crc8_calc((uint8_t*)pb_adv_msg_in_buffer, pb_adv_msg_in_len);
-    if (pdu_crc != pb_adv_msg_in_fcs){
-        printf("Incoming PDU: fcs %02x, calculated %02x -> drop packet\n", pb_adv_msg_in_fcs, btstack_crc8_calc(pb_adv_msg_in_buffer, pb_adv_msg_in_len));
+    uint8_t pdu_crc = btstack_crc8_calc((uint8_t*)link->msg_in_buffer, link->msg_in_len);
+    if (pdu_crc != link->msg_in_fcs){
+        printf("Incoming PDU: fcs %02x, calculated %02x -> drop packet\n", link->msg_in_fcs, pdu_crc);
         return;
     }
 
-    printf("PB-ADV: %02x complete\n", pb_adv_msg_in_transaction_nr);
+    printf("PB-ADV: %02x complete\n", link->msg_in_transaction_nr);
 
     // transaction complete
-    pb_adv_msg_in_transaction_nr_prev = pb_adv_msg_in_transaction_nr;
-    if (pb_adv_provisioner_role){
-        pb_adv_msg_in_transaction_nr = 0x7f;    // invalid
+    link->msg_in_transaction_nr_prev = link->msg_in_transaction_nr;
+    if (link->provisioner_role){
+        link->msg_in_transaction_nr = 0x7f;    // invalid
     } else {
-        pb_adv_msg_in_transaction_nr = 0xff;    // invalid
+        link->msg_in_transaction_nr = 0xff;    // invalid
     }
 
     // Ack Transaction
-    pb_adv_msg_in_send_ack = 1;
-    pb_adv_run();
+    link->msg_in_send_ack = 1;
+    pb_adv_run(link);
 
     // Forward to Provisioning
-    pb_adv_packet_handler(PROVISIONING_DATA_PACKET, 0, pb_adv_msg_in_buffer, pb_adv_msg_in_len);
+    pb_adv_packet_handler(PROVISIONING_DATA_PACKET, link->cid, link->msg_in_buffer, link->msg_in_len);
 }
 
-static void pb_adv_handle_transaction_start(uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
+static void pb_adv_handle_transaction_start(pb_adv_link_t * link, uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
 
     // resend ack if packet from previous transaction received
-    if (transaction_nr != 0xff && transaction_nr == pb_adv_msg_in_transaction_nr_prev){
+    if (transaction_nr != 0xff && transaction_nr == link->msg_in_transaction_nr_prev){
         printf("PB_ADV: %02x transaction complete, resending ack \n", transaction_nr);
-        pb_adv_msg_in_send_ack = 1;
+        link->msg_in_send_ack = 1;
         return;
     }
 
     // new transaction?
-    if (transaction_nr != pb_adv_msg_in_transaction_nr){
+    if (transaction_nr != link->msg_in_transaction_nr){
 
         // check len
         uint16_t msg_len = big_endian_read_16(pdu, 1);
@@ -272,36 +331,36 @@ static void pb_adv_handle_transaction_start(uint8_t transaction_nr, const uint8_
 
         printf("PB-ADV: %02x started\n", transaction_nr);
 
-        pb_adv_msg_in_transaction_nr = transaction_nr;
-        pb_adv_msg_in_len            = msg_len;
-        pb_adv_msg_in_fcs            = pdu[3];
-        pb_adv_msg_in_last_segment   = last_segment;
+        link->msg_in_transaction_nr = transaction_nr;
+        link->msg_in_len            = msg_len;
+        link->msg_in_fcs            = pdu[3];
+        link->msg_in_last_segment   = last_segment;
 
         // set bits for  segments 1..n (segment 0 already received in this message)
-        pb_adv_msg_in_segments_missing = (1 << last_segment) - 1;
+        link->msg_in_segments_missing = (1 << last_segment) - 1;
 
         // store payload
         uint16_t payload_len = size - 4;
-        (void)memcpy(pb_adv_msg_in_buffer, &pdu[4], payload_len);
+        (void)memcpy(link->msg_in_buffer, &pdu[4], payload_len);
 
         // complete?
-        if (pb_adv_msg_in_segments_missing == 0){
-            pb_adv_pdu_complete();
+        if (link->msg_in_segments_missing == 0){
+            pb_adv_pdu_complete(link);
         }
     }
 }
 
-static void pb_adv_handle_transaction_cont(uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
+static void pb_adv_handle_transaction_cont(pb_adv_link_t * link, uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
 
     // check transaction nr
-    if (transaction_nr != 0xff && transaction_nr == pb_adv_msg_in_transaction_nr_prev){
+    if (transaction_nr != 0xff && transaction_nr == link->msg_in_transaction_nr_prev){
         printf("PB_ADV: %02x transaction complete, resending resending ack\n", transaction_nr);
-        pb_adv_msg_in_send_ack = 1;
+        link->msg_in_send_ack = 1;
         return;
     }
 
-    if (transaction_nr != pb_adv_msg_in_transaction_nr){
-        printf("PB-ADV: %02x received msg for transaction nr %x\n", pb_adv_msg_in_transaction_nr, transaction_nr);
+    if (transaction_nr != link->msg_in_transaction_nr){
+        printf("PB-ADV: %02x received msg for transaction nr %x\n", link->msg_in_transaction_nr, transaction_nr);
         return;
     }
 
@@ -313,7 +372,7 @@ static void pb_adv_handle_transaction_cont(uint8_t transaction_nr, const uint8_t
 
     // check if segment already received
     uint8_t seg_mask = 1 << (seg-1);
-    if ((pb_adv_msg_in_segments_missing & seg_mask) == 0){
+    if ((link->msg_in_segments_missing & seg_mask) == 0){
         printf("PB-ADV: %02x, segment %u already received\n", transaction_nr, seg);
         return;
     }
@@ -324,75 +383,216 @@ static void pb_adv_handle_transaction_cont(uint8_t transaction_nr, const uint8_t
     uint16_t fragment_size = size - 1;
 
     // check size if last segment
-    if (seg == pb_adv_msg_in_last_segment && (msg_pos + fragment_size) != pb_adv_msg_in_len){
+    if (seg == link->msg_in_last_segment && (msg_pos + fragment_size) != link->msg_in_len){
         // last segment has invalid size
         return;
     }
 
     // store segment and mark as received
-    (void)memcpy(&pb_adv_msg_in_buffer[msg_pos], &pdu[1], fragment_size);
-    pb_adv_msg_in_segments_missing &= ~seg_mask;
+    (void)memcpy(&link->msg_in_buffer[msg_pos], &pdu[1], fragment_size);
+    link->msg_in_segments_missing &= ~seg_mask;
 
      // last segment
-     if (pb_adv_msg_in_segments_missing == 0){
-        pb_adv_pdu_complete();
+     if (link->msg_in_segments_missing == 0){
+        pb_adv_pdu_complete(link);
     }
 }
 
-static void pb_adv_outgoing_transation_complete(uint8_t status){
+static void pb_adv_outgoing_transation_complete(pb_adv_link_t * link, uint8_t status){
     // stop sending
-    pb_adv_msg_out_active = 0;
+    link->msg_out_active = 0;
     // emit done
-    pb_adv_emit_pdu_sent(status);
+    pb_adv_emit_pdu_sent(link, status);
     // keep track of ack'ed transactions
-    pb_adv_msg_out_completed_transaction_nr = pb_adv_msg_out_transaction_nr;
+    link->msg_out_completed_transaction_nr = link->msg_out_transaction_nr;
     // increment outgoing transaction nr
-    pb_adv_msg_out_transaction_nr++;
-    if (pb_adv_msg_out_transaction_nr == 0x00){
+    link->msg_out_transaction_nr++;
+    if (link->msg_out_transaction_nr == 0x00){
         // Device role
-        pb_adv_msg_out_transaction_nr = 0x80;
+        link->msg_out_transaction_nr = 0x80;
     }
-    if (pb_adv_msg_out_transaction_nr == 0x80){
+    if (link->msg_out_transaction_nr == 0x80){
         // Provisioner role
-        pb_adv_msg_out_transaction_nr = 0x00;
+        link->msg_out_transaction_nr = 0x00;
     }
 }
 
-static void pb_adv_handle_transaction_ack(uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
+static void pb_adv_handle_transaction_ack(pb_adv_link_t * link, uint8_t transaction_nr, const uint8_t * pdu, uint16_t size){
     UNUSED(pdu);    
     UNUSED(size);
-    if (transaction_nr == pb_adv_msg_out_transaction_nr){
+    if (transaction_nr == link->msg_out_transaction_nr){
         printf("PB-ADV: %02x ACK received\n", transaction_nr);
-        pb_adv_outgoing_transation_complete(ERROR_CODE_SUCCESS);
-    } else if (transaction_nr == pb_adv_msg_out_completed_transaction_nr){
+        pb_adv_outgoing_transation_complete(link, ERROR_CODE_SUCCESS);
+    } else if (transaction_nr == link->msg_out_completed_transaction_nr){
         // Transaction ack received again
     } else {
-        printf("PB-ADV: %02x unexpected Transaction ACK %x recevied\n", pb_adv_msg_out_transaction_nr, transaction_nr);
+        printf("PB-ADV: %02x unexpected Transaction ACK %x recevied\n", link->msg_out_transaction_nr, transaction_nr);
     }
 }
 
-static int pb_adv_packet_to_send(void){
-    return pb_adv_msg_in_send_ack || pb_adv_msg_out_active || (link_state == LINK_STATE_W4_ACK);
+static int pb_adv_packet_to_send(pb_adv_link_t * link){
+    return link->msg_in_send_ack || link->msg_out_active || (link->link_state == LINK_STATE_W4_ACK);
 }
 
 static void pb_adv_timer_handler(btstack_timer_source_t * ts){
-    UNUSED(ts);
-    pb_adv_random_delay_active = 0;
-    if (!pb_adv_packet_to_send()) return;
-    adv_bearer_request_can_send_now_for_provisioning_pdu();  
+    pb_adv_link_t * link = (pb_adv_link_t *) btstack_run_loop_get_timer_context(ts);
+    link->random_delay_active = 0;
+    if (!pb_adv_packet_to_send(link)) return;
+    pb_adv_request_can_send_now(link);
 }
 
-static void pb_adv_run(void){
-    if (!pb_adv_packet_to_send()) return;
-    if (pb_adv_random_delay_active) return;
+static void pb_adv_run(pb_adv_link_t * link){
+    if (!pb_adv_packet_to_send(link)) return;
+    if (link->random_delay_active) return;
 
     // spec recommends 20-50 ms, we use 20-51 ms
-    pb_adv_random_delay_active = 1;
+    link->random_delay_active = 1;
     uint16_t random_delay_ms = 20 + (pb_adv_random() & 0x1f);
     log_info("random delay %u ms", random_delay_ms);
-    btstack_run_loop_set_timer_handler(&pb_adv_random_delay_timer, &pb_adv_timer_handler);
-    btstack_run_loop_set_timer(&pb_adv_random_delay_timer, random_delay_ms);
-    btstack_run_loop_add_timer(&pb_adv_random_delay_timer);
+    btstack_run_loop_set_timer_handler(&link->random_delay_timer, &pb_adv_timer_handler);
+    btstack_run_loop_set_timer(&link->random_delay_timer, random_delay_ms);
+    btstack_run_loop_add_timer(&link->random_delay_timer);
+}
+
+// returns 1 if a packet was sent for this link
+static int pb_adv_send_next_packet(pb_adv_link_t * link){
+#ifdef ENABLE_MESH_PROVISIONER
+    if (link->link_state == LINK_STATE_W4_ACK){
+        // build packet
+        uint8_t buffer[22];
+        big_endian_store_32(buffer, 0, link->link_id);
+        buffer[4] = 0;            // Transaction ID = 0
+        buffer[5] = (0 << 2) | 3; // Link Open | Provisioning Bearer Control
+        (void)memcpy(&buffer[6], link->peer_device_uuid, 16);
+        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
+        log_info("link open %08x", link->link_id);
+        printf("PB-ADV: Sending Link Open for device uuid: ");
+        printf_hexdump(link->peer_device_uuid, 16);
+        link->random_delay_active = 1;
+        btstack_run_loop_set_timer_handler(&link->random_delay_timer, &pb_adv_timer_handler);
+        btstack_run_loop_set_timer(&link->random_delay_timer, PB_ADV_LINK_OPEN_RETRANSMIT_MS);
+        btstack_run_loop_add_timer(&link->random_delay_timer);
+        return 1;
+    }
+#endif
+    if (link->link_state == LINK_STATE_CLOSING){
+        log_info("link close %08x", link->link_id);
+        printf("PB-ADV: Sending Link Close\n");
+        // build packet
+        uint8_t buffer[7];
+        big_endian_store_32(buffer, 0, link->link_id);
+        buffer[4] = 0;            // Transaction ID = 0
+        buffer[5] = (2 << 2) | 3; // Link Close | Provisioning Bearer Control
+        buffer[6] = link->link_close_reason;
+        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
+        link->link_close_countdown--;
+        if (link->link_close_countdown) {
+            pb_adv_request_can_send_now(link);
+        } else {
+            link->link_state = LINK_STATE_W4_OPEN;
+        }
+        return 1;
+    }
+    if (link->link_state == LINK_STATE_W2_SEND_ACK){
+        link->link_state = LINK_STATE_OPEN;
+        link->msg_out_transaction_nr = 0x80;
+        // build packet
+        uint8_t buffer[6];
+        big_endian_store_32(buffer, 0, link->link_id);
+        buffer[4] = 0;
+        buffer[5] = (1 << 2) | 3; // Link Ack | Provisioning Bearer Control
+        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
+        log_info("link ack %08x", link->link_id);
+        printf("PB-ADV: Sending Link Open Ack\n");
+        return 1;
+    }
+    if (link->msg_in_send_ack){
+        link->msg_in_send_ack = 0;
+        uint8_t buffer[6];
+        big_endian_store_32(buffer, 0, link->link_id);
+        buffer[4] = link->msg_in_transaction_nr_prev;
+        buffer[5] = MESH_GPCF_TRANSACTION_ACK;
+        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
+        log_info("transaction ack %08x", link->link_id);
+        printf("PB-ADV: %02x sending ACK\n", link->msg_in_transaction_nr_prev);
+        pb_adv_run(link);
+        return 1;
+    }
+    if (link->msg_out_active){
+
+        // check timeout for outgoing message
+        // since uint32_t is used and time now must be greater than msg_out_start,
+        // this claculation is correct even when the run loop time overruns
+        uint32_t transaction_time_ms = btstack_run_loop_get_time_ms() - link->msg_out_start;
+        if (transaction_time_ms >= MESH_GENERIC_PROVISIONING_TRANSACTION_TIMEOUT_MS){
+            pb_adv_outgoing_transation_complete(link, ERROR_CODE_CONNECTION_TIMEOUT);
+            return 0;
+        }
+
+        uint8_t buffer[29]; // ADV MTU
+        big_endian_store_32(buffer, 0, link->link_id);
+        buffer[4] = link->msg_out_transaction_nr;
+        uint16_t bytes_left;
+        uint16_t pos;
+        if (link->msg_out_pos == 0){
+            // Transaction start
+            int seg_n = link->msg_out_len / 24;
+            link->msg_out_seg = 0;
+            buffer[5] = seg_n << 2 | MESH_GPCF_TRANSACTION_START;
+            big_endian_store_16(buffer, 6, link->msg_out_len);
+            buffer[8] = btstack_crc8_calc((uint8_t*)link->msg_out_buffer, link->msg_out_len);
+            pos = 9;
+            bytes_left = 24 - 4;
+            printf("PB-ADV: %02x Sending Start: ", link->msg_out_transaction_nr);
+        } else {
+            // Transaction continue
+            buffer[5] = link->msg_out_seg << 2 | MESH_GPCF_TRANSACTION_CONT;
+            pos = 6;
+            bytes_left = 24 - 1;
+            printf("PB-ADV: %02x Sending Cont:  ", link->msg_out_transaction_nr);
+        }
+        link->msg_out_seg++;
+        uint16_t bytes_to_copy = btstack_min(bytes_left, link->msg_out_len - link->msg_out_pos);
+        (void)memcpy(&buffer[pos],
+                     &link->msg_out_buffer[link->msg_out_pos],
+                     bytes_to_copy);
+        pos += bytes_to_copy;
+        printf("bytes %02u, pos %02u, len %02u: ", bytes_to_copy, link->msg_out_pos, link->msg_out_len);
+        printf_hexdump(buffer, pos);
+        link->msg_out_pos += bytes_to_copy;
+
+        if (link->msg_out_pos == link->msg_out_len){
+            // done
+            link->msg_out_pos = 0;
+        }
+        adv_bearer_send_provisioning_pdu(buffer, pos);
+        pb_adv_run(link);
+        return 1;
+    }
+    return 0;
+}
+
+static void pb_adv_handle_can_send_now(void){
+    // serve links round robin, one packet per can send now
+    int i;
+    int sent = 0;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS && !sent;i++){
+        pb_adv_link_t * link = &pb_adv_links[pb_adv_next_link_index];
+        pb_adv_next_link_index++;
+        if (pb_adv_next_link_index >= MESH_PB_ADV_NUM_LINKS){
+            pb_adv_next_link_index = 0;
+        }
+        if (link->send_requested == 0) continue;
+        link->send_requested = 0;
+        sent = pb_adv_send_next_packet(link);
+    }
+    // more links waiting?
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        if (pb_adv_links[i].send_requested){
+            adv_bearer_request_can_send_now_for_provisioning_pdu();
+            break;
+        }
+    }
 }
 
 static void pb_adv_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
@@ -404,6 +604,7 @@ static void pb_adv_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
     uint32_t link_id;
     uint8_t  transaction_nr;
     uint8_t  generic_provisioning_control;
+    pb_adv_link_t * link;
     switch(packet[0]){
         case GAP_EVENT_ADVERTISING_REPORT:
             // data starts at offset 12
@@ -420,149 +621,37 @@ static void pb_adv_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             generic_provisioning_control = data[7];
             mesh_gpcf_format_t generic_provisioning_control_format = (mesh_gpcf_format_t) generic_provisioning_control & 3;
 
-            // unless, we're waiting for LINK_OPEN, check link_id
-            if (link_state != LINK_STATE_W4_OPEN){
-                if (link_id != pb_adv_link_id) break;
-            }
+            // find link by link_id, only LINK_OPEN is accepted for unknown links
+            link = pb_adv_link_for_link_id(link_id);
 
             if (generic_provisioning_control_format == MESH_GPCF_PROV_BEARER_CONTROL){
-                pb_adv_handle_bearer_control(link_id, transaction_nr, &data[7], length-6);
+                pb_adv_handle_bearer_control(link, link_id, transaction_nr, &data[7], length-6);
                 break;
             }
 
             // verify link id and link state
-            if (link_state != LINK_STATE_OPEN) break;
+            if (link == NULL) break;
+            if (link->link_state != LINK_STATE_OPEN) break;
 
             switch (generic_provisioning_control_format){
                 case MESH_GPCF_TRANSACTION_START:
-                    pb_adv_handle_transaction_start(transaction_nr, &data[7], length-6);
+                    pb_adv_handle_transaction_start(link, transaction_nr, &data[7], length-6);
                     break;
                 case MESH_GPCF_TRANSACTION_CONT:
-                    pb_adv_handle_transaction_cont(transaction_nr, &data[7], length-6);
+                    pb_adv_handle_transaction_cont(link, transaction_nr, &data[7], length-6);
                     break;
                 case MESH_GPCF_TRANSACTION_ACK:
-                    pb_adv_handle_transaction_ack(transaction_nr, &data[7], length-6);
+                    pb_adv_handle_transaction_ack(link, transaction_nr, &data[7], length-6);
                     break;
                 default:
                     break;
             }
-            pb_adv_run();
+            pb_adv_run(link);
             break;
         case HCI_EVENT_MESH_META:
             switch(packet[2]){
                 case MESH_SUBEVENT_CAN_SEND_NOW:
-#ifdef ENABLE_MESH_PROVISIONER
-                    if (link_state == LINK_STATE_W4_ACK){
-                        // build packet
-                        uint8_t buffer[22];
-                        big_endian_store_32(buffer, 0, pb_adv_link_id);
-                        buffer[4] = 0;            // Transaction ID = 0
-                        buffer[5] = (0 << 2) | 3; // Link Open | Provisioning Bearer Control
-                        (void)memcpy(&buffer[6], pb_adv_peer_device_uuid, 16);
-                        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
-                        log_info("link open %08x", pb_adv_link_id);
-                        printf("PB-ADV: Sending Link Open for device uuid: ");
-                        printf_hexdump(pb_adv_peer_device_uuid, 16);
-                        btstack_run_loop_set_timer_handler(&pb_adv_random_delay_timer, &pb_adv_timer_handler);
-                        btstack_run_loop_set_timer(&pb_adv_random_delay_timer, PB_ADV_LINK_OPEN_RETRANSMIT_MS);
-                        btstack_run_loop_add_timer(&pb_adv_random_delay_timer);
-                        break;
-                    }
-#endif
-                    if (link_state == LINK_STATE_CLOSING){
-                        log_info("link close %08x", pb_adv_link_id);
-                        printf("PB-ADV: Sending Link Close\n");
-                        // build packet
-                        uint8_t buffer[7];
-                        big_endian_store_32(buffer, 0, pb_adv_link_id);
-                        buffer[4] = 0;            // Transaction ID = 0
-                        buffer[5] = (2 << 2) | 3; // Link Close | Provisioning Bearer Control
-                        buffer[6] = pb_adv_link_close_reason;
-                        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
-                        pb_adv_link_close_countdown--;
-                        if (pb_adv_link_close_countdown) {
-                            adv_bearer_request_can_send_now_for_provisioning_pdu();  
-                        } else {
-                            link_state = LINK_STATE_W4_OPEN;
-                        }
-                        break;                        
-                    }
-                    if (link_state == LINK_STATE_W2_SEND_ACK){
-                        link_state = LINK_STATE_OPEN;
-                        pb_adv_msg_out_transaction_nr = 0x80;
-                        // build packet
-                        uint8_t buffer[6];
-                        big_endian_store_32(buffer, 0, pb_adv_link_id);
-                        buffer[4] = 0;
-                        buffer[5] = (1 << 2) | 3; // Link Ack | Provisioning Bearer Control
-                        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
-                        log_info("link ack %08x", pb_adv_link_id);
-                        printf("PB-ADV: Sending Link Open Ack\n");
-                        break;
-                    }
-                    if (pb_adv_msg_in_send_ack){
-                        pb_adv_msg_in_send_ack = 0;
-                        uint8_t buffer[6];
-                        big_endian_store_32(buffer, 0, pb_adv_link_id);
-                        buffer[4] = pb_adv_msg_in_transaction_nr_prev;
-                        buffer[5] = MESH_GPCF_TRANSACTION_ACK;
-                        adv_bearer_send_provisioning_pdu(buffer, sizeof(buffer));
-                        log_info("transaction ack %08x", pb_adv_link_id);
-                        printf("PB-ADV: %02x sending ACK\n", pb_adv_msg_in_transaction_nr_prev);
-                        pb_adv_run();
-                        break;
-                    }
-                    if (pb_adv_msg_out_active){
-
-                        // check timeout for outgoing message
-                        // since uint32_t is used and time now must be greater than pb_adv_msg_out_start,
-                        // this claculation is correct even when the run loop time overruns
-                        uint32_t transaction_time_ms = btstack_run_loop_get_time_ms() - pb_adv_msg_out_start;
-                        if (transaction_time_ms >= MESH_GENERIC_PROVISIONING_TRANSACTION_TIMEOUT_MS){
-                            pb_adv_outgoing_transation_complete(ERROR_CODE_CONNECTION_TIMEOUT);
-                            return;
-                        }
-
-                        uint8_t buffer[29]; // ADV MTU
-                        big_endian_store_32(buffer, 0, pb_adv_link_id);
-                        buffer[4] = pb_adv_msg_out_transaction_nr;
-                        uint16_t bytes_left;
-                        uint16_t pos;
-                        if (pb_adv_msg_out_pos == 0){
-                            // Transaction start
-                            int seg_n = pb_adv_msg_out_len / 24;
-                            pb_adv_msg_out_seg = 0;
-                            buffer[5] = seg_n << 2 | MESH_GPCF_TRANSACTION_START;
-                            big_endian_store_16(buffer, 6, pb_adv_msg_out_len);
-                            buffer[8] = btstack_crc8_calc((uint8_t*)pb_adv_msg_out_buffer, pb_adv_msg_out_len);
-                            pos = 9;
-                            bytes_left = 24 - 4;
-                            printf("PB-ADV: %02x Sending Start: ", pb_adv_msg_out_transaction_nr);
-                        } else {
-                            // Transaction continue
-                            buffer[5] = pb_adv_msg_out_seg << 2 | MESH_GPCF_TRANSACTION_CONT;
-                            pos = 6;
-                            bytes_left = 24 - 1;
-                            printf("PB-ADV: %02x Sending Cont:  ", pb_adv_msg_out_transaction_nr);
-                        }
-                        pb_adv_msg_out_seg++;
-                        uint16_t bytes_to_copy = btstack_min(bytes_left, pb_adv_msg_out_len - pb_adv_msg_out_pos);
-                        (void)memcpy(&buffer[pos],
-                                     &pb_adv_msg_out_buffer[pb_adv_msg_out_pos],
-                                     bytes_to_copy);
-                        pos += bytes_to_copy;
-                        printf("bytes %02u, pos %02u, len %02u: ", bytes_to_copy, pb_adv_msg_out_pos, pb_adv_msg_out_len);
-                        printf_hexdump(buffer, pos);
-                        pb_adv_msg_out_pos += bytes_to_copy;
-
-                        if (pb_adv_msg_out_pos == pb_adv_msg_out_len){
-                            // done
-                            pb_adv_msg_out_pos = 0;
-                        }
-                        adv_bearer_send_provisioning_pdu(buffer, pos);
-                        pb_adv_run();
-                        break;
-                    }
+                    pb_adv_handle_can_send_now();
                     break;
                 default:
                     break;
@@ -573,6 +662,13 @@ static void pb_adv_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
 }
 
 void pb_adv_init(void){
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        pb_adv_link_t * link = &pb_adv_links[i];
+        link->cid = i + 1;
+        link->link_state = LINK_STATE_W4_OPEN;
+        btstack_run_loop_set_timer_context(&link->random_delay_timer, link);
+    }
     adv_bearer_register_for_provisioning_pdu(&pb_adv_handler);
     pb_adv_lfsr = 0x12345678;
     pb_adv_random();
@@ -583,15 +679,16 @@ void pb_adv_register_packet_handler(btstack_packet_handler_t packet_handler){
 }
 
 void pb_adv_send_pdu(uint16_t pb_transport_cid, const uint8_t * pdu, uint16_t size){
-    UNUSED(pb_transport_cid);
+    pb_adv_link_t * link = pb_adv_link_for_cid(pb_transport_cid);
+    if (link == NULL) return;
     printf("PB-ADV: Send packet ");
     printf_hexdump(pdu, size);
-    pb_adv_msg_out_buffer = pdu;
-    pb_adv_msg_out_len    = size;
-    pb_adv_msg_out_pos = 0;
-    pb_adv_msg_out_start = btstack_run_loop_get_time_ms();
-    pb_adv_msg_out_active = 1;
-    pb_adv_run();
+    link->msg_out_buffer = pdu;
+    link->msg_out_len    = size;
+    link->msg_out_pos = 0;
+    link->msg_out_start = btstack_run_loop_get_time_ms();
+    link->msg_out_active = 1;
+    pb_adv_run(link);
 }
 
 /**
@@ -599,15 +696,21 @@ void pb_adv_send_pdu(uint16_t pb_transport_cid, const uint8_t * pdu, uint16_t si
  * @param pb_transport_cid
  */
 void pb_adv_close_link(uint16_t pb_transport_cid, uint8_t reason){
-    switch (link_state){
+    pb_adv_link_t * link = pb_adv_link_for_cid(pb_transport_cid);
+    if (link == NULL) return;
+    switch (link->link_state){
         case LINK_STATE_W4_ACK:
         case LINK_STATE_OPEN:
         case LINK_STATE_W2_SEND_ACK:
             pb_adv_emit_link_close(pb_transport_cid, 0);
-            link_state = LINK_STATE_CLOSING;
-            pb_adv_link_close_countdown = 3;
-            pb_adv_link_close_reason = reason;
-            adv_bearer_request_can_send_now_for_provisioning_pdu();
+            btstack_run_loop_remove_timer(&link->random_delay_timer);
+            link->random_delay_active = 0;
+            link->msg_out_active = 0;
+            link->msg_in_send_ack = 0;
+            link->link_state = LINK_STATE_CLOSING;
+            link->link_close_countdown = 3;
+            link->link_close_reason = reason;
+            pb_adv_request_can_send_now(link);
             break;
         case LINK_STATE_W4_OPEN:
         case LINK_STATE_CLOSING:
@@ -618,22 +721,24 @@ void pb_adv_close_link(uint16_t pb_transport_cid, uint8_t reason){
 
 #ifdef ENABLE_MESH_PROVISIONER
 uint16_t pb_adv_create_link(const uint8_t * device_uuid){
-    if (link_state != LINK_STATE_W4_OPEN) return 0;
+    pb_adv_link_t * link = pb_adv_link_get_free();
+    if (link == NULL) return 0;
     
-    pb_adv_peer_device_uuid = device_uuid;
-    pb_adv_provisioner_role = 1;
+    link->peer_device_uuid = device_uuid;
+    link->provisioner_role = 1;
 
-    // create new 32-bit link id
-    pb_adv_link_id = pb_adv_random();
+    // create new 32-bit link id, unique among active links
+    do {
+        link->link_id = pb_adv_random();
+    } while (pb_adv_link_for_link_id(link->link_id) != NULL);
 
     // after sending OPEN, we wait for an ACK
-    link_state = LINK_STATE_W4_ACK;
+    link->link_state = LINK_STATE_W4_ACK;
 
     // request outgoing
-    adv_bearer_request_can_send_now_for_provisioning_pdu();
+    pb_adv_request_can_send_now(link);
 
-    // dummy pb_adv_cid
-    return pb_adv_cid;
+    return link->cid;
 }
 #endif
 
@@ -48,6 +48,11 @@
 extern "C" {
 #endif
 
+// number of concurrent PB-ADV links, only a single link is used in device role
+#ifndef MESH_PB_ADV_NUM_LINKS
+#define MESH_PB_ADV_NUM_LINKS 1
+#endif
+
 /**
  * Initialize Provisioning Bearer using Advertisement Bearer
  */
@@ -55,6 +60,7 @@ void pb_adv_init(void);
 
 /**
  * Register listener for Provisioning PDUs and MESH_PBV_ADV_SEND_COMPLETE
+ * @note channel is set to pb_adv_cid of the link for all packets and events
  */
 void pb_adv_register_packet_handler(btstack_packet_handler_t packet_handler);
 
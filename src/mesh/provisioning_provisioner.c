@@ -37,6 +37,7 @@
 
 #define BTSTACK_FILE__ "provisioning_provisioner.c"
 
+
 #include "mesh/provisioning_provisioner.h"
 
 #include <stdio.h>
@@ -49,7 +50,72 @@
 #include "mesh/pb_adv.h"
 #include "mesh/provisioning.h"
 
-static void provisioning_public_key_ready(void);
+typedef enum {
+    PROVISIONER_IDLE,
+    PROVISIONER_SEND_INVITE,
+    PROVISIONER_W4_CAPABILITIES,
+    PROVISIONER_W4_AUTH_CONFIGURATION,
+    PROVISIONER_SEND_START,
+    PROVISIONED_W2_EMIT_READ_PUB_KEY_OOB,
+    PROVISIONER_SEND_PUB_KEY,
+    PROVISIONER_W4_PUB_KEY,
+    PROVISIONER_W4_PUB_KEY_OOB,
+    PROVISIONER_W4_INPUT_OOK,
+    PROVISIONER_W4_INPUT_COMPLETE,
+    PROVISIONER_SEND_CONFIRM,
+    PROVISIONER_W4_CONFIRM,
+    PROVISIONER_SEND_RANDOM,
+    PROVISIONER_W4_RANDOM,
+    PROVISIONER_SEND_DATA,
+    PROVISIONER_W4_COMPLETE,
+    PROVISIONER_SEND_ERROR,
+} provisioner_state_t;
+
+// data per provisioning session
+typedef struct {
+    provisioner_state_t state;
+    uint16_t pb_adv_cid;
+
+    // crypto requests are queued by btstack_crypto, each session has its own set
+    btstack_crypto_aes128_cmac_t cmac_request;
+    btstack_crypto_random_t      random_request;
+    btstack_crypto_ecc_p256_t    ecc_p256_request;
+    btstack_crypto_ccm_t         ccm_request;
+
+    btstack_timer_source_t       protocol_timer;
+
+    uint8_t  buffer_out[100];   // TODO: how large are prov messages?
+    uint8_t  waiting_for_outgoing_complete;
+    uint8_t  error_code;
+    uint8_t  start_algorithm;
+    uint8_t  start_public_key_used;
+    uint8_t  start_authentication_method;
+    uint8_t  start_authentication_action;
+    uint8_t  start_authentication_size;
+    uint8_t  authentication_string;
+    uint8_t  emit_output_oob_active;
+
+    const uint8_t * static_oob_data;
+    uint16_t        static_oob_len;
+
+    // ConfirmationInputs = ProvisioningInvitePDUValue || ProvisioningCapabilitiesPDUValue || ProvisioningStartPDUValue || PublicKeyProvisioner || PublicKeyDevice
+    uint8_t  confirmation_inputs[1 + 11 + 5 + 64 + 64];
+    uint8_t  confirmation_provisioner[16];
+    uint8_t  random_provisioner[16];
+    uint8_t  auth_value[16];
+    uint8_t  remote_ec_q[64];
+    uint8_t  dhkey[32];
+    uint8_t  confirmation_salt[16];
+    uint8_t  confirmation_key[16];
+    uint8_t  provisioning_salt[16];
+    uint8_t  session_key[16];
+    uint8_t  session_nonce[16];
+    uint8_t  provisioning_data[25];
+    uint8_t  enc_provisioning_data[25];
+    uint8_t  provisioning_data_mic[8];
+} provisioning_session_t;
+
+static void provisioning_public_key_ready(provisioning_session_t * session);
 
 // global
 static uint8_t         prov_ec_q[64];
@@ -67,48 +133,17 @@ static uint16_t net_key_index;
 static uint8_t  flags;
 // IV Index
 static uint32_t iv_index;
+// Unicast Address
+static uint16_t unicast_address;
 
-// either used once or per session
-static btstack_crypto_aes128_cmac_t prov_cmac_request;
-static btstack_crypto_random_t      prov_random_request;
-static btstack_crypto_ecc_p256_t    prov_ecc_p256_request;
-static btstack_crypto_ccm_t         prov_ccm_request;
-
-// data per provisioning session
-static btstack_timer_source_t       prov_protocol_timer;
-
-static uint16_t pb_adv_cid;
 static uint8_t  prov_attention_timer;
-static uint8_t  prov_buffer_out[100];   // TODO: how large are prov messages?
-static uint8_t  prov_waiting_for_outgoing_complete;
-static uint8_t  prov_error_code;
-static uint8_t  prov_start_algorithm;
-static uint8_t  prov_start_public_key_used;
-static uint8_t  prov_start_authentication_method;
-static uint8_t  prov_start_authentication_action;
-static uint8_t  prov_start_authentication_size;
-static uint8_t  prov_authentication_string;
-static uint8_t  prov_confirmation_inputs[1 + 11 + 5 + 64 + 64];
-static uint8_t  confirmation_provisioner[16];
-static uint8_t  random_provisioner[16];
-static uint8_t  auth_value[16];
-static uint8_t  remote_ec_q[64];
-static uint8_t  dhkey[32];
-static uint8_t  confirmation_salt[16];
-static uint8_t  confirmation_key[16];
-// ConfirmationInputs = ProvisioningInvitePDUValue || ProvisioningCapabilitiesPDUValue || ProvisioningStartPDUValue || PublicKeyProvisioner || PublicKeyDevice
-static uint8_t  prov_confirmation_inputs[1 + 11 + 5 + 64 + 64];
-static uint8_t provisioning_salt[16];
-static uint8_t session_key[16];
-static uint8_t session_nonce[16];
-static uint16_t unicast_address;
-static uint8_t provisioning_data[25];
-static uint8_t enc_provisioning_data[25];
-static uint8_t provisioning_data_mic[8];
-static uint8_t  prov_emit_output_oob_active;
 
-static const uint8_t * prov_static_oob_data;
-static uint16_t  prov_static_oob_len;
+// ECC key pair is shared by all sessions
+static btstack_crypto_ecc_p256_t    prov_ecc_p256_request;
+static uint8_t                      prov_ecc_generation_active;
+
+// one session per PB-ADV link
+static provisioning_session_t provisioning_sessions[MESH_PB_ADV_NUM_LINKS];
 
 #if 0
 static uint8_t  prov_public_key_oob_used;
@@ -142,6 +177,24 @@ static void provisioning_attention_timer_set(void){
 }
 #endif 
 
+static provisioning_session_t * provisioning_session_for_cid(uint16_t the_pb_adv_cid){
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        provisioning_session_t * session = &provisioning_sessions[i];
+        if (session->pb_adv_cid != the_pb_adv_cid) continue;
+        return session;
+    }
+    return NULL;
+}
+
+static int provisioning_session_active(void){
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        if (provisioning_sessions[i].pb_adv_cid != MESH_PB_TRANSPORT_INVALID_CID) return 1;
+    }
+    return 0;
+}
+
 static void provisioning_emit_output_oob_event(uint16_t the_pb_adv_cid, uint32_t number){
     if (!prov_packet_handler) return;
     uint8_t event[9] = { HCI_EVENT_MESH_META, 7, MESH_SUBEVENT_PB_PROV_START_EMIT_OUTPUT_OOB};
@@ -158,196 +211,174 @@ static void provisioning_emit_event(uint8_t mesh_subevent, uint16_t the_pb_adv_c
 }
 
 static void provisiong_timer_handler(btstack_timer_source_t * ts){
-    UNUSED(ts);
+    provisioning_session_t * session = (provisioning_session_t *) btstack_run_loop_get_timer_context(ts);
     printf("Provisioning Protocol Timeout -> Close Link!\n");
-    // TODO: use actual pb_adv_cid
-    pb_adv_close_link(1, 1);
+    pb_adv_close_link(session->pb_adv_cid, 1);
 }
 
 // The provisioning protocol shall have a minimum timeout of 60 seconds that is reset
 // each time a provisioning protocol PDU is sent or received
-static void provisioning_timer_start(void){
-    btstack_run_loop_remove_timer(&prov_protocol_timer);
-    btstack_run_loop_set_timer_handler(&prov_protocol_timer, &provisiong_timer_handler);
-    btstack_run_loop_set_timer(&prov_protocol_timer, PROVISIONING_PROTOCOL_TIMEOUT_MS);
-    btstack_run_loop_add_timer(&prov_protocol_timer);
+static void provisioning_timer_start(provisioning_session_t * session){
+    btstack_run_loop_remove_timer(&session->protocol_timer);
+    btstack_run_loop_set_timer_handler(&session->protocol_timer, &provisiong_timer_handler);
+    btstack_run_loop_set_timer_context(&session->protocol_timer, session);
+    btstack_run_loop_set_timer(&session->protocol_timer, PROVISIONING_PROTOCOL_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&session->protocol_timer);
 }
 
-static void provisioning_timer_stop(void){
-    btstack_run_loop_remove_timer(&prov_protocol_timer);
+static void provisioning_timer_stop(provisioning_session_t * session){
+    btstack_run_loop_remove_timer(&session->protocol_timer);
 }
 
 // Outgoing Provisioning PDUs
 
-static void provisioning_send_invite(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_INVITE;
-    prov_buffer_out[1] = prov_attention_timer;
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 2);
+static void provisioning_send_invite(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_INVITE;
+    session->buffer_out[1] = prov_attention_timer;
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 2);
     // collect confirmation_inputs
-    (void)memcpy(&prov_confirmation_inputs[0], &prov_buffer_out[1], 1);
+    (void)memcpy(&session->confirmation_inputs[0], &session->buffer_out[1], 1);
 }
 
-static void provisioning_send_start(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_START;
-    prov_buffer_out[1] = prov_start_algorithm;
-    prov_buffer_out[2] = prov_start_public_key_used;
-    prov_buffer_out[3] = prov_start_authentication_method;
-    prov_buffer_out[4] = prov_start_authentication_action;
-    prov_buffer_out[5] = prov_start_authentication_size;
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 6);
+static void provisioning_send_start(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_START;
+    session->buffer_out[1] = session->start_algorithm;
+    session->buffer_out[2] = session->start_public_key_used;
+    session->buffer_out[3] = session->start_authentication_method;
+    session->buffer_out[4] = session->start_authentication_action;
+    session->buffer_out[5] = session->start_authentication_size;
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 6);
     // store for confirmation inputs: len 5
-    (void)memcpy(&prov_confirmation_inputs[12], &prov_buffer_out[1], 5);
+    (void)memcpy(&session->confirmation_inputs[12], &session->buffer_out[1], 5);
 }
 
-static void provisioning_send_provisioning_error(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_FAILED;
-    prov_buffer_out[1] = prov_error_code;
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 2);
+static void provisioning_send_provisioning_error(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_FAILED;
+    session->buffer_out[1] = session->error_code;
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 2);
 }
 
-static void provisioning_send_public_key(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_PUB_KEY;
-    (void)memcpy(&prov_buffer_out[1], prov_ec_q, 64);
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 65);
+static void provisioning_send_public_key(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_PUB_KEY;
+    (void)memcpy(&session->buffer_out[1], prov_ec_q, 64);
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 65);
     // store for confirmation inputs: len 64
-    (void)memcpy(&prov_confirmation_inputs[17], &prov_buffer_out[1], 64);
+    (void)memcpy(&session->confirmation_inputs[17], &session->buffer_out[1], 64);
 }
 
-static void provisioning_send_confirm(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_CONFIRM;
-    (void)memcpy(&prov_buffer_out[1], confirmation_provisioner, 16);
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 17);
+static void provisioning_send_confirm(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_CONFIRM;
+    (void)memcpy(&session->buffer_out[1], session->confirmation_provisioner, 16);
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 17);
 }
 
-static void provisioning_send_random(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_RANDOM;
-    (void)memcpy(&prov_buffer_out[1], random_provisioner, 16);
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 17);
+static void provisioning_send_random(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_RANDOM;
+    (void)memcpy(&session->buffer_out[1], session->random_provisioner, 16);
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 17);
 }
 
-static void provisioning_send_data(uint16_t the_pb_adv_cid){
-    prov_buffer_out[0] = MESH_PROV_DATA;
-    (void)memcpy(&prov_buffer_out[1], enc_provisioning_data, 25);
-    (void)memcpy(&prov_buffer_out[26], provisioning_data_mic, 8);
-    pb_adv_send_pdu(the_pb_adv_cid, prov_buffer_out, 34);
+static void provisioning_send_data(provisioning_session_t * session){
+    session->buffer_out[0] = MESH_PROV_DATA;
+    (void)memcpy(&session->buffer_out[1], session->enc_provisioning_data, 25);
+    (void)memcpy(&session->buffer_out[26], session->provisioning_data_mic, 8);
+    pb_adv_send_pdu(session->pb_adv_cid, session->buffer_out, 34);
 }
 
-typedef enum {
-    PROVISIONER_IDLE,
-    PROVISIONER_SEND_INVITE,
-    PROVISIONER_W4_CAPABILITIES,
-    PROVISIONER_W4_AUTH_CONFIGURATION,
-    PROVISIONER_SEND_START,
-    PROVISIONED_W2_EMIT_READ_PUB_KEY_OOB,
-    PROVISIONER_SEND_PUB_KEY,
-    PROVISIONER_W4_PUB_KEY,
-    PROVISIONER_W4_PUB_KEY_OOB,
-    PROVISIONER_W4_INPUT_OOK,
-    PROVISIONER_W4_INPUT_COMPLETE,
-    PROVISIONER_SEND_CONFIRM,
-    PROVISIONER_W4_CONFIRM,
-    PROVISIONER_SEND_RANDOM,
-    PROVISIONER_W4_RANDOM,
-    PROVISIONER_SEND_DATA,
-    PROVISIONER_W4_COMPLETE,
-    PROVISIONER_SEND_ERROR,
-} provisioner_state_t;
-
-static provisioner_state_t provisioner_state;
-
-static void provisioning_run(void){
-    if (prov_waiting_for_outgoing_complete) return;
+static void provisioning_run(provisioning_session_t * session){
+    if (session->waiting_for_outgoing_complete) return;
     int start_timer = 1;
-    switch (provisioner_state){
+    switch (session->state){
         case PROVISIONER_SEND_ERROR:
             start_timer = 0;    // game over
-            provisioning_send_provisioning_error(pb_adv_cid);
+            provisioning_send_provisioning_error(session);
             break;
         case PROVISIONER_SEND_INVITE:
-            provisioning_send_invite(pb_adv_cid);
-            provisioner_state = PROVISIONER_W4_CAPABILITIES;
+            provisioning_send_invite(session);
+            session->state = PROVISIONER_W4_CAPABILITIES;
             break;
         case PROVISIONER_SEND_START:
-            provisioning_send_start(pb_adv_cid);
-            if (prov_start_public_key_used){
-                provisioner_state = PROVISIONED_W2_EMIT_READ_PUB_KEY_OOB;
+            provisioning_send_start(session);
+            if (session->start_public_key_used){
+                session->state = PROVISIONED_W2_EMIT_READ_PUB_KEY_OOB;
             } else {
-                provisioner_state = PROVISIONER_SEND_PUB_KEY;
+                session->state = PROVISIONER_SEND_PUB_KEY;
             }
             break;
         case PROVISIONED_W2_EMIT_READ_PUB_KEY_OOB:
             printf("Public OOB: please read OOB from remote device\n");
-            provisioner_state = PROVISIONER_W4_PUB_KEY_OOB;
-            provisioning_emit_event(MESH_SUBEVENT_PB_PROV_START_RECEIVE_PUBLIC_KEY_OOB, 1);
+            session->state = PROVISIONER_W4_PUB_KEY_OOB;
+            provisioning_emit_event(MESH_SUBEVENT_PB_PROV_START_RECEIVE_PUBLIC_KEY_OOB, session->pb_adv_cid);
             break;
         case PROVISIONER_SEND_PUB_KEY:
-            provisioning_send_public_key(pb_adv_cid);
-            if (prov_start_public_key_used){
-                provisioning_public_key_ready();
+            provisioning_send_public_key(session);
+            if (session->start_public_key_used){
+                provisioning_public_key_ready(session);
             } else {
-                provisioner_state = PROVISIONER_W4_PUB_KEY;
+                session->state = PROVISIONER_W4_PUB_KEY;
             }
             break;
         case PROVISIONER_SEND_CONFIRM:
-            provisioning_send_confirm(pb_adv_cid);
-            provisioner_state = PROVISIONER_W4_CONFIRM;
+            provisioning_send_confirm(session);
+            session->state = PROVISIONER_W4_CONFIRM;
             break;
         case PROVISIONER_SEND_RANDOM:
-            provisioning_send_random(pb_adv_cid);
-            provisioner_state = PROVISIONER_W4_RANDOM;
+            provisioning_send_random(session);
+            session->state = PROVISIONER_W4_RANDOM;
             break;
         case PROVISIONER_SEND_DATA:
-            provisioning_send_data(pb_adv_cid);
-            provisioner_state = PROVISIONER_W4_COMPLETE;
+            provisioning_send_data(session);
+            session->state = PROVISIONER_W4_COMPLETE;
             break;
         default:
             return;
     }
     if (start_timer){
-        provisioning_timer_start();
+        provisioning_timer_start(session);
     }
-    prov_waiting_for_outgoing_complete = 1;
+    session->waiting_for_outgoing_complete = 1;
 }
 
 // End of outgoing PDUs
 
-static void provisioning_done(void){
+static void provisioning_done(provisioning_session_t * session){
     // if (prov_emit_public_key_oob_active){
     //     prov_emit_public_key_oob_active = 0;
     //     provisioning_emit_event(MESH_PB_PROV_STOP_EMIT_PUBLIC_KEY_OOB, 1);
     // }
-    if (prov_emit_output_oob_active){
-        prov_emit_output_oob_active = 0;
-        provisioning_emit_event(MESH_SUBEVENT_PB_PROV_STOP_EMIT_OUTPUT_OOB, 1);
+    if (session->emit_output_oob_active){
+        session->emit_output_oob_active = 0;
+        provisioning_emit_event(MESH_SUBEVENT_PB_PROV_STOP_EMIT_OUTPUT_OOB, session->pb_adv_cid);
     }
-    provisioner_state = PROVISIONER_IDLE;
+    provisioning_timer_stop(session);
+    session->state = PROVISIONER_IDLE;
 }
 
 
-static void provisioning_handle_provisioning_error(uint8_t error_code){
-    provisioning_timer_stop();
-    prov_error_code = error_code;
-    provisioner_state = PROVISIONER_SEND_ERROR;
-    provisioning_run();
+static void provisioning_handle_provisioning_error(provisioning_session_t * session, uint8_t error_code){
+    provisioning_timer_stop(session);
+    session->error_code = error_code;
+    session->state = PROVISIONER_SEND_ERROR;
+    provisioning_run(session);
 }
 
-static void provisioning_handle_link_opened(uint16_t the_pb_adv_cid){
-    UNUSED(the_pb_adv_cid);
-    provisioner_state = PROVISIONER_SEND_INVITE;
+static void provisioning_handle_link_opened(provisioning_session_t * session){
+    session->waiting_for_outgoing_complete = 0;
+    session->state = PROVISIONER_SEND_INVITE;
 }
 
-static void provisioning_handle_capabilities(uint16_t the_pb_adv_cid, const uint8_t * packet_data, uint16_t packet_len){
+static void provisioning_handle_capabilities(provisioning_session_t * session, const uint8_t * packet_data, uint16_t packet_len){
     
     if (packet_len != 11) return;
 
     // collect confirmation_inputs
-    (void)memcpy(&prov_confirmation_inputs[1], packet_data, packet_len);
+    (void)memcpy(&session->confirmation_inputs[1], packet_data, packet_len);
 
-    provisioner_state = PROVISIONER_W4_AUTH_CONFIGURATION; 
+    session->state = PROVISIONER_W4_AUTH_CONFIGURATION; 
 
     // notify client and wait for auth method selection
     uint8_t event[16] = { HCI_EVENT_MESH_META, 3, MESH_SUBEVENT_PB_PROV_CAPABILITIES};
-    little_endian_store_16(event, 3, the_pb_adv_cid);
+    little_endian_store_16(event, 3, session->pb_adv_cid);
     event[5] = packet_data[0];
     little_endian_store_16(event, 6, big_endian_read_16(packet_data, 1));
     event[8] = packet_data[3];
@@ -360,116 +391,115 @@ static void provisioning_handle_capabilities(uint16_t the_pb_adv_cid, const uint
 }
 
 static void provisioning_handle_confirmation_provisioner_calculated(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     printf("ConfirmationProvisioner: ");
-    printf_hexdump(confirmation_provisioner, sizeof(confirmation_provisioner));
+    printf_hexdump(session->confirmation_provisioner, sizeof(session->confirmation_provisioner));
 
-    provisioner_state = PROVISIONER_SEND_CONFIRM;
-    provisioning_run();
+    session->state = PROVISIONER_SEND_CONFIRM;
+    provisioning_run(session);
 }
 
 static void provisioning_handle_random_provisioner(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     printf("RandomProvisioner:   ");
-    printf_hexdump(random_provisioner, sizeof(random_provisioner));
+    printf_hexdump(session->random_provisioner, sizeof(session->random_provisioner));
 
-    // re-use prov_confirmation_inputs buffer
-    (void)memcpy(&prov_confirmation_inputs[0], random_provisioner, 16);
-    (void)memcpy(&prov_confirmation_inputs[16], auth_value, 16);
+    // re-use confirmation_inputs buffer
+    (void)memcpy(&session->confirmation_inputs[0], session->random_provisioner, 16);
+    (void)memcpy(&session->confirmation_inputs[16], session->auth_value, 16);
 
     // calc confirmation device
-    btstack_crypto_aes128_cmac_message(&prov_cmac_request, confirmation_key, 32, prov_confirmation_inputs, confirmation_provisioner, &provisioning_handle_confirmation_provisioner_calculated, NULL);
+    btstack_crypto_aes128_cmac_message(&session->cmac_request, session->confirmation_key, 32, session->confirmation_inputs, session->confirmation_provisioner, &provisioning_handle_confirmation_provisioner_calculated, session);
 }
 
 static void provisioning_handle_confirmation_k1_calculated(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     printf("ConfirmationKey:   ");
-    printf_hexdump(confirmation_key, sizeof(confirmation_key));
+    printf_hexdump(session->confirmation_key, sizeof(session->confirmation_key));
 
     // generate random_device
-    btstack_crypto_random_generate(&prov_random_request,random_provisioner, 16, &provisioning_handle_random_provisioner, NULL);
+    btstack_crypto_random_generate(&session->random_request, session->random_provisioner, 16, &provisioning_handle_random_provisioner, session);
 }
 
 static void provisioning_handle_confirmation_salt(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     // dump
     printf("ConfirmationSalt:   ");
-    printf_hexdump(confirmation_salt, sizeof(confirmation_salt));
+    printf_hexdump(session->confirmation_salt, sizeof(session->confirmation_salt));
 
     // ConfirmationKey
-    mesh_k1(&prov_cmac_request, dhkey, sizeof(dhkey), confirmation_salt, (const uint8_t*) "prck", 4, confirmation_key, &provisioning_handle_confirmation_k1_calculated, NULL);
+    mesh_k1(&session->cmac_request, session->dhkey, sizeof(session->dhkey), session->confirmation_salt, (const uint8_t*) "prck", 4, session->confirmation_key, &provisioning_handle_confirmation_k1_calculated, session);
 }
 
-static void provisioning_handle_auth_value_ready(void){
+static void provisioning_handle_auth_value_ready(provisioning_session_t * session){
     // CalculationInputs
     printf("ConfirmationInputs: ");
-    printf_hexdump(prov_confirmation_inputs, sizeof(prov_confirmation_inputs));
+    printf_hexdump(session->confirmation_inputs, sizeof(session->confirmation_inputs));
 
     // calculate s1
-    btstack_crypto_aes128_cmac_zero(&prov_cmac_request, sizeof(prov_confirmation_inputs), prov_confirmation_inputs, confirmation_salt, &provisioning_handle_confirmation_salt, NULL);
+    btstack_crypto_aes128_cmac_zero(&session->cmac_request, sizeof(session->confirmation_inputs), session->confirmation_inputs, session->confirmation_salt, &provisioning_handle_confirmation_salt, session);
 }
 
 static void provisioning_handle_auth_value_input_oob(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     // limit auth value to single digit
-    auth_value[15] = auth_value[15] % 9 + 1;
-    printf("Input OOB: %u\n", auth_value[15]);
+    session->auth_value[15] = session->auth_value[15] % 9 + 1;
+    printf("Input OOB: %u\n", session->auth_value[15]);
 
-    if (prov_authentication_string){
+    if (session->authentication_string){
         // strings start at 0 while numbers are stored as 16-byte big endian
-        auth_value[0] = auth_value[15] + '0';
-        auth_value[15] = 0;
+        session->auth_value[0] = session->auth_value[15] + '0';
+        session->auth_value[15] = 0;
     }
 
     printf("AuthValue: ");
-    printf_hexdump(auth_value, sizeof(auth_value));
+    printf_hexdump(session->auth_value, sizeof(session->auth_value));
 
     // emit output oob value
-    provisioning_emit_output_oob_event(1, auth_value[15]);
-    prov_emit_output_oob_active = 1;
+    provisioning_emit_output_oob_event(session->pb_adv_cid, session->auth_value[15]);
+    session->emit_output_oob_active = 1;
 
-    provisioner_state = PROVISIONER_W4_INPUT_COMPLETE;
+    session->state = PROVISIONER_W4_INPUT_COMPLETE;
 }
 
-static void provisioning_handle_input_complete(uint16_t the_pb_adv_cid){
-    UNUSED(the_pb_adv_cid);
-    provisioning_handle_auth_value_ready();
+static void provisioning_handle_input_complete(provisioning_session_t * session){
+    provisioning_handle_auth_value_ready(session);
 }
 
-static void provisioning_public_key_exchange_complete(void){
+static void provisioning_public_key_exchange_complete(provisioning_session_t * session){
     // reset auth_value
-    memset(auth_value, 0, sizeof(auth_value));
+    memset(session->auth_value, 0, sizeof(session->auth_value));
 
     // handle authentication method
-    switch (prov_start_authentication_method){
+    switch (session->start_authentication_method){
         case 0x00:
-            provisioning_handle_auth_value_ready();
+            provisioning_handle_auth_value_ready(session);
             break;        
         case 0x01:
-            (void)memcpy(&auth_value[16 - prov_static_oob_len],
-                         prov_static_oob_data, prov_static_oob_len);
-            provisioning_handle_auth_value_ready();
+            (void)memcpy(&session->auth_value[16 - session->static_oob_len],
+                         session->static_oob_data, session->static_oob_len);
+            provisioning_handle_auth_value_ready(session);
             break;
         case 0x02:
             // Output OOB
-            prov_authentication_string = prov_start_authentication_action == 0x04;
-            printf("Output OOB requested (and we're in Provisioniner role), string %u\n", prov_authentication_string);
-            provisioner_state = PROVISIONER_W4_INPUT_OOK;
-            provisioning_emit_event(MESH_SUBEVENT_PB_PROV_OUTPUT_OOB_REQUEST, 1);
+            session->authentication_string = session->start_authentication_action == 0x04;
+            printf("Output OOB requested (and we're in Provisioniner role), string %u\n", session->authentication_string);
+            session->state = PROVISIONER_W4_INPUT_OOK;
+            provisioning_emit_event(MESH_SUBEVENT_PB_PROV_OUTPUT_OOB_REQUEST, session->pb_adv_cid);
             break;
         case 0x03:
             // Input OOB
-            prov_authentication_string = prov_start_authentication_action == 0x03;
-            printf("Input OOB requested, string %u\n", prov_authentication_string);
+            session->authentication_string = session->start_authentication_action == 0x03;
+            printf("Input OOB requested, string %u\n", session->authentication_string);
             printf("Generate random for auth_value\n");
             // generate single byte of random data to use for authentication
-            btstack_crypto_random_generate(&prov_random_request, &auth_value[15], 1, &provisioning_handle_auth_value_input_oob, NULL);
-            provisioning_emit_event(MESH_SUBEVENT_PB_PROV_START_EMIT_INPUT_OOB, 1);
+            btstack_crypto_random_generate(&session->random_request, &session->auth_value[15], 1, &provisioning_handle_auth_value_input_oob, session);
+            provisioning_emit_event(MESH_SUBEVENT_PB_PROV_START_EMIT_INPUT_OOB, session->pb_adv_cid);
             break;
         default:
             break;
@@ -477,38 +507,38 @@ static void provisioning_public_key_exchange_complete(void){
 }
 
 static void provisioning_handle_public_key_dhkey(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     printf("DHKEY: ");
-    printf_hexdump(dhkey, sizeof(dhkey));
+    printf_hexdump(session->dhkey, sizeof(session->dhkey));
 
 #if 0
     // skip sending own public key when public key oob is used
     if (prov_public_key_oob_available && prov_public_key_oob_used){
         // just copy key for confirmation inputs
-        memcpy(&prov_confirmation_inputs[81], prov_ec_q, 64);
+        memcpy(&session->confirmation_inputs[81], prov_ec_q, 64);
     } else {
         // queue public key pdu
         provisioning_queue_pdu(MESH_PROV_PUB_KEY);
     }
 #endif
 
-    provisioning_public_key_exchange_complete();
+    provisioning_public_key_exchange_complete(session);
 }
 
-static void provisioning_public_key_ready(void){
+static void provisioning_public_key_ready(provisioning_session_t * session){
     // calculate DHKey
-    btstack_crypto_ecc_p256_calculate_dhkey(&prov_ecc_p256_request, remote_ec_q, dhkey, provisioning_handle_public_key_dhkey, NULL);
+    btstack_crypto_ecc_p256_calculate_dhkey(&session->ecc_p256_request, session->remote_ec_q, session->dhkey, provisioning_handle_public_key_dhkey, session);
 }
 
-static void provisioning_handle_public_key(uint16_t the_pb_adv_cid, const uint8_t *packet_data, uint16_t packet_len){
+static void provisioning_handle_public_key(provisioning_session_t * session, const uint8_t *packet_data, uint16_t packet_len){
     // validate public key
-    if (packet_len != sizeof(remote_ec_q) || btstack_crypto_ecc_p256_validate_public_key(packet_data) != 0){
+    if (packet_len != sizeof(session->remote_ec_q) || btstack_crypto_ecc_p256_validate_public_key(packet_data) != 0){
         printf("Public Key invalid, abort provisioning\n");
         
         // disconnect provisioning link 
-        pb_adv_close_link(the_pb_adv_cid, 0x02);    // reason: fail
-        provisioning_timer_stop();
+        pb_adv_close_link(session->pb_adv_cid, 0x02);    // reason: fail
+        provisioning_timer_stop(session);
         return;
     }
 
@@ -525,191 +555,203 @@ static void provisioning_handle_public_key(uint16_t the_pb_adv_cid, const uint8_
 #endif
 
     // store for confirmation inputs: len 64
-    (void)memcpy(&prov_confirmation_inputs[81], packet_data, 64);
+    (void)memcpy(&session->confirmation_inputs[81], packet_data, 64);
 
     // store remote q
-    (void)memcpy(remote_ec_q, packet_data, sizeof(remote_ec_q));
+    (void)memcpy(session->remote_ec_q, packet_data, sizeof(session->remote_ec_q));
 
-    provisioning_public_key_ready();
+    provisioning_public_key_ready(session);
 }
 
-static void provisioning_handle_confirmation(uint16_t the_pb_adv_cid, const uint8_t *packet_data, uint16_t packet_len){
+static void provisioning_handle_confirmation(provisioning_session_t * session, const uint8_t *packet_data, uint16_t packet_len){
 
-    UNUSED(the_pb_adv_cid);
     UNUSED(packet_data);
     UNUSED(packet_len);
 
     // 
-    if (prov_emit_output_oob_active){
-        prov_emit_output_oob_active = 0;
-        provisioning_emit_event(MESH_SUBEVENT_PB_PROV_STOP_EMIT_OUTPUT_OOB, 1);
+    if (session->emit_output_oob_active){
+        session->emit_output_oob_active = 0;
+        provisioning_emit_event(MESH_SUBEVENT_PB_PROV_STOP_EMIT_OUTPUT_OOB, session->pb_adv_cid);
     }
 
 #if 0
     // CalculationInputs
     printf("ConfirmationInputs: ");
-    printf_hexdump(prov_confirmation_inputs, sizeof(prov_confirmation_inputs));
+    printf_hexdump(session->confirmation_inputs, sizeof(session->confirmation_inputs));
 
     // calculate s1
-    btstack_crypto_aes128_cmac_zero(&prov_cmac_request, sizeof(prov_confirmation_inputs), prov_confirmation_inputs, confirmation_salt, &provisioning_handle_confirmation_s1_calculated, NULL);
+    btstack_crypto_aes128_cmac_zero(&session->cmac_request, sizeof(session->confirmation_inputs), session->confirmation_inputs, session->confirmation_salt, &provisioning_handle_confirmation_s1_calculated, session);
 #endif
-    provisioner_state = PROVISIONER_SEND_RANDOM;
+    session->state = PROVISIONER_SEND_RANDOM;
 }
 
 static void provisioning_handle_data_encrypted(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     // enc_provisioning_data
     printf("EncProvisioningData:   ");
-    printf_hexdump(enc_provisioning_data, sizeof(enc_provisioning_data));
+    printf_hexdump(session->enc_provisioning_data, sizeof(session->enc_provisioning_data));
 
-    btstack_crypto_ccm_get_authentication_value(&prov_ccm_request, provisioning_data_mic);
+    btstack_crypto_ccm_get_authentication_value(&session->ccm_request, session->provisioning_data_mic);
     printf("MIC:   ");
-    printf_hexdump(provisioning_data_mic, sizeof(provisioning_data_mic));
+    printf_hexdump(session->provisioning_data_mic, sizeof(session->provisioning_data_mic));
 
     // send
-    provisioner_state = PROVISIONER_SEND_DATA;
-    provisioning_run();
+    session->state = PROVISIONER_SEND_DATA;
+    provisioning_run(session);
 }
 
 static void provisioning_handle_session_nonce_calculated(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     // The nonce shall be the 13 least significant octets == zero most significant octets
     uint8_t temp[13];
-    (void)memcpy(temp, &session_nonce[3], 13);
-    (void)memcpy(session_nonce, temp, 13);
+    (void)memcpy(temp, &session->session_nonce[3], 13);
+    (void)memcpy(session->session_nonce, temp, 13);
 
     // SessionNonce
     printf("SessionNonce:   ");
-    printf_hexdump(session_nonce, 13);
+    printf_hexdump(session->session_nonce, 13);
 
     // setup provisioning data
-    (void)memcpy(&provisioning_data[0], net_key, 16);
-    big_endian_store_16(provisioning_data, 16, net_key_index);
-    provisioning_data[18] = flags;
-    big_endian_store_32(provisioning_data, 19, iv_index);
-    big_endian_store_16(provisioning_data, 23, unicast_address);
+    (void)memcpy(&session->provisioning_data[0], net_key, 16);
+    big_endian_store_16(session->provisioning_data, 16, net_key_index);
+    session->provisioning_data[18] = flags;
+    big_endian_store_32(session->provisioning_data, 19, iv_index);
+    big_endian_store_16(session->provisioning_data, 23, unicast_address);
 
-    btstack_crypto_ccm_init(&prov_ccm_request, session_key, session_nonce, 25, 0, 8);
-    btstack_crypto_ccm_encrypt_block(&prov_ccm_request, 25, provisioning_data, enc_provisioning_data, &provisioning_handle_data_encrypted, NULL);
+    btstack_crypto_ccm_init(&session->ccm_request, session->session_key, session->session_nonce, 25, 0, 8);
+    btstack_crypto_ccm_encrypt_block(&session->ccm_request, 25, session->provisioning_data, session->enc_provisioning_data, &provisioning_handle_data_encrypted, session);
 }
 
 static void provisioning_handle_session_key_calculated(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
 
     // SessionKey
     printf("SessionKey:   ");
-    printf_hexdump(session_key, sizeof(session_key));
+    printf_hexdump(session->session_key, sizeof(session->session_key));
 
     // SessionNonce
-    mesh_k1(&prov_cmac_request, dhkey, sizeof(dhkey), provisioning_salt, (const uint8_t*) "prsn", 4, session_nonce, &provisioning_handle_session_nonce_calculated, NULL);
+    mesh_k1(&session->cmac_request, session->dhkey, sizeof(session->dhkey), session->provisioning_salt, (const uint8_t*) "prsn", 4, session->session_nonce, &provisioning_handle_session_nonce_calculated, session);
 }
 
 
 static void provisioning_handle_provisioning_salt_calculated(void * arg){
-    UNUSED(arg);
+    provisioning_session_t * session = (provisioning_session_t *) arg;
     
     // ProvisioningSalt
     printf("ProvisioningSalt:   ");
-    printf_hexdump(provisioning_salt, sizeof(provisioning_salt));
+    printf_hexdump(session->provisioning_salt, sizeof(session->provisioning_salt));
 
     // SessionKey
-    mesh_k1(&prov_cmac_request, dhkey, sizeof(dhkey), provisioning_salt, (const uint8_t*) "prsk", 4, session_key, &provisioning_handle_session_key_calculated, NULL);
+    mesh_k1(&session->cmac_request, session->dhkey, sizeof(session->dhkey), session->provisioning_salt, (const uint8_t*) "prsk", 4, session->session_key, &provisioning_handle_session_key_calculated, session);
 }
 
-static void provisioning_handle_random(uint16_t the_pb_adv_cid, const uint8_t *packet_data, uint16_t packet_len){
+static void provisioning_handle_random(provisioning_session_t * session, const uint8_t *packet_data, uint16_t packet_len){
 
-    UNUSED(the_pb_adv_cid);
     UNUSED(packet_len);
 
     // TODO: validate Confirmation
 
     // calc ProvisioningSalt = s1(ConfirmationSalt || RandomProvisioner || RandomDevice)
-    (void)memcpy(&prov_confirmation_inputs[0], confirmation_salt, 16);
-    (void)memcpy(&prov_confirmation_inputs[16], random_provisioner, 16);
-    (void)memcpy(&prov_confirmation_inputs[32], packet_data, 16);
-    btstack_crypto_aes128_cmac_zero(&prov_cmac_request, 48, prov_confirmation_inputs, provisioning_salt, &provisioning_handle_provisioning_salt_calculated, NULL);
+    (void)memcpy(&session->confirmation_inputs[0], session->confirmation_salt, 16);
+    (void)memcpy(&session->confirmation_inputs[16], session->random_provisioner, 16);
+    (void)memcpy(&session->confirmation_inputs[32], packet_data, 16);
+    btstack_crypto_aes128_cmac_zero(&session->cmac_request, 48, session->confirmation_inputs, session->provisioning_salt, &provisioning_handle_provisioning_salt_calculated, session);
 }
 
-static void provisioning_handle_complete(uint16_t the_pb_adv_cid){
-    UNUSED(the_pb_adv_cid);
+static void provisioning_handle_complete(provisioning_session_t * session){
+    UNUSED(session);
 }
 
 static void provisioning_handle_pdu(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-    UNUSED(channel);
 
     if (size < 1) return;
 
+    // PB-ADV reports pb_adv_cid as channel
+    provisioning_session_t * session = provisioning_session_for_cid(channel);
+
     switch (packet_type){
         case HCI_EVENT_PACKET:
             if (packet[0] != HCI_EVENT_MESH_META)  break;
             switch (packet[2]){
                 case MESH_SUBEVENT_PB_TRANSPORT_LINK_OPEN:
+                    if (session == NULL){
+                        // bind free session to new link
+                        session = provisioning_session_for_cid(MESH_PB_TRANSPORT_INVALID_CID);
+                        if (session == NULL) break;
+                        session->pb_adv_cid = mesh_subevent_pb_transport_link_open_get_pb_transport_cid(packet);
+                    }
                     printf("Link opened, sending Invite\n");
-                    provisioning_handle_link_opened(pb_adv_cid);
+                    provisioning_handle_link_opened(session);
                     break;
                 case MESH_SUBEVENT_PB_TRANSPORT_PDU_SENT:
+                    if (session == NULL) break;
                     printf("Outgoing packet acked\n");
-                    prov_waiting_for_outgoing_complete = 0;
+                    session->waiting_for_outgoing_complete = 0;
                     break;                    
                 case MESH_SUBEVENT_PB_TRANSPORT_LINK_CLOSED:
+                    if (session == NULL) break;
                     printf("Link close, reset state\n");
-                    provisioning_done();
-                    break;
+                    provisioning_done(session);
+                    session->pb_adv_cid = MESH_PB_TRANSPORT_INVALID_CID;
+                    return;
             }
             break;
         case PROVISIONING_DATA_PACKET:
+            if (session == NULL) break;
             // check state
-            switch (provisioner_state){
+            switch (session->state){
                 case PROVISIONER_W4_CAPABILITIES:
-                    if (packet[0] != MESH_PROV_CAPABILITIES) provisioning_handle_provisioning_error(0x03);
+                    if (packet[0] != MESH_PROV_CAPABILITIES) provisioning_handle_provisioning_error(session, 0x03);
                     printf("MESH_PROV_CAPABILITIES: ");
                     printf_hexdump(&packet[1], size-1);
-                    provisioning_handle_capabilities(pb_adv_cid, &packet[1], size-1);
+                    provisioning_handle_capabilities(session, &packet[1], size-1);
                     break;
                 case PROVISIONER_W4_PUB_KEY:
-                    if (packet[0] != MESH_PROV_PUB_KEY) provisioning_handle_provisioning_error(0x03);
+                    if (packet[0] != MESH_PROV_PUB_KEY) provisioning_handle_provisioning_error(session, 0x03);
                     printf("MESH_PROV_PUB_KEY: ");
                     printf_hexdump(&packet[1], size-1);
-                    provisioning_handle_public_key(pb_adv_cid, &packet[1], size-1);
+                    provisioning_handle_public_key(session, &packet[1], size-1);
                     break;
                 case PROVISIONER_W4_INPUT_COMPLETE:
-                    if (packet[0] != MESH_PROV_INPUT_COMPLETE) provisioning_handle_provisioning_error(0x03);
+                    if (packet[0] != MESH_PROV_INPUT_COMPLETE) provisioning_handle_provisioning_error(session, 0x03);
                     printf("MESH_PROV_INPUT_COMPLETE: ");
                     printf_hexdump(&packet[1], size-1);
-                    provisioning_handle_input_complete(pb_adv_cid);
+                    provisioning_handle_input_complete(session);
                     break;
                 case PROVISIONER_W4_CONFIRM:
-                    if (packet[0] != MESH_PROV_CONFIRM) provisioning_handle_provisioning_error(0x03);
+                    if (packet[0] != MESH_PROV_CONFIRM) provisioning_handle_provisioning_error(session, 0x03);
                     printf("MESH_PROV_CONFIRM: ");
                     printf_hexdump(&packet[1], size-1);
-                    provisioning_handle_confirmation(pb_adv_cid, &packet[1], size-1);
+                    provisioning_handle_confirmation(session, &packet[1], size-1);
                     break;
                 case PROVISIONER_W4_RANDOM:
-                    if (packet[0] != MESH_PROV_RANDOM) provisioning_handle_provisioning_error(0x03);
+                    if (packet[0] != MESH_PROV_RANDOM) provisioning_handle_provisioning_error(session, 0x03);
                     printf("MESH_PROV_RANDOM:  ");
                     printf_hexdump(&packet[1], size-1);
-                    provisioning_handle_random(pb_adv_cid, &packet[1], size-1);
+                    provisioning_handle_random(session, &packet[1], size-1);
                     break;
                 case PROVISIONER_W4_COMPLETE:
-                    if (packet[0] != MESH_PROV_COMPLETE) provisioning_handle_provisioning_error(0x03);
+                    if (packet[0] != MESH_PROV_COMPLETE) provisioning_handle_provisioning_error(session, 0x03);
                     printf("MESH_PROV_COMPLETE:  ");
-                    provisioning_handle_complete(pb_adv_cid);
+                    provisioning_handle_complete(session);
                     break;
                 default:
-                    printf("TODO: handle provisioning state %x\n", provisioner_state);
+                    printf("TODO: handle provisioning state %x\n", session->state);
                     break;
             }            
             break;
         default:
             break;
     }
-    provisioning_run();
+    if (session == NULL) return;
+    provisioning_run(session);
 }
 
 static void prov_key_generated(void * arg){
     UNUSED(arg);
+    prov_ecc_generation_active = 0;
     printf("ECC-P256: ");
     printf_hexdump(prov_ec_q, sizeof(prov_ec_q));
     // allow override
@@ -722,7 +764,11 @@ static void prov_key_generated(void * arg){
 }
 
 void provisioning_provisioner_init(void){
-    pb_adv_cid = MESH_PB_TRANSPORT_INVALID_CID;
+    int i;
+    for (i=0;i<MESH_PB_ADV_NUM_LINKS;i++){
+        provisioning_sessions[i].pb_adv_cid = MESH_PB_TRANSPORT_INVALID_CID;
+        provisioning_sessions[i].state = PROVISIONER_IDLE;
+    }
     pb_adv_init();
     pb_adv_register_packet_handler(&provisioning_handle_pdu);
 }
@@ -732,71 +778,77 @@ void provisioning_provisioner_register_packet_handler(btstack_packet_handler_t p
 }
 
 uint16_t provisioning_provisioner_start_provisioning(const uint8_t * device_uuid){
-    // generate new public key
-    btstack_crypto_ecc_p256_generate_key(&prov_ecc_p256_request, prov_ec_q, &prov_key_generated, NULL);
-
-    if (pb_adv_cid == MESH_PB_TRANSPORT_INVALID_CID) {
-        pb_adv_cid = pb_adv_create_link(device_uuid);
+    // generate new public key, unless it's already in use by other sessions
+    if ((provisioning_session_active() == 0) && (prov_ecc_generation_active == 0)){
+        prov_ecc_generation_active = 1;
+        btstack_crypto_ecc_p256_generate_key(&prov_ecc_p256_request, prov_ec_q, &prov_key_generated, NULL);
     }
-    return pb_adv_cid;
+
+    // session is bound to link on link open
+    return pb_adv_create_link(device_uuid);
 }
 
 void provisioning_provisioner_set_static_oob(uint16_t the_pb_adv_cid, uint16_t static_oob_len, const uint8_t * static_oob_data){
-    UNUSED(the_pb_adv_cid);
-    prov_static_oob_data = static_oob_data;
-    prov_static_oob_len  = btstack_min(static_oob_len, 16);
+    provisioning_session_t * session = provisioning_session_for_cid(the_pb_adv_cid);
+    if (session == NULL) return;
+    session->static_oob_data = static_oob_data;
+    session->static_oob_len  = btstack_min(static_oob_len, 16);
 }
 
 uint8_t provisioning_provisioner_select_authentication_method(uint16_t the_pb_adv_cid, uint8_t algorithm, uint8_t public_key_used, uint8_t authentication_method, uint8_t authentication_action, uint8_t authentication_size){
-    UNUSED(the_pb_adv_cid);
+    provisioning_session_t * session = provisioning_session_for_cid(the_pb_adv_cid);
+    if (session == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
 
-    if (provisioner_state != PROVISIONER_W4_AUTH_CONFIGURATION) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (session->state != PROVISIONER_W4_AUTH_CONFIGURATION) return ERROR_CODE_COMMAND_DISALLOWED;
 
-    prov_start_algorithm = algorithm;
-    prov_start_public_key_used = public_key_used;
-    prov_start_authentication_method = authentication_method;
-    prov_start_authentication_action = authentication_action;
-    prov_start_authentication_size   = authentication_size;
-    provisioner_state = PROVISIONER_SEND_START;
+    session->start_algorithm = algorithm;
+    session->start_public_key_used = public_key_used;
+    session->start_authentication_method = authentication_method;
+    session->start_authentication_action = authentication_action;
+    session->start_authentication_size   = authentication_size;
+    session->state = PROVISIONER_SEND_START;
 
     return ERROR_CODE_SUCCESS;
 }
 
 uint8_t provisioning_provisioner_public_key_oob_received(uint16_t the_pb_adv_cid, const uint8_t * public_key){
-    UNUSED(the_pb_adv_cid);
+    provisioning_session_t * session = provisioning_session_for_cid(the_pb_adv_cid);
+    if (session == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
 
-    if (provisioner_state != PROVISIONER_W4_PUB_KEY_OOB) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (session->state != PROVISIONER_W4_PUB_KEY_OOB) return ERROR_CODE_COMMAND_DISALLOWED;
 
     // store for confirmation inputs: len 64
-    (void)memcpy(&prov_confirmation_inputs[81], public_key, 64);
+    (void)memcpy(&session->confirmation_inputs[81], public_key, 64);
 
     // store remote q
-    (void)memcpy(remote_ec_q, public_key, sizeof(remote_ec_q));
+    (void)memcpy(session->remote_ec_q, public_key, sizeof(session->remote_ec_q));
 
     // continue procedure
-    provisioner_state = PROVISIONER_SEND_PUB_KEY;
-    provisioning_run();
+    session->state = PROVISIONER_SEND_PUB_KEY;
+    provisioning_run(session);
 
     return ERROR_CODE_SUCCESS;
 }
 
 void provisioning_provisioner_input_oob_complete_numeric(uint16_t the_pb_adv_cid, uint32_t input_oob){
-    UNUSED(the_pb_adv_cid);
-    if (provisioner_state != PROVISIONER_W4_INPUT_OOK) return;
+    provisioning_session_t * session = provisioning_session_for_cid(the_pb_adv_cid);
+    if (session == NULL) return;
+    if (session->state != PROVISIONER_W4_INPUT_OOK) return;
 
     // store input_oob as auth value
-    big_endian_store_32(auth_value, 12, input_oob);
-    provisioning_handle_auth_value_ready();
+    big_endian_store_32(session->auth_value, 12, input_oob);
+    provisioning_handle_auth_value_ready(session);
 }
 
 void provisioning_provisioner_input_oob_complete_alphanumeric(uint16_t the_pb_adv_cid, const uint8_t * input_oob_data, uint16_t input_oob_len){
-    UNUSED(the_pb_adv_cid);
-    if (provisioner_state != PROVISIONER_W4_INPUT_OOK) return;
+    provisioning_session_t * session = provisioning_session_for_cid(the_pb_adv_cid);
+    if (session == NULL) return;
+    if (session->state != PROVISIONER_W4_INPUT_OOK) return;
 
     // store input_oob and fillup with zeros
     input_oob_len = btstack_min(input_oob_len, 16);
-    memset(auth_value, 0, 16);
-    (void)memcpy(auth_value, input_oob_data, input_oob_len);
-    provisioning_handle_auth_value_ready();
+    memset(session->auth_value, 0, 16);
+    (void)memcpy(session->auth_value, input_oob_data, input_oob_len);
+    provisioning_handle_auth_value_ready(session);
 }
 
@@ -91,8 +91,6 @@ void CHECK_EQUAL_ARRAY(const uint8_t * expected, uint8_t * actual, int size){
 // mock
 extern "C" {
 
-    void att_set_db(uint8_t const * db){
-    }
     void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
     }
     int hci_can_send_command_packet_now(void){
@@ -107,6 +105,17 @@ extern "C" {
         printf("hci_send_cmd opcode %04x\n", cmd->opcode);
         return 0;
     }
+    static uint8_t hci_cmd_buffer[256];
+    int hci_reserve_packet_buffer(void){
+        return 1;
+    }
+    uint8_t * hci_get_outgoing_packet_buffer(void){
+        return hci_cmd_buffer;
+    }
+    int hci_send_prepared_cmd_packet(uint16_t size){
+        printf("hci_send_prepared_cmd_packet opcode %04x\n", little_endian_read_16(hci_cmd_buffer, 0));
+        return 0;
+    }
 }
 
 TEST_GROUP(AttDbUtil){
@@ -171,6 +180,181 @@ TEST(AttDbUtil, GattHash){
     CHECK_EQUAL_ARRAY(gatt_database_hash_expected, cmac_calculated, 16);
 }
 
+static uint16_t value_changed_handle;
+static uint8_t  value_changed_data[4];
+
+static void value_changed_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t * value, uint16_t value_len){
+    UNUSED(con_handle);
+    value_changed_handle = attribute_handle;
+    (void)memcpy(value_changed_data, value, btstack_min(value_len, sizeof(value_changed_data)));
+}
+
+TEST(AttDbUtil, InlineValues){
+    const uint8_t initial_value[] = { 1, 2, 3, 4 };
+    att_db_util_add_service_uuid16(0x1234);
+    uint16_t value_handle = att_db_util_add_characteristic_uuid16(0x2345, ATT_PROPERTY_READ | ATT_PROPERTY_WRITE | ATT_PROPERTY_WRITE_WITHOUT_RESPONSE, ATT_SECURITY_NONE, ATT_SECURITY_NONE, (uint8_t*)initial_value, sizeof(initial_value));
+    uint16_t zero_handle  = att_db_util_add_characteristic_uuid16(0x2346, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, NULL, 2);
+
+    uint8_t * db = att_db_util_get_address();
+    att_set_db(db);
+    att_set_db_inline_values(db, &value_changed_callback);
+    value_changed_handle = 0;
+
+    att_connection_t att_connection;
+    memset(&att_connection, 0, sizeof(att_connection));
+    att_connection.mtu = 23;
+    att_connection.max_mtu = 23;
+
+    uint8_t request[7];
+    uint8_t response[23];
+    uint16_t response_len;
+
+    // zero-initialized storage
+    request[0] = ATT_READ_REQUEST;
+    little_endian_store_16(request, 1, zero_handle);
+    response_len = att_handle_request(&att_connection, request, 3, response);
+    CHECK_EQUAL(3, response_len);
+    CHECK_EQUAL(0, response[1]);
+    CHECK_EQUAL(0, response[2]);
+
+    // write request with matching length
+    const uint8_t new_value[] = { 5, 6, 7, 8 };
+    request[0] = ATT_WRITE_REQUEST;
+    little_endian_store_16(request, 1, value_handle);
+    (void)memcpy(&request[3], new_value, sizeof(new_value));
+    response_len = att_handle_request(&att_connection, request, 7, response);
+    CHECK_EQUAL(1, response_len);
+    CHECK_EQUAL(ATT_WRITE_RESPONSE, response[0]);
+    CHECK_EQUAL(value_handle, value_changed_handle);
+    CHECK_EQUAL_ARRAY((uint8_t*) new_value, value_changed_data, sizeof(new_value));
+
+    // write request with wrong length
+    response_len = att_handle_request(&att_connection, request, 5, response);
+    CHECK_EQUAL(ATT_ERROR_RESPONSE, response[0]);
+    CHECK_EQUAL(ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH, response[4]);
+
+    // write to read-only value
+    little_endian_store_16(request, 1, zero_handle);
+    response_len = att_handle_request(&att_connection, request, 5, response);
+    CHECK_EQUAL(ATT_ERROR_RESPONSE, response[0]);
+    CHECK_EQUAL(ATT_ERROR_WRITE_NOT_PERMITTED, response[4]);
+
+    // read returns new value
+    request[0] = ATT_READ_REQUEST;
+    little_endian_store_16(request, 1, value_handle);
+    response_len = att_handle_request(&att_connection, request, 3, response);
+    CHECK_EQUAL(5, response_len);
+    CHECK_EQUAL_ARRAY((uint8_t*) new_value, &response[1], sizeof(new_value));
+
+    // local update
+    CHECK_TRUE(att_set_inline_value(value_handle, initial_value, sizeof(initial_value)));
+    CHECK_FALSE(att_set_inline_value(value_handle, initial_value, 2));
+    response_len = att_handle_request(&att_connection, request, 3, response);
+    CHECK_EQUAL_ARRAY((uint8_t*) initial_value, &response[1], sizeof(initial_value));
+
+    att_set_db_inline_values(NULL, NULL);
+}
+
+// handles 1..9 with value handles 3, 5, 7 and 9, value handle 9 not covered by handle index
+#define TEST_NUM_CHARACTERISTICS 4
+
+TEST_GROUP(AttDbHandleIndex){
+    att_connection_t att_connection;
+    uint16_t value_handles[TEST_NUM_CHARACTERISTICS];
+
+    void setup(void){
+        att_db_util_init();
+        att_db_util_add_service_uuid16(0x1234);
+        uint8_t i;
+        for (i = 0; i < TEST_NUM_CHARACTERISTICS; i++){
+            value_handles[i] = add_characteristic(i);
+        }
+        att_set_db(att_db_util_get_address());
+        memset(&att_connection, 0, sizeof(att_connection));
+        att_connection.mtu = 23;
+        att_connection.max_mtu = 23;
+    }
+    uint16_t add_characteristic(uint8_t value){
+        return att_db_util_add_characteristic_uuid16(0x2a00 + value, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, &value, 1);
+    }
+    void check_read(uint16_t handle, uint8_t value){
+        uint8_t request[3];
+        uint8_t response[23];
+        request[0] = ATT_READ_REQUEST;
+        little_endian_store_16(request, 1, handle);
+        uint16_t response_len = att_handle_request(&att_connection, request, sizeof(request), response);
+        CHECK_EQUAL(2, response_len);
+        CHECK_EQUAL(ATT_READ_RESPONSE, response[0]);
+        CHECK_EQUAL(value, response[1]);
+    }
+    uint16_t find_information(uint16_t start_handle){
+        uint8_t request[5];
+        uint8_t response[23];
+        request[0] = ATT_FIND_INFORMATION_REQUEST;
+        little_endian_store_16(request, 1, start_handle);
+        little_endian_store_16(request, 3, 0xffff);
+        (void) att_handle_request(&att_connection, request, sizeof(request), response);
+        CHECK_EQUAL(ATT_FIND_INFORMATION_REPLY, response[0]);
+        // first handle in reply
+        return little_endian_read_16(response, 2);
+    }
+};
+
+TEST(AttDbHandleIndex, Read){
+    CHECK(value_handles[TEST_NUM_CHARACTERISTICS - 1] >= ATT_DB_HANDLE_INDEX_SIZE);
+    uint8_t i;
+    for (i = 0; i < TEST_NUM_CHARACTERISTICS; i++){
+        check_read(value_handles[i], i);
+    }
+}
+
+TEST(AttDbHandleIndex, ReadUnknownHandle){
+    uint8_t request[3];
+    uint8_t response[23];
+    request[0] = ATT_READ_REQUEST;
+    little_endian_store_16(request, 1, value_handles[TEST_NUM_CHARACTERISTICS - 1] + 1);
+    (void) att_handle_request(&att_connection, request, sizeof(request), response);
+    CHECK_EQUAL(ATT_ERROR_RESPONSE, response[0]);
+    CHECK_EQUAL(ATT_ERROR_INVALID_HANDLE, response[4]);
+}
+
+TEST(AttDbHandleIndex, FindInformationFromStartHandle){
+    uint16_t start_handle;
+    for (start_handle = 1; start_handle <= value_handles[TEST_NUM_CHARACTERISTICS - 1]; start_handle++){
+        CHECK_EQUAL(start_handle, find_information(start_handle));
+    }
+}
+
+TEST(AttDbHandleIndex, ExtendedAfterSetDb){
+    att_db_util_init();
+    att_db_util_add_service_uuid16(0x1234);
+    uint16_t value_handle = add_characteristic(0);
+    att_set_db(att_db_util_get_address());
+    // fits into current att db buffer, so att_set_db is not called again and new handle is not indexed
+    uint16_t new_value_handle = add_characteristic(1);
+    CHECK(new_value_handle < ATT_DB_HANDLE_INDEX_SIZE);
+    check_read(new_value_handle, 1);
+    check_read(value_handle, 0);
+}
+
+TEST(AttDbHandleIndex, ModifiedInPlace){
+    static uint8_t db[128];
+    (void)memcpy(db, att_db_util_get_address(), att_db_util_get_size());
+    att_set_db(db);
+    // same handles at other offsets: service with 128-bit UUID
+    att_db_util_init();
+    att_db_util_add_service_uuid128(counter_service_uuid);
+    uint8_t i;
+    for (i = 0; i < TEST_NUM_CHARACTERISTICS; i++){
+        value_handles[i] = add_characteristic(i);
+    }
+    CHECK(att_db_util_get_size() <= sizeof(db));
+    (void)memcpy(db, att_db_util_get_address(), att_db_util_get_size());
+    for (i = 0; i < TEST_NUM_CHARACTERISTICS; i++){
+        check_read(value_handles[i], i);
+    }
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2014 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "hci.h"
+#include "ble/att_db.h"
+#include "btstack_util.h"
+#include "bluetooth.h"
+#include "bluetooth_gatt.h"
+
+#include "att_db_uuid16_index_test.h"
+
+// mock
+extern "C" {
+    void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+        UNUSED(callback_handler);
+    }
+    int hci_can_send_command_packet_now(void){
+        return 1;
+    }
+    HCI_STATE hci_get_state(void){
+        return HCI_STATE_WORKING;
+    }
+    void hci_halting_defer(void){
+    }
+    int hci_send_cmd(const hci_cmd_t *cmd, ...){
+        UNUSED(cmd);
+        return 0;
+    }
+    static uint8_t hci_cmd_buffer[256];
+    int hci_reserve_packet_buffer(void){
+        return 1;
+    }
+    uint8_t * hci_get_outgoing_packet_buffer(void){
+        return hci_cmd_buffer;
+    }
+    int hci_send_prepared_cmd_packet(uint16_t size){
+        UNUSED(size);
+        return 0;
+    }
+}
+
+// 128-bit UUID not based on Bluetooth Base UUID, 3A9C0001-1234-5678-9ABC-DEF012345678
+static const uint8_t custom_uuid128[] = { 0x3A, 0x9C, 0x00, 0x01, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0, 0x12, 0x34, 0x56, 0x78 };
+
+static const uint16_t read_by_type_uuids[] = {
+    GATT_PRIMARY_SERVICE_UUID, GATT_SECONDARY_SERVICE_UUID, GATT_INCLUDE_SERVICE_UUID, GATT_CHARACTERISTICS_UUID,
+    GATT_CHARACTERISTIC_USER_DESCRIPTION, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION,
+    ORG_BLUETOOTH_CHARACTERISTIC_GAP_DEVICE_NAME, ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL, 0x2b2a,
+    0x2345, 0xff11, 0x1234, 0x2a50,
+};
+
+static const uint16_t read_by_group_type_uuids[] = {
+    GATT_PRIMARY_SERVICE_UUID, GATT_SECONDARY_SERVICE_UUID,
+};
+
+static const uint16_t end_handle_offsets[] = { 0, 1, 2, 5, 8, 0x40 };
+
+static const uint16_t mtus[] = { 23, 48, 185 };
+
+static att_connection_t att_connection;
+
+// client characteristic configurations are dynamic
+static uint16_t att_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    const uint8_t value[] = { 0x01, 0x00 };
+    return att_read_callback_handle_blob(value, sizeof(value), offset, buffer, buffer_size);
+}
+
+static uint16_t request_with_index(const uint8_t * index, const uint8_t * request, uint16_t request_len, uint8_t * response){
+    att_set_db_uuid16_index(index);
+    return att_handle_request(&att_connection, (uint8_t *) request, request_len, response);
+}
+
+// send request with and without index and compare responses
+static void check_request(const uint8_t * request, uint16_t request_len){
+    uint8_t response_walk[256];
+    uint8_t response_index[256];
+    uint16_t response_walk_len  = request_with_index(NULL, request, request_len, response_walk);
+    uint16_t response_index_len = request_with_index(profile_uuid16_index, request, request_len, response_index);
+    // the att db walk responds with an empty Read By Group Type Response if the first group is not closed within the range
+    if ((response_walk_len == 2) && (response_walk[0] == ATT_READ_BY_GROUP_TYPE_RESPONSE)){
+        CHECK_EQUAL(5, response_index_len);
+        CHECK_EQUAL(ATT_ERROR_RESPONSE, response_index[0]);
+        CHECK_EQUAL(ATT_ERROR_ATTRIBUTE_NOT_FOUND, response_index[4]);
+        return;
+    }
+    CHECK_EQUAL(response_walk_len, response_index_len);
+    MEMCMP_EQUAL(response_walk, response_index, response_walk_len);
+}
+
+static uint16_t setup_request(uint8_t * request, uint8_t opcode, uint16_t start_handle, uint16_t end_handle){
+    request[0] = opcode;
+    little_endian_store_16(request, 1, start_handle);
+    little_endian_store_16(request, 3, end_handle);
+    return 5;
+}
+
+static void check_uuid16(uint8_t opcode, uint16_t uuid16){
+    uint16_t mtu_index;
+    for (mtu_index = 0; mtu_index < sizeof(mtus) / sizeof(uint16_t); mtu_index++){
+        att_connection.mtu = mtus[mtu_index];
+        uint16_t start_handle;
+        for (start_handle = 1; start_handle <= 0x25; start_handle++){
+            uint16_t i;
+            for (i = 0; i < sizeof(end_handle_offsets) / sizeof(uint16_t); i++){
+                uint16_t end_handle = start_handle + end_handle_offsets[i];
+                uint8_t request[21];
+                // as 16-bit UUID
+                uint16_t pos = setup_request(request, opcode, start_handle, end_handle);
+                little_endian_store_16(request, pos, uuid16);
+                check_request(request, pos + 2);
+                // as 128-bit UUID based on Bluetooth Base UUID
+                pos = setup_request(request, opcode, start_handle, end_handle);
+                uint8_t uuid128[16];
+                uuid_add_bluetooth_prefix(uuid128, uuid16);
+                reverse_128(uuid128, &request[pos]);
+                check_request(request, pos + 16);
+            }
+        }
+    }
+}
+
+TEST_GROUP(AttDbUuid16Index){
+    void setup(void){
+        att_set_db(profile_data);
+        att_set_read_callback(&att_read_callback);
+        memset(&att_connection, 0, sizeof(att_connection));
+        att_connection.mtu = 23;
+        att_connection.max_mtu = 185;
+    }
+    void teardown(void){
+        att_set_db_uuid16_index(NULL);
+    }
+};
+
+TEST(AttDbUuid16Index, OffsetsMatchHandles){
+    // att db starts after version byte
+    const uint8_t * att_db = &profile_data[1];
+    const uint8_t * index_ptr = &profile_uuid16_index[1];
+    uint16_t num_entries = 0;
+    while (true){
+        uint16_t uuid16 = little_endian_read_16(index_ptr, 0);
+        if (uuid16 == 0) break;
+        uint16_t count = little_endian_read_16(index_ptr, 2);
+        bool is_service = (uuid16 == GATT_PRIMARY_SERVICE_UUID) || (uuid16 == GATT_SECONDARY_SERVICE_UUID);
+        uint16_t entry_size = is_service ? 6 : 4;
+        uint16_t i;
+        for (i = 0; i < count; i++){
+            const uint8_t * entry = &index_ptr[4 + (i * entry_size)];
+            uint16_t handle = little_endian_read_16(entry, 0);
+            uint16_t offset = little_endian_read_16(entry, 2);
+            CHECK_EQUAL(handle, little_endian_read_16(att_db, offset + 4));
+            num_entries++;
+        }
+        index_ptr += 4 + (count * entry_size);
+    }
+    CHECK(num_entries > 30);
+}
+
+TEST(AttDbUuid16Index, ReadByType){
+    uint16_t i;
+    for (i = 0; i < sizeof(read_by_type_uuids) / sizeof(uint16_t); i++){
+        check_uuid16(ATT_READ_BY_TYPE_REQUEST, read_by_type_uuids[i]);
+    }
+}
+
+TEST(AttDbUuid16Index, ReadByTypeUuid128){
+    // not covered by index
+    uint8_t request[21];
+    uint16_t start_handle;
+    for (start_handle = 1; start_handle <= 0x25; start_handle++){
+        uint16_t pos = setup_request(request, ATT_READ_BY_TYPE_REQUEST, start_handle, 0xffff);
+        reverse_128(custom_uuid128, &request[pos]);
+        check_request(request, pos + 16);
+    }
+}
+
+TEST(AttDbUuid16Index, ReadByGroupType){
+    uint16_t i;
+    for (i = 0; i < sizeof(read_by_group_type_uuids) / sizeof(uint16_t); i++){
+        check_uuid16(ATT_READ_BY_GROUP_TYPE_REQUEST, read_by_group_type_uuids[i]);
+    }
+}
+
+TEST(AttDbUuid16Index, ReadByTypeFindsCharacteristics){
+    uint8_t request[7];
+    uint8_t response[256];
+    uint16_t pos = setup_request(request, ATT_READ_BY_TYPE_REQUEST, 1, 0xffff);
+    little_endian_store_16(request, pos, ORG_BLUETOOTH_CHARACTERISTIC_GAP_DEVICE_NAME);
+    att_connection.mtu = 185;
+    uint16_t response_len = request_with_index(profile_uuid16_index, request, pos + 2, response);
+    CHECK_EQUAL(ATT_READ_BY_TYPE_RESPONSE, response[0]);
+    // first device name only, as second one has different length
+    CHECK_EQUAL(2 + 2 + 12, response_len);
+    CHECK_EQUAL(0x0003, little_endian_read_16(response, 2));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
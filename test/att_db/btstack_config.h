@@ -27,10 +27,16 @@
 #define ENABLE_SDP_EXTRA_QUERIES
 #define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 #define ENABLE_SOFTWARE_AES128
+#define ENABLE_ATT_DB_INLINE_VALUES
+#define ENABLE_ATT_DB_UUID16_INDEX
+#define ENABLE_ATT_DB_HANDLE_INDEX
 
 // BTstack configuration. buffers, sizes, ...
 #define HCI_ACL_PAYLOAD_SIZE 1024
 #define HCI_INCOMING_PRE_BUFFER_SIZE 6
+
+// small handle index to cover handles beyond index
+#define ATT_DB_HANDLE_INDEX_SIZE 8
 #define NVM_NUM_LINK_KEYS 2
 #define NVM_NUM_DEVICE_DB_ENTRIES 4
 
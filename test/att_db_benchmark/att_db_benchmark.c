@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "att_db_benchmark.c"
+
+// *****************************************************************************
+//
+// ATT DB Benchmark
+//
+// Measures the cost of att_handle_request per opcode for ATT databases of
+// 10, 100 and 1000 attributes created with att_db_util. Each service has
+// 10 attributes and all requests target the last service, which is the worst
+// case for a linear search of the database.
+//
+// Output is CSV, one line per operation and database size. The response
+// length and CRC-8 are deterministic; with -t the timing column is omitted,
+// so the report can be compared against a reference.
+//
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ble/att_db.h"
+#include "ble/att_db_util.h"
+#include "bluetooth.h"
+#include "bluetooth_gatt.h"
+#include "btstack_util.h"
+#include "btstack_run_loop.h"
+#include "hci.h"
+
+#define BENCHMARK_ATTRIBUTES_PER_SERVICE    10
+#define BENCHMARK_SERVICE_UUID16_BASE       0xA000
+#define BENCHMARK_READ_UUID16_BASE          0xB000
+#define BENCHMARK_WRITE_UUID16_BASE         0xC000
+#define BENCHMARK_NOTIFY_UUID16_BASE        0xD000
+#define BENCHMARK_MTU                       247
+
+typedef enum {
+    BENCHMARK_OPERATION_READ,
+    BENCHMARK_OPERATION_READ_BY_TYPE,
+    BENCHMARK_OPERATION_FIND_INFORMATION,
+    BENCHMARK_OPERATION_READ_BY_GROUP_TYPE,
+    BENCHMARK_OPERATION_WRITE,
+    BENCHMARK_OPERATION_NOTIFICATION,
+    BENCHMARK_OPERATION_NUM
+} benchmark_operation_t;
+
+static const char * benchmark_operation_names[] = {
+    "read", "read_by_type", "find_information", "read_by_group_type", "write", "notification"
+};
+
+static const uint16_t benchmark_db_sizes[] = { 10, 100, 1000 };
+
+// 0000FF10-0000-1000-8000-00805F9B34FB
+static const uint8_t benchmark_uuid128[] = { 0x00, 0x00, 0xFF, 0x10, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB};
+
+static att_connection_t benchmark_att_connection;
+static uint8_t  benchmark_request[BENCHMARK_MTU];
+static uint8_t  benchmark_response[BENCHMARK_MTU];
+static uint32_t benchmark_iterations = 100000;
+static bool     benchmark_timing = true;
+
+// handles in last service
+static uint16_t benchmark_service_handle;
+static uint16_t benchmark_read_value_handle;
+static uint16_t benchmark_write_value_handle;
+static uint16_t benchmark_notify_value_handle;
+static uint16_t benchmark_read_uuid16;
+
+// mock
+void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    UNUSED(callback_handler);
+}
+int hci_can_send_command_packet_now(void){
+    return 1;
+}
+HCI_STATE hci_get_state(void){
+    return HCI_STATE_WORKING;
+}
+void hci_halting_defer(void){
+}
+int hci_send_cmd(const hci_cmd_t *cmd, ...){
+    UNUSED(cmd);
+    return 0;
+}
+static uint8_t hci_cmd_buffer[256];
+int hci_reserve_packet_buffer(void){
+    return 1;
+}
+uint8_t * hci_get_outgoing_packet_buffer(void){
+    return hci_cmd_buffer;
+}
+int hci_send_prepared_cmd_packet(uint16_t size){
+    UNUSED(size);
+    return 0;
+}
+uint32_t btstack_run_loop_get_time_ms(void){
+    return 0;
+}
+
+static uint16_t benchmark_att_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    UNUSED(offset);
+    UNUSED(buffer);
+    UNUSED(buffer_size);
+    return 0;
+}
+
+static int benchmark_att_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+    UNUSED(buffer);
+    UNUSED(buffer_size);
+    return 0;
+}
+
+// each service: service declaration + 2 + 2 + 3 + 2 attributes = 10 attributes
+static void benchmark_create_db(uint16_t num_attributes){
+    static uint8_t value[20];
+    uint16_t num_services = num_attributes / BENCHMARK_ATTRIBUTES_PER_SERVICE;
+    uint16_t i;
+    att_db_util_init();
+    for (i=0;i<num_services;i++){
+        benchmark_service_handle = att_db_util_add_service_uuid16(BENCHMARK_SERVICE_UUID16_BASE + i);
+        benchmark_read_uuid16 = BENCHMARK_READ_UUID16_BASE + i;
+        benchmark_read_value_handle = att_db_util_add_characteristic_uuid16(benchmark_read_uuid16,
+            ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, sizeof(value));
+        benchmark_write_value_handle = att_db_util_add_characteristic_uuid16(BENCHMARK_WRITE_UUID16_BASE + i,
+            ATT_PROPERTY_WRITE | ATT_PROPERTY_DYNAMIC, ATT_SECURITY_NONE, ATT_SECURITY_NONE, NULL, 0);
+        benchmark_notify_value_handle = att_db_util_add_characteristic_uuid16(BENCHMARK_NOTIFY_UUID16_BASE + i,
+            ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, sizeof(value));
+        att_db_util_add_characteristic_uuid128(benchmark_uuid128, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, value, sizeof(value));
+    }
+    att_set_db(att_db_util_get_address());
+    att_set_read_callback(&benchmark_att_read_callback);
+    att_set_write_callback(&benchmark_att_write_callback);
+}
+
+// returns request len, or 0 if operation does not use att_handle_request
+static uint16_t benchmark_prepare_request(benchmark_operation_t operation){
+    switch (operation){
+        case BENCHMARK_OPERATION_READ:
+            benchmark_request[0] = ATT_READ_REQUEST;
+            little_endian_store_16(benchmark_request, 1, benchmark_read_value_handle);
+            return 3;
+        case BENCHMARK_OPERATION_READ_BY_TYPE:
+            benchmark_request[0] = ATT_READ_BY_TYPE_REQUEST;
+            little_endian_store_16(benchmark_request, 1, 0x0001);
+            little_endian_store_16(benchmark_request, 3, 0xffff);
+            little_endian_store_16(benchmark_request, 5, benchmark_read_uuid16);
+            return 7;
+        case BENCHMARK_OPERATION_FIND_INFORMATION:
+            benchmark_request[0] = ATT_FIND_INFORMATION_REQUEST;
+            little_endian_store_16(benchmark_request, 1, benchmark_service_handle);
+            little_endian_store_16(benchmark_request, 3, 0xffff);
+            return 5;
+        case BENCHMARK_OPERATION_READ_BY_GROUP_TYPE:
+            benchmark_request[0] = ATT_READ_BY_GROUP_TYPE_REQUEST;
+            little_endian_store_16(benchmark_request, 1, benchmark_service_handle);
+            little_endian_store_16(benchmark_request, 3, 0xffff);
+            little_endian_store_16(benchmark_request, 5, GATT_PRIMARY_SERVICE_UUID);
+            return 7;
+        case BENCHMARK_OPERATION_WRITE:
+            benchmark_request[0] = ATT_WRITE_REQUEST;
+            little_endian_store_16(benchmark_request, 1, benchmark_write_value_handle);
+            memset(&benchmark_request[3], 0x55, 20);
+            return 23;
+        default:
+            return 0;
+    }
+}
+
+static uint16_t benchmark_execute(benchmark_operation_t operation, uint16_t request_len){
+    static const uint8_t value[20] = { 0 };
+    if (operation == BENCHMARK_OPERATION_NOTIFICATION){
+        return att_prepare_handle_value_notification(&benchmark_att_connection, benchmark_notify_value_handle, value, sizeof(value), benchmark_response);
+    }
+    return att_handle_request(&benchmark_att_connection, benchmark_request, request_len, benchmark_response);
+}
+
+static double benchmark_elapsed_ns(const struct timespec * start, const struct timespec * stop){
+    return ((double)(stop->tv_sec - start->tv_sec) * 1e9) + (double)(stop->tv_nsec - start->tv_nsec);
+}
+
+static int benchmark_run(uint16_t num_attributes, benchmark_operation_t operation){
+    uint16_t request_len = benchmark_prepare_request(operation);
+    uint16_t response_len = benchmark_execute(operation, request_len);
+    if ((response_len == 0) || (benchmark_response[0] == ATT_ERROR_RESPONSE)){
+        fprintf(stderr, "%s with %u attributes failed\n", benchmark_operation_names[operation], num_attributes);
+        return -1;
+    }
+    uint8_t response_crc = btstack_crc8_calc(benchmark_response, response_len);
+    printf("%s,%u,%u,%u,0x%02x", benchmark_operation_names[operation], num_attributes, request_len, response_len, response_crc);
+
+    if (benchmark_timing){
+        struct timespec start;
+        struct timespec stop;
+        uint32_t i;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (i=0;i<benchmark_iterations;i++){
+            (void) benchmark_execute(operation, request_len);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        printf(",%.1f", benchmark_elapsed_ns(&start, &stop) / (double) benchmark_iterations);
+    }
+    printf("\n");
+    return 0;
+}
+
+static void usage(const char * name){
+    printf("Usage: %s [-i iterations] [-t]\n", name);
+    printf("  -i iterations  number of requests per operation, default %" PRIu32 "\n", benchmark_iterations);
+    printf("  -t             omit timing, e.g. to compare report against reference\n");
+}
+
+int main(int argc, const char * argv[]){
+    int arg;
+    for (arg = 1; arg < argc; arg++){
+        if ((strcmp(argv[arg], "-i") == 0) && ((arg + 1) < argc)){
+            benchmark_iterations = (uint32_t) strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "-t") == 0){
+            benchmark_timing = false;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    benchmark_att_connection.mtu = BENCHMARK_MTU;
+    benchmark_att_connection.max_mtu = BENCHMARK_MTU;
+
+    printf("operation,attributes,request_len,response_len,response_crc8%s\n", benchmark_timing ? ",ns_per_request" : "");
+    int result = 0;
+    unsigned int i;
+    for (i=0;i<(sizeof(benchmark_db_sizes)/sizeof(benchmark_db_sizes[0]));i++){
+        benchmark_create_db(benchmark_db_sizes[i]);
+        int operation;
+        for (operation = 0; operation < BENCHMARK_OPERATION_NUM; operation++){
+            result |= benchmark_run(benchmark_db_sizes[i], (benchmark_operation_t) operation);
+        }
+    }
+    return (result == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
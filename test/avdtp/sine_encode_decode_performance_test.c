@@ -35,109 +35,324 @@
  *
  */
 
-#include <stdio.h>
+// *****************************************************************************
+//
+// Codec benchmark matrix
+//
+// Encodes and decodes a sine wave with all SBC channel modes, allocation methods,
+// block and subband counts for several bitpools, mSBC and CVSD PLC at different
+// frame loss rates, and btstack_resample. Prints CSV with ns and cycles per frame.
+//
+// Cycles are read from the time stamp counter on x86, on other targets they are
+// derived from the elapsed time and the CPU clock given with -m MHz.
+// Compare against a build with -D SBC_SIMD_OPT=FALSE to get the speedup of the
+// SIMD windowing.
+//
+// *****************************************************************************
+
+#include <inttypes.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <portaudio.h>
+#include <time.h>
 
-#include "btstack_sbc.h"
-#include "avdtp.h"
-#include "avdtp_source.h"
-#include "btstack_stdin.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_HAVE_TSC
+#endif
 
-#define NUM_CHANNELS        2
-#define SAMPLE_RATE         44100
-#define BYTES_PER_AUDIO_SAMPLE   (2*NUM_CHANNELS)
-#define LATENCY             300 // ms
+#include "btstack_cvsd_plc.h"
+#include "btstack_resample.h"
+#include "btstack_sbc.h"
+#include "btstack_util.h"
+#include "hci_dump.h"
+#include "hfp_msbc.h"
+#include "sbc_encoder.h"
 
 #ifndef M_PI
 #define M_PI  3.14159265
 #endif
-#define TABLE_SIZE_441HZ   100
+
+#define BENCHMARK_SAMPLE_RATE       44100
+#define BENCHMARK_MAX_FRAMES        2000
+#define BENCHMARK_MAX_SBC_FRAME     520
+#define BENCHMARK_MAX_PCM_SAMPLES   (16*8*2)
+#define BENCHMARK_RESAMPLE_FRAMES   128
+#define BENCHMARK_CVSD_FRAME        CVSD_FS
 
 typedef struct {
-    int16_t source[TABLE_SIZE_441HZ];
-    int left_phase;
-    int right_phase;
-} paTestData;
+    uint64_t ns;
+    uint64_t cycles;
+} benchmark_time_t;
+
+static const char * channel_mode_names[] = { "mono", "dual_channel", "stereo", "joint_stereo" };
+static const char * allocation_method_names[] = { "loudness", "snr" };
+static const int    sbc_blocks[]   = { 4, 8, 12, 16 };
+static const int    sbc_subbands[] = { 4, 8 };
+static const int    sbc_bitpools[] = { 16, 32, 53 };
+static const int    loss_rates_percent[] = { 0, 1, 5, 10, 20, 50 };
 
-static uint8_t pcm_frame[2*8*16*2];
+static int      num_frames = 1000;
+static uint32_t cpu_mhz;
 
-static paTestData sin_data;
+static int16_t  pcm_input[BENCHMARK_MAX_FRAMES * BENCHMARK_MAX_PCM_SAMPLES];
+static uint8_t  sbc_frames[BENCHMARK_MAX_FRAMES][BENCHMARK_MAX_SBC_FRAME];
+static uint16_t sbc_frame_lengths[BENCHMARK_MAX_FRAMES];
+static int16_t  resample_output[2 * BENCHMARK_RESAMPLE_FRAMES * 2];
+static uint32_t decoded_samples;
+static uint32_t loss_lfsr;
 
-static btstack_sbc_mode_t mode = SBC_MODE_STANDARD;
 static btstack_sbc_encoder_state_t sbc_encoder_state;
 static btstack_sbc_decoder_state_t sbc_decoder_state;
 
+static void benchmark_now(benchmark_time_t * now){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now->ns = ((uint64_t) ts.tv_sec * 1000000000u) + (uint64_t) ts.tv_nsec;
+#ifdef BENCHMARK_HAVE_TSC
+    now->cycles = __rdtsc();
+#else
+    now->cycles = 0;
+#endif
+}
+
+static void benchmark_report(const char * codec, const char * config, int frames, const benchmark_time_t * start, const benchmark_time_t * stop){
+    uint64_t ns = stop->ns - start->ns;
+#ifdef BENCHMARK_HAVE_TSC
+    uint64_t cycles = stop->cycles - start->cycles;
+#else
+    uint64_t cycles = (ns * cpu_mhz) / 1000u;
+#endif
+    printf("%s,%s,%d,%.1f,%.0f\n", codec, config, frames, (double) ns / (double) frames, (double) cycles / (double) frames);
+}
+
+// deterministic frame loss pattern
+static bool benchmark_frame_lost(int loss_rate_percent){
+    loss_lfsr ^= loss_lfsr << 13;
+    loss_lfsr ^= loss_lfsr >> 17;
+    loss_lfsr ^= loss_lfsr << 5;
+    return (int)(loss_lfsr % 100u) < loss_rate_percent;
+}
+
+// 441 Hz on left, 882 Hz on right channel at 44.1 kHz, scaled for other rates
+static void benchmark_fill_sine(int num_channels, int num_samples_per_channel){
+    int i;
+    for (i=0;i<num_samples_per_channel;i++){
+        double phase = ((double) i / 100.0) * M_PI * 2.0;
+        pcm_input[i * num_channels] = (int16_t) (sin(phase) * 16000.0);
+        if (num_channels == 2){
+            pcm_input[(i * num_channels) + 1] = (int16_t) (sin(2.0 * phase) * 16000.0);
+        }
+    }
+}
+
 static void handle_pcm_data(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context){
-    UNUSED(sample_rate);
-    UNUSED(context);
     UNUSED(data);
-    UNUSED(num_samples);
     UNUSED(num_channels);
+    UNUSED(sample_rate);
+    UNUSED(context);
+    decoded_samples += num_samples;
+}
+
+static void benchmark_sbc(int channel_mode, int allocation_method, int blocks, int subbands, int bitpool){
+    benchmark_time_t start;
+    benchmark_time_t stop;
+    char config[80];
+    int num_channels = (channel_mode == SBC_MONO) ? 1 : 2;
+    int frame_samples = blocks * subbands * num_channels;
+    int i;
+
+    snprintf(config, sizeof(config), "%s/%s/b%u/s%u/bp%u", channel_mode_names[channel_mode],
+             allocation_method_names[allocation_method], blocks, subbands, bitpool);
+    benchmark_fill_sine(num_channels, num_frames * blocks * subbands);
+
+    btstack_sbc_encoder_init(&sbc_encoder_state, SBC_MODE_STANDARD, blocks, subbands, allocation_method, BENCHMARK_SAMPLE_RATE, bitpool, channel_mode);
+    benchmark_now(&start);
+    for (i=0;i<num_frames;i++){
+        btstack_sbc_encoder_state_process_data(&sbc_encoder_state, &pcm_input[i * frame_samples]);
+        sbc_frame_lengths[i] = btstack_sbc_encoder_state_sbc_buffer_length(&sbc_encoder_state);
+        (void) memcpy(sbc_frames[i], btstack_sbc_encoder_state_sbc_buffer(&sbc_encoder_state), sbc_frame_lengths[i]);
+    }
+    benchmark_now(&stop);
+    btstack_sbc_encoder_deinit(&sbc_encoder_state);
+    benchmark_report("sbc_encode", config, num_frames, &start, &stop);
+
+    decoded_samples = 0;
+    btstack_sbc_decoder_init(&sbc_decoder_state, SBC_MODE_STANDARD, &handle_pcm_data, NULL);
+    benchmark_now(&start);
+    for (i=0;i<num_frames;i++){
+        btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, sbc_frames[i], sbc_frame_lengths[i]);
+    }
+    benchmark_now(&stop);
+    btstack_sbc_decoder_deinit(&sbc_decoder_state);
+    if (decoded_samples == 0){
+        printf("sbc_decode,%s,failed\n", config);
+        return;
+    }
+    benchmark_report("sbc_decode", config, num_frames, &start, &stop);
 }
 
-static void fill_sine_frame(void *userData, int num_samples_to_write){
-    paTestData *data = (paTestData*)userData;
-    int count = 0;
-    int offset = 0;
-    while (count < num_samples_to_write){
-        uint8_t write_data[BYTES_PER_AUDIO_SAMPLE];
-        *(int16_t*)&write_data[0] = data->source[data->left_phase];
-        *(int16_t*)&write_data[2] = data->source[data->right_phase];
-        
-        memcpy(pcm_frame+offset, write_data, BYTES_PER_AUDIO_SAMPLE);
-        offset += BYTES_PER_AUDIO_SAMPLE;
-        count++;
-
-        data->left_phase += 1;
-        if (data->left_phase >= TABLE_SIZE_441HZ){
-            data->left_phase -= TABLE_SIZE_441HZ;
+static void benchmark_msbc(void){
+    benchmark_time_t start;
+    benchmark_time_t stop;
+    char config[20];
+    hfp_msbc_encoder_t msbc_encoder;
+    unsigned int l;
+    int i;
+
+    hfp_msbc_encoder_init(&msbc_encoder);
+    int frame_samples = hfp_msbc_encoder_num_audio_samples_per_frame(&msbc_encoder);
+    benchmark_fill_sine(1, num_frames * frame_samples);
+    benchmark_now(&start);
+    for (i=0;i<num_frames;i++){
+        hfp_msbc_encoder_encode_audio_frames(&msbc_encoder, &pcm_input[i * frame_samples], 1);
+        hfp_msbc_encoder_read_from_stream(&msbc_encoder, sbc_frames[i], HFP_MSBC_ENCODED_FRAME_SIZE);
+    }
+    benchmark_now(&stop);
+    hfp_msbc_encoder_deinit(&msbc_encoder);
+    benchmark_report("msbc_encode", "-", num_frames, &start, &stop);
+
+    // lost frames are reported as 'no data received' with zeroed payload and are concealed by btstack_sbc_plc
+    static uint8_t lost_frame[HFP_MSBC_ENCODED_FRAME_SIZE];
+    for (l=0;l<(sizeof(loss_rates_percent)/sizeof(int));l++){
+        snprintf(config, sizeof(config), "loss%u%%", loss_rates_percent[l]);
+        loss_lfsr = 0x12345678;
+        btstack_sbc_decoder_init(&sbc_decoder_state, SBC_MODE_mSBC, &handle_pcm_data, NULL);
+        benchmark_now(&start);
+        for (i=0;i<num_frames;i++){
+            if (benchmark_frame_lost(loss_rates_percent[l])){
+                btstack_sbc_decoder_process_data(&sbc_decoder_state, 2, lost_frame, sizeof(lost_frame));
+            } else {
+                btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, sbc_frames[i], HFP_MSBC_ENCODED_FRAME_SIZE);
+            }
         }
-        data->right_phase += 1; 
-        if (data->right_phase >= TABLE_SIZE_441HZ){
-            data->right_phase -= TABLE_SIZE_441HZ;
-        } 
+        benchmark_now(&stop);
+        btstack_sbc_decoder_deinit(&sbc_decoder_state);
+        benchmark_report("msbc_decode_plc", config, num_frames, &start, &stop);
     }
 }
 
-int btstack_main(int argc, const char * argv[]);
-int btstack_main(int argc, const char * argv[]){
-    (void) argc;
-    (void) argv;
-    btstack_sbc_encoder_init(&sbc_encoder_state, SBC_MODE_STANDARD, 16, 8, 2, 44100, 53);
-                    
-    /* initialise sinusoidal wavetable */
+// lost frames are zero frames, which are detected by btstack_cvsd_plc
+static void benchmark_cvsd_plc(void){
+    benchmark_time_t start;
+    benchmark_time_t stop;
+    char config[20];
+    btstack_cvsd_plc_state_t cvsd_plc_state;
+    int16_t frame[BENCHMARK_CVSD_FRAME];
+    int16_t output[BENCHMARK_CVSD_FRAME];
+    unsigned int l;
     int i;
-    for (i=0; i<TABLE_SIZE_441HZ; i++){ 
-        sin_data.source[i] = sin(((double)i/(double)TABLE_SIZE_441HZ) * M_PI * 2.)*32767;
+
+    benchmark_fill_sine(1, num_frames * BENCHMARK_CVSD_FRAME);
+    for (l=0;l<(sizeof(loss_rates_percent)/sizeof(int));l++){
+        snprintf(config, sizeof(config), "loss%u%%", loss_rates_percent[l]);
+        loss_lfsr = 0x12345678;
+        btstack_cvsd_plc_init(&cvsd_plc_state);
+        benchmark_now(&start);
+        for (i=0;i<num_frames;i++){
+            if (benchmark_frame_lost(loss_rates_percent[l])){
+                memset(frame, 0, sizeof(frame));
+            } else {
+                (void) memcpy(frame, &pcm_input[i * BENCHMARK_CVSD_FRAME], sizeof(frame));
+            }
+            btstack_cvsd_plc_process_data(&cvsd_plc_state, frame, BENCHMARK_CVSD_FRAME, output);
+        }
+        benchmark_now(&stop);
+        benchmark_report("cvsd_plc", config, num_frames, &start, &stop);
+    }
+}
+
+// frame = block of BENCHMARK_RESAMPLE_FRAMES stereo samples
+static void benchmark_resample_run(bool polyphase, uint32_t factor){
+    benchmark_time_t start;
+    benchmark_time_t stop;
+    char config[40];
+    btstack_resample_t resample;
+    int i;
+
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+    if (polyphase){
+        btstack_resample_init_polyphase(&resample, 2);
+    } else {
+        btstack_resample_init(&resample, 2);
     }
-    sin_data.left_phase = sin_data.right_phase = 0;
-    
-    btstack_sbc_decoder_init(&sbc_decoder_state, mode, handle_pcm_data, NULL);
-    int num_frames = 10000;
-    uint32_t timestamp_start;
-    uint32_t encoding_time = 0;
-    uint32_t decoding_time = 0;
-    
-    timestamp_start = btstack_run_loop_get_time_ms();
-    for (i=0; i<num_frames; i++){
-        fill_sine_frame(&sin_data, 128);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
+#else
+    UNUSED(polyphase);
+    btstack_resample_init(&resample, 2);
+#endif
+    btstack_resample_set_factor(&resample, factor);
+    snprintf(config, sizeof(config), "%s/0x%05" PRIx32, polyphase ? "polyphase" : "linear", factor);
+    benchmark_now(&start);
+    for (i=0;i<num_frames;i++){
+        btstack_resample_block(&resample, &pcm_input[(i % 8) * BENCHMARK_RESAMPLE_FRAMES * 2], BENCHMARK_RESAMPLE_FRAMES, resample_output);
     }
-    encoding_time = btstack_run_loop_get_time_ms() - timestamp_start;
+    benchmark_now(&stop);
+    benchmark_report("resample", config, num_frames, &start, &stop);
+}
 
-    timestamp_start = btstack_run_loop_get_time_ms();
-    for (i=0; i<num_frames; i++){
-        fill_sine_frame(&sin_data, 128);
-        btstack_sbc_encoder_process_data((int16_t *) pcm_frame);
-        btstack_sbc_decoder_process_data(&sbc_decoder_state, 0, btstack_sbc_encoder_sbc_buffer(), btstack_sbc_encoder_sbc_buffer_length());
+static void benchmark_resample(void){
+    // identity, drift compensation, 44.1 -> 48 kHz
+    static const uint32_t factors[] = { 0x10000, 0x10100, 0xeb33 };
+    unsigned int i;
+    benchmark_fill_sine(2, 8 * BENCHMARK_RESAMPLE_FRAMES);
+    for (i=0;i<(sizeof(factors)/sizeof(uint32_t));i++){
+        benchmark_resample_run(false, factors[i]);
+#ifdef ENABLE_RESAMPLE_POLYPHASE
+        benchmark_resample_run(true, factors[i]);
+#endif
     }
-    decoding_time =  btstack_run_loop_get_time_ms() - timestamp_start - encoding_time;
+}
 
-    printf("%d frames encoded in %dms\n", num_frames, encoding_time);
-    printf("%d frames decoded in %dms\n", num_frames, decoding_time);
-    
-    exit(0);
+static void usage(const char * name){
+    printf("Usage: %s [-f frames] [-m cpu_mhz]\n", name);
+    printf("  -f frames   number of frames per configuration, max %u, default %u\n", BENCHMARK_MAX_FRAMES, num_frames);
+    printf("  -m cpu_mhz  CPU clock to derive cycles from elapsed time, if no cycle counter is available\n");
+}
+
+int main(int argc, const char * argv[]){
+    int arg;
+    for (arg = 1; arg < argc; arg++){
+        if ((strcmp(argv[arg], "-f") == 0) && ((arg + 1) < argc)){
+            num_frames = btstack_min(BENCHMARK_MAX_FRAMES, btstack_max(1, atoi(argv[++arg])));
+        } else if ((strcmp(argv[arg], "-m") == 0) && ((arg + 1) < argc)){
+            cpu_mhz = (uint32_t) strtoul(argv[++arg], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // decoder reports errors for lost frames with log_info
+    hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+
+#if (SBC_SIMD_OPT == TRUE)
+    printf("# SBC analysis windowing: SIMD\n");
+#else
+    printf("# SBC analysis windowing: scalar\n");
+#endif
+#ifdef BENCHMARK_HAVE_TSC
+    printf("# cycles: time stamp counter\n");
+#else
+    printf("# cycles: elapsed time at %" PRIu32 " MHz\n", cpu_mhz);
+#endif
+    printf("codec,config,frames,ns_per_frame,cycles_per_frame\n");
+
+    unsigned int m, a, b, s, p;
+    for (m=0;m<4;m++){
+        for (a=0;a<2;a++){
+            for (b=0;b<(sizeof(sbc_blocks)/sizeof(int));b++){
+                for (s=0;s<(sizeof(sbc_subbands)/sizeof(int));s++){
+                    for (p=0;p<(sizeof(sbc_bitpools)/sizeof(int));p++){
+                        benchmark_sbc(m, a, sbc_blocks[b], sbc_subbands[s], sbc_bitpools[p]);
+                    }
+                }
+            }
+        }
+    }
+    benchmark_msbc();
+    benchmark_cvsd_plc();
+    benchmark_resample();
+    return EXIT_SUCCESS;
 }
@@ -203,6 +203,38 @@ TEST(ADParser, TestMalformed){
     CHECK_EQUAL(ad_iterator_has_more(&context), 0);
 }
 
+TEST(ADParser, TestUuidMatcher){
+    // 16-bit list: 0x180F, 0x180A; 128-bit list: 0x1812 in Bluetooth Base UUID form and a vendor UUID (little endian)
+    uint8_t data[] = {
+        0x05, 0x03, 0x0F, 0x18, 0x0A, 0x18,
+        0x21, 0x07,
+        0xFB, 0x34, 0x9B, 0x5F, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x12, 0x18, 0x00, 0x00,
+        0x0F, 0x0E, 0x0D, 0x0C, 0x0B, 0x0A, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00,
+    };
+    const uint16_t uuid16s[] = { 0x1812, 0x1800, 0x180A };
+    const uint8_t uuid128s[] = {
+        0x00, 0x00, 0x18, 0x0F, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB,
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    };
+    uint16_t table[8];
+    uint16_t matches[5];
+    ad_uuid_matcher_t matcher;
+
+    CHECK_EQUAL(false, ad_uuid_matcher_init(&matcher, table, 6, uuid16s, 3, uuid128s, 2));
+    CHECK_EQUAL(true,  ad_uuid_matcher_init(&matcher, table, 8, uuid16s, 3, uuid128s, 2));
+
+    uint16_t num_matches = ad_uuid_matcher_match(&matcher, sizeof(data), data, matches, 5);
+    CHECK_EQUAL(4, num_matches);
+    // 0x180F matches 128-bit target, 0x180A, 0x1812, vendor UUID
+    CHECK_EQUAL(3, matches[0]);
+    CHECK_EQUAL(2, matches[1]);
+    CHECK_EQUAL(0, matches[2]);
+    CHECK_EQUAL(4, matches[3]);
+
+    CHECK_EQUAL(true, ad_data_contains_uuid128(sizeof(data), data, &uuid128s[0]));
+    CHECK_EQUAL(true, ad_data_contains_uuid16(sizeof(data), data, 0x1812));
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
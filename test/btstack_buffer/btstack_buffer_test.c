@@ -0,0 +1,121 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "btstack_buffer.h"
+
+#define NUM_BUFFERS 3
+#define BUFFER_SIZE 20
+
+static void * storage[BTSTACK_BUFFER_POOL_STORAGE_SIZE(NUM_BUFFERS, BUFFER_SIZE) / sizeof(void *)];
+
+TEST_GROUP(Buffer){
+    btstack_buffer_pool_t pool;
+
+    void setup(void){
+        btstack_buffer_pool_init(&pool, storage, NUM_BUFFERS, BUFFER_SIZE);
+    }
+};
+
+TEST(Buffer, AllocRelease){
+    btstack_buffer_t * buffers[NUM_BUFFERS];
+    int i;
+    for (i=0;i<NUM_BUFFERS;i++){
+        buffers[i] = btstack_buffer_alloc(&pool, 0);
+        CHECK(buffers[i] != NULL);
+    }
+    CHECK_EQUAL(0, btstack_buffer_pool_num_free(&pool));
+    CHECK(btstack_buffer_alloc(&pool, 0) == NULL);
+    for (i=0;i<NUM_BUFFERS;i++){
+        btstack_buffer_release(buffers[i]);
+    }
+    CHECK_EQUAL(NUM_BUFFERS, btstack_buffer_pool_num_free(&pool));
+}
+
+TEST(Buffer, HeadroomTooLarge){
+    CHECK(btstack_buffer_alloc(&pool, BUFFER_SIZE + 1) == NULL);
+    CHECK_EQUAL(NUM_BUFFERS, btstack_buffer_pool_num_free(&pool));
+}
+
+TEST(Buffer, Retain){
+    btstack_buffer_t * buffer = btstack_buffer_alloc(&pool, 0);
+    btstack_buffer_retain(buffer);
+    btstack_buffer_release(buffer);
+    CHECK_EQUAL(NUM_BUFFERS - 1, btstack_buffer_pool_num_free(&pool));
+    btstack_buffer_release(buffer);
+    CHECK_EQUAL(NUM_BUFFERS, btstack_buffer_pool_num_free(&pool));
+}
+
+TEST(Buffer, Headers){
+    const uint8_t payload[] = { 1, 2, 3, 4 };
+    btstack_buffer_t * buffer = btstack_buffer_alloc(&pool, 8);
+    CHECK_EQUAL(8, btstack_buffer_get_headroom(buffer));
+    CHECK_EQUAL(BUFFER_SIZE - 8, btstack_buffer_get_tailroom(buffer));
+    memcpy(btstack_buffer_append(buffer, sizeof(payload)), payload, sizeof(payload));
+    CHECK_EQUAL(sizeof(payload), btstack_buffer_get_len(buffer));
+
+    // lower layers
+    uint8_t * header = btstack_buffer_add_header(buffer, 4);
+    CHECK(header != NULL);
+    header[0] = 0xaa;
+    CHECK(btstack_buffer_add_header(buffer, 4) != NULL);
+    CHECK(btstack_buffer_add_header(buffer, 1) == NULL);
+    CHECK_EQUAL(12, btstack_buffer_get_len(buffer));
+
+    // upper layers
+    CHECK(btstack_buffer_remove_header(buffer, 4) == header);
+    CHECK_EQUAL(0xaa, btstack_buffer_get_data(buffer)[0]);
+    btstack_buffer_remove_header(buffer, 4);
+    MEMCMP_EQUAL(payload, btstack_buffer_get_data(buffer), sizeof(payload));
+    CHECK(btstack_buffer_remove_header(buffer, 5) == NULL);
+
+    btstack_buffer_truncate(buffer, 2);
+    CHECK_EQUAL(2, btstack_buffer_get_len(buffer));
+    btstack_buffer_truncate(buffer, 3);
+    CHECK_EQUAL(2, btstack_buffer_get_len(buffer));
+
+    CHECK(btstack_buffer_append(buffer, BUFFER_SIZE) == NULL);
+    btstack_buffer_release(buffer);
+}
+
+TEST(Buffer, Chain){
+    btstack_buffer_t * head = btstack_buffer_alloc(&pool, 0);
+    btstack_buffer_t * middle = btstack_buffer_alloc(&pool, 0);
+    btstack_buffer_t * tail = btstack_buffer_alloc(&pool, 0);
+    uint8_t i;
+    for (i=0;i<5;i++){
+        *btstack_buffer_append(head, 1) = i;
+    }
+    for (i=5;i<10;i++){
+        *btstack_buffer_append(middle, 1) = i;
+    }
+    for (i=10;i<12;i++){
+        *btstack_buffer_append(tail, 1) = i;
+    }
+    btstack_buffer_chain(head, middle);
+    btstack_buffer_chain(head, tail);
+    CHECK(btstack_buffer_get_next(head) == middle);
+    CHECK(btstack_buffer_get_next(middle) == tail);
+    CHECK_EQUAL(12, btstack_buffer_get_total_len(head));
+
+    uint8_t data[12];
+    CHECK_EQUAL(12, btstack_buffer_copy(head, 0, data, sizeof(data)));
+    for (i=0;i<12;i++){
+        CHECK_EQUAL(i, data[i]);
+    }
+    memset(data, 0, sizeof(data));
+    CHECK_EQUAL(4, btstack_buffer_copy(head, 3, data, 4));
+    CHECK_EQUAL(3, data[0]);
+    CHECK_EQUAL(6, data[3]);
+    CHECK_EQUAL(1, btstack_buffer_copy(head, 11, data, 4));
+    CHECK_EQUAL(11, data[0]);
+
+    // middle retained by other layer
+    btstack_buffer_retain(middle);
+    btstack_buffer_release(head);
+    CHECK_EQUAL(NUM_BUFFERS - 2, btstack_buffer_pool_num_free(&pool));
+    btstack_buffer_release(middle);
+    CHECK_EQUAL(NUM_BUFFERS, btstack_buffer_pool_num_free(&pool));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
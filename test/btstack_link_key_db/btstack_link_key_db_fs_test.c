@@ -45,6 +45,39 @@ TEST(RemoteDeviceDB, SinglePutGetDeleteKey){
     CHECK(btstack_link_key_db_fs_instance()->get_link_key(bd_addr, test_link_key, &test_link_key_type) == 0);
 }
 
+TEST(RemoteDeviceDB, PutIterateReload){
+    const btstack_link_key_db_t * db = btstack_link_key_db_fs_instance();
+    bd_addr_t addr_2 = {0x00, 0x01, 0x02, 0x03, 0x04, 0x02 };
+    link_key_t test_link_key;
+    link_key_type_t test_link_key_type;
+
+    db->put_link_key(bd_addr, link_key, link_key_type);
+    db->put_link_key(addr_2, link_key, (link_key_type_t) 5);
+
+    // drop in-memory table and read files again
+    db->close();
+    db->open();
+    CHECK(db->get_link_key(addr_2, test_link_key, &test_link_key_type) == 1);
+    CHECK(memcmp(link_key, test_link_key, 16) == 0);
+    CHECK_EQUAL(5, test_link_key_type);
+
+    // iterate and delete all
+    btstack_link_key_iterator_t it;
+    bd_addr_t it_addr;
+    int count = 0;
+    CHECK(db->iterator_init(&it) == 1);
+    while (db->iterator_get_next(&it, it_addr, test_link_key, &test_link_key_type)){
+        count++;
+        db->delete_link_key(it_addr);
+    }
+    db->iterator_done(&it);
+    CHECK_EQUAL(2, count);
+
+    db->close();
+    db->open();
+    CHECK(db->get_link_key(bd_addr, test_link_key, &test_link_key_type) == 0);
+    CHECK(db->get_link_key(addr_2, test_link_key, &test_link_key_type) == 0);
+}
 
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
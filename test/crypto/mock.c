@@ -40,15 +40,20 @@ static void aes128_report_result(void){
 	mock_simulate_hci_event(&le_enc_result[0], sizeof(le_enc_result));
 }
 
-int hci_send_cmd(const hci_cmd_t *cmd, ...){
-    va_list argptr;
-    va_start(argptr, cmd);
-    uint16_t len = hci_cmd_create_from_template(packet_buffer, cmd, argptr);
-    va_end(argptr);
+int hci_reserve_packet_buffer(void){
+	return 1;
+}
+
+uint8_t * hci_get_outgoing_packet_buffer(void){
+	return packet_buffer;
+}
+
+int hci_send_prepared_cmd_packet(uint16_t len){
+	uint16_t opcode = little_endian_read_16(packet_buffer, 0);
 	hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet_buffer, len);
 	// dump_packet(HCI_COMMAND_DATA_PACKET, packet_buffer, len);
 	packet_buffer_len = len;
-	if (cmd->opcode ==  hci_le_encrypt.opcode){
+	if (opcode ==  hci_le_encrypt.opcode){
 	    uint8_t * key_flipped = &packet_buffer[3];
 	    uint8_t key[16];
 		reverse_128(key_flipped, key);
@@ -61,5 +66,13 @@ int hci_send_cmd(const hci_cmd_t *cmd, ...){
 	return 0;
 }
 
+int hci_send_cmd(const hci_cmd_t *cmd, ...){
+    va_list argptr;
+    va_start(argptr, cmd);
+    uint16_t len = hci_cmd_create_from_template(packet_buffer, cmd, argptr);
+    va_end(argptr);
+	return hci_send_prepared_cmd_packet(len);
+}
+
 void hci_halting_defer(void){
 }
@@ -101,6 +101,17 @@ extern "C" {
         printf("hci_send_cmd opcode %04x\n", cmd->opcode);
         return 0;
     }
+    static uint8_t hci_cmd_buffer[256];
+    int hci_reserve_packet_buffer(void){
+        return 1;
+    }
+    uint8_t * hci_get_outgoing_packet_buffer(void){
+        return hci_cmd_buffer;
+    }
+    int hci_send_prepared_cmd_packet(uint16_t size){
+        printf("hci_send_prepared_cmd_packet opcode %04x\n", little_endian_read_16(hci_cmd_buffer, 0));
+        return 0;
+    }
 }
 
 TEST_GROUP(AES_CMAC){
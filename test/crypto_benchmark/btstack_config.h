@@ -0,0 +1,23 @@
+//
+// btstack_config.h for crypto_benchmark
+//
+// AES128 and ECC P-256 implementation are selected in Makefile
+//
+
+#ifndef BTSTACK_CONFIG_H
+#define BTSTACK_CONFIG_H
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_LE_SECURE_CONNECTIONS
+#define ENABLE_LOG_ERROR
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1024
+#define HCI_INCOMING_PRE_BUFFER_SIZE 6
+
+#endif
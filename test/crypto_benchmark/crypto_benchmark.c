@@ -0,0 +1,427 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "crypto_benchmark.c"
+
+// *****************************************************************************
+//
+// Crypto Benchmark
+//
+// Drives btstack_crypto through its asynchronous API and reports operations
+// per second and the latency distribution per operation. The backend is selected
+// at compile time, see Makefile:
+// - crypto_benchmark_software:   rijndael for AES128, micro-ecc for ECC P-256
+// - crypto_benchmark_mbedtls:    rijndael for AES128, mbedTLS for ECC P-256
+// - crypto_benchmark_controller: HCI LE Encrypt, LE Read Local P-256 Public Key and LE Generate DHKey
+//
+// HCI commands are answered by a mocked Controller. Its processing time is not
+// counted, instead, each HCI command adds the configured latency to a virtual
+// clock. Latency of an operation = host CPU time + HCI latency per command.
+//
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bluetooth.h"
+#include "btstack_crypto.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "rijndael.h"
+#include "uECC.h"
+
+#if defined(ENABLE_SOFTWARE_AES128) && defined(ENABLE_MICRO_ECC_P256)
+#define BENCHMARK_BACKEND "software"
+#elif defined(ENABLE_SOFTWARE_AES128) && defined(HAVE_MBEDTLS_ECC_P256)
+#define BENCHMARK_BACKEND "mbedtls"
+#else
+#define BENCHMARK_BACKEND "controller"
+#endif
+
+#define BENCHMARK_MAX_ITERATIONS    100000
+#define BENCHMARK_AES_ITERATIONS    10000
+#define BENCHMARK_ECC_ITERATIONS    20
+
+typedef struct {
+    const char * name;
+    uint32_t iterations;
+    void (*start)(void);
+    int  (*verify)(void);
+} benchmark_operation_t;
+
+// FIPS-197 C.1
+static const uint8_t aes128_key[]        = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const uint8_t aes128_plaintext[]  = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+static const uint8_t aes128_ciphertext[] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+// RFC 4493, Examples 2 and 4
+static const uint8_t cmac_key[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const uint8_t cmac_message[] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+static const uint8_t cmac_16_expected[] = { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c };
+static const uint8_t cmac_64_expected[] = { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe };
+
+// AES-CCM with 13 byte nonce and 8 byte MIC, as used for Mesh Network PDUs
+static const uint8_t ccm_nonce[13] = { 0x00, 0x03, 0x12, 0x34, 0x56, 0x12, 0x01, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78 };
+static const uint8_t ccm_plaintext[16] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 };
+
+static union {
+    btstack_crypto_aes128_t      aes128;
+    btstack_crypto_aes128_cmac_t cmac;
+    btstack_crypto_ccm_t         ccm;
+    btstack_crypto_ecc_p256_t    ecc_p256;
+} benchmark_request;
+
+static uint8_t  benchmark_output[64];
+static uint8_t  benchmark_ccm_ciphertext[16];
+static uint8_t  benchmark_ccm_mic[8];
+static uint8_t  benchmark_ecc_public_key[64];
+static bool     benchmark_done;
+static uint32_t benchmark_iterations_divider = 1;
+static uint64_t benchmark_latencies_ns[BENCHMARK_MAX_ITERATIONS];
+
+// mocked Controller
+static btstack_packet_callback_registration_t * mock_event_handler;
+static uint8_t  mock_hci_cmd_buffer[260];
+static uint8_t  mock_event[80];
+static uint16_t mock_event_len;
+static uint32_t mock_hci_latency_us;
+static uint64_t mock_virtual_time_ns;
+static uint64_t mock_controller_time_ns;
+static uint32_t mock_num_commands;
+static uint32_t mock_random_state = 0x12345678;
+static uint8_t  mock_ecc_private_key[32];
+
+static uint64_t benchmark_clock_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000u) + (uint64_t) now.tv_nsec;
+}
+
+// benchmark time excludes mocked Controller and includes virtual HCI latency
+static uint64_t benchmark_now_ns(void){
+    return benchmark_clock_ns() - mock_controller_time_ns + mock_virtual_time_ns;
+}
+
+// xorshift32, deterministic
+static int mock_random(uint8_t * buffer, unsigned size){
+    unsigned i;
+    for (i=0;i<size;i++){
+        mock_random_state ^= mock_random_state << 13;
+        mock_random_state ^= mock_random_state >> 17;
+        mock_random_state ^= mock_random_state << 5;
+        buffer[i] = (uint8_t) mock_random_state;
+    }
+    return 1;
+}
+
+static void mock_command_complete(uint16_t opcode, const uint8_t * data, uint16_t data_len){
+    mock_event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    mock_event[1] = (uint8_t) (4 + data_len);
+    mock_event[2] = 1;
+    little_endian_store_16(mock_event, 3, opcode);
+    mock_event[5] = ERROR_CODE_SUCCESS;
+    (void) memcpy(&mock_event[6], data, data_len);
+    mock_event_len = 6 + data_len;
+}
+
+static void mock_le_meta_event(uint8_t subevent_code, const uint8_t * data, uint16_t data_len){
+    mock_event[0] = HCI_EVENT_LE_META;
+    mock_event[1] = (uint8_t) (2 + data_len);
+    mock_event[2] = subevent_code;
+    mock_event[3] = ERROR_CODE_SUCCESS;
+    (void) memcpy(&mock_event[4], data, data_len);
+    mock_event_len = 4 + data_len;
+}
+
+// result is reported by mock_controller_process, LE Meta events are sent without Command Status
+static void mock_controller_handle_command(const uint8_t * packet){
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    uint8_t data[64];
+    uint8_t key[16];
+    uint8_t plaintext[16];
+    uint8_t ciphertext[16];
+    uint8_t public_key[64];
+    uint8_t dhkey[32];
+    uint32_t rk[RKLENGTH(KEYBITS)];
+    int nrounds;
+
+    if (opcode == hci_le_rand.opcode){
+        mock_random(data, 8);
+        mock_command_complete(opcode, data, 8);
+    } else if (opcode == hci_le_encrypt.opcode){
+        reverse_128(&packet[3], key);
+        reverse_128(&packet[19], plaintext);
+        nrounds = rijndaelSetupEncrypt(rk, key, KEYBITS);
+        rijndaelEncrypt(rk, nrounds, plaintext, ciphertext);
+        reverse_128(ciphertext, data);
+        mock_command_complete(opcode, data, 16);
+    } else if (opcode == hci_le_read_local_p256_public_key.opcode){
+        uECC_set_rng(&mock_random);
+        uECC_make_key(public_key, mock_ecc_private_key);
+        reverse_256(&public_key[0],  &data[0]);
+        reverse_256(&public_key[32], &data[32]);
+        mock_le_meta_event(HCI_SUBEVENT_LE_READ_LOCAL_P256_PUBLIC_KEY_COMPLETE, data, 64);
+    } else if (opcode == hci_le_generate_dhkey.opcode){
+        reverse_256(&packet[3],  &public_key[0]);
+        reverse_256(&packet[35], &public_key[32]);
+        uECC_set_rng(&mock_random);
+        uECC_shared_secret(public_key, mock_ecc_private_key, dhkey);
+        reverse_256(dhkey, data);
+        mock_le_meta_event(HCI_SUBEVENT_LE_GENERATE_DHKEY_COMPLETE, data, 32);
+    } else {
+        log_error("mock controller: unexpected command 0x%04x", opcode);
+        return;
+    }
+    mock_num_commands++;
+    mock_virtual_time_ns += (uint64_t) mock_hci_latency_us * 1000u;
+}
+
+// deliver pending event, returns false if none
+static bool mock_controller_process(void){
+    uint8_t event[sizeof(mock_event)];
+    uint16_t event_len = mock_event_len;
+    if (event_len == 0) return false;
+    (void) memcpy(event, mock_event, event_len);
+    mock_event_len = 0;
+    (*mock_event_handler->callback)(HCI_EVENT_PACKET, 0, event, event_len);
+    return true;
+}
+
+void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    mock_event_handler = callback_handler;
+}
+HCI_STATE hci_get_state(void){
+    return HCI_STATE_WORKING;
+}
+int hci_can_send_command_packet_now(void){
+    return mock_event_len == 0;
+}
+void hci_halting_defer(void){
+}
+int hci_reserve_packet_buffer(void){
+    return 1;
+}
+uint8_t * hci_get_outgoing_packet_buffer(void){
+    return mock_hci_cmd_buffer;
+}
+int hci_send_prepared_cmd_packet(uint16_t size){
+    UNUSED(size);
+    uint64_t start_ns = benchmark_clock_ns();
+    mock_controller_handle_command(mock_hci_cmd_buffer);
+    mock_controller_time_ns += benchmark_clock_ns() - start_ns;
+    return 0;
+}
+int hci_send_cmd(const hci_cmd_t *cmd, ...){
+    va_list argptr;
+    va_start(argptr, cmd);
+    uint16_t len = hci_cmd_create_from_template(mock_hci_cmd_buffer, cmd, argptr);
+    va_end(argptr);
+    return hci_send_prepared_cmd_packet(len);
+}
+uint32_t btstack_run_loop_get_time_ms(void){
+    return (uint32_t) (benchmark_now_ns() / 1000000u);
+}
+
+// operations
+static void benchmark_operation_done(void * arg){
+    UNUSED(arg);
+    benchmark_done = true;
+}
+
+static void benchmark_aes128_start(void){
+    btstack_crypto_aes128_encrypt(&benchmark_request.aes128, aes128_key, aes128_plaintext, benchmark_output, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_aes128_verify(void){
+    return memcmp(benchmark_output, aes128_ciphertext, 16);
+}
+
+static void benchmark_cmac_16_start(void){
+    btstack_crypto_aes128_cmac_message(&benchmark_request.cmac, cmac_key, 16, cmac_message, benchmark_output, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_cmac_16_verify(void){
+    return memcmp(benchmark_output, cmac_16_expected, 16);
+}
+
+static void benchmark_cmac_64_start(void){
+    btstack_crypto_aes128_cmac_message(&benchmark_request.cmac, cmac_key, 64, cmac_message, benchmark_output, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_cmac_64_verify(void){
+    return memcmp(benchmark_output, cmac_64_expected, 16);
+}
+
+static void benchmark_ccm_encrypt_start(void){
+    btstack_crypto_ccm_init(&benchmark_request.ccm, aes128_key, ccm_nonce, sizeof(ccm_plaintext), 0, sizeof(benchmark_ccm_mic));
+    btstack_crypto_ccm_encrypt_block(&benchmark_request.ccm, sizeof(ccm_plaintext), ccm_plaintext, benchmark_ccm_ciphertext, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_ccm_encrypt_verify(void){
+    btstack_crypto_ccm_get_authentication_value(&benchmark_request.ccm, benchmark_ccm_mic);
+    return 0;
+}
+
+static void benchmark_ccm_decrypt_start(void){
+    btstack_crypto_ccm_init(&benchmark_request.ccm, aes128_key, ccm_nonce, sizeof(ccm_plaintext), 0, sizeof(benchmark_ccm_mic));
+    btstack_crypto_ccm_decrypt_block(&benchmark_request.ccm, sizeof(ccm_plaintext), benchmark_ccm_ciphertext, benchmark_output, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_ccm_decrypt_verify(void){
+    uint8_t mic[8];
+    btstack_crypto_ccm_get_authentication_value(&benchmark_request.ccm, mic);
+    if (memcmp(mic, benchmark_ccm_mic, sizeof(mic)) != 0) return -1;
+    return memcmp(benchmark_output, ccm_plaintext, sizeof(ccm_plaintext));
+}
+
+static void benchmark_ecc_generate_key_start(void){
+    btstack_crypto_ecc_p256_generate_key(&benchmark_request.ecc_p256, benchmark_ecc_public_key, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_ecc_generate_key_verify(void){
+    return uECC_valid_public_key(benchmark_ecc_public_key) == 0;
+}
+
+// DHKey for our own public key
+static void benchmark_ecc_dhkey_start(void){
+    btstack_crypto_ecc_p256_calculate_dhkey(&benchmark_request.ecc_p256, benchmark_ecc_public_key, benchmark_output, &benchmark_operation_done, NULL);
+}
+
+static int benchmark_ecc_dhkey_verify(void){
+    static const uint8_t zero_dhkey[32] = { 0 };
+    return memcmp(benchmark_output, zero_dhkey, 32) == 0;
+}
+
+static const benchmark_operation_t benchmark_operations[] = {
+    { "aes128",        BENCHMARK_AES_ITERATIONS, &benchmark_aes128_start,           &benchmark_aes128_verify },
+    { "aes_cmac_16",   BENCHMARK_AES_ITERATIONS, &benchmark_cmac_16_start,          &benchmark_cmac_16_verify },
+    { "aes_cmac_64",   BENCHMARK_AES_ITERATIONS, &benchmark_cmac_64_start,          &benchmark_cmac_64_verify },
+    { "ccm_encrypt",   BENCHMARK_AES_ITERATIONS, &benchmark_ccm_encrypt_start,      &benchmark_ccm_encrypt_verify },
+    { "ccm_decrypt",   BENCHMARK_AES_ITERATIONS, &benchmark_ccm_decrypt_start,      &benchmark_ccm_decrypt_verify },
+    { "ecc_p256_key",  BENCHMARK_ECC_ITERATIONS, &benchmark_ecc_generate_key_start, &benchmark_ecc_generate_key_verify },
+    { "ecc_p256_dh",   BENCHMARK_ECC_ITERATIONS, &benchmark_ecc_dhkey_start,        &benchmark_ecc_dhkey_verify },
+};
+
+static int benchmark_compare_latency(const void * a, const void * b){
+    uint64_t latency_a = *(const uint64_t *) a;
+    uint64_t latency_b = *(const uint64_t *) b;
+    if (latency_a < latency_b) return -1;
+    if (latency_a > latency_b) return 1;
+    return 0;
+}
+
+static double benchmark_percentile_us(uint32_t count, uint32_t percentile){
+    uint32_t index = (count * percentile) / 100u;
+    if (index >= count){
+        index = count - 1;
+    }
+    return (double) benchmark_latencies_ns[index] / 1000.0;
+}
+
+static int benchmark_run(const benchmark_operation_t * operation){
+    uint32_t iterations = btstack_max(1, operation->iterations / benchmark_iterations_divider);
+    uint32_t commands = mock_num_commands;
+    uint64_t total_ns = 0;
+    uint32_t i;
+    for (i=0;i<iterations;i++){
+        uint64_t start_ns = benchmark_now_ns();
+        benchmark_done = false;
+        (*operation->start)();
+        while (!benchmark_done && mock_controller_process()){
+        }
+        uint64_t latency_ns = benchmark_now_ns() - start_ns;
+        if (!benchmark_done || ((*operation->verify)() != 0)){
+            printf("%-14s failed in iteration %" PRIu32 "\n", operation->name, i);
+            return -1;
+        }
+        benchmark_latencies_ns[i] = latency_ns;
+        total_ns += latency_ns;
+    }
+    qsort(benchmark_latencies_ns, iterations, sizeof(uint64_t), &benchmark_compare_latency);
+    printf("%-14s %6" PRIu32 " ops, %10.1f ops/s, latency us: mean %9.2f, p50 %9.2f, p90 %9.2f, p99 %9.2f, max %9.2f, %5.2f HCI commands/op\n",
+           operation->name, iterations,
+           (double) iterations * 1e9 / (double) total_ns,
+           (double) total_ns / (double) iterations / 1000.0,
+           benchmark_percentile_us(iterations, 50), benchmark_percentile_us(iterations, 90),
+           benchmark_percentile_us(iterations, 99), (double) benchmark_latencies_ns[iterations - 1] / 1000.0,
+           (double) (mock_num_commands - commands) / (double) iterations);
+    return 0;
+}
+
+static void usage(const char * name){
+    printf("Usage: %s [-l latency_us] [-d divider]\n", name);
+    printf("  -l latency_us  HCI command latency of mocked Controller, default 0\n");
+    printf("  -d divider     divide number of iterations, e.g. for a quick check\n");
+}
+
+int main(int argc, const char * argv[]){
+    int arg;
+    for (arg = 1; arg < argc; arg++){
+        if ((strcmp(argv[arg], "-l") == 0) && ((arg + 1) < argc)){
+            mock_hci_latency_us = (uint32_t) strtoul(argv[++arg], NULL, 10);
+        } else if ((strcmp(argv[arg], "-d") == 0) && ((arg + 1) < argc)){
+            benchmark_iterations_divider = btstack_max(1, (uint32_t) strtoul(argv[++arg], NULL, 10));
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    btstack_crypto_init();
+
+    printf("backend %s, HCI latency %" PRIu32 " us\n", BENCHMARK_BACKEND, mock_hci_latency_us);
+    int result = 0;
+    unsigned int i;
+    for (i=0;i<(sizeof(benchmark_operations)/sizeof(benchmark_operations[0]));i++){
+        result |= benchmark_run(&benchmark_operations[i]);
+    }
+    return (result == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -11,6 +11,7 @@
 #include "btstack_util.h"
 #include "bluetooth.h"
 #include "btstack_audio.h"
+#include "btstack_run_loop_base.h"
 
 #include "hal_audio.h"
 #include "hal_cpu.h"
@@ -78,6 +79,113 @@ TEST_GROUP(Embedded){
     }
 };
 
+#define NUM_TEST_TIMERS 50
+
+static btstack_timer_source_t test_timers[NUM_TEST_TIMERS];
+static btstack_timer_source_t * test_timers_fired[NUM_TEST_TIMERS];
+static int test_timers_num_fired;
+
+static void test_timer_handler(btstack_timer_source_t * ts){
+    test_timers_fired[test_timers_num_fired++] = ts;
+}
+
+TEST_GROUP(RunLoopBase){
+    void setup(void){
+        btstack_run_loop_base_init();
+        memset(test_timers, 0, sizeof(test_timers));
+        test_timers_num_fired = 0;
+        int i;
+        for (i=0;i<NUM_TEST_TIMERS;i++){
+            test_timers[i].process = &test_timer_handler;
+            // pseudo-random order
+            test_timers[i].timeout = 1000 + ((i * 37) % NUM_TEST_TIMERS) * 10;
+        }
+    }
+};
+
+TEST(RunLoopBase, TimersFireInOrder){
+    int i;
+    for (i=0;i<NUM_TEST_TIMERS;i++){
+        btstack_run_loop_base_add_timer(&test_timers[i]);
+    }
+    CHECK_EQUAL(0, btstack_run_loop_base_get_time_until_timeout(1000));
+    CHECK_EQUAL(100, btstack_run_loop_base_get_time_until_timeout(900));
+    btstack_run_loop_base_process_timers(999);
+    CHECK_EQUAL(0, test_timers_num_fired);
+    btstack_run_loop_base_process_timers(1000 + NUM_TEST_TIMERS * 10);
+    CHECK_EQUAL(NUM_TEST_TIMERS, test_timers_num_fired);
+    for (i=1;i<NUM_TEST_TIMERS;i++){
+        CHECK(test_timers_fired[i-1]->timeout < test_timers_fired[i]->timeout);
+    }
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(0));
+}
+
+TEST(RunLoopBase, RemoveTimers){
+    int i;
+    for (i=0;i<NUM_TEST_TIMERS;i++){
+        btstack_run_loop_base_add_timer(&test_timers[i]);
+    }
+    // adding timer twice is ignored
+    btstack_run_loop_base_add_timer(&test_timers[3]);
+    // remove every third timer, including the first one to fire
+    for (i=0;i<NUM_TEST_TIMERS;i+=3){
+        CHECK_TRUE(btstack_run_loop_base_remove_timer(&test_timers[i]));
+        CHECK_FALSE(btstack_run_loop_base_remove_timer(&test_timers[i]));
+    }
+    btstack_run_loop_base_process_timers(1000 + NUM_TEST_TIMERS * 10);
+    CHECK_EQUAL(NUM_TEST_TIMERS - ((NUM_TEST_TIMERS + 2) / 3), test_timers_num_fired);
+    for (i=1;i<test_timers_num_fired;i++){
+        CHECK(test_timers_fired[i-1]->timeout < test_timers_fired[i]->timeout);
+    }
+}
+
+TEST(RunLoopBase, InitResetsTimers){
+    int i;
+    for (i=0;i<NUM_TEST_TIMERS;i++){
+        btstack_run_loop_base_add_timer(&test_timers[i]);
+    }
+    btstack_run_loop_base_init();
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(0));
+    // timers from before init can be added again
+    for (i=0;i<NUM_TEST_TIMERS;i++){
+        btstack_run_loop_base_add_timer(&test_timers[i]);
+    }
+    btstack_run_loop_base_process_timers(1000 + NUM_TEST_TIMERS * 10);
+    CHECK_EQUAL(NUM_TEST_TIMERS, test_timers_num_fired);
+}
+
+TEST(RunLoopBase, TimeWrap){
+    btstack_timer_source_t * late  = &test_timers[0];
+    btstack_timer_source_t * early = &test_timers[1];
+    late->timeout  = 0x00000010;
+    early->timeout = 0xfffffff0;
+    btstack_run_loop_base_add_timer(late);
+    btstack_run_loop_base_add_timer(early);
+    btstack_run_loop_base_process_timers(0xfffffff8);
+    CHECK_EQUAL(1, test_timers_num_fired);
+    POINTERS_EQUAL(early, test_timers_fired[0]);
+    btstack_run_loop_base_process_timers(0x00000010);
+    CHECK_EQUAL(2, test_timers_num_fired);
+}
+
+TEST(RunLoopBase, CallbacksInOrder){
+    btstack_context_callback_registration_t callbacks[3];
+    memset(callbacks, 0, sizeof(callbacks));
+    POINTERS_EQUAL(NULL, btstack_run_loop_base_get_next_callback());
+    btstack_run_loop_base_add_callback(&callbacks[0]);
+    btstack_run_loop_base_add_callback(&callbacks[1]);
+    // adding pending callback again is ignored
+    btstack_run_loop_base_add_callback(&callbacks[0]);
+    btstack_run_loop_base_add_callback(&callbacks[2]);
+    POINTERS_EQUAL(&callbacks[0], btstack_run_loop_base_get_next_callback());
+    POINTERS_EQUAL(&callbacks[1], btstack_run_loop_base_get_next_callback());
+    // callback can be added again after it was removed
+    btstack_run_loop_base_add_callback(&callbacks[0]);
+    POINTERS_EQUAL(&callbacks[2], btstack_run_loop_base_get_next_callback());
+    POINTERS_EQUAL(&callbacks[0], btstack_run_loop_base_get_next_callback());
+    POINTERS_EQUAL(NULL, btstack_run_loop_base_get_next_callback());
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -24,6 +24,7 @@
 #include "hal_uart_dma.h"
 
 #include "queue.h"
+#include "semphr.h"
 #include "task.h"
 #include "event_groups.h"
 
@@ -108,6 +109,15 @@ EventBits_t xEventGroupWaitBits( const EventGroupHandle_t xEventGroup, const Eve
 TaskHandle_t xTaskGetCurrentTaskHandle( void ){
 	return 0;
 }
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t *pxMutexBuffer ){
+	return 0;
+}
+BaseType_t xSemaphoreTake( SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait ){
+	return 1;
+}
+BaseType_t xSemaphoreGive( SemaphoreHandle_t xSemaphore ){
+	return 1;
+}
 
 TEST_GROUP(FreeRTOS){
     void setup(void){
@@ -0,0 +1,8 @@
+#include <stdint.h>
+typedef int StaticSemaphore_t;
+typedef int SemaphoreHandle_t;
+typedef int BaseType_t;
+typedef int TickType_t;
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t *pxMutexBuffer );
+BaseType_t xSemaphoreTake( SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait );
+BaseType_t xSemaphoreGive( SemaphoreHandle_t xSemaphore );
@@ -0,0 +1,36 @@
+//
+// btstack_config.h for esp32_vhci tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+// #define ENABLE_LOG_DEBUG
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO 
+#define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_CENTRAL
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1021
+#define HCI_INCOMING_PRE_BUFFER_SIZE 4
+
+// VHCI ring buffer
+#define HCI_HOST_ACL_PACKET_NUM 20
+#define HCI_HOST_ACL_PACKET_LEN 1024
+#define HCI_HOST_SCO_PACKET_NUM 10
+#define HCI_HOST_SCO_PACKET_LEN 60
+
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+
+#define NVM_NUM_DEVICE_DB_ENTRIES 4
+#define NVM_NUM_LINK_KEYS 2
+
+#endif
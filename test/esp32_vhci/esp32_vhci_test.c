@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "esp32_vhci_test.c"
+
+/*
+ *  esp32_vhci_test.c
+ *
+ *  ESP32 VHCI transport with simulated VHCI callbacks
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "mock_btstack_run_loop.h"
+
+// include port to access VHCI callbacks and ring buffer
+#include "../../port/esp32/components/btstack/btstack_port_esp32.c"
+
+// ESP-IDF
+
+static const esp_vhci_host_callback_t * vhci_callback;
+static uint16_t num_triggers;
+
+uint32_t esp_log_timestamp(){
+    return 0;
+}
+
+int xPortInIsrContext(void){
+    return 0;
+}
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg){
+    UNUSED(cfg);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode){
+    UNUSED(mode);
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_disable(void){
+    return ESP_OK;
+}
+
+esp_err_t esp_vhci_host_register_callback(const esp_vhci_host_callback_t *callback){
+    vhci_callback = callback;
+    return ESP_OK;
+}
+
+bool esp_vhci_host_check_send_available(void){
+    return true;
+}
+
+void esp_vhci_host_send_packet(uint8_t *data, uint16_t len){
+    UNUSED(data);
+    UNUSED(len);
+}
+
+// BTstack FreeRTOS run loop and esp32 port, not used by transport
+
+void btstack_run_loop_freertos_trigger(void){
+    num_triggers++;
+}
+
+const btstack_run_loop_t * btstack_run_loop_freertos_get_instance(void){
+    return mock_btstack_run_loop_get_instance();
+}
+
+const btstack_tlv_t * btstack_tlv_esp32_get_instance(void){
+    return NULL;
+}
+
+const btstack_audio_sink_t * btstack_audio_esp32_sink_get_instance(void){
+    return NULL;
+}
+
+// simulated Controller sends ACL packets with sequence number and pattern
+
+#define TEST_MAX_PACKET_LEN (1 + HCI_ACL_HEADER_SIZE + HCI_HOST_ACL_PACKET_LEN)
+
+static uint16_t next_seq_sent;
+static uint16_t next_seq_received;
+static uint16_t pending_len[0x10000];
+static uint16_t num_packet_sent_events;
+static bool     reopen_in_handler;
+static uint32_t random_state;
+
+static uint32_t test_random(void){
+    random_state = (random_state * 1103515245u) + 12345u;
+    return random_state >> 8;
+}
+
+static uint8_t test_pattern(uint16_t seq, uint16_t pos){
+    return (uint8_t) ((seq * 31u) + pos);
+}
+
+static int controller_send_packet(uint16_t len){
+    static uint8_t packet[TEST_MAX_PACKET_LEN];
+    btstack_assert((len >= 3) && (len <= sizeof(packet)));
+    uint16_t seq = next_seq_sent;
+    packet[0] = HCI_ACL_DATA_PACKET;
+    little_endian_store_16(packet, 1, seq);
+    uint16_t i;
+    for (i = 3; i < len; i++){
+        packet[i] = test_pattern(seq, i);
+    }
+    int bytes_free_before = (int) btstack_ring_buffer_spsc_bytes_free(&hci_ringbuffer);
+    vhci_callback->notify_host_recv(packet, len);
+    // VHCI frees packet after callback returns
+    memset(packet, 0x55, len);
+    if (bytes_free_before == (int) btstack_ring_buffer_spsc_bytes_free(&hci_ringbuffer)) return 0;
+    pending_len[seq] = len;
+    next_seq_sent++;
+    return 1;
+}
+
+static void test_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    if (packet_type == HCI_EVENT_PACKET){
+        CHECK_EQUAL(HCI_EVENT_TRANSPORT_PACKET_SENT, packet[0]);
+        num_packet_sent_events++;
+        return;
+    }
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, packet_type);
+    // delivered from ring buffer
+    CHECK(packet >= &hci_ringbuffer_storage[HCI_INCOMING_PRE_BUFFER_SIZE]);
+    CHECK(&packet[size] <= &hci_ringbuffer_storage[sizeof(hci_ringbuffer_storage)]);
+    uint16_t seq = little_endian_read_16(packet, 0);
+    CHECK_EQUAL(next_seq_received, seq);
+    CHECK_EQUAL(pending_len[seq] - 1, size);
+    uint16_t i;
+    for (i = 2; i < size; i++){
+        if (packet[i] != test_pattern(seq, i + 1)){
+            CHECK_EQUAL(test_pattern(seq, i + 1), packet[i]);
+            break;
+        }
+    }
+    next_seq_received++;
+    // HCI may use pre-buffer in place
+    memset(packet - HCI_INCOMING_PRE_BUFFER_SIZE, 0xaa, HCI_INCOMING_PRE_BUFFER_SIZE);
+    if (reopen_in_handler){
+        reopen_in_handler = false;
+        transport_open();
+    }
+}
+
+static void btstack_poll(void){
+    transport_process(&transport_data_source, DATA_SOURCE_CALLBACK_POLL);
+}
+
+TEST_GROUP(ESP32_VHCI){
+    const hci_transport_t * hci_transport;
+
+    void setup(void){
+        num_triggers = 0;
+        num_packet_sent_events = 0;
+        next_seq_sent = 0;
+        next_seq_received = 0;
+        reopen_in_handler = false;
+        random_state = 1;
+        mock_btstack_run_loop_init();
+        hci_transport = transport_get_instance();
+        hci_transport->init(NULL);
+        hci_transport->register_packet_handler(&test_packet_handler);
+        CHECK_EQUAL(0, hci_transport->open());
+        CHECK(vhci_callback != NULL);
+    }
+    void teardown(void){
+        btstack_run_loop_remove_data_source(&transport_data_source);
+        transport_packets_to_deliver = 0;
+        transport_signal_sent = 0;
+    }
+};
+
+TEST(ESP32_VHCI, DeliverBatchWithSingleTrigger){
+    CHECK_EQUAL(1, controller_send_packet(10));
+    CHECK_EQUAL(1, controller_send_packet(200));
+    CHECK_EQUAL(1, controller_send_packet(3));
+    CHECK_EQUAL(1, num_triggers);
+    btstack_poll();
+    CHECK_EQUAL(3, next_seq_received);
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&hci_ringbuffer));
+
+    // next packet triggers again
+    CHECK_EQUAL(1, controller_send_packet(20));
+    CHECK_EQUAL(2, num_triggers);
+    btstack_poll();
+    CHECK_EQUAL(4, next_seq_received);
+}
+
+TEST(ESP32_VHCI, PacketSentWithSingleTrigger){
+    vhci_callback->notify_host_send_available();
+    vhci_callback->notify_host_send_available();
+    CHECK_EQUAL(1, num_triggers);
+    btstack_poll();
+    CHECK_EQUAL(1, num_packet_sent_events);
+    vhci_callback->notify_host_send_available();
+    CHECK_EQUAL(2, num_triggers);
+    btstack_poll();
+    CHECK_EQUAL(2, num_packet_sent_events);
+}
+
+TEST(ESP32_VHCI, RandomSizesWrapStorage){
+    uint32_t num_packets = 0;
+    while (num_packets < 5000){
+        uint16_t burst = (uint16_t) (1 + (test_random() % 12));
+        while (burst--){
+            uint16_t len = (uint16_t) (3 + (test_random() % (TEST_MAX_PACKET_LEN - 2)));
+            num_packets += controller_send_packet(len);
+        }
+        if ((test_random() % 3) != 0){
+            btstack_poll();
+            CHECK_EQUAL(next_seq_sent, next_seq_received);
+        }
+    }
+    btstack_poll();
+    CHECK_EQUAL(next_seq_sent, next_seq_received);
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&hci_ringbuffer));
+}
+
+TEST(ESP32_VHCI, DropWhenFull){
+    uint16_t num_stored = 0;
+    while (controller_send_packet(TEST_MAX_PACKET_LEN)){
+        num_stored++;
+    }
+    CHECK(num_stored >= HCI_HOST_ACL_PACKET_NUM);
+    // smaller packet may still fit
+    while (controller_send_packet(3)){
+        num_stored++;
+    }
+    btstack_poll();
+    CHECK_EQUAL(num_stored, next_seq_received);
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&hci_ringbuffer));
+
+    // full size again after storage was emptied
+    CHECK_EQUAL(1, controller_send_packet(TEST_MAX_PACKET_LEN));
+    btstack_poll();
+    CHECK_EQUAL(num_stored + 1, next_seq_received);
+}
+
+TEST(ESP32_VHCI, ReopenInPacketHandler){
+    CHECK_EQUAL(1, controller_send_packet(10));
+    CHECK_EQUAL(1, controller_send_packet(10));
+    reopen_in_handler = true;
+    btstack_poll();
+    // second packet discarded with ring buffer
+    CHECK_EQUAL(1, next_seq_received);
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&hci_ringbuffer));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,40 @@
+// minimal esp_bt.h to compile btstack_port_esp32.c on the host
+
+#ifndef ESP_BT_H
+#define ESP_BT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// from sdkconfig.h
+#define CONFIG_BT_ENABLED 1
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+typedef enum {
+    ESP_BT_MODE_IDLE       = 0x00,
+    ESP_BT_MODE_BLE        = 0x01,
+    ESP_BT_MODE_CLASSIC_BT = 0x02,
+    ESP_BT_MODE_BTDM       = 0x03,
+} esp_bt_mode_t;
+
+typedef struct {
+    uint16_t controller_task_stack_size;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() { 0 }
+
+typedef struct esp_vhci_host_callback {
+    void (*notify_host_send_available)(void);
+    int (*notify_host_recv)(uint8_t *data, uint16_t len);
+} esp_vhci_host_callback_t;
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_disable(void);
+esp_err_t esp_vhci_host_register_callback(const esp_vhci_host_callback_t *callback);
+bool esp_vhci_host_check_send_available(void);
+void esp_vhci_host_send_packet(uint8_t *data, uint16_t len);
+
+#endif
@@ -0,0 +1,8 @@
+// minimal freertos/FreeRTOS.h to compile btstack_port_esp32.c on the host
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+int xPortInIsrContext(void);
+
+#endif
@@ -0,0 +1 @@
+// minimal freertos/task.h to compile btstack_port_esp32.c on the host
@@ -123,6 +123,59 @@ TEST(LE_DEVICE_DB, AddTwoRemoveOneAddOne){
     CHECK_EQUAL_ARRAY(addr_cc, addr, 6);
 }
 
+TEST(LE_DEVICE_DB, EncryptionSetGet){
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    CHECK_TRUE(index >= 0);
+    uint8_t rand_set[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    le_device_db_encryption_set(index, 0x1234, rand_set, sm_key_bb, 16, 1, 0, 1);
+    uint16_t ediv;
+    uint8_t  rand[8];
+    sm_key_t ltk;
+    int key_size, authenticated, authorized, secure_connection;
+    le_device_db_encryption_get(index, &ediv, rand, ltk, &key_size, &authenticated, &authorized, &secure_connection);
+    CHECK_EQUAL(0x1234, ediv);
+    CHECK_EQUAL_ARRAY(rand_set, rand, 8);
+    CHECK_EQUAL_ARRAY(sm_key_bb, ltk, 16);
+    CHECK_EQUAL(16, key_size);
+    CHECK_EQUAL(1, authenticated);
+    CHECK_EQUAL(0, authorized);
+    CHECK_EQUAL(1, secure_connection);
+}
+
+TEST(LE_DEVICE_DB, ReloadFromTLV){
+    int index = le_device_db_add(BD_ADDR_TYPE_LE_RANDOM, addr_bb, sm_key_bb);
+    uint8_t rand_set[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    le_device_db_encryption_set(index, 0x4321, rand_set, sm_key_cc, 7, 0, 0, 0);
+    // scan TLV again
+    le_device_db_tlv_configure(btstack_tlv_impl, &btstack_tlv_context);
+    CHECK_EQUAL(1, le_device_db_count());
+    bd_addr_t addr;
+    sm_key_t sm_key;
+    int addr_type;
+    le_device_db_info(index, &addr_type, addr, sm_key);
+    CHECK_EQUAL(BD_ADDR_TYPE_LE_RANDOM, addr_type);
+    CHECK_EQUAL_ARRAY(addr_bb, addr, 6);
+    CHECK_EQUAL_ARRAY(sm_key_bb, sm_key, 16);
+    uint16_t ediv;
+    sm_key_t ltk;
+    int key_size;
+    le_device_db_encryption_get(index, &ediv, NULL, ltk, &key_size, NULL, NULL, NULL);
+    CHECK_EQUAL(0x4321, ediv);
+    CHECK_EQUAL_ARRAY(sm_key_cc, ltk, 16);
+    CHECK_EQUAL(7, key_size);
+}
+
+TEST(LE_DEVICE_DB, AddSameAddress){
+    int index_a = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    int index_b = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_bb);
+    CHECK_EQUAL(index_a, index_b);
+    CHECK_EQUAL(1, le_device_db_count());
+    bd_addr_t addr;
+    sm_key_t sm_key;
+    int addr_type;
+    le_device_db_info(index_b, &addr_type, addr, sm_key);
+    CHECK_EQUAL_ARRAY(sm_key_bb, sm_key, 16);
+}
 
 int main (int argc, const char * argv[]){
     hci_dump_open("tlv_le_test.pklg", HCI_DUMP_PACKETLOGGER);
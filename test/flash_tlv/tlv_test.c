@@ -244,6 +244,32 @@ TEST(BSTACK_TLV, TestWriteResetRead){
     CHECK_EQUAL(buffer, data);
 }
 
+TEST(BSTACK_TLV, TestWriteMultipleDeleteResetRead){
+    btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, hal_flash_bank_impl, &hal_flash_bank_context);
+    uint8_t buffer;
+    uint32_t i;
+    for (i=0;i<5;i++){
+        buffer = (uint8_t) i;
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, 0x11110000 + i, &buffer, 1);
+    }
+    buffer = 9;
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, 0x11110003, &buffer, 1);
+    btstack_tlv_impl->delete_tag(&btstack_tlv_context, 0x11110001);
+    int run;
+    for (run=0;run<2;run++){
+        for (i=0;i<5;i++){
+            int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, 0x11110000 + i, &buffer, 1);
+            if (i == 1){
+                CHECK_EQUAL(0, size);
+                continue;
+            }
+            CHECK_EQUAL(1, size);
+            CHECK_EQUAL((i == 3) ? 9 : i, buffer);
+        }
+        btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, hal_flash_bank_impl, &hal_flash_bank_context);
+    }
+}
+
 //
 TEST_GROUP(LINK_KEY_DB){
 	const hal_flash_bank_t * hal_flash_bank_impl;
@@ -1,12 +1,21 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "fuzz_cost.h"
+
 #include "ad_parser.h"
 
-int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+static int test_one_input(const uint8_t *data, size_t size) {
     // ad parser uses uint88_t length
     if (size > 255) return 0;
     // test ad iterator by calling simple function that uses it
     ad_data_contains_uuid16(size, data, 0xffff);
     return 0;
 }
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_cost_begin("fuzz_ad_parser");
+    int result = test_one_input(data, size);
+    fuzz_cost_end(data, size);
+    return result;
+}
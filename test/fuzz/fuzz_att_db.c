@@ -2,6 +2,8 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include "fuzz_cost.h"
+
 #include "ble/att_db.h"
 #include "ble/att_db_util.h"
 #include "bluetooth_gatt.h"
@@ -16,7 +18,7 @@ static int att_write_callback(hci_con_handle_t con_handle, uint16_t attribute_ha
     return 0;
 }
 
-int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+static int test_one_input(const uint8_t *data, size_t size) {
     static int initialized = 0;
     if (initialized == 0){
         initialized = 1;
@@ -41,3 +43,10 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     uint16_t att_respnose_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
     return 0;
 }
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_cost_begin("fuzz_att_db");
+    int result = test_one_input(data, size);
+    fuzz_cost_end(data, size);
+    return result;
+}
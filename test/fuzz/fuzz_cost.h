@@ -0,0 +1,134 @@
+//
+// Cost-guided fuzzing: measure the cost of each input and report it to libFuzzer as extra feature
+//
+// FUZZ_COST=1                enable cost tracking. Each power of two of the cost is a separate feature,
+//                            so libFuzzer keeps inputs that are more expensive than all seen before
+// FUZZ_COST_THRESHOLD=cost   store inputs with a higher cost in the regression corpus
+// FUZZ_COST_CORPUS=dir       regression corpus, default: cost_corpus
+// FUZZ_COST_MAX=cost         abort if an input is more expensive, e.g. to check corpus in CI:
+//                            FUZZ_COST=1 FUZZ_COST_MAX=1000000 ./fuzz_att_db cost_corpus/fuzz_att_db-*
+//
+// Cost is the number of user space instructions if available via perf_event_open, CPU time in ns otherwise
+//
+
+#ifndef FUZZ_COST_H
+#define FUZZ_COST_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define FUZZ_COST_NUM_BUCKETS 64
+
+// extra counters are treated like coverage counters by libFuzzer
+__attribute__((used, section("__libfuzzer_extra_counters")))
+static uint8_t fuzz_cost_counters[FUZZ_COST_NUM_BUCKETS];
+
+static int         fuzz_cost_initialized;
+static int         fuzz_cost_enabled;
+static int         fuzz_cost_perf_fd = -1;
+static uint64_t    fuzz_cost_threshold;
+static uint64_t    fuzz_cost_max;
+static const char * fuzz_cost_corpus;
+static const char * fuzz_cost_target;
+static uint64_t    fuzz_cost_start;
+
+static uint64_t fuzz_cost_env(const char * name){
+    const char * value = getenv(name);
+    if (value == NULL) return 0;
+    return strtoull(value, NULL, 0);
+}
+
+static void fuzz_cost_init(const char * target){
+    fuzz_cost_initialized = 1;
+    fuzz_cost_enabled = fuzz_cost_env("FUZZ_COST") != 0;
+    if (!fuzz_cost_enabled) return;
+    fuzz_cost_target    = target;
+    fuzz_cost_threshold = fuzz_cost_env("FUZZ_COST_THRESHOLD");
+    fuzz_cost_max       = fuzz_cost_env("FUZZ_COST_MAX");
+    fuzz_cost_corpus    = getenv("FUZZ_COST_CORPUS");
+    if (fuzz_cost_corpus == NULL){
+        fuzz_cost_corpus = "cost_corpus";
+    }
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fuzz_cost_perf_fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    fprintf(stderr, "fuzz_cost: %s, cost in %s, threshold %llu, max %llu, corpus %s\n", target,
+            (fuzz_cost_perf_fd >= 0) ? "instructions" : "ns",
+            (unsigned long long) fuzz_cost_threshold, (unsigned long long) fuzz_cost_max, fuzz_cost_corpus);
+}
+
+static uint64_t fuzz_cost_now(void){
+#ifdef __linux__
+    if (fuzz_cost_perf_fd >= 0){
+        uint64_t count = 0;
+        if (read(fuzz_cost_perf_fd, &count, sizeof(count)) == sizeof(count)) return count;
+    }
+#endif
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return ((uint64_t) now.tv_sec * 1000000000u) + (uint64_t) now.tv_nsec;
+}
+
+static void fuzz_cost_store(const uint8_t * data, size_t size, uint64_t cost){
+    // FNV-1a to avoid duplicates
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < size; i++){
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    if ((mkdir(fuzz_cost_corpus, 0755) != 0) && (errno != EEXIST)) return;
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s-%llu-%08x", fuzz_cost_corpus, fuzz_cost_target, (unsigned long long) cost, hash);
+    FILE * file = fopen(path, "wb");
+    if (file == NULL) return;
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+// call at start of LLVMFuzzerTestOneInput
+static void fuzz_cost_begin(const char * target){
+    if (!fuzz_cost_initialized){
+        fuzz_cost_init(target);
+    }
+    if (!fuzz_cost_enabled) return;
+    fuzz_cost_start = fuzz_cost_now();
+}
+
+// call after processing the input
+static void fuzz_cost_end(const uint8_t * data, size_t size){
+    if (!fuzz_cost_enabled) return;
+    uint64_t cost = fuzz_cost_now() - fuzz_cost_start;
+    int bucket = 0;
+    while ((bucket < (FUZZ_COST_NUM_BUCKETS - 1)) && ((cost >> bucket) > 1)){
+        bucket++;
+    }
+    fuzz_cost_counters[bucket] = 1;
+    if ((fuzz_cost_threshold > 0) && (cost > fuzz_cost_threshold)){
+        fuzz_cost_store(data, size, cost);
+    }
+    if ((fuzz_cost_max > 0) && (cost > fuzz_cost_max)){
+        fprintf(stderr, "fuzz_cost: input with cost %llu exceeds max %llu\n", (unsigned long long) cost, (unsigned long long) fuzz_cost_max);
+        abort();
+    }
+}
+
+#endif // FUZZ_COST_H
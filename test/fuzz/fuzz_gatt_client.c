@@ -1,6 +1,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "fuzz_cost.h"
+
 #include "ble/gatt_client.h"
 #include "btstack_run_loop_posix.h"
 #include "btstack_memory.h"
@@ -80,7 +82,7 @@ void set_gatt_characteristic_uuid128(gatt_client_characteristic_t * characterist
     memcpy(characteristic->uuid128, data, 16);
 }
 
-int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+static int test_one_input(const uint8_t *data, size_t size) {
     const hci_con_handle_t ble_handle = 0x0005;
 
     static bool gatt_client_initiated = false;
@@ -253,3 +255,10 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     gatt_client_att_packet_handler_fuzz(ATT_DATA_PACKET, ble_handle, (uint8_t *) data, size);
     return 0;
 }
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_cost_begin("fuzz_gatt_client");
+    int result = test_one_input(data, size);
+    fuzz_cost_end(data, size);
+    return result;
+}
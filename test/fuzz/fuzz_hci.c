@@ -2,6 +2,8 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include "fuzz_cost.h"
+
 #include <btstack_util.h>
 #include <btstack.h>
 #include <btstack_run_loop_posix.h>
@@ -62,7 +64,7 @@ static void l2cap_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t
     }
 }
 
-int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+static int test_one_input(const uint8_t *data, size_t size) {
     static int initialized = 0;
     if (initialized == 0){
         initialized = 1;
@@ -118,3 +120,10 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     hci_free_connections_fuzz();
     return 0;
 }
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_cost_begin("fuzz_hci");
+    int result = test_one_input(data, size);
+    fuzz_cost_end(data, size);
+    return result;
+}
@@ -17,6 +17,7 @@
 #include "hci_cmd.h"
 
 #include "btstack_memory.h"
+#include "btstack_tlv.h"
 #include "hci.h"
 #include "hci_dump.h"
 #include "ble/gatt_client.h"
@@ -26,6 +27,7 @@
 
 static uint16_t gatt_client_handle = 0x40;
 static int gatt_query_complete = 0;
+static uint8_t gatt_query_status;
 
 typedef enum {
 	IDLE,
@@ -73,6 +75,11 @@ static gatt_client_characteristic_descriptor_t descriptors[50];
 
 void mock_simulate_discover_primary_services_response(void);
 void mock_simulate_att_exchange_mtu_response(void);
+void mock_simulate_disconnected(hci_con_handle_t con_handle);
+void mock_simulate_att_indication(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t * value, uint16_t value_len);
+void mock_set_le_device_index(int index);
+void mock_set_database_hash(const uint8_t * hash);
+void mock_run_loop_process_zero_timeouts(void);
 
 void CHECK_EQUAL_ARRAY(const uint8_t * expected, uint8_t * actual, int size){
 	for (int i=0; i<size; i++){
@@ -150,6 +157,7 @@ static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8
 	switch (packet[0]){
 		case GATT_EVENT_QUERY_COMPLETE:
 			status = packet[4];
+            gatt_query_status = status;
             gatt_query_complete = 1;
             if (status){
                 gatt_query_complete = 0;
@@ -535,6 +543,134 @@ TEST(GATTClient, TestReadCharacteristicValue){
 	CHECK_EQUAL(result_counter, 3);
 }
 
+TEST(GATTClient, TestReadMultipleVariableCharacteristicValues){
+	test = READ_CHARACTERISTIC_VALUE;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xF100);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	reset_query_state();
+	uint16_t value_handles[2];
+	value_handles[0] = characteristics[0].value_handle;
+	value_handles[1] = characteristics[0].value_handle;
+	status = gatt_client_read_multiple_variable_characteristic_values(handle_ble_client_event, gatt_client_handle, 2, value_handles);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	// two read callbacks and one result per value
+	CHECK_EQUAL(result_counter, 6);
+}
+
+static int query_request_counter;
+static void start_read_characteristic_value_query(void * context){
+	query_request_counter++;
+	gatt_client_read_value_of_characteristic(handle_ble_client_event, gatt_client_handle, (gatt_client_characteristic_t *) context);
+}
+
+TEST(GATTClient, TestRequestToSendGattQuery){
+	test = READ_CHARACTERISTIC_VALUE;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xF100);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	reset_query_state();
+	query_request_counter = 0;
+	btstack_context_callback_registration_t first_request;
+	btstack_context_callback_registration_t second_request;
+	first_request.callback = &start_read_characteristic_value_query;
+	first_request.context = &characteristics[0];
+	second_request.callback = &start_read_characteristic_value_query;
+	second_request.context = &characteristics[0];
+	status = gatt_client_request_to_send_gatt_query(&first_request, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	status = gatt_client_request_to_send_gatt_query(&second_request, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	// callbacks are executed from run loop
+	CHECK_EQUAL(query_request_counter, 0);
+	mock_run_loop_process_zero_timeouts();
+	CHECK_EQUAL(query_request_counter, 2);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	// two read callbacks and one result per query
+	CHECK_EQUAL(result_counter, 6);
+}
+
+TEST(GATTClient, TestRequestToSendGattQueryDroppedOnDisconnect){
+	query_request_counter = 0;
+	btstack_context_callback_registration_t request;
+	request.callback = &start_read_characteristic_value_query;
+	request.context = &characteristics[0];
+	status = gatt_client_request_to_send_gatt_query(&request, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, gatt_client_request_to_send_gatt_query(&request, gatt_client_handle));
+
+	mock_simulate_disconnected(gatt_client_handle);
+	mock_run_loop_process_zero_timeouts();
+	CHECK_EQUAL(query_request_counter, 0);
+
+	// registration can be used again
+	status = gatt_client_request_to_send_gatt_query(&request, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	mock_simulate_disconnected(gatt_client_handle);
+	mock_run_loop_process_zero_timeouts();
+	CHECK_EQUAL(query_request_counter, 0);
+}
+
+static int      write_stream_chunks_available;
+static uint32_t write_stream_bytes_sent;
+static int      write_stream_progress_events;
+static uint16_t write_stream_provider(hci_con_handle_t con_handle, uint16_t value_handle, uint8_t * buffer, uint16_t max_len){
+	if (write_stream_chunks_available == 0) return 0;
+	write_stream_chunks_available--;
+	memset(buffer, 0x55, max_len);
+	return max_len;
+}
+static void handle_write_stream_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	if (packet_type != HCI_EVENT_PACKET) return;
+	if (packet[0] != GATT_EVENT_WRITE_WITHOUT_RESPONSE_STREAM_PROGRESS) return;
+	write_stream_progress_events++;
+	write_stream_bytes_sent = little_endian_read_32(packet, 6);
+}
+
+TEST(GATTClient, TestWriteWithoutResponseStream){
+	write_stream_chunks_available = 3;
+	write_stream_progress_events = 0;
+	write_stream_bytes_sent = 0;
+	status = gatt_client_write_without_response_stream_start(handle_write_stream_event, gatt_client_handle, 0x0010, &write_stream_provider);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(write_stream_progress_events, 1);
+	CHECK_EQUAL(write_stream_bytes_sent, 3 * (23 - 3));
+
+	// already started
+	status = gatt_client_write_without_response_stream_start(handle_write_stream_event, gatt_client_handle, 0x0010, &write_stream_provider);
+	CHECK_EQUAL(status, GATT_CLIENT_IN_WRONG_STATE);
+
+	write_stream_chunks_available = 1;
+	status = gatt_client_write_without_response_stream_resume(gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(write_stream_progress_events, 2);
+	CHECK_EQUAL(write_stream_bytes_sent, 4 * (23 - 3));
+
+	status = gatt_client_write_without_response_stream_stop(gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	status = gatt_client_write_without_response_stream_resume(gatt_client_handle);
+	CHECK_EQUAL(status, GATT_CLIENT_IN_WRONG_STATE);
+}
+
 TEST(GATTClient, TestWriteCharacteristicValue){
     test = WRITE_CHARACTERISTIC_VALUE;
 	reset_query_state();
@@ -602,6 +738,31 @@ TEST(GATTClient, TestReadLongCharacteristicValue){
 	CHECK_EQUAL(result_counter, 7);
 }
 
+TEST(GATTClient, TestReadLongMultipleCharacteristicValues){
+	test = READ_LONG_CHARACTERISTIC_VALUE;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xF100);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	reset_query_state();
+	uint16_t value_handles[2];
+	value_handles[0] = characteristics[0].value_handle;
+	value_handles[1] = characteristics[0].value_handle;
+	status = gatt_client_read_long_multiple_characteristic_values(handle_ble_client_event, gatt_client_handle, 2, value_handles);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	// read multiple variable with truncated first value, read blob, read and read blob for second value
+	CHECK_EQUAL(result_counter, 15);
+}
+
 TEST(GATTClient, TestReadLongCharacteristicDescriptor){
 	test = READ_LONG_CHARACTERISTIC_DESCRIPTOR;
 	reset_query_state();
@@ -699,6 +860,164 @@ TEST(GATTClient, TestWriteReliableLongCharacteristicValue){
 	CHECK_EQUAL(gatt_query_complete, 1);
 }
 
+// GATT Client Cache
+
+static uint8_t  tlv_data[GATT_CLIENT_CACHE_HEADER_SIZE + GATT_CLIENT_CACHE_SIZE];
+static uint32_t tlv_tag;
+static int      tlv_len;
+
+static int tlv_get_tag(void * context, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
+	if ((tlv_len == 0) || (tag != tlv_tag)) return 0;
+	CHECK(buffer_size >= (uint32_t) tlv_len);
+	memcpy(buffer, tlv_data, tlv_len);
+	return tlv_len;
+}
+
+static int tlv_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
+	CHECK(data_size <= sizeof(tlv_data));
+	tlv_tag = tag;
+	tlv_len = data_size;
+	memcpy(tlv_data, data, data_size);
+	return 0;
+}
+
+static void tlv_delete_tag(void * context, uint32_t tag){
+	if (tag == tlv_tag){
+		tlv_len = 0;
+	}
+}
+
+static const btstack_tlv_t tlv_impl = {
+	&tlv_get_tag,
+	&tlv_store_tag,
+	&tlv_delete_tag,
+};
+
+static const uint8_t database_hash[16] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10 };
+
+TEST_GROUP(GATTClientCache){
+	uint8_t status;
+
+	void setup(void){
+		gatt_query_complete = 0;
+		gatt_query_status = 0;
+		result_counter = 0;
+		result_index = 0;
+		test = IDLE;
+		tlv_len = 0;
+		btstack_tlv_set_instance(&tlv_impl, NULL);
+		mock_set_database_hash(database_hash);
+		mock_set_le_device_index(0);
+		// start with fresh context
+		mock_simulate_disconnected(gatt_client_handle);
+	}
+
+	void teardown(void){
+		mock_simulate_disconnected(gatt_client_handle);
+		mock_set_le_device_index(-1);
+		mock_set_database_hash(NULL);
+		btstack_tlv_set_instance(NULL, NULL);
+	}
+
+	void reset_query_state(void){
+		gatt_query_complete = 0;
+		result_counter = 0;
+		result_index = 0;
+	}
+
+	void discover_primary_services_from_remote(void){
+		reset_query_state();
+		status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+		CHECK_EQUAL(0, status);
+		CHECK_EQUAL(1, gatt_query_complete);
+		verify_primary_services();
+	}
+};
+
+TEST(GATTClientCache, ReportedFromRunLoop){
+	discover_primary_services_from_remote();
+	CHECK(tlv_len > GATT_CLIENT_CACHE_HEADER_SIZE);
+
+	// reconnect, results are reported after query function returned
+	mock_simulate_disconnected(gatt_client_handle);
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(0, gatt_query_complete);
+	CHECK_EQUAL(0, result_counter);
+	CHECK_EQUAL(GATT_CLIENT_IN_WRONG_STATE, gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle));
+
+	mock_run_loop_process_zero_timeouts();
+	CHECK_EQUAL(1, gatt_query_complete);
+	verify_primary_services();
+}
+
+TEST(GATTClientCache, DisconnectWhileReportPending){
+	discover_primary_services_from_remote();
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(0, status);
+
+	mock_simulate_disconnected(gatt_client_handle);
+	CHECK_EQUAL(ATT_ERROR_HCI_DISCONNECT_RECEIVED, gatt_query_status);
+	CHECK_EQUAL(0, result_counter);
+
+	// deferred report was cancelled
+	mock_run_loop_process_zero_timeouts();
+	CHECK_EQUAL(0, result_counter);
+}
+
+TEST(GATTClientCache, ServiceChangedDropsCache){
+	discover_primary_services_from_remote();
+
+	// Service Changed is part of GATT Service
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &services[1]);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(1, result_counter);
+	CHECK_EQUAL(GAP_SERVICE_CHANGED, characteristics[0].uuid16);
+	uint16_t service_changed_handle = characteristics[0].value_handle;
+
+	// indication of other characteristic keeps cache
+	uint8_t range[4];
+	little_endian_store_16(range, 0, 0x0001);
+	little_endian_store_16(range, 2, 0xffff);
+	mock_simulate_att_indication(gatt_client_handle, service_changed_handle + 1, range, sizeof(range));
+	CHECK(tlv_len > GATT_CLIENT_CACHE_HEADER_SIZE);
+
+	mock_simulate_att_indication(gatt_client_handle, service_changed_handle, range, sizeof(range));
+	CHECK_EQUAL(0, tlv_len);
+
+	// next query is sent to remote
+	discover_primary_services_from_remote();
+	CHECK(tlv_len > GATT_CLIENT_CACHE_HEADER_SIZE);
+}
+
+TEST(GATTClientCache, ServiceChangedWhileReportPending){
+	discover_primary_services_from_remote();
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &services[1]);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+	uint16_t service_changed_handle = characteristics[0].value_handle;
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &services[1]);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(0, gatt_query_complete);
+
+	uint8_t range[4];
+	little_endian_store_16(range, 0, 0x0001);
+	little_endian_store_16(range, 2, 0xffff);
+	mock_simulate_att_indication(gatt_client_handle, service_changed_handle, range, sizeof(range));
+
+	// query is performed instead of reporting dropped results
+	mock_run_loop_process_zero_timeouts();
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(1, result_counter);
+	CHECK_EQUAL(GAP_SERVICE_CHANGED, characteristics[0].uuid16);
+}
 
 int main (int argc, const char * argv[]){
 	att_set_db(profile_data);
@@ -21,6 +21,9 @@ static const uint16_t max_mtu = 23;
 static uint8_t  l2cap_stack_buffer[PREBUFFER_SIZE + max_mtu];	// pre buffer + HCI Header + L2CAP header
 static uint16_t gatt_client_handle = 0x40;
 static hci_connection_t hci_connection;
+static int le_device_index = -1;
+static const uint8_t * database_hash;
+static btstack_linked_list_t timers;
 
 uint16_t get_gatt_client_handle(void){
 	return gatt_client_handle;
@@ -41,6 +44,32 @@ void mock_simulate_connected(void){
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
 }
 
+void mock_simulate_disconnected(hci_con_handle_t con_handle){
+	uint8_t packet[] = {HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, 0, 0, 0x13};
+	little_endian_store_16(packet, 3, con_handle);
+	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
+}
+
+void mock_simulate_att_indication(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t * value, uint16_t value_len){
+	// events are assembled in place, provide pre buffer
+	uint8_t buffer[PREBUFFER_SIZE + 32];
+	uint8_t * packet = &buffer[PREBUFFER_SIZE];
+	packet[0] = ATT_HANDLE_VALUE_INDICATION;
+	little_endian_store_16(packet, 1, attribute_handle);
+	memcpy(&packet[3], value, value_len);
+	att_packet_handler(ATT_DATA_PACKET, con_handle, packet, 3 + value_len);
+}
+
+// bonded device index for sm_le_device_index
+void mock_set_le_device_index(int index){
+	le_device_index = index;
+}
+
+// answer Read By Type for Database Hash, not part of profile.gatt
+void mock_set_database_hash(const uint8_t * hash){
+	database_hash = hash;
+}
+
 void mock_simulate_scan_response(void){
 	uint8_t packet[] = {0xE2, 0x13, 0xE2, 0x01, 0x34, 0xB1, 0xF7, 0xD1, 0x77, 0x9B, 0xCC, 0x09, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
@@ -105,6 +134,9 @@ int l2cap_reserve_packet_buffer(void){
 	return 1;
 }
 
+void l2cap_release_packet_buffer(void){
+}
+
 int l2cap_can_send_fixed_channel_packet_now(uint16_t handle, uint16_t channel_id){
 	return 1;
 }
@@ -119,7 +151,17 @@ int l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t l
 	att_init_connection(&att_connection);
 	uint8_t response_buffer[PREBUFFER_SIZE + max_mtu];
 	uint8_t * response = &response_buffer[PREBUFFER_SIZE];
-	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, response);
+	uint8_t * request = l2cap_get_outgoing_buffer();
+	uint16_t response_len;
+	if ((database_hash != NULL) && (request[0] == ATT_READ_BY_TYPE_REQUEST) && (len == 7) && (little_endian_read_16(request, 5) == GAP_DATABASE_HASH)){
+		response[0] = ATT_READ_BY_TYPE_RESPONSE;
+		response[1] = 18;
+		little_endian_store_16(response, 2, 0x0100);
+		memcpy(&response[4], database_hash, 16);
+		response_len = 20;
+	} else {
+		response_len = att_handle_request(&att_connection, request, len, response);
+	}
 	if (response_len){
 		att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response[0], response_len);
 	}
@@ -136,7 +178,7 @@ void sm_cmac_signed_write_start(const sm_key_t key, uint8_t opcode, uint16_t att
 	//sm_notify_client(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, sm_central_device_addr_type, sm_central_device_address, 0, sm_central_device_matched);      
 }
 int sm_le_device_index(uint16_t handle ){
-	return -1;
+	return le_device_index;
 }
 void sm_send_security_request(hci_con_handle_t con_handle){
 }
@@ -145,20 +187,46 @@ irk_lookup_state_t sm_identity_resolving_state(hci_con_handle_t con_handle){
 	return IRK_LOOKUP_SUCCEEDED;
 }
 void btstack_run_loop_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+	a->timeout = timeout_in_ms;
 }
 
 // Set callback that will be executed when timer expires.
 void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *_ts)){
+	ts->process = process;
+}
+
+void btstack_run_loop_set_timer_context(btstack_timer_source_t *ts, void * context){
+	ts->context = context;
+}
+
+void * btstack_run_loop_get_timer_context(btstack_timer_source_t *ts){
+	return ts->context;
 }
 
 // Add/Remove timer source.
 void btstack_run_loop_add_timer(btstack_timer_source_t *timer){
+	btstack_linked_list_add_tail(&timers, (btstack_linked_item_t *) timer);
 }
 
 int  btstack_run_loop_remove_timer(btstack_timer_source_t *timer){
+	btstack_linked_list_remove(&timers, (btstack_linked_item_t *) timer);
 	return 1;
 }
 
+// execute timers with zero timeout, e.g. used to defer callbacks
+void mock_run_loop_process_zero_timeouts(void){
+	btstack_linked_list_iterator_t it;
+	btstack_linked_list_iterator_init(&it, &timers);
+	while (btstack_linked_list_iterator_has_next(&it)){
+		btstack_timer_source_t * timer = (btstack_timer_source_t *) btstack_linked_list_iterator_next(&it);
+		if (timer->timeout != 0) continue;
+		btstack_linked_list_iterator_remove(&it);
+		timer->process(timer);
+		// handler might have modified list
+		btstack_linked_list_iterator_init(&it, &timers);
+	}
+}
+
 // todo:
 hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t addr, bd_addr_type_t addr_type){
 	printf("hci_connection_for_bd_addr_and_type not implemented in mock backend\n");
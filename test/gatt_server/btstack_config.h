@@ -26,6 +26,9 @@
 #define ENABLE_SDP_EXTRA_QUERIES
 #define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 #define ENABLE_ATT_DELAYED_RESPONSE
+#define ENABLE_ATT_SERVER_ASYNC_RESPONSE
+#define ENABLE_ATT_SERVER_CONNECTION_TABLE
+#define ENABLE_ATT_SERVER_NOTIFICATION_QUEUE
 
 // BTstack configuration. buffers, sizes, ...
 #define HCI_ACL_PAYLOAD_SIZE 52
@@ -33,6 +36,9 @@
 
 #define MAX_NR_LE_DEVICE_DB_ENTRIES 4
 
+#define ATT_SERVER_MAX_CONNECTIONS 2
+#define ATT_SERVER_NOTIFICATION_QUEUE_SIZE 24
+
 #define NVM_NUM_LINK_KEYS 2
 
 #endif
@@ -23,6 +23,270 @@
 #include "ble/att_db.h"
 #include "profile.h"
 
+extern uint16_t get_gatt_client_handle(void);
+extern void mock_simulate_connected(void);
+extern void mock_simulate_le_connection(hci_con_handle_t con_handle);
+extern void mock_simulate_disconnected(hci_con_handle_t con_handle);
+extern void mock_simulate_att_pdu(const uint8_t * pdu, uint16_t len);
+extern void mock_simulate_att_pdu_for_handle(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t len);
+extern void mock_set_can_send_budget(int num_packets);
+extern hci_con_handle_t mock_get_sent_pdu_handle(void);
+extern hci_con_handle_t mock_get_disconnect_handle(void);
+extern void mock_clear_sent_pdus(void);
+extern int  mock_get_sent_pdu_count(void);
+extern const uint8_t * mock_get_sent_pdu(uint16_t * len);
+
+#define ASYNC_HANDLE   ATT_CHARACTERISTIC_GAP_DEVICE_NAME_01_VALUE_HANDLE
+#define COMMAND_HANDLE ATT_CHARACTERISTIC_F10D_01_VALUE_HANDLE
+#define READ_HANDLE    ATT_CHARACTERISTIC_GAP_APPEARANCE_01_VALUE_HANDLE
+
+static att_server_token_t pending_token;
+static int      write_callback_count;
+static uint16_t last_written_handle;
+
+static uint16_t async_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    if (attribute_handle != ASYNC_HANDLE) return 0;
+    pending_token = att_server_get_token(con_handle);
+    return ATT_READ_RESPONSE_PENDING;
+}
+
+static int async_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    write_callback_count++;
+    last_written_handle = attribute_handle;
+    if (attribute_handle != ASYNC_HANDLE) return 0;
+    pending_token = att_server_get_token(con_handle);
+    return ATT_ERROR_WRITE_RESPONSE_PENDING;
+}
+
+static void check_sent_pdu(const uint8_t * expected, uint16_t expected_len){
+    uint16_t len;
+    const uint8_t * pdu = mock_get_sent_pdu(&len);
+    CHECK_EQUAL(expected_len, len);
+    MEMCMP_EQUAL(expected, pdu, expected_len);
+}
+
+TEST_GROUP(ATTServerAsync){
+    void setup(void){
+        pending_token = 0;
+        write_callback_count = 0;
+        last_written_handle = 0;
+        att_server_init(profile_data, &async_read_callback, &async_write_callback);
+        mock_set_can_send_budget(-1);
+        mock_simulate_connected();
+        mock_clear_sent_pdus();
+    }
+    void teardown(void){
+        mock_simulate_disconnected(get_gatt_client_handle());
+    }
+};
+
+TEST(ATTServerAsync, ReadResponseReady){
+    const uint8_t read_request[] = { ATT_READ_REQUEST, ASYNC_HANDLE, 0x00 };
+    mock_simulate_att_pdu(read_request, sizeof(read_request));
+    CHECK(pending_token != 0);
+    CHECK_EQUAL(0, mock_get_sent_pdu_count());
+
+    const uint8_t value[] = { 'a', 's', 'y', 'n', 'c' };
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_read_response_ready(pending_token, value, sizeof(value)));
+    CHECK_EQUAL(1, mock_get_sent_pdu_count());
+    const uint8_t read_response[] = { ATT_READ_RESPONSE, 'a', 's', 'y', 'n', 'c' };
+    check_sent_pdu(read_response, sizeof(read_response));
+
+    // token is consumed by the response
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_read_response_ready(pending_token, value, sizeof(value)));
+}
+
+TEST(ATTServerAsync, WriteResponseReady){
+    const uint8_t write_request[] = { ATT_WRITE_REQUEST, ASYNC_HANDLE, 0x00, 0x42 };
+    mock_simulate_att_pdu(write_request, sizeof(write_request));
+    CHECK_EQUAL(1, write_callback_count);
+    CHECK_EQUAL(0, mock_get_sent_pdu_count());
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_write_response_ready(pending_token, ATT_ERROR_SUCCESS));
+    CHECK_EQUAL(1, mock_get_sent_pdu_count());
+    const uint8_t write_response[] = { ATT_WRITE_RESPONSE };
+    check_sent_pdu(write_response, sizeof(write_response));
+    // stored result is used, write callback is not called again
+    CHECK_EQUAL(1, write_callback_count);
+}
+
+TEST(ATTServerAsync, WriteResponseReadyError){
+    const uint8_t write_request[] = { ATT_WRITE_REQUEST, ASYNC_HANDLE, 0x00, 0x42 };
+    mock_simulate_att_pdu(write_request, sizeof(write_request));
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_write_response_ready(pending_token, 0x80));
+    const uint8_t error_response[] = { ATT_ERROR_RESPONSE, ATT_WRITE_REQUEST, ASYNC_HANDLE, 0x00, 0x80 };
+    check_sent_pdu(error_response, sizeof(error_response));
+}
+
+TEST(ATTServerAsync, WriteCommandQueuedWhilePending){
+    const uint8_t write_request[] = { ATT_WRITE_REQUEST, ASYNC_HANDLE, 0x00, 0x42 };
+    mock_simulate_att_pdu(write_request, sizeof(write_request));
+    const uint8_t write_command[] = { ATT_WRITE_COMMAND, COMMAND_HANDLE, 0x00, 0x17 };
+    mock_simulate_att_pdu(write_command, sizeof(write_command));
+    // command waits for the pending request
+    CHECK_EQUAL(1, write_callback_count);
+    CHECK_EQUAL(ASYNC_HANDLE, last_written_handle);
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_write_response_ready(pending_token, ATT_ERROR_SUCCESS));
+    const uint8_t write_response[] = { ATT_WRITE_RESPONSE };
+    check_sent_pdu(write_response, sizeof(write_response));
+    CHECK_EQUAL(2, write_callback_count);
+    CHECK_EQUAL(COMMAND_HANDLE, last_written_handle);
+}
+
+TEST(ATTServerAsync, InvalidToken){
+    const uint8_t value[] = { 0x01 };
+    // unknown connection, no request pending
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, att_server_read_response_ready(0x10000u | (get_gatt_client_handle() + 2), value, sizeof(value)));
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_read_response_ready(0x10000u | get_gatt_client_handle(), value, sizeof(value)));
+
+    const uint8_t read_request[] = { ATT_READ_REQUEST, ASYNC_HANDLE, 0x00 };
+    mock_simulate_att_pdu(read_request, sizeof(read_request));
+    // wrong sequence number, wrong operation
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_read_response_ready(pending_token + 0x10000u, value, sizeof(value)));
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, att_server_write_response_ready(pending_token, ATT_ERROR_SUCCESS));
+    CHECK_EQUAL(0, mock_get_sent_pdu_count());
+
+    // value larger than ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE
+    uint8_t large_value[ATT_SERVER_ASYNC_VALUE_BUFFER_SIZE + 1];
+    memset(large_value, 0, sizeof(large_value));
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, att_server_read_response_ready(pending_token, large_value, sizeof(large_value)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_read_response_ready(pending_token, value, sizeof(value)));
+    CHECK_EQUAL(1, mock_get_sent_pdu_count());
+}
+
+TEST_GROUP(ATTServerConnectionTable){
+    hci_con_handle_t con_handle_a;
+    hci_con_handle_t con_handle_b;
+    hci_con_handle_t con_handle_c;
+    void setup(void){
+        con_handle_a = get_gatt_client_handle();
+        con_handle_b = con_handle_a + 1;
+        con_handle_c = con_handle_a + 2;
+        att_server_init(profile_data, &async_read_callback, &async_write_callback);
+        mock_set_can_send_budget(-1);
+        mock_simulate_le_connection(con_handle_a);
+        mock_simulate_le_connection(con_handle_b);
+        mock_clear_sent_pdus();
+    }
+    void teardown(void){
+        mock_set_can_send_budget(-1);
+        mock_simulate_disconnected(con_handle_a);
+        mock_simulate_disconnected(con_handle_b);
+    }
+    void send_read_request(hci_con_handle_t con_handle){
+        const uint8_t read_request[] = { ATT_READ_REQUEST, READ_HANDLE, 0x00 };
+        mock_simulate_att_pdu_for_handle(con_handle, read_request, sizeof(read_request));
+    }
+};
+
+TEST(ATTServerConnectionTable, DisconnectWhenFull){
+    // ATT_SERVER_MAX_CONNECTIONS = 2
+    mock_simulate_le_connection(con_handle_c);
+    CHECK_EQUAL(con_handle_c, mock_get_disconnect_handle());
+    mock_simulate_disconnected(con_handle_c);
+
+    // slot is reused after disconnect
+    mock_simulate_disconnected(con_handle_a);
+    mock_simulate_le_connection(con_handle_c);
+    send_read_request(con_handle_c);
+    CHECK_EQUAL(1, mock_get_sent_pdu_count());
+    CHECK_EQUAL(con_handle_c, mock_get_sent_pdu_handle());
+    mock_simulate_disconnected(con_handle_c);
+}
+
+TEST(ATTServerConnectionTable, RoundRobin){
+    mock_set_can_send_budget(0);
+    send_read_request(con_handle_a);
+    send_read_request(con_handle_b);
+    CHECK_EQUAL(0, mock_get_sent_pdu_count());
+
+    // one PDU per can send now event
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(1, mock_get_sent_pdu_count());
+    hci_con_handle_t first = mock_get_sent_pdu_handle();
+    hci_con_handle_t second = (first == con_handle_a) ? con_handle_b : con_handle_a;
+
+    // served connection is ready again, other one goes first
+    send_read_request(first);
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(2, mock_get_sent_pdu_count());
+    CHECK_EQUAL(second, mock_get_sent_pdu_handle());
+
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(3, mock_get_sent_pdu_count());
+    CHECK_EQUAL(first, mock_get_sent_pdu_handle());
+}
+
+TEST_GROUP(ATTServerNotificationQueue){
+    void setup(void){
+        att_server_init(profile_data, &async_read_callback, &async_write_callback);
+        mock_set_can_send_budget(0);
+        mock_simulate_connected();
+        mock_clear_sent_pdus();
+    }
+    void teardown(void){
+        mock_set_can_send_budget(-1);
+        mock_simulate_disconnected(get_gatt_client_handle());
+    }
+    // 4 notifications with 2 byte value fill the queue
+    void queue_notifications(void){
+        uint8_t i;
+        for (i = 0; i < 4; i++){
+            const uint8_t value[] = { i, 0x10 };
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_notify_queued(get_gatt_client_handle(), 0x0010 + i, value, sizeof(value)));
+        }
+    }
+};
+
+TEST(ATTServerNotificationQueue, SentOnCanSendNow){
+    queue_notifications();
+    CHECK_EQUAL(0, mock_get_sent_pdu_count());
+
+    // one notification per can send now event, in order
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        mock_set_can_send_budget(1);
+        CHECK_EQUAL(i + 1, mock_get_sent_pdu_count());
+        const uint8_t notification[] = { ATT_HANDLE_VALUE_NOTIFICATION, (uint8_t)(0x10 + i), 0x00, i, 0x10 };
+        check_sent_pdu(notification, sizeof(notification));
+    }
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(4, mock_get_sent_pdu_count());
+}
+
+TEST(ATTServerNotificationQueue, QueueFull){
+    queue_notifications();
+    const uint8_t value[] = { 0x01 };
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, att_server_notify_queued(get_gatt_client_handle(), 0x0020, value, sizeof(value)));
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, att_server_notify_queued(get_gatt_client_handle() + 2, 0x0020, value, sizeof(value)));
+
+    // space is available after first notification was sent
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, att_server_notify_queued(get_gatt_client_handle(), 0x0020, value, sizeof(value)));
+}
+
+TEST(ATTServerNotificationQueue, MultipleHandleValueNotification){
+    att_server_set_multiple_handle_value_notifications_supported(get_gatt_client_handle(), true);
+    queue_notifications();
+
+    // three handle length value tuples fit into default MTU of 23
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(1, mock_get_sent_pdu_count());
+    const uint8_t multiple[] = { ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION,
+        0x10, 0x00, 0x02, 0x00, 0x00, 0x10,
+        0x11, 0x00, 0x02, 0x00, 0x01, 0x10,
+        0x12, 0x00, 0x02, 0x00, 0x02, 0x10 };
+    check_sent_pdu(multiple, sizeof(multiple));
+
+    // single remaining notification is sent as regular notification
+    mock_set_can_send_budget(1);
+    CHECK_EQUAL(2, mock_get_sent_pdu_count());
+    const uint8_t notification[] = { ATT_HANDLE_VALUE_NOTIFICATION, 0x13, 0x00, 0x03, 0x10 };
+    check_sent_pdu(notification, sizeof(notification));
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -18,12 +18,73 @@ static btstack_linked_list_t     connections;
 static const uint16_t max_mtu = 23;
 static uint8_t  l2cap_stack_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8 + max_mtu];	// pre buffer + HCI Header + L2CAP header
 static uint16_t gatt_client_handle = 0x40;
-static hci_connection_t hci_connection;
+
+// connections use handles gatt_client_handle + index
+#define MOCK_MAX_NR_CONNECTIONS 3
+static hci_connection_t hci_connections[MOCK_MAX_NR_CONNECTIONS];
+
+// last PDU sent by ATT Server
+static uint8_t  sent_pdu[max_mtu];
+static uint16_t sent_pdu_len;
+static hci_con_handle_t sent_pdu_handle = HCI_CON_HANDLE_INVALID;
+static int      sent_pdu_count;
+
+// number of packets that can be sent, -1 for unlimited
+static int  can_send_budget = -1;
+static bool can_send_now_requested;
+
+static hci_con_handle_t disconnect_handle = HCI_CON_HANDLE_INVALID;
 
 uint16_t get_gatt_client_handle(void){
 	return gatt_client_handle;
 }
 
+void mock_clear_sent_pdus(void){
+	sent_pdu_len = 0;
+	sent_pdu_handle = HCI_CON_HANDLE_INVALID;
+	sent_pdu_count = 0;
+}
+
+hci_con_handle_t mock_get_sent_pdu_handle(void){
+	return sent_pdu_handle;
+}
+
+int mock_get_sent_pdu_count(void){
+	return sent_pdu_count;
+}
+
+const uint8_t * mock_get_sent_pdu(uint16_t * len){
+	*len = sent_pdu_len;
+	return sent_pdu;
+}
+
+void mock_simulate_att_pdu_for_handle(hci_con_handle_t con_handle, const uint8_t * pdu, uint16_t len){
+	uint8_t buffer[max_mtu];
+	(void)memcpy(buffer, pdu, len);
+	att_packet_handler(ATT_DATA_PACKET, con_handle, buffer, len);
+}
+
+void mock_simulate_att_pdu(const uint8_t * pdu, uint16_t len){
+	mock_simulate_att_pdu_for_handle(gatt_client_handle, pdu, len);
+}
+
+static void mock_emit_can_send_now(void){
+	uint8_t event[] = { L2CAP_EVENT_CAN_SEND_NOW, 2, 1, 0};
+	att_packet_handler(HCI_EVENT_PACKET, 0, (uint8_t*)event, sizeof(event));
+}
+
+void mock_set_can_send_budget(int num_packets){
+	can_send_budget = num_packets;
+	if ((can_send_budget != 0) && can_send_now_requested){
+		can_send_now_requested = false;
+		mock_emit_can_send_now();
+	}
+}
+
+hci_con_handle_t mock_get_disconnect_handle(void){
+	return disconnect_handle;
+}
+
 void mock_simulate_command_complete(const hci_cmd_t *cmd){
 	uint8_t packet[] = {HCI_EVENT_COMMAND_COMPLETE, 4, 1, (uint8_t) (cmd->opcode & 0xff), (uint8_t) (cmd->opcode >> 8), 0};
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
@@ -34,11 +95,26 @@ void mock_simulate_hci_state_working(void){
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, 3);
 }
 
-void mock_simulate_connected(void){
+void mock_simulate_le_connection(hci_con_handle_t con_handle){
+	hci_connection_t * hci_connection = &hci_connections[con_handle - gatt_client_handle];
+	hci_connection->con_handle = con_handle;
+	btstack_linked_list_add(&connections, (btstack_linked_item_t *) hci_connection);
 	uint8_t packet[] = {0x3E, 0x13, 0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x9B, 0x77, 0xD1, 0xF7, 0xB1, 0x34, 0x50, 0x00, 0x00, 0x00, 0xD0, 0x07, 0x05};
+	little_endian_store_16(packet, 4, con_handle);
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
 }
 
+void mock_simulate_connected(void){
+	mock_simulate_le_connection(gatt_client_handle);
+}
+
+void mock_simulate_disconnected(hci_con_handle_t con_handle){
+	uint8_t packet[] = {HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, 0, 0, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION};
+	little_endian_store_16(packet, 3, con_handle);
+	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
+	btstack_linked_list_remove(&connections, (btstack_linked_item_t *) &hci_connections[con_handle - gatt_client_handle]);
+}
+
 void mock_simulate_scan_response(void){
 	uint8_t packet[] = {0xE2, 0x13, 0xE2, 0x01, 0x34, 0xB1, 0xF7, 0xD1, 0x77, 0x9B, 0xCC, 0x09, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
@@ -51,6 +127,10 @@ void gap_stop_scan(void){
 uint8_t gap_connect(bd_addr_t addr, bd_addr_type_t addr_type){
 	return 0;
 }
+uint8_t gap_disconnect(hci_con_handle_t handle){
+	disconnect_handle = handle;
+	return 0;
+}
 void gap_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window){
 }
 
@@ -59,16 +139,8 @@ int gap_reconnect_security_setup_active(hci_con_handle_t con_handle){
 	return 0;
 }
 
-static void att_init_connection(att_connection_t * att_connection){
-    att_connection->mtu = 23;
-    att_connection->max_mtu = 23;
-    att_connection->encryption_key_size = 0;
-    att_connection->authenticated = 0;
-	att_connection->authorized = 0;
-}
-
 int hci_can_send_acl_le_packet_now(void){
-	return 1;
+	return can_send_budget != 0;
 }
 
 int  l2cap_can_send_connectionless_packet_now(void){
@@ -108,21 +180,24 @@ void l2cap_release_packet_buffer(void){
 }
 
 int l2cap_can_send_fixed_channel_packet_now(uint16_t handle, uint16_t channel_id){
-	return 1;
+	return can_send_budget != 0;
 }
 
 void l2cap_request_can_send_fix_channel_now_event(uint16_t handle, uint16_t channel_id){
-	uint8_t event[] = { L2CAP_EVENT_CAN_SEND_NOW, 2, 1, 0};
-	att_packet_handler(HCI_EVENT_PACKET, 0, (uint8_t*)event, sizeof(event));
+	if (can_send_budget == 0){
+		can_send_now_requested = true;
+		return;
+	}
+	mock_emit_can_send_now();
 }
 
 int l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t len){
-	att_connection_t att_connection;
-	att_init_connection(&att_connection);
-	uint8_t response[max_mtu];
-	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, &response[0]);
-	if (response_len){
-		att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response[0], response_len);
+	sent_pdu_len = btstack_min(len, sizeof(sent_pdu));
+	(void)memcpy(sent_pdu, l2cap_get_outgoing_buffer(), sent_pdu_len);
+	sent_pdu_handle = handle;
+	sent_pdu_count++;
+	if (can_send_budget > 0){
+		can_send_budget--;
 	}
 	return 0;
 }
@@ -172,7 +247,13 @@ hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t addr, bd_addr_t
 	return NULL;
 }
 hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
-	return &hci_connection;
+	btstack_linked_list_iterator_t it;
+	btstack_linked_list_iterator_init(&it, &connections);
+	while (btstack_linked_list_iterator_has_next(&it)){
+		hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+		if (hci_connection->con_handle == con_handle) return hci_connection;
+	}
+	return NULL;
 }
 void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
 	// printf("hci_connections_get_iterator not implemented in mock backend\n");
@@ -0,0 +1,40 @@
+//
+// btstack_config.h for hci tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+// #define ENABLE_LOG_DEBUG
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO 
+#define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_CENTRAL
+#define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+#define ENABLE_HCI_COMMAND_QUEUE
+#define ENABLE_LE_ISOCHRONOUS_STREAMS
+#define ENABLE_HCI_CONNECTION_LOOKUP_TABLE
+#define ENABLE_HCI_ACL_BUFFER_PROVIDER
+#define ENABLE_L2CAP_WEIGHTED_SCHEDULING
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1021
+#define HCI_INCOMING_PRE_BUFFER_SIZE 4
+
+// small lookup tables to get collisions
+#define HCI_CONNECTION_HANDLE_TABLE_SIZE 4
+#define HCI_CONNECTION_ADDRESS_TABLE_SIZE 2
+
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+
+#define NVM_NUM_DEVICE_DB_ENTRIES 4
+#define NVM_NUM_LINK_KEYS 2
+
+#endif
@@ -0,0 +1,848 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_test.c"
+
+/*
+ *  hci_test.c
+ *
+ *  HCI over simulated Controller
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "bluetooth.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "gap.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+
+#include "mock_btstack_run_loop.h"
+#include "mock_hci_transport.h"
+
+#define TEST_CON_HANDLE   0x0001
+
+static const bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static uint16_t rssi_events;
+static int8_t   last_rssi;
+
+static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case GAP_EVENT_RSSI_MEASUREMENT:
+            rssi_events++;
+            last_rssi = (int8_t) gap_event_rssi_measurement_get_rssi(packet);
+            break;
+        default:
+            break;
+    }
+}
+
+static void receive_read_rssi_complete(int8_t rssi){
+    uint8_t return_params[3];
+    little_endian_store_16(return_params, 0, TEST_CON_HANDLE);
+    return_params[2] = (uint8_t) rssi;
+    mock_hci_transport_receive_command_complete(hci_read_rssi.opcode, ERROR_CODE_SUCCESS, return_params, sizeof(return_params));
+    mock_hci_transport_process();
+}
+
+TEST_GROUP(HCI){
+    void setup(void){
+        rssi_events = 0;
+        last_rssi = 0;
+        mock_hci_transport_init();
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        hci_event_callback_registration.callback = &hci_event_handler;
+        hci_add_event_handler(&hci_event_callback_registration);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        mock_hci_transport_clear_packets();
+    }
+};
+
+TEST(HCI, PowerOn){
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK_EQUAL(1021, hci_max_acl_data_packet_length());
+}
+
+// HCI Connection Lookup Table
+
+static const bd_addr_t other_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x77 };
+
+// maps to same handle table entry as TEST_CON_HANDLE
+#define TEST_OTHER_CON_HANDLE (TEST_CON_HANDLE + HCI_CONNECTION_HANDLE_TABLE_SIZE)
+
+TEST(HCI, ConnectionLookupCollidingHandles){
+    hci_connection_t * conn = hci_connection_for_handle(TEST_CON_HANDLE);
+    CHECK(conn != NULL);
+    mock_hci_transport_connect_classic(other_addr, TEST_OTHER_CON_HANDLE);
+    hci_connection_t * other_conn = hci_connection_for_handle(TEST_OTHER_CON_HANDLE);
+    CHECK(other_conn != NULL);
+    CHECK(other_conn != conn);
+    CHECK_EQUAL(TEST_OTHER_CON_HANDLE, other_conn->con_handle);
+    POINTERS_EQUAL(conn, hci_connection_for_handle(TEST_CON_HANDLE));
+    POINTERS_EQUAL(other_conn, hci_connection_for_handle(TEST_OTHER_CON_HANDLE));
+    POINTERS_EQUAL(NULL, hci_connection_for_handle(TEST_CON_HANDLE + 1));
+}
+
+TEST(HCI, ConnectionLookupByAddress){
+    mock_hci_transport_connect_classic(other_addr, TEST_OTHER_CON_HANDLE);
+    hci_connection_t * conn = hci_connection_for_handle(TEST_CON_HANDLE);
+    hci_connection_t * other_conn = hci_connection_for_handle(TEST_OTHER_CON_HANDLE);
+    POINTERS_EQUAL(conn, hci_connection_for_bd_addr_and_type((uint8_t *) remote_addr, BD_ADDR_TYPE_ACL));
+    POINTERS_EQUAL(other_conn, hci_connection_for_bd_addr_and_type((uint8_t *) other_addr, BD_ADDR_TYPE_ACL));
+    POINTERS_EQUAL(conn, hci_connection_for_bd_addr_and_type((uint8_t *) remote_addr, BD_ADDR_TYPE_ACL));
+    POINTERS_EQUAL(NULL, hci_connection_for_bd_addr_and_type((uint8_t *) remote_addr, BD_ADDR_TYPE_LE_PUBLIC));
+}
+
+TEST(HCI, ConnectionLookupAfterDisconnect){
+    CHECK(hci_connection_for_handle(TEST_CON_HANDLE) != NULL);
+    CHECK(hci_connection_for_bd_addr_and_type((uint8_t *) remote_addr, BD_ADDR_TYPE_ACL) != NULL);
+    mock_hci_transport_disconnect(TEST_CON_HANDLE, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+    mock_hci_transport_process();
+    POINTERS_EQUAL(NULL, hci_connection_for_handle(TEST_CON_HANDLE));
+    POINTERS_EQUAL(NULL, hci_connection_for_bd_addr_and_type((uint8_t *) remote_addr, BD_ADDR_TYPE_ACL));
+    // reconnect reuses handle
+    mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+    hci_connection_t * conn = hci_connection_for_handle(TEST_CON_HANDLE);
+    CHECK(conn != NULL);
+    POINTERS_EQUAL(conn, hci_connection_for_bd_addr_and_type((uint8_t *) remote_addr, BD_ADDR_TYPE_ACL));
+}
+
+// L2CAP Weighted Scheduling over connections with one channel each
+
+#define TEST_PSM                0x1001
+#define TEST_NUM_CONNECTIONS    3
+#define TEST_SCHEDULING_EVENTS  12
+#define CONFIG_OPTION_TYPE_MTU  0x01
+
+static uint8_t  remote_sig_id;
+static uint16_t scheduling_cids[TEST_NUM_CONNECTIONS];
+static uint16_t scheduling_num_cids;
+static uint16_t scheduling_order[TEST_SCHEDULING_EVENTS];
+static uint16_t scheduling_num_events;
+
+static void remote_send_signaling(hci_con_handle_t con_handle, uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t data_len){
+    uint8_t packet[32];
+    little_endian_store_16(packet, 0, con_handle | (0x02 << 12));
+    little_endian_store_16(packet, 2, 8 + data_len);
+    little_endian_store_16(packet, 4, 4 + data_len);
+    little_endian_store_16(packet, 6, L2CAP_CID_SIGNALING);
+    packet[8] = code;
+    packet[9] = sig_id;
+    little_endian_store_16(packet, 10, data_len);
+    (void)memcpy(&packet[12], data, data_len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 12 + data_len);
+}
+
+// configure channels like a remote device with Basic Mode only
+static void remote_handle_packet(const mock_hci_transport_packet_t * packet){
+    if (packet->type != HCI_ACL_DATA_PACKET) return;
+    if (little_endian_read_16(packet->buffer, 6) != L2CAP_CID_SIGNALING) return;
+    hci_con_handle_t con_handle = little_endian_read_16(packet->buffer, 0) & 0x0fff;
+    const uint8_t * command = &packet->buffer[8];
+    uint8_t response[8];
+    switch (command[0]){
+        case INFORMATION_REQUEST:
+            little_endian_store_16(response, 0, little_endian_read_16(command, 4));
+            little_endian_store_16(response, 2, 1);     // not supported
+            remote_send_signaling(con_handle, INFORMATION_RESPONSE, command[1], response, 4);
+            break;
+        case CONNECTION_RESPONSE:
+            little_endian_store_16(response, 0, little_endian_read_16(command, 4));
+            little_endian_store_16(response, 2, 0);
+            response[4] = CONFIG_OPTION_TYPE_MTU;
+            response[5] = 2;
+            little_endian_store_16(response, 6, 100);
+            remote_send_signaling(con_handle, CONFIGURE_REQUEST, ++remote_sig_id, response, 8);
+            break;
+        case CONFIGURE_REQUEST:
+            little_endian_store_16(response, 0, 0x0070);
+            little_endian_store_16(response, 2, 0);
+            little_endian_store_16(response, 4, 0);
+            remote_send_signaling(con_handle, CONFIGURE_RESPONSE, command[1], response, 6);
+            break;
+        default:
+            break;
+    }
+}
+
+static void scheduling_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    uint16_t cid;
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            l2cap_accept_connection(l2cap_event_incoming_connection_get_local_cid(packet));
+            break;
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            if (l2cap_event_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            scheduling_cids[scheduling_num_cids++] = l2cap_event_channel_opened_get_local_cid(packet);
+            break;
+        case L2CAP_EVENT_CAN_SEND_NOW:
+            cid = l2cap_event_can_send_now_get_local_cid(packet);
+            if (scheduling_num_events >= TEST_SCHEDULING_EVENTS) break;
+            scheduling_order[scheduling_num_events++] = cid;
+            (void) l2cap_send(cid, (uint8_t *) "x", 1);
+            // keep all channels busy
+            l2cap_request_can_send_now_event(cid);
+            break;
+        default:
+            break;
+    }
+}
+
+static void remote_open_channel(hci_con_handle_t con_handle){
+    uint8_t params[4];
+    little_endian_store_16(params, 0, TEST_PSM);
+    little_endian_store_16(params, 2, 0x0070);
+    remote_send_signaling(con_handle, CONNECTION_REQUEST, ++remote_sig_id, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+static uint16_t scheduling_count(uint16_t cid, uint16_t num_events){
+    uint16_t count = 0;
+    uint16_t i;
+    for (i = 0; i < num_events; i++){
+        if (scheduling_order[i] == cid) count++;
+    }
+    return count;
+}
+
+TEST_GROUP(L2CAP_WEIGHTED_SCHEDULING){
+    void setup(void){
+        remote_sig_id = 0;
+        scheduling_num_cids = 0;
+        scheduling_num_events = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&scheduling_packet_handler, TEST_PSM, 100, LEVEL_0);
+        mock_hci_transport_power_on();
+        bd_addr_t addr;
+        uint16_t i;
+        for (i = 0; i < TEST_NUM_CONNECTIONS; i++){
+            (void)memcpy(addr, remote_addr, 6);
+            addr[5] = (uint8_t) i;
+            mock_hci_transport_connect_classic(addr, TEST_CON_HANDLE + i);
+            remote_open_channel(TEST_CON_HANDLE + i);
+        }
+        CHECK_EQUAL(TEST_NUM_CONNECTIONS, scheduling_num_cids);
+    }
+    void run_scheduler(void){
+        uint16_t i;
+        for (i = 0; i < TEST_NUM_CONNECTIONS; i++){
+            l2cap_request_can_send_now_event(scheduling_cids[i]);
+        }
+        while (scheduling_num_events < TEST_SCHEDULING_EVENTS){
+            uint16_t num_events = scheduling_num_events;
+            mock_hci_transport_process();
+            if (num_events == scheduling_num_events) break;
+        }
+        CHECK_EQUAL(TEST_SCHEDULING_EVENTS, scheduling_num_events);
+    }
+};
+
+TEST(L2CAP_WEIGHTED_SCHEDULING, InvalidParameters){
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_set_connection_scheduling(TEST_CON_HANDLE, 0, false));
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, l2cap_set_connection_scheduling(0x0100, 1, false));
+}
+
+TEST(L2CAP_WEIGHTED_SCHEDULING, EqualWeights){
+    run_scheduler();
+    uint16_t i;
+    for (i = 0; i < TEST_NUM_CONNECTIONS; i++){
+        CHECK_EQUAL(TEST_SCHEDULING_EVENTS / TEST_NUM_CONNECTIONS, scheduling_count(scheduling_cids[i], TEST_SCHEDULING_EVENTS));
+    }
+}
+
+TEST(L2CAP_WEIGHTED_SCHEDULING, ShareByWeight){
+    // weights 1 : 2 : 3
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_connection_scheduling(TEST_CON_HANDLE + 1, 2, false));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_connection_scheduling(TEST_CON_HANDLE + 2, 3, false));
+    run_scheduler();
+    CHECK_EQUAL(2, scheduling_count(scheduling_cids[0], TEST_SCHEDULING_EVENTS));
+    CHECK_EQUAL(4, scheduling_count(scheduling_cids[1], TEST_SCHEDULING_EVENTS));
+    CHECK_EQUAL(6, scheduling_count(scheduling_cids[2], TEST_SCHEDULING_EVENTS));
+}
+
+TEST(L2CAP_WEIGHTED_SCHEDULING, LowLatencyFirst){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_connection_scheduling(TEST_CON_HANDLE + 2, 1, true));
+    run_scheduler();
+    // first channel is served right away on its request, before the low latency channel is waiting
+    CHECK_EQUAL(scheduling_cids[0], scheduling_order[0]);
+    CHECK_EQUAL(TEST_SCHEDULING_EVENTS - 1, scheduling_count(scheduling_cids[2], TEST_SCHEDULING_EVENTS));
+}
+
+// HCI ACL Buffer Provider
+
+#define TEST_PROVIDER_CID 0x0040
+
+static uint8_t  provider_buffer[32];
+static bool     provider_accept;
+static uint16_t provider_get_buffer_calls;
+static uint16_t provider_payload_len;
+static uint16_t provider_fragment_len;
+static uint16_t provider_complete_calls;
+static uint16_t provider_complete_len;
+static uint16_t provider_aborted_calls;
+static uint16_t acl_packets_received;
+static uint16_t acl_packet_size;
+
+static uint8_t * provider_get_buffer(hci_con_handle_t con_handle, uint16_t cid, uint16_t payload_len, const uint8_t * fragment, uint16_t fragment_len){
+    UNUSED(fragment);
+    CHECK_EQUAL(TEST_CON_HANDLE, con_handle);
+    CHECK_EQUAL(TEST_PROVIDER_CID, cid);
+    provider_get_buffer_calls++;
+    provider_payload_len  = payload_len;
+    provider_fragment_len = fragment_len;
+    if (!provider_accept) return NULL;
+    return provider_buffer;
+}
+
+static void provider_buffer_complete(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer, uint16_t len){
+    UNUSED(con_handle);
+    UNUSED(cid);
+    POINTERS_EQUAL(provider_buffer, buffer);
+    provider_complete_calls++;
+    provider_complete_len = len;
+}
+
+static void provider_buffer_aborted(hci_con_handle_t con_handle, uint16_t cid, uint8_t * buffer){
+    UNUSED(con_handle);
+    UNUSED(cid);
+    POINTERS_EQUAL(provider_buffer, buffer);
+    provider_aborted_calls++;
+}
+
+static const hci_acl_buffer_provider_t test_acl_buffer_provider = {
+    &provider_get_buffer,
+    &provider_buffer_complete,
+    &provider_buffer_aborted
+};
+
+static void acl_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(packet);
+    if (packet_type != HCI_ACL_DATA_PACKET) return;
+    acl_packets_received++;
+    acl_packet_size = size;
+}
+
+static void receive_acl_fragment(uint8_t pb_flag, const uint8_t * data, uint16_t len){
+    uint8_t packet[4 + 32];
+    little_endian_store_16(packet, 0, TEST_CON_HANDLE | (pb_flag << 12));
+    little_endian_store_16(packet, 2, len);
+    (void)memcpy(&packet[4], data, len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 4 + len);
+    mock_hci_transport_process();
+}
+
+// L2CAP packet with 10 byte payload in ACL fragments of 4 + 6 and 4 bytes
+static void receive_first_l2cap_fragment(void){
+    const uint8_t first[] = { 10, 0, TEST_PROVIDER_CID, 0, 0, 1, 2, 3, 4, 5 };
+    receive_acl_fragment(0x02, first, sizeof(first));
+}
+
+static void receive_last_l2cap_fragment(void){
+    const uint8_t last[]  = { 6, 7, 8, 9 };
+    receive_acl_fragment(0x01, last, sizeof(last));
+}
+
+TEST_GROUP(HCI_ACL_BUFFER_PROVIDER){
+    void setup(void){
+        memset(provider_buffer, 0, sizeof(provider_buffer));
+        provider_accept = true;
+        provider_get_buffer_calls = 0;
+        provider_payload_len = 0;
+        provider_fragment_len = 0;
+        provider_complete_calls = 0;
+        provider_complete_len = 0;
+        provider_aborted_calls = 0;
+        acl_packets_received = 0;
+        acl_packet_size = 0;
+        mock_hci_transport_init();
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        hci_register_acl_packet_handler(&acl_packet_handler);
+        hci_register_acl_buffer_provider(&test_acl_buffer_provider);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+    }
+};
+
+TEST(HCI_ACL_BUFFER_PROVIDER, ReassembleIntoProvidedBuffer){
+    receive_first_l2cap_fragment();
+    CHECK_EQUAL(1, provider_get_buffer_calls);
+    CHECK_EQUAL(10, provider_payload_len);
+    CHECK_EQUAL(6, provider_fragment_len);
+    CHECK_EQUAL(0, provider_complete_calls);
+
+    receive_last_l2cap_fragment();
+    CHECK_EQUAL(1, provider_complete_calls);
+    CHECK_EQUAL(4, provider_complete_len);
+    const uint8_t expected[] = { 6, 7, 8, 9 };
+    MEMCMP_EQUAL(expected, provider_buffer, sizeof(expected));
+    CHECK_EQUAL(0, acl_packets_received);
+}
+
+TEST(HCI_ACL_BUFFER_PROVIDER, CompletePacketNotProvided){
+    const uint8_t packet[] = { 2, 0, TEST_PROVIDER_CID, 0, 1, 2 };
+    receive_acl_fragment(0x02, packet, sizeof(packet));
+    CHECK_EQUAL(0, provider_get_buffer_calls);
+    CHECK_EQUAL(1, acl_packets_received);
+}
+
+TEST(HCI_ACL_BUFFER_PROVIDER, RejectedUsesRecombinationBuffer){
+    provider_accept = false;
+    receive_first_l2cap_fragment();
+    CHECK_EQUAL(1, provider_get_buffer_calls);
+    receive_last_l2cap_fragment();
+    CHECK_EQUAL(0, provider_complete_calls);
+    CHECK_EQUAL(1, acl_packets_received);
+    CHECK_EQUAL(4 + 4 + 10, acl_packet_size);
+}
+
+TEST(HCI_ACL_BUFFER_PROVIDER, ContinuationTooLargeAborts){
+    receive_first_l2cap_fragment();
+    const uint8_t last[]  = { 6, 7, 8, 9, 10 };
+    receive_acl_fragment(0x01, last, sizeof(last));
+    CHECK_EQUAL(1, provider_aborted_calls);
+    CHECK_EQUAL(0, provider_complete_calls);
+    CHECK_EQUAL(0, acl_packets_received);
+}
+
+TEST(HCI_ACL_BUFFER_PROVIDER, NewFirstFragmentAbortsPending){
+    receive_first_l2cap_fragment();
+    receive_first_l2cap_fragment();
+    CHECK_EQUAL(1, provider_aborted_calls);
+    receive_last_l2cap_fragment();
+    CHECK_EQUAL(1, provider_complete_calls);
+}
+
+TEST(HCI_ACL_BUFFER_PROVIDER, DisconnectAbortsPending){
+    receive_first_l2cap_fragment();
+    mock_hci_transport_disconnect(TEST_CON_HANDLE, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, provider_aborted_calls);
+    CHECK_EQUAL(0, provider_complete_calls);
+}
+
+// HCI Command Queue
+
+typedef struct {
+    hci_command_request_t request;
+    uint8_t  buffer[HCI_CMD_HEADER_SIZE + 4];
+    uint16_t num_callbacks;
+    bool     aborted;
+    int8_t   rssi;
+} test_command_t;
+
+static test_command_t test_commands[3];
+
+static void test_command_callback(hci_command_request_t * request, const uint8_t * event, uint16_t size){
+    UNUSED(size);
+    test_command_t * command = (test_command_t *) request->context;
+    command->num_callbacks++;
+    if (event == NULL){
+        command->aborted = true;
+        return;
+    }
+    if (hci_event_packet_get_type(event) == HCI_EVENT_COMMAND_COMPLETE){
+        command->rssi = (int8_t) event[OFFSET_OF_DATA_IN_COMMAND_COMPLETE + 3];
+    }
+}
+
+static uint8_t test_command_queue_read_rssi(test_command_t * command){
+    memset(command, 0, sizeof(test_command_t));
+    command->request.callback = &test_command_callback;
+    command->request.context  = command;
+    return hci_send_cmd_queued(&command->request, command->buffer, &hci_read_rssi, TEST_CON_HANDLE);
+}
+
+TEST(HCI, CommandQueueComplete){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[0]));
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, test_commands[0].num_callbacks);
+    CHECK_FALSE(test_commands[0].aborted);
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+}
+
+TEST(HCI, CommandQueueRequestQueuedTwice){
+    mock_hci_transport_set_auto_respond(false);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[0]));
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, hci_send_cmd_queued(&test_commands[0].request, test_commands[0].buffer, &hci_read_rssi, TEST_CON_HANDLE));
+}
+
+TEST(HCI, CommandQueueInterleavedWithStackCommand){
+    mock_hci_transport_set_auto_respond(false);
+
+    // stack command with same opcode is in flight
+    gap_read_rssi(TEST_CON_HANDLE);
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    // queued command waits for it
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[0]));
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    // completion of stack command does not complete queued request
+    receive_read_rssi_complete(-10);
+    CHECK_EQUAL(1, rssi_events);
+    CHECK_EQUAL(-10, last_rssi);
+    CHECK_EQUAL(0, test_commands[0].num_callbacks);
+    CHECK_EQUAL(2, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    // stack command with same opcode waits for queued command
+    gap_read_rssi(TEST_CON_HANDLE);
+    mock_hci_transport_process();
+    CHECK_EQUAL(2, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    receive_read_rssi_complete(-20);
+    CHECK_EQUAL(1, test_commands[0].num_callbacks);
+    CHECK_EQUAL(-20, test_commands[0].rssi);
+    CHECK_EQUAL(3, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    receive_read_rssi_complete(-30);
+    CHECK_EQUAL(1, test_commands[0].num_callbacks);
+    // GAP_EVENT_RSSI_MEASUREMENT is also emitted for queued Read RSSI
+    CHECK_EQUAL(3, rssi_events);
+    CHECK_EQUAL(-30, last_rssi);
+}
+
+TEST(HCI, CommandQueueInOrder){
+    mock_hci_transport_set_auto_respond(false);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[0]));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[1]));
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    receive_read_rssi_complete(-1);
+    CHECK_EQUAL(1, test_commands[0].num_callbacks);
+    CHECK_EQUAL(-1, test_commands[0].rssi);
+    CHECK_EQUAL(0, test_commands[1].num_callbacks);
+    CHECK_EQUAL(2, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+
+    receive_read_rssi_complete(-2);
+    CHECK_EQUAL(1, test_commands[1].num_callbacks);
+    CHECK_EQUAL(-2, test_commands[1].rssi);
+}
+
+TEST(HCI, CommandQueuePowerOffAbortsRequests){
+    mock_hci_transport_set_auto_respond(false);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[0]));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[1]));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, test_command_queue_read_rssi(&test_commands[2]));
+    mock_hci_transport_process();
+
+    receive_read_rssi_complete(-1);
+    CHECK_EQUAL(1, test_commands[0].num_callbacks);
+    CHECK_FALSE(test_commands[0].aborted);
+
+    // second one is in flight, third one pending
+    CHECK_EQUAL(2, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+    hci_power_control(HCI_POWER_OFF);
+    mock_hci_transport_set_auto_respond(true);
+
+    // in flight command completes while halting, pending one is not sent anymore
+    receive_read_rssi_complete(-2);
+    CHECK_EQUAL(1, test_commands[1].num_callbacks);
+    CHECK_FALSE(test_commands[1].aborted);
+    CHECK_EQUAL(-2, test_commands[1].rssi);
+
+    mock_btstack_run_loop_advance_time_ms(1000);
+    mock_hci_transport_process();
+    CHECK_EQUAL(HCI_STATE_OFF, hci_get_state());
+    CHECK_EQUAL(2, mock_hci_transport_count_commands(hci_read_rssi.opcode));
+    CHECK_EQUAL(1, test_commands[2].num_callbacks);
+    CHECK_TRUE(test_commands[2].aborted);
+
+    // not accepted while off
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, test_command_queue_read_rssi(&test_commands[0]));
+}
+
+// LE Isochronous Channels
+
+#define TEST_LE_CON_HANDLE  0x0002
+#define TEST_CIS_CON_HANDLE 0x0060
+#define TEST_ISO_PACKET_LEN 40
+
+static uint16_t iso_can_send_now_events;
+static uint16_t iso_received_sdus;
+static uint8_t  iso_received_sdu[HCI_ISO_HEADER_SIZE + HCI_ISO_DATA_LOAD_HEADER_SIZE + HCI_ISO_SDU_MAX_SIZE];
+static uint16_t iso_received_size;
+
+static void iso_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    switch (packet_type){
+        case HCI_EVENT_PACKET:
+            if (hci_event_packet_get_type(packet) != HCI_EVENT_ISO_CAN_SEND_NOW) break;
+            CHECK_EQUAL(TEST_CIS_CON_HANDLE, little_endian_read_16(packet, 2));
+            iso_can_send_now_events++;
+            break;
+        case HCI_ISO_DATA_PACKET:
+            btstack_assert(size <= sizeof(iso_received_sdu));
+            (void)memcpy(iso_received_sdu, packet, size);
+            iso_received_size = size;
+            iso_received_sdus++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void receive_cis_request(void){
+    uint8_t params[7];
+    params[0] = HCI_SUBEVENT_LE_CIS_REQUEST;
+    little_endian_store_16(params, 1, TEST_LE_CON_HANDLE);
+    little_endian_store_16(params, 3, TEST_CIS_CON_HANDLE);
+    params[5] = 1;  // CIG ID
+    params[6] = 1;  // CIS ID
+    mock_hci_transport_receive_event(HCI_EVENT_LE_META, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+static void receive_cis_established(void){
+    uint8_t params[29];
+    memset(params, 0, sizeof(params));
+    params[0] = HCI_SUBEVENT_LE_CIS_ESTABLISHED;
+    params[1] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(params, 2, TEST_CIS_CON_HANDLE);
+    params[19] = 1;  // BN C to P
+    params[20] = 1;  // BN P to C
+    mock_hci_transport_receive_event(HCI_EVENT_LE_META, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+static void receive_iso_fragment(uint8_t pb_flag, const uint8_t * data, uint16_t len){
+    uint8_t packet[HCI_ISO_HEADER_SIZE + TEST_ISO_PACKET_LEN];
+    btstack_assert(len <= TEST_ISO_PACKET_LEN);
+    little_endian_store_16(packet, 0, TEST_CIS_CON_HANDLE | (pb_flag << 12));
+    little_endian_store_16(packet, 2, len);
+    (void)memcpy(&packet[HCI_ISO_HEADER_SIZE], data, len);
+    mock_hci_transport_receive_packet(HCI_ISO_DATA_PACKET, packet, HCI_ISO_HEADER_SIZE + len);
+    mock_hci_transport_process();
+}
+
+static const mock_hci_transport_packet_t * iso_packet(uint16_t nr){
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ISO_DATA_PACKET) continue;
+        if (nr == 0) return packet;
+        nr--;
+    }
+    return NULL;
+}
+
+// CIS requested by remote Central over LE connection
+TEST_GROUP(HCI_ISO){
+    void setup(void){
+        iso_can_send_now_events = 0;
+        iso_received_sdus = 0;
+        iso_received_size = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_set_le_buffers(27, 4, TEST_ISO_PACKET_LEN, 2);
+        // LE Set Host Feature
+        mock_hci_transport_set_supported_command(44, 0);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        hci_register_iso_packet_handler(&iso_packet_handler);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_le(remote_addr, TEST_LE_CON_HANDLE);
+    }
+    void open_cis(void){
+        receive_cis_request();
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, gap_cis_accept(TEST_CIS_CON_HANDLE));
+        mock_hci_transport_process();
+        CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_le_accept_cis_request.opcode));
+        receive_cis_established();
+        // input and output data path
+        CHECK_EQUAL(2, mock_hci_transport_count_commands(hci_le_setup_iso_data_path.opcode));
+    }
+};
+
+TEST(HCI_ISO, PowerOnReadsIsoBuffers){
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_le_read_buffer_size_v2.opcode));
+    CHECK_EQUAL(0, mock_hci_transport_count_commands(hci_le_read_buffer_size.opcode));
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_le_set_host_feature.opcode));
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, hci_send_iso_sdu(TEST_CIS_CON_HANDLE, NULL, 0, false, 0));
+}
+
+TEST(HCI_ISO, SendBeforeEstablishedDisallowed){
+    static const uint8_t sdu[10] = { 0 };
+    receive_cis_request();
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, hci_send_iso_sdu(TEST_CIS_CON_HANDLE, sdu, sizeof(sdu), false, 0));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, gap_cis_accept(TEST_CIS_CON_HANDLE));
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, gap_cis_accept(TEST_CIS_CON_HANDLE));
+}
+
+TEST(HCI_ISO, CanSendNowAfterDataPathSetup){
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, hci_request_iso_can_send_now_event(TEST_CIS_CON_HANDLE));
+    open_cis();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, hci_request_iso_can_send_now_event(TEST_CIS_CON_HANDLE));
+    CHECK_EQUAL(1, iso_can_send_now_events);
+}
+
+TEST(HCI_ISO, SendFragmentedSduWithIsoCredits){
+    open_cis();
+    mock_hci_transport_set_auto_complete(false);
+    mock_hci_transport_clear_packets();
+
+    static uint8_t sdu[100];
+    uint16_t i;
+    for (i = 0; i < sizeof(sdu); i++){
+        sdu[i] = (uint8_t) i;
+    }
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, hci_send_iso_sdu(TEST_CIS_CON_HANDLE, sdu, sizeof(sdu), true, 0x11223344));
+    mock_hci_transport_process();
+    CHECK_EQUAL(ERROR_CODE_CONTROLLER_BUSY, hci_send_iso_sdu(TEST_CIS_CON_HANDLE, sdu, sizeof(sdu), false, 0));
+
+    // two ISO buffers in Controller
+    CHECK_EQUAL(2, mock_hci_transport_num_packets_of_type(HCI_ISO_DATA_PACKET));
+
+    // first fragment with time stamp, sequence number and SDU length
+    const mock_hci_transport_packet_t * packet = iso_packet(0);
+    CHECK_EQUAL(TEST_CIS_CON_HANDLE | (1u << 14) | (0u << 12), little_endian_read_16(packet->buffer, 0));
+    CHECK_EQUAL(TEST_ISO_PACKET_LEN, little_endian_read_16(packet->buffer, 2));
+    CHECK_EQUAL(0x11223344, little_endian_read_32(packet->buffer, 4));
+    CHECK_EQUAL(0, little_endian_read_16(packet->buffer, 8));
+    CHECK_EQUAL(sizeof(sdu), little_endian_read_16(packet->buffer, 10));
+    MEMCMP_EQUAL(&sdu[0], &packet->buffer[12], TEST_ISO_PACKET_LEN - 8);
+
+    // continuation
+    packet = iso_packet(1);
+    CHECK_EQUAL(TEST_CIS_CON_HANDLE | (1u << 12), little_endian_read_16(packet->buffer, 0));
+    CHECK_EQUAL(TEST_ISO_PACKET_LEN, little_endian_read_16(packet->buffer, 2));
+    MEMCMP_EQUAL(&sdu[32], &packet->buffer[4], TEST_ISO_PACKET_LEN);
+
+    // last fragment after Number Of Completed Packets
+    mock_hci_transport_complete_packets(TEST_CIS_CON_HANDLE, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(3, mock_hci_transport_num_packets_of_type(HCI_ISO_DATA_PACKET));
+    packet = iso_packet(2);
+    CHECK_EQUAL(TEST_CIS_CON_HANDLE | (3u << 12), little_endian_read_16(packet->buffer, 0));
+    CHECK_EQUAL(28, little_endian_read_16(packet->buffer, 2));
+    MEMCMP_EQUAL(&sdu[72], &packet->buffer[4], 28);
+
+    // next SDU has next sequence number and fits into one packet
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, hci_send_iso_sdu(TEST_CIS_CON_HANDLE, sdu, 10, false, 0));
+    mock_hci_transport_process();
+    CHECK_EQUAL(3, mock_hci_transport_num_packets_of_type(HCI_ISO_DATA_PACKET));
+    mock_hci_transport_complete_packets(TEST_CIS_CON_HANDLE, 2);
+    mock_hci_transport_process();
+    packet = iso_packet(3);
+    CHECK(packet != NULL);
+    CHECK_EQUAL(TEST_CIS_CON_HANDLE | (2u << 12), little_endian_read_16(packet->buffer, 0));
+    CHECK_EQUAL(14, little_endian_read_16(packet->buffer, 2));
+    CHECK_EQUAL(1, little_endian_read_16(packet->buffer, 4));
+    CHECK_EQUAL(10, little_endian_read_16(packet->buffer, 6));
+}
+
+TEST(HCI_ISO, ReceiveFragmentedSdu){
+    open_cis();
+    uint8_t data[TEST_ISO_PACKET_LEN];
+    uint16_t i;
+    for (i = 0; i < sizeof(data); i++){
+        data[i] = (uint8_t) i;
+    }
+
+    // complete SDU
+    receive_iso_fragment(2, data, 20);
+    CHECK_EQUAL(1, iso_received_sdus);
+    CHECK_EQUAL(HCI_ISO_HEADER_SIZE + 20, iso_received_size);
+
+    // SDU in three fragments, first one with sequence number and SDU length
+    little_endian_store_16(data, 0, 7);
+    little_endian_store_16(data, 2, 36 + 40 + 10);
+    receive_iso_fragment(0, data, 40);
+    receive_iso_fragment(1, data, 40);
+    CHECK_EQUAL(1, iso_received_sdus);
+    receive_iso_fragment(3, data, 10);
+    CHECK_EQUAL(2, iso_received_sdus);
+    CHECK_EQUAL(HCI_ISO_HEADER_SIZE + 40 + 40 + 10, iso_received_size);
+    CHECK_EQUAL(TEST_CIS_CON_HANDLE | (2u << 12), little_endian_read_16(iso_received_sdu, 0));
+    CHECK_EQUAL(90, little_endian_read_16(iso_received_sdu, 2));
+    CHECK_EQUAL(7, little_endian_read_16(iso_received_sdu, 4));
+    MEMCMP_EQUAL(&data[4], &iso_received_sdu[8], 36);
+    MEMCMP_EQUAL(data, &iso_received_sdu[44], 40);
+    MEMCMP_EQUAL(data, &iso_received_sdu[84], 10);
+
+    // continuation without first fragment is dropped
+    receive_iso_fragment(1, data, 40);
+    receive_iso_fragment(3, data, 10);
+    CHECK_EQUAL(2, iso_received_sdus);
+}
+
+TEST(HCI_ISO, DisconnectReleasesStream){
+    open_cis();
+    mock_hci_transport_disconnect(TEST_CIS_CON_HANDLE, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+    mock_hci_transport_process();
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, hci_request_iso_can_send_now_event(TEST_CIS_CON_HANDLE));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
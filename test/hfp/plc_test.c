@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+
+#define BTSTACK_FILE__ "plc_test.c"
+
+/*
+ *  plc_test.c
+ *
+ *  Packet loss concealment for CVSD and mSBC, built with and without ENABLE_PLC_FIXED_POINT
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_cvsd_plc.h"
+#include "btstack_sbc_plc.h"
+
+// sine wave, 160 Hz at 16 kHz, period 100 samples
+#define SINE_PERIOD 100
+#define SINE_AMPLITUDE 20000
+
+static int16_t sine_sample(uint32_t pos){
+    static int16_t sine[SINE_PERIOD];
+    static bool initialized = false;
+    if (!initialized){
+        initialized = true;
+        int i;
+        for (i = 0; i < SINE_PERIOD; i++){
+            sine[i] = (int16_t) (SINE_AMPLITUDE * sin((2.0 * M_PI * i) / SINE_PERIOD));
+        }
+    }
+    return sine[pos % SINE_PERIOD];
+}
+
+static void sine_frame(uint32_t pos, int16_t * frame, uint16_t num_samples){
+    uint16_t i;
+    for (i = 0; i < num_samples; i++){
+        frame[i] = sine_sample(pos + i);
+    }
+}
+
+static int max_deviation_from_sine(uint32_t pos, const int16_t * frame, uint16_t num_samples){
+    int max_deviation = 0;
+    uint16_t i;
+    for (i = 0; i < num_samples; i++){
+        int deviation = abs(frame[i] - sine_sample(pos + i));
+        if (deviation > max_deviation){
+            max_deviation = deviation;
+        }
+    }
+    return max_deviation;
+}
+
+// tolerance for concealment of a periodic signal, pattern match has to find a lag aligned with the template at the end of the history
+#define MAX_DEVIATION 8
+
+static btstack_cvsd_plc_state_t cvsd_plc_state;
+static int16_t cvsd_frame_in[CVSD_FS];
+static int16_t cvsd_frame_out[CVSD_FS];
+
+TEST_GROUP(CVSD_PLC){
+    uint32_t pos;
+
+    void setup(void){
+        pos = 0;
+        btstack_cvsd_plc_init(&cvsd_plc_state);
+    }
+
+    void good_frames(uint16_t num_frames){
+        uint16_t i;
+        for (i = 0; i < num_frames; i++){
+            sine_frame(pos, cvsd_frame_in, CVSD_FS);
+            btstack_cvsd_plc_good_frame(&cvsd_plc_state, CVSD_FS, cvsd_frame_in, cvsd_frame_out);
+            pos += CVSD_FS;
+        }
+    }
+};
+
+TEST(CVSD_PLC, BadFrameContinuesPeriodicSignal){
+    good_frames(10);
+    btstack_cvsd_plc_bad_frame(&cvsd_plc_state, CVSD_FS, cvsd_frame_out);
+    CHECK_EQUAL(CVSD_LHIST % SINE_PERIOD, cvsd_plc_state.bestlag % SINE_PERIOD);
+    CHECK(max_deviation_from_sine(pos, cvsd_frame_out, CVSD_FS) <= MAX_DEVIATION);
+    pos += CVSD_FS;
+
+    btstack_cvsd_plc_bad_frame(&cvsd_plc_state, CVSD_FS, cvsd_frame_out);
+    CHECK(max_deviation_from_sine(pos, cvsd_frame_out, CVSD_FS) <= MAX_DEVIATION);
+    pos += CVSD_FS;
+
+    // good frame after concealment starts with reconvergence, is cross-faded and then passed through
+    sine_frame(pos, cvsd_frame_in, CVSD_FS);
+    btstack_cvsd_plc_good_frame(&cvsd_plc_state, CVSD_FS, cvsd_frame_in, cvsd_frame_out);
+    CHECK(max_deviation_from_sine(pos, cvsd_frame_out, CVSD_RT) <= MAX_DEVIATION);
+    MEMCMP_EQUAL(&cvsd_frame_in[CVSD_RT + CVSD_OLAL], &cvsd_frame_out[CVSD_RT + CVSD_OLAL], (CVSD_FS - CVSD_RT - CVSD_OLAL) * 2);
+}
+
+TEST(CVSD_PLC, BadFrameAfterSilence){
+    memset(cvsd_frame_in, 0, sizeof(cvsd_frame_in));
+    int i;
+    for (i = 0; i < 10; i++){
+        btstack_cvsd_plc_good_frame(&cvsd_plc_state, CVSD_FS, cvsd_frame_in, cvsd_frame_out);
+    }
+    memset(cvsd_frame_out, 0x55, sizeof(cvsd_frame_out));
+    btstack_cvsd_plc_bad_frame(&cvsd_plc_state, CVSD_FS, cvsd_frame_out);
+    MEMCMP_EQUAL(cvsd_frame_in, cvsd_frame_out, sizeof(cvsd_frame_out));
+}
+
+static btstack_sbc_plc_state_t sbc_plc_state;
+static int16_t sbc_frame_in[SBC_FS];
+static int16_t sbc_frame_out[SBC_FS];
+static int16_t sbc_zir[SBC_FS];
+
+TEST_GROUP(SBC_PLC){
+    uint32_t pos;
+
+    void setup(void){
+        pos = 0;
+        btstack_sbc_plc_init(&sbc_plc_state);
+    }
+
+    void good_frames(uint16_t num_frames){
+        uint16_t i;
+        for (i = 0; i < num_frames; i++){
+            sine_frame(pos, sbc_frame_in, SBC_FS);
+            btstack_sbc_plc_good_frame(&sbc_plc_state, sbc_frame_in, sbc_frame_out);
+            pos += SBC_FS;
+        }
+    }
+};
+
+TEST(SBC_PLC, BadFrameContinuesPeriodicSignal){
+    good_frames(10);
+
+    // zero input response of decoder is faded out, use expected signal
+    sine_frame(pos, sbc_zir, SBC_FS);
+    btstack_sbc_plc_bad_frame(&sbc_plc_state, sbc_zir, sbc_frame_out);
+    CHECK_EQUAL(SBC_LHIST % SINE_PERIOD, sbc_plc_state.bestlag % SINE_PERIOD);
+    CHECK(max_deviation_from_sine(pos, sbc_frame_out, SBC_FS) <= MAX_DEVIATION);
+    pos += SBC_FS;
+
+    sine_frame(pos, sbc_zir, SBC_FS);
+    btstack_sbc_plc_bad_frame(&sbc_plc_state, sbc_zir, sbc_frame_out);
+    CHECK(max_deviation_from_sine(pos, sbc_frame_out, SBC_FS) <= MAX_DEVIATION);
+    pos += SBC_FS;
+
+    sine_frame(pos, sbc_frame_in, SBC_FS);
+    btstack_sbc_plc_good_frame(&sbc_plc_state, sbc_frame_in, sbc_frame_out);
+    CHECK(max_deviation_from_sine(pos, sbc_frame_out, SBC_RT) <= MAX_DEVIATION);
+    MEMCMP_EQUAL(&sbc_frame_in[SBC_RT + SBC_OLAL], &sbc_frame_out[SBC_RT + SBC_OLAL], (SBC_FS - SBC_RT - SBC_OLAL) * 2);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
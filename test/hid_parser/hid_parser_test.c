@@ -232,6 +232,32 @@ static void expect_field(btstack_hid_parser_t * parser, uint16_t expected_usage_
     CHECK_EQUAL(expected_value, value);
 }
 
+// compile report fields and verify that compiled parser reports the same fields as btstack_hid_parser
+static void expect_compiled_fields_match(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, uint8_t report_id, const uint8_t * hid_report, uint16_t hid_report_len){
+    btstack_hid_field_t fields[20];
+    int num_fields = btstack_hid_compile_report(hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, report_id, fields, 20);
+    CHECK(num_fields > 0);
+    btstack_hid_parser_t hid_parser;
+    btstack_hid_parser_init(&hid_parser, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, hid_report, hid_report_len);
+    btstack_hid_compiled_parser_t compiled_parser;
+    btstack_hid_compiled_parser_init(&compiled_parser, fields, num_fields, hid_report, hid_report_len);
+    while (btstack_hid_parser_has_more(&hid_parser)){
+        uint16_t usage_page;
+        uint16_t usage;
+        int32_t value;
+        btstack_hid_parser_get_field(&hid_parser, &usage_page, &usage, &value);
+        CHECK_EQUAL(1, btstack_hid_compiled_parser_has_more(&compiled_parser));
+        uint16_t compiled_usage_page;
+        uint16_t compiled_usage;
+        int32_t compiled_value;
+        btstack_hid_compiled_parser_get_field(&compiled_parser, &compiled_usage_page, &compiled_usage, &compiled_value);
+        CHECK_EQUAL(usage_page, compiled_usage_page);
+        CHECK_EQUAL(usage, compiled_usage);
+        CHECK_EQUAL(value, compiled_value);
+    }
+    CHECK_EQUAL(0, btstack_hid_compiled_parser_has_more(&compiled_parser));
+}
+
 // test
 TEST_GROUP(HID){
 	void setup(void){
@@ -328,6 +354,20 @@ TEST(HID, Combo2){
     CHECK_EQUAL(0, btstack_hid_parser_has_more(&hid_parser));
 }
 
+TEST(HID, CompiledReport){
+    expect_compiled_fields_match(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), 0, mouse_report_without_id_positive_xy, sizeof(mouse_report_without_id_positive_xy));
+    expect_compiled_fields_match(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), 0, mouse_report_without_id_negative_xy, sizeof(mouse_report_without_id_negative_xy));
+    expect_compiled_fields_match(mouse_descriptor_with_report_id, sizeof(mouse_descriptor_with_report_id), 1, mouse_report_with_id_1, sizeof(mouse_report_with_id_1));
+    expect_compiled_fields_match(hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), 0, keyboard_report1, sizeof(keyboard_report1));
+    expect_compiled_fields_match(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), 1, combo_report1, sizeof(combo_report1));
+    expect_compiled_fields_match(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), 2, combo_report2, sizeof(combo_report2));
+}
+
+TEST(HID, CompiledReportFieldsTableTooSmall){
+    btstack_hid_field_t fields[4];
+    CHECK_EQUAL(-1, btstack_hid_compile_report(hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), HID_REPORT_TYPE_INPUT, 0, fields, 4));
+}
+
 TEST(HID, GetReportSize){
     int report_size = 0;
     const uint8_t * hid_descriptor =  combo_descriptor_with_report_ids;
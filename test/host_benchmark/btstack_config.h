@@ -0,0 +1,28 @@
+//
+// btstack_config.h for host benchmark
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+#define HAVE_EMBEDDED_TIME_MS
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+#define ENABLE_LE_CENTRAL
+#define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_DATA_CHANNELS
+#define ENABLE_SCO_OVER_HCI
+#define ENABLE_LOG_ERROR
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_INCOMING_PRE_BUFFER_SIZE 14
+#define HCI_ACL_PAYLOAD_SIZE (1691 + 4)
+
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+
+#endif
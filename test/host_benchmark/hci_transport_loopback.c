@@ -0,0 +1,722 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_loopback.c"
+
+/*
+ *  hci_transport_loopback.c
+ *
+ *  Simulated Controller that connects the host stack with itself
+ */
+
+#include <string.h>
+
+#include "hci_transport_loopback.h"
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "bluetooth_company_id.h"
+
+// buffer sizes reported by HCI Read Buffer Size and HCI LE Read Buffer Size
+#ifndef LOOPBACK_ACL_PACKET_LENGTH
+#define LOOPBACK_ACL_PACKET_LENGTH 1021
+#endif
+#ifndef LOOPBACK_NUM_ACL_PACKETS
+#define LOOPBACK_NUM_ACL_PACKETS 8
+#endif
+#ifndef LOOPBACK_LE_ACL_PACKET_LENGTH
+#define LOOPBACK_LE_ACL_PACKET_LENGTH 251
+#endif
+#ifndef LOOPBACK_NUM_LE_ACL_PACKETS
+#define LOOPBACK_NUM_LE_ACL_PACKETS 8
+#endif
+#ifndef LOOPBACK_SCO_PACKET_LENGTH
+#define LOOPBACK_SCO_PACKET_LENGTH 60
+#endif
+#ifndef LOOPBACK_NUM_SCO_PACKETS
+#define LOOPBACK_NUM_SCO_PACKETS 4
+#endif
+
+#ifndef LOOPBACK_MAX_LINKS
+#define LOOPBACK_MAX_LINKS 8
+#endif
+
+// queued packets towards the host, must hold all Controller buffers plus events
+#ifndef LOOPBACK_QUEUE_SIZE
+#define LOOPBACK_QUEUE_SIZE 64
+#endif
+
+#define LOOPBACK_PACKET_SIZE (HCI_ACL_HEADER_SIZE + HCI_ACL_PAYLOAD_SIZE)
+
+typedef enum {
+    LOOPBACK_LINK_CLASSIC,
+    LOOPBACK_LINK_LE,
+    LOOPBACK_LINK_SCO,
+} loopback_link_type_t;
+
+typedef struct {
+    bool                 active;
+    loopback_link_type_t type;
+    hci_con_handle_t     handle;
+    hci_con_handle_t     peer_handle;
+    // ACL handle for SCO links
+    hci_con_handle_t     acl_handle;
+    // peer address as seen by the host on this link
+    bd_addr_t            address;
+    // packets delivered to peer, reported with Number Of Completed Packets
+    uint16_t             num_completed;
+} loopback_link_t;
+
+typedef struct {
+    uint8_t  packet_type;
+    uint16_t size;
+    uint8_t  storage[HCI_INCOMING_PRE_BUFFER_SIZE + LOOPBACK_PACKET_SIZE];
+} loopback_packet_t;
+
+static const uint8_t loopback_local_addr[] = { 0x00, 0x1B, 0xDC, 0x0B, 0x00, 0x01 };
+
+// 3/5 slot packets, SCO link, LE Supported (Controller)
+static const uint8_t loopback_local_features[] = { 0x03, 0x08, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00 };
+
+static void (*loopback_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static btstack_data_source_t loopback_data_source;
+
+static loopback_packet_t loopback_queue[LOOPBACK_QUEUE_SIZE];
+static uint16_t loopback_queue_head;
+static uint16_t loopback_queue_count;
+
+static loopback_link_t loopback_links[LOOPBACK_MAX_LINKS];
+static hci_con_handle_t loopback_next_handle;
+
+// outgoing Classic connection waiting for HCI Accept Connection Request
+static bool      loopback_connection_request_pending;
+static bd_addr_t loopback_connection_request_address;
+// outgoing SCO connection waiting for HCI Accept Synchronous Connection
+static bool             loopback_sco_request_pending;
+static hci_con_handle_t loopback_sco_request_acl_handle;
+static uint8_t          loopback_sco_request_link_type;
+
+// send_packet completes asynchronously with HCI_EVENT_TRANSPORT_PACKET_SENT, like UART and USB transports
+static bool loopback_packet_sent_pending;
+
+static hci_transport_loopback_statistics_t loopback_statistics;
+
+static uint8_t * loopback_queue_reserve(uint8_t packet_type, uint16_t size){
+    btstack_assert(loopback_queue_count < LOOPBACK_QUEUE_SIZE);
+    btstack_assert(size <= LOOPBACK_PACKET_SIZE);
+    uint16_t index = (loopback_queue_head + loopback_queue_count) % LOOPBACK_QUEUE_SIZE;
+    loopback_queue_count++;
+    loopback_packet_t * entry = &loopback_queue[index];
+    entry->packet_type = packet_type;
+    entry->size = size;
+    return &entry->storage[HCI_INCOMING_PRE_BUFFER_SIZE];
+}
+
+static void loopback_emit_event(const uint8_t * event, uint16_t size){
+    uint8_t * buffer = loopback_queue_reserve(HCI_EVENT_PACKET, size);
+    (void)memcpy(buffer, event, size);
+}
+
+static void loopback_emit_command_complete(uint16_t opcode, const uint8_t * return_params, uint8_t params_len){
+    uint8_t event[3 + 1 + 255];
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + 1 + params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    event[5] = ERROR_CODE_SUCCESS;
+    if (params_len > 0){
+        (void)memcpy(&event[6], return_params, params_len);
+    }
+    loopback_emit_event(event, 6 + params_len);
+}
+
+static void loopback_emit_command_status(uint16_t opcode, uint8_t status){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = 4;
+    event[2] = status;
+    event[3] = 1;
+    little_endian_store_16(event, 4, opcode);
+    loopback_emit_event(event, sizeof(event));
+}
+
+static loopback_link_t * loopback_link_for_handle(hci_con_handle_t handle){
+    int i;
+    for (i=0;i<LOOPBACK_MAX_LINKS;i++){
+        if (loopback_links[i].active && (loopback_links[i].handle == handle)) return &loopback_links[i];
+    }
+    return NULL;
+}
+
+static loopback_link_t * loopback_link_create(loopback_link_type_t type, const bd_addr_t address){
+    int i;
+    for (i=0;i<LOOPBACK_MAX_LINKS;i++){
+        loopback_link_t * link = &loopback_links[i];
+        if (link->active) continue;
+        memset(link, 0, sizeof(loopback_link_t));
+        link->active = true;
+        link->type = type;
+        link->handle = loopback_next_handle++;
+        bd_addr_copy(link->address, address);
+        return link;
+    }
+    return NULL;
+}
+
+// creates connected pair of links, initiator first
+static bool loopback_link_create_pair(loopback_link_type_t type, const bd_addr_t initiator_peer_address, loopback_link_t ** out_initiator, loopback_link_t ** out_acceptor){
+    loopback_link_t * initiator = loopback_link_create(type, initiator_peer_address);
+    if (initiator == NULL) return false;
+    loopback_link_t * acceptor = loopback_link_create(type, loopback_local_addr);
+    if (acceptor == NULL) {
+        initiator->active = false;
+        return false;
+    }
+    initiator->peer_handle = acceptor->handle;
+    acceptor->peer_handle  = initiator->handle;
+    *out_initiator = initiator;
+    *out_acceptor  = acceptor;
+    return true;
+}
+
+static void loopback_emit_connection_complete(uint8_t status, const loopback_link_t * link, const bd_addr_t address){
+    uint8_t event[13];
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = status;
+    little_endian_store_16(event, 3, (link != NULL) ? link->handle : 0);
+    reverse_bd_addr(address, &event[5]);
+    event[11] = 1;  // ACL
+    event[12] = 0;  // no encryption
+    loopback_emit_event(event, sizeof(event));
+}
+
+static void loopback_emit_connection_request(const bd_addr_t address, uint8_t link_type){
+    uint8_t event[12];
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = sizeof(event) - 2;
+    reverse_bd_addr(address, &event[2]);
+    little_endian_store_24(event, 8, 0x000000);
+    event[11] = link_type;
+    loopback_emit_event(event, sizeof(event));
+}
+
+static void loopback_emit_synchronous_connection_complete(const loopback_link_t * link, uint8_t link_type){
+    uint8_t event[19];
+    event[0] = HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, link->handle);
+    reverse_bd_addr(link->address, &event[5]);
+    event[11] = link_type;
+    event[12] = 0x0c;   // transmission interval
+    event[13] = 0x02;   // retransmission window
+    little_endian_store_16(event, 14, LOOPBACK_SCO_PACKET_LENGTH);
+    little_endian_store_16(event, 16, LOOPBACK_SCO_PACKET_LENGTH);
+    event[18] = 0x02;   // CVSD
+    loopback_emit_event(event, sizeof(event));
+}
+
+static void loopback_emit_le_connection_complete(const loopback_link_t * link, uint8_t role, bd_addr_type_t address_type){
+    uint8_t event[21];
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 4, link->handle);
+    event[6] = role;
+    event[7] = (uint8_t) address_type;
+    reverse_bd_addr(link->address, &event[8]);
+    little_endian_store_16(event, 14, 0x0006);  // 7.5 ms
+    little_endian_store_16(event, 16, 0);
+    little_endian_store_16(event, 18, 500);     // 5 s
+    event[20] = 0;
+    loopback_emit_event(event, sizeof(event));
+}
+
+static void loopback_emit_le_connection_update_complete(const loopback_link_t * link, const uint8_t * params){
+    uint8_t event[12];
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE;
+    event[3] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 4, link->handle);
+    // use max interval, latency, and supervision timeout from HCI LE Connection Update
+    little_endian_store_16(event, 6, little_endian_read_16(params, 4));
+    little_endian_store_16(event, 8, little_endian_read_16(params, 6));
+    little_endian_store_16(event, 10, little_endian_read_16(params, 8));
+    loopback_emit_event(event, sizeof(event));
+}
+
+static void loopback_emit_disconnection_complete(hci_con_handle_t handle, uint8_t reason){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, handle);
+    event[5] = reason;
+    loopback_emit_event(event, sizeof(event));
+}
+
+static void loopback_disconnect_link(loopback_link_t * link, uint8_t reason){
+    loopback_link_t * peer = loopback_link_for_handle(link->peer_handle);
+    link->active = false;
+    loopback_emit_disconnection_complete(link->handle, ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST);
+    if (peer != NULL){
+        peer->active = false;
+        loopback_emit_disconnection_complete(peer->handle, reason);
+    }
+}
+
+static void loopback_disconnect(hci_con_handle_t handle, uint8_t reason){
+    loopback_link_t * link = loopback_link_for_handle(handle);
+    if (link == NULL) return;
+    // SCO links are closed together with their ACL link
+    if (link->type == LOOPBACK_LINK_CLASSIC){
+        int i;
+        for (i=0;i<LOOPBACK_MAX_LINKS;i++){
+            loopback_link_t * sco_link = &loopback_links[i];
+            if (!sco_link->active) continue;
+            if (sco_link->type != LOOPBACK_LINK_SCO) continue;
+            if (sco_link->acl_handle != handle) continue;
+            loopback_disconnect_link(sco_link, reason);
+        }
+    }
+    loopback_disconnect_link(link, reason);
+}
+
+static void loopback_reset(void){
+    memset(loopback_links, 0, sizeof(loopback_links));
+    loopback_next_handle = 0x0001;
+    loopback_connection_request_pending = false;
+    loopback_sco_request_pending = false;
+}
+
+static void loopback_handle_link_control_command(uint16_t opcode, const uint8_t * params){
+    bd_addr_t address;
+    loopback_link_t * initiator;
+    loopback_link_t * acceptor;
+    loopback_link_t * link;
+
+    if (opcode == hci_create_connection.opcode){
+        reverse_bd_addr(params, address);
+        if (loopback_connection_request_pending){
+            loopback_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+            return;
+        }
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        loopback_connection_request_pending = true;
+        bd_addr_copy(loopback_connection_request_address, address);
+        loopback_emit_connection_request(loopback_local_addr, 1);
+        return;
+    }
+
+    if (opcode == hci_accept_connection_request.opcode){
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        if (loopback_sco_request_pending){
+            return;
+        }
+        if (!loopback_connection_request_pending){
+            return;
+        }
+        loopback_connection_request_pending = false;
+        if (!loopback_link_create_pair(LOOPBACK_LINK_CLASSIC, loopback_connection_request_address, &initiator, &acceptor)){
+            loopback_emit_connection_complete(ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES, NULL, loopback_local_addr);
+            loopback_emit_connection_complete(ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES, NULL, loopback_connection_request_address);
+            return;
+        }
+        loopback_emit_connection_complete(ERROR_CODE_SUCCESS, acceptor, acceptor->address);
+        loopback_emit_connection_complete(ERROR_CODE_SUCCESS, initiator, initiator->address);
+        return;
+    }
+
+    if (opcode == hci_reject_connection_request.opcode){
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        if (loopback_connection_request_pending){
+            loopback_connection_request_pending = false;
+            loopback_emit_connection_complete(params[6], NULL, loopback_connection_request_address);
+        }
+        return;
+    }
+
+    if ((opcode == hci_setup_synchronous_connection.opcode) || (opcode == hci_enhanced_setup_synchronous_connection.opcode)){
+        hci_con_handle_t acl_handle = little_endian_read_16(params, 0);
+        link = loopback_link_for_handle(acl_handle);
+        if ((link == NULL) || (link->type != LOOPBACK_LINK_CLASSIC) || loopback_sco_request_pending){
+            loopback_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+            return;
+        }
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        loopback_sco_request_pending = true;
+        loopback_sco_request_acl_handle = acl_handle;
+        loopback_sco_request_link_type = 0;
+        loopback_link_t * peer = loopback_link_for_handle(link->peer_handle);
+        btstack_assert(peer != NULL);
+        loopback_emit_connection_request(peer->address, loopback_sco_request_link_type);
+        return;
+    }
+
+    if ((opcode == hci_accept_synchronous_connection.opcode) || (opcode == hci_enhanced_accept_synchronous_connection.opcode)){
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        if (!loopback_sco_request_pending) return;
+        loopback_sco_request_pending = false;
+        link = loopback_link_for_handle(loopback_sco_request_acl_handle);
+        if (link == NULL) return;
+        loopback_link_t * acl_peer = loopback_link_for_handle(link->peer_handle);
+        if (acl_peer == NULL) return;
+        if (!loopback_link_create_pair(LOOPBACK_LINK_SCO, link->address, &initiator, &acceptor)) return;
+        bd_addr_copy(acceptor->address, acl_peer->address);
+        initiator->acl_handle = link->handle;
+        acceptor->acl_handle  = acl_peer->handle;
+        loopback_emit_synchronous_connection_complete(acceptor, loopback_sco_request_link_type);
+        loopback_emit_synchronous_connection_complete(initiator, loopback_sco_request_link_type);
+        return;
+    }
+
+    if (opcode == hci_disconnect.opcode){
+        hci_con_handle_t handle = little_endian_read_16(params, 0);
+        if (loopback_link_for_handle(handle) == NULL){
+            loopback_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            return;
+        }
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        loopback_disconnect(handle, params[2]);
+        return;
+    }
+
+    if (opcode == hci_read_remote_supported_features_command.opcode){
+        hci_con_handle_t handle = little_endian_read_16(params, 0);
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        uint8_t event[13];
+        event[0] = HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE;
+        event[1] = sizeof(event) - 2;
+        event[2] = ERROR_CODE_SUCCESS;
+        little_endian_store_16(event, 3, handle);
+        (void)memcpy(&event[5], loopback_local_features, 8);
+        loopback_emit_event(event, sizeof(event));
+        return;
+    }
+
+    if (opcode == hci_read_remote_version_information.opcode){
+        hci_con_handle_t handle = little_endian_read_16(params, 0);
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        uint8_t event[10];
+        event[0] = HCI_EVENT_READ_REMOTE_VERSION_INFORMATION_COMPLETE;
+        event[1] = sizeof(event) - 2;
+        event[2] = ERROR_CODE_SUCCESS;
+        little_endian_store_16(event, 3, handle);
+        event[5] = 0x09;
+        little_endian_store_16(event, 6, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+        little_endian_store_16(event, 8, 0);
+        loopback_emit_event(event, sizeof(event));
+        return;
+    }
+
+    // other link control commands are not supported
+    loopback_emit_command_status(opcode, ERROR_CODE_UNKNOWN_HCI_COMMAND);
+}
+
+static void loopback_handle_le_command(uint16_t opcode, const uint8_t * params){
+    bd_addr_t address;
+    loopback_link_t * initiator;
+    loopback_link_t * acceptor;
+    loopback_link_t * link;
+    uint8_t return_params[16];
+
+    if (opcode == hci_le_create_connection.opcode){
+        bd_addr_type_t address_type = (bd_addr_type_t) params[5];
+        reverse_bd_addr(&params[6], address);
+        if (!loopback_link_create_pair(LOOPBACK_LINK_LE, address, &initiator, &acceptor)){
+            loopback_emit_command_status(opcode, ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES);
+            return;
+        }
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        loopback_emit_le_connection_complete(acceptor, HCI_ROLE_SLAVE, BD_ADDR_TYPE_LE_PUBLIC);
+        loopback_emit_le_connection_complete(initiator, HCI_ROLE_MASTER, address_type);
+        return;
+    }
+
+    if (opcode == hci_le_connection_update.opcode){
+        link = loopback_link_for_handle(little_endian_read_16(params, 0));
+        if (link == NULL){
+            loopback_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            return;
+        }
+        loopback_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+        loopback_emit_le_connection_update_complete(link, params);
+        link = loopback_link_for_handle(link->peer_handle);
+        if (link != NULL){
+            loopback_emit_le_connection_update_complete(link, params);
+        }
+        return;
+    }
+
+    if (opcode == hci_le_read_buffer_size.opcode){
+        little_endian_store_16(return_params, 0, LOOPBACK_LE_ACL_PACKET_LENGTH);
+        return_params[2] = LOOPBACK_NUM_LE_ACL_PACKETS;
+        loopback_emit_command_complete(opcode, return_params, 3);
+        return;
+    }
+
+    if (opcode == hci_le_read_white_list_size.opcode){
+        return_params[0] = LOOPBACK_MAX_LINKS;
+        loopback_emit_command_complete(opcode, return_params, 1);
+        return;
+    }
+
+    if (opcode == hci_le_rand.opcode){
+        static uint32_t loopback_rand = 0x12345678;
+        loopback_rand = loopback_rand * 1103515245u + 12345u;
+        little_endian_store_32(return_params, 0, loopback_rand);
+        little_endian_store_32(return_params, 4, ~loopback_rand);
+        loopback_emit_command_complete(opcode, return_params, 8);
+        return;
+    }
+
+    if (opcode == hci_le_encrypt.opcode){
+        // not used for pairing, any key material is fine
+        memset(return_params, 0, sizeof(return_params));
+        loopback_emit_command_complete(opcode, return_params, 16);
+        return;
+    }
+
+    loopback_emit_command_complete(opcode, NULL, 0);
+}
+
+static void loopback_handle_command(const uint8_t * packet, uint16_t size){
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    const uint8_t * params = &packet[3];
+    uint8_t return_params[64];
+
+    loopback_statistics.commands++;
+
+    // OGF Link Control
+    if ((opcode >> 10) == 0x01){
+        loopback_handle_link_control_command(opcode, params);
+        return;
+    }
+    // OGF LE Controller
+    if ((opcode >> 10) == 0x08){
+        loopback_handle_le_command(opcode, params);
+        return;
+    }
+
+    memset(return_params, 0, sizeof(return_params));
+    if (opcode == hci_reset.opcode){
+        loopback_reset();
+        loopback_emit_command_complete(opcode, NULL, 0);
+    } else if (opcode == hci_read_local_version_information.opcode){
+        return_params[0] = 0x09;    // HCI Version 5.0
+        return_params[3] = 0x09;    // LMP Version 5.0
+        little_endian_store_16(return_params, 4, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+        loopback_emit_command_complete(opcode, return_params, 8);
+    } else if (opcode == hci_read_local_supported_commands.opcode){
+        return_params[10] = 0x10;   // Write Synchronous Flow Control Enable
+        return_params[14] = 0x80;   // Read Buffer Size
+        return_params[24] = 0x40;   // Write LE Host Supported
+        loopback_emit_command_complete(opcode, return_params, 64);
+    } else if (opcode == hci_read_local_supported_features.opcode){
+        (void)memcpy(return_params, loopback_local_features, 8);
+        loopback_emit_command_complete(opcode, return_params, 8);
+    } else if (opcode == hci_read_bd_addr.opcode){
+        reverse_bd_addr(loopback_local_addr, return_params);
+        loopback_emit_command_complete(opcode, return_params, 6);
+    } else if (opcode == hci_read_buffer_size.opcode){
+        little_endian_store_16(return_params, 0, LOOPBACK_ACL_PACKET_LENGTH);
+        return_params[2] = LOOPBACK_SCO_PACKET_LENGTH;
+        little_endian_store_16(return_params, 3, LOOPBACK_NUM_ACL_PACKETS);
+        little_endian_store_16(return_params, 5, LOOPBACK_NUM_SCO_PACKETS);
+        loopback_emit_command_complete(opcode, return_params, 7);
+    } else {
+        // accept all other commands, return parameters are zero
+        loopback_emit_command_complete(opcode, return_params, 0);
+    }
+}
+
+static void loopback_handle_data(uint8_t packet_type, const uint8_t * packet, uint16_t size){
+    hci_con_handle_t handle = little_endian_read_16(packet, 0) & 0x0fff;
+    loopback_link_t * link = loopback_link_for_handle(handle);
+    if (link == NULL){
+        log_error("loopback: data for unknown handle 0x%04x", handle);
+        return;
+    }
+    uint16_t flags = little_endian_read_16(packet, 0) & 0xf000;
+    if (packet_type == HCI_ACL_DATA_PACKET){
+        loopback_statistics.acl_packets++;
+        // first non-flushable packet is received as first automatically flushable packet
+        if ((flags & 0x3000) == 0x0000){
+            flags |= 0x2000;
+        }
+    } else {
+        loopback_statistics.sco_packets++;
+    }
+    uint8_t * buffer = loopback_queue_reserve(packet_type, size);
+    (void)memcpy(buffer, packet, size);
+    little_endian_store_16(buffer, 0, flags | link->peer_handle);
+    link->num_completed++;
+}
+
+// report packets handed over to peer since last poll
+static void loopback_emit_number_of_completed_packets(void){
+    uint8_t event[3 + 4 * LOOPBACK_MAX_LINKS];
+    uint8_t num_handles = 0;
+    int i;
+    for (i=0;i<LOOPBACK_MAX_LINKS;i++){
+        loopback_link_t * link = &loopback_links[i];
+        if (!link->active) continue;
+        if (link->num_completed == 0) continue;
+        little_endian_store_16(event, 3 + 4 * num_handles, link->handle);
+        little_endian_store_16(event, 5 + 4 * num_handles, link->num_completed);
+        link->num_completed = 0;
+        num_handles++;
+    }
+    if (num_handles == 0) return;
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 1 + 4 * num_handles;
+    event[2] = num_handles;
+    loopback_emit_event(event, 3 + 4 * num_handles);
+}
+
+static void loopback_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    if (loopback_queue_count == 0){
+        loopback_emit_number_of_completed_packets();
+        if (loopback_queue_count == 0) return;
+    }
+    loopback_statistics.polls++;
+    // deliver until host stops sending, limited to let run loop process timers
+    uint16_t budget = 4 * LOOPBACK_QUEUE_SIZE;
+    while (budget > 0){
+        budget--;
+        if (loopback_queue_count == 0){
+            // report completed packets when idle, i.e. after the host used up its buffers
+            loopback_emit_number_of_completed_packets();
+            if (loopback_queue_count == 0) break;
+        }
+        loopback_packet_t * entry = &loopback_queue[loopback_queue_head];
+        loopback_queue_head = (loopback_queue_head + 1) % LOOPBACK_QUEUE_SIZE;
+        loopback_queue_count--;
+        uint8_t * packet = &entry->storage[HCI_INCOMING_PRE_BUFFER_SIZE];
+        if (entry->packet_type == HCI_EVENT_PACKET){
+            if (packet[0] == HCI_EVENT_TRANSPORT_PACKET_SENT){
+                loopback_packet_sent_pending = false;
+            } else {
+                loopback_statistics.events++;
+            }
+        }
+        (*loopback_packet_handler)(entry->packet_type, packet, entry->size);
+    }
+}
+
+static void hci_transport_loopback_init(const void * transport_config){
+    UNUSED(transport_config);
+    loopback_queue_head  = 0;
+    loopback_queue_count = 0;
+    loopback_packet_sent_pending = false;
+    loopback_reset();
+}
+
+static int hci_transport_loopback_open(void){
+    btstack_run_loop_set_data_source_handler(&loopback_data_source, &loopback_process);
+    btstack_run_loop_enable_data_source_callbacks(&loopback_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&loopback_data_source);
+    return 0;
+}
+
+static int hci_transport_loopback_close(void){
+    btstack_run_loop_remove_data_source(&loopback_data_source);
+    return 0;
+}
+
+static void hci_transport_loopback_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    loopback_packet_handler = handler;
+}
+
+static int hci_transport_loopback_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return loopback_packet_sent_pending ? 0 : 1;
+}
+
+static int hci_transport_loopback_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0 };
+    if (loopback_packet_sent_pending) return -1;
+    // packet sent event precedes Controller response
+    loopback_packet_sent_pending = true;
+    loopback_emit_event(packet_sent_event, sizeof(packet_sent_event));
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            loopback_handle_command(packet, (uint16_t) size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+        case HCI_SCO_DATA_PACKET:
+            loopback_handle_data(packet_type, packet, (uint16_t) size);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static const hci_transport_t hci_transport_loopback = {
+    /* const char * name; */                                        "LOOPBACK",
+    /* void   (*init) (const void *transport_config); */            &hci_transport_loopback_init,
+    /* int    (*open)(void); */                                     &hci_transport_loopback_open,
+    /* int    (*close)(void); */                                    &hci_transport_loopback_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_loopback_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_loopback_can_send_packet_now,
+    /* int    (*send_packet)(...); */                               &hci_transport_loopback_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+const hci_transport_t * hci_transport_loopback_instance(void){
+    return &hci_transport_loopback;
+}
+
+void hci_transport_loopback_get_statistics(hci_transport_loopback_statistics_t * statistics){
+    *statistics = loopback_statistics;
+}
+
+void hci_transport_loopback_reset_statistics(void){
+    memset(&loopback_statistics, 0, sizeof(loopback_statistics));
+}
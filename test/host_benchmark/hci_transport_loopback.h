@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title HCI Transport Loopback
+ *
+ * Virtual HCI Transport with a simulated Controller that connects the host stack with itself:
+ * an outgoing Classic or LE connection creates a second, incoming connection in the same stack.
+ * ACL and SCO packets sent on one connection are received on the other one.
+ *
+ * The acceptor side reports the BD_ADDR of the simulated Controller as peer address,
+ * outgoing connections must be created to any other address.
+ *
+ * Packets towards the host are queued and delivered from a data source that is polled by the run loop.
+ * As with UART and USB transports, a sent packet is confirmed by HCI_EVENT_TRANSPORT_PACKET_SENT.
+ * Number Of Completed Packets is reported for all packets delivered to the peer when the queue runs empty.
+ */
+
+#ifndef HCI_TRANSPORT_LOOPBACK_H
+#define HCI_TRANSPORT_LOOPBACK_H
+
+#include <stdint.h>
+
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t commands;
+    uint32_t events;
+    uint32_t acl_packets;
+    uint32_t sco_packets;
+    // number of run loop polls that delivered packets
+    uint32_t polls;
+} hci_transport_loopback_statistics_t;
+
+/* API_START */
+
+/**
+ * @brief Get Loopback HCI Transport instance
+ * @return transport
+ */
+const hci_transport_t * hci_transport_loopback_instance(void);
+
+/**
+ * @brief Get counters for packets exchanged with the host since last reset
+ * @param statistics
+ */
+void hci_transport_loopback_get_statistics(hci_transport_loopback_statistics_t * statistics);
+
+/**
+ * @brief Reset counters
+ */
+void hci_transport_loopback_reset_statistics(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_TRANSPORT_LOOPBACK_H
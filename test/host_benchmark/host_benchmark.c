@@ -0,0 +1,663 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "host_benchmark.c"
+
+// *****************************************************************************
+//
+// Host Benchmark
+//
+// Measures throughput and CPU time per byte of the host stack without a radio.
+// The loopback HCI Transport connects the stack with itself: an outgoing connection
+// results in a second, incoming connection, so both sender and receiver are
+// handled by the same BTstack instance. Payload is verified on the receiving side.
+//
+// Benchmarks: l2cap, rfcomm, att-notify, att-write, le-cbm, sco
+//
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack.h"
+#include "btstack_run_loop_embedded.h"
+#include "hal_cpu.h"
+#include "hal_time_ms.h"
+
+#include "hci_transport_loopback.h"
+#include "host_benchmark.h"
+
+#define BENCHMARK_L2CAP_PSM         0x1001
+#define BENCHMARK_LE_PSM            0x0081
+#define BENCHMARK_RFCOMM_CHANNEL    1
+#define BENCHMARK_LE_CBM_MTU        1024
+#define BENCHMARK_TIMEOUT_MS        60000
+#define BENCHMARK_VALUE_HANDLE      ATT_CHARACTERISTIC_0000FF11_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE
+
+typedef enum {
+    BENCHMARK_L2CAP,
+    BENCHMARK_RFCOMM,
+    BENCHMARK_ATT_NOTIFY,
+    BENCHMARK_ATT_WRITE,
+    BENCHMARK_LE_CBM,
+    BENCHMARK_SCO,
+    BENCHMARK_NUM_TYPES
+} benchmark_type_t;
+
+static const char * benchmark_names[] = { "l2cap", "rfcomm", "att-notify", "att-write", "le-cbm", "sco" };
+
+typedef enum {
+    BENCHMARK_STATE_IDLE,
+    BENCHMARK_STATE_W4_CONNECTED,
+    BENCHMARK_STATE_STREAMING,
+    BENCHMARK_STATE_W4_DISCONNECTED,
+    BENCHMARK_STATE_DONE,
+} benchmark_state_t;
+
+// address used for outgoing connections, must differ from the Controller address
+static bd_addr_t benchmark_peer_addr = { 0x00, 0x1B, 0xDC, 0x0B, 0x00, 0x02 };
+
+// configuration
+static uint32_t benchmark_total_bytes = 4000000;
+
+// current benchmark
+static benchmark_type_t  benchmark_type;
+static benchmark_state_t benchmark_state;
+static bool              benchmark_working;
+static bool              benchmark_failed;
+static uint32_t          benchmark_tx_bytes;
+static uint32_t          benchmark_rx_bytes;
+static uint16_t          benchmark_num_connections;
+
+// roles
+static hci_con_handle_t  benchmark_initiator_handle;
+static hci_con_handle_t  benchmark_acceptor_handle;
+static uint16_t          benchmark_tx_cid;
+static uint16_t          benchmark_rx_cid;
+static uint16_t          benchmark_tx_mtu;
+
+// SCO
+static bool              benchmark_sco_setup_pending;
+static bool              benchmark_sco_accept_pending;
+static bd_addr_t         benchmark_sco_accept_addr;
+static hci_con_handle_t  benchmark_sco_tx_handle;
+static hci_con_handle_t  benchmark_sco_rx_handle;
+
+static struct timespec   benchmark_wall_start;
+static struct timespec   benchmark_wall_stop;
+static struct timespec   benchmark_cpu_start;
+static struct timespec   benchmark_cpu_stop;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static gatt_client_notification_t benchmark_notification_listener;
+static gatt_client_characteristic_t benchmark_characteristic;
+
+static void benchmark_l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+static void benchmark_gatt_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+static uint8_t benchmark_tx_buffer[HCI_ACL_PAYLOAD_SIZE];
+static uint8_t benchmark_cbm_rx_buffer_initiator[BENCHMARK_LE_CBM_MTU];
+static uint8_t benchmark_cbm_rx_buffer_acceptor[BENCHMARK_LE_CBM_MTU];
+
+// embedded run loop with HAVE_EMBEDDED_TIME_MS
+uint32_t hal_time_ms(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+}
+void hal_cpu_disable_irqs(void){}
+void hal_cpu_enable_irqs(void){}
+void hal_cpu_enable_irqs_and_sleep(void){}
+
+static double benchmark_elapsed_s(const struct timespec * start, const struct timespec * stop){
+    return (double)(stop->tv_sec - start->tv_sec) + ((double)(stop->tv_nsec - start->tv_nsec) / 1e9);
+}
+
+// payload: stream offset modulo a prime, so that payload boundaries don't align with the pattern
+static uint16_t benchmark_fill(uint8_t * buffer, uint16_t max_len){
+    if (benchmark_tx_bytes == 0){
+        clock_gettime(CLOCK_MONOTONIC, &benchmark_wall_start);
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &benchmark_cpu_start);
+    }
+    uint32_t remaining = benchmark_total_bytes - benchmark_tx_bytes;
+    uint16_t len = (uint16_t) btstack_min(max_len, remaining);
+    uint16_t i;
+    for (i=0;i<len;i++){
+        buffer[i] = (uint8_t)((benchmark_tx_bytes + i) % 251);
+    }
+    benchmark_tx_bytes += len;
+    return len;
+}
+
+static bool benchmark_tx_done(void){
+    return benchmark_tx_bytes >= benchmark_total_bytes;
+}
+
+static void benchmark_disconnect(void){
+    benchmark_state = BENCHMARK_STATE_W4_DISCONNECTED;
+    gap_disconnect(benchmark_initiator_handle);
+}
+
+static void benchmark_receive(const uint8_t * data, uint16_t len){
+    if (benchmark_state != BENCHMARK_STATE_STREAMING) return;
+    uint16_t i;
+    for (i=0;i<len;i++){
+        if (data[i] != (uint8_t)((benchmark_rx_bytes + i) % 251)){
+            printf("%s: payload mismatch at offset %" PRIu32 "\n", benchmark_names[benchmark_type], benchmark_rx_bytes + i);
+            benchmark_failed = true;
+            benchmark_disconnect();
+            return;
+        }
+    }
+    benchmark_rx_bytes += len;
+    if (benchmark_rx_bytes < benchmark_total_bytes) return;
+    clock_gettime(CLOCK_MONOTONIC, &benchmark_wall_stop);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &benchmark_cpu_stop);
+    benchmark_disconnect();
+}
+
+static void benchmark_le_connected_both(void){
+    switch (benchmark_type){
+        case BENCHMARK_ATT_NOTIFY:
+        case BENCHMARK_ATT_WRITE:
+            benchmark_characteristic.value_handle = BENCHMARK_VALUE_HANDLE;
+            benchmark_characteristic.end_handle   = BENCHMARK_VALUE_HANDLE;
+            gatt_client_listen_for_characteristic_value_updates(&benchmark_notification_listener, &benchmark_gatt_client_packet_handler,
+                                                                benchmark_initiator_handle, &benchmark_characteristic);
+            gatt_client_send_mtu_negotiation(&benchmark_gatt_client_packet_handler, benchmark_initiator_handle);
+            break;
+        case BENCHMARK_LE_CBM:
+            l2cap_le_create_channel(&benchmark_l2cap_packet_handler, benchmark_initiator_handle, BENCHMARK_LE_PSM,
+                                    benchmark_cbm_rx_buffer_initiator, sizeof(benchmark_cbm_rx_buffer_initiator),
+                                    L2CAP_LE_AUTOMATIC_CREDITS, LEVEL_0, &benchmark_tx_cid);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    bd_addr_t addr;
+    hci_con_handle_t handle;
+
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING){
+                benchmark_working = true;
+            }
+            break;
+        case HCI_EVENT_CONNECTION_COMPLETE:
+            if (hci_event_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            benchmark_num_connections++;
+            hci_event_connection_complete_get_bd_addr(packet, addr);
+            handle = hci_event_connection_complete_get_connection_handle(packet);
+            if (bd_addr_cmp(addr, benchmark_peer_addr) == 0){
+                benchmark_initiator_handle = handle;
+                if (benchmark_type == BENCHMARK_SCO){
+                    benchmark_sco_setup_pending = true;
+                }
+            } else {
+                benchmark_acceptor_handle = handle;
+            }
+            break;
+        case HCI_EVENT_CONNECTION_REQUEST:
+            // incoming ACL connections are accepted by HCI
+            if (hci_event_connection_request_get_link_type(packet) == 1) break;
+            hci_event_connection_request_get_bd_addr(packet, benchmark_sco_accept_addr);
+            benchmark_sco_accept_pending = true;
+            break;
+        case HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE:
+            if (hci_event_synchronous_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            benchmark_num_connections++;
+            hci_event_synchronous_connection_complete_get_bd_addr(packet, addr);
+            handle = hci_event_synchronous_connection_complete_get_handle(packet);
+            if (bd_addr_cmp(addr, benchmark_peer_addr) == 0){
+                benchmark_sco_tx_handle = handle;
+            } else {
+                benchmark_sco_rx_handle = handle;
+            }
+            if ((benchmark_sco_tx_handle != HCI_CON_HANDLE_INVALID) && (benchmark_sco_rx_handle != HCI_CON_HANDLE_INVALID)){
+                benchmark_state = BENCHMARK_STATE_STREAMING;
+                hci_request_sco_can_send_now_event();
+            }
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) break;
+            benchmark_num_connections++;
+            handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+            if (hci_subevent_le_connection_complete_get_role(packet) == HCI_ROLE_MASTER){
+                benchmark_initiator_handle = handle;
+            } else {
+                benchmark_acceptor_handle = handle;
+            }
+            if ((benchmark_initiator_handle != HCI_CON_HANDLE_INVALID) && (benchmark_acceptor_handle != HCI_CON_HANDLE_INVALID)){
+                benchmark_le_connected_both();
+            }
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            if (benchmark_num_connections > 0){
+                benchmark_num_connections--;
+            }
+            if (benchmark_num_connections > 0) break;
+            if (benchmark_type == BENCHMARK_ATT_NOTIFY || benchmark_type == BENCHMARK_ATT_WRITE){
+                gatt_client_stop_listening_for_characteristic_value_updates(&benchmark_notification_listener);
+            }
+            if (benchmark_state != BENCHMARK_STATE_W4_DISCONNECTED){
+                printf("%s: disconnected unexpectedly\n", benchmark_names[benchmark_type]);
+                benchmark_failed = true;
+            }
+            benchmark_state = BENCHMARK_STATE_DONE;
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    uint16_t cid;
+    uint16_t len;
+
+    if (packet_type == L2CAP_DATA_PACKET){
+        if (channel == benchmark_rx_cid){
+            benchmark_receive(packet, size);
+        }
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            benchmark_rx_cid = l2cap_event_incoming_connection_get_local_cid(packet);
+            l2cap_accept_connection(benchmark_rx_cid);
+            break;
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            if (l2cap_event_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS){
+                printf("%s: L2CAP channel failed, status 0x%02x\n", benchmark_names[benchmark_type], l2cap_event_channel_opened_get_status(packet));
+                benchmark_failed = true;
+                benchmark_state = BENCHMARK_STATE_DONE;
+                break;
+            }
+            cid = l2cap_event_channel_opened_get_local_cid(packet);
+            if (cid != benchmark_tx_cid) break;
+            benchmark_tx_mtu = l2cap_event_channel_opened_get_remote_mtu(packet);
+            benchmark_state = BENCHMARK_STATE_STREAMING;
+            l2cap_request_can_send_now_event(benchmark_tx_cid);
+            break;
+        case L2CAP_EVENT_CAN_SEND_NOW:
+            if (benchmark_state != BENCHMARK_STATE_STREAMING) break;
+            len = benchmark_fill(benchmark_tx_buffer, benchmark_tx_mtu);
+            l2cap_send(benchmark_tx_cid, benchmark_tx_buffer, len);
+            if (!benchmark_tx_done()){
+                l2cap_request_can_send_now_event(benchmark_tx_cid);
+            }
+            break;
+        case L2CAP_EVENT_LE_INCOMING_CONNECTION:
+            benchmark_rx_cid = l2cap_event_le_incoming_connection_get_local_cid(packet);
+            l2cap_le_accept_connection(benchmark_rx_cid, benchmark_cbm_rx_buffer_acceptor, sizeof(benchmark_cbm_rx_buffer_acceptor),
+                                       L2CAP_LE_AUTOMATIC_CREDITS);
+            break;
+        case L2CAP_EVENT_LE_CHANNEL_OPENED:
+            if (l2cap_event_le_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS){
+                printf("%s: L2CAP channel failed, status 0x%02x\n", benchmark_names[benchmark_type], l2cap_event_le_channel_opened_get_status(packet));
+                benchmark_failed = true;
+                benchmark_state = BENCHMARK_STATE_DONE;
+                break;
+            }
+            cid = l2cap_event_le_channel_opened_get_local_cid(packet);
+            if (cid != benchmark_tx_cid) break;
+            benchmark_tx_mtu = l2cap_event_le_channel_opened_get_remote_mtu(packet);
+            benchmark_state = BENCHMARK_STATE_STREAMING;
+            l2cap_le_request_can_send_now_event(benchmark_tx_cid);
+            break;
+        case L2CAP_EVENT_LE_CAN_SEND_NOW:
+            if (benchmark_state != BENCHMARK_STATE_STREAMING) break;
+            // SDU buffer is not in use anymore when can send now is emitted
+            len = benchmark_fill(benchmark_tx_buffer, benchmark_tx_mtu);
+            l2cap_le_send_data(benchmark_tx_cid, benchmark_tx_buffer, len);
+            if (!benchmark_tx_done()){
+                l2cap_le_request_can_send_now_event(benchmark_tx_cid);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_rfcomm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    uint16_t cid;
+    uint16_t len;
+
+    if (packet_type == RFCOMM_DATA_PACKET){
+        if (channel == benchmark_rx_cid){
+            benchmark_receive(packet, size);
+        }
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)){
+        case RFCOMM_EVENT_INCOMING_CONNECTION:
+            benchmark_rx_cid = rfcomm_event_incoming_connection_get_rfcomm_cid(packet);
+            rfcomm_accept_connection(benchmark_rx_cid);
+            break;
+        case RFCOMM_EVENT_CHANNEL_OPENED:
+            if (rfcomm_event_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS){
+                printf("%s: RFCOMM channel failed, status 0x%02x\n", benchmark_names[benchmark_type], rfcomm_event_channel_opened_get_status(packet));
+                benchmark_failed = true;
+                benchmark_state = BENCHMARK_STATE_DONE;
+                break;
+            }
+            cid = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
+            if (cid != benchmark_tx_cid) break;
+            benchmark_tx_mtu = rfcomm_event_channel_opened_get_max_frame_size(packet);
+            benchmark_state = BENCHMARK_STATE_STREAMING;
+            rfcomm_request_can_send_now_event(benchmark_tx_cid);
+            break;
+        case RFCOMM_EVENT_CAN_SEND_NOW:
+            if (benchmark_state != BENCHMARK_STATE_STREAMING) break;
+            len = benchmark_fill(benchmark_tx_buffer, benchmark_tx_mtu);
+            rfcomm_send(benchmark_tx_cid, benchmark_tx_buffer, len);
+            if (!benchmark_tx_done()){
+                rfcomm_request_can_send_now_event(benchmark_tx_cid);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_gatt_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    uint16_t len;
+    switch (hci_event_packet_get_type(packet)){
+        case GATT_EVENT_MTU:
+            benchmark_tx_mtu = gatt_event_mtu_get_MTU(packet) - 3;
+            benchmark_state = BENCHMARK_STATE_STREAMING;
+            if (benchmark_type == BENCHMARK_ATT_NOTIFY){
+                att_server_request_can_send_now_event(benchmark_acceptor_handle);
+            } else {
+                gatt_client_request_can_write_without_response_event(&benchmark_gatt_client_packet_handler, benchmark_initiator_handle);
+            }
+            break;
+        case GATT_EVENT_CAN_WRITE_WITHOUT_RESPONSE:
+            if (benchmark_state != BENCHMARK_STATE_STREAMING) break;
+            len = benchmark_fill(benchmark_tx_buffer, benchmark_tx_mtu);
+            gatt_client_write_value_of_characteristic_without_response(benchmark_initiator_handle, BENCHMARK_VALUE_HANDLE, len, benchmark_tx_buffer);
+            if (!benchmark_tx_done()){
+                gatt_client_request_can_write_without_response_event(&benchmark_gatt_client_packet_handler, benchmark_initiator_handle);
+            }
+            break;
+        case GATT_EVENT_NOTIFICATION:
+            benchmark_receive(gatt_event_notification_get_value(packet), gatt_event_notification_get_value_length(packet));
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != ATT_EVENT_CAN_SEND_NOW) return;
+    if (benchmark_state != BENCHMARK_STATE_STREAMING) return;
+    uint16_t len = benchmark_fill(benchmark_tx_buffer, benchmark_tx_mtu);
+    att_server_notify(benchmark_acceptor_handle, BENCHMARK_VALUE_HANDLE, benchmark_tx_buffer, len);
+    if (!benchmark_tx_done()){
+        att_server_request_can_send_now_event(benchmark_acceptor_handle);
+    }
+}
+
+static int benchmark_att_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+    if (attribute_handle == BENCHMARK_VALUE_HANDLE){
+        benchmark_receive(buffer, buffer_size);
+    }
+    return 0;
+}
+
+static void benchmark_sco_send(void){
+    if (benchmark_state != BENCHMARK_STATE_STREAMING) return;
+    if (benchmark_tx_done()) return;
+    uint16_t payload_len = (uint16_t) (hci_get_sco_packet_length() - 3);
+    benchmark_tx_mtu = payload_len;
+    hci_reserve_packet_buffer();
+    uint8_t * sco_packet = hci_get_outgoing_packet_buffer();
+    little_endian_store_16(sco_packet, 0, benchmark_sco_tx_handle);
+    sco_packet[2] = (uint8_t) benchmark_fill(&sco_packet[3], payload_len);
+    hci_send_sco_packet_buffer(3 + sco_packet[2]);
+    if (!benchmark_tx_done()){
+        hci_request_sco_can_send_now_event();
+    }
+}
+
+// receives SCO packets and HCI_EVENT_SCO_CAN_SEND_NOW
+static void benchmark_sco_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type == HCI_EVENT_PACKET){
+        if (hci_event_packet_get_type(packet) == HCI_EVENT_SCO_CAN_SEND_NOW){
+            benchmark_sco_send();
+        }
+        return;
+    }
+    if (packet_type != HCI_SCO_DATA_PACKET) return;
+    if ((little_endian_read_16(packet, 0) & 0x0fff) != benchmark_sco_rx_handle) return;
+    benchmark_receive(&packet[3], packet[2]);
+}
+
+// HCI Commands that can't be sent from event handlers
+static void benchmark_send_pending_commands(void){
+    if (!hci_can_send_command_packet_now()) return;
+    if (benchmark_sco_setup_pending){
+        benchmark_sco_setup_pending = false;
+        hci_send_cmd(&hci_setup_synchronous_connection, benchmark_initiator_handle, 8000, 8000, 0xFFFF, hci_get_sco_voice_setting(), 0xFF, 0x003F);
+        return;
+    }
+    if (benchmark_sco_accept_pending){
+        benchmark_sco_accept_pending = false;
+        hci_send_cmd(&hci_accept_synchronous_connection, benchmark_sco_accept_addr, 8000, 8000, 0xFFFF, hci_get_sco_voice_setting(), 0xFF, 0x003F);
+        return;
+    }
+}
+
+static void benchmark_execute_until(bool (*done)(void)){
+    uint32_t started_ms = hal_time_ms();
+    while (!(*done)()){
+        btstack_run_loop_embedded_execute_once();
+        benchmark_send_pending_commands();
+        if ((hal_time_ms() - started_ms) > BENCHMARK_TIMEOUT_MS){
+            printf("%s: timeout, sent %" PRIu32 ", received %" PRIu32 "\n", benchmark_names[benchmark_type], benchmark_tx_bytes, benchmark_rx_bytes);
+            benchmark_failed = true;
+            return;
+        }
+    }
+}
+
+static bool benchmark_is_working(void){
+    return benchmark_working;
+}
+
+static bool benchmark_is_done(void){
+    return benchmark_state == BENCHMARK_STATE_DONE;
+}
+
+static void benchmark_start(benchmark_type_t type){
+    benchmark_type  = type;
+    benchmark_state = BENCHMARK_STATE_W4_CONNECTED;
+    benchmark_tx_bytes = 0;
+    benchmark_rx_bytes = 0;
+    benchmark_tx_cid = 0;
+    benchmark_rx_cid = 0;
+    benchmark_initiator_handle = HCI_CON_HANDLE_INVALID;
+    benchmark_acceptor_handle  = HCI_CON_HANDLE_INVALID;
+    benchmark_sco_tx_handle    = HCI_CON_HANDLE_INVALID;
+    benchmark_sco_rx_handle    = HCI_CON_HANDLE_INVALID;
+    hci_transport_loopback_reset_statistics();
+
+    switch (type){
+        case BENCHMARK_L2CAP:
+            l2cap_create_channel(&benchmark_l2cap_packet_handler, benchmark_peer_addr, BENCHMARK_L2CAP_PSM, l2cap_max_mtu(), &benchmark_tx_cid);
+            break;
+        case BENCHMARK_RFCOMM:
+            rfcomm_create_channel(&benchmark_rfcomm_packet_handler, benchmark_peer_addr, BENCHMARK_RFCOMM_CHANNEL, &benchmark_tx_cid);
+            break;
+        case BENCHMARK_ATT_NOTIFY:
+        case BENCHMARK_ATT_WRITE:
+        case BENCHMARK_LE_CBM:
+            gap_connect(benchmark_peer_addr, BD_ADDR_TYPE_LE_PUBLIC);
+            break;
+        case BENCHMARK_SCO:
+            hci_send_cmd(&hci_create_connection, benchmark_peer_addr, hci_usable_acl_packet_types(), 0, 0, 0, 1);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_report(void){
+    hci_transport_loopback_statistics_t statistics;
+    hci_transport_loopback_get_statistics(&statistics);
+    double wall_s = benchmark_elapsed_s(&benchmark_wall_start, &benchmark_wall_stop);
+    double cpu_s  = benchmark_elapsed_s(&benchmark_cpu_start, &benchmark_cpu_stop);
+    printf("%-10s %9" PRIu32 " bytes, payload %4u, %8.2f MB/s, %7.2f ns CPU/byte, %7" PRIu32 " ACL, %7" PRIu32 " SCO, %7" PRIu32 " events, %7" PRIu32 " polls\n",
+           benchmark_names[benchmark_type], benchmark_rx_bytes, benchmark_tx_mtu,
+           (wall_s > 0.0) ? ((double) benchmark_rx_bytes / wall_s / 1e6) : 0.0,
+           (benchmark_rx_bytes > 0) ? (cpu_s * 1e9 / (double) benchmark_rx_bytes) : 0.0,
+           statistics.acl_packets, statistics.sco_packets, statistics.events, statistics.polls);
+}
+
+static void benchmark_run(benchmark_type_t type){
+    benchmark_start(type);
+    benchmark_execute_until(&benchmark_is_done);
+    if (!benchmark_failed){
+        benchmark_report();
+    }
+}
+
+static void usage(const char * name){
+    printf("Usage: %s [-n bytes] [-d pklg] [benchmark...]\n", name);
+    printf("  -n bytes   number of bytes per benchmark, default %" PRIu32 "\n", benchmark_total_bytes);
+    printf("  -d pklg    store HCI packets in PacketLogger format\n");
+    printf("Benchmarks (default: all):");
+    int i;
+    for (i=0;i<BENCHMARK_NUM_TYPES;i++){
+        printf(" %s", benchmark_names[i]);
+    }
+    printf("\n");
+}
+
+int main(int argc, const char * argv[]){
+    bool selected[BENCHMARK_NUM_TYPES];
+    bool any_selected = false;
+    memset(selected, 0, sizeof(selected));
+
+    int arg;
+    for (arg = 1; arg < argc; arg++){
+        if ((strcmp(argv[arg], "-n") == 0) && ((arg + 1) < argc)){
+            benchmark_total_bytes = (uint32_t) strtoul(argv[++arg], NULL, 0);
+            continue;
+        }
+        if ((strcmp(argv[arg], "-d") == 0) && ((arg + 1) < argc)){
+            hci_dump_open(argv[++arg], HCI_DUMP_PACKETLOGGER);
+            continue;
+        }
+        int i;
+        for (i=0;i<BENCHMARK_NUM_TYPES;i++){
+            if (strcmp(argv[arg], benchmark_names[i]) == 0) break;
+        }
+        if (i == BENCHMARK_NUM_TYPES){
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        selected[i] = true;
+        any_selected = true;
+    }
+
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_embedded_get_instance());
+
+    hci_init(hci_transport_loopback_instance(), NULL);
+    hci_register_sco_packet_handler(&benchmark_sco_packet_handler);
+    hci_event_callback_registration.callback = &benchmark_hci_event_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    // no pairing, also used for services registered below
+    gap_set_security_level(LEVEL_0);
+
+    l2cap_init();
+    l2cap_register_service(&benchmark_l2cap_packet_handler, BENCHMARK_L2CAP_PSM, l2cap_max_mtu(), LEVEL_0);
+    l2cap_le_register_service(&benchmark_l2cap_packet_handler, BENCHMARK_LE_PSM, LEVEL_0);
+
+    rfcomm_init();
+    rfcomm_register_service(&benchmark_rfcomm_packet_handler, BENCHMARK_RFCOMM_CHANNEL, 0xffff);
+
+    // SM handles LE connections even without pairing
+    sm_init();
+
+    att_server_init(profile_data, NULL, &benchmark_att_write_callback);
+    att_server_register_packet_handler(&benchmark_att_packet_handler);
+    gatt_client_init();
+    // MTU is exchanged explicitly before streaming
+    gatt_client_mtu_enable_auto_negotiation(0);
+
+    hci_power_control(HCI_POWER_ON);
+    benchmark_execute_until(&benchmark_is_working);
+    if (benchmark_failed) return EXIT_FAILURE;
+
+    int i;
+    for (i=0;i<BENCHMARK_NUM_TYPES;i++){
+        if (any_selected && !selected[i]) continue;
+        benchmark_run((benchmark_type_t) i);
+        if (benchmark_failed) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+//
+// btstack_config.h for l2cap-classic tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+// #define ENABLE_LOG_DEBUG
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO 
+#define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_CENTRAL
+#define ENABLE_LE_DATA_CHANNELS
+#define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+#define ENABLE_L2CAP_STREAMING_MODE
+#define ENABLE_HCI_ACL_TX_BUFFER_POOL
+#define ENABLE_L2CAP_CAN_SEND_NOW_PER_CONNECTION
+#define ENABLE_CLASSIC_MEDIA_QOS
+#define ENABLE_HCI_QOS_ARBITER
+#define ENABLE_L2CAP_LOCAL_CID_TABLE
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1021
+#define HCI_INCOMING_PRE_BUFFER_SIZE 4
+
+// small local cid table to get collisions
+#define L2CAP_LOCAL_CID_TABLE_SIZE 4
+
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+
+#define NVM_NUM_DEVICE_DB_ENTRIES 4
+#define NVM_NUM_LINK_KEYS 2
+
+#endif
@@ -0,0 +1,1273 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "l2cap_classic_test.c"
+
+/*
+ *  l2cap_classic_test.c
+ *
+ *  Classic L2CAP channels over simulated Controller and scripted remote device
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "bluetooth.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+
+#include "mock_btstack_run_loop.h"
+#include "mock_hci_transport.h"
+
+#define TEST_PSM          0x1001
+#define TEST_CON_HANDLE   0x0001
+#define TEST_CON_HANDLE_2 0x0002
+#define TEST_LE_CON_HANDLE 0x0003
+#define TEST_REMOTE_CID   0x0070
+
+#define INFO_TYPE_EXTENDED_FEATURES_SUPPORTED 0x0002
+#define INFO_TYPE_FIXED_CHANNELS_SUPPORTED    0x0003
+#define CONFIG_OPTION_TYPE_MTU                0x01
+#define CONFIG_OPTION_TYPE_RFC                0x04
+#define CONFIG_OPTION_TYPE_FCS                0x05
+
+static const bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+static const bd_addr_t remote_addr_2 = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x77 };
+
+// remote device
+static uint16_t remote_mtu;
+static uint8_t  remote_sig_id;
+static uint16_t remote_extended_feature_mask;
+static uint8_t  remote_rfc_mode;
+static uint16_t remote_mps;
+
+// local channel
+static uint16_t l2cap_cid;
+static uint8_t  l2cap_channel_opened_status;
+static bool     l2cap_channel_closed;
+static uint16_t l2cap_received_len;
+static uint16_t l2cap_can_send_now_cid;
+
+static void remote_send_signaling_for_cid(hci_con_handle_t con_handle, uint16_t cid, uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t data_len){
+    uint8_t packet[64];
+    btstack_assert(data_len <= (sizeof(packet) - 12));
+    little_endian_store_16(packet, 0, con_handle | (0x02 << 12));
+    little_endian_store_16(packet, 2, 8 + data_len);
+    little_endian_store_16(packet, 4, 4 + data_len);
+    little_endian_store_16(packet, 6, cid);
+    packet[8] = code;
+    packet[9] = sig_id;
+    little_endian_store_16(packet, 10, data_len);
+    (void)memcpy(&packet[12], data, data_len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 12 + data_len);
+}
+
+static void remote_send_signaling_for_handle(hci_con_handle_t con_handle, uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t data_len){
+    remote_send_signaling_for_cid(con_handle, L2CAP_CID_SIGNALING, code, sig_id, data, data_len);
+}
+
+static void remote_send_signaling(uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t data_len){
+    remote_send_signaling_for_handle(TEST_CON_HANDLE, code, sig_id, data, data_len);
+}
+
+static void remote_send_data_for_handle(hci_con_handle_t con_handle, uint16_t cid, const uint8_t * data, uint16_t len){
+    uint8_t packet[1100];
+    btstack_assert(len <= (sizeof(packet) - 8));
+    little_endian_store_16(packet, 0, con_handle | (0x02 << 12));
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    (void)memcpy(&packet[8], data, len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 8 + len);
+}
+
+static void remote_send_data(uint16_t cid, const uint8_t * data, uint16_t len){
+    remote_send_data_for_handle(TEST_CON_HANDLE, cid, data, len);
+}
+
+// respond to signaling requests from stack like a remote device, Basic Mode unless remote_rfc_mode is set
+static void remote_handle_packet(const mock_hci_transport_packet_t * packet){
+    if (packet->type != HCI_ACL_DATA_PACKET) return;
+    if (little_endian_read_16(packet->buffer, 6) != L2CAP_CID_SIGNALING) return;
+    hci_con_handle_t con_handle = little_endian_read_16(packet->buffer, 0) & 0x0fff;
+    const uint8_t * command = &packet->buffer[8];
+    uint8_t  code   = command[0];
+    uint8_t  sig_id = command[1];
+    uint8_t  response[24];
+    uint16_t pos;
+    switch (code){
+        case INFORMATION_REQUEST:
+            little_endian_store_16(response, 0, little_endian_read_16(command, 4));
+            little_endian_store_16(response, 2, 0);     // success
+            memset(&response[4], 0, 8);
+            if (little_endian_read_16(command, 4) == INFO_TYPE_EXTENDED_FEATURES_SUPPORTED){
+                little_endian_store_32(response, 4, remote_extended_feature_mask);
+            }
+            if (little_endian_read_16(command, 4) == INFO_TYPE_FIXED_CHANNELS_SUPPORTED){
+                response[4] = 1 << L2CAP_CID_SIGNALING;
+                remote_send_signaling_for_handle(con_handle, INFORMATION_RESPONSE, sig_id, response, 12);
+            } else {
+                remote_send_signaling_for_handle(con_handle, INFORMATION_RESPONSE, sig_id, response, 8);
+            }
+            break;
+        case CONNECTION_RESPONSE:
+            // result success: send own configuration request with MTU option, plus RFC and 'No FCS' options if not Basic Mode
+            if (little_endian_read_16(command, 8) != 0) break;
+            little_endian_store_16(response, 0, little_endian_read_16(command, 4));
+            little_endian_store_16(response, 2, 0);
+            response[4] = CONFIG_OPTION_TYPE_MTU;
+            response[5] = 2;
+            little_endian_store_16(response, 6, remote_mtu);
+            pos = 8;
+            if (remote_rfc_mode != L2CAP_CHANNEL_MODE_BASIC){
+                response[pos++] = CONFIG_OPTION_TYPE_RFC;
+                response[pos++] = 9;
+                response[pos++] = remote_rfc_mode;
+                response[pos++] = 4;                            // tx window
+                response[pos++] = 2;                            // max transmit
+                little_endian_store_16(response, pos, 2000);    // retransmission timeout
+                pos += 2;
+                little_endian_store_16(response, pos, 12000);   // monitor timeout
+                pos += 2;
+                little_endian_store_16(response, pos, remote_mps);
+                pos += 2;
+                response[pos++] = CONFIG_OPTION_TYPE_FCS;
+                response[pos++] = 1;
+                response[pos++] = 0;                            // no FCS
+            }
+            remote_send_signaling_for_handle(con_handle, CONFIGURE_REQUEST, ++remote_sig_id, response, pos);
+            break;
+        case CONFIGURE_REQUEST:
+            little_endian_store_16(response, 0, TEST_REMOTE_CID);
+            little_endian_store_16(response, 2, 0);
+            little_endian_store_16(response, 4, 0);
+            remote_send_signaling_for_handle(con_handle, CONFIGURE_RESPONSE, sig_id, response, 6);
+            break;
+        case DISCONNECTION_REQUEST:
+            remote_send_signaling_for_handle(con_handle, DISCONNECTION_RESPONSE, sig_id, &command[4], 4);
+            break;
+        default:
+            break;
+    }
+}
+
+static void l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    if (packet_type == L2CAP_DATA_PACKET){
+        l2cap_received_len = size;
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            l2cap_accept_connection(l2cap_event_incoming_connection_get_local_cid(packet));
+            break;
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            l2cap_channel_opened_status = l2cap_event_channel_opened_get_status(packet);
+            l2cap_cid = l2cap_event_channel_opened_get_local_cid(packet);
+            break;
+        case L2CAP_EVENT_CHANNEL_CLOSED:
+            l2cap_channel_closed = true;
+            break;
+        case L2CAP_EVENT_CAN_SEND_NOW:
+            l2cap_can_send_now_cid = l2cap_event_can_send_now_get_local_cid(packet);
+            (void) l2cap_send(l2cap_can_send_now_cid, (uint8_t *) "x", 1);
+            break;
+        default:
+            break;
+    }
+}
+
+static void remote_open_channel_for_handle(hci_con_handle_t con_handle, uint16_t mtu){
+    uint8_t params[4];
+    remote_mtu = mtu;
+    little_endian_store_16(params, 0, TEST_PSM);
+    little_endian_store_16(params, 2, TEST_REMOTE_CID);
+    remote_send_signaling_for_handle(con_handle, CONNECTION_REQUEST, ++remote_sig_id, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+static void remote_open_channel(uint16_t mtu){
+    remote_open_channel_for_handle(TEST_CON_HANDLE, mtu);
+}
+
+static const mock_hci_transport_packet_t * last_data_packet(void){
+    uint16_t i = mock_hci_transport_num_packets();
+    while (i > 0){
+        i--;
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ACL_DATA_PACKET) continue;
+        if (little_endian_read_16(packet->buffer, 6) != TEST_REMOTE_CID) continue;
+        return packet;
+    }
+    return NULL;
+}
+
+TEST_GROUP(L2CAP_CLASSIC){
+    void setup(void){
+        remote_sig_id = 0;
+        l2cap_cid = 0;
+        l2cap_channel_opened_status = 0xff;
+        l2cap_channel_closed = false;
+        l2cap_received_len = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&l2cap_packet_handler, TEST_PSM, 1000, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+    }
+};
+
+TEST(L2CAP_CLASSIC, OpenChannel){
+    remote_open_channel(1000);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    CHECK(l2cap_cid != 0);
+    CHECK_EQUAL(1000, l2cap_get_remote_mtu_for_local_cid(l2cap_cid));
+
+    const uint8_t data[] = { 1, 2, 3 };
+    remote_send_data(l2cap_cid, data, sizeof(data));
+    mock_hci_transport_process();
+    CHECK_EQUAL(sizeof(data), l2cap_received_len);
+}
+
+TEST(L2CAP_CLASSIC, SendIovUnknownCid){
+    uint8_t data[4] = { 0 };
+    btstack_iovec_t iov[1] = { { data, sizeof(data) } };
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_send_iov(0x1234, iov, 1));
+}
+
+TEST(L2CAP_CLASSIC, SendIov){
+    remote_open_channel(1000);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    const uint8_t part_a[] = { 'a', 'b' };
+    const uint8_t part_b[] = { 'c', 'd', 'e' };
+    btstack_iovec_t iov[2] = { { part_a, sizeof(part_a) }, { part_b, sizeof(part_b)} };
+    mock_hci_transport_clear_packets();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send_iov(l2cap_cid, iov, 2));
+
+    const mock_hci_transport_packet_t * packet = last_data_packet();
+    CHECK(packet != NULL);
+    CHECK_EQUAL(8 + 5, packet->size);
+    CHECK_EQUAL(5, little_endian_read_16(packet->buffer, 4));
+    MEMCMP_EQUAL("abcde", &packet->buffer[8], 5);
+}
+
+TEST(L2CAP_CLASSIC, SendIovGather){
+    remote_open_channel(1000);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    // more buffers than the transport accepts get copied into the outgoing buffer
+    const uint8_t parts[HCI_TRANSPORT_IOV_MAX + 1][2] = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 8, 9 } };
+    btstack_iovec_t iov[HCI_TRANSPORT_IOV_MAX + 1];
+    uint16_t i;
+    for (i = 0; i < (HCI_TRANSPORT_IOV_MAX + 1); i++){
+        iov[i].base = parts[i];
+        iov[i].len  = 2;
+    }
+    mock_hci_transport_clear_packets();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send_iov(l2cap_cid, iov, HCI_TRANSPORT_IOV_MAX + 1));
+
+    const mock_hci_transport_packet_t * packet = last_data_packet();
+    CHECK(packet != NULL);
+    CHECK_EQUAL(2 * (HCI_TRANSPORT_IOV_MAX + 1), little_endian_read_16(packet->buffer, 4));
+    MEMCMP_EQUAL(parts, &packet->buffer[8], 2 * (HCI_TRANSPORT_IOV_MAX + 1));
+}
+
+TEST(L2CAP_CLASSIC, SendIovExceedsRemoteMtu){
+    remote_open_channel(100);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    uint8_t data[101] = { 0 };
+    btstack_iovec_t iov[2] = { { data, 60 }, { data, 41 } };
+    mock_hci_transport_clear_packets();
+    CHECK_EQUAL(L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU, l2cap_send_iov(l2cap_cid, iov, 2));
+    CHECK(last_data_packet() == NULL);
+}
+
+TEST(L2CAP_CLASSIC, SendIovLengthOverflow){
+    remote_open_channel(0xffff);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    // total length of 0x10010 would wrap around to 16 bytes in 16 bit
+    static uint8_t data[0x8008];
+    btstack_iovec_t iov[2] = { { data, sizeof(data) }, { data, sizeof(data) } };
+    mock_hci_transport_clear_packets();
+    CHECK_EQUAL(L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU, l2cap_send_iov(l2cap_cid, iov, 2));
+    CHECK(last_data_packet() == NULL);
+}
+
+// more channels than entries in local cid table
+#define TEST_NUM_CHANNELS (L2CAP_LOCAL_CID_TABLE_SIZE + 2)
+
+TEST_GROUP(L2CAP_LOCAL_CID_TABLE){
+    uint16_t cids[TEST_NUM_CHANNELS];
+
+    void setup(void){
+        remote_sig_id = 0;
+        l2cap_channel_closed = false;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&l2cap_packet_handler, TEST_PSM, 1000, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        uint16_t i;
+        for (i = 0; i < TEST_NUM_CHANNELS; i++){
+            l2cap_cid = 0;
+            // remote mtu identifies channel
+            remote_open_channel(100 + i);
+            CHECK(l2cap_cid != 0);
+            cids[i] = l2cap_cid;
+        }
+    }
+};
+
+TEST(L2CAP_LOCAL_CID_TABLE, LookupAllChannels){
+    uint16_t i;
+    for (i = 0; i < TEST_NUM_CHANNELS; i++){
+        CHECK_EQUAL(100 + i, l2cap_get_remote_mtu_for_local_cid(cids[i]));
+    }
+    // unused cid in occupied slot
+    CHECK_EQUAL(0, l2cap_get_remote_mtu_for_local_cid(cids[0] + (4 * L2CAP_LOCAL_CID_TABLE_SIZE)));
+}
+
+TEST(L2CAP_LOCAL_CID_TABLE, SlotReusedAfterDisconnect){
+    uint16_t cid = cids[1];
+    l2cap_disconnect(cid, 0);
+    mock_hci_transport_process();
+    CHECK(l2cap_channel_closed);
+    CHECK_EQUAL(0, l2cap_get_remote_mtu_for_local_cid(cid));
+
+    // new channel gets free slot
+    l2cap_cid = 0;
+    remote_open_channel(200);
+    CHECK(l2cap_cid != 0);
+    CHECK_EQUAL(cid & (L2CAP_LOCAL_CID_TABLE_SIZE - 1), l2cap_cid & (L2CAP_LOCAL_CID_TABLE_SIZE - 1));
+    CHECK_EQUAL(200, l2cap_get_remote_mtu_for_local_cid(l2cap_cid));
+    CHECK_EQUAL(100 + 2, l2cap_get_remote_mtu_for_local_cid(cids[2]));
+}
+
+// connection with ACL fragments waiting for Controller buffers
+TEST_GROUP(L2CAP_CLASSIC_CAN_SEND_NOW){
+    uint16_t cid_1;
+    uint16_t cid_2;
+
+    void setup(void){
+        remote_sig_id = 0;
+        l2cap_can_send_now_cid = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_set_acl_buffers(64, 2);
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&l2cap_packet_handler, TEST_PSM, 1000, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        mock_hci_transport_connect_classic(remote_addr_2, TEST_CON_HANDLE_2);
+        remote_open_channel_for_handle(TEST_CON_HANDLE, 1000);
+        cid_1 = l2cap_cid;
+        remote_open_channel_for_handle(TEST_CON_HANDLE_2, 1000);
+        cid_2 = l2cap_cid;
+        mock_hci_transport_set_auto_complete(false);
+        mock_hci_transport_clear_packets();
+    }
+};
+
+TEST(L2CAP_CLASSIC_CAN_SEND_NOW, OtherConnectionNotBlocked){
+    CHECK(cid_1 != cid_2);
+
+    // 204 bytes in 64 byte fragments, third and fourth fragment get queued
+    static uint8_t data[200];
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(cid_1, data, sizeof(data)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(2, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+
+    l2cap_request_can_send_now_event(cid_2);
+    mock_hci_transport_process();
+    CHECK_EQUAL(0, l2cap_can_send_now_cid);
+
+    // free Controller buffer is used by second connection first
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(cid_2, l2cap_can_send_now_cid);
+    CHECK_EQUAL(3, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+    const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(mock_hci_transport_num_packets() - 1);
+    CHECK_EQUAL(TEST_CON_HANDLE_2, little_endian_read_16(packet->buffer, 0) & 0x0fff);
+
+    // queued fragments follow
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE, 1);
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE_2, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(5, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+}
+
+// signaling responses for Classic and LE connections, Classic ACL buffers used up
+TEST_GROUP(L2CAP_SIGNALING_RESPONSES){
+    const uint8_t echo_data[1] = { 0x55 };
+    void setup(void){
+        remote_sig_id = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_set_acl_buffers(64, 2);
+        mock_hci_transport_set_le_buffers(27, 2, 0, 0);
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        mock_hci_transport_connect_le(remote_addr_2, TEST_LE_CON_HANDLE);
+        mock_hci_transport_set_auto_complete(false);
+        mock_hci_transport_clear_packets();
+    }
+    const mock_hci_transport_packet_t * signaling_packet(uint16_t index){
+        uint16_t i;
+        for (i = 0; i < mock_hci_transport_num_packets(); i++){
+            const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+            if (packet->type != HCI_ACL_DATA_PACKET) continue;
+            if (index == 0) return packet;
+            index--;
+        }
+        return NULL;
+    }
+};
+
+TEST(L2CAP_SIGNALING_RESPONSES, OtherConnectionNotBlocked){
+    // echo responses use both Classic ACL buffers, third one is queued
+    remote_send_signaling(ECHO_REQUEST, 1, echo_data, sizeof(echo_data));
+    remote_send_signaling(ECHO_REQUEST, 2, echo_data, sizeof(echo_data));
+    remote_send_signaling(ECHO_REQUEST, 3, echo_data, sizeof(echo_data));
+    mock_hci_transport_process();
+    CHECK_EQUAL(2, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+
+    // reject for unknown LE signaling command is sent right away
+    remote_send_signaling_for_cid(TEST_LE_CON_HANDLE, L2CAP_CID_SIGNALING_LE, 0x7f, 4, NULL, 0);
+    mock_hci_transport_process();
+    CHECK_EQUAL(3, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+    const mock_hci_transport_packet_t * packet = signaling_packet(2);
+    CHECK(packet != NULL);
+    CHECK_EQUAL(TEST_LE_CON_HANDLE, little_endian_read_16(packet->buffer, 0) & 0x0fff);
+    CHECK_EQUAL(L2CAP_CID_SIGNALING_LE, little_endian_read_16(packet->buffer, 6));
+    CHECK_EQUAL(COMMAND_REJECT, packet->buffer[8]);
+    CHECK_EQUAL(4, packet->buffer[9]);
+
+    // queued echo response follows once a Classic ACL buffer is free
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(4, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+    packet = signaling_packet(3);
+    CHECK(packet != NULL);
+    CHECK_EQUAL(TEST_CON_HANDLE, little_endian_read_16(packet->buffer, 0) & 0x0fff);
+    CHECK_EQUAL(ECHO_RESPONSE, packet->buffer[8]);
+    CHECK_EQUAL(3, packet->buffer[9]);
+}
+
+TEST(L2CAP_SIGNALING_RESPONSES, ClosedConnectionDropped){
+    // two echo responses sent, NR_PENDING_SIGNALING_RESPONSES = 3 queued
+    uint8_t sig_id;
+    for (sig_id = 1; sig_id <= 5; sig_id++){
+        remote_send_signaling(ECHO_REQUEST, sig_id, echo_data, sizeof(echo_data));
+    }
+    mock_hci_transport_process();
+    CHECK_EQUAL(2, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+
+    // queued responses for closed connection are dropped and free the queue
+    mock_hci_transport_disconnect(TEST_CON_HANDLE, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+    mock_hci_transport_process();
+    remote_send_signaling_for_cid(TEST_LE_CON_HANDLE, L2CAP_CID_SIGNALING_LE, 0x7f, 4, NULL, 0);
+    mock_hci_transport_process();
+    CHECK_EQUAL(3, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+    const mock_hci_transport_packet_t * packet = signaling_packet(2);
+    CHECK(packet != NULL);
+    CHECK_EQUAL(TEST_LE_CON_HANDLE, little_endian_read_16(packet->buffer, 0) & 0x0fff);
+}
+
+// flushable channels and Automatic Flush Timeout, Controller supports Non-flushable Packet Boundary Flag
+TEST_GROUP(L2CAP_MEDIA_QOS){
+    void setup(void){
+        remote_sig_id = 0;
+        l2cap_cid = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_set_supported_feature(54);
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&l2cap_packet_handler, TEST_PSM, 1000, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        remote_open_channel(1000);
+        mock_hci_transport_clear_packets();
+    }
+    uint8_t packet_boundary_flag_for_last_data_packet(void){
+        const mock_hci_transport_packet_t * packet = last_data_packet();
+        CHECK(packet != NULL);
+        return (little_endian_read_16(packet->buffer, 0) >> 12) & 0x03;
+    }
+};
+
+TEST(L2CAP_MEDIA_QOS, FlushablePacketBoundaryFlag){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    uint8_t data[] = { 1, 2, 3 };
+
+    // non-flushable by default
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(l2cap_cid, data, sizeof(data)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(0x00, packet_boundary_flag_for_last_data_packet());
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_flushable(l2cap_cid, true));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(l2cap_cid, data, sizeof(data)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(0x02, packet_boundary_flag_for_last_data_packet());
+
+    btstack_iovec_t iov[1] = { { data, sizeof(data) } };
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send_iov(l2cap_cid, iov, 1));
+    mock_hci_transport_process();
+    CHECK_EQUAL(0x02, packet_boundary_flag_for_last_data_packet());
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_flushable(l2cap_cid, false));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(l2cap_cid, data, sizeof(data)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(0x00, packet_boundary_flag_for_last_data_packet());
+
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_set_flushable(0x1234, true));
+}
+
+TEST(L2CAP_MEDIA_QOS, AutomaticFlushTimeout){
+    // 100 ms = 160 * 0.625 ms
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, gap_set_automatic_flush_timeout(TEST_CON_HANDLE, 100));
+    mock_hci_transport_process();
+    const mock_hci_transport_packet_t * command = mock_hci_transport_find_command(hci_write_automatic_flush_timeout.opcode);
+    CHECK(command != NULL);
+    CHECK_EQUAL(TEST_CON_HANDLE, little_endian_read_16(command->buffer, 3));
+    CHECK_EQUAL(160, little_endian_read_16(command->buffer, 5));
+
+    // unchanged value is not written again
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, gap_set_automatic_flush_timeout(TEST_CON_HANDLE, 100));
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, mock_hci_transport_count_commands(hci_write_automatic_flush_timeout.opcode));
+
+    // clamped to 0x07ff
+    mock_hci_transport_clear_packets();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, gap_set_automatic_flush_timeout(TEST_CON_HANDLE, 2000));
+    mock_hci_transport_process();
+    command = mock_hci_transport_find_command(hci_write_automatic_flush_timeout.opcode);
+    CHECK(command != NULL);
+    CHECK_EQUAL(0x07ff, little_endian_read_16(command->buffer, 5));
+
+    CHECK_EQUAL(GAP_CONNECTION_INVALID, gap_set_automatic_flush_timeout(0x0abc, 100));
+}
+
+TEST(L2CAP_MEDIA_QOS, FlushedPackets){
+    CHECK_EQUAL(0, gap_get_flushed_packets(TEST_CON_HANDLE));
+    uint8_t params[2];
+    little_endian_store_16(params, 0, TEST_CON_HANDLE);
+    mock_hci_transport_receive_event(HCI_EVENT_FLUSH_OCCURRED, params, sizeof(params));
+    mock_hci_transport_receive_event(HCI_EVENT_FLUSH_OCCURRED, params, sizeof(params));
+    mock_hci_transport_process();
+    CHECK_EQUAL(2, gap_get_flushed_packets(TEST_CON_HANDLE));
+    CHECK_EQUAL(0, gap_get_flushed_packets(0x0abc));
+}
+
+// bulk and media channels on two connections sharing four Controller ACL buffers
+TEST_GROUP(L2CAP_QOS){
+    uint16_t bulk_cid;
+    uint16_t media_cid;
+
+    void setup(void){
+        remote_sig_id = 0;
+        l2cap_can_send_now_cid = 0;
+        mock_hci_transport_init();
+        mock_hci_transport_set_acl_buffers(64, 4);
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&l2cap_packet_handler, TEST_PSM, 1000, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        mock_hci_transport_connect_classic(remote_addr_2, TEST_CON_HANDLE_2);
+        remote_open_channel_for_handle(TEST_CON_HANDLE, 1000);
+        bulk_cid = l2cap_cid;
+        remote_open_channel_for_handle(TEST_CON_HANDLE_2, 1000);
+        media_cid = l2cap_cid;
+        mock_hci_transport_set_auto_complete(false);
+        mock_hci_transport_clear_packets();
+    }
+    void send_packet(uint16_t cid){
+        uint8_t data[] = { 1, 2, 3 };
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(cid, data, sizeof(data)));
+        mock_hci_transport_process();
+    }
+};
+
+TEST(L2CAP_QOS, ReservationForActiveMediaChannel){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_traffic_class(media_cid, HCI_TRAFFIC_CLASS_MEDIA));
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_set_traffic_class(0x1234, HCI_TRAFFIC_CLASS_MEDIA));
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_set_traffic_class(media_cid, HCI_TRAFFIC_CLASS_NUM));
+
+    // HCI_QOS_ACL_RESERVED_MEDIA = 2 buffers are kept for media
+    send_packet(bulk_cid);
+    CHECK_EQUAL(1, l2cap_can_send_packet_now(bulk_cid));
+    send_packet(bulk_cid);
+    CHECK_EQUAL(0, l2cap_can_send_packet_now(bulk_cid));
+    CHECK_EQUAL(1, l2cap_can_send_packet_now(media_cid));
+
+    // reservation ends when media channel becomes bulk again
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_traffic_class(media_cid, HCI_TRAFFIC_CLASS_BULK));
+    CHECK_EQUAL(1, l2cap_can_send_packet_now(bulk_cid));
+}
+
+TEST(L2CAP_QOS, OneBufferLeftForLowerPriority){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_traffic_class(media_cid, HCI_TRAFFIC_CLASS_MEDIA));
+    hci_qos_set_acl_reservation(HCI_TRAFFIC_CLASS_MEDIA, 10);
+    send_packet(bulk_cid);
+    CHECK_EQUAL(0, l2cap_can_send_packet_now(bulk_cid));
+
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, l2cap_can_send_packet_now(bulk_cid));
+}
+
+TEST(L2CAP_QOS, MediaChannelServedFirst){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_traffic_class(media_cid, HCI_TRAFFIC_CLASS_MEDIA));
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        send_packet(media_cid);
+    }
+    CHECK_EQUAL(0, l2cap_can_send_packet_now(media_cid));
+
+    // bulk channel asks first
+    l2cap_request_can_send_now_event(bulk_cid);
+    l2cap_request_can_send_now_event(media_cid);
+    mock_hci_transport_process();
+    CHECK_EQUAL(0, l2cap_can_send_now_cid);
+
+    // single free buffer goes to media channel
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE_2, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(media_cid, l2cap_can_send_now_cid);
+
+    // bulk channel gets buffers beyond media reservation
+    l2cap_can_send_now_cid = 0;
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE_2, 2);
+    mock_hci_transport_process();
+    CHECK_EQUAL(0, l2cap_can_send_now_cid);
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE_2, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(bulk_cid, l2cap_can_send_now_cid);
+}
+
+TEST(L2CAP_QOS, PriorityWithoutReservation){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_set_traffic_class(media_cid, HCI_TRAFFIC_CLASS_MEDIA));
+    hci_qos_set_acl_reservation(HCI_TRAFFIC_CLASS_MEDIA, 0);
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        send_packet(bulk_cid);
+    }
+    l2cap_request_can_send_now_event(bulk_cid);
+    l2cap_request_can_send_now_event(media_cid);
+    mock_hci_transport_process();
+
+    // both channels could use the free buffer, higher priority class wins
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(media_cid, l2cap_can_send_now_cid);
+    mock_hci_transport_complete_packets(TEST_CON_HANDLE, 1);
+    mock_hci_transport_process();
+    CHECK_EQUAL(bulk_cid, l2cap_can_send_now_cid);
+}
+
+// ERTM with 16-bit Enhanced Control Field and without FCS
+#define ERTM_EXTENDED_FEATURE_MASK      0x0008
+#define STREAMING_EXTENDED_FEATURE_MASK 0x0010
+#define S_FUNCTION_RR   0
+#define S_FUNCTION_SREJ 3
+
+static l2cap_ertm_config_t ertm_config = {
+    1,      // ertm mandatory
+    2,      // max transmit
+    2000,   // retransmission timeout ms
+    12000,  // monitor timeout ms
+    100,    // local mtu
+    4,      // num tx buffers
+    4,      // num rx buffers
+    0,      // no fcs
+};
+static uint8_t  ertm_buffer[2000];
+static uint8_t  ertm_received[16];
+static uint16_t ertm_num_received;
+static bool     ertm_accept_streaming;
+
+static void ertm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    if (packet_type == L2CAP_DATA_PACKET){
+        if ((size > 0) && (ertm_num_received < sizeof(ertm_received))){
+            ertm_received[ertm_num_received++] = packet[0];
+        }
+        return;
+    }
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            if (ertm_accept_streaming){
+                l2cap_accept_streaming_connection(l2cap_event_incoming_connection_get_local_cid(packet), &ertm_config, ertm_buffer, sizeof(ertm_buffer));
+            } else {
+                l2cap_accept_ertm_connection(l2cap_event_incoming_connection_get_local_cid(packet), &ertm_config, ertm_buffer, sizeof(ertm_buffer));
+            }
+            break;
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            l2cap_channel_opened_status = l2cap_event_channel_opened_get_status(packet);
+            l2cap_cid = l2cap_event_channel_opened_get_local_cid(packet);
+            break;
+        default:
+            break;
+    }
+}
+
+static void remote_send_i_frame_segment(uint8_t tx_seq, uint8_t req_seq, l2cap_segmentation_and_reassembly_t sar, const uint8_t * data, uint16_t len){
+    uint8_t frame[16];
+    btstack_assert(len <= (sizeof(frame) - 2));
+    little_endian_store_16(frame, 0, (tx_seq << 1) | (req_seq << 8) | (sar << 14));
+    (void)memcpy(&frame[2], data, len);
+    remote_send_data(l2cap_cid, frame, 2 + len);
+    mock_hci_transport_process();
+}
+
+static void remote_send_i_frame(uint8_t tx_seq, uint8_t req_seq, uint8_t data){
+    remote_send_i_frame_segment(tx_seq, req_seq, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, &data, 1);
+}
+
+static void remote_send_s_frame(uint8_t s, uint8_t req_seq){
+    uint8_t frame[2];
+    little_endian_store_16(frame, 0, 1 | (s << 2) | (req_seq << 8));
+    remote_send_data(l2cap_cid, frame, sizeof(frame));
+    mock_hci_transport_process();
+}
+
+static uint16_t last_data_packet_control(void){
+    const mock_hci_transport_packet_t * packet = last_data_packet();
+    if (packet == NULL) return 0xffff;
+    return little_endian_read_16(packet->buffer, 8);
+}
+
+static bool is_s_frame(uint16_t control, uint8_t s, uint8_t req_seq){
+    return ((control & 1) == 1) && (((control >> 2) & 0x03) == s) && (((control >> 8) & 0x3f) == req_seq);
+}
+
+TEST_GROUP(L2CAP_ERTM){
+    void setup(void){
+        remote_sig_id = 0;
+        remote_extended_feature_mask = ERTM_EXTENDED_FEATURE_MASK;
+        remote_rfc_mode = L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION;
+        remote_mps = 1000;
+        l2cap_cid = 0;
+        l2cap_channel_opened_status = 0xff;
+        ertm_num_received = 0;
+        ertm_accept_streaming = false;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&ertm_packet_handler, TEST_PSM, 100, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+    }
+    void teardown(void){
+        remote_extended_feature_mask = 0;
+        remote_rfc_mode = L2CAP_CHANNEL_MODE_BASIC;
+    }
+};
+
+TEST(L2CAP_ERTM, SelectiveRejectForMissingFrame){
+    remote_open_channel(100);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    remote_send_i_frame(0, 0, 'a');
+    CHECK(is_s_frame(last_data_packet_control(), S_FUNCTION_RR, 1));
+
+    // frame 1 lost: frame 2 is stored and frame 1 requested with S-SREJ
+    remote_send_i_frame(2, 0, 'c');
+    CHECK_EQUAL(1, ertm_num_received);
+    CHECK(is_s_frame(last_data_packet_control(), S_FUNCTION_SREJ, 1));
+
+    // retransmitted frame 1 releases stored frame 2
+    remote_send_i_frame(1, 0, 'b');
+    CHECK_EQUAL(3, ertm_num_received);
+    MEMCMP_EQUAL("abc", ertm_received, 3);
+    CHECK(is_s_frame(last_data_packet_control(), S_FUNCTION_RR, 3));
+}
+
+TEST(L2CAP_ERTM, DuplicateFrameAcknowledged){
+    remote_open_channel(100);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    remote_send_i_frame(0, 0, 'a');
+    mock_hci_transport_clear_packets();
+
+    // retransmission of already received frame, e.g. after lost acknowledgement
+    remote_send_i_frame(0, 0, 'a');
+    CHECK_EQUAL(1, ertm_num_received);
+    CHECK(is_s_frame(last_data_packet_control(), S_FUNCTION_RR, 1));
+}
+
+TEST(L2CAP_ERTM, SelectiveRejectRetransmitsRequestedFrame){
+    remote_open_channel(100);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    uint8_t data;
+    for (data = '1'; data <= '3'; data++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(l2cap_cid, &data, 1));
+        mock_hci_transport_process();
+    }
+    mock_hci_transport_clear_packets();
+
+    remote_send_s_frame(S_FUNCTION_SREJ, 1);
+    CHECK_EQUAL(1, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+    const mock_hci_transport_packet_t * packet = last_data_packet();
+    CHECK(packet != NULL);
+    uint16_t control = little_endian_read_16(packet->buffer, 8);
+    CHECK_EQUAL(0, control & 1);
+    CHECK_EQUAL(1, (control >> 1) & 0x3f);
+    CHECK_EQUAL('2', packet->buffer[10]);
+}
+
+TEST(L2CAP_ERTM, TxBuffersSplitByRemoteMps){
+    // remote MPS smaller than local MPS, SDUs fit into single frame
+    remote_mps = 40;
+    remote_open_channel(30);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    uint8_t data = 0;
+    uint16_t num_stored = 0;
+    while ((num_stored < 64) && (l2cap_send(l2cap_cid, &data, 1) == ERROR_CODE_SUCCESS)){
+        num_stored++;
+    }
+    CHECK(num_stored > ertm_config.num_tx_buffers);
+}
+
+TEST_GROUP(L2CAP_STREAMING){
+    void setup(void){
+        remote_sig_id = 0;
+        remote_extended_feature_mask = STREAMING_EXTENDED_FEATURE_MASK;
+        remote_rfc_mode = L2CAP_CHANNEL_MODE_STREAMING_MODE;
+        remote_mps = 1000;
+        l2cap_cid = 0;
+        l2cap_channel_opened_status = 0xff;
+        ertm_num_received = 0;
+        ertm_accept_streaming = true;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&ertm_packet_handler, TEST_PSM, 100, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        remote_open_channel(100);
+    }
+    void teardown(void){
+        remote_extended_feature_mask = 0;
+        remote_rfc_mode = L2CAP_CHANNEL_MODE_BASIC;
+    }
+};
+
+TEST(L2CAP_STREAMING, ExtendedFeatureMask){
+    uint8_t params[2];
+    little_endian_store_16(params, 0, INFO_TYPE_EXTENDED_FEATURES_SUPPORTED);
+    mock_hci_transport_clear_packets();
+    remote_send_signaling(INFORMATION_REQUEST, 0x42, params, sizeof(params));
+    mock_hci_transport_process();
+
+    const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(mock_hci_transport_num_packets() - 1);
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, packet->type);
+    CHECK_EQUAL(L2CAP_CID_SIGNALING, little_endian_read_16(packet->buffer, 6));
+    CHECK_EQUAL(INFORMATION_RESPONSE, packet->buffer[8]);
+    CHECK_EQUAL(STREAMING_EXTENDED_FEATURE_MASK, little_endian_read_32(packet->buffer, 16) & STREAMING_EXTENDED_FEATURE_MASK);
+}
+
+TEST(L2CAP_STREAMING, IncompleteSduDropped){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    mock_hci_transport_clear_packets();
+
+    // start segment with SDU length 4, continuation with TxSeq 1 lost
+    const uint8_t start[] = { 4, 0, 'a', 'a' };
+    const uint8_t end[]   = { 'b', 'b' };
+    remote_send_i_frame_segment(0, 0, L2CAP_SEGMENTATION_AND_REASSEMBLY_START_OF_L2CAP_SDU, start, sizeof(start));
+    remote_send_i_frame_segment(2, 0, L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU, end, sizeof(end));
+    CHECK_EQUAL(0, ertm_num_received);
+
+    // next SDU is delivered, lost frame is neither acknowledged nor requested
+    remote_send_i_frame(3, 0, 'c');
+    CHECK_EQUAL(1, ertm_num_received);
+    CHECK_EQUAL('c', ertm_received[0]);
+    CHECK(last_data_packet() == NULL);
+}
+
+TEST(L2CAP_STREAMING, FramesReleasedAfterSending){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    mock_hci_transport_clear_packets();
+
+    // more SDUs than tx buffers without any acknowledgement from remote
+    uint8_t data;
+    for (data = 0; data < (2 * ertm_config.num_tx_buffers); data++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(l2cap_cid, &data, 1));
+        mock_hci_transport_process();
+    }
+
+    CHECK_EQUAL(2 * ertm_config.num_tx_buffers, mock_hci_transport_num_packets_of_type(HCI_ACL_DATA_PACKET));
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ACL_DATA_PACKET) continue;
+        uint16_t control = little_endian_read_16(packet->buffer, 8);
+        uint8_t  tx_seq  = (control >> 1) & 0x3f;
+        CHECK_EQUAL(0, control & 1);
+        CHECK_EQUAL(0, (control >> 8) & 0x3f);
+        CHECK_EQUAL(tx_seq, packet->buffer[10]);
+    }
+}
+
+// LE Data Channel opened by remote with given MPS and initial credits
+#define TEST_LE_PSM 0x0080
+#define TEST_LE_MTU 100
+
+static uint8_t  le_receive_buffer[TEST_LE_MTU];
+static uint16_t le_num_packets_sent;
+static uint16_t le_num_can_send_now;
+static const l2cap_le_credit_policy_t * le_credit_policy;
+
+static void le_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    uint16_t local_cid;
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_LE_INCOMING_CONNECTION:
+            local_cid = l2cap_event_le_incoming_connection_get_local_cid(packet);
+            if (le_credit_policy != NULL){
+                l2cap_le_set_credit_policy(local_cid, le_credit_policy);
+                l2cap_le_accept_connection(local_cid, le_receive_buffer, TEST_LE_MTU, 0);
+            } else {
+                l2cap_le_accept_connection(local_cid, le_receive_buffer, TEST_LE_MTU, 1);
+            }
+            break;
+        case L2CAP_EVENT_LE_CHANNEL_OPENED:
+            l2cap_channel_opened_status = l2cap_event_le_channel_opened_get_status(packet);
+            l2cap_cid = l2cap_event_le_channel_opened_get_local_cid(packet);
+            break;
+        case L2CAP_EVENT_LE_CAN_SEND_NOW:
+            le_num_can_send_now++;
+            break;
+        case L2CAP_EVENT_LE_PACKET_SENT:
+            le_num_packets_sent++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void remote_le_open_channel(uint16_t mps, uint16_t credits){
+    uint8_t params[10];
+    little_endian_store_16(params, 0, TEST_LE_PSM);
+    little_endian_store_16(params, 2, TEST_REMOTE_CID);
+    little_endian_store_16(params, 4, TEST_LE_MTU);
+    little_endian_store_16(params, 6, mps);
+    little_endian_store_16(params, 8, credits);
+    remote_send_signaling_for_cid(TEST_LE_CON_HANDLE, L2CAP_CID_SIGNALING_LE, LE_CREDIT_BASED_CONNECTION_REQUEST, ++remote_sig_id, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+static void remote_le_send_credits(uint16_t credits){
+    uint8_t params[4];
+    little_endian_store_16(params, 0, l2cap_cid);
+    little_endian_store_16(params, 2, credits);
+    remote_send_signaling_for_cid(TEST_LE_CON_HANDLE, L2CAP_CID_SIGNALING_LE, LE_FLOW_CONTROL_CREDIT, ++remote_sig_id, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+// K-frames sent by stack since last clear, payload appended to buffer
+static uint16_t le_collect_k_frames(uint8_t * buffer, uint16_t * len){
+    uint16_t num_frames = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ACL_DATA_PACKET) continue;
+        if (little_endian_read_16(packet->buffer, 6) != TEST_REMOTE_CID) continue;
+        uint16_t pdu_len = little_endian_read_16(packet->buffer, 4);
+        (void)memcpy(&buffer[*len], &packet->buffer[8], pdu_len);
+        *len += pdu_len;
+        num_frames++;
+    }
+    return num_frames;
+}
+
+TEST_GROUP(L2CAP_LE_DATA_CHANNEL){
+    void setup(void){
+        remote_sig_id = 0;
+        l2cap_cid = 0;
+        l2cap_channel_opened_status = 0xff;
+        le_num_packets_sent = 0;
+        le_num_can_send_now = 0;
+        le_credit_policy = NULL;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        l2cap_le_register_service(&le_packet_handler, TEST_LE_PSM, LEVEL_0);
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_le(remote_addr_2, TEST_LE_CON_HANDLE);
+    }
+};
+
+TEST(L2CAP_LE_DATA_CHANNEL, SduSentInChunks){
+    remote_le_open_channel(10, 2);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    uint8_t sdu[30];
+    uint16_t i;
+    for (i = 0; i < sizeof(sdu); i++){
+        sdu[i] = (uint8_t) i;
+    }
+    mock_hci_transport_clear_packets();
+
+    // PDUs end with first chunk, next chunk requested
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_sdu_start(l2cap_cid, sizeof(sdu), sdu, 12));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_request_can_send_now_event(l2cap_cid));
+    mock_hci_transport_process();
+    uint8_t  frames[40];
+    uint16_t frames_len = 0;
+    CHECK_EQUAL(2, le_collect_k_frames(frames, &frames_len));
+    CHECK_EQUAL(2 + 12, frames_len);
+    CHECK_EQUAL(1, le_num_can_send_now);
+    CHECK_EQUAL(0, le_num_packets_sent);
+
+    // SDU not complete, no new SDU can be started
+    CHECK_EQUAL(0, l2cap_le_can_send_now(l2cap_cid));
+    CHECK_EQUAL(BTSTACK_ACL_BUFFERS_FULL, l2cap_le_send_data(l2cap_cid, sdu, 1));
+
+    // remaining chunk waits for credits
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_sdu_continue(l2cap_cid, &sdu[12], sizeof(sdu) - 12));
+    mock_hci_transport_process();
+    frames_len = 0;
+    CHECK_EQUAL(2, le_collect_k_frames(frames, &frames_len));
+
+    // sent right after credits are received
+    remote_le_send_credits(2);
+    frames_len = 0;
+    CHECK_EQUAL(4, le_collect_k_frames(frames, &frames_len));
+    CHECK_EQUAL(2 + sizeof(sdu), frames_len);
+    CHECK_EQUAL(sizeof(sdu), little_endian_read_16(frames, 0));
+    MEMCMP_EQUAL(sdu, &frames[2], sizeof(sdu));
+    CHECK_EQUAL(1, le_num_packets_sent);
+}
+
+TEST(L2CAP_LE_DATA_CHANNEL, SduContinueInvalid){
+    remote_le_open_channel(10, 2);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+
+    uint8_t sdu[30] = { 0 };
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, l2cap_le_send_sdu_continue(l2cap_cid, sdu, 10));
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_le_send_sdu_start(l2cap_cid, 10, sdu, 20));
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_sdu_start(l2cap_cid, sizeof(sdu), sdu, 8));
+    mock_hci_transport_process();
+    // chunk must not exceed announced SDU length
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_le_send_sdu_continue(l2cap_cid, sdu, 23));
+}
+
+// credits in LE Credit Based Connection Response sent by stack
+static uint16_t le_connection_response_credits(void){
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ACL_DATA_PACKET) continue;
+        if (little_endian_read_16(packet->buffer, 6) != L2CAP_CID_SIGNALING_LE) continue;
+        if (packet->buffer[8] != LE_CREDIT_BASED_CONNECTION_RESPONSE) continue;
+        return little_endian_read_16(packet->buffer, 18);
+    }
+    return 0;
+}
+
+// credits granted with LE Flow Control Credit since last clear
+static uint16_t le_granted_credits(uint16_t * num_packets){
+    uint16_t credits = 0;
+    *num_packets = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ACL_DATA_PACKET) continue;
+        if (little_endian_read_16(packet->buffer, 6) != L2CAP_CID_SIGNALING_LE) continue;
+        if (packet->buffer[8] != LE_FLOW_CONTROL_CREDIT) continue;
+        CHECK_EQUAL(TEST_REMOTE_CID, little_endian_read_16(packet->buffer, 12));
+        credits += little_endian_read_16(packet->buffer, 14);
+        (*num_packets)++;
+    }
+    return credits;
+}
+
+static void remote_le_send_sdu(uint8_t data){
+    uint8_t k_frame[3];
+    little_endian_store_16(k_frame, 0, 1);
+    k_frame[2] = data;
+    remote_send_data_for_handle(TEST_LE_CON_HANDLE, l2cap_cid, k_frame, sizeof(k_frame));
+    mock_hci_transport_process();
+}
+
+TEST(L2CAP_LE_DATA_CHANNEL, CreditPolicyFixedWindow){
+    static const l2cap_le_credit_policy_t policy = { L2CAP_LE_CREDIT_POLICY_FIXED_WINDOW, 8, 0, 4, 0 };
+    le_credit_policy = &policy;
+    remote_le_open_channel(TEST_LE_MTU, 1);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    CHECK_EQUAL(8, le_connection_response_credits());
+    mock_hci_transport_clear_packets();
+
+    // credits granted once a batch is missing from the window
+    uint16_t num_packets;
+    uint8_t i;
+    for (i = 0; i < 3; i++){
+        remote_le_send_sdu(i);
+    }
+    CHECK_EQUAL(0, le_granted_credits(&num_packets));
+    remote_le_send_sdu(3);
+    CHECK_EQUAL(4, le_granted_credits(&num_packets));
+    CHECK_EQUAL(1, num_packets);
+}
+
+TEST(L2CAP_LE_DATA_CHANNEL, CreditPolicyBatchLargerThanWindow){
+    // batch is limited to window, remote does not run out of credits
+    static const l2cap_le_credit_policy_t policy = { L2CAP_LE_CREDIT_POLICY_FIXED_WINDOW, 2, 0, 4, 0 };
+    le_credit_policy = &policy;
+    remote_le_open_channel(TEST_LE_MTU, 1);
+    CHECK_EQUAL(2, le_connection_response_credits());
+    mock_hci_transport_clear_packets();
+
+    uint16_t num_packets;
+    remote_le_send_sdu(0);
+    CHECK_EQUAL(0, le_granted_credits(&num_packets));
+    remote_le_send_sdu(1);
+    CHECK_EQUAL(2, le_granted_credits(&num_packets));
+}
+
+TEST(L2CAP_LE_DATA_CHANNEL, CreditPolicyRxMemory){
+    static const l2cap_le_credit_policy_t policy = { L2CAP_LE_CREDIT_POLICY_RX_MEMORY, 8, 0, 1, 0 };
+    le_credit_policy = &policy;
+    remote_le_open_channel(TEST_LE_MTU, 1);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    // until reported otherwise, memory for one SDU of local MTU is assumed
+    CHECK_EQUAL(1, le_connection_response_credits());
+    mock_hci_transport_clear_packets();
+
+    // one credit per local MPS, bounded by policy window
+    uint16_t num_packets;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_set_rx_memory_available(l2cap_cid, 4 * TEST_LE_MTU));
+    mock_hci_transport_process();
+    CHECK_EQUAL(3, le_granted_credits(&num_packets));
+    mock_hci_transport_clear_packets();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_set_rx_memory_available(l2cap_cid, 20 * TEST_LE_MTU));
+    mock_hci_transport_process();
+    CHECK_EQUAL(4, le_granted_credits(&num_packets));
+}
+
+TEST(L2CAP_LE_DATA_CHANNEL, CreditPolicyConsumptionRate){
+    static const l2cap_le_credit_policy_t policy = { L2CAP_LE_CREDIT_POLICY_CONSUMPTION_RATE, 16, 2, 1, 1000 };
+    le_credit_policy = &policy;
+    remote_le_open_channel(TEST_LE_MTU, 1);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_channel_opened_status);
+    // start with half of max window
+    CHECK_EQUAL(8, le_connection_response_credits());
+    mock_hci_transport_clear_packets();
+
+    uint16_t num_packets;
+    uint8_t i;
+    for (i = 0; i < 8; i++){
+        remote_le_send_sdu(i);
+    }
+    CHECK_EQUAL(8, le_granted_credits(&num_packets));
+
+    // complete window used in interval: window doubled
+    mock_hci_transport_clear_packets();
+    mock_btstack_run_loop_advance_time_ms(1000);
+    remote_le_send_sdu(8);
+    CHECK_EQUAL(9, le_granted_credits(&num_packets));
+
+    // single credit used in interval: window shrinks to min window, no credits granted
+    mock_hci_transport_clear_packets();
+    mock_btstack_run_loop_advance_time_ms(1000);
+    remote_le_send_sdu(9);
+    CHECK_EQUAL(0, le_granted_credits(&num_packets));
+}
+
+TEST(L2CAP_LE_DATA_CHANNEL, CreditPolicyInvalid){
+    remote_le_open_channel(TEST_LE_MTU, 1);
+    static const l2cap_le_credit_policy_t policy = { L2CAP_LE_CREDIT_POLICY_FIXED_WINDOW, 0, 0, 0, 0 };
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_le_set_credit_policy(l2cap_cid, &policy));
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_le_set_credit_policy(0x1234, &policy));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -235,6 +235,80 @@ TEST(LinkedList, RemoveSecondAndThirdUsingListRemove){
     CHECK(!btstack_linked_list_iterator_has_next(&it));
 }
 
+TEST_GROUP(LinkedQueue){
+    btstack_linked_queue_t queue;
+    void setup(void){
+        queue.head = NULL;
+        queue.tail = NULL;
+        btstack_linked_queue_enqueue(&queue, &itemA);
+        btstack_linked_queue_enqueue(&queue, &itemB);
+        btstack_linked_queue_enqueue(&queue, &itemC);
+    }
+};
+
+TEST(LinkedQueue, Dequeue){
+    CHECK_EQUAL(&itemA, btstack_linked_queue_first(&queue));
+    CHECK_EQUAL(&itemA, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemB, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemC, btstack_linked_queue_dequeue(&queue));
+    CHECK(btstack_linked_queue_empty(&queue));
+    CHECK(btstack_linked_queue_dequeue(&queue) == NULL);
+    btstack_linked_queue_enqueue(&queue, &itemD);
+    CHECK_EQUAL(&itemD, btstack_linked_queue_dequeue(&queue));
+}
+
+TEST(LinkedQueue, EnqueueTwice){
+    // re-enqueue tail and head
+    CHECK(!btstack_linked_queue_enqueue(&queue, &itemC));
+    CHECK(!btstack_linked_queue_enqueue(&queue, &itemA));
+    CHECK(btstack_linked_queue_enqueue(&queue, &itemD));
+    CHECK_EQUAL(&itemA, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemB, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemC, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemD, btstack_linked_queue_dequeue(&queue));
+    CHECK(btstack_linked_queue_empty(&queue));
+}
+
+TEST(LinkedQueue, RemoveLast){
+    CHECK(btstack_linked_queue_remove(&queue, &itemC));
+    CHECK(!btstack_linked_queue_remove(&queue, &itemD));
+    btstack_linked_queue_enqueue(&queue, &itemD);
+    CHECK_EQUAL(&itemA, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemB, btstack_linked_queue_dequeue(&queue));
+    CHECK_EQUAL(&itemD, btstack_linked_queue_dequeue(&queue));
+    CHECK(btstack_linked_queue_empty(&queue));
+}
+
+TEST_GROUP(LinkedDList){
+    btstack_linked_dlist_t list;
+    btstack_linked_dlist_item_t items[3];
+    void setup(void){
+        list.head = NULL;
+        list.tail = NULL;
+        btstack_linked_dlist_add_tail(&list, &items[1]);
+        btstack_linked_dlist_add_tail(&list, &items[2]);
+        btstack_linked_dlist_add(&list, &items[0]);
+    }
+};
+
+TEST(LinkedDList, Order){
+    CHECK_EQUAL(&items[0], btstack_linked_dlist_get_first_item(&list));
+    CHECK_EQUAL(&items[2], btstack_linked_dlist_get_last_item(&list));
+    CHECK_EQUAL(&items[1], items[0].next);
+    CHECK_EQUAL(&items[1], items[2].prev);
+}
+
+TEST(LinkedDList, Remove){
+    btstack_linked_dlist_remove(&list, &items[1]);
+    CHECK_EQUAL(&items[2], items[0].next);
+    CHECK_EQUAL(&items[0], items[2].prev);
+    btstack_linked_dlist_remove(&list, &items[2]);
+    CHECK_EQUAL(&items[0], btstack_linked_dlist_get_last_item(&list));
+    CHECK_EQUAL(&items[0], btstack_linked_dlist_pop(&list));
+    CHECK(btstack_linked_dlist_empty(&list));
+    CHECK(btstack_linked_dlist_get_last_item(&list) == NULL);
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
\ No newline at end of file
@@ -70,25 +70,27 @@ void gatt_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handle
 }
 void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t packet_handler){
 }
-void gatt_bearer_request_can_send_now_for_network_pdu(void){
+void gatt_bearer_request_can_send_now_for_network_pdu(hci_con_handle_t con_handle){
     // simulate can send now
-    uint8_t event[3];
+    uint8_t event[5];
     event[0] = HCI_EVENT_MESH_META;
     event[1] = 1;
     event[2] = MESH_SUBEVENT_CAN_SEND_NOW;
+    little_endian_store_16(event, 3, con_handle);
     (*gatt_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
 }
-void gatt_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size){
+void gatt_bearer_send_network_pdu(hci_con_handle_t con_handle, const uint8_t * network_pdu, uint16_t size){
     // printf("ADV Network PDU: ");
     // printf_hexdump(network_pdu, size);
     memcpy(outgoing_gatt_network_pdu_data, network_pdu, size);
     outgoing_gatt_network_pdu_len = size;
 }
 static void gatt_bearer_emit_sent(void){
-    uint8_t event[3];
+    uint8_t event[5];
     event[0] = HCI_EVENT_MESH_META;
     event[1] = 1;
     event[2] = MESH_SUBEVENT_MESSAGE_SENT;
+    little_endian_store_16(event, 3, 0x1234);
     (*gatt_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
 }
 static void gatt_bearer_emit_connected(void){
@@ -1059,7 +1061,7 @@ TEST(MessageTest, ProxyConfigReceive){
     char ** network_pdus = proxy_config_pdus;
     test_network_pdu_len = strlen(network_pdus[i]) / 2;
     btstack_parse_hex(network_pdus[i], test_network_pdu_len, test_network_pdu_data);
-    mesh_network_process_proxy_configuration_message(&test_network_pdu_data[1], test_network_pdu_len-1);
+    mesh_network_process_proxy_configuration_message(0x1234, &test_network_pdu_data[1], test_network_pdu_len-1);
     while (received_proxy_pdu == NULL) {
         mock_process_hci_cmd();
     }
@@ -1149,14 +1151,89 @@ TEST(MessageTest, ServiceDataUsingNodeIdentityTest){
 // Mesh v1.0, 8.2.1 
 static btstack_crypto_aes128_cmac_t aes_cmac_request;
 static uint8_t k4_result[1];
+static int     k4_done;
 static void handle_k4_result(void *arg){
     printf("ApplicationkeyIDTest: %02x\n", k4_result[0]);
     CHECK_EQUAL( 0x26, k4_result[0]);
+    k4_done = 1;
 }
 TEST(MessageTest, ApplicationkeyIDTest){
     static uint8_t application_key[16];
     btstack_parse_hex("63964771734fbd76e3b40519d1d94a48", 16, application_key);
+    k4_done = 0;
     mesh_k4(&aes_cmac_request, application_key, &k4_result[0], &handle_k4_result, NULL);
+    while (k4_done == 0){
+        mock_process_hci_cmd();
+    }
+}
+
+// Mesh v1.0, 8.1.4
+static btstack_crypto_aes128_cmac_t k2_request;
+static uint8_t k2_result[33];
+static int     k2_done;
+static void handle_k2_result(void *arg){
+    UNUSED(arg);
+    k2_done = 1;
+}
+static void test_k2(const char * p_string, uint8_t expected_nid, const char * expected_encryption_key, const char * expected_privacy_key){
+    static uint8_t net_key[16];
+    uint8_t p[MESH_K2_P_MAX_LEN];
+    uint16_t p_len = strlen(p_string) / 2;
+    uint8_t expected_key[16];
+    btstack_parse_hex("f7a2a44f8e8a8029064f173ddc1e2b00", 16, net_key);
+    btstack_parse_hex(p_string, p_len, p);
+    k2_done = 0;
+    mesh_k2_with_p(&k2_request, net_key, p, p_len, k2_result, &handle_k2_result, NULL);
+    while (k2_done == 0){
+        mock_process_hci_cmd();
+    }
+    CHECK_EQUAL(expected_nid, k2_result[0]);
+    btstack_parse_hex(expected_encryption_key, 16, expected_key);
+    CHECK_EQUAL_ARRAY(expected_key, &k2_result[1], 16);
+    btstack_parse_hex(expected_privacy_key, 16, expected_key);
+    CHECK_EQUAL_ARRAY(expected_key, &k2_result[17], 16);
+}
+TEST(MessageTest, K2MasterTest){
+    test_k2("00", 0x7f, "9f589181a0f50de73c8070c7a6d27f46", "4c715bd4a64b938f99b453351653124f");
+}
+TEST(MessageTest, K2FriendshipTest){
+    test_k2("010203040506070809", 0x73, "11efec0642774992510fb5929646df49", "d4d7cc0dfa772d836a8df9df5510d7a7");
+}
+
+// Network Message Cache
+
+// returns true if network pdu was passed to lower transport, false if it was dropped
+static bool test_receive_network_pdu_cached(char * network_pdu){
+    test_network_pdu_len = strlen(network_pdu) / 2;
+    btstack_parse_hex(network_pdu, test_network_pdu_len, test_network_pdu_data);
+    mesh_network_received_message(test_network_pdu_data, test_network_pdu_len, 0);
+    while (mock_process_hci_cmd()){
+    }
+    if (received_network_pdu == NULL) return false;
+    mesh_network_message_processed_by_higher_layer(received_network_pdu);
+    received_network_pdu = NULL;
+    return true;
+}
+
+TEST(MessageTest, NetworkCacheDropsDuplicate){
+    load_network_key_nid_68();
+    mesh_set_iv_index(0x12345678);
+    CHECK_TRUE(test_receive_network_pdu_cached(message18_network_pdus[0]));
+    CHECK_FALSE(test_receive_network_pdu_cached(message18_network_pdus[0]));
+}
+
+TEST(MessageTest, NetworkCacheEvictsLeastRecentlyUsed){
+    load_network_key_nid_68();
+    mesh_set_iv_index(0x12345678);
+    // cache holds two pdus
+    CHECK_TRUE(test_receive_network_pdu_cached(message18_network_pdus[0]));
+    CHECK_TRUE(test_receive_network_pdu_cached(message19_network_pdus[0]));
+    // duplicate of first pdu makes it most recently used
+    CHECK_FALSE(test_receive_network_pdu_cached(message18_network_pdus[0]));
+    // new pdu evicts second pdu instead of first one
+    CHECK_TRUE(test_receive_network_pdu_cached(message1_network_pdus[0]));
+    CHECK_FALSE(test_receive_network_pdu_cached(message18_network_pdus[0]));
+    CHECK_TRUE(test_receive_network_pdu_cached(message19_network_pdus[0]));
 }
 
 int main (int argc, const char * argv[]){
@@ -0,0 +1,619 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+// *****************************************************************************
+//
+// Mesh Network Benchmark
+//
+// Runs the network layer of a single node (the device under test, DUT) inside a
+// simulated topology. All other nodes are modelled by the benchmark: they relay
+// Network PDUs with a decremented TTL and keep a perfect network cache. Time is virtual and all jitter is derived from a seeded LFSR,
+// so results only depend on the command line arguments - except for the CPU
+// time spent by the DUT, which is measured with the monotonic clock.
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack_crypto.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "mesh/adv_bearer.h"
+#include "mesh/gatt_bearer.h"
+#include "mesh/mesh_foundation.h"
+#include "mesh/mesh_iv_index_seq_number.h"
+#include "mesh/mesh_keys.h"
+#include "mesh/mesh_network.h"
+#include "mesh/mesh_node.h"
+
+#define BENCHMARK_MAX_NODES         64
+#define BENCHMARK_MAX_MESSAGES      1024
+#define BENCHMARK_MAX_EVENTS        65536
+#define BENCHMARK_NODE_ADDRESS_BASE 0x0100
+#define BENCHMARK_NETKEY_NID        0x68
+#define BENCHMARK_IV_INDEX          0x12345678
+#define BENCHMARK_PAYLOAD_LEN       8
+
+// provided by mock.c
+int  mock_process_hci_cmd(void);
+void aes128_calc_cyphertext(uint8_t key[16], uint8_t plaintext[16], uint8_t cyphertext[16]);
+
+typedef enum {
+    BENCHMARK_TOPOLOGY_LINE,
+    BENCHMARK_TOPOLOGY_RING,
+    BENCHMARK_TOPOLOGY_GRID,
+    BENCHMARK_TOPOLOGY_FULL,
+} benchmark_topology_t;
+
+static const char * benchmark_topology_names[] = { "line", "ring", "grid", "full" };
+
+// single advertisement of a Network PDU
+typedef struct {
+    uint32_t time_ms;
+    // insertion order, keeps events with same time in FIFO order
+    uint32_t order;
+    uint16_t transmitter;
+    uint8_t  len;
+    uint8_t  data[29];
+} benchmark_event_t;
+
+typedef struct {
+    uint16_t src_node;
+    uint16_t dst_node;
+    uint32_t originated_ms;
+    uint8_t  delivered;
+} benchmark_message_t;
+
+// configuration
+static benchmark_topology_t topology = BENCHMARK_TOPOLOGY_GRID;
+static uint16_t num_nodes           = 16;
+static uint16_t num_messages        = 200;
+static uint16_t dut_node            = 5;
+static uint16_t message_period_ms   = 100;
+static uint8_t  initial_ttl         = 7;
+static uint8_t  transmit_count      = 2;
+static uint16_t transmit_interval_ms = 20;
+static uint16_t relay_jitter_ms     = 10;
+static uint8_t  loss_percent        = 0;
+static uint32_t lfsr_state          = 0x1234;
+
+// network key with NID 0x68 from Mesh Profile Sample Data
+static const uint8_t benchmark_encryption_key[] = {
+    0x09, 0x53, 0xfa, 0x93, 0xe7, 0xca, 0xac, 0x96, 0x38, 0xf5, 0x88, 0x20, 0x22, 0x0a, 0x39, 0x8e,
+};
+static const uint8_t benchmark_privacy_key[] = {
+    0x8b, 0x84, 0xee, 0xde, 0xc1, 0x00, 0x06, 0x7d, 0x67, 0x09, 0x71, 0xdd, 0x2a, 0xa7, 0x00, 0xcf,
+};
+static uint8_t privacy_key[16];
+static uint16_t grid_width;
+
+// simulation state
+static benchmark_message_t messages[BENCHMARK_MAX_MESSAGES];
+static uint8_t  virtual_node_seen[BENCHMARK_MAX_NODES][BENCHMARK_MAX_MESSAGES];
+static uint8_t  dut_offered[BENCHMARK_MAX_MESSAGES];
+static uint8_t  dut_forwarded[BENCHMARK_MAX_MESSAGES];
+
+static benchmark_event_t events[BENCHMARK_MAX_EVENTS];
+static uint32_t num_events;
+static uint32_t event_order;
+static uint32_t now_ms;
+
+static uint8_t * capture_data;
+static uint8_t   capture_len;
+static btstack_packet_handler_t adv_packet_handler;
+static btstack_packet_handler_t gatt_packet_handler;
+
+// results
+static uint32_t transmissions;
+static uint32_t transmissions_dut;
+static uint32_t receptions_lost;
+static uint32_t virtual_receptions;
+static uint32_t virtual_duplicates;
+static uint32_t dut_receptions;
+static uint32_t dut_duplicates_offered;
+static uint32_t dut_duplicates_forwarded;
+static uint32_t dut_forwarded_total;
+static uint32_t delivered;
+static uint32_t hops_total;
+static uint64_t dut_cpu_ns;
+static mesh_statistics_latency_t delivery_latency;
+
+// Xorshift32, deterministic for a given seed
+static uint32_t benchmark_random(void){
+    lfsr_state ^= lfsr_state << 13;
+    lfsr_state ^= lfsr_state >> 17;
+    lfsr_state ^= lfsr_state << 5;
+    return lfsr_state;
+}
+
+static uint64_t benchmark_cpu_time_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000u) + (uint64_t) ts.tv_nsec;
+}
+
+static uint16_t benchmark_node_address(uint16_t node){
+    return BENCHMARK_NODE_ADDRESS_BASE + node;
+}
+
+static int benchmark_nodes_in_range(uint16_t a, uint16_t b){
+    if (a == b) return 0;
+    switch (topology){
+        case BENCHMARK_TOPOLOGY_LINE:
+            return (a + 1 == b) || (b + 1 == a);
+        case BENCHMARK_TOPOLOGY_RING:
+            return (a + 1 == b) || (b + 1 == a) || ((a == 0) && (b == num_nodes - 1)) || ((b == 0) && (a == num_nodes - 1));
+        case BENCHMARK_TOPOLOGY_GRID:
+            if ((a / grid_width) == (b / grid_width)) {
+                return (a + 1 == b) || (b + 1 == a);
+            }
+            return (a + grid_width == b) || (b + grid_width == a);
+        case BENCHMARK_TOPOLOGY_FULL:
+        default:
+            return 1;
+    }
+}
+
+// event queue: binary min heap ordered by time and insertion order
+
+static int benchmark_event_before(const benchmark_event_t * a, const benchmark_event_t * b){
+    if (a->time_ms != b->time_ms) return a->time_ms < b->time_ms;
+    return a->order < b->order;
+}
+
+static void benchmark_event_swap(uint32_t i, uint32_t j){
+    benchmark_event_t tmp = events[i];
+    events[i] = events[j];
+    events[j] = tmp;
+}
+
+static void benchmark_schedule(uint32_t time_ms, uint16_t transmitter, const uint8_t * data, uint8_t len){
+    if (num_events == BENCHMARK_MAX_EVENTS){
+        fprintf(stderr, "Event queue full, reduce number of nodes or message rate\n");
+        exit(EXIT_FAILURE);
+    }
+    uint32_t i = num_events++;
+    events[i].time_ms = time_ms;
+    events[i].order = event_order++;
+    events[i].transmitter = transmitter;
+    events[i].len = len;
+    (void)memcpy(events[i].data, data, len);
+    while (i > 0){
+        uint32_t parent = (i - 1) / 2;
+        if (!benchmark_event_before(&events[i], &events[parent])) break;
+        benchmark_event_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void benchmark_pop(benchmark_event_t * event){
+    *event = events[0];
+    events[0] = events[--num_events];
+    uint32_t i = 0;
+    while (1){
+        uint32_t smallest = i;
+        uint32_t left  = 2 * i + 1;
+        uint32_t right = 2 * i + 2;
+        if ((left  < num_events) && benchmark_event_before(&events[left],  &events[smallest])) smallest = left;
+        if ((right < num_events) && benchmark_event_before(&events[right], &events[smallest])) smallest = right;
+        if (smallest == i) break;
+        benchmark_event_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+// schedule all advertisements for a single transmission, starting after processing delay
+static void benchmark_schedule_transmission(uint16_t transmitter, const uint8_t * data, uint8_t len, uint8_t count, uint16_t interval_ms){
+    uint32_t time_ms = now_ms + 1;
+    if (relay_jitter_ms > 0){
+        time_ms += benchmark_random() % relay_jitter_ms;
+    }
+    uint8_t i;
+    for (i = 0; i < count; i++){
+        benchmark_schedule(time_ms, transmitter, data, len);
+        // advertising events add up to 10 ms random delay
+        time_ms += interval_ms + (benchmark_random() % 10) + 1;
+    }
+}
+
+// PECB = e(PrivacyKey, 0x0000000000 || IV Index || Privacy Random)
+static void benchmark_pecb(const uint8_t * network_pdu, uint8_t * pecb){
+    uint8_t plaintext[16];
+    memset(plaintext, 0, 5);
+    big_endian_store_32(plaintext, 5, BENCHMARK_IV_INDEX);
+    (void)memcpy(&plaintext[9], &network_pdu[7], 7);
+    aes128_calc_cyphertext(privacy_key, plaintext, pecb);
+}
+
+// Network PDUs of simulated nodes are encrypted by the DUT network layer, SEQ = message index + 1
+// NetMIC covers the TTL, so relaying nodes have to encrypt the message again
+static uint8_t benchmark_encrypt(uint16_t message_index, uint8_t ttl, uint8_t * data){
+    benchmark_message_t * message = &messages[message_index];
+
+    // unsegmented access message, message index as payload
+    uint8_t transport_pdu[BENCHMARK_PAYLOAD_LEN];
+    memset(transport_pdu, 0, sizeof(transport_pdu));
+    big_endian_store_16(transport_pdu, 1, message_index);
+
+    mesh_network_pdu_t * network_pdu = mesh_network_pdu_get();
+    mesh_network_setup_pdu(network_pdu, 0, BENCHMARK_NETKEY_NID, 0, ttl, message_index + 1,
+                           benchmark_node_address(message->src_node), benchmark_node_address(message->dst_node),
+                           transport_pdu, sizeof(transport_pdu));
+    capture_data = data;
+    mesh_network_send_pdu(network_pdu);
+    while (mock_process_hci_cmd()){
+    }
+    return capture_len;
+}
+
+static void benchmark_deliver(uint16_t message_index, uint8_t ttl){
+    benchmark_message_t * message = &messages[message_index];
+    if (message->delivered) return;
+    message->delivered = 1;
+    delivered++;
+    hops_total += initial_ttl - ttl + 1;
+    mesh_statistics_latency_add(&delivery_latency, now_ms - message->originated_ms);
+}
+
+static void benchmark_virtual_node_receive(uint16_t node, const uint8_t * data){
+    virtual_receptions++;
+
+    // de-obfuscate CTL/TTL, SEQ, SRC
+    uint8_t pecb[16];
+    uint8_t header[6];
+    benchmark_pecb(data, pecb);
+    uint8_t i;
+    for (i = 0; i < 6; i++){
+        header[i] = data[1 + i] ^ pecb[i];
+    }
+    uint8_t  ttl = header[0] & 0x7f;
+    uint32_t seq = big_endian_read_24(header, 1);
+
+    // SEQ identifies message
+    uint16_t message_index = (uint16_t) (seq - 1);
+    if (virtual_node_seen[node][message_index]){
+        virtual_duplicates++;
+        return;
+    }
+    virtual_node_seen[node][message_index] = 1;
+
+    if (messages[message_index].dst_node == node){
+        benchmark_deliver(message_index, ttl);
+        return;
+    }
+
+    if (ttl < 2) return;
+
+    // relay with decremented TTL
+    uint8_t relayed[29];
+    uint8_t relayed_len = benchmark_encrypt(message_index, ttl - 1, relayed);
+    benchmark_schedule_transmission(node, relayed, relayed_len, transmit_count, transmit_interval_ms);
+}
+
+static void benchmark_dut_receive(const uint8_t * data, uint8_t len){
+    dut_receptions++;
+
+    uint8_t pecb[16];
+    benchmark_pecb(data, pecb);
+    uint32_t seq = big_endian_read_24(data, 2) ^ big_endian_read_24(pecb, 1);
+    uint16_t message_index = (uint16_t) (seq - 1);
+    if (dut_offered[message_index]){
+        dut_duplicates_offered++;
+    }
+    dut_offered[message_index] = 1;
+
+    uint64_t start_ns = benchmark_cpu_time_ns();
+    (*adv_packet_handler)(MESH_NETWORK_PACKET, 0, (uint8_t *) data, len);
+    while (mock_process_hci_cmd()){
+    }
+    dut_cpu_ns += benchmark_cpu_time_ns() - start_ns;
+}
+
+// mocked bearers
+
+void adv_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    adv_packet_handler = packet_handler;
+}
+
+void adv_bearer_request_can_send_now_for_network_pdu(void){
+    uint8_t event[3];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_CAN_SEND_NOW;
+    (*adv_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+
+void adv_bearer_send_network_pdu(const uint8_t * network_pdu, uint16_t size, uint8_t count, uint16_t interval){
+    if (capture_data != NULL){
+        (void)memcpy(capture_data, network_pdu, size);
+        capture_len = (uint8_t) size;
+        capture_data = NULL;
+        return;
+    }
+    benchmark_schedule_transmission(dut_node, network_pdu, (uint8_t) size, count, interval);
+}
+
+void gatt_bearer_register_for_network_pdu(btstack_packet_handler_t packet_handler){
+    gatt_packet_handler = packet_handler;
+}
+
+void gatt_bearer_register_for_mesh_proxy_configuration(btstack_packet_handler_t packet_handler){
+    UNUSED(packet_handler);
+}
+
+void gatt_bearer_request_can_send_now_for_network_pdu(hci_con_handle_t con_handle){
+    uint8_t event[5];
+    event[0] = HCI_EVENT_MESH_META;
+    event[1] = 1;
+    event[2] = MESH_SUBEVENT_CAN_SEND_NOW;
+    little_endian_store_16(event, 3, con_handle);
+    (*gatt_packet_handler)(HCI_EVENT_PACKET, 0, &event[0], sizeof(event));
+}
+
+void gatt_bearer_send_network_pdu(hci_con_handle_t con_handle, const uint8_t * network_pdu, uint16_t size){
+    UNUSED(con_handle);
+    UNUSED(network_pdu);
+    UNUSED(size);
+}
+
+// DUT network layer
+
+static void benchmark_network_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    uint16_t message_index;
+    switch (callback_type){
+        case MESH_NETWORK_PDU_RECEIVED:
+            dut_forwarded_total++;
+            message_index = (uint16_t) (mesh_network_seq(network_pdu) - 1);
+            if (dut_forwarded[message_index]){
+                dut_duplicates_forwarded++;
+            }
+            dut_forwarded[message_index] = 1;
+            if (messages[message_index].dst_node == dut_node){
+                benchmark_deliver(message_index, mesh_network_ttl(network_pdu));
+            }
+            // relays message if needed
+            mesh_network_message_processed_by_higher_layer(network_pdu);
+            break;
+        case MESH_NETWORK_PDU_SENT:
+            mesh_network_pdu_free(network_pdu);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_proxy_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    UNUSED(callback_type);
+    mesh_network_message_processed_by_higher_layer(network_pdu);
+}
+
+static void benchmark_setup_dut(void){
+    btstack_memory_init();
+    btstack_crypto_init();
+    mesh_network_init();
+    mesh_network_set_higher_layer_handler(&benchmark_network_handler);
+    mesh_network_set_proxy_message_handler(&benchmark_proxy_handler);
+
+    mesh_network_key_init();
+    mesh_network_key_t * network_key = btstack_memory_mesh_network_key_get();
+    network_key->nid = BENCHMARK_NETKEY_NID;
+    (void)memcpy(network_key->encryption_key, benchmark_encryption_key, 16);
+    (void)memcpy(network_key->privacy_key, benchmark_privacy_key, 16);
+    (void)memcpy(privacy_key, network_key->privacy_key, 16);
+    mesh_network_key_add(network_key);
+    mesh_subnet_setup_for_netkey_index(network_key->netkey_index);
+
+    mesh_set_iv_index(BENCHMARK_IV_INDEX);
+    mesh_node_primary_element_address_set(benchmark_node_address(dut_node));
+    mesh_foundation_relay_set(1);
+    mesh_foundation_gatt_proxy_set(0);
+}
+
+static void benchmark_generate_messages(void){
+    uint16_t i;
+    for (i = 0; i < num_messages; i++){
+        benchmark_message_t * message = &messages[i];
+        message->src_node = benchmark_random() % num_nodes;
+        message->dst_node = (message->src_node + 1 + (benchmark_random() % (num_nodes - 1))) % num_nodes;
+        message->originated_ms = i * message_period_ms;
+    }
+}
+
+static void benchmark_originate(uint16_t message_index){
+    benchmark_message_t * message = &messages[message_index];
+    if (message->src_node == dut_node){
+        dut_offered[message_index] = 1;
+    } else {
+        virtual_node_seen[message->src_node][message_index] = 1;
+    }
+    uint8_t data[29];
+    uint8_t len = benchmark_encrypt(message_index, initial_ttl, data);
+    benchmark_schedule_transmission(message->src_node, data, len, transmit_count, transmit_interval_ms);
+}
+
+static void benchmark_transmit(const benchmark_event_t * event){
+    transmissions++;
+    if (event->transmitter == dut_node){
+        transmissions_dut++;
+    }
+    uint16_t node;
+    for (node = 0; node < num_nodes; node++){
+        if (!benchmark_nodes_in_range(event->transmitter, node)) continue;
+        if ((loss_percent > 0) && ((benchmark_random() % 100) < loss_percent)){
+            receptions_lost++;
+            continue;
+        }
+        if (node == dut_node){
+            benchmark_dut_receive(event->data, event->len);
+        } else {
+            benchmark_virtual_node_receive(node, event->data);
+        }
+    }
+}
+
+static void benchmark_run(void){
+    uint16_t next_message = 0;
+    benchmark_event_t event;
+    while ((next_message < num_messages) || (num_events > 0)){
+        if ((next_message < num_messages) && ((num_events == 0) || (messages[next_message].originated_ms <= events[0].time_ms))){
+            now_ms = messages[next_message].originated_ms;
+            benchmark_originate(next_message++);
+            continue;
+        }
+        benchmark_pop(&event);
+        now_ms = event.time_ms;
+        benchmark_transmit(&event);
+    }
+}
+
+static double benchmark_percent(uint32_t part, uint32_t total){
+    if (total == 0) return 0.0;
+    return (100.0 * part) / total;
+}
+
+static void benchmark_report(void){
+    const mesh_network_pdu_stats_t * pdu_stats = mesh_network_pdu_get_stats();
+
+    printf("Topology %s, %u nodes, DUT node %u, %u messages every %u ms, TTL %u\n",
+           benchmark_topology_names[topology], num_nodes, dut_node, num_messages, message_period_ms, initial_ttl);
+    printf("Transmit %u x %u ms, relay jitter %u ms, loss %u %%, seed %u\n",
+           transmit_count, transmit_interval_ms, relay_jitter_ms, loss_percent, lfsr_state);
+    printf("\n");
+    printf("Delivered:          %u / %u (%.1f %%)\n", delivered, num_messages, benchmark_percent(delivered, num_messages));
+    if (delivered > 0){
+        printf("Latency:            avg %u ms, max %u ms, avg %.2f hops\n",
+               delivery_latency.total_ms / delivery_latency.count, delivery_latency.max_ms, (double) hops_total / delivered);
+    }
+    printf("Transmissions:      %u (DUT %u), amplification %.2f per message\n",
+           transmissions, transmissions_dut, num_messages ? (double) transmissions / num_messages : 0.0);
+    printf("Receptions lost:    %u\n", receptions_lost);
+    printf("Virtual nodes:      %u received, %u duplicates (%.1f %%)\n",
+           virtual_receptions, virtual_duplicates, benchmark_percent(virtual_duplicates, virtual_receptions));
+    printf("DUT received:       %u, %u duplicates, %u forwarded to lower transport\n",
+           dut_receptions, dut_duplicates_offered, dut_forwarded_total);
+    printf("DUT network cache:  %u of %u duplicates dropped (%.1f %%)\n",
+           dut_duplicates_offered - dut_duplicates_forwarded, dut_duplicates_offered,
+           benchmark_percent(dut_duplicates_offered - dut_duplicates_forwarded, dut_duplicates_offered));
+    printf("DUT buffer drops:   %u relay (quota), %u receive (no buffer)\n",
+           pdu_stats->relay_dropped, pdu_stats->alloc_failed[MESH_NETWORK_PDU_PURPOSE_RX]);
+    if (dut_receptions > 0){
+        printf("DUT CPU:            %.2f us per received network pdu\n", (double) dut_cpu_ns / 1000.0 / dut_receptions);
+    }
+}
+
+static void benchmark_usage(const char * name){
+    printf("Usage: %s [options]\n", name);
+    printf("  --topology line|ring|grid|full  default grid\n");
+    printf("  --nodes N                       number of nodes, max %u, default 16\n", BENCHMARK_MAX_NODES);
+    printf("  --dut N                         node index of device under test, default 5\n");
+    printf("  --messages N                    number of messages, max %u, default 200\n", BENCHMARK_MAX_MESSAGES);
+    printf("  --period MS                     time between messages, default 100\n");
+    printf("  --ttl N                         initial TTL, default 7\n");
+    printf("  --count N                       transmissions per network pdu of simulated nodes, default 2\n");
+    printf("  --interval MS                   interval between transmissions, default 20\n");
+    printf("  --jitter MS                     max random relay delay, default 10\n");
+    printf("  --loss PERCENT                  reception loss, default 0\n");
+    printf("  --seed N                        random seed, default 4660\n");
+}
+
+int main(int argc, const char * argv[]){
+    int i;
+    for (i = 1; i < argc; i++){
+        const char * arg = argv[i];
+        if ((i + 1) >= argc){
+            benchmark_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        const char * value = argv[++i];
+        if (strcmp(arg, "--topology") == 0){
+            int t;
+            for (t = 0; t <= (int) BENCHMARK_TOPOLOGY_FULL; t++){
+                if (strcmp(value, benchmark_topology_names[t]) == 0) break;
+            }
+            if (t > (int) BENCHMARK_TOPOLOGY_FULL){
+                benchmark_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            topology = (benchmark_topology_t) t;
+        } else if (strcmp(arg, "--nodes") == 0){
+            num_nodes = (uint16_t) atoi(value);
+        } else if (strcmp(arg, "--dut") == 0){
+            dut_node = (uint16_t) atoi(value);
+        } else if (strcmp(arg, "--messages") == 0){
+            num_messages = (uint16_t) atoi(value);
+        } else if (strcmp(arg, "--period") == 0){
+            message_period_ms = (uint16_t) atoi(value);
+        } else if (strcmp(arg, "--ttl") == 0){
+            initial_ttl = (uint8_t) atoi(value);
+        } else if (strcmp(arg, "--count") == 0){
+            transmit_count = (uint8_t) atoi(value);
+        } else if (strcmp(arg, "--interval") == 0){
+            transmit_interval_ms = (uint16_t) atoi(value);
+        } else if (strcmp(arg, "--jitter") == 0){
+            relay_jitter_ms = (uint16_t) atoi(value);
+        } else if (strcmp(arg, "--loss") == 0){
+            loss_percent = (uint8_t) atoi(value);
+        } else if (strcmp(arg, "--seed") == 0){
+            lfsr_state = (uint32_t) strtoul(value, NULL, 0);
+        } else {
+            benchmark_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((num_nodes < 2) || (num_nodes > BENCHMARK_MAX_NODES) || (dut_node >= num_nodes) ||
+        (num_messages > BENCHMARK_MAX_MESSAGES) || (initial_ttl > 127) || (lfsr_state == 0) || (loss_percent > 100)){
+        benchmark_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    grid_width = 1;
+    while ((grid_width * grid_width) < num_nodes){
+        grid_width++;
+    }
+    uint32_t seed = lfsr_state;
+
+    benchmark_setup_dut();
+    benchmark_generate_messages();
+    benchmark_run();
+
+    lfsr_state = seed;
+    benchmark_report();
+    return EXIT_SUCCESS;
+}
@@ -111,17 +111,22 @@ int hci_can_send_command_packet_now(void){
 	return 1;
 }
 
-int hci_send_cmd(const hci_cmd_t *cmd, ...){
-    va_list argptr;
-    va_start(argptr, cmd);
-    uint16_t len = hci_cmd_create_from_template(packet_buffer, cmd, argptr);
-    va_end(argptr);
+int hci_reserve_packet_buffer(void){
+	return 1;
+}
+
+uint8_t * hci_get_outgoing_packet_buffer(void){
+	return packet_buffer;
+}
+
+int hci_send_prepared_cmd_packet(uint16_t len){
+	uint16_t opcode = little_endian_read_16(packet_buffer, 0);
 	hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet_buffer, len);
 	dump_packet(HCI_COMMAND_DATA_PACKET, packet_buffer, len);
 	packet_buffer_len = len;
 
 	// track le encrypt and le rand
-	if (cmd->opcode ==  hci_le_encrypt.opcode){
+	if (opcode ==  hci_le_encrypt.opcode){
 	    uint8_t * key_flipped = &packet_buffer[3];
 	    uint8_t key[16];
 		reverse_128(key_flipped, key);
@@ -137,12 +142,20 @@ int hci_send_cmd(const hci_cmd_t *cmd, ...){
 	    printf("Cipher: "); printf_hexdump(aes128_cyphertext, 16);
 #endif
 	}
-	if (cmd->opcode == hci_le_rand.opcode){
+	if (opcode == hci_le_rand.opcode){
 		report_random = 1;
 	}
 	return 0;
 }
 
+int hci_send_cmd(const hci_cmd_t *cmd, ...){
+    va_list argptr;
+    va_start(argptr, cmd);
+    uint16_t len = hci_cmd_create_from_template(packet_buffer, cmd, argptr);
+    va_end(argptr);
+	return hci_send_prepared_cmd_packet(len);
+}
+
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
     btstack_linked_list_add_tail(&event_packet_handlers, (btstack_linked_item_t*) callback_handler);
 }
@@ -42,6 +42,7 @@
 #include "ble/gatt-service/mesh_provisioning_service_server.h"
 #include "hci_dump.h"
 #include "mesh/mesh_node.h"
+#include "mesh/mesh_virtual_addresses.h"
 #include "mesh/pb_adv.h"
 #include "mesh/pb_gatt.h"
 #include "mesh/provisioning.h"
@@ -149,6 +150,20 @@ extern "C" mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     return &network_key;
 }
 
+// used by mesh_node subscription filter
+void mesh_virtual_address_iterator_init(mesh_virtual_address_iterator_t * it, uint16_t hash){
+    UNUSED(it);
+    UNUSED(hash);
+}
+int mesh_virtual_address_iterator_has_more(mesh_virtual_address_iterator_t * it){
+    UNUSED(it);
+    return 0;
+}
+const mesh_virtual_address_t * mesh_virtual_address_iterator_get_next(mesh_virtual_address_iterator_t * it){
+    UNUSED(it);
+    return NULL;
+}
+
 static void perform_crypto_operations(void){
     int more = 1;
     while (more){
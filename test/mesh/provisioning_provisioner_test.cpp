@@ -103,12 +103,12 @@ static void pb_adv_emit_link_open(uint8_t status, uint16_t pb_adv_cid){
     uint8_t event[7] = { HCI_EVENT_MESH_META, 5, MESH_SUBEVENT_PB_TRANSPORT_LINK_OPEN, status};
     little_endian_store_16(event, 4, pb_adv_cid);
     event[6] = MESH_PB_TYPE_ADV;
-    pb_adv_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    pb_adv_packet_handler(HCI_EVENT_PACKET, pb_adv_cid, event, sizeof(event));
 }
 
 static void pb_adv_emit_pdu_sent(uint8_t status){
     uint8_t event[] = { HCI_EVENT_MESH_META, 2, MESH_SUBEVENT_PB_TRANSPORT_PDU_SENT, status};
-    pb_adv_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    pb_adv_packet_handler(HCI_EVENT_PACKET, 1, event, sizeof(event));
 }
 
 void pb_adv_init(void){}
@@ -148,7 +148,7 @@ static void perform_crypto_operations(void){
 }
 
 static void send_prov_pdu(const uint8_t * packet, uint16_t size){
-    pb_adv_packet_handler(PROVISIONING_DATA_PACKET, 0, (uint8_t*) packet, size);
+    pb_adv_packet_handler(PROVISIONING_DATA_PACKET, 1, (uint8_t*) packet, size);
     perform_crypto_operations();
 }
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "mock_btstack_run_loop.c"
+
+#include "mock_btstack_run_loop.h"
+
+#include <stddef.h>
+
+#include "btstack_run_loop_base.h"
+
+static uint32_t mock_btstack_run_loop_time_ms;
+static uint32_t mock_btstack_run_loop_num_callbacks;
+
+static void mock_btstack_run_loop_run_loop_init(void){
+    btstack_run_loop_base_init();
+    mock_btstack_run_loop_time_ms = 0;
+    mock_btstack_run_loop_num_callbacks = 0;
+}
+
+static void mock_btstack_run_loop_set_timer(btstack_timer_source_t * ts, uint32_t timeout_in_ms){
+    ts->timeout = mock_btstack_run_loop_time_ms + timeout_in_ms;
+}
+
+static uint32_t mock_btstack_run_loop_get_time_ms(void){
+    return mock_btstack_run_loop_time_ms;
+}
+
+static void mock_btstack_run_loop_execute(void){
+    mock_btstack_run_loop_process();
+}
+
+static void mock_btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    btstack_run_loop_base_add_callback(callback_registration);
+}
+
+static const btstack_run_loop_t mock_btstack_run_loop = {
+    &mock_btstack_run_loop_run_loop_init,
+    &btstack_run_loop_base_add_data_source,
+    &btstack_run_loop_base_remove_data_source,
+    &btstack_run_loop_base_enable_data_source_callbacks,
+    &btstack_run_loop_base_disable_data_source_callbacks,
+    &mock_btstack_run_loop_set_timer,
+    &btstack_run_loop_base_add_timer,
+    &btstack_run_loop_base_remove_timer,
+    &mock_btstack_run_loop_execute,
+    &btstack_run_loop_base_dump_timer,
+    &mock_btstack_run_loop_get_time_ms,
+    &mock_btstack_run_loop_execute_on_main_thread,
+};
+
+const btstack_run_loop_t * mock_btstack_run_loop_get_instance(void){
+    return &mock_btstack_run_loop;
+}
+
+void mock_btstack_run_loop_init(void){
+    static bool run_loop_initialized = false;
+    if (run_loop_initialized){
+        // run loop can only be initialized once, drop all timers and callbacks instead
+        mock_btstack_run_loop_run_loop_init();
+        return;
+    }
+    run_loop_initialized = true;
+    btstack_run_loop_init(&mock_btstack_run_loop);
+}
+
+void mock_btstack_run_loop_process(void){
+    while (true){
+        btstack_context_callback_registration_t * callback_registration = btstack_run_loop_base_get_next_callback();
+        if (callback_registration == NULL) break;
+        mock_btstack_run_loop_num_callbacks++;
+        btstack_run_loop_base_execute_callback(callback_registration);
+    }
+    btstack_run_loop_base_process_timers(mock_btstack_run_loop_time_ms);
+}
+
+void mock_btstack_run_loop_advance_time_ms(uint32_t time_ms){
+    // process timers in order of their timeout
+    uint32_t end_ms = mock_btstack_run_loop_time_ms + time_ms;
+    mock_btstack_run_loop_process();
+    while (true){
+        int32_t timeout_ms = btstack_run_loop_base_get_time_until_timeout(mock_btstack_run_loop_time_ms);
+        if ((timeout_ms < 0) || ((int32_t)(end_ms - mock_btstack_run_loop_time_ms) < timeout_ms)) break;
+        mock_btstack_run_loop_time_ms += (uint32_t) timeout_ms;
+        mock_btstack_run_loop_process();
+    }
+    mock_btstack_run_loop_time_ms = end_ms;
+    mock_btstack_run_loop_process();
+}
+
+uint32_t mock_btstack_run_loop_get_num_callbacks_executed(void){
+    return mock_btstack_run_loop_num_callbacks;
+}
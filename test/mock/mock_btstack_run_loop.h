@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  mock_btstack_run_loop.h
+ *
+ *  Run loop for unit tests with simulated time
+ */
+
+#ifndef MOCK_BTSTACK_RUN_LOOP_H
+#define MOCK_BTSTACK_RUN_LOOP_H
+
+#include "btstack_run_loop.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get run loop instance, time starts at 0 ms
+ */
+const btstack_run_loop_t * mock_btstack_run_loop_get_instance(void);
+
+/**
+ * @brief Init run loop with mock instance on first call, reset time, timers and callbacks on further calls
+ */
+void mock_btstack_run_loop_init(void);
+
+/**
+ * @brief Execute callbacks registered via btstack_run_loop_execute_on_main_thread and expired timers
+ */
+void mock_btstack_run_loop_process(void);
+
+/**
+ * @brief Advance simulated time, expired timers and pending callbacks are executed
+ * @param time_ms
+ */
+void mock_btstack_run_loop_advance_time_ms(uint32_t time_ms);
+
+/**
+ * @brief Get number of callbacks executed since mock_btstack_run_loop_init
+ */
+uint32_t mock_btstack_run_loop_get_num_callbacks_executed(void);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // MOCK_BTSTACK_RUN_LOOP_H
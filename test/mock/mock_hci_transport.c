@@ -0,0 +1,626 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "mock_hci_transport.c"
+
+/*
+ *  mock_hci_transport.c
+ */
+
+#include <string.h>
+
+#include "mock_hci_transport.h"
+#include "mock_btstack_run_loop.h"
+
+#include "bluetooth.h"
+#include "btstack_debug.h"
+#include "btstack_util.h"
+#include "hci_cmd.h"
+
+#define MOCK_HCI_TRANSPORT_MAX_RX_PACKETS 64
+
+#define OPCODE_OGF(opcode) ((opcode) >> 10)
+
+#define MOCK_OPCODE(ogf, ocf) ((uint16_t)((ocf) | ((ogf) << 10)))
+#define MOCK_OPCODE_READ_LOCAL_NAME                          MOCK_OPCODE(OGF_CONTROLLER_BASEBAND, 0x14)
+#define MOCK_OPCODE_READ_LOCAL_SUPPORTED_COMMANDS            MOCK_OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x02)
+#define MOCK_OPCODE_READ_LOCAL_SUPPORTED_FEATURES            MOCK_OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x03)
+#define MOCK_OPCODE_READ_BD_ADDR                             MOCK_OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x09)
+#define MOCK_OPCODE_READ_BUFFER_SIZE                         MOCK_OPCODE(OGF_INFORMATIONAL_PARAMETERS, 0x05)
+#define MOCK_OPCODE_LE_READ_BUFFER_SIZE                      MOCK_OPCODE(OGF_LE_CONTROLLER, 0x02)
+#define MOCK_OPCODE_LE_READ_BUFFER_SIZE_V2                   MOCK_OPCODE(OGF_LE_CONTROLLER, 0x60)
+#define MOCK_OPCODE_LE_READ_LOCAL_SUPPORTED_FEATURES         MOCK_OPCODE(OGF_LE_CONTROLLER, 0x03)
+#define MOCK_OPCODE_LE_READ_WHITE_LIST_SIZE                  MOCK_OPCODE(OGF_LE_CONTROLLER, 0x0f)
+#define MOCK_OPCODE_LE_READ_RESOLVING_LIST_SIZE              MOCK_OPCODE(OGF_LE_CONTROLLER, 0x2a)
+#define MOCK_OPCODE_ACCEPT_CONNECTION_REQUEST                MOCK_OPCODE(OGF_LINK_CONTROL, 0x09)
+#define MOCK_OPCODE_CREATE_CONNECTION                        MOCK_OPCODE(OGF_LINK_CONTROL, 0x05)
+#define MOCK_OPCODE_DISCONNECT                               MOCK_OPCODE(OGF_LINK_CONTROL, 0x06)
+#define MOCK_OPCODE_READ_REMOTE_SUPPORTED_FEATURES_COMMAND   MOCK_OPCODE(OGF_LINK_CONTROL, 0x1b)
+#define MOCK_OPCODE_READ_REMOTE_EXTENDED_FEATURES_COMMAND    MOCK_OPCODE(OGF_LINK_CONTROL, 0x1c)
+#define MOCK_OPCODE_INQUIRY_CANCEL                           MOCK_OPCODE(OGF_LINK_CONTROL, 0x02)
+#define MOCK_OPCODE_CREATE_CONNECTION_CANCEL                 MOCK_OPCODE(OGF_LINK_CONTROL, 0x08)
+#define MOCK_OPCODE_LINK_KEY_REQUEST_REPLY                   MOCK_OPCODE(OGF_LINK_CONTROL, 0x0b)
+#define MOCK_OPCODE_LINK_KEY_REQUEST_NEGATIVE_REPLY          MOCK_OPCODE(OGF_LINK_CONTROL, 0x0c)
+#define MOCK_OPCODE_PIN_CODE_REQUEST_REPLY                   MOCK_OPCODE(OGF_LINK_CONTROL, 0x0d)
+#define MOCK_OPCODE_PIN_CODE_REQUEST_NEGATIVE_REPLY          MOCK_OPCODE(OGF_LINK_CONTROL, 0x0e)
+#define MOCK_OPCODE_REMOTE_NAME_REQUEST_CANCEL               MOCK_OPCODE(OGF_LINK_CONTROL, 0x1a)
+#define MOCK_OPCODE_IO_CAPABILITY_REQUEST_REPLY              MOCK_OPCODE(OGF_LINK_CONTROL, 0x2b)
+#define MOCK_OPCODE_USER_CONFIRMATION_REQUEST_REPLY          MOCK_OPCODE(OGF_LINK_CONTROL, 0x2c)
+#define MOCK_OPCODE_USER_CONFIRMATION_REQUEST_NEGATIVE_REPLY MOCK_OPCODE(OGF_LINK_CONTROL, 0x2d)
+#define MOCK_OPCODE_USER_PASSKEY_REQUEST_REPLY               MOCK_OPCODE(OGF_LINK_CONTROL, 0x2e)
+#define MOCK_OPCODE_USER_PASSKEY_REQUEST_NEGATIVE_REPLY      MOCK_OPCODE(OGF_LINK_CONTROL, 0x2f)
+#define MOCK_OPCODE_IO_CAPABILITY_REQUEST_NEGATIVE_REPLY     MOCK_OPCODE(OGF_LINK_CONTROL, 0x34)
+#define MOCK_OPCODE_LE_CREATE_CONNECTION                     MOCK_OPCODE(OGF_LE_CONTROLLER, 0x0d)
+#define MOCK_OPCODE_LE_CONNECTION_UPDATE                     MOCK_OPCODE(OGF_LE_CONTROLLER, 0x13)
+#define MOCK_OPCODE_LE_READ_REMOTE_USED_FEATURES             MOCK_OPCODE(OGF_LE_CONTROLLER, 0x16)
+#define MOCK_OPCODE_LE_START_ENCRYPTION                      MOCK_OPCODE(OGF_LE_CONTROLLER, 0x19)
+#define MOCK_OPCODE_LE_READ_LOCAL_P256_PUBLIC_KEY            MOCK_OPCODE(OGF_LE_CONTROLLER, 0x25)
+#define MOCK_OPCODE_LE_GENERATE_DHKEY                        MOCK_OPCODE(OGF_LE_CONTROLLER, 0x26)
+#define MOCK_OPCODE_LE_SET_PHY                               MOCK_OPCODE(OGF_LE_CONTROLLER, 0x32)
+#define MOCK_OPCODE_LE_EXTENDED_CREATE_CONNECTION            MOCK_OPCODE(OGF_LE_CONTROLLER, 0x43)
+#define MOCK_OPCODE_LE_CREATE_CIS                            MOCK_OPCODE(OGF_LE_CONTROLLER, 0x64)
+#define MOCK_OPCODE_LE_ACCEPT_CIS_REQUEST                    MOCK_OPCODE(OGF_LE_CONTROLLER, 0x66)
+#define MOCK_OPCODE_LE_CREATE_BIG                            MOCK_OPCODE(OGF_LE_CONTROLLER, 0x68)
+#define MOCK_OPCODE_LE_TERMINATE_BIG                         MOCK_OPCODE(OGF_LE_CONTROLLER, 0x6a)
+#define MOCK_OPCODE_LE_BIG_CREATE_SYNC                       MOCK_OPCODE(OGF_LE_CONTROLLER, 0x6b)
+#define MOCK_OPCODE_LE_SETUP_ISO_DATA_PATH                   MOCK_OPCODE(OGF_LE_CONTROLLER, 0x6e)
+
+static void (*mock_hci_transport_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+static void (*mock_hci_transport_packet_callback)(const mock_hci_transport_packet_t * packet);
+
+// packets sent by stack
+static mock_hci_transport_packet_t mock_hci_transport_tx_packets[MOCK_HCI_TRANSPORT_MAX_PACKETS];
+static uint16_t mock_hci_transport_tx_count;
+
+// packets queued for stack
+static mock_hci_transport_packet_t mock_hci_transport_rx_packets[MOCK_HCI_TRANSPORT_MAX_RX_PACKETS];
+static uint16_t mock_hci_transport_rx_read_pos;
+static uint16_t mock_hci_transport_rx_count;
+
+// controller config
+static bool     mock_hci_transport_auto_respond;
+static bool     mock_hci_transport_auto_complete;
+static uint16_t mock_hci_transport_acl_data_packet_length;
+static uint16_t mock_hci_transport_num_acl_packets;
+static uint16_t mock_hci_transport_le_data_packet_length;
+static uint8_t  mock_hci_transport_num_le_packets;
+static uint16_t mock_hci_transport_iso_data_packet_length;
+static uint8_t  mock_hci_transport_num_iso_packets;
+static uint8_t  mock_hci_transport_supported_commands[64];
+static uint8_t  mock_hci_transport_supported_features[8];
+static uint8_t  mock_hci_transport_le_supported_features[8];
+
+// transport busy until HCI_EVENT_TRANSPORT_PACKET_SENT was delivered
+static bool     mock_hci_transport_packet_sent_pending;
+
+// connections
+static hci_con_handle_t mock_hci_transport_next_con_handle;
+static hci_con_handle_t mock_hci_transport_incoming_con_handle;
+
+static void mock_hci_transport_queue_packet(uint8_t packet_type, const uint8_t * packet, uint16_t size){
+    btstack_assert(mock_hci_transport_rx_count < MOCK_HCI_TRANSPORT_MAX_RX_PACKETS);
+    btstack_assert(size <= MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE);
+    uint16_t pos = (mock_hci_transport_rx_read_pos + mock_hci_transport_rx_count) % MOCK_HCI_TRANSPORT_MAX_RX_PACKETS;
+    mock_hci_transport_packet_t * rx_packet = &mock_hci_transport_rx_packets[pos];
+    rx_packet->type = packet_type;
+    rx_packet->size = size;
+    (void)memcpy(rx_packet->buffer, packet, size);
+    mock_hci_transport_rx_count++;
+}
+
+static void mock_hci_transport_respond_to_command(const uint8_t * packet){
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    const uint8_t * params = &packet[3];
+    uint8_t  return_params[250];
+    uint8_t  return_params_len = 64;
+    uint8_t  event[20];
+    uint16_t con_handle;
+
+    memset(return_params, 0, sizeof(return_params));
+
+    switch (opcode){
+        // Command Complete with return parameters
+        case MOCK_OPCODE_READ_LOCAL_NAME:
+            return_params_len = 248;
+            break;
+        case MOCK_OPCODE_READ_LOCAL_SUPPORTED_COMMANDS:
+            (void)memcpy(return_params, mock_hci_transport_supported_commands, 64);
+            break;
+        case MOCK_OPCODE_READ_LOCAL_SUPPORTED_FEATURES:
+            (void)memcpy(return_params, mock_hci_transport_supported_features, 8);
+            break;
+        case MOCK_OPCODE_READ_BD_ADDR:
+            return_params[0] = 0x01;
+            return_params[1] = 0x00;
+            return_params[2] = 0x33;
+            return_params[3] = 0x44;
+            return_params[4] = 0x55;
+            return_params[5] = 0x66;
+            break;
+        case MOCK_OPCODE_READ_BUFFER_SIZE:
+            little_endian_store_16(return_params, 0, mock_hci_transport_acl_data_packet_length);
+            return_params[2] = 60;
+            little_endian_store_16(return_params, 3, mock_hci_transport_num_acl_packets);
+            little_endian_store_16(return_params, 5, 4);
+            break;
+        case MOCK_OPCODE_LE_READ_BUFFER_SIZE:
+            little_endian_store_16(return_params, 0, mock_hci_transport_le_data_packet_length);
+            return_params[2] = mock_hci_transport_num_le_packets;
+            break;
+        case MOCK_OPCODE_LE_READ_BUFFER_SIZE_V2:
+            little_endian_store_16(return_params, 0, mock_hci_transport_le_data_packet_length);
+            return_params[2] = mock_hci_transport_num_le_packets;
+            little_endian_store_16(return_params, 3, mock_hci_transport_iso_data_packet_length);
+            return_params[5] = mock_hci_transport_num_iso_packets;
+            break;
+        case MOCK_OPCODE_LE_SETUP_ISO_DATA_PATH:
+            little_endian_store_16(return_params, 0, little_endian_read_16(params, 0));
+            return_params_len = 2;
+            break;
+        case MOCK_OPCODE_LE_READ_LOCAL_SUPPORTED_FEATURES:
+            (void)memcpy(return_params, mock_hci_transport_le_supported_features, 8);
+            break;
+        case MOCK_OPCODE_LE_READ_WHITE_LIST_SIZE:
+        case MOCK_OPCODE_LE_READ_RESOLVING_LIST_SIZE:
+            return_params[0] = 8;
+            break;
+
+        // Command Status and follow up events
+        case MOCK_OPCODE_ACCEPT_CONNECTION_REQUEST:
+            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+            event[0] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 1, mock_hci_transport_incoming_con_handle);
+            (void)memcpy(&event[3], params, 6);
+            event[9]  = 0x01;  // ACL
+            event[10] = 0x00;  // no encryption
+            mock_hci_transport_receive_event(HCI_EVENT_CONNECTION_COMPLETE, event, 11);
+            return;
+        case MOCK_OPCODE_CREATE_CONNECTION:
+            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+            event[0] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 1, mock_hci_transport_next_con_handle++);
+            (void)memcpy(&event[3], params, 6);
+            event[9]  = 0x01;  // ACL
+            event[10] = 0x00;  // no encryption
+            mock_hci_transport_receive_event(HCI_EVENT_CONNECTION_COMPLETE, event, 11);
+            return;
+        case MOCK_OPCODE_DISCONNECT:
+            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+            event[0] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, 1, little_endian_read_16(params, 0));
+            event[3] = ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST;
+            mock_hci_transport_receive_event(HCI_EVENT_DISCONNECTION_COMPLETE, event, 4);
+            return;
+        case MOCK_OPCODE_READ_REMOTE_SUPPORTED_FEATURES_COMMAND:
+            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+            memset(event, 0, sizeof(event));
+            little_endian_store_16(event, 1, little_endian_read_16(params, 0));
+            mock_hci_transport_receive_event(HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE, event, 11);
+            return;
+        case MOCK_OPCODE_READ_REMOTE_EXTENDED_FEATURES_COMMAND:
+            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+            memset(event, 0, sizeof(event));
+            con_handle = little_endian_read_16(params, 0);
+            little_endian_store_16(event, 1, con_handle);
+            event[3] = params[2];
+            event[4] = params[2];
+            mock_hci_transport_receive_event(HCI_EVENT_READ_REMOTE_EXTENDED_FEATURES_COMPLETE, event, 13);
+            return;
+        default:
+            switch (OPCODE_OGF(opcode)){
+                case OGF_LINK_POLICY:
+                    switch (opcode & 0x3ff){
+                        case 0x01:  // Hold Mode
+                        case 0x03:  // Sniff Mode
+                        case 0x04:  // Exit Sniff Mode
+                        case 0x07:  // QoS Setup
+                        case 0x0b:  // Switch Role
+                        case 0x10:  // Flow Specification
+                            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+                            return;
+                        default:
+                            break;
+                    }
+                    break;
+                case OGF_LINK_CONTROL:
+                    // most Link Control commands are acknowledged by Command Status
+                    switch (opcode){
+                        case MOCK_OPCODE_INQUIRY_CANCEL:
+                        case MOCK_OPCODE_CREATE_CONNECTION_CANCEL:
+                        case MOCK_OPCODE_LINK_KEY_REQUEST_REPLY:
+                        case MOCK_OPCODE_LINK_KEY_REQUEST_NEGATIVE_REPLY:
+                        case MOCK_OPCODE_PIN_CODE_REQUEST_REPLY:
+                        case MOCK_OPCODE_PIN_CODE_REQUEST_NEGATIVE_REPLY:
+                        case MOCK_OPCODE_REMOTE_NAME_REQUEST_CANCEL:
+                        case MOCK_OPCODE_IO_CAPABILITY_REQUEST_REPLY:
+                        case MOCK_OPCODE_USER_CONFIRMATION_REQUEST_REPLY:
+                        case MOCK_OPCODE_USER_CONFIRMATION_REQUEST_NEGATIVE_REPLY:
+                        case MOCK_OPCODE_USER_PASSKEY_REQUEST_REPLY:
+                        case MOCK_OPCODE_USER_PASSKEY_REQUEST_NEGATIVE_REPLY:
+                        case MOCK_OPCODE_IO_CAPABILITY_REQUEST_NEGATIVE_REPLY:
+                            break;
+                        default:
+                            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+                            return;
+                    }
+                    break;
+                case OGF_LE_CONTROLLER:
+                    switch (opcode){
+                        case MOCK_OPCODE_LE_CREATE_CONNECTION:
+                        case MOCK_OPCODE_LE_CONNECTION_UPDATE:
+                        case MOCK_OPCODE_LE_READ_REMOTE_USED_FEATURES:
+                        case MOCK_OPCODE_LE_START_ENCRYPTION:
+                        case MOCK_OPCODE_LE_READ_LOCAL_P256_PUBLIC_KEY:
+                        case MOCK_OPCODE_LE_GENERATE_DHKEY:
+                        case MOCK_OPCODE_LE_SET_PHY:
+                        case MOCK_OPCODE_LE_EXTENDED_CREATE_CONNECTION:
+                        case MOCK_OPCODE_LE_CREATE_CIS:
+                        case MOCK_OPCODE_LE_CREATE_BIG:
+                        case MOCK_OPCODE_LE_TERMINATE_BIG:
+                        case MOCK_OPCODE_LE_BIG_CREATE_SYNC:
+                        case MOCK_OPCODE_LE_ACCEPT_CIS_REQUEST:
+                            mock_hci_transport_receive_command_status(opcode, ERROR_CODE_SUCCESS);
+                            return;
+                        default:
+                            break;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+    }
+    mock_hci_transport_receive_command_complete(opcode, ERROR_CODE_SUCCESS, return_params, return_params_len);
+}
+
+static int mock_hci_transport_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return mock_hci_transport_packet_sent_pending ? 0 : 1;
+}
+
+static int mock_hci_transport_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+
+    btstack_assert(size <= MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE);
+    btstack_assert(mock_hci_transport_packet_sent_pending == false);
+
+    mock_hci_transport_packet_t * tx_packet = NULL;
+    if (mock_hci_transport_tx_count < MOCK_HCI_TRANSPORT_MAX_PACKETS){
+        tx_packet = &mock_hci_transport_tx_packets[mock_hci_transport_tx_count++];
+    } else {
+        // keep most recent packets
+        memmove(&mock_hci_transport_tx_packets[0], &mock_hci_transport_tx_packets[1], (MOCK_HCI_TRANSPORT_MAX_PACKETS - 1) * sizeof(mock_hci_transport_packet_t));
+        tx_packet = &mock_hci_transport_tx_packets[MOCK_HCI_TRANSPORT_MAX_PACKETS - 1];
+    }
+    tx_packet->type = packet_type;
+    tx_packet->size = (uint16_t) size;
+    (void)memcpy(tx_packet->buffer, packet, size);
+
+    // notify upper stack that it can send again
+    mock_hci_transport_packet_sent_pending = true;
+    mock_hci_transport_queue_packet(HCI_EVENT_PACKET, packet_sent_event, sizeof(packet_sent_event));
+
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            if (mock_hci_transport_auto_respond){
+                mock_hci_transport_respond_to_command(packet);
+            }
+            break;
+        case HCI_ACL_DATA_PACKET:
+        case HCI_ISO_DATA_PACKET:
+            if (mock_hci_transport_auto_complete){
+                mock_hci_transport_complete_packets(little_endian_read_16(packet, 0) & 0x0fff, 1);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (mock_hci_transport_packet_callback != NULL){
+        (*mock_hci_transport_packet_callback)(tx_packet);
+    }
+    return 0;
+}
+
+static void mock_hci_transport_transport_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int mock_hci_transport_open(void){
+    return 0;
+}
+
+static int mock_hci_transport_close(void){
+    return 0;
+}
+
+static void mock_hci_transport_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    mock_hci_transport_packet_handler = handler;
+}
+
+static int mock_hci_transport_set_baudrate(uint32_t baudrate){
+    UNUSED(baudrate);
+    return 0;
+}
+
+static const hci_transport_t mock_hci_transport = {
+    /* const char * name; */                                        "MOCK",
+    /* void   (*init) (const void *transport_config); */            &mock_hci_transport_transport_init,
+    /* int    (*open)(void); */                                     &mock_hci_transport_open,
+    /* int    (*close)(void); */                                    &mock_hci_transport_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &mock_hci_transport_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       &mock_hci_transport_can_send_packet_now,
+    /* int    (*send_packet)(...); */                               &mock_hci_transport_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                &mock_hci_transport_set_baudrate,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+    /* int    (*send_packet_iov)(...); */                           NULL,
+};
+
+const hci_transport_t * mock_hci_transport_get_instance(void){
+    return &mock_hci_transport;
+}
+
+void mock_hci_transport_init(void){
+    mock_hci_transport_packet_handler = NULL;
+    mock_hci_transport_packet_callback = NULL;
+    mock_hci_transport_tx_count = 0;
+    mock_hci_transport_rx_read_pos = 0;
+    mock_hci_transport_rx_count = 0;
+    mock_hci_transport_packet_sent_pending = false;
+    mock_hci_transport_auto_respond = true;
+    mock_hci_transport_auto_complete = true;
+    mock_hci_transport_acl_data_packet_length = 1021;
+    mock_hci_transport_num_acl_packets = 8;
+    mock_hci_transport_le_data_packet_length = 0;
+    mock_hci_transport_num_le_packets = 0;
+    mock_hci_transport_iso_data_packet_length = 0;
+    mock_hci_transport_num_iso_packets = 0;
+    mock_hci_transport_next_con_handle = 0x0040;
+    mock_hci_transport_incoming_con_handle = HCI_CON_HANDLE_INVALID;
+    memset(mock_hci_transport_supported_commands, 0, sizeof(mock_hci_transport_supported_commands));
+    memset(mock_hci_transport_supported_features, 0, sizeof(mock_hci_transport_supported_features));
+    memset(mock_hci_transport_le_supported_features, 0, sizeof(mock_hci_transport_le_supported_features));
+    // LE Supported (Controller), Secure Simple Pairing
+    mock_hci_transport_set_supported_feature(38);
+    mock_hci_transport_set_supported_feature(51);
+    // Read Buffer Size, Write LE Host Supported
+    mock_hci_transport_set_supported_command(14, 7);
+    mock_hci_transport_set_supported_command(24, 6);
+}
+
+void mock_hci_transport_set_acl_buffers(uint16_t acl_data_packet_length, uint16_t num_acl_packets){
+    mock_hci_transport_acl_data_packet_length = acl_data_packet_length;
+    mock_hci_transport_num_acl_packets = num_acl_packets;
+}
+
+void mock_hci_transport_set_le_buffers(uint16_t le_data_packet_length, uint8_t num_le_packets, uint16_t iso_data_packet_length, uint8_t num_iso_packets){
+    mock_hci_transport_le_data_packet_length = le_data_packet_length;
+    mock_hci_transport_num_le_packets = num_le_packets;
+    mock_hci_transport_iso_data_packet_length = iso_data_packet_length;
+    mock_hci_transport_num_iso_packets = num_iso_packets;
+    if (num_iso_packets > 0){
+        // LE Read Buffer Size v2
+        mock_hci_transport_set_supported_command(41, 5);
+    }
+}
+
+void mock_hci_transport_set_supported_command(uint8_t octet, uint8_t bit){
+    btstack_assert(octet < 64);
+    mock_hci_transport_supported_commands[octet] |= (uint8_t)(1u << bit);
+}
+
+void mock_hci_transport_set_supported_feature(uint8_t bit){
+    btstack_assert(bit < 64);
+    mock_hci_transport_supported_features[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+}
+
+void mock_hci_transport_set_le_supported_feature(uint8_t bit){
+    btstack_assert(bit < 64);
+    mock_hci_transport_le_supported_features[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+}
+
+void mock_hci_transport_set_auto_respond(bool enabled){
+    mock_hci_transport_auto_respond = enabled;
+}
+
+void mock_hci_transport_set_auto_complete(bool enabled){
+    mock_hci_transport_auto_complete = enabled;
+}
+
+void mock_hci_transport_register_packet_callback(void (*callback)(const mock_hci_transport_packet_t * packet)){
+    mock_hci_transport_packet_callback = callback;
+}
+
+void mock_hci_transport_power_on(void){
+    hci_power_control(HCI_POWER_ON);
+    int i;
+    for (i = 0; i < 100; i++){
+        mock_hci_transport_process();
+        if (hci_get_state() == HCI_STATE_WORKING) return;
+        // let init timeouts expire
+        mock_btstack_run_loop_advance_time_ms(100);
+    }
+    btstack_assert(false);
+}
+
+void mock_hci_transport_process(void){
+    while (true){
+        while (mock_hci_transport_rx_count > 0){
+            // copy packet as queue might get modified while packet is processed
+            static mock_hci_transport_packet_t rx_packet;
+            rx_packet = mock_hci_transport_rx_packets[mock_hci_transport_rx_read_pos];
+            mock_hci_transport_rx_read_pos = (mock_hci_transport_rx_read_pos + 1) % MOCK_HCI_TRANSPORT_MAX_RX_PACKETS;
+            mock_hci_transport_rx_count--;
+            if ((rx_packet.type == HCI_EVENT_PACKET) && (rx_packet.buffer[0] == HCI_EVENT_TRANSPORT_PACKET_SENT)){
+                mock_hci_transport_packet_sent_pending = false;
+            }
+            btstack_assert(mock_hci_transport_packet_handler != NULL);
+            (*mock_hci_transport_packet_handler)(rx_packet.type, rx_packet.buffer, rx_packet.size);
+        }
+        mock_btstack_run_loop_process();
+        if (mock_hci_transport_rx_count == 0) break;
+    }
+}
+
+void mock_hci_transport_receive_packet(uint8_t packet_type, const uint8_t * packet, uint16_t size){
+    mock_hci_transport_queue_packet(packet_type, packet, size);
+}
+
+void mock_hci_transport_receive_event(uint8_t event_code, const uint8_t * params, uint8_t params_len){
+    uint8_t event[257];
+    event[0] = event_code;
+    event[1] = params_len;
+    (void)memcpy(&event[2], params, params_len);
+    mock_hci_transport_queue_packet(HCI_EVENT_PACKET, event, 2u + params_len);
+}
+
+void mock_hci_transport_receive_command_complete(uint16_t opcode, uint8_t status, const uint8_t * return_params, uint8_t return_params_len){
+    uint8_t params[255];
+    btstack_assert(return_params_len <= (sizeof(params) - 4));
+    params[0] = 1;  // Num HCI Command Packets
+    little_endian_store_16(params, 1, opcode);
+    params[3] = status;
+    if (return_params_len > 0){
+        (void)memcpy(&params[4], return_params, return_params_len);
+    }
+    mock_hci_transport_receive_event(HCI_EVENT_COMMAND_COMPLETE, params, 4u + return_params_len);
+}
+
+void mock_hci_transport_receive_command_status(uint16_t opcode, uint8_t status){
+    uint8_t params[4];
+    params[0] = status;
+    params[1] = 1;  // Num HCI Command Packets
+    little_endian_store_16(params, 2, opcode);
+    mock_hci_transport_receive_event(HCI_EVENT_COMMAND_STATUS, params, sizeof(params));
+}
+
+void mock_hci_transport_complete_packets(hci_con_handle_t con_handle, uint16_t num_packets){
+    uint8_t params[5];
+    params[0] = 1;
+    little_endian_store_16(params, 1, con_handle);
+    little_endian_store_16(params, 3, num_packets);
+    mock_hci_transport_receive_event(HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, params, sizeof(params));
+}
+
+void mock_hci_transport_connect_classic(const bd_addr_t addr, hci_con_handle_t con_handle){
+    uint8_t params[10];
+    reverse_bd_addr(addr, params);
+    params[6] = 0x00;   // Class of Device
+    params[7] = 0x00;
+    params[8] = 0x00;
+    params[9] = 0x01;   // ACL
+    mock_hci_transport_incoming_con_handle = con_handle;
+    mock_hci_transport_receive_event(HCI_EVENT_CONNECTION_REQUEST, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+void mock_hci_transport_connect_le(const bd_addr_t addr, hci_con_handle_t con_handle){
+    uint8_t params[19];
+    params[0] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    params[1] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(params, 2, con_handle);
+    params[4] = HCI_ROLE_SLAVE;
+    params[5] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(addr, &params[6]);
+    little_endian_store_16(params, 12, 0x0018);    // connection interval
+    little_endian_store_16(params, 14, 0);         // latency
+    little_endian_store_16(params, 16, 0x0048);    // supervision timeout
+    params[18] = 0;                                // clock accuracy
+    mock_hci_transport_receive_event(HCI_EVENT_LE_META, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+void mock_hci_transport_disconnect(hci_con_handle_t con_handle, uint8_t reason){
+    uint8_t params[4];
+    params[0] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(params, 1, con_handle);
+    params[3] = reason;
+    mock_hci_transport_receive_event(HCI_EVENT_DISCONNECTION_COMPLETE, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+uint16_t mock_hci_transport_num_packets(void){
+    return mock_hci_transport_tx_count;
+}
+
+const mock_hci_transport_packet_t * mock_hci_transport_get_packet(uint16_t index){
+    if (index >= mock_hci_transport_tx_count) return NULL;
+    return &mock_hci_transport_tx_packets[index];
+}
+
+uint16_t mock_hci_transport_num_packets_of_type(uint8_t packet_type){
+    uint16_t i;
+    uint16_t count = 0;
+    for (i = 0; i < mock_hci_transport_tx_count; i++){
+        if (mock_hci_transport_tx_packets[i].type == packet_type){
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool mock_hci_transport_packet_is_command(const mock_hci_transport_packet_t * packet, uint16_t opcode){
+    if (packet->type != HCI_COMMAND_DATA_PACKET) return false;
+    return little_endian_read_16(packet->buffer, 0) == opcode;
+}
+
+const mock_hci_transport_packet_t * mock_hci_transport_find_command(uint16_t opcode){
+    uint16_t i = mock_hci_transport_tx_count;
+    while (i > 0){
+        i--;
+        if (mock_hci_transport_packet_is_command(&mock_hci_transport_tx_packets[i], opcode)){
+            return &mock_hci_transport_tx_packets[i];
+        }
+    }
+    return NULL;
+}
+
+uint16_t mock_hci_transport_count_commands(uint16_t opcode){
+    uint16_t i;
+    uint16_t count = 0;
+    for (i = 0; i < mock_hci_transport_tx_count; i++){
+        if (mock_hci_transport_packet_is_command(&mock_hci_transport_tx_packets[i], opcode)){
+            count++;
+        }
+    }
+    return count;
+}
+
+void mock_hci_transport_clear_packets(void){
+    mock_hci_transport_tx_count = 0;
+}
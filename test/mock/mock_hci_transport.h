@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  mock_hci_transport.h
+ *
+ *  HCI Transport for unit tests that simulates a Controller:
+ *  - responds to HCI Commands with Command Complete or Command Status
+ *  - reports configured ACL, LE and ISO buffers during power up
+ *  - records all packets sent by the stack and reports them as sent asynchronously
+ *  - optionally reports sent ACL packets as completed
+ */
+
+#ifndef MOCK_HCI_TRANSPORT_H
+#define MOCK_HCI_TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hci.h"
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_HCI_TRANSPORT_MAX_PACKETS     128
+#define MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE 2048
+
+typedef struct {
+    uint8_t  type;
+    uint16_t size;
+    uint8_t  buffer[MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE];
+} mock_hci_transport_packet_t;
+
+/**
+ * @brief Get transport instance for hci_init
+ */
+const hci_transport_t * mock_hci_transport_get_instance(void);
+
+/**
+ * @brief Reset Controller configuration and state, call before hci_init
+ */
+void mock_hci_transport_init(void);
+
+/**
+ * @brief Configure buffers reported by HCI Read Buffer Size
+ * @param acl_data_packet_length
+ * @param num_acl_packets
+ */
+void mock_hci_transport_set_acl_buffers(uint16_t acl_data_packet_length, uint16_t num_acl_packets);
+
+/**
+ * @brief Configure buffers reported by HCI LE Read Buffer Size (v2), 0 packets = shared with ACL buffers
+ * @param le_data_packet_length
+ * @param num_le_packets
+ * @param iso_data_packet_length
+ * @param num_iso_packets
+ */
+void mock_hci_transport_set_le_buffers(uint16_t le_data_packet_length, uint8_t num_le_packets, uint16_t iso_data_packet_length, uint8_t num_iso_packets);
+
+/**
+ * @brief Mark HCI Command as supported in HCI Read Local Supported Commands
+ * @param octet
+ * @param bit
+ */
+void mock_hci_transport_set_supported_command(uint8_t octet, uint8_t bit);
+
+/**
+ * @brief Set bit in LMP Features returned by HCI Read Local Supported Features
+ * @param bit
+ */
+void mock_hci_transport_set_supported_feature(uint8_t bit);
+
+/**
+ * @brief Set bit in LE Local Supported Features
+ * @param bit
+ */
+void mock_hci_transport_set_le_supported_feature(uint8_t bit);
+
+/**
+ * @brief Respond to HCI Commands automatically, default: true
+ * @param enabled
+ */
+void mock_hci_transport_set_auto_respond(bool enabled);
+
+/**
+ * @brief Report sent ACL and ISO packets as completed automatically, default: true
+ * @param enabled
+ */
+void mock_hci_transport_set_auto_complete(bool enabled);
+
+/**
+ * @brief Register callback for packets sent by the stack, e.g. to simulate the remote device
+ * @param callback
+ */
+void mock_hci_transport_register_packet_callback(void (*callback)(const mock_hci_transport_packet_t * packet));
+
+/**
+ * @brief Power on stack and run init sequence until HCI_STATE_WORKING
+ */
+void mock_hci_transport_power_on(void);
+
+/**
+ * @brief Deliver all packets queued for the stack and execute run loop callbacks
+ */
+void mock_hci_transport_process(void);
+
+/**
+ * @brief Queue packet from Controller to stack
+ * @param packet_type
+ * @param packet
+ * @param size
+ */
+void mock_hci_transport_receive_packet(uint8_t packet_type, const uint8_t * packet, uint16_t size);
+
+/**
+ * @brief Queue HCI Event from Controller to stack
+ * @param event_code
+ * @param params
+ * @param params_len
+ */
+void mock_hci_transport_receive_event(uint8_t event_code, const uint8_t * params, uint8_t params_len);
+
+/**
+ * @brief Queue Command Complete for opcode with status and additional return parameters
+ * @param opcode
+ * @param status
+ * @param return_params
+ * @param return_params_len
+ */
+void mock_hci_transport_receive_command_complete(uint16_t opcode, uint8_t status, const uint8_t * return_params, uint8_t return_params_len);
+
+/**
+ * @brief Queue Command Status for opcode
+ * @param opcode
+ * @param status
+ */
+void mock_hci_transport_receive_command_status(uint16_t opcode, uint8_t status);
+
+/**
+ * @brief Queue Number Of Completed Packets event
+ * @param con_handle
+ * @param num_packets
+ */
+void mock_hci_transport_complete_packets(hci_con_handle_t con_handle, uint16_t num_packets);
+
+/**
+ * @brief Simulate incoming Classic ACL connection and process it until connection is complete
+ * @param addr
+ * @param con_handle
+ */
+void mock_hci_transport_connect_classic(const bd_addr_t addr, hci_con_handle_t con_handle);
+
+/**
+ * @brief Simulate LE Connection Complete as Peripheral and process it
+ * @param addr
+ * @param con_handle
+ */
+void mock_hci_transport_connect_le(const bd_addr_t addr, hci_con_handle_t con_handle);
+
+/**
+ * @brief Simulate Disconnection Complete and process it
+ * @param con_handle
+ * @param reason
+ */
+void mock_hci_transport_disconnect(hci_con_handle_t con_handle, uint8_t reason);
+
+/**
+ * @brief Get number of packets sent by stack since last clear
+ */
+uint16_t mock_hci_transport_num_packets(void);
+
+/**
+ * @brief Get packet sent by stack
+ * @param index
+ * @return packet
+ */
+const mock_hci_transport_packet_t * mock_hci_transport_get_packet(uint16_t index);
+
+/**
+ * @brief Get number of packets of given type sent by stack since last clear
+ * @param packet_type
+ */
+uint16_t mock_hci_transport_num_packets_of_type(uint8_t packet_type);
+
+/**
+ * @brief Find last HCI Command with opcode sent since last clear
+ * @param opcode
+ * @return packet or NULL
+ */
+const mock_hci_transport_packet_t * mock_hci_transport_find_command(uint16_t opcode);
+
+/**
+ * @brief Count HCI Commands with opcode sent since last clear
+ * @param opcode
+ */
+uint16_t mock_hci_transport_count_commands(uint16_t opcode);
+
+/**
+ * @brief Forget recorded packets
+ */
+void mock_hci_transport_clear_packets(void);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // MOCK_HCI_TRANSPORT_H
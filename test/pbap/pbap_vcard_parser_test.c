@@ -0,0 +1,100 @@
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "classic/pbap_vcard_parser.h"
+
+static char result[500];
+
+static void append(const char * text){
+    strcat(result, text);
+}
+
+static void log_event(pbap_vcard_parser_t * parser, pbap_vcard_parser_ret_t ret){
+    switch (ret){
+        case PBAP_VCARD_PARSER_CARD_START:
+            append("[");
+            break;
+        case PBAP_VCARD_PARSER_CARD_END:
+            append("]");
+            break;
+        case PBAP_VCARD_PARSER_PROPERTY_START:
+            append(parser->name);
+            append("(");
+            append(parser->parameters);
+            append(")=");
+            break;
+        case PBAP_VCARD_PARSER_PROPERTY_VALUE:
+            append(parser->data);
+            break;
+        case PBAP_VCARD_PARSER_PROPERTY_END:
+            append(";");
+            break;
+        default:
+            break;
+    }
+}
+
+// feed data in chunks of given size, log events
+static void parse(pbap_vcard_parser_t * parser, const char * vcard, uint16_t chunk_size){
+    uint16_t len = (uint16_t) strlen(vcard);
+    uint16_t pos = 0;
+    while (pos < len){
+        uint16_t chunk_len = len - pos;
+        if (chunk_len > chunk_size) chunk_len = chunk_size;
+        uint16_t i;
+        for (i = 0; i < chunk_len; i++){
+            log_event(parser, pbap_vcard_parser_parse(parser, (uint8_t) vcard[pos + i]));
+        }
+        pos += chunk_len;
+    }
+    log_event(parser, pbap_vcard_parser_eof(parser));
+}
+
+TEST_GROUP(VCardParser){
+    pbap_vcard_parser_t parser;
+
+    void setup(void){
+        pbap_vcard_parser_init(&parser);
+        result[0] = 0;
+    }
+};
+
+TEST(VCardParser, Simple){
+    parse(&parser, "BEGIN:VCARD\r\nVERSION:3.0\r\nFN:John Doe\r\nTEL;TYPE=CELL:+49 123\r\nEND:VCARD\r\n", 100);
+    STRCMP_EQUAL("[VERSION()=3.0;FN()=John Doe;TEL(TYPE=CELL)=+49 123;]", result);
+}
+
+TEST(VCardParser, Chunks){
+    const char * phonebook = "BEGIN:VCARD\r\nN:Doe;John\r\nEND:VCARD\r\nbegin:vcard\r\nitem1.tel:1\r\nend:vcard\r\n";
+    uint16_t chunk_size;
+    for (chunk_size = 1; chunk_size < 20; chunk_size++){
+        setup();
+        parse(&parser, phonebook, chunk_size);
+        STRCMP_EQUAL("[N()=Doe;John;][TEL()=1;]", result);
+    }
+}
+
+TEST(VCardParser, FoldedLine){
+    parse(&parser, "BEGIN:VCARD\r\nNOTE:first\r\n  second\r\n\tthird\r\nEND:VCARD\r\n", 100);
+    STRCMP_EQUAL("[NOTE()=first secondthird;]", result);
+}
+
+TEST(VCardParser, QuotedPrintable){
+    parse(&parser, "BEGIN:VCARD\r\nFN;ENCODING=QUOTED-PRINTABLE:J=C3=\r\n=B6rg\r\nEND:VCARD\r\n", 100);
+    STRCMP_EQUAL("[FN(ENCODING=QUOTED-PRINTABLE)=J=C3=B6rg;]", result);
+}
+
+TEST(VCardParser, QuotedParameter){
+    parse(&parser, "BEGIN:VCARD\nX-TEST;LABEL=\"a:b\":value\nEND:VCARD", 100);
+    STRCMP_EQUAL("[X-TEST(LABEL=\"a:b\")=value;]", result);
+}
+
+TEST(VCardParser, Truncated){
+    parse(&parser, "BEGIN:VCARD\r\nX-VERY-LONG-PROPERTY-NAME-FOR-TEST:1\r\nEND:VCARD\r\n", 100);
+    STRCMP_EQUAL("[X-VERY-LONG-PROPERTY-NAM()=1;]", result);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
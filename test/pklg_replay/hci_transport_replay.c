@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_replay.c"
+
+/*
+ *  hci_transport_replay.c
+ *
+ *  Replays the Controller side of a PacketLogger capture
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hci_transport_replay.h"
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+
+// PacketLogger packet types
+#define PKLG_COMMAND    0x00
+#define PKLG_EVENT      0x01
+#define PKLG_ACL_OUT    0x02
+#define PKLG_ACL_IN     0x03
+#define PKLG_SCO_OUT    0x08
+#define PKLG_SCO_IN     0x09
+// header: len (4), ts_sec (4), ts_usec (4), type (1), len covers timestamps and type
+#define PKLG_HEADER_SIZE 13
+
+// buffer sizes for HCI Read Buffer Size and HCI LE Read Buffer Size if not in capture
+#define REPLAY_ACL_PACKET_LENGTH    1021
+#define REPLAY_NUM_ACL_PACKETS      8
+#define REPLAY_SCO_PACKET_LENGTH    60
+#define REPLAY_NUM_SCO_PACKETS      4
+#define REPLAY_LE_ACL_PACKET_LENGTH 251
+#define REPLAY_NUM_LE_ACL_PACKETS   8
+
+// generated events, packet sent and command responses
+#define REPLAY_QUEUE_SIZE 8
+#define REPLAY_EVENT_SIZE (2 + 255)
+
+// handles with packets to report in Number Of Completed Packets
+#define REPLAY_MAX_HANDLES 8
+
+#define REPLAY_MAX_PACKET_SIZE 0xffff
+
+typedef struct {
+    uint8_t  packet_type;
+    bool     used;
+    // opcode for Command Complete and Command Status events
+    uint16_t opcode;
+    uint16_t size;
+    uint32_t offset;
+} replay_record_t;
+
+typedef struct {
+    uint16_t size;
+    uint8_t  data[REPLAY_EVENT_SIZE];
+} replay_event_t;
+
+typedef struct {
+    hci_con_handle_t handle;
+    uint16_t         num_completed;
+} replay_handle_t;
+
+static void (*replay_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static btstack_data_source_t replay_data_source;
+
+// capture
+static uint8_t *         replay_data;
+static uint32_t          replay_data_size;
+static replay_record_t * replay_records;
+static uint32_t          replay_num_records;
+static uint32_t          replay_max_records;
+// next Controller to host packet to deliver
+static uint32_t          replay_stream_index;
+// first response that might not have been used yet
+static uint32_t          replay_response_index;
+
+static replay_event_t    replay_queue[REPLAY_QUEUE_SIZE];
+static uint16_t          replay_queue_head;
+static uint16_t          replay_queue_count;
+
+static replay_handle_t   replay_handles[REPLAY_MAX_HANDLES];
+
+static bool replay_packet_sent_pending;
+
+static uint8_t replay_packet_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + REPLAY_MAX_PACKET_SIZE];
+
+static hci_transport_replay_statistics_t replay_statistics;
+
+static bool replay_is_response(const uint8_t * event, uint16_t size){
+    if (size < 2) return false;
+    if ((event[0] == HCI_EVENT_COMMAND_COMPLETE) && (size >= 5)) return true;
+    if ((event[0] == HCI_EVENT_COMMAND_STATUS)   && (size >= 6)) return true;
+    return false;
+}
+
+// BTstack events logged by the host use codes above HCI events, vendor events use 0xff
+static bool replay_is_controller_event(uint8_t event_code){
+    return (event_code < 0x60) || (event_code == HCI_EVENT_VENDOR_SPECIFIC);
+}
+
+static uint16_t replay_response_opcode(const uint8_t * event){
+    if (event[0] == HCI_EVENT_COMMAND_COMPLETE){
+        return little_endian_read_16(event, 3);
+    }
+    return little_endian_read_16(event, 4);
+}
+
+static int replay_add_record(uint8_t packet_type, const uint8_t * packet, uint16_t size, uint32_t offset){
+    if (replay_num_records == replay_max_records){
+        uint32_t max_records = (replay_max_records == 0) ? 1024 : (2 * replay_max_records);
+        replay_record_t * records = (replay_record_t *) realloc(replay_records, max_records * sizeof(replay_record_t));
+        if (records == NULL) return -1;
+        replay_records = records;
+        replay_max_records = max_records;
+    }
+    replay_record_t * record = &replay_records[replay_num_records++];
+    record->packet_type = packet_type;
+    record->used = false;
+    record->opcode = 0;
+    record->size = size;
+    record->offset = offset;
+    if ((packet_type == HCI_EVENT_PACKET) && replay_is_response(packet, size)){
+        record->opcode = replay_response_opcode(packet);
+    }
+    return 0;
+}
+
+int hci_transport_replay_load(const char * path){
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        log_error("replay: cannot open %s", path);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (file_size < 0){
+        fclose(file);
+        return -1;
+    }
+    uint8_t * data = (uint8_t *) realloc(replay_data, replay_data_size + (uint32_t) file_size);
+    if (data == NULL){
+        fclose(file);
+        return -1;
+    }
+    replay_data = data;
+    size_t bytes_read = fread(&replay_data[replay_data_size], 1, (size_t) file_size, file);
+    fclose(file);
+    if (bytes_read != (size_t) file_size) return -1;
+
+    uint32_t pos = replay_data_size;
+    uint32_t end = replay_data_size + (uint32_t) file_size;
+    replay_data_size = end;
+    while ((pos + PKLG_HEADER_SIZE) <= end){
+        uint32_t len = big_endian_read_32(replay_data, pos);
+        if ((len < 9) || ((len - 9) > REPLAY_MAX_PACKET_SIZE) || ((pos + 4 + len) > end)){
+            log_error("replay: error parsing %s at offset %u", path, (unsigned int) pos);
+            return -1;
+        }
+        uint8_t  type    = replay_data[pos + 12];
+        uint32_t offset  = pos + PKLG_HEADER_SIZE;
+        uint16_t size    = (uint16_t) (len - 9);
+        int err = 0;
+        switch (type){
+            case PKLG_EVENT:
+                err = replay_add_record(HCI_EVENT_PACKET, &replay_data[offset], size, offset);
+                break;
+            case PKLG_ACL_IN:
+                err = replay_add_record(HCI_ACL_DATA_PACKET, &replay_data[offset], size, offset);
+                break;
+            case PKLG_SCO_IN:
+                err = replay_add_record(HCI_SCO_DATA_PACKET, &replay_data[offset], size, offset);
+                break;
+            default:
+                // host to Controller packets and log messages
+                break;
+        }
+        if (err != 0) return err;
+        pos += 4 + len;
+    }
+    return 0;
+}
+
+static void replay_queue_event(const uint8_t * event, uint16_t size){
+    btstack_assert(replay_queue_count < REPLAY_QUEUE_SIZE);
+    btstack_assert(size <= REPLAY_EVENT_SIZE);
+    replay_event_t * entry = &replay_queue[(replay_queue_head + replay_queue_count) % REPLAY_QUEUE_SIZE];
+    (void)memcpy(entry->data, event, size);
+    entry->size = size;
+    replay_queue_count++;
+}
+
+static void replay_handle_command(const uint8_t * packet, uint16_t size){
+    if (size < 3) return;
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    // skip used responses at the start
+    while ((replay_response_index < replay_num_records) &&
+          ((replay_records[replay_response_index].opcode == 0) || replay_records[replay_response_index].used)){
+        replay_response_index++;
+    }
+    uint32_t i;
+    for (i = replay_response_index; i < replay_num_records; i++){
+        replay_record_t * record = &replay_records[i];
+        if (record->used) continue;
+        if (record->opcode != opcode) continue;
+        if (record->size > REPLAY_EVENT_SIZE) continue;
+        record->used = true;
+        replay_queue_event(&replay_data[record->offset], record->size);
+        replay_statistics.commands_replayed++;
+        return;
+    }
+    // not in capture, accept. provide return parameters required for HCI startup
+    uint8_t event[6 + 64];
+    uint8_t params_len = 0;
+    memset(event, 0, sizeof(event));
+    if (opcode == hci_read_local_supported_commands.opcode){
+        memset(&event[6], 0xff, 64);
+        params_len = 64;
+    } else if (opcode == hci_read_buffer_size.opcode){
+        little_endian_store_16(event, 6, REPLAY_ACL_PACKET_LENGTH);
+        event[8] = REPLAY_SCO_PACKET_LENGTH;
+        little_endian_store_16(event, 9, REPLAY_NUM_ACL_PACKETS);
+        little_endian_store_16(event, 11, REPLAY_NUM_SCO_PACKETS);
+        params_len = 7;
+    } else if (opcode == hci_le_read_buffer_size.opcode){
+        little_endian_store_16(event, 6, REPLAY_LE_ACL_PACKET_LENGTH);
+        event[8] = REPLAY_NUM_LE_ACL_PACKETS;
+        params_len = 3;
+    }
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 4 + params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    event[5] = ERROR_CODE_SUCCESS;
+    replay_queue_event(event, 6 + params_len);
+    replay_statistics.commands_not_found++;
+}
+
+static void replay_handle_data(const uint8_t * packet, uint16_t size){
+    if (size < 2) return;
+    hci_con_handle_t handle = little_endian_read_16(packet, 0) & 0x0fff;
+    int free_slot = -1;
+    int i;
+    for (i=0;i<REPLAY_MAX_HANDLES;i++){
+        if ((replay_handles[i].num_completed > 0) && (replay_handles[i].handle == handle)){
+            replay_handles[i].num_completed++;
+            return;
+        }
+        if ((replay_handles[i].num_completed == 0) && (free_slot < 0)){
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        log_error("replay: too many handles");
+        return;
+    }
+    replay_handles[free_slot].handle = handle;
+    replay_handles[free_slot].num_completed = 1;
+}
+
+static void replay_queue_number_of_completed_packets(void){
+    uint8_t event[3 + 4 * REPLAY_MAX_HANDLES];
+    uint8_t num_handles = 0;
+    int i;
+    for (i=0;i<REPLAY_MAX_HANDLES;i++){
+        replay_handle_t * entry = &replay_handles[i];
+        if (entry->num_completed == 0) continue;
+        little_endian_store_16(event, 3 + 4 * num_handles, entry->handle);
+        little_endian_store_16(event, 5 + 4 * num_handles, entry->num_completed);
+        entry->num_completed = 0;
+        num_handles++;
+    }
+    if (num_handles == 0) return;
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 1 + 4 * num_handles;
+    event[2] = num_handles;
+    replay_queue_event(event, 3 + 4 * num_handles);
+}
+
+static uint64_t replay_time_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000u) + (uint64_t) now.tv_nsec;
+}
+
+static void replay_deliver(uint8_t packet_type, const uint8_t * data, uint16_t size){
+    uint8_t * packet = &replay_packet_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    (void)memcpy(packet, data, size);
+    hci_transport_replay_timing_t * timing;
+    switch (packet_type){
+        case HCI_EVENT_PACKET:
+            if ((packet[0] == HCI_EVENT_LE_META) && (size >= 3)){
+                timing = &replay_statistics.le_meta_events[packet[2]];
+            } else {
+                timing = &replay_statistics.events[packet[0]];
+            }
+            break;
+        case HCI_ACL_DATA_PACKET:
+            timing = &replay_statistics.acl_packets;
+            break;
+        default:
+            timing = &replay_statistics.sco_packets;
+            break;
+    }
+    uint64_t start_ns = replay_time_ns();
+    (*replay_packet_handler)(packet_type, packet, size);
+    uint32_t duration_ns = (uint32_t) (replay_time_ns() - start_ns);
+    timing->count++;
+    timing->total_ns += duration_ns;
+    if (duration_ns > timing->max_ns){
+        timing->max_ns = duration_ns;
+    }
+}
+
+// next Controller to host packet from capture, skips responses and flow control
+static replay_record_t * replay_next_stream_record(void){
+    while (replay_stream_index < replay_num_records){
+        replay_record_t * record = &replay_records[replay_stream_index];
+        if (record->packet_type != HCI_EVENT_PACKET) return record;
+        if (record->size < 2) {
+            replay_stream_index++;
+            continue;
+        }
+        const uint8_t * event = &replay_data[record->offset];
+        if ((record->opcode == 0) && (event[0] != HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS) && replay_is_controller_event(event[0])) return record;
+        replay_stream_index++;
+    }
+    return NULL;
+}
+
+static void replay_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    // deliver a batch, then let run loop process timers
+    uint16_t budget = 64;
+    while (budget > 0){
+        budget--;
+        if (replay_queue_count == 0){
+            replay_queue_number_of_completed_packets();
+        }
+        if (replay_queue_count > 0){
+            replay_event_t * entry = &replay_queue[replay_queue_head];
+            replay_queue_head = (replay_queue_head + 1) % REPLAY_QUEUE_SIZE;
+            replay_queue_count--;
+            if (entry->data[0] == HCI_EVENT_TRANSPORT_PACKET_SENT){
+                replay_packet_sent_pending = false;
+            }
+            replay_deliver(HCI_EVENT_PACKET, entry->data, entry->size);
+            continue;
+        }
+        // capture is replayed after HCI startup
+        if (hci_get_state() != HCI_STATE_WORKING) break;
+        replay_record_t * record = replay_next_stream_record();
+        if (record == NULL) break;
+        replay_stream_index++;
+        replay_deliver(record->packet_type, &replay_data[record->offset], record->size);
+    }
+}
+
+static void hci_transport_replay_init(const void * transport_config){
+    UNUSED(transport_config);
+    replay_queue_head  = 0;
+    replay_queue_count = 0;
+    replay_stream_index = 0;
+    replay_response_index = 0;
+    replay_packet_sent_pending = false;
+    memset(replay_handles, 0, sizeof(replay_handles));
+    memset(&replay_statistics, 0, sizeof(replay_statistics));
+}
+
+static int hci_transport_replay_open(void){
+    btstack_run_loop_set_data_source_handler(&replay_data_source, &replay_process);
+    btstack_run_loop_enable_data_source_callbacks(&replay_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&replay_data_source);
+    return 0;
+}
+
+static int hci_transport_replay_close(void){
+    btstack_run_loop_remove_data_source(&replay_data_source);
+    return 0;
+}
+
+static void hci_transport_replay_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    replay_packet_handler = handler;
+}
+
+static int hci_transport_replay_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return replay_packet_sent_pending ? 0 : 1;
+}
+
+static int hci_transport_replay_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0 };
+    if (replay_packet_sent_pending) return -1;
+    // packet sent event precedes Controller response
+    replay_packet_sent_pending = true;
+    replay_queue_event(packet_sent_event, sizeof(packet_sent_event));
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            replay_handle_command(packet, (uint16_t) size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            replay_statistics.acl_packets_sent++;
+            replay_handle_data(packet, (uint16_t) size);
+            break;
+        case HCI_SCO_DATA_PACKET:
+            replay_statistics.sco_packets_sent++;
+            replay_handle_data(packet, (uint16_t) size);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static const hci_transport_t hci_transport_replay = {
+    /* const char * name; */                                        "REPLAY",
+    /* void   (*init) (const void *transport_config); */            &hci_transport_replay_init,
+    /* int    (*open)(void); */                                     &hci_transport_replay_open,
+    /* int    (*close)(void); */                                    &hci_transport_replay_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_replay_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_replay_can_send_packet_now,
+    /* int    (*send_packet)(...); */                               &hci_transport_replay_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+};
+
+const hci_transport_t * hci_transport_replay_instance(void){
+    return &hci_transport_replay;
+}
+
+bool hci_transport_replay_done(void){
+    if (replay_queue_count > 0) return false;
+    return replay_next_stream_record() == NULL;
+}
+
+const hci_transport_replay_statistics_t * hci_transport_replay_get_statistics(void){
+    uint32_t skipped = 0;
+    uint32_t i;
+    for (i = 0; i < replay_num_records; i++){
+        if ((replay_records[i].opcode != 0) && !replay_records[i].used){
+            skipped++;
+        }
+    }
+    replay_statistics.packets_skipped = skipped;
+    return &replay_statistics;
+}
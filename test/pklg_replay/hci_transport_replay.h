@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/**
+ * @title HCI Transport Replay
+ *
+ * Virtual HCI Transport that replays the Controller side of a PacketLogger capture (.pklg).
+ *
+ * Command Complete and Command Status events are used as responses to the commands sent by the host:
+ * for each command, the next unused response for the same opcode in the capture is returned. Commands
+ * without a recorded response are answered with a successful Command Complete without return parameters.
+ *
+ * All other events and incoming ACL and SCO packets are delivered in capture order as fast as possible once
+ * HCI is working. Number Of Completed Packets events from the capture are dropped and generated for the
+ * ACL and SCO packets sent by the host instead, so the host is not limited by replayed flow control.
+ *
+ * The processing time of each packet delivered to the host is measured per packet type and event code.
+ */
+
+#ifndef HCI_TRANSPORT_REPLAY_H
+#define HCI_TRANSPORT_REPLAY_H
+
+#include <stdint.h>
+
+#include "btstack_bool.h"
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_ns;
+    uint32_t max_ns;
+} hci_transport_replay_timing_t;
+
+typedef struct {
+    // by event code, LE Meta events by subevent code
+    hci_transport_replay_timing_t events[256];
+    hci_transport_replay_timing_t le_meta_events[256];
+    hci_transport_replay_timing_t acl_packets;
+    hci_transport_replay_timing_t sco_packets;
+    // commands sent by host, answered from capture or not found in capture
+    uint32_t commands_replayed;
+    uint32_t commands_not_found;
+    uint32_t acl_packets_sent;
+    uint32_t sco_packets_sent;
+    // Controller to host packets in capture that are not replayed, e.g. responses for commands not sent by host
+    uint32_t packets_skipped;
+} hci_transport_replay_statistics_t;
+
+/* API_START */
+
+/**
+ * @brief Get Replay HCI Transport instance
+ * @return transport
+ */
+const hci_transport_t * hci_transport_replay_instance(void);
+
+/**
+ * @brief Load capture, can be called multiple times for segments of a rotating log, oldest first
+ * @param path of PacketLogger file
+ * @return 0 on success
+ */
+int hci_transport_replay_load(const char * path);
+
+/**
+ * @brief Check if all packets of the capture have been delivered
+ * @return true if done
+ */
+bool hci_transport_replay_done(void);
+
+/**
+ * @brief Get processing time statistics
+ * @return statistics
+ */
+const hci_transport_replay_statistics_t * hci_transport_replay_get_statistics(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_TRANSPORT_REPLAY_H
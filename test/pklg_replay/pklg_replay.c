@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "pklg_replay.c"
+
+// *****************************************************************************
+//
+// PacketLogger Replay
+//
+// Replays the Controller side of PacketLogger captures into the host stack and reports the
+// processing time per packet type and event code. The HCI Replay Transport answers host commands
+// with the responses from the capture and delivers all other Controller to host packets as fast
+// as possible. L2CAP, RFCOMM, SDP, SM, ATT Server and GATT Client are active, incoming connections
+// and channels are accepted.
+//
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack.h"
+#include "btstack_run_loop_embedded.h"
+#include "hal_cpu.h"
+#include "hal_time_ms.h"
+
+#include "hci_transport_replay.h"
+#include "pklg_replay.h"
+
+#define REPLAY_RFCOMM_CHANNEL    1
+#define REPLAY_TIMEOUT_MS        60000
+
+typedef struct {
+    const char * name;
+    const hci_transport_replay_timing_t * timing;
+} replay_entry_t;
+
+static btstack_packet_callback_registration_t replay_hci_event_callback_registration;
+static btstack_packet_callback_registration_t replay_sm_event_callback_registration;
+
+static uint8_t replay_spp_service_buffer[150];
+
+static bool replay_working;
+
+// embedded run loop with HAVE_EMBEDDED_TIME_MS
+uint32_t hal_time_ms(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+}
+void hal_cpu_disable_irqs(void){}
+void hal_cpu_enable_irqs(void){}
+void hal_cpu_enable_irqs_and_sleep(void){}
+
+static void replay_hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING){
+                replay_working = true;
+            }
+            break;
+        case SM_EVENT_JUST_WORKS_REQUEST:
+            sm_just_works_confirm(sm_event_just_works_request_get_handle(packet));
+            break;
+        case SM_EVENT_NUMERIC_COMPARISON_REQUEST:
+            sm_numeric_comparison_confirm(sm_event_numeric_comparison_request_get_handle(packet));
+            break;
+        default:
+            break;
+    }
+}
+
+static void replay_rfcomm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) == RFCOMM_EVENT_INCOMING_CONNECTION){
+        rfcomm_accept_connection(rfcomm_event_incoming_connection_get_rfcomm_cid(packet));
+    }
+}
+
+static void replay_sco_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(packet);
+    UNUSED(size);
+}
+
+static int replay_att_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+    UNUSED(buffer);
+    UNUSED(buffer_size);
+    return 0;
+}
+
+static void replay_execute_until(bool (*done)(void)){
+    uint32_t started_ms = hal_time_ms();
+    while (!(*done)()){
+        btstack_run_loop_embedded_execute_once();
+        if ((hal_time_ms() - started_ms) > REPLAY_TIMEOUT_MS){
+            printf("Replay: timeout\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static bool replay_is_working(void){
+    return replay_working;
+}
+
+static int replay_entry_compare(const void * a, const void * b){
+    const replay_entry_t * entry_a = (const replay_entry_t *) a;
+    const replay_entry_t * entry_b = (const replay_entry_t *) b;
+    if (entry_a->timing->total_ns > entry_b->timing->total_ns) return -1;
+    if (entry_a->timing->total_ns < entry_b->timing->total_ns) return 1;
+    return 0;
+}
+
+static void replay_report(double wall_s){
+    static char names[2 * 256][16];
+    replay_entry_t entries[2 * 256 + 2];
+    uint16_t num_entries = 0;
+    const hci_transport_replay_statistics_t * statistics = hci_transport_replay_get_statistics();
+    int i;
+    for (i=0;i<256;i++){
+        if (statistics->events[i].count > 0){
+            snprintf(names[num_entries], sizeof(names[0]), "event 0x%02x", i);
+            entries[num_entries].name = names[num_entries];
+            entries[num_entries].timing = &statistics->events[i];
+            num_entries++;
+        }
+    }
+    for (i=0;i<256;i++){
+        if (statistics->le_meta_events[i].count > 0){
+            snprintf(names[num_entries], sizeof(names[0]), "le meta 0x%02x", i);
+            entries[num_entries].name = names[num_entries];
+            entries[num_entries].timing = &statistics->le_meta_events[i];
+            num_entries++;
+        }
+    }
+    if (statistics->acl_packets.count > 0){
+        entries[num_entries].name = "acl";
+        entries[num_entries].timing = &statistics->acl_packets;
+        num_entries++;
+    }
+    if (statistics->sco_packets.count > 0){
+        entries[num_entries].name = "sco";
+        entries[num_entries].timing = &statistics->sco_packets;
+        num_entries++;
+    }
+    qsort(entries, num_entries, sizeof(replay_entry_t), &replay_entry_compare);
+
+    uint64_t total_ns = 0;
+    uint32_t total_count = 0;
+    printf("%-14s %9s %12s %9s %9s\n", "packet", "count", "total us", "avg ns", "max ns");
+    for (i=0;i<num_entries;i++){
+        const hci_transport_replay_timing_t * timing = entries[i].timing;
+        printf("%-14s %9" PRIu32 " %12" PRIu64 " %9" PRIu64 " %9" PRIu32 "\n", entries[i].name, timing->count,
+               timing->total_ns / 1000u, timing->total_ns / timing->count, timing->max_ns);
+        total_ns += timing->total_ns;
+        total_count += timing->count;
+    }
+    printf("%-14s %9" PRIu32 " %12" PRIu64 " %9" PRIu64 "\n", "total", total_count, total_ns / 1000u,
+           (total_count > 0) ? (total_ns / total_count) : 0u);
+    printf("\n");
+    printf("commands: %" PRIu32 " replayed, %" PRIu32 " not in capture, %" PRIu32 " responses not used\n",
+           statistics->commands_replayed, statistics->commands_not_found, statistics->packets_skipped);
+    printf("sent: %" PRIu32 " ACL, %" PRIu32 " SCO packets, wall time %.3f s\n",
+           statistics->acl_packets_sent, statistics->sco_packets_sent, wall_s);
+}
+
+static void usage(const char * name){
+    printf("Usage: %s [-d pklg] capture.pklg [more segments of rotating log]\n", name);
+    printf("  -d pklg    store HCI packets of the replay in PacketLogger format\n");
+}
+
+int main(int argc, const char * argv[]){
+    int num_captures = 0;
+    int arg;
+    for (arg = 1; arg < argc; arg++){
+        if ((strcmp(argv[arg], "-d") == 0) && ((arg + 1) < argc)){
+            hci_dump_open(argv[++arg], HCI_DUMP_PACKETLOGGER);
+            continue;
+        }
+        if (argv[arg][0] == '-'){
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (hci_transport_replay_load(argv[arg]) != 0){
+            printf("Cannot load %s\n", argv[arg]);
+            return EXIT_FAILURE;
+        }
+        num_captures++;
+    }
+    if (num_captures == 0){
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_embedded_get_instance());
+
+    hci_init(hci_transport_replay_instance(), NULL);
+    hci_register_sco_packet_handler(&replay_sco_packet_handler);
+    replay_hci_event_callback_registration.callback = &replay_hci_event_handler;
+    hci_add_event_handler(&replay_hci_event_callback_registration);
+
+    l2cap_init();
+
+    rfcomm_init();
+    rfcomm_register_service(&replay_rfcomm_packet_handler, REPLAY_RFCOMM_CHANNEL, 0xffff);
+
+    sdp_init();
+    memset(replay_spp_service_buffer, 0, sizeof(replay_spp_service_buffer));
+    spp_create_sdp_record(replay_spp_service_buffer, 0x10001, REPLAY_RFCOMM_CHANNEL, "SPP Replay");
+    sdp_register_service(replay_spp_service_buffer);
+
+    sm_init();
+    sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    replay_sm_event_callback_registration.callback = &replay_hci_event_handler;
+    sm_add_event_handler(&replay_sm_event_callback_registration);
+
+    att_server_init(profile_data, NULL, &replay_att_write_callback);
+    gatt_client_init();
+
+    gap_ssp_set_io_capability(SSP_IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    gap_discoverable_control(1);
+    gap_connectable_control(1);
+
+    hci_power_control(HCI_POWER_ON);
+    replay_execute_until(&replay_is_working);
+
+    struct timespec start;
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replay_execute_until(&hci_transport_replay_done);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    replay_report((double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9));
+    return EXIT_SUCCESS;
+}
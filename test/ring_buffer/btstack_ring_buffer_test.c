@@ -1,6 +1,7 @@
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
 #include "btstack_ring_buffer.h"
+#include "btstack_ring_buffer_spsc.h"
 #include "btstack_util.h"
 
 static  uint8_t storage[10];
@@ -93,6 +94,90 @@ TEST(RingBuffer, ReadWriteChunks){
     }
 }
 
+static uint8_t spsc_storage[16];
+
+TEST_GROUP(RingBufferSPSC){
+    btstack_ring_buffer_spsc_t ring_buffer;
+
+    void setup(void){
+        memset(spsc_storage, 0, sizeof(spsc_storage));
+        btstack_ring_buffer_spsc_init(&ring_buffer, spsc_storage, sizeof(spsc_storage));
+    }
+};
+
+TEST(RingBufferSPSC, EmptyBuffer){
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(16, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+}
+
+TEST(RingBufferSPSC, StorageSizeNotPowerOfTwo){
+    btstack_ring_buffer_spsc_init(&ring_buffer, spsc_storage, 10);
+    CHECK_EQUAL(8, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+}
+
+TEST(RingBufferSPSC, WriteFullBuffer){
+    uint8_t test_write_data[16];
+    uint8_t test_read_data[16];
+    int i;
+    for (i=0;i<16;i++){
+        test_write_data[i] = i;
+    }
+
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, 16));
+    CHECK_EQUAL(16, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+    CHECK_TRUE(btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, 1) != 0);
+
+    uint32_t number_of_bytes_read = 0;
+    btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, 16, &number_of_bytes_read);
+    CHECK_EQUAL(16, number_of_bytes_read);
+    CHECK_EQUAL(0, memcmp(test_write_data, test_read_data, 16));
+}
+
+TEST(RingBufferSPSC, ReadWriteWrapAround){
+    uint8_t test_write_data[] = {1,2,3,4,5};
+    uint8_t test_read_data[5];
+
+    int i;
+    for (i=0;i<30;i++){
+        CHECK_EQUAL(0, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data)));
+        CHECK_EQUAL(5, btstack_ring_buffer_spsc_peek(&ring_buffer, test_read_data, sizeof(test_read_data)));
+        CHECK_EQUAL(5, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+
+        uint32_t number_of_bytes_read = 0;
+        memset(test_read_data, 0, sizeof(test_read_data));
+        btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+        CHECK_EQUAL(5, number_of_bytes_read);
+        CHECK_EQUAL(0, memcmp(test_write_data, test_read_data, sizeof(test_read_data)));
+    }
+}
+
+TEST(RingBufferSPSC, Regions){
+    uint32_t region_size;
+    uint8_t * write_region = btstack_ring_buffer_spsc_get_write_region(&ring_buffer, &region_size);
+    CHECK_EQUAL(16, region_size);
+    memset(write_region, 0x55, 12);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 12);
+
+    const uint8_t * read_region = btstack_ring_buffer_spsc_get_read_region(&ring_buffer, &region_size);
+    CHECK_EQUAL(12, region_size);
+    CHECK_EQUAL(0x55, read_region[11]);
+    btstack_ring_buffer_spsc_read_commit(&ring_buffer, 8);
+
+    // free region ends at end of storage
+    write_region = btstack_ring_buffer_spsc_get_write_region(&ring_buffer, &region_size);
+    CHECK_EQUAL(4, region_size);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 4);
+    write_region = btstack_ring_buffer_spsc_get_write_region(&ring_buffer, &region_size);
+    CHECK_EQUAL(8, region_size);
+    CHECK_TRUE(write_region == spsc_storage);
+
+    // available region ends at end of storage, too
+    read_region = btstack_ring_buffer_spsc_get_read_region(&ring_buffer, &region_size);
+    CHECK_EQUAL(8, region_size);
+    CHECK_EQUAL(8, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
\ No newline at end of file
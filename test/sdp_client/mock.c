@@ -19,7 +19,7 @@ extern "C" void l2cap_request_can_send_now_event(uint16_t cid){
 
 extern "C" uint8_t l2cap_create_channel(btstack_packet_handler_t handler, bd_addr_t address, uint16_t psm, uint16_t mtu, uint16_t * out_local_cid){
 	packet_handler = handler;
-    return 0x41;
+    return 0;
 }
 extern "C" void l2cap_disconnect(uint16_t local_cid, uint8_t reason){
 }
@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "sdp_server_test.c"
+
+/*
+ *  sdp_server_test.c
+ *
+ *  SDP Server over simulated Controller, compares responses for records with and without record index
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "bluetooth.h"
+#include "bluetooth_psm.h"
+#include "bluetooth_sdp.h"
+#include "btstack_debug.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+#include "classic/sdp_server.h"
+#include "classic/sdp_util.h"
+
+#include "mock_btstack_run_loop.h"
+#include "mock_hci_transport.h"
+
+#include "sdp_server_test.h"
+
+#define TEST_CON_HANDLE   0x0001
+#define TEST_REMOTE_CID   0x0070
+#define TEST_REMOTE_MTU   200
+
+#define INFO_TYPE_FIXED_CHANNELS_SUPPORTED 0x0003
+#define CONFIG_OPTION_TYPE_MTU             0x01
+
+#define INDEXED_HANDLE 0x10001
+#define PLAIN_HANDLE   0x10002
+#define CUSTOM_HANDLE  0x10003
+
+static const bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+// remote device
+static uint8_t  remote_sig_id;
+static uint16_t sdp_cid;
+static uint16_t remote_transaction_id;
+
+// last SDP response
+static uint8_t  sdp_response[TEST_REMOTE_MTU];
+static uint16_t sdp_response_len;
+
+static void remote_send_signaling(uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t data_len){
+    uint8_t packet[64];
+    btstack_assert(data_len <= (sizeof(packet) - 12));
+    little_endian_store_16(packet, 0, TEST_CON_HANDLE | (0x02 << 12));
+    little_endian_store_16(packet, 2, 8 + data_len);
+    little_endian_store_16(packet, 4, 4 + data_len);
+    little_endian_store_16(packet, 6, L2CAP_CID_SIGNALING);
+    packet[8] = code;
+    packet[9] = sig_id;
+    little_endian_store_16(packet, 10, data_len);
+    (void)memcpy(&packet[12], data, data_len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 12 + data_len);
+}
+
+static void remote_send_data(uint16_t cid, const uint8_t * data, uint16_t len){
+    uint8_t packet[300];
+    btstack_assert(len <= (sizeof(packet) - 8));
+    little_endian_store_16(packet, 0, TEST_CON_HANDLE | (0x02 << 12));
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    (void)memcpy(&packet[8], data, len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 8 + len);
+}
+
+// respond to signaling requests like a remote device with Basic Mode only and store SDP responses
+static void remote_handle_packet(const mock_hci_transport_packet_t * packet){
+    if (packet->type != HCI_ACL_DATA_PACKET) return;
+    uint16_t cid = little_endian_read_16(packet->buffer, 6);
+    if (cid == TEST_REMOTE_CID){
+        sdp_response_len = little_endian_read_16(packet->buffer, 4);
+        btstack_assert(sdp_response_len <= sizeof(sdp_response));
+        (void)memcpy(sdp_response, &packet->buffer[8], sdp_response_len);
+        return;
+    }
+    if (cid != L2CAP_CID_SIGNALING) return;
+    const uint8_t * command = &packet->buffer[8];
+    uint8_t  code   = command[0];
+    uint8_t  sig_id = command[1];
+    uint8_t  response[12];
+    switch (code){
+        case INFORMATION_REQUEST:
+            little_endian_store_16(response, 0, little_endian_read_16(command, 4));
+            little_endian_store_16(response, 2, 0);     // success
+            memset(&response[4], 0, 8);
+            if (little_endian_read_16(command, 4) == INFO_TYPE_FIXED_CHANNELS_SUPPORTED){
+                response[4] = 1 << L2CAP_CID_SIGNALING;
+                remote_send_signaling(INFORMATION_RESPONSE, sig_id, response, 12);
+            } else {
+                remote_send_signaling(INFORMATION_RESPONSE, sig_id, response, 8);
+            }
+            break;
+        case CONNECTION_RESPONSE:
+            // result success: remember SDP Server cid and send own configuration request with MTU option
+            if (little_endian_read_16(command, 8) != 0) break;
+            sdp_cid = little_endian_read_16(command, 4);
+            little_endian_store_16(response, 0, sdp_cid);
+            little_endian_store_16(response, 2, 0);
+            response[4] = CONFIG_OPTION_TYPE_MTU;
+            response[5] = 2;
+            little_endian_store_16(response, 6, TEST_REMOTE_MTU);
+            remote_send_signaling(CONFIGURE_REQUEST, ++remote_sig_id, response, 8);
+            break;
+        case CONFIGURE_REQUEST:
+            little_endian_store_16(response, 0, TEST_REMOTE_CID);
+            little_endian_store_16(response, 2, 0);
+            little_endian_store_16(response, 4, 0);
+            remote_send_signaling(CONFIGURE_RESPONSE, sig_id, response, 6);
+            break;
+        default:
+            break;
+    }
+}
+
+static void remote_open_sdp_channel(void){
+    uint8_t params[4];
+    little_endian_store_16(params, 0, BLUETOOTH_PSM_SDP);
+    little_endian_store_16(params, 2, TEST_REMOTE_CID);
+    remote_send_signaling(CONNECTION_REQUEST, ++remote_sig_id, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+// send SDP request with given parameters and continuation state, returns length of response
+static uint16_t remote_sdp_request(uint8_t pdu_id, const uint8_t * params, uint16_t params_len, const uint8_t * continuation, uint8_t continuation_len){
+    uint8_t request[100];
+    btstack_assert((params_len + 6 + continuation_len) <= sizeof(request));
+    request[0] = pdu_id;
+    big_endian_store_16(request, 1, ++remote_transaction_id);
+    big_endian_store_16(request, 3, params_len + 1 + continuation_len);
+    (void)memcpy(&request[5], params, params_len);
+    request[5 + params_len] = continuation_len;
+    (void)memcpy(&request[6 + params_len], continuation, continuation_len);
+    sdp_response_len = 0;
+    remote_send_data(sdp_cid, request, 6 + params_len + continuation_len);
+    mock_hci_transport_process();
+    return sdp_response_len;
+}
+
+static uint16_t sdp_service_search(const uint8_t * pattern, uint8_t * handles){
+    uint8_t params[30];
+    uint16_t pattern_len = de_get_len(pattern);
+    (void)memcpy(params, pattern, pattern_len);
+    big_endian_store_16(params, pattern_len, 10);
+    uint16_t len = remote_sdp_request(SDP_ServiceSearchRequest, params, pattern_len + 2, NULL, 0);
+    CHECK(len >= 9);
+    CHECK_EQUAL(SDP_ServiceSearchResponse, sdp_response[0]);
+    uint16_t count = big_endian_read_16(sdp_response, 7);
+    (void)memcpy(handles, &sdp_response[9], count * 4);
+    return count;
+}
+
+// collect AttributeLists of ServiceAttribute or ServiceSearchAttribute response over all continuations
+static uint16_t sdp_attribute_request(uint8_t pdu_id, const uint8_t * prefix, uint16_t prefix_len, uint16_t max_bytes,
+                                      const uint8_t * attribute_id_list, uint8_t * attribute_lists){
+    uint8_t params[60];
+    uint16_t attribute_id_list_len = de_get_len(attribute_id_list);
+    (void)memcpy(params, prefix, prefix_len);
+    big_endian_store_16(params, prefix_len, max_bytes);
+    (void)memcpy(&params[prefix_len + 2], attribute_id_list, attribute_id_list_len);
+    uint16_t params_len = prefix_len + 2 + attribute_id_list_len;
+
+    uint8_t  continuation[20];
+    uint8_t  continuation_len = 0;
+    uint16_t total_len = 0;
+    uint16_t num_requests = 0;
+    do {
+        uint16_t len = remote_sdp_request(pdu_id, params, params_len, continuation, continuation_len);
+        CHECK(len >= 8);
+        CHECK_EQUAL(pdu_id + 1, sdp_response[0]);
+        uint16_t byte_count = big_endian_read_16(sdp_response, 5);
+        CHECK(byte_count <= max_bytes);
+        (void)memcpy(&attribute_lists[total_len], &sdp_response[7], byte_count);
+        total_len += byte_count;
+        continuation_len = sdp_response[7 + byte_count];
+        btstack_assert(continuation_len <= sizeof(continuation));
+        (void)memcpy(continuation, &sdp_response[8 + byte_count], continuation_len);
+        num_requests++;
+        btstack_assert(num_requests < 200);
+    } while (continuation_len > 0);
+    return total_len;
+}
+
+static uint16_t sdp_service_attribute(uint32_t handle, uint16_t max_bytes, const uint8_t * attribute_id_list, uint8_t * attribute_list){
+    uint8_t prefix[4];
+    big_endian_store_32(prefix, 0, handle);
+    return sdp_attribute_request(SDP_ServiceAttributeRequest, prefix, 4, max_bytes, attribute_id_list, attribute_list);
+}
+
+static uint16_t sdp_service_search_attribute(const uint8_t * pattern, uint16_t max_bytes, const uint8_t * attribute_id_list, uint8_t * attribute_lists){
+    return sdp_attribute_request(SDP_ServiceSearchAttributeRequest, pattern, de_get_len(pattern), max_bytes, attribute_id_list, attribute_lists);
+}
+
+// ServiceSearchPatterns
+static const uint8_t pattern_audio_source[]  = { 0x35, 0x03, 0x19, 0x11, 0x0a };
+static const uint8_t pattern_avdtp_browse[]  = { 0x35, 0x06, 0x19, 0x00, 0x19, 0x19, 0x10, 0x02 };
+static const uint8_t pattern_audio_source_uuid128[] = { 0x35, 0x11, 0x1c,
+    0x00, 0x00, 0x11, 0x0a, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb };
+static const uint8_t pattern_audio_source_uuid32[] = { 0x35, 0x05, 0x1a, 0x00, 0x00, 0x11, 0x0a };
+static const uint8_t pattern_custom_uuid128[] = { 0x35, 0x11, 0x1c,
+    0x12, 0x34, 0x56, 0x78, 0x12, 0x34, 0x56, 0x78, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 };
+static const uint8_t pattern_unknown[] = { 0x35, 0x03, 0x19, 0x12, 0x34 };
+static const uint8_t pattern_audio_source_unknown[] = { 0x35, 0x06, 0x19, 0x11, 0x0a, 0x19, 0x12, 0x34 };
+
+static const uint8_t * const patterns[] = {
+    pattern_audio_source, pattern_avdtp_browse, pattern_audio_source_uuid128, pattern_audio_source_uuid32,
+    pattern_custom_uuid128, pattern_unknown, pattern_audio_source_unknown,
+};
+
+// AttributeIDLists
+static const uint8_t attributes_all[]        = { 0x35, 0x05, 0x0a, 0x00, 0x00, 0xff, 0xff };
+static const uint8_t attributes_single[]     = { 0x35, 0x03, 0x09, 0x00, 0x04 };
+static const uint8_t attributes_range[]      = { 0x35, 0x05, 0x0a, 0x00, 0x02, 0x01, 0x00 };
+static const uint8_t attributes_none[]       = { 0x35, 0x05, 0x0a, 0x00, 0x02, 0x00, 0x03 };
+static const uint8_t attributes_mixed[]      = { 0x35, 0x0b, 0x09, 0x00, 0x01, 0x0a, 0x00, 0x05, 0x01, 0x00, 0x09, 0x03, 0x11 };
+
+static const uint8_t * const attribute_id_lists[] = {
+    attributes_all, attributes_single, attributes_range, attributes_none, attributes_mixed,
+};
+
+#define NUM_PATTERNS           (sizeof(patterns) / sizeof(patterns[0]))
+#define NUM_ATTRIBUTE_ID_LISTS (sizeof(attribute_id_lists) / sizeof(attribute_id_lists[0]))
+
+static const uint16_t max_byte_counts[] = { 7, 10, 33, 79, 0xffff };
+#define NUM_MAX_BYTE_COUNTS (sizeof(max_byte_counts) / sizeof(max_byte_counts[0]))
+
+TEST_GROUP(SDP_SERVER_RECORD_INDEX){
+    void setup(void){
+        // SDP Server keeps its channel, open it once
+        static bool initialized = false;
+        if (initialized) return;
+        initialized = true;
+        mock_hci_transport_init();
+        mock_hci_transport_register_packet_callback(&remote_handle_packet);
+        btstack_memory_init();
+        mock_btstack_run_loop_init();
+        hci_init(mock_hci_transport_get_instance(), NULL);
+        l2cap_init();
+        sdp_init();
+        mock_hci_transport_power_on();
+        mock_hci_transport_connect_classic(remote_addr, TEST_CON_HANDLE);
+        remote_open_sdp_channel();
+    }
+    void teardown(void){
+        sdp_unregister_service(INDEXED_HANDLE);
+        sdp_unregister_service(PLAIN_HANDLE);
+        sdp_unregister_service(CUSTOM_HANDLE);
+    }
+};
+
+TEST(SDP_SERVER_RECORD_INDEX, RegisterChecksIndex){
+    uint8_t index[sizeof(indexed_service_record_index)];
+    (void)memcpy(index, indexed_service_record_index, sizeof(index));
+    index[0]++;
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, sdp_register_service_with_index(indexed_service_record, index));
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, sdp_register_service_with_index(custom_service_record, indexed_service_record_index));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service_with_index(indexed_service_record, indexed_service_record_index));
+    CHECK_EQUAL(SDP_HANDLE_ALREADY_REGISTERED, sdp_register_service_with_index(indexed_service_record, indexed_service_record_index));
+}
+
+TEST(SDP_SERVER_RECORD_INDEX, ServiceSearch){
+    CHECK(sdp_cid != 0);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service_with_index(indexed_service_record, indexed_service_record_index));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service(plain_service_record));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service_with_index(custom_service_record, custom_service_record_index));
+
+    uint8_t handles[12];
+    uint16_t i;
+    // UUID16, UUID32 and Bluetooth Base UUID128 match indexed and plain record, last registered first
+    const uint8_t * const audio_source_patterns[] = { pattern_audio_source, pattern_avdtp_browse, pattern_audio_source_uuid128, pattern_audio_source_uuid32 };
+    for (i = 0; i < 4; i++){
+        CHECK_EQUAL(2, sdp_service_search(audio_source_patterns[i], handles));
+        CHECK_EQUAL(PLAIN_HANDLE,   big_endian_read_32(handles, 0));
+        CHECK_EQUAL(INDEXED_HANDLE, big_endian_read_32(handles, 4));
+    }
+    // 128-bit UUID is not in UUID32 list, but record is flagged to be parsed
+    CHECK_EQUAL(1, sdp_service_search(pattern_custom_uuid128, handles));
+    CHECK_EQUAL(CUSTOM_HANDLE, big_endian_read_32(handles, 0));
+    CHECK_EQUAL(0, sdp_service_search(pattern_unknown, handles));
+    CHECK_EQUAL(0, sdp_service_search(pattern_audio_source_unknown, handles));
+}
+
+TEST(SDP_SERVER_RECORD_INDEX, ServiceAttributeFullRangeIsRecord){
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service_with_index(indexed_service_record, indexed_service_record_index));
+    static uint8_t attribute_list[200];
+    uint16_t len = sdp_service_attribute(INDEXED_HANDLE, 0xffff, attributes_all, attribute_list);
+    CHECK_EQUAL(de_get_len(indexed_service_record) - 3, len - de_get_header_size(attribute_list));
+    MEMCMP_EQUAL(&indexed_service_record[3], &attribute_list[de_get_header_size(attribute_list)], len - de_get_header_size(attribute_list));
+}
+
+// same record registered with and without index gives the same responses for all requests and continuations
+TEST(SDP_SERVER_RECORD_INDEX, ResponsesMatchParsedRecord){
+    static uint8_t parsed[NUM_PATTERNS][NUM_ATTRIBUTE_ID_LISTS][NUM_MAX_BYTE_COUNTS][2][200];
+    static uint16_t parsed_len[NUM_PATTERNS][NUM_ATTRIBUTE_ID_LISTS][NUM_MAX_BYTE_COUNTS][2];
+    static uint8_t  attribute_lists[200];
+    uint16_t p, a, m;
+    int pass;
+    for (pass = 0; pass < 2; pass++){
+        if (pass == 0){
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service(indexed_service_record));
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service(custom_service_record));
+        } else {
+            sdp_unregister_service(INDEXED_HANDLE);
+            sdp_unregister_service(CUSTOM_HANDLE);
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service_with_index(indexed_service_record, indexed_service_record_index));
+            CHECK_EQUAL(ERROR_CODE_SUCCESS, sdp_register_service_with_index(custom_service_record, custom_service_record_index));
+        }
+        for (p = 0; p < NUM_PATTERNS; p++){
+            for (a = 0; a < NUM_ATTRIBUTE_ID_LISTS; a++){
+                for (m = 0; m < NUM_MAX_BYTE_COUNTS; m++){
+                    uint16_t len_attribute = (p == 0) ? sdp_service_attribute(INDEXED_HANDLE, max_byte_counts[m], attribute_id_lists[a], attribute_lists) : 0;
+                    if (pass == 0){
+                        parsed_len[p][a][m][0] = len_attribute;
+                        (void)memcpy(parsed[p][a][m][0], attribute_lists, len_attribute);
+                    } else {
+                        CHECK_EQUAL(parsed_len[p][a][m][0], len_attribute);
+                        MEMCMP_EQUAL(parsed[p][a][m][0], attribute_lists, len_attribute);
+                    }
+                    uint16_t len_search = sdp_service_search_attribute(patterns[p], max_byte_counts[m], attribute_id_lists[a], attribute_lists);
+                    if (pass == 0){
+                        parsed_len[p][a][m][1] = len_search;
+                        (void)memcpy(parsed[p][a][m][1], attribute_lists, len_search);
+                    } else {
+                        CHECK_EQUAL(parsed_len[p][a][m][1], len_search);
+                        MEMCMP_EQUAL(parsed[p][a][m][1], attribute_lists, len_search);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -31,6 +31,8 @@
 #define HCI_INCOMING_PRE_BUFFER_SIZE 4
 
 #define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+#define MAX_NR_SM_SETUP_CONTEXTS 2
+#define ENABLE_SM_LTK_CACHE
 
 #define NVM_NUM_LINK_KEYS 2
 
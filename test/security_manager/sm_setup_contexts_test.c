@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2026 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+
+#define BTSTACK_FILE__ "sm_setup_contexts_test.c"
+
+/*
+ *  sm_setup_contexts_test.c
+ *
+ *  Security Manager with multiple connections over simulated Controller
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "bluetooth.h"
+#include "bluetooth_company_id.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_util.h"
+#include "ble/le_device_db.h"
+#include "ble/sm.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "l2cap.h"
+
+#include "mock_btstack_run_loop.h"
+#include "mock_hci_transport.h"
+
+#define NUM_CONNECTIONS 3
+
+static const hci_con_handle_t con_handles[NUM_CONNECTIONS] = { 0x0040, 0x0041, 0x0042 };
+static const bd_addr_t remote_addrs[NUM_CONNECTIONS] = {
+    { 0x11, 0x22, 0x33, 0x44, 0x55, 0x01 },
+    { 0x11, 0x22, 0x33, 0x44, 0x55, 0x02 },
+    { 0x11, 0x22, 0x33, 0x44, 0x55, 0x03 },
+};
+
+static btstack_packet_callback_registration_t sm_event_callback_registration;
+static uint8_t  pairing_complete_status[NUM_CONNECTIONS];
+static uint16_t pairing_complete_events[NUM_CONNECTIONS];
+
+static int connection_index_for_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i = 0; i < NUM_CONNECTIONS; i++){
+        if (con_handles[i] == con_handle) return i;
+    }
+    return -1;
+}
+
+static void sm_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case SM_EVENT_JUST_WORKS_REQUEST:
+            sm_just_works_confirm(sm_event_just_works_request_get_handle(packet));
+            break;
+        case SM_EVENT_PAIRING_COMPLETE: {
+            int index = connection_index_for_handle(sm_event_pairing_complete_get_handle(packet));
+            btstack_assert(index >= 0);
+            pairing_complete_events[index]++;
+            pairing_complete_status[index] = sm_event_pairing_complete_get_status(packet);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void remote_send_sm_pdu(int index, const uint8_t * pdu, uint16_t len){
+    uint8_t packet[8 + 32];
+    btstack_assert(len <= (sizeof(packet) - 8));
+    little_endian_store_16(packet, 0, con_handles[index] | (0x02 << 12));
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
+    (void)memcpy(&packet[8], pdu, len);
+    mock_hci_transport_receive_packet(HCI_ACL_DATA_PACKET, packet, 8 + len);
+    mock_hci_transport_process();
+}
+
+// Just Works: responder key distribution as requested
+static void remote_send_pairing_request(int index, uint8_t responder_key_distribution){
+    const uint8_t pdu[] = { SM_CODE_PAIRING_REQUEST, IO_CAPABILITY_NO_INPUT_NO_OUTPUT, 0, SM_AUTHREQ_BONDING, 16, 0, responder_key_distribution };
+    remote_send_sm_pdu(index, pdu, sizeof(pdu));
+}
+
+// Controller calculates all-zero AES results, so confirm and random values of both sides are all zero
+static void remote_send_pairing_confirm(int index){
+    uint8_t pdu[17];
+    memset(pdu, 0, sizeof(pdu));
+    pdu[0] = SM_CODE_PAIRING_CONFIRM;
+    remote_send_sm_pdu(index, pdu, sizeof(pdu));
+}
+
+static void remote_send_pairing_random(int index){
+    uint8_t pdu[17];
+    memset(pdu, 0, sizeof(pdu));
+    pdu[0] = SM_CODE_PAIRING_RANDOM;
+    remote_send_sm_pdu(index, pdu, sizeof(pdu));
+}
+
+static void controller_send_ltk_request(int index, uint16_t ediv, const uint8_t * rand){
+    uint8_t params[13];
+    params[0] = HCI_SUBEVENT_LE_LONG_TERM_KEY_REQUEST;
+    little_endian_store_16(params, 1, con_handles[index]);
+    (void)memcpy(&params[3], rand, 8);
+    little_endian_store_16(params, 11, ediv);
+    mock_hci_transport_receive_event(HCI_EVENT_LE_META, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+static void controller_send_encryption_change(int index){
+    uint8_t params[4];
+    params[0] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(params, 1, con_handles[index]);
+    params[3] = 1;
+    mock_hci_transport_receive_event(HCI_EVENT_ENCRYPTION_CHANGE, params, sizeof(params));
+    mock_hci_transport_process();
+}
+
+// @returns number of SM PDUs with given code sent on connection, last one is copied into pdu if not NULL
+static uint16_t sm_pdus_sent(int index, uint8_t code, uint8_t * pdu, uint16_t pdu_size){
+    uint16_t count = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_ACL_DATA_PACKET) continue;
+        if ((little_endian_read_16(packet->buffer, 0) & 0x0fff) != con_handles[index]) continue;
+        if (little_endian_read_16(packet->buffer, 6) != L2CAP_CID_SECURITY_MANAGER_PROTOCOL) continue;
+        if (packet->buffer[8] != code) continue;
+        count++;
+        if (pdu != NULL){
+            uint16_t len = little_endian_read_16(packet->buffer, 4);
+            (void)memcpy(pdu, &packet->buffer[8], btstack_min(len, pdu_size));
+        }
+    }
+    return count;
+}
+
+static uint16_t ltk_request_replies_sent(int index, uint8_t * ltk){
+    uint16_t count = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_packets(); i++){
+        const mock_hci_transport_packet_t * packet = mock_hci_transport_get_packet(i);
+        if (packet->type != HCI_COMMAND_DATA_PACKET) continue;
+        if (little_endian_read_16(packet->buffer, 0) != hci_le_long_term_key_request_reply.opcode) continue;
+        if (little_endian_read_16(packet->buffer, 3) != con_handles[index]) continue;
+        count++;
+        if (ltk != NULL){
+            (void)memcpy(ltk, &packet->buffer[5], 16);
+        }
+    }
+    return count;
+}
+
+TEST_GROUP(SMSetupContexts){
+    void setup(void){
+        // btstack_crypto registers with HCI only once, keep stack running for all tests
+        static bool initialized = false;
+        if (!initialized){
+            initialized = true;
+            mock_hci_transport_init();
+            btstack_memory_init();
+            mock_btstack_run_loop_init();
+            hci_init(mock_hci_transport_get_instance(), NULL);
+            l2cap_init();
+            le_device_db_init();
+            sm_init();
+            sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+            sm_set_authentication_requirements(SM_AUTHREQ_BONDING);
+            sm_event_callback_registration.callback = &sm_event_handler;
+            sm_add_event_handler(&sm_event_callback_registration);
+            mock_hci_transport_power_on();
+        }
+        memset(pairing_complete_status, 0xff, sizeof(pairing_complete_status));
+        memset(pairing_complete_events, 0, sizeof(pairing_complete_events));
+        int i;
+        for (i = 0; i < NUM_CONNECTIONS; i++){
+            mock_hci_transport_connect_le(remote_addrs[i], con_handles[i]);
+        }
+        mock_hci_transport_process();
+        mock_hci_transport_clear_packets();
+    }
+
+    void teardown(void){
+        // release setup contexts
+        int i;
+        for (i = 0; i < NUM_CONNECTIONS; i++){
+            mock_hci_transport_disconnect(con_handles[i], ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION);
+        }
+        mock_hci_transport_process();
+    }
+};
+
+TEST(SMSetupContexts, ConcurrentPairing){
+    CHECK_EQUAL(2, MAX_NR_SM_SETUP_CONTEXTS);
+
+    // connection 0 requests encryption key, connection 1 identity key
+    remote_send_pairing_request(0, SM_KEYDIST_ENC_KEY);
+    remote_send_pairing_request(1, SM_KEYDIST_ID_KEY);
+    uint8_t pdu[17];
+    CHECK_EQUAL(1, sm_pdus_sent(0, SM_CODE_PAIRING_RESPONSE, pdu, sizeof(pdu)));
+    CHECK_EQUAL(SM_KEYDIST_ENC_KEY, pdu[6]);
+    CHECK_EQUAL(1, sm_pdus_sent(1, SM_CODE_PAIRING_RESPONSE, pdu, sizeof(pdu)));
+    CHECK_EQUAL(SM_KEYDIST_ID_KEY, pdu[6]);
+
+    // interleaved pairing phases
+    remote_send_pairing_confirm(0);
+    remote_send_pairing_confirm(1);
+    CHECK_EQUAL(1, sm_pdus_sent(0, SM_CODE_PAIRING_CONFIRM, NULL, 0));
+    CHECK_EQUAL(1, sm_pdus_sent(1, SM_CODE_PAIRING_CONFIRM, NULL, 0));
+
+    remote_send_pairing_random(1);
+    remote_send_pairing_random(0);
+    CHECK_EQUAL(1, sm_pdus_sent(0, SM_CODE_PAIRING_RANDOM, NULL, 0));
+    CHECK_EQUAL(1, sm_pdus_sent(1, SM_CODE_PAIRING_RANDOM, NULL, 0));
+
+    // STK used for encryption
+    const uint8_t null_rand[8] = { 0 };
+    controller_send_ltk_request(0, 0, null_rand);
+    controller_send_ltk_request(1, 0, null_rand);
+    CHECK_EQUAL(1, ltk_request_replies_sent(0, NULL));
+    CHECK_EQUAL(1, ltk_request_replies_sent(1, NULL));
+
+    // third connection has to wait for a free setup context
+    remote_send_pairing_request(2, SM_KEYDIST_ENC_KEY);
+    CHECK_EQUAL(0, sm_pdus_sent(2, SM_CODE_PAIRING_RESPONSE, NULL, 0));
+
+    // each connection distributes the keys it negotiated
+    controller_send_encryption_change(1);
+    controller_send_encryption_change(0);
+    CHECK_EQUAL(1, sm_pdus_sent(0, SM_CODE_ENCRYPTION_INFORMATION, NULL, 0));
+    CHECK_EQUAL(1, sm_pdus_sent(0, SM_CODE_MASTER_IDENTIFICATION, NULL, 0));
+    CHECK_EQUAL(0, sm_pdus_sent(0, SM_CODE_IDENTITY_INFORMATION, NULL, 0));
+    CHECK_EQUAL(0, sm_pdus_sent(1, SM_CODE_ENCRYPTION_INFORMATION, NULL, 0));
+    CHECK_EQUAL(1, sm_pdus_sent(1, SM_CODE_IDENTITY_INFORMATION, NULL, 0));
+    CHECK_EQUAL(1, sm_pdus_sent(1, SM_CODE_IDENTITY_ADDRESS_INFORMATION, NULL, 0));
+
+    CHECK_EQUAL(1, pairing_complete_events[0]);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, pairing_complete_status[0]);
+    CHECK_EQUAL(1, pairing_complete_events[1]);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, pairing_complete_status[1]);
+
+    // released setup context is used by waiting connection
+    CHECK_EQUAL(1, sm_pdus_sent(2, SM_CODE_PAIRING_RESPONSE, pdu, sizeof(pdu)));
+    CHECK_EQUAL(SM_KEYDIST_ENC_KEY, pdu[6]);
+}
+TEST(SMSetupContexts, CachedLtkWhileContextsInUse){
+    // LTK reconstructed from EDIV and Rand gets cached
+    const uint8_t rand[8] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+    controller_send_ltk_request(2, 0x1234, rand);
+    uint8_t ltk[16];
+    CHECK_EQUAL(1, ltk_request_replies_sent(2, ltk));
+
+    // all setup contexts in use
+    remote_send_pairing_request(0, SM_KEYDIST_ENC_KEY);
+    remote_send_pairing_request(1, SM_KEYDIST_ENC_KEY);
+    CHECK_EQUAL(1, sm_pdus_sent(0, SM_CODE_PAIRING_RESPONSE, NULL, 0));
+    CHECK_EQUAL(1, sm_pdus_sent(1, SM_CODE_PAIRING_RESPONSE, NULL, 0));
+
+    // re-encryption with cached LTK is served
+    controller_send_ltk_request(2, 0x1234, rand);
+    uint8_t cached_ltk[16];
+    CHECK_EQUAL(2, ltk_request_replies_sent(2, cached_ltk));
+    MEMCMP_EQUAL(ltk, cached_ltk, 16);
+
+    // other EDIV requires setup context
+    controller_send_ltk_request(2, 0x4321, rand);
+    CHECK_EQUAL(2, ltk_request_replies_sent(2, NULL));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
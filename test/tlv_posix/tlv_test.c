@@ -181,6 +181,47 @@ TEST(BSTACK_TLV, TestWriteDeleteResetReadDeleteRead){
     CHECK_EQUAL(size, 0);
 }
 
+TEST(BSTACK_TLV, TestCompaction){
+    uint8_t buffer[100];
+    uint32_t i;
+    // two entries that are kept, many updates of a third one
+    memset(buffer, 0x11, sizeof(buffer));
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, TAG('a','a','a','a'), buffer, sizeof(buffer));
+    btstack_tlv_impl->store_tag(&btstack_tlv_context, TAG('b','b','b','b'), buffer, 10);
+    for (i=0;i<200;i++){
+        buffer[0] = (uint8_t) i;
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, TAG('c','c','c','c'), buffer, sizeof(buffer));
+    }
+    btstack_tlv_impl->delete_tag(&btstack_tlv_context, TAG('b','b','b','b'));
+
+    // file is compacted
+    CHECK_TRUE(btstack_tlv_context.file_size < 200 * sizeof(buffer));
+
+    reopen_db();
+
+    int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, TAG('a','a','a','a'), buffer, sizeof(buffer));
+    CHECK_EQUAL(sizeof(buffer), size);
+    CHECK_EQUAL(0x11, buffer[0]);
+    size = btstack_tlv_impl->get_tag(&btstack_tlv_context, TAG('b','b','b','b'), buffer, sizeof(buffer));
+    CHECK_EQUAL(0, size);
+    size = btstack_tlv_impl->get_tag(&btstack_tlv_context, TAG('c','c','c','c'), buffer, sizeof(buffer));
+    CHECK_EQUAL(sizeof(buffer), size);
+    CHECK_EQUAL(199, buffer[0]);
+}
+
+TEST(BSTACK_TLV, TestManyTags){
+    uint32_t i;
+    for (i=0;i<100;i++){
+        btstack_tlv_impl->store_tag(&btstack_tlv_context, i, (const uint8_t *) &i, sizeof(i));
+    }
+    reopen_db();
+    for (i=0;i<100;i++){
+        uint32_t value = 0xffffffff;
+        int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, i, (uint8_t *) &value, sizeof(value));
+        CHECK_EQUAL(sizeof(value), size);
+        CHECK_EQUAL(i, value);
+    }
+}
 
 int main (int argc, const char * argv[]){
 	hci_dump_open("tlv_test.pklg", HCI_DUMP_PACKETLOGGER);
@@ -0,0 +1,266 @@
+#!/usr/bin/env python
+# BlueKitchen GmbH (c) 2020
+
+# Generate typed builder functions for all HCI Commands defined in src/hci_cmd.c
+# They store parameters directly into the command buffer without parsing the format string at runtime
+
+import re
+import os
+import sys
+
+import btstack_parser as parser
+
+program_info = """
+BTstack HCI Command Builder Generator for BTstack
+Copyright 2020, BlueKitchen GmbH
+"""
+
+copyright = """/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+"""
+
+hfile_header_begin = """
+
+/*
+ *  hci_cmd_builder.h
+ *
+ *  @brief Create HCI Commands without format string parsing, see hci_send_prepared_cmd_packet
+ *  @note  Don't edit - generated by tool/btstack_hci_cmd_generator.py
+ *
+ */
+
+#ifndef HCI_CMD_BUILDER_H
+#define HCI_CMD_BUILDER_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include "btstack_config.h"
+#include "btstack_util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* API_START */
+
+"""
+
+hfile_header_end = """
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HCI_CMD_BUILDER_H
+"""
+
+builder_template = """/**
+ * @brief Create {command_name} command in buffer
+ * @param hci_cmd_buffer{param_docs}
+ * @return size of command packet
+ */
+static inline uint16_t {fn_name}(uint8_t * hci_cmd_buffer{params}){{
+    little_endian_store_16(hci_cmd_buffer, 0, 0x{opcode:04x});
+    hci_cmd_buffer[2] = {param_len};
+{code}    return {size};
+}}
+"""
+
+builder_unsupported = """/**
+ * @brief Create {command_name} command in buffer
+ * @note: format {format} not supported
+ */
+"""
+
+param_types = {
+    '1' : 'uint8_t',
+    '2' : 'uint16_t',
+    '3' : 'uint32_t',
+    '4' : 'uint32_t',
+    'H' : 'hci_con_handle_t',
+    'B' : 'const bd_addr_t',
+    'D' : 'const uint8_t *',
+    'E' : 'const uint8_t *',
+    'N' : 'const char *',
+    'P' : 'const uint8_t *',
+    'A' : 'const uint8_t *',
+    'Q' : 'const uint8_t *',
+}
+
+param_sizes = { '1' : 1, '2' : 2, '3' : 3, '4' : 4, 'H' : 2, 'B' : 6, 'D' : 8, 'E' : 240, 'N' : 248, 'P' : 16, 'A' : 31, 'Q' : 32 }
+
+param_store = {
+    '1' : '    hci_cmd_buffer[{offset}] = {name};\n',
+    '2' : '    little_endian_store_16(hci_cmd_buffer, {offset}, {name});\n',
+    'H' : '    little_endian_store_16(hci_cmd_buffer, {offset}, {name});\n',
+    '3' : '    little_endian_store_24(hci_cmd_buffer, {offset}, {name});\n',
+    '4' : '    little_endian_store_32(hci_cmd_buffer, {offset}, {name});\n',
+    'B' : '    reverse_bd_addr({name}, &hci_cmd_buffer[{offset}]);\n',
+    'D' : '    (void)memcpy(&hci_cmd_buffer[{offset}], {name}, 8);\n',
+    'E' : '    (void)memcpy(&hci_cmd_buffer[{offset}], {name}, 240);\n',
+    'P' : '    (void)memcpy(&hci_cmd_buffer[{offset}], {name}, 16);\n',
+    'A' : '    (void)memcpy(&hci_cmd_buffer[{offset}], {name}, 31);\n',
+    'Q' : '    reverse_256({name}, &hci_cmd_buffer[{offset}]);\n',
+    'N' : """    uint16_t {name}_len = (uint16_t) strlen({name});
+    if ({name}_len > 248u){{
+        {name}_len = 248u;
+    }}
+    (void)memcpy(&hci_cmd_buffer[{offset}], {name}, {name}_len);
+    (void)memset(&hci_cmd_buffer[{offset} + {name}_len], 0, 248u - {name}_len);
+""",
+}
+
+# avoid C/C++ keywords as parameter names, header is also used from C++
+reserved_names = ['auto', 'break', 'case', 'char', 'class', 'const', 'default', 'delete', 'do', 'double', 'else', 'enum',
+                  'float', 'for', 'int', 'long', 'new', 'private', 'protected', 'public', 'register', 'short', 'signed',
+                  'switch', 'template', 'this', 'union', 'unsigned', 'virtual', 'void', 'volatile', 'while']
+
+def parse_commands(path, defines):
+    # returns list of ('cmd', name, opcode, format, params, brief) and ('directive', line) in order of hci_cmd.c
+    items = []
+    params = []
+    in_template = False
+    template_done = False
+    command = None
+    with open(path, 'rt') as fin:
+        for line in fin:
+            if line.startswith('uint16_t hci_cmd_create_from_template'):
+                in_template = True
+                continue
+            if in_template:
+                if line.startswith('}'):
+                    in_template = False
+                    template_done = True
+                continue
+            if not template_done:
+                continue
+            if re.match(r'\s*#\s*(if|ifdef|ifndef|else|elif|endif)\b', line):
+                items.append(('directive', line.strip()))
+                continue
+            parts = re.match(r'.*@param\s+(\w+)', line)
+            if parts:
+                params.append(parts.groups()[0].lower())
+                continue
+            declaration = re.match(r'const\s+hci_cmd_t\s+(\w+)[\s=]+', line)
+            if declaration:
+                command = declaration.groups()[0]
+                continue
+            if command is None:
+                continue
+            definition = re.match(r'\s*OPCODE\(\s*(\w+)\s*,\s*(\w+)\s*\)\s*,\s*"(\w*)"', line)
+            if definition:
+                (ogf, ocf, format) = definition.groups()
+                ogf = int(defines.get(ogf, ogf), 0)
+                opcode = (ogf << 10) | int(ocf, 0)
+            else:
+                definition = re.match(r'\s*(0x[0-9a-fA-F]+)\s*,\s*"(\w*)"', line)
+                if not definition:
+                    continue
+                (opcode, format) = definition.groups()
+                opcode = int(opcode, 16)
+            # use generic names if params don't match format
+            if len(params) != len(format) or len(set(params)) != len(params):
+                params = ['arg%u' % (i + 1) for i in range(len(format))]
+            params = [name + '_param' if name in reserved_names else name for name in params]
+            items.append(('cmd', command, opcode, format, params))
+            params = []
+            command = None
+    return items
+
+def function_name(command_name):
+    if command_name.startswith('hci_'):
+        command_name = command_name[len('hci_'):]
+    return 'hci_cmd_create_' + command_name
+
+def create_builder(command_name, opcode, format, params):
+    if not all(f in param_types for f in format):
+        return builder_unsupported.format(command_name=command_name, format=format)
+    offset = 3
+    code = ''
+    param_list = ''
+    param_docs = ''
+    for f, name in zip(format, params):
+        param_list += ', %s %s' % (param_types[f], name)
+        param_docs += '\n * @param %s' % name
+        code += param_store[f].format(offset=offset, name=name)
+        offset += param_sizes[f]
+    return builder_template.format(command_name=command_name, fn_name=function_name(command_name), opcode=opcode,
+                                   param_docs=param_docs, params=param_list, param_len=offset - 3, code=code, size=offset)
+
+def prune_empty_blocks(items):
+    changed = True
+    while changed:
+        changed = False
+        for i in range(len(items) - 1):
+            (kind_a, text_a) = (items[i][0], items[i][1])
+            (kind_b, text_b) = (items[i+1][0], items[i+1][1])
+            if kind_a != 'directive' or kind_b != 'directive' or not text_b.startswith('#endif'):
+                continue
+            if text_a.startswith('#if'):
+                del items[i:i+2]
+                changed = True
+                break
+            if text_a.startswith('#else'):
+                del items[i]
+                changed = True
+                break
+    return items
+
+btstack_root = os.path.abspath(os.path.dirname(sys.argv[0]) + '/..')
+parser.set_btstack_root(btstack_root)
+gen_path = btstack_root + '/src/hci_cmd_builder.h'
+
+print(program_info)
+
+defines = parser.parse_defines()
+items = prune_empty_blocks(parse_commands(btstack_root + '/src/hci_cmd.c', defines))
+
+with open(gen_path, 'wt') as fout:
+    fout.write(copyright)
+    fout.write(hfile_header_begin)
+    for item in items:
+        if item[0] == 'directive':
+            fout.write(item[1] + '\n')
+        else:
+            (_, command_name, opcode, format, params) = item
+            fout.write(create_builder(command_name, opcode, format, params))
+            fout.write('\n')
+    fout.write(hfile_header_end)
+
+print('Done!')
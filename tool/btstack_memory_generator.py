@@ -95,6 +95,34 @@ extern "C" {
  */
 void btstack_memory_init(void);
 
+// Memory statistics per type, requires ENABLE_BTSTACK_MEMORY_STATISTICS
+typedef struct {
+    const char * name;
+    // number of items in pool, 0 if allocated by malloc
+    uint16_t pool_size;
+    uint16_t in_use;
+    uint16_t peak;
+    uint32_t failures;
+} btstack_memory_statistics_t;
+
+/**
+ * @brief Get number of types with memory statistics. Requires ENABLE_BTSTACK_MEMORY_STATISTICS
+ * @return num types
+ */
+uint16_t btstack_memory_statistics_num_types(void);
+
+/**
+ * @brief Get memory statistics for type. Requires ENABLE_BTSTACK_MEMORY_STATISTICS
+ * @param index < btstack_memory_statistics_num_types()
+ * @return statistics or NULL if index invalid
+ */
+const btstack_memory_statistics_t * btstack_memory_statistics_get(uint16_t index);
+
+/**
+ * @brief Log memory statistics for all types via log_info. Requires ENABLE_BTSTACK_MEMORY_STATISTICS
+ */
+void btstack_memory_statistics_dump(void);
+
 /* API_END */
 """
 
@@ -106,7 +134,9 @@ hfile_header_end = """
 #endif // BTSTACK_MEMORY_H
 """
 
-cfile_header_begin = """
+cfile_header_begin = """#define BTSTACK_FILE__ "btstack_memory.c"
+
+
 /*
  *  btstack_memory.h
  *
@@ -119,16 +149,170 @@ cfile_header_begin = """
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
 #include <stdlib.h>
 
+#ifdef ENABLE_BTSTACK_MEMORY_STATISTICS
+static void btstack_memory_track_get(btstack_memory_statistics_t * statistics, const void * buffer){
+    if (buffer == NULL){
+        statistics->failures++;
+        return;
+    }
+    statistics->in_use++;
+    if (statistics->in_use > statistics->peak){
+        statistics->peak = statistics->in_use;
+    }
+}
+static void btstack_memory_track_free(btstack_memory_statistics_t * statistics, const void * buffer){
+    if (buffer == NULL) return;
+    if (statistics->in_use == 0) return;
+    statistics->in_use--;
+}
+#define BTSTACK_MEMORY_STATISTICS(name, pool_size) static btstack_memory_statistics_t name##_statistics = { #name, pool_size, 0, 0, 0 };
+#define BTSTACK_MEMORY_TRACK_GET(name, buffer)     btstack_memory_track_get(&name##_statistics, buffer)
+#define BTSTACK_MEMORY_TRACK_FREE(name, buffer)    btstack_memory_track_free(&name##_statistics, buffer)
+#else
+#define BTSTACK_MEMORY_STATISTICS(name, pool_size)
+#define BTSTACK_MEMORY_TRACK_GET(name, buffer)     (void)(buffer)
+#define BTSTACK_MEMORY_TRACK_FREE(name, buffer)    (void)(buffer)
+#endif
+
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+// Single static arena shared by all types. Blocks are carved from the arena on demand
+// and returned to a free list per size class, which makes get and free O(1).
+// Size classes are multiples of 8 with 4 classes per power of two, e.g. 40, 48, 56, 64, 80, ...
+// MAX_NR_* are optional caps per type
+#ifndef BTSTACK_MEMORY_ARENA_SIZE
+#error "ENABLE_BTSTACK_MEMORY_ARENA requires BTSTACK_MEMORY_ARENA_SIZE in btstack_config.h"
+#endif
+
+#define BTSTACK_MEMORY_ARENA_UNLIMITED        0xffff
+#define BTSTACK_MEMORY_ARENA_NUM_SIZE_CLASSES 48
+#define BTSTACK_MEMORY_ARENA_INVALID_CLASS    0xff
+
+typedef struct btstack_memory_arena_block {
+    struct btstack_memory_arena_block * next;
+} btstack_memory_arena_block_t;
+
+typedef struct {
+    uint32_t item_size;
+    uint32_t block_size;
+    uint16_t max_items;
+    uint16_t num_items;
+    uint8_t  size_class;
+} btstack_memory_arena_type_t;
+
+static union {
+    uint64_t alignment;
+    uint8_t  data[BTSTACK_MEMORY_ARENA_SIZE];
+} btstack_memory_arena_storage;
+static uint32_t btstack_memory_arena_used;
+static btstack_memory_arena_block_t * btstack_memory_arena_free_lists[BTSTACK_MEMORY_ARENA_NUM_SIZE_CLASSES];
+
+static uint32_t btstack_memory_arena_class_size(uint8_t size_class){
+    if (size_class < 4){
+        return (size_class + 1u) * 8u;
+    }
+    uint8_t octave = (size_class - 4u) / 4u;
+    uint8_t step   = (size_class - 4u) % 4u;
+    return (32u << octave) + (step + 1u) * (8u << octave);
+}
+
+static void btstack_memory_arena_init(void){
+    btstack_memory_arena_used = 0;
+    memset(btstack_memory_arena_free_lists, 0, sizeof(btstack_memory_arena_free_lists));
+}
+
+static void btstack_memory_arena_type_init(btstack_memory_arena_type_t * type){
+    type->num_items  = 0;
+    type->size_class = BTSTACK_MEMORY_ARENA_INVALID_CLASS;
+    type->block_size = 0;
+    uint8_t size_class;
+    for (size_class = 0; size_class < BTSTACK_MEMORY_ARENA_NUM_SIZE_CLASSES; size_class++){
+        uint32_t block_size = btstack_memory_arena_class_size(size_class);
+        if (block_size >= type->item_size){
+            type->size_class = size_class;
+            type->block_size = block_size;
+            return;
+        }
+    }
+    log_error("item size %u exceeds largest arena size class", (unsigned int) type->item_size);
+}
+
+static void * btstack_memory_arena_get(btstack_memory_arena_type_t * type){
+    if (type->num_items >= type->max_items) return NULL;
+    if (type->size_class == BTSTACK_MEMORY_ARENA_INVALID_CLASS) return NULL;
+    btstack_memory_arena_block_t * block = btstack_memory_arena_free_lists[type->size_class];
+    if (block != NULL){
+        btstack_memory_arena_free_lists[type->size_class] = block->next;
+    } else {
+        if (type->block_size > (BTSTACK_MEMORY_ARENA_SIZE - btstack_memory_arena_used)) return NULL;
+        block = (btstack_memory_arena_block_t *) &btstack_memory_arena_storage.data[btstack_memory_arena_used];
+        btstack_memory_arena_used += type->block_size;
+    }
+    type->num_items++;
+    memset(block, 0, type->item_size);
+    return block;
+}
+
+static void btstack_memory_arena_free(btstack_memory_arena_type_t * type, void * buffer){
+    if (buffer == NULL) return;
+    btstack_memory_arena_block_t * block = (btstack_memory_arena_block_t *) buffer;
+    block->next = btstack_memory_arena_free_lists[type->size_class];
+    btstack_memory_arena_free_lists[type->size_class] = block;
+    type->num_items--;
+}
+#endif
+
 """
 
+cfile_statistics = """
+uint16_t btstack_memory_statistics_num_types(void){
+    return (uint16_t) (sizeof(btstack_memory_statistics) / sizeof(btstack_memory_statistics[0]));
+}
+
+const btstack_memory_statistics_t * btstack_memory_statistics_get(uint16_t index){
+    if (index >= btstack_memory_statistics_num_types()) return NULL;
+    return btstack_memory_statistics[index];
+}
+
+void btstack_memory_statistics_dump(void){
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    log_info("arena used %u of %u bytes", (unsigned int) btstack_memory_arena_used, (unsigned int) BTSTACK_MEMORY_ARENA_SIZE);
+#endif
+    uint16_t i;
+    for (i=0;i<btstack_memory_statistics_num_types();i++){
+        const btstack_memory_statistics_t * statistics = btstack_memory_statistics[i];
+        log_info("%-32s pool %3u, in use %3u, peak %3u, failures %u", statistics->name, statistics->pool_size,
+                 statistics->in_use, statistics->peak, (unsigned int) statistics->failures);
+    }
+}"""
+
 header_template = """STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void);
 void   btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME);"""
 
 code_template = """
 // MARK: STRUCT_TYPE
+#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+#ifdef POOL_COUNT
+BTSTACK_MEMORY_STATISTICS(STRUCT_NAME, POOL_COUNT)
+static btstack_memory_arena_type_t STRUCT_NAME_arena_type = { sizeof(STRUCT_TYPE), 0, POOL_COUNT, 0, 0 };
+#else
+BTSTACK_MEMORY_STATISTICS(STRUCT_NAME, 0)
+static btstack_memory_arena_type_t STRUCT_NAME_arena_type = { sizeof(STRUCT_TYPE), 0, BTSTACK_MEMORY_ARENA_UNLIMITED, 0, 0 };
+#endif
+STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
+    void * buffer = btstack_memory_arena_get(&STRUCT_NAME_arena_type);
+    BTSTACK_MEMORY_TRACK_GET(STRUCT_NAME, buffer);
+    return (STRUCT_NAME_t *) buffer;
+}
+void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    BTSTACK_MEMORY_TRACK_FREE(STRUCT_NAME, STRUCT_NAME);
+    btstack_memory_arena_free(&STRUCT_NAME_arena_type, STRUCT_NAME);
+}
+#else
+
 #if !defined(HAVE_MALLOC) && !defined(POOL_COUNT)
     #if defined(POOL_COUNT_OLD_NO)
         #error "Deprecated POOL_COUNT_OLD_NO defined instead of POOL_COUNT. Please update your btstack_config.h to use POOL_COUNT."
@@ -138,6 +322,7 @@ code_template = """
 #endif
 
 #ifdef POOL_COUNT
+BTSTACK_MEMORY_STATISTICS(STRUCT_NAME, POOL_COUNT)
 #if POOL_COUNT > 0
 static STRUCT_TYPE STRUCT_NAME_storage[POOL_COUNT];
 static btstack_memory_pool_t STRUCT_NAME_pool;
@@ -146,13 +331,16 @@ STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     if (buffer){
         memset(buffer, 0, sizeof(STRUCT_TYPE));
     }
+    BTSTACK_MEMORY_TRACK_GET(STRUCT_NAME, buffer);
     return (STRUCT_NAME_t *) buffer;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    BTSTACK_MEMORY_TRACK_FREE(STRUCT_NAME, STRUCT_NAME);
     btstack_memory_pool_free(&STRUCT_NAME_pool, STRUCT_NAME);
 }
 #else
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
+    BTSTACK_MEMORY_TRACK_GET(STRUCT_NAME, NULL);
     return NULL;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
@@ -161,20 +349,29 @@ void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
 };
 #endif
 #elif defined(HAVE_MALLOC)
+BTSTACK_MEMORY_STATISTICS(STRUCT_NAME, 0)
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     void * buffer = malloc(sizeof(STRUCT_TYPE));
     if (buffer){
         memset(buffer, 0, sizeof(STRUCT_TYPE));
     }
+    BTSTACK_MEMORY_TRACK_GET(STRUCT_NAME, buffer);
     return (STRUCT_NAME_t *) buffer;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    BTSTACK_MEMORY_TRACK_FREE(STRUCT_NAME, STRUCT_NAME);
     free(STRUCT_NAME);
 }
+#endif
+
 #endif
 """
 
-init_template = """#if POOL_COUNT > 0
+statistics_template = """    &STRUCT_NAME_statistics,"""
+
+init_template = """#ifdef ENABLE_BTSTACK_MEMORY_ARENA
+    btstack_memory_arena_type_init(&STRUCT_NAME_arena_type);
+#elif POOL_COUNT > 0
     btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE));
 #endif"""
 
@@ -209,6 +406,9 @@ list_of_classic_structs = [
 list_of_le_structs = [
     ["gatt_client", "whitelist_entry", "sm_lookup_entry"],
 ]
+list_of_le_iso_structs = [
+    ["hci_iso_stream"],
+]
 list_of_mesh_structs = [
     ['mesh_network_pdu', 'mesh_transport_pdu', 'mesh_network_key', 'mesh_transport_key', 'mesh_virtual_address', 'mesh_subnet']
 ]
@@ -238,6 +438,12 @@ for struct_names in list_of_le_structs:
     for struct_name in struct_names:
         writeln(f, replacePlaceholder(header_template, struct_name))
 writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS")
+for struct_names in list_of_le_iso_structs:
+    writeln(f, "// "+ ", ".join(struct_names))
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(header_template, struct_name))
+writeln(f, "#endif")
 writeln(f, "#ifdef ENABLE_MESH")
 for struct_names in list_of_mesh_structs:
     writeln(f, "// "+ ", ".join(struct_names))
@@ -267,6 +473,12 @@ for struct_names in list_of_le_structs:
         writeln(f, replacePlaceholder(code_template, struct_name))
     writeln(f, "")
 writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS")
+for struct_names in list_of_le_iso_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(code_template, struct_name))
+    writeln(f, "")
+writeln(f, "#endif")
 writeln(f, "#ifdef ENABLE_MESH")
 for struct_names in list_of_mesh_structs:
     for struct_name in struct_names:
@@ -275,8 +487,41 @@ for struct_names in list_of_mesh_structs:
 writeln(f, "#endif")
 
 
+writeln(f, "#ifdef ENABLE_BTSTACK_MEMORY_STATISTICS")
+writeln(f, "static btstack_memory_statistics_t * const btstack_memory_statistics[] = {")
+for struct_names in list_of_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#ifdef ENABLE_CLASSIC")
+for struct_names in list_of_classic_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_BLE")
+for struct_names in list_of_le_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS")
+for struct_names in list_of_le_iso_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_MESH")
+for struct_names in list_of_mesh_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(statistics_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "};")
+writeln(f, cfile_statistics)
+writeln(f, "#endif")
+writeln(f, "")
+
 writeln(f, "// init")
 writeln(f, "void btstack_memory_init(void){")
+writeln(f, "#ifdef ENABLE_BTSTACK_MEMORY_ARENA")
+writeln(f, "    btstack_memory_arena_init();")
+writeln(f, "#endif")
 for struct_names in list_of_structs:
     for struct_name in struct_names:
         writeln(f, replacePlaceholder(init_template, struct_name))
@@ -290,6 +535,11 @@ for struct_names in list_of_le_structs:
     for struct_name in struct_names:
         writeln(f, replacePlaceholder(init_template, struct_name))
 writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_LE_ISOCHRONOUS_STREAMS")
+for struct_names in list_of_le_iso_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(init_template, struct_name))
+writeln(f, "#endif")
 writeln(f, "#ifdef ENABLE_MESH")
 for struct_names in list_of_mesh_structs:
     for struct_name in struct_names:
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# BlueKitchen GmbH (c) 2020
+
+# latency histograms between trace points from ENABLE_BTSTACK_TRACE
+#
+# trace records are written by btstack_trace_dump as log messages into a PacketLogger file (hci_dump.pklg),
+# either as file or captured via RTT, or into the console output of HCI_DUMP_STDOUT:
+#   "btstack_trace <timestamps per second> <lost records> <hex records>"
+#
+# record (9 bytes, little endian):
+#   uint32_t timestamp
+#   uint8_t  point         see btstack_trace_point_t in src/btstack_trace.h
+#   uint16_t id            con handle or local cid
+#   uint16_t len
+#
+# Each RX or TX path is processed synchronously, so the latency of a stage is the time between a trace point
+# and the one recorded before, e.g. hci_acl_rx -> l2cap_rx. Transitions with a gap larger than the
+# max gap are ignored as they belong to different packets.
+
+import struct
+import sys
+
+trace_points = [
+	'hci_event_rx',
+	'hci_acl_rx',
+	'hci_sco_rx',
+	'hci_command_tx',
+	'hci_acl_tx',
+	'l2cap_rx',
+	'l2cap_tx',
+	'rfcomm_rx',
+	'rfcomm_tx',
+	'att_rx',
+	'att_tx',
+	'avdtp_rx',
+	'avdtp_tx',
+	'mesh_network_rx',
+	'mesh_network_rx_decoded',
+	'mesh_network_tx',
+	'mesh_network_tx_encrypted',
+]
+
+marker = 'btstack_trace '
+
+def point_name(point):
+	if point < len(trace_points):
+		return trace_points[point]
+	if point >= 0x80:
+		return 'application_%u' % (point - 0x80)
+	return 'point_%u' % point
+
+def parse_message(message, records):
+	# returns timestamps per second and lost records
+	fields = message[len(marker):].split()
+	if len(fields) < 2:
+		return None
+	rate = int(fields[0])
+	lost = int(fields[1])
+	if len(fields) > 2:
+		data = bytes.fromhex(fields[2])
+		for pos in range(0, len(data) - 8, 9):
+			records.append(struct.unpack_from('<IBHH', data, pos))
+	return (rate, lost)
+
+def read_messages(path):
+	with open(path, 'rb') as f:
+		data = f.read()
+	pos = data.find(marker.encode())
+	if pos < 0:
+		return []
+	# console output of HCI_DUMP_STDOUT
+	if data[0:1] == b'[':
+		messages = []
+		for line in data.decode('utf-8', 'replace').splitlines():
+			index = line.find(marker)
+			if index >= 0:
+				messages.append(line[index:])
+		return messages
+	# PacketLogger
+	messages = []
+	pos = 0
+	while pos + 13 <= len(data):
+		(record_len, ts_sec, ts_usec, packet_type) = struct.unpack_from('>IIIB', data, pos)
+		if record_len < 9 or pos + 4 + record_len > len(data):
+			print('Error parsing pklg at offset %u (%x).' % (pos, pos))
+			break
+		if packet_type == 0xfc:
+			message = data[pos+13:pos+4+record_len].decode('utf-8', 'replace')
+			if message.startswith(marker):
+				messages.append(message)
+		pos += 4 + record_len
+	return messages
+
+def percentile(values, p):
+	return values[min(len(values) - 1, (len(values) * p) // 100)]
+
+if len(sys.argv) < 2:
+	print('Latency histograms for trace points from ENABLE_BTSTACK_TRACE')
+	print('Copyright 2020, BlueKitchen GmbH')
+	print('')
+	print('Usage: ', sys.argv[0], 'hci_dump.pklg [max gap in us, default 10000]')
+	exit(0)
+
+max_gap_us = 10000
+if len(sys.argv) > 2:
+	max_gap_us = int(sys.argv[2])
+
+records = []
+rate = 1000
+lost = 0
+for message in read_messages(sys.argv[1]):
+	result = parse_message(message, records)
+	if result is not None:
+		(rate, lost) = result
+
+if len(records) == 0:
+	print('No trace records found')
+	exit(0)
+
+# collect latencies per transition
+latencies = {}
+for i in range(1, len(records)):
+	(previous_timestamp, previous_point, _, _) = records[i-1]
+	(timestamp, point, _, _) = records[i]
+	delta_ns = ((timestamp - previous_timestamp) & 0xffffffff) * 1000000000 // rate
+	if delta_ns > max_gap_us * 1000:
+		continue
+	transition = '%s -> %s' % (point_name(previous_point), point_name(point))
+	latencies.setdefault(transition, []).append(delta_ns)
+
+print('%u records, %u lost, %u timestamps per second' % (len(records), lost, rate))
+print('')
+print('%-48s %8s %10s %10s %10s %10s %10s' % ('transition', 'count', 'min ns', 'p50 ns', 'p90 ns', 'p99 ns', 'max ns'))
+for transition in sorted(latencies, key=lambda t: -len(latencies[t])):
+	values = sorted(latencies[transition])
+	print('%-48s %8u %10u %10u %10u %10u %10u' % (transition, len(values), values[0], percentile(values, 50),
+		percentile(values, 90), percentile(values, 99), values[-1]))
+
+# histograms with power of two buckets in ns
+for transition in sorted(latencies, key=lambda t: -len(latencies[t])):
+	values = latencies[transition]
+	buckets = {}
+	for value in values:
+		bucket = 0
+		while (1 << bucket) <= value:
+			bucket += 1
+		buckets[bucket] = buckets.get(bucket, 0) + 1
+	print('')
+	print(transition)
+	for bucket in sorted(buckets):
+		lower = 0 if bucket == 0 else 1 << (bucket - 1)
+		count = buckets[bucket]
+		bar = '#' * max(1, (count * 50) // len(values))
+		print('  %10u - %10u ns %8u %s' % (lower, (1 << bucket) - 1, count, bar))
@@ -132,6 +132,11 @@ defines_for_characteristics = []
 defines_for_services = []
 include_paths = []
 database_hash_message = bytearray()
+uuid16_index = dict()
+service_end_handles = dict()
+att_db_offset = 0
+current_attribute_offset = 0
+callback_slots = []
 
 handle = 1
 total_size = 0
@@ -345,11 +350,35 @@ def serviceDefinitionComplete(fout):
     global services
     if current_service_uuid_string:
         fout.write("\n")
+        service_end_handles[current_service_start_handle] = handle-1
         # print("append service %s = [%d, %d]" % (current_characteristic_uuid_string, current_service_start_handle, handle-1))
         defines_for_services.append('#define ATT_SERVICE_%s_START_HANDLE 0x%04x' % (current_service_uuid_string, current_service_start_handle))
         defines_for_services.append('#define ATT_SERVICE_%s_END_HANDLE 0x%04x' % (current_service_uuid_string, handle-1))
         services[current_service_uuid_string] = [current_service_start_handle, handle-1]
 
+def write_attribute_size(fout, size):
+    # track offset of attribute in att db for uuid16 index
+    global att_db_offset
+    global current_attribute_offset
+    current_attribute_offset = att_db_offset
+    att_db_offset = att_db_offset + size
+    write_16(fout, size)
+
+def uuid16_index_append(handle, uuid16):
+    uuid16_index.setdefault(uuid16, []).append((handle, current_attribute_offset))
+
+def uuid16_index_append_uuid(handle, uuid):
+    # 128-bit UUIDs based on the Bluetooth Base UUID are found by their 16-bit UUID as well
+    bluetooth_base_uuid = [0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00]
+    if len(uuid) == 2:
+        uuid16_index_append(handle, uuid[0] | (uuid[1] << 8))
+    elif uuid[0:12] == bluetooth_base_uuid[0:12] and uuid[14:16] == bluetooth_base_uuid[14:16]:
+        uuid16_index_append(handle, uuid[12] | (uuid[13] << 8))
+
+def callback_slot_append(handle, name):
+    # dynamic attributes get a slot in callback table for att_server_set_callback_slots
+    callback_slots.append((handle, name))
+
 def dump_flags(fout, flags):
     global security_permsission
     encryption_key_size = encryption_key_size_from_flags(flags)
@@ -409,10 +438,11 @@ def parseService(fout, parts, service_type):
         size += 4
 
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, service_type)
+    uuid16_index_append(handle, service_type)
     write_uuid(fout, uuid)
     fout.write("\n")
 
@@ -451,10 +481,11 @@ def parseIncludeService(fout, parts):
     keyUUID = c_string_for_uuid(parts[1])
 
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, 0x2802)
+    uuid16_index_append(handle, 0x2802)
     write_16(fout, services[keyUUID][0])
     write_16(fout, services[keyUUID][1])
     if uuid_size > 0:
@@ -507,10 +538,11 @@ def parseCharacteristic(fout, parts):
     characteristic_properties = gatt_characteristic_properties(properties)
     size = 2 + 2 + 2 + 2 + (1+2+uuid_size)
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, 0x2803)
+    uuid16_index_append(handle, 0x2803)
     write_8(fout, characteristic_properties)
     write_16(fout, handle+1)
     write_uuid(fout, uuid)
@@ -547,10 +579,11 @@ def parseCharacteristic(fout, parts):
     dump_flags(fout, value_flags)
 
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, value_flags)
     write_16(fout, handle)
     write_uuid(fout, uuid)
+    uuid16_index_append_uuid(handle, uuid)
     if uuid_is_database_hash:
         write_database_hash(fout)
     else:
@@ -561,6 +594,8 @@ def parseCharacteristic(fout, parts):
 
     fout.write("\n")
     defines_for_characteristics.append('#define ATT_CHARACTERISTIC_%s_VALUE_HANDLE 0x%04x' % (current_characteristic_uuid_string, handle))
+    if value_flags & property_flags['DYNAMIC']:
+        callback_slot_append(handle, 'ATT_CHARACTERISTIC_%s_VALUE' % current_characteristic_uuid_string)
     handle = handle + 1
 
     if add_client_characteristic_configuration(properties):
@@ -578,10 +613,11 @@ def parseCharacteristic(fout, parts):
         dump_flags(fout, flags)
 
         write_indent(fout)
-        write_16(fout, size)
+        write_attribute_size(fout, size)
         write_16(fout, flags)
         write_16(fout, handle)
         write_16(fout, 0x2902)
+        uuid16_index_append(handle, 0x2902)
         write_16(fout, 0)
         fout.write("\n")
 
@@ -589,6 +625,7 @@ def parseCharacteristic(fout, parts):
         database_hash_append_uint16(0x2902)
 
         defines_for_characteristics.append('#define ATT_CHARACTERISTIC_%s_CLIENT_CONFIGURATION_HANDLE 0x%04x' % (current_characteristic_uuid_string, handle))
+        callback_slot_append(handle, 'ATT_CHARACTERISTIC_%s_CLIENT_CONFIGURATION' % current_characteristic_uuid_string)
         handle = handle + 1
 
 
@@ -597,10 +634,11 @@ def parseCharacteristic(fout, parts):
         write_indent(fout)
         fout.write('// 0x%04x CHARACTERISTIC_EXTENDED_PROPERTIES\n' % (handle))
         write_indent(fout)
-        write_16(fout, size)
+        write_attribute_size(fout, size)
         write_16(fout, read_only_anybody_flags)
         write_16(fout, handle)
         write_16(fout, 0x2900)
+        uuid16_index_append(handle, 0x2900)
         write_16(fout, 1)   # Reliable Write
         fout.write("\n")
 
@@ -635,10 +673,11 @@ def parseCharacteristicUserDescription(fout, parts):
     dump_flags(fout, flags)
 
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, flags)
     write_16(fout, handle)
     write_16(fout, 0x2901)
+    uuid16_index_append(handle, 0x2901)
     if is_string(value):
         write_string(fout, value)
     else:
@@ -671,16 +710,18 @@ def parseServerCharacteristicConfiguration(fout, parts):
     dump_flags(fout, flags)
 
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, flags)
     write_16(fout, handle)
     write_16(fout, 0x2903)
+    uuid16_index_append(handle, 0x2903)
     fout.write("\n")
 
     database_hash_append_uint16(handle)
     database_hash_append_uint16(0x2903)
 
     defines_for_characteristics.append('#define ATT_CHARACTERISTIC_%s_SERVER_CONFIGURATION_HANDLE 0x%04x' % (current_characteristic_uuid_string, handle))
+    callback_slot_append(handle, 'ATT_CHARACTERISTIC_%s_SERVER_CONFIGURATION' % current_characteristic_uuid_string)
     handle = handle + 1
 
 def parseCharacteristicFormat(fout, parts):
@@ -704,10 +745,11 @@ def parseCharacteristicFormat(fout, parts):
     write_indent(fout)
     fout.write('// 0x%04x CHARACTERISTIC_FORMAT-%s\n' % (handle, '-'.join(parts[1:])))
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, 0x2904)
+    uuid16_index_append(handle, 0x2904)
     write_sequence(fout, format)
     write_sequence(fout, exponent)
     write_uuid(fout, unit)
@@ -731,10 +773,11 @@ def parseCharacteristicAggregateFormat(fout, parts):
     write_indent(fout)
     fout.write('// 0x%04x CHARACTERISTIC_AGGREGATE_FORMAT-%s\n' % (handle, '-'.join(parts[1:])))
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, 0x2905)
+    uuid16_index_append(handle, 0x2905)
     for identifier in parts[1:]:
         format_handle = presentation_formats[identifier]
         if format == 0:
@@ -761,10 +804,11 @@ def parseReportReference(fout, parts):
     write_indent(fout)
     fout.write('// 0x%04x REPORT_REFERENCE-%s\n' % (handle, '-'.join(parts[1:])))
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, 0x2908)
+    uuid16_index_append(handle, 0x2908)
     write_sequence(fout, report_id)
     write_sequence(fout, report_type)
     fout.write("\n")
@@ -783,10 +827,11 @@ def parseNumberOfDigitals(fout, parts):
     write_indent(fout)
     fout.write('// 0x%04x NUMBER_OF_DIGITALS-%s\n' % (handle, '-'.join(parts[1:])))
     write_indent(fout)
-    write_16(fout, size)
+    write_attribute_size(fout, size)
     write_16(fout, read_only_anybody_flags)
     write_16(fout, handle)
     write_16(fout, 0x2909)
+    uuid16_index_append(handle, 0x2909)
     write_sequence(fout, no_of_digitals)
     fout.write("\n")
     handle = handle + 1
@@ -976,6 +1021,66 @@ def listHandles(fout):
         fout.write(define)
         fout.write('\n')
 
+def writeUUID16Index(fout):
+    fout.write('\n')
+    fout.write('// UUID16 index for att_set_db_uuid16_index\n')
+    fout.write('// - list of uuid16 (16), num handles (16), handles (16) with offset in att db (16), sorted by uuid16 and handle\n')
+    fout.write('// - service declarations also store end handle (16) of each service\n')
+    fout.write('const uint8_t profile_uuid16_index[] =\n')
+    fout.write('{\n')
+    write_indent(fout)
+    fout.write('// UUID16 Index Version\n')
+    write_indent(fout)
+    fout.write('2,\n')
+    fout.write('\n')
+    for uuid16 in sorted(uuid16_index.keys()):
+        handles = uuid16_index[uuid16]
+        is_service = uuid16 in [0x2800, 0x2801]
+        write_indent(fout)
+        fout.write('// 0x%04x: %u handles\n' % (uuid16, len(handles)))
+        write_indent(fout)
+        write_16(fout, uuid16)
+        write_16(fout, len(handles))
+        for (handle, offset) in handles:
+            write_16(fout, handle)
+            # offset 0xffff: not indexed, found by handle
+            write_16(fout, offset if offset < 0xffff else 0xffff)
+            if is_service:
+                write_16(fout, service_end_handles[handle])
+        fout.write('\n')
+    write_indent(fout)
+    fout.write('// END\n')
+    write_indent(fout)
+    write_16(fout, 0)
+    fout.write('\n')
+    fout.write('};\n')
+
+def writeCallbackSlots(fout):
+    if len(callback_slots) > 255:
+        print("ERROR: %u dynamic attributes, at most 255 supported by --callback-slots" % len(callback_slots))
+        sys.exit(1)
+    fout.write('\n')
+    fout.write('//\n')
+    fout.write('// list callback slots of dynamic attributes for att_server_set_callback_slots\n')
+    fout.write('//\n')
+    for (slot, (attribute_handle, name)) in enumerate(callback_slots):
+        fout.write('#define %s_CALLBACK_SLOT %u\n' % (name, slot))
+    fout.write('#define PROFILE_CALLBACK_NUM_SLOTS %u\n' % len(callback_slots))
+    fout.write('\n')
+    fout.write('// callback slot + 1 by attribute handle, 0 for static attributes\n')
+    fout.write('#define PROFILE_CALLBACK_NUM_HANDLES %u\n' % handle)
+    fout.write('const uint8_t profile_callback_slots[] =\n')
+    fout.write('{\n')
+    slot_for_handle = dict()
+    for (slot, (attribute_handle, name)) in enumerate(callback_slots):
+        slot_for_handle[attribute_handle] = slot + 1
+    for line_start in range(0, handle, 16):
+        write_indent(fout)
+        for attribute_handle in range(line_start, min(line_start + 16, handle)):
+            write_8(fout, slot_for_handle.get(attribute_handle, 0))
+        fout.write('\n')
+    fout.write('};\n')
+
 def getFile( fileName ):
     for d in include_paths:
         fullFile = os.path.normpath(d + os.sep + fileName) # because Windows exists
@@ -998,6 +1103,10 @@ parser.add_argument('gattfile', metavar='gattfile', type=str,
         help='gatt file to be compiled')
 parser.add_argument('hfile', metavar='hfile', type=str,
         help='header file to be generated')
+parser.add_argument('--uuid16-index', action='store_true',
+        help='generate profile_uuid16_index for att_set_db_uuid16_index')
+parser.add_argument('--callback-slots', action='store_true',
+        help='generate profile_callback_slots for att_server_set_callback_slots')
 
 args = parser.parse_args()
 
@@ -1021,6 +1130,10 @@ try:
     ftemp = tempfile.TemporaryFile(mode='w+t')
     parse(args.gattfile, fin, filename, sys.argv[0], ftemp)
     listHandles(ftemp)
+    if args.uuid16_index:
+        writeUUID16Index(ftemp)
+    if args.callback_slots:
+        writeCallbackSlots(ftemp)
 
     # calc GATT Database Hash
     db_hash = aes_cmac(bytearray(16), database_hash_message)
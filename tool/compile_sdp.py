@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+#
+# SDP Service Record generator for use with BTstack
+# Copyright 2020 BlueKitchen GmbH
+#
+# Compiles SDP Service Record descriptions into const Data Element Sequences and a record index
+# for sdp_register_service_with_index. The record index contains all UUIDs of the record and the
+# offset of each attribute, so the SDP Server does not need to parse the record per query.
+#
+# Format of input file:
+# SERVICE_RECORD, NAME, SERVICE_RECORD_HANDLE
+# ATTRIBUTE, ATTRIBUTE_ID, ELEMENT
+#
+# ELEMENT:
+# - UINT8 | UINT16 | UINT32 | INT8 | INT16 | INT32 | BOOL, VALUE
+# - UUID16 | UUID32, VALUE
+# - UUID128, 0000110A-0000-1000-8000-00805F9B34FB
+# - STRING | URL, "text"
+# - NIL
+# - DES, followed by one element per line until END
+#
+# Numbers and IDs can be given as decimal or hex value, or by name from bluetooth_sdp.h,
+# e.g. BLUETOOTH_ATTRIBUTE_SERVICE_CLASS_ID_LIST or BLUETOOTH_SERVICE_CLASS_AUDIO_SOURCE.
+# The ServiceRecordHandle attribute is added automatically, attributes are sorted by ID.
+# Lines starting with # or // are comments.
+
+import argparse
+import codecs
+import csv
+import os
+import re
+import struct
+import sys
+
+header = '''
+// {0} generated from {1} for BTstack
+// it needs to be regenerated when the .sdp file is updated.
+
+// To generate {0}:
+// {2} {1} {0}
+
+// sdp record index format version 1
+
+#include <stdint.h>
+'''
+
+print('''
+SDP Service Record generator for use with BTstack
+Copyright 2020 BlueKitchen GmbH
+''')
+
+# data element types
+DE_NIL    = 0
+DE_UINT   = 1
+DE_INT    = 2
+DE_UUID   = 3
+DE_STRING = 4
+DE_BOOL   = 5
+DE_DES    = 6
+DE_URL    = 8
+
+# size index for fixed size elements
+size_index = { 1: 0, 2: 1, 4: 2, 8: 3, 16: 4}
+
+number_elements = {
+    'UINT8'  : (DE_UINT, 1),
+    'UINT16' : (DE_UINT, 2),
+    'UINT32' : (DE_UINT, 4),
+    'INT8'   : (DE_INT,  1),
+    'INT16'  : (DE_INT,  2),
+    'INT32'  : (DE_INT,  4),
+    'BOOL'   : (DE_BOOL, 1),
+    'UUID16' : (DE_UUID, 2),
+    'UUID32' : (DE_UUID, 4),
+}
+
+bluetooth_base_uuid = bytes.fromhex('0000000000001000800000805F9B34FB')
+
+SDP_RECORD_INDEX_VERSION = 1
+SDP_RECORD_INDEX_FLAG_UUID128 = 0x01
+
+BLUETOOTH_ATTRIBUTE_SERVICE_RECORD_HANDLE = 0x0000
+
+defines = dict()
+include_paths = []
+
+class CompileError(Exception):
+    pass
+
+def read_defines(infile):
+    result = dict()
+    with open (infile, 'rt') as fin:
+        for line in fin:
+            parts = re.match(r'#define\s+(\w+)\s+(\w+)', line)
+            if parts and len(parts.groups()) == 2:
+                (key, value) = parts.groups()
+                result[key] = int(value, 16) if value.lower().startswith('0x') else int(value)
+    return result
+
+def parse_number(text):
+    text = text.strip()
+    if text in defines:
+        return defines[text]
+    try:
+        return int(text, 0)
+    except ValueError:
+        raise CompileError("unknown value '%s'" % text)
+
+def data_element(de_type, size, payload):
+    return bytes([(de_type << 3) | size_index[size]]) + payload
+
+def data_element_variable(de_type, payload):
+    # use smallest length field
+    if len(payload) < 0x100:
+        return bytes([(de_type << 3) | 5, len(payload)]) + payload
+    if len(payload) < 0x10000:
+        return bytes([(de_type << 3) | 6]) + struct.pack('>H', len(payload)) + payload
+    raise CompileError('data element too long')
+
+def number_element(token, value):
+    (de_type, size) = number_elements[token]
+    if de_type == DE_INT:
+        minimum = -(1 << (8 * size - 1))
+        if value < minimum or value >= (1 << (8 * size - 1)):
+            raise CompileError('%s value %d out of range' % (token, value))
+        value &= (1 << (8 * size)) - 1
+    elif value < 0 or value >= (1 << (8 * size)):
+        raise CompileError('%s value 0x%x out of range' % (token, value))
+    return data_element(de_type, size, value.to_bytes(size, 'big'))
+
+def parse_uuid128(text):
+    uuid = text.strip().replace('-', '')
+    if not re.match(r'^[0-9a-fA-F]{32}$', uuid):
+        raise CompileError("invalid UUID128 '%s'" % text)
+    return bytes.fromhex(uuid)
+
+class Parser:
+
+    def __init__(self, fname_in, lines):
+        self.fname_in = fname_in
+        self.lines = lines
+        self.pos = 0
+        self.line_nr = 0
+
+    def next_line(self):
+        # returns list of fields or None at end of file
+        while self.pos < len(self.lines):
+            (self.line_nr, line) = self.lines[self.pos]
+            self.pos += 1
+            line = line.strip()
+            if len(line) == 0 or line.startswith('#') or line.startswith('//'):
+                continue
+            return [field.strip() for field in next(csv.reader([line], skipinitialspace=True))]
+        return None
+
+    def error(self, message):
+        raise CompileError('%s:%u: %s' % (self.fname_in, self.line_nr, message))
+
+    def parse_element(self, parts):
+        token = parts[0].upper()
+        try:
+            if token in number_elements:
+                if len(parts) != 2:
+                    self.error('%s requires a value' % token)
+                return number_element(token, parse_number(parts[1]))
+            if token == 'UUID128':
+                return data_element(DE_UUID, 16, parse_uuid128(parts[1]))
+            if token in ['STRING', 'URL']:
+                de_type = DE_STRING if token == 'STRING' else DE_URL
+                # quotes are removed by csv reader, text with commas has to be quoted
+                if len(parts) != 2:
+                    self.error('%s requires a single, quoted value' % token)
+                return data_element_variable(de_type, parts[1].encode('utf-8'))
+            if token == 'NIL':
+                return bytes([0])
+            if token == 'DES':
+                payload = bytes()
+                while True:
+                    element_parts = self.next_line()
+                    if element_parts is None:
+                        self.error('missing END for DES')
+                    if element_parts[0].upper() == 'END':
+                        return data_element_variable(DE_DES, payload)
+                    payload += self.parse_element(element_parts)
+        except CompileError as e:
+            if str(e).startswith(self.fname_in):
+                raise
+            self.error(str(e))
+        except IndexError:
+            self.error('%s requires a value' % token)
+        self.error("unknown element '%s'" % parts[0])
+
+    def parse(self):
+        records = []
+        record = None
+        while True:
+            parts = self.next_line()
+            if parts is None:
+                break
+            token = parts[0].upper()
+            if token == 'SERVICE_RECORD':
+                if len(parts) != 3:
+                    self.error('SERVICE_RECORD requires name and service record handle')
+                name = parts[1]
+                if not re.match(r'^[A-Za-z_]\w*$', name):
+                    self.error("invalid name '%s'" % name)
+                handle = parse_number(parts[2])
+                record = { 'name': name, 'handle': handle, 'attributes': dict() }
+                records.append(record)
+                continue
+            if token == 'ATTRIBUTE':
+                if record is None:
+                    self.error('ATTRIBUTE outside of SERVICE_RECORD')
+                if len(parts) < 3:
+                    self.error('ATTRIBUTE requires attribute ID and element')
+                try:
+                    attribute_id = parse_number(parts[1])
+                except CompileError as e:
+                    self.error(str(e))
+                if attribute_id == BLUETOOTH_ATTRIBUTE_SERVICE_RECORD_HANDLE:
+                    self.error('ServiceRecordHandle is set by SERVICE_RECORD')
+                if attribute_id in record['attributes']:
+                    self.error('attribute 0x%04x already defined' % attribute_id)
+                record['attributes'][attribute_id] = self.parse_element(parts[2:])
+                continue
+            self.error("unknown token '%s'" % parts[0])
+        return records
+
+def collect_uuids(element, uuids, flags):
+    # returns size of element, adds all UUIDs like sdp_record_matches_service_search_pattern finds them
+    de_type  = element[0] >> 3
+    de_size  = element[0] & 0x07
+    if de_size < 5:
+        header_size = 1
+        data_size = 1 << de_size if de_type != DE_NIL else 0
+    else:
+        header_size = 1 + (1 << (de_size - 5))
+        data_size = int.from_bytes(element[1:header_size], 'big')
+    data = element[header_size:header_size+data_size]
+    if de_type == DE_UUID:
+        if len(data) == 16:
+            if data[4:] != bluetooth_base_uuid[4:]:
+                return (header_size + data_size, flags | SDP_RECORD_INDEX_FLAG_UUID128)
+            uuid32 = int.from_bytes(data[0:4], 'big')
+        else:
+            uuid32 = int.from_bytes(data, 'big')
+        if uuid32 not in uuids:
+            uuids.append(uuid32)
+    if de_type == DE_DES:
+        pos = 0
+        while pos < len(data):
+            (element_size, flags) = collect_uuids(data[pos:], uuids, flags)
+            pos += element_size
+    return (header_size + data_size, flags)
+
+def compile_record(record):
+    attributes = dict(record['attributes'])
+    attributes[BLUETOOTH_ATTRIBUTE_SERVICE_RECORD_HANDLE] = number_element('UINT32', record['handle'])
+    payload = bytes()
+    # offsets are relative to start of record, as attribute ids and values follow the DES header
+    offsets = []
+    for attribute_id in sorted(attributes):
+        offsets.append((attribute_id, len(payload)))
+        payload += number_element('UINT16', attribute_id) + attributes[attribute_id]
+    # top-level DES always uses 16-bit length as de_create_sequence
+    if len(payload) >= 0x10000:
+        raise CompileError('service record %s too long' % record['name'])
+    record_data = bytes([(DE_DES << 3) | 6]) + struct.pack('>H', len(payload)) + payload
+    offsets = [(attribute_id, offset + 3) for (attribute_id, offset) in offsets]
+
+    uuids = []
+    (_, flags) = collect_uuids(record_data, uuids, 0)
+    if len(uuids) > 255:
+        raise CompileError('service record %s has more than 255 UUIDs' % record['name'])
+    index = bytes([SDP_RECORD_INDEX_VERSION, flags, len(uuids)])
+    for uuid32 in sorted(uuids):
+        index += struct.pack('<I', uuid32)
+    index += struct.pack('<H', len(offsets))
+    for (attribute_id, offset) in offsets:
+        index += struct.pack('<HH', attribute_id, offset)
+    index += struct.pack('<H', len(record_data))
+    return (record_data, index, sorted(uuids), offsets)
+
+def write_bytes(fout, data):
+    for pos in range(0, len(data), 16):
+        fout.write('    ' + ' '.join('0x%02x,' % byte for byte in data[pos:pos+16]) + '\n')
+
+def write_record(fout, record):
+    (record_data, index, uuids, offsets) = compile_record(record)
+    name = record['name']
+    fout.write('\n')
+    fout.write('// Service Record %s, ServiceRecordHandle 0x%08x\n' % (name, record['handle']))
+    fout.write('const uint8_t %s_service_record[] =\n' % name)
+    fout.write('{\n')
+    write_bytes(fout, record_data)
+    fout.write('}; // total size %u bytes\n' % len(record_data))
+    fout.write('\n')
+    fout.write('// Record index for sdp_register_service_with_index\n')
+    fout.write('// - version (8), flags (8), num UUIDs (8), UUID32 (32) sorted\n')
+    fout.write('// - num attributes (16), attribute ID (16) and offset in record (16), record size (16)\n')
+    fout.write('// - UUIDs: %s\n' % (', '.join('0x%04x' % uuid for uuid in uuids)))
+    for (attribute_id, offset) in offsets:
+        fout.write('// - attribute 0x%04x at offset %u\n' % (attribute_id, offset))
+    fout.write('const uint8_t %s_service_record_index[] =\n' % name)
+    fout.write('{\n')
+    write_bytes(fout, index)
+    fout.write('};\n')
+
+def getFile( fileName ):
+    for d in include_paths:
+        fullFile = os.path.normpath(d + os.sep + fileName) # because Windows exists
+        if os.path.isfile( fullFile ) == True:
+            return fullFile
+    print ("'{0}' not found".format( fileName ))
+    print ("Include paths: %s" % ", ".join(include_paths))
+    exit(-1)
+
+btstack_root = os.path.abspath(os.path.dirname(sys.argv[0]) + '/..')
+default_includes = [os.path.normpath(path) for path in [ btstack_root + '/src/']]
+
+parser = argparse.ArgumentParser(description='SDP Service Record generator for use with BTstack')
+
+parser.add_argument('-I', action='append', nargs=1, metavar='includes',
+        help='include search path for bluetooth_sdp.h (default: %s)' % ", ".join(default_includes))
+parser.add_argument('sdpfile', metavar='sdpfile', type=str,
+        help='sdp file to be compiled')
+parser.add_argument('hfile', metavar='hfile', type=str,
+        help='header file to be generated')
+
+args = parser.parse_args()
+
+# add include path arguments
+if args.I != None:
+    for d in args.I:
+        include_paths.append(os.path.normpath(d[0]))
+
+# append default include paths
+include_paths.extend(default_includes)
+
+try:
+    # read defines from bluetooth_sdp.h
+    defines = read_defines(getFile('bluetooth_sdp.h'))
+
+    with codecs.open (args.sdpfile, encoding='utf-8') as fin:
+        lines = list(enumerate(fin.read().splitlines(), start=1))
+    records = Parser(args.sdpfile, lines).parse()
+    if len(records) == 0:
+        raise CompileError('%s: no SERVICE_RECORD found' % args.sdpfile)
+
+    names = [record['name'] for record in records]
+    if len(names) != len(set(names)):
+        raise CompileError('%s: SERVICE_RECORD names have to be unique' % args.sdpfile)
+
+    with open (args.hfile, 'w') as fout:
+        fout.write(header.format(args.hfile, args.sdpfile, sys.argv[0]))
+        for record in records:
+            write_record(fout, record)
+
+    print('Created %s' % args.hfile)
+
+except CompileError as e:
+    print('Error: %s' % e)
+    sys.exit(1)
+
+except IOError as e:
+    print(e)
+    sys.exit(1)
+
+print('Compilation successful!\n')
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# BlueKitchen GmbH (c) 2020
+
+# decode binary log from ENABLE_LOG_DEFERRED, e.g. captured with JLinkRTTLogger on channel 2
+#
+# record:
+#   uint8_t  len
+#   uint8_t  log_level
+#   uint32_t time_ms
+#   void *   format        address of format string in firmware
+#   ...      arguments     see hci_dump_log_deferred in src/hci_dump.c
+
+import re
+import struct
+import sys
+
+log_levels = ["DEBUG", "INFO", "ERROR"]
+
+format_regex = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|L|j|z|t)?([diouxXcspfFeEgG%])')
+
+class Elf:
+
+	def __init__(self, path):
+		with open(path, 'rb') as f:
+			self.data = f.read()
+		if self.data[0:4] != b'\x7fELF':
+			raise ValueError('not an ELF file')
+		self.is_64 = self.data[4] == 2
+		self.endian = '<' if self.data[5] == 1 else '>'
+		self.pointer_size = 8 if self.is_64 else 4
+		# LP64 for 64-bit, ILP32 otherwise
+		self.long_size = self.pointer_size
+		if self.is_64:
+			(shoff,) = struct.unpack_from(self.endian + 'Q', self.data, 0x28)
+			(shentsize, shnum) = struct.unpack_from(self.endian + 'HH', self.data, 0x3a)
+		else:
+			(shoff,) = struct.unpack_from(self.endian + 'I', self.data, 0x20)
+			(shentsize, shnum) = struct.unpack_from(self.endian + 'HH', self.data, 0x2e)
+		# collect allocated sections with content: (address, size, file offset)
+		self.sections = []
+		for i in range(shnum):
+			offset = shoff + i * shentsize
+			if self.is_64:
+				(sh_type, sh_flags, sh_addr, sh_offset, sh_size) = struct.unpack_from(self.endian + 'IQQQQ', self.data, offset + 4)
+			else:
+				(sh_type, sh_flags, sh_addr, sh_offset, sh_size) = struct.unpack_from(self.endian + 'IIIII', self.data, offset + 4)
+			# SHT_PROGBITS and SHF_ALLOC
+			if sh_type == 1 and (sh_flags & 2) != 0:
+				self.sections.append((sh_addr, sh_size, sh_offset))
+
+	def read_string(self, address):
+		for (sh_addr, sh_size, sh_offset) in self.sections:
+			if sh_addr <= address < sh_addr + sh_size:
+				start = sh_offset + address - sh_addr
+				end = self.data.index(b'\x00', start)
+				return self.data[start:end].decode('utf-8', 'replace')
+		return None
+
+def format_record(elf, record):
+	pos = 0
+	def take(size):
+		nonlocal pos
+		value = int.from_bytes(record[pos:pos+size], 'little')
+		pos += size
+		return value
+
+	log_level = take(1)
+	time_ms = take(4)
+	format_address = take(elf.pointer_size)
+	format = elf.read_string(format_address)
+	if format is None:
+		return 'unknown format string at 0x%x' % format_address
+
+	def convert(match):
+		nonlocal pos
+		(flags, width, precision, length, conversion) = match.groups()
+		if conversion == '%':
+			return '%'
+		if width == '*':
+			width = str(take(4))
+		if precision == '*':
+			precision = str(take(4))
+		spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+		if pos >= len(record):
+			return '<missing>'
+		if conversion == 's':
+			str_len = take(1)
+			value = record[pos:pos+str_len].decode('utf-8', 'replace')
+			pos += str_len
+			return (spec + 's') % value
+		if conversion in 'fFeEgG':
+			(value,) = struct.unpack_from('<d', record, pos)
+			pos += 8
+			return (spec + conversion) % value
+		if conversion == 'p':
+			return '0x%x' % take(elf.pointer_size)
+		size = 4
+		if length == 'l':
+			size = elf.long_size
+		elif length in ['ll', 'L', 'j']:
+			size = 8
+		elif length in ['z', 't']:
+			size = elf.pointer_size
+		value = take(size)
+		if conversion in 'di' and value >= 1 << (8 * size - 1):
+			value -= 1 << (8 * size)
+		if conversion == 'u':
+			conversion = 'd'
+		return (spec + conversion) % value
+
+	message = format_regex.sub(convert, format)
+	level = log_levels[log_level] if log_level < len(log_levels) else str(log_level)
+	return '[%02u:%02u:%02u.%03u] %s -- %s' % (time_ms // 3600000, (time_ms // 60000) % 60, (time_ms // 1000) % 60, time_ms % 1000, level, message)
+
+if len(sys.argv) < 3:
+	print('Decode binary log created with ENABLE_LOG_DEFERRED')
+	print('Copyright 2020, BlueKitchen GmbH')
+	print('')
+	print('Usage: ', sys.argv[0], 'firmware.elf deferred_log.bin')
+	exit(0)
+
+elf = Elf(sys.argv[1])
+with open(sys.argv[2], 'rb') as fin:
+	log = fin.read()
+
+pos = 0
+while pos < len(log):
+	record_len = log[pos]
+	if record_len < 2 or pos + record_len > len(log):
+		print('Error parsing log at offset %u (%x).' % (pos, pos))
+		break
+	print(format_record(elf, log[pos+1:pos+record_len]))
+	pos += record_len
@@ -43,33 +43,35 @@ if len(sys.argv) == 1:
 	print 'Dump PacketLogger file'
 	print 'Copyright 2014, BlueKitchen GmbH'
 	print ''
-	print 'Usage: ', sys.argv[0], 'hci_dump.pklg'
+	print 'Usage: ', sys.argv[0], 'hci_dump.pklg [more segments of rotating log]'
 	exit(0)
 
-infile = sys.argv[1]
-
-with open (infile, 'rb') as fin:
-	pos = 0
-	try:
-		while True:
-			len     = read_net_32(fin)
-			if len < 0:
-				break
-			ts_sec  = read_net_32(fin)
-			ts_usec = read_net_32(fin)
-			type    = ord(fin.read(1))
-			packet_len = len - 9;
-			if (packet_len > 66000):
-				print ("Error parsing pklg at offset %u (%x)." % (pos, pos))
-				break
-			packet  = fin.read(packet_len)
-			pos     = pos + 4 + len
-			time    = "[%s.%03u]" % (datetime.datetime.fromtimestamp(ts_sec).strftime("%Y-%m-%d %H:%M:%S"), ts_usec / 1000)
-			if type == 0xfc:
-				print time, "LOG", packet
-				continue
-			if type <= 0x03:
-				print time, packet_types[type], as_hex(packet)
-	except TypeError:
-		print ("Error parsing pklg at offset %u (%x)." % (pos, pos))
+def dump_file(infile):
+	with open (infile, 'rb') as fin:
+		pos = 0
+		try:
+			while True:
+				len     = read_net_32(fin)
+				if len < 0:
+					break
+				ts_sec  = read_net_32(fin)
+				ts_usec = read_net_32(fin)
+				type    = ord(fin.read(1))
+				packet_len = len - 9;
+				if (packet_len > 66000):
+					print ("Error parsing pklg at offset %u (%x)." % (pos, pos))
+					break
+				packet  = fin.read(packet_len)
+				pos     = pos + 4 + len
+				time    = "[%s.%03u]" % (datetime.datetime.fromtimestamp(ts_sec).strftime("%Y-%m-%d %H:%M:%S"), ts_usec / 1000)
+				if type == 0xfc:
+					print time, "LOG", packet
+					continue
+				if type <= 0x03:
+					print time, packet_types[type], as_hex(packet)
+		except TypeError:
+			print ("Error parsing pklg at offset %u (%x)." % (pos, pos))
 
+# rotating log segments can be passed oldest first, e.g. hci_dump.pklg.2 hci_dump.pklg.1 hci_dump.pklg
+for infile in sys.argv[1:]:
+	dump_file(infile)
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# BlueKitchen GmbH (c) 2020
+
+# summarize RAM and flash per module from linker maps in build/<config>/btstack.map
+# and sizes of static buffers and pool elements from build/<config>/sizes.txt, see Makefile
+#
+# flash: .text, .rodata, .data.rel.ro, .data
+# ram:   .data, .bss, COMMON
+#
+# static buffers are only listed by name if compiled with -fdata-sections
+
+import os
+import re
+import sys
+
+# largest static buffers listed per configuration
+max_buffers = 15
+
+input_section_regex     = re.compile(r'^ (\.\S+|COMMON)(?:\s+0x[0-9a-f]+\s+0x([0-9a-f]+)\s+(\S+))?\s*$')
+continuation_regex      = re.compile(r'^\s+0x[0-9a-f]+\s+0x([0-9a-f]+)\s+(\S+)\s*$')
+
+def section_type(section):
+	# relocated constants of position independent code, read-only after load
+	if section.startswith('.data.rel.ro'):
+		return 'rodata'
+	for prefix in ['.text', '.rodata', '.data', '.bss']:
+		if section == prefix or section.startswith(prefix + '.'):
+			return prefix[1:]
+	if section == 'COMMON':
+		return 'bss'
+	return None
+
+def module_name(path):
+	name = os.path.basename(path)
+	if name.endswith('.o'):
+		name = name[:-2]
+	return name
+
+def parse_map(path):
+	# returns modules { name : { text, rodata, data, bss } } and buffers [ (size, name, module) ]
+	modules = {}
+	buffers = []
+	with open(path, 'r') as f:
+		lines = f.read().splitlines()
+	started = False
+	pending = None
+	for line in lines:
+		if not started:
+			started = line.startswith('Linker script and memory map')
+			continue
+		if pending is not None:
+			match = continuation_regex.match(line)
+			if match:
+				(size, object_file) = match.groups()
+				add_section(modules, buffers, pending, int(size, 16), object_file)
+			pending = None
+			continue
+		match = input_section_regex.match(line)
+		if not match:
+			continue
+		(section, size, object_file) = match.groups()
+		if size is None:
+			pending = section
+		else:
+			add_section(modules, buffers, section, int(size, 16), object_file)
+	return (modules, buffers)
+
+def add_section(modules, buffers, section, size, object_file):
+	kind = section_type(section)
+	if kind is None or size == 0 or not object_file.endswith('.o'):
+		return
+	module = module_name(object_file)
+	sizes = modules.setdefault(module, { 'text' : 0, 'rodata' : 0, 'data' : 0, 'bss' : 0})
+	sizes[kind] += size
+	if kind in ['data', 'bss']:
+		name = section[len(kind) + 2:] if section.startswith('.' + kind + '.') else section
+		buffers.append((size, name, module))
+
+def flash(sizes):
+	return sizes['text'] + sizes['rodata'] + sizes['data']
+
+def ram(sizes):
+	return sizes['data'] + sizes['bss']
+
+def parse_sizes(path):
+	# nm -S output: address size type name
+	sizes = {}
+	with open(path, 'r') as f:
+		for line in f:
+			fields = line.split()
+			if len(fields) == 4 and fields[3].startswith('footprint_size_'):
+				sizes[fields[3][len('footprint_size_'):]] = int(fields[1], 16)
+	return sizes
+
+if len(sys.argv) < 2:
+	print('RAM and flash footprint per module for BTstack configurations')
+	print('Copyright 2020, BlueKitchen GmbH')
+	print('')
+	print('Usage: ', sys.argv[0], 'config1 [config2 ...], expects build/<config>/btstack.map and build/<config>/sizes.txt')
+	exit(0)
+
+configs = sys.argv[1:]
+maps = {}
+sizes = {}
+for config in configs:
+	maps[config] = parse_map(os.path.join('build', config, 'btstack.map'))
+	sizes[config] = parse_sizes(os.path.join('build', config, 'sizes.txt'))
+
+print('# BTstack Footprint')
+print('')
+print('All values in bytes. Flash = .text + .rodata + .data, RAM = .data + .bss. Without garbage collection by the final link.')
+print('')
+print('## Total')
+print('')
+print('Configuration | Flash | RAM')
+print('--------------|------:|----:')
+for config in configs:
+	(modules, _) = maps[config]
+	print('%s | %u | %u' % (config, sum(flash(s) for s in modules.values()), sum(ram(s) for s in modules.values())))
+
+print('')
+print('## Modules (Flash / RAM)')
+print('')
+print('Module | ' + ' | '.join(configs))
+print('-------|' + '|'.join('------:' for _ in configs))
+all_modules = sorted(set(module for config in configs for module in maps[config][0]))
+for module in all_modules:
+	cells = []
+	for config in configs:
+		module_sizes = maps[config][0].get(module)
+		cells.append('-' if module_sizes is None else '%u / %u' % (flash(module_sizes), ram(module_sizes)))
+	print('%s | %s' % (module, ' | '.join(cells)))
+
+print('')
+print('## Static Buffers and Pool Elements')
+print('')
+print('Size of | ' + ' | '.join(configs))
+print('--------|' + '|'.join('------:' for _ in configs))
+all_names = []
+for config in configs:
+	for name in sizes[config]:
+		if name not in all_names:
+			all_names.append(name)
+for name in all_names:
+	print('%s | %s' % (name, ' | '.join(str(sizes[config][name]) if name in sizes[config] else '-' for config in configs)))
+
+for config in configs:
+	(_, buffers) = maps[config]
+	print('')
+	print('## Largest RAM Objects: %s' % config)
+	print('')
+	print('Object | Module | Size')
+	print('-------|--------|----:')
+	for (size, name, module) in sorted(buffers, reverse=True)[:max_buffers]:
+		print('%s | %s | %u' % (name, module, size))
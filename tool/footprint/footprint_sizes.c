@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "footprint_sizes.c"
+
+/*
+ *  footprint_sizes.c
+ *
+ *  Not linked, only used to extract the size of static buffers and pool elements for the current configuration.
+ *  footprint.py reads the symbol sizes with nm, each symbol footprint_size_<name> has a size of <name>
+ */
+
+#include <stdint.h>
+
+#include "btstack_config.h"
+#include "hci.h"
+#include "l2cap.h"
+
+#ifdef ENABLE_BLE
+#include "ble/gatt_client.h"
+#include "ble/sm.h"
+#endif
+
+#ifdef ENABLE_CLASSIC
+#include "classic/rfcomm.h"
+#endif
+
+#define FOOTPRINT_SIZE(name, size) const uint8_t footprint_size_ ## name[size] = { 0 }
+
+FOOTPRINT_SIZE(hci_stack_t, sizeof(hci_stack_t));
+FOOTPRINT_SIZE(hci_packet_buffer, sizeof(((hci_stack_t *) 0)->hci_packet_buffer_data));
+FOOTPRINT_SIZE(hci_connection_t, sizeof(hci_connection_t));
+FOOTPRINT_SIZE(acl_recombination_buffer, sizeof(((hci_connection_t *) 0)->acl_recombination_buffer));
+FOOTPRINT_SIZE(l2cap_channel_t, sizeof(l2cap_channel_t));
+FOOTPRINT_SIZE(l2cap_service_t, sizeof(l2cap_service_t));
+
+#ifdef ENABLE_BLE
+FOOTPRINT_SIZE(whitelist_entry_t, sizeof(whitelist_entry_t));
+FOOTPRINT_SIZE(sm_lookup_entry_t, sizeof(sm_lookup_entry_t));
+FOOTPRINT_SIZE(gatt_client_t, sizeof(gatt_client_t));
+#endif
+
+#ifdef ENABLE_CLASSIC
+FOOTPRINT_SIZE(rfcomm_multiplexer_t, sizeof(rfcomm_multiplexer_t));
+FOOTPRINT_SIZE(rfcomm_channel_t, sizeof(rfcomm_channel_t));
+#endif
@@ -0,0 +1,28 @@
+//
+// btstack_config.h for footprint report: LE Central with GATT Client
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_EMBEDDED_TIME_MS
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_LE_CENTRAL
+#define ENABLE_LE_SECURE_CONNECTIONS
+#define ENABLE_MICRO_ECC_FOR_LE_SECURE_CONNECTIONS
+#define ENABLE_LOG_ERROR
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE (251 + 4)
+#define MAX_NR_HCI_CONNECTIONS 2
+#define MAX_NR_L2CAP_SERVICES  0
+#define MAX_NR_L2CAP_CHANNELS  0
+#define MAX_NR_GATT_CLIENTS 2
+#define MAX_NR_WHITELIST_ENTRIES 2
+#define MAX_NR_SM_LOOKUP_ENTRIES 3
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+
+#endif
@@ -96,10 +96,19 @@ event_template = \
 
 class {0}(btstack.btstack_types.Event):
 
+    # precompiled decoder for fixed size fields at the start of the event
+    decoder = struct.Struct("<{1}")
+
     def __init__(self, payload):
         super().__init__(payload)
-    {1}
+        self.fields = None
+
+    def decode(self):
+        if self.fields is None:
+            self.fields = self.decoder.unpack_from(self.payload, 2)
+        return self.fields
     {2}
+    {3}
 '''
 
 event_getter = \
@@ -242,18 +251,41 @@ def create_event(fout, event_name, format, args):
     global gen_path
     global event_template
 
+    # fields up to the first variable size field are decoded at once by the precompiled struct of the event
+    decoder_format = {
+     '1' : 'B', 'J' : 'B', '2' : 'H', 'H' : 'H', 'L' : 'H', '4' : 'I', '3' : '3s', 'B' : '6s',
+     'D' : '8s', 'Q' : '32s', 'X' : '20s', 'Y' : '24s', 'Z' : '18s', 'N' : '248s',
+     }
+
+    decoder_read = {
+     '1' : 'return self.decode()[{index}]',
+     'J' : 'return self.decode()[{index}]',
+     '2' : 'return self.decode()[{index}]',
+     'H' : 'return self.decode()[{index}]',
+     'L' : 'return self.decode()[{index}]',
+     '4' : 'return self.decode()[{index}]',
+     '3' : 'return btstack.btstack_types.unpack24(self.decode()[{index}])',
+     'B' : 'data = bytearray(self.decode()[{index}]); data.reverse(); return btstack.btstack_types.BD_ADDR(data)',
+     'D' : 'return self.decode()[{index}]',
+     'Q' : 'return self.decode()[{index}]',
+     'X' : 'return btstack.btstack_types.GATTService(self.decode()[{index}])',
+     'Y' : 'return btstack.btstack_types.GATTCharacteristic(self.decode()[{index}])',
+     'Z' : 'return btstack.btstack_types.GATTCharacteristicDescriptor(self.decode()[{index}])',
+     'N' : 'return self.decode()[{index}].decode("utf-8")',
+     }
+
     param_read = {
      '1' : 'return self.payload[{offset}]',
      'J' : 'return self.payload[{offset}]',
-     '2' : 'return struct.unpack("<H", self.payload[{offset} : {offset}+2])',
-     'H' : 'return struct.unpack("<H", self.payload[{offset} : {offset}+2])',
-     'L' : 'return struct.unpack("<H", self.payload[{offset} : {offset}+2])',
-     '3' : 'return btstack.btstack_types.unpack24(self.payload[{offset}:3])',
-     '4' : 'return struct.unpack("<I", self.payload[{offset} : {offset}+4])',
+     '2' : 'return struct.unpack_from("<H", self.payload, {offset})[0]',
+     'H' : 'return struct.unpack_from("<H", self.payload, {offset})[0]',
+     'L' : 'return struct.unpack_from("<H", self.payload, {offset})[0]',
+     '3' : 'return btstack.btstack_types.unpack24(self.payload[{offset}:{offset}+3])',
+     '4' : 'return struct.unpack_from("<I", self.payload, {offset})[0]',
      'B' : 'data = bytearray(self.payload[{offset}:{offset}+6]); data.reverse(); return btstack.btstack_types.BD_ADDR(data)',
-     'X' : 'return btstack.btstack_types.GATTService(self.payload[{offset}:20])',
-     'Y' : 'return btstack.btstack_types.GATTCharacteristic(self.payload[{offset}:24])',
-     'Z' : 'return btstack.btstack_types.GATTCharacteristicDescriptor(self.payload[{offset}:18])',
+     'X' : 'return btstack.btstack_types.GATTService(self.payload[{offset}:{offset}+20])',
+     'Y' : 'return btstack.btstack_types.GATTCharacteristic(self.payload[{offset}:{offset}+24])',
+     'Z' : 'return btstack.btstack_types.GATTCharacteristicDescriptor(self.payload[{offset}:{offset}+18])',
      'T' : 'return self.payload[{offset}:].decode("utf-8")',
      'N' : 'return self.payload[{offset}:{offset}+248].decode("utf-8")',
      # 'D' : 'Util.storeBytes(self.payload, %u, 8);',
@@ -268,11 +300,19 @@ def create_event(fout, event_name, format, args):
     offset = 2
     getters = ''
     length_name = ''
+    decoder = ''
+    decoder_fields = 0
+    decoding = True
     for f, arg in zip(format, args):
         # just remember name
         if f in ['L','J']:
             length_name = arg.lower()
-        if f == 'R':    
+        if decoding and f in decoder_format:
+            access = decoder_read[f].format(index=decoder_fields)
+            decoder += decoder_format[f]
+            decoder_fields += 1
+            size = size_for_type(f)
+        elif f == 'R':    
             # remaining data
             access = param_read[f].format(offset=offset)
             size = 0
@@ -285,6 +325,8 @@ def create_event(fout, event_name, format, args):
         else: 
             access = param_read[f].format(offset=offset)
             size = size_for_type(f)
+        if f not in decoder_format:
+            decoding = False
         getters += event_getter.format(arg.lower(), access)
         offset += size
     to_string_args = ''
@@ -298,7 +340,7 @@ def create_event(fout, event_name, format, args):
             to_string_args += '        repr += str(self.get_%s())\n' % arg.lower()
     to_string_method = event_to_string.format(event_name, to_string_args)
     fout.write('# %s - %s' % (event_name, format))
-    fout.write(event_template.format(event_name, getters, to_string_method))
+    fout.write(event_template.format(event_name, decoder, getters, to_string_method))
 
 def event_supported(event_name):
     parts = event_name.split('_')